@@ -0,0 +1,478 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./MessageBatch.h"
+#include "./Trace.h"
+#include "./ThreadPriorities.h"
+
+// the priority classes, a free pool thread takes the oldest job of the highest class
+#define JOB_PRIORITY_INTERACTIVE	0	// the user is looking at the result, e.g. a thumbnail
+#define JOB_PRIORITY_NORMAL			1	// started by the user, who waits for it, e.g. a breeding run
+#define JOB_PRIORITY_IDLE			2	// work ahead that nobody waits for yet, e.g. the speculation
+#define NUM_JOB_PRIORITIES			3
+
+#define JOB_QUEUE_MIN_THREADS		2		// a long run doesn't hold up the short jobs
+#define JOB_QUEUE_STOP_TIMEOUT_MS	5000	// for the running jobs to see the cancel when the queue goes
+
+class JobQueue;
+
+//---------------------------------------------------------------------------
+/** A piece of work that runs on a pool thread of the JobQueue.
+
+	The job is reference counted, the Ptr the caller keeps is the handle of
+	the result: isDone(), waitUntilDone() and the state tell what became of
+	it, a subclass adds the getters of whatever it produced. A job that is
+	cancelled before it started never runs, a running one has to call
+	shouldExit() often enough and return when it is true. then() chains a
+	job that is only queued when this one has succeeded. A job below
+	JOB_PRIORITY_INTERACTIVE also pauses in shouldExit() while the user is
+	editing or auditioning, see UserActivity.
+
+	setProgress() and setStatusMessage() may be called as often as the job
+	likes, the listeners are told on the message thread with at most one
+	call per dispatch of the MessageBatch, however many changes there were
+	in between. Listeners are added and removed on the message thread, a
+	listener added after the job is done isn't told.
+*/
+class BackgroundJob : public ReferenceCountedObject
+{
+public:
+	typedef ReferenceCountedObjectPtr<BackgroundJob> Ptr;
+
+	enum State
+	{
+		JOB_WAITING = 0,	// a continuation whose job isn't done yet
+		JOB_QUEUED,
+		JOB_RUNNING,
+		JOB_SUCCEEDED,
+		JOB_FAILED,
+		JOB_CANCELLED
+	};
+
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** the progress or the status message has changed*/
+		virtual void jobProgressChanged(BackgroundJob*) {};
+		/** once, after the job has succeeded, failed or was cancelled*/
+		virtual void jobFinished(BackgroundJob* job) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	BackgroundJob(const String& name, int priority)
+	: mName(name),
+	mPriority(priority),
+	mDone(true),
+	mProgress(0.0),
+	mFinishReported(false)
+	{
+		jassert(priority >= 0 && priority < NUM_JOB_PRIORITIES);
+		mState.set(JOB_WAITING);
+	};
+
+	virtual ~BackgroundJob()
+	{
+	};
+
+	/** does the work on a pool thread, false if it failed.
+		A job that was cancelled while it ran counts as cancelled, whatever it returns*/
+	virtual bool run() = 0;
+
+	const String& getName() const
+	{
+		return mName;
+	};
+
+	int getPriority() const
+	{
+		return mPriority;
+	};
+
+	int getState() const
+	{
+		return mState.get();
+	};
+
+	bool isDone() const
+	{
+		return getState() >= JOB_SUCCEEDED;
+	};
+
+	bool succeeded() const
+	{
+		return getState() == JOB_SUCCEEDED;
+	};
+
+	/** waits until the job is done, false if the timeout ran out first.
+		Never wait on the message thread for a job that takes the MessageManagerLock*/
+	bool waitUntilDone(int timeoutMs)
+	{
+		return mDone.wait(timeoutMs);
+	};
+
+	/** any thread. A queued job is done at once, a running one when it has seen shouldExit()*/
+	inline void cancel();
+
+	/** true once the job is cancelled, a running job returns as soon as it can.
+		Called by the job only, it may sleep while the user is active*/
+	bool shouldExit() const
+	{
+		while(mPriority != JOB_PRIORITY_INTERACTIVE && mShouldExit.get() == 0 && UserActivity::pauseIfActive()) {}
+		return mShouldExit.get() != 0;
+	};
+
+	/** queues next when this job has succeeded, otherwise next is cancelled. Returns next*/
+	inline Ptr then(BackgroundJob* next);
+
+	/** 0..1, or -1 if the job can't tell*/
+	void setProgress(double progress)
+	{
+		{
+			const ScopedLock lock(mStatusLock);
+			mProgress = progress;
+		}
+		notify();
+	};
+
+	double getProgress() const
+	{
+		const ScopedLock lock(mStatusLock);
+		return mProgress;
+	};
+
+	void setStatusMessage(const String& message)
+	{
+		{
+			const ScopedLock lock(mStatusLock);
+			mStatusMessage = message;
+		}
+		notify();
+	};
+
+	String getStatusMessage() const
+	{
+		const ScopedLock lock(mStatusLock);
+		return mStatusMessage;
+	};
+
+	void addListener(Listener* listener)
+	{
+		mListeners.add(listener);
+	};
+
+	void removeListener(Listener* listener)
+	{
+		mListeners.remove(listener);
+	};
+
+private:
+	friend class JobQueue;
+
+	/** the listeners are told on the next dispatch, once however often this is called*/
+	inline void notify();
+
+	const String mName;
+	const int mPriority;
+	Atomic<int> mState;
+	Atomic<int> mShouldExit;
+	Atomic<int> mNotifyPending;		// the job is in the notify list of the queue
+	WaitableEvent mDone;			// set when the state is one of the done ones
+
+	CriticalSection mStatusLock;
+	double mProgress;
+	String mStatusMessage;
+
+	ReferenceCountedArray<BackgroundJob> mContinuations;	// under the lock of the queue
+	ListenerList<Listener> mListeners;						// only used on the message thread
+	bool mFinishReported;									// the same
+};
+
+//---------------------------------------------------------------------------
+/** Runs the BackgroundJobs on a juce ThreadPool, by priority class.
+
+	The pool runs its jobs first come first served, so it is only given
+	runners, one for each job that is queued. A runner takes the oldest job
+	of the highest priority class when a pool thread gets to it, not the
+	job it was added for, and sets the priority of its thread to the class
+	while the job runs. A job that is cancelled while it is queued leaves a
+	runner with nothing to do, which just returns.
+
+	The listeners of all jobs are told through the one BatchedAsyncUpdater
+	of the queue, it keeps every job it has to tell something alive until
+	it is told.
+*/
+class JobQueue : private BatchedAsyncUpdater
+{
+public:
+	JobQueue()
+	: mNumThreads(jmax(JOB_QUEUE_MIN_THREADS,SystemStats::getNumCpus()-1)),
+	mPool(mNumThreads)
+	{
+	};
+
+	~JobQueue()
+	{
+		//the queued jobs are done at once, the running ones when they have seen the cancel
+		ReferenceCountedArray<BackgroundJob> queued;
+		{
+			const ScopedLock lock(mLock);
+			for(int p=0;p<NUM_JOB_PRIORITIES;p++)
+			{
+				queued.addArray(mQueued[p]);
+				mQueued[p].clear();
+			}
+			for(int i=0;i<mRunning.size();i++)
+			{
+				mRunning.getUnchecked(i)->mShouldExit.set(1);
+			}
+		}
+		for(int i=0;i<queued.size();i++)
+		{
+			queued.getUnchecked(i)->mShouldExit.set(1);
+			finish(queued.getUnchecked(i),BackgroundJob::JOB_CANCELLED);
+		}
+		mPool.removeAllJobs(true,JOB_QUEUE_STOP_TIMEOUT_MS,true);
+		cancelPendingUpdate();
+		mNotify.clear();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (JobQueue, false)
+
+	/** queues job to run when a pool thread is free, returns the handle of the job*/
+	BackgroundJob::Ptr addJob(BackgroundJob* job)
+	{
+		BackgroundJob::Ptr handle(job);
+		jassert(job->getState() == BackgroundJob::JOB_WAITING);
+		enqueue(job);
+		return handle;
+	};
+
+	int getNumThreads() const
+	{
+		return mNumThreads;
+	};
+
+private:
+	friend class BackgroundJob;
+
+	class Runner : public ThreadPoolJob
+	{
+	public:
+		Runner(JobQueue& owner) : ThreadPoolJob("job runner"), mOwner(owner)
+		{
+		};
+
+		JobStatus runJob()
+		{
+			BackgroundJob::Ptr job(mOwner.takeNext());
+			if(job == NULL) return jobHasFinishedAndShouldBeDeleted;
+
+			TRACE_SCOPE("jobs","run");
+			Thread::setCurrentThreadPriority(getThreadPriority(job->getPriority()));
+			const bool succeeded = job->run();
+			Thread::setCurrentThreadPriority(getThreadPriority(JOB_PRIORITY_INTERACTIVE));
+			mOwner.finish(job,succeeded ? BackgroundJob::JOB_SUCCEEDED : BackgroundJob::JOB_FAILED);
+			return jobHasFinishedAndShouldBeDeleted;
+		};
+
+	private:
+		/** only the interactive jobs run beside the message thread, the rest below it*/
+		static int getThreadPriority(int priority)
+		{
+			switch(priority)
+			{
+			case JOB_PRIORITY_INTERACTIVE:	return PRIORITY_CLASS_UI;
+			case JOB_PRIORITY_IDLE:			return PRIORITY_CLASS_IDLE;
+			default:						return PRIORITY_CLASS_BACKGROUND;
+			}
+		};
+
+		JobQueue& mOwner;
+	};
+
+	void enqueue(BackgroundJob* job)
+	{
+		if(job->mShouldExit.get() != 0)
+		{
+			finish(job,BackgroundJob::JOB_CANCELLED);
+			return;
+		}
+		{
+			const ScopedLock lock(mLock);
+			job->mState.set(BackgroundJob::JOB_QUEUED);
+			mQueued[job->getPriority()].add(job);
+		}
+		mPool.addJob(new Runner(*this));
+	};
+
+	/** the next job to run, NULL if the runner came for a job that was cancelled*/
+	BackgroundJob::Ptr takeNext()
+	{
+		const ScopedLock lock(mLock);
+		for(int p=0;p<NUM_JOB_PRIORITIES;p++)
+		{
+			if(mQueued[p].size() == 0) continue;
+
+			BackgroundJob::Ptr job(mQueued[p].getUnchecked(0));
+			mQueued[p].remove(0);
+			job->mState.set(BackgroundJob::JOB_RUNNING);
+			mRunning.add(job);
+			return job;
+		}
+		return NULL;
+	};
+
+	void cancel(BackgroundJob* job)
+	{
+		BackgroundJob::Ptr handle(job);
+		bool finished = false;
+		{
+			const ScopedLock lock(mLock);
+			job->mShouldExit.set(1);
+			if(job->getState() == BackgroundJob::JOB_QUEUED)
+			{
+				mQueued[job->getPriority()].removeObject(job);
+				finished = true;
+			}
+			//a waiting continuation stays in the list of its job, which skips it
+			else if(job->getState() == BackgroundJob::JOB_WAITING)
+			{
+				finished = true;
+			}
+		}
+		if(finished) finish(job,BackgroundJob::JOB_CANCELLED);
+	};
+
+	void addContinuation(BackgroundJob* job, BackgroundJob* next)
+	{
+		jassert(next->getState() == BackgroundJob::JOB_WAITING);
+		int state;
+		{
+			const ScopedLock lock(mLock);
+			state = job->getState();
+			if(state < BackgroundJob::JOB_SUCCEEDED)
+			{
+				job->mContinuations.add(next);
+				return;
+			}
+		}
+		if(state == BackgroundJob::JOB_SUCCEEDED) enqueue(next);
+		else finish(next,BackgroundJob::JOB_CANCELLED);
+	};
+
+	void finish(BackgroundJob* job, int state)
+	{
+		BackgroundJob::Ptr handle(job);
+		ReferenceCountedArray<BackgroundJob> continuations;
+		{
+			const ScopedLock lock(mLock);
+			if(job->mShouldExit.get() != 0) state = BackgroundJob::JOB_CANCELLED;
+			job->mState.set(state);
+			mRunning.removeObject(job);
+			continuations.swapWithArray(job->mContinuations);
+		}
+		job->mDone.signal();
+		job->notify();
+
+		for(int i=0;i<continuations.size();i++)
+		{
+			BackgroundJob* next = continuations.getUnchecked(i);
+			if(next->getState() != BackgroundJob::JOB_WAITING) continue;	// cancelled already
+
+			if(state == BackgroundJob::JOB_SUCCEEDED) enqueue(next);
+			else finish(next,BackgroundJob::JOB_CANCELLED);
+		}
+	};
+
+	void addNotification(BackgroundJob* job)
+	{
+		{
+			const ScopedLock lock(mNotifyLock);
+			mNotify.add(job);
+		}
+		triggerAsyncUpdate();
+	};
+
+	void handleAsyncUpdate()
+	{
+		ReferenceCountedArray<BackgroundJob> jobs;
+		{
+			const ScopedLock lock(mNotifyLock);
+			jobs.swapWithArray(mNotify);
+		}
+
+		for(int i=0;i<jobs.size();i++)
+		{
+			BackgroundJob* job = jobs.getUnchecked(i);
+			//cleared before the state is read, a job that finishes now is put in the list again
+			job->mNotifyPending.set(0);
+			const bool done = job->isDone();
+
+			job->mListeners.call(&BackgroundJob::Listener::jobProgressChanged,job);
+			if(done && !job->mFinishReported)
+			{
+				job->mFinishReported = true;
+				job->mListeners.call(&BackgroundJob::Listener::jobFinished,job);
+			}
+		}
+	};
+
+	const int mNumThreads;
+	ThreadPool mPool;
+	CriticalSection mLock;
+	ReferenceCountedArray<BackgroundJob> mQueued[NUM_JOB_PRIORITIES];	// oldest first
+	ReferenceCountedArray<BackgroundJob> mRunning;
+
+	CriticalSection mNotifyLock;
+	ReferenceCountedArray<BackgroundJob> mNotify;	// jobs whose listeners are told on the next dispatch
+};
+
+//---------------------------------------------------------------------------
+inline void BackgroundJob::cancel()
+{
+	JobQueue* queue = JobQueue::getInstanceWithoutCreating();
+	if(queue != NULL) queue->cancel(this);
+	else mShouldExit.set(1);
+}
+
+inline BackgroundJob::Ptr BackgroundJob::then(BackgroundJob* next)
+{
+	Ptr handle(next);
+	JobQueue::getInstance()->addContinuation(this,next);
+	return handle;
+}
+
+inline void BackgroundJob::notify()
+{
+	//a job finished by ~JobQueue has nobody left to tell
+	JobQueue* queue = JobQueue::getInstanceWithoutCreating();
+	if(queue != NULL && mNotifyPending.compareAndSetBool(1,0)) queue->addNotification(this);
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,312 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Log.h"
+#include "../MemoryAccounting.h"
+
+#define BENCHMARK_DEFAULT_WARMUP_MS		300		// at least this long before the first sample
+#define BENCHMARK_DEFAULT_SAMPLE_MS		50		// one timed batch of operations
+#define BENCHMARK_DEFAULT_NUM_SAMPLES	30
+#define BENCHMARK_MAX_BATCH				(1<<24)	// operations per sample
+
+//---------------------------------------------------------------------------
+/** One measured operation, e.g. loading a .SND file.
+	Whatever the operation needs is made in prepare(), only run() is timed.*/
+class Benchmark
+{
+public:
+	Benchmark(const String& name) : mName(name)
+	{
+	};
+
+	virtual ~Benchmark() {};
+
+	const String& getName() const
+	{
+		return mName;
+	};
+
+	/** returns false if the benchmark can't run here, e.g. a missing file*/
+	virtual bool prepare()
+	{
+		return true;
+	};
+
+	/** runs the operation numOps times*/
+	virtual void run(int numOps) = 0;
+
+	virtual void cleanup() {};
+
+private:
+	String mName;
+};
+
+//---------------------------------------------------------------------------
+/** the times of one benchmark, in nanoseconds per operation*/
+struct BenchmarkResult
+{
+	BenchmarkResult()
+	: skipped(true),
+	opsPerSample(0),
+	numSamples(0),
+	meanNs(0),
+	medianNs(0),
+	minNs(0),
+	maxNs(0),
+	stdDevNs(0)
+	{
+		for(int i=0;i<NUM_MEMORY_TAGS;i++)
+		{
+			liveBytes[i] = peakBytes[i] = 0;
+			allocationsPerOp[i] = 0;
+		}
+	};
+
+	/** from the median, which a few preempted samples don't move*/
+	double getOpsPerSecond() const
+	{
+		return medianNs > 0 ? 1.0e9/medianNs : 0;
+	};
+
+	String name;
+	bool skipped;
+	int opsPerSample;
+	int numSamples;
+	double meanNs;
+	double medianNs;
+	double minNs;
+	double maxNs;
+	double stdDevNs;
+
+	//per MemoryAccounting tag
+	int liveBytes[NUM_MEMORY_TAGS];				// after the samples, before cleanup()
+	int peakBytes[NUM_MEMORY_TAGS];				// from prepare() to the end of the samples
+	double allocationsPerOp[NUM_MEMORY_TAGS];	// during the samples
+};
+
+//---------------------------------------------------------------------------
+/** Runs benchmarks one after the other and writes their results as JSON.
+
+	Each benchmark first warms up: the number of operations per batch is
+	doubled until a batch takes about the sample time, and batches keep
+	running until the warm up time is over, so caches, the allocator and
+	the branch predictors are in their steady state. Then numSamples
+	batches are timed with the high resolution counter. The spread of the
+	samples is reported next to the mean, a result with a large stdDevNs
+	or maxNs was disturbed and should be run again.
+*/
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner()
+	: mWarmupMs(BENCHMARK_DEFAULT_WARMUP_MS),
+	mSampleMs(BENCHMARK_DEFAULT_SAMPLE_MS),
+	mNumSamples(BENCHMARK_DEFAULT_NUM_SAMPLES)
+	{
+	};
+
+	~BenchmarkRunner()
+	{
+	};
+
+	/** the runner owns the benchmark*/
+	void add(Benchmark* benchmark)
+	{
+		mBenchmarks.add(benchmark);
+	};
+
+	void setWarmupTime(int ms)
+	{
+		mWarmupMs = jmax(0,ms);
+	};
+
+	void setSampleTime(int ms)
+	{
+		mSampleMs = jmax(1,ms);
+	};
+
+	void setNumSamples(int numSamples)
+	{
+		mNumSamples = jmax(1,numSamples);
+	};
+
+	/** runs every benchmark whose name contains filter, all of them for an empty filter*/
+	void runAll(const String& filter, bool logProgress = true)
+	{
+		mResults.clearQuick();
+		for(int i=0;i<mBenchmarks.size();i++)
+		{
+			Benchmark& benchmark = *mBenchmarks.getUnchecked(i);
+			if(filter.isNotEmpty() && !benchmark.getName().contains(filter)) continue;
+
+			const BenchmarkResult result = runOne(benchmark);
+			mResults.add(result);
+			if(!logProgress) continue;
+
+			if(result.skipped)	logText(benchmark.getName() + ": skipped");
+			else				logText(benchmark.getName() + ": " + String(result.medianNs,1) + " ns, "
+										+ String((int64)result.getOpsPerSecond()) + " per second, +-" + String(result.stdDevNs,1) + " ns" + formatMemory(result));
+		}
+	};
+
+	const Array<BenchmarkResult>& getResults() const
+	{
+		return mResults;
+	};
+
+	/** {"warmupMs":..,"sampleMs":..,"benchmarks":[{"name":..,...},...]}*/
+	bool writeJson(const File& file)
+	{
+		String json;
+		json << "{\"warmupMs\":" << mWarmupMs << ",\"sampleMs\":" << mSampleMs << ",\"benchmarks\":[\n";
+		for(int i=0;i<mResults.size();i++)
+		{
+			const BenchmarkResult& r = mResults.getReference(i);
+			json << "{\"name\":\"" << r.name << "\",\"skipped\":" << (r.skipped ? "true" : "false");
+			if(!r.skipped)
+			{
+				json << ",\"opsPerSample\":" << r.opsPerSample
+					<< ",\"samples\":" << r.numSamples
+					<< ",\"meanNs\":" << String(r.meanNs,3)
+					<< ",\"medianNs\":" << String(r.medianNs,3)
+					<< ",\"minNs\":" << String(r.minNs,3)
+					<< ",\"maxNs\":" << String(r.maxNs,3)
+					<< ",\"stdDevNs\":" << String(r.stdDevNs,3)
+					<< ",\"opsPerSecond\":" << String(r.getOpsPerSecond(),1)
+					<< ",\"memory\":{";
+				for(int t=0;t<NUM_MEMORY_TAGS;t++)
+				{
+					json << (t > 0 ? "," : "") << "\"" << MemoryAccounting::getTagName(t) << "\":{\"liveBytes\":" << r.liveBytes[t]
+						<< ",\"peakBytes\":" << r.peakBytes[t] << ",\"allocationsPerOp\":" << String(r.allocationsPerOp[t],3) << "}";
+				}
+				json << "}";
+			}
+			json << (i+1 < mResults.size() ? "},\n" : "}\n");
+		}
+		json << "]}\n";
+		return file.replaceWithText(json);
+	};
+
+private:
+	BenchmarkResult runOne(Benchmark& benchmark)
+	{
+		BenchmarkResult result;
+		result.name = benchmark.getName();
+		MemoryAccounting::resetPeaks();
+		if(!benchmark.prepare())
+		{
+			benchmark.cleanup();
+			return result;
+		}
+
+		//grow the batch to the sample time, then keep running it until the warm up is over
+		const double sampleSeconds = mSampleMs*0.001;
+		const int64 warmupEnd = Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks(mWarmupMs*0.001);
+		int batch = 1;
+		for(;;)
+		{
+			const double seconds = timeBatch(benchmark,batch);
+			if(seconds < sampleSeconds && batch < BENCHMARK_MAX_BATCH)
+			{
+				batch = (seconds*4 < sampleSeconds) ? batch*4 : batch*2;
+				batch = jmin(batch,BENCHMARK_MAX_BATCH);
+			}
+			else if(Time::getHighResolutionTicks() >= warmupEnd)
+			{
+				break;
+			}
+		}
+
+		int allocations[NUM_MEMORY_TAGS];
+		for(int t=0;t<NUM_MEMORY_TAGS;t++)
+		{
+			allocations[t] = MemoryAccounting::getNumAllocations(t);
+		}
+
+		Array<double> samples;
+		double sum = 0;
+		for(int i=0;i<mNumSamples;i++)
+		{
+			samples.add(timeBatch(benchmark,batch)*1.0e9/batch);
+			sum += samples.getLast();
+		}
+
+		for(int t=0;t<NUM_MEMORY_TAGS;t++)
+		{
+			result.liveBytes[t] = MemoryAccounting::getLiveBytes(t);
+			result.peakBytes[t] = MemoryAccounting::getPeakBytes(t);
+			result.allocationsPerOp[t] = (MemoryAccounting::getNumAllocations(t)-allocations[t])/((double)batch*mNumSamples);
+		}
+		benchmark.cleanup();
+
+		DefaultElementComparator<double> comparator;
+		samples.sort(comparator);
+		result.skipped = false;
+		result.opsPerSample = batch;
+		result.numSamples = mNumSamples;
+		result.meanNs = sum/mNumSamples;
+		result.medianNs = (mNumSamples&1) ? samples[mNumSamples/2] : 0.5*(samples[mNumSamples/2-1]+samples[mNumSamples/2]);
+		result.minNs = samples[0];
+		result.maxNs = samples[mNumSamples-1];
+
+		double squares = 0;
+		for(int i=0;i<mNumSamples;i++)
+		{
+			squares += (samples[i]-result.meanNs)*(samples[i]-result.meanNs);
+		}
+		result.stdDevNs = mNumSamples > 1 ? sqrt(squares/(mNumSamples-1)) : 0;
+		return result;
+	};
+
+	/** the tags that were used, e.g. ", markov 1.25 MB peak 0.00 allocs/op"*/
+	static String formatMemory(const BenchmarkResult& result)
+	{
+		String text;
+		for(int t=0;t<NUM_MEMORY_TAGS;t++)
+		{
+			if(result.peakBytes[t] == 0 && result.allocationsPerOp[t] == 0) continue;
+			text << ", " << MemoryAccounting::getTagName(t) << " " << MemoryAccounting::formatBytes(result.peakBytes[t])
+				<< " peak " << String(result.allocationsPerOp[t],2) << " allocs/op";
+		}
+		return text;
+	};
+
+	/** in seconds*/
+	static double timeBatch(Benchmark& benchmark, int numOps)
+	{
+		const int64 start = Time::getHighResolutionTicks();
+		benchmark.run(numOps);
+		return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks()-start);
+	};
+
+	OwnedArray<Benchmark> mBenchmarks;
+	Array<BenchmarkResult> mResults;
+	int mWarmupMs;
+	int mSampleMs;
+	int mNumSamples;
+};
+//---------------------------------------------------------------------------
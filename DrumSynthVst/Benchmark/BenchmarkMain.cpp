@@ -0,0 +1,146 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Source/Singletons.h"
+#include "./EditorBenchmarks.h"
+#include "../Midi/EditReplay.h"
+
+//---------------------------------------------------------------------------
+static String getUsage()
+{
+	return String(
+		"DrumSynthBenchmark [options]\n"
+		"\n"
+		"  -filter <text>      only the benchmarks whose name contains text\n"
+		"  -out <file>         where the JSON results go, benchmark.json by default\n"
+		"  -warmup <ms>        warm up time of each benchmark, default ") + String(BENCHMARK_DEFAULT_WARMUP_MS) + String("\n"
+		"  -sample <ms>        time of one sample, default ") + String(BENCHMARK_DEFAULT_SAMPLE_MS) + String("\n"
+		"  -samples <n>        samples per benchmark, default ") + String(BENCHMARK_DEFAULT_NUM_SAMPLES) + String("\n"
+		"  -replay <file>      replay recorded edits (File > Save Recorded Edits for Replay) instead of the benchmarks\n"
+		"  -speed <x>          replay at x times the recorded speed, 0 (the default) as fast as possible\n"
+		"\n"
+		"markovLearn reads resources/namelist.txt of the working directory and is skipped without it\n");
+}
+
+/** the edits go through the ParameterStore and the MidiTransmitter, without a device.
+	returns false if the coalescing lost a value*/
+static bool runReplay(const File& sessionFile, double speed, const File& output)
+{
+	EditSession session;
+	if(!session.load(sessionFile))
+	{
+		logText("error: can't read " + sessionFile.getFullPathName());
+		return false;
+	}
+
+	EditReplayer replayer;
+	const EditReplayResult result = replayer.replay(session,speed);
+	logText(result.toString());
+
+	TemporaryFile temp(output);
+	{
+		FileOutputStream out(temp.getFile());
+		out << "{\"replay\":";
+		result.writeJson(out);
+		out << "}\n";
+		out.flush();
+	}
+	if(!temp.overwriteTargetFileWithTemporary())
+	{
+		logText("error: can't write " + output.getFullPathName());
+		return false;
+	}
+	return result.passed;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	//juce 1.54 only has the GUI initialiser, the look and feel benchmark needs it anyway
+	ScopedJuceInitialiser_GUI juceInitialiser;
+
+	BenchmarkRunner runner;
+	addEditorBenchmarks(runner);
+
+	String filter;
+	File replayFile;
+	double replaySpeed = 0;
+	File output(File::getCurrentWorkingDirectory().getChildFile("benchmark.json"));
+	for(int i=1;i<argc;i++)
+	{
+		const String arg = String::fromUTF8(argv[i]);
+		if(arg == "-help")
+		{
+			logText(getUsage());
+			deleteSingletons();
+			return 0;
+		}
+		if(i+1 == argc)
+		{
+			logText("error: " + arg + " needs a value\n" + getUsage());
+			deleteSingletons();
+			return 1;
+		}
+		const String value = String::fromUTF8(argv[++i]);
+
+		if(arg == "-filter")		filter = value;
+		else if(arg == "-out")		output = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if(arg == "-warmup")	runner.setWarmupTime(value.getIntValue());
+		else if(arg == "-sample")	runner.setSampleTime(value.getIntValue());
+		else if(arg == "-samples")	runner.setNumSamples(value.getIntValue());
+		else if(arg == "-replay")	replayFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if(arg == "-speed")	replaySpeed = jmax(0.,value.getDoubleValue());
+		else
+		{
+			logText("error: unknown argument " + arg + "\n" + getUsage());
+			deleteSingletons();
+			return 1;
+		}
+	}
+
+	if(replayFile != File::nonexistent)
+	{
+		const int result = runReplay(replayFile,replaySpeed,output) ? 0 : 1;
+		deleteSingletons();
+		return result;
+	}
+
+	runner.runAll(filter);
+
+	int result = 0;
+	if(!runner.writeJson(output))
+	{
+		logText("error: can't write " + output.getFullPathName());
+		result = 1;
+	}
+	else
+	{
+		logText("results written to " + output.getFullPathName());
+	}
+
+	deleteSingletons();
+	return result;
+}
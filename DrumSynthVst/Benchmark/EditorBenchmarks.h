@@ -0,0 +1,341 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Log.h"
+#include "../PresetLoader.h"
+#include "../FastRandom.h"
+#include "../PatchGenerator.h"
+#include "../GreenLookAndFeel.h"
+#include "../MarkovName/Markov.h"
+#include "../Midi/MidiEncoder.h"
+#include "../Source/EmbeddedResources.h"
+#include "Benchmark.h"
+
+#define BENCHMARK_SEED			1234	// every run works on the same patches and names
+#define BENCHMARK_KNOB_SIZE		48		// the knob size of the voice panels
+#define BENCHMARK_KNOB_FRAMES	31
+
+//---------------------------------------------------------------------------
+/** a scratch folder in the temp directory, deleted again in cleanup()*/
+class FileBenchmark : public Benchmark
+{
+public:
+	FileBenchmark(const String& name) : Benchmark(name)
+	{
+	};
+
+	bool prepare()
+	{
+		mFolder = File::getSpecialLocation(File::tempDirectory).getNonexistentChildFile("drumsynth_benchmark",String::empty,false);
+		return mFolder.createDirectory();
+	};
+
+	void cleanup()
+	{
+		mFolder.deleteRecursively();
+	};
+
+protected:
+	/** a patch with random values*/
+	static void fillPatch(Patch& patch)
+	{
+		FastRandom random(BENCHMARK_SEED,0);
+		uint8_t values[NUM_PARAMS];
+		random.fillBytes(values,NUM_PARAMS);
+		patch.setValues(values);
+		patch.setName("BENCH");
+	};
+
+	File mFolder;
+};
+
+//---------------------------------------------------------------------------
+/** PresetLoader::loadPatch() of one .SND file, from the page cache*/
+class LoadPatchBenchmark : public FileBenchmark
+{
+public:
+	LoadPatchBenchmark() : FileBenchmark("loadPatch")
+	{
+	};
+
+	bool prepare()
+	{
+		if(!FileBenchmark::prepare()) return false;
+		Patch patch;
+		fillPatch(patch);
+		mFile = mFolder.getChildFile("bench.snd");
+		mLoader.savePatch(mFile,&patch);
+		return mFile.existsAsFile();
+	};
+
+	void run(int numOps)
+	{
+		for(int i=0;i<numOps;i++)
+		{
+			delete mLoader.loadPatch(mFile);
+		}
+	};
+
+private:
+	PresetLoader mLoader;
+	File mFile;
+};
+
+//---------------------------------------------------------------------------
+/** PresetLoader::savePatch() over the same .SND file*/
+class SavePatchBenchmark : public FileBenchmark
+{
+public:
+	SavePatchBenchmark() : FileBenchmark("savePatch")
+	{
+	};
+
+	bool prepare()
+	{
+		if(!FileBenchmark::prepare()) return false;
+		fillPatch(mPatch);
+		mFile = mFolder.getChildFile("bench.snd");
+		return true;
+	};
+
+	void run(int numOps)
+	{
+		for(int i=0;i<numOps;i++)
+		{
+			mLoader.savePatch(mFile,&mPatch);
+		}
+	};
+
+private:
+	PresetLoader mLoader;
+	Patch mPatch;
+	File mFile;
+};
+
+//---------------------------------------------------------------------------
+/** Markov::learn() of resources/namelist.txt in the working directory, like the editor at startup*/
+class MarkovLearnBenchmark : public Benchmark
+{
+public:
+	MarkovLearnBenchmark() : Benchmark("markovLearn")
+	{
+	};
+
+	bool prepare()
+	{
+		mNamelist = File::getCurrentWorkingDirectory().getChildFile("resources/namelist.txt");
+		if(!mNamelist.existsAsFile()) return false;
+		//the compiled model is used as it is, the list is only learned below
+		mMarkov = new Markov(EmbeddedResources::namelist_smm,EmbeddedResources::namelist_smmSize);
+		return true;
+	};
+
+	void run(int numOps)
+	{
+		for(int i=0;i<numOps;i++)
+		{
+			mMarkov->learn(mNamelist,MARKOV_MAX_ORDER);
+		}
+	};
+
+	void cleanup()
+	{
+		mMarkov = NULL;
+	};
+
+private:
+	ScopedPointer<Markov> mMarkov;
+	File mNamelist;
+};
+
+//---------------------------------------------------------------------------
+/** Markov::generateName() from the embedded model*/
+class GenerateNameBenchmark : public Benchmark
+{
+public:
+	GenerateNameBenchmark() : Benchmark("generateName"), mRandom(BENCHMARK_SEED,0), mChecksum(0)
+	{
+	};
+
+	bool prepare()
+	{
+		mMarkov = new Markov(EmbeddedResources::namelist_smm,EmbeddedResources::namelist_smmSize);
+		return true;
+	};
+
+	void run(int numOps)
+	{
+		char name[MARKOV_MAX_NAME_LENGTH+1];
+		for(int i=0;i<numOps;i++)
+		{
+			mChecksum += mMarkov->generateName(MARKOV_DEFAULT_ORDER,3,PATCH_NAME_LENGTH,mRandom,name);
+		}
+	};
+
+	void cleanup()
+	{
+		mMarkov = NULL;
+	};
+
+private:
+	ScopedPointer<Markov> mMarkov;
+	FastRandom mRandom;
+	int mChecksum;	// keeps the names from being optimised away
+};
+
+//---------------------------------------------------------------------------
+/** PatchGenerator::generateChild() of two random parents*/
+class GenerateChildBenchmark : public FileBenchmark
+{
+public:
+	GenerateChildBenchmark() : FileBenchmark("generateChild"), mRandom(BENCHMARK_SEED,0)
+	{
+	};
+
+	bool prepare()
+	{
+		if(!FileBenchmark::prepare()) return false;
+		//an empty parent folder, the checkpoint and votes go into the scratch folder
+		const File parents(mFolder.getChildFile("parents"));
+		const File output(mFolder.getChildFile("children"));
+		if(!parents.createDirectory() || !output.createDirectory()) return false;
+		mGenerator = new PatchGenerator(parents,output);
+
+		mRandom.fillBytes(mFather,NUM_PARAMS);
+		mRandom.fillBytes(mMother,NUM_PARAMS);
+		return true;
+	};
+
+	void run(int numOps)
+	{
+		for(int i=0;i<numOps;i++)
+		{
+			delete mGenerator->generateChild(mFather,mMother,1,mRandom);
+		}
+	};
+
+	void cleanup()
+	{
+		mGenerator = NULL;
+		FileBenchmark::cleanup();
+	};
+
+private:
+	ScopedPointer<PatchGenerator> mGenerator;
+	FastRandom mRandom;
+	uint8_t mFather[NUM_PARAMS];
+	uint8_t mMother[NUM_PARAMS];
+};
+
+//---------------------------------------------------------------------------
+/** GreenLookAndFeel::drawRotarySlider() with the knob film strip into an offscreen image*/
+class DrawRotarySliderBenchmark : public Benchmark
+{
+public:
+	DrawRotarySliderBenchmark() : Benchmark("drawRotarySlider"), mFrame(0)
+	{
+	};
+
+	bool prepare()
+	{
+		const Image knob(ImageCache::getFromMemory(EmbeddedResources::knob_png,EmbeddedResources::knob_pngSize));
+		if(!knob.isValid()) return false;
+
+		mLookAndFeel = new GreenLookAndFeel();
+		mLookAndFeel->setSliderImage(knob,BENCHMARK_KNOB_FRAMES,false);
+		mSlider = new Slider();
+		mSlider->setRange(0,BENCHMARK_KNOB_FRAMES-1,1);
+		mImage = Image(Image::ARGB,BENCHMARK_KNOB_SIZE,BENCHMARK_KNOB_SIZE,true);
+		return true;
+	};
+
+	void run(int numOps)
+	{
+		Graphics g(mImage);
+		for(int i=0;i<numOps;i++)
+		{
+			//a different frame every time, like a knob being turned
+			mFrame = (mFrame+1) % BENCHMARK_KNOB_FRAMES;
+			mSlider->setValue(mFrame,false);
+			mLookAndFeel->drawRotarySlider(g,0,0,BENCHMARK_KNOB_SIZE,BENCHMARK_KNOB_SIZE,
+				mFrame/(float)(BENCHMARK_KNOB_FRAMES-1),float_Pi*1.2f,float_Pi*2.8f,*mSlider);
+		}
+	};
+
+	void cleanup()
+	{
+		mSlider = NULL;
+		mLookAndFeel = NULL;
+		mImage = Image::null;
+	};
+
+private:
+	ScopedPointer<GreenLookAndFeel> mLookAndFeel;
+	ScopedPointer<Slider> mSlider;
+	Image mImage;
+	int mFrame;
+};
+
+//---------------------------------------------------------------------------
+/** MidiEncoder::encodeBytes() of NRPN parameters, the path of the MIDI transmitter.
+	Every change goes to another parameter, so the address is sent each time*/
+class NrpnEncodeBenchmark : public Benchmark
+{
+public:
+	NrpnEncodeBenchmark() : Benchmark("nrpnEncode"), mParameter(0), mChecksum(0)
+	{
+	};
+
+	void run(int numOps)
+	{
+		uint8_t bytes[MAX_BYTES_PER_PARAMETER];
+		for(int i=0;i<numOps;i++)
+		{
+			mParameter = (mParameter+1) % (NUM_PARAMS-128);
+			mChecksum += mEncoder.encodeBytes(128+mParameter,i&0x7f,bytes);
+		}
+	};
+
+private:
+	MidiEncoder mEncoder;
+	int mParameter;
+	int mChecksum;	// keeps the encoding from being optimised away
+};
+
+//---------------------------------------------------------------------------
+/** the benchmarks of the editor's hot paths, in the order they run*/
+static inline void addEditorBenchmarks(BenchmarkRunner& runner)
+{
+	runner.add(new LoadPatchBenchmark());
+	runner.add(new SavePatchBenchmark());
+	runner.add(new MarkovLearnBenchmark());
+	runner.add(new GenerateNameBenchmark());
+	runner.add(new GenerateChildBenchmark());
+	runner.add(new DrawRotarySliderBenchmark());
+	runner.add(new NrpnEncodeBenchmark());
+}
+//---------------------------------------------------------------------------
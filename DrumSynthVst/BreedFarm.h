@@ -0,0 +1,638 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./ChildBreeder.h"
+#include "./ObjectArena.h"
+#include "./PatchHash.h"
+#include "./Log.h"
+#include "./Preview/PatchFeatures.h"
+
+#define BREED_FARM_MAGIC				0x4d465053	// "SPFM", the header of every InterprocessConnection message
+#define BREED_FARM_CONNECT_TIMEOUT_MS	10000		// for the connection and the hello of a worker
+#define BREED_FARM_TASK_TIMEOUT_MS		300000		// a father that hasn't come back by then is bred elsewhere
+#define BREED_FARM_POLL_MS				50			// how often a waiting task looks for a stop
+#define BREED_FARM_CHUNK_CHILDREN		2048		// children per result message, far below the 10MB juce allows
+#define BREED_FARM_STOP_TIMEOUT_MS		2000
+
+#define BREED_FARM_HELLO		1	// worker -> number of cpus
+#define BREED_FARM_SETUP		2	// run, BreedSettings, features, number of parents, their load status, their records
+#define BREED_FARM_TASK			3	// run, task, father
+#define BREED_FARM_RESULT		4	// run, task, first child, children in this message, all children (-1 if the
+									// worker can't breed it), then per child mother, values, hash, features
+
+//---------------------------------------------------------------------------
+/** The children of one father as a BreedFarm worker sent them back*/
+struct BreedFarmResult
+{
+	Array<int> mothers;
+	MemoryBlock values;				// NUM_PARAMS per child
+	Array<int64> hashes;			// hashPatchValues() of the values, checked when they arrive
+	Array<PatchFeatures> features;	// empty unless the run asked for them
+
+	int getNumChildren() const
+	{
+		return mothers.size();
+	};
+
+	const uint8_t* getValues(int child) const
+	{
+		return (const uint8_t*)values.getData() + child*NUM_PARAMS;
+	};
+
+	void clear()
+	{
+		mothers.clearQuick();
+		values.setSize(0);
+		hashes.clearQuick();
+		features.clearQuick();
+	};
+};
+
+//---------------------------------------------------------------------------
+/** The coordinator side of a breeding farm: the workers on other machines
+	that breed the pairs of a PatchGenerator::runAllPairs() run.
+
+	startRun() sends the parent table and the BreedSettings to every worker
+	once, after that a father is one small task message and its children
+	come back packed, with their hashes and, if asked for, their features.
+	The children of a father are the same wherever it is bred, so the
+	coordinator dedupes, names and writes them as if it had bred them. Each
+	worker gets as many fathers at once as it has cpus, breedFather() picks
+	the one with the most free cpus, so the throughput grows with every
+	worker added.
+	A worker that drops its connection or doesn't answer in time is dropped
+	and its fathers are bred again on another one. breedFather() returns
+	false once none is left, the caller breeds the father itself then.
+	breedFather() is called from several threads at once.
+*/
+class BreedFarm
+{
+public:
+	BreedFarm() : mRunId(0), mNextTask(0), mNumLost(0)
+	{
+	};
+
+	~BreedFarm()
+	{
+		mWorkers.clear();
+	};
+
+	/** connects to a worker started with -worker and waits for its hello*/
+	bool addWorker(const String& hostName, int port)
+	{
+		ScopedPointer<Worker> worker(new Worker(hostName + ":" + String(port)));
+		if(!worker->connectToSocket(hostName,port,BREED_FARM_CONNECT_TIMEOUT_MS)) return false;
+		if(!worker->mHello.wait(BREED_FARM_CONNECT_TIMEOUT_MS) || worker->getNumCpus() <= 0) return false;
+
+		const ScopedLock sl(mLock);
+		mWorkers.add(worker.release());
+		return true;
+	};
+
+	/** the workers that are still connected*/
+	int getNumWorkers() const
+	{
+		const ScopedLock sl(mLock);
+		int num = 0;
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			if(mWorkers[i]->isAlive()) num++;
+		}
+		return num;
+	};
+
+	/** fathers the connected workers breed at once, the cpus of all of them*/
+	int getNumSlots() const
+	{
+		const ScopedLock sl(mLock);
+		int num = 0;
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			if(mWorkers[i]->isAlive()) num += mWorkers[i]->getNumCpus();
+		}
+		return num;
+	};
+
+	/** workers dropped because they were lost or too slow*/
+	int getNumLost() const
+	{
+		return mNumLost.get();
+	};
+
+	/** sends the parents and the settings of a run, the fathers of the last run are forgotten*/
+	void startRun(const PatchBatch& parents, const BreedSettings& settings, bool withFeatures)
+	{
+		MemoryBlock setup;
+		{
+			MemoryOutputStream out(setup,false);
+			out.writeInt(BREED_FARM_SETUP);
+			out.writeInt(++mRunId);
+			settings.write(out);
+			out.writeBool(withFeatures);
+			out.writeInt(parents.getNumPatches());
+			for(int i=0;i<parents.getNumPatches();i++)
+			{
+				out.writeByte((char)parents.getStatus(i));
+			}
+			out.write(parents.getData(),(size_t)parents.getNumPatches()*PATCH_DATA_SIZE);
+			out.flush();
+		}
+
+		const ScopedLock sl(mLock);
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			Worker* worker = mWorkers[i];
+			if(worker->isAlive() && !worker->sendMessage(setup)) dropWorker(worker);
+		}
+	};
+
+	/** the children of a father from the worker with the most free cpus, another one is tried
+		if it fails. false once no worker is left or the calling thread should exit*/
+	bool breedFather(int father, BreedFarmResult& result)
+	{
+		for(;;)
+		{
+			Worker* worker;
+			int task;
+			{
+				const ScopedLock sl(mLock);
+				worker = findFreeWorker();
+				if(worker == NULL) return false;
+				worker->mNumInFlight++;
+				task = mNextTask++;
+			}
+
+			const int status = worker->breed(mRunId,task,father,result);
+			{
+				const ScopedLock sl(mLock);
+				worker->mNumInFlight--;
+				if(status == Worker::BRED) return true;
+				if(status == Worker::STOPPED) return false;
+				dropWorker(worker);
+			}
+			logText("lost the breeding worker " + worker->getName() + ", father " + String(father) + " is bred again");
+		}
+	};
+
+private:
+	//-----------------------------------------------------------------------
+	class Worker : public InterprocessConnection
+	{
+	public:
+		enum { BRED, FAILED, STOPPED };
+
+		Worker(const String& name) : InterprocessConnection(false,BREED_FARM_MAGIC), mNumInFlight(0), mName(name), mNumCpus(0), mAlive(true)
+		{
+		};
+
+		~Worker()
+		{
+			disconnect();
+		};
+
+		const String& getName() const
+		{
+			return mName;
+		};
+
+		int getNumCpus() const
+		{
+			return mNumCpus.get();
+		};
+
+		bool isAlive() const
+		{
+			return mAlive.get() != 0;
+		};
+
+		/** sends the task and waits for all its children*/
+		int breed(int run, int task, int father, BreedFarmResult& result)
+		{
+			Pending pending(task,result);
+			{
+				const ScopedLock sl(mLock);
+				mPending.add(&pending);
+			}
+
+			MemoryBlock message;
+			{
+				MemoryOutputStream out(message,false);
+				out.writeInt(BREED_FARM_TASK);
+				out.writeInt(run);
+				out.writeInt(task);
+				out.writeInt(father);
+				out.flush();
+			}
+
+			int status = FAILED;
+			if(isAlive() && sendMessage(message))
+			{
+				Thread* thread = Thread::getCurrentThread();
+				const uint32 start = Time::getMillisecondCounter();
+				for(;;)
+				{
+					if(pending.done.wait(BREED_FARM_POLL_MS))
+					{
+						status = pending.failed ? FAILED : BRED;
+						break;
+					}
+					if(thread != NULL && thread->threadShouldExit())
+					{
+						status = STOPPED;
+						break;
+					}
+					if(Time::getMillisecondCounter() - start > BREED_FARM_TASK_TIMEOUT_MS) break;
+				}
+			}
+
+			const ScopedLock sl(mLock);
+			mPending.removeValue(&pending);
+			return status;
+		};
+
+		void connectionMade() {};
+
+		/** the tasks that wait for it are bred elsewhere*/
+		void connectionLost()
+		{
+			mAlive = 0;
+			mHello.signal();
+			const ScopedLock sl(mLock);
+			for(int i=0;i<mPending.size();i++)
+			{
+				mPending[i]->failed = true;
+				mPending[i]->done.signal();
+			}
+		};
+
+		void messageReceived(const MemoryBlock& message)
+		{
+			MemoryInputStream in(message,false);
+			const int type = in.readInt();
+			if(type == BREED_FARM_HELLO)
+			{
+				mNumCpus = jmax(1,in.readInt());
+				mHello.signal();
+				return;
+			}
+			if(type != BREED_FARM_RESULT) return;
+
+			in.readInt();	// the run, the task numbers are unique across runs
+			const int task = in.readInt();
+			const int first = in.readInt();
+			const int num = in.readInt();
+			const int total = in.readInt();
+
+			const ScopedLock sl(mLock);
+			Pending* pending = NULL;
+			for(int i=0;i<mPending.size() && pending == NULL;i++)
+			{
+				if(mPending[i]->task == task) pending = mPending[i];
+			}
+			//one that timed out already
+			if(pending == NULL) return;
+
+			if(total < 0 || first != pending->numReceived || num < 0 || first + num > total || !readChildren(in,num,*pending))
+			{
+				pending->failed = true;
+				pending->done.signal();
+				return;
+			}
+			pending->numReceived += num;
+			if(pending->numReceived == total) pending->done.signal();
+		};
+
+		WaitableEvent mHello;
+		int mNumInFlight;	// under the lock of the farm
+
+	private:
+		struct Pending
+		{
+			Pending(int taskNr, BreedFarmResult& r) : task(taskNr), result(r), numReceived(0), failed(false)
+			{
+				result.clear();
+			};
+
+			int task;
+			BreedFarmResult& result;
+			int numReceived;
+			bool failed;
+			WaitableEvent done;
+		};
+
+		/** appends num children, false if one doesn't match its hash*/
+		static bool readChildren(MemoryInputStream& in, int num, Pending& pending)
+		{
+			BreedFarmResult& result = pending.result;
+			const bool withFeatures = in.readBool();
+			const int64 childSize = 4 + NUM_PARAMS + 8 + (withFeatures ? PATCH_FEATURES_BYTES : 0);
+			if(num < 0 || in.getTotalLength() - in.getPosition() < (int64)num*childSize) return false;
+
+			result.values.ensureSize((size_t)(pending.numReceived+num)*NUM_PARAMS);
+			for(int c=0;c<num;c++)
+			{
+				result.mothers.add(in.readInt());
+				uint8_t* values = (uint8_t*)result.values.getData() + (pending.numReceived+c)*NUM_PARAMS;
+				in.read(values,NUM_PARAMS);
+				const int64 hash = in.readInt64();
+				if((int64)hashPatchValues(values) != hash) return false;
+				result.hashes.add(hash);
+				if(withFeatures)
+				{
+					PatchFeatures features;
+					features.read(in);
+					result.features.add(features);
+				}
+			}
+			return true;
+		};
+
+		const String mName;
+		Atomic<int> mNumCpus;
+		Atomic<int> mAlive;
+		CriticalSection mLock;
+		Array<Pending*> mPending;	// under the lock
+	};
+	//-----------------------------------------------------------------------
+
+	/** the live worker with the most cpus that aren't busy, under the lock*/
+	Worker* findFreeWorker()
+	{
+		Worker* best = NULL;
+		int bestFree = INT_MIN;
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			Worker* worker = mWorkers[i];
+			const int free = worker->getNumCpus() - worker->mNumInFlight;
+			if(worker->isAlive() && free > bestFree)
+			{
+				best = worker;
+				bestFree = free;
+			}
+		}
+		return best;
+	};
+
+	/** under the lock. The connection stays until the farm is deleted*/
+	void dropWorker(Worker* worker)
+	{
+		if(worker->isAlive()) ++mNumLost;
+		worker->connectionLost();
+	};
+
+	mutable CriticalSection mLock;
+	OwnedArray<Worker> mWorkers;	// under the lock, the lost ones stay until the farm is deleted
+	int mRunId;
+	int mNextTask;					// under the lock
+	Atomic<int> mNumLost;
+};
+
+//---------------------------------------------------------------------------
+/** The worker side of a breeding farm, started by the -worker job of the
+	console build. Every coordinator that connects gets its own pool of
+	one thread per cpu, which breeds the fathers it sends with the table
+	and the settings of its last setup and sends the children back in
+	chunks of BREED_FARM_CHUNK_CHILDREN.
+*/
+class BreedFarmServer : public InterprocessConnectionServer
+{
+public:
+	BreedFarmServer()
+	{
+	};
+
+	~BreedFarmServer()
+	{
+		stop();
+	};
+
+	bool start(int port)
+	{
+		stop();
+		return beginWaitingForSocket(port);
+	};
+
+	void stop()
+	{
+		InterprocessConnectionServer::stop();
+		const ScopedLock sl(mLock);
+		mConnections.clear();
+	};
+
+private:
+	/** the table and the settings of a setup, kept by the fathers that are still being bred*/
+	class Run : public ReferenceCountedObject
+	{
+	public:
+		typedef ReferenceCountedObjectPtr<Run> Ptr;
+
+		Run(int runId, const BreedSettings& settings, bool withFeatures, int numParents)
+		: id(runId), breeder(settings), features(withFeatures), parents(numParents)
+		{
+		};
+
+		const int id;
+		const ChildBreeder breeder;
+		const bool features;
+		PatchBatch parents;
+	};
+
+	//-----------------------------------------------------------------------
+	class Node : public InterprocessConnection
+	{
+	public:
+		Node() : InterprocessConnection(false,BREED_FARM_MAGIC), mPool(SystemStats::getNumCpus())
+		{
+		};
+
+		~Node()
+		{
+			mPool.removeAllJobs(true,BREED_FARM_STOP_TIMEOUT_MS,true);
+			disconnect();
+		};
+
+		void connectionMade()
+		{
+			MemoryBlock hello;
+			MemoryOutputStream out(hello,false);
+			out.writeInt(BREED_FARM_HELLO);
+			out.writeInt(SystemStats::getNumCpus());
+			out.flush();
+			sendMessage(hello);
+			logText("breeding for " + getConnectedHostName());
+		};
+
+		void connectionLost()
+		{
+			logText("the coordinator has gone");
+		};
+
+		void messageReceived(const MemoryBlock& message)
+		{
+			MemoryInputStream in(message,false);
+			const int type = in.readInt();
+			if(type == BREED_FARM_SETUP)
+			{
+				const int runId = in.readInt();
+				BreedSettings settings;
+				if(!settings.read(in)) return;
+				const bool withFeatures = in.readBool();
+				const int numParents = in.readInt();
+				if(numParents < 0 || in.getTotalLength() - in.getPosition() != (int64)numParents*(1+PATCH_DATA_SIZE)) return;
+
+				Run::Ptr run(new Run(runId,settings,withFeatures,numParents));
+				HeapBlock<uint8_t> status(jmax(1,numParents));
+				in.read(status,numParents);
+				for(int i=0;i<numParents;i++)
+				{
+					uint8_t data[PATCH_DATA_SIZE];
+					in.read(data,PATCH_DATA_SIZE);
+					run->parents.setPatch(i,data,status[i]);
+				}
+				const ScopedLock sl(mLock);
+				mRun = run;
+				logText("run " + String(runId) + ": " + String(numParents) + " parents");
+			}
+			else if(type == BREED_FARM_TASK)
+			{
+				const int runId = in.readInt();
+				const int task = in.readInt();
+				const int father = in.readInt();
+				Run::Ptr run;
+				{
+					const ScopedLock sl(mLock);
+					run = mRun;
+				}
+				if(run == NULL || run->id != runId || father < 0 || father >= run->parents.getNumPatches())
+				{
+					sendFailure(runId,task);
+					return;
+				}
+				mPool.addJob(new TaskJob(*this,run,task,father));
+			}
+		};
+
+	private:
+		class TaskJob : public ThreadPoolJob
+		{
+		public:
+			TaskJob(Node& owner, Run* run, int task, int father)
+			: ThreadPoolJob("breeding task"), mOwner(owner), mRun(run), mTask(task), mFather(father)
+			{
+			};
+
+			JobStatus runJob()
+			{
+				Array<int> mothers;
+				ChildBreeder::findMothers(mRun->parents,mFather,mothers);
+				ObjectArena<Patch> arena;
+				Array<Patch*> children;
+				for(int i=0;i<mothers.size();i++)
+				{
+					children.add(arena.create());
+				}
+				mRun->breeder.breedChildren(mRun->parents,mFather,mothers,children,NULL);
+
+				ScopedPointer<PatchFeatureExtractor> extractor;
+				if(mRun->features) extractor = new PatchFeatureExtractor();
+
+				//an empty father is one message with no children
+				int first = 0;
+				do
+				{
+					if(shouldExit()) return jobHasFinishedAndShouldBeDeleted;
+					const int num = jmin(BREED_FARM_CHUNK_CHILDREN,children.size()-first);
+					MemoryBlock message;
+					MemoryOutputStream out(message,false);
+					out.writeInt(BREED_FARM_RESULT);
+					out.writeInt(mRun->id);
+					out.writeInt(mTask);
+					out.writeInt(first);
+					out.writeInt(num);
+					out.writeInt(children.size());
+					out.writeBool(extractor != NULL);
+					for(int c=first;c<first+num;c++)
+					{
+						const uint8_t* values = children[c]->getValues();
+						out.writeInt(mothers[c]);
+						out.write(values,NUM_PARAMS);
+						out.writeInt64((int64)hashPatchValues(values));
+						if(extractor != NULL)
+						{
+							PatchFeatures features;
+							extractor->compute(values,features);
+							features.write(out);
+						}
+					}
+					out.flush();
+					if(!mOwner.sendMessage(message)) break;
+					first += num;
+				}
+				while(first < children.size());
+				return jobHasFinishedAndShouldBeDeleted;
+			};
+
+		private:
+			Node& mOwner;
+			Run::Ptr mRun;
+			const int mTask;
+			const int mFather;
+		};
+
+		void sendFailure(int runId, int task)
+		{
+			MemoryBlock message;
+			MemoryOutputStream out(message,false);
+			out.writeInt(BREED_FARM_RESULT);
+			out.writeInt(runId);
+			out.writeInt(task);
+			out.writeInt(0);
+			out.writeInt(0);
+			out.writeInt(-1);
+			out.flush();
+			sendMessage(message);
+		};
+
+		ThreadPool mPool;
+		CriticalSection mLock;
+		Run::Ptr mRun;		// of the last setup, under the lock
+	};
+	//-----------------------------------------------------------------------
+
+	/** on the listener thread*/
+	InterprocessConnection* createConnectionObject()
+	{
+		Node* node = new Node();
+		const ScopedLock sl(mLock);
+		mConnections.add(node);
+		return node;
+	};
+
+	CriticalSection mLock;
+	OwnedArray<Node> mConnections;	// the closed ones stay until stop()
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,193 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./PresetLoader.h"
+#include "./Patch.h"
+#include "./FastRandom.h"
+#include "./Crossover.h"
+#include "./ParameterLocks.h"
+#include "./Mutation.h"
+#include "./Library/PatchLineage.h"
+#include "./Log.h"
+
+#define BREED_SETTINGS_VERSION	1
+
+//---------------------------------------------------------------------------
+/** What a run of the PatchGenerator breeds with. Another machine that gets
+	the same settings and parents breeds the same children.
+*/
+struct BreedSettings
+{
+	uint64 seed;
+	int crossoverMode;
+	int mutationDistribution;
+	float mutationRate;
+	float maxMutationOffset;
+	bool locked[LOCK_NUM_CATEGORIES];	// ParameterLocks categories
+
+	void write(OutputStream& out) const
+	{
+		out.writeInt(BREED_SETTINGS_VERSION);
+		out.writeInt64((int64)seed);
+		out.writeInt(crossoverMode);
+		out.writeInt(mutationDistribution);
+		out.writeFloat(mutationRate);
+		out.writeFloat(maxMutationOffset);
+		out.writeInt(LOCK_NUM_CATEGORIES);
+		for(int i=0;i<LOCK_NUM_CATEGORIES;i++) out.writeBool(locked[i]);
+	};
+
+	/** false for settings of another version*/
+	bool read(InputStream& in)
+	{
+		if(in.readInt() != BREED_SETTINGS_VERSION) return false;
+		seed = (uint64)in.readInt64();
+		crossoverMode = in.readInt();
+		mutationDistribution = in.readInt();
+		mutationRate = in.readFloat();
+		maxMutationOffset = in.readFloat();
+		if(in.readInt() != LOCK_NUM_CATEGORIES) return false;
+		for(int i=0;i<LOCK_NUM_CATEGORIES;i++) locked[i] = in.readBool();
+		return true;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** The crossover and the mutation of a child, for the PatchGenerator and for
+	the BreedFarm workers that breed the pairs of its runs elsewhere.
+
+	runAllPairs() gives every father two random streams of the run seed, one
+	for the crossover and one for the mutation of its children. They are
+	numbered here, so a father bred on another machine gets the children it
+	would have got on this one.
+	An instance breeds with fixed settings, its methods can be called from
+	several threads at once.
+*/
+class ChildBreeder
+{
+public:
+	ChildBreeder(const BreedSettings& settings) : mSettings(settings)
+	{
+		for(int i=0;i<LOCK_NUM_CATEGORIES;i++)
+		{
+			mLocks.setCategoryLocked(i,settings.locked[i]);
+		}
+	};
+
+	/** the mothers of a father in runAllPairs(): every other parent that could be loaded*/
+	static void findMothers(const PatchBatch& parents, int father, Array<int>& mothers)
+	{
+		mothers.clearQuick();
+		if(parents.getStatus(father) != LOAD_OK) return;
+		for(int j=0;j<parents.getNumPatches();j++)
+		{
+			if(j != father && parents.getStatus(j) == LOAD_OK) mothers.add(j);
+		}
+	};
+
+	static uint64 getCrossoverStream(int father)
+	{
+		return (uint64)father;
+	};
+
+	/** behind the crossover streams and the one of the names*/
+	static uint64 getMutationStream(int numParents, int father)
+	{
+		return (uint64)(numParents+1+father);
+	};
+
+	/** the children of a father with one mother each, before the dedupe. deltas may be NULL*/
+	void breedChildren(const PatchBatch& parents, int father, const Array<int>& mothers, const Array<Patch*>& children, const Array<PatchDelta*>* deltas) const
+	{
+		FastRandom crossoverRandom(mSettings.seed,getCrossoverStream(father));
+		const uint8_t* fatherValues = parents.getPatchData(father) + PATCH_NAME_LENGTH;
+		for(int c=0;c<children.size();c++)
+		{
+			const uint8_t* mother = parents.getPatchData(mothers[c]) + PATCH_NAME_LENGTH;
+			crossover(mSettings.crossoverMode,mLocks,fatherValues,mother,children[c],deltas != NULL ? (*deltas)[c] : NULL,crossoverRandom);
+			//the parents come from files, so they are all generation 0
+			children[c]->setGeneration(1);
+		}
+
+		FastRandom mutationRandom(mSettings.seed,getMutationStream(parents.getNumPatches(),father));
+		for(int c=0;c<children.size();c++)
+		{
+			mutate(mLocks,mSettings.mutationRate,mSettings.maxMutationOffset,mSettings.mutationDistribution,mKernel,
+				children[c],deltas != NULL ? (*deltas)[c] : NULL,mutationRandom);
+		}
+	};
+
+	/** randomly picks each unlocked parameter from the father or the mother*/
+	static void crossover(int mode, const ParameterLocks& locks, const uint8_t* father, const uint8_t* mother, Patch* child, PatchDelta* delta, FastRandom& random)
+	{
+		LOG_VERBOSE("Combining parent parameters...");
+		//randomly select parameters from mother an father for child, one mask bit per parameter
+		uint8_t motherMask[PARAMETER_MASK_SIZE];
+		Crossover::fillMask(mode,motherMask,NUM_PARAMS,random);
+		//the locked lanes stay the father's
+		locks.applyTo(motherMask);
+
+		uint8_t values[NUM_PARAMS];
+		Crossover::blend(father,mother,motherMask,values,NUM_PARAMS);
+		child->setValues(values);
+		if(delta != NULL) delta->setMotherMask(motherMask);
+	};
+
+	/** offsets rate of the unlocked parameters by up to maxOffset of their range*/
+	static void mutate(const ParameterLocks& locks, float rate, float maxOffset, int distribution, const MutationKernel& kernel,
+		Patch* child, PatchDelta* delta, FastRandom& random)
+	{
+		//how many parameters to mutate? only the unlocked ones are candidates
+		const int numSites = locks.getNumUnlocked();
+		const int parameters2mutate = jmin((int)(rate * numSites),numSites);
+
+		LOG_VERBOSE("Mutating {} parameters out of {}",parameters2mutate,numSites);
+		uint8_t sites[NUM_PARAMS];
+		memcpy(sites,locks.getUnlockedParameters(),numSites);
+
+		//the offsets of the picked parameters are added and clamped to their bounds in one pass
+		short offsets[NUM_PARAMS];
+		uint8_t mutationMask[PARAMETER_MASK_SIZE];
+		MutationKernel::fillOffsets(distribution,sites,numSites,parameters2mutate,maxOffset,random,offsets,mutationMask);
+
+		uint8_t values[NUM_PARAMS];
+		kernel.apply(child->getValues(),offsets,mutationMask,values,1);
+		child->setValues(values);
+
+		for(int i=0;i<parameters2mutate;i++)
+		{
+			LOG_TRACE("Mutating parameter {} by {} new value: {}",sites[i],offsets[sites[i]],values[sites[i]]);
+			if(delta != NULL) delta->setMutation(sites[i],values[sites[i]]);
+		}
+	};
+
+private:
+	const BreedSettings mSettings;
+	ParameterLocks mLocks;
+	MutationKernel mKernel;
+};
+//---------------------------------------------------------------------------
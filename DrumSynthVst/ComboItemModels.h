@@ -0,0 +1,293 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./controllerAssignments.h"
+#include "./Patch.h"
+#include "./parameterRanges.h"
+
+#define NUM_MENUS			(MENU_SEQ_QUANT+1)	// the MENU_* numbers of menuText.h, 0 is none
+#define NUM_DTYPES			256					// a dtype with its menu in the upper 4 bit
+#define VALUE_TEXT_TABLE_SIZE	256				// texts of a ValueTextTable, every dtype fits
+
+//---------------------------------------------------------------------------
+/** The items of one kind of combo box: a text and the MIDI value it stands for.
+
+	Built once and never changed, every combo box of the kind takes its
+	items from here. The texts are shared Strings, so the combos of all
+	voices hold one copy, and a combo is filled without converting the
+	menu tables again. The item id of a value is value+1, so the id 0 of
+	"nothing selected" stays free.
+*/
+class ComboItemModel
+{
+public:
+	int getNumItems() const
+	{
+		return mTexts.size();
+	};
+
+	const String& getText(int index) const
+	{
+		return mTexts[index];
+	};
+
+	int getValue(int index) const
+	{
+		return mValues[index];
+	};
+
+	/** replaces the items of combo with these, the selection is cleared without a change message*/
+	void attachTo(ComboBox& combo) const
+	{
+		combo.clear(true);
+		for(int i=0;i<mTexts.size();i++)
+		{
+			combo.addItem(mTexts[i],valueToItemId(mValues.getUnchecked(i)));
+		}
+	};
+
+	static int valueToItemId(int value)
+	{
+		return value+1;
+	};
+
+	/** -1 if nothing is selected*/
+	static int itemIdToValue(int itemId)
+	{
+		return itemId-1;
+	};
+
+private:
+	friend class ComboItemModels;
+
+	void add(const String& text, int value)
+	{
+		mTexts.add(text);
+		mValues.add(value);
+	};
+
+	/** the first byte of a menu text array is its number of entries, entry i is the value i-1*/
+	template <int N>
+	void addMenu(const char names[][N])
+	{
+		for(int i=1;i<=(int)names[0][0];i++)
+		{
+			add(names[i],i-1);
+		}
+	};
+
+	StringArray mTexts;
+	Array<int> mValues;
+};
+
+//---------------------------------------------------------------------------
+/** The text of every value of one dtype, in the units the UI shows (PM63
+	is -63..63): the menu entries of a DTYPE_MENU and the numbers of the
+	others. Built once per dtype, a knob's text box takes the shared String
+	instead of formatting its value each time the value changes. The menu
+	texts are the Strings of the combo items.
+*/
+class ValueTextTable
+{
+public:
+	/** a value outside the table gets the text of the nearest end*/
+	const String& getText(int value) const
+	{
+		return mTexts[jlimit(0,VALUE_TEXT_TABLE_SIZE-1,value - mMin)];
+	};
+
+private:
+	friend class ComboItemModels;
+
+	ValueTextTable(int dtype, const ComboItemModel& menu) : mMin(computeParameterMin(dtype))
+	{
+		for(int i=0;i<VALUE_TEXT_TABLE_SIZE;i++)
+		{
+			mTexts[i] = i < menu.getNumItems() ? menu.getText(i) : String(mMin + i);
+		}
+	};
+
+	const int mMin;
+	String mTexts[VALUE_TEXT_TABLE_SIZE];	// by value - mMin
+};
+
+//---------------------------------------------------------------------------
+/** The ComboItemModels of the editor, each built the first time it is asked
+	for: one per menu of menuText.h, the parameters of each menu page for the
+	velocity and LFO targets, and the few lists that have no menu. Message
+	thread only.
+*/
+class ComboItemModels
+{
+public:
+	ComboItemModels()
+	{
+		mModels.insertMultiple(0,NULL,NUM_MODELS);
+		mValueTexts.insertMultiple(0,NULL,NUM_DTYPES);
+	};
+
+	~ComboItemModels()
+	{
+		for(int i=0;i<mModels.size();i++)
+		{
+			delete mModels.getUnchecked(i);
+		}
+		for(int i=0;i<mValueTexts.size();i++)
+		{
+			delete mValueTexts.getUnchecked(i);
+		}
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (ComboItemModels, false)
+
+	/** the entries of a MENU_* menu, an empty model for an unknown one*/
+	const ComboItemModel& getMenu(int menu)
+	{
+		return get(jlimit(0,NUM_MENUS-1,menu));
+	};
+
+	/** every parameter on the menu pages of a voice, the value is its page*8+position*/
+	const ComboItemModel& getTargets(int page)
+	{
+		return get(MODEL_TARGETS + jlimit(0,NUM_PAGES-1,page));
+	};
+
+	/** the waveforms of the transient generator, numbered*/
+	const ComboItemModel& getTransientWaves()
+	{
+		return get(MODEL_TRANS_WAVES);
+	};
+
+	/** the voices an LFO can modulate, as the values 1 to 6*/
+	const ComboItemModel& getVoices()
+	{
+		return get(MODEL_VOICES);
+	};
+
+	/** one "---", for a combo of a parameter without any of the others*/
+	const ComboItemModel& getPlaceholder()
+	{
+		return get(MODEL_PLACEHOLDER);
+	};
+
+	/** the texts of the values of a parameter, shared by all parameters of its dtype*/
+	const ValueTextTable& getValueTexts(int parameterNr)
+	{
+		const int dtype = Patch::getDtype(parameterNr);
+		ValueTextTable* table = mValueTexts.getUnchecked(dtype);
+		if(table == NULL)
+		{
+			//menu 0 is none, the numeric types get its empty model
+			table = new ValueTextTable(dtype,getMenu((dtype&0x0F) == DTYPE_MENU ? dtype>>4 : 0));
+			mValueTexts.set(dtype,table);
+		}
+		return *table;
+	};
+
+private:
+	enum
+	{
+		MODEL_TRANS_WAVES = NUM_MENUS,
+		MODEL_VOICES,
+		MODEL_PLACEHOLDER,
+		MODEL_TARGETS,
+		NUM_MODELS = MODEL_TARGETS + NUM_PAGES
+	};
+
+	const ComboItemModel& get(int key)
+	{
+		ComboItemModel* model = mModels.getUnchecked(key);
+		if(model == NULL)
+		{
+			model = build(key);
+			mModels.set(key,model);
+		}
+		return *model;
+	};
+
+	static ComboItemModel* build(int key)
+	{
+		ComboItemModel* model = new ComboItemModel();
+		switch(key)
+		{
+		case MENU_AUDIO_OUT:	model->addMenu(outputNames);		break;
+		case MENU_FILTER:		model->addMenu(filterTypes);		break;
+		case MENU_WAVEFORM:		model->addMenu(waveformNames);		break;
+		case MENU_SYNC_RATES:	model->addMenu(syncRateNames);		break;
+		case MENU_LFO_WAVES:	model->addMenu(lfoWaveNames);		break;
+		case MENU_RETRIGGER:	model->addMenu(retriggerNames);		break;
+		case MENU_SEQ_QUANT:	model->addMenu(quantisationNames);	break;
+		case MENU_NEXT_PATTERN:	model->addMenu(nextPatternNames);	break;
+		case MENU_ROLL_RATES:	model->addMenu(rollRateNames);		break;
+
+		case MODEL_TRANS_WAVES:
+			for(int i=0;i<NUM_TRANS_WAVES;i++)
+			{
+				model->add(String(i),i);
+			}
+			break;
+
+		case MODEL_VOICES:
+			model->add("Drum 1",1);
+			model->add("Drum 2",2);
+			model->add("Drum 3",3);
+			model->add("Snare",4);
+			model->add("Cymbal",5);
+			model->add("Hat",6);
+			break;
+
+		case MODEL_PLACEHOLDER:
+			model->add("---",0);
+			break;
+
+		default:
+			if(key >= MODEL_TARGETS) addTargets(*model,key - MODEL_TARGETS);
+			break;
+		}
+		return model;
+	};
+
+	static void addTargets(ComboItemModel& model, int page)
+	{
+		for(int i=0;i<NUM_SUB_PAGES*8;i++)
+		{
+			const uint8_t subPage			= (i&MASK_PAGE)>>PAGE_SHIFT;
+			const uint8_t activeParameter	= i&MASK_PARAMETER;
+			const uint8_t text				= *(&(menuPages[page][subPage].top1) + activeParameter);
+
+			if(text != TEXT_EMPTY)
+			{
+				model.add(String(catNames[valueNames[text].category]) + String(" ") + String(longNames[valueNames[text].longName]),i);
+			}
+		}
+	};
+
+	Array<ComboItemModel*> mModels;		// NULL until built
+	Array<ValueTextTable*> mValueTexts;	// by dtype, NULL until built
+};
+//---------------------------------------------------------------------------
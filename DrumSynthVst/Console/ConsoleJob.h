@@ -0,0 +1,1196 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Log.h"
+#include "../PresetLoader.h"
+#include "../PatchHash.h"
+#include "../NameGenerator.h"
+#include "../FastRandom.h"
+#include "../PatchGenerator.h"
+#include "../RandomPatchGenerator.h"
+#include "../SurrogateModel.h"
+#include "../VoteDatabase.h"
+#include "../Library/PatchLibrary.h"
+#include "../Library/ShardedLibrary.h"
+#include "../Library/SysExBank.h"
+#include "../Library/PatchJson.h"
+#include "../Library/PatchQueryIndex.h"
+#include "../Library/PatchColumnStore.h"
+#include "../Library/PatchClusters.h"
+#include "../Library/PatchArchive.h"
+#include "../Library/PatchImporter.h"
+#include "../Library/SdCardExport.h"
+#include "../Library/LibrarySync.h"
+#include "../BreedFarm.h"
+#include "../Preview/PreviewRenderer.h"
+
+#define CONSOLE_SYSEX_EXTENSION		".syx"
+#define CONSOLE_WAV_EXTENSION		".wav"
+#define CONSOLE_PROGRESS_STEP		10		// percent between two progress lines of the rendering
+#define CONSOLE_SCORE_GRAIN			256		// random candidates per item of the surrogate scoring
+#define CONSOLE_SHARD_GRAIN			1024	// records a worker appends to its shard at a time
+
+//---------------------------------------------------------------------------
+/** One batch run of the console build, set up from command line arguments
+	or from a line of a job file (see getUsage()).
+
+	A job either breeds a generation from a folder of parents (-breed), on
+	this machine or on the -farm workers, breeds for another machine
+	(-worker), pulls a library from another machine (-sync) or serves one
+	(-serve), or
+	works on a set of patches: -in loads them, -random adds new ones, then
+	they are deduplicated, renamed, written, copied to a card, rendered,
+	clustered and summed up (-stats), in that order. The patches are kept as
+	PATCH_DATA_SIZE records back to back, in the order they were loaded.
+	Everything is logged with logText(), the console build sends it to stdout.
+*/
+class ConsoleJob : private PreviewBatchRenderer::Listener
+{
+public:
+	ConsoleJob()
+	: mDedupe(false),
+	mRename(false),
+	mIndexChildren(false),
+	mHasSeed(false),
+	mSeed(0),
+	mNameOrder(MARKOV_DEFAULT_ORDER),
+	mOutputMode(OUTPUT_SND_FILES),
+	mCrossoverMode(CROSSOVER_UNIFORM),
+	mMutationDistribution(MUTATION_UNIFORM),
+	mSurvivalMode(SURVIVAL_FITNESS),
+	mNumGenerations(0),
+	mNumClusters(0),
+	mServePort(0),
+	mWorkerPort(0),
+	mNumPatches(0),
+	mNumRandom(0),
+	mScreeningFactor(1),
+	mLastProgress(-1)
+	{
+	};
+
+	/** returns false and sets getError() for unknown or incomplete arguments*/
+	bool parse(const StringArray& args)
+	{
+		for(int i=0;i<args.size();i++)
+		{
+			const String arg = args[i];
+			const bool hasValue = i+1 < args.size();
+			const String value = hasValue ? args[i+1] : String::empty;
+
+			if(arg == "-dedupe")
+			{
+				mDedupe = true;
+				continue;
+			}
+			if(arg == "-rename")
+			{
+				mRename = true;
+				continue;
+			}
+			if(arg == "-index")
+			{
+				mIndexChildren = true;
+				continue;
+			}
+			if(!hasValue)
+			{
+				mError = arg + " needs a value";
+				return false;
+			}
+			i++;
+
+			if(arg == "-in")				mInputs.add(File::getCurrentWorkingDirectory().getChildFile(value));
+			else if(arg == "-out")			mOutput = File::getCurrentWorkingDirectory().getChildFile(value);
+			else if(arg == "-render")		mRenderTarget = File::getCurrentWorkingDirectory().getChildFile(value);
+			else if(arg == "-breed")		mParentFolder = File::getCurrentWorkingDirectory().getChildFile(value);
+			else if(arg == "-target")		mSpectralTarget = File::getCurrentWorkingDirectory().getChildFile(value);
+			else if(arg == "-evolve")		mNumGenerations = value.getIntValue();
+			else if(arg == "-names")		mNameOrder = jlimit(1,MARKOV_MAX_ORDER,value.getIntValue());
+			else if(arg == "-sdcard")		mCardFolder = File::getCurrentWorkingDirectory().getChildFile(value);
+			else if(arg == "-where")		mWhere = value;
+			else if(arg == "-cluster")		mNumClusters = jlimit(1,PATCH_CLUSTERS_MAX,value.getIntValue());
+			else if(arg == "-sync")			mSyncSource = value;
+			else if(arg == "-quarantine")	mQuarantine = File::getCurrentWorkingDirectory().getChildFile(value);
+			else if(arg == "-random")
+			{
+				mNumRandom = value.getIntValue();
+				if(mNumRandom <= 0)
+				{
+					mError = "-random needs a number of patches";
+					return false;
+				}
+			}
+			else if(arg == "-screen")
+			{
+				mScreeningFactor = value.getIntValue();
+				if(mScreeningFactor <= 1)
+				{
+					mError = "-screen needs a factor above 1";
+					return false;
+				}
+			}
+			else if(arg == "-serve")
+			{
+				mServePort = value.getIntValue();
+				if(mServePort <= 0 || mServePort > 65535)
+				{
+					mError = "-serve needs a port";
+					return false;
+				}
+			}
+			else if(arg == "-farm")
+			{
+				const String port = value.fromLastOccurrenceOf(":",false,false);
+				if(!value.containsChar(':') || !port.containsOnly("0123456789") || port.isEmpty() || value.startsWithChar(':'))
+				{
+					mError = "-farm needs host:port";
+					return false;
+				}
+				mFarmWorkers.add(value);
+			}
+			else if(arg == "-worker")
+			{
+				mWorkerPort = value.getIntValue();
+				if(mWorkerPort <= 0 || mWorkerPort > 65535)
+				{
+					mError = "-worker needs a port";
+					return false;
+				}
+			}
+			else if(arg == "-stats")
+			{
+				StringArray names;
+				names.addTokens(value,",",String::empty);
+				names.trim();
+				names.removeEmptyStrings();
+				for(int n=0;n<names.size();n++)
+				{
+					const int parameterNr = PatchQuery::parseParameter(names[n],mError);
+					if(parameterNr < 0) return false;
+					mStatsParameters.add(parameterNr);
+					mStatsNames.add(names[n]);
+				}
+			}
+			else if(arg == "-seed")
+			{
+				mSeed = (uint64)value.getLargeIntValue();
+				mHasSeed = true;
+			}
+			else if(arg == "-mode")
+			{
+				if(value == "snd")				mOutputMode = OUTPUT_SND_FILES;
+				else if(value == "library")		mOutputMode = OUTPUT_LIBRARY;
+				else if(value == "lineage")		mOutputMode = OUTPUT_LINEAGE;
+				else
+				{
+					mError = "unknown output mode " + value;
+					return false;
+				}
+			}
+			else if(arg == "-crossover")
+			{
+				if(value == "uniform")			mCrossoverMode = CROSSOVER_UNIFORM;
+				else if(value == "one")			mCrossoverMode = CROSSOVER_ONE_POINT;
+				else if(value == "two")			mCrossoverMode = CROSSOVER_TWO_POINT;
+				else
+				{
+					mError = "unknown crossover " + value;
+					return false;
+				}
+			}
+			else if(arg == "-mutation")
+			{
+				if(value == "uniform")			mMutationDistribution = MUTATION_UNIFORM;
+				else if(value == "gaussian")	mMutationDistribution = MUTATION_GAUSSIAN;
+				else
+				{
+					mError = "unknown mutation " + value;
+					return false;
+				}
+			}
+			else if(arg == "-survival")
+			{
+				if(value == "fitness")			mSurvivalMode = SURVIVAL_FITNESS;
+				else if(value == "pareto")		mSurvivalMode = SURVIVAL_PARETO;
+				else
+				{
+					mError = "unknown survival " + value;
+					return false;
+				}
+			}
+			else if(arg == "-lock")
+			{
+				StringArray names;
+				names.addTokens(value,",",String::empty);
+				names.trim();
+				names.removeEmptyStrings();
+				for(int n=0;n<names.size();n++)
+				{
+					const int category = ParameterLocks::findCategory(names[n]);
+					if(category < 0)
+					{
+						mError = "unknown category " + names[n];
+						return false;
+					}
+					mLockedCategories.add(category);
+				}
+			}
+			else
+			{
+				mError = "unknown argument " + arg;
+				return false;
+			}
+		}
+
+		if(mWorkerPort > 0)
+		{
+			if(args.size() != 2)
+			{
+				mError = "-worker is a job of its own";
+				return false;
+			}
+			return true;
+		}
+		if(mFarmWorkers.size() > 0 && (mParentFolder == File::nonexistent || mNumGenerations > 0 || mOutputMode == OUTPUT_LINEAGE))
+		{
+			mError = "-farm needs -breed of all pairs with -mode snd or library";
+			return false;
+		}
+		if(mSyncSource.isNotEmpty() || mServePort > 0)
+		{
+			if(mParentFolder != File::nonexistent || mNumRandom > 0 || mDedupe || mRename || mRenderTarget != File::nonexistent || mCardFolder != File::nonexistent || mStatsParameters.size() > 0 || mNumClusters > 0)
+			{
+				mError = "-sync and -serve can't be combined with -breed, -random, -dedupe, -rename, -sdcard, -render, -cluster or -stats";
+				return false;
+			}
+			if(mSyncSource.isNotEmpty() && mServePort > 0)
+			{
+				mError = "-sync and -serve are separate jobs";
+				return false;
+			}
+			if(mSyncSource.isNotEmpty() && (mInputs.size() > 0 || !mOutput.hasFileExtension(PATCH_LIBRARY_EXTENSION)))
+			{
+				mError = "-sync needs a .spb library as -out and no -in";
+				return false;
+			}
+			if(mServePort > 0 && (mInputs.size() != 1 || !mInputs[0].hasFileExtension(PATCH_LIBRARY_EXTENSION) || mOutput != File::nonexistent))
+			{
+				mError = "-serve needs one .spb library as -in and no -out";
+				return false;
+			}
+			return true;
+		}
+		if(mParentFolder != File::nonexistent)
+		{
+			if(mOutput == File::nonexistent)
+			{
+				mError = "-breed needs an -out folder";
+				return false;
+			}
+			if(mInputs.size() > 0 || mNumRandom > 0 || mDedupe || mRename || mRenderTarget != File::nonexistent || mCardFolder != File::nonexistent || mStatsParameters.size() > 0 || mNumClusters > 0)
+			{
+				mError = "-breed can't be combined with -in, -random, -dedupe, -rename, -sdcard, -render, -cluster or -stats";
+				return false;
+			}
+		}
+		else if(mInputs.size() == 0 && mNumRandom == 0)
+		{
+			mError = "nothing to do, give -breed, -in or -random";
+			return false;
+		}
+		if(mQuarantine != File::nonexistent && mInputs.size() == 0)
+		{
+			mError = "-quarantine needs -in";
+			return false;
+		}
+		if(mScreeningFactor > 1 && mNumRandom == 0)
+		{
+			mError = "-screen needs -random";
+			return false;
+		}
+		if(mSurvivalMode == SURVIVAL_PARETO && mNumGenerations <= 0)
+		{
+			mError = "-survival pareto needs -evolve";
+			return false;
+		}
+		if(mSpectralTarget != File::nonexistent && mSurvivalMode != SURVIVAL_PARETO)
+		{
+			mError = "-target needs -survival pareto";
+			return false;
+		}
+		if(mWhere.isNotEmpty() && mStatsParameters.size() == 0 && mCardFolder == File::nonexistent)
+		{
+			mError = "-where needs -stats or -sdcard";
+			return false;
+		}
+		PatchQuery query;
+		if(mWhere.isNotEmpty() && !PatchQuery::parse(mWhere,query,mError)) return false;
+		if(mNumClusters > 0 && getClusterLibrary() == File::nonexistent)
+		{
+			mError = "-cluster needs a .spb library as -out, or as the only -in";
+			return false;
+		}
+		return true;
+	};
+
+	const String& getError() const
+	{
+		return mError;
+	};
+
+	/** runs the job on the calling thread, the work itself is spread over all cpus*/
+	bool run()
+	{
+		if(mParentFolder != File::nonexistent) return runBreed();
+		if(mSyncSource.isNotEmpty()) return runSync();
+		if(mServePort > 0) return runServe();
+		if(mWorkerPort > 0) return runWorker();
+
+		mRecords.setSize(0);
+		mNumPatches = 0;
+		for(int i=0;i<mInputs.size();i++)
+		{
+			if(!load(mInputs.getReference(i))) return false;
+		}
+		if(mInputs.size() > 0) logText(String(mNumPatches) + " patches loaded");
+
+		if(mNumRandom > 0)	addRandom();
+		if(mDedupe)		dedupe();
+		if(mRename)		rename();
+
+		if(mOutput != File::nonexistent && !write(mOutput)) return false;
+		if(mCardFolder != File::nonexistent && !exportToCard()) return false;
+		if(mRenderTarget != File::nonexistent && !render(mRenderTarget)) return false;
+		if(mNumClusters > 0 && !cluster()) return false;
+		if(mStatsParameters.size() > 0 && !printStats()) return false;
+		return true;
+	};
+
+	static String getUsage()
+	{
+		return String(
+			"DrumSynthConsole [-verbose] [job arguments] | -jobs <file>\n"
+			"\n"
+			"patch sets:\n"
+			"  -in <path>          .SND folder, .spb library, .sps sharded library, .spz archive, .syx bank or\n"
+			"                      .json list, can be repeated.\n"
+			"                      .SND files of the wrong size or with values out of range are rejected\n"
+			"  -quarantine <dir>   copy the rejected .SND files there, with a report of what is wrong with them\n"
+			"  -random <n>         add n new named patches with random values, unlike each other and the -in ones\n"
+			"  -screen <factor>    draw factor times as many random patches and keep the ones the votes\n"
+			"                      score best\n"
+			"  -dedupe             drop patches that sound like an earlier one\n"
+			"  -rename             give every patch a new unique name\n"
+			"  -names <order>      order of the name generator, 1-") + String(MARKOV_MAX_ORDER) + String("\n"
+			"  -seed <n>           random seed of the names, the breeding, the random patches and the families\n"
+			"  -out <path>         write a .spb library, a .spz archive, a .syx bank, a .json list or a folder of .SND files,\n"
+			"                      or append to a .sps sharded library, from all cpus and in no particular order\n"
+			"  -sdcard <folder>    copy the patches to a mounted card, numbered as the firmware reads them\n"
+			"  -render <path>      render one .wav with cue points, or a folder with a .wav per patch\n"
+			"  -cluster <k>        sort the patches of the library into k families, written next to it\n"
+			"  -stats <params>     mean, variance and histogram of each parameter and how they correlate,\n"
+			"                      comma separated as p8 or \"decay on voice 1\"\n"
+			"  -where <query>      -stats and -sdcard only of the patches a patch browser search finds\n"
+			"\n"
+			"breeding:\n"
+			"  -breed <folder>     breed from the .SND files in folder into the -out folder\n"
+			"  -mode <m>           snd, library or lineage\n"
+			"  -index              with -mode snd also render the children into the patch index of -out\n"
+			"  -crossover <c>      uniform, one or two\n"
+			"  -mutation <m>       uniform or gaussian offsets\n"
+			"  -lock <categories>  keep the father's values of these menu categories, comma separated as\n"
+			"                      oscillator,filter,lfo. the global parameters are never bred. -random\n"
+			"                      keeps the values of the first -in patch for them\n"
+			"  -evolve <n>         breed n generations from the saved population instead of all pairs\n"
+			"  -survival <s>       fitness, or pareto for the best fronts of votes, surrogate score,\n"
+			"                      novelty and -target\n"
+			"  -target <file>      .SND file whose sound the pareto survival pulls the children towards\n"
+			"  -farm <host:port>   breed the pairs on a -worker on another machine, can be repeated\n"
+			"  -worker <port>      breed for the -farm of other machines until stopped\n"
+			"\n"
+			"library sync:\n"
+			"  -sync <source>      make the -out library a copy of a .spb library on a share or of\n"
+			"                      host:port, only the records it lacks are transferred\n"
+			"  -serve <port>       serve the -in library to -sync on other machines until stopped\n"
+			"\n"
+			"-jobs runs one job per line of a text file, lines starting with # are skipped\n"
+			"-verbose logs every bred child, and every bred parameter if the build compiled that in\n");
+	};
+
+private:
+	bool runSync()
+	{
+		const String port = mSyncSource.fromLastOccurrenceOf(":",false,false);
+		const String host = mSyncSource.upToLastOccurrenceOf(":",false,false);
+		const bool remote = host.length() > 1 && port.containsOnly("0123456789") && port.isNotEmpty()
+			&& !host.containsAnyOf("\\/");
+
+		ScopedPointer<LibrarySyncSource> source;
+		if(remote)
+		{
+			LibrarySyncClient* client = new LibrarySyncClient();
+			source = client;
+			if(!client->connect(host,port.getIntValue()))
+			{
+				mError = "can't connect to " + mSyncSource;
+				return false;
+			}
+		}
+		else
+		{
+			const File library(File::getCurrentWorkingDirectory().getChildFile(mSyncSource));
+			LibraryShareSource* share = new LibraryShareSource(library);
+			source = share;
+			if(!library.existsAsFile() || !share->open())
+			{
+				mError = "can't read " + library.getFullPathName();
+				return false;
+			}
+		}
+
+		String report;
+		if(!LibrarySync::pull(*source,mOutput,report))
+		{
+			mError = "sync failed, " + report;
+			return false;
+		}
+		logText(mOutput.getFileName() + ": " + report);
+		return true;
+	};
+
+	bool runServe()
+	{
+		LibrarySyncServer server;
+		if(!server.start(mInputs[0],mServePort))
+		{
+			mError = "can't serve " + mInputs[0].getFullPathName() + " on port " + String(mServePort);
+			return false;
+		}
+		logText("serving " + String(server.getNumRecords()) + " records of " + mInputs[0].getFileName() + " on port " + String(mServePort));
+		for(;;)
+		{
+			Thread::sleep(1000);
+		}
+	};
+
+	bool runWorker()
+	{
+		BreedFarmServer server;
+		if(!server.start(mWorkerPort))
+		{
+			mError = "can't listen on port " + String(mWorkerPort);
+			return false;
+		}
+		logText("breeding with " + String(SystemStats::getNumCpus()) + " cpus on port " + String(mWorkerPort));
+		for(;;)
+		{
+			Thread::sleep(1000);
+		}
+	};
+
+	bool runBreed()
+	{
+		if(!mParentFolder.isDirectory())
+		{
+			mError = "no parent folder " + mParentFolder.getFullPathName();
+			return false;
+		}
+		if(mOutputMode == OUTPUT_SND_FILES && !mOutput.createDirectory())
+		{
+			mError = "can't create " + mOutput.getFullPathName();
+			return false;
+		}
+
+		PatchGenerator generator(mParentFolder,mOutput);
+		generator.setOutputMode(mOutputMode);
+		generator.setIndexChildren(mIndexChildren);
+		generator.setCrossoverMode(mCrossoverMode);
+		generator.setMutationDistribution(mMutationDistribution);
+		generator.setSurvivalMode(mSurvivalMode);
+		if(mSpectralTarget != File::nonexistent)
+		{
+			if(!mSpectralTarget.existsAsFile())
+			{
+				mError = "no target " + mSpectralTarget.getFullPathName();
+				return false;
+			}
+			PresetLoader loader;
+			ScopedPointer<Patch> target(loader.loadPatch(mSpectralTarget));
+			generator.setSpectralTarget(target->getValues());
+		}
+		for(int i=0;i<mLockedCategories.size();i++)
+		{
+			generator.getLocks().setCategoryLocked(mLockedCategories[i],true);
+		}
+		generator.setNameOrder(mNameOrder);
+		if(mHasSeed) generator.setSeed(mSeed);
+
+		//a worker that can't be reached is left out, the pairs are bred here if none is left
+		BreedFarm farm;
+		for(int i=0;i<mFarmWorkers.size();i++)
+		{
+			const String& worker = mFarmWorkers[i];
+			if(farm.addWorker(worker.upToLastOccurrenceOf(":",false,false),worker.fromLastOccurrenceOf(":",false,false).getIntValue()))
+			{
+				logText("breeding on " + worker);
+			}
+			else
+			{
+				logText("can't reach the worker " + worker);
+			}
+		}
+		if(mFarmWorkers.size() > 0)
+		{
+			logText(String(farm.getNumWorkers()) + " workers with " + String(farm.getNumSlots()) + " cpus");
+			generator.setFarm(&farm);
+		}
+
+		if(mNumGenerations > 0)
+		{
+			generator.setNumGenerations(mNumGenerations);
+			generator.evolve();
+		}
+		else
+		{
+			generator.combineAllParents();
+		}
+		generator.waitUntilFinished(-1);
+		return true;
+	};
+
+	bool load(const File& path)
+	{
+		if(path.hasFileExtension(SHARDED_LIBRARY_EXTENSION)) return loadShards(path);
+
+		if(path.isDirectory())
+		{
+			Array<File> files;
+			path.findChildFiles(files,File::findFiles,false,"*.snd");
+			DefaultElementComparator<File> comparator;
+			files.sort(comparator);
+
+			//messy collections are checked on the way in, with -dedupe the copies are dropped right away
+			const double start = Time::getMillisecondCounterHiRes();
+			PatchImporter importer;
+			importer.setDedupe(mDedupe);
+			mNumPatches += importer.import(files,mRecords);
+			const StringArray& report = importer.getReport();
+			for(int i=0;i<report.size();i++)
+			{
+				logText(report[i]);
+			}
+			logText(path.getFileName() + ": " + String(importer.getNumImported()) + " of " + String(files.size()) + " files imported, "
+				+ String(importer.getNumRejected()) + " rejected, " + String(importer.getNumDuplicates()) + " duplicates, "
+				+ String((Time::getMillisecondCounterHiRes()-start)/1000.0,2) + " s");
+			if(mQuarantine != File::nonexistent && !importer.quarantine(mQuarantine))
+			{
+				mError = "can't quarantine into " + mQuarantine.getFullPathName();
+				return false;
+			}
+			return true;
+		}
+
+		if(path.hasFileExtension(PATCH_LIBRARY_EXTENSION)) return loadLibrary(path);
+
+		if(path.hasFileExtension(PATCH_ARCHIVE_EXTENSION))
+		{
+			PatchArchive archive;
+			if(!archive.open(path))
+			{
+				mError = "can't read the archive " + path.getFullPathName();
+				return false;
+			}
+			for(int i=0;i<archive.getNumPatches();i++)
+			{
+				addRecord(archive.getPatchData(i));
+			}
+			return true;
+		}
+
+		if(path.hasFileExtension(CONSOLE_SYSEX_EXTENSION))
+		{
+			//the bank is decoded into a library next to the target
+			TemporaryFile temp(path.withFileExtension(PATCH_LIBRARY_EXTENSION));
+			if(SysExBank::importBank(path,temp.getFile()) < 0)
+			{
+				mError = "can't read the bank " + path.getFullPathName();
+				return false;
+			}
+			return loadLibrary(temp.getFile());
+		}
+
+		if(path.hasFileExtension(PATCH_JSON_EXTENSION))
+		{
+			TemporaryFile temp(path.withFileExtension(PATCH_LIBRARY_EXTENSION));
+			if(PatchJson::importLibrary(path,temp.getFile()) < 0)
+			{
+				mError = "can't read the patch list " + path.getFullPathName();
+				return false;
+			}
+			return loadLibrary(temp.getFile());
+		}
+
+		mError = "don't know how to read " + path.getFullPathName();
+		return false;
+	};
+
+	bool loadLibrary(const File& file)
+	{
+		PatchLibrary library;
+		if(!library.open(file))
+		{
+			mError = "can't read the library " + file.getFullPathName();
+			return false;
+		}
+		for(int i=0;i<library.getNumPatches();i++)
+		{
+			addRecord(library.getPatchData(i));
+		}
+		return true;
+	};
+
+	/** the patches the writers had flushed when the job got to it*/
+	bool loadShards(const File& folder)
+	{
+		ShardedLibrarySnapshot::Ptr snapshot(ShardedLibrarySnapshot::open(folder));
+		if(snapshot == NULL)
+		{
+			mError = "can't read the sharded library " + folder.getFullPathName();
+			return false;
+		}
+		for(int i=0;i<snapshot->getNumPatches();i++)
+		{
+			addRecord(snapshot->getPatchData(i));
+		}
+		return true;
+	};
+
+	void addRecord(const uint8_t* data)
+	{
+		mRecords.append(data,PATCH_DATA_SIZE);
+		mNumPatches++;
+	};
+
+	uint8_t* getRecord(int index)
+	{
+		return (uint8_t*)mRecords.getData() + index*PATCH_DATA_SIZE;
+	};
+
+	/** appends -random patches. the locked categories and the globals keep the values of the
+		first patch, an empty one without -in. the duplicates of earlier patches are dropped,
+		with -screen the surrogate of the votes picks the best of the candidates, then they get
+		new names. the same seed and patches give the same result*/
+	void addRandom()
+	{
+		const double start = Time::getMillisecondCounterHiRes();
+
+		RandomPatchGenerator generator;
+		ParameterLocks locks;
+		for(int i=0;i<mLockedCategories.size();i++)
+		{
+			locks.setCategoryLocked(mLockedCategories[i],true);
+		}
+		generator.setLocks(locks);
+		Patch empty;
+		generator.setBase(mNumPatches > 0 ? getRecord(0)+PATCH_NAME_LENGTH : empty.getValues());
+
+		SurrogateModel surrogate;
+		if(mScreeningFactor > 1)
+		{
+			VoteDatabase::getInstance()->addVotesTo(surrogate);
+			surrogate.updateIndex();
+			if(!surrogate.isTrained()) logText("not enough votes to screen, the first random patches are kept");
+		}
+		const bool screen = mScreeningFactor > 1 && surrogate.isTrained();
+		const int numCandidates = screen ? mNumRandom*mScreeningFactor : mNumRandom;
+
+		HeapBlock<uint8_t> candidates((size_t)numCandidates*NUM_PARAMS);
+		generator.generate(mSeed,candidates,numCandidates);
+
+		PatchHashSet seen(mNumPatches+numCandidates);
+		for(int i=0;i<mNumPatches;i++)
+		{
+			seen.add(getRecord(i)+PATCH_NAME_LENGTH,i);
+		}
+		Array<int> order;
+		order.ensureStorageAllocated(numCandidates);
+		for(int c=0;c<numCandidates;c++)
+		{
+			if(seen.add(candidates + (size_t)c*NUM_PARAMS,mNumPatches+c)) order.add(c);
+		}
+		const int numUnique = order.size();
+
+		if(screen)
+		{
+			HeapBlock<float> scores(numCandidates);
+			ScoreTask task(surrogate,candidates,order,scores);
+			ParallelFor::getInstance()->execute(order.size(),CONSOLE_SCORE_GRAIN,task);
+			ScoreComparator comparator(scores);
+			order.sort(comparator,true);
+		}
+		const int numKept = jmin(mNumRandom,order.size());
+
+		PatchNameSet taken(mNumPatches+numKept);
+		for(int i=0;i<mNumPatches;i++)
+		{
+			taken.add(String((const char*)getRecord(i),PATCH_NAME_LENGTH).trim());
+		}
+		NameGenerator names;
+		names.setOrder(mNameOrder);
+		FastRandom random(mSeed,0);
+		HeapBlock<char> newNames(jmax(1,numKept)*NAME_SIZE);
+		names.generateNames(numKept,taken,random,newNames);
+
+		for(int i=0;i<numKept;i++)
+		{
+			uint8_t record[PATCH_DATA_SIZE];
+			const char* name = newNames + i*NAME_SIZE;
+			memset(record,0,PATCH_NAME_LENGTH);
+			memcpy(record,name,jmin(PATCH_NAME_LENGTH,(int)strlen(name)));
+			memcpy(record+PATCH_NAME_LENGTH,candidates + (size_t)order[i]*NUM_PARAMS,NUM_PARAMS);
+			addRecord(record);
+		}
+		logText(String(numKept) + " random patches added of " + String(numCandidates) + " drawn, "
+			+ String(numCandidates-numUnique) + " duplicates, " + String((Time::getMillisecondCounterHiRes()-start)/1000.0,2) + " s");
+	};
+
+	/** the surrogate scores of the random candidates in order*/
+	class ScoreTask : public ParallelTask
+	{
+	public:
+		ScoreTask(const SurrogateModel& surrogate, const uint8_t* candidates, const Array<int>& order, float* scores)
+		: mSurrogate(surrogate),
+		mCandidates(candidates),
+		mOrder(order),
+		mScores(scores)
+		{
+		};
+
+		void run(int begin, int end, int)
+		{
+			for(int i=begin;i<end;i++)
+			{
+				const int c = mOrder.getUnchecked(i);
+				mScores[c] = mSurrogate.score(mCandidates + (size_t)c*NUM_PARAMS);
+			}
+		};
+
+	private:
+		const SurrogateModel& mSurrogate;
+		const uint8_t* mCandidates;
+		const Array<int>& mOrder;
+		float* mScores;
+	};
+
+	/** best score first, candidates with the same score keep their order*/
+	class ScoreComparator
+	{
+	public:
+		ScoreComparator(const float* scores) : mScores(scores)
+		{
+		};
+
+		int compareElements(int a, int b) const
+		{
+			return (mScores[a] > mScores[b]) ? -1 : (mScores[a] < mScores[b]) ? 1 : 0;
+		};
+
+	private:
+		const float* mScores;
+	};
+
+	/** keeps the first of every group of patches with the same values*/
+	void dedupe()
+	{
+		PatchHashSet seen(mNumPatches);
+		int numKept = 0;
+		for(int i=0;i<mNumPatches;i++)
+		{
+			if(!seen.add(getRecord(i)+PATCH_NAME_LENGTH,i)) continue;
+			if(numKept != i) memcpy(getRecord(numKept),getRecord(i),PATCH_DATA_SIZE);
+			numKept++;
+		}
+		logText(String(mNumPatches-numKept) + " duplicates removed");
+		mNumPatches = numKept;
+		mRecords.setSize((size_t)mNumPatches*PATCH_DATA_SIZE);
+	};
+
+	/** the same seed and patches give the same names*/
+	void rename()
+	{
+		NameGenerator names;
+		names.setOrder(mNameOrder);
+
+		PatchNameSet taken(mNumPatches);
+		FastRandom random(mSeed,0);
+		HeapBlock<char> newNames(jmax(1,mNumPatches)*NAME_SIZE);
+		names.generateNames(mNumPatches,taken,random,newNames);
+
+		for(int i=0;i<mNumPatches;i++)
+		{
+			const char* name = newNames + i*NAME_SIZE;
+			uint8_t* data = getRecord(i);
+			memset(data,0,PATCH_NAME_LENGTH);
+			memcpy(data,name,jmin(PATCH_NAME_LENGTH,(int)strlen(name)));
+		}
+		logText(String(mNumPatches) + " patches renamed");
+	};
+
+	bool write(const File& target)
+	{
+		bool ok;
+		if(target.hasFileExtension(PATCH_LIBRARY_EXTENSION))
+		{
+			ok = PatchLibrary::write(target,mRecords.getData(),mNumPatches);
+		}
+		else if(target.hasFileExtension(SHARDED_LIBRARY_EXTENSION))
+		{
+			ok = appendShards(target);
+		}
+		else if(target.hasFileExtension(CONSOLE_SYSEX_EXTENSION))
+		{
+			ok = SysExBank::exportBank(mRecords.getData(),mNumPatches,target);
+		}
+		else if(target.hasFileExtension(PATCH_JSON_EXTENSION))
+		{
+			ok = PatchJson::exportLibrary(mRecords.getData(),mNumPatches,target);
+		}
+		else if(target.hasFileExtension(PATCH_ARCHIVE_EXTENSION))
+		{
+			ok = PatchArchive::write(target,mRecords.getData(),mNumPatches);
+		}
+		else
+		{
+			ok = PatchLibrary::exportToFolder(target,mRecords.getData(),mNumPatches) == mNumPatches;
+		}
+
+		if(!ok)
+		{
+			mError = "can't write " + target.getFullPathName();
+			return false;
+		}
+		logText(String(mNumPatches) + " patches written to " + target.getFullPathName());
+		return true;
+	};
+
+	/** every worker appends its share of the records through a writer of its own, then
+		this waits for the compaction that may have started*/
+	bool appendShards(const File& target)
+	{
+		ShardedLibrary library(target);
+		if(!library.isValid()) return false;
+
+		OwnedArray<ShardWriter> writers;
+		for(int i=0;i<ParallelFor::getInstance()->getNumWorkers();i++)
+		{
+			writers.add(library.createWriter());
+		}
+		ShardTask task(writers,(const uint8_t*)mRecords.getData());
+		ParallelFor::getInstance()->execute(mNumPatches,CONSOLE_SHARD_GRAIN,task);
+
+		bool ok = true;
+		for(int i=0;i<writers.size();i++)
+		{
+			ok = writers[i]->close() && ok;
+		}
+		writers.clear();
+		return library.waitForCompaction(-1) && ok;
+	};
+
+	/** appends records to the writer of the worker*/
+	class ShardTask : public ParallelTask
+	{
+	public:
+		ShardTask(OwnedArray<ShardWriter>& writers, const uint8_t* records) : mWriters(writers), mRecords(records)
+		{
+		};
+
+		void run(int begin, int end, int workerIndex)
+		{
+			ShardWriter* writer = mWriters.getUnchecked(workerIndex);
+			for(int i=begin;i<end;i++)
+			{
+				writer->addPatch(mRecords + (size_t)i*PATCH_DATA_SIZE);
+			}
+		};
+
+	private:
+		OwnedArray<ShardWriter>& mWriters;
+		const uint8_t* mRecords;
+	};
+
+	bool render(const File& target)
+	{
+		PreviewBatchRenderer renderer(target,!target.hasFileExtension(CONSOLE_WAV_EXTENSION));
+		for(int i=0;i<mNumPatches;i++)
+		{
+			const uint8_t* data = getRecord(i);
+			renderer.addPatch(data+PATCH_NAME_LENGTH,String((const char*)data,PATCH_NAME_LENGTH).trim());
+		}
+
+		mLastProgress = -1;
+		renderer.render(this);
+		if(renderer.getNumWritten() != mNumPatches)
+		{
+			mError = "rendered " + String(renderer.getNumWritten()) + " of " + String(mNumPatches) + " patches to " + target.getFullPathName();
+			return false;
+		}
+		logText(String(mNumPatches) + " patches rendered to " + target.getFullPathName());
+		return true;
+	};
+
+	/** the -out library, or the -in library as it was read. nonexistent if there is no library*/
+	File getClusterLibrary() const
+	{
+		if(mOutput.hasFileExtension(PATCH_LIBRARY_EXTENSION)) return mOutput;
+		if(mInputs.size() == 1 && mInputs.getReference(0).hasFileExtension(PATCH_LIBRARY_EXTENSION) && mNumRandom == 0 && !mDedupe && !mRename)
+		{
+			return mInputs.getReference(0);
+		}
+		return File::nonexistent;
+	};
+
+	bool cluster()
+	{
+		const File file = getClusterLibrary();
+		PatchLibrary library;
+		if(!library.open(file))
+		{
+			mError = "can't read the library " + file.getFullPathName();
+			return false;
+		}
+
+		const double start = Time::getMillisecondCounterHiRes();
+		PatchClusterer clusterer;
+		clusterer.setNumClusters(mNumClusters);
+		clusterer.setSeed(mSeed);
+		PatchClusters clusters;
+		if(!clusterer.run(library,clusters))
+		{
+			mError = "no patches to cluster";
+			return false;
+		}
+		if(!clusters.save(library))
+		{
+			mError = "can't write " + PatchClusters::getClusterFile(file).getFullPathName();
+			return false;
+		}
+
+		logText(String(library.getNumPatches()) + " patches in " + String(clusters.getNumClusters()) + " families, "
+			+ String(clusterer.getNumPasses()) + " passes, " + String((Time::getMillisecondCounterHiRes()-start)/1000.0,2) + " s");
+		for(int c=0;c<clusters.getNumClusters();c++)
+		{
+			logText("family " + String(c+1) + ": " + String(clusters.getSize(c)) + " patches, like "
+				+ library.getPatchName(clusters.getRepresentative(c)).trim());
+		}
+		return true;
+	};
+
+	/** the file of a library with the records of the job. a library on its own is used as it
+		is, so it keeps its sidecar files for the next run, anything else goes through temp*/
+	bool getJobLibrary(File& libraryFile, ScopedPointer<TemporaryFile>& temp)
+	{
+		if(mInputs.size() == 1 && mInputs.getReference(0).hasFileExtension(PATCH_LIBRARY_EXTENSION) && mNumRandom == 0 && !mDedupe && !mRename)
+		{
+			libraryFile = mInputs.getReference(0);
+			return true;
+		}
+
+		temp = new TemporaryFile(PATCH_LIBRARY_EXTENSION);
+		libraryFile = temp->getFile();
+		if(!PatchLibrary::write(libraryFile,mRecords.getData(),mNumPatches))
+		{
+			mError = "can't write " + libraryFile.getFullPathName();
+			return false;
+		}
+		return true;
+	};
+
+	/** the records of the library -where finds, in file order*/
+	bool findWhere(PatchLibrary& library, Array<int>& matches)
+	{
+		PatchQuery query;
+		if(!PatchQuery::parse(mWhere,query,mError)) return false;
+
+		PatchQueryIndex index;
+		index.setLibrary(library);
+		index.find(query,matches);
+		logText(String(matches.size()) + " of " + String(library.getNumPatches()) + " patches match " + mWhere);
+		return true;
+	};
+
+	/** the patches, or the ones -where finds, in their order*/
+	bool exportToCard()
+	{
+		MemoryBlock selected;
+		const void* records = mRecords.getData();
+		int numPatches = mNumPatches;
+		if(mWhere.isNotEmpty())
+		{
+			File libraryFile;
+			ScopedPointer<TemporaryFile> temp;
+			PatchLibrary library;
+			Array<int> matches;
+			if(!getJobLibrary(libraryFile,temp)) return false;
+			if(!library.open(libraryFile))
+			{
+				mError = "can't read the library " + libraryFile.getFullPathName();
+				return false;
+			}
+			if(!findWhere(library,matches)) return false;
+
+			selected.setSize((size_t)matches.size()*PATCH_DATA_SIZE);
+			for(int i=0;i<matches.size();i++)
+			{
+				memcpy((uint8_t*)selected.getData() + i*PATCH_DATA_SIZE,library.getPatchData(matches[i]),PATCH_DATA_SIZE);
+			}
+			records = selected.getData();
+			numPatches = matches.size();
+			library.close();
+		}
+
+		const double start = Time::getMillisecondCounterHiRes();
+		SdCardExporter exporter;
+		if(!exporter.exportPatches(mCardFolder,records,numPatches))
+		{
+			mError = exporter.getError();
+			return false;
+		}
+		logText(String(exporter.getNumWritten()) + " patches written to " + mCardFolder.getFullPathName() + " and verified, "
+			+ String((Time::getMillisecondCounterHiRes()-start)/1000.0,2) + " s");
+		return true;
+	};
+
+	bool printStats()
+	{
+		File libraryFile;
+		ScopedPointer<TemporaryFile> temp;
+		if(!getJobLibrary(libraryFile,temp)) return false;
+
+		PatchLibrary library;
+		PatchColumnStore columns;
+		if(!library.open(libraryFile) || !columns.open(library))
+		{
+			mError = "can't write the columns of " + libraryFile.getFullPathName();
+			return false;
+		}
+
+		PatchSelection selection(library.getNumPatches());
+		const PatchSelection* selected = NULL;
+		if(mWhere.isNotEmpty())
+		{
+			Array<int> matches;
+			if(!findWhere(library,matches)) return false;
+			selection.select(matches);
+			selected = &selection;
+		}
+
+		for(int i=0;i<mStatsParameters.size();i++)
+		{
+			const ColumnStats stats = columns.getStats(mStatsParameters[i],selected);
+			int counts[COLUMNS_HISTOGRAM_SIZE];
+			columns.getHistogram(mStatsParameters[i],counts,selected);
+
+			String histogram;
+			for(int v=0;v<COLUMNS_HISTOGRAM_SIZE;v++)
+			{
+				if(counts[v] > 0) histogram << " " << v << ":" << counts[v];
+			}
+			logText(mStatsNames[i] + " (p" + String(mStatsParameters[i]) + "): mean " + String(stats.mean,2)
+				+ ", variance " + String(stats.variance,2) + ", values" + histogram);
+		}
+		for(int a=0;a<mStatsParameters.size();a++)
+		{
+			for(int b=a+1;b<mStatsParameters.size();b++)
+			{
+				const double correlation = columns.getCorrelation(mStatsParameters[a],mStatsParameters[b],selected);
+				logText("correlation of " + mStatsNames[a] + " and " + mStatsNames[b] + ": " + String(correlation,3));
+			}
+		}
+
+		//the mapping has to go before the files can be deleted
+		columns.close();
+		library.close();
+		if(temp != NULL) PatchColumnStore::getColumnFile(libraryFile).deleteFile();
+		return true;
+	};
+
+	//----- PreviewBatchRenderer::Listener
+	void renderProgress(int numDone, int numPatches)
+	{
+		const int percent = numDone*100/jmax(1,numPatches);
+		if(percent/CONSOLE_PROGRESS_STEP == mLastProgress/CONSOLE_PROGRESS_STEP) return;
+
+		mLastProgress = percent;
+		logText("rendering " + String(percent) + "%");
+	};
+
+	bool shouldStopRendering()
+	{
+		return false;
+	};
+
+	Array<File> mInputs;
+	File mOutput;
+	File mRenderTarget;
+	File mCardFolder;
+	File mQuarantine;			// nonexistent for no -quarantine
+	bool mDedupe;
+	bool mRename;
+
+	File mParentFolder;
+	bool mIndexChildren;
+	bool mHasSeed;
+	uint64 mSeed;
+	int mNameOrder;
+	int mOutputMode;
+	int mCrossoverMode;
+	int mMutationDistribution;
+	int mSurvivalMode;
+	File mSpectralTarget;
+	int mNumGenerations;
+	int mNumClusters;			// 0 for no -cluster
+
+	Array<int> mLockedCategories;
+	Array<int> mStatsParameters;
+	StringArray mStatsNames;	// as they were given
+	String mWhere;
+	String mSyncSource;			// a library file or host:port, empty for no -sync
+	int mServePort;				// 0 for no -serve
+	StringArray mFarmWorkers;	// host:port of every -farm
+	int mWorkerPort;			// 0 for no -worker
+
+	MemoryBlock mRecords;		// PATCH_DATA_SIZE records back to back
+	int mNumPatches;
+	int mNumRandom;				// 0 for no -random
+	int mScreeningFactor;		// 1 without -screen
+	int mLastProgress;			// percent of the last progress line
+
+	String mError;
+};
+//---------------------------------------------------------------------------
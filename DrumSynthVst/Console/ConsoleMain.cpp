@@ -0,0 +1,112 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Source/Singletons.h"
+#include "./ConsoleJob.h"
+
+//---------------------------------------------------------------------------
+/** runs one job, returns false if it failed*/
+static bool runJob(const StringArray& args)
+{
+	ConsoleJob job;
+	if(!job.parse(args) || !job.run())
+	{
+		logText("error: " + job.getError());
+		return false;
+	}
+	return true;
+}
+
+/** one job per line, the jobs run one after the other and each uses all cpus*/
+static int runJobFile(const File& file)
+{
+	if(!file.existsAsFile())
+	{
+		logText("error: no job file " + file.getFullPathName());
+		return 1;
+	}
+
+	StringArray lines;
+	file.readLines(lines);
+
+	int numFailed = 0;
+	for(int i=0;i<lines.size();i++)
+	{
+		const String line = lines[i].trim();
+		if(line.isEmpty() || line.startsWithChar('#')) continue;
+
+		StringArray args;
+		args.addTokens(line,true);
+		args.trim();
+		args.removeEmptyStrings();
+		//quoted paths keep their spaces, the quotes go
+		for(int a=0;a<args.size();a++)
+		{
+			args.set(a,args[a].unquoted());
+		}
+
+		logText("job " + String(i+1) + ": " + line);
+		if(!runJob(args)) numFailed++;
+	}
+	return numFailed > 0 ? 1 : 0;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	//juce 1.54 only has the GUI initialiser, it also clears up the juce statics at the end
+	ScopedJuceInitialiser_GUI juceInitialiser;
+
+	StringArray args;
+	for(int i=1;i<argc;i++)
+	{
+		args.add(String::fromUTF8(argv[i]));
+	}
+	//applies to every job, so it comes before the job arguments
+	if(args[0] == "-verbose")
+	{
+		LogLevel::set(LOG_LEVEL_TRACE);
+		args.remove(0);
+	}
+
+	int result;
+	if(args.size() == 0 || args[0] == "-help")
+	{
+		logText(ConsoleJob::getUsage());
+		result = args.size() == 0 ? 1 : 0;
+	}
+	else if(args[0] == "-jobs" && args.size() == 2)
+	{
+		result = runJobFile(File::getCurrentWorkingDirectory().getChildFile(args[1]));
+	}
+	else
+	{
+		result = runJob(args) ? 0 : 1;
+	}
+
+	deleteSingletons();
+	return result;
+}
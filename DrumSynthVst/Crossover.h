@@ -0,0 +1,132 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "FastRandom.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define CROSSOVER_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define CROSSOVER_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define CROSSOVER_UNIFORM	0	// every parameter from a random parent
+#define CROSSOVER_ONE_POINT	1	// father up to a random parameter, mother from there on
+#define CROSSOVER_TWO_POINT	2	// one random run of parameters from the mother
+
+//---------------------------------------------------------------------------
+/** Builds a child from two parents with a mother bitmask.
+
+	Bit i of the mask (mask[i>>3] & (1<<(i&7))) selects the mother value
+	for parameter i. The blend handles 16 parameters per step with SSE2 or
+	NEON byte selects and falls back to branchless scalar code.
+*/
+class Crossover
+{
+public:
+	/** fills numBits bits of mask the way the given crossover mode wants it*/
+	static void fillMask(int mode, uint8_t* mask, int numBits, FastRandom& random)
+	{
+		switch(mode)
+		{
+		default:
+			jassertfalse;
+		case CROSSOVER_UNIFORM:
+			random.fillMask(mask,numBits);
+			break;
+
+		case CROSSOVER_ONE_POINT:
+			setRange(mask,numBits,1+random.nextInt(numBits-1),numBits);
+			break;
+
+		case CROSSOVER_TWO_POINT:
+			{
+				int start = random.nextInt(numBits);
+				int end = random.nextInt(numBits);
+				if(start > end)
+				{
+					const int tmp = start;
+					start = end;
+					end = tmp;
+				}
+				setRange(mask,numBits,start,end+1);
+			}
+			break;
+		}
+	};
+
+	/** child[i] = mother[i] where mask bit i is set, father[i] otherwise*/
+	static void blend(const uint8_t* father, const uint8_t* mother, const uint8_t* mask, uint8_t* child, int num)
+	{
+		int i = 0;
+#if CROSSOVER_USE_SSE2
+		const __m128i bits = _mm_setr_epi8(1,2,4,8,16,32,64,-128,1,2,4,8,16,32,64,-128);
+		for(;i+16<=num;i+=16)
+		{
+			//spread the two mask bytes over 8 lanes each and test one bit per lane
+			__m128i m = _mm_cvtsi32_si128(mask[i>>3] | (mask[(i>>3)+1]<<8));
+			m = _mm_unpacklo_epi8(m,m);
+			m = _mm_unpacklo_epi16(m,m);
+			m = _mm_unpacklo_epi32(m,m);
+			const __m128i select = _mm_cmpeq_epi8(_mm_and_si128(m,bits),bits);
+
+			const __m128i f = _mm_loadu_si128((const __m128i*)(father+i));
+			const __m128i mo = _mm_loadu_si128((const __m128i*)(mother+i));
+			_mm_storeu_si128((__m128i*)(child+i),_mm_or_si128(_mm_and_si128(select,mo),_mm_andnot_si128(select,f)));
+		}
+#elif CROSSOVER_USE_NEON
+		static const uint8_t bitValues[16] = {1,2,4,8,16,32,64,128,1,2,4,8,16,32,64,128};
+		const uint8x16_t bits = vld1q_u8(bitValues);
+		for(;i+16<=num;i+=16)
+		{
+			const uint8x16_t m = vcombine_u8(vdup_n_u8(mask[i>>3]),vdup_n_u8(mask[(i>>3)+1]));
+			const uint8x16_t select = vtstq_u8(m,bits);
+			vst1q_u8(child+i,vbslq_u8(select,vld1q_u8(mother+i),vld1q_u8(father+i)));
+		}
+#endif
+		//the tail (or everything without SIMD)
+		for(;i<num;i++)
+		{
+			const uint8_t select = (uint8_t)(0 - ((mask[i>>3]>>(i&7))&1));
+			child[i] = (uint8_t)(father[i] ^ ((father[i]^mother[i]) & select));
+		}
+	};
+
+private:
+	/** mask bits [start:end) are set, the others cleared*/
+	static void setRange(uint8_t* mask, int numBits, int start, int end)
+	{
+		memset(mask,0,(numBits+7)/8);
+		for(int i=start;i<end;i++)
+		{
+			mask[i>>3] |= (uint8_t)(1<<(i&7));
+		}
+	};
+};
+//---------------------------------------------------------------------------
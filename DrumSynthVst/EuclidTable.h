@@ -0,0 +1,74 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+#define EUCLID_MAX_LENGTH	16	// PAR_EUKLID_LENGTH and PAR_EUKLID_STEPS are 1..16
+
+//---------------------------------------------------------------------------
+/** Every euclidean rhythm the sequencer can play, so nothing is computed
+	while a knob is turned or a pattern is drawn.
+
+	Row length-1, column numHits: the hits spread as evenly as possible over
+	length steps, bit n is step n. Step 0 is always a hit, which gives the
+	same rhythms as Bjorklund's algorithm up to a rotation. More hits than
+	steps play every step. The table was generated with
+	(i*numHits) % length < numHits for every step i.
+*/
+static const uint16 euclidMasks[EUCLID_MAX_LENGTH][EUCLID_MAX_LENGTH+1] =
+{
+	{0x0000,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001,0x0001},	// length 1
+	{0x0000,0x0001,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003,0x0003},	// length 2
+	{0x0000,0x0001,0x0005,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007,0x0007},	// length 3
+	{0x0000,0x0001,0x0005,0x000d,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f,0x000f},	// length 4
+	{0x0000,0x0001,0x0009,0x0015,0x001d,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f,0x001f},	// length 5
+	{0x0000,0x0001,0x0009,0x0015,0x002d,0x003d,0x003f,0x003f,0x003f,0x003f,0x003f,0x003f,0x003f,0x003f,0x003f,0x003f,0x003f},	// length 6
+	{0x0000,0x0001,0x0011,0x0029,0x0055,0x006d,0x007d,0x007f,0x007f,0x007f,0x007f,0x007f,0x007f,0x007f,0x007f,0x007f,0x007f},	// length 7
+	{0x0000,0x0001,0x0011,0x0049,0x0055,0x00b5,0x00dd,0x00fd,0x00ff,0x00ff,0x00ff,0x00ff,0x00ff,0x00ff,0x00ff,0x00ff,0x00ff},	// length 8
+	{0x0000,0x0001,0x0021,0x0049,0x00a9,0x0155,0x016d,0x01dd,0x01fd,0x01ff,0x01ff,0x01ff,0x01ff,0x01ff,0x01ff,0x01ff,0x01ff},	// length 9
+	{0x0000,0x0001,0x0021,0x0091,0x0129,0x0155,0x02b5,0x036d,0x03bd,0x03fd,0x03ff,0x03ff,0x03ff,0x03ff,0x03ff,0x03ff,0x03ff},	// length 10
+	{0x0000,0x0001,0x0041,0x0111,0x0249,0x02a9,0x0555,0x05b5,0x06ed,0x07bd,0x07fd,0x07ff,0x07ff,0x07ff,0x07ff,0x07ff,0x07ff},	// length 11
+	{0x0000,0x0001,0x0041,0x0111,0x0249,0x0529,0x0555,0x0ad5,0x0b6d,0x0ddd,0x0f7d,0x0ffd,0x0fff,0x0fff,0x0fff,0x0fff,0x0fff},	// length 12
+	{0x0000,0x0001,0x0081,0x0221,0x0491,0x0949,0x0aa9,0x1555,0x16b5,0x1b6d,0x1ddd,0x1f7d,0x1ffd,0x1fff,0x1fff,0x1fff,0x1fff},	// length 13
+	{0x0000,0x0001,0x0081,0x0421,0x0891,0x1249,0x14a9,0x1555,0x2ad5,0x2db5,0x36ed,0x3bdd,0x3efd,0x3ffd,0x3fff,0x3fff,0x3fff},	// length 14
+	{0x0000,0x0001,0x0101,0x0421,0x1111,0x1249,0x2529,0x2aa9,0x5555,0x56b5,0x5b6d,0x6eed,0x77bd,0x7efd,0x7ffd,0x7fff,0x7fff},	// length 15
+	{0x0000,0x0001,0x0101,0x0841,0x1111,0x2491,0x4949,0x54a9,0x5555,0xab55,0xb5b5,0xdb6d,0xdddd,0xf7bd,0xfdfd,0xfffd,0xffff},	// length 16
+};
+
+/** the rhythm of numHits over length steps, moved rotation steps later. steps wrap at length*/
+static inline uint16 getEuclidMask(int length, int numHits, int rotation = 0)
+{
+	length = jlimit(1, EUCLID_MAX_LENGTH, length);
+	numHits = jlimit(0, EUCLID_MAX_LENGTH, numHits);
+
+	const uint32 mask = euclidMasks[length-1][numHits];
+	rotation %= length;
+	if(rotation < 0) rotation += length;
+	if(rotation == 0) return (uint16)mask;
+
+	return (uint16)(((mask << rotation) | (mask >> (length - rotation))) & ((1u << length) - 1));
+}
+//---------------------------------------------------------------------------
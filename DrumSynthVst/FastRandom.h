@@ -0,0 +1,148 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+
+#define FAST_RANDOM_STATE_SIZE	4
+
+//---------------------------------------------------------------------------
+/** A small, fast xoshiro128** random generator.
+
+	Unlike rand() every instance has its own state, so each worker thread can
+	use its own generator, and the same seed always gives the same numbers.
+	A run seed plus a stream id (e.g. the work item number) gives independent,
+	reproducible sequences however the work is scheduled.
+*/
+class FastRandom
+{
+public:
+	FastRandom(uint64 seed = 0, uint64 stream = 0)
+	{
+		setSeed(seed,stream);
+	};
+
+	void setSeed(uint64 seed, uint64 stream = 0)
+	{
+		//splitmix64 spreads the seed over the whole state, it can never be all zero
+		uint64 x = seed ^ mix(stream + literal64bit(0x632be59bd9b4e019));
+		for(int i=0;i<4;i+=2)
+		{
+			const uint64 s = mix(x += literal64bit(0x9e3779b97f4a7c15));
+			mState[i] = (uint32)s;
+			mState[i+1] = (uint32)(s>>32);
+		}
+	};
+
+	/** the whole generator state, FAST_RANDOM_STATE_SIZE words. setState() continues the sequence from there*/
+	void getState(uint32* state) const
+	{
+		memcpy(state,mState,sizeof(mState));
+	};
+
+	void setState(const uint32* state)
+	{
+		memcpy(mState,state,sizeof(mState));
+	};
+
+	uint32 next()
+	{
+		const uint32 result = rotl(mState[1]*5,7)*9;
+		const uint32 t = mState[1] << 9;
+
+		mState[2] ^= mState[0];
+		mState[3] ^= mState[1];
+		mState[1] ^= mState[2];
+		mState[0] ^= mState[3];
+		mState[2] ^= t;
+		mState[3] = rotl(mState[3],11);
+
+		return result;
+	};
+
+	/** 0 <= x < max, without the modulo bias of rand()%max*/
+	int nextInt(int max)
+	{
+		jassert(max > 0);
+		return (int)(((uint64)next()*(uint32)max)>>32);
+	};
+
+	/** 0 <= x < 1*/
+	float nextFloat()
+	{
+		return (next()>>8) * (1.f/16777216.f);
+	};
+
+	bool nextBool()
+	{
+		return (next()&0x80000000) != 0;
+	};
+
+	/** fill numBytes with random bytes, 4 at a time*/
+	void fillBytes(uint8_t* dest, int numBytes)
+	{
+		int i = 0;
+		for(;i+4<=numBytes;i+=4)
+		{
+			const uint32 r = next();
+			memcpy(dest+i,&r,4);
+		}
+		if(i < numBytes)
+		{
+			uint32 r = next();
+			for(;i<numBytes;i++)
+			{
+				dest[i] = (uint8_t)r;
+				r >>= 8;
+			}
+		}
+	};
+
+	/** a bitmask of numBits bits where each bit is set with a chance of 1/2.
+		bits above numBits in the last byte are cleared*/
+	void fillMask(uint8_t* mask, int numBits)
+	{
+		const int numBytes = (numBits+7)/8;
+		fillBytes(mask,numBytes);
+		if(numBits&7) mask[numBytes-1] &= (uint8_t)((1<<(numBits&7))-1);
+	};
+
+private:
+	static uint32 rotl(uint32 x, int k)
+	{
+		return (x << k) | (x >> (32-k));
+	};
+
+	static uint64 mix(uint64 z)
+	{
+		z = (z ^ (z >> 30)) * literal64bit(0xbf58476d1ce4e5b9);
+		z = (z ^ (z >> 27)) * literal64bit(0x94d049bb133111eb);
+		return z ^ (z >> 31);
+	};
+
+	uint32 mState[FAST_RANDOM_STATE_SIZE];
+};
+//---------------------------------------------------------------------------
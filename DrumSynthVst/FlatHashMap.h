@@ -0,0 +1,237 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+#define FLAT_HASH_MAP_MIN_CAPACITY	16
+#define FLAT_HASH_MAP_MAX_PROBE		255		// a longer run only comes from a bad hash function, the table grows then
+
+//---------------------------------------------------------------------------
+/** A hash map with open addressing, for the lookups of the dedup, the
+	Markov counter and the library index.
+
+	juce's HashMap keeps one heap node per entry in chained buckets, so
+	every set() allocates and every lookup follows pointers. Here keys and
+	values are stored in two flat arrays next to a byte per slot that holds
+	the distance of its entry from its home slot. Collisions are resolved by
+	linear probing with Robin Hood insertion: an entry that is further from
+	home takes the slot of one that is closer, which keeps the runs short
+	and lets a lookup stop as soon as it meets an entry closer to home than
+	itself. remove() shifts the following entries back, there are no
+	tombstones. The table is a power of 2 and at most 3/4 full, reserve()
+	makes room for a known number of entries up front.
+
+	The hash functions are the ones of HashMap, generateHash() is called
+	with the number of slots as upper limit.
+*/
+template <typename KeyType, typename ValueType, class HashFunctionToUse = DefaultHashFunctions>
+class FlatHashMap
+{
+	typedef PARAMETER_TYPE (KeyType)   KeyTypeParameter;
+	typedef PARAMETER_TYPE (ValueType) ValueTypeParameter;
+
+public:
+	FlatHashMap(int expectedSize = FLAT_HASH_MAP_MIN_CAPACITY/2) : mCapacity(0), mNumUsed(0)
+	{
+		reserve(expectedSize);
+	};
+
+	~FlatHashMap()
+	{
+	};
+
+	/** makes room for numEntries entries, set() doesn't grow the table before that*/
+	void reserve(int numEntries)
+	{
+		int capacity = FLAT_HASH_MAP_MIN_CAPACITY;
+		while(capacity*3 < numEntries*4) capacity *= 2;
+		if(capacity > mCapacity) rehash(capacity);
+	};
+
+	/** keeps the memory of the table*/
+	void clear()
+	{
+		for(int i=0;i<mCapacity;i++)
+		{
+			if(mProbes[i] == 0) continue;
+
+			mProbes[i] = 0;
+			mKeys.getReference(i) = KeyType();
+			mValues.getReference(i) = ValueType();
+		}
+		mNumUsed = 0;
+	};
+
+	int size() const
+	{
+		return mNumUsed;
+	};
+
+	/** bytes of the slots, used or not*/
+	int getMemorySize() const
+	{
+		return mCapacity*(int)(sizeof(KeyType)+sizeof(ValueType)+sizeof(uint8));
+	};
+
+	bool contains(KeyTypeParameter key) const
+	{
+		return findSlot(key) >= 0;
+	};
+
+	/** the value of key, or a default constructed one*/
+	ValueType operator[] (KeyTypeParameter key) const
+	{
+		const int slot = findSlot(key);
+		return slot >= 0 ? mValues.getReference(slot) : ValueType();
+	};
+
+	/** the value of key or NULL, with a single lookup. valid until the map changes*/
+	ValueType* find(KeyTypeParameter key) const
+	{
+		const int slot = findSlot(key);
+		return slot >= 0 ? &mValues.getReference(slot) : NULL;
+	};
+
+	void set(KeyTypeParameter key, ValueTypeParameter value)
+	{
+		const int slot = findSlot(key);
+		if(slot >= 0)
+		{
+			mValues.getReference(slot) = value;
+			return;
+		}
+
+		if((mNumUsed+1)*4 > mCapacity*3) rehash(mCapacity*2);
+		insert(key,value);
+	};
+
+	void remove(KeyTypeParameter key)
+	{
+		int slot = findSlot(key);
+		if(slot < 0) return;
+
+		//the entries behind it move back one slot, up to one that is at home or a free slot
+		const int mask = mCapacity-1;
+		for(int next=(slot+1)&mask;mProbes[next] > 1;next=(next+1)&mask)
+		{
+			mKeys.getReference(slot) = mKeys.getReference(next);
+			mValues.getReference(slot) = mValues.getReference(next);
+			mProbes[slot] = (uint8)(mProbes[next]-1);
+			slot = next;
+		}
+		mProbes[slot] = 0;
+		mKeys.getReference(slot) = KeyType();
+		mValues.getReference(slot) = ValueType();
+		mNumUsed--;
+	};
+
+private:
+	int getHome(KeyTypeParameter key) const
+	{
+		const int home = HashFunctionToUse::generateHash(key,mCapacity);
+		jassert(isPositiveAndBelow(home,mCapacity));
+		return home;
+	};
+
+	/** mProbes holds the distance from home + 1, 0 is a free slot*/
+	int findSlot(KeyTypeParameter key) const
+	{
+		const int mask = mCapacity-1;
+		int slot = getHome(key);
+		for(int probe=1;probe<=mProbes[slot];probe++)
+		{
+			if(mProbes[slot] == probe && mKeys.getReference(slot) == key) return slot;
+			slot = (slot+1)&mask;
+		}
+		return -1;
+	};
+
+	/** the key must not be in the table yet*/
+	void insert(KeyTypeParameter newKey, ValueTypeParameter newValue)
+	{
+		KeyType key(newKey);
+		ValueType value(newValue);
+		int probe = 1;
+
+		const int mask = mCapacity-1;
+		for(int slot=getHome(key);;slot=(slot+1)&mask)
+		{
+			if(mProbes[slot] == 0)
+			{
+				mKeys.getReference(slot) = key;
+				mValues.getReference(slot) = value;
+				mProbes[slot] = (uint8)probe;
+				mNumUsed++;
+				return;
+			}
+
+			//robin hood, the entry further from home gets the slot and the other one moves on
+			if(mProbes[slot] < probe)
+			{
+				swapVariables(key,mKeys.getReference(slot));
+				swapVariables(value,mValues.getReference(slot));
+				const int displaced = mProbes[slot];
+				mProbes[slot] = (uint8)probe;
+				probe = displaced;
+			}
+
+			if(++probe > FLAT_HASH_MAP_MAX_PROBE)
+			{
+				rehash(mCapacity*2);
+				insert(key,value);
+				return;
+			}
+		}
+	};
+
+	void rehash(int newCapacity)
+	{
+		Array<KeyType> oldKeys;
+		Array<ValueType> oldValues;
+		HeapBlock<uint8> oldProbes;
+		oldKeys.swapWithArray(mKeys);
+		oldValues.swapWithArray(mValues);
+		oldProbes.swapWith(mProbes);
+		const int oldCapacity = mCapacity;
+
+		mCapacity = newCapacity;
+		mKeys.insertMultiple(0,KeyType(),mCapacity);
+		mValues.insertMultiple(0,ValueType(),mCapacity);
+		mProbes.calloc(mCapacity);
+		mNumUsed = 0;
+		for(int i=0;i<oldCapacity;i++)
+		{
+			if(oldProbes[i] != 0) insert(oldKeys.getReference(i),oldValues.getReference(i));
+		}
+	};
+
+	Array<KeyType> mKeys;
+	Array<ValueType> mValues;
+	HeapBlock<uint8> mProbes;
+	int mCapacity;	// a power of 2
+	int mNumUsed;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,208 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/Parameters.h"
+
+#define STATS_VALUE_BINS	256		// one per byte value of a parameter
+
+//---------------------------------------------------------------------------
+/** What GenerationStats found in one generation, a plain value that is
+	copied to the message thread.*/
+struct GenerationSummary
+{
+	GenerationSummary()
+	: generation(0), numMembers(0),
+	fitnessMean(0.f), fitnessDeviation(0.f), fitnessMin(0.f), fitnessMax(0.f),
+	diversity(0.f), entropy(0.f), numFrozen(0), duplicateRate(0.f)
+	{
+	};
+
+	String toString() const
+	{
+		return String("Generation ") + String(generation) + String(": ") + String(numMembers) + String(" patches, fitness ") + String(fitnessMean,2) + String(" +- ") + String(fitnessDeviation,2)
+			+ String(" (") + String(fitnessMin,2) + String("..") + String(fitnessMax,2) + String("), diversity ") + String(diversity,3)
+			+ String(", entropy ") + String(entropy,2) + String(" bits, ") + String(numFrozen) + String(" frozen, ")
+			+ String(roundToInt(duplicateRate*100.f)) + String("% duplicates");
+	};
+
+	int generation;
+	int numMembers;
+	float fitnessMean;
+	float fitnessDeviation;
+	float fitnessMin;
+	float fitnessMax;
+	float diversity;		// mean weighted distance of two members, 0..1 of the distance range
+	float entropy;			// mean bits per parameter
+	int numFrozen;			// parameters that have the same value in every member
+	float duplicateRate;	// of the bred children, the part that was thrown away as a duplicate
+};
+
+//---------------------------------------------------------------------------
+/** Running statistics of a generation, member by member as it is bred.
+
+	Nothing is computed again when a member is added. Every parameter keeps
+	a histogram of its values: the weighted distance of a new member to all
+	members before it is the sum over the bins of count times distance,
+	which adds up to the mean pairwise distance without comparing pairs, and
+	the sum of c*ln(c) over the bins, which is updated by the one bin that
+	changes, gives the entropy of the parameter. The fitness uses Welford's
+	running mean and variance. Not thread safe, one generation has one owner.
+*/
+class GenerationStats
+{
+public:
+	/** the DistanceWeights of the generator, the distances are scaled by maxDistance*/
+	GenerationStats(const short* weights, int maxDistance)
+	: mWeights(weights),
+	mMaxDistance(jmax(1,maxDistance)),
+	mCounts(NUM_PARAMS*STATS_VALUE_BINS)
+	{
+		reset();
+	};
+
+	void reset()
+	{
+		memset(mCounts,0,NUM_PARAMS*STATS_VALUE_BINS*sizeof(uint16));
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			mEntropyTerms[p] = 0.0;
+			mLow[p] = STATS_VALUE_BINS;
+			mHigh[p] = -1;
+		}
+		mPairDistance = 0;
+		mNumMembers = 0;
+		mFitnessMean = 0.0;
+		mFitnessM2 = 0.0;
+		mFitnessMin = 0.f;
+		mFitnessMax = 0.f;
+		mNumBred = 0;
+		mNumDuplicates = 0;
+	};
+
+	/** a member of the generation*/
+	void add(const uint8_t* values, float fitness)
+	{
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			const int v = values[p];
+			uint16* counts = mCounts + p*STATS_VALUE_BINS;
+
+			//distance to the members before, only over the bins that were ever used
+			int64 distance = 0;
+			for(int b=mLow[p];b<=mHigh[p];b++)
+			{
+				distance += counts[b] * (b > v ? b - v : v - b);
+			}
+			mPairDistance += distance * mWeights[p];
+
+			const double c = counts[v];
+			mEntropyTerms[p] += (c+1.0)*log(c+1.0) - (c > 0.0 ? c*log(c) : 0.0);
+			counts[v]++;
+			mLow[p] = jmin(mLow[p],v);
+			mHigh[p] = jmax(mHigh[p],v);
+		}
+
+		mNumMembers++;
+		const double delta = fitness - mFitnessMean;
+		mFitnessMean += delta / mNumMembers;
+		mFitnessM2 += delta * (fitness - mFitnessMean);
+		mFitnessMin = mNumMembers == 1 ? fitness : jmin(mFitnessMin,fitness);
+		mFitnessMax = mNumMembers == 1 ? fitness : jmax(mFitnessMax,fitness);
+	};
+
+	/** a child was bred, duplicate if it was thrown away*/
+	void childBred(bool duplicate)
+	{
+		mNumBred++;
+		if(duplicate) mNumDuplicates++;
+	};
+
+	int getNumMembers() const
+	{
+		return mNumMembers;
+	};
+
+	/** mean weighted distance of two members, 0..1 of the distance range*/
+	float getDiversity() const
+	{
+		if(mNumMembers < 2) return 0.f;
+		const double numPairs = mNumMembers * (mNumMembers - 1.0) * 0.5;
+		return (float)(mPairDistance / (numPairs * mMaxDistance));
+	};
+
+	/** bits, 0 if every member has the same value*/
+	float getEntropy(int parameterNr) const
+	{
+		if(mNumMembers == 0) return 0.f;
+		const double n = mNumMembers;
+		return (float)jmax(0.0,(log(n) - mEntropyTerms[parameterNr]/n) / log(2.0));
+	};
+
+	GenerationSummary getSummary(int generation) const
+	{
+		GenerationSummary summary;
+		summary.generation = generation;
+		summary.numMembers = mNumMembers;
+		summary.fitnessMean = (float)mFitnessMean;
+		summary.fitnessDeviation = mNumMembers > 1 ? (float)sqrt(mFitnessM2 / (mNumMembers - 1)) : 0.f;
+		summary.fitnessMin = mFitnessMin;
+		summary.fitnessMax = mFitnessMax;
+		summary.diversity = getDiversity();
+
+		double entropy = 0.0;
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			entropy += getEntropy(p);
+			if(mNumMembers > 1 && mLow[p] == mHigh[p]) summary.numFrozen++;
+		}
+		summary.entropy = (float)(entropy / NUM_PARAMS);
+		summary.duplicateRate = mNumBred > 0 ? mNumDuplicates / (float)mNumBred : 0.f;
+		return summary;
+	};
+
+private:
+	const short* mWeights;
+	int mMaxDistance;
+	HeapBlock<uint16> mCounts;			// NUM_PARAMS histograms of STATS_VALUE_BINS
+	double mEntropyTerms[NUM_PARAMS];	// sum of c*ln(c) over the bins
+	int mLow[NUM_PARAMS];				// the bins that were used
+	int mHigh[NUM_PARAMS];
+	int64 mPairDistance;				// weighted distance summed over all pairs
+	int mNumMembers;
+	double mFitnessMean;
+	double mFitnessM2;
+	float mFitnessMin;
+	float mFitnessMax;
+	int mNumBred;
+	int mNumDuplicates;
+
+	// (prevent copy constructor and operator= being generated..)
+	GenerationStats (const GenerationStats&);
+	const GenerationStats& operator= (const GenerationStats&);
+};
+//---------------------------------------------------------------------------
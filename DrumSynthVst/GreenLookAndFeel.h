@@ -24,11 +24,15 @@
  */
 #pragma once
 #include "./JuceLibraryCode/JuceHeader.h"
+#include "./MemoryAccounting.h"
+#include "./TextLayoutCache.h"
+
+#define FILMSTRIP_CACHED_SIZES 4	// knob sizes whose scaled frames are kept, the oldest size is dropped first
 
 class GreenLookAndFeel : public LookAndFeel
 {
 public:
-	GreenLookAndFeel()
+	GreenLookAndFeel() : imageMemory(MEMORY_IMAGES)
 	{
 		setColour (Label::textColourId, Colour (0xffffffff));
 
@@ -48,8 +52,9 @@ public:
 		setColour ( Slider::textBoxOutlineColourId, Colour(0x7f8cb039));
 */
 
-		File applicationDirectory = File::getSpecialLocation(File::currentApplicationFile).getParentDirectory();
-		setSliderImage(ImageFileFormat::loadFrom(File(applicationDirectory.getFullPathName() + "/../resources/knob.png")),31,false);
+		//knob.png is decoded by the StartupLoader, setSliderImage() is called when it is ready
+		numFrames = 0;
+		cacheTime = 0;
 	
 	};
 
@@ -57,16 +62,22 @@ public:
 
 	/** this method is called by the default Juce::Slider paint() method to actually draw the slider*/
 	void drawRotarySlider  (Graphics &g,
-							int  	/*x*/,
-							int  	/*y*/,
+							int  	x,
+							int  	y,
 							int  	width,
 							int  	height,
-							float  	/*sliderPosProportional*/,
-							float  	/*rotaryStartAngle*/,
-							float  	/*rotaryEndAngle*/,
+							float  	sliderPosProportional,
+							float  	rotaryStartAngle,
+							float  	rotaryEndAngle,
 							Slider &  	slider 
 							) 	
 	{
+		if (!filmStripImage.isValid())
+		{
+			//until the film strip is loaded
+			LookAndFeel::drawRotarySlider(g,x,y,width,height,sliderPosProportional,rotaryStartAngle,rotaryEndAngle,slider);
+			return;
+		}
 
 		if (filmStripImage.isValid())
 		{
@@ -87,20 +98,55 @@ public:
 				imageHeight = height;
 			}
 			
-			if(isHorizontal)
-			{
-				g.drawImage(filmStripImage, (int)((width - imageWidth) * 0.5), 0, imageWidth, imageHeight,
-							value * frameWidth, 0, frameWidth, frameHeight);
-			}
-			else
-			{
-				g.drawImage(filmStripImage, (int)((width - imageWidth) * 0.5), 0, imageWidth, imageHeight,
-							0, value * frameHeight, frameWidth, frameHeight);
-			}
+			//the frame is scaled once per knob size, painting is an unscaled blit
+			g.drawImageAt(getScaledFrame(jlimit(0,numFrames-1,value),imageWidth,imageHeight), (int)((width - imageWidth) * 0.5), 0);
 		}
 
 	}
 
+	/** the same as LookAndFeel::drawLabel(), but the laid out text is kept for the next paint*/
+	void drawLabel(Graphics& g, Label& label)
+	{
+		g.fillAll(label.findColour(Label::backgroundColourId));
+
+		if(!label.isBeingEdited())
+		{
+			const float alpha = label.isEnabled() ? 1.0f : 0.5f;
+
+			g.setColour(label.findColour(Label::textColourId).withMultipliedAlpha(alpha));
+			g.setFont(label.getFont());
+			textLayouts.drawFittedText(g,label.getFont(),label.getText(),
+				label.getHorizontalBorderSize(),
+				label.getVerticalBorderSize(),
+				label.getWidth() - 2 * label.getHorizontalBorderSize(),
+				label.getHeight() - 2 * label.getVerticalBorderSize(),
+				label.getJustificationType(),
+				jmax(1,(int)(label.getHeight() / label.getFont().getHeight())),
+				label.getMinimumHorizontalScale());
+
+			g.setColour(label.findColour(Label::outlineColourId).withMultipliedAlpha(alpha));
+			g.drawRect(0,0,label.getWidth(),label.getHeight());
+		}
+		else if(label.isEnabled())
+		{
+			g.setColour(label.findColour(Label::outlineColourId));
+			g.drawRect(0,0,label.getWidth(),label.getHeight());
+		}
+	};
+
+	/** the fonts of the panels, the StartupLoader measures their GlyphMetrics. The size doesn't matter*/
+	static void getTextFonts(Array<Font>& fonts)
+	{
+		fonts.add(Font(15.0f,Font::plain));
+		fonts.add(Font(15.0f,Font::bold));
+	};
+
+	/** the measured fonts of getTextFonts(), new texts are laid out with them*/
+	void setGlyphMetrics(const ReferenceCountedArray<GlyphMetrics>& metrics)
+	{
+		textLayouts.setGlyphMetrics(metrics);
+	};
+
 	/** Sets the image to use, you need to supply the number of frames within the image.
      */
     void setSliderImage (Image image, int numFrames_, bool isHorizontal_ = true)
@@ -127,6 +173,12 @@ public:
 		{
 			numFrames = 0;
 		}
+
+		for(int i=0;i<FILMSTRIP_CACHED_SIZES;i++)
+		{
+			frameCache[i].clear();
+		}
+		updateImageMemory();
 		
 	};
 
@@ -141,11 +193,102 @@ public:
 		
 	};
 private:
+	/** the frames of the film strip scaled to one knob size, they are only rendered when first painted*/
+	struct ScaledFrames
+	{
+		ScaledFrames() : width(0), height(0), lastUsed(0) {};
+
+		void clear()
+		{
+			frames.clear();
+			width = height = 0;
+			lastUsed = 0;
+		};
+
+		int width;
+		int height;
+		uint32 lastUsed;
+		Array<Image> frames;
+	};
+
+	/** returns frame scaled to width x height. the ARGB frames are premultiplied like every juce image.
+		juce 1.54 draws components at their logical size, so the size alone is the cache key*/
+	const Image& getScaledFrame(int frame, int width, int height)
+	{
+		ScaledFrames* sizeCache = 0;
+		for(int i=0;i<FILMSTRIP_CACHED_SIZES && sizeCache == 0;i++)
+		{
+			if(frameCache[i].width == width && frameCache[i].height == height) sizeCache = &frameCache[i];
+		}
+
+		if(sizeCache == 0)
+		{
+			//reuse the size that was painted longest ago
+			sizeCache = &frameCache[0];
+			for(int i=1;i<FILMSTRIP_CACHED_SIZES;i++)
+			{
+				if(frameCache[i].lastUsed < sizeCache->lastUsed) sizeCache = &frameCache[i];
+			}
+			sizeCache->clear();
+			sizeCache->width = width;
+			sizeCache->height = height;
+			sizeCache->frames.insertMultiple(0,Image::null,numFrames);
+		}
+		sizeCache->lastUsed = ++cacheTime;
+
+		if(!sizeCache->frames.getReference(frame).isValid())
+		{
+			Image scaled(Image::ARGB,jmax(1,width),jmax(1,height),true);
+			Graphics sg(scaled);
+			sg.setImageResamplingQuality(Graphics::highResamplingQuality);
+			if(isHorizontal)
+			{
+				sg.drawImage(filmStripImage, 0, 0, width, height, frame * frameWidth, 0, frameWidth, frameHeight);
+			}
+			else
+			{
+				sg.drawImage(filmStripImage, 0, 0, width, height, 0, frame * frameHeight, frameWidth, frameHeight);
+			}
+			//the frames never change, the Direct2D renderer may keep them on the GPU
+			scaled.getProperties()->set("cacheAsBitmap",true);
+			sizeCache->frames.set(frame,scaled);
+			updateImageMemory();
+		}
+		return sizeCache->frames.getReference(frame);
+	};
+
+	/** the pixels of the film strip and of every scaled frame*/
+	void updateImageMemory()
+	{
+		int bytes = getImageBytes(filmStripImage);
+		for(int i=0;i<FILMSTRIP_CACHED_SIZES;i++)
+		{
+			for(int j=0;j<frameCache[i].frames.size();j++)
+			{
+				bytes += getImageBytes(frameCache[i].frames.getReference(j));
+			}
+		}
+		imageMemory.setBytes(bytes);
+	};
+
+	static int getImageBytes(const Image& image)
+	{
+		if(!image.isValid()) return 0;
+		const int pixelSize = image.getFormat() == Image::SingleChannel ? 1 : image.getFormat() == Image::RGB ? 3 : 4;
+		return image.getWidth()*image.getHeight()*pixelSize;
+	};
+
 	/** the image for the filmstrip slider*/
 	Image filmStripImage;
 	int numFrames;
 	int frameHeight;
 	int	frameWidth;
 	bool isHorizontal;
+	/** the scaled frames of the last painted knob sizes*/
+	ScaledFrames frameCache[FILMSTRIP_CACHED_SIZES];
+	uint32 cacheTime;
+	MemoryAccount imageMemory;
+	/** the texts of the labels, combo boxes and slider text boxes*/
+	TextLayoutCache textLayouts;
 
 };
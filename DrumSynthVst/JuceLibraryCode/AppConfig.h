@@ -16,14 +16,16 @@
 #endif
 //#define  JUCE_LOG_ASSERTIONS
 #define  JUCE_ASIO 0
-//#define  JUCE_WASAPI
+#define  JUCE_WASAPI 1
 //#define  JUCE_DIRECTSOUND
 //#define  JUCE_DIRECTSHOW
 //#define  JUCE_MEDIAFOUNDATION
 //#define  JUCE_ALSA
+#define  JUCE_JACK 1
+#define  JUCE_JACK_CLIENT_NAME "DrumSynthEditor"
 //#define  JUCE_QUICKTIME
 //#define  JUCE_OPENGL
-//#define  JUCE_DIRECT2D
+#define  JUCE_DIRECT2D 1
 //#define  JUCE_USE_FLAC
 //#define  JUCE_USE_OGGVORBIS
 //#define  JUCE_USE_CDBURNER
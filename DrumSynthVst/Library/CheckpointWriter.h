@@ -0,0 +1,145 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../ThreadPriorities.h"
+
+#define CHECKPOINT_STOP_TIMEOUT_MS	10000	// the last checkpoint is still written when the writer is deleted
+
+//---------------------------------------------------------------------------
+/** Writes files on its own thread so the caller never waits for the disk.
+
+	write() only copies the data and returns. Every file is first written
+	to a temporary file next to it and then renamed over the old one, so a
+	crash in the middle leaves the previous version intact. If a file is
+	posted again before the writer got to it, only the newest data is
+	written.
+*/
+class CheckpointWriter : public Thread
+{
+public:
+	CheckpointWriter() : Thread("CheckpointWriter"),
+	mBusy(false),
+	mFailed(false)
+	{
+	};
+
+	~CheckpointWriter()
+	{
+		stopThread(CHECKPOINT_STOP_TIMEOUT_MS);
+		writePending();
+	};
+
+	void write(const File& file, const MemoryBlock& data)
+	{
+		{
+			const ScopedLock lock(mLock);
+			const int index = mFiles.indexOf(file);
+			if(index >= 0)
+			{
+				*mData[index] = data;
+			}
+			else
+			{
+				mFiles.add(file);
+				mData.add(new MemoryBlock(data));
+			}
+		}
+
+		if(!isThreadRunning()) startThread(PRIORITY_CLASS_BACKGROUND);
+		notify();
+	};
+
+	/** true if every posted file is on disk, false if the last write failed*/
+	bool waitUntilWritten(int timeoutMs)
+	{
+		const uint32 end = Time::getMillisecondCounter() + (uint32)timeoutMs;
+		for(;;)
+		{
+			{
+				const ScopedLock lock(mLock);
+				if(mFiles.size() == 0 && !mBusy) return !mFailed;
+			}
+			if(Time::getMillisecondCounter() >= end) return false;
+			Thread::sleep(10);
+		}
+	};
+
+	void run()
+	{
+		while(!threadShouldExit())
+		{
+			writePending();
+			wait(-1);
+		}
+	};
+
+private:
+	void writePending()
+	{
+		for(;;)
+		{
+			File file;
+			ScopedPointer<MemoryBlock> data;
+			{
+				const ScopedLock lock(mLock);
+				if(mFiles.size() == 0) return;
+
+				file = mFiles[0];
+				data = mData.removeAndReturn(0);
+				mFiles.remove(0);
+				mBusy = true;
+			}
+
+			const bool ok = writeFile(file,*data);
+
+			const ScopedLock lock(mLock);
+			mBusy = false;
+			mFailed = !ok;
+		}
+	};
+
+	static bool writeFile(const File& file, const MemoryBlock& data)
+	{
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->write(data.getData(),(int)data.getSize());
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	CriticalSection mLock;
+	Array<File> mFiles;				// waiting to be written
+	OwnedArray<MemoryBlock> mData;	// the contents of mFiles
+	bool mBusy;
+	bool mFailed;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,546 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+
+#define JSON_MAX_DEPTH			64		// nested objects and arrays
+#define JSON_READ_CHUNK_SIZE	4096
+#define JSON_MAX_NUMBER_LENGTH	64
+
+//---------------------------------------------------------------------------
+/** Reads a JSON document that arrives in arbitrary chunks and reports what
+	it finds to a Listener, without building a tree of vars.
+
+	juce's JSON::parse() keeps the whole document as vars and Strings, which
+	for a big patch list costs far more memory and time than the records it
+	describes. Here only the string or number being read is buffered, the
+	listener gets it the moment it is complete. Strings are given as UTF-8
+	with the escapes decoded.
+
+	Anything that isn't valid JSON stops the parser, isOk() is false from
+	then on and getErrorPosition() tells the byte offset.
+*/
+class JsonStreamParser
+{
+public:
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		virtual void startObject() {};
+		virtual void endObject() {};
+		virtual void startArray() {};
+		virtual void endArray() {};
+		/** the name of the next member of the innermost object*/
+		virtual void key(const char* /*text*/, int /*length*/) {};
+		virtual void stringValue(const char* /*text*/, int /*length*/) {};
+		virtual void numberValue(double /*value*/) {};
+		virtual void boolValue(bool /*value*/) {};
+		virtual void nullValue() {};
+	};
+	//-----------------------------------------------------------------------
+
+	JsonStreamParser(Listener* listener) : mListener(listener)
+	{
+		reset();
+	};
+
+	~JsonStreamParser()
+	{
+	};
+
+	void reset()
+	{
+		mToken = TOKEN_NONE;
+		mExpect = EXPECT_VALUE;
+		mDepth = 0;
+		mTextLength = 0;
+		mHighSurrogate = 0;
+		mPosition = 0;
+		mError = false;
+	};
+
+	/** parse the next chunk, a token may be split anywhere*/
+	void feed(const uint8_t* bytes, int numBytes)
+	{
+		for(int i=0;i<numBytes && !mError;i++)
+		{
+			handleByte(bytes[i]);
+			mPosition++;
+		}
+	};
+
+	/** parse a block in memory, e.g. a mapped file, checking the thread every
+		JSON_READ_CHUNK_SIZE bytes. returns false if it was asked to stop before the end*/
+	bool feed(const uint8_t* bytes, size_t numBytes, Thread* thread)
+	{
+		for(size_t pos=0;pos<numBytes && !mError;pos+=JSON_READ_CHUNK_SIZE)
+		{
+			if(thread != NULL && thread->threadShouldExit()) return false;
+			feed(bytes+pos,(int)jmin((size_t)JSON_READ_CHUNK_SIZE,numBytes-pos));
+		}
+		return true;
+	};
+
+	/** parse a whole stream in JSON_READ_CHUNK_SIZE chunks.
+		returns false if the thread was asked to stop before the end*/
+	bool feed(InputStream& in, Thread* thread = NULL)
+	{
+		uint8_t chunk[JSON_READ_CHUNK_SIZE];
+		while(!mError)
+		{
+			if(thread != NULL && thread->threadShouldExit()) return false;
+
+			const int numRead = in.read(chunk,JSON_READ_CHUNK_SIZE);
+			if(numRead <= 0) break;
+			feed(chunk,numRead);
+		}
+		return true;
+	};
+
+	/** call after the last chunk. returns true if it held exactly one complete document*/
+	bool finish()
+	{
+		//a number or literal at the very end has nothing behind it that ends it
+		if(!mError && (mToken == TOKEN_NUMBER || mToken == TOKEN_LITERAL)) endToken();
+		if(mToken != TOKEN_NONE || mExpect != EXPECT_END) mError = true;
+		return !mError;
+	};
+
+	bool isOk() const
+	{
+		return !mError;
+	};
+
+	/** the byte offset of the first byte that didn't fit*/
+	int64 getErrorPosition() const
+	{
+		return mPosition;
+	};
+
+private:
+	enum Token
+	{
+		TOKEN_NONE = 0,		// between tokens
+		TOKEN_STRING,
+		TOKEN_ESCAPE,		// after a backslash
+		TOKEN_UNICODE,		// the 4 hex digits of \u
+		TOKEN_NUMBER,
+		TOKEN_LITERAL		// true, false or null
+	};
+
+	enum Expect
+	{
+		EXPECT_VALUE = 0,
+		EXPECT_VALUE_OR_END,	// after [
+		EXPECT_KEY,				// after , in an object
+		EXPECT_KEY_OR_END,		// after {
+		EXPECT_COLON,
+		EXPECT_COMMA_OR_END,
+		EXPECT_END				// the document is complete
+	};
+
+	void handleByte(uint8_t b)
+	{
+		switch(mToken)
+		{
+		case TOKEN_STRING:
+			if(b == '"')		endString();
+			else if(b == '\\')	mToken = TOKEN_ESCAPE;
+			else if(b < 0x20)	mError = true;
+			else
+			{
+				flushSurrogate();
+				appendText(b);
+			}
+			return;
+
+		case TOKEN_ESCAPE:
+			handleEscape(b);
+			return;
+
+		case TOKEN_UNICODE:
+			handleHexDigit(b);
+			return;
+
+		case TOKEN_NUMBER:
+			if((b >= '0' && b <= '9') || b == '-' || b == '+' || b == '.' || b == 'e' || b == 'E')
+			{
+				if(mTextLength == JSON_MAX_NUMBER_LENGTH)	mError = true;
+				else										appendText(b);
+				return;
+			}
+			endToken();
+			break;
+
+		case TOKEN_LITERAL:
+			if(b >= 'a' && b <= 'z')
+			{
+				if(mTextLength == 5)	mError = true;
+				else					appendText(b);
+				return;
+			}
+			endToken();
+			break;
+
+		default:
+			break;
+		}
+		if(!mError) handleStructure(b);
+	};
+
+	void handleStructure(uint8_t b)
+	{
+		switch(b)
+		{
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+			break;
+
+		case '{':
+		case '[':
+			if(!expectsValue() || mDepth == JSON_MAX_DEPTH)
+			{
+				mError = true;
+				return;
+			}
+			mStack[mDepth++] = (char)b;
+			if(b == '{')
+			{
+				mExpect = EXPECT_KEY_OR_END;
+				mListener->startObject();
+			}
+			else
+			{
+				mExpect = EXPECT_VALUE_OR_END;
+				mListener->startArray();
+			}
+			break;
+
+		case '}':
+		case ']':
+			{
+				const char open = (b == '}') ? '{' : '[';
+				const Expect canEnd = (b == '}') ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+				if(mDepth == 0 || mStack[mDepth-1] != open || (mExpect != canEnd && mExpect != EXPECT_COMMA_OR_END))
+				{
+					mError = true;
+					return;
+				}
+				mDepth--;
+				if(b == '}')	mListener->endObject();
+				else			mListener->endArray();
+				valueDone();
+			}
+			break;
+
+		case ',':
+			if(mExpect != EXPECT_COMMA_OR_END)
+			{
+				mError = true;
+				return;
+			}
+			mExpect = (mStack[mDepth-1] == '{') ? EXPECT_KEY : EXPECT_VALUE;
+			break;
+
+		case ':':
+			if(mExpect != EXPECT_COLON)
+			{
+				mError = true;
+				return;
+			}
+			mExpect = EXPECT_VALUE;
+			break;
+
+		case '"':
+			mIsKey = (mExpect == EXPECT_KEY || mExpect == EXPECT_KEY_OR_END);
+			if(!mIsKey && !expectsValue())
+			{
+				mError = true;
+				return;
+			}
+			startToken(TOKEN_STRING);
+			break;
+
+		case 't':
+		case 'f':
+		case 'n':
+			if(!expectsValue())
+			{
+				mError = true;
+				return;
+			}
+			startToken(TOKEN_LITERAL);
+			appendText(b);
+			break;
+
+		default:
+			if(!(b == '-' || (b >= '0' && b <= '9')) || !expectsValue())
+			{
+				mError = true;
+				return;
+			}
+			startToken(TOKEN_NUMBER);
+			appendText(b);
+			break;
+		}
+	};
+
+	void handleEscape(uint8_t b)
+	{
+		mToken = TOKEN_STRING;
+		if(b != 'u') flushSurrogate();
+		switch(b)
+		{
+		case '"':
+		case '\\':
+		case '/':	appendText(b); break;
+		case 'b':	appendText('\b'); break;
+		case 'f':	appendText('\f'); break;
+		case 'n':	appendText('\n'); break;
+		case 'r':	appendText('\r'); break;
+		case 't':	appendText('\t'); break;
+		case 'u':
+			mToken = TOKEN_UNICODE;
+			mHexValue = 0;
+			mNumHexDigits = 0;
+			break;
+		default:
+			mError = true;
+			break;
+		}
+	};
+
+	void handleHexDigit(uint8_t b)
+	{
+		int digit;
+		if(b >= '0' && b <= '9')		digit = b-'0';
+		else if(b >= 'a' && b <= 'f')	digit = b-'a'+10;
+		else if(b >= 'A' && b <= 'F')	digit = b-'A'+10;
+		else
+		{
+			mError = true;
+			return;
+		}
+		mHexValue = (mHexValue<<4) | digit;
+		if(++mNumHexDigits < 4) return;
+
+		mToken = TOKEN_STRING;
+		const bool isLow = (mHexValue >= 0xdc00 && mHexValue <= 0xdfff);
+		if(mHighSurrogate != 0 && isLow)
+		{
+			appendCodePoint(0x10000 + ((mHighSurrogate-0xd800)<<10) + (mHexValue-0xdc00));
+			mHighSurrogate = 0;
+			return;
+		}
+		flushSurrogate();
+		if(mHexValue >= 0xd800 && mHexValue <= 0xdbff)	mHighSurrogate = mHexValue;
+		else if(isLow)									appendCodePoint(0xfffd);
+		else											appendCodePoint(mHexValue);
+	};
+
+	void startToken(Token token)
+	{
+		mToken = token;
+		mTextLength = 0;
+		mHighSurrogate = 0;
+	};
+
+	/** a high surrogate that isn't followed by its low half*/
+	void flushSurrogate()
+	{
+		if(mHighSurrogate == 0) return;
+		mHighSurrogate = 0;
+		appendCodePoint(0xfffd);
+	};
+
+	void appendText(uint8_t b)
+	{
+		if(mTextLength == (int)mText.getSize())
+		{
+			mText.setSize(jmax((size_t)256,mText.getSize()*2));
+		}
+		((uint8_t*)mText.getData())[mTextLength++] = b;
+	};
+
+	/** as UTF-8*/
+	void appendCodePoint(uint32 c)
+	{
+		if(c < 0x80)
+		{
+			appendText((uint8_t)c);
+		}
+		else if(c < 0x800)
+		{
+			appendText((uint8_t)(0xc0 | (c>>6)));
+			appendText((uint8_t)(0x80 | (c&0x3f)));
+		}
+		else if(c < 0x10000)
+		{
+			appendText((uint8_t)(0xe0 | (c>>12)));
+			appendText((uint8_t)(0x80 | ((c>>6)&0x3f)));
+			appendText((uint8_t)(0x80 | (c&0x3f)));
+		}
+		else
+		{
+			appendText((uint8_t)(0xf0 | (c>>18)));
+			appendText((uint8_t)(0x80 | ((c>>12)&0x3f)));
+			appendText((uint8_t)(0x80 | ((c>>6)&0x3f)));
+			appendText((uint8_t)(0x80 | (c&0x3f)));
+		}
+	};
+
+	void endString()
+	{
+		flushSurrogate();
+		mToken = TOKEN_NONE;
+		const char* text = (const char*)mText.getData();
+		if(mIsKey)
+		{
+			mListener->key(text,mTextLength);
+			mExpect = EXPECT_COLON;
+		}
+		else
+		{
+			mListener->stringValue(text,mTextLength);
+			valueDone();
+		}
+	};
+
+	/** ends a number or a literal at the first byte that can't belong to it*/
+	void endToken()
+	{
+		const Token token = mToken;
+		mToken = TOKEN_NONE;
+		const char* text = (const char*)mText.getData();
+
+		if(token == TOKEN_LITERAL)
+		{
+			if(mTextLength == 4 && memcmp(text,"true",4) == 0)			mListener->boolValue(true);
+			else if(mTextLength == 5 && memcmp(text,"false",5) == 0)	mListener->boolValue(false);
+			else if(mTextLength == 4 && memcmp(text,"null",4) == 0)		mListener->nullValue();
+			else
+			{
+				mError = true;
+				return;
+			}
+		}
+		else
+		{
+			double value;
+			if(!parseNumber(text,mTextLength,value))
+			{
+				mError = true;
+				return;
+			}
+			mListener->numberValue(value);
+		}
+		valueDone();
+	};
+
+	/** the JSON number grammar, without going through the C locale*/
+	static bool parseNumber(const char* text, int length, double& value)
+	{
+		int pos = 0;
+		const bool negative = (text[0] == '-');
+		if(negative) pos++;
+
+		//an integer part without leading zeros
+		if(pos == length || text[pos] < '0' || text[pos] > '9') return false;
+		double mantissa = 0;
+		if(text[pos] == '0')
+		{
+			pos++;
+		}
+		else
+		{
+			while(pos < length && text[pos] >= '0' && text[pos] <= '9')
+			{
+				mantissa = mantissa*10 + (text[pos++]-'0');
+			}
+		}
+
+		int exponent = 0;
+		if(pos < length && text[pos] == '.')
+		{
+			pos++;
+			if(pos == length || text[pos] < '0' || text[pos] > '9') return false;
+			while(pos < length && text[pos] >= '0' && text[pos] <= '9')
+			{
+				mantissa = mantissa*10 + (text[pos++]-'0');
+				exponent--;
+			}
+		}
+
+		if(pos < length && (text[pos] == 'e' || text[pos] == 'E'))
+		{
+			pos++;
+			bool negativeExponent = false;
+			if(pos < length && (text[pos] == '+' || text[pos] == '-')) negativeExponent = (text[pos++] == '-');
+			if(pos == length) return false;
+			int e = 0;
+			while(pos < length && text[pos] >= '0' && text[pos] <= '9')
+			{
+				e = jmin(100000,e*10 + (text[pos++]-'0'));
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+		if(pos != length) return false;
+
+		value = (exponent == 0) ? mantissa : mantissa*pow(10.0,(double)exponent);
+		if(negative) value = -value;
+		return true;
+	};
+
+	bool expectsValue() const
+	{
+		return mExpect == EXPECT_VALUE || mExpect == EXPECT_VALUE_OR_END;
+	};
+
+	void valueDone()
+	{
+		mExpect = (mDepth == 0) ? EXPECT_END : EXPECT_COMMA_OR_END;
+	};
+
+	Listener* mListener;
+	Token mToken;
+	Expect mExpect;
+	char mStack[JSON_MAX_DEPTH];	// { or [ of every open container
+	int mDepth;
+	bool mIsKey;					// the string being read is a member name
+	MemoryBlock mText;				// the string, number or literal being read
+	int mTextLength;
+	uint32 mHexValue;
+	int mNumHexDigits;
+	uint32 mHighSurrogate;			// of a \u pair, 0 if none is pending
+	int64 mPosition;
+	bool mError;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,774 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PresetLoader.h"
+#include "../PatchHash.h"
+#include "../FlatHashMap.h"
+#include "../Log.h"
+#include "PatchLibrary.h"
+
+#define LIBRARY_SYNC_BLOCK_RECORDS		256			// records per block hash
+#define LIBRARY_MANIFEST_MAGIC			0x4d505053	// "SPPM" little endian
+#define LIBRARY_MANIFEST_VERSION		1
+#define LIBRARY_MANIFEST_HEADER_SIZE	32
+
+#define LIBRARY_SYNC_MAGIC				0x53505359	// "SPSY", the header of every InterprocessConnection message
+#define LIBRARY_SYNC_TIMEOUT_MS			10000		// for the connection and for every answer
+#define LIBRARY_SYNC_MAX_REQUEST		1024		// blocks or records asked for in one message
+
+#define LIBRARY_SYNC_BLOCKS		1	// -> number of records, number of blocks, the block hashes
+#define LIBRARY_SYNC_HASHES		2	// count, block numbers -> the record hashes of the blocks
+#define LIBRARY_SYNC_RECORDS	3	// count, record numbers -> the records
+
+//---------------------------------------------------------------------------
+/** The content hashes of a PatchLibrary: one per record, over name and
+	values, and one per block of LIBRARY_SYNC_BLOCK_RECORDS records over the
+	record hashes.
+
+	The manifest is kept as a file next to its library, stamped with the size
+	and modification time of the library, so a library that was changed since
+	is hashed again instead of being trusted. PatchLibraryWriter deletes it
+	when it writes the library. Layout (little endian):
+	header		magic, version, number of records, records per block,
+				library size (64 bit), library time (64 bit)
+	blocks		one 64 bit hash per block
+	records		one 64 bit hash per record
+*/
+class LibraryManifest
+{
+public:
+	LibraryManifest()
+	{
+	};
+
+	static int64 hashRecord(const uint8_t* record)
+	{
+		const uint64 multiplier = literal64bit(0x9e3779b97f4a7c15);
+		uint64 hash = hashPatchValues(record + PATCH_NAME_LENGTH);
+		for(int i=0;i<PATCH_NAME_LENGTH;i++)
+		{
+			hash = (hash ^ record[i]) * multiplier;
+		}
+		hash ^= hash >> 29;
+		return (int64)hash;
+	};
+
+	static int64 hashBlock(const Array<int64>& recordHashes, int first, int numRecords)
+	{
+		const uint64 multiplier = literal64bit(0x9e3779b97f4a7c15);
+		uint64 hash = literal64bit(0xcbf29ce484222325) ^ (uint64)numRecords;
+		for(int i=first;i<first+numRecords;i++)
+		{
+			hash = (hash ^ (uint64)recordHashes.getUnchecked(i)) * multiplier;
+			hash ^= hash >> 29;
+		}
+		return (int64)hash;
+	};
+
+	static int getNumBlocks(int numRecords)
+	{
+		return (numRecords + LIBRARY_SYNC_BLOCK_RECORDS - 1) / LIBRARY_SYNC_BLOCK_RECORDS;
+	};
+
+	/** the records of a block, the last one may be short*/
+	static int getBlockSize(int block, int numRecords)
+	{
+		return jmin(LIBRARY_SYNC_BLOCK_RECORDS,numRecords - block*LIBRARY_SYNC_BLOCK_RECORDS);
+	};
+
+	static File getFile(const File& library)
+	{
+		return library.withFileExtension(LIBRARY_MANIFEST_EXTENSION);
+	};
+
+	/** hashes every record of an open library*/
+	void build(PatchLibrary& library)
+	{
+		TRACE_SCOPE("patch io","hash library");
+		mRecordHashes.clearQuick();
+		mRecordHashes.ensureStorageAllocated(library.getNumPatches());
+		for(int i=0;i<library.getNumPatches();i++)
+		{
+			mRecordHashes.add(hashRecord(library.getPatchData(i)));
+		}
+		updateBlocks();
+	};
+
+	/** the records in library order, the block hashes are made from them*/
+	void setRecordHashes(const Array<int64>& recordHashes)
+	{
+		mRecordHashes = recordHashes;
+		updateBlocks();
+	};
+
+	int getNumRecords() const
+	{
+		return mRecordHashes.size();
+	};
+
+	const Array<int64>& getRecordHashes() const
+	{
+		return mRecordHashes;
+	};
+
+	const Array<int64>& getBlockHashes() const
+	{
+		return mBlockHashes;
+	};
+
+	/** false if the file can't be written, e.g. on a read only share*/
+	bool save(const File& library) const
+	{
+		TemporaryFile temp(getFile(library));
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			writeHeader(*out,getNumRecords(),library);
+			for(int i=0;i<mBlockHashes.size();i++)
+			{
+				out->writeInt64(mBlockHashes.getUnchecked(i));
+			}
+			for(int i=0;i<mRecordHashes.size();i++)
+			{
+				out->writeInt64(mRecordHashes.getUnchecked(i));
+			}
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** the saved manifest, false if there is none or the library changed since*/
+	bool load(const File& library)
+	{
+		FileInputStream in(getFile(library));
+		int numRecords;
+		if(in.getStatus().failed() || !readHeader(in,library,numRecords)) return false;
+
+		in.setPosition(LIBRARY_MANIFEST_HEADER_SIZE + (int64)getNumBlocks(numRecords)*8);
+		Array<int64> recordHashes;
+		recordHashes.ensureStorageAllocated(numRecords);
+		for(int i=0;i<numRecords;i++)
+		{
+			recordHashes.add(in.readInt64());
+		}
+		if(in.getPosition() != in.getTotalLength()) return false;
+
+		setRecordHashes(recordHashes);
+		return true;
+	};
+
+	/** load(), or build() and save() for a library that changed or was never hashed*/
+	bool loadOrBuild(const File& library)
+	{
+		if(load(library)) return true;
+
+		PatchLibrary opened;
+		if(!opened.open(library)) return false;
+		build(opened);
+		save(library);
+		return true;
+	};
+
+	/** checks the stamp of a manifest stream against the library as it is now*/
+	static bool readHeader(InputStream& in, const File& library, int& numRecords)
+	{
+		if(in.readInt() != LIBRARY_MANIFEST_MAGIC || in.readInt() != LIBRARY_MANIFEST_VERSION) return false;
+		numRecords = in.readInt();
+		const int blockRecords = in.readInt();
+		const int64 size = in.readInt64();
+		const int64 time = in.readInt64();
+		return numRecords >= 0 && blockRecords == LIBRARY_SYNC_BLOCK_RECORDS
+			&& size == library.getSize() && time == library.getLastModificationTime().toMilliseconds();
+	};
+
+private:
+	static void writeHeader(OutputStream& out, int numRecords, const File& library)
+	{
+		out.writeInt(LIBRARY_MANIFEST_MAGIC);
+		out.writeInt(LIBRARY_MANIFEST_VERSION);
+		out.writeInt(numRecords);
+		out.writeInt(LIBRARY_SYNC_BLOCK_RECORDS);
+		out.writeInt64(library.getSize());
+		out.writeInt64(library.getLastModificationTime().toMilliseconds());
+	};
+
+	void updateBlocks()
+	{
+		const int numRecords = mRecordHashes.size();
+		mBlockHashes.clearQuick();
+		for(int b=0;b<getNumBlocks(numRecords);b++)
+		{
+			mBlockHashes.add(hashBlock(mRecordHashes,b*LIBRARY_SYNC_BLOCK_RECORDS,getBlockSize(b,numRecords)));
+		}
+	};
+
+	Array<int64> mRecordHashes;
+	Array<int64> mBlockHashes;
+};
+
+//---------------------------------------------------------------------------
+/** Where LibrarySync::pull() gets a library from. Every call may block on
+	the transfer, false if it failed.*/
+class LibrarySyncSource
+{
+public:
+	virtual ~LibrarySyncSource() {};
+
+	virtual bool getBlockHashes(int& numRecords, Array<int64>& blockHashes) = 0;
+
+	/** the record hashes of the blocks, one after the other*/
+	virtual bool getRecordHashes(const Array<int>& blocks, Array<int64>& recordHashes) = 0;
+
+	/** PATCH_DATA_SIZE bytes for each record, one after the other*/
+	virtual bool getRecords(const Array<int>& records, MemoryBlock& data) = 0;
+
+	/** the bytes read or received so far*/
+	virtual int64 getBytesTransferred() const = 0;
+};
+
+//---------------------------------------------------------------------------
+/** A library on a file share. Only the parts of the manifest and of the
+	library that are asked for are read. Without a current manifest on the
+	share the library is read once to hash it, the manifest is then written
+	next to it if the share allows it.
+*/
+class LibraryShareSource : public LibrarySyncSource
+{
+public:
+	LibraryShareSource(const File& library) : mLibrary(library), mBytes(0), mReadsManifest(false), mNumRecords(0)
+	{
+	};
+
+	/** false if the library can't be read*/
+	bool open()
+	{
+		int numRecords;
+		FileInputStream in(LibraryManifest::getFile(mLibrary));
+		mReadsManifest = !in.getStatus().failed() && LibraryManifest::readHeader(in,mLibrary,numRecords);
+		if(mReadsManifest) return true;
+
+		logText("No current manifest next to " + mLibrary.getFullPathName() + ", the library is read once to hash it");
+		if(!mManifest.loadOrBuild(mLibrary)) return false;
+		mBytes += mLibrary.getSize();
+		return true;
+	};
+
+	bool getBlockHashes(int& numRecords, Array<int64>& blockHashes)
+	{
+		if(!mReadsManifest)
+		{
+			numRecords = mManifest.getNumRecords();
+			blockHashes = mManifest.getBlockHashes();
+			return true;
+		}
+
+		FileInputStream in(LibraryManifest::getFile(mLibrary));
+		if(in.getStatus().failed() || !LibraryManifest::readHeader(in,mLibrary,numRecords)) return false;
+
+		const int numBlocks = LibraryManifest::getNumBlocks(numRecords);
+		if(in.getTotalLength() != LIBRARY_MANIFEST_HEADER_SIZE + (int64)(numBlocks + numRecords)*8) return false;
+		blockHashes.clearQuick();
+		for(int b=0;b<numBlocks;b++)
+		{
+			blockHashes.add(in.readInt64());
+		}
+		mBytes += in.getPosition();
+		mNumRecords = numRecords;
+		return true;
+	};
+
+	bool getRecordHashes(const Array<int>& blocks, Array<int64>& recordHashes)
+	{
+		recordHashes.clearQuick();
+		if(!mReadsManifest)
+		{
+			for(int i=0;i<blocks.size();i++)
+			{
+				const int first = blocks[i]*LIBRARY_SYNC_BLOCK_RECORDS;
+				const int num = LibraryManifest::getBlockSize(blocks[i],mManifest.getNumRecords());
+				recordHashes.addArray(mManifest.getRecordHashes(),first,num);
+			}
+			return true;
+		}
+
+		FileInputStream in(LibraryManifest::getFile(mLibrary));
+		if(in.getStatus().failed()) return false;
+		const int64 recordsStart = LIBRARY_MANIFEST_HEADER_SIZE + (int64)LibraryManifest::getNumBlocks(mNumRecords)*8;
+		for(int i=0;i<blocks.size();i++)
+		{
+			const int first = blocks[i]*LIBRARY_SYNC_BLOCK_RECORDS;
+			const int num = LibraryManifest::getBlockSize(blocks[i],mNumRecords);
+			if(num <= 0 || !in.setPosition(recordsStart + (int64)first*8)) return false;
+			for(int r=0;r<num;r++)
+			{
+				recordHashes.add(in.readInt64());
+			}
+			mBytes += num*8;
+		}
+		return true;
+	};
+
+	bool getRecords(const Array<int>& records, MemoryBlock& data)
+	{
+		FileInputStream in(mLibrary);
+		if(in.getStatus().failed()) return false;
+
+		data.setSize(records.size()*PATCH_DATA_SIZE);
+		for(int i=0;i<records.size();i++)
+		{
+			if(!in.setPosition(PATCH_LIBRARY_HEADER_SIZE + (int64)records[i]*PATCH_DATA_SIZE)) return false;
+			if(in.read((uint8*)data.getData() + i*PATCH_DATA_SIZE,PATCH_DATA_SIZE) != PATCH_DATA_SIZE) return false;
+		}
+		mBytes += data.getSize();
+		return true;
+	};
+
+	int64 getBytesTransferred() const
+	{
+		return mBytes;
+	};
+
+private:
+	File mLibrary;
+	int64 mBytes;
+	bool mReadsManifest;		// the manifest on the share is current, else mManifest was built
+	int mNumRecords;			// of the manifest on the share
+	LibraryManifest mManifest;
+};
+
+//---------------------------------------------------------------------------
+/** Frames of the sync connection: a type and 32 bit counts and numbers, little endian*/
+class LibrarySyncFrame
+{
+public:
+	static MemoryBlock createRequest(int type, const Array<int>& numbers)
+	{
+		MemoryBlock frame;
+		MemoryOutputStream out(frame,false);
+		out.writeInt(type);
+		out.writeInt(numbers.size());
+		for(int i=0;i<numbers.size();i++)
+		{
+			out.writeInt(numbers.getUnchecked(i));
+		}
+		out.flush();
+		return frame;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** Serves one library to the LibrarySyncClients of other machines. The
+	library and its manifest are read when start() is called, the
+	connections answer on their own threads.
+*/
+class LibrarySyncServer : public InterprocessConnectionServer
+{
+public:
+	LibrarySyncServer()
+	{
+	};
+
+	~LibrarySyncServer()
+	{
+		stop();
+	};
+
+	/** returns false if the library can't be read or the port can't be opened*/
+	bool start(const File& library, int port)
+	{
+		stop();
+		if(!mManifest.loadOrBuild(library) || !mLibrary.open(library)) return false;
+		return beginWaitingForSocket(port);
+	};
+
+	void stop()
+	{
+		InterprocessConnectionServer::stop();
+		const ScopedLock sl(mLock);
+		mConnections.clear();
+	};
+
+	int getNumRecords() const
+	{
+		return mManifest.getNumRecords();
+	};
+
+private:
+	//-----------------------------------------------------------------------
+	class Responder : public InterprocessConnection
+	{
+	public:
+		Responder(LibrarySyncServer& owner) : InterprocessConnection(false,LIBRARY_SYNC_MAGIC), mOwner(owner)
+		{
+		};
+
+		~Responder()
+		{
+			disconnect();
+		};
+
+		void connectionMade() {};
+		void connectionLost() {};
+
+		void messageReceived(const MemoryBlock& request)
+		{
+			MemoryInputStream in(request,false);
+			const int type = in.readInt();
+			const int num = jlimit(0,LIBRARY_SYNC_MAX_REQUEST,in.readInt());
+
+			MemoryBlock reply;
+			MemoryOutputStream out(reply,false);
+			out.writeInt(type);
+
+			const LibraryManifest& manifest = mOwner.mManifest;
+			const int numRecords = manifest.getNumRecords();
+			if(type == LIBRARY_SYNC_BLOCKS)
+			{
+				out.writeInt(numRecords);
+				out.writeInt(manifest.getBlockHashes().size());
+				for(int b=0;b<manifest.getBlockHashes().size();b++)
+				{
+					out.writeInt64(manifest.getBlockHashes().getUnchecked(b));
+				}
+			}
+			else if(type == LIBRARY_SYNC_HASHES)
+			{
+				for(int i=0;i<num;i++)
+				{
+					const int block = in.readInt();
+					if(block < 0 || block >= LibraryManifest::getNumBlocks(numRecords)) return;
+					const int first = block*LIBRARY_SYNC_BLOCK_RECORDS;
+					for(int r=0;r<LibraryManifest::getBlockSize(block,numRecords);r++)
+					{
+						out.writeInt64(manifest.getRecordHashes().getUnchecked(first+r));
+					}
+				}
+			}
+			else if(type == LIBRARY_SYNC_RECORDS)
+			{
+				for(int i=0;i<num;i++)
+				{
+					const int record = in.readInt();
+					if(record < 0 || record >= numRecords) return;
+					out.write(mOwner.mLibrary.getPatchData(record),PATCH_DATA_SIZE);
+				}
+			}
+			else return;
+
+			out.flush();
+			sendMessage(reply);
+		};
+
+	private:
+		LibrarySyncServer& mOwner;
+	};
+	//-----------------------------------------------------------------------
+
+	/** on the listener thread*/
+	InterprocessConnection* createConnectionObject()
+	{
+		Responder* responder = new Responder(*this);
+		const ScopedLock sl(mLock);
+		mConnections.add(responder);
+		return responder;
+	};
+
+	PatchLibrary mLibrary;		// only read once started
+	LibraryManifest mManifest;
+	CriticalSection mLock;
+	OwnedArray<Responder> mConnections;	// the closed ones stay until stop()
+};
+
+//---------------------------------------------------------------------------
+/** The library of a LibrarySyncServer on another machine. One request is
+	on its way at a time, the calls wait for the answer.
+*/
+class LibrarySyncClient : public LibrarySyncSource
+{
+public:
+	LibrarySyncClient() : mBytes(0)
+	{
+	};
+
+	bool connect(const String& hostName, int port)
+	{
+		return mConnection.connectToSocket(hostName,port,LIBRARY_SYNC_TIMEOUT_MS);
+	};
+
+	bool getBlockHashes(int& numRecords, Array<int64>& blockHashes)
+	{
+		MemoryBlock reply;
+		if(!request(LibrarySyncFrame::createRequest(LIBRARY_SYNC_BLOCKS,Array<int>()),reply)) return false;
+
+		MemoryInputStream in(reply,false);
+		in.readInt();
+		numRecords = in.readInt();
+		const int numBlocks = in.readInt();
+		if(numRecords < 0 || numBlocks != LibraryManifest::getNumBlocks(numRecords) || reply.getSize() != (size_t)(12 + numBlocks*8)) return false;
+
+		blockHashes.clearQuick();
+		for(int b=0;b<numBlocks;b++)
+		{
+			blockHashes.add(in.readInt64());
+		}
+		return true;
+	};
+
+	bool getRecordHashes(const Array<int>& blocks, Array<int64>& recordHashes)
+	{
+		MemoryBlock reply;
+		if(!request(LibrarySyncFrame::createRequest(LIBRARY_SYNC_HASHES,blocks),reply)) return false;
+		if(reply.getSize() < 4 || (reply.getSize()-4) % 8 != 0) return false;
+
+		MemoryInputStream in(reply,false);
+		in.readInt();
+		recordHashes.clearQuick();
+		while(!in.isExhausted())
+		{
+			recordHashes.add(in.readInt64());
+		}
+		return true;
+	};
+
+	bool getRecords(const Array<int>& records, MemoryBlock& data)
+	{
+		MemoryBlock reply;
+		if(!request(LibrarySyncFrame::createRequest(LIBRARY_SYNC_RECORDS,records),reply)) return false;
+		if(reply.getSize() != (size_t)(4 + records.size()*PATCH_DATA_SIZE)) return false;
+
+		data = MemoryBlock((const uint8*)reply.getData() + 4,reply.getSize() - 4);
+		return true;
+	};
+
+	int64 getBytesTransferred() const
+	{
+		return mBytes;
+	};
+
+private:
+	bool request(const MemoryBlock& frame, MemoryBlock& reply)
+	{
+		const int type = (int)ByteOrder::littleEndianInt(frame.getData());
+		mConnection.mAnswered.reset();
+		if(!mConnection.sendMessage(frame) || !mConnection.mAnswered.wait(LIBRARY_SYNC_TIMEOUT_MS)) return false;
+
+		{
+			const ScopedLock sl(mConnection.mLock);
+			reply.swapWith(mConnection.mReply);
+		}
+		mBytes += frame.getSize() + reply.getSize();
+		return reply.getSize() >= 4 && (int)ByteOrder::littleEndianInt(reply.getData()) == type;
+	};
+
+	class Connection : public InterprocessConnection
+	{
+	public:
+		Connection() : InterprocessConnection(false,LIBRARY_SYNC_MAGIC)
+		{
+		};
+
+		~Connection()
+		{
+			disconnect();
+		};
+
+		void connectionMade() {};
+
+		/** a request that waits gives up at once*/
+		void connectionLost()
+		{
+			mAnswered.signal();
+		};
+
+		void messageReceived(const MemoryBlock& message)
+		{
+			{
+				const ScopedLock sl(mLock);
+				mReply = message;
+			}
+			mAnswered.signal();
+		};
+
+		CriticalSection mLock;
+		MemoryBlock mReply;		// under the lock
+		WaitableEvent mAnswered;
+	};
+
+	Connection mConnection;
+	int64 mBytes;
+};
+
+//---------------------------------------------------------------------------
+/** Makes a local library a copy of the library of a LibrarySyncSource.
+
+	The block hashes of both are compared first, the record hashes are only
+	fetched for the blocks that differ, and a record is only transferred if
+	no record of the local library has its hash. So a library that changed
+	in a few places costs the block hashes plus a few blocks of record
+	hashes and the new records, records that moved are taken from the local
+	copy. The new library is written through a PatchLibraryWriter, which
+	also sorts its name index, and its manifest next to it.
+*/
+class LibrarySync
+{
+public:
+	/** returns false and sets the error if a transfer failed, the local library is then unchanged*/
+	static bool pull(LibrarySyncSource& source, const File& target, String& report)
+	{
+		TRACE_SCOPE("patch io","sync library");
+		int numRecords;
+		Array<int64> remoteBlocks;
+		if(!source.getBlockHashes(numRecords,remoteBlocks))
+		{
+			report = "can't read the block hashes of the source";
+			return false;
+		}
+
+		PatchLibrary local;
+		LibraryManifest localManifest;
+		if(local.open(target))
+		{
+			if(!localManifest.load(target)) localManifest.build(local);
+		}
+
+		//the blocks that differ, their record hashes are fetched
+		Array<int64> recordHashes;
+		recordHashes.insertMultiple(0,0,numRecords);
+		Array<int> changedBlocks;
+		for(int b=0;b<remoteBlocks.size();b++)
+		{
+			const bool same = b < localManifest.getBlockHashes().size() && localManifest.getBlockHashes()[b] == remoteBlocks[b]
+				&& LibraryManifest::getBlockSize(b,localManifest.getNumRecords()) == LibraryManifest::getBlockSize(b,numRecords);
+			if(same)
+			{
+				const int first = b*LIBRARY_SYNC_BLOCK_RECORDS;
+				for(int r=0;r<LibraryManifest::getBlockSize(b,numRecords);r++)
+				{
+					recordHashes.set(first+r,localManifest.getRecordHashes()[first+r]);
+				}
+			}
+			else changedBlocks.add(b);
+		}
+		if(changedBlocks.size() == 0 && numRecords == localManifest.getNumRecords())
+		{
+			report = String(numRecords) + " records, up to date, " + String(source.getBytesTransferred()) + " bytes transferred";
+			return true;
+		}
+
+		for(int start=0;start<changedBlocks.size();start+=LIBRARY_SYNC_MAX_REQUEST)
+		{
+			Array<int> blocks;
+			blocks.addArray(changedBlocks,start,LIBRARY_SYNC_MAX_REQUEST);
+			Array<int64> hashes;
+			if(!source.getRecordHashes(blocks,hashes))
+			{
+				report = "can't read the record hashes of the source";
+				return false;
+			}
+			int next = 0;
+			for(int i=0;i<blocks.size();i++)
+			{
+				const int first = blocks[i]*LIBRARY_SYNC_BLOCK_RECORDS;
+				const int num = LibraryManifest::getBlockSize(blocks[i],numRecords);
+				if(next + num > hashes.size())
+				{
+					report = "the source sent too few record hashes";
+					return false;
+				}
+				for(int r=0;r<num;r++)
+				{
+					recordHashes.set(first+r,hashes[next++]);
+				}
+			}
+		}
+
+		//every record the local library has is taken from there
+		FlatHashMap<int64,int,PatchHashFunctions> localRecords(localManifest.getNumRecords());
+		for(int i=0;i<localManifest.getNumRecords();i++)
+		{
+			if(!localRecords.contains(localManifest.getRecordHashes()[i])) localRecords.set(localManifest.getRecordHashes()[i],i);
+		}
+		Array<int> missing;
+		FlatHashMap<int64,int,PatchHashFunctions> fetchedRecords(64);
+		for(int i=0;i<numRecords;i++)
+		{
+			const int64 hash = recordHashes[i];
+			if(localRecords.contains(hash) || fetchedRecords.contains(hash)) continue;
+			fetchedRecords.set(hash,missing.size());
+			missing.add(i);
+		}
+
+		MemoryBlock fetched(missing.size()*PATCH_DATA_SIZE);
+		for(int start=0;start<missing.size();start+=LIBRARY_SYNC_MAX_REQUEST)
+		{
+			Array<int> records;
+			records.addArray(missing,start,LIBRARY_SYNC_MAX_REQUEST);
+			MemoryBlock data;
+			if(!source.getRecords(records,data))
+			{
+				report = "can't read the records of the source";
+				return false;
+			}
+			for(int i=0;i<records.size();i++)
+			{
+				const uint8_t* record = (const uint8_t*)data.getData() + i*PATCH_DATA_SIZE;
+				if(LibraryManifest::hashRecord(record) != recordHashes[records[i]])
+				{
+					report = "record " + String(records[i]) + " of the source doesn't match its hash";
+					return false;
+				}
+			}
+			fetched.copyFrom(data.getData(),start*PATCH_DATA_SIZE,data.getSize());
+		}
+
+		//the local library is mapped until every record is written to the temporary file
+		PatchLibraryWriter writer(target);
+		for(int i=0;i<numRecords;i++)
+		{
+			const int* localIndex = localRecords.find(recordHashes[i]);
+			if(localIndex != NULL)	writer.addPatch(local.getPatchData(*localIndex));
+			else					writer.addPatch((const uint8_t*)fetched.getData() + *fetchedRecords.find(recordHashes[i])*PATCH_DATA_SIZE);
+		}
+		local.close();
+		if(!writer.finish())
+		{
+			report = "can't write " + target.getFullPathName();
+			return false;
+		}
+
+		LibraryManifest manifest;
+		manifest.setRecordHashes(recordHashes);
+		manifest.save(target);
+
+		report = String(numRecords) + " records, " + String(changedBlocks.size()) + " of " + String(remoteBlocks.size()) + " blocks changed, "
+			+ String(missing.size()) + " records fetched, " + String(source.getBytesTransferred()) + " bytes transferred";
+		return true;
+	};
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,76 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//---------------------------------------------------------------------------
+/** A whole file mapped read only into memory, shared by reference count.
+
+	The bytes come straight from the OS page cache, a loader parses them
+	where they are instead of reading them into a MemoryBlock first. Whoever
+	reads the data holds a Ptr, so the mapping stays valid for a job that is
+	still parsing it even when its owner has moved on to another file.
+	Mapping costs a few system calls and a page per file, it pays off for
+	banks and libraries, not for a single .SND file.
+*/
+class MappedFileData : public ReferenceCountedObject
+{
+public:
+	typedef ReferenceCountedObjectPtr<MappedFileData> Ptr;
+
+	/** NULL if the file is missing, empty or can't be mapped*/
+	static Ptr open(const File& file)
+	{
+		Ptr mapping(new MappedFileData(file));
+		if(mapping->getData() == NULL) return NULL;
+		return mapping;
+	};
+
+	const uint8_t* getData() const
+	{
+		return (const uint8_t*)mFile.getData();
+	};
+
+	size_t getSize() const
+	{
+		return mFile.getSize();
+	};
+
+	/** numBytes at offset, or NULL if they are not all inside the file*/
+	const uint8_t* getRange(size_t offset, size_t numBytes) const
+	{
+		if(offset > getSize() || numBytes > getSize() - offset) return NULL;
+		return getData() + offset;
+	};
+
+private:
+	MappedFileData(const File& file) : mFile(file,MemoryMappedFile::readOnly)
+	{
+	};
+
+	MemoryMappedFile mFile;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,634 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PresetLoader.h"
+#include "../PatchDistance.h"
+#include "../PatchVpTree.h"
+#include "MappedFileData.h"
+
+#define PATCH_ARCHIVE_MAGIC			0x5a505053	// "SPPZ" little endian
+#define PATCH_ARCHIVE_VERSION		1
+#define PATCH_ARCHIVE_EXTENSION		".spz"
+#define PATCH_ARCHIVE_HEADER_SIZE	24
+#define PATCH_ARCHIVE_BLOCK_PATCHES	128		// patches decoded at once, a block is the unit of random access
+#define PATCH_ARCHIVE_REFERENCE_BITS	7		// a patch refers to one of the 127 before it in its block, 0 is the archive's reference
+#define PATCH_ARCHIVE_CACHE_BLOCKS	8
+#define PATCH_ARCHIVE_TABLE_OFFSET	(PATCH_ARCHIVE_HEADER_SIZE + NUM_PARAMS + NUM_PARAMS*2*2)	// after the reference and the priors
+
+// the range coder, the same as the one of LZMA
+#define ARCHIVE_PROB_BITS			11
+#define ARCHIVE_PROB_ONE			(1 << ARCHIVE_PROB_BITS)
+#define ARCHIVE_MOVE_BITS			5		// how fast a probability follows the bits
+#define ARCHIVE_RANGE_TOP			(1 << 24)
+
+//---------------------------------------------------------------------------
+/** Binary range coder with adaptive probabilities. A probability is the
+	chance of a 0 in ARCHIVE_PROB_BITS bits and moves towards every bit
+	coded with it.
+*/
+class ArchiveEncoder
+{
+public:
+	ArchiveEncoder(MemoryOutputStream& out) : mOut(out), mLow(0), mRange(0xffffffff), mCache(0), mCacheSize(1)
+	{
+	};
+
+	void encodeBit(uint16& prob, int bit)
+	{
+		const uint32 bound = (mRange >> ARCHIVE_PROB_BITS) * prob;
+		if(bit == 0)
+		{
+			mRange = bound;
+			prob = (uint16)(prob + ((ARCHIVE_PROB_ONE - prob) >> ARCHIVE_MOVE_BITS));
+		}
+		else
+		{
+			mLow += bound;
+			mRange -= bound;
+			prob = (uint16)(prob - (prob >> ARCHIVE_MOVE_BITS));
+		}
+		while(mRange < ARCHIVE_RANGE_TOP)
+		{
+			mRange <<= 8;
+			shiftLow();
+		}
+	};
+
+	/** numBits bits of value, high bit first, each coded with the probability of the bits above it. probs has 1 << numBits entries*/
+	void encodeTree(uint16* probs, int numBits, int value)
+	{
+		int node = 1;
+		for(int i=numBits-1;i>=0;i--)
+		{
+			const int bit = (value >> i) & 1;
+			encodeBit(probs[node],bit);
+			node = (node << 1) | bit;
+		}
+	};
+
+	void flush()
+	{
+		for(int i=0;i<5;i++)
+		{
+			shiftLow();
+		}
+	};
+
+private:
+	/** a carry can still change the bytes held back in the cache*/
+	void shiftLow()
+	{
+		if((uint32)mLow < 0xff000000 || (int)(mLow >> 32) != 0)
+		{
+			uint8 temp = mCache;
+			do
+			{
+				mOut.writeByte((char)(uint8)(temp + (uint8)(mLow >> 32)));
+				temp = 0xff;
+			}
+			while(--mCacheSize != 0);
+			mCache = (uint8)(mLow >> 24);
+		}
+		mCacheSize++;
+		mLow = (mLow & 0x00ffffff) << 8;
+	};
+
+	MemoryOutputStream& mOut;
+	uint64 mLow;
+	uint32 mRange;
+	uint8 mCache;
+	int64 mCacheSize;
+};
+
+//---------------------------------------------------------------------------
+/** Reads what an ArchiveEncoder wrote. Reading past the end gives zeros,
+	hasOverrun() tells a damaged block*/
+class ArchiveDecoder
+{
+public:
+	ArchiveDecoder(const uint8_t* data, int size) : mData(data), mSize(size), mPos(0), mCode(0), mRange(0xffffffff)
+	{
+		for(int i=0;i<5;i++)
+		{
+			mCode = (mCode << 8) | nextByte();
+		}
+	};
+
+	int decodeBit(uint16& prob)
+	{
+		const uint32 bound = (mRange >> ARCHIVE_PROB_BITS) * prob;
+		int bit;
+		if(mCode < bound)
+		{
+			mRange = bound;
+			prob = (uint16)(prob + ((ARCHIVE_PROB_ONE - prob) >> ARCHIVE_MOVE_BITS));
+			bit = 0;
+		}
+		else
+		{
+			mCode -= bound;
+			mRange -= bound;
+			prob = (uint16)(prob - (prob >> ARCHIVE_MOVE_BITS));
+			bit = 1;
+		}
+		while(mRange < ARCHIVE_RANGE_TOP)
+		{
+			mRange <<= 8;
+			mCode = (mCode << 8) | nextByte();
+		}
+		return bit;
+	};
+
+	int decodeTree(uint16* probs, int numBits)
+	{
+		int node = 1;
+		for(int i=0;i<numBits;i++)
+		{
+			node = (node << 1) | decodeBit(probs[node]);
+		}
+		return node - (1 << numBits);
+	};
+
+	bool hasOverrun() const
+	{
+		return mPos > mSize;
+	};
+
+private:
+	uint32 nextByte()
+	{
+		return mPos < mSize ? mData[mPos++] : (mPos++, 0);
+	};
+
+	const uint8_t* mData;
+	int mSize;
+	int mPos;
+	uint32 mCode;
+	uint32 mRange;
+};
+
+//---------------------------------------------------------------------------
+/** The probabilities of one block. Every block starts from the same
+	state, so it can be decoded without the ones before it.
+
+	A parameter either has the value of the reference, or the residual,
+	the difference to it, is coded. Whether it changed is coded with a
+	probability of its own that depends on whether it changed in the
+	patch before, the archive stores a first guess of those from the whole
+	library. A residual is its sign and the number of bits of its size,
+	both per parameter, then the bits below the top one, shared by all
+	parameters. Small steps of a knob cost a few bits, and the model
+	learns a parameter from the few patches of a block. The name bytes
+	have a bit tree per position.
+*/
+struct ArchiveModel
+{
+	uint16 reference[1 << PATCH_ARCHIVE_REFERENCE_BITS];
+	uint16 changed[NUM_PARAMS][2];
+	uint16 sign[NUM_PARAMS];
+	uint16 magnitude[NUM_PARAMS][8];	// a bit tree of the top bit of the size, 0..7
+	uint16 mantissa[8][128];			// the bits below it, by top bit
+	uint16 name[PATCH_NAME_LENGTH][256];
+	uint8 changedBefore[NUM_PARAMS];	// in the patch before, 0 or 1
+
+	void reset(const uint16* changedPriors)
+	{
+		fill(reference,1 << PATCH_ARCHIVE_REFERENCE_BITS);
+		fill(sign,NUM_PARAMS);
+		fill(&magnitude[0][0],NUM_PARAMS*8);
+		fill(&mantissa[0][0],8*128);
+		fill(&name[0][0],PATCH_NAME_LENGTH*256);
+		memcpy(changed,changedPriors,sizeof(changed));
+		memset(changedBefore,0,sizeof(changedBefore));
+	};
+
+	/** value and reference differ*/
+	void encodeResidual(ArchiveEncoder& encoder, int parameterNr, int value, int reference)
+	{
+		const int residual = value - reference;
+		const int size = residual < 0 ? -residual : residual;
+		const int topBit = getTopBit(size);
+		encoder.encodeBit(sign[parameterNr],residual < 0 ? 1 : 0);
+		encoder.encodeTree(magnitude[parameterNr],3,topBit);
+		if(topBit > 0) encoder.encodeTree(mantissa[topBit],topBit,size - (1 << topBit));
+	};
+
+	int decodeResidual(ArchiveDecoder& decoder, int parameterNr, int reference)
+	{
+		const int negative = decoder.decodeBit(sign[parameterNr]);
+		const int topBit = decoder.decodeTree(magnitude[parameterNr],3);
+		const int size = (1 << topBit) + (topBit > 0 ? decoder.decodeTree(mantissa[topBit],topBit) : 0);
+		return (reference + (negative ? -size : size)) & 0xff;
+	};
+
+private:
+	static int getTopBit(int size)
+	{
+		int bit = 0;
+		while(size >> (bit+1)) bit++;
+		return bit;
+	};
+
+	static void fill(uint16* probs, int num)
+	{
+		for(int i=0;i<num;i++)
+		{
+			probs[i] = ARCHIVE_PROB_ONE/2;
+		}
+	};
+};
+
+//---------------------------------------------------------------------------
+/** A bank of patches compressed for the SD card, read a block at a time.
+
+	The patches are put in the order of a PatchVpTree over their values,
+	so similar ones are neighbours, and cut into blocks of
+	PATCH_ARCHIVE_BLOCK_PATCHES. Every patch refers to the earlier patch
+	of its block it has the most values in common with, or to the
+	reference patch of the archive (the most common value of every
+	parameter). Only the values that differ from the reference are
+	stored, as the residual to the reference, and all of it goes through
+	an adaptive range coder (ArchiveModel). The archive keeps the patches, not their order.
+
+	Layout (numbers 32 bit little endian):
+	header		magic, version, NUM_PARAMS, number of patches, patches
+				per block, number of blocks
+	reference	NUM_PARAMS bytes
+	priors		NUM_PARAMS*2 16 bit probabilities of ArchiveModel::changed
+	block table	file offset of every block and of the end of the last one
+	blocks		the range coded patches
+
+	The reader maps the file and decodes a block when one of its patches
+	is asked for. The last PATCH_ARCHIVE_CACHE_BLOCKS blocks are kept, an
+	archive of any size needs a few hundred KB to browse.
+*/
+class PatchArchive
+{
+public:
+	PatchArchive() : mReference(NULL), mPriors(NULL), mBlockTable(NULL), mNumPatches(0), mNumBlocks(0), mUseCount(0)
+	{
+		mModel.malloc(1);
+	};
+
+	~PatchArchive()
+	{
+		close();
+	};
+
+	/** returns false if the file isn't a valid archive*/
+	bool open(const File& file)
+	{
+		TRACE_SCOPE("patch io","open archive");
+		close();
+
+		mMapping = MappedFileData::open(file);
+		const uint8_t* header = mMapping != NULL ? mMapping->getRange(0,PATCH_ARCHIVE_HEADER_SIZE) : NULL;
+		if(header == NULL
+			|| readInt(header,0) != PATCH_ARCHIVE_MAGIC
+			|| readInt(header,1) != PATCH_ARCHIVE_VERSION
+			|| readInt(header,2) != NUM_PARAMS
+			|| readInt(header,4) != PATCH_ARCHIVE_BLOCK_PATCHES)
+		{
+			close();
+			return false;
+		}
+
+		const int numPatches = (int)readInt(header,3);
+		const int numBlocks = (int)readInt(header,5);
+		mBlockTable = numPatches >= 0 && numBlocks == (numPatches + PATCH_ARCHIVE_BLOCK_PATCHES-1)/PATCH_ARCHIVE_BLOCK_PATCHES
+			? mMapping->getRange(PATCH_ARCHIVE_TABLE_OFFSET,(size_t)(numBlocks+1)*4) : NULL;
+		if(mBlockTable == NULL || readInt(mBlockTable,numBlocks) > mMapping->getSize())
+		{
+			close();
+			return false;
+		}
+		for(int i=0;i<numBlocks;i++)
+		{
+			if(readInt(mBlockTable,i) > readInt(mBlockTable,i+1))
+			{
+				close();
+				return false;
+			}
+		}
+
+		mReference = mMapping->getData() + PATCH_ARCHIVE_HEADER_SIZE;
+		mPriors = mReference + NUM_PARAMS;
+		mNumPatches = numPatches;
+		mNumBlocks = numBlocks;
+		mFile = file;
+		return true;
+	};
+
+	void close()
+	{
+		mMapping = NULL;
+		mReference = NULL;
+		mPriors = NULL;
+		mBlockTable = NULL;
+		mNumPatches = 0;
+		mNumBlocks = 0;
+		mFile = File::nonexistent;
+		mCache.clear();
+	};
+
+	bool isOpen() const
+	{
+		return mMapping != NULL;
+	};
+
+	const File& getFile() const
+	{
+		return mFile;
+	};
+
+	int getNumPatches() const
+	{
+		return mNumPatches;
+	};
+
+	/** the PATCH_DATA_SIZE bytes of a patch. The pointer stays valid until
+		PATCH_ARCHIVE_CACHE_BLOCKS other blocks have been decoded. A damaged block reads as empty patches*/
+	const uint8_t* getPatchData(int index)
+	{
+		jassert(index >= 0 && index < mNumPatches);
+		const int block = index / PATCH_ARCHIVE_BLOCK_PATCHES;
+		CachedBlock* cached = NULL;
+		for(int i=0;i<mCache.size() && cached == NULL;i++)
+		{
+			if(mCache[i]->block == block) cached = mCache[i];
+		}
+		if(cached == NULL)
+		{
+			if(mCache.size() < PATCH_ARCHIVE_CACHE_BLOCKS)
+			{
+				cached = new CachedBlock();
+				mCache.add(cached);
+			}
+			else
+			{
+				cached = mCache[0];
+				for(int i=1;i<mCache.size();i++)
+				{
+					if(mCache[i]->lastUse < cached->lastUse) cached = mCache[i];
+				}
+			}
+			cached->block = block;
+			if(!decodeBlock(block,cached->records))
+			{
+				memset(cached->records,0,sizeof(cached->records));
+			}
+		}
+		cached->lastUse = ++mUseCount;
+		return cached->records + (index % PATCH_ARCHIVE_BLOCK_PATCHES)*PATCH_DATA_SIZE;
+	};
+
+	/** the patches of a block into records, PATCH_DATA_SIZE each. returns false if the block is damaged*/
+	bool decodeBlock(int block, uint8_t* records)
+	{
+		const int first = block*PATCH_ARCHIVE_BLOCK_PATCHES;
+		const int numPatches = jmin(PATCH_ARCHIVE_BLOCK_PATCHES,mNumPatches-first);
+		const uint32 start = readInt(mBlockTable,block);
+		ArchiveDecoder decoder(mMapping->getData() + start,(int)(readInt(mBlockTable,block+1) - start));
+
+		ArchiveModel& model = *mModel;
+		model.reset(getPriors());
+		for(int i=0;i<numPatches;i++)
+		{
+			uint8_t* record = records + i*PATCH_DATA_SIZE;
+			const int back = decoder.decodeTree(model.reference,PATCH_ARCHIVE_REFERENCE_BITS);
+			if(back > i) return false;
+			const uint8_t* reference = back > 0 ? record - back*PATCH_DATA_SIZE + PATCH_NAME_LENGTH : mReference;
+
+			for(int c=0;c<PATCH_NAME_LENGTH;c++)
+			{
+				record[c] = (uint8_t)decoder.decodeTree(model.name[c],8);
+			}
+			uint8_t* values = record + PATCH_NAME_LENGTH;
+			for(int p=0;p<NUM_PARAMS;p++)
+			{
+				const int changed = decoder.decodeBit(model.changed[p][model.changedBefore[p]]);
+				values[p] = changed ? (uint8_t)model.decodeResidual(decoder,p,reference[p]) : reference[p];
+				model.changedBefore[p] = (uint8)changed;
+			}
+		}
+		return !decoder.hasOverrun();
+	};
+
+	//-----------------------------------------------------------------------
+	/** compress PATCH_DATA_SIZE records stored back to back into an archive*/
+	static bool write(const File& file, const void* records, int numPatches)
+	{
+		TRACE_SCOPE("patch io","write archive");
+		const uint8_t* data = (const uint8_t*)records;
+
+		//similar patches next to each other
+		Array<int> order;
+		if(numPatches > 0)
+		{
+			PatchVpTree tree;
+			tree.build(data + PATCH_NAME_LENGTH,numPatches,PATCH_DATA_SIZE);
+			order.ensureStorageAllocated(numPatches);
+			for(int i=0;i<numPatches;i++)
+			{
+				order.add(tree.getNodeSample(i));
+			}
+		}
+
+		uint8_t reference[NUM_PARAMS];
+		findReference(data,numPatches,reference);
+
+		//the references first, the priors are counted from them
+		HeapBlock<uint8> back;
+		back.calloc(jmax(1,numPatches));
+		int counts[NUM_PARAMS][2][2];
+		memset(counts,0,sizeof(counts));
+		for(int i=0;i<numPatches;i++)
+		{
+			const int blockStart = i - i%PATCH_ARCHIVE_BLOCK_PATCHES;
+			const uint8_t* values = data + order[i]*PATCH_DATA_SIZE + PATCH_NAME_LENGTH;
+			int best = PatchDistance::hamming(values,reference);
+			for(int j=i-1;j>=blockStart && best > 0;j--)
+			{
+				const int d = PatchDistance::hamming(values,data + order[j]*PATCH_DATA_SIZE + PATCH_NAME_LENGTH);
+				if(d < best)
+				{
+					best = d;
+					back[i] = (uint8)(i-j);
+				}
+			}
+
+			const uint8_t* ref = back[i] > 0 ? data + order[i-back[i]]*PATCH_DATA_SIZE + PATCH_NAME_LENGTH : reference;
+			const uint8_t* before = i > blockStart ? data + order[i-1]*PATCH_DATA_SIZE + PATCH_NAME_LENGTH : NULL;
+			const uint8_t* beforeRef = NULL;
+			if(before != NULL) beforeRef = back[i-1] > 0 ? data + order[i-1-back[i-1]]*PATCH_DATA_SIZE + PATCH_NAME_LENGTH : reference;
+			for(int p=0;p<NUM_PARAMS;p++)
+			{
+				const int changedBefore = before != NULL && before[p] != beforeRef[p] ? 1 : 0;
+				counts[p][changedBefore][values[p] != ref[p] ? 1 : 0]++;
+			}
+		}
+		uint16 priors[NUM_PARAMS][2];
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			for(int c=0;c<2;c++)
+			{
+				//the chance of a 0, kept off the ends so a surprise stays affordable
+				const int total = counts[p][c][0] + counts[p][c][1];
+				const int prob = total > 0 ? (int)((int64)counts[p][c][0]*ARCHIVE_PROB_ONE/total) : ARCHIVE_PROB_ONE/2;
+				priors[p][c] = (uint16)jlimit(32,ARCHIVE_PROB_ONE-32,prob);
+			}
+		}
+
+		//the blocks
+		const int numBlocks = (numPatches + PATCH_ARCHIVE_BLOCK_PATCHES-1)/PATCH_ARCHIVE_BLOCK_PATCHES;
+		MemoryOutputStream blocks;
+		Array<uint32> offsets;
+		const uint32 firstOffset = PATCH_ARCHIVE_TABLE_OFFSET + (numBlocks+1)*4;
+		HeapBlock<ArchiveModel> model(1);
+		for(int block=0;block<numBlocks;block++)
+		{
+			offsets.add(firstOffset + (uint32)blocks.getDataSize());
+			model->reset(&priors[0][0]);
+			ArchiveEncoder encoder(blocks);
+
+			const int first = block*PATCH_ARCHIVE_BLOCK_PATCHES;
+			const int end = jmin(numPatches,first+PATCH_ARCHIVE_BLOCK_PATCHES);
+			for(int i=first;i<end;i++)
+			{
+				const uint8_t* record = data + order[i]*PATCH_DATA_SIZE;
+				const uint8_t* values = record + PATCH_NAME_LENGTH;
+				const uint8_t* ref = back[i] > 0 ? data + order[i-back[i]]*PATCH_DATA_SIZE + PATCH_NAME_LENGTH : reference;
+
+				encoder.encodeTree(model->reference,PATCH_ARCHIVE_REFERENCE_BITS,back[i]);
+				for(int c=0;c<PATCH_NAME_LENGTH;c++)
+				{
+					encoder.encodeTree(model->name[c],8,record[c]);
+				}
+				for(int p=0;p<NUM_PARAMS;p++)
+				{
+					const int changed = values[p] != ref[p] ? 1 : 0;
+					encoder.encodeBit(model->changed[p][model->changedBefore[p]],changed);
+					if(changed) model->encodeResidual(encoder,p,values[p],ref[p]);
+					model->changedBefore[p] = (uint8)changed;
+				}
+			}
+			encoder.flush();
+		}
+		offsets.add(firstOffset + (uint32)blocks.getDataSize());
+
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->writeInt(PATCH_ARCHIVE_MAGIC);
+			out->writeInt(PATCH_ARCHIVE_VERSION);
+			out->writeInt(NUM_PARAMS);
+			out->writeInt(numPatches);
+			out->writeInt(PATCH_ARCHIVE_BLOCK_PATCHES);
+			out->writeInt(numBlocks);
+			out->write(reference,NUM_PARAMS);
+			for(int p=0;p<NUM_PARAMS;p++)
+			{
+				out->writeShort((short)priors[p][0]);
+				out->writeShort((short)priors[p][1]);
+			}
+			for(int i=0;i<offsets.size();i++)
+			{
+				out->writeInt((int)offsets[i]);
+			}
+			out->write(blocks.getData(),blocks.getDataSize());
+
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+private:
+	struct CachedBlock
+	{
+		CachedBlock() : block(-1), lastUse(0) {};
+
+		int block;
+		int lastUse;
+		uint8_t records[PATCH_ARCHIVE_BLOCK_PATCHES*PATCH_DATA_SIZE];
+	};
+
+	/** the most common value of every parameter*/
+	static void findReference(const uint8_t* data, int numPatches, uint8_t* reference)
+	{
+		HeapBlock<int> counts;
+		counts.calloc(NUM_PARAMS*256);
+		for(int i=0;i<numPatches;i++)
+		{
+			const uint8_t* values = data + i*PATCH_DATA_SIZE + PATCH_NAME_LENGTH;
+			for(int p=0;p<NUM_PARAMS;p++)
+			{
+				counts[p*256 + values[p]]++;
+			}
+		}
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			int best = 0;
+			for(int v=1;v<256;v++)
+			{
+				if(counts[p*256 + v] > counts[p*256 + best]) best = v;
+			}
+			reference[p] = (uint8_t)best;
+		}
+	};
+
+	/** the priors are stored unaligned*/
+	const uint16* getPriors()
+	{
+		for(int p=0;p<NUM_PARAMS*2;p++)
+		{
+			mPriorsCopy[p] = ByteOrder::littleEndianShort(mPriors + p*2);
+		}
+		return mPriorsCopy;
+	};
+
+	static uint32 readInt(const uint8_t* data, int index)
+	{
+		return ByteOrder::littleEndianInt(data + index*4);
+	};
+
+	MappedFileData::Ptr mMapping;
+	File mFile;
+	const uint8_t* mReference;
+	const uint8_t* mPriors;
+	const uint8_t* mBlockTable;
+	int mNumPatches;
+	int mNumBlocks;
+
+	HeapBlock<ArchiveModel> mModel;
+	uint16 mPriorsCopy[NUM_PARAMS*2];
+	OwnedArray<CachedBlock> mCache;
+	int mUseCount;
+};
+//---------------------------------------------------------------------------
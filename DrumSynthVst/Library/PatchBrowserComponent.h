@@ -0,0 +1,494 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../ParameterStore.h"
+#include "../PresetLoader.h"
+#include "../Preview/PreviewEngine.h"
+#include "../Preview/PatchThumbnailCache.h"
+#include "../ThreadPriorities.h"
+#include "../VoteDatabase.h"
+#include "PatchLibrary.h"
+#include "MappedFileData.h"
+#include "PatchQueryIndex.h"
+#include "PatchClusters.h"
+#include "PatchArchive.h"
+
+#define BROWSER_PREFETCH_SCREENS	4		// rows paged in above and below the visible ones, in screens
+#define BROWSER_AUDITION_MS			40		// holding an arrow key only auditions where it stops
+#define BROWSER_ROW_HEIGHT			18
+
+// columns of the table
+#define BROWSER_COLUMN_NUMBER		1
+#define BROWSER_COLUMN_NAME			2
+#define BROWSER_COLUMN_CHANGES		3
+#define BROWSER_COLUMN_FAMILY		4
+#define BROWSER_COLUMN_VOTE			5
+
+//---------------------------------------------------------------------------
+/** Pages in the library records around the visible rows, so scrolling
+	doesn't wait for the disk when a row is painted for the first time.
+
+	The thread reads the first and the last byte of the records the rows
+	point to, which faults in their pages. It holds a reference to the
+	mapping, the library may be closed while it runs. Nothing is copied,
+	the memory it uses doesn't grow with the library.
+*/
+class PatchLibraryPrefetcher : public Thread
+{
+public:
+	PatchLibraryPrefetcher() : Thread("LibraryPrefetchThread"),
+		mIndex(NULL),
+		mNumPatches(0),
+		mSortedByName(false),
+		mForwards(true)
+	{
+		mFirstRow.set(0);
+		mLastRow.set(-1);
+		mChecksum.set(0);
+	};
+
+	~PatchLibraryPrefetcher()
+	{
+		stop();
+	};
+
+	/** the rows are in record order, or name index order if sortedByName, reversed unless forwards*/
+	void setLibrary(PatchLibrary& library, bool sortedByName, bool forwards)
+	{
+		stop();
+		mMapping = library.getMapping();
+		mNumPatches = library.getNumPatches();
+		//the name index follows the records, PatchLibrary::open() checks that
+		mIndex = mMapping != NULL ? mMapping->getData() + PATCH_LIBRARY_HEADER_SIZE + mNumPatches*PATCH_DATA_SIZE : NULL;
+		mSortedByName = sortedByName;
+		mForwards = forwards;
+		mFirstRow.set(0);
+		mLastRow.set(-1);
+		if(mMapping != NULL) startThread(PRIORITY_CLASS_IDLE);
+	};
+
+	void stop()
+	{
+		signalThreadShouldExit();
+		notify();
+		stopThread(1000);
+		mMapping = NULL;
+	};
+
+	/** message thread. pages in the rows around the visible ones*/
+	void setVisibleRows(int first, int numRows)
+	{
+		const int margin = numRows*BROWSER_PREFETCH_SCREENS;
+		mFirstRow.set(jmax(0,first - margin));
+		mLastRow.set(jmin(mNumPatches-1,first + numRows + margin));
+		notify();
+	};
+
+private:
+	void run()
+	{
+		int doneFirst = 0;
+		int doneLast = -1;
+		while(!threadShouldExit())
+		{
+			const int first = mFirstRow.get();
+			const int last = mLastRow.get();
+			if(first == doneFirst && last == doneLast)
+			{
+				wait(-1);
+				continue;
+			}
+
+			//only the rows that weren't in the last window
+			for(int row=first;row<=last && !threadShouldExit();row++)
+			{
+				if(row >= doneFirst && row <= doneLast) continue;
+				touch(row);
+			}
+			doneFirst = first;
+			doneLast = last;
+		}
+	};
+
+	void touch(int row)
+	{
+		if(!mForwards) row = mNumPatches-1 - row;
+		int record = row;
+		if(mSortedByName)
+		{
+			record = (int)ByteOrder::littleEndianInt(mIndex + row*4);
+			if(record < 0 || record >= mNumPatches) return;
+		}
+		//a record can cross a page boundary. the sum keeps the reads from being optimised away
+		const uint8_t* data = mMapping->getData() + PATCH_LIBRARY_HEADER_SIZE + record*PATCH_DATA_SIZE;
+		mChecksum += data[0] + data[PATCH_DATA_SIZE-1];
+	};
+
+	MappedFileData::Ptr mMapping;
+	const uint8_t* mIndex;
+	int mNumPatches;
+	bool mSortedByName;
+	bool mForwards;
+
+	Atomic<int> mFirstRow;
+	Atomic<int> mLastRow;
+	Atomic<int> mChecksum;
+};
+//---------------------------------------------------------------------------
+/** Browses a PatchLibrary of any size.
+
+	The TableListBox only has components for the visible rows, and every
+	cell is painted straight from the mapped records, so a library of 100k
+	patches costs no more memory than one of 10. Sorting by name uses the
+	name index of the file. The PatchLibraryPrefetcher pages in the records
+	around the visible rows while the list scrolls.
+
+	Selecting a row auditions the patch: it is loaded into the
+	ParameterStore, which sends only what differs from the synth's state,
+	and played by the preview if auto preview is on. The changes column
+	tells how many values a patch differs in from the edited sound, the
+	family column the cluster of the patch if the library has been
+	clustered (see PatchClusterer).
+
+	A PatchQuery typed into the search field (return runs it, escape
+	shows the whole library again) lists only the matching patches, in
+	file order, answered by the PatchQueryIndex.
+
+	A PatchArchive is browsed the same way, a block is decoded when one
+	of its rows is painted. It has no name index, search or families,
+	those need the library it was packed from.
+*/
+class PatchBrowserComponent : public Component,
+							  public TableListBoxModel,
+							  public ButtonListener,
+							  public TextEditor::Listener,
+							  private Timer
+{
+public:
+	PatchBrowserComponent() : mSortedByName(false), mForwards(true), mAuditionRow(-1), mFiltered(false)
+	{
+		addAndMakeVisible(mOpenButton = new TextButton("Open Library..."));
+		mOpenButton->addListener(this);
+
+		addAndMakeVisible(mSearch = new TextEditor("search"));
+		mSearch->setTextToShowWhenEmpty("search, e.g. decay > 90 and filter type = HP on voice 4",Colours::grey);
+		mSearch->addListener(this);
+
+		addAndMakeVisible(mTable = new TableListBox("patches",this));
+		mTable->setRowHeight(BROWSER_ROW_HEIGHT);
+		mTable->setColour(ListBox::backgroundColourId,Colour(0xff3a3a3a));
+		mTable->getHeader().addColumn("#",BROWSER_COLUMN_NUMBER,70);
+		mTable->getHeader().addColumn("name",BROWSER_COLUMN_NAME,120);
+		mTable->getHeader().addColumn("changes",BROWSER_COLUMN_CHANGES,70);
+		mTable->getHeader().addColumn("family",BROWSER_COLUMN_FAMILY,60);
+		mTable->getHeader().addColumn("vote",BROWSER_COLUMN_VOTE,60);
+		mTable->getHeader().setSortColumnId(BROWSER_COLUMN_NUMBER,true);
+
+		addAndMakeVisible(mThumbnail = new PatchThumbnailComponent());
+
+		setSize(420,512);
+	};
+
+	~PatchBrowserComponent()
+	{
+		stopTimer();
+		mPrefetcher.stop();
+		deleteAllChildren();
+	};
+
+	/** a library or an archive. returns false if the file is neither*/
+	bool openLibrary(const File& file)
+	{
+		mTable->deselectAllRows();
+		mFiltered = false;
+		mMatches.clear();
+		mClusters.clear();
+		mArchive.close();
+		if(file.hasFileExtension(PATCH_ARCHIVE_EXTENSION))
+		{
+			mLibrary.close();
+			mPrefetcher.stop();
+			mQueryIndex.clear();
+			mSortedByName = false;
+			mTable->getHeader().setSortColumnId(BROWSER_COLUMN_NUMBER,mForwards);
+			const bool opened = mArchive.open(file);
+			mTable->updateContent();
+			mTable->scrollToEnsureRowIsOnscreen(0);
+			repaint();
+			return opened;
+		}
+		if(!mLibrary.open(file))
+		{
+			mPrefetcher.stop();
+			mQueryIndex.clear();
+			mTable->updateContent();
+			return false;
+		}
+		mQueryIndex.setLibrary(mLibrary);
+		mClusters.load(mLibrary);
+		mPrefetcher.setLibrary(mLibrary,mSortedByName,mForwards);
+		mTable->updateContent();
+		mTable->scrollToEnsureRowIsOnscreen(0);
+		listWasScrolled();
+		repaint();
+		return true;
+	};
+
+	void buttonClicked(Button*)
+	{
+		FileChooser chooser("Open library",getFile(),"*" PATCH_LIBRARY_EXTENSION ";*" PATCH_ARCHIVE_EXTENSION);
+		if(!chooser.browseForFileToOpen()) return;
+		if(!openLibrary(chooser.getResult()))
+		{
+			AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Patch Browser","The file is not a patch library or archive.");
+		}
+	};
+
+	void textEditorReturnKeyPressed(TextEditor&)
+	{
+		if(mArchive.isOpen())
+		{
+			mStatus = "an archive can't be searched, unpack it into a library first";
+			repaint();
+			return;
+		}
+		if(!mLibrary.isOpen()) return;
+		if(mSearch->getText().trim().isEmpty())
+		{
+			showAll();
+			return;
+		}
+
+		PatchQuery query;
+		String error;
+		if(!PatchQuery::parse(mSearch->getText(),query,error))
+		{
+			mStatus = error;
+			repaint();
+			return;
+		}
+		const double start = Time::getMillisecondCounterHiRes();
+		mQueryIndex.find(query,mMatches);
+		mStatus = String(mMatches.size()) + " of " + String(mLibrary.getNumPatches()) + " patches match ("
+			+ String(Time::getMillisecondCounterHiRes()-start,2) + " ms)";
+		mFiltered = true;
+		mTable->deselectAllRows();
+		mTable->updateContent();
+		mTable->scrollToEnsureRowIsOnscreen(0);
+		mTable->repaint();
+		repaint();
+	};
+
+	void textEditorEscapeKeyPressed(TextEditor&)
+	{
+		mSearch->clear();
+		showAll();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+		String text = isOpen() ? getFile().getFileName() + ", " + String(getNumPatches()) + " patches" : String("no library");
+		if(mFiltered || mStatus.isNotEmpty()) text = mStatus;
+		g.drawText(text,96,8,getWidth()-104,24,Justification::left,true);
+	};
+
+	void resized()
+	{
+		mOpenButton->setBounds(8,8,80,24);
+		mSearch->setBounds(8,40,getWidth()-16,24);
+		mTable->setBounds(8,72,getWidth()-16,getHeight()-72-72);
+		mThumbnail->setBounds(8,getHeight()-64,getWidth()-16,56);
+	};
+
+	//-----------------------------------------------------------------------
+	int getNumRows()
+	{
+		if(mFiltered) return mMatches.size();
+		return getNumPatches();
+	};
+
+	void paintRowBackground(Graphics& g, int rowNumber, int /*width*/, int /*height*/, bool rowIsSelected)
+	{
+		if(rowIsSelected)			g.fillAll(Colour(0xff6a8f3a));
+		else if(rowNumber & 1)		g.fillAll(Colour(0xff424242));
+	};
+
+	void paintCell(Graphics& g, int rowNumber, int columnId, int width, int height, bool /*rowIsSelected*/)
+	{
+		const int record = getRecord(rowNumber);
+		if(record < 0) return;
+		const uint8_t* data = getPatchData(record);
+
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+		switch(columnId)
+		{
+		case BROWSER_COLUMN_NUMBER:
+			g.drawText(String(record+1),2,0,width-4,height,Justification::right,false);
+			break;
+		case BROWSER_COLUMN_NAME:
+			g.drawText(ShortString((const char*)data,PATCH_NAME_LENGTH).getText(),4,0,width-8,height,Justification::left,true);
+			break;
+		case BROWSER_COLUMN_CHANGES:
+			g.drawText(String(countChanges(data+PATCH_NAME_LENGTH)),2,0,width-4,height,Justification::right,false);
+			break;
+		case BROWSER_COLUMN_FAMILY:
+			if(mClusters.getLabel(record) >= 0)
+			{
+				g.drawText(String(mClusters.getLabel(record)+1),2,0,width-4,height,Justification::right,false);
+			}
+			break;
+		case BROWSER_COLUMN_VOTE:
+			switch(VoteDatabase::getInstance()->getOpinion(data+PATCH_NAME_LENGTH))
+			{
+			case LIKE:		g.drawText("liked",4,0,width-8,height,Justification::left,false); break;
+			case DISLIKE:	g.drawText("disliked",4,0,width-8,height,Justification::left,false); break;
+			}
+			break;
+		}
+	};
+
+	void sortOrderChanged(int newSortColumnId, bool isForwards)
+	{
+		//only the file order and the name index are stored, the changes, families and votes are shown unsorted
+		mSortedByName = newSortColumnId == BROWSER_COLUMN_NAME && !mArchive.isOpen();
+		mForwards = isForwards;
+		mPrefetcher.setLibrary(mLibrary,mSortedByName,mForwards);
+		mTable->deselectAllRows();
+		mTable->updateContent();
+		listWasScrolled();
+		mTable->repaint();
+	};
+
+	void listWasScrolled()
+	{
+		//the matches are few or already paged in by the query
+		if(mFiltered) return;
+		mPrefetcher.setVisibleRows(mTable->getRowContainingPosition(0,mTable->getHeaderHeight()),mTable->getNumRowsOnScreen());
+	};
+
+	void selectedRowsChanged(int lastRowSelected)
+	{
+		mAuditionRow = lastRowSelected;
+		if(mAuditionRow >= 0) startTimer(BROWSER_AUDITION_MS);
+	};
+
+private:
+	void timerCallback()
+	{
+		stopTimer();
+		const int record = getRecord(mAuditionRow);
+		if(record < 0) return;
+
+		Patch patch;
+		PresetLoader::readPatchData(getPatchData(record),&patch);
+		ParameterStore::getInstance()->loadFromPatch(&patch,true);
+		mThumbnail->setPatch(patch.getValues());
+		if(PreviewEngine::getInstance()->getAutoPreview())
+		{
+			PreviewEngine::getInstance()->playSound();
+		}
+		mTable->repaint();
+	};
+
+	bool isOpen()
+	{
+		return mArchive.isOpen() || mLibrary.isOpen();
+	};
+
+	const File& getFile()
+	{
+		return mArchive.isOpen() ? mArchive.getFile() : mLibrary.getFile();
+	};
+
+	int getNumPatches()
+	{
+		return mArchive.isOpen() ? mArchive.getNumPatches() : mLibrary.getNumPatches();
+	};
+
+	/** of the library or the archive, an archive decodes the block of the record if it isn't cached*/
+	const uint8_t* getPatchData(int record)
+	{
+		return mArchive.isOpen() ? mArchive.getPatchData(record) : mLibrary.getPatchData(record);
+	};
+
+	/** the record shown in a row, or -1*/
+	int getRecord(int row)
+	{
+		const int numRows = getNumRows();
+		if(row < 0 || row >= numRows) return -1;
+		if(!mForwards) row = numRows-1 - row;
+		if(mFiltered) return mMatches[row];
+		return mSortedByName ? mLibrary.getIndexEntry(row) : row;
+	};
+
+	void showAll()
+	{
+		mFiltered = false;
+		mMatches.clear();
+		mStatus = String::empty;
+		mTable->deselectAllRows();
+		mTable->updateContent();
+		listWasScrolled();
+		mTable->repaint();
+		repaint();
+	};
+
+	/** the values a patch differs in from the edited sound*/
+	static int countChanges(const uint8_t* values)
+	{
+		const uint8_t* current = ParameterStore::getInstance()->getValues();
+		int num = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(values[i] != current[i]) num++;
+		}
+		return num;
+	};
+
+	PatchLibrary mLibrary;
+	PatchArchive mArchive;	// instead of the library
+	PatchLibraryPrefetcher mPrefetcher;
+	bool mSortedByName;
+	bool mForwards;
+	int mAuditionRow;
+
+	PatchQueryIndex mQueryIndex;
+	PatchClusters mClusters;
+	Array<int> mMatches;	// the records of the last query
+	bool mFiltered;			// only the matches are listed
+	String mStatus;
+
+	TextButton* mOpenButton;
+	TextEditor* mSearch;
+	TableListBox* mTable;
+	PatchThumbnailComponent* mThumbnail;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,529 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PatchDistance.h"
+#include "../PatchHash.h"
+#include "../ParallelFor.h"
+#include "../FastRandom.h"
+#include "../parameterRanges.h"
+#include "./PatchLibrary.h"
+
+#define PATCH_CLUSTERS_MAGIC		0x4b505053	// "SPPK" little endian
+#define PATCH_CLUSTERS_VERSION		1
+#define PATCH_CLUSTERS_EXTENSION	".spk"
+#define PATCH_CLUSTERS_MAX			1024	// every worker sums up the members of every centre
+#define PATCH_CLUSTERS_DEFAULT_K	64
+
+#define KMEANS_VECTOR_SIZE		((NUM_PARAMS+15)&~15)	// padded with zeros to whole SIMD blocks
+#define KMEANS_SEED_SAMPLE		8192	// k-means++ picks the first centres from this many patches
+#define KMEANS_BATCH_SIZE		2048	// patches per mini-batch step
+#define KMEANS_NUM_BATCHES		64
+#define KMEANS_MAX_PASSES		12		// full Lloyd passes after the mini-batches
+#define KMEANS_GRAIN			256		// patches a worker takes at once
+
+//---------------------------------------------------------------------------
+/** The families of the patches of a PatchLibrary: a cluster label for
+	every record, and the size and the most typical member of every
+	cluster. Written next to the library by a PatchClusterer.
+
+	Layout (all numbers little endian):
+	header		magic, version, NUM_PARAMS, number of patches, number of
+				clusters, checksum of the records (64 bit)
+	labels		the cluster of every record, 16 bit
+	clusters	size and representative record of every cluster, 32 bit
+*/
+class PatchClusters
+{
+public:
+	PatchClusters() : mNumClusters(0)
+	{
+	};
+
+	void clear()
+	{
+		mLabels.clear();
+		mSizes.clear();
+		mRepresentatives.clear();
+		mNumClusters = 0;
+	};
+
+	int getNumPatches() const				{ return mLabels.size(); };
+	int getNumClusters() const				{ return mNumClusters; };
+	/** -1 for a record the clusters don't know*/
+	int getLabel(int record) const			{ return record < mLabels.size() ? (int)mLabels.getUnchecked(record) : -1; };
+	int getSize(int cluster) const			{ return mSizes[cluster]; };
+	/** the member closest to the centre of the cluster*/
+	int getRepresentative(int cluster) const	{ return mRepresentatives[cluster]; };
+
+	/** returns false if the file is missing or belongs to other records, the clusters are empty then*/
+	bool load(PatchLibrary& library)
+	{
+		clear();
+
+		FileInputStream in(getClusterFile(library.getFile()));
+		if(in.getStatus().failed()) return false;
+
+		if(in.readInt() != PATCH_CLUSTERS_MAGIC || in.readInt() != PATCH_CLUSTERS_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
+		const int numPatches = in.readInt();
+		const int numClusters = in.readInt();
+		const uint64 checksum = (uint64)in.readInt64();
+		if(numPatches != library.getNumPatches() || numClusters < 1 || numClusters > PATCH_CLUSTERS_MAX
+			|| in.getTotalLength() != in.getPosition() + numPatches*2 + numClusters*8
+			|| checksum != getChecksum(library))
+		{
+			return false;
+		}
+
+		mLabels.ensureStorageAllocated(numPatches);
+		for(int i=0;i<numPatches;i++)
+		{
+			mLabels.add((uint16)in.readShort());
+		}
+		for(int i=0;i<numClusters;i++)
+		{
+			mSizes.add(in.readInt());
+			mRepresentatives.add(in.readInt());
+		}
+		mNumClusters = numClusters;
+		return true;
+	};
+
+	bool save(PatchLibrary& library) const
+	{
+		TemporaryFile temp(getClusterFile(library.getFile()));
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->writeInt(PATCH_CLUSTERS_MAGIC);
+			out->writeInt(PATCH_CLUSTERS_VERSION);
+			out->writeInt(NUM_PARAMS);
+			out->writeInt(mLabels.size());
+			out->writeInt(mNumClusters);
+			out->writeInt64((int64)getChecksum(library));
+			for(int i=0;i<mLabels.size();i++)
+			{
+				out->writeShort((short)mLabels.getUnchecked(i));
+			}
+			for(int i=0;i<mNumClusters;i++)
+			{
+				out->writeInt(mSizes[i]);
+				out->writeInt(mRepresentatives[i]);
+			}
+
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	static File getClusterFile(const File& libraryFile)
+	{
+		return libraryFile.withFileExtension(PATCH_CLUSTERS_EXTENSION);
+	};
+
+private:
+	friend class PatchClusterer;
+
+	/** of the values of all records, a renamed patch keeps its family*/
+	static uint64 getChecksum(PatchLibrary& library)
+	{
+		uint64 checksum = (uint64)library.getNumPatches();
+		for(int i=0;i<library.getNumPatches();i++)
+		{
+			checksum = checksum*literal64bit(0x100000001b3) ^ hashPatchValues(library.getPatchData(i)+PATCH_NAME_LENGTH);
+		}
+		return checksum;
+	};
+
+	Array<uint16> mLabels;			// by record
+	Array<int> mSizes;				// by cluster
+	Array<int> mRepresentatives;	// by cluster
+	int mNumClusters;
+};
+
+//---------------------------------------------------------------------------
+/** Sorts the patches of a library into k families by k-means over their
+	parameter values.
+
+	Every value is first scaled to 0..255 of its range, so a full range
+	step of a switch counts as much as one of a knob (like the
+	DistanceWeights), and the distance is PatchDistance::l2Squared() of
+	those bytes. The centres are kept as float means and rounded to bytes
+	for the distances.
+
+	k-means++ picks the first centres from a sample, mini-batch steps
+	(Sculley 2010) move them close to where they end up, and full Lloyd
+	passes finish the job until no patch changes its family. The
+	distances of a pass are spread over the ParallelFor workers, each
+	worker sums up the members of the centres on its own.
+	The same seed and library give the same families.
+*/
+class PatchClusterer
+{
+public:
+	PatchClusterer() : mNumClusters(PATCH_CLUSTERS_DEFAULT_K), mSeed(0), mNumPatches(0), mNumPasses(0)
+	{
+	};
+
+	void setNumClusters(int k)
+	{
+		mNumClusters = jlimit(1,PATCH_CLUSTERS_MAX,k);
+	};
+
+	void setSeed(uint64 seed)
+	{
+		mSeed = seed;
+	};
+
+	/** the Lloyd passes of the last run()*/
+	int getNumPasses() const
+	{
+		return mNumPasses;
+	};
+
+	/** returns false for an empty library*/
+	bool run(PatchLibrary& library, PatchClusters& result)
+	{
+		TRACE_SCOPE("patch io","cluster library");
+		result.clear();
+		mNumPatches = library.getNumPatches();
+		mNumPasses = 0;
+		if(mNumPatches == 0) return false;
+
+		const int k = jmin(mNumClusters,mNumPatches);
+		scaleValues(library);
+		mCentres.calloc(k*KMEANS_VECTOR_SIZE);
+		mRounded.calloc(k*KMEANS_VECTOR_SIZE);
+		mLabels.malloc(mNumPatches);
+		mDistances.malloc(mNumPatches);
+		FastRandom random(mSeed,0);
+
+		seed(k,random);
+		refineWithBatches(k,random);
+
+		//Lloyd until no patch moves. the labels and distances are those of the centres that come out
+		for(;;)
+		{
+			const int numMoved = assignAll(k,++mNumPasses == 1);
+			if(numMoved == 0 || mNumPasses == KMEANS_MAX_PASSES) break;
+			updateCentres(k);
+		}
+
+		result.mNumClusters = k;
+		result.mLabels.ensureStorageAllocated(mNumPatches);
+		for(int i=0;i<mNumPatches;i++)
+		{
+			result.mLabels.add((uint16)mLabels[i]);
+		}
+		for(int c=0;c<k;c++)
+		{
+			result.mSizes.add(0);
+			result.mRepresentatives.add(-1);
+		}
+		for(int i=0;i<mNumPatches;i++)
+		{
+			const int c = mLabels[i];
+			result.mSizes.getReference(c)++;
+			const int best = result.mRepresentatives[c];
+			if(best < 0 || mDistances[i] < mDistances[best]) result.mRepresentatives.set(c,i);
+		}
+
+		mValues.free();
+		mCentres.free();
+		mRounded.free();
+		mTask = NULL;
+		return true;
+	};
+
+private:
+	/** the nearest centre of patches, and the member sums of each worker for the next centres*/
+	class AssignTask : public ParallelTask
+	{
+	public:
+		AssignTask(PatchClusterer& owner, const int* patches, int numCentres, int numWorkers, bool sum)
+		: mOwner(owner),
+		mPatches(patches),
+		mNumCentres(numCentres),
+		mSum(sum)
+		{
+			if(mSum)
+			{
+				mSums.calloc(numWorkers*numCentres*KMEANS_VECTOR_SIZE);
+				mCounts.calloc(numWorkers*numCentres);
+			}
+			mMoved.calloc(numWorkers);
+		};
+
+		void run(int begin, int end, int workerIndex)
+		{
+			int* sums = mSum ? mSums + workerIndex*mNumCentres*KMEANS_VECTOR_SIZE : NULL;
+			int* counts = mSum ? mCounts + workerIndex*mNumCentres : NULL;
+			for(int i=begin;i<end;i++)
+			{
+				const int patch = mPatches != NULL ? mPatches[i] : i;
+				const uint8_t* values = mOwner.getValues(patch);
+				int distance;
+				const int centre = mOwner.findNearest(values,mNumCentres,distance);
+				if(mPatches == NULL)
+				{
+					if(mOwner.mLabels[patch] != centre) mMoved[workerIndex]++;
+					mOwner.mLabels[patch] = centre;
+					mOwner.mDistances[patch] = distance;
+				}
+				else mOwner.mLabels[i] = centre;
+
+				if(sums != NULL)
+				{
+					int* sum = sums + centre*KMEANS_VECTOR_SIZE;
+					for(int p=0;p<NUM_PARAMS;p++) sum[p] += values[p];
+					counts[centre]++;
+				}
+			}
+		};
+
+		int getNumMoved(int numWorkers) const
+		{
+			int num = 0;
+			for(int w=0;w<numWorkers;w++) num += mMoved[w];
+			return num;
+		};
+
+		HeapBlock<int> mSums;		// by worker and centre, fits 8 million patches
+		HeapBlock<int> mCounts;
+		HeapBlock<int> mMoved;		// by worker
+
+	private:
+		PatchClusterer& mOwner;
+		const int* mPatches;		// NULL for all of them
+		const int mNumCentres;
+		const bool mSum;
+	};
+
+	const uint8_t* getValues(int patch) const
+	{
+		return mValues + (size_t)patch*KMEANS_VECTOR_SIZE;
+	};
+
+	int findNearest(const uint8_t* values, int numCentres, int& distance) const
+	{
+		int best = 0;
+		distance = PatchDistance::l2Squared(values,mRounded,KMEANS_VECTOR_SIZE);
+		for(int c=1;c<numCentres;c++)
+		{
+			const int d = PatchDistance::l2Squared(values,mRounded + c*KMEANS_VECTOR_SIZE,KMEANS_VECTOR_SIZE);
+			if(d < distance)
+			{
+				distance = d;
+				best = c;
+			}
+		}
+		return best;
+	};
+
+	/** every value to 0..255 of its range*/
+	void scaleValues(PatchLibrary& library)
+	{
+		int scale[NUM_PARAMS];
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			scale[p] = jmax(1,(int)parameterRanges[p].range);
+		}
+		mValues.calloc((size_t)mNumPatches*KMEANS_VECTOR_SIZE);
+		for(int i=0;i<mNumPatches;i++)
+		{
+			const uint8_t* values = library.getPatchData(i) + PATCH_NAME_LENGTH;
+			uint8_t* scaled = mValues + (size_t)i*KMEANS_VECTOR_SIZE;
+			for(int p=0;p<NUM_PARAMS;p++)
+			{
+				scaled[p] = (uint8_t)jmin(255,(values[p]*255 + scale[p]/2)/scale[p]);
+			}
+		}
+	};
+
+	void setCentre(int centre, const uint8_t* values)
+	{
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			mCentres[centre*KMEANS_VECTOR_SIZE + p] = values[p];
+		}
+		memcpy(mRounded + centre*KMEANS_VECTOR_SIZE,values,KMEANS_VECTOR_SIZE);
+	};
+
+	void roundCentre(int centre)
+	{
+		const float* from = mCentres + centre*KMEANS_VECTOR_SIZE;
+		uint8_t* to = mRounded + centre*KMEANS_VECTOR_SIZE;
+		for(int p=0;p<NUM_PARAMS;p++)
+		{
+			to[p] = (uint8_t)jlimit(0,255,roundToInt(from[p]));
+		}
+	};
+
+	/** k-means++: a patch becomes the next centre with a chance that grows with its squared distance to the ones so far*/
+	void seed(int k, FastRandom& random)
+	{
+		const int numSamples = jmin(mNumPatches,KMEANS_SEED_SAMPLE);
+		HeapBlock<int> samples(numSamples);
+		HeapBlock<double> nearest(numSamples);
+		for(int i=0;i<numSamples;i++)
+		{
+			samples[i] = numSamples == mNumPatches ? i : random.nextInt(mNumPatches);
+		}
+
+		setCentre(0,getValues(samples[random.nextInt(numSamples)]));
+		double total = 0;
+		for(int i=0;i<numSamples;i++)
+		{
+			nearest[i] = PatchDistance::l2Squared(getValues(samples[i]),mRounded,KMEANS_VECTOR_SIZE);
+			total += nearest[i];
+		}
+
+		for(int c=1;c<k;c++)
+		{
+			//all samples on the centres so far, any of them will do
+			int pick = random.nextInt(numSamples);
+			if(total > 0)
+			{
+				double target = random.nextFloat()*total;
+				for(pick=0;pick<numSamples-1 && target >= nearest[pick];pick++)
+				{
+					target -= nearest[pick];
+				}
+			}
+			setCentre(c,getValues(samples[pick]));
+
+			const uint8_t* centre = mRounded + c*KMEANS_VECTOR_SIZE;
+			total = 0;
+			for(int i=0;i<numSamples;i++)
+			{
+				nearest[i] = jmin(nearest[i],(double)PatchDistance::l2Squared(getValues(samples[i]),centre,KMEANS_VECTOR_SIZE));
+				total += nearest[i];
+			}
+		}
+	};
+
+	/** every step moves the centres towards the members of a random batch, by less the more members they had*/
+	void refineWithBatches(int k, FastRandom& random)
+	{
+		if(mNumPatches <= KMEANS_BATCH_SIZE) return;
+
+		ParallelFor* parallel = ParallelFor::getInstance();
+		HeapBlock<int> batch(KMEANS_BATCH_SIZE);
+		HeapBlock<int> seen;
+		seen.calloc(k);
+		for(int step=0;step<KMEANS_NUM_BATCHES;step++)
+		{
+			for(int i=0;i<KMEANS_BATCH_SIZE;i++)
+			{
+				batch[i] = random.nextInt(mNumPatches);
+			}
+			//the labels of the batch go into the first slots of mLabels, the full pass overwrites them
+			AssignTask task(*this,batch,k,parallel->getNumWorkers(),false);
+			parallel->execute(KMEANS_BATCH_SIZE,KMEANS_GRAIN,task);
+
+			for(int i=0;i<KMEANS_BATCH_SIZE;i++)
+			{
+				const int c = mLabels[i];
+				const float rate = 1.f/++seen[c];
+				float* centre = mCentres + c*KMEANS_VECTOR_SIZE;
+				const uint8_t* values = getValues(batch[i]);
+				for(int p=0;p<NUM_PARAMS;p++)
+				{
+					centre[p] += rate*(values[p] - centre[p]);
+				}
+			}
+			for(int c=0;c<k;c++)
+			{
+				roundCentre(c);
+			}
+		}
+	};
+
+	/** labels every patch with its nearest centre and sums up the members. returns how many changed their label*/
+	int assignAll(int k, bool first)
+	{
+		ParallelFor* parallel = ParallelFor::getInstance();
+		const int numWorkers = parallel->getNumWorkers();
+		if(first)
+		{
+			for(int i=0;i<mNumPatches;i++) mLabels[i] = -1;
+		}
+		mTask = new AssignTask(*this,NULL,k,numWorkers,true);
+		parallel->execute(mNumPatches,KMEANS_GRAIN,*mTask);
+		return mTask->getNumMoved(numWorkers);
+	};
+
+	/** the means of the members of the last assignAll(). an empty centre takes the patch furthest from its own*/
+	void updateCentres(int k)
+	{
+		const int numWorkers = ParallelFor::getInstance()->getNumWorkers();
+		for(int c=0;c<k;c++)
+		{
+			int count = 0;
+			for(int w=0;w<numWorkers;w++) count += mTask->mCounts[w*k + c];
+			if(count == 0)
+			{
+				int furthest = 0;
+				for(int i=1;i<mNumPatches;i++)
+				{
+					if(mDistances[i] > mDistances[furthest]) furthest = i;
+				}
+				setCentre(c,getValues(furthest));
+				mDistances[furthest] = 0;
+				continue;
+			}
+
+			float* centre = mCentres + c*KMEANS_VECTOR_SIZE;
+			for(int p=0;p<NUM_PARAMS;p++)
+			{
+				int64 sum = 0;
+				for(int w=0;w<numWorkers;w++) sum += mTask->mSums[(w*k + c)*KMEANS_VECTOR_SIZE + p];
+				centre[p] = (float)((double)sum/count);
+			}
+			roundCentre(c);
+		}
+		mTask = NULL;
+	};
+
+	int mNumClusters;
+	uint64 mSeed;
+
+	//while run() runs
+	int mNumPatches;
+	HeapBlock<uint8_t> mValues;		// the scaled values, KMEANS_VECTOR_SIZE per patch
+	HeapBlock<float> mCentres;		// KMEANS_VECTOR_SIZE per centre
+	HeapBlock<uint8_t> mRounded;	// the same rounded for the distances
+	HeapBlock<int> mLabels;			// by patch
+	HeapBlock<int> mDistances;		// to the own centre
+	ScopedPointer<AssignTask> mTask;	// of the last full pass
+	int mNumPasses;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,523 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PatchLibrary.h"
+#include "MappedFileData.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define COLUMNS_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define COLUMNS_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define PATCH_COLUMNS_MAGIC			0x43505053	// "SPPC" little endian
+#define PATCH_COLUMNS_VERSION		1
+#define PATCH_COLUMNS_HEADER_SIZE	64
+#define PATCH_COLUMNS_EXTENSION		".spc"
+#define PATCH_COLUMNS_ALIGN			64		// a column starts on a cache line and is padded to one with zeros
+#define PATCH_COLUMNS_STRIDE(n)		(((n) + PATCH_COLUMNS_ALIGN-1) & ~(PATCH_COLUMNS_ALIGN-1))
+#define PATCH_COLUMNS_GROUP			16		// columns filled per pass over the records in build()
+#define COLUMNS_FLUSH_BLOCKS		4096	// 16 byte blocks before the 32 bit sums of products would overflow
+#define COLUMNS_HISTOGRAM_SIZE		256
+
+//---------------------------------------------------------------------------
+/** A set of records of a library, such as the results of a PatchQuery,
+	kept as a mask of one byte per record: 0xff if selected, 0 if not.
+	The mask is padded like a column, so the aggregates of the
+	PatchColumnStore can AND it with 16 values at a time.
+*/
+class PatchSelection
+{
+public:
+	PatchSelection(int numPatches) : mNumPatches(numPatches), mNumSelected(0)
+	{
+		mMask.calloc(jmax(PATCH_COLUMNS_ALIGN,PATCH_COLUMNS_STRIDE(numPatches)));
+	};
+
+	void select(int record)
+	{
+		jassert(record >= 0 && record < mNumPatches);
+		if(mMask[record] != 0) return;
+		mMask[record] = 0xff;
+		mNumSelected++;
+	};
+
+	void select(const Array<int>& records)
+	{
+		for(int i=0;i<records.size();i++)
+		{
+			select(records.getUnchecked(i));
+		}
+	};
+
+	void selectAll()
+	{
+		memset(mMask,0xff,mNumPatches);
+		mNumSelected = mNumPatches;
+	};
+
+	void clear()
+	{
+		memset(mMask,0,mNumPatches);
+		mNumSelected = 0;
+	};
+
+	bool isSelected(int record) const
+	{
+		return mMask[record] != 0;
+	};
+
+	int getNumSelected() const
+	{
+		return mNumSelected;
+	};
+
+	int getNumPatches() const
+	{
+		return mNumPatches;
+	};
+
+	const uint8_t* getMask() const
+	{
+		return mMask;
+	};
+
+private:
+	HeapBlock<uint8_t> mMask;
+	int mNumPatches;
+	int mNumSelected;
+};
+
+//---------------------------------------------------------------------------
+struct ColumnStats
+{
+	int count;			// patches that were looked at
+	double mean;
+	double variance;	// of the patches themselves, not an estimate for a larger set
+};
+
+/** the sums one pass over two columns gives, everything else follows from them*/
+struct ColumnSums
+{
+	int64 count;
+	int64 sumA;
+	int64 sumB;
+	int64 sumAA;
+	int64 sumBB;
+	int64 sumAB;
+};
+
+//---------------------------------------------------------------------------
+/** The values of a PatchLibrary transposed to one column per parameter,
+	for questions about many patches at once, like the distribution of a
+	parameter over the results of a query.
+
+	The row store keeps a patch together, so reading one parameter of
+	every patch touches every cache line of the library. Here the values
+	of a parameter are back to back, a scan reads only the bytes it
+	needs, and the SSE2 and NEON kernels take 16 of them per step.
+
+	The columns live in a file next to the library (PATCH_COLUMNS_EXTENSION)
+	and are mapped like it. open() writes the file if it is missing or
+	was built from another version of the library.
+
+	Layout (all numbers 32 bit little endian):
+	header		magic, version, NUM_PARAMS, number of patches, column
+				stride, offset of the first column, size and modification
+				time of the library as 64 bit numbers, padding up to
+				PATCH_COLUMNS_HEADER_SIZE
+	columns		NUM_PARAMS columns of one byte per patch, each padded with
+				zeros to the stride, a multiple of PATCH_COLUMNS_ALIGN
+*/
+class PatchColumnStore
+{
+public:
+	PatchColumnStore() : mColumns(NULL), mNumPatches(0), mStride(0)
+	{
+	};
+
+	~PatchColumnStore()
+	{
+		close();
+	};
+
+	/** map the columns of an open library, writing them first if needed.
+		returns false if they can't be written next to the library*/
+	bool open(PatchLibrary& library)
+	{
+		close();
+		if(!library.isOpen()) return false;
+
+		const File file = getColumnFile(library.getFile());
+		if(map(file,library)) return true;
+		if(build(library,file) && map(file,library)) return true;
+		close();
+		return false;
+	};
+
+	void close()
+	{
+		mMapping = NULL;
+		mColumns = NULL;
+		mNumPatches = 0;
+		mStride = 0;
+	};
+
+	bool isOpen() const
+	{
+		return mColumns != NULL;
+	};
+
+	int getNumPatches() const
+	{
+		return mNumPatches;
+	};
+
+	/** the value of the parameter for every record, padded with zeros to a multiple of PATCH_COLUMNS_ALIGN*/
+	const uint8_t* getColumn(int parameterNr) const
+	{
+		jassert(parameterNr >= 0 && parameterNr < NUM_PARAMS);
+		return mColumns + (size_t)parameterNr*mStride;
+	};
+
+	static File getColumnFile(const File& libraryFile)
+	{
+		return libraryFile.withFileExtension(PATCH_COLUMNS_EXTENSION);
+	};
+
+	//-----------------------------------------------------------------------
+	/** the number of patches with each value, of all patches or the selected ones*/
+	void getHistogram(int parameterNr, int* counts, const PatchSelection* selection = NULL) const
+	{
+		//four tables, so a run of equal values doesn't wait for each increment.
+		//the unselected values are counted above COLUMNS_HISTOGRAM_SIZE and dropped
+		HeapBlock<int> tables;
+		tables.calloc(4*2*COLUMNS_HISTOGRAM_SIZE);
+		int* const t0 = tables;
+		int* const t1 = t0 + 2*COLUMNS_HISTOGRAM_SIZE;
+		int* const t2 = t1 + 2*COLUMNS_HISTOGRAM_SIZE;
+		int* const t3 = t2 + 2*COLUMNS_HISTOGRAM_SIZE;
+
+		const uint8_t* column = getColumn(parameterNr);
+		const uint8_t* mask = selection != NULL ? selection->getMask() : NULL;
+		int i = 0;
+		if(mask != NULL)
+		{
+			//the padding of the column and the mask is zero, no tail
+			for(;i<mNumPatches;i+=4)
+			{
+				t0[column[i]   | ((~mask[i]   & 1) << 8)]++;
+				t1[column[i+1] | ((~mask[i+1] & 1) << 8)]++;
+				t2[column[i+2] | ((~mask[i+2] & 1) << 8)]++;
+				t3[column[i+3] | ((~mask[i+3] & 1) << 8)]++;
+			}
+		}
+		else
+		{
+			for(;i+4<=mNumPatches;i+=4)
+			{
+				t0[column[i]]++;
+				t1[column[i+1]]++;
+				t2[column[i+2]]++;
+				t3[column[i+3]]++;
+			}
+			for(;i<mNumPatches;i++)
+			{
+				t0[column[i]]++;
+			}
+		}
+
+		for(int v=0;v<COLUMNS_HISTOGRAM_SIZE;v++)
+		{
+			counts[v] = t0[v] + t1[v] + t2[v] + t3[v];
+		}
+	};
+
+	ColumnStats getStats(int parameterNr, const PatchSelection* selection = NULL) const
+	{
+		const ColumnSums sums = getSums(parameterNr,parameterNr,selection);
+
+		ColumnStats stats;
+		stats.count = (int)sums.count;
+		stats.mean = 0;
+		stats.variance = 0;
+		if(sums.count > 0)
+		{
+			const double n = (double)sums.count;
+			stats.mean = sums.sumA / n;
+			//the sums are exact, the usual cancellation of this formula doesn't happen before the division
+			stats.variance = jmax(0.,(double)(sums.count*sums.sumAA - sums.sumA*sums.sumA) / (n*n));
+		}
+		return stats;
+	};
+
+	/** the Pearson correlation of two parameters, 0 if one of them doesn't vary*/
+	double getCorrelation(int parameterA, int parameterB, const PatchSelection* selection = NULL) const
+	{
+		const ColumnSums sums = getSums(parameterA,parameterB,selection);
+
+		const double covariance = (double)(sums.count*sums.sumAB - sums.sumA*sums.sumB);
+		const double varianceA = (double)(sums.count*sums.sumAA - sums.sumA*sums.sumA);
+		const double varianceB = (double)(sums.count*sums.sumBB - sums.sumB*sums.sumB);
+		if(varianceA <= 0 || varianceB <= 0) return 0;
+		return covariance / sqrt(varianceA*varianceB);
+	};
+
+	/** one pass over two columns, the same column twice for the statistics of one*/
+	ColumnSums getSums(int parameterA, int parameterB, const PatchSelection* selection = NULL) const
+	{
+		jassert(selection == NULL || selection->getNumPatches() == mNumPatches);
+		ColumnSums sums;
+		accumulate(getColumn(parameterA),getColumn(parameterB),selection != NULL ? selection->getMask() : NULL,mStride,sums);
+		if(selection == NULL) sums.count = mNumPatches;
+		return sums;
+	};
+
+	//-----------------------------------------------------------------------
+	/** transpose the records of a library into a column file. the library is
+		read PATCH_COLUMNS_GROUP parameters at a time, the memory needed is
+		that many columns*/
+	static bool build(PatchLibrary& library, const File& target)
+	{
+		TRACE_SCOPE("patch io","build columns");
+		const int numPatches = library.getNumPatches();
+		const int stride = PATCH_COLUMNS_STRIDE(numPatches);
+
+		TemporaryFile temp(target);
+		ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+		if(out == NULL) return false;
+
+		const File& libraryFile = library.getFile();
+		out->writeInt(PATCH_COLUMNS_MAGIC);
+		out->writeInt(PATCH_COLUMNS_VERSION);
+		out->writeInt(NUM_PARAMS);
+		out->writeInt(numPatches);
+		out->writeInt(stride);
+		out->writeInt(PATCH_COLUMNS_HEADER_SIZE);
+		out->writeInt64(libraryFile.getSize());
+		out->writeInt64(libraryFile.getLastModificationTime().toMilliseconds());
+		for(int i=10*4;i<PATCH_COLUMNS_HEADER_SIZE;i+=4)
+		{
+			out->writeInt(0);
+		}
+
+		//the padding of each column stays zero
+		HeapBlock<uint8_t> group;
+		group.calloc(jmax(1,stride)*PATCH_COLUMNS_GROUP);
+		for(int first=0;first<NUM_PARAMS;first+=PATCH_COLUMNS_GROUP)
+		{
+			const int numColumns = jmin(PATCH_COLUMNS_GROUP,NUM_PARAMS-first);
+			for(int record=0;record<numPatches;record++)
+			{
+				const uint8_t* values = library.getPatchData(record) + PATCH_NAME_LENGTH + first;
+				for(int c=0;c<numColumns;c++)
+				{
+					group[c*stride + record] = values[c];
+				}
+			}
+			out->write(group,numColumns*stride);
+		}
+
+		out->flush();
+		const bool failed = out->getStatus().failed();
+		out = NULL;
+		return !failed && temp.overwriteTargetFileWithTemporary();
+	};
+
+private:
+	/** returns false if the file is missing or doesn't belong to the library as it is now*/
+	bool map(const File& file, PatchLibrary& library)
+	{
+		MappedFileData::Ptr mapping = MappedFileData::open(file);
+		if(mapping == NULL) return false;
+
+		const uint8_t* header = mapping->getRange(0,PATCH_COLUMNS_HEADER_SIZE);
+		if(header == NULL
+			|| readInt(header,0) != PATCH_COLUMNS_MAGIC
+			|| readInt(header,1) != PATCH_COLUMNS_VERSION
+			|| readInt(header,2) != NUM_PARAMS
+			|| (int)readInt(header,3) != library.getNumPatches()
+			|| (int)readInt(header,4) != PATCH_COLUMNS_STRIDE(library.getNumPatches())
+			|| readInt(header,5) != PATCH_COLUMNS_HEADER_SIZE
+			|| readInt64(header,6) != library.getFile().getSize()
+			|| readInt64(header,8) != library.getFile().getLastModificationTime().toMilliseconds())
+		{
+			return false;
+		}
+
+		const int stride = (int)readInt(header,4);
+		const uint8_t* columns = mapping->getRange(PATCH_COLUMNS_HEADER_SIZE,(size_t)stride*NUM_PARAMS);
+		if(columns == NULL) return false;
+
+		mMapping = mapping;
+		mColumns = columns;
+		mNumPatches = library.getNumPatches();
+		mStride = stride;
+		return true;
+	};
+
+	static uint32 readInt(const uint8_t* data, int index)
+	{
+		return ByteOrder::littleEndianInt(data + index*4);
+	};
+
+	static int64 readInt64(const uint8_t* data, int index)
+	{
+		return (int64)readInt(data,index) | ((int64)readInt(data,index+1) << 32);
+	};
+
+	/** num is a multiple of 16 and the padding is zero, so there is no tail. mask may be NULL,
+		the count is then left to the caller*/
+	static void accumulate(const uint8_t* a, const uint8_t* b, const uint8_t* mask, int num, ColumnSums& sums)
+	{
+		memset(&sums,0,sizeof(sums));
+		int i = 0;
+#if COLUMNS_USE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i all = _mm_set1_epi8((char)0xff);
+		const __m128i ones = _mm_set1_epi8(1);
+		__m128i count = zero, sumA = zero, sumB = zero;		// 64 bit lanes
+		__m128i sumAA = zero, sumBB = zero, sumAB = zero;	// 32 bit lanes
+		int numBlocks = 0;
+		for(;i+16<=num;i+=16)
+		{
+			const __m128i m = mask != NULL ? load(mask+i) : all;
+			const __m128i va = _mm_and_si128(load(a+i),m);
+			const __m128i vb = _mm_and_si128(load(b+i),m);
+			count = _mm_add_epi64(count,_mm_sad_epu8(_mm_and_si128(m,ones),zero));
+			sumA = _mm_add_epi64(sumA,_mm_sad_epu8(va,zero));
+			sumB = _mm_add_epi64(sumB,_mm_sad_epu8(vb,zero));
+
+			//bytes to 16 bit, madd multiplies and adds neighbours into 32 bit lanes
+			const __m128i aLow = _mm_unpacklo_epi8(va,zero);
+			const __m128i aHigh = _mm_unpackhi_epi8(va,zero);
+			const __m128i bLow = _mm_unpacklo_epi8(vb,zero);
+			const __m128i bHigh = _mm_unpackhi_epi8(vb,zero);
+			sumAA = _mm_add_epi32(sumAA,_mm_add_epi32(_mm_madd_epi16(aLow,aLow),_mm_madd_epi16(aHigh,aHigh)));
+			sumBB = _mm_add_epi32(sumBB,_mm_add_epi32(_mm_madd_epi16(bLow,bLow),_mm_madd_epi16(bHigh,bHigh)));
+			sumAB = _mm_add_epi32(sumAB,_mm_add_epi32(_mm_madd_epi16(aLow,bLow),_mm_madd_epi16(aHigh,bHigh)));
+
+			if(++numBlocks == COLUMNS_FLUSH_BLOCKS)
+			{
+				flush(sumAA,sumBB,sumAB,sums);
+				sumAA = sumBB = sumAB = zero;
+				numBlocks = 0;
+			}
+		}
+		flush(sumAA,sumBB,sumAB,sums);
+		sums.count += sum64(count);
+		sums.sumA += sum64(sumA);
+		sums.sumB += sum64(sumB);
+#elif COLUMNS_USE_NEON
+		const uint8x16_t all = vdupq_n_u8(0xff);
+		const uint8x16_t ones = vdupq_n_u8(1);
+		uint32x4_t count = vdupq_n_u32(0), sumA = count, sumB = count;
+		uint32x4_t sumAA = count, sumBB = count, sumAB = count;
+		int numBlocks = 0;
+		for(;i+16<=num;i+=16)
+		{
+			const uint8x16_t m = mask != NULL ? vld1q_u8(mask+i) : all;
+			const uint8x16_t va = vandq_u8(vld1q_u8(a+i),m);
+			const uint8x16_t vb = vandq_u8(vld1q_u8(b+i),m);
+			count = vpadalq_u16(count,vpaddlq_u8(vandq_u8(m,ones)));
+			sumA = vpadalq_u16(sumA,vpaddlq_u8(va));
+			sumB = vpadalq_u16(sumB,vpaddlq_u8(vb));
+
+			//a product of two bytes fits 16 bits
+			sumAA = vpadalq_u16(sumAA,vmull_u8(vget_low_u8(va),vget_low_u8(va)));
+			sumAA = vpadalq_u16(sumAA,vmull_u8(vget_high_u8(va),vget_high_u8(va)));
+			sumBB = vpadalq_u16(sumBB,vmull_u8(vget_low_u8(vb),vget_low_u8(vb)));
+			sumBB = vpadalq_u16(sumBB,vmull_u8(vget_high_u8(vb),vget_high_u8(vb)));
+			sumAB = vpadalq_u16(sumAB,vmull_u8(vget_low_u8(va),vget_low_u8(vb)));
+			sumAB = vpadalq_u16(sumAB,vmull_u8(vget_high_u8(va),vget_high_u8(vb)));
+
+			if(++numBlocks == COLUMNS_FLUSH_BLOCKS)
+			{
+				sums.count += sum32(count);		sums.sumA += sum32(sumA);		sums.sumB += sum32(sumB);
+				sums.sumAA += sum32(sumAA);		sums.sumBB += sum32(sumBB);		sums.sumAB += sum32(sumAB);
+				count = sumA = sumB = sumAA = sumBB = sumAB = vdupq_n_u32(0);
+				numBlocks = 0;
+			}
+		}
+		sums.count += sum32(count);		sums.sumA += sum32(sumA);		sums.sumB += sum32(sumB);
+		sums.sumAA += sum32(sumAA);		sums.sumBB += sum32(sumBB);		sums.sumAB += sum32(sumAB);
+#endif
+		for(;i<num;i++)
+		{
+			if(mask != NULL && mask[i] == 0) continue;
+			const int va = a[i];
+			const int vb = b[i];
+			sums.count++;
+			sums.sumA += va;
+			sums.sumB += vb;
+			sums.sumAA += va*va;
+			sums.sumBB += vb*vb;
+			sums.sumAB += va*vb;
+		}
+	};
+
+#if COLUMNS_USE_SSE2
+	static __m128i load(const uint8_t* p)
+	{
+		return _mm_loadu_si128((const __m128i*)p);
+	};
+
+	static int64 sum64(__m128i v)
+	{
+		int64 lanes[2];
+		_mm_storeu_si128((__m128i*)lanes,v);
+		return lanes[0] + lanes[1];
+	};
+
+	static int64 sum32(__m128i v)
+	{
+		int32 lanes[4];
+		_mm_storeu_si128((__m128i*)lanes,v);
+		return (int64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	};
+
+	static void flush(__m128i sumAA, __m128i sumBB, __m128i sumAB, ColumnSums& sums)
+	{
+		sums.sumAA += sum32(sumAA);
+		sums.sumBB += sum32(sumBB);
+		sums.sumAB += sum32(sumAB);
+	};
+#elif COLUMNS_USE_NEON
+	static int64 sum32(uint32x4_t v)
+	{
+		return (int64)vgetq_lane_u32(v,0) + vgetq_lane_u32(v,1) + vgetq_lane_u32(v,2) + vgetq_lane_u32(v,3);
+	};
+#endif
+
+	MappedFileData::Ptr mMapping;
+	const uint8_t* mColumns;
+	int mNumPatches;
+	int mStride;
+};
+//---------------------------------------------------------------------------
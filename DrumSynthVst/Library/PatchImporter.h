@@ -0,0 +1,289 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../parameterRanges.h"
+#include "../PresetLoader.h"
+#include "../PatchHash.h"
+#include "../ParallelFor.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define PATCH_IMPORT_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define PATCH_IMPORT_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define PATCH_IMPORT_STRIDE		((NUM_PARAMS+15)&~15)	// the bound table is padded to whole 16 byte vectors
+#define PATCH_IMPORT_GRAIN		256						// records per item of the ParallelFor
+#define PATCH_IMPORT_REPORT		"import report.txt"		// written into the quarantine folder
+
+//---------------------------------------------------------------------------
+/** Checks the values of patch records against the highest stored value of
+	every parameter: 126 for PM63 parameters, the max of their
+	parameterRanges entry for the others. Nothing is below 0, and the
+	parameters that count from 1 hold 0 in an empty patch and in the files
+	the editor writes from one, so the lower bound is 0 for all of them.
+	A record is 16 values per compare with SSE2 or NEON, the bound of the
+	padding lets everything through. Any thread.
+*/
+class PatchRangeCheck
+{
+public:
+	PatchRangeCheck()
+	{
+		memset(mHigh,0xff,sizeof(mHigh));
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			const ParameterRange& range = parameterRanges[i];
+			mHigh[i] = (uint8_t)((range.min < 0 ? 0 : range.min) + range.range);
+		}
+	};
+
+	/** NUM_PARAMS values, the first one that is out of its bounds or -1*/
+	int findBadValue(const uint8_t* values) const
+	{
+		if(isValid(values)) return -1;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(values[i] > mHigh[i]) return i;
+		}
+		return -1;
+	};
+
+	bool isValid(const uint8_t* values) const
+	{
+		//the last vector is read from a padded copy, the values end inside it
+		uint8_t tail[16];
+		const int numWhole = NUM_PARAMS & ~15;
+		memset(tail,0,16);
+		memcpy(tail,values+numWhole,NUM_PARAMS-numWhole);
+
+#if PATCH_IMPORT_USE_SSE2
+		__m128i ok = _mm_set1_epi8(-1);
+		for(int i=0;i<PATCH_IMPORT_STRIDE;i+=16)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(i < numWhole ? values+i : tail));
+			ok = _mm_and_si128(ok,_mm_cmpeq_epi8(_mm_min_epu8(v,_mm_loadu_si128((const __m128i*)(mHigh+i))),v));
+		}
+		return _mm_movemask_epi8(ok) == 0xffff;
+#elif PATCH_IMPORT_USE_NEON
+		uint8x16_t ok = vdupq_n_u8(0xff);
+		for(int i=0;i<PATCH_IMPORT_STRIDE;i+=16)
+		{
+			const uint8x16_t v = vld1q_u8(i < numWhole ? values+i : tail);
+			ok = vandq_u8(ok,vcleq_u8(v,vld1q_u8(mHigh+i)));
+		}
+		const uint64x2_t words = vreinterpretq_u64_u8(ok);
+		return (vgetq_lane_u64(words,0) & vgetq_lane_u64(words,1)) == literal64bit(0xffffffffffffffff);
+#else
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(values[i] > mHigh[i]) return false;
+		}
+		return true;
+#endif
+	};
+
+	int getHigh(int parameterNr) const
+	{
+		return mHigh[parameterNr];
+	};
+
+private:
+	uint8_t mHigh[PATCH_IMPORT_STRIDE];		// 255 in the padding
+};
+//---------------------------------------------------------------------------
+/** Imports a collection of loose .SND files in one go.
+
+	The files are read in parallel with PresetLoader::loadPatches(), which
+	also rejects every file that isn't exactly PATCH_DATA_SIZE bytes. Then
+	one pass over the ParallelFor checks the values of each record with the
+	PatchRangeCheck and hashes the good ones, and the hashes go into a
+	PatchHashSet in file order, so with setDedupe() only the first of
+	several files that sound the same is taken. The good records are
+	appended to the caller's block in file order.
+
+	getReport() says why each rejected file was rejected, the files can be
+	copied to a quarantine folder together with the
+	report to be looked at or repaired.
+*/
+class PatchImporter
+{
+public:
+	PatchImporter()
+	: mDedupe(false),
+	mNumImported(0),
+	mNumDuplicates(0)
+	{
+	};
+
+	/** skip files that sound like one imported before*/
+	void setDedupe(bool dedupe)
+	{
+		mDedupe = dedupe;
+	};
+
+	/** appends the PATCH_DATA_SIZE records of the good files to records, returns how many.
+		the report and the rejected files are those of this call*/
+	int import(const Array<File>& files, MemoryBlock& records)
+	{
+		TRACE_SCOPE("patch io","import");
+		mRejected.clear();
+		mReport.clear();
+		mNumImported = 0;
+		mNumDuplicates = 0;
+
+		ScopedPointer<PatchBatch> batch(PresetLoader::loadPatches(files,true));
+		const int numFiles = batch->getNumPatches();
+		HeapBlock<int> status(jmax(1,numFiles));
+		HeapBlock<int> badValue(jmax(1,numFiles));
+		HeapBlock<uint64> hashes(jmax(1,numFiles));
+		CheckTask task(mRangeCheck,*batch,status,badValue,hashes);
+		ParallelFor::getInstance()->execute(numFiles,PATCH_IMPORT_GRAIN,task);
+
+		PatchHashSet seen(numFiles);
+		for(int i=0;i<numFiles;i++)
+		{
+			if(status[i] != LOAD_OK)
+			{
+				const File& file = files.getReference(i);
+				mRejected.add(file);
+				mReport.add(file.getFullPathName() + ": " + getProblem(file,status[i],badValue[i],batch->getPatchData(i)));
+				continue;
+			}
+			if(mDedupe && !seen.addHash(hashes[i],i))
+			{
+				mNumDuplicates++;
+				continue;
+			}
+			records.append(batch->getPatchData(i),PATCH_DATA_SIZE);
+			mNumImported++;
+		}
+		return mNumImported;
+	};
+
+	int getNumImported() const
+	{
+		return mNumImported;
+	};
+
+	int getNumRejected() const
+	{
+		return mRejected.size();
+	};
+
+	int getNumDuplicates() const
+	{
+		return mNumDuplicates;
+	};
+
+	/** a line for every rejected file: its path and why*/
+	const StringArray& getReport() const
+	{
+		return mReport;
+	};
+
+	/** copies the rejected files into folder and adds the report to PATCH_IMPORT_REPORT there.
+		the files of the collection stay where they are*/
+	bool quarantine(const File& folder) const
+	{
+		if(mRejected.size() == 0) return true;
+		if(!folder.createDirectory()) return false;
+
+		bool ok = true;
+		for(int i=0;i<mRejected.size();i++)
+		{
+			const File& file = mRejected.getReference(i);
+			if(!file.existsAsFile()) continue;
+
+			const File target = folder.getNonexistentChildFile(file.getFileNameWithoutExtension(),file.getFileExtension(),false);
+			ok = file.copyFileTo(target) && ok;
+		}
+		return folder.getChildFile(PATCH_IMPORT_REPORT).appendText(mReport.joinIntoString("\n") + "\n") && ok;
+	};
+
+private:
+	/** checks and hashes the records that were read*/
+	class CheckTask : public ParallelTask
+	{
+	public:
+		CheckTask(const PatchRangeCheck& rangeCheck, const PatchBatch& batch, int* status, int* badValue, uint64* hashes)
+		: mRangeCheck(rangeCheck),
+		mBatch(batch),
+		mStatus(status),
+		mBadValue(badValue),
+		mHashes(hashes)
+		{
+		};
+
+		void run(int begin, int end, int)
+		{
+			for(int i=begin;i<end;i++)
+			{
+				mStatus[i] = mBatch.getStatus(i);
+				mBadValue[i] = -1;
+				mHashes[i] = 0;
+				if(mStatus[i] != LOAD_OK) continue;
+
+				const uint8_t* values = mBatch.getPatchData(i) + PATCH_NAME_LENGTH;
+				mBadValue[i] = mRangeCheck.findBadValue(values);
+				if(mBadValue[i] >= 0)	mStatus[i] = LOAD_OUT_OF_RANGE;
+				else					mHashes[i] = hashPatchValues(values);
+			}
+		};
+
+	private:
+		const PatchRangeCheck& mRangeCheck;
+		const PatchBatch& mBatch;
+		int* mStatus;
+		int* mBadValue;
+		uint64* mHashes;
+	};
+
+	String getProblem(const File& file, int status, int badValue, const uint8_t* data) const
+	{
+		switch(status)
+		{
+		case LOAD_FILE_NOT_FOUND:	return "not found";
+		case LOAD_WRONG_SIZE:		return String(file.getSize()) + " bytes instead of " + String(PATCH_DATA_SIZE);
+		case LOAD_OUT_OF_RANGE:
+			return "p" + String(badValue) + " is " + String(data[PATCH_NAME_LENGTH+badValue]) + ", above "
+				+ String(mRangeCheck.getHigh(badValue));
+		default:					return "can't be read";
+		}
+	};
+
+	PatchRangeCheck mRangeCheck;
+	bool mDedupe;
+	Array<File> mRejected;
+	StringArray mReport;
+	int mNumImported;
+	int mNumDuplicates;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,268 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PresetLoader.h"
+#include "../PatchHash.h"
+#include "../FlatHashMap.h"
+#include "../Preview/PatchFeatures.h"
+
+#define PATCH_INDEX_MAGIC		0x58495053	// "SPIX" little endian
+#define PATCH_INDEX_VERSION		2
+#define PATCH_INDEX_FILENAME	"patches.idx"
+
+//---------------------------------------------------------------------------
+struct PatchIndexEntry
+{
+	File file;
+	int64 modificationTime;	// ms since 1970
+	int64 fileSize;
+	uint64 hash;			// hashPatchValues() of the patch
+	ShortString name;
+	PatchFeatures features;	// of the rendered preview, for similarity search
+};
+//---------------------------------------------------------------------------
+/** Name, content hash and audio features of every .SND file in a folder,
+	cached on disk.
+
+	update() walks the folder once, using the size and time the directory
+	listing already returns, and only reads files that are new or have
+	changed since the last update. Only those are rendered for the features,
+	on all cores. The cache is a small binary file written with save() and
+	read back with load(), so a large folder doesn't have to be read again on
+	every start.
+*/
+class PatchIndex
+{
+public:
+	PatchIndex()
+	{
+	};
+
+	~PatchIndex()
+	{
+	};
+
+	/** read a cache written by save(). returns false if missing or invalid, the index is empty then*/
+	bool load(const File& cacheFile)
+	{
+		clear();
+
+		FileInputStream in(cacheFile);
+		if(in.getStatus().failed()) return false;
+
+		if(in.readInt() != PATCH_INDEX_MAGIC || in.readInt() != PATCH_INDEX_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
+
+		const int numEntries = in.readInt();
+		for(int i=0;i<numEntries && !in.isExhausted();i++)
+		{
+			PatchIndexEntry& entry = mEntries.addNew();
+			entry.file = File(in.readString());
+			entry.modificationTime = in.readInt64();
+			entry.fileSize = in.readInt64();
+			entry.hash = (uint64)in.readInt64();
+			entry.name = ShortString(in.readString());
+			entry.features.read(in);
+			addPath(mEntries.size()-1);
+		}
+		if(mEntries.size() != numEntries)
+		{
+			clear();
+			return false;
+		}
+		return true;
+	};
+
+	bool save(const File& cacheFile)
+	{
+		TemporaryFile temp(cacheFile);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->writeInt(PATCH_INDEX_MAGIC);
+			out->writeInt(PATCH_INDEX_VERSION);
+			out->writeInt(NUM_PARAMS);
+			out->writeInt(mEntries.size());
+			for(int i=0;i<mEntries.size();i++)
+			{
+				const PatchIndexEntry& entry = mEntries.getReference(i);
+				out->writeString(entry.file.getFullPathName());
+				out->writeInt64(entry.modificationTime);
+				out->writeInt64(entry.fileSize);
+				out->writeInt64((int64)entry.hash);
+				out->writeString(entry.name.toString());
+				entry.features.write(*out);
+			}
+
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** bring the index in line with the .SND files in a folder.
+		returns the number of entries that were added, changed or removed*/
+	int update(const File& folder, bool recursive=false)
+	{
+		Array<PatchIndexEntry> entries;
+		Array<int> changed;
+
+		DirectoryIterator iter(folder,recursive,"*.snd",File::findFiles);
+		bool isDirectory;
+		int64 fileSize;
+		Time modificationTime;
+		while(iter.next(&isDirectory,NULL,&fileSize,&modificationTime,NULL,NULL))
+		{
+			PatchIndexEntry& entry = entries.addNew();
+			entry.file = iter.getFile();
+			entry.modificationTime = modificationTime.toMilliseconds();
+			entry.fileSize = fileSize;
+			entry.hash = 0;
+
+			const int known = indexOf(entry.file);
+			if(known >= 0
+				&& mEntries.getReference(known).modificationTime == entry.modificationTime
+				&& mEntries.getReference(known).fileSize == entry.fileSize)
+			{
+				entry = mEntries.getReference(known);
+			}
+			else
+			{
+				changed.add(entries.size()-1);
+			}
+		}
+
+		//read only the new and modified files
+		if(changed.size() > 0)
+		{
+			Array<File> files;
+			for(int i=0;i<changed.size();i++)
+			{
+				files.add(entries.getReference(changed[i]).file);
+			}
+
+			ScopedPointer<PatchBatch> batch(PresetLoader::loadPatches(files));
+			Array<const uint8_t*> values;
+			for(int i=0;i<changed.size();i++)
+			{
+				PatchIndexEntry& entry = entries.getReference(changed[i]);
+				//a file that couldn't be read is tried again on the next update
+				if(batch->getStatus(i) != LOAD_OK) entry.modificationTime = 0;
+
+				const uint8_t* data = batch->getPatchData(i);
+				entry.hash = hashPatchValues(data+PATCH_NAME_LENGTH);
+				entry.name = ShortString((const char*)data,PATCH_NAME_LENGTH);
+				values.add(data+PATCH_NAME_LENGTH);
+			}
+
+			HeapBlock<PatchFeatures> features(changed.size());
+			PatchFeatureExtractor::computeAll(values, features);
+			for(int i=0;i<changed.size();i++)
+			{
+				entries.getReference(changed[i]).features = features[i];
+			}
+		}
+
+		//everything that is neither kept nor changed has been removed
+		const int numKept = entries.size() - changed.size();
+		const int numChanged = changed.size() + (mEntries.size() - numKept);
+
+		//the new entries are taken over as they are, only the paths are indexed again
+		clear();
+		mEntries.swapWithArray(entries);
+		mPaths.reserve(mEntries.size());
+		for(int i=0;i<mEntries.size();i++)
+		{
+			addPath(i);
+		}
+		return numChanged;
+	};
+
+	/** adds the entry, or replaces the one of the same file. For a file that was just written
+		and whose features are already known*/
+	void add(const PatchIndexEntry& entry)
+	{
+		const int known = indexOf(entry.file);
+		if(known >= 0)
+		{
+			mEntries.getReference(known) = entry;
+			return;
+		}
+		mEntries.add(entry);
+		addPath(mEntries.size()-1);
+	};
+
+	void clear()
+	{
+		mEntries.clear();
+		mPaths.clear();
+	};
+
+	int getNumEntries() const
+	{
+		return mEntries.size();
+	};
+
+	const PatchIndexEntry& getEntry(int index) const
+	{
+		return mEntries.getReference(index);
+	};
+
+	/** index of the entry for a file or -1*/
+	int indexOf(const File& file) const
+	{
+		const int* index = mPaths.find(file.getFullPathName());
+		return index != NULL ? *index : -1;
+	};
+
+	void getFiles(Array<File>& results) const
+	{
+		for(int i=0;i<mEntries.size();i++)
+		{
+			results.add(mEntries.getReference(i).file);
+		}
+	};
+
+	/** the default cache location for a patch folder*/
+	static File getCacheFile(const File& folder)
+	{
+		return folder.getChildFile(PATCH_INDEX_FILENAME);
+	};
+
+private:
+	void addPath(int index)
+	{
+		mPaths.set(mEntries.getReference(index).file.getFullPathName(),index);
+	};
+
+	Array<PatchIndexEntry> mEntries;
+	FlatHashMap<String,int> mPaths;	// full path -> index in mEntries
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,333 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "JsonStreamParser.h"
+#include "PatchLibrary.h"
+#include "MappedFileData.h"
+
+#define PATCH_JSON_EXTENSION		".json"
+#define PATCH_JSON_WRITE_BUFFER_SIZE	65536
+#define PATCH_JSON_FORMAT			"sonic potions drumsynth patches"
+
+//---------------------------------------------------------------------------
+/** Turns a JSON patch list into a PatchLibrary and back, record by record.
+
+	A list looks like
+		{"format":"...","numParams":N,"patches":[
+		{"name":"KICK 01","values":[v0,v1,...]},
+		...]}
+	a plain array of the patch objects is read as well. Members the editor
+	doesn't know are skipped, so other tools can add their own. A patch
+	needs one integer 0-255 for every parameter, one that doesn't have them
+	is skipped and counted in getNumSkipped().
+
+	The reading side is a JsonStreamParser listener that fills a single
+	record and hands it straight to a PatchLibraryWriter, the writing side
+	formats each record into one line of a buffered stream. Neither builds
+	juce vars, so a list of any size costs one record of memory.
+
+	Names are the raw bytes of the record: printable ASCII is written as it
+	is, any other byte as \u00XX, and trailing 0 bytes are left out. Names
+	read back keep characters up to U+00FF as one byte, others become '?'.
+*/
+class PatchJson : public JsonStreamParser::Listener
+{
+public:
+	PatchJson(const File& libraryFile)
+	: mWriter(libraryFile),
+	mParser(this),
+	mDepth(0),
+	mListDepth(-1),
+	mRootKey(KEY_OTHER),
+	mPatchKey(KEY_OTHER),
+	mNumValues(0),
+	mNumSkipped(0)
+	{
+	};
+
+	~PatchJson()
+	{
+	};
+
+	JsonStreamParser& getParser()
+	{
+		return mParser;
+	};
+
+	int getNumPatches()
+	{
+		return mWriter.getNumPatches();
+	};
+
+	/** patches that didn't have a full set of valid values*/
+	int getNumSkipped()
+	{
+		return mNumSkipped;
+	};
+
+	/** write the library. returns false if it couldn't be written or the list was incomplete*/
+	bool finish()
+	{
+		if(!mParser.finish() || mListDepth < 0) return false;
+		return mWriter.finish();
+	};
+
+	//----- JsonStreamParser::Listener
+	void startObject()
+	{
+		mDepth++;
+		if(mDepth == mListDepth+1)
+		{
+			//a new patch
+			memset(mRecord,0,PATCH_DATA_SIZE);
+			mNumValues = 0;
+			mValid = true;
+			mPatchKey = KEY_OTHER;
+		}
+	};
+
+	void endObject()
+	{
+		if(mDepth == mListDepth+1)
+		{
+			if(mValid && mNumValues == NUM_PARAMS)	mWriter.addPatch(mRecord);
+			else									mNumSkipped++;
+		}
+		mDepth--;
+	};
+
+	void startArray()
+	{
+		mDepth++;
+		//the list is the root array or the patches member of the root object
+		if(mListDepth < 0 && (mDepth == 1 || (mDepth == 2 && mRootKey == KEY_PATCHES)))
+		{
+			mListDepth = mDepth;
+		}
+	};
+
+	void endArray()
+	{
+		mDepth--;
+	};
+
+	void key(const char* text, int length)
+	{
+		Key k = KEY_OTHER;
+		if(length == 7 && memcmp(text,"patches",7) == 0)		k = KEY_PATCHES;
+		else if(length == 4 && memcmp(text,"name",4) == 0)		k = KEY_NAME;
+		else if(length == 6 && memcmp(text,"values",6) == 0)	k = KEY_VALUES;
+
+		if(mDepth == 1)					mRootKey = k;
+		else if(isInPatch(0))			mPatchKey = k;
+	};
+
+	void stringValue(const char* text, int length)
+	{
+		if(isInPatch(0) && mPatchKey == KEY_NAME) setName(text,length);
+	};
+
+	void numberValue(double value)
+	{
+		if(!isInPatch(1) || mPatchKey != KEY_VALUES) return;
+
+		if(mNumValues < NUM_PARAMS && value >= 0 && value <= 255 && value == (int)value)
+		{
+			mRecord[PATCH_NAME_LENGTH + mNumValues] = (uint8_t)(int)value;
+		}
+		else
+		{
+			mValid = false;
+		}
+		mNumValues++;
+	};
+
+	void boolValue(bool)
+	{
+		if(isInPatch(1) && mPatchKey == KEY_VALUES) mValid = false;
+	};
+
+	void nullValue()
+	{
+		if(isInPatch(1) && mPatchKey == KEY_VALUES) mValid = false;
+	};
+
+	//-----------------------------------------------------------------------
+	/** convert a JSON patch list into a library. returns the number of patches or -1 on failure.
+		thread can be given to make the import cancelable*/
+	static int importLibrary(const File& jsonFile, const File& libraryFile, Thread* thread = NULL)
+	{
+		//parsed from the page cache like a .syx bank, an empty file can't be mapped and is read as a stream
+		MappedFileData::Ptr mapping(MappedFileData::open(jsonFile));
+		PatchJson list(libraryFile);
+		if(mapping != NULL)
+		{
+			if(!list.getParser().feed(mapping->getData(),mapping->getSize(),thread)) return -1;
+		}
+		else
+		{
+			FileInputStream in(jsonFile);
+			if(in.getStatus().failed()) return -1;
+			if(!list.getParser().feed(in,thread)) return -1;
+		}
+		if(!list.finish()) return -1;
+		return list.getNumPatches();
+	};
+
+	/** write every patch of a library into a JSON patch list*/
+	static bool exportLibrary(PatchLibrary& library, const File& jsonFile)
+	{
+		//the records of a library are back to back in the mapped file
+		const int numPatches = library.getNumPatches();
+		return exportLibrary(numPatches > 0 ? library.getPatchData(0) : NULL,numPatches,jsonFile);
+	};
+
+	/** write PATCH_DATA_SIZE records stored back to back into a JSON patch list*/
+	static bool exportLibrary(const void* records, int numPatches, const File& jsonFile)
+	{
+		TemporaryFile temp(jsonFile);
+		{
+			FileOutputStream out(temp.getFile(),PATCH_JSON_WRITE_BUFFER_SIZE);
+			if(out.getStatus().failed()) return false;
+
+			const String header = String("{\"format\":\"") + PATCH_JSON_FORMAT + "\",\"numParams\":" + String(NUM_PARAMS) + ",\"patches\":[\n";
+			out.write(header.toUTF8(),(int)strlen(header.toUTF8()));
+
+			//at most 6 bytes per name byte and 4 per value
+			char line[64 + 6*PATCH_NAME_LENGTH + 4*NUM_PARAMS];
+			for(int i=0;i<numPatches;i++)
+			{
+				const int length = formatPatch((const uint8_t*)records + i*PATCH_DATA_SIZE,i+1 < numPatches,line);
+				out.write(line,length);
+			}
+			out.write("]}\n",3);
+
+			out.flush();
+			if(out.getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+private:
+	enum Key
+	{
+		KEY_OTHER = 0,
+		KEY_PATCHES,
+		KEY_NAME,
+		KEY_VALUES
+	};
+
+	/** true while the parser is inside a patch object, level containers below it*/
+	bool isInPatch(int level) const
+	{
+		return mListDepth >= 0 && mDepth == mListDepth+1+level;
+	};
+
+	/** UTF-8 into the name field, see the class comment*/
+	void setName(const char* text, int length)
+	{
+		memset(mRecord,0,PATCH_NAME_LENGTH);
+		const uint8_t* s = (const uint8_t*)text;
+		int pos = 0;
+		for(int n=0;n<PATCH_NAME_LENGTH && pos<length;n++)
+		{
+			const uint8_t b = s[pos++];
+			uint32 c = b;
+			if(b >= 0xc0 && b < 0xe0 && pos < length)
+			{
+				c = ((b&0x1f)<<6) | (s[pos++]&0x3f);
+			}
+			else if(b >= 0x80)
+			{
+				//longer sequences and stray continuation bytes
+				while(pos < length && (s[pos]&0xc0) == 0x80) pos++;
+				c = '?';
+			}
+			mRecord[n] = (uint8_t)(c < 0x100 ? c : '?');
+		}
+	};
+
+	/** one line of the list, returns its length*/
+	static int formatPatch(const uint8_t* data, bool hasNext, char* line)
+	{
+		static const char hex[] = "0123456789abcdef";
+		char* p = line;
+		p = append(p,"{\"name\":\"");
+
+		int nameLength = PATCH_NAME_LENGTH;
+		while(nameLength > 0 && data[nameLength-1] == 0) nameLength--;
+		for(int i=0;i<nameLength;i++)
+		{
+			const uint8_t b = data[i];
+			if(b == '"' || b == '\\')
+			{
+				*p++ = '\\';
+				*p++ = (char)b;
+			}
+			else if(b >= 0x20 && b < 0x7f)
+			{
+				*p++ = (char)b;
+			}
+			else
+			{
+				p = append(p,"\\u00");
+				*p++ = hex[b>>4];
+				*p++ = hex[b&15];
+			}
+		}
+
+		p = append(p,"\",\"values\":[");
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(i > 0) *p++ = ',';
+			const int v = data[PATCH_NAME_LENGTH+i];
+			if(v >= 100) *p++ = (char)('0' + v/100);
+			if(v >= 10) *p++ = (char)('0' + (v/10)%10);
+			*p++ = (char)('0' + v%10);
+		}
+		p = append(p,hasNext ? "]},\n" : "]}\n");
+		return (int)(p-line);
+	};
+
+	static char* append(char* p, const char* text)
+	{
+		while(*text != 0) *p++ = *text++;
+		return p;
+	};
+
+	PatchLibraryWriter mWriter;
+	JsonStreamParser mParser;
+	int mDepth;				// open objects and arrays
+	int mListDepth;			// depth of the array holding the patches, -1 until it was found
+	Key mRootKey;			// member of the root object being read
+	Key mPatchKey;			// member of the patch object being read
+	uint8_t mRecord[PATCH_DATA_SIZE];
+	int mNumValues;
+	bool mValid;
+	int mNumSkipped;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,409 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PresetLoader.h"
+#include "../PatchHash.h"
+#include "MappedFileData.h"
+#include "PatchImporter.h"
+
+#define PATCH_LIBRARY_MAGIC		0x42505053	// "SPPB" little endian
+#define PATCH_LIBRARY_VERSION	1
+#define PATCH_LIBRARY_HEADER_SIZE	32
+#define PATCH_LIBRARY_EXTENSION	".spb"
+#define LIBRARY_MANIFEST_EXTENSION	".spbm"	// the hashes of LibrarySync next to a library
+
+//---------------------------------------------------------------------------
+/** Orders record numbers by the patch names in a block of records*/
+class PatchNameComparator
+{
+public:
+	PatchNameComparator(const uint8_t* records) : mRecords(records) {};
+
+	int compareElements(int first, int second) const
+	{
+		const int result = memcmp(mRecords + first*PATCH_DATA_SIZE,mRecords + second*PATCH_DATA_SIZE,PATCH_NAME_LENGTH);
+		//keep equal names in file order
+		if(result == 0) return first - second;
+		return result;
+	};
+
+private:
+	const uint8_t* mRecords;
+};
+//---------------------------------------------------------------------------
+/** Writes a PatchLibrary one record at a time, so a bank of any size can be
+	written without holding its records in memory. The records go straight to
+	a temporary file, finish() sorts the name index through a mapping of that
+	file and then replaces the target.
+*/
+class PatchLibraryWriter
+{
+public:
+	PatchLibraryWriter(const File& file) : mTemp(file), mNumPatches(0)
+	{
+		mOut = mTemp.getFile().createOutputStream();
+		if(mOut != NULL) writeHeader();
+	};
+
+	~PatchLibraryWriter()
+	{
+	};
+
+	/** append PATCH_DATA_SIZE bytes in .SND layout*/
+	bool addPatch(const uint8_t* data)
+	{
+		if(mOut == NULL) return false;
+
+		mOut->write(data,PATCH_DATA_SIZE);
+		mNumPatches++;
+		return true;
+	};
+
+	int getNumPatches()
+	{
+		return mNumPatches;
+	};
+
+	/** write the index and move the library into place. returns false if anything failed*/
+	bool finish()
+	{
+		TRACE_SCOPE("patch io","write library");
+		if(mOut == NULL) return false;
+		mOut->flush();
+		if(mOut->getStatus().failed()) return false;
+		mOut = NULL;
+
+		//sort the record numbers by name for the index
+		Array<int> index;
+		for(int i=0;i<mNumPatches;i++)
+		{
+			index.add(i);
+		}
+		if(mNumPatches > 1)
+		{
+			MemoryMappedFile mapped(mTemp.getFile(),MemoryMappedFile::readOnly);
+			if(mapped.getData() == NULL) return false;
+
+			PatchNameComparator comparator((const uint8_t*)mapped.getData() + PATCH_LIBRARY_HEADER_SIZE);
+			//the comparator already keeps equal names in file order. juce's order
+			//keeping sort is a gnome sort, far too slow for a large library
+			index.sort(comparator,false);
+		}
+
+		//the stream appends to the records, the header is rewritten with the final count
+		mOut = mTemp.getFile().createOutputStream();
+		if(mOut == NULL) return false;
+		for(int i=0;i<mNumPatches;i++)
+		{
+			mOut->writeInt(index[i]);
+		}
+		mOut->setPosition(0);
+		writeHeader();
+
+		mOut->flush();
+		const bool failed = mOut->getStatus().failed();
+		mOut = NULL;
+		if(failed || !mTemp.overwriteTargetFileWithTemporary()) return false;
+
+		//its stamp only has the size and the time in seconds, a quick rewrite could pass it
+		mTemp.getTargetFile().withFileExtension(LIBRARY_MANIFEST_EXTENSION).deleteFile();
+		return true;
+	};
+
+private:
+	void writeHeader()
+	{
+		mOut->writeInt(PATCH_LIBRARY_MAGIC);
+		mOut->writeInt(PATCH_LIBRARY_VERSION);
+		mOut->writeInt(NUM_PARAMS);
+		mOut->writeInt(mNumPatches);
+		mOut->writeInt(PATCH_DATA_SIZE);
+		mOut->writeInt(PATCH_LIBRARY_HEADER_SIZE + mNumPatches*PATCH_DATA_SIZE);
+		for(int i=6*4;i<PATCH_LIBRARY_HEADER_SIZE;i+=4)
+		{
+			mOut->writeInt(0);
+		}
+	};
+
+	TemporaryFile mTemp;
+	ScopedPointer<FileOutputStream> mOut;
+	int mNumPatches;
+};
+//---------------------------------------------------------------------------
+/** A bank of patches packed into one file that is read in place through a memory mapping.
+
+	Layout (all numbers 32 bit little endian):
+	header		magic, version, NUM_PARAMS, number of patches, record size,
+				offset of the name index, padding up to PATCH_LIBRARY_HEADER_SIZE
+	records		one PATCH_DATA_SIZE record per patch, same layout as a .SND file
+	name index	record numbers sorted by patch name, for findPatch()
+
+	Libraries are written from loose .SND files with createFromFiles() and can
+	be turned back into loose files with exportToFolder().
+*/
+class PatchLibrary
+{
+public:
+	PatchLibrary() : mRecords(NULL), mIndex(NULL), mNumPatches(0)
+	{
+	};
+
+	~PatchLibrary()
+	{
+		close();
+	};
+
+	/** map a library file. returns false if it can't be read or isn't a valid library*/
+	bool open(const File& file)
+	{
+		TRACE_SCOPE("patch io","open library");
+		close();
+
+		mMapping = MappedFileData::open(file);
+		const uint8_t* data = mMapping != NULL ? mMapping->getData() : NULL;
+		const size_t size = mMapping != NULL ? mMapping->getSize() : 0;
+
+		if(data == NULL || size < PATCH_LIBRARY_HEADER_SIZE
+			|| readInt(data,0) != PATCH_LIBRARY_MAGIC
+			|| readInt(data,1) != PATCH_LIBRARY_VERSION
+			|| readInt(data,2) != NUM_PARAMS
+			|| readInt(data,4) != PATCH_DATA_SIZE)
+		{
+			close();
+			return false;
+		}
+
+		const int numPatches = (int)readInt(data,3);
+		const uint32 indexOffset = readInt(data,5);
+		if(indexOffset != PATCH_LIBRARY_HEADER_SIZE + (uint32)numPatches*PATCH_DATA_SIZE
+			|| (size_t)indexOffset + numPatches*4 > size)
+		{
+			close();
+			return false;
+		}
+
+		mRecords = data + PATCH_LIBRARY_HEADER_SIZE;
+		mIndex = data + indexOffset;
+		mNumPatches = numPatches;
+		mFile = file;
+		return true;
+	};
+
+	void close()
+	{
+		mMapping = NULL;
+		mRecords = NULL;
+		mIndex = NULL;
+		mNumPatches = 0;
+		mFile = File::nonexistent;
+		mUniquePatches.clear();
+	};
+
+	bool isOpen()
+	{
+		return mRecords != NULL;
+	};
+
+	/** for readers that have to outlive an open() or close()*/
+	MappedFileData::Ptr getMapping()
+	{
+		return mMapping;
+	};
+
+	const File& getFile()
+	{
+		return mFile;
+	};
+
+	int getNumPatches()
+	{
+		return mNumPatches;
+	};
+
+	/** the PATCH_DATA_SIZE bytes of a patch, pointing into the mapped file*/
+	const uint8_t* getPatchData(int index)
+	{
+		jassert(index >= 0 && index < mNumPatches);
+		return mRecords + index*PATCH_DATA_SIZE;
+	};
+
+	String getPatchName(int index)
+	{
+		return String((const char*)getPatchData(index),PATCH_NAME_LENGTH);
+	};
+
+	/** decode a patch into a new Patch object*/
+	Patch* createPatch(int index)
+	{
+		Patch* patch = new Patch();
+		PresetLoader::readPatchData(getPatchData(index),patch);
+		return patch;
+	};
+
+	/** returns the index of the first patch with the given name or -1*/
+	int findPatch(const String& name)
+	{
+		char key[PATCH_NAME_LENGTH];
+		makeKey(name,key);
+
+		//binary search in the name index
+		int start = 0;
+		int end = mNumPatches;
+		while(start < end)
+		{
+			const int mid = (start+end)/2;
+			if(memcmp(getPatchData(getIndexEntry(mid)),key,PATCH_NAME_LENGTH) < 0)	start = mid+1;
+			else																	end = mid;
+		}
+		if(start < mNumPatches && memcmp(getPatchData(getIndexEntry(start)),key,PATCH_NAME_LENGTH) == 0)
+		{
+			return getIndexEntry(start);
+		}
+		return -1;
+	};
+
+	/** the record number of the n-th patch in name order*/
+	int getIndexEntry(int n)
+	{
+		return (int)readInt(mIndex,n);
+	};
+
+	//-----------------------------------------------------------------------
+	/** write a library from PATCH_DATA_SIZE records stored back to back*/
+	static bool write(const File& file, const void* records, int numPatches)
+	{
+		PatchLibraryWriter writer(file);
+		for(int i=0;i<numPatches;i++)
+		{
+			writer.addPatch((const uint8_t*)records + i*PATCH_DATA_SIZE);
+		}
+		return writer.finish();
+	};
+
+	/** add records to the end of a library, or write a new one if there is none.
+		the records already in it keep their numbers*/
+	static bool append(const File& file, const void* records, int numPatches)
+	{
+		PatchLibraryWriter writer(file);
+		{
+			PatchLibrary existing;
+			if(existing.open(file))
+			{
+				for(int i=0;i<existing.getNumPatches();i++)
+				{
+					writer.addPatch(existing.getPatchData(i));
+				}
+			}
+		}
+		for(int i=0;i<numPatches;i++)
+		{
+			writer.addPatch((const uint8_t*)records + i*PATCH_DATA_SIZE);
+		}
+		return writer.finish();
+	};
+
+	/** the record numbers of the first copy of every distinct sound, for a browser
+		that shows duplicates only once*/
+	const Array<int>& getUniquePatches()
+	{
+		if(mUniquePatches.size() == 0 && mNumPatches > 0)
+		{
+			PatchHashSet seen(mNumPatches);
+			for(int i=0;i<mNumPatches;i++)
+			{
+				if(seen.add(getPatchData(i)+PATCH_NAME_LENGTH,i)) mUniquePatches.add(i);
+			}
+		}
+		return mUniquePatches;
+	};
+
+	/** pack loose .SND files into a library. files that can't be read or don't pass
+		the PatchImporter's checks and patches that sound like one already packed are skipped*/
+	static bool createFromFiles(const File& file, const Array<File>& patchFiles)
+	{
+		PatchImporter importer;
+		importer.setDedupe(true);
+		MemoryBlock records;
+		const int numPatches = importer.import(patchFiles,records);
+
+		PatchLibraryWriter writer(file);
+		for(int i=0;i<numPatches;i++)
+		{
+			writer.addPatch((const uint8_t*)records.getData() + i*PATCH_DATA_SIZE);
+		}
+		return writer.finish();
+	};
+
+	/** write every patch as a loose .SND file named after the patch. returns the number of written files*/
+	int exportToFolder(const File& folder)
+	{
+		return exportToFolder(folder,mRecords,mNumPatches);
+	};
+
+	/** the same for PATCH_DATA_SIZE records stored back to back*/
+	static int exportToFolder(const File& folder, const void* records, int numPatches)
+	{
+		if(!folder.createDirectory()) return 0;
+
+		int numWritten = 0;
+		for(int i=0;i<numPatches;i++)
+		{
+			const uint8_t* data = (const uint8_t*)records + i*PATCH_DATA_SIZE;
+			String name = File::createLegalFileName(String((const char*)data,PATCH_NAME_LENGTH).trim());
+			if(name.isEmpty()) name = "PATCH";
+
+			const File target = folder.getNonexistentChildFile(name,".SND",false);
+			if(target.replaceWithData(data,PATCH_DATA_SIZE))
+			{
+				numWritten++;
+			}
+		}
+		return numWritten;
+	};
+
+private:
+	/** names are stored zero padded to PATCH_NAME_LENGTH bytes*/
+	static void makeKey(const String& name, char* key)
+	{
+		memset(key,0,PATCH_NAME_LENGTH);
+		memcpy(key,name.toUTF8(),jmin(PATCH_NAME_LENGTH,(int)strlen(name.toUTF8())));
+	};
+
+	static uint32 readInt(const uint8_t* data, int index)
+	{
+		return ByteOrder::littleEndianInt(data + index*4);
+	};
+
+private:
+	MappedFileData::Ptr mMapping;
+	File mFile;
+	const uint8_t* mRecords;
+	const uint8_t* mIndex;
+	int mNumPatches;
+	Array<int> mUniquePatches;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,361 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PresetLoader.h"
+
+#define PATCH_LINEAGE_MAGIC		0x4e4c5053	// "SPLN" little endian
+#define PATCH_LINEAGE_VERSION	1
+#define PATCH_LINEAGE_EXTENSION	".spl"
+
+#define PARAMETER_MASK_SIZE		((NUM_PARAMS+7)/8)
+#define NO_PARENT				-1
+
+//---------------------------------------------------------------------------
+/** How a child differs from its parents: which values came from the mother
+	(the rest came from the father) and which values were mutated afterwards.
+*/
+class PatchDelta
+{
+public:
+	PatchDelta()
+	{
+		clear();
+	};
+
+	void clear()
+	{
+		memset(mMotherMask,0,PARAMETER_MASK_SIZE);
+		memset(mMutationMask,0,PARAMETER_MASK_SIZE);
+	};
+
+	void setFromMother(int parameterNr)
+	{
+		mMotherMask[parameterNr>>3] |= (1<<(parameterNr&7));
+	};
+
+	/** takes the mother bits of a whole crossover at once*/
+	void setMotherMask(const uint8_t* mask)
+	{
+		memcpy(mMotherMask,mask,PARAMETER_MASK_SIZE);
+	};
+
+	void setMutation(int parameterNr, int value)
+	{
+		mMutationMask[parameterNr>>3] |= (1<<(parameterNr&7));
+		mMutatedValues[parameterNr] = (uint8_t)value;
+	};
+
+	bool isFromMother(int parameterNr) const
+	{
+		return (mMotherMask[parameterNr>>3] & (1<<(parameterNr&7))) != 0;
+	};
+
+	bool isMutated(int parameterNr) const
+	{
+		return (mMutationMask[parameterNr>>3] & (1<<(parameterNr&7))) != 0;
+	};
+
+	int getMutatedValue(int parameterNr) const
+	{
+		jassert(isMutated(parameterNr));
+		return mMutatedValues[parameterNr];
+	};
+
+	/** rebuild the child values from the parent values*/
+	void apply(const uint8_t* father, const uint8_t* mother, uint8_t* child) const
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(isMutated(i))			child[i] = mMutatedValues[i];
+			else if(isFromMother(i))	child[i] = mother[i];
+			else						child[i] = father[i];
+		}
+	};
+
+private:
+	friend class PatchLineage;
+
+	uint8_t mMotherMask[PARAMETER_MASK_SIZE];
+	uint8_t mMutationMask[PARAMETER_MASK_SIZE];
+	uint8_t mMutatedValues[NUM_PARAMS];	// only valid where the mutation bit is set
+};
+//---------------------------------------------------------------------------
+/** A family tree of patches. Roots are stored with all their values, children
+	only as parent ids, a crossover mask and their mutated values, so a
+	generation costs a fraction of the .SND files it stands for. Full values are
+	rebuilt on demand with getValues().
+
+	File layout (numbers are 32 bit little endian):
+	header	magic, version, NUM_PARAMS, number of entries
+	entry	father id (NO_PARENT for a root), mother id, generation, 8 byte name,
+			root:  NUM_PARAMS values
+			child: PARAMETER_MASK_SIZE mother mask, PARAMETER_MASK_SIZE mutation mask,
+			       one byte for every set bit of the mutation mask
+*/
+class PatchLineage
+{
+public:
+	PatchLineage()
+	{
+	};
+
+	~PatchLineage()
+	{
+	};
+
+	/** add a patch without known parents, returns its id*/
+	int addRoot(Patch* patch)
+	{
+		Entry* entry = createEntry(NO_PARENT,NO_PARENT,patch);
+		entry->data.append(patch->getValues(),NUM_PARAMS);
+		mEntries.add(entry);
+		return mEntries.size()-1;
+	};
+
+	/** add a child of two existing entries, returns its id*/
+	int addChild(int fatherId, int motherId, Patch* child, const PatchDelta& delta)
+	{
+		jassert(fatherId >= 0 && fatherId < mEntries.size());
+		jassert(motherId >= 0 && motherId < mEntries.size());
+
+		Entry* entry = createEntry(fatherId,motherId,child);
+		entry->data.append(delta.mMotherMask,PARAMETER_MASK_SIZE);
+		entry->data.append(delta.mMutationMask,PARAMETER_MASK_SIZE);
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(delta.isMutated(i)) entry->data.append(&delta.mMutatedValues[i],1);
+		}
+		mEntries.add(entry);
+		return mEntries.size()-1;
+	};
+
+	void clear()
+	{
+		mEntries.clear();
+	};
+
+	int getNumEntries()
+	{
+		return mEntries.size();
+	};
+
+	bool isRoot(int id)
+	{
+		return mEntries[id]->father == NO_PARENT;
+	};
+
+	int getFather(int id)
+	{
+		return mEntries[id]->father;
+	};
+
+	int getMother(int id)
+	{
+		return mEntries[id]->mother;
+	};
+
+	int getGeneration(int id)
+	{
+		return mEntries[id]->generation;
+	};
+
+	const ShortString getName(int id)
+	{
+		return ShortString((const char*)mEntries[id]->name,PATCH_NAME_LENGTH);
+	};
+
+	/** the delta of a child entry*/
+	void getDelta(int id, PatchDelta& delta)
+	{
+		const Entry* entry = mEntries[id];
+		jassert(entry->father != NO_PARENT);
+
+		const uint8_t* data = (const uint8_t*)entry->data.getData();
+		delta.clear();
+		memcpy(delta.mMotherMask,data,PARAMETER_MASK_SIZE);
+		memcpy(delta.mMutationMask,data+PARAMETER_MASK_SIZE,PARAMETER_MASK_SIZE);
+
+		const uint8_t* value = data + 2*PARAMETER_MASK_SIZE;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(delta.isMutated(i)) delta.mMutatedValues[i] = *value++;
+		}
+	};
+
+	/** rebuild the NUM_PARAMS values of an entry from its ancestors.
+		rebuilt values are kept, so shared ancestors are only rebuilt once*/
+	void getValues(int id, uint8_t* values)
+	{
+		memcpy(values,getReconstructedValues(id),NUM_PARAMS);
+	};
+
+	Patch* createPatch(int id)
+	{
+		Patch* patch = new Patch();
+		uint8_t values[NUM_PARAMS];
+		getValues(id,values);
+		patch->setValues(values);
+		patch->setName(getName(id));
+		patch->setGeneration(getGeneration(id));
+		return patch;
+	};
+
+	bool save(const File& file)
+	{
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->writeInt(PATCH_LINEAGE_MAGIC);
+			out->writeInt(PATCH_LINEAGE_VERSION);
+			out->writeInt(NUM_PARAMS);
+			out->writeInt(mEntries.size());
+			for(int i=0;i<mEntries.size();i++)
+			{
+				const Entry* entry = mEntries[i];
+				out->writeInt(entry->father);
+				out->writeInt(entry->mother);
+				out->writeInt(entry->generation);
+				out->write(entry->name,PATCH_NAME_LENGTH);
+				out->write(entry->data.getData(),(int)entry->data.getSize());
+			}
+
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** returns false if the file is missing or invalid, the lineage is empty then*/
+	bool load(const File& file)
+	{
+		clear();
+
+		FileInputStream in(file);
+		if(in.getStatus().failed()) return false;
+
+		if(in.readInt() != PATCH_LINEAGE_MAGIC || in.readInt() != PATCH_LINEAGE_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
+
+		const int numEntries = in.readInt();
+		for(int i=0;i<numEntries;i++)
+		{
+			ScopedPointer<Entry> entry(new Entry());
+			entry->father = in.readInt();
+			entry->mother = in.readInt();
+			entry->generation = in.readInt();
+			if(in.read(entry->name,PATCH_NAME_LENGTH) != PATCH_NAME_LENGTH) break;
+
+			if(entry->father == NO_PARENT)
+			{
+				if(!readData(in,entry->data,NUM_PARAMS)) break;
+			}
+			else
+			{
+				if(entry->father < 0 || entry->father >= i || entry->mother < 0 || entry->mother >= i) break;
+				if(!readData(in,entry->data,2*PARAMETER_MASK_SIZE)) break;
+
+				//one value per mutation bit
+				int numMutations = 0;
+				const uint8_t* mutationMask = (const uint8_t*)entry->data.getData() + PARAMETER_MASK_SIZE;
+				for(int bit=0;bit<NUM_PARAMS;bit++)
+				{
+					if(mutationMask[bit>>3] & (1<<(bit&7))) numMutations++;
+				}
+				if(!readData(in,entry->data,numMutations)) break;
+			}
+			mEntries.add(entry.release());
+		}
+
+		if(mEntries.size() != numEntries)
+		{
+			clear();
+			return false;
+		}
+		return true;
+	};
+
+private:
+	struct Entry
+	{
+		int father;
+		int mother;
+		int generation;
+		uint8_t name[PATCH_NAME_LENGTH];
+		MemoryBlock data;	// values of a root, delta of a child
+		MemoryBlock values;	// rebuilt values of a child, empty until needed
+	};
+
+	Entry* createEntry(int father, int mother, Patch* patch)
+	{
+		Entry* entry = new Entry();
+		entry->father = father;
+		entry->mother = mother;
+		entry->generation = patch->getGeneration();
+
+		//the length of a ShortString counts the UTF-8 bytes, not the characters
+		const ShortString name(patch->getShortName());
+		memset(entry->name,0,PATCH_NAME_LENGTH);
+		memcpy(entry->name,name.getText(),jmin(PATCH_NAME_LENGTH,name.length()));
+		return entry;
+	};
+
+	const uint8_t* getReconstructedValues(int id)
+	{
+		Entry* entry = mEntries[id];
+		if(entry->father == NO_PARENT)
+		{
+			return (const uint8_t*)entry->data.getData();
+		}
+		if(entry->values.getSize() == 0)
+		{
+			//parents always have smaller ids, so this ends at the roots
+			jassert(entry->father < id && entry->mother < id);
+
+			PatchDelta delta;
+			getDelta(id,delta);
+			entry->values.setSize(NUM_PARAMS);
+			delta.apply(getReconstructedValues(entry->father),getReconstructedValues(entry->mother),(uint8_t*)entry->values.getData());
+		}
+		return (const uint8_t*)entry->values.getData();
+	};
+
+	/** append numBytes from the stream*/
+	static bool readData(InputStream& in, MemoryBlock& data, int numBytes)
+	{
+		const size_t oldSize = data.getSize();
+		data.setSize(oldSize+numBytes);
+		return in.read((uint8_t*)data.getData()+oldSize,numBytes) == numBytes;
+	};
+
+private:
+	OwnedArray<Entry> mEntries;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,671 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Patch.h"
+#include "../parameterRanges.h"
+#include "../controllerAssignments.h"
+#include "PatchLibrary.h"
+#include "MappedFileData.h"
+#include "SharedCache.h"
+
+#define QUERY_MAX_COLUMNS		32		// sorted parameter columns kept, 4 bytes per patch each
+#define QUERY_NUM_VALUES		256		// a stored value is a byte
+#define QUERY_PM_OFFSET			63		// what signed values are stored with, like the plugin shows them
+#define QUERY_AMBIGUOUS			-2		// a parameter name found on more than one voice
+#define QUERY_CACHE_VERSION		1		// of the shared name and column segments
+
+//---------------------------------------------------------------------------
+/** A search of a PatchLibrary: value ranges of parameters and a patch name
+	or name prefix, all of which have to match.
+
+	parse() reads the short form the patch browser takes, terms joined
+	with "and" and an optional "on voice n" for the whole query:
+
+		decay > 90 and filter type = HP on voice 4
+		name = kick* and p8 <= 40
+
+	A parameter is named like the synth's menu shows it ("decay", or
+	"filter type" to tell it from other parameters of that name), or given
+	by number as p8. Values are in the units of the editor, menu entries
+	by their text, switches as on and off. Names compare case insensitive,
+	a trailing * matches a prefix.
+*/
+class PatchQuery
+{
+public:
+	struct Range
+	{
+		int parameterNr;
+		int min;	// stored values, inclusive
+		int max;
+	};
+
+	PatchQuery()
+	{
+		clear();
+	};
+
+	void clear()
+	{
+		mRanges.clear();
+		mHasName = false;
+		mNameMin = mNameMax = 0;
+	};
+
+	/** a parameter that is in the range more than once has to be in all of them*/
+	void addRange(int parameterNr, int min, int max)
+	{
+		for(int i=0;i<mRanges.size();i++)
+		{
+			Range& range = mRanges.getReference(i);
+			if(range.parameterNr != parameterNr) continue;
+			range.min = jmax(range.min,min);
+			range.max = jmin(range.max,max);
+			return;
+		}
+		Range range;
+		range.parameterNr = parameterNr;
+		range.min = min;
+		range.max = max;
+		mRanges.add(range);
+	};
+
+	/** the whole name, or every name starting with it*/
+	void setName(const String& name, bool prefix)
+	{
+		char key[PATCH_NAME_LENGTH+1];
+		memset(key,0,PATCH_NAME_LENGTH+1);
+		name.copyToUTF8(key,PATCH_NAME_LENGTH+1);
+		const int length = (int)strlen(key);
+
+		mNameMin = makeNameKey((const uint8*)key);
+		if(prefix) memset(key+length,0xff,PATCH_NAME_LENGTH-length);
+		mNameMax = makeNameKey((const uint8*)key);
+		mHasName = true;
+	};
+
+	int getNumRanges() const							{ return mRanges.size(); };
+	const Range& getRange(int index) const				{ return mRanges.getReference(index); };
+	bool hasName() const								{ return mHasName; };
+	bool matchesName(uint64 key) const					{ return key >= mNameMin && key <= mNameMax; };
+	uint64 getNameMin() const							{ return mNameMin; };
+	uint64 getNameMax() const							{ return mNameMax; };
+
+	/** the 8 name bytes of a record, lower case, as one number that sorts like the name*/
+	static uint64 makeNameKey(const uint8* name)
+	{
+		uint64 key = 0;
+		for(int i=0;i<PATCH_NAME_LENGTH;i++)
+		{
+			uint8 c = name[i];
+			if(c >= 'A' && c <= 'Z') c = (uint8)(c - 'A' + 'a');
+			key = (key << 8) | c;
+		}
+		return key;
+	};
+
+	/** returns false and says why if the text can't be read, the query is then empty*/
+	static bool parse(const String& text, PatchQuery& query, String& error)
+	{
+		query.clear();
+		String terms = text.trim();
+
+		//"on voice n" holds for all the parameters
+		int voiceNr = -1;
+		const int voiceStart = terms.indexOfIgnoreCase("on voice");
+		if(voiceStart >= 0)
+		{
+			voiceNr = terms.substring(voiceStart+8).trim().getIntValue() - 1;
+			terms = terms.substring(0,voiceStart).trim();
+			if(voiceNr < 0 || voiceNr >= NUM_VOICES)
+			{
+				error = "there is no such voice";
+				return false;
+			}
+		}
+
+		while(terms.isNotEmpty())
+		{
+			const int end = terms.indexOfIgnoreCase(" and ");
+			const String term = end >= 0 ? terms.substring(0,end).trim() : terms;
+			terms = end >= 0 ? terms.substring(end+5).trim() : String::empty;
+			if(!parseTerm(term,voiceNr,query,error))
+			{
+				query.clear();
+				return false;
+			}
+		}
+		return true;
+	};
+
+	/** a parameter as a query names it, with an optional "on voice n". returns -1 and says why if there is none*/
+	static int parseParameter(const String& text, String& error)
+	{
+		String name = text.trim();
+		int voiceNr = -1;
+		const int voiceStart = name.indexOfIgnoreCase("on voice");
+		if(voiceStart >= 0)
+		{
+			voiceNr = name.substring(voiceStart+8).trim().getIntValue() - 1;
+			name = name.substring(0,voiceStart).trim();
+			if(voiceNr < 0 || voiceNr >= NUM_VOICES)
+			{
+				error = "there is no such voice";
+				return -1;
+			}
+		}
+
+		const int parameterNr = findParameter(name,voiceNr);
+		if(parameterNr == QUERY_AMBIGUOUS)
+		{
+			error = "\"" + name + "\" is on several voices, add on voice n";
+			return -1;
+		}
+		if(parameterNr < 0)
+		{
+			error = "no parameter \"" + name + "\"" + (voiceNr < 0 ? String::empty : " on voice " + String(voiceNr+1));
+			return -1;
+		}
+		return parameterNr;
+	};
+
+private:
+	static bool parseTerm(const String& term, int voiceNr, PatchQuery& query, String& error)
+	{
+		const char* const operators[] = { ">=", "<=", "=", "<", ">" };
+		int op = -1;
+		int opStart = -1;
+		for(int i=0;i<5 && op < 0;i++)
+		{
+			opStart = term.indexOf(operators[i]);
+			if(opStart >= 0) op = i;
+		}
+		if(op < 0)
+		{
+			error = "no comparison in \"" + term + "\"";
+			return false;
+		}
+		const String left = term.substring(0,opStart).trim();
+		const String right = term.substring(opStart + (int)strlen(operators[op])).trim();
+
+		if(left.equalsIgnoreCase("name"))
+		{
+			if(op != 2 || right.isEmpty())
+			{
+				error = "names can only be compared with =";
+				return false;
+			}
+			const bool prefix = right.endsWithChar('*');
+			query.setName(prefix ? right.dropLastCharacters(1) : right,prefix);
+			return true;
+		}
+
+		const int parameterNr = findParameter(left,voiceNr);
+		if(parameterNr == QUERY_AMBIGUOUS)
+		{
+			error = "\"" + left + "\" is on several voices, add on voice n";
+			return false;
+		}
+		if(parameterNr < 0)
+		{
+			error = "no parameter \"" + left + "\"" + (voiceNr < 0 ? String::empty : " on voice " + String(voiceNr+1));
+			return false;
+		}
+		const int value = findValue(parameterNr,right);
+		if(value < 0)
+		{
+			error = "\"" + right + "\" is not a value of " + left;
+			return false;
+		}
+
+		switch(op)
+		{
+		case 0: query.addRange(parameterNr,value,QUERY_NUM_VALUES-1);	break;
+		case 1: query.addRange(parameterNr,0,value);					break;
+		case 2: query.addRange(parameterNr,value,value);				break;
+		case 3: query.addRange(parameterNr,0,value-1);					break;
+		case 4: query.addRange(parameterNr,value+1,QUERY_NUM_VALUES-1);	break;
+		}
+		return true;
+	};
+
+	/** -1 if the voice has no parameter of that name. without a voice the name has to be on one voice only,
+		QUERY_AMBIGUOUS otherwise*/
+	static int findParameter(const String& name, int voiceNr)
+	{
+		//p8 or 8
+		const String number = name.startsWithIgnoreCase("p") ? name.substring(1) : name;
+		if(number.isNotEmpty() && number.containsOnly("0123456789"))
+		{
+			const int parameterNr = number.getIntValue();
+			return parameterNr < NUM_PARAMS ? parameterNr : -1;
+		}
+
+		int found = -1;
+		for(int voice=0;voice<NUM_VOICES;voice++)
+		{
+			if(voiceNr >= 0 && voice != voiceNr) continue;
+
+			const int parameterNr = findParameterOnPage(name,voice);
+			if(parameterNr < 0) continue;
+			if(found >= 0 && found != parameterNr) return QUERY_AMBIGUOUS;
+			found = parameterNr;
+		}
+		return found;
+	};
+
+	/** the first parameter on the menu pages of a voice with that long name, or category and long name*/
+	static int findParameterOnPage(const String& name, int page)
+	{
+		for(int subPage=0;subPage<NUM_SUB_PAGES;subPage++)
+		{
+			const Page& menu = menuPages[page][subPage];
+			for(int i=0;i<8;i++)
+			{
+				const uint8_t text = *(&menu.top1 + i);
+				if(text == TEXT_EMPTY) continue;
+
+				const String longName(longNames[valueNames[text].longName]);
+				const String fullName = String(catNames[valueNames[text].category]) + " " + longName;
+				if(name.equalsIgnoreCase(longName) || name.equalsIgnoreCase(fullName)) return *(&menu.bot1 + i);
+			}
+		}
+		return -1;
+	};
+
+	/** the stored value, or -1*/
+	static int findValue(int parameterNr, const String& text)
+	{
+		if(text.isEmpty()) return -1;
+		if(text.containsOnly("-0123456789"))
+		{
+			const ParameterRange& range = getParameterRange(parameterNr);
+			const int value = text.getIntValue() + (range.min < 0 ? QUERY_PM_OFFSET : 0);
+			return (value >= 0 && value < QUERY_NUM_VALUES) ? value : -1;
+		}
+
+		const int dtype = Patch::getDtype(parameterNr);
+		if((dtype & 0x0f) == DTYPE_ON_OFF)
+		{
+			if(text.equalsIgnoreCase("on")) return 1;
+			if(text.equalsIgnoreCase("off")) return 0;
+			return -1;
+		}
+		switch(dtype>>4)
+		{
+		case MENU_AUDIO_OUT:	return findMenuEntry(outputNames,text);
+		case MENU_FILTER:		return findMenuEntry(filterTypes,text);
+		case MENU_WAVEFORM:		return findMenuEntry(waveformNames,text);
+		case MENU_SYNC_RATES:	return findMenuEntry(syncRateNames,text);
+		case MENU_LFO_WAVES:	return findMenuEntry(lfoWaveNames,text);
+		case MENU_RETRIGGER:	return findMenuEntry(retriggerNames,text);
+		case MENU_SEQ_QUANT:	return findMenuEntry(quantisationNames,text);
+		case MENU_NEXT_PATTERN:	return findMenuEntry(nextPatternNames,text);
+		case MENU_ROLL_RATES:	return findMenuEntry(rollRateNames,text);
+		}
+		return -1;
+	};
+
+	/** the first byte of a menu text array is its number of entries, the value of entry i is i-1*/
+	template <int N>
+	static int findMenuEntry(const char names[][N], const String& text)
+	{
+		for(int i=1;i<=(int)names[0][0];i++)
+		{
+			if(text.equalsIgnoreCase(names[i])) return i-1;
+		}
+		return -1;
+	};
+
+	Array<Range> mRanges;
+	bool mHasName;
+	uint64 mNameMin;
+	uint64 mNameMax;
+};
+//---------------------------------------------------------------------------
+/** Answers PatchQuerys over a PatchLibrary without opening a single patch.
+
+	The names are kept as sorted keys, so a name or prefix is a binary
+	search. A parameter gets a column of the record numbers sorted by
+	value (a counting sort, the values are bytes) the first time a query
+	asks for it, with the start of every value in it. A range is then a
+	slice of the column. The QUERY_MAX_COLUMNS most recently used columns
+	are kept.
+
+	The sorted names and the columns only depend on the library file, so
+	they are SharedCache segments: every editor instance that opens the
+	same library maps the copy the first one built.
+
+	A query walks the smallest slice and checks the other terms on the
+	mapped records of its candidates, so its time depends on how selective
+	the best term is, not on the size of the library.
+*/
+class PatchQueryIndex
+{
+public:
+	PatchQueryIndex() : mRecords(NULL), mNumPatches(0), mNameKeys(NULL), mNameRecords(NULL), mUseCount(0)
+	{
+	};
+
+	/** sorts the names, or maps them if another instance already did. the index holds a
+		reference to the mapping, the library may be closed*/
+	void setLibrary(PatchLibrary& library)
+	{
+		TRACE_SCOPE("patch io","index library names");
+		clear();
+		mMapping = library.getMapping();
+		if(mMapping == NULL) return;
+		mRecords = mMapping->getData() + PATCH_LIBRARY_HEADER_SIZE;
+		mNumPatches = library.getNumPatches();
+		mFile = library.getFile();
+
+		NameBuilder builder(mRecords,mNumPatches);
+		mNames = SharedCache::open(SharedCache::makeFileName("names",mFile),getCacheKey(),builder);
+		//a segment of the wrong size can only be a damaged file, the private copy is used then
+		if(mNames == NULL || mNames->getSize() != (size_t)mNumPatches*(sizeof(uint64)+sizeof(int)))
+		{
+			MemoryOutputStream payload;
+			builder.buildSegment(payload);
+			mNames = new SharedCache::Segment(payload);
+		}
+		mNameKeys = (const uint64*)mNames->getData();
+		mNameRecords = (const int*)(mNames->getData() + mNumPatches*sizeof(uint64));
+	};
+
+	void clear()
+	{
+		mColumns.clear();
+		mNames = NULL;
+		mNameKeys = NULL;
+		mNameRecords = NULL;
+		mMapping = NULL;
+		mRecords = NULL;
+		mNumPatches = 0;
+		mFile = File::nonexistent;
+	};
+
+	/** true if the names come from a segment other instances share*/
+	bool isShared() const
+	{
+		return mNames != NULL && mNames->isShared();
+	};
+
+	int getNumPatches() const
+	{
+		return mNumPatches;
+	};
+
+	/** the record numbers of the matching patches in file order. returns how many there are*/
+	int find(const PatchQuery& query, Array<int>& results)
+	{
+		TRACE_SCOPE("patch io","library query");
+		results.clearQuick();
+		if(mNumPatches == 0) return 0;
+
+		//the term with the fewest candidates is walked, -1 for the name
+		int best = -2;
+		int bestCount = mNumPatches;
+		const int* candidates = NULL;
+		int nameStart = 0;
+		int nameEnd = mNumPatches;
+		if(query.hasName())
+		{
+			nameStart = lowerBound(query.getNameMin());
+			nameEnd = upperBound(query.getNameMax());
+			best = -1;
+			bestCount = jmax(0,nameEnd-nameStart);
+			candidates = mNameRecords + nameStart;
+		}
+		for(int i=0;i<query.getNumRanges();i++)
+		{
+			const PatchQuery::Range& range = query.getRange(i);
+			if(range.min > range.max) return 0;
+
+			const Column* column = getColumn(range.parameterNr);
+			const int count = column->offsets[range.max+1] - column->offsets[range.min];
+			if(count < bestCount)
+			{
+				best = i;
+				bestCount = count;
+				candidates = column->records + column->offsets[range.min];
+			}
+		}
+
+		results.ensureStorageAllocated(bestCount);
+		if(best == -2)
+		{
+			//nothing to narrow it down
+			for(int r=0;r<mNumPatches;r++) results.add(r);
+			return mNumPatches;
+		}
+
+		//the columns stay while the query runs, there are fewer terms than QUERY_MAX_COLUMNS
+		for(int i=0;i<bestCount;i++)
+		{
+			if(matches(query,candidates[i],best)) results.add(candidates[i]);
+		}
+
+		//a slice is in file order within each value only
+		DefaultElementComparator<int> comparator;
+		results.sort(comparator);
+		return results.size();
+	};
+
+private:
+	struct Column
+	{
+		int parameterNr;
+		uint32 lastUse;
+		SharedCache::Segment::Ptr segment;
+		const int* offsets;		// QUERY_NUM_VALUES+1, where each value starts in records
+		const int* records;		// sorted by value, file order within a value
+	};
+
+	/** the name keys in order, then the record of each key*/
+	class NameBuilder : public SharedCache::Builder
+	{
+	public:
+		NameBuilder(const uint8_t* records, int numPatches) : mRecords(records), mNumPatches(numPatches) {};
+
+		bool buildSegment(OutputStream& out)
+		{
+			HeapBlock<uint64> keys(jmax(1,mNumPatches));
+			Array<int> order;
+			order.ensureStorageAllocated(mNumPatches);
+			for(int i=0;i<mNumPatches;i++)
+			{
+				keys[i] = PatchQuery::makeNameKey(mRecords + i*PATCH_DATA_SIZE);
+				order.add(i);
+			}
+			KeyComparator comparator(keys);
+			order.sort(comparator,false);
+
+			HeapBlock<uint64> sortedKeys(jmax(1,mNumPatches));
+			for(int i=0;i<mNumPatches;i++)
+			{
+				sortedKeys[i] = keys[order[i]];
+			}
+			return out.write(sortedKeys,mNumPatches*(int)sizeof(uint64))
+				&& out.write(order.getRawDataPointer(),mNumPatches*(int)sizeof(int));
+		};
+
+	private:
+		const uint8_t* mRecords;
+		int mNumPatches;
+	};
+
+	/** the offsets of every value, then the records sorted by value (a counting sort)*/
+	class ColumnBuilder : public SharedCache::Builder
+	{
+	public:
+		ColumnBuilder(const uint8_t* records, int numPatches, int parameterNr) : mRecords(records), mNumPatches(numPatches), mParameterNr(parameterNr) {};
+
+		bool buildSegment(OutputStream& out)
+		{
+			int offsets[QUERY_NUM_VALUES+1];
+			memset(offsets,0,sizeof(offsets));
+			const uint8_t* values = mRecords + PATCH_NAME_LENGTH + mParameterNr;
+			for(int r=0;r<mNumPatches;r++)
+			{
+				offsets[values[r*PATCH_DATA_SIZE]+1]++;
+			}
+			for(int v=0;v<QUERY_NUM_VALUES;v++)
+			{
+				offsets[v+1] += offsets[v];
+			}
+			int next[QUERY_NUM_VALUES];
+			memcpy(next,offsets,sizeof(next));
+			HeapBlock<int> sorted(jmax(1,mNumPatches));
+			for(int r=0;r<mNumPatches;r++)
+			{
+				sorted[next[values[r*PATCH_DATA_SIZE]]++] = r;
+			}
+			return out.write(offsets,(int)sizeof(offsets)) && out.write(sorted,mNumPatches*(int)sizeof(int));
+		};
+
+	private:
+		const uint8_t* mRecords;
+		int mNumPatches;
+		int mParameterNr;
+	};
+
+	class KeyComparator
+	{
+	public:
+		KeyComparator(const uint64* keys) : mKeys(keys) {};
+
+		int compareElements(int first, int second) const
+		{
+			if(mKeys[first] < mKeys[second]) return -1;
+			if(mKeys[first] > mKeys[second]) return 1;
+			return first - second;
+		};
+
+	private:
+		const uint64* mKeys;
+	};
+
+	/** the other terms than the walked one on the record itself*/
+	bool matches(const PatchQuery& query, int record, int skipped) const
+	{
+		const uint8_t* data = mRecords + record*PATCH_DATA_SIZE;
+		if(skipped != -1 && query.hasName() && !query.matchesName(PatchQuery::makeNameKey(data))) return false;
+
+		const uint8_t* values = data + PATCH_NAME_LENGTH;
+		for(int i=0;i<query.getNumRanges();i++)
+		{
+			if(i == skipped) continue;
+			const PatchQuery::Range& range = query.getRange(i);
+			const int value = values[range.parameterNr];
+			if(value < range.min || value > range.max) return false;
+		}
+		return true;
+	};
+
+	int64 getCacheKey() const
+	{
+		return SharedCache::makeFileKey(mFile,QUERY_CACHE_VERSION);
+	};
+
+	/** sorts (or maps) a parameter column on first use, dropping the least recently used one if there are too many*/
+	Column* getColumn(int parameterNr)
+	{
+		mUseCount++;
+		int oldest = 0;
+		for(int i=0;i<mColumns.size();i++)
+		{
+			if(mColumns[i]->parameterNr == parameterNr)
+			{
+				mColumns[i]->lastUse = mUseCount;
+				return mColumns[i];
+			}
+			if(mColumns[i]->lastUse < mColumns[oldest]->lastUse) oldest = i;
+		}
+		if(mColumns.size() >= QUERY_MAX_COLUMNS) mColumns.remove(oldest);
+
+		Column* column = new Column();
+		column->parameterNr = parameterNr;
+		column->lastUse = mUseCount;
+
+		ColumnBuilder builder(mRecords,mNumPatches,parameterNr);
+		column->segment = SharedCache::open(SharedCache::makeFileName("p" + String(parameterNr),mFile),getCacheKey(),builder);
+		//a segment of the wrong size can only be a damaged file, the private copy is used then
+		const size_t size = ((QUERY_NUM_VALUES+1) + mNumPatches)*sizeof(int);
+		if(column->segment == NULL || column->segment->getSize() != size)
+		{
+			MemoryOutputStream payload;
+			builder.buildSegment(payload);
+			column->segment = new SharedCache::Segment(payload);
+		}
+		column->offsets = (const int*)column->segment->getData();
+		column->records = column->offsets + QUERY_NUM_VALUES+1;
+
+		mColumns.add(column);
+		return column;
+	};
+
+	/** the first name key >= key*/
+	int lowerBound(uint64 key) const
+	{
+		int start = 0;
+		int end = mNumPatches;
+		while(start < end)
+		{
+			const int middle = (start+end)/2;
+			if(mNameKeys[middle] < key)	start = middle+1;
+			else						end = middle;
+		}
+		return start;
+	};
+
+	/** the first name key > key*/
+	int upperBound(uint64 key) const
+	{
+		int start = 0;
+		int end = mNumPatches;
+		while(start < end)
+		{
+			const int middle = (start+end)/2;
+			if(mNameKeys[middle] <= key)	start = middle+1;
+			else							end = middle;
+		}
+		return start;
+	};
+
+	MappedFileData::Ptr mMapping;
+	const uint8_t* mRecords;
+	int mNumPatches;
+	File mFile;						// of the library, names the shared segments
+
+	SharedCache::Segment::Ptr mNames;
+	const uint64* mNameKeys;		// sorted
+	const int* mNameRecords;		// the record of each key
+
+	OwnedArray<Column> mColumns;
+	uint32 mUseCount;
+};
+//---------------------------------------------------------------------------
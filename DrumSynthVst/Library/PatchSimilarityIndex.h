@@ -0,0 +1,202 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PatchVpTree.h"
+#include "./PatchLibrary.h"
+
+#define PATCH_SIMILARITY_MAGIC		0x4e535053	// "SPSN" little endian
+#define PATCH_SIMILARITY_VERSION	1
+#define PATCH_SIMILARITY_EXTENSION	".spn"
+#define PATCH_SIMILARITY_MIN_TAIL	1024	// unindexed patches that are always just scanned
+#define PATCH_SIMILARITY_TAIL_SHARE	8		// the tree is rebuilt when the tail grows past 1/8 of it
+#define PATCH_SIMILARITY_DEFAULT_K	50
+
+//---------------------------------------------------------------------------
+/** Finds the patches of a PatchLibrary that sound most like a given one.
+
+	The parameter values of the library records are indexed in place by a
+	PatchVpTree, a query only measures the distance to a small part of a
+	large library. The tree is saved next to the library, so it is built once
+	and not on every start.
+	Patches appended to the library after the tree was built are scanned
+	linearly, like the votes of the SurrogateModel. update() only builds the
+	tree again once that tail has grown past a share of the tree, so
+	importing one generation after another costs little.
+	The library records must not change while they are indexed, a checksum
+	of the indexed records tells a rewritten library from an appended one.
+*/
+class PatchSimilarityIndex
+{
+public:
+	PatchSimilarityIndex() : mNumIndexed(0), mChecksum(0)
+	{
+	};
+
+	~PatchSimilarityIndex()
+	{
+	};
+
+	void clear()
+	{
+		mTree.clear();
+		mNumIndexed = 0;
+		mChecksum = 0;
+	};
+
+	int getNumIndexed() const
+	{
+		return mNumIndexed;
+	};
+
+	/** returns false if the file is missing or invalid, the index is empty then*/
+	bool load(const File& file)
+	{
+		clear();
+
+		FileInputStream in(file);
+		if(in.getStatus().failed()) return false;
+
+		if(in.readInt() != PATCH_SIMILARITY_MAGIC || in.readInt() != PATCH_SIMILARITY_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
+		const int numIndexed = in.readInt();
+		const uint64 checksum = (uint64)in.readInt64();
+		if(numIndexed < 0 || !mTree.read(in, numIndexed, PATCH_DATA_SIZE))
+		{
+			clear();
+			return false;
+		}
+		mNumIndexed = numIndexed;
+		mChecksum = checksum;
+		return true;
+	};
+
+	bool save(const File& file) const
+	{
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->writeInt(PATCH_SIMILARITY_MAGIC);
+			out->writeInt(PATCH_SIMILARITY_VERSION);
+			out->writeInt(NUM_PARAMS);
+			out->writeInt(mNumIndexed);
+			out->writeInt64((int64)mChecksum);
+			mTree.write(*out);
+
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** brings the index in line with the library. returns true if the tree was built again and should be saved*/
+	bool update(PatchLibrary& library)
+	{
+		const int numPatches = library.getNumPatches();
+		const bool appended = mNumIndexed <= numPatches && getChecksum(library, mNumIndexed) == mChecksum;
+
+		const int tail = numPatches - mNumIndexed;
+		if(appended && tail <= jmax(PATCH_SIMILARITY_MIN_TAIL, mNumIndexed/PATCH_SIMILARITY_TAIL_SHARE))
+		{
+			return false;
+		}
+
+		clear();
+		if(numPatches > 0)
+		{
+			mTree.build(getValues(library), numPatches, PATCH_DATA_SIZE);
+		}
+		mNumIndexed = numPatches;
+		mChecksum = getChecksum(library, numPatches);
+		return true;
+	};
+
+	/** the k patches closest to the values, closest first. patches with exactly the same values are left out*/
+	void findSimilar(PatchLibrary& library, const uint8_t* values, Array<int>& results, int k = PATCH_SIMILARITY_DEFAULT_K) const
+	{
+		//one more, the query itself is usually in the library
+		KNearest neighbours(k+1);
+		const uint8_t* data = getValues(library);
+		if(data == NULL) return;
+
+		mTree.search(data, values, neighbours);
+		for(int i=mNumIndexed;i<library.getNumPatches();i++)
+		{
+			neighbours.add(i, PatchDistance::l1(values, data + i*PATCH_DATA_SIZE));
+		}
+
+		for(int i=0;i<neighbours.size() && results.size()<k;i++)
+		{
+			if(neighbours.getDistance(i) > 0) results.add(neighbours.getSample(i));
+		}
+	};
+
+	/** where the index of a library is kept*/
+	static File getIndexFile(const File& libraryFile)
+	{
+		return libraryFile.withFileExtension(PATCH_SIMILARITY_EXTENSION);
+	};
+
+	/** load, update and save the index of a library file in one go*/
+	static bool updateIndexFile(const File& libraryFile)
+	{
+		PatchLibrary library;
+		if(!library.open(libraryFile)) return false;
+
+		const File indexFile = getIndexFile(libraryFile);
+		PatchSimilarityIndex index;
+		index.load(indexFile);
+		return !index.update(library) || index.save(indexFile);
+	};
+
+private:
+	/** the values of the first record, the rows are PATCH_DATA_SIZE apart*/
+	static const uint8_t* getValues(PatchLibrary& library)
+	{
+		if(library.getNumPatches() == 0) return NULL;
+		return library.getPatchData(0) + PATCH_NAME_LENGTH;
+	};
+
+	/** of the values of the first numPatches records*/
+	static uint64 getChecksum(PatchLibrary& library, int numPatches)
+	{
+		uint64 checksum = (uint64)numPatches;
+		for(int i=0;i<numPatches;i++)
+		{
+			checksum = checksum*literal64bit(0x100000001b3) ^ hashPatchValues(library.getPatchData(i)+PATCH_NAME_LENGTH);
+		}
+		return checksum;
+	};
+
+	PatchVpTree mTree;
+	int mNumIndexed;		// records in mTree, the rest is scanned linearly
+	uint64 mChecksum;		// getChecksum() of the indexed records
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,174 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PresetLoader.h"
+
+// the layout the firmware reads: numbered 8.3 names in the root folder of the card
+#define SDCARD_PATCH_PREFIX			"P"
+#define SDCARD_PATCH_DIGITS			3
+#define SDCARD_PATCH_EXTENSION		".SND"
+#define SDCARD_PATCH_PATTERN		"P???.SND"
+#define SDCARD_MAX_PATCHES			1000
+#define SDCARD_CLUSTER_SIZE			4096	// the smallest FAT cluster, every file takes at least one
+
+//---------------------------------------------------------------------------
+/** Writes a set of patches straight to a mounted SD card, in the layout
+	the firmware loads them from.
+
+	Every patch is one .SND file of PATCH_DATA_SIZE bytes, numbered from
+	P000.SND in the order they are given. The numbered files already on the
+	card are removed first, so the card holds exactly the exported set.
+	The files are created in number order, each with one write of its whole
+	record and without the temporary file and rename of
+	File::replaceWithData(), so the card sees one create and one
+	sequential write per patch and the clusters are allocated in order.
+
+	After the last file has been closed everything is read back and
+	compared with the records. A card that is pulled out early or runs
+	full shows up there instead of on the synth.
+*/
+class SdCardExporter
+{
+public:
+	SdCardExporter() : mNumWritten(0), mNumVerified(0)
+	{
+	};
+
+	/** the file of patch number index on the card*/
+	static File getPatchFile(const File& card, int index)
+	{
+		return card.getChildFile(SDCARD_PATCH_PREFIX + String(index).paddedLeft('0',SDCARD_PATCH_DIGITS) + SDCARD_PATCH_EXTENSION);
+	};
+
+	/** PATCH_DATA_SIZE records back to back. returns false and sets getError() unless all of them were written and read back*/
+	bool exportPatches(const File& card, const void* records, int numPatches)
+	{
+		TRACE_SCOPE("patch io","sd card export");
+		mNumWritten = 0;
+		mNumVerified = 0;
+		mError = String::empty;
+
+		if(!card.isDirectory())
+		{
+			mError = "no card mounted at " + card.getFullPathName();
+			return false;
+		}
+		if(numPatches > SDCARD_MAX_PATCHES)
+		{
+			mError = String(numPatches) + " patches don't fit the " + String(SDCARD_MAX_PATCHES) + " numbers of the firmware";
+			return false;
+		}
+
+		if(!removeOldPatches(card)) return false;
+
+		const int64 needed = (int64)numPatches * SDCARD_CLUSTER_SIZE;
+		if(card.getBytesFreeOnVolume() < needed)
+		{
+			mError = "the card needs " + File::descriptionOfSizeInBytes(needed) + " free";
+			return false;
+		}
+
+		for(int i=0;i<numPatches;i++)
+		{
+			if(!writePatch(getPatchFile(card,i),(const uint8_t*)records + i*PATCH_DATA_SIZE)) return false;
+			mNumWritten++;
+		}
+		return verify(card,records,numPatches);
+	};
+
+	int getNumWritten() const
+	{
+		return mNumWritten;
+	};
+
+	int getNumVerified() const
+	{
+		return mNumVerified;
+	};
+
+	const String& getError() const
+	{
+		return mError;
+	};
+
+private:
+	bool removeOldPatches(const File& card)
+	{
+		Array<File> oldFiles;
+		card.findChildFiles(oldFiles,File::findFiles,false,SDCARD_PATCH_PATTERN);
+		for(int i=0;i<oldFiles.size();i++)
+		{
+			if(!oldFiles.getReference(i).deleteFile())
+			{
+				mError = "can't remove " + oldFiles.getReference(i).getFullPathName();
+				return false;
+			}
+		}
+		return true;
+	};
+
+	/** the file doesn't exist any more, the stream starts at 0*/
+	bool writePatch(const File& file, const uint8_t* data)
+	{
+		bool ok;
+		{
+			FileOutputStream out(file,PATCH_DATA_SIZE);
+			ok = !out.failedToOpen() && out.write(data,PATCH_DATA_SIZE);
+			out.flush();
+		}
+		if(!ok || file.getSize() != PATCH_DATA_SIZE)
+		{
+			mError = "can't write " + file.getFullPathName();
+			return false;
+		}
+		return true;
+	};
+
+	bool verify(const File& card, const void* records, int numPatches)
+	{
+		uint8_t data[PATCH_DATA_SIZE];
+		for(int i=0;i<numPatches;i++)
+		{
+			const File file = getPatchFile(card,i);
+			FileInputStream in(file);
+			if(in.getTotalLength() != PATCH_DATA_SIZE
+				|| in.read(data,PATCH_DATA_SIZE) != PATCH_DATA_SIZE
+				|| memcmp(data,(const uint8_t*)records + i*PATCH_DATA_SIZE,PATCH_DATA_SIZE) != 0)
+			{
+				mError = file.getFullPathName() + " doesn't read back as written";
+				return false;
+			}
+			mNumVerified++;
+		}
+		return true;
+	};
+
+	int mNumWritten;
+	int mNumVerified;
+	String mError;
+};
+//---------------------------------------------------------------------------
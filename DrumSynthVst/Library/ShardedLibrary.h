@@ -0,0 +1,665 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Log.h"
+#include "../Trace.h"
+#include "../BackgroundJobs.h"
+#include "PatchLibrary.h"
+
+#define SHARDED_LIBRARY_EXTENSION	".sps"		// the folder of a sharded library
+#define SHARD_SEGMENT_MAGIC			0x53535053	// "SPSS" little endian
+#define SHARD_SEGMENT_VERSION		1
+#define SHARD_SEGMENT_HEADER_SIZE	16			// magic, version, NUM_PARAMS, PATCH_DATA_SIZE
+#define SHARD_RECORD_SIZE			(PATCH_DATA_SIZE + 4)	// the record and its check
+#define SHARD_OPEN_EXTENSION		".open"		// a segment a writer still appends to
+#define SHARD_SEALED_EXTENSION		".seg"		// a segment that is complete
+#define SHARD_SEGMENT_MAX_PATCHES	65536		// a writer starts a new segment after this many
+#define SHARD_WRITE_BUFFER_SIZE		65536		// bytes a writer collects before they go to the file
+#define SHARD_COMPACT_MIN_SEGMENTS	4			// sealed segments before they are merged into the base
+#define SHARD_COMPACT_CHECK_EVERY	4096		// records the compaction copies between two looks at the cancel
+#define SHARD_OPEN_ATTEMPTS			8			// a snapshot is listed again when a compaction moved its files
+#define SHARD_STOP_TIMEOUT_MS		5000
+
+//---------------------------------------------------------------------------
+/** The names of the files in the folder of a ShardedLibrary.
+
+	"base <id>.spb" is a PatchLibrary with everything merged up to segment
+	id, "segment <id>.open" is being appended to and "segment <id>.seg" is
+	complete. The ids are numbered up, a file with a higher id is newer.
+*/
+class ShardFiles
+{
+public:
+	static File getBaseFile(const File& folder, int id)
+	{
+		return folder.getChildFile("base " + String(id).paddedLeft('0',8) + PATCH_LIBRARY_EXTENSION);
+	};
+
+	static File getSegmentFile(const File& folder, int id, bool sealed)
+	{
+		return folder.getChildFile("segment " + String(id).paddedLeft('0',8) + (sealed ? SHARD_SEALED_EXTENSION : SHARD_OPEN_EXTENSION));
+	};
+
+	/** the ids of the files in the folder, each sorted. temporary files and anything else are left out*/
+	static void list(const File& folder, Array<int>& bases, Array<int>& sealed, Array<int>& open)
+	{
+		Array<File> files;
+		folder.findChildFiles(files,File::findFiles,false,"*");
+		for(int i=0;i<files.size();i++)
+		{
+			const File& file = files.getReference(i);
+			const String name = file.getFileNameWithoutExtension();
+			const String number = name.fromFirstOccurrenceOf(" ",false,false);
+			if(number.isEmpty() || !number.containsOnly("0123456789")) continue;
+
+			const int id = number.getIntValue();
+			if(name.startsWith("base ") && file.hasFileExtension(PATCH_LIBRARY_EXTENSION))	bases.add(id);
+			else if(name.startsWith("segment ") && file.hasFileExtension(SHARD_SEALED_EXTENSION))	sealed.add(id);
+			else if(name.startsWith("segment ") && file.hasFileExtension(SHARD_OPEN_EXTENSION))	open.add(id);
+		}
+		DefaultElementComparator<int> comparator;
+		bases.sort(comparator);
+		sealed.sort(comparator);
+		open.sort(comparator);
+	};
+
+	/** 32 bits over the name and the values, so a record a crash left half written is found*/
+	static uint32 getCheck(const uint8_t* data)
+	{
+		uint64 hash = hashPatchValues(data + PATCH_NAME_LENGTH);
+		for(int i=0;i<PATCH_NAME_LENGTH;i++)
+		{
+			hash = (hash ^ data[i]) * literal64bit(0x100000001b3);
+		}
+		return (uint32)(hash ^ (hash >> 32));
+	};
+
+	static bool isValidHeader(const uint8_t* data)
+	{
+		return ByteOrder::littleEndianInt(data) == SHARD_SEGMENT_MAGIC
+			&& ByteOrder::littleEndianInt(data+4) == SHARD_SEGMENT_VERSION
+			&& ByteOrder::littleEndianInt(data+8) == NUM_PARAMS
+			&& ByteOrder::littleEndianInt(data+12) == PATCH_DATA_SIZE;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** The patches of a ShardedLibrary as they were when the snapshot was taken.
+
+	The base and every segment newer than it are mapped, the records of a
+	segment that is still written are the ones that were flushed before,
+	whatever the writers add later isn't seen. The order is the base, then
+	the segments by id, the records of one writer stay in the order they
+	were added. The mappings stay valid while a compaction replaces the
+	files, a reader can keep a snapshot as long as it likes and take a new
+	one to see the new patches.
+*/
+class ShardedLibrarySnapshot : public ReferenceCountedObject
+{
+public:
+	typedef ReferenceCountedObjectPtr<ShardedLibrarySnapshot> Ptr;
+
+	/** NULL if the folder isn't a sharded library or one of its files isn't valid*/
+	static Ptr open(const File& folder)
+	{
+		TRACE_SCOPE("patch io","open shards");
+		if(!folder.isDirectory()) return NULL;
+
+		for(int attempt=0;attempt<SHARD_OPEN_ATTEMPTS;attempt++)
+		{
+			Ptr snapshot(new ShardedLibrarySnapshot());
+			const int result = snapshot->read(folder);
+			if(result == SNAPSHOT_OK)		return snapshot;
+			if(result == SNAPSHOT_INVALID)	return NULL;
+			//a compaction moved a file between the listing and the mapping
+		}
+		return NULL;
+	};
+
+	int getNumPatches()
+	{
+		return mNumPatches;
+	};
+
+	/** the PATCH_DATA_SIZE bytes of a patch, pointing into a mapped file*/
+	const uint8_t* getPatchData(int index)
+	{
+		jassert(index >= 0 && index < mNumPatches);
+		if(index < mBase.getNumPatches()) return mBase.getPatchData(index);
+
+		//the last segment that starts at or before index
+		int start = 0;
+		int end = mSegments.size();
+		while(end - start > 1)
+		{
+			const int mid = (start+end)/2;
+			if(mSegments.getReference(mid).first <= index)	start = mid;
+			else											end = mid;
+		}
+		const Segment& segment = mSegments.getReference(start);
+		return segment.mapping->getData() + SHARD_SEGMENT_HEADER_SIZE + (index - segment.first)*SHARD_RECORD_SIZE;
+	};
+
+	String getPatchName(int index)
+	{
+		return String((const char*)getPatchData(index),PATCH_NAME_LENGTH);
+	};
+
+	/** the segments that aren't merged into the base yet*/
+	int getNumSegments()
+	{
+		return mSegments.size();
+	};
+
+private:
+	enum
+	{
+		SNAPSHOT_OK = 0,
+		SNAPSHOT_MOVED,
+		SNAPSHOT_INVALID
+	};
+
+	struct Segment
+	{
+		MappedFileData::Ptr mapping;
+		int first;		// number of the first record in the snapshot
+	};
+
+	ShardedLibrarySnapshot() : mNumPatches(0)
+	{
+	};
+
+	int read(const File& folder)
+	{
+		Array<int> bases;
+		Array<int> sealed;
+		Array<int> open;
+		ShardFiles::list(folder,bases,sealed,open);
+
+		const int baseId = bases.size() > 0 ? bases.getLast() : 0;
+		if(baseId > 0 && !mBase.open(ShardFiles::getBaseFile(folder,baseId)))
+		{
+			return ShardFiles::getBaseFile(folder,baseId).existsAsFile() ? SNAPSHOT_INVALID : SNAPSHOT_MOVED;
+		}
+		mNumPatches = mBase.getNumPatches();
+
+		//the segments by id, the ones a compaction merged into the base may still be there
+		int s = 0;
+		int o = 0;
+		while(s < sealed.size() || o < open.size())
+		{
+			const bool isSealed = o == open.size() || (s < sealed.size() && sealed[s] < open[o]);
+			const int id = isSealed ? sealed[s++] : open[o++];
+			if(id <= baseId) continue;
+
+			const File file = ShardFiles::getSegmentFile(folder,id,isSealed);
+			const MappedFileData::Ptr mapping(MappedFileData::open(file));
+			if(mapping == NULL)
+			{
+				if(!file.existsAsFile()) return SNAPSHOT_MOVED;
+				continue;	//a writer has just created it
+			}
+			//a segment that is written may end inside its header or a record
+			if(mapping->getSize() < SHARD_SEGMENT_HEADER_SIZE) continue;
+			if(!ShardFiles::isValidHeader(mapping->getData())) return SNAPSHOT_INVALID;
+
+			const int numRecords = (int)((mapping->getSize() - SHARD_SEGMENT_HEADER_SIZE) / SHARD_RECORD_SIZE);
+			if(numRecords == 0) continue;
+
+			Segment segment;
+			segment.mapping = mapping;
+			segment.first = mNumPatches;
+			mSegments.add(segment);
+			mNumPatches += numRecords;
+		}
+		return SNAPSHOT_OK;
+	};
+
+	PatchLibrary mBase;
+	Array<Segment> mSegments;	// by the first record
+	int mNumPatches;
+};
+//---------------------------------------------------------------------------
+class ShardedLibrary;
+
+/** Appends patches to segments of its own in a ShardedLibrary.
+
+	One writer is used by one thread at a time, the writers of a library
+	share nothing but the lock of the library, which is only taken when a
+	segment is started or sealed. So every generator worker or farm run
+	gets a writer and they write side by side. The records are collected
+	in the buffer of the file stream, flush() hands them to the system so
+	the next snapshot sees them. After SHARD_SEGMENT_MAX_PATCHES the
+	segment is sealed and a new one started, close() seals it right away.
+	Delete the writers before their library.
+*/
+class ShardWriter
+{
+public:
+	~ShardWriter()
+	{
+		close();
+	};
+
+	/** append PATCH_DATA_SIZE bytes in .SND layout. false once a segment couldn't be written*/
+	inline bool addPatch(const uint8_t* data);
+
+	/** everything added so far is seen by the snapshots taken after this*/
+	bool flush()
+	{
+		if(mOut == NULL) return !mFailed;
+		mOut->flush();
+		if(mOut->getStatus().failed()) mFailed = true;
+		return !mFailed;
+	};
+
+	/** seals the segment, the next addPatch() starts a new one. false if a write has failed since the writer was made*/
+	inline bool close();
+
+	/** the patches this writer has added, over all its segments*/
+	int getNumWritten() const
+	{
+		return mNumWritten;
+	};
+
+private:
+	friend class ShardedLibrary;
+
+	ShardWriter(ShardedLibrary& owner) : mOwner(owner), mId(0), mNumPatches(0), mNumWritten(0), mFailed(false)
+	{
+	};
+
+	inline bool start();
+
+	ShardedLibrary& mOwner;
+	ScopedPointer<FileOutputStream> mOut;	// NULL if no segment is open
+	int mId;
+	int mNumPatches;			// in the open segment
+	int mNumWritten;
+	bool mFailed;
+};
+
+//---------------------------------------------------------------------------
+/** A patch library spread over a folder of append-only segment files, for
+	many writers at once.
+
+	A PatchLibrary is one file that is rewritten to add to it, so only one
+	writer at a time can add and every generation pays for the whole file.
+	Here each ShardWriter appends to a segment of its own (see ShardFiles),
+	a record is the PATCH_DATA_SIZE bytes and a check, so the writers don't
+	wait for each other and the rate grows with their number. Readers
+	take a ShardedLibrarySnapshot, which maps the base and the segments
+	and doesn't change while the writers go on.
+
+	Sealed segments are merged into a new base by an idle BackgroundJob
+	once there are SHARD_COMPACT_MIN_SEGMENTS of them. It only takes the
+	sealed segments below the oldest open one, so everything up to the id
+	of a base is in it and what is newer is in the segments. The new base
+	is moved into place before the merged files are deleted, a reader
+	that lists the folder in between takes its snapshot again. Where the
+	system doesn't delete mapped files they are left to a later compaction.
+
+	One ShardedLibrary per folder and process, the nodes of a farm send
+	their children to the process that writes. Segments that were still
+	open when a session ended are cut back to their last good record and
+	sealed when the library is made.
+*/
+class ShardedLibrary
+{
+public:
+	ShardedLibrary(const File& folder) : mFolder(folder), mNextId(1), mNumSealed(0)
+	{
+		recover();
+	};
+
+	~ShardedLibrary()
+	{
+		jassert(mOpenIds.size() == 0);	// a writer outlives its library
+
+		BackgroundJob::Ptr job;
+		{
+			const ScopedLock sl(mLock);
+			job = mCompactJob;
+		}
+		if(job != NULL)
+		{
+			job->cancel();
+			job->waitUntilDone(SHARD_STOP_TIMEOUT_MS);
+		}
+	};
+
+	/** false if the folder couldn't be made*/
+	bool isValid() const
+	{
+		return mFolder.isDirectory();
+	};
+
+	const File& getFolder() const
+	{
+		return mFolder;
+	};
+
+	/** a writer for one thread, the caller deletes it*/
+	ShardWriter* createWriter()
+	{
+		return new ShardWriter(*this);
+	};
+
+	/** the patches as they are now, NULL if the folder can't be read*/
+	ShardedLibrarySnapshot::Ptr getSnapshot()
+	{
+		return ShardedLibrarySnapshot::open(mFolder);
+	};
+
+	/** merges the sealed segments into the base on this thread. false if it couldn't be written*/
+	bool compact()
+	{
+		int numMerged;
+		return compact(NULL,numMerged);
+	};
+
+	/** waits for the background compactions, also the ones they start. false if the timeout ran out first*/
+	bool waitForCompaction(int timeoutMs)
+	{
+		for(;;)
+		{
+			BackgroundJob::Ptr job;
+			{
+				const ScopedLock sl(mLock);
+				job = mCompactJob;
+			}
+			if(job == NULL) return true;
+			//it clears itself or starts the next one before it is done
+			if(!job->waitUntilDone(timeoutMs)) return false;
+		}
+	};
+
+private:
+	friend class ShardWriter;
+
+	//-----------------------------------------------------------------------
+	class CompactJob : public BackgroundJob
+	{
+	public:
+		CompactJob(ShardedLibrary& owner) : BackgroundJob("compact shards",JOB_PRIORITY_IDLE), mOwner(owner)
+		{
+		};
+
+		bool run()
+		{
+			int numMerged = 0;
+			const bool ok = !shouldExit() && mOwner.compact(this,numMerged);
+			//shouldExit() may wait for the user, not under the lock
+			const bool again = ok && numMerged > 0 && !shouldExit();
+			const ScopedLock sl(mOwner.mLock);
+			mOwner.mCompactJob = NULL;
+			//for the segments sealed while it ran. if an open segment held all of them back,
+			//the next seal starts it again
+			if(again) mOwner.startCompactionIfNeeded();
+			return ok;
+		};
+
+	private:
+		ShardedLibrary& mOwner;
+	};
+	//-----------------------------------------------------------------------
+
+	/** a new id for a writer*/
+	int startSegment()
+	{
+		const ScopedLock sl(mLock);
+		const int id = mNextId++;
+		mOpenIds.add(id);
+		return id;
+	};
+
+	/** the writer has closed the stream of the segment*/
+	void sealSegment(int id, int numPatches)
+	{
+		const File file = ShardFiles::getSegmentFile(mFolder,id,false);
+		const bool done = numPatches == 0 ? file.deleteFile() : file.moveFileTo(ShardFiles::getSegmentFile(mFolder,id,true));
+
+		const ScopedLock sl(mLock);
+		mOpenIds.removeValue(id);
+		//a reader has it mapped where that keeps it from being moved, the compaction tries again
+		if(!done)					mPendingIds.add(id);
+		else if(numPatches > 0)		mNumSealed++;
+		startCompactionIfNeeded();
+	};
+
+	/** under the lock*/
+	void startCompactionIfNeeded()
+	{
+		if(mCompactJob == NULL && mNumSealed >= SHARD_COMPACT_MIN_SEGMENTS)
+		{
+			mCompactJob = JobQueue::getInstance()->addJob(new CompactJob(*this));
+		}
+	};
+
+	/** the segments that couldn't be sealed or deleted when their writer closed them, under the lock*/
+	void retryPending()
+	{
+		for(int i=mPendingIds.size();--i>=0;)
+		{
+			const File file = ShardFiles::getSegmentFile(mFolder,mPendingIds[i],false);
+			const bool empty = file.getSize() <= SHARD_SEGMENT_HEADER_SIZE;
+			if(empty ? file.deleteFile() : file.moveFileTo(ShardFiles::getSegmentFile(mFolder,mPendingIds[i],true)))
+			{
+				if(!empty) mNumSealed++;
+				mPendingIds.remove(i);
+			}
+		}
+	};
+
+	/** the ids go on from the newest file, the segments of an earlier session are sealed*/
+	void recover()
+	{
+		mFolder.createDirectory();
+
+		Array<int> bases;
+		Array<int> sealed;
+		Array<int> open;
+		ShardFiles::list(mFolder,bases,sealed,open);
+		const int baseId = bases.size() > 0 ? bases.getLast() : 0;
+		mNextId = jmax(baseId,sealed.size() > 0 ? sealed.getLast() : 0,open.size() > 0 ? open.getLast() : 0) + 1;
+
+		for(int i=0;i<open.size();i++)
+		{
+			if(open[i] <= baseId)	ShardFiles::getSegmentFile(mFolder,open[i],false).deleteFile();
+			else if(recoverSegment(open[i]))	mNumSealed++;
+		}
+		for(int i=0;i<sealed.size();i++)
+		{
+			if(sealed[i] > baseId) mNumSealed++;
+		}
+
+		const ScopedLock sl(mLock);
+		startCompactionIfNeeded();
+	};
+
+	/** seals the good records of a segment, false if there were none*/
+	bool recoverSegment(int id)
+	{
+		const File file = ShardFiles::getSegmentFile(mFolder,id,false);
+		MemoryBlock data;
+		file.loadFileAsData(data);
+		const uint8_t* segment = (const uint8_t*)data.getData();
+		const size_t size = data.getSize();
+
+		int numRecords = 0;
+		if(size >= SHARD_SEGMENT_HEADER_SIZE && ShardFiles::isValidHeader(segment))
+		{
+			for(;SHARD_SEGMENT_HEADER_SIZE + (size_t)(numRecords+1)*SHARD_RECORD_SIZE <= size;numRecords++)
+			{
+				const uint8_t* record = segment + SHARD_SEGMENT_HEADER_SIZE + numRecords*SHARD_RECORD_SIZE;
+				if(ByteOrder::littleEndianInt(record + PATCH_DATA_SIZE) != ShardFiles::getCheck(record)) break;
+			}
+		}
+		if(numRecords == 0)
+		{
+			file.deleteFile();
+			return false;
+		}
+
+		const File target = ShardFiles::getSegmentFile(mFolder,id,true);
+		const size_t goodSize = SHARD_SEGMENT_HEADER_SIZE + (size_t)numRecords*SHARD_RECORD_SIZE;
+		if(goodSize != size)
+		{
+			logText("The segment " + file.getFullPathName() + " was cut off, " + String(numRecords) + " patches were kept");
+			if(!target.replaceWithData(segment,goodSize)) return false;
+			file.deleteFile();
+			return true;
+		}
+		return file.moveFileTo(target);
+	};
+
+	/** on a pool thread, or on the caller's for compact(). numMerged is 0 if every sealed
+		segment is newer than an open one*/
+	bool compact(const BackgroundJob* job, int& numMerged)
+	{
+		numMerged = 0;
+		const ScopedLock cl(mCompactLock);
+		TRACE_SCOPE("patch io","compact shards");
+
+		//everything below the oldest segment a writer still has may be merged
+		int limit;
+		{
+			const ScopedLock sl(mLock);
+			retryPending();
+			limit = mNextId;
+			for(int i=0;i<mOpenIds.size();i++)		limit = jmin(limit,mOpenIds[i]);
+			for(int i=0;i<mPendingIds.size();i++)	limit = jmin(limit,mPendingIds[i]);
+		}
+
+		Array<int> bases;
+		Array<int> sealed;
+		Array<int> open;
+		ShardFiles::list(mFolder,bases,sealed,open);
+		const int baseId = bases.size() > 0 ? bases.getLast() : 0;
+
+		Array<int> merged;
+		for(int i=0;i<sealed.size();i++)
+		{
+			if(sealed[i] > baseId && sealed[i] < limit) merged.add(sealed[i]);
+		}
+
+		if(merged.size() > 0)
+		{
+			PatchLibraryWriter writer(ShardFiles::getBaseFile(mFolder,merged.getLast()));
+			if(baseId > 0)
+			{
+				PatchLibrary base;
+				if(!base.open(ShardFiles::getBaseFile(mFolder,baseId))) return false;
+				for(int i=0;i<base.getNumPatches();i++)
+				{
+					if(i % SHARD_COMPACT_CHECK_EVERY == 0 && job != NULL && job->shouldExit()) return false;
+					writer.addPatch(base.getPatchData(i));
+				}
+			}
+			for(int m=0;m<merged.size();m++)
+			{
+				const MappedFileData::Ptr mapping(MappedFileData::open(ShardFiles::getSegmentFile(mFolder,merged[m],true)));
+				if(mapping == NULL || mapping->getSize() < SHARD_SEGMENT_HEADER_SIZE || !ShardFiles::isValidHeader(mapping->getData())) return false;
+
+				const int numRecords = (int)((mapping->getSize() - SHARD_SEGMENT_HEADER_SIZE) / SHARD_RECORD_SIZE);
+				for(int i=0;i<numRecords;i++)
+				{
+					if(i % SHARD_COMPACT_CHECK_EVERY == 0 && job != NULL && job->shouldExit()) return false;
+					writer.addPatch(mapping->getData() + SHARD_SEGMENT_HEADER_SIZE + i*SHARD_RECORD_SIZE);
+				}
+			}
+			if(!writer.finish()) return false;
+
+			const ScopedLock sl(mLock);
+			mNumSealed = jmax(0,mNumSealed - merged.size());
+			numMerged = merged.size();
+		}
+
+		//the new base is in place, the files it took in go. and what an earlier one left
+		const int newBaseId = merged.size() > 0 ? merged.getLast() : baseId;
+		for(int i=0;i<bases.size();i++)		if(bases[i] < newBaseId) ShardFiles::getBaseFile(mFolder,bases[i]).deleteFile();
+		for(int i=0;i<sealed.size();i++)	if(sealed[i] <= newBaseId) ShardFiles::getSegmentFile(mFolder,sealed[i],true).deleteFile();
+		return true;
+	};
+
+	const File mFolder;
+	CriticalSection mLock;
+	CriticalSection mCompactLock;	// one compaction at a time, never taken under mLock
+	int mNextId;
+	Array<int> mOpenIds;			// the segments of the writers
+	Array<int> mPendingIds;			// closed, but not yet sealed or deleted
+	int mNumSealed;					// sealed and not merged
+	BackgroundJob::Ptr mCompactJob;	// running, under the lock
+};
+
+//---------------------------------------------------------------------------
+inline bool ShardWriter::addPatch(const uint8_t* data)
+{
+	if(mFailed) return false;
+	if(mOut == NULL || mNumPatches == SHARD_SEGMENT_MAX_PATCHES)
+	{
+		close();
+		if(!start()) return false;
+	}
+	mOut->write(data,PATCH_DATA_SIZE);
+	mOut->writeInt((int)ShardFiles::getCheck(data));
+	mNumPatches++;
+	mNumWritten++;
+	return true;
+}
+
+inline bool ShardWriter::close()
+{
+	if(mOut != NULL)
+	{
+		mOut->flush();
+		if(mOut->getStatus().failed()) mFailed = true;
+		mOut = NULL;
+		mOwner.sealSegment(mId,mNumPatches);
+		mNumPatches = 0;
+	}
+	return !mFailed;
+}
+
+inline bool ShardWriter::start()
+{
+	mId = mOwner.startSegment();
+	mOut = new FileOutputStream(ShardFiles::getSegmentFile(mOwner.getFolder(),mId,false),SHARD_WRITE_BUFFER_SIZE);
+	if(mOut->failedToOpen())
+	{
+		mOut = NULL;
+		mOwner.sealSegment(mId,0);
+		mFailed = true;
+		return false;
+	}
+	mOut->writeInt(SHARD_SEGMENT_MAGIC);
+	mOut->writeInt(SHARD_SEGMENT_VERSION);
+	mOut->writeInt(NUM_PARAMS);
+	mOut->writeInt(PATCH_DATA_SIZE);
+	return true;
+}
+//---------------------------------------------------------------------------
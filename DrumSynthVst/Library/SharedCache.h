@@ -0,0 +1,194 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../Trace.h"
+#include "MappedFileData.h"
+
+#define SHARED_CACHE_MAGIC			0x43535053	// "SPSC" little endian
+#define SHARED_CACHE_HEADER_SIZE	32			// keeps the payload 16 byte aligned
+#define SHARED_CACHE_FOLDER			"DrumSynthCache"
+#define SHARED_CACHE_LOCK_TIMEOUT_MS	10000
+
+//---------------------------------------------------------------------------
+/** Data derived from a file, like the sorted names of a library, that every
+	running editor shares instead of building its own copy.
+
+	A segment is a file in the temp folder that every instance maps read
+	only, so they all read the same pages of the OS page cache. The first
+	instance that asks for a segment builds it under an InterProcessLock of
+	its name, the others wait for the lock and then just map it. The key
+	says what the segment was built from (see makeFileKey()), a segment of
+	another key is built again over the old one. The mapping stays valid
+	while it is held, even after a newer segment replaced the file. If a
+	segment can't be shared, e.g. because another instance still maps an
+	old one that Windows won't replace, the caller gets a private one.
+
+	Layout (all numbers 32 bit little endian):
+	header		magic, key as two ints, payload size, padding up to
+				SHARED_CACHE_HEADER_SIZE
+	payload		whatever the Builder wrote
+*/
+class SharedCache
+{
+public:
+	//-----------------------------------------------------------------------
+	class Builder
+	{
+	public:
+		virtual ~Builder() {};
+		/** writes the payload of a new segment. false if it can't be built*/
+		virtual bool buildSegment(OutputStream& out) = 0;
+	};
+
+	/** the payload of a segment, mapped or, if it couldn't be shared, a private copy*/
+	class Segment : public ReferenceCountedObject
+	{
+	public:
+		typedef ReferenceCountedObjectPtr<Segment> Ptr;
+
+		Segment(MappedFileData* mapping) : mMapping(mapping)
+		{
+			mData = mapping->getData() + SHARED_CACHE_HEADER_SIZE;
+			mSize = mapping->getSize() - SHARED_CACHE_HEADER_SIZE;
+		};
+
+		Segment(const MemoryOutputStream& payload) : mCopy(payload.getData(),payload.getDataSize())
+		{
+			mData = (const uint8_t*)mCopy.getData();
+			mSize = mCopy.getSize();
+		};
+
+		const uint8_t* getData() const
+		{
+			return mData;
+		};
+
+		size_t getSize() const
+		{
+			return mSize;
+		};
+
+		bool isShared() const
+		{
+			return mMapping != NULL;
+		};
+
+	private:
+		MappedFileData::Ptr mMapping;
+		MemoryBlock mCopy;
+		const uint8_t* mData;
+		size_t mSize;
+	};
+	//-----------------------------------------------------------------------
+
+	/** the segment name with this key, built by builder if no instance has built it yet.
+		NULL only if the builder fails*/
+	static Segment::Ptr open(const String& name, int64 key, Builder& builder)
+	{
+		TRACE_SCOPE("patch io","shared cache");
+		MemoryOutputStream payload;
+		bool tried = false;
+		bool built = false;
+
+		const File folder(File::getSpecialLocation(File::tempDirectory).getChildFile(SHARED_CACHE_FOLDER));
+		const File file(folder.getChildFile(name + ".cache"));
+		InterProcessLock lock(String(SHARED_CACHE_FOLDER) + "_" + name);
+		if(folder.createDirectory() && lock.enter(SHARED_CACHE_LOCK_TIMEOUT_MS))
+		{
+			Segment::Ptr segment(map(file,key));
+			if(segment == NULL)
+			{
+				tried = true;
+				built = builder.buildSegment(payload);
+				if(built && write(file,key,payload)) segment = map(file,key);
+			}
+			lock.exit();
+			if(segment != NULL) return segment;
+		}
+
+		if(tried ? !built : !builder.buildSegment(payload)) return NULL;
+		return new Segment(payload);
+	};
+
+	/** a key that changes with the path, size and modification time of a file*/
+	static int64 makeFileKey(const File& file, int version)
+	{
+		uint64 key = (uint64)file.getFullPathName().hashCode64();
+		key = (key ^ (uint64)file.getSize()) * literal64bit(0x9e3779b97f4a7c15);
+		key = (key ^ (uint64)file.getLastModificationTime().toMilliseconds()) * literal64bit(0xbf58476d1ce4e5b9);
+		return (int64)(key ^ (uint64)version);
+	};
+
+	/** a segment name that is unique for a file, e.g. for the segments belonging to a library*/
+	static String makeFileName(const String& prefix, const File& file)
+	{
+		return prefix + "_" + String::toHexString(file.getFullPathName().hashCode64());
+	};
+
+private:
+	static Segment::Ptr map(const File& file, int64 key)
+	{
+		MappedFileData::Ptr mapping(MappedFileData::open(file));
+		if(mapping == NULL) return NULL;
+
+		const uint8_t* header = mapping->getRange(0,SHARED_CACHE_HEADER_SIZE);
+		if(header == NULL
+			|| ByteOrder::littleEndianInt(header) != SHARED_CACHE_MAGIC
+			|| ByteOrder::littleEndianInt(header+4) != (uint32)key
+			|| ByteOrder::littleEndianInt(header+8) != (uint32)(key>>32)
+			|| (size_t)ByteOrder::littleEndianInt(header+12) != mapping->getSize() - SHARED_CACHE_HEADER_SIZE)
+		{
+			return NULL;
+		}
+		return new Segment(mapping);
+	};
+
+	/** the new segment is renamed over the old one, a mapping of that stays intact*/
+	static bool write(const File& file, int64 key, const MemoryOutputStream& payload)
+	{
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			out->writeInt(SHARED_CACHE_MAGIC);
+			out->writeInt((int)key);
+			out->writeInt((int)(key>>32));
+			out->writeInt((int)payload.getDataSize());
+			for(int i=16;i<SHARED_CACHE_HEADER_SIZE;i+=4)
+			{
+				out->writeInt(0);
+			}
+			out->write(payload.getData(),(int)payload.getDataSize());
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Midi/SysExStreamParser.h"
+#include "PatchLibrary.h"
+#include "MappedFileData.h"
+
+#define SYSEX_WRITE_BUFFER_SIZE	16384
+
+//---------------------------------------------------------------------------
+/** Turns a SysEx bank into a PatchLibrary and back without buffering the bank.
+
+	The parser decodes every dump into a single record, which goes straight
+	into a PatchLibraryWriter, so memory use doesn't grow with the bank. A
+	bank can come from a .syx file (importBank()) or live from the synth: give
+	getParser() to MidiInputParser::setBankReceiver() and call finish() when
+	the dump is complete.
+*/
+class SysExBank : public SysExStreamParser::Listener
+{
+public:
+	SysExBank(const File& libraryFile)
+	: mWriter(libraryFile),
+	mParser(this)
+	{
+	};
+
+	~SysExBank()
+	{
+	};
+
+	SysExStreamParser& getParser()
+	{
+		return mParser;
+	};
+
+	int getNumPatches()
+	{
+		return mWriter.getNumPatches();
+	};
+
+	/** write the library. returns false if it couldn't be written*/
+	bool finish()
+	{
+		return mWriter.finish();
+	};
+
+	void patchDumpReceived(const uint8_t* data)
+	{
+		mWriter.addPatch(data);
+	};
+
+	//-----------------------------------------------------------------------
+	/** decode a .syx bank into a library. returns the number of patches or -1 on failure.
+		thread can be given to make the import cancelable*/
+	static int importBank(const File& sysExFile, const File& libraryFile, Thread* thread = NULL)
+	{
+		//the dumps are parsed from the page cache, an empty file can't be mapped and is read as a stream
+		MappedFileData::Ptr mapping(MappedFileData::open(sysExFile));
+		SysExBank bank(libraryFile);
+		if(mapping != NULL)
+		{
+			if(!bank.getParser().feed(mapping->getData(),mapping->getSize(),thread)) return -1;
+		}
+		else
+		{
+			FileInputStream in(sysExFile);
+			if(in.getStatus().failed()) return -1;
+			if(!bank.getParser().feed(in,thread)) return -1;
+		}
+		if(!bank.finish()) return -1;
+		return bank.getNumPatches();
+	};
+
+	/** write every patch of a library as one dump into a .syx bank*/
+	static bool exportBank(PatchLibrary& library, const File& sysExFile)
+	{
+		//the records of a library are back to back in the mapped file
+		const int numPatches = library.getNumPatches();
+		return exportBank(numPatches > 0 ? library.getPatchData(0) : NULL,numPatches,sysExFile);
+	};
+
+	/** write PATCH_DATA_SIZE records stored back to back into a .syx bank*/
+	static bool exportBank(const void* records, int numPatches, const File& sysExFile)
+	{
+		TemporaryFile temp(sysExFile);
+		{
+			FileOutputStream out(temp.getFile(),SYSEX_WRITE_BUFFER_SIZE);
+			if(out.getStatus().failed()) return false;
+
+			uint8_t message[SYSEX_PATCH_DUMP_MESSAGE_SIZE];
+			for(int i=0;i<numPatches;i++)
+			{
+				PatchSysEx::writePatchDump((const uint8_t*)records + i*PATCH_DATA_SIZE,message);
+				out.write(message,SYSEX_PATCH_DUMP_MESSAGE_SIZE);
+			}
+
+			out.flush();
+			if(out.getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+private:
+	PatchLibraryWriter mWriter;
+	SysExStreamParser mParser;
+};
+//---------------------------------------------------------------------------
@@ -24,4 +24,342 @@
  */
 #pragma once
 
-static TextEditor* gloLogText;
\ No newline at end of file
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./MpscFifo.h"
+
+#define LOG_NUM_SLOTS			1024	// lines that can wait for the next flush
+#define LOG_READ_BATCH			64		// lines taken from the queue at once
+#define LOG_LINE_LENGTH			128		// bytes per line including the terminating 0, longer lines are cut
+#define LOG_FLUSH_INTERVAL_MS	50
+#define LOG_MAX_LINES			2000	// the oldest lines are removed from the editor above this
+
+#define LOG_MAX_ARGS			4		// arguments of a deferred line
+
+// the console build has no window, it sets this to 1 and logs to stdout
+#ifndef LOG_TO_STDOUT
+#define LOG_TO_STDOUT			0
+#endif
+
+#define LOG_LEVEL_ERROR			0
+#define LOG_LEVEL_INFO			1
+#define LOG_LEVEL_VERBOSE		2		// a line per bred child
+#define LOG_LEVEL_TRACE			3		// a line per bred parameter
+
+// the LOG_* calls above this level compile to nothing, the ones up to it cost a
+// compare while LogLevel is lower
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL		LOG_LEVEL_VERBOSE
+#endif
+
+//---------------------------------------------------------------------------
+/** The level up to which the LOG_* calls are written, LOG_LEVEL_INFO unless
+	it is raised, e.g. by the -verbose option of the console. Any thread*/
+class LogLevel
+{
+public:
+	static void set(int level)
+	{
+		sLevel.set(level);
+	};
+
+	static bool isOn(int level)
+	{
+		return level <= sLevel.get();
+	};
+
+private:
+	static Atomic<int> sLevel;
+};
+
+//---------------------------------------------------------------------------
+/** One argument of a deferred log line. Only numbers and literals, which the
+	line keeps as they are, so nothing is allocated or formatted by the
+	thread that logs.
+*/
+struct LogArg
+{
+	enum Type
+	{
+		LOG_ARG_INT,
+		LOG_ARG_DOUBLE,
+		LOG_ARG_TEXT
+	};
+
+	LogArg() : type(LOG_ARG_INT)
+	{
+		value.i = 0;
+	};
+
+	LogArg(int i) : type(LOG_ARG_INT)
+	{
+		value.i = i;
+	};
+
+	LogArg(int64 i) : type(LOG_ARG_INT)
+	{
+		value.i = i;
+	};
+
+	LogArg(double d) : type(LOG_ARG_DOUBLE)
+	{
+		value.d = d;
+	};
+
+	/** a literal or another string that outlives the line*/
+	LogArg(const char* text) : type(LOG_ARG_TEXT)
+	{
+		value.text = text;
+	};
+
+	String toString() const
+	{
+		switch(type)
+		{
+		case LOG_ARG_DOUBLE:	return String(value.d);
+		case LOG_ARG_TEXT:		return String(value.text);
+		default:				return String(value.i);
+		}
+	};
+
+	/** format with every {} replaced by the next argument, the {} left over stay*/
+	static String format(const char* format, const LogArg* args, int numArgs)
+	{
+		String text;
+		const char* start = format;
+		int arg = 0;
+		for(const char* c=format;*c != 0;c++)
+		{
+			if(c[0] != '{' || c[1] != '}' || arg >= numArgs) continue;
+			text += String(start,(int)(c - start));
+			text += args[arg++].toString();
+			start = ++c + 1;
+		}
+		return text + start;
+	};
+
+	union
+	{
+		int64 i;
+		double d;
+		const char* text;
+	} value;
+	Type type;
+};
+
+//---------------------------------------------------------------------------
+/** Collects log lines from any thread and appends them to a TextEditor.
+
+	write() never blocks: every line goes into a fixed slot of a bounded
+	MpscFifo (one compare and swap per line). A timer on the
+	message thread moves the waiting lines into the editor, so only new
+	text is inserted and the editor never holds more than about
+	LOG_MAX_LINES lines. Lines that don't fit into the queue are counted
+	and reported with the next flush. A deferred line keeps its format and
+	arguments, it is formatted by the flush.
+*/
+class LogSink : public Timer
+{
+public:
+	LogSink(TextEditor* editor)
+	: mEditor(editor),
+	mNumLines(0),
+	mQueue(LOG_NUM_SLOTS)
+	{
+		startTimer(LOG_FLUSH_INTERVAL_MS);
+	};
+
+	~LogSink()
+	{
+		stopTimer();
+	};
+
+	/** can be called from any thread, text may hold several lines*/
+	void write(const String& text)
+	{
+		int start = 0;
+		while(start < text.length())
+		{
+			int end = text.indexOfChar(start,'\n');
+			if(end < 0) end = text.length();
+			writeLine(text.substring(start,end));
+			start = end+1;
+		}
+	};
+
+	/** can be called from any thread, format and its literal arguments have to outlive the line*/
+	void writeDeferred(const char* format, const LogArg* args, int numArgs)
+	{
+		Line entry;
+		entry.format = format;
+		entry.numArgs = jmin(numArgs,(int)LOG_MAX_ARGS);
+		for(int i=0;i<entry.numArgs;i++)
+		{
+			entry.args[i] = args[i];
+		}
+		if(!mQueue.push(entry)) ++mDropped;
+	};
+
+	/** drops the waiting lines and empties the editor, message thread only*/
+	void clear()
+	{
+		readLines();
+		mDropped.set(0);
+		mEditor->clear();
+		mNumLines = 0;
+	};
+
+	void timerCallback()
+	{
+		String text = readLines();
+		const int dropped = mDropped.exchange(0);
+		if(dropped > 0)
+		{
+			text += String("(") + String(dropped) + String(" log lines dropped)\n");
+		}
+		if(text.isEmpty()) return;
+
+		mEditor->setCaretPosition(mEditor->getTotalNumChars());
+		mEditor->insertTextAtCaret(text);
+
+		for(int i=text.indexOfChar('\n');i>=0;i=text.indexOfChar(i+1,'\n'))
+		{
+			mNumLines++;
+		}
+		if(mNumLines > LOG_MAX_LINES)
+		{
+			removeOldestLines(mNumLines - LOG_MAX_LINES*3/4);
+		}
+	};
+
+private:
+	struct Line
+	{
+		const char* format;		// NULL if text holds the line
+		LogArg args[LOG_MAX_ARGS];
+		int numArgs;
+		char text[LOG_LINE_LENGTH];
+	};
+
+	void writeLine(const String& line)
+	{
+		Line entry;
+		entry.format = NULL;
+		entry.numArgs = 0;
+		line.copyToUTF8(entry.text,LOG_LINE_LENGTH);
+		//the reader is LOG_NUM_SLOTS lines behind
+		if(!mQueue.push(entry)) ++mDropped;
+	};
+
+	/** takes all finished lines out of the queue, message thread only*/
+	String readLines()
+	{
+		String text;
+		Line lines[LOG_READ_BATCH];
+		int num;
+		while((num = mQueue.read(lines,LOG_READ_BATCH)) > 0)
+		{
+			for(int i=0;i<num;i++)
+			{
+				const Line& line = lines[i];
+				text += line.format != NULL ? LogArg::format(line.format,line.args,line.numArgs) : String::fromUTF8(line.text);
+				text += "\n";
+			}
+		}
+		return text;
+	};
+
+	void removeOldestLines(int numLines)
+	{
+		const String text = mEditor->getText();
+		int end = -1;
+		for(int i=0;i<numLines;i++)
+		{
+			end = text.indexOfChar(end+1,'\n');
+			if(end < 0) return;
+		}
+		mEditor->setHighlightedRegion(Range<int>(0,end+1));
+		mEditor->insertTextAtCaret(String::empty);
+		mEditor->setCaretPosition(mEditor->getTotalNumChars());
+		mNumLines -= numLines;
+	};
+
+	TextEditor* mEditor;
+	int mNumLines;
+
+	MpscFifo<Line> mQueue;
+	Atomic<int> mDropped;
+};
+//---------------------------------------------------------------------------
+
+/** set by the generator window, NULL while no window is open*/
+static LogSink* gloLog;
+
+/** writes to the generator log if there is one*/
+static inline void logText(const String& text)
+{
+#if LOG_TO_STDOUT
+	//one call per text, so lines of different threads don't mix
+	if(text.endsWithChar('\n'))	fputs(text.toUTF8(),stdout);
+	else						fputs((text + "\n").toUTF8(),stdout);
+	fflush(stdout);
+#else
+	if(gloLog != NULL) gloLog->write(text);
+#endif
+}
+
+/** writes a deferred line, see the LOG_* macros*/
+static inline void logDeferred(const char* format, const LogArg* args, int numArgs)
+{
+#if LOG_TO_STDOUT
+	logText(LogArg::format(format,args,numArgs));
+#else
+	if(gloLog != NULL) gloLog->writeDeferred(format,args,numArgs);
+#endif
+}
+
+static inline void logFormat(const char* format)
+{
+	logDeferred(format,NULL,0);
+}
+
+static inline void logFormat(const char* format, const LogArg& a)
+{
+	logDeferred(format,&a,1);
+}
+
+static inline void logFormat(const char* format, const LogArg& a, const LogArg& b)
+{
+	const LogArg args[] = { a, b };
+	logDeferred(format,args,2);
+}
+
+static inline void logFormat(const char* format, const LogArg& a, const LogArg& b, const LogArg& c)
+{
+	const LogArg args[] = { a, b, c };
+	logDeferred(format,args,3);
+}
+
+static inline void logFormat(const char* format, const LogArg& a, const LogArg& b, const LogArg& c, const LogArg& d)
+{
+	const LogArg args[] = { a, b, c, d };
+	logDeferred(format,args,4);
+}
+
+/** LOG_VERBOSE("Mutating {} parameters out of {}",num,numSites) writes the line with every {} replaced
+	by the next argument if the level is on. The format is a literal, the arguments numbers or literals*/
+#define LOG_AT(level,...)	do { if(LogLevel::isOn(level)) logFormat(__VA_ARGS__); } while(0)
+
+#define LOG_ERROR(...)		LOG_AT(LOG_LEVEL_ERROR,__VA_ARGS__)
+#define LOG_INFO(...)		LOG_AT(LOG_LEVEL_INFO,__VA_ARGS__)
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_VERBOSE
+#define LOG_VERBOSE(...)	LOG_AT(LOG_LEVEL_VERBOSE,__VA_ARGS__)
+#else
+#define LOG_VERBOSE(...)	do {} while(0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+#define LOG_TRACE(...)		LOG_AT(LOG_LEVEL_TRACE,__VA_ARGS__)
+#else
+#define LOG_TRACE(...)		do {} while(0)
+#endif
@@ -0,0 +1,202 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./MacroControls.h"
+
+#define MACRO_KNOB_WIDTH	64
+
+//---------------------------------------------------------------------------
+/** The macro dialog: the MACRO_NUM_CONTROLS knobs, and below them the name
+	and the targets of the macro chosen in the box.
+
+	Apply checks the targets, sets them and saves all macros. Each drag of
+	a knob is one undo step. The macros are loaded when the dialog is shown
+	for the first time.
+*/
+class MacroComponent : public Component,
+					   public SliderListener,
+					   public ButtonListener,
+					   public ComboBoxListener
+{
+public:
+	MacroComponent() : mLoaded(false)
+	{
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			Slider* knob = new Slider("macro " + String(i+1));
+			knob->setRange(0,MACRO_TABLE_SIZE-1,1);
+			knob->setSliderStyle(Slider::RotaryVerticalDrag);
+			knob->setTextBoxStyle(Slider::TextBoxBelow,false,40,16);
+			knob->addListener(this);
+			addAndMakeVisible(knob);
+			mKnobs[i] = knob;
+
+			addAndMakeVisible(mNames[i] = new Label("name",String::empty));
+			mNames[i]->setColour(Label::textColourId,Colours::white);
+			mNames[i]->setJustificationType(Justification::centred);
+			mNames[i]->setFont(12.f);
+		}
+
+		addAndMakeVisible(mSelector = new ComboBox("macro"));
+		mSelector->addListener(this);
+
+		addAndMakeVisible(mNameEditor = new TextEditor("name"));
+
+		addAndMakeVisible(mApplyButton = new TextButton("Apply"));
+		mApplyButton->addListener(this);
+
+		addAndMakeVisible(mTargetEditor = new TextEditor("targets"));
+		mTargetEditor->setMultiLine(true);
+		mTargetEditor->setReturnKeyStartsNewLine(true);
+
+		mMessage = "one target per line: parameter [on voice n]: from to to [lin|exp|log|s]";
+		setSize(MACRO_NUM_CONTROLS*MACRO_KNOB_WIDTH + 16,310);
+	};
+
+	~MacroComponent()
+	{
+		deleteAllChildren();
+	};
+
+	void visibilityChanged()
+	{
+		if(!isVisible() || mLoaded) return;
+		mLoaded = true;
+		mEngine.loadConfig();
+		updateControls();
+		mSelector->setSelectedItemIndex(0,true);
+		showMacro(0);
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+		g.drawText(mMessage,8,getHeight()-24,getWidth()-16,16,Justification::left,true);
+	};
+
+	void resized()
+	{
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			mNames[i]->setBounds(8 + i*MACRO_KNOB_WIDTH,8,MACRO_KNOB_WIDTH,16);
+			mKnobs[i]->setBounds(8 + i*MACRO_KNOB_WIDTH,24,MACRO_KNOB_WIDTH,72);
+		}
+		mSelector->setBounds(8,104,120,24);
+		mNameEditor->setBounds(136,104,getWidth()-136-96,24);
+		mApplyButton->setBounds(getWidth()-88,104,80,24);
+		mTargetEditor->setBounds(8,136,getWidth()-16,getHeight()-136-32);
+	};
+
+	//-----------------------------------------------------------------------
+	void sliderDragStarted(Slider* slider)
+	{
+		mEngine.beginGesture(getKnobIndex(slider));
+	};
+
+	void sliderValueChanged(Slider* slider)
+	{
+		mEngine.setPosition(getKnobIndex(slider),roundToInt(slider->getValue()));
+	};
+
+	void sliderDragEnded(Slider*)
+	{
+		mEngine.endGesture();
+	};
+
+	void comboBoxChanged(ComboBox*)
+	{
+		showMacro(mSelector->getSelectedItemIndex());
+	};
+
+	void buttonClicked(Button*)
+	{
+		const int index = mSelector->getSelectedItemIndex();
+		if(index < 0) return;
+
+		MacroControl& control = mEngine.getControl(index);
+		String error;
+		if(!control.setDefinition(mTargetEditor->getText(),error))
+		{
+			mMessage = error;
+			repaint();
+			return;
+		}
+		control.setName(mNameEditor->getText().trim().isEmpty() ? "Macro " + String(index+1) : mNameEditor->getText().trim());
+		mEngine.saveConfig();
+
+		mMessage = control.getName() + " drives " + String(control.getNumTargets()) + " parameters";
+		updateControls();
+		repaint();
+	};
+
+private:
+	int getKnobIndex(Slider* slider) const
+	{
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			if(mKnobs[i] == slider) return i;
+		}
+		return 0;
+	};
+
+	void showMacro(int index)
+	{
+		if(index < 0) return;
+		const MacroControl& control = mEngine.getControl(index);
+		mNameEditor->setText(control.getName(),false);
+		mTargetEditor->setText(control.getDefinition(),false);
+	};
+
+	/** the names, and only macros with targets can be turned*/
+	void updateControls()
+	{
+		const int selected = mSelector->getSelectedItemIndex();
+		mSelector->clear(true);
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			const MacroControl& control = mEngine.getControl(i);
+			mSelector->addItem(String(i+1) + " " + control.getName(),i+1);
+			mNames[i]->setText(control.getName(),false);
+			mKnobs[i]->setEnabled(control.getNumTargets() > 0);
+		}
+		if(selected >= 0) mSelector->setSelectedItemIndex(selected,true);
+	};
+
+	MacroEngine mEngine;
+	bool mLoaded;
+	String mMessage;
+
+	Slider* mKnobs[MACRO_NUM_CONTROLS];
+	Label* mNames[MACRO_NUM_CONTROLS];
+	ComboBox* mSelector;
+	TextEditor* mNameEditor;
+	TextButton* mApplyButton;
+	TextEditor* mTargetEditor;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,418 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./parameterRanges.h"
+#include "./ParameterStore.h"
+#include "./MorphEngine.h"
+#include "./Midi/MidiTransmitter.h"
+#include "./Library/PatchQueryIndex.h"
+
+#define MACRO_NUM_CONTROLS		8
+#define MACRO_MAX_TARGETS		MAX_BURST_PARAMETERS	// a step of a macro is one burst
+#define MACRO_TABLE_SIZE		128		// knob positions, like a MIDI controller
+#define MACRO_STEP_MS			16		// one step per frame if the link keeps up
+#define MACRO_EXP_CURVATURE		4.0		// of the exp and log curves
+
+#define MACRO_CONFIG_FILE		"macros.cfg"	// next to midi.cfg
+#define MACRO_CONFIG_ROOT		"MACROS"
+#define MACRO_CONFIG_TAG		"MACRO"
+#define MACRO_NAME_ATTRIBUTE	"name"
+#define MACRO_TARGETS_ATTRIBUTE	"targets"
+
+//---------------------------------------------------------------------------
+/** One parameter a macro drives, from its value at knob position 0 to its
+	value at MACRO_TABLE_SIZE-1 along a curve. The values are the stored
+	ones, see MacroControl::parseTarget().
+*/
+struct MacroTarget
+{
+	enum Curve
+	{
+		CURVE_LINEAR = 0,
+		CURVE_EXPONENTIAL,	// slow at the start
+		CURVE_LOGARITHMIC,	// fast at the start
+		CURVE_S,			// slow at both ends
+		NUM_CURVES
+	};
+
+	int parameterNr;
+	int from;
+	int to;
+	int curve;
+};
+
+// as the definition of a macro names them
+static const char* const macroCurveNames[MacroTarget::NUM_CURVES] = { "lin", "exp", "log", "s" };
+
+//---------------------------------------------------------------------------
+/** A user defined macro knob: a name and up to MACRO_MAX_TARGETS targets.
+
+	The definition is text, one target per line as
+	"parameter [on voice n]: from to to [lin|exp|log|s]", with the names and
+	the signed values of a patch query. Every target gets a table of its
+	value at each of the MACRO_TABLE_SIZE knob positions when the
+	definition is set, so a move of the knob only looks them up. Discrete
+	parameters (see MorphEngine::isDiscrete()) jump from one value to the
+	other where the curve crosses the middle.
+*/
+class MacroControl
+{
+public:
+	MacroControl() : mNumTargets(0)
+	{
+		memset(mTables,0,sizeof(mTables));
+	};
+
+	/** returns false and says which line is wrong, the macro stays as it was then*/
+	bool setDefinition(const String& text, String& error)
+	{
+		StringArray lines;
+		lines.addLines(text);
+
+		MacroTarget targets[MACRO_MAX_TARGETS];
+		int numTargets = 0;
+		for(int i=0;i<lines.size();i++)
+		{
+			const String line = lines[i].trim();
+			if(line.isEmpty()) continue;
+			if(numTargets == MACRO_MAX_TARGETS)
+			{
+				error = "a macro has at most " + String(MACRO_MAX_TARGETS) + " targets";
+				return false;
+			}
+			if(!parseTarget(line,targets[numTargets],error))
+			{
+				error = "line " + String(i+1) + ": " + error;
+				return false;
+			}
+			numTargets++;
+		}
+
+		for(int i=0;i<numTargets;i++)
+		{
+			mTargets[i] = targets[i];
+			buildTable(mTargets[i],mTables[i]);
+		}
+		mNumTargets = numTargets;
+		mDefinition = text;
+		return true;
+	};
+
+	const String& getDefinition() const
+	{
+		return mDefinition;
+	};
+
+	void setName(const String& name)
+	{
+		mName = name;
+	};
+
+	const String& getName() const
+	{
+		return mName;
+	};
+
+	int getNumTargets() const
+	{
+		return mNumTargets;
+	};
+
+	const MacroTarget& getTarget(int index) const
+	{
+		return mTargets[index];
+	};
+
+	/** the value of a target at a knob position*/
+	int getValue(int index, int position) const
+	{
+		return mTables[index][position];
+	};
+
+	/** the targets whose value at a knob position differs from current (NUM_PARAMS values).
+		returns their number*/
+	int findChanges(int position, const uint8_t* current, int* parameterNrs, int* values) const
+	{
+		int num = 0;
+		for(int i=0;i<mNumTargets;i++)
+		{
+			const int parameterNr = mTargets[i].parameterNr;
+			const int value = mTables[i][position];
+			if(current[parameterNr] == value) continue;
+			parameterNrs[num] = parameterNr;
+			values[num] = value;
+			num++;
+		}
+		return num;
+	};
+
+	/** the shape of a curve at x, 0-1*/
+	static double evaluateCurve(int curve, double x)
+	{
+		switch(curve)
+		{
+		case MacroTarget::CURVE_EXPONENTIAL:	return (exp(MACRO_EXP_CURVATURE*x) - 1.0)/(exp(MACRO_EXP_CURVATURE) - 1.0);
+		case MacroTarget::CURVE_LOGARITHMIC:	return 1.0 - evaluateCurve(MacroTarget::CURVE_EXPONENTIAL,1.0-x);
+		case MacroTarget::CURVE_S:				return x*x*(3.0 - 2.0*x);
+		default:								return x;
+		}
+	};
+
+	/** the value of the target at every knob position*/
+	static void buildTable(const MacroTarget& target, uint8_t* table)
+	{
+		const bool discrete = MorphEngine::isDiscrete(target.parameterNr);
+		for(int i=0;i<MACRO_TABLE_SIZE;i++)
+		{
+			const double shape = evaluateCurve(target.curve,i/(double)(MACRO_TABLE_SIZE-1));
+			if(discrete)	table[i] = (uint8_t)(shape > 0.5 ? target.to : target.from);
+			else			table[i] = (uint8_t)roundToInt(target.from + (target.to - target.from)*shape);
+		}
+	};
+
+	/** "parameter [on voice n]: from to to [curve]"*/
+	static bool parseTarget(const String& line, MacroTarget& target, String& error)
+	{
+		const int colon = line.lastIndexOfChar(':');
+		if(colon < 0)
+		{
+			error = "expected \"parameter: from to to\"";
+			return false;
+		}
+		target.parameterNr = PatchQuery::parseParameter(line.substring(0,colon),error);
+		if(target.parameterNr < 0) return false;
+
+		StringArray tokens;
+		tokens.addTokens(line.substring(colon+1)," \t",String::empty);
+		tokens.removeEmptyStrings();
+		if(tokens.size() < 3 || tokens.size() > 4 || !tokens[1].equalsIgnoreCase("to"))
+		{
+			error = "expected \"from to to\" after the parameter";
+			return false;
+		}
+		if(!parseValue(target.parameterNr,tokens[0],target.from,error)) return false;
+		if(!parseValue(target.parameterNr,tokens[2],target.to,error)) return false;
+
+		target.curve = MacroTarget::CURVE_LINEAR;
+		if(tokens.size() == 4)
+		{
+			target.curve = -1;
+			for(int i=0;i<MacroTarget::NUM_CURVES;i++)
+			{
+				if(tokens[3].equalsIgnoreCase(macroCurveNames[i])) target.curve = i;
+			}
+			if(target.curve < 0)
+			{
+				error = "unknown curve \"" + tokens[3] + "\", use lin, exp, log or s";
+				return false;
+			}
+		}
+		return true;
+	};
+
+private:
+	/** the value the plugin shows, signed ones are stored with QUERY_PM_OFFSET like in a query*/
+	static bool parseValue(int parameterNr, const String& text, int& value, String& error)
+	{
+		const ParameterRange& range = getParameterRange(parameterNr);
+		if(text.isEmpty() || !text.containsOnly("-0123456789") || text.getIntValue() < range.min || text.getIntValue() > range.max)
+		{
+			error = "\"" + text + "\" is not a value of " + String(range.min) + " to " + String(range.max);
+			return false;
+		}
+		value = text.getIntValue() + (range.min < 0 ? QUERY_PM_OFFSET : 0);
+		return true;
+	};
+
+	String mName;
+	String mDefinition;
+	MacroTarget mTargets[MACRO_MAX_TARGETS];
+	uint8_t mTables[MACRO_MAX_TARGETS][MACRO_TABLE_SIZE];
+	int mNumTargets;
+};
+//---------------------------------------------------------------------------
+/** Moves the parameters of the MACRO_NUM_CONTROLS macros.
+
+	A step of a macro looks up the values of its targets at the knob
+	position and hands the ones that differ from the store to
+	ParameterStore::setValueBurst() in one batch, which sends them as one
+	burst with interactive priority. Like the MorphEngine a step waits
+	while the link still has more than MACRO_STEP_MS of data to send and
+	then goes to the newest position, so a fast turn over a DIN cable skips
+	positions instead of falling behind. A move between beginGesture() and
+	endGesture() is undone in one step. Message thread only.
+
+	The macros are saved to MACRO_CONFIG_FILE next to midi.cfg.
+*/
+class MacroEngine : private Timer
+{
+public:
+	MacroEngine() : mGesture(-1)
+	{
+		memset(mUndoStart,0,NUM_PARAMS);
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			mPositions[i] = mAppliedPositions[i] = 0;
+			mControls[i].setName("Macro " + String(i+1));
+		}
+	};
+
+	~MacroEngine()
+	{
+		stopTimer();
+	};
+
+	MacroControl& getControl(int index)
+	{
+		return mControls[index];
+	};
+
+	/** 0 to MACRO_TABLE_SIZE-1, sent with the next step the link has room for*/
+	void setPosition(int index, int position)
+	{
+		mPositions[index] = jlimit(0,MACRO_TABLE_SIZE-1,position);
+		if(!isTimerRunning())
+		{
+			timerCallback();
+			startTimer(MACRO_STEP_MS);
+		}
+	};
+
+	int getPosition(int index) const
+	{
+		return mPositions[index];
+	};
+
+	/** remembers the values the undo of the move goes back to*/
+	void beginGesture(int index)
+	{
+		memcpy(mUndoStart,ParameterStore::getInstance()->getValues(),NUM_PARAMS);
+		mGesture = index;
+	};
+
+	/** sends the last position right away and records the targets of the macro as one undo group*/
+	void endGesture()
+	{
+		stopTimer();
+		stepAll();
+		if(mGesture < 0) return;
+
+		const MacroControl& control = mControls[mGesture];
+		mGesture = -1;
+		ParameterStore* store = ParameterStore::getInstance();
+		const uint8_t* values = store->getValues();
+		store->beginUndoGroup();
+		for(int i=0;i<control.getNumTargets();i++)
+		{
+			const int parameterNr = control.getTarget(i).parameterNr;
+			store->getUndoLog().record(parameterNr,mUndoStart[parameterNr],values[parameterNr]);
+		}
+		store->endUndoGroup();
+	};
+
+	//-----------------------------------------------------------------------
+	static File getConfigFile()
+	{
+		return File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getChildFile(MACRO_CONFIG_FILE);
+	};
+
+	/** a macro whose definition doesn't parse any more keeps its name and no targets*/
+	void loadConfig()
+	{
+		XmlDocument doc(getConfigFile());
+		ScopedPointer<XmlElement> config(doc.getDocumentElement());
+		if(config == NULL || !config->hasTagName(MACRO_CONFIG_ROOT)) return;
+
+		int index = 0;
+		forEachXmlChildElementWithTagName(*config,child,MACRO_CONFIG_TAG)
+		{
+			if(index == MACRO_NUM_CONTROLS) break;
+			String error;
+			mControls[index].setName(child->getStringAttribute(MACRO_NAME_ATTRIBUTE,mControls[index].getName()));
+			mControls[index].setDefinition(child->getStringAttribute(MACRO_TARGETS_ATTRIBUTE),error);
+			index++;
+		}
+	};
+
+	void saveConfig()
+	{
+		XmlElement config(MACRO_CONFIG_ROOT);
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			XmlElement* child = config.createNewChildElement(MACRO_CONFIG_TAG);
+			child->setAttribute(MACRO_NAME_ATTRIBUTE,mControls[i].getName());
+			child->setAttribute(MACRO_TARGETS_ATTRIBUTE,mControls[i].getDefinition());
+		}
+		config.writeToFile(getConfigFile(),String::empty);
+	};
+
+private:
+	void timerCallback()
+	{
+		bool pending = false;
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			if(mAppliedPositions[i] != mPositions[i]) pending = true;
+		}
+		if(!pending)
+		{
+			stopTimer();
+			return;
+		}
+		//the wire is still busy with the last step, the next one goes to the newest position
+		if(MidiTransmitter::getInstance()->getEstimatedDrainTime() > MACRO_STEP_MS) return;
+		stepAll();
+	};
+
+	void stepAll()
+	{
+		for(int i=0;i<MACRO_NUM_CONTROLS;i++)
+		{
+			if(mAppliedPositions[i] != mPositions[i]) step(i);
+		}
+	};
+
+	void step(int index)
+	{
+		TRACE_SCOPE("ui","macro step");
+		ParameterStore* store = ParameterStore::getInstance();
+		int parameterNrs[MACRO_MAX_TARGETS];
+		int values[MACRO_MAX_TARGETS];
+		const int num = mControls[index].findChanges(mPositions[index],store->getValues(),parameterNrs,values);
+		if(num > 0) store->setValueBurst(parameterNrs,values,num);
+		mAppliedPositions[index] = mPositions[index];
+	};
+
+	MacroControl mControls[MACRO_NUM_CONTROLS];
+	int mPositions[MACRO_NUM_CONTROLS];
+	int mAppliedPositions[MACRO_NUM_CONTROLS];	// what the store has
+	uint8_t mUndoStart[NUM_PARAMS];				// the store values at beginGesture()
+	int mGesture;								// the macro between beginGesture() and endGesture(), or -1
+};
+//---------------------------------------------------------------------------
@@ -25,402 +25,503 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
-#include <time.h>
+#include "../FastRandom.h"
+#include "MarkovModel.h"
+#include "../FlatHashMap.h"
+#include "../TextTokenizer.h"
+#include "../Library/MappedFileData.h"
+
+#define MARKOV_INDEX_RESERVE	16384	// about the number of distinct contexts of namelist.txt
+#define MARKOV_MAX_NAME_LENGTH	8	// the patch name length, generated names are cut to it
+#define MARKOV_DEFAULT_ORDER	3	// letters of context, 2 gives wilder names, 4 ones closer to the list
+#define MARKOV_END_REDRAWS		4	// how often an end that comes too early is drawn again
+#define MARKOV_SHARD_SIZE		4096	// names one thread learns, smaller lists are learned on the calling thread
 
 //---------------------------------------------------------------------------
-class ChainElement
+/** hash of a (node, letter) pair packed into an int64*/
+class MarkovPairHash
 {
 public:
-	ChainElement(String data)
+	static int generateHash(const int64 key, const int upperLimit)
 	{
-		mData = data;
-		mBeginning = false;
-	}
-
-	~ChainElement()
+		const uint64 h = (uint64)key * literal64bit(0x9e3779b97f4a7c15);
+		return (int)((h >> 32) % (uint64)upperLimit);
+	};
+};
+//---------------------------------------------------------------------------
+/** The trie of a Markov model while it is learned, one entry per node and per
+	distinct (node, follower) pair. Several of them can count parts of a name
+	list on different threads and be merged afterwards.
+*/
+class MarkovCounter
+{
+public:
+	MarkovCounter() : mMaxOrder(MARKOV_MAX_ORDER), mNumNodes(0), mEdgeIndex(MARKOV_INDEX_RESERVE), mNextIndex(MARKOV_INDEX_RESERVE), mMemory(MEMORY_MARKOV),
+		mLetters(CharacterTable().keepOnly('a','z','a').map('A','Z','a'))
 	{
-		mParent = NULL;
-	}
+		clear(MARKOV_MAX_ORDER);
+	};
 
-	void setBeginning(bool isBeginning)
+	~MarkovCounter()
 	{
-		mBeginning = isBeginning;
-	}
+	};
 
-	bool isBeginning()
+	/** counts the letters of names[begin..end-1]*/
+	void countNames(const Array<TextToken>& names, int begin, int end)
 	{
-		return mBeginning;
-	}
+		//one buffer for the whole shard, it only grows for a name longer than all before
+		HeapBlock<uint8_t> letters;
+		int capacity = 0;
+		for(int i=begin;i<end;i++)
+		{
+			const TextToken& name = names.getReference(i);
+			if(name.length > capacity)
+			{
+				capacity = jmax(name.length,MARKOV_MAX_NAME_LENGTH*4);
+				letters.malloc(capacity);
+			}
 
-	String getData()
-	{
-		return mData;
+			//only letters are learned, in lower case
+			const int length = mLetters.apply(name,(char*)letters.getData(),capacity);
+			if(length > 0) countName(letters,length);
+		}
+		updateMemory();
 	}
 
-	int numChilds()
+	/** makes room for numNodes nodes and followers, so learning a list of about that many
+		contexts doesn't grow the tables step by step*/
+	void reserve(int numNodes)
 	{
-		return mChildren.size();
+		mEdgeParents.ensureStorageAllocated(numNodes);
+		mEdgeLetters.ensureStorageAllocated(numNodes);
+		mEdgeNodes.ensureStorageAllocated(numNodes);
+		mNextNodes.ensureStorageAllocated(numNodes);
+		mNextSymbols.ensureStorageAllocated(numNodes);
+		mNextCounts.ensureStorageAllocated(numNodes);
+		updateMemory();
 	}
 
-	ChainElement* getChild(int idx)
+	/** empties the trie and starts again with only the root*/
+	void clear(int maxOrder)
 	{
-		return mChildren[idx];
+		mMaxOrder = jlimit(1,MARKOV_MAX_ORDER,maxOrder);
+		mNumNodes = 0;
+		mEdgeIndex.clear();
+		mEdgeParents.clear();
+		mEdgeLetters.clear();
+		mEdgeNodes.clear();
+		mNextIndex.clear();
+		mNextNodes.clear();
+		mNextSymbols.clear();
+		mNextCounts.clear();
+		addNode(MARKOV_NO_NODE,0);
+		updateMemory();
 	}
 
-	void addChild(ChainElement* child)
+	/** adds the counts of another trie. its nodes are visited in the order they were
+		added, so a parent is always mapped before its children*/
+	void merge(const MarkovCounter& other)
 	{
-		mChildren.add(child);
+		Array<int> nodes;
+		nodes.insertMultiple(0,0,other.mNumNodes);
+		for(int i=0;i<other.mEdgeNodes.size();i++)
+		{
+			nodes.set(other.mEdgeNodes[i],getChild(nodes[other.mEdgeParents[i]],other.mEdgeLetters[i]));
+		}
+		for(int i=0;i<other.mNextNodes.size();i++)
+		{
+			countNext(nodes[other.mNextNodes[i]],other.mNextSymbols[i],other.mNextCounts[i]);
+		}
+		updateMemory();
 	}
 
-	void addEnd(ChainElement* end)
+	/** the trie in MarkovModel layout*/
+	void compile(MemoryBlock& dest) const
 	{
-		mEnding.add(end);
+		dest.setSize(0);
+		MemoryOutputStream out(dest,false);
+		out.writeInt(MARKOV_MODEL_MAGIC);
+		out.writeInt(MARKOV_MODEL_VERSION);
+		out.writeInt(mMaxOrder);
+		out.writeInt(mNumNodes);
+		out.writeInt(mEdgeNodes.size());
+		out.writeInt(mNextNodes.size());
+		out.writeInt(0);
+		out.writeInt(0);
+
+		//the edges of a node are sorted by letter for the binary search, two stable counting sorts do that
+		Array<int> all;
+		for(int i=0;i<mEdgeNodes.size();i++) all.add(i);
+		Array<int> letterKeys;
+		for(int i=0;i<mEdgeLetters.size();i++) letterKeys.add(mEdgeLetters[i]);
+		Array<int> offsets;
+		Array<int> byLetter;
+		countingSort(letterKeys,256,all,offsets,byLetter);
+		Array<int> edgeOrder;
+		countingSort(mEdgeParents,mNumNodes,byLetter,offsets,edgeOrder);
+
+		writeInts(out,offsets);
+		for(int i=0;i<(int)MarkovModel::getPaddedSize(edgeOrder.size());i++)
+		{
+			out.writeByte((char)(i < edgeOrder.size() ? mEdgeLetters[edgeOrder[i]] : 0));
+		}
+		for(int i=0;i<edgeOrder.size();i++)
+		{
+			out.writeInt(mEdgeNodes[edgeOrder[i]]);
+		}
+
+		//the followers are sorted by symbol too, then the model doesn't depend on how the counts were merged
+		all.clearQuick();
+		for(int i=0;i<mNextNodes.size();i++) all.add(i);
+		Array<int> symbolKeys;
+		for(int i=0;i<mNextSymbols.size();i++) symbolKeys.add(mNextSymbols[i]);
+		countingSort(symbolKeys,256,all,offsets,byLetter);
+		Array<int> nextOrder;
+		countingSort(mNextNodes,mNumNodes,byLetter,offsets,nextOrder);
+
+		writeInts(out,offsets);
+		for(int i=0;i<(int)MarkovModel::getPaddedSize(nextOrder.size());i++)
+		{
+			out.writeByte((char)(i < nextOrder.size() ? mNextSymbols[nextOrder[i]] : 0));
+		}
+		writeAliases(out,mNextNodes,mNextCounts,nextOrder);
 	}
 
-	ChainElement* getEnd(int idx)
+private:
+	/** the hash maps keep their slots when cleared, the arrays are counted by their size*/
+	void updateMemory()
 	{
-		return mEnding[idx];
-	}
+		const int edgeBytes = mEdgeParents.size()*(int)(sizeof(int)*2+sizeof(uint8_t));
+		const int nextBytes = mNextNodes.size()*(int)(sizeof(int)*2+sizeof(uint8_t));
+		mMemory.setBytes(mEdgeIndex.getMemorySize() + mNextIndex.getMemorySize() + edgeBytes + nextBytes);
+	};
 
-	int numEnds()
+	/** counts the follower of every position of a name in all its contexts*/
+	void countName(const uint8_t* letters, int length)
 	{
-		return mEnding.size();
+		for(int i=0;i<=length;i++)
+		{
+			const uint8_t symbol = i<length ? letters[i] : (uint8_t)MARKOV_END;
+
+			int node = 0;
+			countNext(node,symbol);
+			for(int d=1;d<=mMaxOrder;d++)
+			{
+				//the context is read backwards, before the first letter there is only MARKOV_BEGIN
+				const uint8_t letter = i-d >= 0 ? letters[i-d] : (uint8_t)MARKOV_BEGIN;
+				node = getChild(node,letter);
+				countNext(node,symbol);
+				if(letter == MARKOV_BEGIN) break;
+			}
+		}
 	}
 
-	void setParent(ChainElement* parent)
+	int addNode(int parent, uint8_t letter)
 	{
-		mParent = parent;
+		const int node = mNumNodes++;
+		if(parent != MARKOV_NO_NODE)
+		{
+			mEdgeIndex.set(((int64)parent << 8) | letter,node);
+			mEdgeParents.add(parent);
+			mEdgeLetters.add(letter);
+			mEdgeNodes.add(node);
+		}
+		return node;
 	}
 
-	ChainElement* getParent()
+	int getChild(int node, uint8_t letter)
 	{
-		return mParent;
+		const int* child = mEdgeIndex.find(((int64)node << 8) | letter);
+		if(child != NULL) return *child;
+		return addNode(node,letter);
 	}
-private:
-	bool mBeginning;
-	String mData;
-	Array<ChainElement*> mChildren;
-	Array<ChainElement*> mEnding;
-	ChainElement* mParent;
-};
-//---------------------------------------------------------------------------
-class Markov
-{
 
-public:
-	Markov()
+	void countNext(int node, uint8_t symbol, int count = 1)
 	{
-		srand(time(NULL));
-		learn(File(File::getCurrentWorkingDirectory().getFullPathName() + String("/resources/namelist.txt")),3);
+		const int64 key = ((int64)node << 8) | symbol;
+		const int* entry = mNextIndex.find(key);
+		if(entry != NULL)
+		{
+			mNextCounts.getReference(*entry) += count;
+		}
+		else
+		{
+			mNextIndex.set(key,mNextNodes.size());
+			mNextNodes.add(node);
+			mNextSymbols.add(symbol);
+			mNextCounts.add(count);
+		}
 	}
 
-	~Markov()
+	/** sorts input stably by keys[input[i]] into order and fills numKeys+1 offsets of the groups*/
+	static void countingSort(const Array<int>& keys, int numKeys, const Array<int>& input, Array<int>& offsets, Array<int>& order)
 	{
+		offsets.clearQuick();
+		offsets.insertMultiple(0,0,numKeys+1);
+		for(int i=0;i<input.size();i++)
+		{
+			const int k = keys[input[i]];
+			offsets.set(k+1,offsets[k+1]+1);
+		}
+		for(int k=0;k<numKeys;k++)
+		{
+			offsets.set(k+1,offsets[k+1]+offsets[k]);
+		}
 
-	}
-	//min not used yet!!!
-	String generateName(int min, int max)
+		Array<int> next(offsets);
+		order.clearQuick();
+		order.insertMultiple(0,0,input.size());
+		for(int i=0;i<input.size();i++)
+		{
+			const int k = keys[input[i]];
+			order.set(next[k],input[i]);
+			next.set(k,next[k]+1);
+		}
+	};
+
+	static void writeInts(OutputStream& out, const Array<int>& values)
 	{
-		String name;
+		for(int i=0;i<values.size();i++)
+		{
+			out.writeInt(values[i]);
+		}
+	};
 
-			int rnd = rand()%mChain.size();
-			ChainElement* startToken = mChain[rnd];
-			while(!isValidStartToken(startToken))
-			{
-				rnd = rand()%mChain.size();
-				startToken = mChain[rnd];
+	/** one alias table per node, built from the counts of its followers*/
+	static void writeAliases(OutputStream& out, const Array<int>& parents, const Array<int>& counts, const Array<int>& order)
+	{
+		Array<int> listCounts;
+		Array<int> table;
+		for(int begin=0;begin<order.size();)
+		{
+			int end = begin+1;
+			while(end < order.size() && parents[order[end]] == parents[order[begin]]) end++;
 
-			}
+			listCounts.clearQuick();
+			for(int i=begin;i<end;i++) listCounts.add(counts[order[i]]);
+			table.clearQuick();
+			table.insertMultiple(0,0,(end-begin)*2);
+			MarkovModel::buildAliasTable(listCounts.getRawDataPointer(),end-begin,table.getRawDataPointer());
 
-			name.append(startToken->getData(),mOrder);
+			writeInts(out,table);
+			begin = end;
+		}
+	};
+
+	int mMaxOrder;
+	int mNumNodes;
+	FlatHashMap<int64,int,MarkovPairHash> mEdgeIndex;	// (node << 8 | letter) -> child node
+	Array<int> mEdgeParents;
+	Array<uint8_t> mEdgeLetters;
+	Array<int> mEdgeNodes;
+	FlatHashMap<int64,int,MarkovPairHash> mNextIndex;	// (node << 8 | symbol) -> next entry
+	Array<int> mNextNodes;
+	Array<uint8_t> mNextSymbols;
+	Array<int> mNextCounts;					// how often the symbol followed the context
+	MemoryAccount mMemory;
+	const CharacterTable mLetters;	// A-Z to lower case, a-z, nothing else
+};
+//---------------------------------------------------------------------------
+/** Generates names letter by letter from the name list.
 
-			appendNextToken(&name,max,startToken);
-		
+	The list is learned once into a trie of contexts up to MARKOV_MAX_ORDER
+	letters (see MarkovModel), so every order from 1 to MARKOV_MAX_ORDER can
+	be generated from the same model. The trie only holds contexts that
+	occur in the list, its size grows with the list and not with the order.
+*/
+class Markov
+{
 
-			name = name.toLowerCase();
-			char *n = name.toUTF8().getAddress();
-			n[0] -= 32;
-			return n;
+public:
+	Markov()
+	{
+		loadNamelist();
 	}
 
-	bool isValidStartToken(ChainElement* e)
+	/** uses a compiled model in place, e.g. one embedded into the editor. the data
+		has to outlive the Markov. an invalid model is replaced by the learned list*/
+	Markov(const void* compiledModel, size_t size)
 	{
-
-#if 1
-		//needs children
-		if(e->numChilds()<=0) return false;
-		if(e->isBeginning()) return true;
-		return false;
-#else
-		//needs children
-		if(e->numChilds()<=0) return false;
-		//should be vowel/consonant  or Consonant/vowel
-		if(isVowel(e->getData()[0]))
+		if(!mModel.openFromStaticData(compiledModel,size))
 		{
-			//1st vowel
-			//check second vowel
-			if(isVowel(e->getData()[1]))
-			{
-				return false;
-			}
-			return true;
+			loadNamelist();
 		}
-		else
-		{
-			//check second vowel
-			if(isVowel(e->getData()[1]))
-			{
-				return true;
-			}
-			return false;
-		}
-
-		return true;
-#endif
 	}
 
-	bool isVowel(char c)
+	~Markov()
 	{
-		if(c=='a') return true;
-		if(c=='e') return true;
-		if(c=='i') return true;
-		if(c=='o') return true;
-		if(c=='u') return true;
-		return false;
+
 	}
 
-	void appendNextToken(String* name, int max, ChainElement* token)
+	/** writes a 0 terminated name into name, which has to hold MARKOV_MAX_NAME_LENGTH+1 bytes.
+		order is the number of letters of context, it is limited to what the model learned.
+		returns the length. nothing is allocated and the model is only read, so several threads
+		can generate names at once with their own random*/
+	int generateName(int order, int min, int max, FastRandom& random, char* name) const
 	{
-		ChainElement* e = NULL;
-		if(name->length()+mOrder<=max)
+		name[0] = 0;
+		if(!mModel.isOpen()) return 0;
+		order = jlimit(1,mModel.getMaxOrder(),order);
+		max = jmin(max,MARKOV_MAX_NAME_LENGTH);
+
+		int length = 0;
+		int redraws = 0;
+		while(length < max)
 		{
-			if(token->numChilds() >0)
-			{
-				int rnd = rand()%token->numChilds();
+			const int node = findContext(name,length,order);
+			uint8_t symbol = mModel.pickNext(node,random);
 
-			
+			//a name that is too short only ends if the context has nothing else
+			while(symbol == MARKOV_END && length < min && redraws < MARKOV_END_REDRAWS && mModel.getNumNexts(node) > 1)
+			{
+				symbol = mModel.pickNext(node,random);
+				redraws++;
+			}
+			if(symbol == MARKOV_END) break;
 
-				e = token->getChild(rnd);
+			name[length++] = (char)symbol;
+		}
+		name[length] = 0;
 
-				name->append(e->getData(),mOrder);
+		//the letters are learned in lower case
+		if(name[0] >= 'a' && name[0] <= 'z') name[0] -= 32;
+		return length;
+	}
 
-				appendNextToken(name,max,e);
-			}
-		}
-		if(name->length()<max)
+	/** appends up to maxChars of text behind name[length], never past MARKOV_MAX_NAME_LENGTH.
+		returns the new length*/
+	static int appendText(char* name, int length, const char* text, int maxChars)
+	{
+		for(int i=0;i<maxChars && text[i] != 0 && length < MARKOV_MAX_NAME_LENGTH;i++)
 		{
-			if(token!=NULL && token->numEnds())
-			{
-				int rnd = rand()%token->numEnds();
-				name->append(token->getEnd(rnd)->getData(),token->getEnd(rnd)->getData().length());
-			}
-			
+			name[length++] = text[i];
 		}
+		name[length] = 0;
+		return length;
 	}
 
-	/**read namelist and build chains of specified order*/
-	void learn(File namelist, int order)
+	/**read namelist and count every context of up to maxOrder letters.
+		long lists are counted in shards of MARKOV_SHARD_SIZE names on a thread pool
+		and merged in shard order, so the model does not depend on the number of cpus*/
+	void learn(File namelist, int maxOrder)
 	{
-		mOrder = order;
+		maxOrder = jlimit(1,MARKOV_MAX_ORDER,maxOrder);
 
-		StringArray names;
-
-		if(namelist.exists())
+		//the names point into the mapped list, it is kept until they are counted
+		const MappedFileData::Ptr mapping(MappedFileData::open(namelist));
+		Array<TextToken> names;
+		if(mapping != NULL)
 		{
-			
-			ScopedPointer<FileInputStream> input = namelist.createInputStream();
-			
-			while(!input->isExhausted())
-			{
-				String line = input->readNextLine();
-				if(line != String::empty)
-					names.addTokens(line," ",String::empty);
-			}
+			names.ensureStorageAllocated((int)(mapping->getSize()/MARKOV_MAX_NAME_LENGTH));
+			TextTokenizer(mapping->getData(),mapping->getSize()," " TEXT_LINE_SEPARATORS).getTokens(names);
 		}
 		else
-			jassertfalse;
+			jassert(namelist.existsAsFile());
 
-#if 0
-//save optimized name list
-		
-		
+		const int numShards = jmax(1,jmin(SystemStats::getNumCpus(),(names.size()+MARKOV_SHARD_SIZE-1)/MARKOV_SHARD_SIZE));
 
-		for(int i=0;i<names.size();i++)
+		mCounter.clear(maxOrder);
+		mCounter.reserve(MARKOV_INDEX_RESERVE);
+		if(numShards == 1)
 		{
-			
-			names.set(i,names[i].removeCharacters(String("!\"#$%&'()*+,-./[]\^_`:;<=>?")));
-
-			if(names[i].length() < 4)
-			{
-				names.remove(i);
-				i--;
-			}
-
+			mCounter.countNames(names,0,names.size());
+			return;
 		}
 
-		names.removeDuplicates(true);
-		names.sort(true);
-		
-		String list = names.joinIntoString(String("\n"));
-		File outfile(File::getCurrentWorkingDirectory().getFullPathName() + String("/namelist_out.txt"));
-		outfile.create();
-		outfile.replaceWithText(list);
+		OwnedArray<MarkovCounter> shards;
+		OwnedArray<LearnJob> jobs;
+		ThreadPool pool(numShards);
+		const int shardSize = (names.size()+numShards-1)/numShards;
+		for(int i=0;i<numShards;i++)
+		{
+			MarkovCounter* counter = new MarkovCounter();
+			counter->clear(maxOrder);
+			shards.add(counter);
 
-#endif
+			LearnJob* job = new LearnJob(*counter,names,i*shardSize,jmin(names.size(),(i+1)*shardSize));
+			jobs.add(job);
+			pool.addJob(job);
+		}
 
-		buildChains(names);
+		for(int i=0;i<numShards;i++)
+		{
+			pool.waitForJobToFinish(jobs[i],-1);
+			mCounter.merge(*shards[i]);
+		}
 	}
 
 private:
-
-	void buildChains(StringArray names)
+	/** learns resources/namelist.txt of the working directory, or maps the model compiled from it*/
+	void loadNamelist()
 	{
+		const File namelist(File::getCurrentWorkingDirectory().getFullPathName() + String("/resources/namelist.txt"));
+		const File compiled(namelist.withFileExtension(MARKOV_MODEL_EXTENSION));
 
-		String token;
-			String prevToken;
-		
-		for(int i=0;i<names.size();i++)
+		//the compiled model is mapped as it is, the text list is only learned again when it changed
+		if(compiled.getLastModificationTime() < namelist.getLastModificationTime() || !mModel.open(compiled))
 		{
-			token = String::empty;
-			prevToken = String::empty;
-
+			learn(namelist,MARKOV_MAX_ORDER);
 
-			String name = names[i];
-
-			int j=0;
-			for(j=0;(j+mOrder)<=name.length();)
+			MemoryBlock model;
+			mCounter.compile(model);
+			if(!writeModel(compiled,model) || !mModel.open(compiled))
 			{
-				
-				int breakCnt=0;
-				for(int k=0;k<mOrder;)
-				{
-					if(j+k+breakCnt < name.length())
-					{
-						char letter = name[j+k+breakCnt];
-						if(letter >= 'A' && letter <= 'z')
-						{
-							k++;
-							token.append(&letter,1);
-							
-						}
-						else
-						{
-							breakCnt++;
-							if(breakCnt>=10) break;
-						}
-					}
-					else break;
-					
-					
-				}
-
-				
-
-				ChainElement* e = addTokenToChain(token,prevToken);
-
-				if(j==0)
-				{
-					//if it is the first element of a word set beginning flag
-					e->setBeginning(true);
-				}
-
-			
-				prevToken = token;
-				token = String::empty;
-				
-
-
-				j += mOrder;
-			}
-			int length = name.length();
-			bool compare = (j<length);
-			
-			if(compare)
-			{
-				int test = 1;
-				//we have some letters left
-				String end;
-				while(j<name.length())
-				{
-					char letter[2];
-					letter[0]= name[j++];
-					letter[1]=0;
-					end.append(letter,1);
-				}
-				addEndTokenToChain(end,prevToken);
+				//e.g. a read only install folder
+				mModel.openFromMemory(model);
 			}
 
-			
+			//generating only needs the compiled model
+			mCounter.clear(1);
 		}
 	}
 
-	void addEndTokenToChain(String token, String prev)
+	/** the deepest known context of the last order letters of name*/
+	int findContext(const char* name, int length, int order) const
 	{
-
-		token = token.toLowerCase();
-		prev = prev.toLowerCase();
-
-		
-		ChainElement* end;
-		end = new ChainElement(token);
-			
-		ChainElement* e = chainContainsToken(prev);
-		if(e!=NULL)
-			e->addEnd(end);
-
-
-	}
-
-	ChainElement* addTokenToChain(String token, String prev)
-	{
-
-		token = token.toLowerCase();
-		prev = prev.toLowerCase();
-
-		//check if token is already in chain
-		ChainElement* element = chainContainsToken(token);
-
-		if(element == NULL)
+		int node = 0;
+		for(int d=1;d<=order;d++)
 		{
-			//non existent yet
-			element = new ChainElement(token);
-			
-			mChain.add(element);
-		}
-		else
-		{
-			//allready existing
-			if(prev != String::empty)
-			{
-				//if we know the previous token we can add this token to its list of children
-				ChainElement* e = chainContainsToken(prev);
-				jassert(e!=NULL);
-				e->addChild(element);
-			}
-		}
-
-		return element;
+			const uint8_t letter = length-d >= 0 ? (uint8_t)name[length-d] : (uint8_t)MARKOV_BEGIN;
+			const int child = mModel.findChild(node,letter);
+			if(child == MARKOV_NO_NODE) break;
 
+			node = child;
+			if(letter == MARKOV_BEGIN) break;
+		}
+		return node;
 	}
 
-	ChainElement* chainContainsToken(String token)
+	static bool writeModel(const File& file, const MemoryBlock& model)
 	{
-		for(int i=0;i<mChain.size();i++)
-		{
-			if((mChain[i]->getData() == token))
-			{
-						return mChain[i];
-				
-			}
-		}
-		return NULL;
+		TemporaryFile temp(file);
+		if(!temp.getFile().replaceWithData(model.getData(),model.getSize())) return false;
+		return temp.overwriteTargetFileWithTemporary();
 	}
 
 private:
-	int mOrder;
+	/** counts one shard of the name list*/
+	class LearnJob : public ThreadPoolJob
+	{
+	public:
+		LearnJob(MarkovCounter& counter, const Array<TextToken>& names, int begin, int end)
+			: ThreadPoolJob("markov learn"), mCounter(counter), mNames(names), mBegin(begin), mEnd(end)
+		{
+		};
 
-	OwnedArray<ChainElement> mChain;
-	
-	
- 
- };
\ No newline at end of file
+		JobStatus runJob()
+		{
+			mCounter.countNames(mNames,mBegin,mEnd);
+			return jobHasFinished;
+		};
+
+	private:
+		MarkovCounter& mCounter;
+		const Array<TextToken>& mNames;
+		int mBegin;
+		int mEnd;
+	};
+
+	MarkovCounter mCounter;	// the trie while learning
+	MarkovModel mModel;	// what names are generated from, the trie is only needed while learning
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,334 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../FastRandom.h"
+#include "../MemoryAccounting.h"
+
+#define MARKOV_MODEL_MAGIC		0x4d4d5053	// "SPMM" little endian
+#define MARKOV_MODEL_VERSION	4
+#define MARKOV_MODEL_EXTENSION	".smm"
+#define MARKOV_MODEL_HEADER_SIZE	32
+
+#define MARKOV_MAX_ORDER		4	// the longest context the trie keeps
+#define MARKOV_END				0	// the symbol that ends a name
+#define MARKOV_BEGIN			1	// the context before the first letter of a name
+#define MARKOV_NO_NODE			-1
+
+//---------------------------------------------------------------------------
+/** A learned variable order Markov model in one flat block that can be mapped
+	from disk as is.
+
+	The model is a trie of contexts. The path from the root to a node spells
+	a context backwards, the last letter first, and is at most
+	MARKOV_MAX_ORDER letters long. A context that reaches back before the
+	start of a name ends with MARKOV_BEGIN. Every node counts the letters
+	(or MARKOV_END) that followed its context. Generating at order n walks
+	at most n letters down from the root; the deepest node that exists is
+	used, so an unknown context backs off to a shorter one. One trie serves
+	all orders up to MARKOV_MAX_ORDER.
+
+	header	magic, version, max order, number of nodes, number of edges,
+			number of next entries, 2 reserved ints
+	child offsets	numNodes+1 ints, the children of node n are
+			edges[offset[n]] .. edges[offset[n+1]-1], sorted by letter
+	edge letters	one byte per edge, padded to a multiple of 4
+	edge nodes	the child node of every edge
+	next offsets	numNodes+1 ints, same scheme for the followers
+	next symbols	one byte per next entry, padded to a multiple of 4
+	next aliases	per next entry an alias table entry (Vose): a threshold
+			and the index of the alias within the same list
+
+	Node 0 is the root, the empty context. All ints are little endian.
+	Opening a model only checks the sizes and indices, there is nothing to
+	parse. Picking from an alias table takes two random numbers: one selects
+	an entry, the other decides between the entry and its alias. Every
+	follower then comes up as often as it was learned, in constant time.
+*/
+class MarkovModel
+{
+public:
+	MarkovModel() : mMemory(MEMORY_MARKOV)
+	{
+		reset();
+	};
+
+	~MarkovModel()
+	{
+	};
+
+	/** map a compiled model file. returns false if it is missing or invalid*/
+	bool open(const File& file)
+	{
+		close();
+
+		mMappedFile = new MemoryMappedFile(file,MemoryMappedFile::readOnly);
+		if(!setData((const uint8_t*)mMappedFile->getData(),mMappedFile->getSize()))
+		{
+			close();
+			return false;
+		}
+		//not from the heap, but the pages are read by every name
+		mMemory.setBytes((int)mMappedFile->getSize());
+		return true;
+	};
+
+	/** use a model that was compiled into memory, the data is copied*/
+	bool openFromMemory(const MemoryBlock& data)
+	{
+		close();
+
+		mOwnedData = data;
+		if(!setData((const uint8_t*)mOwnedData.getData(),mOwnedData.getSize()))
+		{
+			close();
+			return false;
+		}
+		mMemory.setBytes((int)mOwnedData.getSize());
+		return true;
+	};
+
+	/** use a model that stays in memory longer than this one, e.g. one compiled
+		into the editor. nothing is copied*/
+	bool openFromStaticData(const void* data, size_t size)
+	{
+		close();
+
+		if(!setData((const uint8_t*)data,size))
+		{
+			close();
+			return false;
+		}
+		return true;
+	};
+
+	void close()
+	{
+		mMappedFile = NULL;
+		mOwnedData.setSize(0);
+		mMemory.setBytes(0);
+		reset();
+	};
+
+	bool isOpen() const
+	{
+		return mData != NULL;
+	};
+
+	int getMaxOrder() const			{ return mMaxOrder; };
+	int getNumNodes() const			{ return mNumNodes; };
+
+	/** the child of node for one more letter of context or MARKOV_NO_NODE*/
+	int findChild(int node, uint8_t letter) const
+	{
+		int lo = readInt(mChildOffsets,node);
+		int hi = readInt(mChildOffsets,node+1);
+		while(lo < hi)
+		{
+			const int mid = (lo+hi)/2;
+			if(mEdgeLetters[mid] < letter)		lo = mid+1;
+			else if(mEdgeLetters[mid] > letter)	hi = mid;
+			else return readInt(mEdgeNodes,mid);
+		}
+		return MARKOV_NO_NODE;
+	};
+
+	int getNumNexts(int node) const
+	{
+		return readInt(mNextOffsets,node+1) - readInt(mNextOffsets,node);
+	};
+
+	/** a random follower of the context, weighted by how often it was learned. the node needs followers*/
+	uint8_t pickNext(int node, FastRandom& random) const
+	{
+		const int begin = readInt(mNextOffsets,node);
+		const int i = random.nextInt(getNumNexts(node));
+		if(random.next() < (uint32)readInt(mNextAliases,(begin+i)*2)) return mNextSymbols[begin+i];
+		return mNextSymbols[begin + readInt(mNextAliases,(begin+i)*2+1)];
+	};
+
+	/** the number of bytes of a model with these sizes*/
+	static size_t getModelSize(int numNodes, int numEdges, int numNexts)
+	{
+		return MARKOV_MODEL_HEADER_SIZE
+			+ (size_t)(numNodes+1)*4 + getPaddedSize(numEdges) + (size_t)numEdges*4
+			+ (size_t)(numNodes+1)*4 + getPaddedSize(numNexts) + (size_t)numNexts*8;
+	};
+
+	/** byte lists are padded so the ints after them stay aligned*/
+	static size_t getPaddedSize(int numBytes)
+	{
+		return ((size_t)numBytes+3) & ~(size_t)3;
+	};
+
+	/** fills an alias table for counts[0..num-1] as 2 ints per entry (threshold, alias).
+		All integer, so the table stays exact for any counts.*/
+	static void buildAliasTable(const int* counts, int num, int* table)
+	{
+		int64 total = 0;
+		for(int i=0;i<num;i++) total += counts[i];
+
+		//scaled[i] = counts[i]*num, an entry is full when it reaches total
+		HeapBlock<int64> scaled(num);
+		HeapBlock<int> small(num);
+		HeapBlock<int> large(num);
+		int numSmall = 0;
+		int numLarge = 0;
+		for(int i=0;i<num;i++)
+		{
+			scaled[i] = (int64)counts[i]*num;
+			if(scaled[i] < total)	small[numSmall++] = i;
+			else					large[numLarge++] = i;
+		}
+
+		while(numSmall > 0 && numLarge > 0)
+		{
+			const int s = small[--numSmall];
+			const int l = large[numLarge-1];
+			table[s*2] = (int)(uint32)((scaled[s] << 32) / total);
+			table[s*2+1] = l;
+
+			//the large entry gives what the small one lacks
+			scaled[l] -= total - scaled[s];
+			if(scaled[l] < total)
+			{
+				numLarge--;
+				small[numSmall++] = l;
+			}
+		}
+
+		//full entries are their own alias
+		while(numLarge > 0)
+		{
+			const int l = large[--numLarge];
+			table[l*2] = 0;
+			table[l*2+1] = l;
+		}
+		while(numSmall > 0)
+		{
+			//only left by an empty total
+			const int s = small[--numSmall];
+			table[s*2] = 0;
+			table[s*2+1] = s;
+		}
+	};
+
+private:
+	void reset()
+	{
+		mData = NULL;
+		mMaxOrder = 0;
+		mNumNodes = 0;
+		mChildOffsets = NULL;
+		mEdgeLetters = NULL;
+		mEdgeNodes = NULL;
+		mNextOffsets = NULL;
+		mNextSymbols = NULL;
+		mNextAliases = NULL;
+	};
+
+	bool setData(const uint8_t* data, size_t size)
+	{
+		if(data == NULL || size < MARKOV_MODEL_HEADER_SIZE
+			|| readInt(data,0) != MARKOV_MODEL_MAGIC
+			|| readInt(data,1) != MARKOV_MODEL_VERSION)
+		{
+			return false;
+		}
+
+		const int maxOrder = readInt(data,2);
+		const int numNodes = readInt(data,3);
+		const int numEdges = readInt(data,4);
+		const int numNexts = readInt(data,5);
+		if(maxOrder <= 0 || maxOrder > MARKOV_MAX_ORDER || numNodes <= 0 || numEdges < 0 || numNexts < 0
+			|| getModelSize(numNodes,numEdges,numNexts) > size)
+		{
+			return false;
+		}
+
+		const uint8_t* p = data + MARKOV_MODEL_HEADER_SIZE;
+		mChildOffsets = p;		p += (size_t)(numNodes+1)*4;
+		mEdgeLetters = p;		p += getPaddedSize(numEdges);
+		mEdgeNodes = p;			p += (size_t)numEdges*4;
+		mNextOffsets = p;		p += (size_t)(numNodes+1)*4;
+		mNextSymbols = p;		p += getPaddedSize(numNexts);
+		mNextAliases = p;
+
+		//the offsets and indices have to stay inside their lists, then no accessor can leave the block
+		if(!checkOffsets(mChildOffsets,numNodes,numEdges) || !checkOffsets(mNextOffsets,numNodes,numNexts))
+		{
+			return false;
+		}
+		for(int i=0;i<numEdges;i++)
+		{
+			if((uint32)readInt(mEdgeNodes,i) >= (uint32)numNodes) return false;
+		}
+		for(int n=0;n<numNodes;n++)
+		{
+			const int begin = readInt(mNextOffsets,n);
+			const int num = readInt(mNextOffsets,n+1) - begin;
+			for(int i=begin;i<begin+num;i++)
+			{
+				if((uint32)readInt(mNextAliases,i*2+1) >= (uint32)num) return false;
+			}
+		}
+
+		mData = data;
+		mMaxOrder = maxOrder;
+		mNumNodes = numNodes;
+		return true;
+	};
+
+	static bool checkOffsets(const uint8_t* offsets, int numNodes, int numEntries)
+	{
+		if(readInt(offsets,0) != 0 || readInt(offsets,numNodes) != numEntries) return false;
+		for(int n=0;n<numNodes;n++)
+		{
+			if(readInt(offsets,n) > readInt(offsets,n+1)) return false;
+		}
+		return true;
+	};
+
+	static int readInt(const uint8_t* data, int index)
+	{
+		return (int)ByteOrder::littleEndianInt(data + index*4);
+	};
+
+	ScopedPointer<MemoryMappedFile> mMappedFile;
+	MemoryBlock mOwnedData;
+	MemoryAccount mMemory;		// the mapped or owned data, a static model isn't counted
+
+	const uint8_t* mData;
+	int mMaxOrder;
+	int mNumNodes;
+	const uint8_t* mChildOffsets;
+	const uint8_t* mEdgeLetters;
+	const uint8_t* mEdgeNodes;
+	const uint8_t* mNextOffsets;
+	const uint8_t* mNextSymbols;
+	const uint8_t* mNextAliases;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,205 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+/** the subsystems whose memory is accounted*/
+enum MemoryTags
+{
+	MEMORY_MARKOV = 0,	// the name model and the tries it is learned with
+	MEMORY_PATCHES,		// Patch objects
+	MEMORY_IMAGES,		// the knob film strip and its scaled frames
+	MEMORY_UNDO,		// the parameter undo log
+	NUM_MEMORY_TAGS
+};
+
+//---------------------------------------------------------------------------
+/** Live bytes and allocation counts per subsystem.
+
+	juce's LeakedObjectDetector counts the instances of a class with a
+	member that is constructed and destroyed with its owner. The same is
+	done here per subsystem and in bytes: a MemoryAccount member charges
+	the buffers of its owner to a tag, MEMORY_ACCOUNTED() charges the
+	object itself. Most of the memory is in juce Arrays and HeapBlocks,
+	which take it from malloc() and not from operator new, so the owners
+	tell their size whenever they resize.
+
+	numAllocations counts every new size of an account, so a buffer that
+	grows in steps shows up as often as it was reallocated. Everything is
+	atomic, accounts can be changed on any thread.
+*/
+class MemoryAccounting
+{
+public:
+	static void allocated(int tag, int bytes)
+	{
+		Counters& c = sCounters[tag];
+		++c.numLive;
+		++c.numAllocations;
+		const int live = (c.liveBytes += bytes);
+
+		int peak;
+		do
+		{
+			peak = c.peakBytes.get();
+		} while(live > peak && !c.peakBytes.compareAndSetBool(live,peak));
+	};
+
+	static void freed(int tag, int bytes)
+	{
+		Counters& c = sCounters[tag];
+		--c.numLive;
+		c.liveBytes -= bytes;
+	};
+
+	static int getLiveBytes(int tag)
+	{
+		return sCounters[tag].liveBytes.get();
+	};
+
+	/** the most live bytes since the start or resetPeaks()*/
+	static int getPeakBytes(int tag)
+	{
+		return sCounters[tag].peakBytes.get();
+	};
+
+	/** blocks and objects that are allocated right now*/
+	static int getNumLive(int tag)
+	{
+		return sCounters[tag].numLive.get();
+	};
+
+	/** allocations since the start, freed ones included*/
+	static int getNumAllocations(int tag)
+	{
+		return sCounters[tag].numAllocations.get();
+	};
+
+	static void resetPeaks()
+	{
+		for(int i=0;i<NUM_MEMORY_TAGS;i++)
+		{
+			sCounters[i].peakBytes.set(sCounters[i].liveBytes.get());
+		}
+	};
+
+	static const char* getTagName(int tag)
+	{
+		const char* const names[] = { "markov", "patches", "images", "undo" };
+		return names[tag];
+	};
+
+	/** e.g. "1.25 MB"*/
+	static String formatBytes(int bytes)
+	{
+		if(bytes < 1024) return String(bytes) + " bytes";
+		if(bytes < 1024*1024) return String(bytes/1024.,1) + " kB";
+		return String(bytes/(1024.*1024.),2) + " MB";
+	};
+
+private:
+	struct Counters
+	{
+		Atomic<int> liveBytes;
+		Atomic<int> peakBytes;
+		Atomic<int> numLive;
+		Atomic<int> numAllocations;
+	};
+
+	static Counters sCounters[NUM_MEMORY_TAGS];
+};
+
+//---------------------------------------------------------------------------
+/** Charges the memory of its owner's buffers to a tag, give it the new size
+	after each resize. A copy charges the same size again, like the copy of
+	the owner's buffers. The tag stays with the account, also on assignment.
+*/
+class MemoryAccount
+{
+public:
+	explicit MemoryAccount(int tag) : mTag(tag), mBytes(0)
+	{
+	};
+
+	MemoryAccount(const MemoryAccount& other) : mTag(other.mTag), mBytes(0)
+	{
+		setBytes(other.mBytes);
+	};
+
+	MemoryAccount& operator= (const MemoryAccount& other)
+	{
+		setBytes(other.mBytes);
+		return *this;
+	};
+
+	~MemoryAccount()
+	{
+		setBytes(0);
+	};
+
+	void setBytes(int bytes)
+	{
+		if(bytes == mBytes) return;
+		if(mBytes > 0) MemoryAccounting::freed(mTag,mBytes);
+		if(bytes > 0) MemoryAccounting::allocated(mTag,bytes);
+		mBytes = bytes;
+	};
+
+	int getBytes() const
+	{
+		return mBytes;
+	};
+
+private:
+	const int mTag;
+	int mBytes;
+};
+
+//---------------------------------------------------------------------------
+/** charges sizeof(OwnerClass) to a tag for every instance, use it through MEMORY_ACCOUNTED()*/
+template <class OwnerClass, int tag>
+class MemoryAccountedObject
+{
+public:
+	MemoryAccountedObject()
+	{
+		MemoryAccounting::allocated(tag,(int)sizeof(OwnerClass));
+	};
+
+	MemoryAccountedObject(const MemoryAccountedObject&)
+	{
+		MemoryAccounting::allocated(tag,(int)sizeof(OwnerClass));
+	};
+
+	~MemoryAccountedObject()
+	{
+		MemoryAccounting::freed(tag,(int)sizeof(OwnerClass));
+	};
+};
+
+/** put it into the private members of a class, like JUCE_LEAK_DETECTOR. instances on the stack count too*/
+#define MEMORY_ACCOUNTED(tag,OwnerClass)	MemoryAccountedObject<OwnerClass,tag> JUCE_JOIN_MACRO(memoryAccount_,__LINE__);
+//---------------------------------------------------------------------------
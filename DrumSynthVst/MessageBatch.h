@@ -0,0 +1,155 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Trace.h"
+
+class BatchedAsyncUpdater;
+
+//---------------------------------------------------------------------------
+/** Delivers the updates of every BatchedAsyncUpdater with one message.
+
+	Each juce AsyncUpdater posts its own message to the OS queue, so the
+	MIDI thread, the startup loader and the thumbnail jobs each wake the
+	message thread on their own. Here an updater only sets its flag, the
+	first flag set since the last dispatch posts the single message of the
+	batch and its callback runs all updaters whose flag is set.
+*/
+class MessageBatch : private AsyncUpdater
+{
+public:
+	MessageBatch() : mDispatchPos(0)
+	{
+	};
+
+	~MessageBatch()
+	{
+		//every updater has to be deleted before the batch
+		jassert(mUpdaters.size() == 0);
+		cancelPendingUpdate();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (MessageBatch, false)
+
+private:
+	friend class BatchedAsyncUpdater;
+
+	void add(BatchedAsyncUpdater* updater)
+	{
+		const ScopedLock lock(mLock);
+		mUpdaters.add(updater);
+	};
+
+	void remove(BatchedAsyncUpdater* updater)
+	{
+		const ScopedLock lock(mLock);
+		const int index = mUpdaters.indexOf(updater);
+		if(index < 0) return;
+		mUpdaters.remove(index);
+		//the dispatch doesn't skip the one behind it
+		if(index < mDispatchPos) mDispatchPos--;
+	};
+
+	void post()
+	{
+		triggerAsyncUpdate();
+	};
+
+	inline void handleAsyncUpdate();
+
+	CriticalSection mLock;
+	Array<BatchedAsyncUpdater*> mUpdaters;
+	int mDispatchPos;		// the next updater the dispatch looks at
+};
+
+//---------------------------------------------------------------------------
+/** Drop in replacement of AsyncUpdater for updaters triggered from other
+	threads, many triggers still only post one message, see MessageBatch.
+	Like an AsyncUpdater it has to be deleted on the message thread, or
+	where no update can be delivered at the same time.
+*/
+class BatchedAsyncUpdater
+{
+public:
+	BatchedAsyncUpdater()
+	{
+		mBatch = MessageBatch::getInstance();
+		mBatch->add(this);
+	};
+
+	virtual ~BatchedAsyncUpdater()
+	{
+		mBatch->remove(this);
+	};
+
+	/** any thread, handleAsyncUpdate() is called once on the message thread*/
+	void triggerAsyncUpdate()
+	{
+		if(mPending.compareAndSetBool(1,0)) mBatch->post();
+	};
+
+	void cancelPendingUpdate()
+	{
+		mPending.set(0);
+	};
+
+	bool isUpdatePending() const
+	{
+		return mPending.get() != 0;
+	};
+
+	virtual void handleAsyncUpdate() = 0;
+
+private:
+	friend class MessageBatch;
+
+	MessageBatch* mBatch;
+	Atomic<int> mPending;
+};
+
+//---------------------------------------------------------------------------
+/** the lock isn't held during a callback, so a callback may trigger, add or delete updaters*/
+inline void MessageBatch::handleAsyncUpdate()
+{
+	TRACE_SCOPE("message","batch dispatch");
+	{
+		const ScopedLock lock(mLock);
+		mDispatchPos = 0;
+	}
+	for(;;)
+	{
+		BatchedAsyncUpdater* updater;
+		{
+			const ScopedLock lock(mLock);
+			if(mDispatchPos >= mUpdaters.size()) return;
+			updater = mUpdaters.getUnchecked(mDispatchPos++);
+			if(updater->mPending.exchange(0) == 0) continue;
+		}
+		updater->handleAsyncUpdate();
+	}
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,248 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../ParameterStore.h"
+#include "../PatchHash.h"
+#include "MidiTransmitter.h"
+#include "MidiInputParser.h"
+#include "SysExStreamParser.h"
+
+#define DEVICE_VERIFY_TIMEOUT_MS	2000	// for the dump to come back once the queues are sent
+#define DEVICE_VERIFY_POLL_MS		50
+#define DEVICE_VERIFY_MAX_ROUNDS	3		// dumps with a repair in between before it gives up
+
+//---------------------------------------------------------------------------
+/** Checks that the synth holds the sound of the editor, e.g. after a bulk
+	transfer.
+
+	start() takes the values of the ParameterStore and queues a dump request
+	behind everything the MidiTransmitter still has to send. The answer is
+	taken from the MIDI input by a SysExStreamParser, so it doesn't change
+	the edited sound, and compared by hashPatchValues(). If the hashes differ
+	only the parameters that differ are sent again and another dump is
+	requested, up to DEVICE_VERIFY_MAX_ROUNDS times. A synth that holds the
+	sound costs one dump.
+
+	The dumps are handled on the MIDI thread. The timeout and the Listener
+	run on the message thread, start() and stop() are called from there.
+	Other patch dumps arriving while it runs are taken for the answer.
+*/
+class DeviceVerifier : public SysExStreamParser::Listener,
+					   private Timer
+{
+public:
+	enum Result
+	{
+		RESULT_NONE = 0,
+		RESULT_RUNNING,
+		RESULT_SAME,		// the first dump matched
+		RESULT_REPAIRED,	// a later one matched after the differing parameters were sent again
+		RESULT_DIFFERENT,	// still different after DEVICE_VERIFY_MAX_ROUNDS dumps
+		RESULT_TIMEOUT,		// no dump came back
+		RESULT_NO_OUTPUT
+	};
+
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** on the message thread, getResult() tells how it went*/
+		virtual void deviceVerified(DeviceVerifier* verifier) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	DeviceVerifier() : mParser(this),
+		mInput(NULL),
+		mListener(NULL),
+		mExpectedHash(0),
+		mNumDiffering(0),
+		mNumResent(0)
+	{
+		memset(mExpected,0,sizeof(mExpected));
+		mResult.set(RESULT_NONE);
+		mNumDumps.set(0);
+		mDeadline.set(0);
+	};
+
+	~DeviceVerifier()
+	{
+		stop();
+	};
+
+	/** compare the synth with the edited sound. the listener is told when it is done*/
+	void start(MidiInputParser& input, Listener* listener)
+	{
+		stop();
+		mListener = listener;
+		mNumDiffering = 0;
+		mNumResent = 0;
+		mNumDumps.set(0);
+		startTimer(DEVICE_VERIFY_POLL_MS);
+
+		if(!MidiTransmitter::getInstance()->hasMidiOutput())
+		{
+			mResult.set(RESULT_NO_OUTPUT);
+			return;
+		}
+
+		memcpy(mExpected,ParameterStore::getInstance()->getValues(),NUM_PARAMS);
+		mExpectedHash = hashPatchValues(mExpected);
+		mParser.reset();
+		mResult.set(RESULT_RUNNING);
+		mInput = &input;
+		input.setBankReceiver(&mParser);
+		requestDump();
+	};
+
+	/** the listener isn't called*/
+	void stop()
+	{
+		stopTimer();
+		detach();
+		mResult.compareAndSetBool(RESULT_NONE,RESULT_RUNNING);
+	};
+
+	bool isRunning()
+	{
+		return mResult.get() == RESULT_RUNNING;
+	};
+
+	int getResult()
+	{
+		return mResult.get();
+	};
+
+	/** the dumps that came back*/
+	int getNumDumps()
+	{
+		return mNumDumps.get();
+	};
+
+	/** the parameters the first dump differed in*/
+	int getNumDiffering() const
+	{
+		return mNumDiffering;
+	};
+
+	/** the parameters sent again, over all rounds*/
+	int getNumResent() const
+	{
+		return mNumResent;
+	};
+
+	String getDescription()
+	{
+		switch(getResult())
+		{
+		case RESULT_SAME:		return "The synth holds the current sound.";
+		case RESULT_REPAIRED:	return String(mNumDiffering) + " parameters were different and have been sent again, the synth holds the current sound now.";
+		case RESULT_DIFFERENT:	return "The synth still differs after " + String(getNumDumps()) + " dumps, " + String(mNumResent) + " parameters were sent again.";
+		case RESULT_TIMEOUT:	return "The synth didn't answer the dump request. Is a MIDI input selected?";
+		case RESULT_NO_OUTPUT:	return "No MIDI output selected.";
+		default:				return String::empty;
+		}
+	};
+
+	//----- SysExStreamParser::Listener, on the MIDI thread
+	void patchDumpReceived(const uint8_t* data)
+	{
+		if(!isRunning()) return;
+
+		const uint8_t* values = data + PATCH_NAME_LENGTH;
+		const int round = mNumDumps.get();
+		++mNumDumps;
+		if(hashPatchValues(values) == mExpectedHash)
+		{
+			mResult.compareAndSetBool(round == 0 ? RESULT_SAME : RESULT_REPAIRED,RESULT_RUNNING);
+			return;
+		}
+
+		//only what differs goes out again, the next dump is queued behind it
+		MidiTransmitter* transmitter = MidiTransmitter::getInstance();
+		int numDiffering = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(values[i] == mExpected[i]) continue;
+			transmitter->sendParameter(i,mExpected[i],PRIORITY_BULK);
+			numDiffering++;
+		}
+		if(round == 0) mNumDiffering = numDiffering;
+		mNumResent += numDiffering;
+
+		if(round+1 >= DEVICE_VERIFY_MAX_ROUNDS)
+		{
+			mResult.compareAndSetBool(RESULT_DIFFERENT,RESULT_RUNNING);
+			return;
+		}
+		requestDump();
+	};
+
+private:
+	void timerCallback()
+	{
+		if(isRunning())
+		{
+			if((int)(Time::getMillisecondCounter() - (uint32)mDeadline.get()) < 0) return;
+			mResult.compareAndSetBool(RESULT_TIMEOUT,RESULT_RUNNING);
+		}
+
+		stopTimer();
+		detach();
+		if(mListener != NULL) mListener->deviceVerified(this);
+	};
+
+	/** the answer may take as long as the queues need to drain*/
+	void requestDump()
+	{
+		MidiTransmitter* transmitter = MidiTransmitter::getInstance();
+		const int waitMs = roundToInt(transmitter->getEstimatedDrainTime()) + DEVICE_VERIFY_TIMEOUT_MS;
+		mDeadline.set((int)(Time::getMillisecondCounter() + waitMs));
+		transmitter->sendDumpRequest();
+	};
+
+	void detach()
+	{
+		if(mInput == NULL) return;
+		mInput->setBankReceiver(NULL);
+		mInput = NULL;
+	};
+
+	SysExStreamParser mParser;
+	MidiInputParser* mInput;
+	Listener* mListener;
+
+	uint8_t mExpected[NUM_PARAMS];
+	uint64 mExpectedHash;
+	int mNumDiffering;		// MIDI thread while running
+	int mNumResent;
+
+	Atomic<int> mResult;
+	Atomic<int> mNumDumps;
+	Atomic<int> mDeadline;	// Time::getMillisecondCounter() the current dump has to be back by
+};
+//---------------------------------------------------------------------------
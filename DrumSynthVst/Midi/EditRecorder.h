@@ -0,0 +1,125 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../ParameterStore.h"
+
+#define EDIT_RECORDER_RESERVE	65536	// edits reserved when a recording starts, the array only grows beyond that
+
+//---------------------------------------------------------------------------
+/** one value change of a recording, ms after the recording started*/
+struct RecordedEdit
+{
+	double timeMs;
+	short parameterNr;
+	uint8_t value;
+};
+
+//---------------------------------------------------------------------------
+/** Records every change of the ParameterStore with its time, so an edit
+	session can be exported as a MIDI file (see MidiFileExport::writeEdits()).
+
+	The store reports changes once per PARAMETER_FRAME_MS with the latest
+	value, so the timeline has that resolution, like what the synth gets.
+	The values at the start are kept too, so the file restores the sound the
+	session started from. The edits are stored back to back in an array that
+	is reserved once, recording doesn't allocate until EDIT_RECORDER_RESERVE
+	edits have been made. Message thread only, like the store listeners.
+*/
+class EditRecorder : public ParameterStore::Listener
+{
+public:
+	EditRecorder() : mRecording(false), mStartTime(0)
+	{
+		memset(mStartValues,0,NUM_PARAMS);
+	};
+
+	~EditRecorder()
+	{
+		stop();
+	};
+
+	/** drops the last recording and starts a new one*/
+	void start()
+	{
+		stop();
+		mEdits.clearQuick();
+		mEdits.ensureStorageAllocated(EDIT_RECORDER_RESERVE);
+
+		ParameterStore* store = ParameterStore::getInstance();
+		memcpy(mStartValues,store->getValues(),NUM_PARAMS);
+		mStartTime = Time::getMillisecondCounterHiRes();
+		store->addListener(this);
+		mRecording = true;
+	};
+
+	/** the recording stays until the next start()*/
+	void stop()
+	{
+		if(!mRecording) return;
+
+		ParameterStore::getInstance()->removeListener(this);
+		mRecording = false;
+	};
+
+	bool isRecording() const
+	{
+		return mRecording;
+	};
+
+	int getNumEdits() const
+	{
+		return mEdits.size();
+	};
+
+	const RecordedEdit& getEdit(int index) const
+	{
+		return mEdits.getReference(index);
+	};
+
+	/** NUM_PARAMS values as they were when the recording started*/
+	const uint8_t* getStartValues() const
+	{
+		return mStartValues;
+	};
+
+	//----- ParameterStore::Listener
+	void parameterChanged(int parameterNr, int value)
+	{
+		RecordedEdit edit;
+		edit.timeMs = Time::getMillisecondCounterHiRes() - mStartTime;
+		edit.parameterNr = (short)parameterNr;
+		edit.value = (uint8_t)value;
+		mEdits.add(edit);
+	};
+
+private:
+	bool mRecording;
+	double mStartTime;
+	uint8_t mStartValues[NUM_PARAMS];
+	Array<RecordedEdit> mEdits;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,481 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../controllerAssignments.h"
+#include "../ParameterStore.h"
+#include "MidiTransmitter.h"
+#include "LatencyMonitor.h"
+
+#define EDIT_SESSION_MAGIC		0x53455053	// "SPES" little endian
+#define EDIT_SESSION_VERSION	1
+#define EDIT_SESSION_EXTENSION	".ses"
+#define EDIT_SESSION_RESERVE	65536	// edits reserved when a recording starts
+
+#define REPLAY_DRAIN_TIMEOUT_MS	5000	// the transmitter gets this long to send the last values
+
+//---------------------------------------------------------------------------
+/** one widget callback of a voice panel, ms after the recording started*/
+struct UiEdit
+{
+	double timeMs;
+	uint8_t voiceNr;
+	uint8_t controlNr;	// 1-MAX_CONTROLS, the index into controllerAssignments is controlNr-1
+	uint8_t value;
+};
+
+//---------------------------------------------------------------------------
+/** The values a recording started from and the widget edits made after that.
+
+	File: magic, version, NUM_PARAMS, number of edits, the NUM_PARAMS start
+	values, then per edit the time as a double and voice, control and value
+	as bytes.
+*/
+class EditSession
+{
+public:
+	EditSession()
+	{
+		memset(mStartValues,0,NUM_PARAMS);
+	};
+
+	void clear(const uint8_t* startValues)
+	{
+		memcpy(mStartValues,startValues,NUM_PARAMS);
+		mEdits.clearQuick();
+	};
+
+	void add(const UiEdit& edit)
+	{
+		mEdits.add(edit);
+	};
+
+	void reserve(int numEdits)
+	{
+		mEdits.ensureStorageAllocated(numEdits);
+	};
+
+	int getNumEdits() const
+	{
+		return mEdits.size();
+	};
+
+	const UiEdit& getEdit(int index) const
+	{
+		return mEdits.getReference(index);
+	};
+
+	const uint8_t* getStartValues() const
+	{
+		return mStartValues;
+	};
+
+	/** the store value of every parameter after the last edit*/
+	void getEndValues(uint8_t* values) const
+	{
+		memcpy(values,mStartValues,NUM_PARAMS);
+		for(int i=0;i<mEdits.size();i++)
+		{
+			const UiEdit& edit = mEdits.getReference(i);
+			const int parameterNr = getParameterNr(edit);
+			if(parameterNr >= 0 && parameterNr < NUM_PARAMS) values[parameterNr] = edit.value;
+		}
+	};
+
+	/** the parameter VoicePanel::sendValue() sets for an edit, NONE for controls without one*/
+	static int getParameterNr(const UiEdit& edit)
+	{
+		if(edit.voiceNr >= NUM_VOICES || edit.controlNr < 1 || edit.controlNr > MAX_CONTROLS) return NONE;
+		return controllerAssignments[edit.voiceNr][edit.controlNr-1];
+	};
+
+	bool save(const File& file) const
+	{
+		TemporaryFile temp(file);
+		{
+			FileOutputStream out(temp.getFile());
+			if(out.getStatus().failed()) return false;
+
+			out.writeInt(EDIT_SESSION_MAGIC);
+			out.writeInt(EDIT_SESSION_VERSION);
+			out.writeInt(NUM_PARAMS);
+			out.writeInt(mEdits.size());
+			out.write(mStartValues,NUM_PARAMS);
+			for(int i=0;i<mEdits.size();i++)
+			{
+				const UiEdit& edit = mEdits.getReference(i);
+				out.writeDouble(edit.timeMs);
+				out.writeByte((char)edit.voiceNr);
+				out.writeByte((char)edit.controlNr);
+				out.writeByte((char)edit.value);
+			}
+
+			out.flush();
+			if(out.getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** the session is empty if the file is invalid*/
+	bool load(const File& file)
+	{
+		const uint8_t zeros[NUM_PARAMS] = {0};
+		clear(zeros);
+
+		FileInputStream in(file);
+		if(in.getStatus().failed()) return false;
+		if(in.readInt() != EDIT_SESSION_MAGIC || in.readInt() != EDIT_SESSION_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
+
+		//11 bytes per edit, a broken count can't reserve more than the file holds
+		const int numEdits = in.readInt();
+		if(numEdits < 0 || numEdits > (in.getTotalLength()-in.getPosition()-NUM_PARAMS)/11
+			|| in.read(mStartValues,NUM_PARAMS) != NUM_PARAMS)
+		{
+			clear(zeros);
+			return false;
+		}
+		reserve(numEdits);
+		for(int i=0;i<numEdits;i++)
+		{
+			UiEdit edit;
+			edit.timeMs = in.readDouble();
+			edit.voiceNr = (uint8_t)in.readByte();
+			edit.controlNr = (uint8_t)in.readByte();
+			if(in.isExhausted())
+			{
+				clear(zeros);
+				return false;
+			}
+			edit.value = (uint8_t)in.readByte();
+			mEdits.add(edit);
+		}
+		return true;
+	};
+
+private:
+	uint8_t mStartValues[NUM_PARAMS];
+	Array<UiEdit> mEdits;
+};
+
+//---------------------------------------------------------------------------
+/** Records the edits of the voice panels before anything is coalesced,
+	the input of the EditReplayer. VoicePanel::sendValue() calls add(),
+	which does nothing unless a recording runs. Message thread only.
+*/
+class UiEditRecorder
+{
+public:
+	UiEditRecorder() : mRecording(false), mStartTime(0)
+	{
+	};
+
+	~UiEditRecorder()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (UiEditRecorder, false)
+
+	/** drops the last recording and starts a new one from the current values*/
+	void start()
+	{
+		mSession.clear(ParameterStore::getInstance()->getValues());
+		//recording doesn't allocate until this many edits were made
+		mSession.reserve(EDIT_SESSION_RESERVE);
+		mStartTime = Time::getMillisecondCounterHiRes();
+		mRecording = true;
+	};
+
+	/** the recording stays until the next start()*/
+	void stop()
+	{
+		mRecording = false;
+	};
+
+	bool isRecording() const
+	{
+		return mRecording;
+	};
+
+	void add(int voiceNr, int controlNr, int value)
+	{
+		if(!mRecording) return;
+
+		UiEdit edit;
+		edit.timeMs = Time::getMillisecondCounterHiRes() - mStartTime;
+		edit.voiceNr = (uint8_t)voiceNr;
+		edit.controlNr = (uint8_t)controlNr;
+		edit.value = (uint8_t)value;
+		mSession.add(edit);
+	};
+
+	const EditSession& getSession() const
+	{
+		return mSession;
+	};
+
+private:
+	bool mRecording;
+	double mStartTime;
+	EditSession mSession;
+};
+
+//---------------------------------------------------------------------------
+/** what a replay sent, the rates are from the first edit to the last message*/
+struct EditReplayResult
+{
+	EditReplayResult()
+	: numEdits(0),
+	numMessages(0),
+	numBytes(0),
+	numTransmitted(0),
+	elapsedMs(0),
+	numStale(0),
+	passed(false)
+	{
+	};
+
+	double getMessagesPerSecond() const
+	{
+		return elapsedMs > 0 ? numMessages*1000./elapsedMs : 0;
+	};
+
+	double getBytesPerSecond() const
+	{
+		return elapsedMs > 0 ? numBytes*1000./elapsedMs : 0;
+	};
+
+	/** e.g. "replay: 5000 edits -> 812 parameters, 2436 messages, 7308 bytes in 40.2 ms ..."*/
+	String toString() const
+	{
+		String text("replay: ");
+		text << numEdits << " edits -> " << numTransmitted << " parameters, " << numMessages << " messages, "
+			<< numBytes << " bytes in " << String(elapsedMs,1) << " ms, "
+			<< String((int64)getMessagesPerSecond()) << " messages/s, " << String((int64)getBytesPerSecond()) << " bytes/s";
+		if(!passed) text << ", FAILED: " << error;
+		return text;
+	};
+
+	void writeJson(OutputStream& out) const
+	{
+		out << "{\"edits\":" << numEdits << ",\"transmitted\":" << numTransmitted
+			<< ",\"messages\":" << numMessages << ",\"bytes\":" << numBytes
+			<< ",\"elapsedMs\":" << String(elapsedMs,3)
+			<< ",\"messagesPerSecond\":" << String(getMessagesPerSecond(),1)
+			<< ",\"bytesPerSecond\":" << String(getBytesPerSecond(),1)
+			<< ",\"stale\":" << numStale << ",\"passed\":" << (passed ? "true" : "false") << "}";
+	};
+
+	int numEdits;
+	int numMessages;		// MIDI messages put on the wire
+	int numBytes;
+	int numTransmitted;		// parameter values that left the coalescing slots
+	double elapsedMs;
+	int numStale;			// parameters whose last sent value isn't the last edit
+	bool passed;
+	String error;
+};
+
+//---------------------------------------------------------------------------
+/** Plays an EditSession through the whole send path without a UI:
+	ParameterStore::setValue() like a voice panel, the coalescing slots of
+	the MidiTransmitter, its thread and the MidiEncoder. The transmitter
+	reports what it sends to the replayer, the output device is used if
+	there is one.
+
+	With speed 0 the edits are made as fast as possible, otherwise at their
+	recorded times divided by speed. The link speed is unlimited meanwhile,
+	so the rates are those of the code and not of a modelled cable.
+
+	The check of the coalescing holds for every timing: more edits than
+	messages may go in, but for every edited parameter the last value that
+	is sent has to be the value of its last edit, and no parameter may be
+	sent more often than it was edited. Message thread only, replay()
+	blocks until the transmitter sent everything.
+*/
+class EditReplayer : private MidiTransmitter::Listener
+{
+public:
+	EditReplayer()
+	{
+		resetCounters();
+	};
+
+	EditReplayResult replay(const EditSession& session, double speed)
+	{
+		EditReplayResult result;
+		result.numEdits = session.getNumEdits();
+
+		ParameterStore* store = ParameterStore::getInstance();
+		MidiTransmitter* transmitter = MidiTransmitter::getInstance();
+		if(store->getEditTarget() != NULL)
+		{
+			result.error = "the edits go to an edit target, not to the transmitter";
+			return result;
+		}
+
+		//the start values are the state of the synth, they aren't part of the measurement
+		Patch start;
+		start.setValues(session.getStartValues());
+		store->loadFromPatch(&start,false);
+		if(!waitUntilIdle(transmitter))
+		{
+			result.error = "the transmitter is still busy";
+			return result;
+		}
+
+		int editCounts[NUM_PARAMS] = {0};
+		uint8_t endValues[NUM_PARAMS];
+		session.getEndValues(endValues);
+
+		const int linkSpeed = transmitter->getLinkSpeed();
+		transmitter->setLinkSpeed(LINK_SPEED_UNLIMITED);
+		resetCounters();
+		transmitter->setListener(this);
+
+		const double startTime = Time::getMillisecondCounterHiRes();
+		for(int i=0;i<session.getNumEdits();i++)
+		{
+			const UiEdit& edit = session.getEdit(i);
+			if(speed > 0)
+			{
+				const double due = startTime + edit.timeMs/speed;
+				while(Time::getMillisecondCounterHiRes() < due)
+				{
+					Thread::yield();
+				}
+			}
+			const int parameterNr = EditSession::getParameterNr(edit);
+			if(parameterNr >= 0 && parameterNr < NUM_PARAMS) editCounts[parameterNr]++;
+
+			LatencyMonitor::getInstance()->uiEvent();
+			store->setValue(parameterNr,edit.value);
+		}
+
+		//the coalesced values are still in flight, wait for each edited parameter's last one
+		const double timeout = Time::getMillisecondCounterHiRes() + REPLAY_DRAIN_TIMEOUT_MS;
+		while(countStale(editCounts,endValues) > 0 && Time::getMillisecondCounterHiRes() < timeout)
+		{
+			Thread::sleep(1);
+		}
+		waitUntilIdle(transmitter);
+		transmitter->setListener(NULL);
+		transmitter->setLinkSpeed(linkSpeed);
+
+		result.numMessages = mNumMessages.get();
+		result.numBytes = mNumBytes.get();
+		result.numTransmitted = mNumTransmitted.get();
+		result.elapsedMs = jmax(0.,mLastMessageTime - startTime);
+		result.numStale = countStale(editCounts,endValues);
+
+		if(result.numStale > 0)
+		{
+			result.error = String(result.numStale) + " parameters didn't get the value of their last edit";
+		}
+		else
+		{
+			result.passed = checkSendCounts(editCounts,result.error);
+		}
+		return result;
+	};
+
+private:
+	//----- MidiTransmitter::Listener, on the transmit thread
+	void messagesTransmitted(int parameterNr, int value, int numMessages, int numBytes)
+	{
+		mNumMessages += numMessages;
+		mNumBytes += numBytes;
+		mLastMessageTime = Time::getMillisecondCounterHiRes();
+		if(parameterNr < 0 || parameterNr >= NUM_PARAMS) return;
+
+		++mNumTransmitted;
+		mSendCounts[parameterNr] += 1;
+		mSentValues[parameterNr].set(value);
+	};
+
+	void resetCounters()
+	{
+		mNumMessages.set(0);
+		mNumBytes.set(0);
+		mNumTransmitted.set(0);
+		mLastMessageTime = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mSendCounts[i].set(0);
+			mSentValues[i].set(-1);
+		}
+	};
+
+	int countStale(const int* editCounts, const uint8_t* endValues)
+	{
+		int num = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(editCounts[i] > 0 && mSentValues[i].get() != endValues[i]) num++;
+		}
+		return num;
+	};
+
+	bool checkSendCounts(const int* editCounts, String& error)
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(mSendCounts[i].get() > editCounts[i])
+			{
+				error = "parameter " + String(i) + " was sent " + String(mSendCounts[i].get()) + " times for "
+					+ String(editCounts[i]) + " edits";
+				return false;
+			}
+		}
+		return true;
+	};
+
+	/** queued and in flight: the thread takes an item before it sends it, so the queues are checked twice*/
+	static bool waitUntilIdle(MidiTransmitter* transmitter)
+	{
+		const double timeout = Time::getMillisecondCounterHiRes() + REPLAY_DRAIN_TIMEOUT_MS;
+		int numIdle = 0;
+		while(numIdle < 2)
+		{
+			if(Time::getMillisecondCounterHiRes() > timeout) return false;
+			numIdle = transmitter->getNumPending() == 0 ? numIdle+1 : 0;
+			Thread::sleep(1);
+		}
+		return true;
+	};
+
+	Atomic<int> mNumMessages;
+	Atomic<int> mNumBytes;
+	Atomic<int> mNumTransmitted;
+	double mLastMessageTime;	// written by the transmit thread, read after it went idle
+	Atomic<int> mSendCounts[NUM_PARAMS];
+	Atomic<int> mSentValues[NUM_PARAMS];	// -1 until the parameter is sent
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,203 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// 4 buckets per octave from 1us to 2^24us (~17s)
+#define LATENCY_BUCKETS_PER_OCTAVE	4
+#define LATENCY_NUM_OCTAVES			24
+#define LATENCY_NUM_BUCKETS			(LATENCY_BUCKETS_PER_OCTAVE*LATENCY_NUM_OCTAVES)
+
+//---------------------------------------------------------------------------
+/** Logarithmic histogram of durations in microseconds.
+	addSample() is lock free and can be called from any thread.
+*/
+class LatencyHistogram
+{
+public:
+	LatencyHistogram()
+	{
+		reset();
+	};
+
+	void reset()
+	{
+		for(int i=0;i<LATENCY_NUM_BUCKETS;i++)
+		{
+			mBuckets[i].set(0);
+		}
+		mNumSamples.set(0);
+		mMax.set(0);
+	};
+
+	void addSample(int us)
+	{
+		++mBuckets[getBucket(us)];
+		++mNumSamples;
+
+		int max;
+		do
+		{
+			max = mMax.get();
+		} while(us > max && !mMax.compareAndSetBool(us,max));
+	};
+
+	int getNumSamples()
+	{
+		return mNumSamples.get();
+	};
+
+	int getMax()
+	{
+		return mMax.get();
+	};
+
+	/** returns the upper bound in us of the bucket holding the given percentile [0:1]*/
+	int getPercentile(double percentile)
+	{
+		int counts[LATENCY_NUM_BUCKETS];
+		int total = 0;
+		for(int i=0;i<LATENCY_NUM_BUCKETS;i++)
+		{
+			counts[i] = mBuckets[i].get();
+			total += counts[i];
+		}
+		if(total == 0) return 0;
+
+		const int wanted = jmax(1,roundToInt(total*percentile));
+		int sum = 0;
+		for(int i=0;i<LATENCY_NUM_BUCKETS;i++)
+		{
+			sum += counts[i];
+			if(sum >= wanted)
+			{
+				return jmin(getMax(),getBucketLimit(i));
+			}
+		}
+		return getMax();
+	};
+
+private:
+	static int getBucket(int us)
+	{
+		//bucket b holds (2^((b-1)/4), 2^(b/4)]
+		if(us <= 1) return 0;
+		const int bucket = (int)std::ceil(std::log((double)us)/std::log(2.)*LATENCY_BUCKETS_PER_OCTAVE);
+		return jlimit(0,LATENCY_NUM_BUCKETS-1,bucket);
+	};
+
+	static int getBucketLimit(int bucket)
+	{
+		return roundToInt(std::pow(2.,bucket/(double)LATENCY_BUCKETS_PER_OCTAVE));
+	};
+
+private:
+	Atomic<int> mBuckets[LATENCY_NUM_BUCKETS];
+	Atomic<int> mNumSamples;
+	Atomic<int> mMax;
+};
+//---------------------------------------------------------------------------
+/** Collects the edit to wire latency of interactive parameter changes.
+
+	The stages of a knob edit:
+	STAGE_UI		widget callback until the value is queued
+	STAGE_QUEUE		queued until the transmit thread picks it up
+	STAGE_DRIVER	time spent in MidiOutput::sendShortMessageNow()
+	STAGE_TOTAL		widget callback until the driver returned
+
+	STAGE_REMOTE is the round trip of a RemoteEditSender frame.
+*/
+class LatencyMonitor
+{
+public:
+	enum Stages
+	{
+		STAGE_UI = 0,
+		STAGE_QUEUE,
+		STAGE_DRIVER,
+		STAGE_TOTAL,
+		STAGE_REMOTE,
+		NUM_STAGES
+	};
+
+	LatencyMonitor()
+	{
+		mLastUiEvent.set(getTime());
+	};
+
+	~LatencyMonitor()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (LatencyMonitor, false)
+
+	/** a timestamp in us. wraps after ~71 minutes, differences stay valid*/
+	static int getTime()
+	{
+		return (int)(uint32)(int64)(Time::getMillisecondCounterHiRes()*1000.);
+	};
+
+	/** called by the widget callbacks before they queue a value*/
+	void uiEvent()
+	{
+		mLastUiEvent.set(getTime());
+	};
+
+	int getLastUiEvent()
+	{
+		return mLastUiEvent.get();
+	};
+
+	void addSample(int stage, int startTime, int endTime)
+	{
+		mHistograms[stage].addSample((int)((uint32)endTime - (uint32)startTime));
+	};
+
+	LatencyHistogram& getHistogram(int stage)
+	{
+		return mHistograms[stage];
+	};
+
+	void reset()
+	{
+		for(int i=0;i<NUM_STAGES;i++)
+		{
+			mHistograms[i].reset();
+		}
+	};
+
+	static const char* getStageName(int stage)
+	{
+		const char* const names[] = { "UI -> queue", "queue -> thread", "driver send", "UI -> wire", "remote round trip" };
+		return names[stage];
+	};
+
+private:
+	Atomic<int> mLastUiEvent;
+	LatencyHistogram mHistograms[NUM_STAGES];
+};
+//---------------------------------------------------------------------------
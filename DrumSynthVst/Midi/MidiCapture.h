@@ -0,0 +1,161 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "LatencyMonitor.h"
+
+#define MIDI_CAPTURE_SIZE			65536	// records in the ring, a power of 2. 16 bytes each
+#define MIDI_CAPTURE_OUT			1		// info bit: sent, not received
+#define MIDI_CAPTURE_SYSEX			2		// info bit: message holds the first 4 bytes of a SysEx
+#define MIDI_CAPTURE_SIZE_SHIFT		8		// info >> this is the size of the message in bytes
+
+//---------------------------------------------------------------------------
+/** One captured message*/
+struct MidiCaptureRecord
+{
+	int time;			// LatencyMonitor::getTime() when it went to the driver or came from it
+	uint32 message;		// the bytes packed like MidiEncoder::packShortMessage(), the first 4 of a SysEx
+	int info;			// MIDI_CAPTURE_OUT | MIDI_CAPTURE_SYSEX | size << MIDI_CAPTURE_SIZE_SHIFT
+
+	bool isOutgoing() const
+	{
+		return (info & MIDI_CAPTURE_OUT) != 0;
+	};
+
+	bool isSysEx() const
+	{
+		return (info & MIDI_CAPTURE_SYSEX) != 0;
+	};
+
+	int getSize() const
+	{
+		return info >> MIDI_CAPTURE_SIZE_SHIFT;
+	};
+
+	int getByte(int index) const
+	{
+		return (int)((message >> (index*8)) & 0xff);
+	};
+};
+//---------------------------------------------------------------------------
+/** Keeps the last MIDI_CAPTURE_SIZE messages that went to the synths or
+	came from them, for the MidiMonitorComponent.
+
+	Capture is always on, so it has to cost next to nothing on the MIDI
+	threads: a writer takes the next position with one atomic increment
+	and fills the 16 byte slot of the ring, nothing is decoded, allocated
+	or locked and a full ring simply overwrites its oldest records. The
+	sequence of a slot is cleared while it is written and set to the
+	position + 1 when it is done, a reader compares it before and after
+	copying the slot and gets false for a record that is being written or
+	was overwritten already. Any number of threads can capture and read.
+*/
+class MidiCapture
+{
+public:
+	MidiCapture()
+	{
+		mSlots.calloc(MIDI_CAPTURE_SIZE);
+	};
+
+	~MidiCapture()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (MidiCapture, false)
+
+	/** a short message packed by MidiEncoder::packShortMessage(), at LatencyMonitor::getTime() or at
+		the time it is scheduled for*/
+	void captureShort(bool outgoing, uint32 packedMessage, int size, int time)
+	{
+		add(time,packedMessage,(outgoing ? MIDI_CAPTURE_OUT : 0) | (size << MIDI_CAPTURE_SIZE_SHIFT));
+	};
+
+	void capture(bool outgoing, const MidiMessage& message, int time)
+	{
+		const uint8* data = message.getRawData();
+		const int size = message.getRawDataSize();
+		uint32 packed = 0;
+		for(int i=jmin(4,size)-1;i>=0;i--)
+		{
+			packed = (packed << 8) | data[i];
+		}
+		const int sysEx = size > 0 && data[0] == 0xf0 ? MIDI_CAPTURE_SYSEX : 0;
+		add(time,packed,(outgoing ? MIDI_CAPTURE_OUT : 0) | sysEx | (size << MIDI_CAPTURE_SIZE_SHIFT));
+	};
+
+	/** the position the next record gets. the ring holds the MIDI_CAPTURE_SIZE positions before it*/
+	int getEnd() const
+	{
+		return mEnd.get();
+	};
+
+	/** how many in and out records were captured so far*/
+	int getNumCaptured(bool outgoing) const
+	{
+		return mNumCaptured[outgoing ? 1 : 0].get();
+	};
+
+	/** false if the record at position is being written or was overwritten*/
+	bool read(int position, MidiCaptureRecord& record) const
+	{
+		const Slot& slot = mSlots[position & (MIDI_CAPTURE_SIZE-1)];
+		if(slot.sequence.get() != position+1) return false;
+		record = slot.record;
+		return slot.sequence.get() == position+1;
+	};
+
+	/** a time in LatencyMonitor::getTime() units for a Time::getMillisecondCounterHiRes() value*/
+	static int getTime(double milliseconds)
+	{
+		return (int)(uint32)(int64)(milliseconds*1000.);
+	};
+
+private:
+	struct Slot
+	{
+		Atomic<int> sequence;	// position+1 of the record in it, 0 while it is written
+		MidiCaptureRecord record;
+	};
+
+	void add(int time, uint32 message, int info)
+	{
+		const int position = ++mEnd - 1;
+		Slot& slot = mSlots[position & (MIDI_CAPTURE_SIZE-1)];
+		slot.sequence.set(0);
+		slot.record.time = time;
+		slot.record.message = message;
+		slot.record.info = info;
+		slot.sequence.set(position+1);
+		++mNumCaptured[info & MIDI_CAPTURE_OUT];
+	};
+
+	HeapBlock<Slot> mSlots;
+	Atomic<int> mEnd;
+	Atomic<int> mNumCaptured[2];	// in, out
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,275 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#define MIDI_CLOCKS_PER_BEAT			24
+#define MIDI_CLOCKS_PER_STEP			6		// a 16th note, the step of the sequencers
+#define MIDI_CLOCK_LOCK_CLOCKS			48		// clocks with the wide loop bandwidth after the first one
+#define MIDI_CLOCK_LOCK_BANDWIDTH		2.0		// Hz, pulls the loop in quickly
+#define MIDI_CLOCK_BANDWIDTH			0.2		// Hz, afterwards the tempo only follows slow changes
+#define MIDI_CLOCK_TIMEOUT				0.25	// s without a clock (10 bpm) until the loop locks again
+#define MIDI_CLOCK_MIN_PERIOD			(60.0 / (MIDI_CLOCKS_PER_BEAT * 1000.0))	// 1000 bpm
+#define MIDI_CLOCK_MAX_EXTRAPOLATION	MIDI_CLOCKS_PER_STEP	// clocks the position runs on after the last clock
+#define MIDI_CLOCK_STATS_SMOOTHING		0.01	// weight of a new clock in the jitter average
+#define MIDI_CLOCK_MAX_STAMP_AGE		0.1		// s, an older timestamp of the MIDI input isn't trusted
+#define MIDI_CLOCK_MAX_STAMP_AHEAD		0.002	// s, the Windows timestamps are rounded to ms
+
+//---------------------------------------------------------------------------
+/** What the MidiClockFollower knows at its last clock. Times are in
+	seconds of Time::getMillisecondCounterHiRes().
+*/
+struct MidiClockState
+{
+	bool locked;			// enough clocks have arrived to know the tempo
+	bool running;			// between start/continue and stop
+	double clockTime;		// when the last clock was due after smoothing
+	double period;			// seconds per clock
+	int64 clockCount;		// clocks from the song start to the last one
+
+	//statistics since the last reset
+	int numClocks;
+	double jitterRms;		// ms, deviation of the clocks from the smoothed time
+	double jitterMax;		// ms
+	double minBpm;			// the range the smoothed tempo has drifted in
+	double maxBpm;
+
+	double getBpm() const
+	{
+		return 60.0 / (MIDI_CLOCKS_PER_BEAT * period);
+	};
+
+	/** false if the clocks have stopped arriving*/
+	bool isRunningAt(double time) const
+	{
+		return locked && running && time - clockTime < MIDI_CLOCK_TIMEOUT;
+	};
+
+	/** song position in clocks at the given time, extrapolated from the last clock*/
+	double getPosition(double time) const
+	{
+		return clockCount + jlimit(0.0, (double)MIDI_CLOCK_MAX_EXTRAPOLATION, (time - clockTime) / period);
+	};
+};
+
+//---------------------------------------------------------------------------
+/** Follows the MIDI clock and transport messages of an external sequencer,
+	so the preview can play in time with the rest of the studio.
+
+	The clocks are taken at the timestamp the MIDI input gave them when
+	they arrived, on ALSA that is stamped by the sequencer queue and on
+	JACK by the frame of the cycle, so a busy MIDI thread doesn't delay
+	them. A message without a plausible
+	timestamp gets the time it is handled. The clocks are smoothed with a second order delay locked loop, which gives the tempo
+	and the time of every clock without the jitter of the MIDI driver and
+	the USB link. The loop starts with a wide bandwidth to lock quickly and
+	narrows it after MIDI_CLOCK_LOCK_CLOCKS. The deviation of the clocks
+	from the loop is kept as jitter statistics, the range of the smoothed
+	tempo as drift.
+
+	handleMessage() runs on the MIDI thread and is the only writer. It
+	publishes a MidiClockState after every message behind a version counter,
+	getState() copies it without locking from any thread, the audio callback
+	reads the clock this way instead of asking the message thread.
+*/
+class MidiClockFollower
+{
+public:
+	MidiClockFollower()
+	{
+		zerostruct(mState);
+		mState.period = 60.0 / (MIDI_CLOCKS_PER_BEAT * 120.0);
+		mShared = mState;
+		mSongPosition = 0;
+		mNextTime = 0.0;
+		mLastArrival = 0.0;
+		mNumLockClocks = 0;
+		resetStatistics();
+	};
+
+	~MidiClockFollower()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (MidiClockFollower, false)
+
+	/** takes clock, start, continue, stop and song position messages. MIDI thread only*/
+	bool handleMessage(const MidiMessage& message)
+	{
+		const double now = getArrivalTime(message);
+		if(mResetRequested.exchange(0) != 0) clearStatistics();
+
+		if(message.isMidiClock())
+		{
+			handleClock(now);
+		}
+		else if(message.isMidiStart())
+		{
+			//the first clock after a start is the downbeat
+			mSongPosition = 0;
+			mState.clockCount = -1;
+			mState.running = true;
+		}
+		else if(message.isMidiContinue())
+		{
+			mState.clockCount = mSongPosition - 1;
+			mState.running = true;
+		}
+		else if(message.isMidiStop())
+		{
+			mState.running = false;
+			mSongPosition = mState.clockCount + 1;
+		}
+		else if(message.isSongPositionPointer())
+		{
+			//in midi beats, 16th notes
+			mSongPosition = (int64)message.getSongPositionPointerMidiBeat() * MIDI_CLOCKS_PER_STEP;
+		}
+		else
+		{
+			return false;
+		}
+		publish();
+		return true;
+	};
+
+	/** a copy of the state at the last message, any thread. false if it couldn't be read this time*/
+	bool getState(MidiClockState& state) const
+	{
+		for(int i=0;i<4;i++)
+		{
+			const int version = mVersion.get();
+			if(version & 1) continue;
+
+			state = mShared;
+			if(mVersion.get() == version) return true;
+		}
+		return false;
+	};
+
+	/** the statistics start again with the next message, any thread*/
+	void resetStatistics()
+	{
+		mResetRequested.set(1);
+	};
+
+private:
+	/** the timestamp of the message, or now if the input didn't set one in seconds of getMillisecondCounterHiRes()*/
+	static double getArrivalTime(const MidiMessage& message)
+	{
+		const double now = Time::getMillisecondCounterHiRes() * 0.001;
+		const double stamp = message.getTimeStamp();
+		if(stamp > now + MIDI_CLOCK_MAX_STAMP_AHEAD || stamp < now - MIDI_CLOCK_MAX_STAMP_AGE) return now;
+		return jmin(stamp, now);
+	};
+
+	void handleClock(double now)
+	{
+		const double gap = now - mLastArrival;
+		mLastArrival = now;
+		if(mState.running) ++mState.clockCount;
+
+		if(!mState.locked || gap > MIDI_CLOCK_TIMEOUT)
+		{
+			//the loop needs two clocks for its first period
+			if(mNumLockClocks == 0 || gap > MIDI_CLOCK_TIMEOUT)
+			{
+				mState.locked = false;
+				mNumLockClocks = 1;
+				return;
+			}
+			mState.period = gap;
+			mState.clockTime = now;
+			mNextTime = now + gap;
+			mState.locked = true;
+			mNumLockClocks = 1;
+			return;
+		}
+
+		//delay locked loop, see F. Adriaensen, "Using a DLL to filter time" (2005)
+		const double bandwidth = mNumLockClocks < MIDI_CLOCK_LOCK_CLOCKS ? MIDI_CLOCK_LOCK_BANDWIDTH : MIDI_CLOCK_BANDWIDTH;
+		const double omega = 2.0 * double_Pi * bandwidth * mState.period;
+		const double error = now - mNextTime;
+		mState.clockTime = mNextTime;
+		mNextTime += std::sqrt(2.0) * omega * error + mState.period;
+		mState.period += omega * omega * error;
+		mState.period = jlimit(MIDI_CLOCK_MIN_PERIOD, MIDI_CLOCK_TIMEOUT, mState.period);
+
+		if(mNumLockClocks < MIDI_CLOCK_LOCK_CLOCKS)
+		{
+			++mNumLockClocks;
+			return;
+		}
+
+		//the statistics only count the clocks after the loop has settled
+		const double errorMs = std::abs(error) * 1000.0;
+		const double bpm = mState.getBpm();
+		if(mState.numClocks == 0)
+		{
+			mMeanSquare = errorMs * errorMs;
+			mState.minBpm = bpm;
+			mState.maxBpm = bpm;
+		}
+		mMeanSquare += (errorMs * errorMs - mMeanSquare) * MIDI_CLOCK_STATS_SMOOTHING;
+		mState.jitterRms = std::sqrt(mMeanSquare);
+		mState.jitterMax = jmax(mState.jitterMax, errorMs);
+		mState.minBpm = jmin(mState.minBpm, bpm);
+		mState.maxBpm = jmax(mState.maxBpm, bpm);
+		++mState.numClocks;
+	};
+
+	void clearStatistics()
+	{
+		mState.numClocks = 0;
+		mState.jitterRms = 0.0;
+		mState.jitterMax = 0.0;
+		mState.minBpm = 0.0;
+		mState.maxBpm = 0.0;
+		mMeanSquare = 0.0;
+	};
+
+	/** odd while the copy is written*/
+	void publish()
+	{
+		++mVersion;
+		mShared = mState;
+		++mVersion;
+	};
+
+	//MIDI thread only
+	MidiClockState mState;
+	double mNextTime;		// when the loop expects the next clock
+	double mLastArrival;
+	double mMeanSquare;
+	int mNumLockClocks;
+	int64 mSongPosition;	// where continue starts, in clocks
+
+	MidiClockState mShared;
+	Atomic<int> mVersion;
+	Atomic<int> mResetRequested;
+};
+//---------------------------------------------------------------------------
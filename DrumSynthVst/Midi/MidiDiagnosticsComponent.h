@@ -0,0 +1,322 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "LatencyMonitor.h"
+#include "MidiTransmitter.h"
+#include "MidiOutputRouter.h"
+#include "MidiRoundTripTester.h"
+#include "../Preview/PreviewEngine.h"
+#include "../MemoryAccounting.h"
+
+#define DIAGNOSTICS_REFRESH_MS 250
+
+//---------------------------------------------------------------------------
+/** Shows the edit to wire latency histograms and the state of the transmit queues.
+	The link speed used by the transmit scheduler can be changed here too.
+	Below them are the jitter and drift of an incoming MIDI clock, the next
+	line tells whether the preview's audio thread has allocated memory, the
+	one after it how regularly its callbacks arrive and how much of a buffer
+	they take.
+	The memory table lists the live bytes of the MemoryAccounting tags.
+	The last lines are the result of a MidiRoundTripTester run, the
+	sustained rate it measured is offered as another link speed.
+*/
+class MidiDiagnosticsComponent : public Component,
+								 public Timer,
+								 public ButtonListener,
+								 public ComboBoxListener
+{
+public:
+	MidiDiagnosticsComponent(AudioDeviceManager& deviceManager)
+	: mDeviceManager(deviceManager),
+	mTesting(false)
+	{
+		addAndMakeVisible(mResetButton = new TextButton("Reset"));
+		mResetButton->addListener(this);
+
+		addAndMakeVisible(mLinkSpeed = new ComboBox("link speed"));
+		mLinkSpeed->addItem("DIN (31.25 kbaud)",1);
+		mLinkSpeed->addItem("USB",2);
+		mLinkSpeed->addItem("unlimited",3);
+		mLinkSpeed->addListener(this);
+
+		addAndMakeVisible(mEchoInput = new ComboBox("echo input"));
+		mEchoInput->setTextWhenNothingSelected("echo input");
+
+		addAndMakeVisible(mProbeType = new ComboBox("probes"));
+		mProbeType->addItem("SysEx probes",MidiRoundTripTester::PROBE_SYSEX+1);
+		mProbeType->addItem("3 byte probes",MidiRoundTripTester::PROBE_SHORT+1);
+		mProbeType->setSelectedId(MidiRoundTripTester::PROBE_SYSEX+1,true);
+
+		addAndMakeVisible(mRoundTripButton = new TextButton("Round trip"));
+		mRoundTripButton->addListener(this);
+
+		setSize(420,416);
+	};
+
+	~MidiDiagnosticsComponent()
+	{
+		mTester.stop();
+		deleteAllChildren();
+	};
+
+	void visibilityChanged()
+	{
+		if(isVisible())
+		{
+			updateLinkSpeed();
+			updateEchoInputs();
+			startTimer(DIAGNOSTICS_REFRESH_MS);
+		}
+		else
+		{
+			stopTimer();
+			stopRoundTrip();
+		}
+	};
+
+	void timerCallback()
+	{
+		if(mTesting && mTester.isFinished()) stopRoundTrip();
+		repaint();
+	};
+
+	void buttonClicked(Button* button)
+	{
+		if(button == mRoundTripButton)
+		{
+			if(mTesting)	stopRoundTrip();
+			else			startRoundTrip();
+		}
+		else
+		{
+			LatencyMonitor::getInstance()->reset();
+			MidiClockFollower::getInstance()->resetStatistics();
+			AudioThreadAllocations::reset();
+			PreviewEngine::getInstance()->getCallbackTiming().resetStatistics();
+			MemoryAccounting::resetPeaks();
+		}
+		repaint();
+	};
+
+	void comboBoxChanged(ComboBox* comboBox)
+	{
+		const int speeds[] = { LINK_SPEED_DIN, LINK_SPEED_USB, LINK_SPEED_UNLIMITED, mResult.getBytesPerSecond() };
+		MidiOutputRouter::getInstance()->setLinkSpeed(speeds[comboBox->getSelectedId()-1]);
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+
+		const int columns[] = { 8, 130, 200, 270, 340 };
+		int y = 8;
+		g.drawText("stage",columns[0],y,120,16,Justification::left,false);
+		g.drawText("count",columns[1],y,70,16,Justification::right,false);
+		g.drawText("p50",columns[2],y,70,16,Justification::right,false);
+		g.drawText("p99",columns[3],y,70,16,Justification::right,false);
+		g.drawText("max",columns[4],y,70,16,Justification::right,false);
+
+		LatencyMonitor* monitor = LatencyMonitor::getInstance();
+		for(int i=0;i<LatencyMonitor::NUM_STAGES;i++)
+		{
+			y += 18;
+			LatencyHistogram& histogram = monitor->getHistogram(i);
+			g.drawText(LatencyMonitor::getStageName(i),columns[0],y,120,16,Justification::left,false);
+			g.drawText(String(histogram.getNumSamples()),columns[1],y,70,16,Justification::right,false);
+			g.drawText(formatTime(histogram.getPercentile(0.5)),columns[2],y,70,16,Justification::right,false);
+			g.drawText(formatTime(histogram.getPercentile(0.99)),columns[3],y,70,16,Justification::right,false);
+			g.drawText(formatTime(histogram.getMax()),columns[4],y,70,16,Justification::right,false);
+		}
+
+		MidiTransmitter* transmitter = MidiTransmitter::getInstance();
+		y += 30;
+		g.drawText("queued: " + String(transmitter->getQueueDepth(PRIORITY_INTERACTIVE)) + " interactive, "
+			+ String(transmitter->getQueueDepth(PRIORITY_BULK)) + " bulk, drains in "
+			+ String(transmitter->getEstimatedDrainTime(),1) + " ms",columns[0],y,400,16,Justification::left,false);
+
+		y += 18;
+		MidiClockState clock;
+		if(!MidiClockFollower::getInstance()->getState(clock) || !clock.locked)
+		{
+			g.drawText("MIDI clock: none",columns[0],y,400,16,Justification::left,false);
+		}
+		else
+		{
+			g.drawText("MIDI clock: " + String(clock.getBpm(),1) + " bpm, jitter " + String(clock.jitterRms,2) + " ms rms "
+				+ String(clock.jitterMax,2) + " ms max, drift " + String(clock.minBpm,2) + "-" + String(clock.maxBpm,2) + " bpm",
+				columns[0],y,400,16,Justification::left,false);
+		}
+
+		y += 18;
+		const int numAllocations = AudioThreadAllocations::getNumAllocations();
+		g.setColour(numAllocations == 0 ? Colours::white : Colours::orange);
+		g.drawText("preview: " + String(PreviewEngine::getInstance()->getNumPlaying()) + " voices playing, "
+			+ String(numAllocations) + " allocations on the audio thread",columns[0],y,400,16,Justification::left,false);
+
+		y += 18;
+		AudioCallbackStats timing;
+		if(!PreviewEngine::getInstance()->getCallbackTiming().getStats(timing) || timing.numCallbacks == 0)
+		{
+			g.setColour(Colours::white);
+			g.drawText("audio callbacks: none",columns[0],y,400,16,Justification::left,false);
+		}
+		else
+		{
+			g.setColour(timing.numLate == 0 ? Colours::white : Colours::orange);
+			g.drawText("audio callbacks: " + String(timing.bufferSize) + " samples (" + String(timing.bufferMs,2) + " ms), jitter "
+				+ String(timing.jitterRms,2) + " ms rms, longest gap " + String(timing.intervalMax,2) + " ms, load " + String(roundToInt(timing.loadAverage*100.0))
+				+ "% " + String(roundToInt(timing.loadMax*100.0)) + "% max, " + String(timing.numLate) + " late",
+				columns[0],y,400,16,Justification::left,false);
+		}
+
+		y += 24;
+		g.setColour(Colours::white);
+		g.drawText("memory",columns[0],y,120,16,Justification::left,false);
+		g.drawText("live",columns[1],y,70,16,Justification::right,false);
+		g.drawText("blocks",columns[2],y,70,16,Justification::right,false);
+		g.drawText("peak",columns[3],y,70,16,Justification::right,false);
+		g.drawText("allocs",columns[4],y,70,16,Justification::right,false);
+		for(int i=0;i<NUM_MEMORY_TAGS;i++)
+		{
+			y += 18;
+			g.drawText(MemoryAccounting::getTagName(i),columns[0],y,120,16,Justification::left,false);
+			g.drawText(MemoryAccounting::formatBytes(MemoryAccounting::getLiveBytes(i)),columns[1],y,70,16,Justification::right,false);
+			g.drawText(String(MemoryAccounting::getNumLive(i)),columns[2],y,70,16,Justification::right,false);
+			g.drawText(MemoryAccounting::formatBytes(MemoryAccounting::getPeakBytes(i)),columns[3],y,70,16,Justification::right,false);
+			g.drawText(String(MemoryAccounting::getNumAllocations(i)),columns[4],y,70,16,Justification::right,false);
+		}
+
+		y += 24;
+		if(mTesting)
+		{
+			g.drawText("round trip: " + mTester.getProgress(),columns[0],y,400,16,Justification::left,false);
+		}
+		else if(mResult.driver.isEmpty())
+		{
+			g.drawText("round trip: connect the output to an input and start the test",columns[0],y,400,16,Justification::left,false);
+		}
+		else if(mResult.error.isNotEmpty())
+		{
+			g.setColour(Colours::orange);
+			g.drawText("round trip (" + mResult.driver + "): " + mResult.error,columns[0],y,400,16,Justification::left,false);
+		}
+		else
+		{
+			g.drawText("round trip (" + mResult.driver + "): " + formatTime(mResult.p50Us) + " p50, " + formatTime(mResult.p99Us)
+				+ " p99, " + formatTime(mResult.maxUs) + " max, jitter " + formatTime(roundToInt(mResult.jitterUs)),
+				columns[0],y,400,16,Justification::left,false);
+			y += 18;
+			g.drawText(String(mResult.numReceived) + "/" + String(mResult.numSent) + " back, sustained " + String(mResult.maxRate)
+				+ " probes/s = " + String(mResult.getBytesPerSecond()) + " bytes/s",columns[0],y,400,16,Justification::left,false);
+		}
+	};
+
+	void resized()
+	{
+		mEchoInput->setBounds(8,getHeight()-64,200,24);
+		mProbeType->setBounds(212,getHeight()-64,112,24);
+		mRoundTripButton->setBounds(getWidth()-88,getHeight()-64,80,24);
+
+		mLinkSpeed->setBounds(8,getHeight()-32,160,24);
+		mResetButton->setBounds(getWidth()-88,getHeight()-32,80,24);
+	};
+
+private:
+	static String formatTime(int us)
+	{
+		if(us < 1000) return String(us) + " us";
+		return String(us/1000.,2) + " ms";
+	};
+
+	void startRoundTrip()
+	{
+		if(mEchoInput->getSelectedId() == 0) return;
+
+		const MidiRoundTripTester::ProbeType probeType = (MidiRoundTripTester::ProbeType)(mProbeType->getSelectedId()-1);
+		mTester.start(mDeviceManager,mEchoInput->getText(),probeType);
+		mTesting = true;
+		mRoundTripButton->setButtonText("Stop");
+	};
+
+	void stopRoundTrip()
+	{
+		if(!mTesting) return;
+
+		mTester.stop();
+		mResult = mTester.getResult();
+		mTesting = false;
+		mRoundTripButton->setButtonText("Round trip");
+		updateLinkSpeed();
+	};
+
+	/** the measured speed is offered as a fourth entry once there is one*/
+	void updateLinkSpeed()
+	{
+		const int measured = mResult.getBytesPerSecond();
+		if(measured > 0)
+		{
+			const String text = "measured (" + String(measured) + " bytes/s)";
+			if(mLinkSpeed->getNumItems() < 4)	mLinkSpeed->addItem(text,4);
+			else								mLinkSpeed->changeItemText(4,text);
+		}
+
+		const int speed = MidiTransmitter::getInstance()->getLinkSpeed();
+		int id = 3;
+		if(speed == LINK_SPEED_DIN)							id = 1;
+		else if(speed == LINK_SPEED_USB)					id = 2;
+		else if(speed != LINK_SPEED_UNLIMITED && speed == measured)	id = 4;
+		mLinkSpeed->setSelectedId(id,true);
+	};
+
+	void updateEchoInputs()
+	{
+		const String selected = mEchoInput->getText();
+		mEchoInput->clear(true);
+		const StringArray inputs(MidiInput::getDevices());
+		for(int i=0;i<inputs.size();i++)
+		{
+			mEchoInput->addItem(inputs[i],i+1);
+			if(inputs[i] == selected) mEchoInput->setSelectedId(i+1,true);
+		}
+	};
+
+private:
+	AudioDeviceManager& mDeviceManager;
+	MidiRoundTripTester mTester;
+	RoundTripResult mResult;	// of the last finished test
+	bool mTesting;
+
+	TextButton* mResetButton;
+	ComboBox* mLinkSpeed;
+	ComboBox* mEchoInput;
+	ComboBox* mProbeType;
+	TextButton* mRoundTripButton;
+};
+//---------------------------------------------------------------------------
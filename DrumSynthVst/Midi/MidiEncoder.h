@@ -0,0 +1,184 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../controllerAssignments.h"
+
+#define MAX_MESSAGES_PER_PARAMETER 3
+#define MAX_BYTES_PER_PARAMETER 9
+
+//---------------------------------------------------------------------------
+/** Turns parameter changes into CC/NRPN messages for one output.
+
+	The encoder remembers which NRPN address the synth has selected, so a
+	stream of changes to the same NRPN parameter only costs one DATA_ENTRY
+	message per value. When writing raw bytes it also uses running status.
+	Call reset() whenever the output device changes.
+
+	encodeShort() packs each message into a uint32 the way
+	MidiOutput::sendShortMessageNow() and midiOutShortMsg() take it, so the
+	transmit thread never constructs a MidiMessage. encode() is for the
+	places that need MidiMessages, like MIDI files and plugin buffers.
+*/
+class MidiEncoder
+{
+public:
+	MidiEncoder()
+	{
+		reset();
+	};
+
+	~MidiEncoder()
+	{
+	};
+
+	/** forget the cached NRPN address and running status*/
+	void reset()
+	{
+		mNrpnLsb = -1;
+		mNrpnMsb = -1;
+		mRunningStatus = -1;
+	};
+
+	/** writes up to MAX_MESSAGES_PER_PARAMETER messages and returns how many were used*/
+	int encode(int parameterNr, int value, MidiMessage* messages)
+	{
+		uint8_t controllers[MAX_MESSAGES_PER_PARAMETER];
+		uint8_t values[MAX_MESSAGES_PER_PARAMETER];
+		const int num = encodeControllers(parameterNr,value,controllers,values);
+
+		for(int i=0;i<num;i++)
+		{
+			messages[i] = MidiMessage(MIDI_CC,controllers[i],values[i]);
+		}
+		return num;
+	};
+
+	/** writes up to MAX_MESSAGES_PER_PARAMETER packed short messages and returns how many were used*/
+	int encodeShort(int parameterNr, int value, uint32* messages)
+	{
+		uint8_t controllers[MAX_MESSAGES_PER_PARAMETER];
+		uint8_t values[MAX_MESSAGES_PER_PARAMETER];
+		const int num = encodeControllers(parameterNr,value,controllers,values);
+
+		for(int i=0;i<num;i++)
+		{
+			messages[i] = packShortMessage(MIDI_CC,controllers[i],values[i]);
+		}
+		return num;
+	};
+
+	/** the status byte in the lowest 8 bits, the data bytes above it*/
+	static uint32 packShortMessage(int status, int data1, int data2)
+	{
+		return (uint32)(status&0xff) | ((uint32)(data1&0xff) << 8) | ((uint32)(data2&0xff) << 16);
+	};
+
+	static int getShortMessageSize(uint32 packedMessage)
+	{
+		return MidiMessage::getMessageLengthFromFirstByte((uint8)packedMessage);
+	};
+
+	/** adds a packed short message to a buffer without going through a MidiMessage*/
+	static void addShortMessage(MidiBuffer& buffer, uint32 packedMessage, int sampleNumber)
+	{
+		const uint8 data[3] = { (uint8)packedMessage, (uint8)(packedMessage >> 8), (uint8)(packedMessage >> 16) };
+		buffer.addEvent(data,getShortMessageSize(packedMessage),sampleNumber);
+	};
+
+	/** writes up to MAX_BYTES_PER_PARAMETER raw bytes and returns how many were used.
+		The status byte is omitted if it equals the previous one (running status),
+		so this must only be used on a byte stream that nothing else writes into.*/
+	int encodeBytes(int parameterNr, int value, uint8_t* dest)
+	{
+		uint8_t controllers[MAX_MESSAGES_PER_PARAMETER];
+		uint8_t values[MAX_MESSAGES_PER_PARAMETER];
+		const int num = encodeControllers(parameterNr,value,controllers,values);
+
+		int numBytes = 0;
+		for(int i=0;i<num;i++)
+		{
+			if(mRunningStatus != MIDI_CC)
+			{
+				dest[numBytes++] = MIDI_CC;
+				mRunningStatus = MIDI_CC;
+			}
+			dest[numBytes++] = controllers[i];
+			dest[numBytes++] = values[i];
+		}
+		return numBytes;
+	};
+
+	/** has to be called when a non CC message was written into the same byte stream*/
+	void clearRunningStatus()
+	{
+		mRunningStatus = -1;
+	};
+
+private:
+	int encodeControllers(int parameterNr, int value, uint8_t* controllers, uint8_t* values)
+	{
+		int num = 0;
+		if(parameterNr <= 0x7f)
+		{
+			controllers[num] = (uint8_t)(parameterNr+1);
+			values[num++] = (uint8_t)(value&0x7f);
+
+			//the low parameter numbers overlap with the NRPN address controllers
+			if(controllers[0] == NRPN_FINE)		mNrpnLsb = value&0x7f;
+			if(controllers[0] == NRPN_COARSE)	mNrpnMsb = value&0x7f;
+		}
+		else
+		{
+			const int nrpnNr = parameterNr-128;
+			const int lsb = nrpnNr&0x7f;
+			const int msb = (nrpnNr>>7)&0x7f;
+
+			if(lsb != mNrpnLsb)
+			{
+				controllers[num] = NRPN_FINE;
+				values[num++] = (uint8_t)lsb;
+				mNrpnLsb = lsb;
+			}
+			if(msb != mNrpnMsb)
+			{
+				controllers[num] = NRPN_COARSE;
+				values[num++] = (uint8_t)msb;
+				mNrpnMsb = msb;
+			}
+			controllers[num] = DATA_ENTRY;
+			values[num++] = (uint8_t)(value&0x7f);
+		}
+		return num;
+	};
+
+private:
+	int mNrpnLsb;
+	int mNrpnMsb;
+	int mRunningStatus;
+};
+//---------------------------------------------------------------------------
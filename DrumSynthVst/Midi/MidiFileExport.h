@@ -0,0 +1,326 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Pattern.h"
+#include "../controllerAssignments.h"
+#include "../Preview/PreviewSequencer.h"
+#include "MidiEncoder.h"
+#include "EditRecorder.h"
+
+#define MIDI_FILE_PATTERN_PPQ		96		// ticks per quarter note of an exported pattern
+#define MIDI_FILE_EDIT_PPQ			500		// at 120 bpm one tick is one ms
+#define MIDI_FILE_EDIT_TEMPO		500000	// microseconds per quarter note, 120 bpm
+#define MIDI_FILE_STEPS_PER_BAR		16
+#define MIDI_FILE_VELOCITY			100		// steps without a PAR_STEP_VOLUME lock
+#define MIDI_FILE_WRITE_BUFFER_SIZE	65536
+
+//---------------------------------------------------------------------------
+/** Writes the events of one track chunk of a Standard MIDI File, with delta
+	times and running status. Without an output stream it only counts the
+	bytes, that is how the chunk length is found before the events are
+	written.
+*/
+class MidiFileTrackWriter
+{
+public:
+	MidiFileTrackWriter(OutputStream* out) : mOut(out), mNumBytes(0), mLastTick(0), mRunningStatus(0)
+	{
+	};
+
+	/** ticks must not go backwards*/
+	void addMessage(int tick, const uint8* data, int numBytes)
+	{
+		writeDelta(tick);
+
+		//meta events and sysex cancel the running status
+		const uint8 status = data[0];
+		if(status >= 0xf0)
+		{
+			mRunningStatus = 0;
+			write(data,numBytes);
+		}
+		else if(status == mRunningStatus)
+		{
+			write(data+1,numBytes-1);
+		}
+		else
+		{
+			mRunningStatus = status;
+			write(data,numBytes);
+		}
+	};
+
+	void addMessage(int tick, const MidiMessage& message)
+	{
+		addMessage(tick,message.getRawData(),message.getRawDataSize());
+	};
+
+	void addTempo(int tick, int microsecondsPerQuarter)
+	{
+		const uint8 tempo[6] = { 0xff, 0x51, 0x03, (uint8)(microsecondsPerQuarter>>16), (uint8)(microsecondsPerQuarter>>8), (uint8)microsecondsPerQuarter };
+		addMessage(tick,tempo,6);
+	};
+
+	void addEndOfTrack(int tick)
+	{
+		const uint8 end[3] = { 0xff, 0x2f, 0x00 };
+		addMessage(tick,end,3);
+	};
+
+	/** what has been written (or just counted) so far*/
+	int getNumBytes() const
+	{
+		return mNumBytes;
+	};
+
+private:
+	void writeDelta(int tick)
+	{
+		jassert(tick >= mLastTick);
+		uint32 delta = (uint32)jmax(0,tick-mLastTick);
+		mLastTick = jmax(mLastTick,tick);
+
+		//variable length, 7 bits per byte, most significant first
+		uint8 bytes[5];
+		int num = 0;
+		bytes[4-num++] = (uint8)(delta&0x7f);
+		while((delta >>= 7) != 0)
+		{
+			bytes[4-num++] = (uint8)((delta&0x7f)|0x80);
+		}
+		write(bytes+5-num,num);
+	};
+
+	void write(const uint8* data, int numBytes)
+	{
+		if(mOut != NULL) mOut->write(data,numBytes);
+		mNumBytes += numBytes;
+	};
+
+	OutputStream* mOut;
+	int mNumBytes;
+	int mLastTick;
+	uint8 mRunningStatus;
+};
+
+//---------------------------------------------------------------------------
+/** Exports patterns and recorded edit sessions as single track Standard MIDI
+	Files.
+
+	juce's MidiFile keeps a copy of every event as a MidiMessageSequence and
+	builds each track in memory before it is written, which for a session with
+	tens of thousands of controller changes means as many allocations. Here
+	the events are made straight from the Pattern or the EditRecorder array:
+	a first pass only counts the bytes of the track chunk, a second one
+	streams the events through a buffered file stream. Nothing is held in
+	memory but the source.
+
+	Pattern steps are 16th notes, a track plays note PREVIEW_SEQUENCER_NOTE
+	plus its number on channel 1 like the preview. PAR_STEP_VOLUME and
+	PAR_STEP_NOTE locks set velocity and transpose the note, sound parameter locks are sent
+	as CC/NRPN right before the note. Tracks shorter than the export loop on
+	their own length.
+*/
+class MidiFileExport
+{
+public:
+	/** numBars of the pattern at bpm, returns false if the file can't be written*/
+	static bool writePattern(const Pattern& pattern, int bpm, int numBars, const File& file)
+	{
+		PatternSource source(pattern,jlimit(1,999,bpm),jmax(1,numBars));
+		return writeFile(file,MIDI_FILE_PATTERN_PPQ,source);
+	};
+
+	/** the start values at tick 0, then every edit at its time. returns false if the file can't be written*/
+	static bool writeEdits(const EditRecorder& recorder, const File& file)
+	{
+		EditSource source(recorder);
+		return writeFile(file,MIDI_FILE_EDIT_PPQ,source);
+	};
+
+	/** the steps of the groove the preview plays from the pattern parameters, for exporting it*/
+	static void getPreviewPattern(const uint8_t* values, Pattern& pattern)
+	{
+		pattern.clear();
+		const int length = jlimit(1,PREVIEW_SEQUENCER_STEPS,(int)values[PAR_TRACK_LENGTH]);
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			pattern.setLength(t,length);
+			pattern.setStepWord(t,0,PreviewSequencer::getPattern(values,t) & ((1u<<length)-1));
+		}
+	};
+
+private:
+	/** makes the events of the track, called once for counting and once for writing*/
+	class EventSource
+	{
+	public:
+		virtual ~EventSource() {};
+		virtual void addEvents(MidiFileTrackWriter& writer) = 0;
+	};
+
+	static bool writeFile(const File& file, int ppq, EventSource& source)
+	{
+		MidiFileTrackWriter counter(NULL);
+		source.addEvents(counter);
+
+		TemporaryFile temp(file);
+		{
+			FileOutputStream out(temp.getFile(),MIDI_FILE_WRITE_BUFFER_SIZE);
+			if(out.getStatus().failed()) return false;
+
+			//format 0, one track
+			out.write("MThd",4);
+			out.writeIntBigEndian(6);
+			out.writeShortBigEndian(0);
+			out.writeShortBigEndian(1);
+			out.writeShortBigEndian((short)ppq);
+
+			out.write("MTrk",4);
+			out.writeIntBigEndian(counter.getNumBytes());
+			MidiFileTrackWriter writer(&out);
+			source.addEvents(writer);
+			jassert(writer.getNumBytes() == counter.getNumBytes());
+
+			out.flush();
+			if(out.getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	//-----------------------------------------------------------------------
+	class PatternSource : public EventSource
+	{
+	public:
+		PatternSource(const Pattern& pattern, int bpm, int numBars)
+		: mPattern(pattern), mBpm(bpm), mNumBars(numBars)
+		{
+		};
+
+		void addEvents(MidiFileTrackWriter& writer)
+		{
+			MidiEncoder encoder;
+			MidiMessage messages[MAX_MESSAGES_PER_PARAMETER];
+			const int stepTicks = MIDI_FILE_PATTERN_PPQ*4/MIDI_FILE_STEPS_PER_BAR;
+			const int numSteps = mNumBars*MIDI_FILE_STEPS_PER_BAR;
+
+			writer.addTempo(0,60000000/mBpm);
+			for(int s=0;s<numSteps;s++)
+			{
+				const int tick = s*stepTicks;
+				uint8 notes[PATTERN_NUM_TRACKS];
+				int numNotes = 0;
+
+				for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+				{
+					const int step = s % mPattern.getLength(t);
+					if(!mPattern.getStep(t,step)) continue;
+
+					int note = PREVIEW_SEQUENCER_NOTE + t;
+					int velocity = MIDI_FILE_VELOCITY;
+					for(int i=mPattern.getFirstLock(t,step);i<mPattern.getNumLocks();i++)
+					{
+						const PatternLock& lock = mPattern.getLock(i);
+						if(lock.track != t || lock.step != step) break;
+
+						if(lock.parameterNr == PAR_STEP_VOLUME)		velocity = lock.value;
+						else if(lock.parameterNr == PAR_STEP_NOTE)	note += lock.value - 63;
+						else if(lock.parameterNr < END_OF_SOUND_PARAMETERS)
+						{
+							const int num = encoder.encode(lock.parameterNr,lock.value,messages);
+							for(int m=0;m<num;m++)
+							{
+								writer.addMessage(tick,messages[m]);
+							}
+						}
+					}
+
+					const uint8 noteOn[3] = { 0x90, (uint8)jlimit(0,127,note), (uint8)jlimit(1,127,velocity) };
+					writer.addMessage(tick,noteOn,3);
+					notes[numNotes++] = noteOn[1];
+				}
+
+				//drum hits are short, the offs come half way to the next step
+				for(int i=0;i<numNotes;i++)
+				{
+					const uint8 noteOff[3] = { 0x80, notes[i], 0 };
+					writer.addMessage(tick+stepTicks/2,noteOff,3);
+				}
+			}
+			writer.addEndOfTrack(numSteps*stepTicks);
+		};
+
+	private:
+		const Pattern& mPattern;
+		const int mBpm;
+		const int mNumBars;
+	};
+
+	//-----------------------------------------------------------------------
+	class EditSource : public EventSource
+	{
+	public:
+		EditSource(const EditRecorder& recorder) : mRecorder(recorder)
+		{
+		};
+
+		void addEvents(MidiFileTrackWriter& writer)
+		{
+			MidiEncoder encoder;
+			MidiMessage messages[MAX_MESSAGES_PER_PARAMETER];
+			writer.addTempo(0,MIDI_FILE_EDIT_TEMPO);
+
+			const uint8_t* startValues = mRecorder.getStartValues();
+			for(int i=0;i<NUM_PARAMS;i++)
+			{
+				add(writer,encoder,messages,0,i,startValues[i]);
+			}
+
+			int tick = 0;
+			for(int i=0;i<mRecorder.getNumEdits();i++)
+			{
+				const RecordedEdit& edit = mRecorder.getEdit(i);
+				tick = jmax(tick,roundToInt(edit.timeMs));
+				add(writer,encoder,messages,tick,edit.parameterNr,edit.value);
+			}
+			writer.addEndOfTrack(tick);
+		};
+
+	private:
+		static void add(MidiFileTrackWriter& writer, MidiEncoder& encoder, MidiMessage* messages, int tick, int parameterNr, int value)
+		{
+			const int num = encoder.encode(parameterNr,value,messages);
+			for(int m=0;m<num;m++)
+			{
+				writer.addMessage(tick,messages[m]);
+			}
+		};
+
+		const EditRecorder& mRecorder;
+	};
+};
+//---------------------------------------------------------------------------
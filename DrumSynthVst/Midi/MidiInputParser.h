@@ -0,0 +1,171 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../controllerAssignments.h"
+#include "../ParameterStore.h"
+#include "PatchSysEx.h"
+#include "PatternSysEx.h"
+#include "SysExStreamParser.h"
+#include "MidiClockFollower.h"
+#include "MidiCapture.h"
+
+//---------------------------------------------------------------------------
+/** Decodes the CC/NRPN stream, patch dumps and pattern dumps sent by the drumsynth.
+
+	Runs on the MIDI thread and only writes into the ParameterStore, which
+	takes care of updating the UI, and into the MidiTransmitter's mirror of
+	the synth. Clock and transport messages go to the
+	MidiClockFollower. This is the reverse of MidiEncoder:
+	CC n sets parameter n-1, DATA_ENTRY sets parameter 128 + the NRPN
+	address selected with NRPN_COARSE/NRPN_FINE. Every message is put into
+	the MidiCapture ring before it is looked at.
+*/
+class MidiInputParser : public MidiInputCallback
+{
+public:
+	MidiInputParser() : mBankReceiver(NULL), mPatternListener(NULL)
+	{
+		reset();
+	};
+
+	~MidiInputParser()
+	{
+	};
+
+	/** forget the selected NRPN address*/
+	void reset()
+	{
+		mNrpnLsb = -1;
+		mNrpnMsb = -1;
+	};
+
+	/** while a receiver is set, incoming dumps are passed to it as a bank
+		instead of changing the current sound. NULL switches back*/
+	void setBankReceiver(SysExStreamParser* receiver)
+	{
+		const ScopedLock lock(mBankLock);
+		mBankReceiver = receiver;
+	};
+
+	/** gets the pattern dumps, they don't go to the bank receiver. NULL drops them*/
+	void setPatternListener(PatternSysEx::Listener* listener)
+	{
+		const ScopedLock lock(mBankLock);
+		mPatternListener = listener;
+	};
+
+	void handleIncomingMidiMessage(MidiInput* /*source*/, const MidiMessage& message)
+	{
+		MidiCapture::getInstance()->capture(false,message,LatencyMonitor::getTime());
+		if(MidiClockFollower::getInstance()->handleMessage(message)) return;
+
+		if(message.isSysEx())
+		{
+			handleSysEx(message);
+		}
+		else if(message.isController() && message.getChannel() == 1)
+		{
+			handleController(message.getControllerNumber(),message.getControllerValue());
+		}
+	};
+
+private:
+	void handleController(int controller, int value)
+	{
+		switch(controller)
+		{
+		case NRPN_FINE:
+			mNrpnLsb = value;
+			break;
+
+		case NRPN_COARSE:
+			mNrpnMsb = value;
+			break;
+
+		case DATA_ENTRY:
+			if(mNrpnLsb >= 0 && mNrpnMsb >= 0)
+			{
+				setValue(128 + ((mNrpnMsb<<7)|mNrpnLsb),value);
+			}
+			break;
+
+		default:
+			if(controller > 0)
+			{
+				setValue(controller-1,value);
+			}
+			break;
+		}
+	};
+
+	void handleSysEx(const MidiMessage& message)
+	{
+		{
+			const ScopedLock lock(mBankLock);
+			if(PatternSysEx::isPatternDump(message))
+			{
+				int patternNr;
+				Pattern pattern;
+				if(mPatternListener != NULL && PatternSysEx::parsePatternDump(message,patternNr,pattern))
+				{
+					mPatternListener->patternDumpReceived(patternNr,pattern);
+				}
+				return;
+			}
+			if(mBankReceiver != NULL)
+			{
+				mBankReceiver->feed(message.getRawData(),message.getRawDataSize());
+				return;
+			}
+		}
+
+		uint8_t data[PATCH_DATA_SIZE];
+		if(!PatchSysEx::parsePatchDump(message,data)) return;
+
+		//the name isn't part of the parameter set
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			setValue(i,data[PATCH_NAME_LENGTH+i]);
+		}
+	};
+
+	/** the synth has the value now*/
+	static void setValue(int parameterNr, int value)
+	{
+		ParameterStore::getInstance()->setValueFromMidi(parameterNr,value);
+		MidiTransmitter::getInstance()->setDeviceValue(parameterNr,value);
+	};
+
+private:
+	int mNrpnLsb;
+	int mNrpnMsb;
+
+	CriticalSection mBankLock;		// guards both receivers
+	SysExStreamParser* mBankReceiver;
+	PatternSysEx::Listener* mPatternListener;
+};
+//---------------------------------------------------------------------------
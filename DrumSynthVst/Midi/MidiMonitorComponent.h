@@ -0,0 +1,342 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../parameterRanges.h"
+#include "../controllerAssignments.h"
+#include "MidiCapture.h"
+
+#define MONITOR_REFRESH_MS			100
+#define MONITOR_ROW_HEIGHT			16
+#define MONITOR_NRPN_LOOKBACK		64		// records searched for the address of a DATA_ENTRY
+
+// columns of the table
+#define MONITOR_COLUMN_TIME			1
+#define MONITOR_COLUMN_DIRECTION	2
+#define MONITOR_COLUMN_BYTES		3
+#define MONITOR_COLUMN_MEANING		4
+
+//---------------------------------------------------------------------------
+/** Lists the MIDI traffic of the MidiCapture ring, newest at the bottom.
+
+	The capture only stores raw records. The TableListBox asks for the
+	visible rows alone, and only those are decoded when they are painted:
+	CC n is parameter n-1 and a DATA_ENTRY is parameter 128 + the NRPN
+	address of the NRPN_COARSE/NRPN_FINE records before it in the same
+	direction, as MidiInputParser reads them. The names are the menu
+	names of valueNames. So the list costs the same at full link rate as
+	for an idle port.
+
+	While "Follow" is on the list keeps scrolling to the newest message,
+	switched off it stays on the records it showed, rows that have been
+	overwritten since say so. The line below counts the messages per
+	second in each direction.
+*/
+class MidiMonitorComponent : public Component,
+							 public TableListBoxModel,
+							 public ButtonListener,
+							 private Timer
+{
+public:
+	MidiMonitorComponent()
+	: mBegin(0),
+	mEnd(0),
+	mFirstTime(0),
+	mLastIn(0),
+	mLastOut(0),
+	mInRate(0),
+	mOutRate(0),
+	mLastTick(0)
+	{
+		addAndMakeVisible(mTable = new TableListBox("midi",this));
+		mTable->setRowHeight(MONITOR_ROW_HEIGHT);
+		mTable->setColour(ListBox::backgroundColourId,Colour(0xff3a3a3a));
+		mTable->getHeader().addColumn("time",MONITOR_COLUMN_TIME,80);
+		mTable->getHeader().addColumn("",MONITOR_COLUMN_DIRECTION,32);
+		mTable->getHeader().addColumn("bytes",MONITOR_COLUMN_BYTES,100);
+		mTable->getHeader().addColumn("message",MONITOR_COLUMN_MEANING,260);
+
+		addAndMakeVisible(mFollowButton = new ToggleButton("Follow"));
+		mFollowButton->setToggleState(true,false);
+		mFollowButton->addListener(this);
+
+		addAndMakeVisible(mClearButton = new TextButton("Clear"));
+		mClearButton->addListener(this);
+
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mParameterNames.add("p" + String(i));
+		}
+		for(int page=NUM_PAGES-1;page>=0;page--)
+		{
+			for(int subPage=NUM_SUB_PAGES-1;subPage>=0;subPage--)
+			{
+				const Page& menu = menuPages[page][subPage];
+				for(int i=7;i>=0;i--)
+				{
+					//backwards, so the first page that shows a parameter names it
+					const uint8_t text = *(&menu.top1 + i);
+					const uint8_t parameterNr = *(&menu.bot1 + i);
+					if(text == TEXT_EMPTY || parameterNr >= NUM_PARAMS) continue;
+					String name = String(catNames[valueNames[text].category]).trim() + " " + String(longNames[valueNames[text].longName]).trim();
+					if(page < NUM_VOICES) name << " on voice " << (page+1);
+					mParameterNames.set(parameterNr,name);
+				}
+			}
+		}
+
+		setSize(500,480);
+	};
+
+	~MidiMonitorComponent()
+	{
+		stopTimer();
+		deleteAllChildren();
+	};
+
+	void visibilityChanged()
+	{
+		if(isVisible())
+		{
+			update();
+			startTimer(MONITOR_REFRESH_MS);
+		}
+		else
+		{
+			stopTimer();
+		}
+	};
+
+	void timerCallback()
+	{
+		update();
+	};
+
+	void buttonClicked(Button* button)
+	{
+		if(button == mClearButton)
+		{
+			mBegin = MidiCapture::getInstance()->getEnd();
+			mEnd = mBegin;
+			mTable->updateContent();
+		}
+		update();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+		g.drawText(String(mEnd-mBegin) + " messages, " + String(mInRate) + "/s in, " + String(mOutRate) + "/s out",
+			8,getHeight()-28,getWidth()-180,16,Justification::left,false);
+	};
+
+	void resized()
+	{
+		mTable->setBounds(8,8,getWidth()-16,getHeight()-48);
+		mFollowButton->setBounds(getWidth()-168,getHeight()-32,72,24);
+		mClearButton->setBounds(getWidth()-88,getHeight()-32,80,24);
+	};
+
+	//-----------------------------------------------------------------------
+	int getNumRows()
+	{
+		return mEnd - mBegin;
+	};
+
+	void paintRowBackground(Graphics& g, int rowNumber, int /*width*/, int /*height*/, bool rowIsSelected)
+	{
+		if(rowIsSelected)			g.fillAll(Colour(0xff6a8f3a));
+		else if(rowNumber & 1)		g.fillAll(Colour(0xff424242));
+	};
+
+	void paintCell(Graphics& g, int rowNumber, int columnId, int width, int height, bool /*rowIsSelected*/)
+	{
+		const int position = mBegin + rowNumber;
+		MidiCaptureRecord record;
+		g.setFont(13.f);
+		if(!MidiCapture::getInstance()->read(position,record))
+		{
+			g.setColour(Colours::grey);
+			if(columnId == MONITOR_COLUMN_MEANING) g.drawText("overwritten",4,0,width-8,height,Justification::left,false);
+			return;
+		}
+
+		g.setColour(record.isOutgoing() ? Colours::white : Colour(0xffb8e08a));
+		switch(columnId)
+		{
+		case MONITOR_COLUMN_TIME:
+			//seconds since the first row, the timestamps wrap after ~71 minutes
+			{
+				MidiCaptureRecord first;
+				const int reference = MidiCapture::getInstance()->read(mBegin,first) ? first.time : mFirstTime;
+				g.drawText(String((record.time - reference)/1000000.,3),2,0,width-4,height,Justification::right,false);
+			}
+			break;
+		case MONITOR_COLUMN_DIRECTION:
+			g.drawText(record.isOutgoing() ? "out" : "in",4,0,width-8,height,Justification::left,false);
+			break;
+		case MONITOR_COLUMN_BYTES:
+			g.drawText(formatBytes(record),4,0,width-8,height,Justification::left,true);
+			break;
+		case MONITOR_COLUMN_MEANING:
+			g.drawText(decode(position,record),4,0,width-8,height,Justification::left,true);
+			break;
+		}
+	};
+
+private:
+	/** takes the new records and the rates of the capture*/
+	void update()
+	{
+		MidiCapture* capture = MidiCapture::getInstance();
+		const uint32 now = Time::getMillisecondCounter();
+		const int numIn = capture->getNumCaptured(false);
+		const int numOut = capture->getNumCaptured(true);
+		if(mLastTick != 0 && now != mLastTick)
+		{
+			mInRate = (int)((numIn - mLastIn)*1000/(int)(now - mLastTick));
+			mOutRate = (int)((numOut - mLastOut)*1000/(int)(now - mLastTick));
+		}
+		mLastIn = numIn;
+		mLastOut = numOut;
+		mLastTick = now;
+
+		if(mFollowButton->getToggleState())
+		{
+			mEnd = capture->getEnd();
+			if(mEnd - mBegin > MIDI_CAPTURE_SIZE) mBegin = mEnd - MIDI_CAPTURE_SIZE;
+
+			MidiCaptureRecord first;
+			if(capture->read(mBegin,first)) mFirstTime = first.time;
+			mTable->updateContent();
+			if(mEnd > mBegin) mTable->scrollToEnsureRowIsOnscreen(mEnd-mBegin-1);
+		}
+		mTable->repaint();
+		repaint(0,getHeight()-32,getWidth(),32);
+	};
+
+	static String formatBytes(const MidiCaptureRecord& record)
+	{
+		String text;
+		for(int i=0;i<jmin(4,record.getSize());i++)
+		{
+			text << String::toHexString(record.getByte(i)).paddedLeft('0',2) << " ";
+		}
+		if(record.getSize() > 4) text << "...";
+		return text.trimEnd();
+	};
+
+	String decode(int position, const MidiCaptureRecord& record) const
+	{
+		if(record.isSysEx()) return "SysEx, " + String(record.getSize()) + " bytes";
+
+		const int status = record.getByte(0);
+		const int channel = (status & 0x0f) + 1;
+		switch(status & 0xf0)
+		{
+		case 0x80:	return "note off " + String(record.getByte(1)) + ", channel " + String(channel);
+		case 0x90:	return "note on " + String(record.getByte(1)) + " velocity " + String(record.getByte(2)) + ", channel " + String(channel);
+		case 0xc0:	return "program " + String(record.getByte(1)) + ", channel " + String(channel);
+		case 0xe0:	return "pitch bend " + String(((record.getByte(2)<<7)|record.getByte(1)) - 8192) + ", channel " + String(channel);
+		case 0xb0:	break;
+		case 0xf0:
+			switch(status)
+			{
+			case 0xf8:	return "clock";
+			case 0xfa:	return "start";
+			case 0xfb:	return "continue";
+			case 0xfc:	return "stop";
+			case 0xf2:	return "song position " + String((record.getByte(2)<<7)|record.getByte(1));
+			default:	return "system " + String::toHexString(status);
+			}
+		default:	return String::empty;
+		}
+
+		const int controller = record.getByte(1);
+		const int value = record.getByte(2);
+		if(channel != 1) return "CC " + String(controller) + " = " + String(value) + ", channel " + String(channel);
+
+		switch(controller)
+		{
+		case NRPN_COARSE:	return "NRPN address coarse " + String(value);
+		case NRPN_FINE:		return "NRPN address fine " + String(value);
+		case DATA_ENTRY:
+			{
+				const int address = findNrpnAddress(position,record.isOutgoing());
+				if(address < 0) return "data entry " + String(value) + ", no NRPN address";
+				return describeValue(128 + address,value);
+			}
+		default:
+			if(controller == 0) return "CC 0 = " + String(value);
+			return describeValue(controller-1,value);
+		}
+	};
+
+	/** the NRPN address selected before a DATA_ENTRY, from the visible row's neighbours only*/
+	int findNrpnAddress(int position, bool outgoing) const
+	{
+		MidiCapture* capture = MidiCapture::getInstance();
+		int coarse = -1;
+		int fine = -1;
+		for(int i=1;i<=MONITOR_NRPN_LOOKBACK && (coarse < 0 || fine < 0);i++)
+		{
+			MidiCaptureRecord record;
+			if(!capture->read(position-i,record)) break;
+			if(record.isOutgoing() != outgoing || record.isSysEx() || record.getByte(0) != 0xb0) continue;
+
+			if(record.getByte(1) == NRPN_COARSE && coarse < 0)	coarse = record.getByte(2);
+			else if(record.getByte(1) == NRPN_FINE && fine < 0)	fine = record.getByte(2);
+		}
+		if(coarse < 0 || fine < 0) return -1;
+		return (coarse<<7) | fine;
+	};
+
+	/** "Osc Coarse on voice 1 = 64", in the units the UI shows*/
+	String describeValue(int parameterNr, int value) const
+	{
+		if(parameterNr >= NUM_PARAMS) return "p" + String(parameterNr) + " = " + String(value);
+
+		const ParameterRange& range = parameterRanges[parameterNr];
+		return mParameterNames[parameterNr] + " = " + String(range.min < 0 ? value + range.min : value);
+	};
+
+	TableListBox* mTable;
+	ToggleButton* mFollowButton;
+	TextButton* mClearButton;
+	StringArray mParameterNames;	// by parameter number, the first menu page showing it
+
+	int mBegin;			// capture position of row 0
+	int mEnd;			// capture position after the last row
+	int mFirstTime;		// time of row 0 while it was still in the ring
+	int mLastIn;
+	int mLastOut;
+	int mInRate;
+	int mOutRate;
+	uint32 mLastTick;
+};
+//---------------------------------------------------------------------------
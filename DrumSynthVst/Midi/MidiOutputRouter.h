@@ -0,0 +1,233 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Patch.h"
+#include "MidiTransmitter.h"
+#include "RemoteEditSender.h"
+
+#define ROUTER_CONFIG_TAG			"EXTRAMIDIOUTPUT"	// one child of midi.cfg per extra unit
+#define ROUTER_NAME_ATTRIBUTE		"name"
+#define ROUTER_TARGET_ATTRIBUTE		"editTarget"		// of the midi.cfg root
+#define ROUTER_ALL_UNITS			-1					// setTargetUnit(): every unit gets the edits
+
+//---------------------------------------------------------------------------
+/** Sends the edits to one or several synths, each on its own MIDI port.
+
+	Unit 0 is the MidiTransmitter singleton with the output of the MIDI
+	setup. Every extra output gets a MidiTransmitter of its own, so each
+	unit has its own queues, sender thread and mirror of the synth's state.
+	With ROUTER_ALL_UNITS an edit is put into every queue, the threads
+	then send it at the same time, and a patch load only sends what each
+	synth is missing.
+
+	While the RemoteEditSender is connected every edit and patch also goes
+	to the editor on the other end, whatever the target unit is.
+
+	The extra outputs are kept in midi.cfg. Message thread only, the
+	units themselves can be used from any thread.
+*/
+class MidiOutputRouter
+{
+public:
+	MidiOutputRouter() : mTargetUnit(0)
+	{
+	};
+
+	~MidiOutputRouter()
+	{
+		closeExtraOutputs();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (MidiOutputRouter, false)
+
+	int getNumUnits() const
+	{
+		return 1 + mUnits.size();
+	};
+
+	MidiTransmitter* getUnit(int index)
+	{
+		return index == 0 ? MidiTransmitter::getInstance() : mUnits[index-1];
+	};
+
+	/** "setup output" for unit 0, the device name for the others*/
+	String getUnitName(int index) const
+	{
+		return index == 0 ? String("setup output") : mNames[index-1];
+	};
+
+	const StringArray& getExtraOutputs() const
+	{
+		return mNames;
+	};
+
+	/** opens the outputs as units 1..n, closing the ones before. returns the names that couldn't be opened*/
+	StringArray setExtraOutputs(const StringArray& names)
+	{
+		closeExtraOutputs();
+
+		StringArray failed;
+		const StringArray devices(MidiOutput::getDevices());
+		for(int i=0;i<names.size();i++)
+		{
+			const int deviceIndex = devices.indexOf(names[i]);
+			MidiOutput* output = deviceIndex >= 0 ? MidiOutput::openDevice(deviceIndex) : NULL;
+			if(output == NULL)
+			{
+				failed.add(names[i]);
+				continue;
+			}
+
+			MidiTransmitter* unit = new MidiTransmitter();
+			unit->setLinkSpeed(MidiTransmitter::getInstance()->getLinkSpeed());
+			unit->setMidiOutput(output);
+			mOutputs.add(output);
+			mUnits.add(unit);
+			mNames.add(names[i]);
+		}
+
+		if(mTargetUnit >= getNumUnits()) mTargetUnit = 0;
+		return failed;
+	};
+
+	/** a unit index or ROUTER_ALL_UNITS*/
+	void setTargetUnit(int unit)
+	{
+		mTargetUnit = (unit == ROUTER_ALL_UNITS) ? unit : jlimit(0,getNumUnits()-1,unit);
+	};
+
+	int getTargetUnit() const
+	{
+		return mTargetUnit;
+	};
+
+	RemoteEditSender& getRemote()
+	{
+		return mRemote;
+	};
+
+	/** see MidiTransmitter::sendParameter()*/
+	void sendParameter(int parameterNr, int value, int priority = PRIORITY_INTERACTIVE)
+	{
+		if(mRemote.isConnected()) mRemote.queueParameter(parameterNr,value);
+		if(mTargetUnit != ROUTER_ALL_UNITS)
+		{
+			getUnit(mTargetUnit)->sendParameter(parameterNr,value,priority);
+			return;
+		}
+		for(int i=0;i<getNumUnits();i++)
+		{
+			getUnit(i)->sendParameter(parameterNr,value,priority);
+		}
+	};
+
+	/** see MidiTransmitter::sendParameterBurst()*/
+	void sendParameterBurst(const int* parameterNrs, const int* values, int num)
+	{
+		if(mRemote.isConnected())
+		{
+			for(int i=0;i<num;i++)
+			{
+				mRemote.queueParameter(parameterNrs[i],values[i]);
+			}
+		}
+		if(mTargetUnit != ROUTER_ALL_UNITS)
+		{
+			getUnit(mTargetUnit)->sendParameterBurst(parameterNrs,values,num);
+			return;
+		}
+		for(int i=0;i<getNumUnits();i++)
+		{
+			getUnit(i)->sendParameterBurst(parameterNrs,values,num);
+		}
+	};
+
+	/** see MidiTransmitter::sendPatch(), every unit sends its own diff. returns the largest one*/
+	int sendPatch(Patch* patch, const MidiMessage* dump = NULL)
+	{
+		if(mRemote.isConnected()) mRemote.queuePatch(patch);
+		if(mTargetUnit != ROUTER_ALL_UNITS) return getUnit(mTargetUnit)->sendPatch(patch,dump);
+
+		int numDiffering = 0;
+		for(int i=0;i<getNumUnits();i++)
+		{
+			numDiffering = jmax(numDiffering,getUnit(i)->sendPatch(patch,dump));
+		}
+		return numDiffering;
+	};
+
+	/** all units are on the same kind of link*/
+	void setLinkSpeed(int bytesPerSecond)
+	{
+		for(int i=0;i<getNumUnits();i++)
+		{
+			getUnit(i)->setLinkSpeed(bytesPerSecond);
+		}
+	};
+
+	void loadFromConfig(const XmlElement* config)
+	{
+		if(config == NULL) return;
+
+		StringArray names;
+		forEachXmlChildElementWithTagName(*config,child,ROUTER_CONFIG_TAG)
+		{
+			names.add(child->getStringAttribute(ROUTER_NAME_ATTRIBUTE));
+		}
+		setExtraOutputs(names);
+		setTargetUnit(config->getIntAttribute(ROUTER_TARGET_ATTRIBUTE,0));
+	};
+
+	void saveToConfig(XmlElement& config) const
+	{
+		config.deleteAllChildElementsWithTagName(ROUTER_CONFIG_TAG);
+		for(int i=0;i<mNames.size();i++)
+		{
+			XmlElement* child = config.createNewChildElement(ROUTER_CONFIG_TAG);
+			child->setAttribute(ROUTER_NAME_ATTRIBUTE,mNames[i]);
+		}
+		config.setAttribute(ROUTER_TARGET_ATTRIBUTE,mTargetUnit);
+	};
+
+private:
+	void closeExtraOutputs()
+	{
+		//the threads stop before their outputs are closed
+		mUnits.clear();
+		mOutputs.clear();
+		mNames.clear();
+	};
+
+	OwnedArray<MidiTransmitter> mUnits;		// units 1..n
+	OwnedArray<MidiOutput> mOutputs;
+	StringArray mNames;
+	int mTargetUnit;
+
+	RemoteEditSender mRemote;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,147 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Source/AudioDemoSetupPage.h"
+#include "MidiOutputRouter.h"
+
+#define OUTPUTS_ROW_HEIGHT	24
+
+//---------------------------------------------------------------------------
+/** Picks the extra MIDI outputs of the MidiOutputRouter and the unit the
+	edits go to. The output of the MIDI setup is always unit 1, it isn't
+	in the list. Every change is saved to midi.cfg.
+*/
+class MidiOutputsComponent : public Component,
+							 public ButtonListener,
+							 public ComboBoxListener
+{
+public:
+	MidiOutputsComponent(AudioDeviceManager& deviceManager)
+	: mDeviceManager(deviceManager)
+	{
+		addAndMakeVisible(mTarget = new ComboBox("edit target"));
+		mTarget->addListener(this);
+
+		setSize(360,200);
+	};
+
+	~MidiOutputsComponent()
+	{
+		deleteAllChildren();
+	};
+
+	void visibilityChanged()
+	{
+		if(isVisible()) updateOutputs();
+	};
+
+	void buttonClicked(Button*)
+	{
+		StringArray names;
+		for(int i=0;i<mOutputs.size();i++)
+		{
+			if(mOutputs[i]->getToggleState()) names.add(mOutputs[i]->getButtonText());
+		}
+
+		const StringArray failed = MidiOutputRouter::getInstance()->setExtraOutputs(names);
+		if(failed.size() > 0)
+		{
+			AlertWindow::showMessageBox(AlertWindow::WarningIcon,"MIDI Outputs","Could not open " + failed.joinIntoString(", ") + ".");
+		}
+		AudioDemoSetupPage::saveConfig(mDeviceManager);
+		updateOutputs();
+	};
+
+	void comboBoxChanged(ComboBox*)
+	{
+		//id 1 is all units, unit n has id n+2
+		const int id = mTarget->getSelectedId();
+		MidiOutputRouter::getInstance()->setTargetUnit(id == 1 ? ROUTER_ALL_UNITS : id-2);
+		AudioDemoSetupPage::saveConfig(mDeviceManager);
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+		g.drawText("edits go to",8,8,100,24,Justification::left,false);
+		g.drawText("extra outputs, each with its own sender thread:",8,40,getWidth()-16,OUTPUTS_ROW_HEIGHT,Justification::left,false);
+	};
+
+	void resized()
+	{
+		mTarget->setBounds(112,8,getWidth()-120,24);
+		for(int i=0;i<mOutputs.size();i++)
+		{
+			mOutputs[i]->setBounds(8,40+(i+1)*OUTPUTS_ROW_HEIGHT,getWidth()-16,OUTPUTS_ROW_HEIGHT);
+		}
+	};
+
+private:
+	/** one toggle per device except the one of the MIDI setup*/
+	void updateOutputs()
+	{
+		for(int i=0;i<mOutputs.size();i++)
+		{
+			removeChildComponent(mOutputs[i]);
+		}
+		mOutputs.clear();
+
+		MidiOutputRouter* router = MidiOutputRouter::getInstance();
+		const StringArray devices(MidiOutput::getDevices());
+		for(int i=0;i<devices.size();i++)
+		{
+			if(devices[i] == mDeviceManager.getDefaultMidiOutputName()) continue;
+
+			ToggleButton* toggle = new ToggleButton(devices[i]);
+			toggle->setColour(ToggleButton::textColourId,Colours::white);
+			toggle->setToggleState(router->getExtraOutputs().contains(devices[i]),false);
+			toggle->addListener(this);
+			addAndMakeVisible(toggle);
+			mOutputs.add(toggle);
+		}
+
+		mTarget->clear(true);
+		mTarget->addItem("all units at once",1);
+		for(int i=0;i<router->getNumUnits();i++)
+		{
+			mTarget->addItem("unit " + String(i+1) + " (" + router->getUnitName(i) + ")",i+2);
+		}
+		const int target = router->getTargetUnit();
+		mTarget->setSelectedId(target == ROUTER_ALL_UNITS ? 1 : target+2,true);
+
+		setSize(getWidth(),jmax(200,40+(mOutputs.size()+2)*OUTPUTS_ROW_HEIGHT));
+		resized();
+	};
+
+	AudioDeviceManager& mDeviceManager;
+
+	ComboBox* mTarget;
+	OwnedArray<ToggleButton> mOutputs;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,509 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "LatencyMonitor.h"
+#include "MidiTransmitter.h"
+#include "PreciseWait.h"
+#include "../ThreadPriorities.h"
+
+#define ROUNDTRIP_MAX_IN_FLIGHT			4096	// probes whose send time is kept, a power of 2
+#define ROUNDTRIP_LATENCY_PROBES		200		// sent one at a time to measure the idle round trip
+#define ROUNDTRIP_LATENCY_INTERVAL_MS	10
+#define ROUNDTRIP_TIMEOUT_MS			500		// a probe that isn't back by then is lost
+#define ROUNDTRIP_STEP_MS				1000	// how long each rate of the sweep is sent
+#define ROUNDTRIP_START_RATE			100		// probes per second
+#define ROUNDTRIP_MAX_RATE				25600
+#define ROUNDTRIP_REFINE_STEPS			3		// bisections between the last good and the first bad rate
+#define ROUNDTRIP_QUEUE_MARGIN_US		2000	// p95 growth over the idle p95 that means the messages queue up
+#define ROUNDTRIP_MIN_SEND_RATIO		0.9		// below this share of the wanted rate the driver can't keep up
+
+#define ROUNDTRIP_SYSEX_ID				0x7d	// non commercial, the synth ignores it
+#define ROUNDTRIP_SHORT_STATUS			0xaf	// poly pressure on channel 16
+#define ROUNDTRIP_JACK_DEVICE			"JACK MIDI"	// the device juce makes for the MIDI ports of the JACK client
+
+//---------------------------------------------------------------------------
+/** one rate of the throughput sweep*/
+struct RoundTripStep
+{
+	int rate;			// probes per second wanted
+	int numSent;
+	int numLost;
+	int p95Us;
+	bool sustained;
+};
+
+//---------------------------------------------------------------------------
+/** what MidiRoundTripTester measured*/
+struct RoundTripResult
+{
+	RoundTripResult()
+	: probeSize(0),
+	numSent(0),
+	numReceived(0),
+	minUs(0),
+	p50Us(0),
+	p95Us(0),
+	p99Us(0),
+	maxUs(0),
+	jitterUs(0),
+	maxRate(0)
+	{
+	};
+
+	/** what the link carried at the highest sustained rate, for MidiTransmitter::setLinkSpeed()*/
+	int getBytesPerSecond() const
+	{
+		return maxRate*probeSize;
+	};
+
+	String driver;
+	String output;
+	String input;
+	String error;		// empty if the test ran
+	int probeSize;		// bytes per probe
+
+	//probes sent one at a time
+	int numSent;
+	int numReceived;
+	int minUs;
+	int p50Us;
+	int p95Us;
+	int p99Us;
+	int maxUs;
+	double jitterUs;	// standard deviation
+
+	Array<RoundTripStep> steps;
+	int maxRate;		// highest rate without losses or queueing, 0 if none
+};
+
+//---------------------------------------------------------------------------
+/** Measures the MIDI round trip from the selected output to an input that
+	echoes it, a synth with MIDI thru, a cable from out to in or a virtual
+	loopback port.
+
+	Every probe carries a sequence number, its send time is kept by the
+	tester. The time is taken right before the MidiTransmitter sends it, so
+	the round trip includes the driver call, the wire and the input driver.
+	PROBE_SYSEX probes are F0 7D 'S' 'P' seq seq seq F7 and safe with a
+	synth in the loop. PROBE_SHORT probes are 3 byte poly pressure messages
+	on channel 16, they go out packed like the parameter changes the
+	transmitter sends, use them with a cable or a loopback port.
+
+	The test has two parts: ROUNDTRIP_LATENCY_PROBES probes are sent
+	ROUNDTRIP_LATENCY_INTERVAL_MS apart for the idle latency distribution.
+	Then the rate is doubled from ROUNDTRIP_START_RATE every
+	ROUNDTRIP_STEP_MS until probes get lost, the driver can't send them in
+	time or their p95 rises by ROUNDTRIP_QUEUE_MARGIN_US because they queue
+	up. The step between the last good and the first bad rate is bisected.
+
+	The input is opened through the AudioDeviceManager, so it can be the
+	one the editor already listens to. start() and stop() are called on
+	the message thread, stop() once isFinished() returns true. juce uses
+	one backend per platform, on Linux JACK MIDI as well, getDriverName()
+	tells which was measured.
+*/
+class MidiRoundTripTester : public Thread,
+							public MidiInputCallback
+{
+public:
+	enum ProbeType
+	{
+		PROBE_SYSEX = 0,
+		PROBE_SHORT
+	};
+
+	MidiRoundTripTester()
+	: Thread("MIDI round trip"),
+	mDeviceManager(NULL),
+	mWasEnabled(false),
+	mProbeType(PROBE_SYSEX),
+	mFinished(0),
+	mNextSequence(0),
+	mNumSent(0),
+	mNumReceived(0)
+	{
+		for(int i=0;i<ROUNDTRIP_MAX_IN_FLIGHT;i++)
+		{
+			mSlotSequence[i].set(-1);
+		}
+	};
+
+	~MidiRoundTripTester()
+	{
+		stop();
+	};
+
+	/** the MIDI backend of the device*/
+	static String getDriverName(const String& deviceName)
+	{
+#if JUCE_WINDOWS
+		return "WinMM";
+#elif JUCE_LINUX
+		return deviceName == ROUNDTRIP_JACK_DEVICE ? "JACK" : "ALSA";
+#elif JUCE_MAC
+		return "CoreMIDI";
+#else
+		return "unknown";
+#endif
+	};
+
+	/** listen on inputName and start sending probes to the transmitter's output*/
+	void start(AudioDeviceManager& deviceManager, const String& inputName, ProbeType probeType)
+	{
+		stop();
+		mDeviceManager = &deviceManager;
+		mInputName = inputName;
+		mProbeType = probeType;
+		mFinished.set(0);
+
+		mWasEnabled = deviceManager.isMidiInputEnabled(inputName);
+		if(!mWasEnabled) deviceManager.setMidiInputEnabled(inputName,true);
+		deviceManager.addMidiInputCallback(inputName,this);
+
+		{
+			const ScopedLock sl(mResultLock);
+			mResult = RoundTripResult();
+			mResult.driver = getDriverName(inputName);
+			mResult.output = deviceManager.getDefaultMidiOutputName();
+			mResult.input = inputName;
+			mResult.probeSize = getProbeSize();
+			mProgress = "starting";
+		}
+		startThread(PRIORITY_CLASS_MIDI);
+	};
+
+	/** wait for the test thread and close the input again*/
+	void stop()
+	{
+		stopThread(ROUNDTRIP_STEP_MS + ROUNDTRIP_TIMEOUT_MS);
+		if(mDeviceManager == NULL) return;
+
+		mDeviceManager->removeMidiInputCallback(mInputName,this);
+		if(!mWasEnabled) mDeviceManager->setMidiInputEnabled(mInputName,false);
+		mDeviceManager = NULL;
+	};
+
+	bool isFinished()
+	{
+		return mFinished.get() != 0;
+	};
+
+	/** what the test is doing right now*/
+	String getProgress()
+	{
+		const ScopedLock sl(mResultLock);
+		return mProgress;
+	};
+
+	RoundTripResult getResult()
+	{
+		const ScopedLock sl(mResultLock);
+		return mResult;
+	};
+
+	//----- Thread
+	void run()
+	{
+		measure();
+		mFinished.set(1);
+	};
+
+	//----- MidiInputCallback
+	void handleIncomingMidiMessage(MidiInput* /*source*/, const MidiMessage& message)
+	{
+		const int now = LatencyMonitor::getTime();
+		const int sequence = parseProbe(message);
+		if(sequence < 0) return;
+
+		//the slot is cleared so a doubled echo isn't counted twice
+		const int slot = sequence & (ROUNDTRIP_MAX_IN_FLIGHT-1);
+		if(!mSlotSequence[slot].compareAndSetBool(-1,sequence)) return;
+
+		const int us = (int)((uint32)now - (uint32)mSendTimes[slot].get());
+		++mNumReceived;
+		const ScopedLock sl(mSampleLock);
+		mSamples.add(us);
+	};
+
+private:
+	void measure()
+	{
+		if(!MidiTransmitter::getInstance()->hasMidiOutput())
+		{
+			setError("no MIDI output selected");
+			return;
+		}
+
+		//----- idle latency
+		setProgress("latency, " + String(ROUNDTRIP_LATENCY_PROBES) + " probes");
+		resetCounts();
+		double next = Time::getMillisecondCounterHiRes();
+		for(int i=0;i<ROUNDTRIP_LATENCY_PROBES && !threadShouldExit();i++)
+		{
+			mWait.waitUntil(next);
+			sendProbe();
+			next += ROUNDTRIP_LATENCY_INTERVAL_MS;
+		}
+		waitForEchoes();
+		if(threadShouldExit()) return;
+
+		Array<int> samples;
+		getSamples(samples);
+		{
+			const ScopedLock sl(mResultLock);
+			mResult.numSent = mNumSent;
+			mResult.numReceived = samples.size();
+			if(samples.size() > 0)
+			{
+				mResult.minUs = samples.getFirst();
+				mResult.p50Us = getPercentile(samples,0.5);
+				mResult.p95Us = getPercentile(samples,0.95);
+				mResult.p99Us = getPercentile(samples,0.99);
+				mResult.maxUs = samples.getLast();
+				mResult.jitterUs = getStandardDeviation(samples);
+			}
+		}
+		if(samples.size() == 0)
+		{
+			setError("no probe came back on " + mInputName);
+			return;
+		}
+		const int idleP95 = getPercentile(samples,0.95);
+
+		//----- throughput, double the rate until it fails, then bisect
+		int good = 0;
+		int bad = 0;
+		for(int rate=ROUNDTRIP_START_RATE;rate<=ROUNDTRIP_MAX_RATE && !threadShouldExit();rate*=2)
+		{
+			if(runStep(rate,idleP95))
+			{
+				good = rate;
+			}
+			else
+			{
+				bad = rate;
+				break;
+			}
+		}
+		for(int i=0;i<ROUNDTRIP_REFINE_STEPS && bad > 0 && !threadShouldExit();i++)
+		{
+			const int rate = (good+bad)/2;
+			if(rate == good || rate == bad) break;
+			if(runStep(rate,idleP95))	good = rate;
+			else						bad = rate;
+		}
+		if(threadShouldExit()) return;
+
+		const ScopedLock sl(mResultLock);
+		mResult.maxRate = good;
+		mProgress = "done";
+	};
+
+	/** send rate probes per second for ROUNDTRIP_STEP_MS. returns true if the link kept up*/
+	bool runStep(int rate, int idleP95)
+	{
+		setProgress("throughput, " + String(rate) + " probes per second");
+		resetCounts();
+
+		const int numProbes = jmax(1,rate*ROUNDTRIP_STEP_MS/1000);
+		const double interval = 1000./rate;
+		const double start = Time::getMillisecondCounterHiRes();
+		for(int i=0;i<numProbes && !threadShouldExit();i++)
+		{
+			mWait.waitUntil(start + i*interval);
+			sendProbe();
+		}
+		const double elapsed = Time::getMillisecondCounterHiRes() - start;
+		waitForEchoes();
+
+		Array<int> samples;
+		getSamples(samples);
+
+		RoundTripStep step;
+		step.rate = rate;
+		step.numSent = mNumSent;
+		step.numLost = mNumSent - samples.size();
+		step.p95Us = getPercentile(samples,0.95);
+		//the last probe goes out one interval before the step's end
+		const double wanted = (numProbes-1)*interval;
+		step.sustained = !threadShouldExit()
+			&& step.numLost == 0
+			&& step.p95Us <= idleP95 + ROUNDTRIP_QUEUE_MARGIN_US
+			&& elapsed*ROUNDTRIP_MIN_SEND_RATIO <= wanted + interval;
+
+		const ScopedLock sl(mResultLock);
+		mResult.steps.add(step);
+		return step.sustained;
+	};
+
+	/** until every probe is back or ROUNDTRIP_TIMEOUT_MS have passed without one*/
+	void waitForEchoes()
+	{
+		int received = mNumReceived.get();
+		double lastEcho = Time::getMillisecondCounterHiRes();
+		while(received < mNumSent && !threadShouldExit())
+		{
+			wait(5);
+			const int now = mNumReceived.get();
+			if(now != received)
+			{
+				received = now;
+				lastEcho = Time::getMillisecondCounterHiRes();
+			}
+			else if(Time::getMillisecondCounterHiRes() - lastEcho > ROUNDTRIP_TIMEOUT_MS)
+			{
+				break;
+			}
+		}
+	};
+
+	void sendProbe()
+	{
+		const int sequence = mNextSequence;
+		mNextSequence = (mNextSequence+1) & getSequenceMask();
+		const int slot = sequence & (ROUNDTRIP_MAX_IN_FLIGHT-1);
+
+		//the send time is stored before the slot is armed, the echo reads them in the other order
+		mSendTimes[slot].set(LatencyMonitor::getTime());
+		mSlotSequence[slot].set(sequence);
+		mNumSent++;
+		if(mProbeType == PROBE_SHORT)
+		{
+			MidiTransmitter::getInstance()->sendShortMessageNow(MidiEncoder::packShortMessage(ROUNDTRIP_SHORT_STATUS,sequence&0x7f,(sequence>>7)&0x7f));
+		}
+		else MidiTransmitter::getInstance()->sendMessageNow(makeSysExProbe(sequence));
+	};
+
+	MidiMessage makeSysExProbe(int sequence) const
+	{
+		const uint8 data[] = { 0xf0, ROUNDTRIP_SYSEX_ID, 'S', 'P',
+			(uint8)(sequence&0x7f), (uint8)((sequence>>7)&0x7f), (uint8)((sequence>>14)&0x7f), 0xf7 };
+		return MidiMessage(data,sizeof(data));
+	};
+
+	/** the sequence number of a probe, -1 for other messages*/
+	int parseProbe(const MidiMessage& message) const
+	{
+		const uint8* data = message.getRawData();
+		const int size = message.getRawDataSize();
+		if(mProbeType == PROBE_SHORT)
+		{
+			if(size != 3 || data[0] != ROUNDTRIP_SHORT_STATUS) return -1;
+			return data[1] | (data[2]<<7);
+		}
+		if(size != 8 || data[0] != 0xf0 || data[1] != ROUNDTRIP_SYSEX_ID || data[2] != 'S' || data[3] != 'P') return -1;
+		return data[4] | (data[5]<<7) | (data[6]<<14);
+	};
+
+	int getProbeSize() const
+	{
+		return mProbeType == PROBE_SHORT ? 3 : 8;
+	};
+
+	int getSequenceMask() const
+	{
+		return mProbeType == PROBE_SHORT ? 0x3fff : 0x1fffff;
+	};
+
+	void resetCounts()
+	{
+		//probes of the last step that are still out can't be matched anymore
+		for(int i=0;i<ROUNDTRIP_MAX_IN_FLIGHT;i++)
+		{
+			mSlotSequence[i].set(-1);
+		}
+		mNumSent = 0;
+		mNumReceived.set(0);
+		const ScopedLock sl(mSampleLock);
+		mSamples.clearQuick();
+	};
+
+	/** sorted*/
+	void getSamples(Array<int>& samples)
+	{
+		{
+			const ScopedLock sl(mSampleLock);
+			samples = mSamples;
+		}
+		DefaultElementComparator<int> comparator;
+		samples.sort(comparator);
+	};
+
+	static int getPercentile(const Array<int>& sorted, double percentile)
+	{
+		if(sorted.size() == 0) return 0;
+		return sorted[jlimit(0,sorted.size()-1,roundToInt(percentile*sorted.size())-1)];
+	};
+
+	static double getStandardDeviation(const Array<int>& samples)
+	{
+		if(samples.size() < 2) return 0;
+		double sum = 0;
+		for(int i=0;i<samples.size();i++) sum += samples[i];
+		const double mean = sum/samples.size();
+
+		double squares = 0;
+		for(int i=0;i<samples.size();i++) squares += (samples[i]-mean)*(samples[i]-mean);
+		return sqrt(squares/(samples.size()-1));
+	};
+
+	void setProgress(const String& text)
+	{
+		const ScopedLock sl(mResultLock);
+		mProgress = text;
+	};
+
+	void setError(const String& text)
+	{
+		const ScopedLock sl(mResultLock);
+		mResult.error = text;
+		mProgress = text;
+	};
+
+	AudioDeviceManager* mDeviceManager;		// set between start() and stop()
+	String mInputName;
+	bool mWasEnabled;						// the input was open before the test
+	ProbeType mProbeType;
+	Atomic<int> mFinished;
+
+	//test thread only
+	PreciseWait mWait;
+	int mNextSequence;
+	int mNumSent;
+
+	//written by the echoes
+	Atomic<int> mSendTimes[ROUNDTRIP_MAX_IN_FLIGHT];
+	Atomic<int> mSlotSequence[ROUNDTRIP_MAX_IN_FLIGHT];	// the probe a slot waits for, -1 if none
+	Atomic<int> mNumReceived;
+	CriticalSection mSampleLock;
+	Array<int> mSamples;
+
+	CriticalSection mResultLock;
+	RoundTripResult mResult;
+	String mProgress;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,789 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/Parameters.h"
+#include "../controllerAssignments.h"
+#include "MidiEncoder.h"
+#include "PatchSysEx.h"
+#include "PatternSysEx.h"
+#include "LatencyMonitor.h"
+#include "MidiCapture.h"
+#include "../MpscFifo.h"
+#include "PreciseWait.h"
+#include "../Trace.h"
+#include "../ThreadPriorities.h"
+#include "../Telemetry.h"
+
+#define PRIORITY_INTERACTIVE	0	// knob edits, always sent first
+#define PRIORITY_BULK			1	// patch loads, dumps, morphs
+#define NUM_PRIORITIES			2
+
+// link speeds in bytes per second
+#define LINK_SPEED_DIN			3125	// 31250 baud, 10 bits per byte
+#define LINK_SPEED_USB			48000	// USB full speed, 16 packets of 3 bytes per 1ms frame
+#define LINK_SPEED_UNLIMITED	0
+
+// how far we may run ahead of the modelled wire. keeps the driver buffer busy without queueing in it
+#define MAX_WIRE_BACKLOG_MS		3.0
+
+// bulk traffic is handed to the output thread of the device as timestamped blocks
+#define SCHEDULED_BLOCK_MS		8.0		// link time one block covers
+#define SCHEDULED_RATE			10000	// sample positions per second in a block, 0.1ms steps
+#define SCHEDULED_MARGIN_MS		5.0		// the output thread may send this much later than a timestamp
+
+#define MAX_PENDING_DUMPS		128
+#define MAX_PENDING_BURSTS		16
+#define MAX_BURST_PARAMETERS	64		// a macro moves up to this many at once
+#define SKIP_PENDING_VALUE		-1
+#define DUMP_MARKER				-1
+#define BURST_MARKER			-2
+#define UNKNOWN_DEVICE_VALUE	-1	// in the mirror of the device state
+
+// an edit whose widget callback is older than this didn't come from a widget
+#define MAX_UI_EVENT_AGE_US		1000000
+
+//---------------------------------------------------------------------------
+/** Schedules everything sent to the drumsynth from a background thread.
+
+	sendParameter(), sendPatchDump() and sendPatternDump() never block and
+	can be called from any thread, the queues are MpscFifos. Every parameter
+	has one pending slot per priority, so if a knob is moved faster than the
+	link can transmit only the latest value goes out. The parameters of a
+	sendParameterBurst() are sent back to back by one step of the thread.
+
+	The thread models the byte budget of the link (see setLinkSpeed()) and
+	never lets more than MAX_WIRE_BACKLOG_MS of data pile up in the driver.
+	The wait for the wire is a PreciseWait, Thread::wait() would oversleep
+	the backlog. Interactive edits always go before bulk traffic, so a knob
+	stays responsive while a patch or a bank is transferred. Their latency
+	is recorded by the LatencyMonitor.
+
+	Bulk traffic is not sent from this thread. Whenever less than
+	MAX_WIRE_BACKLOG_MS of it is left ahead, the next SCHEDULED_BLOCK_MS
+	of queued bulk parameters and dumps are stamped with the times the
+	link model gives them and passed to MidiOutput::sendBlockOfMessages(),
+	so the output thread of the device puts them on the wire evenly paced.
+	Each scheduled parameter carries its full NRPN address, and while a
+	block is in flight interactive edits are put into the same time
+	ordered list of the output, right at the front, so they overtake the
+	block without splitting the messages of a parameter.
+
+	The queues only carry parameter numbers, the values wait in their
+	slots. The thread encodes them into packed short messages (see
+	MidiEncoder::encodeShort()) that go to MidiOutput::sendShortMessageNow()
+	or straight into the MidiBuffer of a block, so no MidiMessage is built
+	for a parameter on its way to the driver. Only the dumps are MidiMessages.
+
+	The transmitter mirrors the values the device has once the queues are
+	sent, so sendPatch() only sends what differs: as single parameters when
+	they are fewer bytes than a dump, as a patch dump otherwise. The mirror
+	starts unknown and is forgotten when the output changes, the first
+	patch after that is a dump.
+
+	A Listener is told about everything that is put on the wire. While one
+	is set the messages are encoded and reported without an output too,
+	so the EditReplayer can measure the send path without a device.
+	Every message that goes to an output is also put into the MidiCapture
+	ring, the scheduled ones with the time the link model gives them.
+*/
+class MidiTransmitter : public Thread
+{
+public:
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** called on the transmit thread after a parameter or, with DUMP_MARKER as parameterNr, a dump was sent*/
+		virtual void messagesTransmitted(int parameterNr, int value, int numMessages, int numBytes) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	MidiTransmitter() : Thread("MidiTransmitThread"),
+		mMidiOut(NULL),
+		mListener(NULL),
+		mLinkSpeed(LINK_SPEED_DIN),
+		mWireFreeAt(0),
+		mScheduledUntil(0)
+	{
+		for(int p=0;p<NUM_PRIORITIES;p++)
+		{
+			mFifo[p] = new MpscFifo<int>(NUM_PARAMS+MAX_PENDING_DUMPS+MAX_PENDING_BURSTS);
+			for(int i=0;i<NUM_PARAMS;i++)
+			{
+				mPendingFlags[p][i].set(0);
+			}
+		}
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mPendingValues[i].set(0);
+			mEditTimes[i].set(0);
+			mQueueTimes[i].set(0);
+			mDeviceValues[i].set(UNKNOWN_DEVICE_VALUE);
+		}
+		mPendingBytes.set(0);
+		startThread(PRIORITY_CLASS_MIDI);
+	};
+
+	~MidiTransmitter()
+	{
+		signalThreadShouldExit();
+		mDataAvailable.signal();
+		stopThread(1000);
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (MidiTransmitter, false)
+
+	/** set the device all queued messages are sent to (NULL to mute)*/
+	void setMidiOutput(MidiOutput* output)
+	{
+		const ScopedLock sl(mOutputLock);
+		if(mMidiOut != NULL) mMidiOut->clearAllPendingMessages();
+		mMidiOut = output;
+		//a new device doesn't know our last NRPN address or values
+		mEncoder.reset();
+		forgetDeviceState();
+		mWireFreeAt = 0;
+		mScheduledUntil = 0;
+		//needed for sendBlockOfMessages(). does nothing if it is already running
+		if(mMidiOut != NULL) mMidiOut->startBackgroundThread();
+	};
+
+	/** NULL to remove it. the listener is called with the output lock held, it mustn't call back*/
+	void setListener(Listener* listener)
+	{
+		const ScopedLock sl(mOutputLock);
+		mListener = listener;
+	};
+
+	/** bytes per second the link can carry, LINK_SPEED_UNLIMITED sends as fast as the driver accepts*/
+	void setLinkSpeed(int bytesPerSecond)
+	{
+		mLinkSpeed = jmax(0,bytesPerSecond);
+	};
+
+	int getLinkSpeed()
+	{
+		return mLinkSpeed;
+	};
+
+	/** queue a parameter value (already in the 0-127 MIDI range) for transmission*/
+	void sendParameter(int parameterNr, int value, int priority = PRIORITY_INTERACTIVE)
+	{
+		TRACE_SCOPE("midi","sendParameter");
+		if(parameterNr < 0 || parameterNr >= NUM_PARAMS) return;
+		jassert(priority >= 0 && priority < NUM_PRIORITIES);
+
+		mPendingValues[parameterNr].set(value);
+		mDeviceValues[parameterNr].set(value);
+
+		const int now = LatencyMonitor::getTime();
+		if(priority == PRIORITY_INTERACTIVE)
+		{
+			mEditTimes[parameterNr].set(getUiTime(now));
+		}
+
+		//only the first update marks the slot as pending, all following ones just overwrite the value
+		if(mPendingFlags[priority][parameterNr].compareAndSetBool(1,0))
+		{
+			mQueueTimes[parameterNr].set(now);
+			mPendingBytes += estimateBytes(parameterNr);
+			push(priority,parameterNr);
+		}
+		else Telemetry::add(TELEMETRY_MIDI_COALESCED,1);
+	};
+
+	/** queue the parameters of one gesture with interactive priority, e.g. a control edited
+		on several voices at once. The thread sends them in one step, so they reach the synth
+		back to back instead of interleaved with other edits. A parameter that is already
+		queued only gets the new value. Without a free burst they are queued one by one*/
+	void sendParameterBurst(const int* parameterNrs, const int* values, int num)
+	{
+		TRACE_SCOPE("midi","sendParameterBurst");
+		const int now = LatencyMonitor::getTime();
+		const int uiTime = getUiTime(now);
+
+		ParameterBurst burst;
+		burst.numParameters = 0;
+		for(int i=0;i<num;i++)
+		{
+			const int parameterNr = parameterNrs[i];
+			if(parameterNr < 0 || parameterNr >= NUM_PARAMS) continue;
+			if(burst.numParameters == MAX_BURST_PARAMETERS)
+			{
+				sendParameter(parameterNr,values[i],PRIORITY_INTERACTIVE);
+				continue;
+			}
+
+			mPendingValues[parameterNr].set(values[i]);
+			mDeviceValues[parameterNr].set(values[i]);
+			mEditTimes[parameterNr].set(uiTime);
+			if(mPendingFlags[PRIORITY_INTERACTIVE][parameterNr].compareAndSetBool(1,0))
+			{
+				mQueueTimes[parameterNr].set(now);
+				mPendingBytes += estimateBytes(parameterNr);
+				burst.parameterNrs[burst.numParameters++] = (short)parameterNr;
+			}
+			else Telemetry::add(TELEMETRY_MIDI_COALESCED,1);
+		}
+		if(burst.numParameters == 0) return;
+
+		bool queued = false;
+		{
+			const ScopedLock sl(mBurstLock);
+			if(mBursts.size() < MAX_PENDING_BURSTS)
+			{
+				mBursts.add(burst);
+				queued = true;
+			}
+		}
+		if(queued)
+		{
+			push(PRIORITY_INTERACTIVE,BURST_MARKER);
+			return;
+		}
+		for(int i=0;i<burst.numParameters;i++)
+		{
+			push(PRIORITY_INTERACTIVE,burst.parameterNrs[i]);
+		}
+	};
+
+	/** queue a complete patch as one SysEx frame with bulk priority.
+		Queued parameter changes are dropped since the dump contains newer values.
+		dump is the frame of the patch if it was built ahead, e.g. by the AuditionPlaylist.
+		returns false if too many dumps are queued*/
+	bool sendPatchDump(Patch* patch, const MidiMessage* dump = NULL)
+	{
+		TRACE_SCOPE("midi","sendPatchDump");
+		if(!addDump(dump != NULL ? *dump : PatchSysEx::createPatchDump(patch))) return false;
+
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(mPendingFlags[PRIORITY_INTERACTIVE][i].get() != 0 || mPendingFlags[PRIORITY_BULK][i].get() != 0)
+			{
+				mPendingValues[i].set(SKIP_PENDING_VALUE);
+			}
+			mDeviceValues[i].set(patch->getParameter(i));
+		}
+
+		push(PRIORITY_BULK,DUMP_MARKER);
+		return true;
+	};
+
+	/** queue the values of a patch that differ from the device's state, with bulk priority.
+		A prepared dump is used if the diff is sent as a dump.
+		returns the number of differing parameters*/
+	int sendPatch(Patch* patch, const MidiMessage* dump = NULL)
+	{
+		TRACE_SCOPE("midi","sendPatch");
+		short differing[NUM_PARAMS];
+		int numDiffering = 0;
+		int numBytes = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(mDeviceValues[i].get() == patch->getParameter(i)) continue;
+			differing[numDiffering++] = (short)i;
+			numBytes += estimateBytes(i);
+		}
+
+		//a full dump queue falls back to the single parameters
+		if(numBytes >= SYSEX_PATCH_DUMP_MESSAGE_SIZE && sendPatchDump(patch,dump)) return numDiffering;
+
+		for(int i=0;i<numDiffering;i++)
+		{
+			sendParameter(differing[i],patch->getParameter(differing[i]),PRIORITY_BULK);
+		}
+		return numDiffering;
+	};
+
+	/** queue a request for a patch dump with bulk priority, it goes out after everything queued before it.
+		returns false if too many dumps are queued*/
+	bool sendDumpRequest()
+	{
+		if(!addDump(PatchSysEx::createDumpRequest())) return false;
+
+		push(PRIORITY_BULK,DUMP_MARKER);
+		return true;
+	};
+
+	/** a value the device reported, e.g. from a knob on the synth. Any thread*/
+	void setDeviceValue(int parameterNr, int value)
+	{
+		if(parameterNr < 0 || parameterNr >= NUM_PARAMS) return;
+		mDeviceValues[parameterNr].set(value);
+	};
+
+	/** the next patch is sent as a whole, e.g. when the synth loaded a kit on its own*/
+	void forgetDeviceState()
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mDeviceValues[i].set(UNKNOWN_DEVICE_VALUE);
+		}
+	};
+
+	/** queue a whole pattern as one SysEx frame with bulk priority.
+		returns false if too many dumps are queued*/
+	bool sendPatternDump(const Pattern& pattern, int patternNr)
+	{
+		if(!addDump(PatternSysEx::createPatternDump(pattern,patternNr))) return false;
+
+		push(PRIORITY_BULK,DUMP_MARKER);
+		return true;
+	};
+
+	bool hasMidiOutput()
+	{
+		const ScopedLock sl(mOutputLock);
+		return mMidiOut != NULL;
+	};
+
+	/** send a message right away, past the queues and the link model. for diagnostics like the round trip test.
+		returns false if there is no output*/
+	bool sendMessageNow(const MidiMessage& message)
+	{
+		const ScopedLock sl(mOutputLock);
+		if(mMidiOut == NULL) return false;
+		mMidiOut->sendMessageNow(message);
+		MidiCapture::getInstance()->capture(true,message,LatencyMonitor::getTime());
+		return true;
+	};
+
+	/** the same for a short message packed by MidiEncoder::packShortMessage()*/
+	bool sendShortMessageNow(uint32 packedMessage)
+	{
+		const ScopedLock sl(mOutputLock);
+		if(mMidiOut == NULL) return false;
+		mMidiOut->sendShortMessageNow(packedMessage);
+		MidiCapture::getInstance()->captureShort(true,packedMessage,MidiEncoder::getShortMessageSize(packedMessage),LatencyMonitor::getTime());
+		return true;
+	};
+
+	/** returns the number of queued parameters and dumps*/
+	int getNumPending()
+	{
+		return getQueueDepth(PRIORITY_INTERACTIVE) + getQueueDepth(PRIORITY_BULK);
+	};
+
+	int getQueueDepth(int priority)
+	{
+		return mFifo[priority]->getNumReady();
+	};
+
+	/** estimated time in ms until everything queued is on the wire*/
+	double getEstimatedDrainTime()
+	{
+		if(mLinkSpeed == LINK_SPEED_UNLIMITED) return 0;
+
+		double onWire;
+		{
+			const ScopedLock sl(mOutputLock);
+			onWire = jmax(0.,jmax(mWireFreeAt,mScheduledUntil) - Time::getMillisecondCounterHiRes());
+		}
+		return onWire + mPendingBytes.get()*1000./mLinkSpeed;
+	};
+
+	void run()
+	{
+		while(!threadShouldExit())
+		{
+			if(getNumPending() == 0)
+			{
+				mDataAvailable.wait(100);
+				continue;
+			}
+
+			//wait until the wire has room. the queues are checked again afterwards,
+			//so an edit arriving meanwhile still overtakes the bulk data
+			const bool interactive = getQueueDepth(PRIORITY_INTERACTIVE) > 0;
+			bool scheduled;
+			double waitMs;
+			{
+				const ScopedLock sl(mOutputLock);
+				scheduled = !interactive && isScheduling();
+				const double now = Time::getMillisecondCounterHiRes();
+				waitMs = scheduled ? jmax(mWireFreeAt,mScheduledUntil) - MAX_WIRE_BACKLOG_MS - now
+								   : mWireFreeAt - MAX_WIRE_BACKLOG_MS - now;
+			}
+			if(waitMs > 0)
+			{
+				//a new edit wakes a long wait up, a short one is precise
+				if(waitMs > 2*MAX_WIRE_BACKLOG_MS) mDataAvailable.wait((int)(waitMs - MAX_WIRE_BACKLOG_MS));
+				else mWait.waitFor(waitMs);
+				continue;
+			}
+
+			if(interactive)
+			{
+				transmitNext(PRIORITY_INTERACTIVE);
+			}
+			else if(scheduled)
+			{
+				scheduleBulk();
+			}
+			else
+			{
+				transmitNext(PRIORITY_BULK);
+			}
+		}
+	};
+
+private:
+	//-----------------------------------------------------------------------
+	/** the parameters of a sendParameterBurst() that weren't queued yet*/
+	struct ParameterBurst
+	{
+		short parameterNrs[MAX_BURST_PARAMETERS];
+		int numParameters;
+	};
+	//-----------------------------------------------------------------------
+
+	/** the widget callback of an interactive edit happening now*/
+	static int getUiTime(int now)
+	{
+		LatencyMonitor* monitor = LatencyMonitor::getInstance();
+		int uiTime = monitor->getLastUiEvent();
+		if((uint32)now - (uint32)uiTime > MAX_UI_EVENT_AGE_US) uiTime = now;
+
+		monitor->addSample(LatencyMonitor::STAGE_UI,uiTime,now);
+		return uiTime;
+	};
+
+	void push(int priority, int item)
+	{
+		//there are never more pending slots than parameters + dumps, so the fifo can't overflow
+		if(!mFifo[priority]->push(item))
+		{
+			jassertfalse;
+		}
+
+		mDataAvailable.signal();
+	};
+
+	/** the dump is sent when its DUMP_MARKER is taken from the bulk queue*/
+	bool addDump(const MidiMessage& dump)
+	{
+		{
+			const ScopedLock sl(mDumpLock);
+			if(mDumps.size() >= MAX_PENDING_DUMPS) return false;
+			mDumps.add(dump);
+		}
+		mPendingBytes += dump.getRawDataSize();
+		return true;
+	};
+
+	/** send the oldest item of a queue. returns false if it was empty*/
+	bool transmitNext(int priority)
+	{
+		TRACE_SCOPE("midi","transmitNext");
+		//one at a time, an edit arriving meanwhile has to overtake the rest of the bulk queue
+		int item;
+		if(mFifo[priority]->read(&item,1) == 0) return false;
+
+		if(item == DUMP_MARKER)
+		{
+			transmitDump();
+			return true;
+		}
+		if(item == BURST_MARKER)
+		{
+			transmitBurst();
+			return true;
+		}
+
+		const int parameterNr = item;
+		mPendingBytes -= estimateBytes(parameterNr);
+
+		//clear the flag before reading the value, so an update arriving in between queues the slot again
+		mPendingFlags[priority][parameterNr].set(0);
+
+		//an interactive edit of the same parameter goes out on its own, faster
+		if(priority == PRIORITY_BULK && mPendingFlags[PRIORITY_INTERACTIVE][parameterNr].get() != 0) return true;
+
+		const int value = mPendingValues[parameterNr].get();
+		if(value == SKIP_PENDING_VALUE)
+		{
+			Telemetry::add(TELEMETRY_MIDI_DROPPED,1);
+			return true;
+		}
+
+		const ScopedLock sl(mOutputLock);
+		if(mMidiOut == NULL && mListener == NULL) return true;
+
+		if(priority == PRIORITY_INTERACTIVE)
+		{
+			LatencyMonitor* monitor = LatencyMonitor::getInstance();
+			const int sendTime = LatencyMonitor::getTime();
+			transmitParameter(mMidiOut,parameterNr,value);
+			const int sentTime = LatencyMonitor::getTime();
+
+			monitor->addSample(LatencyMonitor::STAGE_QUEUE,mQueueTimes[parameterNr].get(),sendTime);
+			monitor->addSample(LatencyMonitor::STAGE_DRIVER,sendTime,sentTime);
+			monitor->addSample(LatencyMonitor::STAGE_TOTAL,mEditTimes[parameterNr].get(),sentTime);
+		}
+		else
+		{
+			transmitParameter(mMidiOut,parameterNr,value);
+		}
+		return true;
+	};
+
+	/** CC for parameters up to 0x7f, NRPN for all others. out may be NULL if there is a listener.
+		While scheduled messages are in flight they go to the front of the output thread's list*/
+	void transmitParameter(MidiOutput* out, int parameterNr, int value)
+	{
+		const double now = Time::getMillisecondCounterHiRes();
+		const bool behindBlock = out != NULL && now < mScheduledUntil + SCHEDULED_MARGIN_MS;
+		if(mScheduledUntil > 0)
+		{
+			//the scheduled parameters moved the NRPN address of the device
+			mEncoder.reset();
+			if(!behindBlock) mScheduledUntil = 0;
+		}
+
+		uint32 messages[MAX_MESSAGES_PER_PARAMETER];
+		const int num = mEncoder.encodeShort(parameterNr,value,messages);
+		int numBytes = 0;
+		MidiBuffer buffer;
+		MidiCapture* capture = MidiCapture::getInstance();
+		const int captureTime = MidiCapture::getTime(now);
+		for(int i=0;i<num;i++)
+		{
+			const int size = MidiEncoder::getShortMessageSize(messages[i]);
+			if(behindBlock) MidiEncoder::addShortMessage(buffer,messages[i],0);
+			else if(out != NULL) out->sendShortMessageNow(messages[i]);
+			if(out != NULL) capture->captureShort(true,messages[i],size,captureTime);
+			numBytes += size;
+		}
+		if(behindBlock) out->sendBlockOfMessages(buffer,jmax(1.,now),SCHEDULED_RATE);
+		occupyWire(numBytes);
+		Telemetry::add(TELEMETRY_MIDI_BYTES,numBytes);
+		if(mListener != NULL) mListener->messagesTransmitted(parameterNr,value,num,numBytes);
+	};
+
+	/** bulk traffic goes through sendBlockOfMessages() while there is a device and the link is paced. mOutputLock has to be held*/
+	bool isScheduling() const
+	{
+		return mMidiOut != NULL && mLinkSpeed != LINK_SPEED_UNLIMITED;
+	};
+
+	/** takes the bulk queue up to SCHEDULED_BLOCK_MS of link time and hands it to the output thread
+		as one block. Every parameter is stamped where the link model puts it and sent with its full
+		NRPN address, all its messages at the same time, so nothing can get between them*/
+	void scheduleBulk()
+	{
+		TRACE_SCOPE("midi","scheduleBulk");
+		const ScopedLock sl(mOutputLock);
+		if(!isScheduling()) return;
+
+		const double now = Time::getMillisecondCounterHiRes();
+		const double start = jmax(now + 1.,jmax(mWireFreeAt,mScheduledUntil));
+		const double msPerByte = 1000./mLinkSpeed;
+		double time = start;
+		//captured at the time the link model puts them on the wire
+		MidiCapture* capture = MidiCapture::getInstance();
+
+		MidiBuffer buffer;
+		while(time < start + SCHEDULED_BLOCK_MS)
+		{
+			int item;
+			if(mFifo[PRIORITY_BULK]->read(&item,1) == 0) break;
+			const int position = roundToInt((time - start)*SCHEDULED_RATE/1000.);
+
+			if(item == DUMP_MARKER)
+			{
+				MidiMessage dump;
+				{
+					const ScopedLock dl(mDumpLock);
+					jassert(mDumps.size() > 0);
+					dump = mDumps.getReference(0);
+					mDumps.remove(0);
+				}
+				mPendingBytes -= dump.getRawDataSize();
+				buffer.addEvent(dump,position);
+				capture->capture(true,dump,MidiCapture::getTime(time));
+				time += dump.getRawDataSize()*msPerByte;
+				Telemetry::add(TELEMETRY_MIDI_BYTES,dump.getRawDataSize());
+				if(mListener != NULL) mListener->messagesTransmitted(DUMP_MARKER,0,1,dump.getRawDataSize());
+				continue;
+			}
+			if(item == BURST_MARKER)
+			{
+				//bursts are interactive, this can't happen
+				jassertfalse;
+				continue;
+			}
+
+			const int parameterNr = item;
+			mPendingBytes -= estimateBytes(parameterNr);
+			mPendingFlags[PRIORITY_BULK][parameterNr].set(0);
+			if(mPendingFlags[PRIORITY_INTERACTIVE][parameterNr].get() != 0) continue;
+			const int value = mPendingValues[parameterNr].get();
+			if(value == SKIP_PENDING_VALUE)
+			{
+				Telemetry::add(TELEMETRY_MIDI_DROPPED,1);
+				continue;
+			}
+
+			mEncoder.reset();
+			uint32 messages[MAX_MESSAGES_PER_PARAMETER];
+			const int num = mEncoder.encodeShort(parameterNr,value,messages);
+			int numBytes = 0;
+			for(int i=0;i<num;i++)
+			{
+				const int size = MidiEncoder::getShortMessageSize(messages[i]);
+				MidiEncoder::addShortMessage(buffer,messages[i],position);
+				capture->captureShort(true,messages[i],size,MidiCapture::getTime(time));
+				numBytes += size;
+			}
+			time += numBytes*msPerByte;
+			Telemetry::add(TELEMETRY_MIDI_BYTES,numBytes);
+			if(mListener != NULL) mListener->messagesTransmitted(parameterNr,value,num,numBytes);
+		}
+		//whatever comes next can't rely on the address the block leaves behind
+		mEncoder.reset();
+		if(buffer.isEmpty()) return;
+
+		mMidiOut->sendBlockOfMessages(buffer,start,SCHEDULED_RATE);
+		mScheduledUntil = time;
+	};
+
+	/** all parameters of the burst in one go, the wire model is only checked before it*/
+	void transmitBurst()
+	{
+		TRACE_SCOPE("midi","transmitBurst");
+		ParameterBurst burst;
+		{
+			const ScopedLock sl(mBurstLock);
+			jassert(mBursts.size() > 0);
+			burst = mBursts.getReference(0);
+			mBursts.remove(0);
+		}
+
+		const ScopedLock sl(mOutputLock);
+		LatencyMonitor* monitor = LatencyMonitor::getInstance();
+		const int sendTime = LatencyMonitor::getTime();
+		short sent[MAX_BURST_PARAMETERS];
+		int numSent = 0;
+		for(int i=0;i<burst.numParameters;i++)
+		{
+			const int parameterNr = burst.parameterNrs[i];
+			mPendingBytes -= estimateBytes(parameterNr);
+			mPendingFlags[PRIORITY_INTERACTIVE][parameterNr].set(0);
+
+			const int value = mPendingValues[parameterNr].get();
+			if(value == SKIP_PENDING_VALUE)
+			{
+				Telemetry::add(TELEMETRY_MIDI_DROPPED,1);
+				continue;
+			}
+			if(mMidiOut == NULL && mListener == NULL) continue;
+
+			transmitParameter(mMidiOut,parameterNr,value);
+			monitor->addSample(LatencyMonitor::STAGE_QUEUE,mQueueTimes[parameterNr].get(),sendTime);
+			sent[numSent++] = (short)parameterNr;
+		}
+		if(numSent == 0) return;
+
+		const int sentTime = LatencyMonitor::getTime();
+		monitor->addSample(LatencyMonitor::STAGE_DRIVER,sendTime,sentTime);
+		for(int i=0;i<numSent;i++)
+		{
+			monitor->addSample(LatencyMonitor::STAGE_TOTAL,mEditTimes[sent[i]].get(),sentTime);
+		}
+	};
+
+	void transmitDump()
+	{
+		TRACE_SCOPE("midi","transmitDump");
+		MidiMessage dump;
+		{
+			const ScopedLock sl(mDumpLock);
+			jassert(mDumps.size() > 0);
+			dump = mDumps.getReference(0);
+			mDumps.remove(0);
+		}
+		mPendingBytes -= dump.getRawDataSize();
+
+		const ScopedLock sl(mOutputLock);
+		if(mMidiOut != NULL)
+		{
+			//one call, the output thread puts the frame on the wire
+			MidiBuffer buffer;
+			buffer.addEvent(dump,0);
+			mMidiOut->sendBlockOfMessages(buffer,Time::getMillisecondCounter()+1,1000);
+			MidiCapture::getInstance()->capture(true,dump,LatencyMonitor::getTime());
+		}
+		else if(mListener == NULL) return;
+
+		occupyWire(dump.getRawDataSize());
+		Telemetry::add(TELEMETRY_MIDI_BYTES,dump.getRawDataSize());
+		if(mListener != NULL) mListener->messagesTransmitted(DUMP_MARKER,0,1,dump.getRawDataSize());
+	};
+
+	/** account for numBytes on the modelled wire. mOutputLock has to be held*/
+	void occupyWire(int numBytes)
+	{
+		if(mLinkSpeed == LINK_SPEED_UNLIMITED) return;
+		const double now = Time::getMillisecondCounterHiRes();
+		mWireFreeAt = jmax(now,mWireFreeAt) + numBytes*1000./mLinkSpeed;
+	};
+
+	/** worst case bytes for one parameter, the NRPN address is often cached*/
+	static int estimateBytes(int parameterNr)
+	{
+		return parameterNr <= 0x7f ? 3 : MAX_BYTES_PER_PARAMETER;
+	};
+
+private:
+	ScopedPointer<MpscFifo<int> > mFifo[NUM_PRIORITIES];
+	Atomic<int> mPendingFlags[NUM_PRIORITIES][NUM_PARAMS];
+	Atomic<int> mPendingValues[NUM_PARAMS];
+	Atomic<int> mEditTimes[NUM_PARAMS];		// widget callback of the pending value
+	Atomic<int> mQueueTimes[NUM_PARAMS];	// when the interactive slot was queued
+	Atomic<int> mDeviceValues[NUM_PARAMS];	// what the device has after the queues, or UNKNOWN_DEVICE_VALUE
+	Atomic<int> mPendingBytes;
+
+	CriticalSection mDumpLock;
+	Array<MidiMessage> mDumps;
+	CriticalSection mBurstLock;
+	Array<ParameterBurst> mBursts;
+
+	WaitableEvent mDataAvailable;
+	PreciseWait mWait;		// transmit thread only
+
+	CriticalSection mOutputLock;
+	MidiOutput* mMidiOut;
+	Listener* mListener;
+	MidiEncoder mEncoder;
+
+	int mLinkSpeed;
+	double mWireFreeAt;
+	double mScheduledUntil;	// when the last block handed to sendBlockOfMessages() is on the wire, 0 if none
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,170 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../PresetLoader.h"
+
+#define SYSEX_MANUFACTURER_ID	0x7d	// non commercial/educational id
+#define SYSEX_PATCH_DUMP		0x01
+#define SYSEX_DUMP_REQUEST		0x03	// no data, the synth answers with a patch dump of its sound
+
+// manufacturer id + command + 7 bit packed patch data + checksum
+#define SYSEX_PACKED_SIZE		(((PATCH_DATA_SIZE+6)/7)*8)
+#define SYSEX_PATCH_DUMP_SIZE	(2+SYSEX_PACKED_SIZE+1)
+// the same with F0 and F7, as stored in a .syx bank
+#define SYSEX_PATCH_DUMP_MESSAGE_SIZE	(SYSEX_PATCH_DUMP_SIZE+2)
+
+//---------------------------------------------------------------------------
+/** Packs a complete patch into a single SysEx frame and back.
+
+	Frame layout (without the F0/F7 juce adds):
+	[0x7d] [SYSEX_PATCH_DUMP] [packed .SND data] [checksum]
+
+	The patch data is the PresetLoader file layout (8 byte name + NUM_PARAMS
+	values). Values can use all 8 bits, so every 7 data bytes are preceded by
+	one byte holding their MSBs. The checksum is the 7 bit sum of the packed
+	bytes.
+*/
+class PatchSysEx
+{
+public:
+	/** build the dump message for a patch*/
+	static MidiMessage createPatchDump(Patch* patch)
+	{
+		uint8_t data[PATCH_DATA_SIZE];
+		PresetLoader::writePatchData(patch,data);
+
+		uint8_t message[SYSEX_PATCH_DUMP_MESSAGE_SIZE];
+		writePatchDump(data,message);
+		return MidiMessage::createSysExMessage(message+1,SYSEX_PATCH_DUMP_SIZE);
+	};
+
+	/** asks the synth for a dump of the sound it is playing*/
+	static MidiMessage createDumpRequest()
+	{
+		const uint8_t frame[] = { SYSEX_MANUFACTURER_ID, SYSEX_DUMP_REQUEST };
+		return MidiMessage::createSysExMessage(frame,sizeof(frame));
+	};
+
+	/** write the complete dump message including F0 and F7 for PATCH_DATA_SIZE bytes in .SND layout.
+		message has to hold SYSEX_PATCH_DUMP_MESSAGE_SIZE bytes*/
+	static void writePatchDump(const uint8_t* data, uint8_t* message)
+	{
+		uint8_t* frame = message+1;
+		message[0] = 0xf0;
+		frame[0] = SYSEX_MANUFACTURER_ID;
+		frame[1] = SYSEX_PATCH_DUMP;
+		const int packedSize = pack(data,PATCH_DATA_SIZE,frame+2);
+		jassert(packedSize == SYSEX_PACKED_SIZE);
+		frame[2+packedSize] = checksum(frame+2,packedSize);
+		message[SYSEX_PATCH_DUMP_MESSAGE_SIZE-1] = 0xf7;
+	};
+
+	/** true if the message is a patch dump of the right size and with a valid checksum*/
+	static bool isPatchDump(const MidiMessage& msg)
+	{
+		if(!msg.isSysEx() || msg.getSysExDataSize() != SYSEX_PATCH_DUMP_SIZE) return false;
+
+		const uint8* frame = msg.getSysExData();
+		if(frame[0] != SYSEX_MANUFACTURER_ID || frame[1] != SYSEX_PATCH_DUMP) return false;
+
+		return checksum(frame+2,SYSEX_PACKED_SIZE) == frame[2+SYSEX_PACKED_SIZE];
+	};
+
+	/** decode a dump into PATCH_DATA_SIZE bytes in .SND layout without allocating anything.
+		returns false if msg is no valid patch dump*/
+	static bool parsePatchDump(const MidiMessage& msg, uint8_t* data)
+	{
+		if(!isPatchDump(msg)) return false;
+
+		unpack(msg.getSysExData()+2,SYSEX_PACKED_SIZE,data,PATCH_DATA_SIZE);
+		return true;
+	};
+
+	/** decode a dump into a new patch. returns NULL if msg is no valid patch dump*/
+	static Patch* parsePatchDump(const MidiMessage& msg)
+	{
+		uint8_t data[PATCH_DATA_SIZE];
+		if(!parsePatchDump(msg,data)) return NULL;
+
+		Patch* patch = new Patch();
+		PresetLoader::readPatchData(data,patch);
+		return patch;
+	};
+
+	//-----------------------------------------------------------------------
+	// the packing is shared with the other dumps, see PatternSysEx
+
+	/** the number of packed bytes for size data bytes*/
+	static int getPackedSize(int size)
+	{
+		return ((size+6)/7)*8;
+	};
+
+	/** 7 in 8 packing: a header byte with the MSBs followed by up to 7 data bytes*/
+	static int pack(const uint8_t* src, int size, uint8_t* dest)
+	{
+		int numBytes = 0;
+		for(int i=0;i<size;i+=7)
+		{
+			uint8_t& msbs = dest[numBytes++];
+			msbs = 0;
+			for(int j=0;j<7;j++)
+			{
+				const uint8_t value = (i+j < size) ? src[i+j] : 0;
+				msbs |= (value>>7)<<j;
+				dest[numBytes++] = value&0x7f;
+			}
+		}
+		return numBytes;
+	};
+
+	/** decodes at most destSize bytes, the padding of the last group is dropped*/
+	static void unpack(const uint8_t* src, int packedSize, uint8_t* dest, int destSize)
+	{
+		int numBytes = 0;
+		for(int i=0;i<packedSize;i+=8)
+		{
+			const uint8_t msbs = src[i];
+			for(int j=0;j<7 && numBytes<destSize;j++)
+			{
+				dest[numBytes++] = src[i+1+j] | (((msbs>>j)&1)<<7);
+			}
+		}
+	};
+
+	static uint8_t checksum(const uint8_t* data, int size)
+	{
+		int sum = 0;
+		for(int i=0;i<size;i++)
+		{
+			sum += data[i];
+		}
+		return (uint8_t)(sum&0x7f);
+	};
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,115 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Pattern.h"
+#include "PatchSysEx.h"
+
+#define SYSEX_PATTERN_DUMP		0x02
+#define SYSEX_MAX_PATTERN_NR	127
+
+// manufacturer id + command + pattern number + 7 bit packed pattern + checksum
+#define SYSEX_PATTERN_DUMP_MAX_SIZE	(3+((PATTERN_MAX_DATA_SIZE+6)/7)*8+1)
+
+//---------------------------------------------------------------------------
+/** Packs a whole pattern into a single SysEx frame and back, so copying a
+	pattern to or from the synth is one message of a few hundred bytes
+	instead of a CC or NRPN stream for every step.
+
+	Frame layout (without the F0/F7 juce adds):
+	[0x7d] [SYSEX_PATTERN_DUMP] [pattern number] [packed Pattern::write() data] [checksum]
+
+	The packing and the checksum are the same as for a patch dump. The size
+	depends on the number of parameter locks, an empty pattern takes
+	3 + PatchSysEx::getPackedSize(PATTERN_HEADER_SIZE) + 1 bytes.
+*/
+class PatternSysEx
+{
+public:
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** called on the MIDI thread for every valid pattern dump*/
+		virtual void patternDumpReceived(int patternNr, const Pattern& pattern) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	static MidiMessage createPatternDump(const Pattern& pattern, int patternNr)
+	{
+		jassert(patternNr >= 0 && patternNr <= SYSEX_MAX_PATTERN_NR);
+
+		uint8_t data[PATTERN_MAX_DATA_SIZE];
+		const int size = pattern.write(data);
+
+		uint8_t frame[SYSEX_PATTERN_DUMP_MAX_SIZE];
+		frame[0] = SYSEX_MANUFACTURER_ID;
+		frame[1] = SYSEX_PATTERN_DUMP;
+		frame[2] = (uint8_t)patternNr;
+		const int packedSize = PatchSysEx::pack(data,size,frame+3);
+		frame[3+packedSize] = PatchSysEx::checksum(frame+3,packedSize);
+		return MidiMessage::createSysExMessage(frame,3+packedSize+1);
+	};
+
+	/** true if the message is a pattern dump with a valid checksum, the pattern itself is checked by parsePatternDump()*/
+	static bool isPatternDump(const MidiMessage& msg)
+	{
+		if(!msg.isSysEx()) return false;
+
+		const int size = msg.getSysExDataSize();
+		if(size < 3+PatchSysEx::getPackedSize(PATTERN_HEADER_SIZE)+1 || size > SYSEX_PATTERN_DUMP_MAX_SIZE) return false;
+
+		const uint8* frame = msg.getSysExData();
+		if(frame[0] != SYSEX_MANUFACTURER_ID || frame[1] != SYSEX_PATTERN_DUMP || frame[2] > SYSEX_MAX_PATTERN_NR) return false;
+
+		const int packedSize = size-4;
+		return packedSize%8 == 0 && PatchSysEx::checksum(frame+3,packedSize) == frame[size-1];
+	};
+
+	/** decodes a dump. returns false and leaves pattern unchanged if msg is no valid pattern dump*/
+	static bool parsePatternDump(const MidiMessage& msg, int& patternNr, Pattern& pattern)
+	{
+		if(!isPatternDump(msg)) return false;
+
+		const uint8* frame = msg.getSysExData();
+		const int packedSize = msg.getSysExDataSize()-4;
+
+		//the packing pads to groups of 7, the lock count tells the real size
+		uint8_t data[PATTERN_MAX_DATA_SIZE];
+		const int maxSize = jmin(PATTERN_MAX_DATA_SIZE,packedSize/8*7);
+		PatchSysEx::unpack(frame+3,packedSize,data,maxSize);
+
+		const int numLocks = data[PATTERN_HEADER_SIZE-2] | (data[PATTERN_HEADER_SIZE-1]<<8);
+		const int size = PATTERN_HEADER_SIZE + numLocks*PATTERN_LOCK_SIZE;
+		if(size > maxSize || PatchSysEx::getPackedSize(size) != packedSize) return false;
+		if(!pattern.read(data,size)) return false;
+
+		patternNr = frame[2];
+		return true;
+	};
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,115 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+
+#include "PreciseWait.h"
+
+#if JUCE_WINDOWS
+ #define WIN32_LEAN_AND_MEAN 1
+ #include <windows.h>
+ #include <mmsystem.h>
+ #pragma comment (lib, "winmm.lib")
+#elif JUCE_MAC || JUCE_IOS
+ #include <mach/mach_time.h>
+#else
+ #include <time.h>
+ #include <errno.h>
+#endif
+
+#if JUCE_WINDOWS
+//==============================================================================
+// a waitable timer only wakes up on the timer period, 1ms is the shortest one
+PreciseWait::PreciseWait()
+{
+	timeBeginPeriod(1);
+	mTimer = CreateWaitableTimer(NULL, TRUE, NULL);
+}
+
+PreciseWait::~PreciseWait()
+{
+	if(mTimer != NULL) CloseHandle((HANDLE)mTimer);
+	timeEndPeriod(1);
+}
+
+void PreciseWait::sleep(double ms)
+{
+	if(mTimer == NULL)
+	{
+		Sleep((DWORD)ms);
+		return;
+	}
+
+	//negative times are relative, in 100ns units
+	LARGE_INTEGER due;
+	due.QuadPart = -(LONGLONG)(ms*10000.0);
+	if(SetWaitableTimer((HANDLE)mTimer, &due, 0, NULL, NULL, FALSE))
+	{
+		WaitForSingleObject((HANDLE)mTimer, INFINITE);
+	}
+}
+
+#elif JUCE_MAC || JUCE_IOS
+//==============================================================================
+PreciseWait::PreciseWait() : mTimer(NULL)
+{
+}
+
+PreciseWait::~PreciseWait()
+{
+}
+
+void PreciseWait::sleep(double ms)
+{
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	const uint64 ticks = (uint64)(ms*1000000.0*timebase.denom/timebase.numer);
+	mach_wait_until(mach_absolute_time() + ticks);
+}
+
+#else
+//==============================================================================
+// the clock of Time::getMillisecondCounterHiRes() on Linux
+PreciseWait::PreciseWait() : mTimer(NULL)
+{
+}
+
+PreciseWait::~PreciseWait()
+{
+}
+
+void PreciseWait::sleep(double ms)
+{
+	timespec due;
+	clock_gettime(CLOCK_MONOTONIC, &due);
+	const int64 ns = due.tv_nsec + (int64)(ms*1000000.0);
+	due.tv_sec += (time_t)(ns/1000000000);
+	due.tv_nsec = (long)(ns%1000000000);
+
+	//an absolute time, so a signal doesn't make the wait longer
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+	{
+	}
+}
+
+#endif
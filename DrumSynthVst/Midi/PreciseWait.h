@@ -0,0 +1,72 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#define PRECISE_WAIT_SPIN_MS	0.1		// the end of a wait is spun, the OS wakes a thread up a little late
+
+//---------------------------------------------------------------------------
+/** Waits until a time of Time::getMillisecondCounterHiRes() to well below a
+	millisecond. Thread::wait() and juce::Timer round to the scheduler tick,
+	which is 15.6ms on Windows unless the timer period is raised, so they
+	can't pace MIDI.
+
+	The platform waits are in PreciseWait.cpp: a waitable timer with a 1ms
+	timer period on Windows, clock_nanosleep() on Linux and
+	mach_wait_until() on the Mac. The last PRECISE_WAIT_SPIN_MS are spun.
+	The timer belongs to the instance, use one per thread.
+*/
+class PreciseWait
+{
+public:
+	PreciseWait();
+	~PreciseWait();
+
+	/** returns at once if targetMs has passed*/
+	void waitUntil(double targetMs)
+	{
+		for(;;)
+		{
+			const double remaining = targetMs - Time::getMillisecondCounterHiRes();
+			if(remaining <= 0.0) return;
+
+			if(remaining > PRECISE_WAIT_SPIN_MS)	sleep(remaining - PRECISE_WAIT_SPIN_MS);
+			else									Thread::yield();
+		}
+	};
+
+	void waitFor(double ms)
+	{
+		waitUntil(Time::getMillisecondCounterHiRes() + ms);
+	};
+
+private:
+	/** the precise sleep of the platform*/
+	void sleep(double ms);
+
+	void* mTimer;	// the waitable timer on Windows, NULL elsewhere
+};
+//---------------------------------------------------------------------------
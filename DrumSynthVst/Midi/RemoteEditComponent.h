@@ -0,0 +1,153 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MidiOutputRouter.h"
+#include "RemoteEditServer.h"
+
+#define REMOTE_REFRESH_MS	250
+
+//---------------------------------------------------------------------------
+/** Remote editing: connects to the editor of a rack machine, or waits for
+	the editors of the control room. The statistics below are refreshed
+	while the dialog is open, the round trip is in the MIDI diagnostics.
+*/
+class RemoteEditComponent : public Component,
+							public ButtonListener,
+							private Timer
+{
+public:
+	RemoteEditComponent()
+	{
+		addAndMakeVisible(mHost = new TextEditor("host"));
+		mHost->setText("localhost",false);
+
+		addAndMakeVisible(mPort = new TextEditor("port"));
+		mPort->setInputRestrictions(5,"0123456789");
+		mPort->setText(String(REMOTE_DEFAULT_PORT),false);
+
+		addAndMakeVisible(mConnectButton = new TextButton("Connect"));
+		mConnectButton->addListener(this);
+
+		addAndMakeVisible(mListenButton = new ToggleButton("take edits from other editors on the port"));
+		mListenButton->setColour(ToggleButton::textColourId,Colours::white);
+		mListenButton->addListener(this);
+
+		setSize(380,150);
+	};
+
+	~RemoteEditComponent()
+	{
+		deleteAllChildren();
+	};
+
+	void visibilityChanged()
+	{
+		if(isVisible())
+		{
+			updateButtons();
+			startTimer(REMOTE_REFRESH_MS);
+		}
+		else stopTimer();
+	};
+
+	void buttonClicked(Button* button)
+	{
+		const int port = mPort->getText().getIntValue();
+		if(button == mConnectButton)
+		{
+			RemoteEditSender& remote = MidiOutputRouter::getInstance()->getRemote();
+			if(remote.isConnected())
+			{
+				remote.close();
+			}
+			else if(!remote.connect(mHost->getText(),port))
+			{
+				AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Remote Editing","Could not connect to " + mHost->getText() + ":" + String(port) + ".");
+			}
+		}
+		else
+		{
+			RemoteEditServer* server = RemoteEditServer::getInstance();
+			if(!mListenButton->getToggleState())
+			{
+				server->stop();
+			}
+			else if(!server->start(port))
+			{
+				AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Remote Editing","Port " + String(port) + " could not be opened.");
+			}
+		}
+		updateButtons();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+		g.setColour(Colours::white);
+		g.setFont(13.f);
+
+		RemoteEditSender& remote = MidiOutputRouter::getInstance()->getRemote();
+		const int numFrames = remote.getNumFramesSent();
+		g.drawText("sent: " + String(remote.getNumEditsQueued()) + " edits in " + String(numFrames) + " frames ("
+			+ String(remote.getNumEditsSent()/(double)jmax(1,numFrames),1) + " per frame), "
+			+ String(remote.getNumBytesSent()) + " bytes, " + String(remote.getNumFramesAcked()) + " acked",
+			8,96,getWidth()-16,16,Justification::left,false);
+
+		RemoteEditServer* server = RemoteEditServer::getInstance();
+		g.drawText("received: " + String(server->getNumEditsReceived()) + " edits in " + String(server->getNumFramesReceived())
+			+ " frames from " + String(server->getNumConnections()) + " editors",
+			8,114,getWidth()-16,16,Justification::left,false);
+	};
+
+	void resized()
+	{
+		mHost->setBounds(8,8,200,24);
+		mPort->setBounds(216,8,60,24);
+		mConnectButton->setBounds(284,8,getWidth()-292,24);
+		mListenButton->setBounds(8,48,getWidth()-16,24);
+	};
+
+private:
+	void timerCallback()
+	{
+		//the connection may have been lost
+		updateButtons();
+		repaint();
+	};
+
+	void updateButtons()
+	{
+		mConnectButton->setButtonText(MidiOutputRouter::getInstance()->getRemote().isConnected() ? "Disconnect" : "Connect");
+		mListenButton->setToggleState(RemoteEditServer::getInstance()->getPort() != 0,false);
+	};
+
+	TextEditor* mHost;
+	TextEditor* mPort;
+	TextButton* mConnectButton;
+	ToggleButton* mListenButton;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,321 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../drumSynthSource/Parameters.h"
+#include "../Patch.h"
+#include "LatencyMonitor.h"
+#include "PreciseWait.h"
+#include "../ThreadPriorities.h"
+
+#define REMOTE_DEFAULT_PORT			52741
+#define REMOTE_CONNECTION_MAGIC		0x53505245	// "SPRE", the header of every InterprocessConnection message
+#define REMOTE_CONNECT_TIMEOUT_MS	2000
+#define REMOTE_FRAME_MS				5			// the edits of this long go into one frame
+
+// frame types. every frame starts with the type, the sequence number and the send time
+#define REMOTE_FRAME_EDITS			'E'			// then parameter and value bytes for each edit
+#define REMOTE_FRAME_PATCH			'P'			// then the name and all NUM_PARAMS values
+#define REMOTE_FRAME_ACK			'A'			// the header of the frame it acknowledges
+#define REMOTE_HEADER_SIZE			9
+
+//---------------------------------------------------------------------------
+/** The frames of the remote editing link, little endian.
+
+	The send time is the LatencyMonitor time of the sender. The receiver
+	echoes the header back once the edits are queued on its side, so the
+	sender measures the round trip on its own clock.
+*/
+class RemoteFrame
+{
+public:
+	static void writeHeader(uint8* data, int type, uint32 sequence, int sendTime)
+	{
+		data[0] = (uint8)type;
+		writeInt(data+1,sequence);
+		writeInt(data+5,(uint32)sendTime);
+	};
+
+	/** returns false for frames shorter than a header*/
+	static bool readHeader(const MemoryBlock& frame, int& type, uint32& sequence, int& sendTime)
+	{
+		if(frame.getSize() < REMOTE_HEADER_SIZE) return false;
+
+		const uint8* data = (const uint8*)frame.getData();
+		type = data[0];
+		sequence = ByteOrder::littleEndianInt(data+1);
+		sendTime = (int)ByteOrder::littleEndianInt(data+5);
+		return true;
+	};
+
+private:
+	static void writeInt(uint8* data, uint32 value)
+	{
+		for(int i=0;i<4;i++)
+		{
+			data[i] = (uint8)(value >> (i*8));
+		}
+	};
+};
+//---------------------------------------------------------------------------
+/** Sends the edits to an editor on another machine, which plays them to
+	its synths (see RemoteEditServer).
+
+	queueParameter() and queuePatch() never wait for the network. The first
+	edit after a frame wakes the sender thread, which collects for
+	REMOTE_FRAME_MS and then sends everything in one frame. A parameter
+	edited several times in between goes out once with its latest value,
+	a patch replaces the edits queued before it. Parameter numbers fit a
+	byte, so an edit is 2 bytes on the wire.
+
+	The acknowledged frames go into the LatencyMonitor as
+	STAGE_REMOTE, the network round trip plus the time the other side
+	needs to queue the edits.
+*/
+class RemoteEditSender : private Thread
+{
+public:
+	RemoteEditSender() : Thread("RemoteEditThread"),
+		mConnection(*this),
+		mNumDirty(0),
+		mHasPatch(false),
+		mFramePending(false),
+		mSequence(0)
+	{
+		static_jassert(NUM_PARAMS <= 256);
+		memset(mDirty,0,sizeof(mDirty));
+		mNumFramesSent.set(0);
+		mNumFramesAcked.set(0);
+		mNumEditsQueued.set(0);
+		mNumEditsSent.set(0);
+		mNumBytesSent.set(0);
+	};
+
+	~RemoteEditSender()
+	{
+		close();
+	};
+
+	/** returns false if the other side couldn't be reached*/
+	bool connect(const String& hostName, int port)
+	{
+		close();
+		if(!mConnection.connectToSocket(hostName,port,REMOTE_CONNECT_TIMEOUT_MS)) return false;
+		startThread(PRIORITY_CLASS_MIDI);
+		return true;
+	};
+
+	/** drops what is still queued*/
+	void close()
+	{
+		signalThreadShouldExit();
+		notify();
+		stopThread(1000);
+		mConnection.disconnect();
+
+		const ScopedLock sl(mLock);
+		clearEdits();
+		mHasPatch = false;
+		mFramePending = false;
+	};
+
+	/** a value in the 0-127 MIDI range*/
+	void queueParameter(int parameterNr, int value)
+	{
+		if(parameterNr < 0 || parameterNr >= NUM_PARAMS) return;
+		++mNumEditsQueued;
+
+		bool wake;
+		{
+			const ScopedLock sl(mLock);
+			mValues[parameterNr] = (uint8)value;
+			if(!mDirty[parameterNr])
+			{
+				mDirty[parameterNr] = true;
+				mDirtyList[mNumDirty++] = (uint8)parameterNr;
+			}
+			wake = !mFramePending;
+			mFramePending = true;
+		}
+		if(wake) notify();
+	};
+
+	/** the other side sends what its synths are missing*/
+	void queuePatch(Patch* patch)
+	{
+		bool wake;
+		{
+			const ScopedLock sl(mLock);
+			strncpy(mPatchName,patch->getShortName().getText(),PATCH_NAME_LENGTH);
+			memcpy(mPatchValues,patch->getValues(),NUM_PARAMS);
+			clearEdits();
+			mHasPatch = true;
+			wake = !mFramePending;
+			mFramePending = true;
+		}
+		if(wake) notify();
+	};
+
+	bool isConnected() const
+	{
+		return mConnection.isConnected();
+	};
+
+	String getHostName() const
+	{
+		return mConnection.getConnectedHostName();
+	};
+
+	int getNumFramesSent()		{ return mNumFramesSent.get(); };
+	int getNumFramesAcked()		{ return mNumFramesAcked.get(); };
+	int getNumEditsQueued()		{ return mNumEditsQueued.get(); };
+	int getNumEditsSent()		{ return mNumEditsSent.get(); };
+	int getNumBytesSent()		{ return mNumBytesSent.get(); };
+
+private:
+	//-----------------------------------------------------------------------
+	/** the callbacks come on the connection's own thread, the acks aren't held up by the message loop*/
+	class Connection : public InterprocessConnection
+	{
+	public:
+		Connection(RemoteEditSender& owner) : InterprocessConnection(false,REMOTE_CONNECTION_MAGIC),
+			mOwner(owner)
+		{
+		};
+
+		void connectionMade()
+		{
+		};
+
+		void connectionLost()
+		{
+		};
+
+		void messageReceived(const MemoryBlock& message)
+		{
+			int type, sendTime;
+			uint32 sequence;
+			if(!RemoteFrame::readHeader(message,type,sequence,sendTime) || type != REMOTE_FRAME_ACK) return;
+
+			LatencyMonitor::getInstance()->addSample(LatencyMonitor::STAGE_REMOTE,sendTime,LatencyMonitor::getTime());
+			++mOwner.mNumFramesAcked;
+		};
+
+	private:
+		RemoteEditSender& mOwner;
+	};
+	//-----------------------------------------------------------------------
+
+	void run()
+	{
+		while(!threadShouldExit())
+		{
+			wait(-1);
+			if(threadShouldExit()) return;
+
+			//let the frame fill up
+			mFrameWait.waitFor(REMOTE_FRAME_MS);
+			sendFrames();
+		}
+	};
+
+	void sendFrames()
+	{
+		MemoryBlock patchFrame;
+		MemoryBlock editFrame;
+		{
+			const ScopedLock sl(mLock);
+			const int now = LatencyMonitor::getTime();
+			if(mHasPatch)
+			{
+				patchFrame.setSize(REMOTE_HEADER_SIZE + PATCH_NAME_LENGTH + NUM_PARAMS);
+				uint8* data = (uint8*)patchFrame.getData();
+				RemoteFrame::writeHeader(data,REMOTE_FRAME_PATCH,mSequence++,now);
+				memcpy(data+REMOTE_HEADER_SIZE,mPatchName,PATCH_NAME_LENGTH);
+				memcpy(data+REMOTE_HEADER_SIZE+PATCH_NAME_LENGTH,mPatchValues,NUM_PARAMS);
+				mHasPatch = false;
+			}
+			if(mNumDirty > 0)
+			{
+				editFrame.setSize(REMOTE_HEADER_SIZE + mNumDirty*2);
+				uint8* data = (uint8*)editFrame.getData();
+				RemoteFrame::writeHeader(data,REMOTE_FRAME_EDITS,mSequence++,now);
+				for(int i=0;i<mNumDirty;i++)
+				{
+					data[REMOTE_HEADER_SIZE + i*2] = mDirtyList[i];
+					data[REMOTE_HEADER_SIZE + i*2 + 1] = mValues[mDirtyList[i]];
+				}
+				mNumEditsSent += mNumDirty;
+				clearEdits();
+			}
+			mFramePending = false;
+		}
+
+		//outside the lock, the socket may block
+		if(patchFrame.getSize() > 0) send(patchFrame);
+		if(editFrame.getSize() > 0) send(editFrame);
+	};
+
+	void send(const MemoryBlock& frame)
+	{
+		if(!mConnection.sendMessage(frame)) return;
+		++mNumFramesSent;
+		mNumBytesSent += (int)frame.getSize();
+	};
+
+	/** with mLock held*/
+	void clearEdits()
+	{
+		for(int i=0;i<mNumDirty;i++)
+		{
+			mDirty[mDirtyList[i]] = false;
+		}
+		mNumDirty = 0;
+	};
+
+	Connection mConnection;
+
+	CriticalSection mLock;
+	uint8 mValues[NUM_PARAMS];
+	bool mDirty[NUM_PARAMS];
+	uint8 mDirtyList[NUM_PARAMS];	// in the order of the first edit
+	int mNumDirty;
+	char mPatchName[PATCH_NAME_LENGTH];
+	uint8 mPatchValues[NUM_PARAMS];
+	bool mHasPatch;
+	bool mFramePending;		// the thread has been woken for the next frame
+	uint32 mSequence;
+
+	PreciseWait mFrameWait;	// sender thread only
+
+	Atomic<int> mNumFramesSent;
+	Atomic<int> mNumFramesAcked;
+	Atomic<int> mNumEditsQueued;
+	Atomic<int> mNumEditsSent;
+	Atomic<int> mNumBytesSent;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,206 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Patch.h"
+#include "../ParameterStore.h"
+#include "LatencyMonitor.h"
+#include "MidiTransmitter.h"
+#include "RemoteEditSender.h"
+
+//---------------------------------------------------------------------------
+/** Plays the edits of a RemoteEditSender on another machine to the synth
+	of the MIDI setup.
+
+	A frame is handled on the thread of its connection: the edits go into
+	the ParameterStore, so the widgets follow, and into the interactive
+	queue of the MidiTransmitter, a patch frame through sendPatch(). The
+	arrival of a frame counts as the widget callback of its edits, so the
+	UI stages of the LatencyMonitor show the time from the network to the
+	wire. Then the header is echoed back for the sender's round trip.
+
+	Several editors can be connected at once. start() and stop() on the
+	message thread.
+*/
+class RemoteEditServer : public InterprocessConnectionServer
+{
+public:
+	RemoteEditServer() : mPort(0)
+	{
+		mNumConnections.set(0);
+		mNumFramesReceived.set(0);
+		mNumEditsReceived.set(0);
+	};
+
+	~RemoteEditServer()
+	{
+		stop();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (RemoteEditServer, false)
+
+	/** returns false if the port can't be opened*/
+	bool start(int port)
+	{
+		stop();
+		if(!beginWaitingForSocket(port)) return false;
+		mPort = port;
+		return true;
+	};
+
+	/** closes the port and every connection*/
+	void stop()
+	{
+		InterprocessConnectionServer::stop();
+		const ScopedLock sl(mLock);
+		mConnections.clear();
+		mPort = 0;
+	};
+
+	/** 0 while stopped*/
+	int getPort() const
+	{
+		return mPort;
+	};
+
+	int getNumConnections()		{ return mNumConnections.get(); };
+	int getNumFramesReceived()	{ return mNumFramesReceived.get(); };
+	int getNumEditsReceived()	{ return mNumEditsReceived.get(); };
+
+private:
+	//-----------------------------------------------------------------------
+	class Receiver : public InterprocessConnection
+	{
+	public:
+		Receiver(RemoteEditServer& owner) : InterprocessConnection(false,REMOTE_CONNECTION_MAGIC),
+			mOwner(owner),
+			mConnected(false)
+		{
+		};
+
+		~Receiver()
+		{
+			//connectionLost() is still called from here
+			disconnect();
+		};
+
+		void connectionMade()
+		{
+			mConnected = true;
+			++mOwner.mNumConnections;
+		};
+
+		void connectionLost()
+		{
+			if(mConnected) --mOwner.mNumConnections;
+			mConnected = false;
+		};
+
+		void messageReceived(const MemoryBlock& frame)
+		{
+			int type, sendTime;
+			uint32 sequence;
+			if(!RemoteFrame::readHeader(frame,type,sequence,sendTime)) return;
+
+			LatencyMonitor::getInstance()->uiEvent();
+			const uint8* data = (const uint8*)frame.getData() + REMOTE_HEADER_SIZE;
+			const int size = (int)frame.getSize() - REMOTE_HEADER_SIZE;
+			if(type == REMOTE_FRAME_EDITS)
+			{
+				playEdits(data,size/2);
+			}
+			else if(type == REMOTE_FRAME_PATCH && size == PATCH_NAME_LENGTH + NUM_PARAMS)
+			{
+				playPatch(data);
+			}
+			else return;
+			++mOwner.mNumFramesReceived;
+
+			uint8 ack[REMOTE_HEADER_SIZE];
+			RemoteFrame::writeHeader(ack,REMOTE_FRAME_ACK,sequence,sendTime);
+			sendMessage(MemoryBlock(ack,REMOTE_HEADER_SIZE));
+		};
+
+	private:
+		void playEdits(const uint8* edits, int numEdits)
+		{
+			ParameterStore* store = ParameterStore::getInstance();
+			MidiTransmitter* transmitter = MidiTransmitter::getInstance();
+			for(int i=0;i<numEdits;i++)
+			{
+				const int parameterNr = edits[i*2];
+				const int value = edits[i*2+1];
+				if(parameterNr >= NUM_PARAMS) continue;
+
+				store->setValueFromMidi(parameterNr,value);
+				transmitter->sendParameter(parameterNr,value,PRIORITY_INTERACTIVE);
+			}
+			mOwner.mNumEditsReceived += numEdits;
+		};
+
+		void playPatch(const uint8* data)
+		{
+			char name[PATCH_NAME_LENGTH+1];
+			memcpy(name,data,PATCH_NAME_LENGTH);
+			name[PATCH_NAME_LENGTH] = 0;
+
+			Patch patch;
+			patch.setName(name);
+			patch.setValues(data+PATCH_NAME_LENGTH);
+
+			ParameterStore* store = ParameterStore::getInstance();
+			for(int i=0;i<NUM_PARAMS;i++)
+			{
+				store->setValueFromMidi(i,patch.getParameter(i));
+			}
+			MidiTransmitter::getInstance()->sendPatch(&patch);
+			mOwner.mNumEditsReceived += NUM_PARAMS;
+		};
+
+		RemoteEditServer& mOwner;
+		bool mConnected;
+	};
+	//-----------------------------------------------------------------------
+
+	/** on the listener thread*/
+	InterprocessConnection* createConnectionObject()
+	{
+		Receiver* receiver = new Receiver(*this);
+		const ScopedLock sl(mLock);
+		mConnections.add(receiver);
+		return receiver;
+	};
+
+	CriticalSection mLock;
+	OwnedArray<Receiver> mConnections;	// the closed ones stay until stop()
+	int mPort;
+
+	Atomic<int> mNumConnections;
+	Atomic<int> mNumFramesReceived;
+	Atomic<int> mNumEditsReceived;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,233 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PatchSysEx.h"
+
+#define SYSEX_READ_CHUNK_SIZE	4096
+
+//---------------------------------------------------------------------------
+/** Finds patch dumps in a raw MIDI byte stream that arrives in arbitrary chunks.
+
+	The 7 in 8 packed data is decoded while it arrives, so only one
+	PATCH_DATA_SIZE record is buffered, however long the stream is. Messages
+	from other manufacturers are skipped, realtime bytes inside a dump are
+	ignored and a dump that is cut short or has a wrong checksum is counted
+	as an error and dropped.
+*/
+class SysExStreamParser
+{
+public:
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** called for every complete dump with PATCH_DATA_SIZE bytes in .SND layout*/
+		virtual void patchDumpReceived(const uint8_t* data) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	SysExStreamParser(Listener* listener) : mListener(listener)
+	{
+		reset();
+	};
+
+	~SysExStreamParser()
+	{
+	};
+
+	void reset()
+	{
+		mState = STATE_IDLE;
+		mNumPatches = 0;
+		mNumErrors = 0;
+	};
+
+	/** parse the next chunk, a dump may be split anywhere*/
+	void feed(const uint8_t* bytes, int numBytes)
+	{
+		for(int i=0;i<numBytes;i++)
+		{
+			const uint8_t b = bytes[i];
+			if(b >= 0xf8) continue;	// realtime messages may appear anywhere
+
+			if(b & 0x80)	handleStatus(b);
+			else			handleData(b);
+		}
+	};
+
+	/** parse a block in memory, e.g. a mapped .syx file, checking the thread every
+		SYSEX_READ_CHUNK_SIZE bytes. returns false if it was asked to stop before the end*/
+	bool feed(const uint8_t* bytes, size_t numBytes, Thread* thread)
+	{
+		for(size_t pos=0;pos<numBytes;pos+=SYSEX_READ_CHUNK_SIZE)
+		{
+			if(thread != NULL && thread->threadShouldExit()) return false;
+			feed(bytes+pos,(int)jmin((size_t)SYSEX_READ_CHUNK_SIZE,numBytes-pos));
+		}
+		return true;
+	};
+
+	/** parse a whole stream, e.g. a .syx file, in SYSEX_READ_CHUNK_SIZE chunks.
+		returns false if the thread was asked to stop before the end*/
+	bool feed(InputStream& in, Thread* thread = NULL)
+	{
+		uint8_t chunk[SYSEX_READ_CHUNK_SIZE];
+		for(;;)
+		{
+			if(thread != NULL && thread->threadShouldExit()) return false;
+
+			const int numRead = in.read(chunk,SYSEX_READ_CHUNK_SIZE);
+			if(numRead <= 0) break;
+			feed(chunk,numRead);
+		}
+		return true;
+	};
+
+	int getNumPatches()
+	{
+		return mNumPatches;
+	};
+
+	int getNumErrors()
+	{
+		return mNumErrors;
+	};
+
+private:
+	enum State
+	{
+		STATE_IDLE = 0,		// between messages
+		STATE_SKIP,			// inside a message that isn't a patch dump
+		STATE_HEADER,		// manufacturer id and command
+		STATE_DATA,			// packed patch data
+		STATE_CHECKSUM,
+		STATE_END			// waiting for F7
+	};
+
+	void handleStatus(uint8_t b)
+	{
+		//any status byte ends the current message
+		if(mState == STATE_END && b == 0xf7)
+		{
+			if(mChecksumOk)
+			{
+				mNumPatches++;
+				if(mListener != NULL) mListener->patchDumpReceived(mRecord);
+			}
+			else
+			{
+				mNumErrors++;
+			}
+		}
+		else if(mState >= STATE_DATA)
+		{
+			//a dump that was cut short
+			mNumErrors++;
+		}
+
+		if(b == 0xf0)
+		{
+			mState = STATE_HEADER;
+			mPosition = 0;
+		}
+		else
+		{
+			mState = STATE_IDLE;
+		}
+	};
+
+	void handleData(uint8_t b)
+	{
+		switch(mState)
+		{
+		case STATE_IDLE:
+		case STATE_SKIP:
+			break;
+
+		case STATE_HEADER:
+			if((mPosition == 0 && b != SYSEX_MANUFACTURER_ID) || (mPosition == 1 && b != SYSEX_PATCH_DUMP))
+			{
+				mState = STATE_SKIP;
+			}
+			else if(++mPosition == 2)
+			{
+				mState = STATE_DATA;
+				mPosition = 0;
+				mNumDecoded = 0;
+				mSum = 0;
+			}
+			break;
+
+		case STATE_DATA:
+			{
+				mSum += b;
+				//every 8 bytes start with the MSBs of the following 7
+				const int groupPos = mPosition&7;
+				if(groupPos == 0)
+				{
+					mMsbs = b;
+				}
+				else if(mNumDecoded < PATCH_DATA_SIZE)
+				{
+					mRecord[mNumDecoded++] = b | (((mMsbs>>(groupPos-1))&1)<<7);
+				}
+				if(++mPosition == SYSEX_PACKED_SIZE)
+				{
+					mState = STATE_CHECKSUM;
+				}
+			}
+			break;
+
+		case STATE_CHECKSUM:
+			mChecksumOk = (b == (mSum&0x7f));
+			mState = STATE_END;
+			break;
+
+		case STATE_END:
+			//longer than a dump
+			mNumErrors++;
+			mState = STATE_SKIP;
+			break;
+		}
+	};
+
+private:
+	Listener* mListener;
+
+	int mState;
+	int mPosition;		// byte position inside the header or the packed data
+	int mNumDecoded;
+	int mSum;
+	uint8_t mMsbs;
+	bool mChecksumOk;
+	uint8_t mRecord[PATCH_DATA_SIZE];
+
+	int mNumPatches;
+	int mNumErrors;
+};
+//---------------------------------------------------------------------------
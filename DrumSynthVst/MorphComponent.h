@@ -0,0 +1,121 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./MorphEngine.h"
+#include "./PresetLoader.h"
+
+//---------------------------------------------------------------------------
+/** The morph dialog: a target preset and the amount slider.
+
+	Choosing a target morphs from the sound as it is then. Each drag of the
+	slider is one undo step.
+*/
+class MorphComponent : public Component,
+					   public SliderListener,
+					   public ButtonListener
+{
+public:
+	MorphComponent()
+	{
+		addAndMakeVisible(mTargetButton = new TextButton("Target..."));
+		mTargetButton->addListener(this);
+
+		addAndMakeVisible(mTargetLabel = new Label("target","no target"));
+		mTargetLabel->setColour(Label::textColourId,Colours::white);
+
+		addAndMakeVisible(mAmount = new Slider("amount"));
+		mAmount->setRange(0,MORPH_MAX_AMOUNT,1);
+		mAmount->setSliderStyle(Slider::LinearHorizontal);
+		mAmount->setTextBoxStyle(Slider::TextBoxRight,false,48,20);
+		mAmount->setEnabled(false);
+		mAmount->addListener(this);
+
+		setSize(360,72);
+	};
+
+	~MorphComponent()
+	{
+		deleteAllChildren();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+	};
+
+	void resized()
+	{
+		mTargetButton->setBounds(8,8,80,24);
+		mTargetLabel->setBounds(96,8,getWidth()-104,24);
+		mAmount->setBounds(8,40,getWidth()-16,24);
+	};
+
+	void buttonClicked(Button*)
+	{
+		FileChooser chooser("Morph target",File::nonexistent,"*.snd");
+		if(!chooser.browseForFileToOpen()) return;
+
+		uint8_t data[PATCH_DATA_SIZE];
+		memset(data,0,PATCH_DATA_SIZE);
+		FileInputStream in(chooser.getResult());
+		if(in.getStatus().failed() || in.read(data,PATCH_DATA_SIZE) <= 0)
+		{
+			AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Morph","The preset could not be read.");
+			return;
+		}
+		Patch target;
+		PresetLoader::readPatchData(data,&target);
+
+		mEngine.setPatches(ParameterStore::getInstance()->getValues(),target.getValues());
+		mTargetLabel->setText("to " + target.getShortName().toString(),false);
+		mAmount->setValue(0,false);
+		mAmount->setEnabled(true);
+	};
+
+	void sliderDragStarted(Slider*)
+	{
+		mEngine.beginMorph();
+	};
+
+	void sliderValueChanged(Slider*)
+	{
+		mEngine.setAmount(roundToInt(mAmount->getValue()));
+	};
+
+	void sliderDragEnded(Slider*)
+	{
+		mEngine.endMorph();
+	};
+
+private:
+	MorphEngine mEngine;
+
+	TextButton* mTargetButton;
+	Label* mTargetLabel;
+	Slider* mAmount;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,243 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./parameterDtypes.h"
+#include "./ParameterStore.h"
+#include "./Midi/MidiTransmitter.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define MORPH_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define MORPH_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define MORPH_MAX_AMOUNT		255		// the range of PAR_MORPH on the synth
+#define MORPH_STEP_MS			16		// one step per frame if the link keeps up
+#define MORPH_FIRST_PARAMETER	1		// the sound parameters are morphed, like on the synth
+#define MORPH_END_PARAMETER		END_OF_SOUND_PARAMETERS
+#define MORPH_STRIDE			((NUM_PARAMS+15)&~15)	// the packed values are padded to whole SIMD steps
+
+//---------------------------------------------------------------------------
+/** Morphs the edited sound between two patches, the way PAR_MORPH does it
+	on the synth between the kit and the morph target: 0 is the source,
+	MORPH_MAX_AMOUNT the target.
+
+	Both patches are packed into MORPH_STRIDE bytes and interpolated in one
+	pass, 16 parameters per step with SSE2 or NEON. Parameters with a
+	discrete dtype (menus, switches, voice and target selections) don't
+	have values in between, they jump from the source to the target value
+	at the middle.
+
+	Every step only sends the parameters whose value changed, with bulk
+	priority through the MidiTransmitter. A step waits while the link still
+	has more than MORPH_STEP_MS of data to send, and then goes to the
+	newest amount, so a fast drag over a DIN cable skips amounts instead of
+	falling behind. A morph between beginMorph() and endMorph() is undone
+	in one step. Message thread only.
+*/
+class MorphEngine : private Timer
+{
+public:
+	MorphEngine() : mAmount(0), mAppliedAmount(0), mHasTarget(false), mMorphing(false)
+	{
+		memset(mSource,0,MORPH_STRIDE);
+		memset(mTarget,0,MORPH_STRIDE);
+		memset(mValues,0,MORPH_STRIDE);
+		memset(mUndoStart,0,NUM_PARAMS);
+		memset(mDiscrete,0,MORPH_STRIDE);
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mDiscrete[i] = isDiscrete(i) ? 0xff : 0;
+		}
+	};
+
+	~MorphEngine()
+	{
+		stopTimer();
+	};
+
+	/** NUM_PARAMS values each, the amount goes back to the source*/
+	void setPatches(const uint8_t* source, const uint8_t* target)
+	{
+		stopTimer();
+		memcpy(mSource,source,NUM_PARAMS);
+		memcpy(mTarget,target,NUM_PARAMS);
+		mAmount = mAppliedAmount = 0;
+		mHasTarget = true;
+	};
+
+	bool hasTarget() const
+	{
+		return mHasTarget;
+	};
+
+	/** 0-MORPH_MAX_AMOUNT, sent with the next step the link has room for*/
+	void setAmount(int amount)
+	{
+		if(!mHasTarget) return;
+
+		mAmount = jlimit(0,MORPH_MAX_AMOUNT,amount);
+		if(!isTimerRunning())
+		{
+			timerCallback();
+			startTimer(MORPH_STEP_MS);
+		}
+	};
+
+	int getAmount() const
+	{
+		return mAmount;
+	};
+
+	/** remembers the values the undo of the morph goes back to*/
+	void beginMorph()
+	{
+		memcpy(mUndoStart,ParameterStore::getInstance()->getValues(),NUM_PARAMS);
+		mMorphing = true;
+	};
+
+	/** sends the last amount right away and records the whole morph as one undo group*/
+	void endMorph()
+	{
+		stopTimer();
+		if(mHasTarget && mAppliedAmount != mAmount) step();
+		if(!mMorphing) return;
+		mMorphing = false;
+
+		ParameterStore* store = ParameterStore::getInstance();
+		const uint8_t* values = store->getValues();
+		store->beginUndoGroup();
+		for(int i=MORPH_FIRST_PARAMETER;i<MORPH_END_PARAMETER;i++)
+		{
+			store->getUndoLog().record(i,mUndoStart[i],values[i]);
+		}
+		store->endUndoGroup();
+	};
+
+	/** out[i] = a[i] + (b[i]-a[i])*amount/MORPH_MAX_AMOUNT, rounded. where discrete[i] is 0xff
+		out[i] is a[i] up to the middle and b[i] from there on. the SIMD steps take 16 bytes, the rest is scalar*/
+	static void interpolate(const uint8_t* a, const uint8_t* b, const uint8_t* discrete, int amount, uint8_t* out, int num)
+	{
+		//weights out of 256, so the division is a shift and MORPH_MAX_AMOUNT gives b exactly
+		const int wb = amount + (amount>>7);
+		const int wa = 256 - wb;
+		const uint8_t* nearest = amount > MORPH_MAX_AMOUNT/2 ? b : a;
+
+		int i = 0;
+#if MORPH_USE_SSE2
+		//a*wa + b*wb + 128 is at most 255*256+128, it fits the unsigned 16 bit lanes
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i weightA = _mm_set1_epi16((short)wa);
+		const __m128i weightB = _mm_set1_epi16((short)wb);
+		const __m128i round = _mm_set1_epi16(128);
+		for(;i+16<=num;i+=16)
+		{
+			const __m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+			const __m128i vb = _mm_loadu_si128((const __m128i*)(b+i));
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va,zero),weightA),_mm_mullo_epi16(_mm_unpacklo_epi8(vb,zero),weightB));
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va,zero),weightA),_mm_mullo_epi16(_mm_unpackhi_epi8(vb,zero),weightB));
+			lo = _mm_srli_epi16(_mm_add_epi16(lo,round),8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi,round),8);
+			const __m128i mixed = _mm_packus_epi16(lo,hi);
+
+			const __m128i select = _mm_loadu_si128((const __m128i*)(discrete+i));
+			const __m128i jump = _mm_loadu_si128((const __m128i*)(nearest+i));
+			_mm_storeu_si128((__m128i*)(out+i),_mm_or_si128(_mm_and_si128(select,jump),_mm_andnot_si128(select,mixed)));
+		}
+#elif MORPH_USE_NEON
+		const uint16x8_t weightA = vdupq_n_u16((uint16_t)wa);
+		const uint16x8_t weightB = vdupq_n_u16((uint16_t)wb);
+		for(;i+16<=num;i+=16)
+		{
+			const uint8x16_t va = vld1q_u8(a+i);
+			const uint8x16_t vb = vld1q_u8(b+i);
+			const uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(va)),weightA),vmovl_u8(vget_low_u8(vb)),weightB);
+			const uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(va)),weightA),vmovl_u8(vget_high_u8(vb)),weightB);
+			//the rounding shift adds the 128
+			const uint8x16_t mixed = vcombine_u8(vrshrn_n_u16(lo,8),vrshrn_n_u16(hi,8));
+			vst1q_u8(out+i,vbslq_u8(vld1q_u8(discrete+i),vld1q_u8(nearest+i),mixed));
+		}
+#endif
+		//the tail (or everything without SIMD)
+		for(;i<num;i++)
+		{
+			const uint8_t mixed = (uint8_t)((a[i]*wa + b[i]*wb + 128)>>8);
+			out[i] = (uint8_t)((nearest[i] & discrete[i]) | (mixed & ~discrete[i]));
+		}
+	};
+
+	/** menus and the other dtypes without values in between*/
+	static bool isDiscrete(int parameterNr)
+	{
+		switch(parameterDtypes[parameterNr] & 0x0f)
+		{
+		case DTYPE_0B255:
+		case DTYPE_0B127:
+		case DTYPE_PM100:
+		case DTYPE_PM63:
+			return false;
+		default:
+			return true;
+		}
+	};
+
+private:
+	void timerCallback()
+	{
+		if(mAppliedAmount == mAmount)
+		{
+			stopTimer();
+			return;
+		}
+		//the wire is still busy with the last step, the next one goes to the newest amount
+		if(MidiTransmitter::getInstance()->getEstimatedDrainTime() > MORPH_STEP_MS) return;
+		step();
+	};
+
+	void step()
+	{
+		interpolate(mSource,mTarget,mDiscrete,mAmount,mValues,MORPH_STRIDE);
+		ParameterStore::getInstance()->setValues(mValues,MORPH_FIRST_PARAMETER,MORPH_END_PARAMETER,PRIORITY_BULK);
+		mAppliedAmount = mAmount;
+	};
+
+	uint8_t mSource[MORPH_STRIDE];
+	uint8_t mTarget[MORPH_STRIDE];
+	uint8_t mDiscrete[MORPH_STRIDE];	// 0xff for the discrete parameters
+	uint8_t mValues[MORPH_STRIDE];		// the values of the last step
+	uint8_t mUndoStart[NUM_PARAMS];		// the store values at beginMorph()
+
+	int mAmount;
+	int mAppliedAmount;		// what the store has
+	bool mHasTarget;
+	bool mMorphing;			// between beginMorph() and endMorph()
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,140 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+//---------------------------------------------------------------------------
+/** A bounded queue any number of threads can write to and one thread reads.
+
+	AbstractFifo only allows one writer. Here every item has its own slot
+	with a sequence number: a writer claims the next write position with
+	one compare and swap, copies the item and marks the slot as filled.
+	Neither side ever blocks or takes a lock, push() returns false when the
+	reader is a full queue behind.
+
+	read() takes every filled slot in order up to maxNum in one call. It
+	stops at a slot that is claimed but not filled yet, the items behind it
+	come with the next call.
+
+	The slots are made once in the constructor, the capacity is rounded up
+	to a power of 2.
+*/
+template <class ElementType>
+class MpscFifo
+{
+public:
+	MpscFifo(int capacity)
+	{
+		mCapacity = 2;
+		while(mCapacity < capacity) mCapacity *= 2;
+		mSlots = new Slot[mCapacity];
+		for(int i=0;i<mCapacity;i++)
+		{
+			mSlots[i].sequence.set(i);
+		}
+		mWritePos.set(0);
+		mReadPos.set(0);
+	};
+
+	~MpscFifo()
+	{
+		delete[] mSlots;
+	};
+
+	int getCapacity() const
+	{
+		return mCapacity;
+	};
+
+	/** items written but not read yet, including ones still being copied*/
+	int getNumReady() const
+	{
+		return mWritePos.get() - mReadPos.get();
+	};
+
+	/** can be called from any thread, returns false if the queue is full*/
+	bool push(const ElementType& item)
+	{
+		int pos = mWritePos.get();
+		for(;;)
+		{
+			Slot& slot = mSlots[pos & (mCapacity-1)];
+			const int diff = slot.sequence.get() - pos;
+			if(diff == 0)
+			{
+				//claim the slot
+				if(mWritePos.compareAndSetBool(pos+1,pos))
+				{
+					slot.item = item;
+					slot.sequence.set(pos+1);
+					return true;
+				}
+				pos = mWritePos.get();
+			}
+			else if(diff < 0)
+			{
+				//the reader hasn't freed this slot yet
+				return false;
+			}
+			else
+			{
+				//another writer took it
+				pos = mWritePos.get();
+			}
+		}
+	};
+
+	/** copies up to maxNum items into dest and returns how many, reading thread only*/
+	int read(ElementType* dest, int maxNum)
+	{
+		int pos = mReadPos.get();
+		int num = 0;
+		while(num < maxNum)
+		{
+			Slot& slot = mSlots[pos & (mCapacity-1)];
+			if(slot.sequence.get() != pos+1) break;
+
+			dest[num++] = slot.item;
+			slot.sequence.set(pos + mCapacity);
+			pos++;
+		}
+		mReadPos.set(pos);
+		return num;
+	};
+
+private:
+	struct Slot
+	{
+		Atomic<int> sequence;	// == position: free, == position+1: holds an item
+		ElementType item;
+	};
+
+	Slot* mSlots;
+	int mCapacity;
+	Atomic<int> mWritePos;
+	Atomic<int> mReadPos;	// written by the reader only, read by getNumReady()
+};
+//---------------------------------------------------------------------------
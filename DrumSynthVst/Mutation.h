@@ -0,0 +1,178 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./parameterRanges.h"
+#include "./Crossover.h"
+#include "./Library/PatchLineage.h"
+#include "FastRandom.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define MUTATION_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define MUTATION_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define MUTATION_UNIFORM	0	// offsets up to the max offset, all equally likely
+#define MUTATION_GAUSSIAN	1	// normal offsets, the max offset is two standard deviations
+
+//---------------------------------------------------------------------------
+/** Adds offsets to a masked subset of the values of patches and saturates
+	them against the bounds of every parameter.
+
+	The bounds are the stored ones: PM63 parameters are 0 to 126, the 1..6
+	and 1..16 ones start at 1, everything else at 0. They are built once by
+	the constructor as 16 bit tables, apply() then handles 16 parameters
+	per step with SSE2 or NEON saturating adds, max and min, and falls back
+	to scalar code. Where the mask bit of a parameter is clear its value is
+	taken over as it is, even if it is out of its bounds. The mask is the
+	layout of a Crossover mother mask, the masked values are selected with
+	Crossover::blend().
+*/
+class MutationKernel
+{
+public:
+	MutationKernel()
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			const ParameterRange& range = parameterRanges[i];
+			mLow[i] = (short)(range.min < 0 ? 0 : range.min);
+			mHigh[i] = (short)(mLow[i] + range.range);
+		}
+	};
+
+	/** the smallest stored value of a parameter*/
+	int getLow(int parameterNr) const
+	{
+		return mLow[parameterNr];
+	};
+
+	/** the largest stored value of a parameter*/
+	int getHigh(int parameterNr) const
+	{
+		return mHigh[parameterNr];
+	};
+
+	/** picks numMutations distinct parameters of the numSites in sites, sets their mask bits and
+		gives them a random offset of up to maxOffset (0-1) of their range. offsets has NUM_PARAMS
+		entries and mask PARAMETER_MASK_SIZE bytes, the others are cleared. sites is shuffled,
+		its first numMutations entries are the picked parameters*/
+	static void fillOffsets(int distribution, uint8_t* sites, int numSites, int numMutations, float maxOffset, FastRandom& random, short* offsets, uint8_t* mask)
+	{
+		memset(offsets,0,NUM_PARAMS*sizeof(short));
+		memset(mask,0,PARAMETER_MASK_SIZE);
+
+		//partial Fisher-Yates shuffle: after k steps the first k entries are k distinct random parameters
+		for(int i=0;i<numMutations;i++)
+		{
+			const int pick = i + random.nextInt(numSites-i);
+			const uint8_t parameterNr = sites[pick];
+			sites[pick] = sites[i];
+			sites[i] = parameterNr;
+
+			const int range = parameterRanges[parameterNr].range;
+			int offset;
+			if(distribution == MUTATION_GAUSSIAN)
+			{
+				offset = roundToInt(nextGaussian(random)*maxOffset*0.5f*range);
+			}
+			else
+			{
+				offset = (int)(range*random.nextFloat()*maxOffset);
+				if(!random.nextBool()) offset = -offset;
+			}
+			offsets[parameterNr] = (short)jlimit(-range,range,offset);
+			mask[parameterNr>>3] |= (uint8_t)(1<<(parameterNr&7));
+		}
+	};
+
+	/** out = values + offsets saturated to the bounds where the mask bit is set, values elsewhere.
+		numPatches patches of NUM_PARAMS values and offsets and PARAMETER_MASK_SIZE mask bytes each,
+		back to back, so a whole population goes in one call. out may be values*/
+	void apply(const uint8_t* values, const short* offsets, const uint8_t* mask, uint8_t* out, int numPatches) const
+	{
+		uint8_t saturated[NUM_PARAMS];
+		for(int p=0;p<numPatches;p++)
+		{
+			saturate(values,offsets,saturated);
+			Crossover::blend(values,saturated,mask,out,NUM_PARAMS);
+			values += NUM_PARAMS;
+			offsets += NUM_PARAMS;
+			mask += PARAMETER_MASK_SIZE;
+			out += NUM_PARAMS;
+		}
+	};
+
+private:
+	/** out[i] = clamp(values[i] + offsets[i], low, high) for all NUM_PARAMS parameters*/
+	void saturate(const uint8_t* values, const short* offsets, uint8_t* out) const
+	{
+		int i = 0;
+#if MUTATION_USE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for(;i+16<=NUM_PARAMS;i+=16)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(values+i));
+			__m128i lo = _mm_adds_epi16(_mm_unpacklo_epi8(v,zero),_mm_loadu_si128((const __m128i*)(offsets+i)));
+			__m128i hi = _mm_adds_epi16(_mm_unpackhi_epi8(v,zero),_mm_loadu_si128((const __m128i*)(offsets+i+8)));
+			lo = _mm_min_epi16(_mm_max_epi16(lo,_mm_loadu_si128((const __m128i*)(mLow+i))),_mm_loadu_si128((const __m128i*)(mHigh+i)));
+			hi = _mm_min_epi16(_mm_max_epi16(hi,_mm_loadu_si128((const __m128i*)(mLow+i+8))),_mm_loadu_si128((const __m128i*)(mHigh+i+8)));
+			_mm_storeu_si128((__m128i*)(out+i),_mm_packus_epi16(lo,hi));
+		}
+#elif MUTATION_USE_NEON
+		for(;i+16<=NUM_PARAMS;i+=16)
+		{
+			const uint8x16_t v = vld1q_u8(values+i);
+			int16x8_t lo = vqaddq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(v))),vld1q_s16(offsets+i));
+			int16x8_t hi = vqaddq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(v))),vld1q_s16(offsets+i+8));
+			lo = vminq_s16(vmaxq_s16(lo,vld1q_s16(mLow+i)),vld1q_s16(mHigh+i));
+			hi = vminq_s16(vmaxq_s16(hi,vld1q_s16(mLow+i+8)),vld1q_s16(mHigh+i+8));
+			vst1q_u8(out+i,vcombine_u8(vqmovun_s16(lo),vqmovun_s16(hi)));
+		}
+#endif
+		//the tail (or everything without SIMD)
+		for(;i<NUM_PARAMS;i++)
+		{
+			out[i] = (uint8_t)jlimit((int)mLow[i],(int)mHigh[i],values[i] + offsets[i]);
+		}
+	};
+
+	/** a standard normal number, Box-Muller*/
+	static float nextGaussian(FastRandom& random)
+	{
+		const float u = 1.f - random.nextFloat();	// (0:1], the log needs it above 0
+		const float v = random.nextFloat();
+		return sqrtf(-2.f*logf(u)) * cosf(2.f*float_Pi*v);
+	};
+
+	short mLow[NUM_PARAMS];
+	short mHigh[NUM_PARAMS];
+};
+//---------------------------------------------------------------------------
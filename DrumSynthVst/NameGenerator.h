@@ -28,6 +28,8 @@
 //#include "MarkovNameGenerator.h"
 //#include "MarkovName/CRandomName.h"
 #include "MarkovName/Markov.h"
+#include "Patch.h"
+#include "NameModel.h"
 
 #define NUM_NAMES 30
 
@@ -38,6 +40,10 @@
 #define NUM_BEGINS 10
 
 #define NUM_PATTERNS 11
+
+#define NAME_SIZE			(PATCH_NAME_LENGTH+1)	// bytes per name in a batch, 0 terminated
+#define NAME_SHARD_SIZE		256		// names one worker generates, smaller batches stay on the calling thread
+#define NAME_ATTEMPTS		16		// tries for an unused name before a number is added
 /*
 static char namePatterns[NUM_PATTERNS][10] = 
 {
@@ -167,11 +173,141 @@ static String markovNames(     "Proton,Solaris,Groove,Beat,funk,jam,wobble, drum
 						ooze,turtle,splinter,krank,rock,steady,bebop");
 						*/
 //---------------------------------------------------------------------------
+/** The names that are taken, so a batch of new patches gets only unused ones.
+	A name is packed into the 8 bytes of a uint64, the set is an open addressed
+	table of those. Lookups compare one word and never allocate. Names are
+	compared exactly as they are stored.
+*/
+class PatchNameSet
+{
+public:
+	PatchNameSet(int expectedSize=256)
+	{
+		mNumNames = 0;
+		mCapacity = 64;
+		while(mCapacity < expectedSize*2) mCapacity *= 2;
+		mTable.calloc(mCapacity);
+		mHasEmpty = false;
+	};
+
+	~PatchNameSet()
+	{
+	};
+
+	/** returns false if the name was taken already*/
+	bool add(const char* name)
+	{
+		const uint64 key = pack(name);
+		if(key == 0)
+		{
+			//the empty name can't be stored in the table, 0 marks a free slot
+			const bool added = !mHasEmpty;
+			mHasEmpty = true;
+			return added;
+		}
+
+		if((mNumNames+1)*2 > mCapacity) grow();
+		return insert(key);
+	};
+
+	bool add(const String& name)
+	{
+		char buffer[NAME_SIZE];
+		name.copyToUTF8(buffer,NAME_SIZE);
+		return add(buffer);
+	};
+
+	bool add(const ShortString& name)
+	{
+		return add(name.getText());
+	};
+
+	bool contains(const char* name) const
+	{
+		const uint64 key = pack(name);
+		if(key == 0) return mHasEmpty;
+
+		for(int i=getSlot(key);;i=(i+1)&(mCapacity-1))
+		{
+			if(mTable[i] == key) return true;
+			if(mTable[i] == 0) return false;
+		}
+	};
+
+	int size() const
+	{
+		return mNumNames + (mHasEmpty ? 1 : 0);
+	};
+
+	void clear()
+	{
+		memset(mTable,0,mCapacity*sizeof(uint64));
+		mNumNames = 0;
+		mHasEmpty = false;
+	};
+
+private:
+	/** the first PATCH_NAME_LENGTH bytes zero padded, like in the .SND files*/
+	static uint64 pack(const char* name)
+	{
+		uint8_t bytes[PATCH_NAME_LENGTH];
+		memset(bytes,0,PATCH_NAME_LENGTH);
+		for(int i=0;i<PATCH_NAME_LENGTH && name[i] != 0;i++)
+		{
+			bytes[i] = (uint8_t)name[i];
+		}
+		uint64 key;
+		memcpy(&key,bytes,PATCH_NAME_LENGTH);
+		return key;
+	};
+
+	int getSlot(uint64 key) const
+	{
+		key *= literal64bit(0x9e3779b97f4a7c15);
+		return (int)(key >> 32) & (mCapacity-1);
+	};
+
+	bool insert(uint64 key)
+	{
+		for(int i=getSlot(key);;i=(i+1)&(mCapacity-1))
+		{
+			if(mTable[i] == key) return false;
+			if(mTable[i] == 0)
+			{
+				mTable[i] = key;
+				mNumNames++;
+				return true;
+			}
+		}
+	};
+
+	void grow()
+	{
+		HeapBlock<uint64> old;
+		old.swapWith(mTable);
+		const int oldCapacity = mCapacity;
+
+		mCapacity *= 2;
+		mTable.calloc(mCapacity);
+		mNumNames = 0;
+		for(int i=0;i<oldCapacity;i++)
+		{
+			if(old[i] != 0) insert(old[i]);
+		}
+	};
+
+	HeapBlock<uint64> mTable;
+	int mCapacity;	// a power of 2, at most half of it is used
+	int mNumNames;
+	bool mHasEmpty;
+};
+//---------------------------------------------------------------------------
 class NameGenerator
 {
 public:
-	NameGenerator()
+	NameGenerator() : mPool(SystemStats::getNumCpus())
 	{
+		mOrder = MARKOV_DEFAULT_ORDER;
 
 		/*
 		//pMarkov = new MarkovNameGenerator(markovNames,2,4,8);
@@ -186,58 +322,106 @@ public:
 			jassertfalse;
 		*/
 
-		File input(File::getCurrentWorkingDirectory().getFullPathName() + String("/resources/3wordNamelist.txt"));
-		input.readLines(m3Letters);
-		m3Letters.removeDuplicates(true);
+		static_jassert(MARKOV_MAX_NAME_LENGTH == PATCH_NAME_LENGTH);
 
-		
-		for(int i=0;i<m3Letters.size();i++)
-		{
-			
-			m3Letters.set(i,m3Letters[i].removeCharacters(String("!\"#$%&'()*+,/[]\\^_`:;<=>? " )));
+		//the model is shared and only loaded by the first generateName()
+	};
+	~NameGenerator()
+	{
+	}
 
-		}
+	/** the letters of context of the Markov names, 1 to MARKOV_MAX_ORDER. the model is
+		shared, so every generator can use its own naming style*/
+	void setOrder(int order)
+	{
+		jassert(order >= 1 && order <= MARKOV_MAX_ORDER);
+		mOrder = order;
+	}
 
-		
+	int getOrder() const
+	{
+		return mOrder;
+	}
 
-		
-		
-	};
-	~NameGenerator()
+	/** writes count names of NAME_SIZE bytes each into names. none of them is in taken or
+		used twice, and all of them are added to taken. big batches are split into shards
+		that are generated in parallel, the result only depends on the random*/
+	void generateNames(int count, PatchNameSet& taken, FastRandom& random, char* names)
 	{
+		if(count <= 0) return;
+
+		//every shard gets its own stream, so the scheduling doesn't change the names
+		const uint64 seed = ((uint64)random.next() << 32) | random.next();
+		const int numShards = jmin(SystemStats::getNumCpus(),(count+NAME_SHARD_SIZE-1)/NAME_SHARD_SIZE);
+		if(numShards <= 1)
+		{
+			generateShard(FastRandom(seed,0),taken,names,count);
+		}
+		else
+		{
+			//the shards only read taken, it is filled below
+			OwnedArray<NameShardJob> jobs;
+			for(int s=0;s<numShards;s++)
+			{
+				const int begin = (int)((int64)count*s/numShards);
+				const int end = (int)((int64)count*(s+1)/numShards);
+				NameShardJob* job = new NameShardJob(*this,taken,seed,s,names+begin*NAME_SIZE,end-begin);
+				jobs.add(job);
+				mPool.addJob(job);
+			}
+			for(int s=0;s<jobs.size();s++)
+			{
+				mPool.waitForJobToFinish(jobs[s],-1);
+			}
+		}
+
+		//the shards can't see each other, a name two of them picked is generated again
+		FastRandom retry(seed,numShards);
+		for(int i=0;i<count;i++)
+		{
+			char* name = names + i*NAME_SIZE;
+			for(int attempt=0;!taken.add(name);attempt++)
+			{
+				if(attempt < NAME_ATTEMPTS)	generateName(retry,name);
+				else						numberName(name,attempt-NAME_ATTEMPTS+2);
+			}
+		}
 	}
 
-	String generateName()
+	/** writes a 0 terminated name of at most PATCH_NAME_LENGTH characters into name,
+		which has to hold PATCH_NAME_LENGTH+1 bytes. nothing is allocated*/
+	void generateName(FastRandom& random, char* name)
 	{
-		String name;
-		String name2;
-		switch(rand()%3)
+		char name2[PATCH_NAME_LENGTH+1];
+		int length;
+		int length2;
+		const NameModel& model = NameModel::get();
+		const Markov& markovGenerator = model.getMarkov();
+		switch(random.nextInt(3))
 		{
 		case 0: //3 letter word + 5
-			name = m3Letters[rand()%m3Letters.size()];
-			name2 = markovGenerator.generateName(3,5);
+			length = Markov::appendText(name,0,model.getNum3Letters() > 0 ? model.get3Letters(random.nextInt(model.getNum3Letters())) : "",PATCH_NAME_LENGTH);
+			length2 = markovGenerator.generateName(mOrder,3,5,random,name2);
 
-			if(name.length()+name2.length() < 8)
+			if(length+length2 < 8)
 			{
-				name.append(" ",1);
+				length = Markov::appendText(name,length," ",1);
 			}
-			name.append(name2,5);
-			return String(name);
+			Markov::appendText(name,length,name2,5);
 			break;
 		case 1: // 8 letter word
-			return markovGenerator.generateName(3,8);
+			markovGenerator.generateName(mOrder,3,8,random,name);
 			break;
 
 		default:
 		case 2: // 4+4
-			name = markovGenerator.generateName(3,4);
-			name2 = markovGenerator.generateName(3,4);
-			if(name.length()+name2.length() < 8)
+			length = markovGenerator.generateName(mOrder,3,4,random,name);
+			length2 = markovGenerator.generateName(mOrder,3,4,random,name2);
+			if(length+length2 < 8)
 			{
-				name.append(" ",1);
+				length = Markov::appendText(name,length," ",1);
 			}
-			name.append(name2,4);
-			return String(name);
+			Markov::appendText(name,length,name2,4);
 			break;
 		}
 		
@@ -351,8 +535,72 @@ public:
 		*/
 	}
 private:
+	/** generates the names of one shard of a batch on a pool thread*/
+	class NameShardJob : public ThreadPoolJob
+	{
+	public:
+		NameShardJob(NameGenerator& generator, const PatchNameSet& taken, uint64 seed, int shard, char* names, int count)
+		: ThreadPoolJob("names"),
+		mGenerator(generator),
+		mTaken(taken),
+		mSeed(seed),
+		mShard(shard),
+		mNames(names),
+		mCount(count)
+		{
+		};
+
+		JobStatus runJob()
+		{
+			mGenerator.generateShard(FastRandom(mSeed,mShard),mTaken,mNames,mCount);
+			return jobHasFinished;
+		};
+
+	private:
+		NameGenerator& mGenerator;
+		const PatchNameSet& mTaken;
+		const uint64 mSeed;
+		const int mShard;
+		char* mNames;
+		const int mCount;
+	};
+
+	/** names that are not taken and unique within the shard, as far as NAME_ATTEMPTS tries get.
+		taken is only read, several shards can run at once*/
+	void generateShard(FastRandom random, const PatchNameSet& taken, char* names, int count)
+	{
+		PatchNameSet shard(count);
+		for(int i=0;i<count;i++)
+		{
+			char* name = names + i*NAME_SIZE;
+			for(int attempt=0;attempt<NAME_ATTEMPTS;attempt++)
+			{
+				generateName(random,name);
+				if(!taken.contains(name) && shard.add(name)) break;
+			}
+		}
+	}
+
+	/** the name with a number at its end, cut so it still fits*/
+	static void numberName(char* name, int number)
+	{
+		char digits[12];
+		int numDigits = 0;
+		for(int n=number;n>0 || numDigits==0;n/=10)
+		{
+			digits[numDigits++] = (char)('0' + n%10);
+		}
+
+		int length = jmin((int)strlen(name),PATCH_NAME_LENGTH-numDigits);
+		while(numDigits > 0)
+		{
+			name[length++] = digits[--numDigits];
+		}
+		name[length] = 0;
+	}
+
 	//ScopedPointer<MarkovNameGenerator> pMarkov;
-	Markov markovGenerator;
-	StringArray m3Letters;
+	int mOrder;
+	ThreadPool mPool;		// runs the shards of big batches
 	
 };
\ No newline at end of file
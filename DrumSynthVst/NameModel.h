@@ -0,0 +1,138 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Patch.h"
+#include "./MarkovName/Markov.h"
+#include "./TextTokenizer.h"
+#include "./Source/EmbeddedResources.h"
+#include "./StartupProfiler.h"
+
+//---------------------------------------------------------------------------
+/** The trained name model, the Markov chain and the 3 letter words, shared by
+	every NameGenerator.
+
+	The first getInstance() starts a thread that loads the model, so creating
+	the app or a generator costs nothing. get() waits until it is loaded. After
+	that the model is never changed, any number of threads can read it at once
+	without locking.
+*/
+class NameModel : public Thread
+{
+public:
+	NameModel() : Thread("NameModel"), mLoaded(true)
+	{
+		mNum3Letters = 0;
+		mReady.set(0);
+		startThread();
+	};
+
+	~NameModel()
+	{
+		//learning can't be interrupted, it has to finish before the model goes
+		stopThread(-1);
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (NameModel, false)
+
+	/** the shared model, waits on the first calls until it is loaded*/
+	static const NameModel& get()
+	{
+		NameModel* model = getInstance();
+		if(!model->isReady())
+		{
+			model->mLoaded.wait(-1);
+		}
+		return *model;
+	};
+
+	bool isReady() const
+	{
+		return mReady.get() != 0;
+	};
+
+	const Markov& getMarkov() const
+	{
+		return *mMarkov;
+	};
+
+	int getNum3Letters() const
+	{
+		return mNum3Letters;
+	};
+
+	/** 0 terminated, at most PATCH_NAME_LENGTH characters*/
+	const char* get3Letters(int index) const
+	{
+		return (const char*)m3Letters.getData() + index*(PATCH_NAME_LENGTH+1);
+	};
+
+	void run()
+	{
+		const ScopedStartupPhase startupPhase(STARTUP_NAME_MODEL);
+		//both are compiled into the editor, the model is used in place
+		mMarkov = new Markov(EmbeddedResources::namelist_smm,EmbeddedResources::namelist_smmSize);
+
+		//a word per line, blank lines and words that are repeated in any case are dropped
+		Array<TextToken> lines;
+		TextTokenizer(EmbeddedResources::_3wordNamelist_txt,EmbeddedResources::_3wordNamelist_txtSize,TEXT_LINE_SEPARATORS).getTokens(lines);
+		Array<TextToken> words;
+		for(int i=0;i<lines.size();i++)
+		{
+			const TextToken& line = lines.getReference(i);
+			bool keep = !line.isBlank();
+			for(int j=0;j<words.size() && keep;j++)
+			{
+				keep = !words.getReference(j).equalsIgnoreCase(line);
+			}
+			if(keep) words.add(line);
+		}
+
+		//kept as fixed size 0 terminated entries, so generating names does not touch any String
+		const CharacterTable punctuation(CharacterTable().remove("!\"#$%&'()*+,/[]\\^_`:;<=>? "));
+		m3Letters.setSize(words.size()*(PATCH_NAME_LENGTH+1),true);
+		for(int i=0;i<words.size();i++)
+		{
+			char* entry = (char*)m3Letters.getData() + i*(PATCH_NAME_LENGTH+1);
+			entry[punctuation.apply(words.getReference(i),entry,PATCH_NAME_LENGTH)] = 0;
+		}
+		mNum3Letters = words.size();
+
+		//publish the model, the event lets everybody through from now on
+		mReady.set(1);
+		mLoaded.signal();
+	};
+
+private:
+	ScopedPointer<Markov> mMarkov;
+	MemoryBlock m3Letters;	// PATCH_NAME_LENGTH+1 bytes per word
+	int mNum3Letters;
+
+	Atomic<int> mReady;
+	WaitableEvent mLoaded;	// manual reset, stays signalled once loaded
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+#define ARENA_BLOCK_OBJECTS		256		// objects per block of an ObjectArena
+
+//---------------------------------------------------------------------------
+/** Objects that live until the next reset(), e.g. the children of one
+	generation.
+
+	The objects are placed in blocks of ARENA_BLOCK_OBJECTS. reset()
+	destroys them all but keeps the blocks, so once the first generation
+	has grown the arena another one of the same size doesn't allocate at
+	all. The objects never move, the pointers create() returns stay valid
+	until reset(). Not thread safe, every breeding thread has its own.
+*/
+template <class ObjectType>
+class ObjectArena
+{
+public:
+	ObjectArena() : mNumObjects(0)
+	{
+	};
+
+	~ObjectArena()
+	{
+		reset();
+	};
+
+	/** a default constructed object*/
+	ObjectType* create()
+	{
+		return new (allocate()) ObjectType();
+	};
+
+	/** a copy of other*/
+	ObjectType* create(const ObjectType& other)
+	{
+		return new (allocate()) ObjectType(other);
+	};
+
+	/** destroys the object created last, e.g. a child that was thrown away. Its place is used again*/
+	void removeLast()
+	{
+		jassert(mNumObjects > 0);
+		--mNumObjects;
+		getObject(mNumObjects)->~ObjectType();
+	};
+
+	/** destroys all objects, the memory is kept for the next ones*/
+	void reset()
+	{
+		while(mNumObjects > 0) removeLast();
+	};
+
+	int getNumObjects() const
+	{
+		return mNumObjects;
+	};
+
+	int getNumBlocks() const
+	{
+		return mBlocks.size();
+	};
+
+private:
+	void* allocate()
+	{
+		if(mNumObjects == mBlocks.size()*ARENA_BLOCK_OBJECTS)
+		{
+			mBlocks.add(new HeapBlock<ObjectType>(ARENA_BLOCK_OBJECTS));
+		}
+		return getObject(mNumObjects++);
+	};
+
+	ObjectType* getObject(int index) const
+	{
+		return mBlocks.getUnchecked(index/ARENA_BLOCK_OBJECTS)->getData() + index%ARENA_BLOCK_OBJECTS;
+	};
+
+	OwnedArray<HeapBlock<ObjectType> > mBlocks;	// the memory, nothing is constructed by the HeapBlocks
+	int mNumObjects;
+};
+//---------------------------------------------------------------------------
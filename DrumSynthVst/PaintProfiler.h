@@ -0,0 +1,316 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Trace.h"
+#include "./Telemetry.h"
+
+#define PAINT_PROFILER_REFRESH_MS	500
+#define PAINT_PROFILER_ROWS			12	// the most expensive components shown by the overlay
+
+//---------------------------------------------------------------------------
+/** Times every Component::paint() call while it is enabled.
+
+	A frame starts when a window on the desktop is painted, its children
+	follow. For each component the paint time and the number of calls are
+	summed up, together with the most expensive frame. Everything runs on
+	the message thread.
+
+	While a trace is recorded every paint() call also goes into the Tracer,
+	as a scope named after the class of the component, and while the
+	paints are counted their time goes into the Telemetry counters.
+*/
+class PaintProfiler : public Component::PaintTimer
+{
+public:
+	struct Entry
+	{
+		String name;
+		int count;
+		double time;		// ms, since the last reset
+		double frameTime;	// ms in the current frame
+		double worstFrame;
+	};
+
+	PaintProfiler()
+	{
+		mEnabled = false;
+		mTracePaints = false;
+		mCountPaints = false;
+		mNumFrames = 0;
+	};
+
+	~PaintProfiler()
+	{
+		setEnabled(false);
+		setTracePaints(false);
+		setCountPaints(false);
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (PaintProfiler, false)
+
+	/** starts timing from scratch or stops it*/
+	void setEnabled(bool enabled)
+	{
+		reset();
+		mEnabled = enabled;
+		updatePaintTimer();
+	};
+
+	bool isEnabled() const
+	{
+		return mEnabled;
+	};
+
+	/** the paint calls go into the Tracer while it records, independent of setEnabled()*/
+	void setTracePaints(bool tracePaints)
+	{
+		mTracePaints = tracePaints;
+		updatePaintTimer();
+	};
+
+	/** the frames and the paint time go into the Telemetry counters, independent of setEnabled()*/
+	void setCountPaints(bool countPaints)
+	{
+		mCountPaints = countPaints;
+		updatePaintTimer();
+	};
+
+	void reset()
+	{
+		mEntries.clear();
+		mIndices.clear();
+		mNumFrames = 0;
+	};
+
+	void componentPainted(Component& component, double milliseconds)
+	{
+		if(mTracePaints) tracePaint(component,milliseconds);
+		if(mCountPaints)
+		{
+			if(component.isOnDesktop()) Telemetry::add(TELEMETRY_PAINT_FRAMES,1);
+			Telemetry::add(TELEMETRY_PAINT_MICROSECONDS,roundToInt(milliseconds*1000.0));
+		}
+		if(!mEnabled) return;
+
+		if(component.isOnDesktop())
+		{
+			endFrame();
+		}
+
+		Entry* entry;
+		if(mIndices.contains(&component))
+		{
+			entry = mEntries[mIndices[&component]];
+		}
+		else
+		{
+			entry = new Entry();
+			entry->name = getDescription(component);
+			entry->count = 0;
+			entry->time = 0.0;
+			entry->frameTime = 0.0;
+			entry->worstFrame = 0.0;
+			mIndices.set(&component,mEntries.size());
+			mEntries.add(entry);
+		}
+		entry->count++;
+		entry->time += milliseconds;
+		entry->frameTime += milliseconds;
+	};
+
+	int getNumFrames() const
+	{
+		return mNumFrames;
+	};
+
+	/** the entries ordered by paint time, the most expensive first*/
+	Array<const Entry*> getSortedEntries() const
+	{
+		Array<const Entry*> sorted;
+		EntrySorter sorter;
+		for(int i=0;i<mEntries.size();i++)
+		{
+			sorted.addSorted(sorter,mEntries[i]);
+		}
+		return sorted;
+	};
+
+	/** a text table of all components, for comparing runs*/
+	String getSummary() const
+	{
+		const double frames = jmax(1,mNumFrames);
+		String summary;
+		summary << "paint profile of " << mNumFrames << " frames\n";
+		summary << "ms/frame\tpaints/frame\tworst frame ms\ttotal ms\tcomponent\n";
+
+		const Array<const Entry*> sorted = getSortedEntries();
+		for(int i=0;i<sorted.size();i++)
+		{
+			const Entry* entry = sorted.getUnchecked(i);
+			summary << String(entry->time/frames,3) << "\t" << String(entry->count/frames,2) << "\t"
+				<< String(jmax(entry->worstFrame,entry->frameTime),3) << "\t" << String(entry->time,1) << "\t"
+				<< entry->name << "\n";
+		}
+		return summary;
+	};
+
+private:
+	class EntrySorter
+	{
+	public:
+		static int compareElements(const Entry* first, const Entry* second)
+		{
+			return first->time > second->time ? -1 : (first->time < second->time ? 1 : 0);
+		};
+	};
+
+	class ComponentHash
+	{
+	public:
+		static int generateHash(Component* key, int upperLimit)
+		{
+			return (int)(((pointer_sized_uint)key >> 4) % (pointer_sized_uint)upperLimit);
+		};
+	};
+
+	void updatePaintTimer()
+	{
+		Component::setPaintTimer((mEnabled || mTracePaints || mCountPaints) ? this : 0);
+	};
+
+	/** the paint has just ended. the class name from typeid lives as long as the program*/
+	static void tracePaint(Component& component, double milliseconds)
+	{
+		Tracer* tracer = Tracer::getInstanceWithoutCreating();
+		if(tracer == NULL || !tracer->isRecording()) return;
+
+		const int64 end = Time::getHighResolutionTicks();
+		tracer->add("paint",typeid(component).name(),end - Time::secondsToHighResolutionTicks(milliseconds*0.001),end);
+	};
+
+	void endFrame()
+	{
+		for(int i=0;i<mEntries.size();i++)
+		{
+			Entry* entry = mEntries.getUnchecked(i);
+			entry->worstFrame = jmax(entry->worstFrame,entry->frameTime);
+			entry->frameTime = 0.0;
+		}
+		mNumFrames++;
+	};
+
+	/** the class, the name and the class of the parent*/
+	static String getDescription(Component& component)
+	{
+		String description = getClassName(component);
+		if(component.getName().isNotEmpty())
+		{
+			description << " \"" << component.getName() << "\"";
+		}
+		if(component.getParentComponent() != NULL)
+		{
+			description << " in " << getClassName(*component.getParentComponent());
+		}
+		return description;
+	};
+
+	static String getClassName(Component& component)
+	{
+		return String(typeid(component).name()).replace("class ",String::empty);
+	};
+
+	bool mEnabled;
+	bool mTracePaints;
+	bool mCountPaints;
+	int mNumFrames;
+	OwnedArray<Entry> mEntries;
+	HashMap<Component*,int,ComponentHash> mIndices;
+};
+//---------------------------------------------------------------------------
+/** Shows the most expensive components of the paint profile on top of its parent.
+	The overlay ignores the mouse, its own painting shows up in the profile as well.
+*/
+class PaintProfilerOverlay : public Component,
+							 public Timer
+{
+public:
+	PaintProfilerOverlay()
+	{
+		setInterceptsMouseClicks(false,false);
+		setSize(460,40 + PAINT_PROFILER_ROWS*15);
+	};
+
+	~PaintProfilerOverlay()
+	{
+		stopTimer();
+	};
+
+	void visibilityChanged()
+	{
+		if(isVisible())
+		{
+			startTimer(PAINT_PROFILER_REFRESH_MS);
+		}
+		else
+		{
+			stopTimer();
+		}
+	};
+
+	void timerCallback()
+	{
+		repaint();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colours::black.withAlpha(0.75f));
+		g.setColour(Colours::white);
+		g.setFont(12.f);
+
+		PaintProfiler* profiler = PaintProfiler::getInstance();
+		const double frames = jmax(1,profiler->getNumFrames());
+		g.drawText("ms/frame",6,4,70,14,Justification::right,false);
+		g.drawText("paints",76,4,50,14,Justification::right,false);
+		g.drawText("worst",126,4,50,14,Justification::right,false);
+		g.drawText(String(profiler->getNumFrames()) + " frames",186,4,getWidth()-192,14,Justification::left,false);
+
+		const Array<const PaintProfiler::Entry*> sorted = profiler->getSortedEntries();
+		int y = 22;
+		for(int i=0;i<jmin(PAINT_PROFILER_ROWS,sorted.size());i++)
+		{
+			const PaintProfiler::Entry* entry = sorted.getUnchecked(i);
+			g.drawText(String(entry->time/frames,3),6,y,70,14,Justification::right,false);
+			g.drawText(String(entry->count/frames,1),76,y,50,14,Justification::right,false);
+			g.drawText(String(jmax(entry->worstFrame,entry->frameTime),2),126,y,50,14,Justification::right,false);
+			g.drawText(entry->name,186,y,getWidth()-192,14,Justification::left,true);
+			y += 15;
+		}
+	};
+};
+//---------------------------------------------------------------------------
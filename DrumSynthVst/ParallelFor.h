@@ -0,0 +1,250 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Trace.h"
+#include "./ThreadPriorities.h"
+
+#define PARALLEL_FOR_STOP_TIMEOUT_MS	2000
+
+//---------------------------------------------------------------------------
+/** The work of one ParallelFor::execute() call.
+	run() gets a range of the items and the worker it runs on. A worker only
+	runs one range at a time, so state kept per worker index needs no lock.
+*/
+class ParallelTask
+{
+public:
+	virtual ~ParallelTask() {};
+	/** items begin..end-1, workerIndex is 0..ParallelFor::getNumWorkers()-1*/
+	virtual void run(int begin, int end, int workerIndex) = 0;
+};
+
+//---------------------------------------------------------------------------
+/** Runs a ParallelTask over many small items on threads that are kept
+	between calls, so a batch doesn't pay for starting a ThreadPool.
+
+	The items are split evenly over the workers, the calling thread is
+	worker 0. Each worker takes grainSize items at a time from the front of
+	its own range. A worker whose range is empty steals the back half of
+	another one, so a worker that got the slow items is helped out instead
+	of holding up the batch. execute() returns when every item is done.
+
+	Every range has its own SpinLock, which is only ever contended by a
+	thief, so the workers don't queue on one lock like the jobs of a
+	ThreadPool do.
+
+	One batch runs at a time. A call while a batch is running, from a
+	worker or from another thread, runs its items on the calling thread.
+*/
+class ParallelFor
+{
+public:
+	ParallelFor()
+	{
+		mTask = NULL;
+		mGrainSize = 1;
+		mNumActive = 0;
+		const int numWorkers = jmax(1,SystemStats::getNumCpus());
+		for(int i=0;i<numWorkers;i++)
+		{
+			mRanges.add(new Range());
+		}
+		//worker 0 is the caller of execute(), the others help whoever that is, the message thread too
+		for(int i=1;i<numWorkers;i++)
+		{
+			Worker* worker = new Worker(*this,i);
+			mWorkers.add(worker);
+			worker->startThread(PRIORITY_CLASS_UI);
+		}
+	};
+
+	~ParallelFor()
+	{
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			mWorkers[i]->signalThreadShouldExit();
+			mWorkers[i]->notify();
+		}
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			mWorkers[i]->stopThread(PARALLEL_FOR_STOP_TIMEOUT_MS);
+		}
+		mWorkers.clear();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (ParallelFor, false)
+
+	/** the calling thread plus the pool threads, one per core*/
+	int getNumWorkers() const
+	{
+		return mRanges.size();
+	};
+
+	/** runs task over the items 0..numItems-1 and waits until all are done.
+		grainSize items are taken at once, big enough that taking them costs
+		little next to running them*/
+	void execute(int numItems, int grainSize, ParallelTask& task)
+	{
+		if(numItems <= 0) return;
+		grainSize = jmax(1,grainSize);
+
+		const int numActive = jmin(getNumWorkers(),(numItems+grainSize-1)/grainSize);
+		if(numActive < 2 || !mBusy.compareAndSetBool(1,0))
+		{
+			task.run(0,numItems,0);
+			return;
+		}
+
+		mTask = &task;
+		mGrainSize = grainSize;
+		mNumActive = numActive;
+		for(int i=0;i<numActive;i++)
+		{
+			Range* range = mRanges.getUnchecked(i);
+			const SpinLock::ScopedLockType lock(range->lock);
+			range->begin = (int)((int64)numItems*i/numActive);
+			range->end = (int)((int64)numItems*(i+1)/numActive);
+		}
+
+		mNumRunning.set(numActive);
+		for(int i=1;i<numActive;i++)
+		{
+			mWorkers.getUnchecked(i-1)->notify();
+		}
+		work(0);
+		if(--mNumRunning != 0)
+		{
+			mDone.wait(-1);
+		}
+
+		mTask = NULL;
+		mBusy.set(0);
+	};
+
+private:
+	/** the items a worker hasn't started yet*/
+	struct Range
+	{
+		Range() : begin(0), end(0) {};
+
+		SpinLock lock;
+		int begin;
+		int end;
+		char padding[64];	// keeps the locks of two workers off the same cache line
+	};
+
+	class Worker : public Thread
+	{
+	public:
+		Worker(ParallelFor& owner, int index)
+		: Thread("parallel for"),
+		mOwner(owner),
+		mIndex(index)
+		{
+		};
+
+		void run()
+		{
+			for(;;)
+			{
+				wait(-1);
+				if(threadShouldExit()) return;
+				mOwner.work(mIndex);
+				if(--mOwner.mNumRunning == 0)
+				{
+					mOwner.mDone.signal();
+				}
+			}
+		};
+
+	private:
+		ParallelFor& mOwner;
+		const int mIndex;
+	};
+
+	/** runs the own range, then steals until no range has items left*/
+	void work(int index)
+	{
+		TRACE_SCOPE("parallel for","work");
+		Range& own = *mRanges.getUnchecked(index);
+		for(;;)
+		{
+			int begin, end;
+			{
+				const SpinLock::ScopedLockType lock(own.lock);
+				begin = own.begin;
+				end = jmin(own.end,begin+mGrainSize);
+				own.begin = end;
+			}
+			if(begin < end)
+			{
+				mTask->run(begin,end,index);
+			}
+			else if(!steal(index))
+			{
+				return;
+			}
+		}
+	};
+
+	/** moves the back half of another range into the own one.
+		The items are never in two ranges, so a worker that finds nothing can stop*/
+	bool steal(int index)
+	{
+		for(int i=1;i<mNumActive;i++)
+		{
+			Range& victim = *mRanges.getUnchecked((index+i)%mNumActive);
+			int begin, end;
+			{
+				const SpinLock::ScopedLockType lock(victim.lock);
+				end = victim.end;
+				begin = victim.begin + (victim.end-victim.begin)/2;
+				victim.end = begin;
+			}
+			if(begin < end)
+			{
+				Range& own = *mRanges.getUnchecked(index);
+				const SpinLock::ScopedLockType lock(own.lock);
+				own.begin = begin;
+				own.end = end;
+				return true;
+			}
+		}
+		return false;
+	};
+
+	OwnedArray<Range> mRanges;		// one per worker
+	OwnedArray<Worker> mWorkers;	// the workers 1..getNumWorkers()-1
+	ParallelTask* mTask;			// of the running batch
+	int mGrainSize;
+	int mNumActive;					// workers that got items in this batch
+	Atomic<int> mBusy;				// 1 while a batch runs
+	Atomic<int> mNumRunning;		// workers that haven't finished the batch
+	WaitableEvent mDone;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,179 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/menuText.h"
+#include "./drumSynthSource/menuPages.h"
+#include "./Library/PatchLineage.h"
+
+#define LOCK_NUM_CATEGORIES		((int)(sizeof(catNames)/sizeof(catNames[0])))
+#define LOCK_FIRST_UNBRED		END_OF_SOUND_PARAMETERS	// from here on nothing is bred, the globals like PAR_BPM included
+
+//---------------------------------------------------------------------------
+/** Which parameters the generator may breed, by the categories of
+	valueNames (CAT_OSC, CAT_FILTER, CAT_LFO...).
+
+	The category of a parameter is taken from the first menu page that
+	shows it, parameters without a page are in CAT_EMPTY. The mask of every
+	category is built once by the constructor, locking or unlocking a
+	category only ORs the masks of the unlocked ones together, and the
+	unlocked parameters are listed for the mutation. Everything from
+	LOCK_FIRST_UNBRED on, the globals PAR_BPM and PAR_MIDI_CHAN_* among
+	them, is always locked. Bit i of a mask is parameter i, like the mother
+	mask of the Crossover.
+*/
+class ParameterLocks
+{
+public:
+	ParameterLocks() : mNumUnlocked(0)
+	{
+		memset(mCategoryMasks,0,sizeof(mCategoryMasks));
+		memset(mLocked,0,sizeof(mLocked));
+
+		int categories[NUM_PARAMS];
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			categories[i] = -1;
+		}
+		for(int page=0;page<NUM_PAGES;page++)
+		{
+			for(int subPage=0;subPage<NUM_SUB_PAGES;subPage++)
+			{
+				const Page& menu = menuPages[page][subPage];
+				for(int i=0;i<8;i++)
+				{
+					const uint8_t text = *(&menu.top1 + i);
+					const uint8_t parameterNr = *(&menu.bot1 + i);
+					if(text == TEXT_EMPTY || parameterNr >= NUM_PARAMS || categories[parameterNr] >= 0) continue;
+					categories[parameterNr] = valueNames[text].category;
+				}
+			}
+		}
+
+		for(int i=0;i<LOCK_FIRST_UNBRED;i++)
+		{
+			const int category = categories[i] >= 0 && categories[i] < LOCK_NUM_CATEGORIES ? categories[i] : CAT_EMPTY;
+			mCategoryMasks[category][i>>3] |= (uint8_t)(1<<(i&7));
+		}
+		update();
+	};
+
+	/** only while the generator isn't breeding*/
+	void setCategoryLocked(int category, bool locked)
+	{
+		jassert(category >= 0 && category < LOCK_NUM_CATEGORIES);
+		mLocked[category] = locked;
+		update();
+	};
+
+	bool isCategoryLocked(int category) const
+	{
+		return mLocked[category];
+	};
+
+	void unlockAll()
+	{
+		memset(mLocked,0,sizeof(mLocked));
+		update();
+	};
+
+	/** PARAMETER_MASK_SIZE bytes, a set bit may be bred*/
+	const uint8_t* getUnlockedMask() const
+	{
+		return mUnlockedMask;
+	};
+
+	/** the parameters of a category, PARAMETER_MASK_SIZE bytes*/
+	const uint8_t* getCategoryMask(int category) const
+	{
+		return mCategoryMasks[category];
+	};
+
+	bool isUnlocked(int parameterNr) const
+	{
+		return (mUnlockedMask[parameterNr>>3]>>(parameterNr&7)) & 1;
+	};
+
+	int getNumUnlocked() const
+	{
+		return mNumUnlocked;
+	};
+
+	/** the unlocked parameters in ascending order*/
+	const uint8_t* getUnlockedParameters() const
+	{
+		return mUnlockedParameters;
+	};
+
+	/** mask[i] &= unlocked[i], what stays set may be bred*/
+	void applyTo(uint8_t* mask) const
+	{
+		for(int i=0;i<PARAMETER_MASK_SIZE;i++)
+		{
+			mask[i] &= mUnlockedMask[i];
+		}
+	};
+
+	/** a category by its name in catNames, case, spaces and dots don't matter. -1 if there is none*/
+	static int findCategory(const String& name)
+	{
+		const String wanted = name.removeCharacters(" ./").toLowerCase();
+		for(int i=1;i<LOCK_NUM_CATEGORIES;i++)
+		{
+			if(wanted == String(catNames[i]).removeCharacters(" ./").toLowerCase()) return i;
+		}
+		return -1;
+	};
+
+private:
+	void update()
+	{
+		memset(mUnlockedMask,0,PARAMETER_MASK_SIZE);
+		for(int category=0;category<LOCK_NUM_CATEGORIES;category++)
+		{
+			if(mLocked[category]) continue;
+			for(int i=0;i<PARAMETER_MASK_SIZE;i++)
+			{
+				mUnlockedMask[i] |= mCategoryMasks[category][i];
+			}
+		}
+
+		mNumUnlocked = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(isUnlocked(i)) mUnlockedParameters[mNumUnlocked++] = (uint8_t)i;
+		}
+	};
+
+	uint8_t mCategoryMasks[LOCK_NUM_CATEGORIES][PARAMETER_MASK_SIZE];
+	uint8_t mUnlockedMask[PARAMETER_MASK_SIZE];
+	uint8_t mUnlockedParameters[NUM_PARAMS];
+	int mNumUnlocked;
+	bool mLocked[LOCK_NUM_CATEGORIES];
+};
+//---------------------------------------------------------------------------
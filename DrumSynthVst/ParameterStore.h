@@ -0,0 +1,486 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./controllerAssignments.h"
+#include "./parameterLocations.h"
+#include "./Patch.h"
+#include "./Midi/MidiTransmitter.h"
+#include "./Midi/MidiOutputRouter.h"
+#include "./MessageBatch.h"
+#include "./ParameterUndoLog.h"
+#include "./ThreadPriorities.h"
+
+#define NUM_DIRTY_WORDS ((NUM_PARAMS+31)/32)
+#define PARAMETER_FRAME_MS		16	// the listeners are updated at most once per frame
+
+// every voice is one listener group, parameters without a voice control are global
+#define GROUP_VOICE(voiceNr)	(1<<(voiceNr))
+#define GROUP_GLOBAL			(1<<NUM_VOICES)
+#define GROUP_ALL				(GROUP_GLOBAL|(GROUP_GLOBAL-1))
+
+//---------------------------------------------------------------------------
+/** The one place the parameter values of the edited sound live.
+
+	Values are stored like the synth sends and receives them (0-127, PM63
+	values offset by 63), which is also the byte layout of the .SND files.
+	Widgets write with setValue(), the MIDI thread with setValueFromMidi()
+	which never blocks, whole patches go through loadFromPatch() and
+	storeToPatch().
+
+	The audio thread of the preview can't wait for a lock, it copies the values
+	with copyValues() whenever getVersion() has changed.
+
+	Edits are sent to the synth by the MidiOutputRouter, unless an EditTarget
+	is set. The plugin sets one to put them into its own MIDI output.
+	setValue() and loadFromPatch() are recorded in the ParameterUndoLog,
+	undo() and redo() only send the values of the group they step over.
+
+	Every change sets a bit in the dirty bitset. The listeners are called on
+	the message thread (through the MessageBatch, so the MIDI thread shares
+	one message with the other background updates), at most once per
+	PARAMETER_FRAME_MS, and only if one of their groups contains a changed
+	parameter. A burst of MIDI or a bulk load is therefore shown in one
+	pass, and the widgets it repaints are painted together in the next
+	paint of the window.
+*/
+class ParameterStore : public BatchedAsyncUpdater, private Timer
+{
+public:
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** called on the message thread for every changed parameter in the listeners groups*/
+		virtual void parameterChanged(int parameterNr, int value) = 0;
+	};
+
+	/** gets every value that is stored, e.g. to keep the session on disk*/
+	class Journal
+	{
+	public:
+		virtual ~Journal() {};
+		/** called on the thread that stored the value, the MIDI thread too, so it mustn't block*/
+		virtual void valueStored(int parameterNr, int value) = 0;
+	};
+
+	/** receives the edits that would otherwise go to the MidiTransmitter*/
+	class EditTarget
+	{
+	public:
+		virtual ~EditTarget() {};
+		/** called on the message thread, right when the value is set*/
+		virtual void parameterEdited(int parameterNr, int value) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	ParameterStore()
+	{
+		memset(mValues,0,NUM_PARAMS);
+		for(int i=0;i<NUM_DIRTY_WORDS;i++)
+		{
+			mDirty[i].set(0);
+		}
+		initGroups();
+		mLastUpdate = 0;
+		mEditTarget = NULL;
+		mJournal = NULL;
+		mUndoRecords.ensureStorageAllocated(NUM_PARAMS);
+	};
+
+	~ParameterStore()
+	{
+		cancelPendingUpdate();
+		stopTimer();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (ParameterStore, false)
+
+	/** groupMask is a combination of GROUP_VOICE() and GROUP_GLOBAL*/
+	void addListener(Listener* listener, int groupMask = GROUP_ALL)
+	{
+		jassert(!mListeners.contains(listener));
+		mListeners.add(listener);
+		mListenerGroups.add(groupMask);
+	};
+
+	void removeListener(Listener* listener)
+	{
+		const int index = mListeners.indexOf(listener);
+		if(index < 0) return;
+		mListeners.remove(index);
+		mListenerGroups.remove(index);
+	};
+
+	/** NULL sends the edits with the MidiTransmitter again. Message thread only*/
+	void setEditTarget(EditTarget* target)
+	{
+		mEditTarget = target;
+	};
+
+	EditTarget* getEditTarget()
+	{
+		return mEditTarget;
+	};
+
+	/** NULL to stop reporting. Only while no MIDI arrives, the MIDI thread reads it without a lock*/
+	void setJournal(Journal* journal)
+	{
+		mJournal = journal;
+	};
+
+	int getValue(int parameterNr)
+	{
+		jassert(parameterNr >= 0 && parameterNr < NUM_PARAMS);
+		return mValues[parameterNr];
+	};
+
+	/** all NUM_PARAMS values in one block*/
+	const uint8_t* getValues()
+	{
+		return mValues;
+	};
+
+	/** counts every change of a value, from any thread*/
+	int getVersion()
+	{
+		return mVersion.get();
+	};
+
+	/** copies all NUM_PARAMS values without locking and returns the version they are at least as new as.
+		A change that arrives during the copy raises the version again, so the next call picks it up*/
+	int copyValues(uint8_t* dest)
+	{
+		const int version = mVersion.get();
+		memcpy(dest,mValues,NUM_PARAMS);
+		return version;
+	};
+
+	/** the group that shows a parameter*/
+	int getGroups(int parameterNr)
+	{
+		return mGroups[parameterNr];
+	};
+
+	/** set a value edited in the UI and send it to the synth. Message thread only*/
+	void setValue(int parameterNr, int value)
+	{
+		if(parameterNr < 0 || parameterNr >= NUM_PARAMS) return;
+
+		mUndo.record(parameterNr,mValues[parameterNr],value);
+		applyEdit(parameterNr,value,PRIORITY_INTERACTIVE);
+	};
+
+	/** set the values of one UI gesture, e.g. a control edited on several voices, and send them
+		to the synth as one burst. They are undone in one step. Message thread only*/
+	void setValueGroup(const int* parameterNrs, const int* values, int num)
+	{
+		mUndo.beginGroup();
+		for(int i=0;i<num;i++)
+		{
+			const int parameterNr = parameterNrs[i];
+			if(parameterNr < 0 || parameterNr >= NUM_PARAMS) continue;
+			mUndo.record(parameterNr,mValues[parameterNr],values[i]);
+		}
+		mUndo.endGroup();
+		setValueBurst(parameterNrs,values,num);
+	};
+
+	/** sets the values of one step of a gesture and sends them as one burst, e.g. a macro move.
+		Nothing is recorded in the undo log, the caller records the whole change. Message thread only*/
+	void setValueBurst(const int* parameterNrs, const int* values, int num)
+	{
+		for(int i=0;i<num;i++)
+		{
+			const int parameterNr = parameterNrs[i];
+			if(parameterNr < 0 || parameterNr >= NUM_PARAMS) continue;
+
+			storeValue(parameterNr,values[i]);
+			if(mEditTarget != NULL) mEditTarget->parameterEdited(parameterNr,values[i]);
+		}
+		UserActivity::edited();
+		if(mEditTarget == NULL) MidiOutputRouter::getInstance()->sendParameterBurst(parameterNrs,values,num);
+	};
+
+	/** sets and sends the values [start:end) that differ from the store, e.g. the steps of a morph.
+		Nothing is recorded in the undo log, the caller records the whole change.
+		returns the number of changed values. Message thread only*/
+	int setValues(const uint8_t* values, int start, int end, int priority)
+	{
+		int numChanged = 0;
+		for(int i=jmax(0,start);i<jmin(end,(int)NUM_PARAMS);i++)
+		{
+			if(mValues[i] == values[i]) continue;
+			applyEdit(i,values[i],priority);
+			numChanged++;
+		}
+		return numChanged;
+	};
+
+	/** the edits until endUndoGroup() are undone in one step, e.g. a knob drag*/
+	void beginUndoGroup()
+	{
+		mUndo.beginGroup();
+	};
+
+	void endUndoGroup()
+	{
+		mUndo.endGroup();
+	};
+
+	bool canUndo() const
+	{
+		return mUndo.canUndo();
+	};
+
+	bool canRedo() const
+	{
+		return mUndo.canRedo();
+	};
+
+	/** restores the values before the last group of edits. Message thread only*/
+	bool undo()
+	{
+		if(!mUndo.takeUndo(mUndoRecords)) return false;
+
+		const int priority = mUndoRecords.size() > 1 ? PRIORITY_BULK : PRIORITY_INTERACTIVE;
+		for(int i=0;i<mUndoRecords.size();i++)
+		{
+			const ParameterUndoRecord& r = mUndoRecords.getReference(i);
+			applyEdit(r.getParameterNr(),r.oldValue,priority);
+		}
+		return true;
+	};
+
+	/** sets the values of the last undone group again. Message thread only*/
+	bool redo()
+	{
+		if(!mUndo.takeRedo(mUndoRecords)) return false;
+
+		const int priority = mUndoRecords.size() > 1 ? PRIORITY_BULK : PRIORITY_INTERACTIVE;
+		for(int i=0;i<mUndoRecords.size();i++)
+		{
+			const ParameterUndoRecord& r = mUndoRecords.getReference(i);
+			applyEdit(r.getParameterNr(),r.newValue,priority);
+		}
+		return true;
+	};
+
+	/** e.g. to change the size of the history*/
+	ParameterUndoLog& getUndoLog()
+	{
+		return mUndo;
+	};
+
+	/** store a value received from the synth. Safe to call from the MIDI thread*/
+	void setValueFromMidi(int parameterNr, int value)
+	{
+		if(parameterNr < 0 || parameterNr >= NUM_PARAMS) return;
+
+		mValues[parameterNr] = (uint8_t)value;
+		setDirty(parameterNr);
+		if(mJournal != NULL) mJournal->valueStored(parameterNr,value);
+		triggerAsyncUpdate();
+	};
+
+	/** copy a patch into the store. Only the values that differ are marked dirty.
+		If transmit is true the MidiTransmitter sends what differs from the synth's
+		state, an EditTarget gets the values that differ from the store.
+		dump is the SysEx frame of the patch if it was built ahead.
+		returns the number of changed values*/
+	int loadFromPatch(Patch* patch, bool transmit, const MidiMessage* dump = NULL)
+	{
+		int numChanged = 0;
+		mUndo.beginGroup();
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			const uint8_t value = (uint8_t)patch->getParameter(i);
+			if(mValues[i] == value) continue;
+
+			mUndo.record(i,mValues[i],value);
+			mValues[i] = value;
+			setDirty(i);
+			if(mJournal != NULL) mJournal->valueStored(i,value);
+			if(transmit && mEditTarget != NULL) mEditTarget->parameterEdited(i,value);
+			numChanged++;
+		}
+		mUndo.endGroup();
+		//the synth may differ from the store, e.g. after changing the output
+		if(transmit && mEditTarget == NULL) MidiOutputRouter::getInstance()->sendPatch(patch,dump);
+		if(numChanged > 0)
+		{
+			triggerAsyncUpdate();
+		}
+		return numChanged;
+	};
+
+	/** copy the current values into a patch*/
+	void storeToPatch(Patch* patch)
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			patch->setParameter(i,mValues[i]);
+		}
+	};
+
+	/** returns the number of values that differ from a patch*/
+	int countDifferences(Patch* patch)
+	{
+		int num = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			if(mValues[i] != (uint8_t)patch->getParameter(i)) num++;
+		}
+		return num;
+	};
+
+	void handleAsyncUpdate()
+	{
+		TRACE_SCOPE("message","parameter updates");
+		//a timer is already waiting for the end of the frame
+		if(isTimerRunning()) return;
+
+		const uint32 elapsed = Time::getMillisecondCounter() - mLastUpdate;
+		if(elapsed < PARAMETER_FRAME_MS)
+		{
+			startTimer(PARAMETER_FRAME_MS - (int)elapsed);
+			return;
+		}
+		updateListeners();
+	};
+
+private:
+	/** stores a value and sends it to the synth, the background pauses for a moment*/
+	void applyEdit(int parameterNr, int value, int priority)
+	{
+		UserActivity::edited();
+		storeValue(parameterNr,value);
+		//always send, the synth might not have the value we think it has
+		if(mEditTarget != NULL) mEditTarget->parameterEdited(parameterNr,value);
+		else MidiOutputRouter::getInstance()->sendParameter(parameterNr,value,priority);
+	};
+
+	void storeValue(int parameterNr, int value)
+	{
+		if(mValues[parameterNr] == (uint8_t)value) return;
+
+		mValues[parameterNr] = (uint8_t)value;
+		setDirty(parameterNr);
+		if(mJournal != NULL) mJournal->valueStored(parameterNr,value);
+		triggerAsyncUpdate();
+	};
+
+	void timerCallback()
+	{
+		stopTimer();
+		updateListeners();
+	};
+
+	/** calls the listeners for everything that changed since the last update.
+		the widgets are set without notification, so nothing is sent back to the synth*/
+	void updateListeners()
+	{
+		mLastUpdate = Time::getMillisecondCounter();
+
+		//take all bits at once, changes arriving now go into the next update
+		int dirty[NUM_DIRTY_WORDS];
+		int changedGroups = 0;
+		for(int word=0;word<NUM_DIRTY_WORDS;word++)
+		{
+			dirty[word] = mDirty[word].exchange(0);
+			for(int bit=0;dirty[word] != 0 && bit<32;bit++)
+			{
+				if(dirty[word] & (1<<bit)) changedGroups |= mGroups[word*32 + bit];
+			}
+		}
+		if(changedGroups == 0) return;
+
+		for(int l=0;l<mListeners.size();l++)
+		{
+			const int groups = mListenerGroups[l];
+			if((groups & changedGroups) == 0) continue;
+
+			for(int word=0;word<NUM_DIRTY_WORDS;word++)
+			{
+				if(dirty[word] == 0) continue;
+				for(int bit=0;bit<32;bit++)
+				{
+					const int parameterNr = word*32 + bit;
+					if((dirty[word] & (1<<bit)) && (mGroups[parameterNr] & groups))
+					{
+						mListeners[l]->parameterChanged(parameterNr,mValues[parameterNr]);
+					}
+				}
+			}
+		}
+	};
+
+	void initGroups()
+	{
+		//parameterLocations has to be regenerated after changing controllerAssignments
+		jassert(checkParameterLocations());
+		jassert(checkParameterRanges());
+
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			const int voiceNr = parameterLocations[i].voiceNr;
+			mGroups[i] = (voiceNr == NO_VOICE) ? GROUP_GLOBAL : GROUP_VOICE(voiceNr);
+		}
+	};
+
+	void setDirty(int parameterNr)
+	{
+		Atomic<int>& word = mDirty[parameterNr/32];
+		const int mask = 1<<(parameterNr%32);
+		int old;
+		do
+		{
+			old = word.get();
+		} while(!word.compareAndSetBool(old|mask,old));
+		//after the value is written, so a reader that sees the new version sees the value
+		++mVersion;
+	};
+
+private:
+	uint8_t mValues[NUM_PARAMS];
+	Atomic<int> mDirty[NUM_DIRTY_WORDS];
+	Atomic<int> mVersion;
+	uint8_t mGroups[NUM_PARAMS];
+	uint32 mLastUpdate;		// Time::getMillisecondCounter() of the last listener update
+
+	Array<Listener*> mListeners;
+	Array<int> mListenerGroups;
+	EditTarget* mEditTarget;
+	Journal* mJournal;
+
+	ParameterUndoLog mUndo;						// message thread only
+	Array<ParameterUndoRecord> mUndoRecords;	// of the running undo() or redo()
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,203 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./MemoryAccounting.h"
+
+#define UNDO_DEFAULT_SIZE		65536	// bytes of undo history, 4 per record
+#define UNDO_GROUP_START		0x8000	// in parameterNr of the first record of a group
+
+//---------------------------------------------------------------------------
+/** one changed value of an undo group*/
+struct ParameterUndoRecord
+{
+	uint16 parameterNr;		// UNDO_GROUP_START is set on the first record of a group
+	uint8_t oldValue;
+	uint8_t newValue;
+
+	int getParameterNr() const
+	{
+		return parameterNr & ~UNDO_GROUP_START;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** The undo history of the edits, as (parameter, old value, new value)
+	records in a ring buffer of a fixed size.
+
+	The records between beginGroup() and endGroup() are undone in one step,
+	the editor opens a group for a knob drag and for a patch load. Inside a
+	group a change of the parameter the last record is about only updates
+	its new value, so a drag of one knob is one record however long it
+	takes. Every record outside a group is a group of its own.
+
+	When the buffer is full the oldest groups are dropped. A group that is
+	bigger than the whole buffer loses its oldest records, undoing it then
+	goes back to the state after them. A new record drops everything that
+	could be redone. Message thread only.
+*/
+class ParameterUndoLog
+{
+public:
+	ParameterUndoLog(int sizeInBytes = UNDO_DEFAULT_SIZE) : mMemory(MEMORY_UNDO)
+	{
+		setSize(sizeInBytes);
+	};
+
+	/** the history is cleared, a patch load always fits*/
+	void setSize(int sizeInBytes)
+	{
+		mCapacity = jmax(NUM_PARAMS+1,sizeInBytes/(int)sizeof(ParameterUndoRecord));
+		mRecords.malloc(mCapacity);
+		mMemory.setBytes(getSize());
+		clear();
+	};
+
+	int getSize() const
+	{
+		return mCapacity*(int)sizeof(ParameterUndoRecord);
+	};
+
+	void clear()
+	{
+		mBegin = mCursor = mEnd = 0;
+		mGroupDepth = 0;
+		mStartNext = true;
+	};
+
+	/** groups can be nested, the outermost one counts*/
+	void beginGroup()
+	{
+		if(mGroupDepth++ == 0) mStartNext = true;
+	};
+
+	void endGroup()
+	{
+		if(mGroupDepth == 0) return;
+		if(--mGroupDepth == 0) mStartNext = true;
+	};
+
+	void record(int parameterNr, int oldValue, int newValue)
+	{
+		jassert(parameterNr >= 0 && parameterNr < NUM_PARAMS);
+		if(oldValue == newValue) return;
+
+		//the new branch replaces what could be redone
+		mEnd = mCursor;
+
+		if(!mStartNext && mCursor != mBegin)
+		{
+			ParameterUndoRecord& last = at(mCursor-1);
+			if(last.getParameterNr() == parameterNr)
+			{
+				last.newValue = (uint8_t)newValue;
+				return;
+			}
+		}
+
+		if(mEnd - mBegin == mCapacity) dropOldest();
+
+		ParameterUndoRecord& r = at(mEnd);
+		r.parameterNr = (uint16)(parameterNr | (mStartNext ? UNDO_GROUP_START : 0));
+		r.oldValue = (uint8_t)oldValue;
+		r.newValue = (uint8_t)newValue;
+		mCursor = ++mEnd;
+		mStartNext = (mGroupDepth == 0);
+	};
+
+	bool canUndo() const
+	{
+		return mCursor != mBegin;
+	};
+
+	bool canRedo() const
+	{
+		return mCursor != mEnd;
+	};
+
+	/** the records of the last group, newest first: set their oldValue*/
+	bool takeUndo(Array<ParameterUndoRecord>& records)
+	{
+		records.clearQuick();
+		if(!canUndo()) return false;
+
+		do
+		{
+			records.add(at(--mCursor));
+		} while((records.getLast().parameterNr & UNDO_GROUP_START) == 0);
+		//an open group isn't continued after it was undone
+		mStartNext = true;
+		return true;
+	};
+
+	/** the records of the next undone group, oldest first: set their newValue*/
+	bool takeRedo(Array<ParameterUndoRecord>& records)
+	{
+		records.clearQuick();
+		if(!canRedo()) return false;
+
+		do
+		{
+			records.add(at(mCursor++));
+		} while(mCursor != mEnd && (at(mCursor).parameterNr & UNDO_GROUP_START) == 0);
+		mStartNext = true;
+		return true;
+	};
+
+private:
+	ParameterUndoRecord& at(int position)
+	{
+		return mRecords[position % mCapacity];
+	};
+
+	/** frees the slot of the oldest record, with the rest of its group*/
+	void dropOldest()
+	{
+		mBegin++;
+		while(mBegin != mEnd && (at(mBegin).parameterNr & UNDO_GROUP_START) == 0)
+		{
+			mBegin++;
+		}
+		//a group filling the whole buffer keeps its newer records
+		if(mBegin == mEnd)
+		{
+			mBegin = mEnd - mCapacity + 1;
+			at(mBegin).parameterNr |= UNDO_GROUP_START;
+		}
+	};
+
+	HeapBlock<ParameterUndoRecord> mRecords;
+	MemoryAccount mMemory;
+	int mCapacity;
+	int mBegin;			// oldest record
+	int mCursor;		// records before it can be undone
+	int mEnd;			// records from the cursor to here can be redone
+	int mGroupDepth;
+	bool mStartNext;	// the next record starts a group
+};
+//---------------------------------------------------------------------------
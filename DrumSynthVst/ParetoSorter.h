@@ -0,0 +1,425 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./ParallelFor.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define PARETO_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define PARETO_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define OBJECTIVE_VOTES		0	// the fitness of the votes, unvoted children inherit it from their parents
+#define OBJECTIVE_SURROGATE	1	// what the surrogate model thinks of the sound
+#define OBJECTIVE_NOVELTY	2	// distance to the closest patch of the population
+#define OBJECTIVE_SPECTRAL	3	// how close the sound is to the spectral target
+#define NUM_OBJECTIVES		4
+
+#define PARETO_GRAIN_SIZE	8		// rows of the dominance matrix a worker takes at once
+#define PARETO_BOUNDARY		1e30f	// crowding distance of the ends of a front, they are always kept
+
+//---------------------------------------------------------------------------
+/** NUM_OBJECTIVES values per item, larger is better. The values are stored
+	by objective, so the dominance test compares four items at once.
+*/
+class ObjectiveTable
+{
+public:
+	ObjectiveTable() : mNumItems(0)
+	{
+	};
+
+	/** numItems items with all objectives 0*/
+	void setSize(int numItems)
+	{
+		mNumItems = numItems;
+		mValues.calloc(jmax(1,numItems*NUM_OBJECTIVES));
+	};
+
+	int getNumItems() const
+	{
+		return mNumItems;
+	};
+
+	float* getColumn(int objective)
+	{
+		return mValues + objective*mNumItems;
+	};
+
+	const float* getColumn(int objective) const
+	{
+		return mValues + objective*mNumItems;
+	};
+
+	float get(int item, int objective) const
+	{
+		return mValues[objective*mNumItems + item];
+	};
+
+	void set(int item, int objective, float value)
+	{
+		mValues[objective*mNumItems + item] = value;
+	};
+
+private:
+	HeapBlock<float> mValues;
+	int mNumItems;
+};
+
+//---------------------------------------------------------------------------
+/** Non-dominated sorting and crowding distance of NSGA-II.
+
+	An item dominates another one if it is at least as good in every
+	objective and better in one. The items nothing dominates are front 0,
+	the ones only front 0 dominates front 1 and so on. Within a front the
+	crowding distance prefers the items in the sparse regions: per
+	objective the distance between the two neighbours of an item, relative
+	to the spread of the front, summed over the objectives. An objective
+	that is the same for the whole front is left out of its crowding.
+
+	The dominance matrix is a bit per pair, its rows are filled on all
+	cores by ParallelFor with four items per SSE2 or NEON compare, and the
+	crowding runs one objective per worker. Only peeling off the fronts is
+	sequential, it walks the set bits of the matrix once. Keeps its buffers
+	between calls, not thread safe.
+*/
+class ParetoSorter
+{
+public:
+	ParetoSorter() : mNumItems(0), mNumWords(0)
+	{
+	};
+
+	void sort(const ObjectiveTable& table)
+	{
+		mNumItems = table.getNumItems();
+		mNumWords = (mNumItems+31)/32;
+		mOrder.clearQuick();
+		mFrontStarts.clearQuick();
+		if(mNumItems == 0) return;
+
+		mDominates.calloc(mNumItems*mNumWords);
+		mNumDominators.malloc(mNumItems);
+		mRanks.malloc(mNumItems);
+		mCrowdingParts.calloc(mNumItems*NUM_OBJECTIVES);
+		mCrowding.calloc(mNumItems);
+
+		ParallelFor* parallel = ParallelFor::getInstance();
+		DominanceTask dominance(*this,table);
+		parallel->execute(mNumItems,PARETO_GRAIN_SIZE,dominance);
+
+		peelFronts();
+
+		CrowdingTask crowding(*this,table);
+		parallel->execute(NUM_OBJECTIVES,1,crowding);
+		for(int objective=0;objective<NUM_OBJECTIVES;objective++)
+		{
+			const float* part = mCrowdingParts + objective*mNumItems;
+			for(int i=0;i<mNumItems;i++)
+			{
+				mCrowding[i] += part[i];
+			}
+		}
+	};
+
+	int getNumFronts() const
+	{
+		return mFrontStarts.size();
+	};
+
+	/** 0 is the front nothing dominates*/
+	int getRank(int item) const
+	{
+		return mRanks[item];
+	};
+
+	float getCrowding(int item) const
+	{
+		return mCrowding[item];
+	};
+
+	/** all items, best first: by front, within a front the larger crowding distance first*/
+	void getOrder(Array<int>& order) const
+	{
+		order = mOrder;
+		CrowdingComparator comparator(*this);
+		for(int f=0;f<mFrontStarts.size();f++)
+		{
+			const int begin = mFrontStarts[f];
+			const int end = f+1 < mFrontStarts.size() ? mFrontStarts[f+1] : order.size();
+			sortArray(comparator,order.getRawDataPointer()+begin,0,end-begin-1,false);
+		}
+	};
+
+private:
+	/** fills the row of the items an item dominates, and counts the items that dominate it*/
+	class DominanceTask : public ParallelTask
+	{
+	public:
+		DominanceTask(ParetoSorter& owner, const ObjectiveTable& table) : mOwner(owner), mTable(table)
+		{
+		};
+
+		void run(int begin, int end, int)
+		{
+			for(int i=begin;i<end;i++)
+			{
+				mOwner.computeRow(mTable,i);
+			}
+		};
+
+	private:
+		ParetoSorter& mOwner;
+		const ObjectiveTable& mTable;
+	};
+
+	/** one objective per item, each writes its own part of the crowding distance*/
+	class CrowdingTask : public ParallelTask
+	{
+	public:
+		CrowdingTask(ParetoSorter& owner, const ObjectiveTable& table) : mOwner(owner), mTable(table)
+		{
+		};
+
+		void run(int begin, int end, int)
+		{
+			for(int objective=begin;objective<end;objective++)
+			{
+				mOwner.computeCrowding(mTable,objective);
+			}
+		};
+
+	private:
+		ParetoSorter& mOwner;
+		const ObjectiveTable& mTable;
+	};
+
+	/** ascending values of one objective, ties by item*/
+	class ValueComparator
+	{
+	public:
+		ValueComparator(const float* values) : mValues(values)
+		{
+		};
+
+		int compareElements(int a, int b) const
+		{
+			if(mValues[a] != mValues[b]) return mValues[a] < mValues[b] ? -1 : 1;
+			return a - b;
+		};
+
+	private:
+		const float* mValues;
+	};
+
+	/** descending crowding distance, ties by item*/
+	class CrowdingComparator
+	{
+	public:
+		CrowdingComparator(const ParetoSorter& owner) : mOwner(owner)
+		{
+		};
+
+		int compareElements(int a, int b) const
+		{
+			const float ca = mOwner.mCrowding[a];
+			const float cb = mOwner.mCrowding[b];
+			if(ca != cb) return ca > cb ? -1 : 1;
+			return a - b;
+		};
+
+	private:
+		const ParetoSorter& mOwner;
+	};
+
+	void computeRow(const ObjectiveTable& table, int i)
+	{
+		uint32* row = mDominates + i*mNumWords;
+		float self[NUM_OBJECTIVES];
+		for(int k=0;k<NUM_OBJECTIVES;k++)
+		{
+			self[k] = table.get(i,k);
+		}
+
+		int numDominators = 0;
+		int j = 0;
+#if PARETO_USE_SSE2
+		__m128 s[NUM_OBJECTIVES];
+		for(int k=0;k<NUM_OBJECTIVES;k++)
+		{
+			s[k] = _mm_set1_ps(self[k]);
+		}
+		const __m128 none = _mm_setzero_ps();
+		const __m128 all = _mm_cmpeq_ps(none,none);
+		for(;j+4<=mNumItems;j+=4)
+		{
+			__m128 notWorse = all, better = none, notBetter = all, worse = none;
+			for(int k=0;k<NUM_OBJECTIVES;k++)
+			{
+				const __m128 other = _mm_loadu_ps(table.getColumn(k)+j);
+				notWorse = _mm_and_ps(notWorse,_mm_cmpge_ps(s[k],other));
+				better = _mm_or_ps(better,_mm_cmpgt_ps(s[k],other));
+				notBetter = _mm_and_ps(notBetter,_mm_cmple_ps(s[k],other));
+				worse = _mm_or_ps(worse,_mm_cmplt_ps(s[k],other));
+			}
+			//j is a multiple of 4, the four bits never cross a word
+			row[j>>5] |= (uint32)_mm_movemask_ps(_mm_and_ps(notWorse,better)) << (j&31);
+			numDominators += countLanes(_mm_movemask_ps(_mm_and_ps(notBetter,worse)));
+		}
+#elif PARETO_USE_NEON
+		float32x4_t s[NUM_OBJECTIVES];
+		for(int k=0;k<NUM_OBJECTIVES;k++)
+		{
+			s[k] = vdupq_n_f32(self[k]);
+		}
+		const uint32x4_t none = vdupq_n_u32(0);
+		const uint32x4_t all = vdupq_n_u32(0xffffffff);
+		for(;j+4<=mNumItems;j+=4)
+		{
+			uint32x4_t notWorse = all, better = none, notBetter = all, worse = none;
+			for(int k=0;k<NUM_OBJECTIVES;k++)
+			{
+				const float32x4_t other = vld1q_f32(table.getColumn(k)+j);
+				notWorse = vandq_u32(notWorse,vcgeq_f32(s[k],other));
+				better = vorrq_u32(better,vcgtq_f32(s[k],other));
+				notBetter = vandq_u32(notBetter,vcleq_f32(s[k],other));
+				worse = vorrq_u32(worse,vcltq_f32(s[k],other));
+			}
+			row[j>>5] |= (uint32)getLaneBits(vandq_u32(notWorse,better)) << (j&31);
+			numDominators += countLanes(getLaneBits(vandq_u32(notBetter,worse)));
+		}
+#endif
+		//the tail (or everything without SIMD)
+		for(;j<mNumItems;j++)
+		{
+			bool notWorse = true, better = false, notBetter = true, worse = false;
+			for(int k=0;k<NUM_OBJECTIVES;k++)
+			{
+				const float other = table.get(j,k);
+				notWorse = notWorse && self[k] >= other;
+				better = better || self[k] > other;
+				notBetter = notBetter && self[k] <= other;
+				worse = worse || self[k] < other;
+			}
+			if(notWorse && better) row[j>>5] |= (uint32)1 << (j&31);
+			if(notBetter && worse) numDominators++;
+		}
+		mNumDominators[i] = numDominators;
+	};
+
+	/** front by front into mOrder: an item joins the next front when the last item that dominates it is taken*/
+	void peelFronts()
+	{
+		for(int i=0;i<mNumItems;i++)
+		{
+			if(mNumDominators[i] == 0)
+			{
+				mRanks[i] = 0;
+				mOrder.add(i);
+			}
+		}
+
+		int begin = 0;
+		while(begin < mOrder.size())
+		{
+			const int end = mOrder.size();
+			mFrontStarts.add(begin);
+			const int nextRank = mFrontStarts.size();
+			for(int k=begin;k<end;k++)
+			{
+				const uint32* row = mDominates + mOrder.getUnchecked(k)*mNumWords;
+				for(int w=0;w<mNumWords;w++)
+				{
+					uint32 bits = row[w];
+					for(int j=w*32;bits != 0;j++,bits >>= 1)
+					{
+						if((bits & 1) && --mNumDominators[j] == 0)
+						{
+							mRanks[j] = nextRank;
+							mOrder.add(j);
+						}
+					}
+				}
+			}
+			begin = end;
+		}
+	};
+
+	void computeCrowding(const ObjectiveTable& table, int objective)
+	{
+		const float* values = table.getColumn(objective);
+		float* part = mCrowdingParts + objective*mNumItems;
+		ValueComparator comparator(values);
+
+		Array<int> front;
+		for(int f=0;f<mFrontStarts.size();f++)
+		{
+			const int begin = mFrontStarts[f];
+			const int end = f+1 < mFrontStarts.size() ? mFrontStarts[f+1] : mOrder.size();
+			front.clearQuick();
+			front.addArray(mOrder,begin,end-begin);
+			front.sort(comparator);
+
+			const int size = front.size();
+			const float spread = values[front.getLast()] - values[front.getFirst()];
+			if(spread <= 0.f) continue;
+
+			part[front.getFirst()] = PARETO_BOUNDARY;
+			part[front.getLast()] = PARETO_BOUNDARY;
+			for(int k=1;k<size-1;k++)
+			{
+				part[front.getUnchecked(k)] = (values[front.getUnchecked(k+1)] - values[front.getUnchecked(k-1)]) / spread;
+			}
+		}
+	};
+
+	static int countLanes(int bits)
+	{
+		return (bits & 1) + ((bits>>1) & 1) + ((bits>>2) & 1) + ((bits>>3) & 1);
+	};
+
+#if PARETO_USE_NEON
+	/** bit n is set if lane n is, like _mm_movemask_ps*/
+	static int getLaneBits(uint32x4_t lanes)
+	{
+		return (int)((vgetq_lane_u32(lanes,0) & 1) | (vgetq_lane_u32(lanes,1) & 2) | (vgetq_lane_u32(lanes,2) & 4) | (vgetq_lane_u32(lanes,3) & 8));
+	};
+#endif
+
+	int mNumItems;
+	int mNumWords;						// per row of the dominance matrix
+	HeapBlock<uint32> mDominates;		// bit j of row i: item i dominates item j
+	HeapBlock<int> mNumDominators;		// items that dominate an item, counted down while peeling
+	HeapBlock<int> mRanks;
+	HeapBlock<float> mCrowdingParts;	// per objective, so the crowding workers don't share a value
+	HeapBlock<float> mCrowding;
+	Array<int> mOrder;					// the items front by front
+	Array<int> mFrontStarts;			// where each front begins in mOrder
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,306 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./parameterRanges.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define DISTANCE_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define DISTANCE_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define DISTANCE_WEIGHT_ONE		1024	// weight of a full range step, a parameter can add at most this to weightedL1()
+#define DISTANCE_WEIGHTS_SIZE	((NUM_PARAMS+15)&~15)
+#define DISTANCE_TILE_SIZE		64		// patches per tile side in l1Matrix()
+
+//---------------------------------------------------------------------------
+/** Per parameter weights that make a full range step of every parameter
+	count the same, so a waveform switch with 6 values isn't drowned by
+	the 0..127 knobs.*/
+class DistanceWeights
+{
+public:
+	DistanceWeights()
+	{
+		mMaxDistance = 0;
+		for(int i=0;i<DISTANCE_WEIGHTS_SIZE;i++)
+		{
+			if(i < NUM_PARAMS)
+			{
+				const int range = jmax(1,(int)parameterRanges[i].range);
+				mWeights[i] = (short)(DISTANCE_WEIGHT_ONE / range);
+				mMaxDistance += mWeights[i] * range;
+			}
+			else mWeights[i] = 0;
+		}
+	};
+
+	const short* get() const
+	{
+		return mWeights;
+	};
+
+	/** weightedL1() of two patches at opposite ends of every range*/
+	int getMaxDistance() const
+	{
+		return mMaxDistance;
+	};
+
+private:
+	short mWeights[DISTANCE_WEIGHTS_SIZE];	// padded with zeros to whole SIMD blocks
+	int mMaxDistance;
+};
+
+//---------------------------------------------------------------------------
+/** Distances between raw patch value vectors (NUM_PARAMS bytes each).
+
+	The SSE2 and NEON paths work on 16 parameters per step; the SSE2 L1
+	is a single psadbw per block. All kernels give exactly the same
+	results as the scalar tail loops.
+*/
+class PatchDistance
+{
+public:
+	/** sum of the absolute differences of all bytes*/
+	static int l1(const uint8_t* a, const uint8_t* b, int num = NUM_PARAMS)
+	{
+		int sum = 0;
+		int i = 0;
+#if DISTANCE_USE_SSE2
+		//two accumulators so the adds of neighbouring blocks don't wait for each other
+		__m128i acc = _mm_setzero_si128();
+		__m128i acc2 = _mm_setzero_si128();
+		for(;i+32<=num;i+=32)
+		{
+			acc = _mm_add_epi64(acc,_mm_sad_epu8(load(a+i),load(b+i)));
+			acc2 = _mm_add_epi64(acc2,_mm_sad_epu8(load(a+i+16),load(b+i+16)));
+		}
+		for(;i+16<=num;i+=16)
+		{
+			acc = _mm_add_epi64(acc,_mm_sad_epu8(load(a+i),load(b+i)));
+		}
+
+		//the last block overlaps the one before, the bytes that were already counted are masked out
+		if(i < num && num >= 16)
+		{
+			const __m128i mask = load(getTailMask() + (num-i));
+			acc2 = _mm_add_epi64(acc2,_mm_sad_epu8(_mm_and_si128(mask,load(a+num-16)),_mm_and_si128(mask,load(b+num-16))));
+			i = num;
+		}
+		acc = _mm_add_epi64(acc,acc2);
+		sum = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc,8));
+#elif DISTANCE_USE_NEON
+		uint32x4_t acc = vdupq_n_u32(0);
+		for(;i+16<=num;i+=16)
+		{
+			acc = vpadalq_u16(acc,vpaddlq_u8(vabdq_u8(vld1q_u8(a+i),vld1q_u8(b+i))));
+		}
+		sum = (int)(vgetq_lane_u32(acc,0) + vgetq_lane_u32(acc,1) + vgetq_lane_u32(acc,2) + vgetq_lane_u32(acc,3));
+#endif
+		for(;i<num;i++)
+		{
+			const int d = a[i] - b[i];
+			sum += d < 0 ? -d : d;
+		}
+		return sum;
+	};
+
+	/** the number of parameters that differ*/
+	static int hamming(const uint8_t* a, const uint8_t* b, int num = NUM_PARAMS)
+	{
+		int sum = 0;
+		int i = 0;
+#if DISTANCE_USE_SSE2
+		for(;i+16<=num;i+=16)
+		{
+			const int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(load(a+i),load(b+i)));
+			sum += 16 - countBits(equal);
+		}
+#elif DISTANCE_USE_NEON
+		uint32x4_t acc = vdupq_n_u32(0);
+		for(;i+16<=num;i+=16)
+		{
+			//a lane that differs is 0 after the compare, 1 after the shift of the inverted mask
+			const uint8x16_t differ = vshrq_n_u8(vmvnq_u8(vceqq_u8(vld1q_u8(a+i),vld1q_u8(b+i))),7);
+			acc = vpadalq_u16(acc,vpaddlq_u8(differ));
+		}
+		sum = (int)(vgetq_lane_u32(acc,0) + vgetq_lane_u32(acc,1) + vgetq_lane_u32(acc,2) + vgetq_lane_u32(acc,3));
+#endif
+		for(;i<num;i++)
+		{
+			if(a[i] != b[i]) sum++;
+		}
+		return sum;
+	};
+
+	/** sum of the absolute differences times the weight of each parameter, see DistanceWeights*/
+	static int weightedL1(const uint8_t* a, const uint8_t* b, const short* weights, int num = NUM_PARAMS)
+	{
+		int sum = 0;
+		int i = 0;
+#if DISTANCE_USE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		__m128i acc = _mm_setzero_si128();
+		for(;i+16<=num;i+=16)
+		{
+			const __m128i va = load(a+i);
+			const __m128i vb = load(b+i);
+			const __m128i diff = _mm_or_si128(_mm_subs_epu8(va,vb),_mm_subs_epu8(vb,va));
+			const __m128i w0 = _mm_loadu_si128((const __m128i*)(weights+i));
+			const __m128i w1 = _mm_loadu_si128((const __m128i*)(weights+i+8));
+			acc = _mm_add_epi32(acc,_mm_madd_epi16(_mm_unpacklo_epi8(diff,zero),w0));
+			acc = _mm_add_epi32(acc,_mm_madd_epi16(_mm_unpackhi_epi8(diff,zero),w1));
+		}
+		acc = _mm_add_epi32(acc,_mm_srli_si128(acc,8));
+		acc = _mm_add_epi32(acc,_mm_srli_si128(acc,4));
+		sum = _mm_cvtsi128_si32(acc);
+#elif DISTANCE_USE_NEON
+		int32x4_t acc = vdupq_n_s32(0);
+		for(;i+16<=num;i+=16)
+		{
+			const uint8x16_t diff = vabdq_u8(vld1q_u8(a+i),vld1q_u8(b+i));
+			const int16x8_t d0 = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(diff)));
+			const int16x8_t d1 = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(diff)));
+			const int16x8_t w0 = vld1q_s16(weights+i);
+			const int16x8_t w1 = vld1q_s16(weights+i+8);
+			acc = vmlal_s16(acc,vget_low_s16(d0),vget_low_s16(w0));
+			acc = vmlal_s16(acc,vget_high_s16(d0),vget_high_s16(w0));
+			acc = vmlal_s16(acc,vget_low_s16(d1),vget_low_s16(w1));
+			acc = vmlal_s16(acc,vget_high_s16(d1),vget_high_s16(w1));
+		}
+		sum = vgetq_lane_s32(acc,0) + vgetq_lane_s32(acc,1) + vgetq_lane_s32(acc,2) + vgetq_lane_s32(acc,3);
+#endif
+		for(;i<num;i++)
+		{
+			const int d = a[i] - b[i];
+			sum += (d < 0 ? -d : d) * weights[i];
+		}
+		return sum;
+	};
+
+	/** sum of the squared differences of all bytes, fits an int for up to 33000 bytes*/
+	static int l2Squared(const uint8_t* a, const uint8_t* b, int num = NUM_PARAMS)
+	{
+		int sum = 0;
+		int i = 0;
+#if DISTANCE_USE_SSE2
+		//the absolute difference fits a byte, madd squares it and adds the neighbours
+		const __m128i zero = _mm_setzero_si128();
+		__m128i acc = _mm_setzero_si128();
+		__m128i acc2 = _mm_setzero_si128();
+		for(;i+16<=num;i+=16)
+		{
+			const __m128i va = load(a+i);
+			const __m128i vb = load(b+i);
+			const __m128i diff = _mm_or_si128(_mm_subs_epu8(va,vb),_mm_subs_epu8(vb,va));
+			const __m128i low = _mm_unpacklo_epi8(diff,zero);
+			const __m128i high = _mm_unpackhi_epi8(diff,zero);
+			acc = _mm_add_epi32(acc,_mm_madd_epi16(low,low));
+			acc2 = _mm_add_epi32(acc2,_mm_madd_epi16(high,high));
+		}
+		acc = _mm_add_epi32(acc,acc2);
+		acc = _mm_add_epi32(acc,_mm_srli_si128(acc,8));
+		acc = _mm_add_epi32(acc,_mm_srli_si128(acc,4));
+		sum = _mm_cvtsi128_si32(acc);
+#elif DISTANCE_USE_NEON
+		uint32x4_t acc = vdupq_n_u32(0);
+		for(;i+16<=num;i+=16)
+		{
+			const uint8x16_t diff = vabdq_u8(vld1q_u8(a+i),vld1q_u8(b+i));
+			acc = vpadalq_u16(acc,vmull_u8(vget_low_u8(diff),vget_low_u8(diff)));
+			acc = vpadalq_u16(acc,vmull_u8(vget_high_u8(diff),vget_high_u8(diff)));
+		}
+		sum = (int)(vgetq_lane_u32(acc,0) + vgetq_lane_u32(acc,1) + vgetq_lane_u32(acc,2) + vgetq_lane_u32(acc,3));
+#endif
+		for(;i<num;i++)
+		{
+			const int d = a[i] - b[i];
+			sum += d*d;
+		}
+		return sum;
+	};
+
+	/** the l1() of every pair of the numPatches rows of data into a numPatches x numPatches matrix*/
+	static void l1Matrix(const uint8_t* data, int numPatches, int* matrix)
+	{
+		//tiles keep the mirrored writes and the patch rows in the cache
+		for(int tileRow=0;tileRow<numPatches;tileRow+=DISTANCE_TILE_SIZE)
+		{
+			const int rowEnd = jmin(tileRow+DISTANCE_TILE_SIZE,numPatches);
+			for(int tileCol=tileRow;tileCol<numPatches;tileCol+=DISTANCE_TILE_SIZE)
+			{
+				const int colEnd = jmin(tileCol+DISTANCE_TILE_SIZE,numPatches);
+				for(int i=tileRow;i<rowEnd;i++)
+				{
+					const uint8_t* a = data + i*NUM_PARAMS;
+					int j = tileCol;
+					if(tileCol == tileRow)
+					{
+						matrix[i*numPatches+i] = 0;
+						j = i+1;
+					}
+					for(;j<colEnd;j++)
+					{
+						const int d = l1(a,data + j*NUM_PARAMS);
+						matrix[i*numPatches+j] = d;
+						matrix[j*numPatches+i] = d;
+					}
+				}
+			}
+		}
+	};
+
+private:
+#if DISTANCE_USE_SSE2
+	static __m128i load(const uint8_t* p)
+	{
+		return _mm_loadu_si128((const __m128i*)p);
+	};
+
+	/** 16 zeros and 16 0xff, loading 16 bytes at offset n keeps the last n bytes of a block*/
+	static const uint8_t* getTailMask()
+	{
+		static const uint8_t tailMask[32] = {
+			0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+			0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff
+		};
+		return tailMask;
+	};
+
+	static int countBits(int x)
+	{
+		x = x - ((x >> 1) & 0x5555);
+		x = (x & 0x3333) + ((x >> 2) & 0x3333);
+		x = (x + (x >> 4)) & 0x0f0f;
+		return (x + (x >> 8)) & 0x1f;
+	};
+#endif
+};
+//---------------------------------------------------------------------------
@@ -28,232 +28,1583 @@
 #include "Patch.h"
 #include "Log.h"
 #include "NameGenerator.h"
+#include "PatchHash.h"
+#include "Library/PatchIndex.h"
+#include "Library/PatchLibrary.h"
+#include "Library/PatchSimilarityIndex.h"
+#include "Library/PatchLineage.h"
+#include "FastRandom.h"
+#include "Crossover.h"
+#include "ParameterLocks.h"
+#include "Mutation.h"
+#include "ChildBreeder.h"
+#include "BreedFarm.h"
+#include "ObjectArena.h"
+#include "Pipeline.h"
+#include "Population.h"
+#include "SurrogateModel.h"
+#include "VoteDatabase.h"
+#include "PatchDistance.h"
+#include "GenerationStats.h"
+#include "ParetoSorter.h"
+#include "Preview/PatchFeatures.h"
+#include "Library/CheckpointWriter.h"
+#include "BackgroundJobs.h"
+#include "Trace.h"
+#include "Telemetry.h"
 
 
 #include <time.h>
 
-class PatchGenerator : public Thread 
+#define OUTPUT_SND_FILES	0	// one .SND file per child
+#define OUTPUT_LIBRARY		1	// every generation is appended to one packed library next to the output folder
+#define OUTPUT_LINEAGE		2	// parents and children as deltas in one lineage file next to the output folder
+
+#define BREED_CANCEL_TIMEOUT_MS	2000
+
+#define GENERATOR_FIRST_CHILD		25	// number of the first child of run(), P025.SND
+#define GENERATOR_PIPELINE_BATCHES	16	// fathers on their way through the stages of run() at once
+#define GENERATOR_PIPELINE_POLL_MS	50	// how often run() looks for a stop while it waits for a batch
+
+#define RUN_ALL_PAIRS	0	// every parent with every other parent
+#define RUN_EVOLVE		1	// the next generations of the voted population
+#define RUN_SPECULATE	2	// the next generation in the background while the user votes
+
+#define DEFAULT_SPECULATION_THRESHOLD	0.5f	// part of the population that has to be voted before the next generation is bred ahead
+
+#define DEFAULT_NUM_GENERATIONS		1
+#define BREED_ATTEMPTS_PER_CHILD	4	// before a generation with too many duplicates is left smaller
+#define DEFAULT_SCREENING_FACTOR	4	// candidates bred per child that reaches the user once the surrogate is trained
+#define DEFAULT_DIVERSITY			0.f	// diversity selection is off
+#define DEFAULT_DIVERSITY_COLLAPSE	0.25f	// a run stops when the diversity falls below this part of where it started
+#define DEFAULT_CHECKPOINT_INTERVAL	1	// generations between two checkpoints
+
+#define SURVIVAL_FITNESS	0	// the children with the best fitness (or surrogate score) reach the population
+#define SURVIVAL_PARETO		1	// NSGA-II: the best fronts of votes, surrogate score, novelty and spectral target
+#define SPECTRAL_SOUNDS_PER_WORKER	2	// rendered per batch for the spectral target, between two checks for a stop
+
+#define GENERATOR_CHECKPOINT_MAGIC		0x4b435053	// "SPCK" little endian
+#define GENERATOR_CHECKPOINT_VERSION	1
+#define GENERATOR_CHECKPOINT_EXTENSION	".sck"
+
+/** Breeds the patches as jobs of the JobQueue, a run at JOB_PRIORITY_NORMAL,
+	the speculation at JOB_PRIORITY_IDLE. One job runs at a time, a new one
+	waits for the last one to finish.
+*/
+class PatchGenerator : public ChangeBroadcaster
 {
 public:
-	PatchGenerator() : Thread("PatchThread")
+	PatchGenerator()
+	{
+		init(File("E:/gewerbe_sonic_potions/git/editor/DrumSynthVst/Patches/Generation1"),
+			File("E:/gewerbe sonic potions/SynthDIY/DrumSynthEditor/DrumSynthVst/Patches/Generation2"));
+	};
+
+	/** parentFolder holds the .SND files to breed from, the checkpoint, votes and libraries are kept next to outputFolder*/
+	PatchGenerator(const File& parentFolder, const File& outputFolder)
+	{
+		init(parentFolder, outputFolder);
+	};
+
+	~PatchGenerator()
+	{
+		cancelSpeculation();
+		if(isEvolving())
+		{
+			//a stopped run writes its checkpoint itself
+			mJob->cancel();
+			mJob->waitUntilDone(-1);
+		}
+		else
+		{
+			writeCheckpoint();
+			saveVotes();
+		}
+		mParentPatches.clear();
+	}
+
+	/** told about the progress of every run, not of the speculation. NULL stops it. Message thread*/
+	void setJobListener(BackgroundJob::Listener* listener)
+	{
+		if(mJob != NULL && mJobListener != NULL) mJob->removeListener(mJobListener);
+		mJobListener = listener;
+	}
+
+	/** the same seed and parents give the same generation, whatever the number of cpus*/
+	void setSeed(uint64 seed)
+	{
+		mSeed = seed;
+	}
+
+	uint64 getSeed()
+	{
+		return mSeed;
+	}
+
+	void setOutputMode(int mode)
+	{
+		jassert(mode == OUTPUT_SND_FILES || mode == OUTPUT_LIBRARY || mode == OUTPUT_LINEAGE);
+		mOutputMode = mode;
+	}
+
+	int getOutputMode()
+	{
+		return mOutputMode;
+	}
+
+	/** in OUTPUT_SND_FILES mode every child is also rendered and put into the patch index of the
+		output folder, so the folder can be bred from or browsed without rendering it again*/
+	void setIndexChildren(bool index)
+	{
+		mIndexChildren = index;
+	}
+
+	/** the workers combineAllParents() sends the fathers to, NULL breeds them all here. Not owned.
+		The lineage mode needs the deltas of the children, it always breeds here*/
+	void setFarm(BreedFarm* farm)
+	{
+		mFarm = farm;
+	}
+
+	/** what the children are bred with, another machine with these settings breeds the same ones*/
+	BreedSettings getBreedSettings()
+	{
+		BreedSettings settings;
+		settings.seed = mSeed;
+		settings.crossoverMode = mCrossoverMode;
+		settings.mutationDistribution = mMutationDistribution;
+		settings.mutationRate = mMutationRate;
+		settings.maxMutationOffset = mMaxMutationOffset;
+		for(int i=0;i<LOCK_NUM_CATEGORIES;i++)
+		{
+			settings.locked[i] = mLocks.isCategoryLocked(i);
+		}
+		return settings;
+	}
+
+	/** CROSSOVER_UNIFORM mixes single parameters, the point modes keep runs of neighbouring parameters together*/
+	void setCrossoverMode(int mode)
+	{
+		jassert(mode == CROSSOVER_UNIFORM || mode == CROSSOVER_ONE_POINT || mode == CROSSOVER_TWO_POINT);
+		mCrossoverMode = mode;
+	}
+
+	int getCrossoverMode()
+	{
+		return mCrossoverMode;
+	}
+
+	/** MUTATION_UNIFORM or MUTATION_GAUSSIAN offsets*/
+	void setMutationDistribution(int distribution)
+	{
+		jassert(distribution == MUTATION_UNIFORM || distribution == MUTATION_GAUSSIAN);
+		mMutationDistribution = distribution;
+	}
+
+	int getMutationDistribution()
+	{
+		return mMutationDistribution;
+	}
+
+	/** the categories crossover and mutation leave alone, a locked parameter keeps the father's value.
+		Only change them while the job isn't running*/
+	ParameterLocks& getLocks()
+	{
+		return mLocks;
+	}
+
+	/** the naming style of the children, see NameGenerator::setOrder()*/
+	void setNameOrder(int order)
+	{
+		nameGen.setOrder(order);
+	}
+
+	int getNameOrder()
+	{
+		return nameGen.getOrder();
+	}
+
+	/** the library the generations are appended to in OUTPUT_LIBRARY mode*/
+	File getLibraryFile()
+	{
+		return mOutputFolder.getSiblingFile(mOutputFolder.getFileName() + PATCH_LIBRARY_EXTENSION);
+	}
+
+	/** the lineage a generation is written to in OUTPUT_LINEAGE mode*/
+	File getLineageFile()
+	{
+		return mOutputFolder.getSiblingFile(mOutputFolder.getFileName() + PATCH_LINEAGE_EXTENSION);
+	}
+
+	/**combine each parent with all other parents if mLike != DISLIKE*/
+	void combineAllParents()
+	{
+		if(isEvolving()) return;
+		cancelSpeculation();
+		if(gloLog != NULL) gloLog->clear();
+		mRunMode = RUN_ALL_PAIRS;
+		startJob(JOB_PRIORITY_NORMAL);
+	};
+
+	/** breed the next generations from the voted population, the first call starts with the parent patches.
+		If the speculation has bred the next generation for these votes it is taken over at once, one that
+		is nearly done is waited for*/
+	void evolve()
+	{
+		if(isEvolving()) return;
+		saveVotes();
+		if(getSpeculation() != NULL)
+		{
+			takeSpeculation();
+			return;
+		}
+		cancelSpeculation();
+
+		mRunMode = RUN_EVOLVE;
+		startJob(JOB_PRIORITY_NORMAL);
+	};
+
+	/** true while a run is busy, the speculation doesn't count*/
+	bool isEvolving()
+	{
+		return isRunning() && mRunMode != RUN_SPECULATE;
+	}
+
+	/** waits for the current run or speculation, false if the timeout ran out first*/
+	bool waitUntilFinished(int timeoutMs)
+	{
+		return mJob == NULL || mJob->waitUntilDone(timeoutMs);
+	}
+
+	/** breeds, dedups and names the next generation as an idle job once
+		enough of the population is voted, so evolve() only has to swap it in. A speculation that is
+		already running is started again, it would be for the old votes. Call it after every vote,
+		only works for one generation per evolve() and a run that wasn't stopped*/
+	void speculate()
+	{
+		if(isEvolving()) return;
+		cancelSpeculation();
+		if(mSpeculationThreshold <= 0.f || mNumGenerations != 1 || mRemainingGenerations > 0) return;
+		if(mPopulation.getNumBreedable() < 2 || getNumVoted() < mSpeculationThreshold*mPopulation.getNumMembers()) return;
+
+		mRunMode = RUN_SPECULATE;
+		startJob(JOB_PRIORITY_IDLE);
+	}
+
+	/** stops the speculation and throws its generation away, call it before the votes change.
+		The speculation only reads the population and the surrogate*/
+	void cancelSpeculation()
+	{
+		if(mRunMode == RUN_SPECULATE && isRunning())
+		{
+			//it stops at its next check, mSpeculation is cleared after that
+			mJob->cancel();
+			mJob->waitUntilDone(-1);
+		}
+		mSpeculationReady = false;
+		mSpeculation.clear();
+	}
+
+	/** the generation the speculation has bred, NULL if there is none. Waits up to BREED_CANCEL_TIMEOUT_MS
+		for a running one, the change message of the generator is sent when it is finished*/
+	const Population* getSpeculation()
+	{
+		//the change message is sent just before the job returns
+		if(mRunMode == RUN_SPECULATE && mJob != NULL && !mJob->waitUntilDone(BREED_CANCEL_TIMEOUT_MS)) return NULL;
+		return mSpeculationReady ? &mSpeculation : NULL;
+	}
+
+	/** the part of the population that has to be voted before speculate() breeds ahead, 0 turns it off*/
+	void setSpeculationThreshold(float fraction)
+	{
+		jassert(fraction >= 0.f);
+		mSpeculationThreshold = fraction;
+	}
+
+	/** only touch the population while isEvolving() is false, and only read it while a speculation runs*/
+	Population& getPopulation()
+	{
+		return mPopulation;
+	}
+
+	/** how many generations one evolve() breeds*/
+	void setNumGenerations(int num)
+	{
+		jassert(num > 0);
+		mNumGenerations = num;
+	}
+
+	int getNumGenerations()
+	{
+		return mNumGenerations;
+	}
+
+	/** teaches the surrogate the vote of a patch, only while the job isn't running.
+		The vote is kept in the VoteDatabase too, for every later session*/
+	void addVote(Patch* patch)
+	{
+		mSurrogate.addVote(patch->getValues(),patch->getOpinion());
+		VoteDatabase::getInstance()->setOpinion(patch->getValues(),patch->getOpinion());
+	}
+
+	/** with a trained surrogate factor times more children are bred and only the best scoring reach the population.
+		1 turns the screening off*/
+	void setScreeningFactor(int factor)
+	{
+		jassert(factor > 0);
+		mScreeningFactor = factor;
+	}
+
+	/** > 0 picks the children one by one for their fitness plus diversity times their distance
+		to the closest patch already picked (0..1 of the weighted distance range), so a generation
+		doesn't collapse onto near clones. Uses the screening factor for the number of candidates*/
+	void setDiversity(float diversity)
+	{
+		jassert(diversity >= 0.f);
+		mDiversity = diversity;
+	}
+
+	/** a run stops early once the diversity of a generation is below fraction of the population it
+		started from, so it doesn't go on breeding clones. 0 never stops*/
+	void setDiversityCollapse(float fraction)
+	{
+		jassert(fraction >= 0.f && fraction < 1.f);
+		mDiversityCollapse = fraction;
+	}
+
+	/** the statistics of the population, updated by a run with every generation. Any thread*/
+	GenerationSummary getStatistics()
+	{
+		const ScopedLock lock(mStatsLock);
+		return mStats;
+	}
+
+	/** the statistics of the population the current or last run started from*/
+	GenerationSummary getStartStatistics()
+	{
+		const ScopedLock lock(mStatsLock);
+		return mStartStats;
+	}
+
+	/** SURVIVAL_PARETO sorts the candidates into fronts over all NUM_OBJECTIVES objectives and takes them
+		front by front, the least crowded first. Uses the screening factor for the number of candidates*/
+	void setSurvivalMode(int mode)
+	{
+		jassert(mode == SURVIVAL_FITNESS || mode == SURVIVAL_PARETO);
+		mSurvivalMode = mode;
+	}
+
+	int getSurvivalMode()
+	{
+		return mSurvivalMode;
+	}
+
+	/** the sound OBJECTIVE_SPECTRAL pulls the children towards, NUM_PARAMS values. Without a target
+		the objective is the same for all candidates and the sounds aren't rendered*/
+	void setSpectralTarget(const uint8_t* values)
+	{
+		PatchFeatureExtractor extractor;
+		extractor.compute(values,mSpectralTarget);
+		mHasSpectralTarget = true;
+	}
+
+	void clearSpectralTarget()
+	{
+		mHasSpectralTarget = false;
+	}
+
+	/** generations between two checkpoints, a checkpoint is also written when a run ends or is stopped*/
+	void setCheckpointInterval(int generations)
+	{
+		jassert(generations > 0);
+		mCheckpointInterval = generations;
+	}
+
+	/** population, votes, random state and generation counter of the evolution*/
+	File getCheckpointFile()
+	{
+		return mOutputFolder.getSiblingFile(mOutputFolder.getFileName() + GENERATOR_CHECKPOINT_EXTENSION);
+	}
+
+	/** all votes ever given, they train the surrogate*/
+	File getVoteHistoryFile()
+	{
+		return mOutputFolder.getSiblingFile(String("votes") + VOTE_HISTORY_EXTENSION);
+	}
+
+	/** if delta isn't NULL it receives the crossover and mutations that made the child*/
+	Patch* generateChild(Patch* father, Patch* mother, FastRandom& random, PatchDelta* delta = NULL)
+	{
+		return generateChild(father->getValues(),mother->getValues(),father->getGeneration()+1,random,delta);
+	}
+
+	/** breed from NUM_PARAMS parent values*/
+	Patch* generateChild(const uint8_t* father, const uint8_t* mother, int generation, FastRandom& random, PatchDelta* delta = NULL)
+	{
+		//generate an empty child
+		Patch* child = new Patch();
+		breedChild(father,mother,generation,random,child,delta);
+		return child;
+	}
+
+	/** like generateChild() into a patch that is already there, e.g. one of an ObjectArena*/
+	void breedChild(const uint8_t* father, const uint8_t* mother, int generation, FastRandom& random, Patch* child, PatchDelta* delta = NULL)
+	{
+		//get parent parameters
+		selectParentParameters(father,mother,child,delta,random);
+		child->setGeneration(generation);
+
+		//Now mutate some parameters
+		mutateParameters(child,delta,random);
+		Telemetry::add(TELEMETRY_CHILDREN_BRED,1);
+
+		//the child has no name yet, nameChildren() names a whole generation at once
+	}
+
+private:
+	/** one run of the generator*/
+	class RunJob : public BackgroundJob
+	{
+	public:
+		RunJob(PatchGenerator& owner, int priority)
+		: BackgroundJob("breeding",priority),
+		mOwner(owner)
+		{
+		};
+
+		bool run()
+		{
+			mOwner.run();
+			return true;
+		};
+
+	private:
+		PatchGenerator& mOwner;
+	};
+
+	void startJob(int priority)
+	{
+		//a job that didn't see the cancel in time still works on the population
+		if(mJob != NULL) mJob->waitUntilDone(-1);
+
+		mJob = new RunJob(*this,priority);
+		if(mJobListener != NULL && mRunMode != RUN_SPECULATE) mJob->addListener(mJobListener);
+		JobQueue::getInstance()->addJob(mJob);
+	}
+
+	bool isRunning()
+	{
+		return mJob != NULL && !mJob->isDone();
+	}
+
+	/** on the job thread, mJob doesn't change while it runs*/
+	bool shouldStop()
+	{
+		return mJob->shouldExit();
+	}
+
+	void run()
+	{
+		if(mRunMode == RUN_EVOLVE)
+		{
+			runEvolution();
+			return;
+		}
+		if(mRunMode == RUN_SPECULATE)
+		{
+			runSpeculation();
+			return;
+		}
+		runAllPairs();
+	}
+
+	void init(const File& parentFolder, const File& outputFolder)
+	{
+		//a new sequence for every session, setSeed() repeats a run
+		mSeed = (uint64)Time::currentTimeMillis();
+
+		mMutationRate = 0.2f;
+		mMaxMutationOffset = 0.15f;
+		mMutationDistribution = MUTATION_UNIFORM;
+
+		mOutputFolder = outputFolder;
+		mOutputMode = OUTPUT_SND_FILES;
+		mIndexChildren = false;
+		mCrossoverMode = CROSSOVER_UNIFORM;
+		mRunMode = RUN_ALL_PAIRS;
+		mNumGenerations = DEFAULT_NUM_GENERATIONS;
+		mScreeningFactor = DEFAULT_SCREENING_FACTOR;
+		mDiversity = DEFAULT_DIVERSITY;
+		mDiversityCollapse = DEFAULT_DIVERSITY_COLLAPSE;
+		mSurvivalMode = SURVIVAL_FITNESS;
+		mHasSpectralTarget = false;
+		mCheckpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+		mSpeculationThreshold = DEFAULT_SPECULATION_THRESHOLD;
+		mSpeculationReady = false;
+		mJobListener = NULL;
+		mFarm = NULL;
+		mRemainingGenerations = 0;
+		memset(mRandomState,0,sizeof(mRandomState));
+
+		findParentPatches(parentFolder.getFullPathName(),mParentPatches);
+
+		mSurrogate.load(getVoteHistoryFile());
+		//and what was voted in every other folder and session
+		VoteDatabase::getInstance()->addVotesTo(mSurrogate);
+		mSurrogate.updateIndex();
+
+		//pick up the population (and an unfinished run) of the last session
+		loadCheckpoint();
+
+		//combineAllParents();
+	};
+
+	/** every parent with every other parent, one batch per father through the stages fetch, crossover,
+		mutation, dedupe, naming, the features if the children are indexed, and write.
+		With a farm the fathers are crossed and mutated, and their features rendered, on its workers*/
+	void runAllPairs()
+	{
+		//all parents are read once, breeding then only works on this table
+		mParents = PresetLoader::loadPatches(mParentPatches);
+		const int numParents = mParents->getNumPatches();
+		const int numCpus = SystemStats::getNumCpus();
+		const bool farmed = mFarm != NULL && mFarm->getNumWorkers() > 0 && mOutputMode != OUTPUT_LINEAGE;
+		const int numSlots = farmed ? mFarm->getNumSlots() : 0;
+
+		FetchStage fetch(*mParents);
+		CrossoverStage crossover(*this,numCpus);
+		MutationStage mutation(*this,numCpus);
+		FarmStage farm(*this,numSlots);
+		DedupeStage dedupe(numParents);
+		NamingStage naming(*this,numParents);
+		FeatureStage features(numCpus);
+		WriteStage write(*this);
+		if(farmed) mFarm->startRun(*mParents,getBreedSettings(),write.isIndexing());
+
+		//children that sound like a parent or a sibling are not written, and no child gets the name of one
+		for(int i=0;i<numParents;i++)
+		{
+			if(mParents->getStatus(i) != LOAD_OK)
+			{
+				write.addParent(NULL);
+				continue;
+			}
+			Patch parent;
+			PresetLoader::readPatchData(mParents->getPatchData(i),&parent);
+			dedupe.addParent(parent,i);
+			naming.addParent(parent);
+			write.addParent(&parent);
+		}
+
+		//the batches are made once and used again, at most GENERATOR_PIPELINE_BATCHES are on their way
+		OwnedArray<BreedBatch> batches;
+		Array<BreedBatch*> idle;
+
+		Pipeline pipeline;
+		pipeline.addStage(&fetch);
+		if(farmed)
+		{
+			pipeline.addStage(&farm);
+		}
+		else
+		{
+			pipeline.addStage(&crossover);
+			pipeline.addStage(&mutation);
+		}
+		pipeline.addStage(&dedupe);
+		pipeline.addStage(&naming);
+		if(write.isIndexing()) pipeline.addStage(&features);
+		pipeline.addStage(&write);
+		pipeline.start();
+
+		int father = 0;
+		int numDone = 0;
+		mJob->setStatusMessage("Breeding all pairs");
+		if(numParents == 0) pipeline.finish();
+		while(!pipeline.isDone())
+		{
+			if(shouldStop())
+			{
+				pipeline.stop();
+				mParents = NULL;
+				return;
+			}
+			//every cpu of the farm gets a father, and the queues in front of the farm stage stay full
+			if(father < numParents && (idle.size() > 0 || batches.size() < GENERATOR_PIPELINE_BATCHES + numSlots))
+			{
+				if(idle.size() == 0)
+				{
+					batches.add(new BreedBatch());
+					idle.add(batches.getLast());
+				}
+				BreedBatch* batch = idle.remove(idle.size()-1);
+				batch->reset(father++);
+				pipeline.push(batch);
+				if(father == numParents) pipeline.finish();
+				continue;
+			}
+			BreedBatch* done = static_cast<BreedBatch*>(pipeline.pop(GENERATOR_PIPELINE_POLL_MS));
+			if(done != NULL)
+			{
+				idle.add(done);
+				mJob->setProgress(++numDone/(double)numParents);
+			}
+		}
+
+		write.finish();
+		logText(pipeline.getReport());
+		if(farmed && mFarm->getNumLost() > 0) logText(String(mFarm->getNumLost()) + " breeding workers lost, their fathers were bred again");
+		mParents = NULL;
+	}
+
+	/** one father and its children on their way through the stages of runAllPairs()*/
+	class BreedBatch : public PipelineItem
+	{
+	public:
+		BreedBatch() : father(-1), hasChildFeatures(false)
+		{
+		};
+
+		/** empty for another father, the arenas keep their memory*/
+		void reset(int fatherIndex)
+		{
+			father = fatherIndex;
+			mothers.clearQuick();
+			children.clearQuick();
+			deltas.clearQuick();
+			kept.clearQuick();
+			hasChildFeatures = false;
+			childArena.reset();
+			deltaArena.reset();
+		};
+
+		int father;
+		Array<int> mothers;					// one per child
+		Array<Patch*> children;				// they live in the arena until the next reset()
+		Array<PatchDelta*> deltas;
+		Array<int> kept;					// the children that aren't duplicates
+		HeapBlock<PatchFeatures> features;	// of the kept children, if the feature stage runs
+		bool hasChildFeatures;				// a farm worker has rendered the features of all children
+		HeapBlock<PatchFeatures> childFeatures;
+		ObjectArena<Patch> childArena;
+		ObjectArena<PatchDelta> deltaArena;
+	};
+
+	/** a child and a delta for every mother of the father*/
+	class FetchStage : public PipelineStage
+	{
+	public:
+		FetchStage(const PatchBatch& parents) : PipelineStage("fetch",1,false), mParents(parents)
+		{
+		};
+
+		void process(PipelineItem* item, int)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			if(mParents.getStatus(batch.father) != LOAD_OK) return;
+
+			for(int j=0;j<mParents.getNumPatches();j++)
+			{
+				if(j == batch.father || mParents.getStatus(j) != LOAD_OK) continue;
+				batch.mothers.add(j);
+				batch.children.add(batch.childArena.create());
+				batch.deltas.add(batch.deltaArena.create());
+			}
+		};
+
+	private:
+		const PatchBatch& mParents;
+	};
+
+	class CrossoverStage : public PipelineStage
+	{
+	public:
+		CrossoverStage(PatchGenerator& generator, int numWorkers) : PipelineStage("crossover",numWorkers,false), mGenerator(generator)
+		{
+		};
+
+		void process(PipelineItem* item, int)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			const PatchBatch& parents = *mGenerator.mParents;
+			if(batch.children.size() == 0) return;
+
+			//one stream per father keeps the run reproducible
+			FastRandom random(mGenerator.mSeed,ChildBreeder::getCrossoverStream(batch.father));
+			const uint8_t* father = parents.getPatchData(batch.father) + PATCH_NAME_LENGTH;
+			for(int c=0;c<batch.children.size();c++)
+			{
+				const uint8_t* mother = parents.getPatchData(batch.mothers[c]) + PATCH_NAME_LENGTH;
+				mGenerator.selectParentParameters(father,mother,batch.children[c],batch.deltas[c],random);
+				//the parents come from files, so they are all generation 0
+				batch.children[c]->setGeneration(1);
+			}
+		};
+
+	private:
+		PatchGenerator& mGenerator;
+	};
+
+	class MutationStage : public PipelineStage
+	{
+	public:
+		MutationStage(PatchGenerator& generator, int numWorkers) : PipelineStage("mutation",numWorkers,false), mGenerator(generator)
+		{
+		};
+
+		void process(PipelineItem* item, int)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			if(batch.children.size() == 0) return;
+
+			//a stream of its own per father, behind the crossover streams and the one of the names
+			FastRandom random(mGenerator.mSeed,ChildBreeder::getMutationStream(mGenerator.mParents->getNumPatches(),batch.father));
+			for(int c=0;c<batch.children.size();c++)
+			{
+				mGenerator.mutateParameters(batch.children[c],batch.deltas[c],random);
+			}
+			Telemetry::add(TELEMETRY_CHILDREN_BRED,batch.children.size());
+		};
+
+	private:
+		PatchGenerator& mGenerator;
+	};
+
+	/** crossover and mutation of a father on a worker of the farm, one worker of the stage per cpu
+		of the farm. A father no worker could breed is bred here*/
+	class FarmStage : public PipelineStage
+	{
+	public:
+		FarmStage(PatchGenerator& generator, int numWorkers)
+		: PipelineStage("farm",numWorkers,false),
+		mGenerator(generator),
+		mBreeder(generator.getBreedSettings())
+		{
+			for(int i=0;i<getNumWorkers();i++)
+			{
+				mResults.add(new BreedFarmResult());
+			}
+		};
+
+		void process(PipelineItem* item, int workerIndex)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			if(batch.children.size() == 0) return;
+
+			BreedFarmResult& result = *mResults.getUnchecked(workerIndex);
+			if(mGenerator.mFarm->breedFather(batch.father,result) && result.mothers == batch.mothers)
+			{
+				for(int c=0;c<batch.children.size();c++)
+				{
+					batch.children[c]->setValues(result.getValues(c));
+					batch.children[c]->setGeneration(1);
+				}
+				if(result.features.size() == batch.children.size())
+				{
+					batch.childFeatures.malloc(jmax(1,batch.children.size()));
+					for(int c=0;c<batch.children.size();c++) batch.childFeatures[c] = result.features.getReference(c);
+					batch.hasChildFeatures = true;
+				}
+			}
+			else
+			{
+				mBreeder.breedChildren(*mGenerator.mParents,batch.father,batch.mothers,batch.children,&batch.deltas);
+			}
+			Telemetry::add(TELEMETRY_CHILDREN_BRED,batch.children.size());
+		};
+
+	private:
+		PatchGenerator& mGenerator;
+		const ChildBreeder mBreeder;
+		OwnedArray<BreedFarmResult> mResults;	// by worker, the memory is used again
+	};
+
+	/** keeps the children that don't sound like a parent or an earlier child*/
+	class DedupeStage : public PipelineStage
+	{
+	public:
+		DedupeStage(int numParents) : PipelineStage("dedupe",1,true), mGeneration(numParents*numParents), mNumKept(0)
+		{
+		};
+
+		void addParent(Patch& parent, int index)
+		{
+			mGeneration.add(parent.getValues(),index);
+		};
+
+		void process(PipelineItem* item, int)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			for(int c=0;c<batch.children.size();c++)
+			{
+				if(mGeneration.add(batch.children[c]->getValues(),GENERATOR_FIRST_CHILD+mNumKept))
+				{
+					batch.kept.add(c);
+					mNumKept++;
+				}
+			}
+		};
+
+	private:
+		PatchHashSet mGeneration;
+		int mNumKept;
+	};
+
+	/** the kept children of a father are named in one batch*/
+	class NamingStage : public PipelineStage
 	{
-		/* initialize random seed: */
-		srand ( time(NULL) );
+	public:
+		NamingStage(PatchGenerator& generator, int numParents)
+		: PipelineStage("naming",1,true),
+		mGenerator(generator),
+		mNames(numParents*numParents),
+		mRandom(generator.mSeed,numParents)
+		{
+		};
 
-		mMutationRate = 0.2f;
-		mMaxMutationOffset = 0.15f;
+		void addParent(Patch& parent)
+		{
+			mNames.add(parent.getShortName());
+		};
 
-		findParentPatches("E:/gewerbe_sonic_potions/git/editor/DrumSynthVst/Patches/Generation1",mParentPatches);
+		void process(PipelineItem* item, int)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			mChildNames.malloc(jmax(1,batch.kept.size())*NAME_SIZE);
+			mGenerator.nameGen.generateNames(batch.kept.size(),mNames,mRandom,mChildNames);
+			for(int k=0;k<batch.kept.size();k++)
+			{
+				batch.children[batch.kept[k]]->setName(mChildNames + k*NAME_SIZE);
+			}
+		};
 
-		//combineAllParents();
+	private:
+		PatchGenerator& mGenerator;
+		PatchNameSet mNames;
+		FastRandom mRandom;
+		HeapBlock<char> mChildNames;
 	};
-	~PatchGenerator()
+
+	/** renders the kept children for the patch index of the output folder*/
+	class FeatureStage : public PipelineStage
 	{
-		mParentPatches.clear();
-	}
+	public:
+		FeatureStage(int numWorkers) : PipelineStage("features",numWorkers,false)
+		{
+			for(int i=0;i<getNumWorkers();i++)
+			{
+				mExtractors.add(NULL);
+			}
+		};
 
-	void run()
+		void process(PipelineItem* item, int workerIndex)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			PatchFeatureExtractor* extractor = mExtractors.getUnchecked(workerIndex);
+			if(extractor == NULL)
+			{
+				extractor = new PatchFeatureExtractor();
+				mExtractors.set(workerIndex,extractor);
+			}
+
+			batch.features.malloc(jmax(1,batch.kept.size()));
+			for(int k=0;k<batch.kept.size();k++)
+			{
+				if(batch.hasChildFeatures)	batch.features[k] = batch.childFeatures[batch.kept[k]];
+				else						extractor->compute(batch.children[batch.kept[k]]->getValues(),batch.features[k]);
+			}
+		};
+
+	private:
+		OwnedArray<PatchFeatureExtractor> mExtractors;	// by worker, the slots don't move
+	};
+
+	/** writes the kept children in the output mode, finish() then writes what is collected over the run*/
+	class WriteStage : public PipelineStage
 	{
-		srand ( time(NULL) );
-		int patchCount = 25;
-		
-		for(int i=0;i<mParentPatches.size();i++)
+	public:
+		WriteStage(PatchGenerator& generator)
+		: PipelineStage("write",1,true),
+		mGenerator(generator),
+		mNumRecords(0),
+		mPatchCount(GENERATOR_FIRST_CHILD),
+		mIndexing(generator.mIndexChildren && generator.mOutputMode == OUTPUT_SND_FILES),
+		mNumIndexed(0)
+		{
+			if(mIndexing) mIndex.load(PatchIndex::getCacheFile(mGenerator.mOutputFolder));
+		};
+
+		/** in parent order, NULL for one that couldn't be loaded. In lineage mode the parents are the roots*/
+		void addParent(Patch* parent)
 		{
-			ScopedPointer<Patch> father = mPresetLoader.loadPatch(mParentPatches[i]);
+			mLineageIds.add(parent != NULL ? mLineage.addRoot(parent) : NO_PARENT);
+		};
+
+		/** the children go into the patch index of the output folder with their features*/
+		bool isIndexing() const
+		{
+			return mIndexing;
+		};
 
-			for(int j=0;j<mParentPatches.size();j++)
+		void process(PipelineItem* item, int)
+		{
+			BreedBatch& batch = *static_cast<BreedBatch*>(item);
+			String log;
+			for(int k=0;k<batch.kept.size();k++)
 			{
-				if(mParentPatches[i] != mParentPatches[j])
+				const int c = batch.kept[k];
+				Patch* child = batch.children[c];
+				log += child->getName() + String("\n");
+
+				if(mGenerator.mOutputMode == OUTPUT_LINEAGE)
+				{
+					mLineage.addChild(mLineageIds[batch.father],mLineageIds[batch.mothers[c]],child,*batch.deltas[c]);
+					mPatchCount++;
+				}
+				else if(mGenerator.mOutputMode == OUTPUT_LIBRARY)
 				{
-					ScopedPointer<Patch> mother = mPresetLoader.loadPatch(mParentPatches[j]);	
+					uint8_t data[PATCH_DATA_SIZE];
+					PresetLoader::writePatchData(child,data);
+					mRecords.append(data,PATCH_DATA_SIZE);
+					mNumRecords++;
+					mPatchCount++;
+				}
+				else
+				{
+					const File file = mGenerator.mOutputFolder.getChildFile(String("P0")+String(mPatchCount++) + String(".SND"));
+					mGenerator.mPresetLoader.savePatch(file,child);
+					if(mIndexing) addToIndex(file,child,batch.features[k]);
+				}
+			}
+			logText(log);
+		};
+
+		void finish()
+		{
+			if(mGenerator.mOutputMode == OUTPUT_LIBRARY && mNumRecords > 0)
+			{
+				//the similarity index only has to take in the new records
+				PatchLibrary::append(mGenerator.getLibraryFile(),mRecords.getData(),mNumRecords);
+				PatchSimilarityIndex::updateIndexFile(mGenerator.getLibraryFile());
+			}
+			if(mGenerator.mOutputMode == OUTPUT_LINEAGE && mLineage.getNumEntries() > mLineageIds.size())
+			{
+				mLineage.save(mGenerator.getLineageFile());
+			}
+			if(mNumIndexed > 0)
+			{
+				mIndex.save(PatchIndex::getCacheFile(mGenerator.mOutputFolder));
+			}
+		};
 
-					ScopedPointer<Patch> child = generateChild(father,mother);
+	private:
+		/** the entry PatchIndex::update() would make, so the folder isn't rendered again*/
+		void addToIndex(const File& file, Patch* child, const PatchFeatures& features)
+		{
+			if(!file.existsAsFile()) return;
 
-					mPresetLoader.savePatch(File(String("E:/gewerbe sonic potions/SynthDIY/DrumSynthEditor/DrumSynthVst/Patches/Generation2/") + String("P0")+String(patchCount++) + String(".SND")),child);
-				}
+			PatchIndexEntry entry;
+			entry.file = file;
+			entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+			entry.fileSize = file.getSize();
+			entry.hash = hashPatchValues(child->getValues());
+			entry.name = child->getShortName();
+			entry.features = features;
+			mIndex.add(entry);
+			mNumIndexed++;
+		};
+
+		PatchGenerator& mGenerator;
+
+		//in library mode the children are collected here and written once at the end
+		MemoryBlock mRecords;
+		int mNumRecords;
+
+		//in lineage mode the parents are the roots and the children are stored as deltas
+		PatchLineage mLineage;
+		Array<int> mLineageIds;
+
+		int mPatchCount;
+		const bool mIndexing;
+		PatchIndex mIndex;
+		int mNumIndexed;
+	};
+
+	void mutateParameters(Patch* child, PatchDelta* delta, FastRandom& random)
+	{
+		ChildBreeder::mutate(mLocks,mMutationRate,mMaxMutationOffset,mMutationDistribution,mMutationKernel,child,delta,random);
+	}
+	void selectParentParameters(const uint8_t* father, const uint8_t* mother, Patch* child, PatchDelta* delta, FastRandom& random)
+	{
+		ChildBreeder::crossover(mCrossoverMode,mLocks,father,mother,child,delta,random);
+	}
+	/** fittest first*/
+	class FitnessComparator
+	{
+	public:
+		FitnessComparator(const Population& population) : mPopulation(population)
+		{
+		};
+
+		int compareElements(int a, int b) const
+		{
+			const float fa = mPopulation.getFitness(a);
+			const float fb = mPopulation.getFitness(b);
+			return (fa > fb) ? -1 : (fa < fb) ? 1 : 0;
+		};
+
+	private:
+		const Population& mPopulation;
+	};
+
+	void runEvolution()
+	{
+		FastRandom random;
+		if(mRemainingGenerations > 0)
+		{
+			//a stopped run goes on with the numbers it would have used
+			random.setState(mRandomState);
+			logText(String("Resuming at generation ") + String(mPopulation.getGeneration()) + String(", ") + String(mRemainingGenerations) + String(" to go"));
+		}
+		else
+		{
+			//one stream per generation, the same votes give the same result
+			random.setSeed(mSeed,mPopulation.getGeneration());
+			mRemainingGenerations = mNumGenerations;
+		}
+
+		if(mPopulation.getNumMembers() == 0)
+		{
+			seedPopulation();
+		}
+		mSurrogate.updateIndex();
+
+		//a collapse is measured against where the run started
+		GenerationStats stats(mDistanceWeights.get(),mDistanceWeights.getMaxDistance());
+		const GenerationSummary start = getPopulationStatistics(mPopulation,stats);
+		{
+			const ScopedLock lock(mStatsLock);
+			mStartStats = start;
+			mStats = start;
+		}
+
+		int sinceCheckpoint = 0;
+		const int numGenerations = mRemainingGenerations;
+		while(mRemainingGenerations > 0)
+		{
+			//a generation that is stopped half way is bred again from here
+			random.getState(mRandomState);
+			mJob->setStatusMessage(String("Breeding generation ") + String(mPopulation.getGeneration()+1));
+			mJob->setProgress((numGenerations-mRemainingGenerations)/(double)numGenerations);
+
+			Population next;
+			stats.reset();
+			if(!breedGeneration(next,random,stats))
+			{
+				logText("Not enough patches left to breed, like some or start again");
+				mRemainingGenerations = 0;
+				break;
+			}
+			//a stopped generation leaves the population as it was
+			if(shouldStop()) break;
+
+			mPopulation.swapWith(next);
+			mPopulation.setGeneration(mPopulation.getGeneration()+1);
+			mRemainingGenerations--;
+			const GenerationSummary summary = stats.getSummary(mPopulation.getGeneration());
+			{
+				const ScopedLock lock(mStatsLock);
+				mStats = summary;
+			}
+			logText(summary.toString());
+
+			if(mDiversityCollapse > 0.f && summary.diversity < mDiversityCollapse*start.diversity)
+			{
+				logText(String("Diversity fell to ") + String(roundToInt(100.f*summary.diversity/start.diversity)) + String("% of the start, the run stops"));
+				mRemainingGenerations = 0;
+				break;
+			}
+
+			if(++sinceCheckpoint >= mCheckpointInterval && mRemainingGenerations > 0)
+			{
+				random.getState(mRandomState);
+				writeCheckpoint();
+				sinceCheckpoint = 0;
 			}
 		}
+		writeCheckpoint();
 	}
 
-	/**combine each parent with all other parents if mLike != DISLIKE*/
-	void combineAllParents()
+	/** the first generation runEvolution() would breed, with the same random stream, into mSpeculation*/
+	void runSpeculation()
 	{
-		gloLogText->clear();
-		startThread();
-		
-	};
+		TRACE_SCOPE("generator","speculate");
+		FastRandom random;
+		random.setSeed(mSeed,mPopulation.getGeneration());
+		mSurrogate.updateIndex();
+
+		Population next;
+		GenerationStats stats(mDistanceWeights.get(),mDistanceWeights.getMaxDistance());
+		if(!breedGeneration(next,random,stats) || shouldStop()) return;
 
-	Patch* generateChild(Patch* father, Patch* mother)
+		mSpeculation.swapWith(next);
+		mSpeculation.setGeneration(mPopulation.getGeneration()+1);
+		mSpeculationStats = stats.getSummary(mSpeculation.getGeneration());
+		mSpeculationReady = true;
+		sendChangeMessage();
+	}
+
+	/** makes the finished speculation the population, false if there is none. Message thread, the job isn't running*/
+	bool takeSpeculation()
 	{
-		//generate an empty child
-		Patch* child = new Patch();
+		if(!mSpeculationReady) return false;
 
-		//get parent parameters
-		selectParentParameters(father,mother,child);
+		mPopulation.swapWith(mSpeculation);
+		mPopulation.setGeneration(mSpeculation.getGeneration());
+		mSpeculation.clear();
+		mSpeculationReady = false;
+		{
+			const ScopedLock lock(mStatsLock);
+			mStats = mSpeculationStats;
+		}
+		logText(mSpeculationStats.toString());
+		writeCheckpoint();
+		return true;
+	}
 
-		//Now mutate some parameters
-		mutateParameters(child);
+	int getNumVoted() const
+	{
+		int num = 0;
+		for(int i=0;i<mPopulation.getNumMembers();i++)
+		{
+			if(mPopulation.getMember(i)->getOpinion() == LIKE || mPopulation.getMember(i)->getOpinion() == DISLIKE) num++;
+		}
+		return num;
+	}
+
+	/** hands a snapshot of the evolution to the checkpoint thread, mRandomState has to be up to date*/
+	void writeCheckpoint()
+	{
+		if(mPopulation.getNumMembers() == 0) return;
+
+		MemoryBlock data;
+		{
+			MemoryOutputStream out(data,false);
+			out.writeInt(GENERATOR_CHECKPOINT_MAGIC);
+			out.writeInt(GENERATOR_CHECKPOINT_VERSION);
+			out.writeInt(NUM_PARAMS);
+			out.writeInt64((int64)mSeed);
+			out.writeInt(mRemainingGenerations);
+			for(int i=0;i<FAST_RANDOM_STATE_SIZE;i++)
+			{
+				out.writeInt((int)mRandomState[i]);
+			}
+			mPopulation.write(out);
+		}
+		mCheckpointWriter.write(getCheckpointFile(),data);
+	}
 
+	/** returns false if there is no valid checkpoint, nothing is changed then*/
+	bool loadCheckpoint()
+	{
+		FileInputStream in(getCheckpointFile());
+		if(in.getStatus().failed()) return false;
 
-		
-		String name = nameGen.generateName();
-		child->setName(name);
+		if(in.readInt() != GENERATOR_CHECKPOINT_MAGIC || in.readInt() != GENERATOR_CHECKPOINT_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
 
-		ScopedPointer<MessageManagerLock> lock = new MessageManagerLock();
-		gloLogText->setText(gloLogText->getText()  + name + String("\n"));
-		lock = 0;
+		const uint64 seed = (uint64)in.readInt64();
+		const int remaining = in.readInt();
+		uint32 state[FAST_RANDOM_STATE_SIZE];
+		for(int i=0;i<FAST_RANDOM_STATE_SIZE;i++)
+		{
+			state[i] = (uint32)in.readInt();
+		}
 
-		//return the new child
-		return child;
+		Population population;
+		if(!population.read(in) || population.getNumMembers() == 0) return false;
 
+		mPopulation.swapWith(population);
+		mPopulation.setGeneration(population.getGeneration());
+		mSeed = seed;
+		mRemainingGenerations = jmax(0,remaining);
+		memcpy(mRandomState,state,sizeof(state));
+		return true;
 	}
 
-private:
-	void mutateParameters(Patch* child)
-	{
-		
-
-		//how many parameters to mutate?
-		int parameters2mutate = mMutationRate * NUM_PARAMS;
-		
-#ifdef LOG_VERBOSE
-		ScopedPointer<MessageManagerLock> lock = new MessageManagerLock();
-		gloLogText->setText(gloLogText->getText() + String("Mutating ") + String(parameters2mutate) + String(" parameters out of ") + String(NUM_PARAMS) + String("\n"));
-		lock=0;
-#endif
-		struct SelectedParameter
-		{
-			int index;
-			Parameter par;
-		};
+	/** the vote history is written in the background too, it grows with every vote*/
+	void saveVotes()
+	{
+		MemoryBlock data;
+		{
+			MemoryOutputStream out(data,false);
+			mSurrogate.write(out);
+		}
+		mCheckpointWriter.write(getVoteHistoryFile(),data);
+	}
+
+	/** the parent patches are the first population, with the votes they got before*/
+	void seedPopulation()
+	{
+		ScopedPointer<PatchBatch> parents(PresetLoader::loadPatches(mParentPatches));
+		for(int i=0;i<parents->getNumPatches();i++)
+		{
+			if(parents->getStatus(i) != LOAD_OK) continue;
+
+			Patch* parent = new Patch();
+			PresetLoader::readPatchData(parents->getPatchData(i),parent);
+			parent->setOpinion(VoteDatabase::getInstance()->getOpinion(parent->getValues()));
+			mPopulation.add(parent);
+		}
+		logText(String("Starting with ") + String(mPopulation.getNumMembers()) + String(" parents"));
+	}
+
+	/** breeds the children of the population into the empty next, false if there are less than two parents.
+		Only reads the population, so a speculation can run it while the user votes. stats gets the
+		bred children and the members of next*/
+	bool breedGeneration(Population& next, FastRandom& random, GenerationStats& stats)
+	{
+		TRACE_SCOPE("generator","breed generation");
+		if(mPopulation.getNumBreedable() < 2) return false;
+
+		const int size = mPopulation.getSize();
+		PatchHashSet children(size);
+
+		//the best patches survive unchanged
+		Array<int> elites;
+		mPopulation.getElites(elites);
+		for(int i=0;i<elites.size();i++)
+		{
+			Patch* elite = new Patch(*mPopulation.getMember(elites[i]));
+			children.add(elite->getValues(),next.getNumMembers());
+			next.add(elite,mPopulation.getFitness(elites[i]));
+		}
+
+		//once the surrogate knows the user's taste it sorts out the candidates nobody would like
+		const bool pareto = mSurvivalMode == SURVIVAL_PARETO;
+		const bool screen = (pareto || mSurrogate.isTrained() || mDiversity > 0.f) && mScreeningFactor > 1;
+		const int numChildren = size - next.getNumMembers();
+		const int numCandidates = screen ? numChildren*mScreeningFactor : numChildren;
+
+		//the candidates live in the arena until the next generation, only the chosen ones are copied into next
+		mCandidateArena.reset();
+		Population candidates;
+		for(int attempt=0;candidates.getNumMembers() < numCandidates && attempt < numCandidates*BREED_ATTEMPTS_PER_CHILD && !shouldStop();attempt++)
+		{
+			const int father = mPopulation.select(random);
+			const int mother = mPopulation.select(random,father);
+			if(father < 0 || mother < 0) break;
+
+			Patch* child = mCandidateArena.create();
+			Patch* fatherPatch = mPopulation.getMember(father);
+			breedChild(fatherPatch->getValues(),mPopulation.getMember(mother)->getValues(),fatherPatch->getGeneration()+1,random,child);
+			const bool duplicate = !children.add(child->getValues(),next.getNumMembers()+candidates.getNumMembers());
+			stats.childBred(duplicate);
+			if(duplicate)
+			{
+				mCandidateArena.removeLast();
+				continue;
+			}
+			//the fronts keep the surrogate score apart, the fitness stays what the votes give
+			const float fitness = screen && !pareto ? mSurrogate.score(child->getValues()) : mPopulation.getChildFitness(father,mother);
+			candidates.add(child,fitness);
+		}
+
+		if(pareto)
+		{
+			pickParetoChildren(candidates,next,numChildren);
+		}
+		else if(mDiversity > 0.f)
+		{
+			pickDiverseChildren(candidates,next,numChildren);
+		}
+		else
+		{
+			Array<int> order;
+			for(int i=0;i<candidates.getNumMembers();i++)
+			{
+				order.add(i);
+			}
+			if(screen)
+			{
+				FitnessComparator comparator(candidates);
+				order.sort(comparator,true);
+			}
+			for(int i=0;i<order.size() && i<numChildren;i++)
+			{
+				next.add(new Patch(*candidates.getMember(order[i])),candidates.getFitness(order[i]));
+			}
+		}
+		candidates.releaseMembers();
+
+		//a stopped generation isn't named, the caller throws it away
+		if(shouldStop()) return true;
+
+		nameChildren(next,elites.size(),random);
+		for(int i=0;i<next.getNumMembers();i++)
+		{
+			stats.add(next.getMember(i)->getValues(),next.getFitness(i));
+		}
+		return true;
+	}
+
+	/** stats of the members of a population that is already there*/
+	GenerationSummary getPopulationStatistics(const Population& population, GenerationStats& stats)
+	{
+		stats.reset();
+		for(int i=0;i<population.getNumMembers();i++)
+		{
+			stats.add(population.getMember(i)->getValues(),population.getFitness(i));
+		}
+		return stats.getSummary(population.getGeneration());
+	}
+
+	/** names the members of next from firstChild on in one batch. the names differ from each
+		other and from every patch of the current and the next population*/
+	void nameChildren(Population& next, int firstChild, FastRandom& random)
+	{
+		const int numChildren = next.getNumMembers() - firstChild;
+		if(numChildren <= 0) return;
+
+		PatchNameSet names(mPopulation.getNumMembers() + next.getNumMembers());
+		for(int i=0;i<mPopulation.getNumMembers();i++)
+		{
+			names.add(mPopulation.getMember(i)->getShortName());
+		}
+		for(int i=0;i<firstChild;i++)
+		{
+			names.add(next.getMember(i)->getShortName());
+		}
 
-#ifdef LOG_VERBOSE
-		lock = new MessageManagerLock();
-		gloLogText->setText(gloLogText->getText() + String("selected parameters: "));
-		lock = 0;
-#endif
-		//pick 'parameters2mutate' number of random parameters
-		OwnedArray<SelectedParameter> selectedParameters;
-		for(int i=0;i<parameters2mutate;i++)
+		HeapBlock<char> childNames(numChildren*NAME_SIZE);
+		nameGen.generateNames(numChildren,names,random,childNames);
+		for(int i=0;i<numChildren;i++)
 		{
+			next.getMember(firstChild+i)->setName(childNames + i*NAME_SIZE);
+		}
+	}
 
-			bool found = true;
-			int randomParamNo=0;
+	/** greedy max-min selection: the candidate with the best fitness plus distance bonus goes in next*/
+	void pickDiverseChildren(const Population& candidates, Population& next, int numChildren)
+	{
+		const int numCandidates = candidates.getNumMembers();
+		const float scale = 1.f / mDistanceWeights.getMaxDistance();
 
-			while(found)
+		//distance of every candidate to the closest patch in next
+		HeapBlock<float> closest(jmax(1,numCandidates));
+		HeapBlock<bool> taken(jmax(1,numCandidates));
+		for(int c=0;c<numCandidates;c++)
+		{
+			closest[c] = 1.f;
+			taken[c] = false;
+			for(int i=0;i<next.getNumMembers();i++)
 			{
-				const float rnd = (rand()%NUM_PARAMS)/(float)NUM_PARAMS;
-				randomParamNo = rnd* NUM_PARAMS;
+				closest[c] = jmin(closest[c],getDistance(candidates.getMember(c),next.getMember(i))*scale);
+			}
+		}
 
-				//check if parameter is already selected
-				found = false;
-				
-				for(int j=0;j<selectedParameters.size();j++)
+		for(int k=0;k<numChildren && k<numCandidates;k++)
+		{
+			int best = -1;
+			float bestValue = 0.f;
+			for(int c=0;c<numCandidates;c++)
+			{
+				if(taken[c]) continue;
+				const float value = candidates.getFitness(c) + mDiversity*closest[c];
+				if(best < 0 || value > bestValue)
 				{
-					if(selectedParameters[j]->index == randomParamNo)
-					{
-						found = true;
-						break;
-					}
+					best = c;
+					bestValue = value;
 				}
 			}
-			//we found a new unused param number
-			SelectedParameter* par = new SelectedParameter();
-			par->index = randomParamNo;
-			selectedParameters.add(par);
-#ifdef LOG_VERBOSE		
-			lock = new MessageManagerLock();
-			gloLogText->setText(gloLogText->getText() +  String(randomParamNo) + String(", "));
-			lock = 0;
-#endif			
-
-		}
-#ifdef LOG_VERBOSE
-		lock = new MessageManagerLock();
-		gloLogText->setText(gloLogText->getText() +  String("\n"));
-		lock = 0;
-#endif
-		//Now we got all parameter numbers to mutate
-		jassert(selectedParameters.size() == parameters2mutate);
-		
-		//Lets mutate them
-		for(int i=0;i<parameters2mutate;i++)
-		{
-			//generate random mutation amount
-			float rnd = (rand()%1000)/1000.f;
-			float mutate = rnd * mMaxMutationOffset;
-#ifdef LOG_VERBOSE
-			lock = new MessageManagerLock();
-			gloLogText->setText(gloLogText->getText() +  String("Mutating parameter ") + String(selectedParameters[i]->index) +String(" by ") + String(mutate) + String("%\n"));
-			lock = 0;
-#endif			
-			//get range
-			int max = child->getParamMax(selectedParameters[i]->index);
-			int min = child->getParamMin(selectedParameters[i]->index);
-			int range = child->getRange(selectedParameters[i]->index);
-			int value = child->getParameter(selectedParameters[i]->index);
-			rnd = (rand()%1000)/1000.f;
-			//mutate
-			bool add = (rnd>=0.5f);
-			
-			int newValue;
-			
-			if(add) newValue = value + range*mutate;
-			else newValue = value - range*mutate;
-
-			if(newValue> max) newValue=range;
-			if(newValue< min) newValue = 0;
-#ifdef LOG_VERBOSE
-			lock = new MessageManagerLock();
-			gloLogText->setText(gloLogText->getText() +  String("original value: ") + String(value) + String(" new value: ")+ String(newValue)+ String("\n") );
-			lock = 0;
-#endif
-			child->setParameter(selectedParameters[i]->index,newValue);
-		}
-	}
-	void selectParentParameters(Patch* father, Patch* mother, Patch* child)
-	{
-		#ifdef LOG_VERBOSE
-		ScopedPointer<MessageManagerLock> lock = new MessageManagerLock();
-		gloLogText->setText(gloLogText->getText() + String("Combining parent parameters...\n"));
-		gloLogText->setText(gloLogText->getText() + String("father: ") + father->getName() + String(" mother:") + mother->getName() + String("\n"));
-		lock = 0;
-#endif
-		//randomly select parameters from mother an father for child
-		for(int i=0;i<NUM_PARAMS;i++)
-		{
-			//generate a random number
-			float rnd = (rand()%100)/100.f;
-
-			if(rnd >= 0.5f)
-			{
-				//use father parameter
-				child->setParameter(i,father->getParameter(i));
+
+			taken[best] = true;
+			next.add(new Patch(*candidates.getMember(best)),candidates.getFitness(best));
+			for(int c=0;c<numCandidates;c++)
+			{
+				if(!taken[c]) closest[c] = jmin(closest[c],getDistance(candidates.getMember(c),candidates.getMember(best))*scale);
 			}
-			else
+		}
+	}
+
+	/** NSGA-II survival: the candidates go into next front by front, the least crowded first*/
+	void pickParetoChildren(const Population& candidates, Population& next, int numChildren)
+	{
+		TRACE_SCOPE("generator","pareto sort");
+		evaluateObjectives(candidates,next);
+		if(shouldStop()) return;
+		mParetoSorter.sort(mObjectives);
+
+		Array<int> order;
+		mParetoSorter.getOrder(order);
+		for(int i=0;i<order.size() && i<numChildren;i++)
+		{
+			next.add(new Patch(*candidates.getMember(order[i])),candidates.getFitness(order[i]));
+		}
+	}
+
+	/** fills mObjectives for the candidates. Novelty is the distance to the closest member of the
+		population or of next, both are only read*/
+	void evaluateObjectives(const Population& candidates, const Population& next)
+	{
+		const int numCandidates = candidates.getNumMembers();
+		mObjectives.setSize(numCandidates);
+
+		float* votes = mObjectives.getColumn(OBJECTIVE_VOTES);
+		for(int c=0;c<numCandidates;c++)
+		{
+			votes[c] = candidates.getFitness(c);
+		}
+
+		ObjectiveTask task(*this,candidates,next);
+		ParallelFor::getInstance()->execute(numCandidates,PARETO_GRAIN_SIZE,task);
+
+		if(!mHasSpectralTarget) return;
+
+		//every candidate is rendered, closer to the target is better. In batches, so a
+		//stopped speculation doesn't have to wait for all sounds
+		ParallelFor* parallel = ParallelFor::getInstance();
+		const int batchSize = parallel->getNumWorkers()*SPECTRAL_SOUNDS_PER_WORKER;
+		HeapBlock<PatchFeatures> features(jmax(1,numCandidates));
+		Array<const uint8_t*> values;
+		for(int begin=0;begin<numCandidates;begin+=batchSize)
+		{
+			if(shouldStop()) return;
+			values.clearQuick();
+			for(int c=begin;c<jmin(numCandidates,begin+batchSize);c++)
 			{
-				//use mother parameter
-				child->setParameter(i,mother->getParameter(i));
+				values.add(candidates.getMember(c)->getValues());
 			}
+			PatchFeatureExtractor::computeAll(values,features+begin);
+		}
+		float* spectral = mObjectives.getColumn(OBJECTIVE_SPECTRAL);
+		for(int c=0;c<numCandidates;c++)
+		{
+			spectral[c] = -features[c].getDistance(mSpectralTarget);
 		}
+	}
+
+	/** the surrogate score and the novelty of the candidates, on all cores*/
+	class ObjectiveTask : public ParallelTask
+	{
+	public:
+		ObjectiveTask(PatchGenerator& generator, const Population& candidates, const Population& next)
+		: mGenerator(generator),
+		mCandidates(candidates),
+		mNext(next)
+		{
+		};
+
+		void run(int begin, int end, int)
+		{
+			const Population& population = mGenerator.mPopulation;
+			const short* weights = mGenerator.mDistanceWeights.get();
+			const float scale = 1.f / mGenerator.mDistanceWeights.getMaxDistance();
+			const bool trained = mGenerator.mSurrogate.isTrained();
+			float* surrogate = mGenerator.mObjectives.getColumn(OBJECTIVE_SURROGATE);
+			float* novelty = mGenerator.mObjectives.getColumn(OBJECTIVE_NOVELTY);
+
+			for(int c=begin;c<end;c++)
+			{
+				const uint8_t* values = mCandidates.getMember(c)->getValues();
+				surrogate[c] = trained ? mGenerator.mSurrogate.score(values) : 0.f;
+
+				int closest = mGenerator.mDistanceWeights.getMaxDistance();
+				for(int i=0;i<population.getNumMembers();i++)
+				{
+					closest = jmin(closest,PatchDistance::weightedL1(values,population.getMember(i)->getValues(),weights));
+				}
+				for(int i=0;i<mNext.getNumMembers();i++)
+				{
+					closest = jmin(closest,PatchDistance::weightedL1(values,mNext.getMember(i)->getValues(),weights));
+				}
+				novelty[c] = closest*scale;
+			}
+		};
 
-		//increase generation no
-		child->setGeneration(father->getGeneration()+1);
+	private:
+		PatchGenerator& mGenerator;
+		const Population& mCandidates;
+		const Population& mNext;
+	};
+
+	int getDistance(Patch* a, Patch* b)
+	{
+		return PatchDistance::weightedL1(a->getValues(),b->getValues(),mDistanceWeights.get());
 	}
+
 	//returns number of found patches
 	int findParentPatches(String path,Array<File> &results)
 	{
 		File foundParents(path);
 		jassert(foundParents.exists());
-		return foundParents.findChildFiles(results,File::findFiles,false,"*.snd");
+
+		//only files that changed since the last start are read again
+		const File cacheFile = PatchIndex::getCacheFile(foundParents);
+		PatchIndex index;
+		index.load(cacheFile);
+		if(index.update(foundParents) > 0)
+		{
+			index.save(cacheFile);
+		}
+		index.getFiles(results);
+		return index.getNumEntries();
 	}
 private:
 	PresetLoader mPresetLoader;
 
 	float mMutationRate;		// amount of parameters that are assigned a random offset [0:1] = [0:100%]
 	float mMaxMutationOffset;	// the maximum amount y parameter can mutate [0:1] = [0:100%]
+	int mMutationDistribution;
+	MutationKernel mMutationKernel;
+
+	uint64 mSeed;	// run seed, every father gets its own stream of it
 
 	Array<File> mParentPatches;
+	ScopedPointer<PatchBatch> mParents;	// values and names of all parents while run() is breeding
+
+	File mOutputFolder;
+	int mOutputMode;
+	bool mIndexChildren;
+	int mCrossoverMode;
+	ParameterLocks mLocks;
+
+	int mRunMode;
+	Population mPopulation;
+	int mNumGenerations;
+
+	SurrogateModel mSurrogate;
+	ObjectArena<Patch> mCandidateArena;	// the candidates of the generation breedGeneration() is at
+	int mScreeningFactor;
+
+	float mDiversity;
+	float mDiversityCollapse;
+	DistanceWeights mDistanceWeights;
+	CriticalSection mStatsLock;
+	GenerationSummary mStats;			// of the population, under the lock
+	GenerationSummary mStartStats;		// of the population the last run started from, under the lock
+	GenerationSummary mSpeculationStats;	// of mSpeculation
+
+	int mSurvivalMode;
+	ObjectiveTable mObjectives;		// of the candidates of the generation breedGeneration() is at
+	ParetoSorter mParetoSorter;
+	PatchFeatures mSpectralTarget;
+	bool mHasSpectralTarget;
+
+	float mSpeculationThreshold;
+	Population mSpeculation;	// the next generation, bred while the user votes
+	bool mSpeculationReady;		// mSpeculation is complete, only read while the job isn't running
+
+	BackgroundJob::Ptr mJob;	// the current or last run or speculation
+	BackgroundJob::Listener* mJobListener;
+	BreedFarm* mFarm;			// not owned, NULL breeds here
+
+	int mCheckpointInterval;
+	int mRemainingGenerations;	// of the current run, > 0 after a run was stopped
+	uint32 mRandomState[FAST_RANDOM_STATE_SIZE];	// where the random stream of the current run is
+	CheckpointWriter mCheckpointWriter;
 
 	NameGenerator nameGen;
 };
\ No newline at end of file
@@ -0,0 +1,126 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./FlatHashMap.h"
+
+//---------------------------------------------------------------------------
+/** 64 bit hash over the NUM_PARAMS value bytes of a patch. The name is not
+	part of the hash, two patches that sound the same hash the same.
+	The bytes are mixed 8 at a time, so a patch costs about 31 multiplies.
+*/
+static uint64 hashPatchValues(const uint8_t* values)
+{
+	const uint64 multiplier = literal64bit(0x9e3779b97f4a7c15);
+	uint64 hash = literal64bit(0xcbf29ce484222325) ^ NUM_PARAMS;
+
+	int i = 0;
+	for(;i+8<=NUM_PARAMS;i+=8)
+	{
+		uint64 word;
+		memcpy(&word,values+i,8);
+		hash = (hash ^ word) * multiplier;
+		hash ^= hash >> 29;
+	}
+	for(;i<NUM_PARAMS;i++)
+	{
+		hash = (hash ^ values[i]) * multiplier;
+	}
+
+	//final avalanche so the low bits used by the hash table are well mixed
+	hash ^= hash >> 32;
+	hash *= multiplier;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+//---------------------------------------------------------------------------
+class PatchHashFunctions
+{
+public:
+	static int generateHash(const int64 key, const int upperLimit)
+	{
+		return (int)((uint64)key % (uint64)upperLimit);
+	};
+};
+//---------------------------------------------------------------------------
+/** Remembers which sounds have been seen, to skip or collapse duplicates.
+	Every hash maps to the index of the first patch that had it.
+*/
+class PatchHashSet
+{
+public:
+	PatchHashSet(int expectedSize=1024) : mHashes(expectedSize)
+	{
+	};
+
+	~PatchHashSet()
+	{
+	};
+
+	/** returns false (and keeps the first index) if the same values were added before*/
+	bool add(const uint8_t* values, int index)
+	{
+		return addHash(hashPatchValues(values),index);
+	};
+
+	/** the same with a hash from hashPatchValues(), for callers that hash on other threads*/
+	bool addHash(uint64 hash, int index)
+	{
+		if(mHashes.contains((int64)hash)) return false;
+
+		mHashes.set((int64)hash,index);
+		return true;
+	};
+
+	bool contains(const uint8_t* values) const
+	{
+		return mHashes.contains((int64)hashPatchValues(values));
+	};
+
+	/** index of the first patch with the same values or -1*/
+	int find(const uint8_t* values) const
+	{
+		const int* index = mHashes.find((int64)hashPatchValues(values));
+		return index != NULL ? *index : -1;
+	};
+
+	int size() const
+	{
+		return mHashes.size();
+	};
+
+	void clear()
+	{
+		mHashes.clear();
+	};
+
+private:
+	FlatHashMap<int64,int,PatchHashFunctions> mHashes;
+};
+//---------------------------------------------------------------------------
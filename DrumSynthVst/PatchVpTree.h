@@ -0,0 +1,287 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "PatchDistance.h"
+
+#define KNN_MAX_K	64
+#define KNN_NO_DISTANCE	0x3fffffff	// further than any two patches, can still be added to without overflow
+
+//---------------------------------------------------------------------------
+/** The k closest samples found so far, closest first*/
+class KNearest
+{
+public:
+	KNearest(int k) : mK(jlimit(1,KNN_MAX_K,k)), mNum(0)
+	{
+	};
+
+	/** keeps the sample if it is one of the k closest*/
+	void add(int sample, int distance)
+	{
+		if(mNum == mK && distance >= mDistances[mNum-1]) return;
+
+		int pos = (mNum < mK) ? mNum++ : mNum-1;
+		while(pos > 0 && mDistances[pos-1] > distance)
+		{
+			mDistances[pos] = mDistances[pos-1];
+			mSamples[pos] = mSamples[pos-1];
+			pos--;
+		}
+		mDistances[pos] = distance;
+		mSamples[pos] = sample;
+	};
+
+	/** the search radius, every sample further away can't get in any more*/
+	int getWorstDistance() const
+	{
+		return (mNum < mK) ? KNN_NO_DISTANCE : mDistances[mNum-1];
+	};
+
+	int size() const				{ return mNum; };
+	int getSample(int i) const		{ return mSamples[i]; };
+	int getDistance(int i) const	{ return mDistances[i]; };
+
+private:
+	int mK;
+	int mNum;
+	int mSamples[KNN_MAX_K];
+	int mDistances[KNN_MAX_K];
+};
+//---------------------------------------------------------------------------
+/** Vantage point tree over patch value vectors for k nearest neighbour queries.
+
+	The samples live in a table of NUM_PARAMS bytes per sample that the
+	caller owns, rows can be further apart than that to index records in
+	place. It is passed to build() and to every search, so the table may
+	move in memory between calls as long as the indexed rows stay the same. Every node splits the samples below it at the median L1 distance
+	to its vantage point, so a query only visits the branches that can
+	still hold a closer sample.
+*/
+class PatchVpTree
+{
+public:
+	PatchVpTree() : mRoot(-1), mStride(NUM_PARAMS)
+	{
+	};
+
+	/** index the first numSamples rows of data, a row starts every stride bytes*/
+	void build(const uint8_t* data, int numSamples, int stride = NUM_PARAMS)
+	{
+		mStride = stride;
+		mNodes.clearQuick();
+		mItems.malloc(jmax(1,numSamples));
+		for(int i=0;i<numSamples;i++)
+		{
+			mItems[i].sample = i;
+			mItems[i].distance = 0;
+		}
+		mNodes.ensureStorageAllocated(numSamples);
+		mRoot = buildNode(data,0,numSamples);
+		mItems.free();
+	};
+
+	void clear()
+	{
+		mNodes.clear();
+		mRoot = -1;
+	};
+
+	int getNumSamples() const
+	{
+		return mNodes.size();
+	};
+
+	/** the vantage point of the n-th node. the nodes of a subtree follow its root,
+		so samples next to each other in node order are mostly close*/
+	int getNodeSample(int n) const
+	{
+		return mNodes.getReference(n).sample;
+	};
+
+	void search(const uint8_t* data, const uint8_t* query, KNearest& result) const
+	{
+		if(mRoot >= 0) searchNode(data,query,mRoot,result);
+	};
+
+	/** the nodes, so a large tree doesn't have to be built again. the rows aren't written*/
+	void write(OutputStream& out) const
+	{
+		out.writeInt(mStride);
+		out.writeInt(mRoot);
+		out.writeInt(mNodes.size());
+		for(int i=0;i<mNodes.size();i++)
+		{
+			const Node& node = mNodes.getReference(i);
+			out.writeInt(node.sample);
+			out.writeInt(node.threshold);
+			out.writeInt(node.inside);
+			out.writeInt(node.outside);
+		}
+	};
+
+	/** a tree written by write() over numSamples rows. returns false if it doesn't fit them, the tree is empty then*/
+	bool read(InputStream& in, int numSamples, int stride = NUM_PARAMS)
+	{
+		clear();
+
+		const int writtenStride = in.readInt();
+		const int root = in.readInt();
+		const int numNodes = in.readInt();
+		if(writtenStride != stride || numNodes != numSamples || root < -1 || root >= numNodes) return false;
+		mStride = stride;
+
+		mNodes.ensureStorageAllocated(numNodes);
+		for(int i=0;i<numNodes && !in.isExhausted();i++)
+		{
+			Node node;
+			node.sample = in.readInt();
+			node.threshold = in.readInt();
+			node.inside = in.readInt();
+			node.outside = in.readInt();
+			if(node.sample < 0 || node.sample >= numSamples
+				|| node.inside < -1 || node.inside >= numNodes
+				|| node.outside < -1 || node.outside >= numNodes)
+			{
+				break;
+			}
+			mNodes.add(node);
+		}
+		if(mNodes.size() != numNodes)
+		{
+			clear();
+			return false;
+		}
+		mRoot = root;
+		return true;
+	};
+
+private:
+	struct Node
+	{
+		int sample;		// the vantage point
+		int threshold;	// median distance of the samples below
+		int inside;		// node with the samples closer than threshold, -1 if none
+		int outside;	// node with the other samples, -1 if none
+	};
+
+	struct Item
+	{
+		int sample;
+		int distance;
+	};
+
+	int buildNode(const uint8_t* data, int lo, int hi)
+	{
+		if(lo >= hi) return -1;
+
+		//the middle item as vantage point, the items are in no particular order
+		swapItems(lo,(lo+hi)/2);
+		const int nodeIndex = mNodes.size();
+		Node node;
+		node.sample = mItems[lo].sample;
+		node.threshold = 0;
+		node.inside = -1;
+		node.outside = -1;
+		mNodes.add(node);
+
+		if(hi - lo == 1) return nodeIndex;
+
+		const uint8_t* vantage = data + node.sample*mStride;
+		for(int i=lo+1;i<hi;i++)
+		{
+			mItems[i].distance = PatchDistance::l1(vantage,data + mItems[i].sample*mStride);
+		}
+
+		//[lo+1:median) is at most the threshold, [median:hi) at least
+		const int median = (lo+1+hi)/2;
+		selectNth(lo+1,hi,median);
+		const int threshold = mItems[median].distance;
+
+		const int inside = buildNode(data,lo+1,median);
+		const int outside = buildNode(data,median,hi);
+
+		//mNodes may have moved while the children were added
+		mNodes.getReference(nodeIndex).threshold = threshold;
+		mNodes.getReference(nodeIndex).inside = inside;
+		mNodes.getReference(nodeIndex).outside = outside;
+		return nodeIndex;
+	};
+
+	/** quickselect, afterwards the item at nth has the distance it would have when sorted*/
+	void selectNth(int lo, int hi, int nth)
+	{
+		hi--;
+		while(lo < hi)
+		{
+			const int pivot = mItems[(lo+hi)/2].distance;
+			int i = lo;
+			int j = hi;
+			while(i <= j)
+			{
+				while(mItems[i].distance < pivot) i++;
+				while(mItems[j].distance > pivot) j--;
+				if(i <= j) swapItems(i++,j--);
+			}
+			if(nth <= j) hi = j;
+			else if(nth >= i) lo = i;
+			else return;
+		}
+	};
+
+	void swapItems(int a, int b)
+	{
+		const Item tmp = mItems[a];
+		mItems[a] = mItems[b];
+		mItems[b] = tmp;
+	};
+
+	void searchNode(const uint8_t* data, const uint8_t* query, int nodeIndex, KNearest& result) const
+	{
+		const Node& node = mNodes.getReference(nodeIndex);
+		const int d = PatchDistance::l1(query,data + node.sample*mStride);
+		result.add(node.sample,d);
+
+		//visit the more likely side first, it shrinks the radius for the other one
+		if(d < node.threshold)
+		{
+			if(node.inside >= 0 && d - result.getWorstDistance() <= node.threshold) searchNode(data,query,node.inside,result);
+			if(node.outside >= 0 && d + result.getWorstDistance() >= node.threshold) searchNode(data,query,node.outside,result);
+		}
+		else
+		{
+			if(node.outside >= 0 && d + result.getWorstDistance() >= node.threshold) searchNode(data,query,node.outside,result);
+			if(node.inside >= 0 && d - result.getWorstDistance() <= node.threshold) searchNode(data,query,node.inside,result);
+		}
+	};
+
+	Array<Node> mNodes;
+	int mRoot;
+	int mStride;			// bytes from one row to the next
+	HeapBlock<Item> mItems;	// only used by build()
+};
+//---------------------------------------------------------------------------
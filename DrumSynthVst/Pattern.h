@@ -0,0 +1,390 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./controllerAssignments.h"
+#include "./EuclidTable.h"
+
+#define PATTERN_NUM_TRACKS		NUM_VOICES
+#define PATTERN_MAX_STEPS		128		// 16 main steps with 8 sub steps each, like the sequencer of the LXR
+#define PATTERN_STEP_WORDS		(PATTERN_MAX_STEPS/32)
+#define PATTERN_DEFAULT_LENGTH	16
+#define PATTERN_MAX_LOCKS		512		// locks of all tracks together
+
+// tracks, the step bits of all tracks, number of locks
+#define PATTERN_HEADER_SIZE		(PATTERN_NUM_TRACKS + PATTERN_NUM_TRACKS*PATTERN_MAX_STEPS/8 + 2)
+#define PATTERN_LOCK_SIZE		5		// track, step, parameter (2 bytes), value
+#define PATTERN_MAX_DATA_SIZE	(PATTERN_HEADER_SIZE + PATTERN_MAX_LOCKS*PATTERN_LOCK_SIZE)
+
+//---------------------------------------------------------------------------
+/** one value that a step plays instead of the sound value, e.g. PAR_STEP_VOLUME,
+	PAR_STEP_NOTE or a sound parameter*/
+struct PatternLock
+{
+	uint8_t track;
+	uint8_t step;
+	short parameterNr;
+	uint8_t value;
+
+	/** the locks of a pattern are sorted by this*/
+	int getKey() const
+	{
+		return getKey(track,step,parameterNr);
+	};
+
+	static int getKey(int track, int step, int parameterNr)
+	{
+		return (track<<24) | (step<<16) | parameterNr;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** One pattern of the sequencer: PATTERN_NUM_TRACKS tracks of up to
+	PATTERN_MAX_STEPS steps.
+
+	Whether a step plays is one bit, a track is PATTERN_STEP_WORDS words.
+	Everything else a step can change (volume, probability, note and the
+	parameter automation) is a sparse parameter lock, most steps have none.
+	The locks are kept sorted by track, step and parameter, so finding one
+	is a binary search and the locks of a step are next to each other.
+
+	write() and read() use a flat byte layout of at most PATTERN_MAX_DATA_SIZE
+	bytes, all numbers little endian:
+	lengths		one byte per track
+	steps		PATTERN_MAX_STEPS/8 bytes per track, bit n%8 of byte n/8 is step n
+	locks		the number of locks (2 bytes), then PATTERN_LOCK_SIZE bytes per lock
+	An empty pattern is PATTERN_HEADER_SIZE bytes, PatternSysEx sends it as one frame.
+*/
+class Pattern
+{
+public:
+	Pattern()
+	{
+		clear();
+	};
+
+	void clear()
+	{
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			mLengths[t] = PATTERN_DEFAULT_LENGTH;
+			clearSteps(t);
+		}
+		mLocks.clearQuick();
+	};
+
+	bool operator==(const Pattern& other) const
+	{
+		if(memcmp(mLengths,other.mLengths,sizeof(mLengths)) != 0
+			|| memcmp(mSteps,other.mSteps,sizeof(mSteps)) != 0
+			|| mLocks.size() != other.mLocks.size()) return false;
+
+		//the struct has padding, so the locks are compared one by one
+		for(int i=0;i<mLocks.size();i++)
+		{
+			const PatternLock& a = mLocks.getReference(i);
+			const PatternLock& b = other.mLocks.getReference(i);
+			if(a.getKey() != b.getKey() || a.value != b.value) return false;
+		}
+		return true;
+	};
+
+	bool operator!=(const Pattern& other) const
+	{
+		return !operator==(other);
+	};
+
+	//----- steps
+	int getLength(int track) const
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS));
+		return mLengths[track];
+	};
+
+	void setLength(int track, int length)
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS));
+		mLengths[track] = (uint8_t)jlimit(1,PATTERN_MAX_STEPS,length);
+	};
+
+	bool getStep(int track, int step) const
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS) && isPositiveAndBelow(step,PATTERN_MAX_STEPS));
+		return (mSteps[track][step/32] & (1u<<(step%32))) != 0;
+	};
+
+	void setStep(int track, int step, bool active)
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS) && isPositiveAndBelow(step,PATTERN_MAX_STEPS));
+		if(active)	mSteps[track][step/32] |= 1u<<(step%32);
+		else		mSteps[track][step/32] &= ~(1u<<(step%32));
+	};
+
+	/** 32 steps from firstStep on, firstStep has to be a multiple of 32. bit n is step firstStep+n*/
+	uint32 getStepWord(int track, int firstStep) const
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS) && firstStep%32 == 0);
+		return mSteps[track][firstStep/32];
+	};
+
+	void setStepWord(int track, int firstStep, uint32 steps)
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS) && firstStep%32 == 0);
+		mSteps[track][firstStep/32] = steps;
+	};
+
+	/** replaces the steps of a track with a euclidean rhythm and sets its length, the locks stay*/
+	void setEuclid(int track, int length, int numHits, int rotation = 0)
+	{
+		clearSteps(track);
+		setLength(track,jlimit(1,EUCLID_MAX_LENGTH,length));
+		mSteps[track][0] = getEuclidMask(length,numHits,rotation);
+	};
+
+	/** the active steps within the length of a track*/
+	int getNumActiveSteps(int track) const
+	{
+		int num = 0;
+		for(int i=0;i<mLengths[track];i++)
+		{
+			if(getStep(track,i)) num++;
+		}
+		return num;
+	};
+
+	/** removes the steps and the locks of a track, the length stays*/
+	void clearTrack(int track)
+	{
+		clearSteps(track);
+		const int start = findLock(PatternLock::getKey(track,0,0));
+		const int end = findLock(PatternLock::getKey(track+1,0,0));
+		mLocks.removeRange(start,end-start);
+	};
+
+	/** copies length, steps and locks of a track of another pattern (or of this one)*/
+	void copyTrack(const Pattern& source, int sourceTrack, int destTrack)
+	{
+		if(&source == this)
+		{
+			//clearTrack() would remove the locks that are copied
+			if(sourceTrack != destTrack) copyTrack(Pattern(source),sourceTrack,destTrack);
+			return;
+		}
+
+		clearTrack(destTrack);
+		mLengths[destTrack] = source.mLengths[sourceTrack];
+		memcpy(mSteps[destTrack],source.mSteps[sourceTrack],sizeof(mSteps[destTrack]));
+
+		for(int i=0;i<source.mLocks.size();i++)
+		{
+			const PatternLock& lock = source.mLocks.getReference(i);
+			if(lock.track == sourceTrack) setLock(destTrack,lock.step,lock.parameterNr,lock.value);
+		}
+	};
+
+	//----- parameter locks
+	int getNumLocks() const
+	{
+		return mLocks.size();
+	};
+
+	/** in key order*/
+	const PatternLock& getLock(int index) const
+	{
+		return mLocks.getReference(index);
+	};
+
+	/** index of the first lock of a step, its locks follow up to the first one of another step*/
+	int getFirstLock(int track, int step) const
+	{
+		return findLock(PatternLock::getKey(track,step,0));
+	};
+
+	/** true and the value if the step has a lock for the parameter*/
+	bool getLock(int track, int step, int parameterNr, uint8_t& value) const
+	{
+		const int key = PatternLock::getKey(track,step,parameterNr);
+		const int index = findLock(key);
+		if(index >= mLocks.size() || mLocks.getReference(index).getKey() != key) return false;
+
+		value = mLocks.getReference(index).value;
+		return true;
+	};
+
+	/** adds or changes a lock. returns false if the pattern already has PATTERN_MAX_LOCKS locks*/
+	bool setLock(int track, int step, int parameterNr, uint8_t value)
+	{
+		jassert(isPositiveAndBelow(track,PATTERN_NUM_TRACKS) && isPositiveAndBelow(step,PATTERN_MAX_STEPS));
+		jassert(isPositiveAndBelow(parameterNr,NUM_PARAMS));
+
+		const int key = PatternLock::getKey(track,step,parameterNr);
+		const int index = findLock(key);
+		if(index < mLocks.size() && mLocks.getReference(index).getKey() == key)
+		{
+			mLocks.getReference(index).value = value;
+			return true;
+		}
+		if(mLocks.size() >= PATTERN_MAX_LOCKS) return false;
+
+		PatternLock lock;
+		lock.track = (uint8_t)track;
+		lock.step = (uint8_t)step;
+		lock.parameterNr = (short)parameterNr;
+		lock.value = value;
+		mLocks.insert(index,lock);
+		return true;
+	};
+
+	void removeLock(int track, int step, int parameterNr)
+	{
+		const int key = PatternLock::getKey(track,step,parameterNr);
+		const int index = findLock(key);
+		if(index < mLocks.size() && mLocks.getReference(index).getKey() == key) mLocks.remove(index);
+	};
+
+	/** removes all locks of a step*/
+	void clearLocks(int track, int step)
+	{
+		const int start = findLock(PatternLock::getKey(track,step,0));
+		const int end = findLock(PatternLock::getKey(track,step+1,0));
+		mLocks.removeRange(start,end-start);
+	};
+
+	//----- byte layout
+	int getDataSize() const
+	{
+		return PATTERN_HEADER_SIZE + mLocks.size()*PATTERN_LOCK_SIZE;
+	};
+
+	/** writes getDataSize() bytes, data has to hold PATTERN_MAX_DATA_SIZE bytes. returns the size*/
+	int write(uint8_t* data) const
+	{
+		int pos = 0;
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			data[pos++] = mLengths[t];
+		}
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			for(int w=0;w<PATTERN_STEP_WORDS;w++)
+			{
+				for(int b=0;b<4;b++)
+				{
+					data[pos++] = (uint8_t)(mSteps[t][w]>>(b*8));
+				}
+			}
+		}
+		data[pos++] = (uint8_t)mLocks.size();
+		data[pos++] = (uint8_t)(mLocks.size()>>8);
+
+		for(int i=0;i<mLocks.size();i++)
+		{
+			const PatternLock& lock = mLocks.getReference(i);
+			data[pos++] = lock.track;
+			data[pos++] = lock.step;
+			data[pos++] = (uint8_t)lock.parameterNr;
+			data[pos++] = (uint8_t)(lock.parameterNr>>8);
+			data[pos++] = lock.value;
+		}
+		jassert(pos == getDataSize());
+		return pos;
+	};
+
+	/** reads what write() wrote. returns false and leaves the pattern unchanged if the data is invalid*/
+	bool read(const uint8_t* data, int size)
+	{
+		if(size < PATTERN_HEADER_SIZE) return false;
+
+		const int numLocks = data[PATTERN_HEADER_SIZE-2] | (data[PATTERN_HEADER_SIZE-1]<<8);
+		if(numLocks > PATTERN_MAX_LOCKS || size != PATTERN_HEADER_SIZE + numLocks*PATTERN_LOCK_SIZE) return false;
+
+		Pattern result;
+		int pos = 0;
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			if(data[pos] < 1 || data[pos] > PATTERN_MAX_STEPS) return false;
+			result.mLengths[t] = data[pos++];
+		}
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			for(int w=0;w<PATTERN_STEP_WORDS;w++)
+			{
+				result.mSteps[t][w] = ByteOrder::littleEndianInt(data+pos);
+				pos += 4;
+			}
+		}
+		pos += 2;
+
+		result.mLocks.ensureStorageAllocated(numLocks);
+		for(int i=0;i<numLocks;i++)
+		{
+			PatternLock lock;
+			lock.track = data[pos++];
+			lock.step = data[pos++];
+			lock.parameterNr = (short)(data[pos] | (data[pos+1]<<8));
+			pos += 2;
+			lock.value = data[pos++];
+
+			//the keys have to be valid and strictly ascending, or the searches fail
+			if(lock.track >= PATTERN_NUM_TRACKS || lock.step >= PATTERN_MAX_STEPS
+				|| lock.parameterNr < 0 || lock.parameterNr >= NUM_PARAMS) return false;
+			if(i > 0 && lock.getKey() <= result.mLocks.getLast().getKey()) return false;
+			result.mLocks.add(lock);
+		}
+
+		*this = result;
+		return true;
+	};
+
+private:
+	void clearSteps(int track)
+	{
+		for(int w=0;w<PATTERN_STEP_WORDS;w++)
+		{
+			mSteps[track][w] = 0;
+		}
+	};
+
+	/** the index of the first lock with a key >= key*/
+	int findLock(int key) const
+	{
+		int start = 0;
+		int end = mLocks.size();
+		while(start < end)
+		{
+			const int mid = (start+end)/2;
+			if(mLocks.getReference(mid).getKey() < key)	start = mid+1;
+			else										end = mid;
+		}
+		return start;
+	};
+
+	uint8_t mLengths[PATTERN_NUM_TRACKS];
+	uint32 mSteps[PATTERN_NUM_TRACKS][PATTERN_STEP_WORDS];
+	Array<PatternLock> mLocks;		// sorted by getKey()
+};
+//---------------------------------------------------------------------------
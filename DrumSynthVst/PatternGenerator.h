@@ -0,0 +1,384 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Pattern.h"
+#include "./EuclidTable.h"
+#include "./Population.h"
+#include "./Crossover.h"
+#include "./FastRandom.h"
+#include "./Patch.h"
+#include "./ParallelFor.h"
+#include "./Trace.h"
+
+#define PATTERN_BREED_GRAIN				32		// children a worker takes at once
+#define DEFAULT_STEP_MUTATION_RATE		0.05f	// chance of a step to flip
+#define DEFAULT_ROTATION_RATE			0.1f	// chance of a track to be moved by one step
+#define DEFAULT_TRACK_SWAP_RATE			0.5f	// chance of a track to come whole from one parent
+#define PATTERN_RANDOM_MAX_HITS			8		// of the euclidean tracks seedRandom() starts with
+
+//---------------------------------------------------------------------------
+/** A pattern in a PatternPopulation, with its vote*/
+class PatternCandidate
+{
+public:
+	PatternCandidate() : mLike(NOT_VOTED), mGeneration(0)
+	{
+	};
+
+	Pattern& getPattern()
+	{
+		return mPattern;
+	};
+
+	void setOpinion(int op)
+	{
+		mLike = op;
+	};
+
+	int getOpinion()
+	{
+		return mLike;
+	};
+
+	void setGeneration(int generation)
+	{
+		mGeneration = generation;
+	};
+
+	int getGeneration()
+	{
+		return mGeneration;
+	};
+
+private:
+	Pattern mPattern;
+	int mLike;
+	int mGeneration;
+};
+
+typedef PopulationOf<PatternCandidate> PatternPopulation;
+
+//---------------------------------------------------------------------------
+/** Breeds drum patterns the way PatchGenerator breeds sounds.
+
+	The population, the votes and the parent selection are the same as for
+	patches (PopulationOf). A child gets every track either whole from one
+	parent, or step by step with a Crossover mask over the father's length,
+	each step bringing its parameter locks along. Then steps flip with the
+	step mutation rate and a track is sometimes moved by one step, which
+	keeps the groove but shifts its accent.
+
+	breed() spreads the children over all cpus. Every child has its own
+	random stream of the seed, the generation and its number, so the same
+	seed and votes give the same children however they are scheduled.
+	Nothing is allocated per step, thousands of children take a few ms.
+*/
+class PatternGenerator
+{
+public:
+	PatternGenerator()
+	{
+		//a new sequence for every session, setSeed() repeats a run
+		mSeed = (uint64)Time::currentTimeMillis();
+		mCrossoverMode = CROSSOVER_UNIFORM;
+		mStepMutationRate = DEFAULT_STEP_MUTATION_RATE;
+		mRotationRate = DEFAULT_ROTATION_RATE;
+		mTrackSwapRate = DEFAULT_TRACK_SWAP_RATE;
+	};
+
+	~PatternGenerator()
+	{
+	};
+
+	void setSeed(uint64 seed)
+	{
+		mSeed = seed;
+	};
+
+	uint64 getSeed() const
+	{
+		return mSeed;
+	};
+
+	/** how the steps of a mixed track are split, see Crossover*/
+	void setCrossoverMode(int mode)
+	{
+		jassert(mode == CROSSOVER_UNIFORM || mode == CROSSOVER_ONE_POINT || mode == CROSSOVER_TWO_POINT);
+		mCrossoverMode = mode;
+	};
+
+	void setStepMutationRate(float rate)
+	{
+		mStepMutationRate = jlimit(0.f,1.f,rate);
+	};
+
+	void setRotationRate(float rate)
+	{
+		mRotationRate = jlimit(0.f,1.f,rate);
+	};
+
+	void setTrackSwapRate(float rate)
+	{
+		mTrackSwapRate = jlimit(0.f,1.f,rate);
+	};
+
+	/** vote on the members, then call nextGeneration()*/
+	PatternPopulation& getPopulation()
+	{
+		return mPopulation;
+	};
+
+	/** starts again with the given patterns as the first generation*/
+	void setParents(const Array<Pattern>& parents)
+	{
+		mPopulation.clear();
+		for(int i=0;i<parents.size();i++)
+		{
+			PatternCandidate* candidate = new PatternCandidate();
+			candidate->getPattern() = parents.getReference(i);
+			mPopulation.add(candidate);
+		}
+	};
+
+	/** starts again with numPatterns random euclidean grooves, for when there is nothing to breed from*/
+	void seedRandom(int numPatterns)
+	{
+		mPopulation.clear();
+		FastRandom random(mSeed,0);
+		for(int i=0;i<numPatterns;i++)
+		{
+			PatternCandidate* candidate = new PatternCandidate();
+			for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+			{
+				const int length = EUCLID_MAX_LENGTH;
+				candidate->getPattern().setEuclid(t,length,random.nextInt(PATTERN_RANDOM_MAX_HITS+1),random.nextInt(length));
+			}
+			mPopulation.add(candidate);
+		}
+	};
+
+	/** breeds numChildren from the population into children, which is cleared first.
+		returns false if there are less than two parents that aren't disliked*/
+	bool breed(int numChildren, PatternPopulation& children)
+	{
+		children.clear();
+		if(mPopulation.getNumBreedable() < 2) return false;
+
+		const int generation = mPopulation.getGeneration()+1;
+		HeapBlock<ChildInfo> infos(jmax(1,numChildren));
+		OwnedArray<PatternCandidate> results;
+		results.ensureStorageAllocated(numChildren);
+		for(int i=0;i<numChildren;i++)
+		{
+			results.add(new PatternCandidate());
+		}
+
+		BreedTask task(*this,generation,results,infos);
+		ParallelFor::getInstance()->execute(numChildren,PATTERN_BREED_GRAIN,task);
+
+		//in child order, so the result doesn't depend on the scheduling
+		for(int i=0;i<numChildren;i++)
+		{
+			results[i]->setGeneration(generation);
+			children.add(results[i],mPopulation.getChildFitness(infos[i].father,infos[i].mother));
+		}
+		results.clear(false);
+		children.setGeneration(generation);
+		return true;
+	};
+
+	/** replaces the population with its elites and children up to the population size.
+		returns false if there are less than two parents*/
+	bool nextGeneration()
+	{
+		Array<int> elites;
+		mPopulation.getElites(elites);
+
+		PatternPopulation children;
+		if(!breed(jmax(0,mPopulation.getSize()-elites.size()),children)) return false;
+
+		PatternPopulation next;
+		for(int i=0;i<elites.size();i++)
+		{
+			PatternCandidate* elite = new PatternCandidate(*mPopulation.getMember(elites[i]));
+			next.add(elite,mPopulation.getFitness(elites[i]));
+		}
+		for(int i=0;i<children.getNumMembers();i++)
+		{
+			next.add(new PatternCandidate(*children.getMember(i)),children.getInheritedFitness(i));
+		}
+		next.setGeneration(children.getGeneration());
+		mPopulation.swapWith(next);
+		mPopulation.setGeneration(next.getGeneration());
+		return true;
+	};
+
+	/** one child of two patterns*/
+	void generateChild(const Pattern& father, const Pattern& mother, Pattern& child, FastRandom& random) const
+	{
+		child.clear();
+		for(int t=0;t<PATTERN_NUM_TRACKS;t++)
+		{
+			if(random.nextFloat() < mTrackSwapRate)
+			{
+				child.copyTrack(random.nextBool() ? mother : father,t,t);
+			}
+			else
+			{
+				mixTrack(father,mother,t,child,random);
+			}
+			mutateTrack(child,t,random);
+		}
+	};
+
+private:
+	struct ChildInfo
+	{
+		int father;
+		int mother;
+	};
+
+	/** one child per item*/
+	class BreedTask : public ParallelTask
+	{
+	public:
+		BreedTask(const PatternGenerator& generator, int generation, OwnedArray<PatternCandidate>& results, ChildInfo* infos)
+		: mGenerator(generator),
+		mGeneration(generation),
+		mResults(results),
+		mInfos(infos)
+		{
+		};
+
+		void run(int begin, int end, int /*workerIndex*/)
+		{
+			TRACE_SCOPE("generator","breed patterns");
+			const PatternPopulation& population = mGenerator.mPopulation;
+			for(int i=begin;i<end;i++)
+			{
+				//one stream per child keeps the run reproducible
+				FastRandom random(mGenerator.mSeed ^ ((uint64)mGeneration<<32),i);
+				const int father = population.select(random);
+				const int mother = population.select(random,father);
+				mInfos[i].father = father;
+				mInfos[i].mother = mother;
+
+				mGenerator.generateChild(population.getMember(father)->getPattern(),
+					population.getMember(mother)->getPattern(),mResults[i]->getPattern(),random);
+			}
+		};
+
+	private:
+		const PatternGenerator& mGenerator;
+		const int mGeneration;
+		OwnedArray<PatternCandidate>& mResults;
+		ChildInfo* mInfos;
+	};
+
+	/** the steps below the father's length from a Crossover mask, every step with its locks*/
+	void mixTrack(const Pattern& father, const Pattern& mother, int track, Pattern& child, FastRandom& random) const
+	{
+		const int length = father.getLength(track);
+		child.setLength(track,length);
+
+		uint8_t motherMask[PATTERN_MAX_STEPS/8];
+		zeromem(motherMask,sizeof(motherMask));
+		if(length > 1)	Crossover::fillMask(mCrossoverMode,motherMask,length,random);
+		else			motherMask[0] = random.nextBool() ? 1 : 0;
+
+		for(int w=0;w<PATTERN_STEP_WORDS;w++)
+		{
+			const uint32 fromMother = ByteOrder::littleEndianInt(motherMask+w*4);
+			const uint32 f = father.getStepWord(track,w*32);
+			const uint32 m = mother.getStepWord(track,w*32);
+			child.setStepWord(track,w*32,f ^ ((f ^ m) & fromMother));
+		}
+
+		copyLocks(father,track,motherMask,false,child);
+		copyLocks(mother,track,motherMask,true,child);
+	};
+
+	/** the locks of the steps the mask gives to this parent*/
+	static void copyLocks(const Pattern& parent, int track, const uint8_t* motherMask, bool isMother, Pattern& child)
+	{
+		for(int i=0;i<parent.getNumLocks();i++)
+		{
+			const PatternLock& lock = parent.getLock(i);
+			if(lock.track != track) continue;
+
+			const bool stepFromMother = (motherMask[lock.step>>3] & (1<<(lock.step&7))) != 0;
+			if(stepFromMother == isMother) child.setLock(track,lock.step,lock.parameterNr,lock.value);
+		}
+	};
+
+	void mutateTrack(Pattern& child, int track, FastRandom& random) const
+	{
+		const int length = child.getLength(track);
+
+		//an integer threshold, so a step costs one random number and a compare
+		const uint32 threshold = (uint32)(mStepMutationRate * 4294967295.0);
+		for(int step=0;step<length;step++)
+		{
+			if(random.next() < threshold) child.setStep(track,step,!child.getStep(track,step));
+		}
+
+		if(length > 1 && random.nextFloat() < mRotationRate)
+		{
+			rotateTrack(child,track,random.nextBool() ? 1 : length-1);
+		}
+	};
+
+	/** moves the steps of a track by amount within its length, the locks move along*/
+	static void rotateTrack(Pattern& pattern, int track, int amount)
+	{
+		const int length = pattern.getLength(track);
+		Pattern rotated;
+		rotated.setLength(track,length);
+		for(int step=0;step<length;step++)
+		{
+			if(pattern.getStep(track,step)) rotated.setStep(track,(step+amount)%length,true);
+		}
+		for(int i=0;i<pattern.getNumLocks();i++)
+		{
+			const PatternLock& lock = pattern.getLock(i);
+			if(lock.track != track) continue;
+
+			const int step = lock.step < length ? (lock.step+amount)%length : lock.step;
+			rotated.setLock(track,step,lock.parameterNr,lock.value);
+		}
+		pattern.copyTrack(rotated,track,track);
+	};
+
+	PatternPopulation mPopulation;
+
+	uint64 mSeed;
+	int mCrossoverMode;
+	float mStepMutationRate;
+	float mRotationRate;
+	float mTrackSwapRate;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,443 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Trace.h"
+#include "./ThreadPriorities.h"
+
+#define PIPELINE_QUEUE_CAPACITY		4		// items between two stages before the one in front waits
+#define PIPELINE_STOP_TIMEOUT_MS	2000
+
+//---------------------------------------------------------------------------
+/** What flows through a Pipeline. The sequence number is given by
+	Pipeline::push(), the items don't belong to the pipeline.
+*/
+class PipelineItem
+{
+public:
+	PipelineItem() : sequence(0)
+	{
+	};
+
+	virtual ~PipelineItem()
+	{
+	};
+
+	int sequence;
+};
+
+//---------------------------------------------------------------------------
+/** A bounded queue of items that blocks the writers while it's full and the
+	readers while it's empty. After close() writes fail and the readers get
+	what is left, then NULL. Every wake up is passed on while the condition
+	still holds, so the auto reset events never lose a waiting thread.
+*/
+class PipelineQueue
+{
+public:
+	PipelineQueue(int capacity) : mCapacity(capacity), mClosed(false)
+	{
+		jassert(capacity > 0);
+	};
+
+	/** false if the queue was closed, the item isn't queued then. waitedTicks gets the time spent waiting*/
+	bool push(PipelineItem* item, int64& waitedTicks)
+	{
+		const ScopedLock lock(mLock);
+		while(mItems.size() >= mCapacity && !mClosed)
+		{
+			const ScopedUnlock unlock(mLock);
+			const int64 start = Time::getHighResolutionTicks();
+			mNotFull.wait(-1);
+			waitedTicks += Time::getHighResolutionTicks() - start;
+		}
+		if(mClosed) return false;
+
+		mItems.add(item);
+		mNotEmpty.signal();
+		if(mItems.size() < mCapacity) mNotFull.signal();
+		return true;
+	};
+
+	/** the oldest item, NULL when the queue is closed and empty or after timeoutMs (-1 waits for ever)*/
+	PipelineItem* pop(int timeoutMs, int64& waitedTicks)
+	{
+		const ScopedLock lock(mLock);
+		while(mItems.size() == 0 && !mClosed)
+		{
+			bool signalled;
+			{
+				const ScopedUnlock unlock(mLock);
+				const int64 start = Time::getHighResolutionTicks();
+				signalled = mNotEmpty.wait(timeoutMs);
+				waitedTicks += Time::getHighResolutionTicks() - start;
+			}
+			if(!signalled && mItems.size() == 0) return NULL;
+		}
+		if(mItems.size() == 0)
+		{
+			//closed, the other readers have to see it too
+			mNotEmpty.signal();
+			return NULL;
+		}
+
+		PipelineItem* item = mItems.remove(0);
+		mNotFull.signal();
+		if(mItems.size() > 0) mNotEmpty.signal();
+		return item;
+	};
+
+	void close()
+	{
+		const ScopedLock lock(mLock);
+		mClosed = true;
+		mNotEmpty.signal();
+		mNotFull.signal();
+	};
+
+	bool isClosed() const
+	{
+		const ScopedLock lock(mLock);
+		return mClosed;
+	};
+
+private:
+	CriticalSection mLock;
+	WaitableEvent mNotFull;
+	WaitableEvent mNotEmpty;
+	Array<PipelineItem*> mItems;
+	const int mCapacity;
+	bool mClosed;
+};
+
+//---------------------------------------------------------------------------
+/** One step of a Pipeline. process() is called for every item on one of
+	the workers of the stage, then the item goes on to the next stage.
+	Every item passes every stage, a stage that filters marks the item.
+
+	An ordered stage has one worker and gets the items in the order they
+	were pushed, e.g. to number or to write them. The others run
+	getNumWorkers() items at once, in any order. State kept per worker
+	index needs no lock.
+
+	The counters are kept per worker, read them when the pipeline is done.
+*/
+class PipelineStage
+{
+public:
+	/** name is a literal, the trace keeps the pointer*/
+	PipelineStage(const char* name, int numWorkers, bool ordered)
+	: mName(name),
+	mNumWorkers(ordered ? 1 : jmax(1,numWorkers)),
+	mOrdered(ordered)
+	{
+	};
+
+	virtual ~PipelineStage()
+	{
+	};
+
+	virtual void process(PipelineItem* item, int workerIndex) = 0;
+
+	const char* getName() const
+	{
+		return mName;
+	};
+
+	int getNumWorkers() const
+	{
+		return mNumWorkers;
+	};
+
+	bool isOrdered() const
+	{
+		return mOrdered;
+	};
+
+	//--- counters, summed over the workers ---
+	int getNumItems() const
+	{
+		int num = 0;
+		for(int i=0;i<mCounters.size();i++) num += mCounters.getReference(i).items;
+		return num;
+	};
+
+	/** time spent in process()*/
+	double getBusySeconds() const
+	{
+		return sumTicks(&Counters::busy);
+	};
+
+	/** time spent waiting for items, the stages in front are slower*/
+	double getStarvedSeconds() const
+	{
+		return sumTicks(&Counters::starved);
+	};
+
+	/** time spent waiting for room in the next queue, the stages behind are slower*/
+	double getBlockedSeconds() const
+	{
+		return sumTicks(&Counters::blocked);
+	};
+
+	/** items per second of process() time of one worker, times the workers*/
+	double getThroughput() const
+	{
+		const double busy = getBusySeconds();
+		return busy > 0.0 ? getNumItems()*mNumWorkers/busy : 0.0;
+	};
+
+private:
+	friend class Pipeline;
+
+	struct Counters
+	{
+		Counters() : items(0), busy(0), starved(0), blocked(0)
+		{
+		};
+
+		int items;
+		int64 busy;
+		int64 starved;
+		int64 blocked;
+		char padding[32];	// the workers write their own counters, keep them off one cache line
+	};
+
+	double sumTicks(int64 Counters::* field) const
+	{
+		int64 ticks = 0;
+		for(int i=0;i<mCounters.size();i++) ticks += mCounters.getReference(i).*field;
+		return Time::highResolutionTicksToSeconds(ticks);
+	};
+
+	const char* const mName;
+	const int mNumWorkers;
+	const bool mOrdered;
+	Array<Counters> mCounters;	// by worker, sized by Pipeline::start()
+};
+
+//---------------------------------------------------------------------------
+/** Stages connected by bounded queues, every stage on its own threads.
+
+	push() hands an item to the first stage and waits while its queue is
+	full, pop() takes the items that have passed the last stage. A stage
+	whose next queue is full waits too, so a slow stage holds up the ones
+	in front of it instead of letting the items pile up, and the counters
+	show which one it is. The caller bounds the number of items in flight
+	itself, the queue behind the last stage is never full.
+
+	finish() says that no more items come, the stages then run dry and
+	pop() returns NULL once the last item is out. stop() gives up, the
+	items in flight stay where they are and are the caller's to delete.
+*/
+class Pipeline
+{
+public:
+	Pipeline(int queueCapacity = PIPELINE_QUEUE_CAPACITY)
+	: mQueueCapacity(queueCapacity),
+	mNextSequence(0),
+	mInFlight(0)
+	{
+	};
+
+	~Pipeline()
+	{
+		stop();
+	};
+
+	/** in order, before start(). The stage isn't owned*/
+	void addStage(PipelineStage* stage)
+	{
+		jassert(mWorkers.size() == 0);
+		mStages.add(stage);
+	};
+
+	void start()
+	{
+		jassert(mStages.size() > 0);
+		for(int s=0;s<mStages.size();s++)
+		{
+			mQueues.add(new PipelineQueue(mQueueCapacity));
+		}
+		mQueues.add(new PipelineQueue(INT_MAX));
+
+		for(int s=0;s<mStages.size();s++)
+		{
+			PipelineStage* stage = mStages[s];
+			stage->mCounters.clearQuick();
+			stage->mCounters.insertMultiple(0,PipelineStage::Counters(),stage->getNumWorkers());
+			mRunning.add(new Atomic<int>(stage->getNumWorkers()));
+			for(int w=0;w<stage->getNumWorkers();w++)
+			{
+				Worker* worker = new Worker(*this,s,w);
+				mWorkers.add(worker);
+				worker->startThread(PRIORITY_CLASS_BACKGROUND);
+			}
+		}
+	};
+
+	/** numbers the item and queues it for the first stage, false after stop()*/
+	bool push(PipelineItem* item)
+	{
+		item->sequence = mNextSequence++;
+		int64 waited = 0;
+		if(!mQueues.getFirst()->push(item,waited)) return false;
+		++mInFlight;
+		return true;
+	};
+
+	/** an item that passed all stages, in the order of the last stage. NULL after timeoutMs, or once
+		finish() was called and everything is out*/
+	PipelineItem* pop(int timeoutMs = -1)
+	{
+		int64 waited = 0;
+		PipelineItem* item = mQueues.getLast()->pop(timeoutMs,waited);
+		if(item != NULL) --mInFlight;
+		return item;
+	};
+
+	/** pushed but not popped yet*/
+	int getNumInFlight() const
+	{
+		return mInFlight.get();
+	};
+
+	/** no more push(), the stages finish what they have*/
+	void finish()
+	{
+		mQueues.getFirst()->close();
+	};
+
+	/** finish() was called and pop() has returned every item*/
+	bool isDone() const
+	{
+		return mQueues.size() > 0 && mQueues.getFirst()->isClosed() && mInFlight.get() == 0;
+	};
+
+	/** closes every queue and waits for the workers, a stage finishes the item it has*/
+	void stop()
+	{
+		for(int i=0;i<mQueues.size();i++)
+		{
+			mQueues[i]->close();
+		}
+		for(int i=0;i<mWorkers.size();i++)
+		{
+			mWorkers[i]->stopThread(PIPELINE_STOP_TIMEOUT_MS);
+		}
+		mWorkers.clear();
+	};
+
+	/** one line per stage: items, workers, items per second and where the time went*/
+	String getReport() const
+	{
+		String report;
+		for(int s=0;s<mStages.size();s++)
+		{
+			const PipelineStage* stage = mStages[s];
+			report << String(stage->getName()) << ": " << stage->getNumItems() << " items, " << stage->getNumWorkers()
+				<< (stage->getNumWorkers() == 1 ? " worker, " : " workers, ") << String(stage->getThroughput(),1) << " items/s, "
+				<< String(stage->getBusySeconds()*1000.0,1) << " ms busy, " << String(stage->getStarvedSeconds()*1000.0,1) << " ms starved, "
+				<< String(stage->getBlockedSeconds()*1000.0,1) << " ms blocked\n";
+		}
+		return report;
+	};
+
+private:
+	class Worker : public Thread
+	{
+	public:
+		Worker(Pipeline& owner, int stageIndex, int workerIndex)
+		: Thread(owner.mStages[stageIndex]->getName()),
+		mOwner(owner),
+		mStageIndex(stageIndex),
+		mWorkerIndex(workerIndex)
+		{
+		};
+
+		void run()
+		{
+			PipelineStage& stage = *mOwner.mStages[mStageIndex];
+			PipelineQueue& input = *mOwner.mQueues[mStageIndex];
+			PipelineQueue& output = *mOwner.mQueues[mStageIndex+1];
+			PipelineStage::Counters& counters = stage.mCounters.getReference(mWorkerIndex);
+
+			//an ordered stage holds back the items that overtook one on a parallel stage
+			Array<PipelineItem*> pending;
+			int nextSequence = 0;
+			bool running = true;
+			while(running && !threadShouldExit())
+			{
+				//a pipeline is background work, it waits while the user edits or listens
+				if(UserActivity::pauseIfActive()) continue;
+				PipelineItem* item = input.pop(-1,counters.starved);
+				if(item == NULL) break;
+
+				if(!stage.isOrdered())
+				{
+					running = processItem(stage,counters,item,output);
+					continue;
+				}
+
+				int pos = pending.size();
+				while(pos > 0 && pending.getUnchecked(pos-1)->sequence > item->sequence) pos--;
+				pending.insert(pos,item);
+				while(running && pending.size() > 0 && pending.getFirst()->sequence == nextSequence)
+				{
+					running = processItem(stage,counters,pending.remove(0),output);
+					nextSequence++;
+				}
+			}
+
+			//the last worker of a stage that ran dry lets the next one run dry
+			if(--*mOwner.mRunning[mStageIndex] == 0) output.close();
+		};
+
+	private:
+		bool processItem(PipelineStage& stage, PipelineStage::Counters& counters, PipelineItem* item, PipelineQueue& output)
+		{
+			TRACE_SCOPE("pipeline",stage.getName());
+			const int64 start = Time::getHighResolutionTicks();
+			stage.process(item,mWorkerIndex);
+			counters.busy += Time::getHighResolutionTicks() - start;
+			counters.items++;
+			return output.push(item,counters.blocked);
+		};
+
+		Pipeline& mOwner;
+		const int mStageIndex;
+		const int mWorkerIndex;
+	};
+
+	const int mQueueCapacity;
+	Array<PipelineStage*> mStages;
+	OwnedArray<PipelineQueue> mQueues;		// the input of every stage, then the output of the last one
+	OwnedArray<Atomic<int> > mRunning;		// workers per stage that haven't run dry
+	OwnedArray<Worker> mWorkers;
+	int mNextSequence;
+	Atomic<int> mInFlight;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,212 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../Midi/MidiEncoder.h"
+#include "../Midi/MidiTransmitter.h"
+
+#define AUTOMATION_MAX_RATE			50		// updates per second and parameter
+#define AUTOMATION_THRESHOLD		2		// smaller steps wait until the lane has settled
+#define AUTOMATION_BURST_MS			10.0	// bytes the link may take at once, in ms of its speed
+
+//---------------------------------------------------------------------------
+/** Thins out host automation so it fits the MIDI input of the synth.
+
+	A host can write a new value every sample, the synth gets at most
+	getMaxRate() updates per second for a parameter. A change smaller than
+	the threshold waits until the parameter hasn't moved for one update
+	interval, so slow ramps aren't sent step by step but the value a lane
+	stops at is always sent exactly.
+
+	All parameters share one byte budget, a token bucket filled at the link
+	speed. Other traffic (edits, dumps) is charged with sent(), so
+	automation yields to it. When the budget runs out the next block starts
+	with the parameter that had to wait, so no voice is starved.
+
+	Audio thread only, apart from the setters.
+*/
+class AutomationDecimator
+{
+public:
+	AutomationDecimator()
+	{
+		mSampleRate = 44100.0;
+		mMaxRate = AUTOMATION_MAX_RATE;
+		mThreshold = AUTOMATION_THRESHOLD;
+		mLinkSpeed = LINK_SPEED_DIN;
+		reset();
+	};
+
+	/** forget what was sent, the next value of every parameter goes out*/
+	void reset()
+	{
+		mTime = 0;
+		mBudget = 0.0;
+		mNextParameter = 0;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mWaiting[i] = false;
+			mLastSent[i] = -1;
+			mSentTime[i] = 0;
+			mChangeTime[i] = 0;
+		}
+	};
+
+	void setSampleRate(double sampleRate)
+	{
+		mSampleRate = sampleRate;
+	};
+
+	/** updates per second and parameter*/
+	void setMaxRate(int updatesPerSecond)
+	{
+		mMaxRate = jmax(1,updatesPerSecond);
+	};
+
+	int getMaxRate() const
+	{
+		return mMaxRate;
+	};
+
+	/** changes smaller than this are only sent when the lane has settled*/
+	void setThreshold(int steps)
+	{
+		mThreshold = jmax(1,steps);
+	};
+
+	int getThreshold() const
+	{
+		return mThreshold;
+	};
+
+	/** bytes per second, as MidiTransmitter::setLinkSpeed(). LINK_SPEED_UNLIMITED has no budget*/
+	void setLinkSpeed(int bytesPerSecond)
+	{
+		mLinkSpeed = jmax(0,bytesPerSecond);
+	};
+
+	int getLinkSpeed() const
+	{
+		return mLinkSpeed;
+	};
+
+	/** at the start of every block, before anything is sent*/
+	void beginBlock(int numSamples)
+	{
+		if(mLinkSpeed == LINK_SPEED_UNLIMITED) return;
+
+		const double bytesPerSample = mLinkSpeed / mSampleRate;
+		const double burst = jmax((double)MAX_BYTES_PER_PARAMETER, AUTOMATION_BURST_MS*0.001*mLinkSpeed);
+		mBudget = jmin(burst, mBudget + numSamples*bytesPerSample);
+	};
+
+	void endBlock(int numSamples)
+	{
+		mTime += numSamples;
+	};
+
+	/** the host changed a parameter since the last block*/
+	void changed(int parameterNr)
+	{
+		mWaiting[parameterNr] = true;
+		mChangeTime[parameterNr] = mTime;
+	};
+
+	/** a value that went out on another path*/
+	void sent(int parameterNr, int value, int numBytes)
+	{
+		mLastSent[parameterNr] = (short)value;
+		mSentTime[parameterNr] = mTime;
+		mBudget -= numBytes;
+	};
+
+	/** charges traffic that isn't a single parameter, like a patch dump*/
+	void sentBytes(int numBytes)
+	{
+		mBudget -= numBytes;
+	};
+
+	/** writes the automation that is due at the start of the block*/
+	void process(const uint8_t* values, MidiEncoder& encoder, MidiBuffer& midiMessages)
+	{
+		const int64 interval = (int64)(mSampleRate / mMaxRate);
+		MidiMessage messages[MAX_MESSAGES_PER_PARAMETER];
+
+		for(int k=0;k<NUM_PARAMS;k++)
+		{
+			const int parameterNr = (mNextParameter + k) % NUM_PARAMS;
+			if(!mWaiting[parameterNr]) continue;
+
+			const int value = values[parameterNr];
+			if(value == mLastSent[parameterNr])
+			{
+				mWaiting[parameterNr] = false;
+				continue;
+			}
+
+			if(mTime - mSentTime[parameterNr] < interval && mLastSent[parameterNr] >= 0) continue;
+
+			//a small step goes out once the lane has stopped moving
+			const bool settled = mTime - mChangeTime[parameterNr] >= interval;
+			if(abs(value - mLastSent[parameterNr]) < mThreshold && !settled) continue;
+
+			if(mLinkSpeed != LINK_SPEED_UNLIMITED && mBudget <= 0)
+			{
+				mNextParameter = parameterNr;
+				return;
+			}
+
+			const int num = encoder.encode(parameterNr, value, messages);
+			int numBytes = 0;
+			for(int i=0;i<num;i++)
+			{
+				midiMessages.addEvent(messages[i], 0);
+				numBytes += messages[i].getRawDataSize();
+			}
+			sent(parameterNr, value, numBytes);
+			mWaiting[parameterNr] = false;
+		}
+		//everything due is out, the next block sends in parameter order again
+		mNextParameter = 0;
+	};
+
+private:
+	double mSampleRate;
+	int mMaxRate;
+	int mThreshold;
+	int mLinkSpeed;
+
+	int64 mTime;				// samples since reset()
+	double mBudget;				// bytes the link can take now, negative after a burst
+	int mNextParameter;			// where the last block ran out of budget
+
+	bool mWaiting[NUM_PARAMS];	// changed by the host, not sent yet
+	short mLastSent[NUM_PARAMS];	// -1 until the first value went out
+	int64 mSentTime[NUM_PARAMS];
+	int64 mChangeTime[NUM_PARAMS];
+};
+//---------------------------------------------------------------------------
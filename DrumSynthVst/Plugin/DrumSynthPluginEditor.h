@@ -0,0 +1,72 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Source/MainTabbedComponent.h"
+#include "../GreenLookAndFeel.h"
+#include "../StartupLoader.h"
+
+//---------------------------------------------------------------------------
+/** The plugin window shows the voice tabs of the application.
+	There is no menu and no device setup, the host owns the MIDI ports.
+*/
+class DrumSynthPluginEditor : public AudioProcessorEditor, public StartupLoader::Listener
+{
+public:
+	DrumSynthPluginEditor(AudioProcessor* owner) : AudioProcessorEditor(owner)
+	{
+		mLookAndFeel = new GreenLookAndFeel();
+		mTabs.setLookAndFeel(mLookAndFeel);
+		addAndMakeVisible(&mTabs);
+		setSize(mTabs.getWidth(), mTabs.getHeight());
+
+		StartupLoader::getInstance()->addListener(this);
+	};
+
+	~DrumSynthPluginEditor()
+	{
+		StartupLoader::getInstance()->removeListener(this);
+		mTabs.setLookAndFeel(0);
+	};
+
+	void resized()
+	{
+		mTabs.setBounds(0, 0, getWidth(), getHeight());
+	};
+
+	void startupResourceReady(int resource)
+	{
+		if(resource != RESOURCE_KNOB_IMAGE) return;
+
+		((GreenLookAndFeel*)(LookAndFeel*)mLookAndFeel)->setSliderImage(StartupLoader::getInstance()->getKnobImage(),31,false);
+		repaint();
+	};
+
+private:
+	ScopedPointer<LookAndFeel> mLookAndFeel;
+	MainTabComponent mTabs;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,417 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JucePluginCharacteristics.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../ParameterStore.h"
+#include "../parameterRanges.h"
+#include "../parameterLocations.h"
+#include "../Midi/MidiEncoder.h"
+#include "../Midi/PatchSysEx.h"
+#include "../StartupLoader.h"
+#include "../Source/Singletons.h"
+#include "./PluginState.h"
+#include "./AutomationDecimator.h"
+
+#define PLUGIN_NUM_PROGRAMS		1
+#define PLUGIN_MAX_EDITS		256		// edits of the plugin window that can wait for the next block
+
+//---------------------------------------------------------------------------
+/** The VST version of the editor. It exposes every value of the
+	ParameterStore as a host parameter, normalised over its parameterRanges.
+
+	The plugin makes no sound. Its MIDI output is the link to the synth, the
+	MidiTransmitter isn't used.
+	Host automation only marks its parameter in a pending bitset,
+	processBlock() sends what is marked as one batch at the start of the
+	block. Like the MidiTransmitter only the latest value of a parameter goes
+	out, and because the batch is in parameter order, NRPN parameters next
+	to each other share the address messages of the MidiEncoder. The
+	AutomationDecimator limits how often a parameter is sent and keeps the
+	whole stream within the link speed.
+
+	Edits made in the plugin window are reported to the host, so they can be
+	recorded as automation. The plugin is the EditTarget of the
+	ParameterStore, the edits reach the audio thread through a lock free
+	fifo with the time they were made. processBlock() places them in the
+	block at the same distance from each other, one block late, so a knob
+	movement keeps its timing on the host timeline. Everything is encoded
+	in the order it is sent, so the NRPN address cache of the one encoder
+	stays valid.
+
+	The state the host saves is a PluginState chunk. After it is restored the
+	whole sound goes to the synth as one patch dump instead of a message per
+	value.
+*/
+class DrumSynthProcessor : public AudioProcessor, public ParameterStore::EditTarget
+{
+public:
+	DrumSynthProcessor() : mFifo(PLUGIN_MAX_EDITS)
+	{
+		for(int i=0;i<NUM_DIRTY_WORDS;i++)
+		{
+			mPending[i].set(0);
+		}
+		mDumpPending.set(0);
+		memset(mName, 0, PATCH_NAME_LENGTH);
+		mStore = ParameterStore::getInstance();
+		memcpy(mHostValues, mStore->getValues(), NUM_PARAMS);
+		//with several instances the window of the newest one sends
+		mStore->setEditTarget(this);
+		mSampleRate = 44100.0;
+
+		//the knob image of the editor
+		StartupLoader::getInstance()->start();
+		sNumInstances++;
+	};
+
+	~DrumSynthProcessor()
+	{
+		if(mStore->getEditTarget() == this) mStore->setEditTarget(NULL);
+		//the host may load the plugin again without unloading the dll
+		if(--sNumInstances == 0) deleteSingletons();
+	};
+
+	//----- AudioProcessor
+	const String getName() const
+	{
+		return JucePlugin_Name;
+	};
+
+	void prepareToPlay(double sampleRate, int /*estimatedSamplesPerBlock*/)
+	{
+		mSampleRate = sampleRate;
+		//the host might have opened another output since the last time
+		mEncoder.reset();
+		mDecimator.setSampleRate(sampleRate);
+		mDecimator.reset();
+	};
+
+	void releaseResources()
+	{
+	};
+
+	void processBlock(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+	{
+		buffer.clear();
+		midiMessages.clear();
+
+		//the bits are taken word by word, a change arriving meanwhile goes into the next block
+		int pending[NUM_DIRTY_WORDS];
+		for(int word=0;word<NUM_DIRTY_WORDS;word++)
+		{
+			pending[word] = mPending[word].exchange(0);
+		}
+
+		const int numSamples = buffer.getNumSamples();
+		mDecimator.beginBlock(numSamples);
+
+		//a dump contains every value, nothing else has to be sent
+		if(mDumpPending.exchange(0) != 0)
+		{
+			mFifo.finishedRead(mFifo.getNumReady());
+			sendPatchDump(midiMessages);
+			mDecimator.endBlock(numSamples);
+			return;
+		}
+
+		for(int word=0;word<NUM_DIRTY_WORDS;word++)
+		{
+			for(int bit=0;pending[word] != 0 && bit<32;bit++)
+			{
+				if(pending[word] & (1<<bit)) mDecimator.changed(word*32 + bit);
+			}
+		}
+		mDecimator.process(mStore->getValues(), mEncoder, midiMessages);
+
+		addEdits(midiMessages, numSamples);
+		mDecimator.endBlock(numSamples);
+	};
+
+	/** the decimator of the host automation, configure it before the host starts playing*/
+	AutomationDecimator& getDecimator()
+	{
+		return mDecimator;
+	};
+
+	const String getInputChannelName(int channelIndex) const
+	{
+		return String(channelIndex+1);
+	};
+
+	const String getOutputChannelName(int channelIndex) const
+	{
+		return String(channelIndex+1);
+	};
+
+	bool isInputChannelStereoPair(int /*index*/) const
+	{
+		return true;
+	};
+
+	bool isOutputChannelStereoPair(int /*index*/) const
+	{
+		return true;
+	};
+
+	bool acceptsMidi() const
+	{
+		return JucePlugin_WantsMidiInput != 0;
+	};
+
+	bool producesMidi() const
+	{
+		return JucePlugin_ProducesMidiOutput != 0;
+	};
+
+	AudioProcessorEditor* createEditor();
+
+	bool hasEditor() const
+	{
+		return true;
+	};
+
+	int getNumParameters()
+	{
+		return NUM_PARAMS;
+	};
+
+	const String getParameterName(int parameterIndex)
+	{
+		static const char* voiceNames[NUM_VOICES] = {"Drum 1","Drum 2","Drum 3","Snare","Cymbal","Hat"};
+
+		const ParameterLocation& location = getParameterLocation(parameterIndex);
+		if(location.voiceNr == NO_VOICE) return String("Parameter ") + String(parameterIndex);
+		return String(voiceNames[location.voiceNr]) + String(" ") + String(location.controlNr);
+	};
+
+	float getParameter(int parameterIndex)
+	{
+		return toNormalised(parameterIndex, mStore->getValue(parameterIndex));
+	};
+
+	/** the value in the units the editor shows*/
+	const String getParameterText(int parameterIndex)
+	{
+		const ParameterRange& range = getParameterRange(parameterIndex);
+		const int value = mStore->getValue(parameterIndex);
+		return String(range.min < 0 ? value-63 : value);
+	};
+
+	/** host automation, any thread*/
+	void setParameter(int parameterIndex, float newValue)
+	{
+		if(parameterIndex < 0 || parameterIndex >= NUM_PARAMS) return;
+
+		const uint8_t value = toValue(parameterIndex, newValue);
+		if(value == mStore->getValue(parameterIndex)) return;
+
+		//written first, so parameterChanged() knows the change came from the host
+		mHostValues[parameterIndex] = value;
+		mStore->setValueFromMidi(parameterIndex, value);
+		setPending(parameterIndex);
+	};
+
+	int getNumPrograms()
+	{
+		return PLUGIN_NUM_PROGRAMS;
+	};
+
+	int getCurrentProgram()
+	{
+		return 0;
+	};
+
+	void setCurrentProgram(int /*index*/)
+	{
+	};
+
+	const String getProgramName(int /*index*/)
+	{
+		return String::empty;
+	};
+
+	void changeProgramName(int /*index*/, const String& /*newName*/)
+	{
+	};
+
+	void getStateInformation(MemoryBlock& destData)
+	{
+		uint8_t patchData[PATCH_DATA_SIZE];
+		writePatchData(patchData);
+		PluginState::write(patchData, destData);
+	};
+
+	/** the synth doesn't know the restored sound, it is sent as a dump in the next block*/
+	void setStateInformation(const void* data, int sizeInBytes)
+	{
+		uint8_t patchData[PATCH_DATA_SIZE];
+		if(!PluginState::read(data, sizeInBytes, patchData)) return;
+
+		memcpy(mName, patchData, PATCH_NAME_LENGTH);
+		const uint8_t* values = patchData + PATCH_NAME_LENGTH;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mHostValues[i] = values[i];
+			if(mStore->getValue(i) != values[i]) mStore->setValueFromMidi(i, values[i]);
+		}
+		mDumpPending.set(1);
+	};
+
+	//----- ParameterStore::EditTarget
+	/** an edit in the plugin window, recorded by the host and sent in the next block*/
+	void parameterEdited(int parameterNr, int value)
+	{
+		Edit e;
+		e.parameterNr = (short)parameterNr;
+		e.value = (uint8_t)value;
+		e.time = Time::getMillisecondCounterHiRes();
+
+		int start1, size1, start2, size2;
+		mFifo.prepareToWrite(1, start1, size1, start2, size2);
+		if(size1 > 0)
+		{
+			mEdits[start1] = e;
+			mFifo.finishedWrite(1);
+		}
+		else
+		{
+			//the audio thread is stuck, the latest value still goes out with the next block
+			setPending(parameterNr);
+		}
+
+		if(mHostValues[parameterNr] == (uint8_t)value) return;
+		mHostValues[parameterNr] = (uint8_t)value;
+		sendParamChangeMessageToListeners(parameterNr, toNormalised(parameterNr, value));
+	};
+
+private:
+	struct Edit
+	{
+		double time;		// Time::getMillisecondCounterHiRes()
+		short parameterNr;
+		uint8_t value;
+	};
+
+	/** the edits of the plugin window at their position. The block before this
+		one is taken to have ended now, so the edits are delayed by one block
+		and keep their distance*/
+	void addEdits(MidiBuffer& midiMessages, int numSamples)
+	{
+		const double samplesPerMs = mSampleRate * 0.001;
+		const double start = Time::getMillisecondCounterHiRes() - numSamples / samplesPerMs;
+
+		int start1, size1, start2, size2;
+		const int ready = mFifo.getNumReady();
+		mFifo.prepareToRead(ready, start1, size1, start2, size2);
+		for(int i=0;i<size1;i++) addEdit(midiMessages, mEdits[start1+i], start, samplesPerMs, numSamples);
+		for(int i=0;i<size2;i++) addEdit(midiMessages, mEdits[start2+i], start, samplesPerMs, numSamples);
+		mFifo.finishedRead(size1+size2);
+	};
+
+	void addEdit(MidiBuffer& midiMessages, const Edit& e, double start, double samplesPerMs, int numSamples)
+	{
+		const int position = jlimit(0, jmax(0, numSamples-1), roundToInt((e.time - start) * samplesPerMs));
+
+		MidiMessage messages[MAX_MESSAGES_PER_PARAMETER];
+		const int num = mEncoder.encode(e.parameterNr, e.value, messages);
+		int numBytes = 0;
+		for(int i=0;i<num;i++)
+		{
+			midiMessages.addEvent(messages[i], position);
+			numBytes += messages[i].getRawDataSize();
+		}
+		//the automation of the parameter doesn't have to repeat it, and yields the bytes
+		mDecimator.sent(e.parameterNr, e.value, numBytes);
+	};
+
+	/** the stored values of PM63 parameters are offset by 63, so they start at 0*/
+	static int getValueMin(int parameterNr)
+	{
+		return jmax(0, (int)getParameterRange(parameterNr).min);
+	};
+
+	static float toNormalised(int parameterNr, int value)
+	{
+		const int range = getParameterRange(parameterNr).range;
+		if(range <= 0) return 0.f;
+		return jlimit(0.f, 1.f, (value - getValueMin(parameterNr)) / (float)range);
+	};
+
+	static uint8_t toValue(int parameterNr, float normalised)
+	{
+		const int range = getParameterRange(parameterNr).range;
+		return (uint8_t)(getValueMin(parameterNr) + roundToInt(jlimit(0.f, 1.f, normalised) * range));
+	};
+
+	/** the current sound in .SND layout*/
+	void writePatchData(uint8_t* patchData)
+	{
+		memcpy(patchData, mName, PATCH_NAME_LENGTH);
+		mStore->copyValues(patchData + PATCH_NAME_LENGTH);
+	};
+
+	/** the bulk path of the MidiTransmitter, built without allocating on the audio thread*/
+	void sendPatchDump(MidiBuffer& midiMessages)
+	{
+		uint8_t patchData[PATCH_DATA_SIZE];
+		writePatchData(patchData);
+		PatchSysEx::writePatchDump(patchData, mDump);
+		midiMessages.addEvent(mDump, SYSEX_PATCH_DUMP_MESSAGE_SIZE, 0);
+
+		mDecimator.sentBytes(SYSEX_PATCH_DUMP_MESSAGE_SIZE);
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mDecimator.sent(i, patchData[PATCH_NAME_LENGTH+i], 0);
+		}
+	};
+
+	void setPending(int parameterNr)
+	{
+		Atomic<int>& word = mPending[parameterNr/32];
+		const int mask = 1<<(parameterNr%32);
+		int old;
+		do
+		{
+			old = word.get();
+		} while(!word.compareAndSetBool(old|mask,old));
+	};
+
+	ParameterStore* mStore;
+	AbstractFifo mFifo;
+	Edit mEdits[PLUGIN_MAX_EDITS];
+	double mSampleRate;
+	Atomic<int> mPending[NUM_DIRTY_WORDS];	// waiting for the next processBlock()
+	uint8_t mHostValues[NUM_PARAMS];		// the values the host knows about
+	Atomic<int> mDumpPending;				// a restored state hasn't been sent yet
+	char mName[PATCH_NAME_LENGTH];			// of the restored state, the store has no name
+	MidiEncoder mEncoder;					// audio thread only
+	AutomationDecimator mDecimator;			// audio thread only
+	uint8_t mDump[SYSEX_PATCH_DUMP_MESSAGE_SIZE];	// audio thread only
+
+	static int sNumInstances;				// message thread only
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+//the plugin has to build juce with the same settings as the application
+#include "../JuceLibraryCode/AppConfig.h"
+
+//---------------------------------------------------------------------------
+// settings of the VST build, read by juce/src/audio/plugin_client.
+// the plugin doesn't make sound itself, it is an editor for the drumsynth
+// that records its edits as host automation and sends them on its MIDI output.
+
+#define JucePlugin_Build_VST					1
+#define JucePlugin_Build_AU						0
+#define JucePlugin_Build_RTAS					0
+#define JucePlugin_Build_Standalone				0
+
+// the VST SDK isn't part of this repository, set its folder in the include path of DrumSynthPlugin.vcproj
+#define JUCE_USE_VSTSDK_2_4						1
+
+#define JucePlugin_Name							"DrumSynthEditor"
+#define JucePlugin_Desc							"Sonic Potions Drumsynth Editor"
+#define JucePlugin_Manufacturer					"Sonic Potions"
+#define JucePlugin_ManufacturerCode				'SoPo'
+#define JucePlugin_PluginCode					'LxrE'
+#define JucePlugin_VSTUniqueID					JucePlugin_PluginCode
+#define JucePlugin_VersionCode					0x00010000
+#define JucePlugin_VersionString				"1.0.0"
+
+#define JucePlugin_IsSynth						1
+#define JucePlugin_VSTCategory					kPlugCategSynth
+#define JucePlugin_WantsMidiInput				0
+#define JucePlugin_ProducesMidiOutput			1
+#define JucePlugin_MaxNumInputChannels			0
+#define JucePlugin_MaxNumOutputChannels			2
+#define JucePlugin_PreferredChannelConfigurations	{0, 2}
+#define JucePlugin_SilenceInProducesSilenceOut	1
+#define JucePlugin_TailLengthSeconds			0
+#define JucePlugin_EditorRequiresKeyboardFocus	0
@@ -0,0 +1,41 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+
+#include "./DrumSynthProcessor.h"
+#include "./DrumSynthPluginEditor.h"
+
+int DrumSynthProcessor::sNumInstances = 0;
+
+AudioProcessorEditor* DrumSynthProcessor::createEditor()
+{
+	return new DrumSynthPluginEditor(this);
+}
+
+//==============================================================================
+// called by the VST wrapper for every new instance
+AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+	return new DrumSynthProcessor();
+}
@@ -0,0 +1,95 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../PresetLoader.h"
+
+#define PLUGIN_STATE_MAGIC			0x5352584c	// "LXRS" read as a little endian int
+#define PLUGIN_STATE_VERSION		1
+#define PLUGIN_STATE_HEADER_SIZE	8
+#define PLUGIN_STATE_SIZE			(PLUGIN_STATE_HEADER_SIZE+PATCH_DATA_SIZE)
+
+//---------------------------------------------------------------------------
+/** The chunk a host saves for every plugin instance, with every project
+	save and often with every undo step, so it is kept small and is read
+	without parsing.
+
+	Layout, all numbers little endian:
+	[magic, 4 bytes] [version, 2 bytes] [size of the patch data, 2 bytes]
+	[patch data in .SND layout]
+
+	A later version may append fields after the patch data, older readers
+	skip them.
+*/
+class PluginState
+{
+public:
+	/** writes PLUGIN_STATE_SIZE bytes for PATCH_DATA_SIZE bytes in .SND layout*/
+	static void write(const uint8_t* patchData, MemoryBlock& destData)
+	{
+		destData.setSize(PLUGIN_STATE_SIZE);
+		uint8* dest = (uint8*)destData.getData();
+
+		writeInt(dest, PLUGIN_STATE_MAGIC);
+		writeShort(dest+4, PLUGIN_STATE_VERSION);
+		writeShort(dest+6, PATCH_DATA_SIZE);
+		memcpy(dest+PLUGIN_STATE_HEADER_SIZE, patchData, PATCH_DATA_SIZE);
+	};
+
+	/** copies the patch data of a chunk into PATCH_DATA_SIZE bytes.
+		returns false if the chunk isn't a state of this plugin*/
+	static bool read(const void* data, int sizeInBytes, uint8_t* patchData)
+	{
+		if(data == NULL || sizeInBytes < PLUGIN_STATE_HEADER_SIZE) return false;
+
+		const uint8* src = (const uint8*)data;
+		if(ByteOrder::littleEndianInt(src) != PLUGIN_STATE_MAGIC) return false;
+		if(ByteOrder::littleEndianShort(src+4) < 1) return false;
+
+		const int size = ByteOrder::littleEndianShort(src+6);
+		if(size < PATCH_DATA_SIZE || PLUGIN_STATE_HEADER_SIZE + size > sizeInBytes) return false;
+
+		memcpy(patchData, src+PLUGIN_STATE_HEADER_SIZE, PATCH_DATA_SIZE);
+		return true;
+	};
+
+private:
+	static void writeInt(uint8* dest, uint32 value)
+	{
+		for(int i=0;i<4;i++)
+		{
+			dest[i] = (uint8)(value >> (8*i));
+		}
+	};
+
+	static void writeShort(uint8* dest, uint16 value)
+	{
+		dest[0] = (uint8)value;
+		dest[1] = (uint8)(value >> 8);
+	};
+};
+//---------------------------------------------------------------------------
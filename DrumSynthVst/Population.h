@@ -0,0 +1,333 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "Patch.h"
+#include "FastRandom.h"
+
+#define SELECTION_TOURNAMENT	0	// the fittest of a few random members
+#define SELECTION_ROULETTE		1	// chance proportional to the fitness
+
+#define DEFAULT_POPULATION_SIZE	32
+#define DEFAULT_TOURNAMENT_SIZE	3
+#define DEFAULT_NUM_ELITES		2
+
+#define FITNESS_LIKE			1.f
+#define FITNESS_NOT_VOTED		0.5f
+#define FITNESS_DISLIKE			0.f
+#define FITNESS_INHERIT_DECAY	0.8f	// how much of the parents' fitness an unvoted child keeps
+
+//---------------------------------------------------------------------------
+/** One generation of patches (or patterns) and the votes they got.
+
+	A voted member has the fitness of its vote. An unvoted member inherits
+	the mean fitness of its parents, pulled a little towards
+	FITNESS_NOT_VOTED, so several generations can be bred from one round
+	of votes. Disliked members are never chosen as parents.
+
+	Member needs getOpinion() and setOpinion(), write() and read() are only
+	there for patches.
+*/
+template <class Member>
+class PopulationOf
+{
+public:
+	PopulationOf()
+	{
+		mSize = DEFAULT_POPULATION_SIZE;
+		mSelectionMode = SELECTION_TOURNAMENT;
+		mTournamentSize = DEFAULT_TOURNAMENT_SIZE;
+		mNumElites = DEFAULT_NUM_ELITES;
+		mGeneration = 0;
+		mCurrent = 0;
+	};
+
+	~PopulationOf()
+	{
+	};
+
+	void clear()
+	{
+		mMembers.clear();
+		mInherited.clear();
+		mGeneration = 0;
+		mCurrent = 0;
+	};
+
+	/** forgets the members without deleting them, for members that belong to an ObjectArena*/
+	void releaseMembers()
+	{
+		mMembers.clear(false);
+		mInherited.clear();
+		mCurrent = 0;
+	};
+
+	/** takes ownership of the member*/
+	void add(Member* member, float inheritedFitness = FITNESS_NOT_VOTED)
+	{
+		mMembers.add(member);
+		mInherited.add(inheritedFitness);
+	};
+
+	/** the next generation replaces this one, other gets the old members*/
+	void swapWith(PopulationOf& other)
+	{
+		mMembers.swapWithArray(other.mMembers);
+		mInherited.swapWithArray(other.mInherited);
+		mCurrent = 0;
+	};
+
+	int getNumMembers() const
+	{
+		return mMembers.size();
+	};
+
+	Member* getMember(int index) const
+	{
+		return mMembers[index];
+	};
+
+	/** the fitness an unvoted member has from its parents*/
+	float getInheritedFitness(int index) const
+	{
+		return mInherited[index];
+	};
+
+	float getFitness(int index) const
+	{
+		switch(mMembers[index]->getOpinion())
+		{
+			case LIKE:		return FITNESS_LIKE;
+			case DISLIKE:	return FITNESS_DISLIKE;
+			default:		return mInherited[index];
+		}
+	};
+
+	/** what an unvoted child of the two members starts with*/
+	float getChildFitness(int father, int mother) const
+	{
+		const float mean = (getFitness(father) + getFitness(mother)) * 0.5f;
+		return FITNESS_NOT_VOTED + (mean - FITNESS_NOT_VOTED) * FITNESS_INHERIT_DECAY;
+	};
+
+	/** the number of members that can still be chosen as parents*/
+	int getNumBreedable() const
+	{
+		int num = 0;
+		for(int i=0;i<mMembers.size();i++)
+		{
+			if(mMembers[i]->getOpinion() != DISLIKE) num++;
+		}
+		return num;
+	};
+
+	/** picks a parent that isn't disliked and isn't exclude, -1 if there is none*/
+	int select(FastRandom& random, int exclude = -1) const
+	{
+		if(mSelectionMode == SELECTION_ROULETTE) return selectRoulette(random,exclude);
+		return selectTournament(random,exclude);
+	};
+
+	/** the numElites fittest breedable members, best first*/
+	void getElites(Array<int>& elites) const
+	{
+		elites.clearQuick();
+		for(int i=0;i<mMembers.size();i++)
+		{
+			if(mMembers[i]->getOpinion() == DISLIKE) continue;
+
+			//insertion sort, the list is only mNumElites long
+			int pos = elites.size();
+			while(pos > 0 && getFitness(elites[pos-1]) < getFitness(i)) pos--;
+			if(pos < mNumElites) elites.insert(pos,i);
+			if(elites.size() > mNumElites) elites.removeLast();
+		}
+	};
+
+	//--- the member that is auditioned in the generator window ---
+	int getCurrent() const
+	{
+		return mCurrent;
+	};
+
+	void next()
+	{
+		if(mMembers.size() > 0) mCurrent = (mCurrent+1) % mMembers.size();
+	};
+
+	void prev()
+	{
+		if(mMembers.size() > 0) mCurrent = (mCurrent + mMembers.size() - 1) % mMembers.size();
+	};
+
+	void vote(int opinion)
+	{
+		if(mCurrent < mMembers.size()) mMembers[mCurrent]->setOpinion(opinion);
+	};
+
+	//--- settings ---
+	void setSize(int size)
+	{
+		jassert(size > 1);
+		mSize = size;
+	};
+
+	int getSize() const
+	{
+		return mSize;
+	};
+
+	void setSelectionMode(int mode)
+	{
+		jassert(mode == SELECTION_TOURNAMENT || mode == SELECTION_ROULETTE);
+		mSelectionMode = mode;
+	};
+
+	void setTournamentSize(int size)
+	{
+		jassert(size > 0);
+		mTournamentSize = size;
+	};
+
+	void setNumElites(int num)
+	{
+		jassert(num >= 0);
+		mNumElites = num;
+	};
+
+	int getGeneration() const
+	{
+		return mGeneration;
+	};
+
+	void setGeneration(int generation)
+	{
+		mGeneration = generation;
+	};
+
+	/** generation, number of members, then per member name, NUM_PARAMS values, vote, generation and inherited fitness*/
+	void write(OutputStream& out) const
+	{
+		out.writeInt(mGeneration);
+		out.writeInt(mMembers.size());
+		for(int i=0;i<mMembers.size();i++)
+		{
+			Member* patch = mMembers[i];
+			out.writeString(patch->getName());
+			out.write(patch->getValues(),NUM_PARAMS);
+			out.writeByte((char)patch->getOpinion());
+			out.writeInt(patch->getGeneration());
+			out.writeFloat(mInherited[i]);
+		}
+	};
+
+	/** replaces the members with the ones written by write(), the population is empty if they are invalid*/
+	bool read(InputStream& in)
+	{
+		clear();
+
+		const int generation = in.readInt();
+		const int numMembers = in.readInt();
+		uint8_t values[NUM_PARAMS];
+		for(int i=0;i<numMembers;i++)
+		{
+			ScopedPointer<Member> patch(new Member());
+			patch->setName(in.readString());
+			if(in.read(values,NUM_PARAMS) != NUM_PARAMS)
+			{
+				clear();
+				return false;
+			}
+			patch->setValues(values);
+
+			const int opinion = in.readByte();
+			patch->setOpinion(jlimit(0,2,opinion));
+			patch->setGeneration(in.readInt());
+			const float inherited = in.readFloat();
+			if(in.isExhausted() && i < numMembers-1)
+			{
+				clear();
+				return false;
+			}
+			add(patch.release(),inherited);
+		}
+		mGeneration = generation;
+		return true;
+	};
+
+private:
+	int selectTournament(FastRandom& random, int exclude) const
+	{
+		int best = -1;
+		const int numBreedable = getNumBreedable() - ((exclude >= 0 && mMembers[exclude]->getOpinion() != DISLIKE) ? 1 : 0);
+		if(numBreedable <= 0) return -1;
+
+		for(int round=0;round<mTournamentSize;)
+		{
+			const int candidate = random.nextInt(mMembers.size());
+			if(candidate == exclude || mMembers[candidate]->getOpinion() == DISLIKE) continue;
+
+			if(best < 0 || getFitness(candidate) > getFitness(best)) best = candidate;
+			round++;
+		}
+		return best;
+	};
+
+	int selectRoulette(FastRandom& random, int exclude) const
+	{
+		float total = 0.f;
+		for(int i=0;i<mMembers.size();i++)
+		{
+			if(i != exclude && mMembers[i]->getOpinion() != DISLIKE) total += getFitness(i);
+		}
+		if(total <= 0.f) return selectTournament(random,exclude);
+
+		float r = random.nextFloat() * total;
+		int last = -1;
+		for(int i=0;i<mMembers.size();i++)
+		{
+			if(i == exclude || mMembers[i]->getOpinion() == DISLIKE) continue;
+			last = i;
+			r -= getFitness(i);
+			if(r < 0.f) return i;
+		}
+		return last;	// rounding
+	};
+
+	OwnedArray<Member> mMembers;
+	Array<float> mInherited;	// fitness of the unvoted members
+
+	int mSize;				// members of the next generation
+	int mSelectionMode;
+	int mTournamentSize;
+	int mNumElites;			// the best members go into the next generation unchanged
+
+	int mGeneration;
+	int mCurrent;
+};
+
+typedef PopulationOf<Patch> Population;
+//---------------------------------------------------------------------------
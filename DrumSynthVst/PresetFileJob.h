@@ -0,0 +1,186 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./PresetLoader.h"
+#include "./ParameterStore.h"
+#include "./Midi/MidiTransmitter.h"
+
+#define JOB_CANCEL_TIMEOUT_MS	2000
+#define JOB_POLL_INTERVAL_MS	10
+
+//---------------------------------------------------------------------------
+/** Opens, saves or resets the current preset on a background thread while a
+	progress window with a cancel button is shown.
+
+	The file is read and written on the job thread. A loaded patch is handed to
+	the ParameterStore under a MessageManagerLock, then the job waits for the
+	MidiTransmitter to send the bulk values so the progress bar shows the
+	transfer to the synth. Cancelling before the patch is applied leaves the
+	editor unchanged, cancelling during the transfer only closes the window,
+	the remaining values are still sent in the background.
+*/
+class PresetFileJob : public ThreadWithProgressWindow
+{
+public:
+	enum JobType
+	{
+		LOAD_PRESET = 0,
+		SAVE_PRESET,
+		NEW_PRESET
+	};
+
+	/** has to be created on the message thread, a save job takes its snapshot of the values here*/
+	PresetFileJob(int jobType, const File& file)
+	: ThreadWithProgressWindow(getTitle(jobType),true,true,JOB_CANCEL_TIMEOUT_MS),
+	mJobType(jobType),
+	mFile(file),
+	mSucceeded(false)
+	{
+		if(mJobType == SAVE_PRESET)
+		{
+			ParameterStore::getInstance()->storeToPatch(&mPatch);
+			mPatch.setName(file.getFileNameWithoutExtension().substring(0,PATCH_NAME_LENGTH));
+		}
+	};
+
+	~PresetFileJob()
+	{
+	};
+
+	/** false if the job failed or was cancelled before it was done*/
+	bool succeeded()
+	{
+		return mSucceeded;
+	};
+
+	void run()
+	{
+		switch(mJobType)
+		{
+		case LOAD_PRESET:
+			{
+				setStatusMessage("Reading " + mFile.getFileName());
+				if(!readPatch() || threadShouldExit()) return;
+
+				if(applyPatch())
+				{
+					mSucceeded = true;
+					waitForTransmit();
+				}
+			}
+			break;
+
+		case SAVE_PRESET:
+			setStatusMessage("Writing " + mFile.getFileName());
+			mSucceeded = writePatch();
+			break;
+
+		case NEW_PRESET:
+			//a default constructed patch is the init sound
+			setStatusMessage("Resetting the sound");
+			if(applyPatch())
+			{
+				mSucceeded = true;
+				waitForTransmit();
+			}
+			break;
+		}
+	};
+
+private:
+	static String getTitle(int jobType)
+	{
+		switch(jobType)
+		{
+			case LOAD_PRESET:	return "Open File";
+			case SAVE_PRESET:	return "Save File";
+			default:			return "New File";
+		}
+	};
+
+	bool readPatch()
+	{
+		setProgress(-1.0);
+
+		uint8_t data[PATCH_DATA_SIZE];
+		memset(data,0,PATCH_DATA_SIZE);
+
+		FileInputStream in(mFile);
+		if(in.getStatus().failed() || in.read(data,PATCH_DATA_SIZE) <= 0)
+		{
+			return false;
+		}
+		PresetLoader::readPatchData(data,&mPatch);
+		return true;
+	};
+
+	bool writePatch()
+	{
+		setProgress(-1.0);
+
+		uint8_t data[PATCH_DATA_SIZE];
+		PresetLoader::writePatchData(&mPatch,data);
+
+		TemporaryFile temp(mFile);
+		if(!temp.getFile().replaceWithData(data,PATCH_DATA_SIZE)) return false;
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** hand the patch to the store, which queues the changed values for the synth*/
+	bool applyPatch()
+	{
+		const MessageManagerLock lock(this);
+		if(!lock.lockWasGained()) return false;	// cancelled while waiting
+
+		ParameterStore::getInstance()->loadFromPatch(&mPatch,true);
+		return true;
+	};
+
+	void waitForTransmit()
+	{
+		setStatusMessage("Sending to the synth");
+
+		MidiTransmitter* transmitter = MidiTransmitter::getInstance();
+		const int total = transmitter->getQueueDepth(PRIORITY_BULK);
+		while(!threadShouldExit())
+		{
+			const int remaining = transmitter->getQueueDepth(PRIORITY_BULK);
+			if(remaining == 0 || total == 0) break;
+
+			setProgress(1.0 - remaining/(double)total);
+			wait(JOB_POLL_INTERVAL_MS);
+		}
+		setProgress(1.0);
+	};
+
+private:
+	const int mJobType;
+	const File mFile;
+	Patch mPatch;
+	bool mSucceeded;
+};
+//---------------------------------------------------------------------------
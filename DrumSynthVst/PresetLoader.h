@@ -21,6 +21,83 @@
 #include <string>
 
 #include "Patch.h"
+#include "Trace.h"
+
+#define PATCH_DATA_SIZE		(PATCH_NAME_LENGTH+NUM_PARAMS)	// name + 1 byte per parameter, the layout of the .SND files
+
+#define NUM_LOADER_THREADS	8	// file reads are mostly waiting for the disk or network, not the cpu
+
+enum LoadStatus
+{
+	LOAD_OK = 0,
+	LOAD_FILE_NOT_FOUND,
+	LOAD_READ_ERROR,
+	LOAD_WRONG_SIZE,		// only with exactSize, the file isn't PATCH_DATA_SIZE bytes
+	LOAD_OUT_OF_RANGE		// set by the PatchImporter, a value the parameter can't have
+};
+//---------------------------------------------------------------------------
+/** The result of PresetLoader::loadPatches().
+	The patches are stored back to back as PATCH_DATA_SIZE records in .SND layout,
+	one per requested file and in the same order. Records of files that failed
+	to load are zeroed.
+*/
+class PatchBatch
+{
+public:
+	PatchBatch(int numPatches)
+	: mData((size_t)numPatches*PATCH_DATA_SIZE,true),
+	mNumPatches(numPatches)
+	{
+		mStatus.insertMultiple(0,LOAD_READ_ERROR,numPatches);
+	};
+
+	int getNumPatches() const
+	{
+		return mNumPatches;
+	};
+
+	int getStatus(int index) const
+	{
+		return mStatus[index];
+	};
+
+	int getNumLoaded() const
+	{
+		int num = 0;
+		for(int i=0;i<mNumPatches;i++)
+		{
+			if(mStatus[i] == LOAD_OK) num++;
+		}
+		return num;
+	};
+
+	const uint8_t* getPatchData(int index) const
+	{
+		jassert(index >= 0 && index < mNumPatches);
+		return (const uint8_t*)mData.getData() + index*PATCH_DATA_SIZE;
+	};
+
+	/** all records back to back*/
+	const void* getData() const
+	{
+		return mData.getData();
+	};
+
+	/** for a table that wasn't loaded from files, like the parents a BreedFarm worker is sent*/
+	void setPatch(int index, const uint8_t* data, int status)
+	{
+		jassert(index >= 0 && index < mNumPatches);
+		memcpy((uint8_t*)mData.getData() + index*PATCH_DATA_SIZE,data,PATCH_DATA_SIZE);
+		mStatus.set(index,status);
+	};
+
+private:
+	friend class PresetLoader;
+
+	MemoryBlock mData;
+	Array<int> mStatus;
+	int mNumPatches;
+};
 //---------------------------------------------------------------------------
 class PresetLoader
 {
@@ -36,24 +113,18 @@ public:
 
 	Patch* loadPatch(File path)
 	{
+		TRACE_SCOPE("patch io","loadPatch");
 		if(path.exists())
 		{
 			Patch* patch = new Patch();
 
-			MemoryBlock mem;
-			path.loadFileAsData(mem);
-
-			char patchName[9];
-			memset(patchName,0,9);
-			memcpy(patchName,mem.getData(),8);
+			//a .SND file is one record, it is read into the stack without a MemoryBlock
+			uint8_t data[PATCH_DATA_SIZE];
+			memset(data,0,PATCH_DATA_SIZE);
+			FileInputStream in(path);
+			if(!in.getStatus().failed()) in.read(data,PATCH_DATA_SIZE);
 
-			patch->setName(patchName);
-
-			for(int i=0;i<NUM_PARAMS;i++)
-			{
-				//f_read((FIL*)&preset_File,&parameters2[i].value,1,&bytesRead);	
-				patch->setParameter(i,mem[i+8]);
-			}
+			readPatchData(data,patch);
 
 			return patch;
 		}
@@ -61,23 +132,120 @@ public:
 		return NULL;
 	}
 
+	/** read many .SND files at once, spread over NUM_LOADER_THREADS threads.
+		The caller owns the returned batch and checks getStatus() for every file.
+		With exactSize a file that isn't PATCH_DATA_SIZE bytes is LOAD_WRONG_SIZE,
+		otherwise short files are zero padded and long ones cut like in loadPatch().*/
+	static PatchBatch* loadPatches(const Array<File>& paths, bool exactSize = false)
+	{
+		TRACE_SCOPE("patch io","loadPatches");
+		PatchBatch* batch = new PatchBatch(paths.size());
+		if(paths.size() == 0) return batch;
+
+		Atomic<int> nextFile;
+		const int numJobs = jmin(NUM_LOADER_THREADS,paths.size());
+		OwnedArray<LoadJob> jobs;
+		ThreadPool pool(numJobs);
+		for(int i=0;i<numJobs;i++)
+		{
+			LoadJob* job = new LoadJob(paths,*batch,nextFile,exactSize);
+			jobs.add(job);
+			pool.addJob(job);
+		}
+		for(int i=0;i<numJobs;i++)
+		{
+			pool.waitForJobToFinish(jobs[i],-1);
+		}
+		return batch;
+	}
+
 	void savePatch(File path,Patch* patch)
 	{
+		TRACE_SCOPE("patch io","savePatch");
 		//save name
 		if(!path.exists())
 			path.create();
 
-		unsigned char data[8+NUM_PARAMS];
-		memset(data,0,8);
-		memcpy(data,patch->getName().toUTF8(),patch->getName().length());
-		for(int i=0;i<NUM_PARAMS;i++)
-		{
-			data[8+i] = patch->getParameter(i);
-		}
-		path.replaceWithData(data,8+NUM_PARAMS);
+		uint8_t data[PATCH_DATA_SIZE];
+		writePatchData(patch,data);
+		path.replaceWithData(data,PATCH_DATA_SIZE);
+	}
+
+	/** decode PATCH_DATA_SIZE bytes in .SND layout into a patch*/
+	static void readPatchData(const uint8_t* data, Patch* patch)
+	{
+		char patchName[PATCH_NAME_LENGTH+1];
+		memset(patchName,0,PATCH_NAME_LENGTH+1);
+		memcpy(patchName,data,PATCH_NAME_LENGTH);
+
+		patch->setName(patchName);
+
+		patch->setValues(data+PATCH_NAME_LENGTH);
+	}
+
+	/** encode a patch into PATCH_DATA_SIZE bytes in .SND layout*/
+	static void writePatchData(Patch* patch, uint8_t* data)
+	{
+		const ShortString name(patch->getShortName());
+		memset(data,0,PATCH_NAME_LENGTH);
+		memcpy(data,name.getText(),name.length());
+		memcpy(data+PATCH_NAME_LENGTH,patch->getValues(),NUM_PARAMS);
 	}
 
 private:
+	/** takes files from the shared counter until all are read*/
+	class LoadJob : public ThreadPoolJob
+	{
+	public:
+		LoadJob(const Array<File>& paths, PatchBatch& batch, Atomic<int>& nextFile, bool exactSize)
+		: ThreadPoolJob("patch loader"),
+		mPaths(paths),
+		mBatch(batch),
+		mNextFile(nextFile),
+		mExactSize(exactSize)
+		{
+		};
+
+		JobStatus runJob()
+		{
+			TRACE_SCOPE("patch io","load job");
+			for(;;)
+			{
+				const int index = ++mNextFile - 1;
+				if(index >= mPaths.size() || shouldExit()) break;
+
+				uint8_t* dest = (uint8_t*)mBatch.mData.getData() + index*PATCH_DATA_SIZE;
+				mBatch.mStatus.set(index,readFile(mPaths.getReference(index),dest,mExactSize));
+			}
+			return jobHasFinished;
+		};
+
+	private:
+		/** short files are zero padded like in loadPatch()*/
+		static int readFile(const File& path, uint8_t* dest, bool exactSize)
+		{
+			FileInputStream in(path);
+			if(in.getStatus().failed())
+			{
+				return path.exists() ? LOAD_READ_ERROR : LOAD_FILE_NOT_FOUND;
+			}
+			if(exactSize && in.getTotalLength() != PATCH_DATA_SIZE)
+			{
+				return LOAD_WRONG_SIZE;
+			}
+			if(in.read(dest,PATCH_DATA_SIZE) < 0)
+			{
+				memset(dest,0,PATCH_DATA_SIZE);
+				return LOAD_READ_ERROR;
+			}
+			return LOAD_OK;
+		};
+
+		const Array<File>& mPaths;
+		PatchBatch& mBatch;
+		Atomic<int>& mNextFile;
+		const bool mExactSize;
+	};
 	
 private:
 	
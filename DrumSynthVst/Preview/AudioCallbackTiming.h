@@ -0,0 +1,153 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#define CALLBACK_TIMING_SMOOTHING	0.01	// weight of a new callback in the jitter average
+#define CALLBACK_TIMING_LATE		1.5		// an interval this many buffers long probably dropped one
+
+//---------------------------------------------------------------------------
+/** What AudioCallbackTiming has seen since its last reset. Times in ms.*/
+struct AudioCallbackStats
+{
+	int numCallbacks;
+	int bufferSize;			// samples of the last callback
+	double bufferMs;		// the time the last buffer plays for
+	double jitterRms;		// deviation of the intervals between callbacks from bufferMs
+	double intervalMax;		// the longest interval
+	double loadAverage;		// time spent in the callback / bufferMs
+	double loadMax;
+	int numLate;			// intervals longer than CALLBACK_TIMING_LATE buffers
+};
+
+//---------------------------------------------------------------------------
+/** Measures when the audio callbacks of the preview arrive and how long they
+	take, to see how much a device mode (e.g. exclusive WASAPI with its small
+	buffers) can be trusted with.
+
+	started() and finished() run on the audio thread, which is the only
+	writer. Like the MidiClockFollower it publishes its stats behind a
+	version counter after every callback, getStats() copies them without
+	locking from any thread.
+*/
+class AudioCallbackTiming
+{
+public:
+	AudioCallbackTiming()
+	{
+		zerostruct(mStats);
+		mShared = mStats;
+		mSampleRate = 44100.0;
+		mLastStart = 0;
+		mStart = 0;
+		mMeanSquare = 0.0;
+		resetStatistics();
+	};
+
+	/** before the device starts*/
+	void setSampleRate(double sampleRate)
+	{
+		mSampleRate = sampleRate;
+		mLastStart = 0;
+	};
+
+	/** at the start of a callback, audio thread*/
+	void started(int numSamples)
+	{
+		mStart = Time::getHighResolutionTicks();
+		if(mResetRequested.exchange(0) != 0) clearStatistics();
+
+		mStats.bufferSize = numSamples;
+		mStats.bufferMs = numSamples * 1000.0 / mSampleRate;
+		if(mLastStart != 0)
+		{
+			const double interval = Time::highResolutionTicksToSeconds(mStart - mLastStart) * 1000.0;
+			const double error = interval - mStats.bufferMs;
+			mMeanSquare = mStats.numCallbacks == 0 ? error * error : mMeanSquare + (error * error - mMeanSquare) * CALLBACK_TIMING_SMOOTHING;
+			mStats.jitterRms = std::sqrt(mMeanSquare);
+			mStats.intervalMax = jmax(mStats.intervalMax, interval);
+			if(interval > mStats.bufferMs * CALLBACK_TIMING_LATE) mStats.numLate++;
+		}
+		mLastStart = mStart;
+	};
+
+	/** at the end of the callback, audio thread*/
+	void finished()
+	{
+		const double load = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - mStart) * 1000.0 / mStats.bufferMs;
+		mStats.loadAverage = mStats.numCallbacks == 0 ? load : mStats.loadAverage + (load - mStats.loadAverage) * CALLBACK_TIMING_SMOOTHING;
+		mStats.loadMax = jmax(mStats.loadMax, load);
+		mStats.numCallbacks++;
+
+		++mVersion;
+		mShared = mStats;
+		++mVersion;
+	};
+
+	/** a copy of the stats after the last callback, any thread. false if it couldn't be read this time*/
+	bool getStats(AudioCallbackStats& stats) const
+	{
+		for(int i=0;i<4;i++)
+		{
+			const int version = mVersion.get();
+			if(version & 1) continue;
+
+			stats = mShared;
+			if(mVersion.get() == version) return true;
+		}
+		return false;
+	};
+
+	/** the stats start again with the next callback, any thread*/
+	void resetStatistics()
+	{
+		mResetRequested.set(1);
+	};
+
+private:
+	void clearStatistics()
+	{
+		mStats.numCallbacks = 0;
+		mStats.jitterRms = 0.0;
+		mStats.intervalMax = 0.0;
+		mStats.loadAverage = 0.0;
+		mStats.loadMax = 0.0;
+		mStats.numLate = 0;
+		mMeanSquare = 0.0;
+	};
+
+	//audio thread only
+	AudioCallbackStats mStats;
+	double mSampleRate;
+	int64 mLastStart;		// high resolution ticks, 0 before the first callback
+	int64 mStart;
+	double mMeanSquare;
+
+	AudioCallbackStats mShared;
+	Atomic<int> mVersion;	// odd while mShared is written
+	Atomic<int> mResetRequested;
+};
+//---------------------------------------------------------------------------
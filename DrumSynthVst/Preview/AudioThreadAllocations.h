@@ -0,0 +1,74 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//---------------------------------------------------------------------------
+/** Counts the heap allocations made on the audio thread, which should stay 0.
+
+	The global operator new in Main.cpp reports every allocation here, the
+	preview engine marks its thread at the start of every callback. Memory
+	from malloc() and HeapBlock isn't seen, the preview doesn't resize any of
+	it after the device has started.
+*/
+class AudioThreadAllocations
+{
+public:
+	/** the audio thread can change when the device is reopened*/
+	static void setAudioThread()
+	{
+		sAudioThread = Thread::getCurrentThreadId();
+	};
+
+	static void clearAudioThread()
+	{
+		sAudioThread = 0;
+	};
+
+	/** called for every allocation, must not allocate itself*/
+	static void allocationMade()
+	{
+		if(sAudioThread != 0 && Thread::getCurrentThreadId() == sAudioThread)
+		{
+			++sNumAllocations;
+		}
+	};
+
+	static int getNumAllocations()
+	{
+		return sNumAllocations.get();
+	};
+
+	static void reset()
+	{
+		sNumAllocations = 0;
+	};
+
+private:
+	static Thread::ThreadID volatile sAudioThread;
+	static Atomic<int> sNumAllocations;
+};
+//---------------------------------------------------------------------------
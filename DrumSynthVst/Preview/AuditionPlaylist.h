@@ -0,0 +1,146 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Population.h"
+#include "../Midi/PatchSysEx.h"
+#include "../BackgroundJobs.h"
+#include "./PatchThumbnailCache.h"
+
+#define AUDITION_PREFETCH			4	// members after the current one that are prepared
+#define AUDITION_PREFETCH_BEHIND	1	// and before it, for stepping back
+
+//---------------------------------------------------------------------------
+/** Prepares the next members of a population while the current one is heard.
+
+	Auditioning a member loads it into the store, sends it and shows its
+	thumbnail. The send can't be done ahead, the diff is taken against the
+	state of the synth when the member is reached. What can be done ahead is
+	the SysEx frame of the member and the rendering of its preview sound:
+	prepare() queues an idle job for the frame of every member in the window
+	around the current one and requests the missing thumbnails, a later step
+	to one of them finds the frame with findDump() and the thumbnail on disk.
+	The prepared members are found by their values, so a stale entry after a
+	new generation is never used and dropped by the next prepare().
+	Message thread only, the jobs only touch their own copy of the patch.
+*/
+class AuditionPlaylist
+{
+public:
+	~AuditionPlaylist()
+	{
+		clear();
+	};
+
+	/** prepares the window around the current member of the population, call it after each step*/
+	void prepare(const Population& population)
+	{
+		const int numMembers = population.getNumMembers();
+		ReferenceCountedArray<PrepareJob> window;
+		for(int offset=-AUDITION_PREFETCH_BEHIND;offset<=AUDITION_PREFETCH;offset++)
+		{
+			if(offset == 0 || jmax(offset,-offset) >= numMembers) continue;
+
+			Patch* patch = population.getMember((population.getCurrent() + offset + numMembers) % numMembers);
+			PrepareJob* job = find(patch->getValues());
+			if(job == NULL)
+			{
+				job = new PrepareJob(*patch);
+				JobQueue::getInstance()->addJob(job);
+				PatchThumbnailCache::getInstance()->prefetch(patch->getValues());
+			}
+			window.addIfNotAlreadyThere(job);
+		}
+
+		for(int i=0;i<mJobs.size();i++)
+		{
+			if(!window.contains(mJobs.getUnchecked(i))) mJobs.getUnchecked(i)->cancel();
+		}
+		mJobs.swapWithArray(window);
+	};
+
+	/** the prepared frame of the values, NULL if it isn't ready*/
+	const MidiMessage* findDump(const uint8_t* values) const
+	{
+		PrepareJob* job = find(values);
+		return job != NULL && job->succeeded() ? &job->getDump() : NULL;
+	};
+
+	void clear()
+	{
+		for(int i=0;i<mJobs.size();i++)
+		{
+			mJobs.getUnchecked(i)->cancel();
+		}
+		mJobs.clear();
+	};
+
+private:
+	/** builds the SysEx frame of one member*/
+	class PrepareJob : public BackgroundJob
+	{
+	public:
+		PrepareJob(const Patch& patch)
+		: BackgroundJob("audition",JOB_PRIORITY_IDLE),
+		mPatch(patch)
+		{
+		};
+
+		bool run()
+		{
+			if(shouldExit()) return false;
+			mDump = PatchSysEx::createPatchDump(&mPatch);
+			return true;
+		};
+
+		const Patch& getPatch() const
+		{
+			return mPatch;
+		};
+
+		/** once the job has succeeded*/
+		const MidiMessage& getDump() const
+		{
+			return mDump;
+		};
+
+	private:
+		Patch mPatch;
+		MidiMessage mDump;
+	};
+
+	PrepareJob* find(const uint8_t* values) const
+	{
+		for(int i=0;i<mJobs.size();i++)
+		{
+			if(memcmp(mJobs.getUnchecked(i)->getPatch().getValues(),values,NUM_PARAMS) == 0) return mJobs.getUnchecked(i);
+		}
+		return NULL;
+	};
+
+	ReferenceCountedArray<PrepareJob> mJobs;	// the window of the last prepare()
+};
+//---------------------------------------------------------------------------
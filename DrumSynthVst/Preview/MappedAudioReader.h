@@ -0,0 +1,266 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/menu.h"
+#include "../Library/MappedFileData.h"
+
+//---------------------------------------------------------------------------
+/** An AudioFormatReader for uncompressed WAV and AIFF files that converts the
+	samples straight from a mapped file.
+
+	The juce readers read every block through a FileInputStream into a buffer
+	of their own and convert it from there. This one maps the file with
+	MappedFileData, so readSamples() takes the frames from the OS page cache
+	and opening a file costs no more than parsing its chunk headers. That keeps
+	thumbnails and scrubbing over thousands of short rendered previews cheap.
+
+	WAV: PCM with 8, 16, 24 or 32 bits, 32 bit float, also as WAVE_FORMAT_EXTENSIBLE.
+	AIFF and AIFC: 8, 16, 24 or 32 bits, 'sowt' (little endian) and 'fl32' AIFC.
+	Anything else, and a file without a data chunk, isn't opened. A data chunk
+	that is cut off is read as far as the file goes.
+*/
+class MappedAudioReader : public AudioFormatReader
+{
+public:
+	/** NULL if the file isn't uncompressed WAV or AIFF or can't be mapped*/
+	static MappedAudioReader* open(const File& file)
+	{
+		MappedFileData::Ptr mapping(MappedFileData::open(file));
+		if(mapping == NULL) return NULL;
+
+		ScopedPointer<MappedAudioReader> reader(new MappedAudioReader(mapping));
+		if(!reader->parseWav() && !reader->parseAiff()) return NULL;
+		return reader.release();
+	};
+
+	bool readSamples(int** destSamples, int numDestChannels, int startOffsetInDestBuffer, int64 startSampleInFile, int numSamples)
+	{
+		jassert(destSamples != NULL);
+		const int64 samplesAvailable = lengthInSamples - startSampleInFile;
+		if(samplesAvailable < numSamples)
+		{
+			for(int i=numDestChannels;--i>=0;)
+			{
+				if(destSamples[i] != NULL) zeromem(destSamples[i] + startOffsetInDestBuffer, sizeof(int)*numSamples);
+			}
+			numSamples = (int)samplesAvailable;
+		}
+		if(numSamples <= 0 || startSampleInFile < 0) return true;
+
+		const void* frames = mMapping->getData() + mDataStart + (size_t)startSampleInFile*mBytesPerFrame;
+		if(mBigEndian)
+		{
+			convert<AudioData::BigEndian>(destSamples, numDestChannels, startOffsetInDestBuffer, frames, numSamples);
+		}
+		else
+		{
+			convert<AudioData::LittleEndian>(destSamples, numDestChannels, startOffsetInDestBuffer, frames, numSamples);
+		}
+		return true;
+	};
+
+private:
+	MappedAudioReader(MappedFileData* mapping) : AudioFormatReader(NULL, "mapped audio"),
+		mMapping(mapping),
+		mDataStart(0),
+		mBytesPerFrame(0),
+		mBigEndian(false),
+		mUnsigned8Bit(false)
+	{
+	};
+
+	template <class Endianness>
+	void convert(int** dest, int numDest, int destOffset, const void* frames, int numSamples) const
+	{
+		switch(bitsPerSample)
+		{
+		case 8:
+			if(mUnsigned8Bit) ReadHelper<AudioData::Int32, AudioData::UInt8, Endianness>::read(dest, destOffset, numDest, frames, numChannels, numSamples);
+			else ReadHelper<AudioData::Int32, AudioData::Int8, Endianness>::read(dest, destOffset, numDest, frames, numChannels, numSamples);
+			break;
+		case 16:
+			ReadHelper<AudioData::Int32, AudioData::Int16, Endianness>::read(dest, destOffset, numDest, frames, numChannels, numSamples);
+			break;
+		case 24:
+			ReadHelper<AudioData::Int32, AudioData::Int24, Endianness>::read(dest, destOffset, numDest, frames, numChannels, numSamples);
+			break;
+		case 32:
+			if(usesFloatingPointData) ReadHelper<AudioData::Float32, AudioData::Float32, Endianness>::read(dest, destOffset, numDest, frames, numChannels, numSamples);
+			else ReadHelper<AudioData::Int32, AudioData::Int32, Endianness>::read(dest, destOffset, numDest, frames, numChannels, numSamples);
+			break;
+		default:
+			jassertfalse;
+			break;
+		}
+	};
+
+	/** fills in the format from the chunks, false if it isn't a WAV file the reader can handle*/
+	bool parseWav()
+	{
+		const uint8_t* header = mMapping->getRange(0,12);
+		if(header == NULL || memcmp(header,"RIFF",4) != 0 || memcmp(header+8,"WAVE",4) != 0) return false;
+
+		int format = -1;
+		size_t dataSize = 0;
+		bool hasData = false;
+		for(size_t pos=12;;)
+		{
+			const uint8_t* chunk = mMapping->getRange(pos,8);
+			if(chunk == NULL) break;
+			const size_t size = ByteOrder::littleEndianInt(chunk+4);
+			const size_t body = pos+8;
+
+			if(memcmp(chunk,"fmt ",4) == 0)
+			{
+				const uint8_t* fmt = mMapping->getRange(body,16);
+				if(fmt == NULL || size < 16) return false;
+				format = ByteOrder::littleEndianShort(fmt);
+				numChannels = ByteOrder::littleEndianShort(fmt+2);
+				sampleRate = ByteOrder::littleEndianInt(fmt+4);
+				bitsPerSample = ByteOrder::littleEndianShort(fmt+14);
+
+				//WAVE_FORMAT_EXTENSIBLE, the format is the start of the sub format GUID
+				const uint8_t* extensible = mMapping->getRange(body+24,2);
+				if(format == 0xfffe && size >= 40 && extensible != NULL) format = ByteOrder::littleEndianShort(extensible);
+			}
+			else if(memcmp(chunk,"data",4) == 0)
+			{
+				mDataStart = body;
+				dataSize = jmin(size, mMapping->getSize() - jmin(body, mMapping->getSize()));
+				hasData = true;
+			}
+
+			//chunks are padded to an even size
+			if(size > mMapping->getSize()) break;
+			pos = body + size + (size&1);
+		}
+
+		if(!hasData) return false;
+		if(format == 1) usesFloatingPointData = false;
+		else if(format == 3 && bitsPerSample == 32) usesFloatingPointData = true;
+		else return false;
+
+		mBigEndian = false;
+		mUnsigned8Bit = true;
+		return setFrames(dataSize, -1);
+	};
+
+	/** the same for AIFF and AIFC*/
+	bool parseAiff()
+	{
+		const uint8_t* header = mMapping->getRange(0,12);
+		if(header == NULL || memcmp(header,"FORM",4) != 0) return false;
+		const bool aifc = memcmp(header+8,"AIFC",4) == 0;
+		if(!aifc && memcmp(header+8,"AIFF",4) != 0) return false;
+
+		int64 numFrames = -1;
+		size_t dataSize = 0;
+		bool hasData = false;
+		mBigEndian = true;
+		usesFloatingPointData = false;
+		for(size_t pos=12;;)
+		{
+			const uint8_t* chunk = mMapping->getRange(pos,8);
+			if(chunk == NULL) break;
+			const size_t size = ByteOrder::bigEndianInt(chunk+4);
+			const size_t body = pos+8;
+
+			if(memcmp(chunk,"COMM",4) == 0)
+			{
+				const uint8_t* comm = mMapping->getRange(body,18);
+				if(comm == NULL || size < 18) return false;
+				numChannels = ByteOrder::bigEndianShort(comm);
+				numFrames = ByteOrder::bigEndianInt(comm+2);
+				bitsPerSample = ByteOrder::bigEndianShort(comm+6);
+				sampleRate = readExtended(comm+8);
+
+				const uint8_t* compression = mMapping->getRange(body+18,4);
+				if(aifc && compression != NULL && size >= 22)
+				{
+					if(memcmp(compression,"sowt",4) == 0) mBigEndian = false;
+					else if(memcmp(compression,"fl32",4) == 0 || memcmp(compression,"FL32",4) == 0) usesFloatingPointData = true;
+					else if(memcmp(compression,"NONE",4) != 0) return false;
+				}
+			}
+			else if(memcmp(chunk,"SSND",4) == 0)
+			{
+				const uint8_t* ssnd = mMapping->getRange(body,8);
+				if(ssnd == NULL || size < 8) return false;
+				const size_t offset = ByteOrder::bigEndianInt(ssnd);
+				mDataStart = body + 8 + offset;
+				if(mDataStart > mMapping->getSize() || offset > size-8) return false;
+				dataSize = jmin(size-8-offset, mMapping->getSize() - mDataStart);
+				hasData = true;
+			}
+
+			if(size > mMapping->getSize()) break;
+			pos = body + size + (size&1);
+		}
+
+		if(!hasData || (usesFloatingPointData && bitsPerSample != 32)) return false;
+		mUnsigned8Bit = false;
+		return setFrames(dataSize, numFrames);
+	};
+
+	/** checks the format, the length is what the data holds, at most numFrames if that is known*/
+	bool setFrames(size_t dataSize, int64 numFrames)
+	{
+		if(numChannels <= 0 || sampleRate <= 0) return false;
+		if(bitsPerSample != 8 && bitsPerSample != 16 && bitsPerSample != 24 && bitsPerSample != 32) return false;
+
+		mBytesPerFrame = (int)numChannels * (int)(bitsPerSample/8);
+		lengthInSamples = (int64)(dataSize / mBytesPerFrame);
+		if(numFrames >= 0) lengthInSamples = jmin(lengthInSamples, numFrames);
+		return true;
+	};
+
+	/** the 80 bit IEEE extended sample rate of an AIFF COMM chunk*/
+	static double readExtended(const uint8_t* bytes)
+	{
+		const int exponent = ((bytes[0]&0x7f)<<8) | bytes[1];
+		uint64 mantissa = 0;
+		for(int i=2;i<10;i++)
+		{
+			mantissa = (mantissa<<8) | bytes[i];
+		}
+		if(exponent == 0 && mantissa == 0) return 0.0;
+
+		const double value = ldexp((double)mantissa, exponent-16383-63);
+		return (bytes[0]&0x80) ? -value : value;
+	};
+
+	MappedFileData::Ptr mMapping;	// the reader has no stream, everything is read from here
+	size_t mDataStart;
+	int mBytesPerFrame;
+	bool mBigEndian;
+	bool mUnsigned8Bit;				// 8 bit WAV is unsigned, 8 bit AIFF signed
+
+	// (prevent copy constructor and operator= being generated..)
+	MappedAudioReader (const MappedAudioReader&);
+	const MappedAudioReader& operator= (const MappedAudioReader&);
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,337 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoiceBank.h"
+#include "./PreviewFft.h"
+#include "../ParallelFor.h"
+
+#define PATCH_FEATURE_SAMPLE_RATE		44100.0
+#define PATCH_FEATURE_MAX_SECONDS		2.0		// longest part of a hit that is analysed
+#define PATCH_FEATURE_FFT_ORDER			10		// 1024 samples, 23ms
+#define PATCH_FEATURE_HOP				256		// 5.8ms between frames
+#define PATCH_FEATURE_ENVELOPE_POINTS	8
+#define PATCH_FEATURE_SPECTRUM_STEP	2		// every second frame goes through the FFT, the window overlaps by half
+#define PATCH_FEATURE_SPECTRUM_DB		-60.f	// frames further below the peak are left out of the centroid
+#define PATCH_FEATURE_DECAY_DB			-40.f	// decay time is measured from the peak down to this
+#define PATCH_FEATURE_FLOOR_DB			-90.f
+#define PATCH_FEATURE_SIZE				(3+PATCH_FEATURE_ENVELOPE_POINTS)
+#define PATCH_FEATURES_BYTES			(PREVIEW_NUM_VOICES*PATCH_FEATURE_SIZE*4)	// what PatchFeatures::write() puts out
+#define PATCH_FEATURE_DISTANCE_DB		20.f	// envelope difference that counts as much as an octave of centroid
+
+//---------------------------------------------------------------------------
+/** What one voice of a sound sounds like, in numbers a distance can be taken of*/
+struct PatchVoiceFeatures
+{
+	float centroid;			// spectral centroid in Hz, weighted by the energy of the frames
+	float decayTime;		// seconds from the peak until the level has fallen by PATCH_FEATURE_DECAY_DB
+	float onsetSharpness;	// 1/(1+ms) of the rise from 10% to 90% of the peak, 1 = a click
+	float envelope[PATCH_FEATURE_ENVELOPE_POINTS];	// level in dB below the peak, 0,5,10,20..640ms after the hit
+
+	void clear()
+	{
+		centroid = decayTime = onsetSharpness = 0.f;
+		for(int i=0;i<PATCH_FEATURE_ENVELOPE_POINTS;i++) envelope[i] = PATCH_FEATURE_FLOOR_DB;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** The features of all six voices, stored in the patch index next to the hash*/
+struct PatchFeatures
+{
+	PatchVoiceFeatures voices[PREVIEW_NUM_VOICES];
+
+	void clear()
+	{
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++) voices[i].clear();
+	};
+
+	void write(OutputStream& out) const
+	{
+		for(int v=0;v<PREVIEW_NUM_VOICES;v++)
+		{
+			out.writeFloat(voices[v].centroid);
+			out.writeFloat(voices[v].decayTime);
+			out.writeFloat(voices[v].onsetSharpness);
+			for(int i=0;i<PATCH_FEATURE_ENVELOPE_POINTS;i++) out.writeFloat(voices[v].envelope[i]);
+		}
+	};
+
+	void read(InputStream& in)
+	{
+		for(int v=0;v<PREVIEW_NUM_VOICES;v++)
+		{
+			voices[v].centroid = in.readFloat();
+			voices[v].decayTime = in.readFloat();
+			voices[v].onsetSharpness = in.readFloat();
+			for(int i=0;i<PATCH_FEATURE_ENVELOPE_POINTS;i++) voices[v].envelope[i] = in.readFloat();
+		}
+	};
+
+	/** how different two sounds are, summed over the voices: the centroids in octaves, the decay
+		times in seconds, the onsets and the mean envelope difference in units of PATCH_FEATURE_DISTANCE_DB*/
+	float getDistance(const PatchFeatures& other) const
+	{
+		float distance = 0.f;
+		for(int v=0;v<PREVIEW_NUM_VOICES;v++)
+		{
+			const PatchVoiceFeatures& a = voices[v];
+			const PatchVoiceFeatures& b = other.voices[v];
+
+			//+1Hz, a silent voice has a centroid of 0
+			distance += fabsf(logf((a.centroid+1.f)/(b.centroid+1.f))) * (float)(1.0/log(2.0));
+			distance += fabsf(a.decayTime - b.decayTime);
+			distance += fabsf(a.onsetSharpness - b.onsetSharpness);
+
+			float envelope = 0.f;
+			for(int i=0;i<PATCH_FEATURE_ENVELOPE_POINTS;i++)
+			{
+				envelope += fabsf(a.envelope[i] - b.envelope[i]);
+			}
+			distance += envelope / (PATCH_FEATURE_ENVELOPE_POINTS*PATCH_FEATURE_DISTANCE_DB);
+		}
+		return distance;
+	};
+};
+
+//---------------------------------------------------------------------------
+/** Renders every voice of a sound on its own and measures it.
+
+	The voice alone is rendered at PATCH_FEATURE_SAMPLE_RATE, then cut into
+	overlapping Hann windowed frames. The level of each frame gives the
+	envelope and the decay time, the spectra of the louder frames give the
+	centroid.
+	The onset is measured on the peaks of PREVIEW_BLOCK_SIZE samples, a frame
+	is too coarse for a click.
+	Keeps its buffers between calls, use one extractor per thread.
+*/
+class PatchFeatureExtractor
+{
+public:
+	PatchFeatureExtractor()
+	: mFft(PATCH_FEATURE_FFT_ORDER)
+	{
+		const int size = mFft.getSize();
+		mWindow.malloc(size);
+		for(int i=0;i<size;i++)
+		{
+			mWindow[i] = 0.5f - 0.5f*(float)cos(2.0*double_Pi*i/size);
+		}
+		mFrame.malloc(size);
+		mPower.malloc(size/2+1);
+
+		mMaxLength = roundToInt(PATCH_FEATURE_MAX_SECONDS*PATCH_FEATURE_SAMPLE_RATE) + size;
+		mLeft.malloc(mMaxLength);
+		mRight.malloc(mMaxLength);
+		mVoices.setSampleRate(PATCH_FEATURE_SAMPLE_RATE);
+	};
+
+	~PatchFeatureExtractor()
+	{
+	};
+
+	void compute(const uint8_t* values, PatchFeatures& result)
+	{
+		const ScopedPreviewFloatMode floatMode;
+		for(int v=0;v<PREVIEW_NUM_VOICES;v++)
+		{
+			computeVoice(PreviewVoiceSettings::fromValues(v, values, 1.f), result.voices[v]);
+		}
+	};
+
+	/** the features of every sound of NUM_PARAMS values in values, on all cores*/
+	static void computeAll(const Array<const uint8_t*>& values, PatchFeatures* results)
+	{
+		ParallelFor* parallel = ParallelFor::getInstance();
+		Task task(values, results, parallel->getNumWorkers());
+		parallel->execute(values.size(), 1, task);
+	};
+
+private:
+	/** one sound per item, an extractor is made for each worker that gets one*/
+	class Task : public ParallelTask
+	{
+	public:
+		Task(const Array<const uint8_t*>& values, PatchFeatures* results, int numWorkers)
+		: mValues(values),
+		mResults(results)
+		{
+			for(int i=0;i<numWorkers;i++)
+			{
+				mExtractors.add(NULL);
+			}
+		};
+
+		void run(int begin, int end, int workerIndex)
+		{
+			PatchFeatureExtractor* extractor = mExtractors.getUnchecked(workerIndex);
+			if(extractor == NULL)
+			{
+				extractor = new PatchFeatureExtractor();
+				mExtractors.set(workerIndex, extractor);
+			}
+			for(int i=begin;i<end;i++)
+			{
+				extractor->compute(mValues.getUnchecked(i), mResults[i]);
+			}
+		};
+
+	private:
+		const Array<const uint8_t*>& mValues;
+		PatchFeatures* mResults;
+		OwnedArray<PatchFeatureExtractor> mExtractors;	// by worker, the slots don't move
+	};
+
+	void computeVoice(const PreviewVoiceSettings& settings, PatchVoiceFeatures& result)
+	{
+		result.clear();
+
+		const int size = mFft.getSize();
+		const double seconds = jmin((double)(settings.attack + settings.decay), PATCH_FEATURE_MAX_SECONDS);
+		const int length = jmin(mMaxLength, roundToInt(seconds*PATCH_FEATURE_SAMPLE_RATE) + size);
+
+		zeromem(mLeft, sizeof(float)*length);
+		zeromem(mRight, sizeof(float)*length);
+		mVoices.stopAll();
+		mVoices.start(settings);
+		for(int pos=0;pos<length;pos+=PREVIEW_BLOCK_SIZE)
+		{
+			const int num = jmin(PREVIEW_BLOCK_SIZE, length-pos);
+			mVoices.renderAdding(mLeft+pos, mRight+pos, num);
+		}
+		for(int i=0;i<length;i++)
+		{
+			mLeft[i] = 0.5f*(mLeft[i] + mRight[i]);
+		}
+
+		measureOnset(length, result);
+		measureFrames(length, result);
+	};
+
+	void measureOnset(int length, PatchVoiceFeatures& result)
+	{
+		//peak of every block
+		const int numBlocks = length/PREVIEW_BLOCK_SIZE;
+		float peak = 0.f;
+		for(int b=0;b<numBlocks;b++)
+		{
+			const float* in = mLeft + b*PREVIEW_BLOCK_SIZE;
+			mRight[b] = 0.f;
+			for(int i=0;i<PREVIEW_BLOCK_SIZE;i++) mRight[b] = jmax(mRight[b], fabsf(in[i]));
+			peak = jmax(peak, mRight[b]);
+		}
+		if(peak <= 0.f) return;
+
+		int low = -1, high = -1;
+		for(int b=0;b<numBlocks && high<0;b++)
+		{
+			if(low < 0 && mRight[b] >= 0.1f*peak) low = b;
+			if(mRight[b] >= 0.9f*peak) high = b;
+		}
+		const double riseMs = (high-low)*PREVIEW_BLOCK_SIZE*1000.0/PATCH_FEATURE_SAMPLE_RATE;
+		result.onsetSharpness = (float)(1.0/(1.0+riseMs));
+	};
+
+	void measureFrames(int length, PatchVoiceFeatures& result)
+	{
+		const int size = mFft.getSize();
+		const int numBins = size/2+1;
+		const double binHz = PATCH_FEATURE_SAMPLE_RATE/size;
+
+		//level of every frame in mRight, the onset is done with it
+		const int numFrames = (length-size)/PATCH_FEATURE_HOP + 1;
+		float peakDb = PATCH_FEATURE_FLOOR_DB;
+		int peakFrame = 0;
+		for(int f=0;f<numFrames;f++)
+		{
+			const float* in = mLeft + f*PATCH_FEATURE_HOP;
+			double energy = 0.0;
+			for(int i=0;i<size;i++)
+			{
+				energy += in[i]*in[i]*mWindow[i]*mWindow[i];
+			}
+			const float db = energy > 0.0 ? jmax(PATCH_FEATURE_FLOOR_DB, (float)(10.0*log10(energy/size))) : PATCH_FEATURE_FLOOR_DB;
+			mRight[f] = db;
+			if(db > peakDb)
+			{
+				peakDb = db;
+				peakFrame = f;
+			}
+		}
+		if(peakDb <= PATCH_FEATURE_FLOOR_DB) return;
+
+		//the quiet tail hardly moves the centroid, and its denormals would make the FFT crawl
+		double weightedCentroid = 0.0, totalPower = 0.0;
+		for(int f=0;f<numFrames;f+=PATCH_FEATURE_SPECTRUM_STEP)
+		{
+			if(mRight[f] < peakDb + PATCH_FEATURE_SPECTRUM_DB) continue;
+
+			const float* in = mLeft + f*PATCH_FEATURE_HOP;
+			for(int i=0;i<size;i++)
+			{
+				mFrame[i] = in[i]*mWindow[i];
+			}
+			mFft.powerSpectrum(mFrame, mPower);
+			for(int k=1;k<numBins;k++)
+			{
+				weightedCentroid += mPower[k]*k*binHz;
+				totalPower += mPower[k];
+			}
+		}
+
+		result.centroid = totalPower > 0.0 ? (float)(weightedCentroid/totalPower) : 0.f;
+
+		//the first frame after the peak that is quiet enough
+		int end = numFrames;
+		for(int f=peakFrame;f<numFrames;f++)
+		{
+			if(mRight[f] <= peakDb + PATCH_FEATURE_DECAY_DB)
+			{
+				end = f;
+				break;
+			}
+		}
+		result.decayTime = (float)((end-peakFrame)*PATCH_FEATURE_HOP/PATCH_FEATURE_SAMPLE_RATE);
+
+		//0ms, then doubling from 5ms
+		for(int i=0;i<PATCH_FEATURE_ENVELOPE_POINTS;i++)
+		{
+			const double ms = i == 0 ? 0.0 : 5.0*(1<<(i-1));
+			const int f = roundToInt(ms*0.001*PATCH_FEATURE_SAMPLE_RATE/PATCH_FEATURE_HOP);
+			result.envelope[i] = f < numFrames ? jmax(PATCH_FEATURE_FLOOR_DB, mRight[f] - peakDb) : PATCH_FEATURE_FLOOR_DB;
+		}
+	};
+
+	PreviewFft mFft;
+	HeapBlock<float> mWindow;
+	HeapBlock<float> mFrame;
+	HeapBlock<float> mPower;
+
+	PreviewVoiceBank mVoices;
+	HeapBlock<float> mLeft, mRight;
+	int mMaxLength;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,318 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PatchHash.h"
+#include "./PreviewRenderer.h"
+#include "./MappedAudioReader.h"
+#include "../Library/SharedCache.h"
+#include "../BackgroundJobs.h"
+
+#define THUMBNAIL_SAMPLES_PER_THUMB_SAMPLE	256
+#define THUMBNAIL_MEMORY_CACHE_SIZE			512		// thumbnails kept in memory, the rest is read from disk
+#define THUMBNAIL_VERSION					1		// bump when the preview sound changes, old files are then ignored
+#define THUMBNAIL_FOLDER					"SonicPotionsEditor/thumbnails"
+#define THUMBNAIL_EXTENSION					".thumb"
+
+//---------------------------------------------------------------------------
+/** Waveform thumbnails of the preview sound of patches, keyed by the hash of
+	the patch values.
+
+	The juce AudioThumbnailCache holds the recently used thumbnails in memory,
+	behind it every thumbnail is stored as a small file in the application data
+	folder, so a sound is rendered only once, ever. Missing thumbnails are
+	rendered as interactive jobs of the JobQueue, or as idle ones ahead of
+	time by prefetch(), the listeners are told on
+	the message thread when one is ready. Everything but the jobs is message
+	thread only.
+	Rendered files, like the previews of PreviewBatchRenderer, get their
+	thumbnails through loadFile() from a MappedAudioReader.
+*/
+class PatchThumbnailCache : private BackgroundJob::Listener
+{
+public:
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		virtual void thumbnailReady(int64 hash) = 0;
+	};
+
+	PatchThumbnailCache()
+	: mMemory(THUMBNAIL_MEMORY_CACHE_SIZE)
+	{
+		mFolder = File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile(THUMBNAIL_FOLDER);
+	};
+
+	~PatchThumbnailCache()
+	{
+		//the jobs use the formats and the folder of the cache
+		for(int i=0;i<mJobs.size();i++)
+		{
+			mJobs.getUnchecked(i)->removeListener(this);
+			mJobs.getUnchecked(i)->cancel();
+		}
+		for(int i=0;i<mJobs.size();i++)
+		{
+			mJobs.getUnchecked(i)->waitUntilDone(-1);
+		}
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (PatchThumbnailCache, false)
+
+	/** the patch hash, salted with THUMBNAIL_VERSION*/
+	static int64 getHash(const uint8_t* values)
+	{
+		return (int64)(hashPatchValues(values) ^ (THUMBNAIL_VERSION * literal64bit(0x9e3779b97f4a7c15)));
+	};
+
+	/** a thumbnail that uses this cache*/
+	AudioThumbnail* createThumbnail()
+	{
+		return new AudioThumbnail(THUMBNAIL_SAMPLES_PER_THUMB_SAMPLE,mFormats,mMemory);
+	};
+
+	/** fills the thumbnail from memory or disk, false if the sound hasn't been rendered yet*/
+	bool load(AudioThumbnail& thumb, int64 hash)
+	{
+		if(mMemory.loadThumb(thumb,hash)) return true;
+
+		FileInputStream in(getFile(hash));
+		if(in.getStatus().failed()) return false;
+
+		thumb.loadFrom(in);
+		mMemory.storeThumb(thumb,hash);
+		return true;
+	};
+
+	/** a thumbnail of an uncompressed WAV or AIFF file. The thumbnail keeps the mapped reader and
+		scans it on the thread of the memory cache, false if the file can't be read that way*/
+	bool loadFile(AudioThumbnail& thumb, const File& file)
+	{
+		MappedAudioReader* reader = MappedAudioReader::open(file);
+		if(reader == NULL) return false;
+
+		thumb.setReader(reader,SharedCache::makeFileKey(file,THUMBNAIL_VERSION));
+		return true;
+	};
+
+	/** renders the thumbnail in the background unless it is already queued, call it when load() failed.
+		A prefetch that hasn't started yet is queued again with the higher priority*/
+	void request(const uint8_t* values, int priority = JOB_PRIORITY_INTERACTIVE)
+	{
+		const int64 hash = getHash(values);
+		RenderJob* pending = findJob(hash);
+		if(pending != NULL)
+		{
+			if(pending->getPriority() <= priority || pending->getState() != BackgroundJob::JOB_QUEUED) return;
+
+			pending->removeListener(this);
+			pending->cancel();
+			mJobs.removeObject(pending);
+		}
+
+		RenderJob* job = new RenderJob(*this,values,hash,priority);
+		job->addListener(this);
+		mJobs.add(job);
+		JobQueue::getInstance()->addJob(job);
+	};
+
+	/** renders the thumbnail as idle work unless it is on disk, for a patch that is likely shown soon*/
+	void prefetch(const uint8_t* values)
+	{
+		if(!getFile(getHash(values)).existsAsFile()) request(values,JOB_PRIORITY_IDLE);
+	};
+
+	void addListener(Listener* listener)
+	{
+		mListeners.add(listener);
+	};
+
+	void removeListener(Listener* listener)
+	{
+		mListeners.remove(listener);
+	};
+
+private:
+	/** renders one sound, its saved thumbnail is the result*/
+	class RenderJob : public BackgroundJob
+	{
+	public:
+		RenderJob(PatchThumbnailCache& owner, const uint8_t* values, int64 hash, int priority)
+		: BackgroundJob("thumbnail",priority),
+		mOwner(owner),
+		mHash(hash)
+		{
+			memcpy(mValues,values,NUM_PARAMS);
+		};
+
+		bool run()
+		{
+			//a prefetch waits until the user is still
+			if(shouldExit()) return false;
+
+			AudioSampleBuffer buffer(2,1);
+			PreviewRenderer::renderCached(mValues,PREVIEW_RENDER_SAMPLE_RATE,buffer);
+			if(shouldExit()) return false;
+
+			//a private thumbnail, the shared memory cache is only touched on the message thread
+			AudioThumbnail thumb(THUMBNAIL_SAMPLES_PER_THUMB_SAMPLE,mOwner.mFormats,mOwner.mMemory);
+			thumb.reset(buffer.getNumChannels(),PREVIEW_RENDER_SAMPLE_RATE,buffer.getNumSamples());
+			thumb.addBlock(0,buffer,0,buffer.getNumSamples());
+
+			MemoryOutputStream out(mData,false);
+			thumb.saveTo(out);
+			out.flush();
+
+			mOwner.writeFile(mHash,mData);
+			return true;
+		};
+
+		int64 getHash() const
+		{
+			return mHash;
+		};
+
+		/** the saved thumbnail, once the job has succeeded*/
+		const MemoryBlock& getData() const
+		{
+			return mData;
+		};
+
+	private:
+		PatchThumbnailCache& mOwner;
+		const int64 mHash;
+		uint8_t mValues[NUM_PARAMS];
+		MemoryBlock mData;
+	};
+
+	RenderJob* findJob(int64 hash) const
+	{
+		for(int i=0;i<mJobs.size();i++)
+		{
+			RenderJob* job = static_cast<RenderJob*>(mJobs.getUnchecked(i).getObject());
+			if(job->getHash() == hash) return job;
+		}
+		return NULL;
+	};
+
+	File getFile(int64 hash) const
+	{
+		return mFolder.getChildFile(String::toHexString(hash) + THUMBNAIL_EXTENSION);
+	};
+
+	/** job threads, a write that fails only means the sound is rendered again next time*/
+	void writeFile(int64 hash, const MemoryBlock& data)
+	{
+		if(!mFolder.createDirectory()) return;
+
+		TemporaryFile temp(getFile(hash));
+		if(temp.getFile().replaceWithData(data.getData(),data.getSize()))
+		{
+			temp.overwriteTargetFileWithTemporary();
+		}
+	};
+
+	/** the finished jobs of one dispatch arrive one after the other*/
+	void jobFinished(BackgroundJob* job)
+	{
+		RenderJob* render = static_cast<RenderJob*>(job);
+		int64 hash = render->getHash();
+		mJobs.removeObject(render);
+		if(!render->succeeded()) return;
+
+		ScopedPointer<AudioThumbnail> thumb(createThumbnail());
+		MemoryInputStream in(render->getData(),false);
+		thumb->loadFrom(in);
+		mMemory.storeThumb(*thumb,hash);
+
+		mListeners.call(&Listener::thumbnailReady,hash);
+	};
+
+	AudioFormatManager mFormats;	// AudioThumbnail wants one, the sounds never come from files
+	AudioThumbnailCache mMemory;
+	File mFolder;
+
+	ReferenceCountedArray<BackgroundJob> mJobs;	// queued or rendering
+	ListenerList<Listener> mListeners;
+};
+//---------------------------------------------------------------------------
+/** Draws the preview waveform of a patch, fetched from the PatchThumbnailCache.
+	Until a new sound is rendered the previous waveform stays dimmed.
+*/
+class PatchThumbnailComponent : public Component, private PatchThumbnailCache::Listener
+{
+public:
+	PatchThumbnailComponent()
+	: mThumbnail(PatchThumbnailCache::getInstance()->createThumbnail()),
+	mHash(0),
+	mUpToDate(false)
+	{
+		PatchThumbnailCache::getInstance()->addListener(this);
+	};
+
+	~PatchThumbnailComponent()
+	{
+		PatchThumbnailCache::getInstance()->removeListener(this);
+	};
+
+	void setPatch(const uint8_t* values)
+	{
+		PatchThumbnailCache* cache = PatchThumbnailCache::getInstance();
+		mHash = PatchThumbnailCache::getHash(values);
+		mUpToDate = cache->load(*mThumbnail,mHash);
+		if(!mUpToDate)
+		{
+			cache->request(values);
+		}
+		repaint();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colours::black);
+		if(mThumbnail->getTotalLength() <= 0.0) return;
+
+		g.setColour(Colour(0xff43f04c).withAlpha(mUpToDate ? 1.f : 0.3f));
+		mThumbnail->drawChannels(g,getLocalBounds(),0.0,mThumbnail->getTotalLength(),1.f);
+	};
+
+private:
+	void thumbnailReady(int64 hash)
+	{
+		if(hash == mHash && !mUpToDate)
+		{
+			mUpToDate = PatchThumbnailCache::getInstance()->load(*mThumbnail,mHash);
+			repaint();
+		}
+	};
+
+	ScopedPointer<AudioThumbnail> mThumbnail;
+	int64 mHash;
+	bool mUpToDate;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,463 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoiceBank.h"
+#include "./PreviewLfos.h"
+#include "../ParameterStore.h"
+#include "../ThreadPriorities.h"
+#include "./AudioThreadAllocations.h"
+#include "./PreviewSequencer.h"
+#include "./AudioCallbackTiming.h"
+#include "../Midi/MidiClockFollower.h"
+
+#define PREVIEW_MAX_EVENTS		32		// triggers that can wait for the audio thread
+#define PREVIEW_MIDI_BUFFER_SIZE	4096	// bytes reserved for the hits of one callback
+
+//---------------------------------------------------------------------------
+/** Plays the current sound on the computer's audio output, so a patch can be
+	heard without sending it to the synth and back.
+
+	trigger() and playSound() are called on the message thread. They hand the
+	hit to the audio callback through a lock free fifo, the audio thread never
+	waits for the message thread.
+	The sound itself isn't sent along. At the start of every callback the audio
+	thread copies the values of the ParameterStore if its version has changed,
+	and hands the new values to the playing voices at the next block boundary,
+	so turning a knob during a long decay is heard right away. The store has
+	several writers (UI and MIDI), which is why a version counter is used
+	instead of a single producer fifo. The PreviewLfoBank modulates the
+	snapshot once per block, the voices always get its modulated copy.
+	Each voice is monophonic like on the LXR, a new hit restarts it.
+	The hits of a callback, from trigger() and from the PreviewSequencer, are
+	collected as note ons in a MidiBuffer and start at their exact sample.
+	With setFollowClock() the groove takes tempo and position from the
+	MidiClockFollower and only plays while the external transport runs, the
+	hits of trigger() and playSound() then start on the next 8th note and
+	the PREVIEW_STEP_MS between them become 8th notes. The callback reads the
+	clock state itself, the time it is heard at includes the output latency.
+	All state is fixed size and set up before the device starts, the callback
+	never allocates. AudioThreadAllocations checks that in the diagnostics.
+*/
+class PreviewEngine : public AudioIODeviceCallback
+{
+public:
+	PreviewEngine() : mFifo(PREVIEW_MAX_EVENTS)
+	{
+		mSampleRate = 44100.0;
+		mNumScheduled = 0;
+		mAutoPreview = false;
+
+		mStore = ParameterStore::getInstance();
+		mVersion = mStore->copyValues(mValues);
+
+		mPatternPlaying = false;
+		mSequencerRunning = false;
+
+		mClock = MidiClockFollower::getInstance();
+		mFollowClock = false;
+		mFollowing = false;
+		mClockRunning = false;
+		mClockPosition = 0.0;
+		mClockBpm = PREVIEW_SEQUENCER_DEFAULT_BPM;
+		mClockStepSamples = 0.0;
+		mOutputLatency = 0.0;
+		mMidi.ensureSize(PREVIEW_MIDI_BUFFER_SIZE);
+	};
+
+	~PreviewEngine()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (PreviewEngine, false)
+
+	/** plays one voice of the current sound after delayMs*/
+	void trigger(int voiceNr, float velocity = 1.f, double delayMs = 0.0)
+	{
+		Event e;
+		e.type = Event::START;
+		e.voiceNr = voiceNr;
+		e.velocity = velocity;
+		e.delayMs = delayMs;
+		post(e);
+		UserActivity::auditioned(delayMs);
+	};
+
+	/** plays all six voices of the current sound one after the other*/
+	void playSound()
+	{
+		stopAll();
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			trigger(i, 1.f, i*PREVIEW_STEP_MS);
+		}
+	};
+
+	/** silences the voices and drops the hits that haven't started yet*/
+	void stopAll()
+	{
+		Event e;
+		e.type = Event::STOP;
+		e.voiceNr = 0;
+		e.velocity = 0.f;
+		e.delayMs = 0.0;
+		post(e);
+	};
+
+	/** whether the patch generator plays every patch it shows*/
+	bool getAutoPreview() const
+	{
+		return mAutoPreview;
+	};
+
+	void setAutoPreview(bool autoPreview)
+	{
+		mAutoPreview = autoPreview;
+	};
+
+	/** loops the groove of the PreviewSequencer until it is switched off again*/
+	void setPatternPlaying(bool playing)
+	{
+		mPatternPlaying = playing;
+
+		Event e;
+		e.type = playing ? Event::PATTERN_START : Event::PATTERN_STOP;
+		e.voiceNr = 0;
+		e.velocity = 0.f;
+		e.delayMs = 0.0;
+		post(e);
+	};
+
+	bool isPatternPlaying() const
+	{
+		return mPatternPlaying;
+	};
+
+	/** locks the groove and the hits to the MIDI clock of an external sequencer*/
+	void setFollowClock(bool follow)
+	{
+		mFollowClock = follow;
+
+		Event e;
+		e.type = follow ? Event::FOLLOW_START : Event::FOLLOW_STOP;
+		e.voiceNr = 0;
+		e.velocity = 0.f;
+		e.delayMs = 0.0;
+		post(e);
+	};
+
+	bool isFollowingClock() const
+	{
+		return mFollowClock;
+	};
+
+	/** hits that were sounding at the end of the last callback, for the diagnostics*/
+	int getNumPlaying() const
+	{
+		return mNumPlaying.get();
+	};
+
+	/** when the callbacks arrive and how long they take, for the diagnostics*/
+	AudioCallbackTiming& getCallbackTiming()
+	{
+		return mTiming;
+	};
+
+	//----- AudioIODeviceCallback
+	void audioDeviceAboutToStart(AudioIODevice* device)
+	{
+		mSampleRate = device->getCurrentSampleRate();
+		mOutputLatency = device->getOutputLatencyInSamples() / mSampleRate;
+		mNumScheduled = 0;
+		mVoices.setSampleRate(mSampleRate);
+		mLfos.setSampleRate(mSampleRate);
+		mLfos.reset(mValues);
+		mSequencer.reset();
+		mTiming.setSampleRate(mSampleRate);
+	};
+
+	void audioDeviceStopped()
+	{
+		AudioThreadAllocations::clearAudioThread();
+		mNumPlaying = 0;
+	};
+
+	void audioDeviceIOCallback(const float** /*inputChannelData*/, int /*numInputChannels*/,
+		float** outputChannelData, int numOutputChannels, int numSamples)
+	{
+		AudioThreadAllocations::setAudioThread();
+		mTiming.started(numSamples);
+
+		for(int c=0;c<numOutputChannels;c++)
+		{
+			if(outputChannelData[c] != NULL)
+			{
+				zeromem(outputChannelData[c], sizeof(float)*numSamples);
+			}
+		}
+
+		readClock();
+		readEvents();
+		const bool changed = readValues();
+
+		float* left = numOutputChannels > 0 ? outputChannelData[0] : NULL;
+		float* right = numOutputChannels > 1 ? outputChannelData[1] : NULL;
+		if(left == NULL)
+		{
+			left = right;
+			right = NULL;
+		}
+		if(left == NULL)
+		{
+			mTiming.finished();
+			return;
+		}
+
+		if(changed) updateVoices();
+
+		//the hits of this callback with their sample positions
+		mMidi.clear();
+		addDueEvents(numSamples);
+		if(mSequencerRunning && !mFollowing)
+		{
+			mSequencer.process(mValues, mSampleRate, numSamples, mMidi);
+		}
+		else if(mSequencerRunning && mClockRunning)
+		{
+			mSequencer.processFollowing(mValues, mSampleRate, numSamples, mMidi, mClockPosition, mClockBpm);
+		}
+
+		//the blocks are cut at every hit
+		MidiBuffer::Iterator iter(mMidi);
+		const uint8* data;
+		int numBytes, hitPosition;
+		bool hasHit = iter.getNextEvent(data, numBytes, hitPosition);
+		int pos = 0;
+		while(pos < numSamples)
+		{
+			while(hasHit && hitPosition <= pos)
+			{
+				startHit(data, numBytes);
+				hasHit = iter.getNextEvent(data, numBytes, hitPosition);
+			}
+			int end = jmin(numSamples, pos + PREVIEW_BLOCK_SIZE);
+			if(hasHit && hitPosition < end) end = hitPosition;
+
+			mLfos.apply(mValues, mVoices);
+			mVoices.renderAdding(left+pos, right != NULL ? right+pos : NULL, end-pos);
+			mLfos.advance(getBpm(), end-pos);
+			pos = end;
+		}
+		mNumPlaying = mVoices.getNumPlaying();
+		mTiming.finished();
+	};
+
+private:
+	struct Event
+	{
+		enum { START, STOP, PATTERN_START, PATTERN_STOP, FOLLOW_START, FOLLOW_STOP };
+		int type;
+		int voiceNr;
+		float velocity;
+		double delayMs;
+	};
+
+	struct ScheduledEvent
+	{
+		int delaySamples;
+		int voiceNr;
+		float velocity;
+	};
+
+	void post(const Event& e)
+	{
+		int start1, size1, start2, size2;
+		mFifo.prepareToWrite(1, start1, size1, start2, size2);
+		if(size1 > 0)
+		{
+			mEvents[start1] = e;
+			mFifo.finishedWrite(1);
+		}
+	};
+
+	void readEvents()
+	{
+		int start1, size1, start2, size2;
+		const int ready = mFifo.getNumReady();
+		mFifo.prepareToRead(ready, start1, size1, start2, size2);
+		for(int i=0;i<size1;i++) schedule(mEvents[start1+i]);
+		for(int i=0;i<size2;i++) schedule(mEvents[start2+i]);
+		mFifo.finishedRead(size1+size2);
+	};
+
+	void schedule(const Event& e)
+	{
+		if(e.type == Event::STOP)
+		{
+			mNumScheduled = 0;
+			mVoices.stopAll();
+		}
+		else if(e.type == Event::PATTERN_START)
+		{
+			mSequencer.reset();
+			mSequencerRunning = true;
+		}
+		else if(e.type == Event::PATTERN_STOP)
+		{
+			mSequencerRunning = false;
+		}
+		else if(e.type == Event::FOLLOW_START || e.type == Event::FOLLOW_STOP)
+		{
+			mFollowing = e.type == Event::FOLLOW_START;
+			mSequencer.reset();
+		}
+		else if(mNumScheduled < PREVIEW_MAX_EVENTS)
+		{
+			ScheduledEvent& s = mScheduled[mNumScheduled++];
+			s.delaySamples = mClockRunning ? getClockDelay(e.delayMs) : roundToInt(e.delayMs * 0.001 * mSampleRate);
+			s.voiceNr = e.voiceNr;
+			s.velocity = e.velocity;
+		}
+	};
+
+	/** where the external sequencer is when the first sample of this callback is heard*/
+	void readClock()
+	{
+		MidiClockState clock;
+		const double now = Time::getMillisecondCounterHiRes() * 0.001;
+		const bool wasRunning = mClockRunning;
+		mClockRunning = mFollowing && mClock->getState(clock) && clock.isRunningAt(now);
+		if(!mClockRunning) return;
+
+		//a new start plays the groove from its first step
+		if(!wasRunning) mSequencer.reset();
+
+		mClockPosition = clock.getPosition(now + mOutputLatency) / MIDI_CLOCKS_PER_STEP;
+		mClockBpm = clock.getBpm();
+		mClockStepSamples = mSampleRate * clock.period * MIDI_CLOCKS_PER_STEP;
+	};
+
+	/** a hit delayed by n PREVIEW_STEP_MS starts n 8th notes after the next one*/
+	int getClockDelay(double delayMs) const
+	{
+		const int eighths = roundToInt(delayMs / PREVIEW_STEP_MS);
+		const double next = std::ceil(mClockPosition * 0.5) * 2.0;
+		return roundToInt((next + eighths*2 - mClockPosition) * mClockStepSamples);
+	};
+
+	/** takes a snapshot of the store if anything has changed since the last one*/
+	bool readValues()
+	{
+		if(mStore->getVersion() == mVersion) return false;
+		mVersion = mStore->copyValues(mValues);
+		return true;
+	};
+
+	/** hands the current snapshot to the voices that are still ringing*/
+	void updateVoices()
+	{
+		mLfos.apply(mValues, mVoices);
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			if(mVoices.isActive(i))
+			{
+				mVoices.update(PreviewVoiceSettings::fromValues(i, mLfos.getValues(), mVoices.getVelocity(i)));
+			}
+		}
+	};
+
+	/** the tempo of the synced LFOs, the external one while following*/
+	double getBpm() const
+	{
+		if(mClockRunning) return mClockBpm;
+		return mValues[PAR_BPM] > 0 ? mValues[PAR_BPM] : (double)PREVIEW_SEQUENCER_DEFAULT_BPM;
+	};
+
+	/** the triggered hits that fall into the next numSamples go into mMidi*/
+	void addDueEvents(int numSamples)
+	{
+		for(int i=mNumScheduled-1;i>=0;i--)
+		{
+			ScheduledEvent& s = mScheduled[i];
+			if(s.delaySamples < numSamples)
+			{
+				const uint8 noteOn[3] = { 0x90, (uint8)(PREVIEW_SEQUENCER_NOTE + s.voiceNr),
+					(uint8)jlimit(1, 127, roundToInt(s.velocity * 127.f)) };
+				mMidi.addEvent(noteOn, 3, jmax(0, s.delaySamples));
+				mScheduled[i] = mScheduled[--mNumScheduled];
+			}
+			else
+			{
+				s.delaySamples -= numSamples;
+			}
+		}
+	};
+
+	/** a note on of mMidi*/
+	void startHit(const uint8* data, int numBytes)
+	{
+		if(numBytes < 3 || (data[0] & 0xf0) != 0x90 || data[2] == 0) return;
+
+		const int voiceNr = data[1] - PREVIEW_SEQUENCER_NOTE;
+		if(voiceNr < 0 || voiceNr >= PREVIEW_NUM_VOICES) return;
+
+		mLfos.voiceStarted(voiceNr, mValues, data[2] / 127.f);
+		mLfos.apply(mValues, mVoices);
+		mVoices.start(PreviewVoiceSettings::fromValues(voiceNr, mLfos.getValues(), data[2] / 127.f));
+	};
+
+	AbstractFifo mFifo;
+	Event mEvents[PREVIEW_MAX_EVENTS];
+	bool mPatternPlaying;
+	bool mFollowClock;
+
+	ParameterStore* mStore;
+
+	//audio thread only
+	uint8_t mValues[NUM_PARAMS];
+	int mVersion;
+	ScheduledEvent mScheduled[PREVIEW_MAX_EVENTS];
+	int mNumScheduled;
+	PreviewVoiceBank mVoices;
+	PreviewLfoBank mLfos;
+	double mSampleRate;
+	PreviewSequencer mSequencer;
+	bool mSequencerRunning;
+	MidiBuffer mMidi;		// reserved once, clear() keeps the memory
+	MidiClockFollower* mClock;
+	bool mFollowing;
+	bool mClockRunning;		// following and the external transport runs
+	double mClockPosition;	// song position in 16th notes at the first sample of the callback
+	double mClockBpm;
+	double mClockStepSamples;
+	double mOutputLatency;	// seconds
+
+	bool mAutoPreview;
+	Atomic<int> mNumPlaying;
+	AudioCallbackTiming mTiming;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,174 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoice.h"
+
+//---------------------------------------------------------------------------
+/** Radix-2 FFT for the feature analysis of rendered previews.
+
+	The data is split into a real and an imaginary array, so the butterflies
+	of one stage read 4 neighbouring values at once. The twiddles of every
+	stage are stored one after the other in the same layout, all stages with
+	4 or more butterflies per block run in SSE.
+	An object holds its own scratch memory, use one per thread.
+*/
+class PreviewFft
+{
+public:
+	PreviewFft(int order)
+	: mOrder(order),
+	mSize(1<<order)
+	{
+		jassert(order >= 1 && order <= 16);
+
+		mBitReverse.malloc(mSize);
+		for(int i=0;i<mSize;i++)
+		{
+			int reversed = 0;
+			for(int b=0;b<mOrder;b++)
+			{
+				if(i & (1<<b)) reversed |= 1<<(mOrder-1-b);
+			}
+			mBitReverse[i] = reversed;
+		}
+
+		//stage with blocks of length len has len/2 twiddles starting at len/2-1
+		mCos.malloc(mSize);
+		mSin.malloc(mSize);
+		for(int len=2;len<=mSize;len*=2)
+		{
+			const int half = len/2;
+			for(int k=0;k<half;k++)
+			{
+				const double angle = -2.0*double_Pi*k/len;
+				mCos[half-1+k] = (float)cos(angle);
+				mSin[half-1+k] = (float)sin(angle);
+			}
+		}
+
+		mRe.malloc(mSize);
+		mIm.malloc(mSize);
+	};
+
+	~PreviewFft()
+	{
+	};
+
+	int getSize() const
+	{
+		return mSize;
+	};
+
+	/** in place forward transform of getSize() complex values*/
+	void perform(float* re, float* im)
+	{
+		for(int i=0;i<mSize;i++)
+		{
+			const int j = mBitReverse[i];
+			if(j > i)
+			{
+				swapVariables(re[i], re[j]);
+				swapVariables(im[i], im[j]);
+			}
+		}
+
+		for(int len=2;len<=mSize;len*=2)
+		{
+			const int half = len/2;
+			const float* c = mCos + half-1;
+			const float* s = mSin + half-1;
+			for(int block=0;block<mSize;block+=len)
+			{
+#if PREVIEW_USE_SSE
+				if(half >= 4 && SystemStats::hasSSE())
+				{
+					butterfliesSSE(re+block, im+block, c, s, half);
+					continue;
+				}
+#endif
+				butterflies(re+block, im+block, c, s, half);
+			}
+		}
+	};
+
+	/** |X|^2 of the getSize()/2+1 bins from DC to nyquist of a real signal*/
+	void powerSpectrum(const float* signal, float* power)
+	{
+		memcpy(mRe, signal, sizeof(float)*mSize);
+		zeromem(mIm, sizeof(float)*mSize);
+		perform(mRe, mIm);
+		for(int i=0;i<=mSize/2;i++)
+		{
+			power[i] = mRe[i]*mRe[i] + mIm[i]*mIm[i];
+		}
+	};
+
+private:
+	static void butterflies(float* re, float* im, const float* c, const float* s, int half)
+	{
+		for(int k=0;k<half;k++)
+		{
+			const int j = k+half;
+			const float tr = re[j]*c[k] - im[j]*s[k];
+			const float ti = re[j]*s[k] + im[j]*c[k];
+			re[j] = re[k] - tr;
+			im[j] = im[k] - ti;
+			re[k] += tr;
+			im[k] += ti;
+		}
+	};
+
+#if PREVIEW_USE_SSE
+	/** the same arithmetic as butterflies() for 4 values at once, half is a multiple of 4*/
+	static void butterfliesSSE(float* re, float* im, const float* c, const float* s, int half)
+	{
+		for(int k=0;k<half;k+=4)
+		{
+			const int j = k+half;
+			const __m128 wr = _mm_loadu_ps(c+k);
+			const __m128 wi = _mm_loadu_ps(s+k);
+			const __m128 xr = _mm_loadu_ps(re+j);
+			const __m128 xi = _mm_loadu_ps(im+j);
+			const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+			const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+			const __m128 ar = _mm_loadu_ps(re+k);
+			const __m128 ai = _mm_loadu_ps(im+k);
+			_mm_storeu_ps(re+j, _mm_sub_ps(ar, tr));
+			_mm_storeu_ps(im+j, _mm_sub_ps(ai, ti));
+			_mm_storeu_ps(re+k, _mm_add_ps(ar, tr));
+			_mm_storeu_ps(im+k, _mm_add_ps(ai, ti));
+		}
+	};
+#endif
+
+	int mOrder;
+	int mSize;
+	HeapBlock<int> mBitReverse;
+	HeapBlock<float> mCos, mSin;	// twiddles of all stages
+	HeapBlock<float> mRe, mIm;		// scratch of powerSpectrum()
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,152 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoiceBank.h"
+#include "./PreviewWavetables.h"
+#include "./PreviewModMatrix.h"
+#include "../FastRandom.h"
+
+//---------------------------------------------------------------------------
+/** The six LFOs and the velocity modulation of a sound for the preview voices.
+
+	They run at block rate: apply() is called once per block of at most
+	PREVIEW_BLOCK_SIZE samples, puts the LFO levels and the velocities of the
+	last hits through the PreviewModMatrix into a copy of the sound and hands
+	the copy to the voices whose modulated values changed, advance() then
+	moves the phases on by the block. The waves are the PreviewWavetables
+	cycles, the synced LFOs take their cycles per quarter note from the
+	syncRateNames table and the tempo. An LFO that targets another LFO's
+	rate modulates it from the next block on.
+	One thread only, the engine's audio thread or an offline render.
+*/
+class PreviewLfoBank
+{
+public:
+	PreviewLfoBank() : mTables(PreviewWavetables::getInstance()), mSampleRate(44100.0)
+	{
+		zeromem(mValues, sizeof(mValues));
+		reset(mValues);
+	};
+
+	void setSampleRate(double sampleRate)
+	{
+		mSampleRate = sampleRate;
+	};
+
+	/** every LFO back to its PAR_OFFSET_LFO phase, for a new render or device*/
+	void reset(const uint8_t* values)
+	{
+		mRandom.setSeed(0x1f05);
+		for(int i=0;i<PREVIEW_NUM_LFOS;i++)
+		{
+			restart(i, values);
+		}
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			mSources[PREVIEW_NUM_LFOS+i] = 0.f;
+		}
+	};
+
+	/** restarts the LFOs that retrigger on a voice and takes the velocity of the hit,
+		call it before the voice is started*/
+	void voiceStarted(int voiceNr, const uint8_t* values, float velocity)
+	{
+		for(int i=0;i<PREVIEW_NUM_LFOS;i++)
+		{
+			if(values[PAR_RETRIGGER_LFO1+i] == voiceNr+1) restart(i, values);
+		}
+		mSources[PREVIEW_NUM_LFOS+voiceNr] = jlimit(0.f, 1.f, velocity) - 1.f;
+	};
+
+	/** the modulated copy of the values passed to the last apply()*/
+	const uint8_t* getValues() const
+	{
+		return mValues;
+	};
+
+	/** modulates a copy of values and updates the playing voices whose targets have moved*/
+	void apply(const uint8_t* values, PreviewVoiceBank& voices)
+	{
+		mMatrix.compile(values);
+		for(int i=0;i<PREVIEW_NUM_LFOS;i++)
+		{
+			const int wave = values[PAR_WAVE_LFO1+i];
+			mSources[i] = wave == PREVIEW_LFO_RANDOM ? mHeld[i]
+				: PreviewWavetables::lookupLfo(mTables->getLfoTable(wave), (float)mPhase[i]);
+		}
+
+		const int changed = mMatrix.apply(values, mSources, mValues);
+		if(changed == 0) return;
+
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			if((changed & (1<<i)) != 0 && voices.isActive(i))
+			{
+				voices.update(PreviewVoiceSettings::fromValues(i, mValues, voices.getVelocity(i)));
+			}
+		}
+	};
+
+	/** moves the phases on by a block, bpm is the tempo of the synced LFOs*/
+	void advance(double bpm, int numSamples)
+	{
+		const double seconds = numSamples / mSampleRate;
+		for(int i=0;i<PREVIEW_NUM_LFOS;i++)
+		{
+			const double cycles = mTables->getLfoSyncCycles(mValues[PAR_SYNC_LFO1+i]);
+			const double rate = cycles > 0.0 ? cycles * bpm / 60.0 : mTables->getLfoFrequency(mValues[PAR_FREQ_LFO1+i]);
+			mPhase[i] += rate * seconds;
+			if(mPhase[i] >= 1.0)
+			{
+				mPhase[i] -= std::floor(mPhase[i]);
+				mHeld[i] = nextRandom();
+			}
+		}
+	};
+
+private:
+	void restart(int lfo, const uint8_t* values)
+	{
+		mPhase[lfo] = values[PAR_OFFSET_LFO1+lfo] / 128.0;
+		mHeld[lfo] = nextRandom();
+	};
+
+	float nextRandom()
+	{
+		return mRandom.nextFloat()*2.f - 1.f;
+	};
+
+	PreviewWavetables* mTables;
+	double mSampleRate;
+	PreviewModMatrix mMatrix;
+	float mSources[PREVIEW_MOD_SOURCES];	// the levels of the last apply(), then velocity-1 of each voice
+	uint8_t mValues[NUM_PARAMS];
+	double mPhase[PREVIEW_NUM_LFOS];		// [0,1)
+	float mHeld[PREVIEW_NUM_LFOS];			// the random wave, new at every cycle
+	FastRandom mRandom;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,206 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoice.h"
+#include "../parameterRanges.h"
+#include "../Patch.h"
+
+#define PREVIEW_NUM_LFOS			6
+#define PREVIEW_MOD_SOURCES			(PREVIEW_NUM_LFOS + PREVIEW_NUM_VOICES)	// the LFOs, then the velocity of each voice
+#define PREVIEW_MOD_TARGETS			12		// columns, one per source at most, a multiple of 4
+#define PREVIEW_MOD_SLOTS			(NUM_SUB_PAGES*8)	// PAR_TARGET_LFO and PAR_VEL_DEST values, sub page * 8 + position
+#define PREVIEW_MOD_ROUTING_SIZE	(5*PREVIEW_NUM_LFOS)	// routing parameters, see getRouting()
+
+//---------------------------------------------------------------------------
+/** The velocity and LFO routings of a sound compiled into a dense matrix of
+	sources x targets.
+
+	A target slot is the sub page and the position of a parameter on the menu
+	page of a voice. compile() resolves the slots of all routings through
+	mSlots, a table built once from menuPages, and gives every distinct
+	target parameter a column. An entry is the amount of a source on that
+	column in raw parameter steps, so apply() is one multiply-accumulate of
+	the source levels over the whole matrix, 4 columns per SSE instruction,
+	and a clip of each column to the range of its parameter.
+	compile() only rebuilds when a routing parameter has changed.
+
+	The LFOs are bipolar and move their target by up to half its range.
+	Velocity only lowers its target, a hit at full velocity sounds like the
+	patch and a silent one moves the target down by the whole amount.
+*/
+class PreviewModMatrix
+{
+public:
+	PreviewModMatrix() : mNumColumns(0), mPendingVoices(0)
+	{
+		for(int voice=0;voice<PREVIEW_NUM_VOICES;voice++)
+		{
+			for(int i=0;i<PREVIEW_MOD_SLOTS;i++)
+			{
+				const int subPage = (i & MASK_PAGE) >> PAGE_SHIFT;
+				const int position = i & MASK_PARAMETER;
+				//the voice pages come first in menuPages
+				const Page& page = menuPages[voice][subPage];
+				const bool hasText = *(&page.top1 + position) != TEXT_EMPTY;
+				const int parameterNr = *(&page.bot1 + position);
+				mSlots[voice][i] = hasText && parameterNr > 0 && parameterNr < NUM_PARAMS ? parameterNr : -1;
+			}
+		}
+		zeromem(mAmounts, sizeof(mAmounts));
+		memset(mRouting, 0xff, sizeof(mRouting));
+	};
+
+	/** rebuilds the matrix if a routing parameter of values has changed*/
+	void compile(const uint8_t* values)
+	{
+		uint8_t routing[PREVIEW_MOD_ROUTING_SIZE];
+		getRouting(values, routing);
+		if(memcmp(routing, mRouting, sizeof(routing)) == 0) return;
+		memcpy(mRouting, routing, sizeof(routing));
+
+		//the voices of the old targets go back to their plain values
+		for(int c=0;c<mNumColumns;c++) mPendingVoices |= mVoices[c];
+
+		zeromem(mAmounts, sizeof(mAmounts));
+		mNumColumns = 0;
+		for(int i=0;i<PREVIEW_NUM_LFOS;i++)
+		{
+			addRouting(i, values[PAR_VOICE_LFO1+i] - 1, values[PAR_TARGET_LFO1+i], values[PAR_AMOUNT_LFO1+i] * 0.5f);
+		}
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			addRouting(PREVIEW_NUM_LFOS+i, i, values[PAR_VEL_DEST_1+i], values[PAR_VELO_MOD_AMT_1+i]);
+		}
+	};
+
+	/** values plus the sources times the matrix into modulated, values is copied whole.
+		sources are the PREVIEW_MOD_SOURCES levels, -1..1 for an LFO and velocity-1 for a voice.
+		Returns a bit per voice whose modulated values differ from the last call*/
+	int apply(const uint8_t* values, const float* sources, uint8_t* modulated)
+	{
+		memcpy(modulated, values, NUM_PARAMS);
+		int changed = mPendingVoices;
+		mPendingVoices = 0;
+		if(mNumColumns == 0) return changed;
+
+		float offsets[PREVIEW_MOD_TARGETS];
+		multiplyAccumulate(sources, offsets);
+
+		for(int c=0;c<mNumColumns;c++)
+		{
+			const int value = jlimit(mLow[c], mHigh[c], values[mParameters[c]] + roundToInt(offsets[c]));
+			modulated[mParameters[c]] = (uint8_t)value;
+			if(value != mApplied[c])
+			{
+				mApplied[c] = value;
+				changed |= mVoices[c];
+			}
+		}
+		return changed;
+	};
+
+	/** the routed target slots of a voice resolve to these parameters, -1 for none*/
+	int getSlotParameter(int voiceNr, int slot) const
+	{
+		return voiceNr >= 0 && voiceNr < PREVIEW_NUM_VOICES && slot >= 0 && slot < PREVIEW_MOD_SLOTS ? mSlots[voiceNr][slot] : -1;
+	};
+
+private:
+	/** every parameter that selects or scales a routing*/
+	static void getRouting(const uint8_t* values, uint8_t* routing)
+	{
+		const int first[5] = { PAR_VOICE_LFO1, PAR_TARGET_LFO1, PAR_AMOUNT_LFO1, PAR_VEL_DEST_1, PAR_VELO_MOD_AMT_1 };
+		for(int i=0;i<5;i++)
+		{
+			memcpy(routing + i*PREVIEW_NUM_LFOS, values + first[i], PREVIEW_NUM_LFOS);
+		}
+	};
+
+	/** amount is in 127ths of the parameter range per unit of the source*/
+	void addRouting(int source, int voiceNr, int slot, float amount)
+	{
+		const int parameterNr = getSlotParameter(voiceNr, slot);
+		if(parameterNr < 0 || amount == 0.f) return;
+
+		int column = 0;
+		while(column < mNumColumns && mParameters[column] != parameterNr) column++;
+		if(column == mNumColumns)
+		{
+			//PM63 parameters are stored as 0..126
+			const ParameterRange& range = getParameterRange(parameterNr);
+			mParameters[column] = parameterNr;
+			mLow[column] = range.min < 0 ? 0 : range.min;
+			mHigh[column] = mLow[column] + range.range;
+			mVoices[column] = 0;
+			mApplied[column] = -1;
+			mNumColumns++;
+		}
+		mAmounts[source][column] += amount * (1.f/127.f) * getParameterRange(parameterNr).range;
+		mVoices[column] |= 1 << voiceNr;
+	};
+
+	void multiplyAccumulate(const float* sources, float* offsets) const
+	{
+#if PREVIEW_USE_SSE
+		if(SystemStats::hasSSE())
+		{
+			__m128 sum0 = _mm_setzero_ps();
+			__m128 sum1 = _mm_setzero_ps();
+			__m128 sum2 = _mm_setzero_ps();
+			for(int s=0;s<PREVIEW_MOD_SOURCES;s++)
+			{
+				const __m128 level = _mm_set1_ps(sources[s]);
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(level, _mm_loadu_ps(mAmounts[s])));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(level, _mm_loadu_ps(mAmounts[s]+4)));
+				sum2 = _mm_add_ps(sum2, _mm_mul_ps(level, _mm_loadu_ps(mAmounts[s]+8)));
+			}
+			_mm_storeu_ps(offsets, sum0);
+			_mm_storeu_ps(offsets+4, sum1);
+			_mm_storeu_ps(offsets+8, sum2);
+			return;
+		}
+#endif
+		for(int c=0;c<PREVIEW_MOD_TARGETS;c++)
+		{
+			float sum = 0.f;
+			for(int s=0;s<PREVIEW_MOD_SOURCES;s++) sum += sources[s] * mAmounts[s][c];
+			offsets[c] = sum;
+		}
+	};
+
+	int mSlots[PREVIEW_NUM_VOICES][PREVIEW_MOD_SLOTS];	// parameter of a target slot, -1 for none
+	float mAmounts[PREVIEW_MOD_SOURCES][PREVIEW_MOD_TARGETS];	// raw steps per unit of the source
+	int mParameters[PREVIEW_MOD_TARGETS];
+	int mLow[PREVIEW_MOD_TARGETS];
+	int mHigh[PREVIEW_MOD_TARGETS];
+	int mVoices[PREVIEW_MOD_TARGETS];	// bit per voice whose page has the parameter
+	int mApplied[PREVIEW_MOD_TARGETS];	// the last modulated value
+	int mNumColumns;
+	int mPendingVoices;					// of the routings compile() dropped
+	uint8_t mRouting[PREVIEW_MOD_ROUTING_SIZE];
+};
+//---------------------------------------------------------------------------
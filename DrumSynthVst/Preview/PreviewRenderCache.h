@@ -0,0 +1,282 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../PatchHash.h"
+#include "../Trace.h"
+
+#define PREVIEW_ENGINE_VERSION			1		// bump when PreviewRenderer sounds different, stored renders are then ignored
+#define PREVIEW_RENDER_CACHE_FOLDER		"SonicPotionsEditor/renders"
+#define PREVIEW_RENDER_CACHE_EXTENSION	".render"
+#define PREVIEW_RENDER_CACHE_MAGIC		0x52505053	// "SPPR" little endian
+#define PREVIEW_RENDER_CACHE_HEADER_SIZE	32
+#define PREVIEW_RENDER_CACHE_MAX_MB		512		// the files of the least recently used sounds are deleted above this
+#define PREVIEW_RENDER_CACHE_EVICT_TO	0.9		// of the cap, so not every new render deletes one
+
+//---------------------------------------------------------------------------
+/** The sounds of PreviewRenderer::renderSound(), stored on disk by what they
+	were rendered from: the hash of the patch values, PREVIEW_ENGINE_VERSION
+	and the sample rate.
+
+	renderSound() gives the same samples on every thread, so a stored render
+	is exactly the one a new call would make. PreviewRenderer::renderCached()
+	goes through here, so the thumbnails, the audition prefetch and the batch
+	renders all share it. The samples are kept as floats, a sound is rendered
+	once and every later consumer reads it back unchanged.
+	The folder is held below PREVIEW_RENDER_CACHE_MAX_MB: a hit marks the file
+	as used, and when a new file goes over the cap the least recently used
+	ones are deleted. Another editor may share the folder, a file that has
+	gone meanwhile is just rendered again.
+	Any thread, the files are read and written outside the lock.
+
+	Layout (all numbers little endian):
+	header		magic, PREVIEW_ENGINE_VERSION, patch hash, sample rate as a
+				double, channels, samples
+	samples		32 bit floats, one channel after the other
+*/
+class PreviewRenderCache
+{
+public:
+	PreviewRenderCache()
+	: mMaxSize((int64)PREVIEW_RENDER_CACHE_MAX_MB*1024*1024),
+	mTotalSize(0),
+	mScanned(false)
+	{
+		mFolder = File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile(PREVIEW_RENDER_CACHE_FOLDER);
+	};
+
+	~PreviewRenderCache()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (PreviewRenderCache, false)
+
+	/** the name of the stored render, it changes with the values, the engine and the sample rate*/
+	static int64 getKey(const uint8_t* values, double sampleRate)
+	{
+		uint64 key = hashPatchValues(values) ^ (PREVIEW_ENGINE_VERSION * literal64bit(0x9e3779b97f4a7c15));
+		key = (key ^ (uint64)roundToInt(sampleRate)) * literal64bit(0xbf58476d1ce4e5b9);
+		return (int64)(key ^ (key >> 31));
+	};
+
+	/** the stored render of these values, false if they haven't been rendered at this sample rate yet*/
+	bool load(const uint8_t* values, double sampleRate, AudioSampleBuffer& buffer)
+	{
+		const int64 key = getKey(values,sampleRate);
+		const File file(getFile(key));
+		if(!read(file,(int64)hashPatchValues(values),sampleRate,buffer)) return false;
+
+		used(key,file);
+		return true;
+	};
+
+	/** keeps a new render of these values*/
+	void store(const uint8_t* values, double sampleRate, const AudioSampleBuffer& buffer)
+	{
+		const int64 key = getKey(values,sampleRate);
+		const int64 size = write(getFile(key),(int64)hashPatchValues(values),sampleRate,buffer);
+		if(size > 0) added(key,size);
+	};
+
+private:
+	struct Entry
+	{
+		int64 key;
+		int64 size;
+		int64 lastUse;		// milliseconds since 1970
+	};
+
+	/** oldest first*/
+	class EntryComparator
+	{
+	public:
+		static int compareElements(const Entry& a, const Entry& b)
+		{
+			return a.lastUse < b.lastUse ? -1 : (a.lastUse > b.lastUse ? 1 : 0);
+		};
+	};
+
+	File getFile(int64 key) const
+	{
+		return mFolder.getChildFile(String::toHexString(key) + PREVIEW_RENDER_CACHE_EXTENSION);
+	};
+
+	/** false for a missing file or one of another sound, engine or sample rate*/
+	static bool read(const File& file, int64 hash, double sampleRate, AudioSampleBuffer& buffer)
+	{
+		TRACE_SCOPE("patch io","render cache read");
+		FileInputStream in(file);
+		if(in.getStatus().failed()) return false;
+
+		if(in.readInt() != PREVIEW_RENDER_CACHE_MAGIC
+			|| in.readInt() != PREVIEW_ENGINE_VERSION
+			|| in.readInt64() != hash
+			|| in.readDouble() != sampleRate)
+		{
+			return false;
+		}
+		const int numChannels = in.readInt();
+		const int numSamples = in.readInt();
+		if(numChannels <= 0 || numSamples <= 0
+			|| in.getTotalLength() != PREVIEW_RENDER_CACHE_HEADER_SIZE + (int64)numChannels*numSamples*(int64)sizeof(float))
+		{
+			return false;
+		}
+
+		buffer.setSize(numChannels,numSamples,false,false,true);
+		for(int ch=0;ch<numChannels;ch++)
+		{
+			const int bytes = numSamples*(int)sizeof(float);
+			if(in.read(buffer.getSampleData(ch),bytes) != bytes) return false;
+		}
+		return true;
+	};
+
+	/** the size of the new file, 0 if it couldn't be written. A failed write only means the sound is rendered again*/
+	int64 write(const File& file, int64 hash, double sampleRate, const AudioSampleBuffer& buffer)
+	{
+		TRACE_SCOPE("patch io","render cache write");
+		if(!mFolder.createDirectory()) return 0;
+
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return 0;
+
+			out->writeInt(PREVIEW_RENDER_CACHE_MAGIC);
+			out->writeInt(PREVIEW_ENGINE_VERSION);
+			out->writeInt64(hash);
+			out->writeDouble(sampleRate);
+			out->writeInt(buffer.getNumChannels());
+			out->writeInt(buffer.getNumSamples());
+			for(int ch=0;ch<buffer.getNumChannels();ch++)
+			{
+				out->write(buffer.getSampleData(ch),buffer.getNumSamples()*(int)sizeof(float));
+			}
+			out->flush();
+			if(out->getStatus().failed()) return 0;
+		}
+		if(!temp.overwriteTargetFileWithTemporary()) return 0;
+		return PREVIEW_RENDER_CACHE_HEADER_SIZE + (int64)buffer.getNumChannels()*buffer.getNumSamples()*sizeof(float);
+	};
+
+	/** a hit, the file is the most recently used one now*/
+	void used(int64 key, const File& file)
+	{
+		const Time now(Time::getCurrentTime());
+		file.setLastModificationTime(now);
+
+		const ScopedLock sl(mLock);
+		scanFolder();
+		const int index = findEntry(key);
+		if(index >= 0)
+		{
+			mEntries.getReference(index).lastUse = now.toMilliseconds();
+		}
+		else
+		{
+			//written by another editor after the scan
+			Entry entry = { key, file.getSize(), now.toMilliseconds() };
+			mEntries.add(entry);
+			mTotalSize += entry.size;
+		}
+	};
+
+	/** a new file, the cap may delete the least recently used ones*/
+	void added(int64 key, int64 size)
+	{
+		Array<File> evicted;
+		{
+			const ScopedLock sl(mLock);
+			scanFolder();
+			const int index = findEntry(key);
+			if(index >= 0)
+			{
+				//another thread rendered the same sound at the same time
+				mTotalSize -= mEntries.getReference(index).size;
+				mEntries.remove(index);
+			}
+			Entry entry = { key, size, Time::currentTimeMillis() };
+			mEntries.add(entry);
+			mTotalSize += size;
+
+			if(mTotalSize > mMaxSize)
+			{
+				EntryComparator comparator;
+				mEntries.sort(comparator);
+				const int64 target = (int64)(mMaxSize*PREVIEW_RENDER_CACHE_EVICT_TO);
+				int numEvicted = 0;
+				while(numEvicted < mEntries.size()-1 && mTotalSize > target)
+				{
+					const Entry& oldest = mEntries.getReference(numEvicted++);
+					mTotalSize -= oldest.size;
+					evicted.add(getFile(oldest.key));
+				}
+				mEntries.removeRange(0,numEvicted);
+			}
+		}
+		for(int i=0;i<evicted.size();i++)
+		{
+			evicted.getReference(i).deleteFile();
+		}
+	};
+
+	/** the files the folder had before this run, once. Called with the lock held*/
+	void scanFolder()
+	{
+		if(mScanned) return;
+		mScanned = true;
+
+		Array<File> files;
+		mFolder.findChildFiles(files,File::findFiles,false,String("*") + PREVIEW_RENDER_CACHE_EXTENSION);
+		for(int i=0;i<files.size();i++)
+		{
+			const File& file = files.getReference(i);
+			Entry entry = { file.getFileNameWithoutExtension().getHexValue64(), file.getSize(), file.getLastModificationTime().toMilliseconds() };
+			mEntries.add(entry);
+			mTotalSize += entry.size;
+		}
+	};
+
+	int findEntry(int64 key) const
+	{
+		for(int i=0;i<mEntries.size();i++)
+		{
+			if(mEntries.getReference(i).key == key) return i;
+		}
+		return -1;
+	};
+
+	File mFolder;
+	const int64 mMaxSize;
+
+	CriticalSection mLock;
+	Array<Entry> mEntries;		// every file of the folder, in no order until the cap sorts them
+	int64 mTotalSize;
+	bool mScanned;
+};
+//---------------------------------------------------------------------------
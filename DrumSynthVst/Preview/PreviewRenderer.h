@@ -0,0 +1,441 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoiceBank.h"
+#include "./PreviewLfos.h"
+#include "./PreviewSequencer.h"
+#include "./PreviewRenderCache.h"
+#include "../Population.h"
+
+#define PREVIEW_RENDER_SAMPLE_RATE	44100.0
+#define PREVIEW_RENDER_BITS			16
+#define PREVIEW_RENDER_FLAC_LEVEL	5		// compression level of FLAC files, 0 (fastest) to 8
+#define PREVIEW_RENDER_MAX_SECONDS	6.0		// cap of one sound, all hits of playSound() fit
+#define PREVIEW_RENDER_GAP_SECONDS	0.1		// silence after every sound
+#define PREVIEW_RENDER_CHUNK_PER_CPU	4	// sounds held in memory per core when writing one file
+#define PREVIEW_RENDER_POLL_MS		20
+#define PREVIEW_RENDER_CANCEL_TIMEOUT_MS	2000
+
+//---------------------------------------------------------------------------
+/** Renders a sound offline, the same six hits PreviewEngine::playSound() plays.
+	Only uses its own voices and LFOs, so any number of threads can render at once,
+	and the same values give the same samples on any of them.
+*/
+class PreviewRenderer
+{
+public:
+	/** samples renderSound() writes, it stops when the longest hit has decayed*/
+	static int getSoundLength(const uint8_t* values, double sampleRate)
+	{
+		double seconds = 0.0;
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			const PreviewVoiceSettings s = PreviewVoiceSettings::fromValues(i, values, 1.f);
+			seconds = jmax(seconds, i*PREVIEW_STEP_MS*0.001 + s.attack + s.decay);
+		}
+		return roundToInt((jmin(seconds, PREVIEW_RENDER_MAX_SECONDS) + PREVIEW_RENDER_GAP_SECONDS) * sampleRate);
+	};
+
+	/** resizes the buffer to 2 x getSoundLength() and renders into it*/
+	static void renderSound(const uint8_t* values, double sampleRate, AudioSampleBuffer& buffer)
+	{
+		const int length = getSoundLength(values, sampleRate);
+		buffer.setSize(2, length, false, false, true);
+		buffer.clear();
+
+		const ScopedPreviewFloatMode floatMode;
+		PreviewVoiceBank voices;
+		voices.setSampleRate(sampleRate);
+		PreviewLfoBank lfos;
+		lfos.setSampleRate(sampleRate);
+		lfos.reset(values);
+		const int bpm = values[PAR_BPM] > 0 ? values[PAR_BPM] : PREVIEW_SEQUENCER_DEFAULT_BPM;
+		int start[PREVIEW_NUM_VOICES];
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			start[i] = roundToInt(i*PREVIEW_STEP_MS*0.001*sampleRate);
+		}
+
+		float* left = buffer.getSampleData(0);
+		float* right = buffer.getSampleData(1);
+		for(int pos=0;pos<length;pos+=PREVIEW_BLOCK_SIZE)
+		{
+			const int num = jmin(PREVIEW_BLOCK_SIZE, length-pos);
+			for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+			{
+				//like the engine, a hit starts at the block it falls into
+				if(start[i] >= pos && start[i] < pos+num)
+				{
+					lfos.voiceStarted(i, values, 1.f);
+					lfos.apply(values, voices);
+					voices.start(PreviewVoiceSettings::fromValues(i, lfos.getValues(), 1.f));
+				}
+			}
+			lfos.apply(values, voices);
+			voices.renderAdding(left+pos, right+pos, num);
+			lfos.advance(bpm, num);
+		}
+	};
+
+	/** renderSound() through the PreviewRenderCache, a sound rendered before is read back*/
+	static void renderCached(const uint8_t* values, double sampleRate, AudioSampleBuffer& buffer)
+	{
+		PreviewRenderCache* cache = PreviewRenderCache::getInstance();
+		if(cache->load(values, sampleRate, buffer)) return;
+
+		renderSound(values, sampleRate, buffer);
+		cache->store(values, sampleRate, buffer);
+	};
+
+	/** a new 16 bit file, see createWriter()*/
+	static bool writeFile(const File& file, const AudioSampleBuffer& buffer, double sampleRate,
+		const StringPairArray& metadata = StringPairArray())
+	{
+		ScopedPointer<AudioFormatWriter> writer(createWriter(file, buffer.getNumChannels(), sampleRate, metadata));
+		return writer != NULL && writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+	};
+
+	/** a FLAC file if the extension is .flac, a WAV file otherwise. Only WAV has the metadata like cue points*/
+	static AudioFormatWriter* createWriter(const File& file, int numChannels, double sampleRate, const StringPairArray& metadata)
+	{
+		file.deleteFile();
+		ScopedPointer<FileOutputStream> stream(file.createOutputStream());
+		if(stream == NULL || stream->failedToOpen()) return NULL;
+
+		AudioFormatWriter* writer;
+		if(file.hasFileExtension(".flac"))
+		{
+			FlacAudioFormat flac;
+			writer = flac.createWriterFor(stream, sampleRate, numChannels, PREVIEW_RENDER_BITS, metadata, PREVIEW_RENDER_FLAC_LEVEL);
+		}
+		else
+		{
+			WavAudioFormat wav;
+			writer = wav.createWriterFor(stream, sampleRate, numChannels, PREVIEW_RENDER_BITS, metadata, 0);
+		}
+		if(writer != NULL)
+		{
+			//the writer deletes the stream
+			stream.release();
+		}
+		return writer;
+	};
+};
+//---------------------------------------------------------------------------
+/** Renders a list of patches to WAV or FLAC files on all cores, without any GUI.
+
+	Either every patch gets its own file in a folder, or all sounds go into one
+	file with a labelled cue point at the start of each, so a whole generation
+	can be skimmed in an audio editor. The lengths are known before rendering,
+	so the cue points are written with the header and the single file is
+	filled in chunks, only a few sounds per core are held in memory.
+
+	A file of its own is encoded by the worker that rendered the sound, so a
+	big set of FLAC files is compressed on all cores. The single file is
+	written while the workers render the next chunk.
+*/
+class PreviewBatchRenderer
+{
+public:
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** called on the rendering thread every PREVIEW_RENDER_POLL_MS*/
+		virtual void renderProgress(int numDone, int numPatches) = 0;
+		/** true cancels the rendering*/
+		virtual bool shouldStopRendering() = 0;
+	};
+
+	/** fileExtension (".wav" or ".flac") is the format of the files of the patches, the single
+		file has the format of its own extension*/
+	PreviewBatchRenderer(const File& target, bool oneFilePerPatch, const String& fileExtension = ".wav")
+	: mTarget(target),
+	mOneFilePerPatch(oneFilePerPatch),
+	mFileExtension(fileExtension),
+	mNumPatches(0),
+	mNumWritten(0)
+	{
+	};
+
+	/** copies NUM_PARAMS values, call it for every patch before render()*/
+	void addPatch(const uint8_t* values, const String& name)
+	{
+		mValues.append(values, NUM_PARAMS);
+		mNames.add(name);
+		mNumPatches++;
+	};
+
+	int getNumPatches() const
+	{
+		return mNumPatches;
+	};
+
+	/** the number of sounds in the written file(s)*/
+	int getNumWritten() const
+	{
+		return mNumWritten;
+	};
+
+	/** renders everything, listener can be NULL*/
+	void render(Listener* listener)
+	{
+		mListener = listener;
+		mNumWritten = 0;
+		mNumDone.set(0);
+		if(mNumPatches == 0) return;
+
+		//one worker per core, each renders faster than real time on its own
+		const int numThreads = jmax(1, SystemStats::getNumCpus());
+		ThreadPool pool(numThreads);
+
+		if(mOneFilePerPatch)
+		{
+			mTarget.createDirectory();
+			renderRange(pool, numThreads, 0, mNumPatches, NULL);
+			mNumWritten = mNumDone.get();
+		}
+		else
+		{
+			renderSingleFile(pool, numThreads);
+		}
+	};
+
+private:
+	/** takes sounds from the shared counter until the range is done*/
+	class RenderJob : public ThreadPoolJob
+	{
+	public:
+		RenderJob(PreviewBatchRenderer& owner, int begin, int end, OwnedArray<AudioSampleBuffer>* results)
+		: ThreadPoolJob("preview render"),
+		mOwner(owner),
+		mBegin(begin),
+		mEnd(end),
+		mResults(results)
+		{
+		};
+
+		JobStatus runJob()
+		{
+			AudioSampleBuffer buffer(2, 1);
+			for(;;)
+			{
+				const int index = ++mOwner.mNextPatch - 1 + mBegin;
+				if(index >= mEnd || shouldExit()) break;
+
+				const uint8_t* values = mOwner.getValues(index);
+				if(mResults != NULL)
+				{
+					PreviewRenderer::renderCached(values, PREVIEW_RENDER_SAMPLE_RATE, *mResults->getUnchecked(index-mBegin));
+					++mOwner.mNumDone;
+				}
+				else
+				{
+					PreviewRenderer::renderCached(values, PREVIEW_RENDER_SAMPLE_RATE, buffer);
+					if(PreviewRenderer::writeFile(mOwner.getFileForPatch(index), buffer, PREVIEW_RENDER_SAMPLE_RATE))
+					{
+						++mOwner.mNumDone;
+					}
+				}
+			}
+			return jobHasFinished;
+		};
+
+	private:
+		PreviewBatchRenderer& mOwner;
+		const int mBegin, mEnd;
+		OwnedArray<AudioSampleBuffer>* mResults;
+	};
+
+	const uint8_t* getValues(int index) const
+	{
+		return (const uint8_t*)mValues.getData() + index*NUM_PARAMS;
+	};
+
+	bool shouldStop()
+	{
+		return mListener != NULL && mListener->shouldStopRendering();
+	};
+
+	/** runs the workers over [begin,end) and reports the progress while they work*/
+	void renderRange(ThreadPool& pool, int numThreads, int begin, int end, OwnedArray<AudioSampleBuffer>* results)
+	{
+		OwnedArray<RenderJob> jobs;
+		startRange(pool, numThreads, begin, end, results, jobs);
+		waitForRange(pool);
+	};
+
+	/** starts the workers over [begin,end), jobs holds them until they are done*/
+	void startRange(ThreadPool& pool, int numThreads, int begin, int end, OwnedArray<AudioSampleBuffer>* results,
+		OwnedArray<RenderJob>& jobs)
+	{
+		jobs.clear();
+		mNextPatch.set(0);
+		for(int i=0;i<jmin(numThreads, end-begin);i++)
+		{
+			RenderJob* job = new RenderJob(*this, begin, end, results);
+			jobs.add(job);
+			pool.addJob(job);
+		}
+	};
+
+	/** reports the progress until the workers are done or the rendering is cancelled*/
+	void waitForRange(ThreadPool& pool)
+	{
+		while(pool.getNumJobs() > 0)
+		{
+			if(shouldStop())
+			{
+				pool.removeAllJobs(true, -1);
+				break;
+			}
+			if(mListener != NULL) mListener->renderProgress(mNumDone.get(), mNumPatches);
+			Thread::sleep(PREVIEW_RENDER_POLL_MS);
+		}
+	};
+
+	void renderSingleFile(ThreadPool& pool, int numThreads)
+	{
+		//the lengths give the cue positions before anything is rendered
+		StringPairArray metadata;
+		metadata.set("NumCuePoints", String(mNumPatches));
+		metadata.set("NumCueLabels", String(mNumPatches));
+		int64 offset = 0;
+		for(int i=0;i<mNumPatches;i++)
+		{
+			const String cue("Cue" + String(i));
+			const String label("CueLabel" + String(i));
+			metadata.set(cue + "Identifier", String(i+1));
+			metadata.set(cue + "Offset", String(offset));
+			metadata.set(cue + "BlockStart", String(offset));
+			metadata.set(label + "Identifier", String(i+1));
+			metadata.set(label + "Text", String(i+1) + " " + mNames[i]);
+			offset += PreviewRenderer::getSoundLength(getValues(i), PREVIEW_RENDER_SAMPLE_RATE);
+		}
+
+		ScopedPointer<AudioFormatWriter> writer(PreviewRenderer::createWriter(mTarget, 2, PREVIEW_RENDER_SAMPLE_RATE, metadata));
+		if(writer == NULL) return;
+
+		//two chunks: the workers render into one while the other is written
+		const int chunkSize = numThreads * PREVIEW_RENDER_CHUNK_PER_CPU;
+		OwnedArray<AudioSampleBuffer> chunks[2];
+		for(int i=0;i<chunkSize;i++)
+		{
+			chunks[0].add(new AudioSampleBuffer(2, 1));
+			chunks[1].add(new AudioSampleBuffer(2, 1));
+		}
+
+		OwnedArray<RenderJob> jobs;
+		int current = 0;
+		renderRange(pool, numThreads, 0, jmin(mNumPatches, chunkSize), &chunks[current]);
+
+		for(int begin=0;begin<mNumPatches && !shouldStop();begin+=chunkSize)
+		{
+			const int end = jmin(mNumPatches, begin+chunkSize);
+			const int next = jmin(mNumPatches, end+chunkSize);
+			if(end < next) startRange(pool, numThreads, end, next, &chunks[1-current], jobs);
+
+			for(int i=0;i<end-begin;i++)
+			{
+				if(!writer->writeFromAudioSampleBuffer(*chunks[current][i], 0, chunks[current][i]->getNumSamples()))
+				{
+					pool.removeAllJobs(true, -1);
+					return;
+				}
+				mNumWritten++;
+			}
+
+			waitForRange(pool);
+			current = 1-current;
+		}
+	};
+
+	/** "0001 name.wav", the number keeps the order of the patches. It has as many digits
+		as the last one, so the files sort by name*/
+	File getFileForPatch(int index) const
+	{
+		const int numDigits = jmax(4, String(mNumPatches).length());
+		const String name(String(index+1).paddedLeft('0', numDigits) + " " + mNames[index]);
+		return mTarget.getChildFile(File::createLegalFileName(name.trim()) + mFileExtension);
+	};
+
+	const File mTarget;
+	const bool mOneFilePerPatch;
+	const String mFileExtension;
+	int mNumPatches;
+	MemoryBlock mValues;	// NUM_PARAMS per patch
+	StringArray mNames;
+	Listener* mListener;
+
+	Atomic<int> mNextPatch;
+	Atomic<int> mNumDone;
+	int mNumWritten;
+};
+//---------------------------------------------------------------------------
+/** Renders the patches of a population behind a progress window with a cancel button.
+*/
+class PreviewRenderJob : public ThreadWithProgressWindow, private PreviewBatchRenderer::Listener
+{
+public:
+	/** has to be created on the message thread, takes a copy of the patches*/
+	PreviewRenderJob(const Population& population, const File& target, bool oneFilePerPatch, const String& fileExtension = ".wav")
+	: ThreadWithProgressWindow("Render", true, true, PREVIEW_RENDER_CANCEL_TIMEOUT_MS),
+	mRenderer(target, oneFilePerPatch, fileExtension)
+	{
+		for(int i=0;i<population.getNumMembers();i++)
+		{
+			Patch* patch = population.getMember(i);
+			mRenderer.addPatch(patch->getValues(), patch->getName());
+		}
+	};
+
+	/** the number of sounds in the written file(s)*/
+	int getNumWritten() const
+	{
+		return mRenderer.getNumWritten();
+	};
+
+	void run()
+	{
+		mRenderer.render(this);
+	};
+
+private:
+	void renderProgress(int numDone, int numPatches)
+	{
+		setProgress(numDone / (double)numPatches);
+		setStatusMessage(String(numDone) + " of " + String(numPatches));
+	};
+
+	bool shouldStopRendering()
+	{
+		return threadShouldExit();
+	};
+
+	PreviewBatchRenderer mRenderer;
+};
+//---------------------------------------------------------------------------
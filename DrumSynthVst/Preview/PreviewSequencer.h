@@ -0,0 +1,142 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoice.h"
+#include "../EuclidTable.h"
+
+#define PREVIEW_SEQUENCER_STEPS			16		// 16th notes in one bar
+#define PREVIEW_SEQUENCER_NOTE			36		// note of voice 0, the other voices follow
+#define PREVIEW_SEQUENCER_DEFAULT_BPM	120		// when PAR_BPM is 0
+#define PREVIEW_SEQUENCER_MAX_SWING		0.33	// share of a step the odd steps are delayed at full shuffle
+#define PREVIEW_SEQUENCER_ACCENT		127		// velocity on the beats
+#define PREVIEW_SEQUENCER_VELOCITY		96		// velocity of the other steps
+
+//---------------------------------------------------------------------------
+/** Plays a groove with the preview voices from the pattern parameters, so a
+	sound can be judged in context instead of as a single hit.
+
+	Drum 1 plays the euclidean rhythm of PAR_EUKLID_STEPS hits spread over
+	PAR_EUKLID_LENGTH steps, the snare plays on 2 and 4 and the hihat plays
+	8th notes. All tracks loop after PAR_TRACK_LENGTH steps at PAR_BPM,
+	PAR_SHUFFLE delays the odd steps. PAR_QUANTISATION only applies when
+	recording on the LXR and is not used.
+
+	process() runs inside the audio callback and writes a note on at the exact
+	sample of every hit, the values are read again for every callback so the
+	groove follows the knobs. processFollowing() takes tempo and position from
+	a MidiClockFollower instead of PAR_BPM, the steps then line up with the
+	song position of the external sequencer.
+*/
+class PreviewSequencer
+{
+public:
+	PreviewSequencer()
+	{
+		reset();
+	};
+
+	/** the next callback starts with the first step*/
+	void reset()
+	{
+		mStep = 0;
+		mSamplesToStep = 0.0;
+		mClockStep = -1;
+	};
+
+	/** adds the note ons of all steps that start in the next numSamples samples*/
+	void process(const uint8_t* values, double sampleRate, int numSamples, MidiBuffer& midi)
+	{
+		const int length = jlimit(1, PREVIEW_SEQUENCER_STEPS, (int)values[PAR_TRACK_LENGTH]);
+		const int bpm = values[PAR_BPM] > 0 ? values[PAR_BPM] : PREVIEW_SEQUENCER_DEFAULT_BPM;
+		const double stepSamples = sampleRate * 60.0 / bpm / 4.0;
+		const double swing = values[PAR_SHUFFLE] / 127.0 * PREVIEW_SEQUENCER_MAX_SWING;
+
+		if(mStep >= length) mStep = 0;
+
+		while(mSamplesToStep < numSamples)
+		{
+			addStep(values, mStep, jmax(0, (int)mSamplesToStep), midi);
+
+			//shuffle makes the even steps longer and the odd ones shorter
+			mSamplesToStep += stepSamples * (mStep % 2 == 0 ? 1.0 + swing : 1.0 - swing);
+			mStep = (mStep + 1) % length;
+		}
+		mSamplesToStep -= numSamples;
+	};
+
+	/** like process(), position is the song position at the first sample in 16th notes*/
+	void processFollowing(const uint8_t* values, double sampleRate, int numSamples, MidiBuffer& midi, double position, double bpm)
+	{
+		const int length = jlimit(1, PREVIEW_SEQUENCER_STEPS, (int)values[PAR_TRACK_LENGTH]);
+		const double stepSamples = sampleRate * 60.0 / bpm / 4.0;
+		const double swing = values[PAR_SHUFFLE] / 127.0 * PREVIEW_SEQUENCER_MAX_SWING;
+
+		//the clock is corrected a little with every callback, only a jump of the song position may skip or repeat a step
+		const int64 first = (int64)std::ceil(position - swing);
+		if(mClockStep < 0 || mClockStep < first - 1 || mClockStep > first + 1) mClockStep = jmax((int64)0, first);
+
+		for(;;)
+		{
+			const double offset = (mClockStep + (mClockStep % 2 == 1 ? swing : 0.0) - position) * stepSamples;
+			if(offset >= numSamples) break;
+
+			if(offset > -stepSamples) addStep(values, (int)(mClockStep % length), jmax(0, (int)offset), midi);
+			++mClockStep;
+		}
+	};
+
+	/** the steps a voice plays, bit n is step n*/
+	static uint32 getPattern(const uint8_t* values, int voice)
+	{
+		switch(voice)
+		{
+		case 0:		return getEuclidMask(values[PAR_EUKLID_LENGTH], values[PAR_EUKLID_STEPS]);
+		case 3:		return (1<<4) | (1<<12);
+		case 5:		return 0x5555;
+		default:	return 0;
+		}
+	};
+
+private:
+	void addStep(const uint8_t* values, int step, int position, MidiBuffer& midi)
+	{
+		for(int voice=0;voice<PREVIEW_NUM_VOICES;voice++)
+		{
+			if(getPattern(values, voice) & (1<<step))
+			{
+				const uint8 noteOn[3] = { 0x90, (uint8)(PREVIEW_SEQUENCER_NOTE + voice),
+					(uint8)(step % 4 == 0 ? PREVIEW_SEQUENCER_ACCENT : PREVIEW_SEQUENCER_VELOCITY) };
+				midi.addEvent(noteOn, 3, position);
+			}
+		}
+	};
+
+	int mStep;				// the step that starts next
+	double mSamplesToStep;	// from the start of the next callback to that step
+	int64 mClockStep;		// the song position step that starts next when following a clock, -1 before the first
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,686 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../drumSynthSource/Parameters.h"
+#include "../FastRandom.h"
+#include "./PreviewWavetables.h"
+#include <math.h>
+
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE__))
+ #include <xmmintrin.h>
+ #define PREVIEW_USE_SSE 1
+#else
+ #define PREVIEW_USE_SSE 0
+#endif
+
+#define PREVIEW_NUM_VOICES		6
+#define PREVIEW_STEP_MS			250.0	// distance of the hits when a whole sound is played
+#define PREVIEW_BLOCK_SIZE		32		// samples per render() call, the envelopes run at this rate
+#define PREVIEW_MAX_TIME		4.f		// longest attack/decay in seconds
+#define PREVIEW_MIN_TIME		0.001f
+#define PREVIEW_PITCH_OCTAVES	4.f		// pitch envelope depth at full mod amount
+
+#define PREVIEW_HALFBAND_TAPS		24		// of the filtered polyphase branch, a multiple of 4
+#define PREVIEW_OVERSAMPLE_MAX		4
+#define PREVIEW_HALFBAND_MAX_BLOCK	(PREVIEW_BLOCK_SIZE*PREVIEW_OVERSAMPLE_MAX/2)	// input samples of a stage per call
+#define PREVIEW_OVERSAMPLE_4X_DRIVE	5.f		// a drive up to this is oversampled 2 times, above it 4 times
+#define PREVIEW_FLOAT_MODE_CSR		0x9f80	// all SSE exceptions masked, round to nearest, flush to zero
+
+enum
+{
+	PREVIEW_FILTER_LP = 0,
+	PREVIEW_FILTER_HP,
+	PREVIEW_FILTER_BP,
+	PREVIEW_FILTER_UBP,
+	PREVIEW_FILTER_NOTCH,
+	PREVIEW_FILTER_PEAK
+};
+
+//---------------------------------------------------------------------------
+/** Pins the SSE float mode of the calling thread while an offline render runs.
+
+	The rounding and the flush to zero are per thread, and a host or driver
+	may have changed them on the thread that renders. With the same mode on
+	every thread the same values render the same samples, bit for bit, so a
+	stored render can stand in for a new one.
+*/
+class ScopedPreviewFloatMode
+{
+public:
+	ScopedPreviewFloatMode()
+	{
+#if PREVIEW_USE_SSE
+		mSaved = _mm_getcsr();
+		_mm_setcsr(PREVIEW_FLOAT_MODE_CSR);
+#endif
+	};
+
+	~ScopedPreviewFloatMode()
+	{
+#if PREVIEW_USE_SSE
+		_mm_setcsr(mSaved);
+#endif
+	};
+
+private:
+	unsigned int mSaved;
+};
+
+//---------------------------------------------------------------------------
+/** One hit of a voice, converted from the raw parameter values.
+	fromValues() runs on the message thread, so the audio thread only copies
+	the struct and never touches the ParameterStore.
+*/
+struct PreviewVoiceSettings
+{
+	int voiceNr;
+
+	int wave[3];			// carrier, 1st and 2nd modulator
+	float freq[3];			// Hz
+	float modAmount[3];		// phase modulation depth of the next oscillator in the chain
+	float noiseMix;			// snare only, 0 = osc ... 1 = noise
+	float noiseFreq;		// snare only, sample & hold rate of the noise
+
+	float attack;			// seconds
+	float decay;
+	float volSlope;			// 0 = linear ... 1 = steep exponential decay
+
+	float pitchAmount;		// octaves added at the start of the hit
+	float pitchDecay;		// seconds
+	float pitchSlope;
+
+	int filterType;
+	float filterFreq;		// Hz
+	float filterQ;
+	float filterDrive;		// gain into the filter, 1 = clean
+
+	float drive;			// gain into the output saturation, 1 = clean
+	int decimation;			// hold every sample for this many samples, 1 = off
+	float gainL, gainR;		// volume, velocity and pan
+	float velocity;
+
+	static PreviewVoiceSettings fromValues(int voiceNr, const uint8_t* values, float velocity, bool openHat = false)
+	{
+		jassert(voiceNr >= 0 && voiceNr < PREVIEW_NUM_VOICES);
+
+		static const int oscWave[PREVIEW_NUM_VOICES] = {PAR_OSC_WAVE_DRUM1,PAR_OSC_WAVE_DRUM2,PAR_OSC_WAVE_DRUM3,PAR_OSC_WAVE_SNARE,PAR_WAVE1_CYM,PAR_WAVE1_HH};
+		static const int pan[PREVIEW_NUM_VOICES] = {PAR_PAN1,PAR_PAN2,PAR_PAN3,PAR_PAN4,PAR_PAN5,PAR_PAN6};
+
+		PreviewVoiceSettings s;
+		s.voiceNr = voiceNr;
+		s.velocity = velocity;
+
+		s.wave[0] = values[oscWave[voiceNr]];
+		s.freq[0] = noteToFrequency(values[PAR_COARSE1+2*voiceNr], values[PAR_FINE1+2*voiceNr]);
+		s.wave[1] = s.wave[2] = PREVIEW_WAVE_SINE;
+		s.freq[1] = s.freq[2] = 0.f;
+		s.modAmount[0] = s.modAmount[1] = s.modAmount[2] = 0.f;
+		s.noiseMix = 0.f;
+		s.noiseFreq = 0.f;
+
+		if(voiceNr < 3)
+		{
+			//drum 1-3: a 2 op FM voice
+			s.wave[1] = values[PAR_MOD_WAVE_DRUM1+voiceNr];
+			s.freq[1] = noteToFrequency(values[PAR_FM_FREQ1+2*voiceNr], 63);
+			s.modAmount[0] = values[PAR_FMAMNT1+2*voiceNr]/127.f * 4.f;
+		}
+		else if(voiceNr == 3)
+		{
+			s.noiseFreq = noteToFrequency(values[PAR_NOISE_FREQ1], 63) * 8.f;
+			s.noiseMix = values[PAR_MIX1]/127.f;
+		}
+		else
+		{
+			//cymbal and hat: osc3 modulates osc2 modulates osc1
+			const bool cym = voiceNr == 4;
+			s.wave[1] = values[cym ? PAR_WAVE2_CYM : PAR_WAVE2_HH];
+			s.wave[2] = values[cym ? PAR_WAVE3_CYM : PAR_WAVE3_HH];
+			s.freq[1] = noteToFrequency(values[cym ? PAR_MOD_OSC_F1_CYM : PAR_MOD_OSC_F1], 63);
+			s.freq[2] = noteToFrequency(values[cym ? PAR_MOD_OSC_F2_CYM : PAR_MOD_OSC_F2], 63);
+			s.modAmount[0] = values[cym ? PAR_MOD_OSC_GAIN1_CYM : PAR_MOD_OSC_GAIN1]/127.f * 4.f;
+			s.modAmount[1] = values[cym ? PAR_MOD_OSC_GAIN2_CYM : PAR_MOD_OSC_GAIN2]/127.f * 4.f;
+		}
+
+		//the open hat decay follows the closed one
+		s.attack = valueToTime(values[PAR_VELOA1+2*voiceNr]);
+		s.decay = valueToTime(values[PAR_VELOD1+2*voiceNr + (openHat ? 1 : 0)]);
+		s.volSlope = values[PAR_VOL_SLOPE1+voiceNr]/127.f;
+
+		if(voiceNr < 4)
+		{
+			s.pitchAmount = values[PAR_MODAMNT1+voiceNr]/127.f * PREVIEW_PITCH_OCTAVES;
+			s.pitchDecay = valueToTime(values[PAR_MOD_EG1+voiceNr]);
+			s.pitchSlope = values[PAR_PITCH_SLOPE1+voiceNr]/127.f;
+		}
+		else
+		{
+			s.pitchAmount = 0.f;
+			s.pitchDecay = PREVIEW_MIN_TIME;
+			s.pitchSlope = 0.f;
+		}
+
+		s.filterType = values[PAR_FILTER_TYPE_1+voiceNr];
+		s.filterFreq = 20.f * powf(1000.f, values[PAR_FILTER_FREQ_1+voiceNr]/127.f);
+		s.filterQ = 0.5f * powf(40.f, values[PAR_RESO_1+voiceNr]/127.f);
+		s.filterDrive = 1.f + values[PAR_FILTER_DRIVE_1+voiceNr]/127.f * 4.f;
+
+		//PAR_DRIVE1-3 are followed by the snare, cymbal and hat distortion
+		s.drive = 1.f + values[PAR_DRIVE1+voiceNr]/127.f * 8.f;
+		s.decimation = 1 + (127 - values[PAR_VOICE_DECIMATION1+voiceNr])/4;
+
+		//pan is stored with a +63 offset, equal power law
+		const float volume = values[PAR_VOL1+voiceNr]/127.f;
+		const float p = jlimit(-1.f, 1.f, (values[pan[voiceNr]] - 63)/63.f);
+		const float angle = (p + 1.f) * float_Pi * 0.25f;
+		s.gainL = volume * volume * velocity * cosf(angle);
+		s.gainR = volume * volume * velocity * sinf(angle);
+
+		return s;
+	};
+
+private:
+	/** coarse is a midi note, fine +-1 semitone with the +63 offset*/
+	static float noteToFrequency(int coarse, int fine)
+	{
+		return 440.f * powf(2.f, (coarse + (fine - 63)/63.f - 69.f) / 12.f);
+	};
+
+	static float valueToTime(int value)
+	{
+		return PREVIEW_MIN_TIME * powf(PREVIEW_MAX_TIME/PREVIEW_MIN_TIME, value/127.f);
+	};
+};
+//---------------------------------------------------------------------------
+/** One 2x stage of the PreviewOversampler, a Blackman windowed half band FIR
+	split into its two polyphase branches. Every other tap of a half band
+	filter is 0 and the centre one is 1/2, so one branch is a plain delay and
+	only the other one is filtered, 4 outputs per SSE instruction. Up- and
+	downsampling keep their own state.
+*/
+class PreviewHalfband
+{
+public:
+	PreviewHalfband()
+	{
+		//the taps of the filtered branch are the even ones of the 2*TAPS-1 long filter
+		const int length = 2*PREVIEW_HALFBAND_TAPS - 1;
+		const int centre = PREVIEW_HALFBAND_TAPS - 1;
+		float sum = 0.f;
+		for(int m=0;m<PREVIEW_HALFBAND_TAPS;m++)
+		{
+			const float j = (float)(2*m);
+			const float t = j - centre;
+			const float window = 0.42f - 0.5f*cosf(2.f*float_Pi*j/(length-1)) + 0.08f*cosf(4.f*float_Pi*j/(length-1));
+			mCoefficients[m] = sinf(float_Pi*t*0.5f) / (float_Pi*t) * window;
+			sum += mCoefficients[m];
+		}
+		//the branch passes DC with 1/2, like the centre tap
+		for(int m=0;m<PREVIEW_HALFBAND_TAPS;m++)
+		{
+			mCoefficients[m] *= 0.5f / sum;
+		}
+		reset();
+	};
+
+	void reset()
+	{
+		zeromem(mUp, sizeof(mUp));
+		zeromem(mEven, sizeof(mEven));
+		zeromem(mOdd, sizeof(mOdd));
+	};
+
+	/** num samples of in to 2*num samples in out*/
+	void upsample(const float* in, float* out, int num)
+	{
+		jassert(num <= PREVIEW_HALFBAND_MAX_BLOCK);
+		memcpy(mUp + PREVIEW_HALFBAND_TAPS-1, in, num*sizeof(float));
+		filter(mUp, mFiltered, num);
+		for(int n=0;n<num;n++)
+		{
+			out[2*n] = 2.f * mFiltered[n];
+			out[2*n+1] = mUp[n + PREVIEW_HALFBAND_TAPS/2];
+		}
+		memmove(mUp, mUp + num, (PREVIEW_HALFBAND_TAPS-1)*sizeof(float));
+	};
+
+	/** 2*num samples of in to num samples in out*/
+	void downsample(const float* in, float* out, int num)
+	{
+		jassert(num <= PREVIEW_HALFBAND_MAX_BLOCK);
+		for(int n=0;n<num;n++)
+		{
+			mEven[PREVIEW_HALFBAND_TAPS-1 + n] = in[2*n];
+			mOdd[PREVIEW_HALFBAND_TAPS/2 + n] = in[2*n+1];
+		}
+		filter(mEven, out, num);
+		for(int n=0;n<num;n++)
+		{
+			out[n] += 0.5f * mOdd[n];
+		}
+		memmove(mEven, mEven + num, (PREVIEW_HALFBAND_TAPS-1)*sizeof(float));
+		memmove(mOdd, mOdd + num, (PREVIEW_HALFBAND_TAPS/2)*sizeof(float));
+	};
+
+private:
+	/** dest[n] = the taps times buffer[n..n+TAPS-1], the taps are symmetric*/
+	void filter(const float* buffer, float* dest, int num) const
+	{
+		int n = 0;
+#if PREVIEW_USE_SSE
+		if(SystemStats::hasSSE())
+		{
+			for(;n+4<=num;n+=4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for(int k=0;k<PREVIEW_HALFBAND_TAPS;k++)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(mCoefficients[k]), _mm_loadu_ps(buffer+n+k)));
+				}
+				_mm_storeu_ps(dest+n, sum);
+			}
+		}
+#endif
+		for(;n<num;n++)
+		{
+			float sum = 0.f;
+			for(int k=0;k<PREVIEW_HALFBAND_TAPS;k++)
+			{
+				sum += mCoefficients[k] * buffer[n+k];
+			}
+			dest[n] = sum;
+		}
+	};
+
+	float mCoefficients[PREVIEW_HALFBAND_TAPS];
+	float mUp[PREVIEW_HALFBAND_TAPS-1 + PREVIEW_HALFBAND_MAX_BLOCK];		// the last inputs, then the block
+	float mEven[PREVIEW_HALFBAND_TAPS-1 + PREVIEW_HALFBAND_MAX_BLOCK];
+	float mOdd[PREVIEW_HALFBAND_TAPS/2 + PREVIEW_HALFBAND_MAX_BLOCK];
+	float mFiltered[PREVIEW_HALFBAND_MAX_BLOCK];
+};
+
+//---------------------------------------------------------------------------
+/** The output saturation of a voice at 1, 2 or 4 times the sample rate.
+
+	A hard drive makes harmonics far above the Nyquist frequency, at the
+	sample rate they fold back as inharmonic noise the hardware doesn't
+	make. Oversampled, the half band filters take them out before the
+	signal comes back down. A factor of 1 is a plain tanh and costs
+	nothing more, the voice only asks for more while its drive is engaged.
+	The 2x stage delays the saturated signal by about 23 samples, the second
+	stage of 4x by about 12 more.
+*/
+class PreviewOversampler
+{
+public:
+	PreviewOversampler() : mFactor(1)
+	{
+	};
+
+	/** 1, 2 or 4, the state is cleared when it changes*/
+	void setFactor(int factor)
+	{
+		jassert(factor == 1 || factor == 2 || factor == 4);
+		if(factor == mFactor) return;
+		mFactor = factor;
+		reset();
+	};
+
+	int getFactor() const
+	{
+		return mFactor;
+	};
+
+	void reset()
+	{
+		mStages[0].reset();
+		mStages[1].reset();
+	};
+
+	/** tanh of num <= PREVIEW_BLOCK_SIZE samples, in place*/
+	void saturate(float* block, int num)
+	{
+		if(mFactor == 1)
+		{
+			for(int i=0;i<num;i++)
+			{
+				block[i] = tanhf(block[i]);
+			}
+			return;
+		}
+
+		mStages[0].upsample(block, mTwice, num);
+		float* high = mTwice;
+		if(mFactor == 4)
+		{
+			mStages[1].upsample(mTwice, mFourTimes, 2*num);
+			high = mFourTimes;
+		}
+		for(int i=0;i<num*mFactor;i++)
+		{
+			high[i] = tanhf(high[i]);
+		}
+		if(mFactor == 4)
+		{
+			mStages[1].downsample(mFourTimes, mTwice, 2*num);
+		}
+		mStages[0].downsample(mTwice, block, num);
+	};
+
+private:
+	PreviewHalfband mStages[2];		// the second one only for 4x
+	int mFactor;
+	float mTwice[PREVIEW_BLOCK_SIZE*2];
+	float mFourTimes[PREVIEW_BLOCK_SIZE*4];
+};
+
+//---------------------------------------------------------------------------
+/** A software approximation of one LXR voice, for auditioning on the computer.
+
+	The signal path follows the firmware: oscillators with phase modulation or
+	noise, pitch and amp envelopes, the state variable filter, drive and
+	decimation. It does not try to sound exactly like the hardware, the LFOs,
+	the transient generator and the velocity modulation are left out.
+
+	The filter is not part of the voice, PreviewVoiceBank runs the filters of
+	all voices side by side. So every block is rendered in two steps,
+	renderSource() up to the filter input and renderOutput() from the filter
+	output on. Blocks are up to PREVIEW_BLOCK_SIZE samples, the envelopes are
+	evaluated once per block and interpolated. A voice whose drive is
+	engaged saturates oversampled, see PreviewOversampler. Audio thread only.
+*/
+class PreviewVoice
+{
+public:
+	PreviewVoice() : mRandom(0x5eed), mTables(PreviewWavetables::getInstance())
+	{
+		mActive = false;
+		mSampleRate = 44100.f;
+		mFade = 1.f;
+		mFadeStep = 0.f;
+		memset(&mSettings, 0, sizeof(mSettings));
+	};
+
+	void setSampleRate(double sampleRate)
+	{
+		mSampleRate = (float)sampleRate;
+		mActive = false;
+	};
+
+	void start(const PreviewVoiceSettings& settings)
+	{
+		mSettings = settings;
+		mActive = true;
+		mTime = 0.f;
+		mPhase[0] = mPhase[1] = mPhase[2] = 0.f;
+		mNoisePhase = 0.f;
+		mNoise = 0.f;
+		mNoiseIndex = mRandom.next();
+		mHoldCount = 0;
+		mHeld = 0.f;
+		mAmp = ampEnvelope(0.f);
+		mPitch = pitchEnvelope(0.f);
+		mDriveNorm = 1.f / tanhf(mSettings.drive);
+		mOversampler.setFactor(getOversampling(mSettings.drive));
+		mOversampler.reset();
+		mFade = 1.f;
+		mFadeStep = 0.f;
+	};
+
+	/** new values for a playing hit, the phases and envelopes carry on*/
+	void update(const PreviewVoiceSettings& settings)
+	{
+		mSettings = settings;
+		mDriveNorm = 1.f / tanhf(mSettings.drive);
+		mOversampler.setFactor(getOversampling(mSettings.drive));
+	};
+
+	void stop()
+	{
+		mActive = false;
+	};
+
+	/** ramps the hit down to silence in numSamples instead of cutting it, the voice ends then*/
+	void fadeOut(int numSamples)
+	{
+		if(!mActive || isFading()) return;
+		mFadeStep = 1.f / jmax(1, numSamples);
+	};
+
+	bool isFading() const
+	{
+		return mFadeStep > 0.f;
+	};
+
+	float getFade() const
+	{
+		return mFade;
+	};
+
+	bool isActive() const
+	{
+		return mActive;
+	};
+
+	const PreviewVoiceSettings& getSettings() const
+	{
+		return mSettings;
+	};
+
+	/** oscillators, noise and filter drive, writes dest[i*stride] for numSamples <= PREVIEW_BLOCK_SIZE*/
+	void renderSource(float* dest, int stride, int numSamples)
+	{
+		jassert(numSamples <= PREVIEW_BLOCK_SIZE);
+
+		const float pitchEnd = pitchEnvelope(mTime + numSamples / mSampleRate);
+		const float pitchStep = (pitchEnd - mPitch) / numSamples;
+		const float invRate = 1.f / mSampleRate;
+
+		//every oscillator uses the table for its highest frequency in the block
+		const float* tables[3];
+		for(int osc=0;osc<3;osc++)
+		{
+			const float maxFreq = osc == 0 ? mSettings.freq[0] * jmax(mPitch, pitchEnd) : mSettings.freq[osc];
+			tables[osc] = mSettings.wave[osc] == PREVIEW_WAVE_NOISE ? NULL : mTables->getTable(mSettings.wave[osc], maxFreq * invRate);
+		}
+
+		float pitch = mPitch;
+
+		for(int i=0;i<numSamples;i++)
+		{
+			//the chain runs from the last modulator to the carrier
+			float mod = 0.f;
+			for(int osc=2;osc>=0;osc--)
+			{
+				if(osc > 0 && mSettings.freq[osc] <= 0.f) continue;
+
+				const float freq = osc == 0 ? mSettings.freq[0] * pitch : mSettings.freq[osc];
+				mod = oscillator(tables[osc], mPhase[osc] + mod) * (osc > 0 ? mSettings.modAmount[osc-1] : 1.f);
+				mPhase[osc] += freq * invRate;
+				mPhase[osc] -= (float)(int)mPhase[osc];
+			}
+			float x = mod;
+
+			if(mSettings.noiseFreq > 0.f)
+			{
+				mNoisePhase += mSettings.noiseFreq * invRate;
+				if(mNoisePhase >= 1.f)
+				{
+					mNoisePhase -= (float)(int)mNoisePhase;
+					mNoise = mRandom.nextFloat()*2.f - 1.f;
+				}
+				x += (mNoise - x) * mSettings.noiseMix;
+			}
+
+			dest[i*stride] = tanhf(x * mSettings.filterDrive);
+			pitch += pitchStep;
+		}
+
+		mPitch = pitchEnd;
+	};
+
+	/** amp envelope, drive, decimation and pan of the filtered block, added to the outputs.
+		right is NULL for a mono output. The voice ends itself after the decay.*/
+	void renderOutput(const float* filtered, int stride, float* left, float* right, int numSamples)
+	{
+		jassert(numSamples <= PREVIEW_BLOCK_SIZE);
+
+		const float blockTime = numSamples / mSampleRate;
+		const float ampEnd = ampEnvelope(mTime + blockTime);
+		const float ampStep = (ampEnd - mAmp) / numSamples;
+
+		float amp = mAmp;
+		for(int i=0;i<numSamples;i++)
+		{
+			mBlock[i] = filtered[i*stride] * amp * mSettings.drive;
+			amp += ampStep;
+		}
+		mOversampler.saturate(mBlock, numSamples);
+
+		//the decimation is held at the sample rate, its aliasing is part of the sound
+		float fade = mFade;
+		for(int i=0;i<numSamples;i++)
+		{
+			const float x = mBlock[i] * mDriveNorm * fade;
+
+			if(--mHoldCount <= 0)
+			{
+				mHeld = x;
+				mHoldCount = mSettings.decimation;
+			}
+			mBlock[i] = mHeld;
+
+			fade = jmax(0.f, fade - mFadeStep);
+		}
+
+		mAmp = ampEnd;
+		mFade = fade;
+		mTime += blockTime;
+
+		if(right == NULL)
+		{
+			//keep the level of both sides
+			addScaled(left, mBlock, mSettings.gainL + mSettings.gainR, numSamples);
+		}
+		else
+		{
+			addScaled(left, mBlock, mSettings.gainL, numSamples);
+			addScaled(right, mBlock, mSettings.gainR, numSamples);
+		}
+
+		if(mTime >= mSettings.attack + mSettings.decay || mFade <= 0.f)
+		{
+			mActive = false;
+		}
+	};
+
+private:
+	/** a clean drive isn't oversampled*/
+	static int getOversampling(float drive)
+	{
+		if(drive <= 1.f) return 1;
+		return drive <= PREVIEW_OVERSAMPLE_4X_DRIVE ? 2 : 4;
+	};
+
+	/** dest += src * gain, 4 samples at a time where SSE is available*/
+	static void addScaled(float* dest, const float* src, float gain, int num)
+	{
+		int i = 0;
+#if PREVIEW_USE_SSE
+		if(SystemStats::hasSSE())
+		{
+			const __m128 g = _mm_set1_ps(gain);
+			for(;i+4<=num;i+=4)
+			{
+				_mm_storeu_ps(dest+i, _mm_add_ps(_mm_loadu_ps(dest+i), _mm_mul_ps(_mm_loadu_ps(src+i), g)));
+			}
+		}
+#endif
+		for(;i<num;i++)
+		{
+			dest[i] += src[i] * gain;
+		}
+	};
+
+	/** a NULL table is the noise wave*/
+	float oscillator(const float* table, float phase)
+	{
+		if(table == NULL)
+		{
+			return mTables->getNoise(mNoiseIndex++);
+		}
+		return PreviewWavetables::lookup(table, phase);
+	};
+
+	/** linear attack, the slope bends the decay from linear towards exponential*/
+	float ampEnvelope(float t) const
+	{
+		if(t < mSettings.attack)
+		{
+			return t / mSettings.attack;
+		}
+		const float x = 1.f - (t - mSettings.attack) / mSettings.decay;
+		return x <= 0.f ? 0.f : powf(x, 1.f + mSettings.volSlope*6.f);
+	};
+
+	/** frequency factor, starts pitchAmount octaves up and falls back to 1*/
+	float pitchEnvelope(float t) const
+	{
+		if(mSettings.pitchAmount <= 0.f) return 1.f;
+
+		const float x = 1.f - t / mSettings.pitchDecay;
+		const float env = x <= 0.f ? 0.f : powf(x, 1.f + mSettings.pitchSlope*6.f);
+		return powf(2.f, env * mSettings.pitchAmount);
+	};
+
+	PreviewVoiceSettings mSettings;
+	FastRandom mRandom;
+	const PreviewWavetables* mTables;
+	bool mActive;
+	float mSampleRate;
+	float mTime;		// seconds since start()
+
+	float mPhase[3];
+	float mNoisePhase;
+	float mNoise;
+	uint32 mNoiseIndex;		// read position in the noise loop
+
+	float mAmp;			// envelope values at the start of the next block
+	float mPitch;
+
+	float mDriveNorm;
+	PreviewOversampler mOversampler;
+
+	int mHoldCount;
+	float mHeld;
+
+	float mFade;		// gain of a retriggered hit that is faded out
+	float mFadeStep;	// per sample, 0 while not fading
+
+	float mBlock[PREVIEW_BLOCK_SIZE];
+};
+//---------------------------------------------------------------------------
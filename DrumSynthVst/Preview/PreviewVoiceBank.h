@@ -0,0 +1,385 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "./PreviewVoice.h"
+
+#define PREVIEW_FILTER_LANES	8		// the six voices padded to two SSE vectors
+#define PREVIEW_FILTER_FLUSH	1e-15f	// smaller states are set to 0
+#define PREVIEW_RETRIGGER_FADE_MS	3.0	// a hit that is cut by the next one on its voice fades out this fast
+
+//---------------------------------------------------------------------------
+/** The state variable filters of all voices as a struct of arrays.
+
+	process() runs the filters side by side on frames of PREVIEW_FILTER_LANES
+	interleaved samples, 4 voices per SSE instruction. It is the TPT state
+	variable filter, every type is a fixed mix of its low, band and high pass
+	outputs, so the type needs no branch in the sample loop either.
+	The coefficients are only recomputed when the frequency or the resonance
+	of a voice change.
+*/
+class PreviewFilterBank
+{
+public:
+	PreviewFilterBank()
+	{
+		mSampleRate = 44100.f;
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			mA1[i] = mA2[i] = mA3[i] = mK[i] = 0.f;
+			setMix(i, PREVIEW_FILTER_LP);
+		}
+		invalidate();
+		reset();
+	};
+
+	void setSampleRate(double sampleRate)
+	{
+		mSampleRate = (float)sampleRate;
+		invalidate();
+		reset();
+	};
+
+	void reset()
+	{
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			mIc1[i] = mIc2[i] = 0.f;
+		}
+	};
+
+	/** sets up the filter of a voice for a new hit and clears its state*/
+	void start(int voice, int type, float frequency, float q)
+	{
+		setParameters(voice, type, frequency, q);
+		mIc1[voice] = mIc2[voice] = 0.f;
+	};
+
+	/** changes the filter of a playing voice, the state is kept*/
+	void setParameters(int voice, int type, float frequency, float q)
+	{
+		jassert(voice >= 0 && voice < PREVIEW_FILTER_LANES);
+
+		if(frequency != mFrequency[voice] || q != mQ[voice])
+		{
+			mFrequency[voice] = frequency;
+			mQ[voice] = q;
+
+			const float fc = jmin(frequency, mSampleRate*0.45f);
+			const float g = tanf(float_Pi * fc / mSampleRate);
+			mK[voice] = 1.f / q;
+			mA1[voice] = 1.f / (1.f + g*(g + mK[voice]));
+			mA2[voice] = g * mA1[voice];
+			mA3[voice] = g * mA2[voice];
+		}
+
+		setMix(voice, type);
+	};
+
+	/** filters numSamples frames of PREVIEW_FILTER_LANES samples in place*/
+	void process(float* frames, int numSamples)
+	{
+#if PREVIEW_USE_SSE
+		if(SystemStats::hasSSE())
+		{
+			for(int lane=0;lane<PREVIEW_FILTER_LANES;lane+=4)
+			{
+				processSSE(frames+lane, numSamples, lane);
+			}
+			flushDenormals();
+			return;
+		}
+#endif
+		for(int i=0;i<numSamples;i++)
+		{
+			float* frame = frames + i*PREVIEW_FILTER_LANES;
+			for(int v=0;v<PREVIEW_FILTER_LANES;v++)
+			{
+				const float x = frame[v];
+				const float v3 = x - mIc2[v];
+				const float v1 = mA1[v]*mIc1[v] + mA2[v]*v3;
+				const float v2 = mIc2[v] + mA2[v]*mIc1[v] + mA3[v]*v3;
+				mIc1[v] = 2.f*v1 - mIc1[v];
+				mIc2[v] = 2.f*v2 - mIc2[v];
+
+				const float hp = x - mK[v]*v1 - v2;
+				frame[v] = mLp[v]*v2 + mBp[v]*v1 + mHp[v]*hp;
+			}
+		}
+		flushDenormals();
+	};
+
+private:
+	/** the state of a silent or ringing out lane decays towards denormals, which
+		are many times slower on x86. Cleared once per block, long before*/
+	void flushDenormals()
+	{
+		for(int v=0;v<PREVIEW_FILTER_LANES;v++)
+		{
+			if(fabsf(mIc1[v]) < PREVIEW_FILTER_FLUSH) mIc1[v] = 0.f;
+			if(fabsf(mIc2[v]) < PREVIEW_FILTER_FLUSH) mIc2[v] = 0.f;
+		}
+	};
+
+#if PREVIEW_USE_SSE
+	/** the same arithmetic as the scalar loop for the 4 lanes from lane on, the state stays in registers*/
+	void processSSE(float* frames, int numSamples, int lane)
+	{
+		const __m128 a1 = _mm_loadu_ps(mA1+lane);
+		const __m128 a2 = _mm_loadu_ps(mA2+lane);
+		const __m128 a3 = _mm_loadu_ps(mA3+lane);
+		const __m128 k = _mm_loadu_ps(mK+lane);
+		const __m128 lp = _mm_loadu_ps(mLp+lane);
+		const __m128 bp = _mm_loadu_ps(mBp+lane);
+		const __m128 hp = _mm_loadu_ps(mHp+lane);
+		const __m128 two = _mm_set1_ps(2.f);
+		__m128 ic1 = _mm_loadu_ps(mIc1+lane);
+		__m128 ic2 = _mm_loadu_ps(mIc2+lane);
+
+		for(int i=0;i<numSamples;i++)
+		{
+			float* frame = frames + i*PREVIEW_FILTER_LANES;
+			const __m128 x = _mm_loadu_ps(frame);
+			const __m128 v3 = _mm_sub_ps(x, ic2);
+			const __m128 v1 = _mm_add_ps(_mm_mul_ps(a1, ic1), _mm_mul_ps(a2, v3));
+			const __m128 v2 = _mm_add_ps(_mm_add_ps(ic2, _mm_mul_ps(a2, ic1)), _mm_mul_ps(a3, v3));
+			ic1 = _mm_sub_ps(_mm_mul_ps(two, v1), ic1);
+			ic2 = _mm_sub_ps(_mm_mul_ps(two, v2), ic2);
+
+			const __m128 h = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, v1)), v2);
+			_mm_storeu_ps(frame, _mm_add_ps(_mm_add_ps(_mm_mul_ps(lp, v2), _mm_mul_ps(bp, v1)), _mm_mul_ps(hp, h)));
+		}
+
+		_mm_storeu_ps(mIc1+lane, ic1);
+		_mm_storeu_ps(mIc2+lane, ic2);
+	};
+#endif
+
+	/** the weights of the low, band and high pass outputs for a filter type*/
+	void setMix(int voice, int type)
+	{
+		float lp = 0.f, bp = 0.f, hp = 0.f;
+		switch(type)
+		{
+		default:
+		case PREVIEW_FILTER_LP:		lp = 1.f;					break;
+		case PREVIEW_FILTER_HP:		hp = 1.f;					break;
+		case PREVIEW_FILTER_BP:		bp = 1.f;					break;
+		case PREVIEW_FILTER_UBP:	bp = mK[voice];				break;
+		case PREVIEW_FILTER_NOTCH:	lp = 1.f;	hp = 1.f;		break;
+		case PREVIEW_FILTER_PEAK:	lp = 1.f;	hp = -1.f;		break;
+		}
+		mLp[voice] = lp;
+		mBp[voice] = bp;
+		mHp[voice] = hp;
+	};
+
+	/** forces the next start() of every voice to compute its coefficients*/
+	void invalidate()
+	{
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			mFrequency[i] = mQ[i] = -1.f;
+		}
+	};
+
+	float mSampleRate;
+
+	float mA1[PREVIEW_FILTER_LANES];
+	float mA2[PREVIEW_FILTER_LANES];
+	float mA3[PREVIEW_FILTER_LANES];
+	float mK[PREVIEW_FILTER_LANES];
+	float mLp[PREVIEW_FILTER_LANES];
+	float mBp[PREVIEW_FILTER_LANES];
+	float mHp[PREVIEW_FILTER_LANES];
+	float mIc1[PREVIEW_FILTER_LANES];
+	float mIc2[PREVIEW_FILTER_LANES];
+
+	float mFrequency[PREVIEW_FILTER_LANES];	// what the coefficients were computed for
+	float mQ[PREVIEW_FILTER_LANES];
+};
+//---------------------------------------------------------------------------
+/** The six preview voices with their filter bank, one instance per output.
+	Audio thread, or any single thread for offline rendering.
+
+	The hits play from a fixed pool of PREVIEW_FILTER_LANES voices, one per
+	filter lane, nothing is allocated after construction. Each of the six
+	voices plays one hit at a time like on the LXR, but a retriggered hit
+	isn't cut off, it is moved out of the way and faded out over
+	PREVIEW_RETRIGGER_FADE_MS in one of the two spare lanes. Every lane
+	knows the voice whose current hit it holds, so a hit that takes over a
+	lane releases it without searching the voices.
+*/
+class PreviewVoiceBank
+{
+public:
+	PreviewVoiceBank() : mFadeSamples(0)
+	{
+		zeromem(mFrames, sizeof(mFrames));
+		clearLanes();
+	};
+
+	void setSampleRate(double sampleRate)
+	{
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			mVoices[i].setSampleRate(sampleRate);
+		}
+		mFilters.setSampleRate(sampleRate);
+		mFadeSamples = roundToInt(PREVIEW_RETRIGGER_FADE_MS * 0.001 * sampleRate);
+		clearLanes();
+	};
+
+	/** a new hit restarts the voice, like on the LXR, the previous hit fades out*/
+	void start(const PreviewVoiceSettings& settings)
+	{
+		const int previous = mLanes[settings.voiceNr];
+		if(previous >= 0) mVoices[previous].fadeOut(mFadeSamples);
+
+		const int lane = findFreeLane();
+
+		//a voice whose hit has ended gives up its lane
+		const int owner = mOwners[lane];
+		if(owner >= 0 && mLanes[owner] == lane) mLanes[owner] = -1;
+		mLanes[settings.voiceNr] = lane;
+		mOwners[lane] = settings.voiceNr;
+		mVoices[lane].start(settings);
+		mFilters.start(lane, settings.filterType, settings.filterFreq, settings.filterQ);
+	};
+
+	/** new values for the hit a voice is playing, ignored if it has ended*/
+	void update(const PreviewVoiceSettings& settings)
+	{
+		if(!isActive(settings.voiceNr)) return;
+
+		const int lane = mLanes[settings.voiceNr];
+		mVoices[lane].update(settings);
+		mFilters.setParameters(lane, settings.filterType, settings.filterFreq, settings.filterQ);
+	};
+
+	/** whether the current hit of a voice is still sounding, a hit that is faded out doesn't count*/
+	bool isActive(int voiceNr) const
+	{
+		const int lane = mLanes[voiceNr];
+		return lane >= 0 && mVoices[lane].isActive() && !mVoices[lane].isFading();
+	};
+
+	/** the velocity of the voice's current hit*/
+	float getVelocity(int voiceNr) const
+	{
+		const int lane = mLanes[voiceNr];
+		return lane >= 0 ? mVoices[lane].getSettings().velocity : 0.f;
+	};
+
+	/** pool voices that are sounding, including those that fade out*/
+	int getNumPlaying() const
+	{
+		int num = 0;
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			if(mVoices[i].isActive()) num++;
+		}
+		return num;
+	};
+
+	void stopAll()
+	{
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			mVoices[i].stop();
+		}
+		clearLanes();
+	};
+
+	/** renders numSamples <= PREVIEW_BLOCK_SIZE of all playing voices and adds them to the outputs.
+		right is NULL for a mono output.*/
+	void renderAdding(float* left, float* right, int numSamples)
+	{
+		jassert(numSamples <= PREVIEW_BLOCK_SIZE);
+
+		bool anyActive = false;
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			PreviewVoice& voice = mVoices[i];
+			if(voice.isActive())
+			{
+				voice.renderSource(mFrames+i, PREVIEW_FILTER_LANES, numSamples);
+				anyActive = true;
+			}
+			else
+			{
+				//silent lanes still run through the filters, their state just decays
+				for(int s=0;s<numSamples;s++) mFrames[s*PREVIEW_FILTER_LANES+i] = 0.f;
+			}
+		}
+		if(!anyActive) return;
+
+		mFilters.process(mFrames, numSamples);
+
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			if(mVoices[i].isActive())
+			{
+				mVoices[i].renderOutput(mFrames+i, PREVIEW_FILTER_LANES, left, right, numSamples);
+			}
+		}
+	};
+
+private:
+	void clearLanes()
+	{
+		for(int i=0;i<PREVIEW_NUM_VOICES;i++)
+		{
+			mLanes[i] = -1;
+		}
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			mOwners[i] = -1;
+		}
+	};
+
+	/** a silent lane, else the spare lane whose fade is furthest along. at
+		most six lanes hold a current hit, so there is always one of the two*/
+	int findFreeLane() const
+	{
+		int fading = -1;
+		for(int i=0;i<PREVIEW_FILTER_LANES;i++)
+		{
+			if(!mVoices[i].isActive()) return i;
+			if(mVoices[i].isFading() && (fading < 0 || mVoices[i].getFade() < mVoices[fading].getFade())) fading = i;
+		}
+		jassert(fading >= 0);
+		return fading;
+	};
+
+	PreviewVoice mVoices[PREVIEW_FILTER_LANES];	// the pool
+	int mLanes[PREVIEW_NUM_VOICES];				// lane of the current hit of every voice, -1 if none
+	int mOwners[PREVIEW_FILTER_LANES];			// voice of the last hit started in every lane, -1 if none
+	int mFadeSamples;
+	PreviewFilterBank mFilters;
+	float mFrames[PREVIEW_BLOCK_SIZE*PREVIEW_FILTER_LANES];	// filter input and output, voice i at i, i+8, ...
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,365 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../FastRandom.h"
+#include "../drumSynthSource/menuText.h"
+#include <math.h>
+
+#define PREVIEW_TABLE_BITS		11
+#define PREVIEW_TABLE_SIZE		(1<<PREVIEW_TABLE_BITS)		// samples per cycle
+#define PREVIEW_TABLE_GUARD		2							// copies of the first samples for the interpolation
+#define PREVIEW_TABLE_LEVELS	PREVIEW_TABLE_BITS			// level l holds PREVIEW_TABLE_SIZE/2 >> l harmonics
+#define PREVIEW_NUM_TABLES		5							// sine, tri, saw, rec, cym
+#define PREVIEW_NOISE_BITS		16
+#define PREVIEW_NOISE_SIZE		(1<<PREVIEW_NOISE_BITS)
+#define PREVIEW_LFO_TABLE_SIZE	256		// samples per cycle of an lfo wave, plus one guard sample
+#define PREVIEW_NUM_LFO_WAVES	8		// the lfoWaveNames
+#define PREVIEW_LFO_MIN_HZ		0.05	// PAR_FREQ_LFO 0
+#define PREVIEW_LFO_MAX_HZ		40.0	// PAR_FREQ_LFO 127
+#define PREVIEW_LFO_EXP_CURVE	4.0		// steepness of the xup and xdn waves
+
+/** the MENU_WAVEFORM values of the oscillators*/
+enum
+{
+	PREVIEW_WAVE_SINE = 0,
+	PREVIEW_WAVE_TRI,
+	PREVIEW_WAVE_SAW,
+	PREVIEW_WAVE_REC,
+	PREVIEW_WAVE_NOISE,
+	PREVIEW_WAVE_CYM
+};
+
+/** the PAR_WAVE_LFO values, in the order of lfoWaveNames*/
+enum
+{
+	PREVIEW_LFO_SINE = 0,
+	PREVIEW_LFO_TRI,
+	PREVIEW_LFO_SAW_UP,
+	PREVIEW_LFO_SAW_DOWN,
+	PREVIEW_LFO_SQUARE,
+	PREVIEW_LFO_RANDOM,
+	PREVIEW_LFO_EXP_UP,
+	PREVIEW_LFO_EXP_DOWN
+};
+
+//---------------------------------------------------------------------------
+/** Band limited, mip mapped single cycles of the oscillator waveforms and a
+	loop of white noise, shared read only by all preview voices.
+
+	Each waveform has one table per octave of harmonics. getTable() picks the
+	richest one whose top harmonic stays below nyquist for the given phase
+	increment, so an oscillator is a table lookup with linear interpolation
+	and doesn't alias. The tri, saw and rec tables are summed from their
+	Fourier series. The cym wave has no closed form, its one cycle is sampled
+	and split into harmonics once with a plain DFT.
+	The LFOs get one plain cycle per wave, they run far below any aliasing,
+	and two lookup tables for their rates: Hz of every PAR_FREQ_LFO value and
+	cycles per quarter note of every syncRateNames entry.
+
+	The tables are built in the constructor, create the instance on startup so
+	the audio thread never builds it.
+*/
+class PreviewWavetables
+{
+public:
+	PreviewWavetables()
+	{
+		mTables.calloc(PREVIEW_NUM_TABLES*PREVIEW_TABLE_LEVELS*getTableStride());
+
+		//sin(2*pi*i/N), the harmonics index it modulo N
+		HeapBlock<float> sine(PREVIEW_TABLE_SIZE);
+		for(int i=0;i<PREVIEW_TABLE_SIZE;i++)
+		{
+			sine[i] = (float)sin(2.0*double_Pi*i/PREVIEW_TABLE_SIZE);
+		}
+
+		const int numHarmonics = PREVIEW_TABLE_SIZE/2;
+		HeapBlock<float> sinAmount(numHarmonics+1);
+		HeapBlock<float> cosAmount(numHarmonics+1);
+
+		const int waves[PREVIEW_NUM_TABLES] = {PREVIEW_WAVE_SINE,PREVIEW_WAVE_TRI,PREVIEW_WAVE_SAW,PREVIEW_WAVE_REC,PREVIEW_WAVE_CYM};
+		for(int i=0;i<PREVIEW_NUM_TABLES;i++)
+		{
+			getSpectrum(waves[i],sine,sinAmount,cosAmount);
+			buildLevels(waves[i],sine,sinAmount,cosAmount);
+		}
+
+		FastRandom random(0x401c);
+		mNoise.malloc(PREVIEW_NOISE_SIZE);
+		for(int i=0;i<PREVIEW_NOISE_SIZE;i++)
+		{
+			mNoise[i] = random.nextFloat()*2.f - 1.f;
+		}
+
+		buildLfoTables();
+	};
+
+	~PreviewWavetables()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (PreviewWavetables, false)
+
+	/** the table of a PREVIEW_WAVE_SINE..PREVIEW_WAVE_REC or PREVIEW_WAVE_CYM wave
+		for an oscillator that advances phaseIncrement cycles per sample, unknown waves are sine*/
+	const float* getTable(int wave, float phaseIncrement) const
+	{
+		const int index = getTableIndex(wave);
+
+		//the top harmonic of level l is SIZE/2 >> l, it has to stay below 0.5/phaseIncrement
+		int level = 0;
+		float top = phaseIncrement * (PREVIEW_TABLE_SIZE/2);
+		while(top > 0.5f && level < PREVIEW_TABLE_LEVELS-1)
+		{
+			top *= 0.5f;
+			level++;
+		}
+		return mTables + (index*PREVIEW_TABLE_LEVELS + level)*getTableStride();
+	};
+
+	/** one cycle at phase [0,1), any phase is wrapped*/
+	static float lookup(const float* table, float phase)
+	{
+		const float pos = (phase - floorf(phase)) * PREVIEW_TABLE_SIZE;
+		const int i = (int)pos;
+		const float frac = pos - (float)i;
+		return table[i] + (table[i+1] - table[i]) * frac;
+	};
+
+	/** white noise, index is masked to the loop*/
+	float getNoise(uint32 index) const
+	{
+		return mNoise[index & (PREVIEW_NOISE_SIZE-1)];
+	};
+
+	/** one bipolar cycle of a PREVIEW_LFO_* wave, the random wave is flat and unknown waves are sine.
+		The caller holds a random value per cycle itself*/
+	const float* getLfoTable(int wave) const
+	{
+		if(wave < 0 || wave >= PREVIEW_NUM_LFO_WAVES) wave = PREVIEW_LFO_SINE;
+		return mLfoTables + wave*(PREVIEW_LFO_TABLE_SIZE+1);
+	};
+
+	/** one lfo cycle at phase [0,1)*/
+	static float lookupLfo(const float* table, float phase)
+	{
+		const float pos = phase * PREVIEW_LFO_TABLE_SIZE;
+		const int i = jlimit(0, PREVIEW_LFO_TABLE_SIZE-1, (int)pos);
+		return table[i] + (table[i+1] - table[i]) * (pos - (float)i);
+	};
+
+	/** the free running rate of a PAR_FREQ_LFO value*/
+	double getLfoFrequency(int value) const
+	{
+		return mLfoFrequencies[jlimit(0, 127, value)];
+	};
+
+	/** cycles per quarter note of a PAR_SYNC_LFO value, 0 for off*/
+	double getLfoSyncCycles(int value) const
+	{
+		return value > 0 && value < mNumSyncRates ? mLfoSyncCycles[value] : 0.0;
+	};
+
+private:
+	static int getTableIndex(int wave)
+	{
+		if(wave == PREVIEW_WAVE_CYM) return PREVIEW_NUM_TABLES-1;
+		return wave >= PREVIEW_WAVE_SINE && wave <= PREVIEW_WAVE_REC ? wave : PREVIEW_WAVE_SINE;
+	};
+
+	static int getTableStride()
+	{
+		return PREVIEW_TABLE_SIZE + PREVIEW_TABLE_GUARD;
+	};
+
+	/** sine and cosine amount of every harmonic, for the same waveforms the naive oscillators had*/
+	static void getSpectrum(int wave, const float* sine, float* sinAmount, float* cosAmount)
+	{
+		const int numHarmonics = PREVIEW_TABLE_SIZE/2;
+		const float pi = float_Pi;
+		for(int h=0;h<=numHarmonics;h++)
+		{
+			sinAmount[h] = cosAmount[h] = 0.f;
+		}
+
+		switch(wave)
+		{
+		case PREVIEW_WAVE_SINE:
+			sinAmount[1] = 1.f;
+			break;
+
+		case PREVIEW_WAVE_TRI:
+			//4|p-0.5|-1, starts at +1
+			for(int h=1;h<=numHarmonics;h+=2) cosAmount[h] = 8.f/(pi*pi*h*h);
+			break;
+
+		case PREVIEW_WAVE_SAW:
+			//2p-1, rising
+			for(int h=1;h<=numHarmonics;h++) sinAmount[h] = -2.f/(pi*h);
+			break;
+
+		case PREVIEW_WAVE_REC:
+			//+1 for the first half
+			for(int h=1;h<=numHarmonics;h+=2) sinAmount[h] = 4.f/(pi*h);
+			break;
+
+		default:
+			{
+				//three squares at inharmonic ratios, the metallic part of the 808 cymbal
+				HeapBlock<float> cycle(PREVIEW_TABLE_SIZE);
+				for(int i=0;i<PREVIEW_TABLE_SIZE;i++)
+				{
+					const float phase = (i + 0.5f) / PREVIEW_TABLE_SIZE;
+					float p2 = phase * 1.4471f;
+					float p3 = phase * 1.6170f;
+					p2 -= floorf(p2);
+					p3 -= floorf(p3);
+					cycle[i] = ((phase < 0.5f ? 1.f : -1.f) + (p2 < 0.5f ? 1.f : -1.f) + (p3 < 0.5f ? 1.f : -1.f)) * (1.f/3.f);
+				}
+
+				const int quarter = PREVIEW_TABLE_SIZE/4;
+				double mean = 0.0;
+				for(int i=0;i<PREVIEW_TABLE_SIZE;i++) mean += cycle[i];
+				cosAmount[0] = (float)(mean/PREVIEW_TABLE_SIZE);
+
+				for(int h=1;h<numHarmonics;h++)
+				{
+					double s = 0.0, c = 0.0;
+					for(int i=0;i<PREVIEW_TABLE_SIZE;i++)
+					{
+						const int n = (h*i) & (PREVIEW_TABLE_SIZE-1);
+						s += cycle[i] * sine[n];
+						c += cycle[i] * sine[(n + quarter) & (PREVIEW_TABLE_SIZE-1)];
+					}
+					sinAmount[h] = (float)(2.0*s/PREVIEW_TABLE_SIZE);
+					cosAmount[h] = (float)(2.0*c/PREVIEW_TABLE_SIZE);
+				}
+			}
+			break;
+		}
+	};
+
+	/** sums the levels from the fewest harmonics up, each adds the next octave to the one below*/
+	void buildLevels(int wave, const float* sine, const float* sinAmount, const float* cosAmount)
+	{
+		const int index = getTableIndex(wave);
+		const int quarter = PREVIEW_TABLE_SIZE/4;
+
+		int firstHarmonic = 0;	// the cym wave has a dc offset
+		for(int level=PREVIEW_TABLE_LEVELS-1;level>=0;level--)
+		{
+			float* table = mTables + (index*PREVIEW_TABLE_LEVELS + level)*getTableStride();
+			const int lastHarmonic = (PREVIEW_TABLE_SIZE/2) >> level;
+
+			if(level < PREVIEW_TABLE_LEVELS-1)
+			{
+				memcpy(table, table + getTableStride(), sizeof(float)*PREVIEW_TABLE_SIZE);
+			}
+			//the nyquist harmonic of the top level would only sample its zero crossings
+			for(int h=firstHarmonic;h<=lastHarmonic && h<PREVIEW_TABLE_SIZE/2;h++)
+			{
+				if(sinAmount[h] == 0.f && cosAmount[h] == 0.f) continue;
+				for(int i=0;i<PREVIEW_TABLE_SIZE;i++)
+				{
+					const int n = (h*i) & (PREVIEW_TABLE_SIZE-1);
+					table[i] += sinAmount[h]*sine[n] + cosAmount[h]*sine[(n + quarter) & (PREVIEW_TABLE_SIZE-1)];
+				}
+			}
+			for(int i=0;i<PREVIEW_TABLE_GUARD;i++)
+			{
+				table[PREVIEW_TABLE_SIZE+i] = table[i];
+			}
+			firstHarmonic = lastHarmonic + 1;
+		}
+	};
+
+	void buildLfoTables()
+	{
+		mLfoTables.calloc(PREVIEW_NUM_LFO_WAVES*(PREVIEW_LFO_TABLE_SIZE+1));
+		const double expScale = 1.0 / (exp(PREVIEW_LFO_EXP_CURVE) - 1.0);
+		for(int wave=0;wave<PREVIEW_NUM_LFO_WAVES;wave++)
+		{
+			float* table = mLfoTables + wave*(PREVIEW_LFO_TABLE_SIZE+1);
+			for(int i=0;i<=PREVIEW_LFO_TABLE_SIZE;i++)
+			{
+				const double phase = (double)(i % PREVIEW_LFO_TABLE_SIZE) / PREVIEW_LFO_TABLE_SIZE;
+				double v = 0.0;
+				switch(wave)
+				{
+				case PREVIEW_LFO_SINE:		v = sin(2.0*double_Pi*phase); break;
+				case PREVIEW_LFO_TRI:		v = phase < 0.5 ? 4.0*phase - 1.0 : 3.0 - 4.0*phase; break;
+				case PREVIEW_LFO_SAW_UP:	v = 2.0*phase - 1.0; break;
+				case PREVIEW_LFO_SAW_DOWN:	v = 1.0 - 2.0*phase; break;
+				case PREVIEW_LFO_SQUARE:	v = phase < 0.5 ? 1.0 : -1.0; break;
+				case PREVIEW_LFO_EXP_UP:	v = 2.0*(exp(PREVIEW_LFO_EXP_CURVE*phase) - 1.0)*expScale - 1.0; break;
+				case PREVIEW_LFO_EXP_DOWN:	v = 2.0*(exp(PREVIEW_LFO_EXP_CURVE*(1.0-phase)) - 1.0)*expScale - 1.0; break;
+				default:					break;
+				}
+				table[i] = (float)v;
+			}
+			//the ramps and the square jump at the end of the cycle, not across the last interval
+			if(wave != PREVIEW_LFO_SINE && wave != PREVIEW_LFO_TRI)
+			{
+				table[PREVIEW_LFO_TABLE_SIZE] = table[PREVIEW_LFO_TABLE_SIZE-1];
+			}
+		}
+
+		//evenly spaced on a log scale, like the pitch of a knob
+		for(int i=0;i<128;i++)
+		{
+			mLfoFrequencies[i] = PREVIEW_LFO_MIN_HZ * pow(PREVIEW_LFO_MAX_HZ/PREVIEW_LFO_MIN_HZ, i/127.0);
+		}
+
+		//"a/b" lasts a/b bars, "n" is an nth note. The first entry is the count, then "off"
+		mNumSyncRates = jmin((int)syncRateNames[0][0], (int)numElementsInArray(mLfoSyncCycles));
+		mLfoSyncCycles[0] = 0.0;
+		for(int i=1;i<mNumSyncRates;i++)
+		{
+			const String name(syncRateNames[i+1]);
+			double wholeNotes = 0.0;
+			if(name.containsChar('/'))
+			{
+				const int denominator = name.fromFirstOccurrenceOf("/", false, false).getIntValue();
+				wholeNotes = denominator > 0 ? name.upToFirstOccurrenceOf("/", false, false).getIntValue() / (double)denominator : 0.0;
+			}
+			else if(name.getIntValue() > 0)
+			{
+				wholeNotes = 1.0 / name.getIntValue();
+			}
+			mLfoSyncCycles[i] = wholeNotes > 0.0 ? 1.0 / (4.0*wholeNotes) : 0.0;
+		}
+	};
+
+	HeapBlock<float> mTables;	// [table][level][PREVIEW_TABLE_SIZE + PREVIEW_TABLE_GUARD]
+	HeapBlock<float> mNoise;
+	HeapBlock<float> mLfoTables;	// [wave][PREVIEW_LFO_TABLE_SIZE + 1]
+	double mLfoFrequencies[128];
+	double mLfoSyncCycles[16];
+	int mNumSyncRates;
+};
+//---------------------------------------------------------------------------
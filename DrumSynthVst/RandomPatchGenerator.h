@@ -0,0 +1,274 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./parameterRanges.h"
+#include "./ParameterLocks.h"
+#include "./ParallelFor.h"
+#include "./Patch.h"
+#include "FastRandom.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define RANDOM_PATCH_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #define RANDOM_PATCH_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#define RANDOM_PATCH_LANES		4		// xoshiro128** streams, one per 32 bit SIMD lane
+#define RANDOM_PATCH_STEP		8		// parameters drawn at once, 16 random bits each
+#define RANDOM_PATCH_STRIDE		((NUM_PARAMS+RANDOM_PATCH_STEP-1)&~(RANDOM_PATCH_STEP-1))	// the tables are padded to whole steps
+#define RANDOM_PATCH_BLOCK		1024	// patches per set of streams and per item of the ParallelFor
+
+//---------------------------------------------------------------------------
+/** Fills packed patch arrays with random values, every parameter drawn
+	uniformly from the values its dtype can store.
+
+	A value is low + (r*count)>>16 with 16 random bits r. low and count come
+	from parameterRanges like the bounds of the MutationKernel, so a menu
+	gets one of its entries, an on/off switch 0 or 1, a PM63 parameter 0 to
+	126 and the 1..16 ones start at 1. The parameters of locked categories
+	(see ParameterLocks) and everything from LOCK_FIRST_UNBRED on keep the
+	values of the base patch, by default an empty Patch.
+
+	The random bits come from RANDOM_PATCH_LANES xoshiro128** streams that
+	run side by side in the lanes of SSE2 or NEON, each step draws
+	RANDOM_PATCH_STEP parameters with a 16 bit multiply-high. The lanes are
+	the sequences of FastRandom, so the scalar code gives the same patches.
+	Every RANDOM_PATCH_BLOCK patches start new streams taken from the seed
+	and the block number, generate() spreads the blocks over the
+	ParallelFor and the patches only depend on the seed. Setting the base
+	or the locks isn't thread safe, generating is.
+*/
+class RandomPatchGenerator
+{
+public:
+	RandomPatchGenerator()
+	{
+		memset(mLow,0,sizeof(mLow));
+		memset(mCount,0,sizeof(mCount));
+		memset(mSelect,0,sizeof(mSelect));
+		memset(mBase,0,sizeof(mBase));
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			const ParameterRange& range = parameterRanges[i];
+			mLow[i] = (uint16)(range.min < 0 ? 0 : range.min);
+			mCount[i] = (uint16)(range.range + 1);
+		}
+
+		Patch empty;
+		setBase(empty.getValues());
+		setLocks(ParameterLocks());
+	};
+
+	/** NUM_PARAMS values, the locked parameters keep them*/
+	void setBase(const uint8_t* values)
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mBase[i] = values[i];
+		}
+	};
+
+	/** only the unlocked parameters are drawn*/
+	void setLocks(const ParameterLocks& locks)
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			mSelect[i] = locks.isUnlocked(i) ? 0xffff : 0;
+		}
+	};
+
+	/** numPatches patches of NUM_PARAMS values, stride bytes apart (e.g. PATCH_DATA_SIZE into
+		records behind their names). the same seed always gives the same patches. Any thread,
+		calls from a ParallelFor task run on the calling thread*/
+	void generate(uint64 seed, uint8_t* out, int numPatches, int stride = NUM_PARAMS) const
+	{
+		BlockTask task(*this,seed,out,numPatches,stride);
+		ParallelFor::getInstance()->execute((numPatches+RANDOM_PATCH_BLOCK-1)/RANDOM_PATCH_BLOCK,1,task);
+	};
+
+	/** the patches of one block, they start at the block's first patch*/
+	void generateBlock(uint64 seed, int block, uint8_t* out, int numPatches, int stride) const
+	{
+		uint32 state[FAST_RANDOM_STATE_SIZE][RANDOM_PATCH_LANES];
+		for(int lane=0;lane<RANDOM_PATCH_LANES;lane++)
+		{
+			uint32 laneState[FAST_RANDOM_STATE_SIZE];
+			FastRandom((uint64)seed,(uint64)block*RANDOM_PATCH_LANES + lane).getState(laneState);
+			for(int k=0;k<FAST_RANDOM_STATE_SIZE;k++)
+			{
+				state[k][lane] = laneState[k];
+			}
+		}
+
+#if RANDOM_PATCH_USE_SSE2
+		__m128i s0 = _mm_loadu_si128((const __m128i*)state[0]);
+		__m128i s1 = _mm_loadu_si128((const __m128i*)state[1]);
+		__m128i s2 = _mm_loadu_si128((const __m128i*)state[2]);
+		__m128i s3 = _mm_loadu_si128((const __m128i*)state[3]);
+		for(int p=0;p<numPatches;p++)
+		{
+			uint8_t* dest = out + p*stride;
+			for(int i=0;i<RANDOM_PATCH_STRIDE;i+=RANDOM_PATCH_STEP)
+			{
+				//xoshiro128**, SSE2 has no 32 bit multiply so *5 and *9 are shifts and adds
+				const __m128i times5 = _mm_add_epi32(_mm_slli_epi32(s1,2),s1);
+				const __m128i rotated = _mm_or_si128(_mm_slli_epi32(times5,7),_mm_srli_epi32(times5,25));
+				const __m128i bits = _mm_add_epi32(_mm_slli_epi32(rotated,3),rotated);
+				const __m128i t = _mm_slli_epi32(s1,9);
+				s2 = _mm_xor_si128(s2,s0);
+				s3 = _mm_xor_si128(s3,s1);
+				s1 = _mm_xor_si128(s1,s2);
+				s0 = _mm_xor_si128(s0,s3);
+				s2 = _mm_xor_si128(s2,t);
+				s3 = _mm_or_si128(_mm_slli_epi32(s3,11),_mm_srli_epi32(s3,21));
+
+				const __m128i drawn = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(mLow+i)),_mm_mulhi_epu16(bits,_mm_loadu_si128((const __m128i*)(mCount+i))));
+				const __m128i select = _mm_loadu_si128((const __m128i*)(mSelect+i));
+				const __m128i value = _mm_or_si128(_mm_and_si128(select,drawn),_mm_andnot_si128(select,_mm_loadu_si128((const __m128i*)(mBase+i))));
+				const __m128i bytes = _mm_packus_epi16(value,value);
+				if(i+RANDOM_PATCH_STEP <= NUM_PARAMS)
+				{
+					_mm_storel_epi64((__m128i*)(dest+i),bytes);
+				}
+				else
+				{
+					//the last step would write into the next patch
+					uint8_t tail[RANDOM_PATCH_STEP];
+					_mm_storel_epi64((__m128i*)tail,bytes);
+					memcpy(dest+i,tail,NUM_PARAMS-i);
+				}
+			}
+		}
+#elif RANDOM_PATCH_USE_NEON
+		uint32x4_t s0 = vld1q_u32(state[0]);
+		uint32x4_t s1 = vld1q_u32(state[1]);
+		uint32x4_t s2 = vld1q_u32(state[2]);
+		uint32x4_t s3 = vld1q_u32(state[3]);
+		for(int p=0;p<numPatches;p++)
+		{
+			uint8_t* dest = out + p*stride;
+			for(int i=0;i<RANDOM_PATCH_STRIDE;i+=RANDOM_PATCH_STEP)
+			{
+				const uint32x4_t times5 = vmulq_n_u32(s1,5);
+				const uint32x4_t rotated = vorrq_u32(vshlq_n_u32(times5,7),vshrq_n_u32(times5,25));
+				const uint16x8_t bits = vreinterpretq_u16_u32(vmulq_n_u32(rotated,9));
+				const uint32x4_t t = vshlq_n_u32(s1,9);
+				s2 = veorq_u32(s2,s0);
+				s3 = veorq_u32(s3,s1);
+				s1 = veorq_u32(s1,s2);
+				s0 = veorq_u32(s0,s3);
+				s2 = veorq_u32(s2,t);
+				s3 = vorrq_u32(vshlq_n_u32(s3,11),vshrq_n_u32(s3,21));
+
+				const uint16x8_t count = vld1q_u16(mCount+i);
+				const uint16x8_t high = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(bits),vget_low_u16(count)),16),
+													 vshrn_n_u32(vmull_u16(vget_high_u16(bits),vget_high_u16(count)),16));
+				const uint16x8_t value = vbslq_u16(vld1q_u16(mSelect+i),vaddq_u16(vld1q_u16(mLow+i),high),vld1q_u16(mBase+i));
+				const uint8x8_t bytes = vqmovn_u16(value);
+				if(i+RANDOM_PATCH_STEP <= NUM_PARAMS)
+				{
+					vst1_u8(dest+i,bytes);
+				}
+				else
+				{
+					uint8_t tail[RANDOM_PATCH_STEP];
+					vst1_u8(tail,bytes);
+					memcpy(dest+i,tail,NUM_PARAMS-i);
+				}
+			}
+		}
+#else
+		FastRandom lanes[RANDOM_PATCH_LANES];
+		for(int lane=0;lane<RANDOM_PATCH_LANES;lane++)
+		{
+			const uint32 laneState[FAST_RANDOM_STATE_SIZE] = { state[0][lane], state[1][lane], state[2][lane], state[3][lane] };
+			lanes[lane].setState(laneState);
+		}
+		for(int p=0;p<numPatches;p++)
+		{
+			uint8_t* dest = out + p*stride;
+			for(int i=0;i<RANDOM_PATCH_STRIDE;i+=RANDOM_PATCH_STEP)
+			{
+				//lane l gives the 16 bit lanes 2l and 2l+1, low half first
+				uint32 bits[RANDOM_PATCH_STEP];
+				for(int lane=0;lane<RANDOM_PATCH_LANES;lane++)
+				{
+					const uint32 r = lanes[lane].next();
+					bits[2*lane] = r & 0xffff;
+					bits[2*lane+1] = r >> 16;
+				}
+				for(int j=0;j<RANDOM_PATCH_STEP && i+j<NUM_PARAMS;j++)
+				{
+					const int n = i+j;
+					dest[n] = (uint8_t)(mSelect[n] != 0 ? mLow[n] + ((bits[j]*mCount[n])>>16) : mBase[n]);
+				}
+			}
+		}
+#endif
+	};
+
+private:
+	//-----------------------------------------------------------------------
+	class BlockTask : public ParallelTask
+	{
+	public:
+		BlockTask(const RandomPatchGenerator& generator, uint64 seed, uint8_t* out, int numPatches, int stride)
+		: mGenerator(generator),
+		mSeed(seed),
+		mOut(out),
+		mNumPatches(numPatches),
+		mStride(stride)
+		{
+		};
+
+		void run(int begin, int end, int)
+		{
+			for(int block=begin;block<end;block++)
+			{
+				const int first = block*RANDOM_PATCH_BLOCK;
+				mGenerator.generateBlock(mSeed,block,mOut + (size_t)first*mStride,jmin(RANDOM_PATCH_BLOCK,mNumPatches-first),mStride);
+			}
+		};
+
+	private:
+		const RandomPatchGenerator& mGenerator;
+		const uint64 mSeed;
+		uint8_t* const mOut;
+		const int mNumPatches;
+		const int mStride;
+	};
+	//-----------------------------------------------------------------------
+
+	uint16 mLow[RANDOM_PATCH_STRIDE];		// the smallest stored value
+	uint16 mCount[RANDOM_PATCH_STRIDE];		// how many values can be stored, 0 in the padding
+	uint16 mSelect[RANDOM_PATCH_STRIDE];	// 0xffff where the value is drawn, 0 where the base is kept
+	uint16 mBase[RANDOM_PATCH_STRIDE];
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,252 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "./ParameterStore.h"
+#include "./MpscFifo.h"
+#include "./ThreadPriorities.h"
+
+#define JOURNAL_FILE				"session.journal"
+#define JOURNAL_SNAPSHOT_FILE		"session.snapshot"
+#define JOURNAL_MAGIC				0x314a5344	// "DSJ1"
+#define JOURNAL_SNAPSHOT_MAGIC		0x31535344	// "DSS1"
+#define JOURNAL_COMMIT_MS			500		// the edits of this long are written and synced together
+#define JOURNAL_FIFO_SIZE			4096	// edits between two commits, more are taken from a snapshot
+#define JOURNAL_SNAPSHOT_RECORDS	16384	// a journal this long is folded into a new snapshot
+#define JOURNAL_COMMIT_MARKER		0xff	// no parameter has this number
+#define JOURNAL_STOP_TIMEOUT_MS		5000
+
+//---------------------------------------------------------------------------
+/** Keeps the edited sound on disk so it survives a crash of the editor.
+
+	The ParameterStore reports every stored value. valueStored() only puts
+	a record into an MpscFifo, so it can be called from the MIDI thread
+	too and never waits for the disk. Every JOURNAL_COMMIT_MS the thread
+	appends what arrived as one commit and syncs the file once, so a knob
+	drag costs one flush per commit instead of one per step.
+
+	A record is two bytes, the parameter number and the value. A commit
+	ends with JOURNAL_COMMIT_MARKER and the sum of its bytes, a commit
+	that was cut off by a crash fails the check and is ignored. The
+	journal starts from a snapshot of all values, written to a temporary
+	file and renamed. Both carry a generation, once the journal holds
+	JOURNAL_SNAPSHOT_RECORDS records a new snapshot is written and the
+	journal starts over with its generation. A journal that doesn't
+	match the snapshot is already contained in it.
+
+	close() removes both files, so recover() only finds a session that
+	didn't end cleanly.
+*/
+class SessionJournal : public Thread, public ParameterStore::Journal
+{
+public:
+	SessionJournal(const File& directory) : Thread("SessionJournal"),
+		mJournalFile(directory.getChildFile(JOURNAL_FILE)),
+		mSnapshotFile(directory.getChildFile(JOURNAL_SNAPSHOT_FILE)),
+		mFifo(JOURNAL_FIFO_SIZE),
+		mGeneration(0),
+		mNumRecords(0)
+	{
+		memset(mValues,0,NUM_PARAMS);
+		mOverflow.set(0);
+	};
+
+	~SessionJournal()
+	{
+		close();
+	};
+
+	/** the values of a session that didn't end cleanly: the snapshot and the
+		complete commits of the journal on top of it. false if there is none*/
+	bool recover(uint8_t* values)
+	{
+		MemoryBlock snapshot;
+		if(!mSnapshotFile.loadFileAsData(snapshot) || snapshot.getSize() != 8 + NUM_PARAMS) return false;
+
+		const uint8_t* data = (const uint8_t*)snapshot.getData();
+		if(ByteOrder::littleEndianInt(data) != JOURNAL_SNAPSHOT_MAGIC) return false;
+		const int generation = (int)ByteOrder::littleEndianInt(data+4);
+		memcpy(values,data+8,NUM_PARAMS);
+
+		MemoryBlock journal;
+		if(!mJournalFile.loadFileAsData(journal) || journal.getSize() < 8) return true;
+		data = (const uint8_t*)journal.getData();
+		if(ByteOrder::littleEndianInt(data) != JOURNAL_MAGIC || (int)ByteOrder::littleEndianInt(data+4) != generation) return true;
+
+		const int size = (int)journal.getSize();
+		int commitStart = 8;
+		uint8_t sum = 0;
+		for(int pos=8;pos+2<=size;pos+=2)
+		{
+			const uint8_t parameterNr = data[pos];
+			const uint8_t value = data[pos+1];
+			if(parameterNr == JOURNAL_COMMIT_MARKER)
+			{
+				if(value != sum) break;
+				applyCommit(data+commitStart,pos-commitStart,values);
+				commitStart = pos+2;
+				sum = 0;
+				continue;
+			}
+			if(parameterNr >= NUM_PARAMS) break;
+			sum = (uint8_t)(sum + parameterNr + value);
+		}
+		return true;
+	};
+
+	/** writes the snapshot of the current values and starts journaling*/
+	bool start(const uint8_t* values)
+	{
+		memcpy(mValues,values,NUM_PARAMS);
+		if(!writeSnapshot()) return false;
+		startThread(PRIORITY_CLASS_BACKGROUND);
+		return true;
+	};
+
+	/** the last commit is written, then the session is over and its files are deleted*/
+	void close()
+	{
+		signalThreadShouldExit();
+		notify();
+		stopThread(JOURNAL_STOP_TIMEOUT_MS);
+		mOut = NULL;
+		mJournalFile.deleteFile();
+		mSnapshotFile.deleteFile();
+	};
+
+	/** any thread, never blocks*/
+	void valueStored(int parameterNr, int value)
+	{
+		if(!mFifo.push((parameterNr<<8) | (value&0xff))) mOverflow.set(1);
+	};
+
+	void run()
+	{
+		while(!threadShouldExit())
+		{
+			wait(JOURNAL_COMMIT_MS);
+			commit();
+		}
+		commit();
+	};
+
+private:
+	static void applyCommit(const uint8_t* records, int numBytes, uint8_t* values)
+	{
+		for(int i=0;i+2<=numBytes;i+=2)
+		{
+			values[records[i]] = records[i+1];
+		}
+	};
+
+	/** appends what arrived since the last commit and syncs the file*/
+	void commit()
+	{
+		int records[JOURNAL_FIFO_SIZE];
+		const int num = mFifo.read(records,JOURNAL_FIFO_SIZE);
+
+		//edits were lost, the store has them all
+		if(mOverflow.compareAndSetBool(0,1))
+		{
+			ParameterStore::getInstance()->copyValues(mValues);
+			writeSnapshot();
+			return;
+		}
+		if(num == 0) return;
+
+		HeapBlock<uint8_t> data(num*2+2);
+		uint8_t sum = 0;
+		for(int i=0;i<num;i++)
+		{
+			const uint8_t parameterNr = (uint8_t)(records[i]>>8);
+			const uint8_t value = (uint8_t)records[i];
+			mValues[parameterNr] = value;
+			data[i*2] = parameterNr;
+			data[i*2+1] = value;
+			sum = (uint8_t)(sum + parameterNr + value);
+		}
+		data[num*2] = JOURNAL_COMMIT_MARKER;
+		data[num*2+1] = sum;
+
+		//the last snapshot failed, try again with the new values
+		if(mOut == NULL)
+		{
+			writeSnapshot();
+			return;
+		}
+
+		mOut->write(data,num*2+2);
+		mOut->flush();
+		mNumRecords += num;
+		if(mOut->getStatus().failed() || mNumRecords >= JOURNAL_SNAPSHOT_RECORDS) writeSnapshot();
+	};
+
+	/** the values as the next generation, then an empty journal for it*/
+	bool writeSnapshot()
+	{
+		mOut = NULL;
+		mGeneration++;
+		mNumRecords = 0;
+		{
+			TemporaryFile temp(mSnapshotFile);
+			{
+				ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+				if(out == NULL) return false;
+				out->writeInt(JOURNAL_SNAPSHOT_MAGIC);
+				out->writeInt(mGeneration);
+				out->write(mValues,NUM_PARAMS);
+				out->flush();
+				if(out->getStatus().failed()) return false;
+			}
+			if(!temp.overwriteTargetFileWithTemporary()) return false;
+		}
+
+		mJournalFile.deleteFile();
+		mOut = mJournalFile.createOutputStream();
+		if(mOut == NULL) return false;
+		mOut->writeInt(JOURNAL_MAGIC);
+		mOut->writeInt(mGeneration);
+		mOut->flush();
+		return !mOut->getStatus().failed();
+	};
+
+	const File mJournalFile;
+	const File mSnapshotFile;
+	MpscFifo<int> mFifo;	// parameterNr<<8 | value
+	Atomic<int> mOverflow;
+
+	// journal thread only, after start()
+	ScopedPointer<FileOutputStream> mOut;
+	uint8_t mValues[NUM_PARAMS];	// what snapshot and journal add up to
+	int mGeneration;
+	int mNumRecords;				// in the journal since the snapshot
+
+	// (prevent copy constructor and operator= being generated..)
+	SessionJournal (const SessionJournal&);
+	const SessionJournal& operator= (const SessionJournal&);
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+#define SHORT_STRING_CAPACITY	15	// bytes without the terminating 0, every patch name and Markov token fits
+
+//---------------------------------------------------------------------------
+/** A string of up to SHORT_STRING_CAPACITY UTF-8 bytes stored in place.
+
+	Patch names have PATCH_NAME_LENGTH bytes, but a juce String of one is a
+	reference counted heap block. A ShortString is a value that is copied
+	and compared without allocating, so it can be used for names inside the
+	breeding and library loops. Longer text is cut, like names are cut when
+	a patch is saved. toString() makes a juce String for the UI.
+*/
+class ShortString
+{
+public:
+	ShortString() : mLength(0)
+	{
+		mText[0] = 0;
+	};
+
+	/** copies text up to its 0 or maxLength bytes, whichever comes first*/
+	ShortString(const char* text, int maxLength = SHORT_STRING_CAPACITY) : mLength(0)
+	{
+		mText[0] = 0;
+		append(text,maxLength);
+	};
+
+	explicit ShortString(const String& text)
+	{
+		text.copyToUTF8(mText,SHORT_STRING_CAPACITY+1);
+		mLength = (uint8)strlen(mText);
+	};
+
+	int length() const
+	{
+		return mLength;
+	};
+
+	bool isEmpty() const
+	{
+		return mLength == 0;
+	};
+
+	/** 0 terminated*/
+	const char* getText() const
+	{
+		return mText;
+	};
+
+	char operator[] (int index) const
+	{
+		jassert(isPositiveAndBelow(index,(int)mLength + 1));
+		return mText[index];
+	};
+
+	void clear()
+	{
+		mLength = 0;
+		mText[0] = 0;
+	};
+
+	/** appends up to maxLength bytes of text, as many as still fit*/
+	void append(const char* text, int maxLength = SHORT_STRING_CAPACITY)
+	{
+		for(int i=0;i<maxLength && text[i] != 0 && mLength < SHORT_STRING_CAPACITY;i++)
+		{
+			mText[mLength++] = text[i];
+		}
+		mText[mLength] = 0;
+	};
+
+	bool operator== (const ShortString& other) const
+	{
+		return mLength == other.mLength && memcmp(mText,other.mText,mLength) == 0;
+	};
+
+	bool operator!= (const ShortString& other) const
+	{
+		return !operator==(other);
+	};
+
+	/** byte order, for sorting*/
+	bool operator< (const ShortString& other) const
+	{
+		return strcmp(mText,other.mText) < 0;
+	};
+
+	String toString() const
+	{
+		return String::fromUTF8(mText,mLength);
+	};
+
+private:
+	char mText[SHORT_STRING_CAPACITY+1];
+	uint8 mLength;
+};
+//---------------------------------------------------------------------------
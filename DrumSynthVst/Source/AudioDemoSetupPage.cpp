@@ -47,6 +47,10 @@
 //[/Headers]
 
 #include "AudioDemoSetupPage.h"
+#include "../Midi/MidiTransmitter.h"
+#include "../Midi/MidiOutputRouter.h"
+#include "../StartupLoader.h"
+#include "../WindowRenderer.h"
 
 
 //[MiscUserDefs] You can add your own user definitions and misc code here...
@@ -58,7 +62,7 @@ AudioDemoSetupPage::AudioDemoSetupPage (AudioDeviceManager& deviceManager_)
     : deviceManager (deviceManager_),
       deviceSelector (0)
 {
-    addAndMakeVisible (deviceSelector = new AudioDeviceSelectorComponent (deviceManager, 0, 0, 0, 0, true, true, true, false));
+    addAndMakeVisible (deviceSelector = new AudioDeviceSelectorComponent (deviceManager, 0, 0, 0, 2, true, true, true, false));
 
 
     //[UserPreSize]
@@ -110,14 +114,23 @@ void AudioDemoSetupPage::changeListenerCallback (ChangeBroadcaster *source)
 {
 	//set the global midi output
 	AudioDemoSetupPage::globalMidiOut = 	((AudioDeviceManager*)source)->getDefaultMidiOutput () ;
+	MidiTransmitter::getInstance()->setMidiOutput(AudioDemoSetupPage::globalMidiOut);
+	saveConfig(*((AudioDeviceManager*)source));
+}
+
+void AudioDemoSetupPage::saveConfig(AudioDeviceManager& deviceManager)
+{
 	//write settings to xml file
-	XmlElement* xml = ((AudioDeviceManager*)source)->createStateXml();
-	if(xml)
+	XmlElement* xml = deviceManager.createStateXml();
+	if(xml == NULL)
 	{
-		xml->writeToFile(File(File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getFullPathName() + String("/midi.cfg")),String::empty);
-		deleteAndZero(xml);
+		//nothing selected yet, the renderer is saved anyway
+		xml = new XmlElement("DEVICESETUP");
 	}
-
+	WindowRenderer::getInstance()->saveToConfig(*xml);
+	MidiOutputRouter::getInstance()->saveToConfig(*xml);
+	xml->writeToFile(StartupLoader::getMidiConfigFile(),String::empty);
+	deleteAndZero(xml);
 }
 //[/MiscUserCode]
 
@@ -138,7 +151,7 @@ BEGIN_JUCER_METADATA
   <BACKGROUND backgroundColour="ffd3d3d3"/>
   <GENERICCOMPONENT name="" id="a04c56de9f3fc537" memberName="deviceSelector" virtualName=""
                     explicitFocusOrder="0" pos="8 8 16M 16M" class="AudioDeviceSelectorComponent"
-                    params="deviceManager, 0, 2, 0, 2, true, true, true, false"/>
+                    params="deviceManager, 0, 0, 0, 2, true, true, true, false"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -73,6 +73,8 @@ public:
     //[UserMethods]     -- You can add your own custom methods in this section.
 	static MidiOutput * globalMidiOut;
 	void changeListenerCallback (ChangeBroadcaster *source);
+	/** writes the device setup and the renderer choice to midi.cfg*/
+	static void saveConfig(AudioDeviceManager& deviceManager);
     //[/UserMethods]
 
     void paint (Graphics& g);
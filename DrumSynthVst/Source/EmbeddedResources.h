@@ -0,0 +1,52 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+//---------------------------------------------------------------------------
+/** Data that is compiled into the editor, so nothing has to be found next to
+	the executable or in the working directory.
+
+	knob_png			the film strip of GreenLookAndFeel
+	namelist_smm		resources/namelist.txt compiled by Markov (see MarkovModel)
+	_3wordNamelist_txt	the 3 letter words of the NameModel
+
+	namelist_smm has to be replaced when namelist.txt changes. A model of an
+	older MARKOV_MODEL_VERSION doesn't open, then the editor learns the list
+	at startup as before and writes resources/namelist.smm, which is the file
+	to embed.
+*/
+class EmbeddedResources
+{
+public:
+	static const char* knob_png;
+	static const int knob_pngSize;
+
+	static const char* namelist_smm;
+	static const int namelist_smmSize;
+
+	static const char* _3wordNamelist_txt;
+	static const int _3wordNamelist_txtSize;
+};
+//---------------------------------------------------------------------------
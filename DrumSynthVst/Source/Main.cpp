@@ -25,9 +25,13 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
-#include "VoiceBasedDrumComponent.h"
 #include "MainTabbedComponent.h"
 #include "..\PatchGeneratorWindow.h"
+#include "../StartupLoader.h"
+#include "../StartupProfiler.h"
+#include "Singletons.h"
+#include "../WindowRenderer.h"
+#include "../TelemetryServer.h"
 
 //==============================================================================
 /**
@@ -95,8 +99,32 @@ public:
     //==============================================================================
     void initialise (const String& commandLine)
     {
+		StartupProfiler::end(STARTUP_JUCE_INIT);
+#if TRACE_ENABLED
+		//-trace records from the start, to see how the startup work overlaps
+		if(commandLine.contains("-trace"))
+		{
+			Tracer::getInstance()->setRecording(true);
+			PaintProfiler::getInstance()->setTracePaints(true);
+		}
+#endif
+		//-telemetry <port> answers the health counters to the monitoring of the studio
+		StringArray args;
+		args.addTokens(commandLine,true);
+		const int telemetry = args.indexOf("-telemetry");
+		if(telemetry >= 0 && !TelemetryServer::getInstance()->start(args[telemetry+1].getIntValue()))
+		{
+			Logger::writeToLog("telemetry port " + args[telemetry+1] + " could not be opened");
+		}
+		TRACE_SCOPE("startup","initialise");
+
+        //the resources load while the windows are built, the windows are told when they are ready
+        StartupLoader::getInstance()->start();
+
         // For this demo, we'll just create the main window...
         helloWorldWindow = new HelloWorldWindow();
+        //software until midi.cfg is read, see MainComponent::startupResourceReady()
+        WindowRenderer::getInstance()->setWindow(helloWorldWindow);
 
         /*  ..and now return, which will fall into to the main event
             dispatch loop, and this will run until something calls
@@ -106,7 +134,10 @@ public:
             hello world window being clicked.
         */
 
+		{
+		const ScopedStartupPhase startupPhase(STARTUP_PATCH_GENERATOR);
 		patchGeneratorWindow = new PatchGeneratorWindow();
+		}
     }
 
     void shutdown()
@@ -115,9 +146,14 @@ public:
 
         // The helloWorldWindow variable is a ScopedPointer, so setting it to a null
         // pointer will delete the window.
+        WindowRenderer::getInstance()->setWindow(0);
         helloWorldWindow = 0;
 
 		patchGeneratorWindow = 0;
+
+		//phases that never ended are listed as running
+		Logger::writeToLog(StartupProfiler::getSummary());
+		deleteSingletons();
     }
 
     //==============================================================================
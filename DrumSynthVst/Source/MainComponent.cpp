@@ -54,8 +54,12 @@
 
 //==============================================================================
 MainComponent::MainComponent ()
-    : mTabbedComponent (0)
+    : mMidiDiagnostics (mDeviceManager),
+      mMidiOutputs (mDeviceManager),
+      mTabbedComponent (0)
 {
+	TRACE_SCOPE("startup","MainComponent");
+	const ScopedStartupPhase startupPhase(STARTUP_MAIN_COMPONENT);
     addAndMakeVisible (mTabbedComponent = new MainTabComponent());
     mTabbedComponent->setName (L"new component");
 
@@ -73,32 +77,39 @@ MainComponent::MainComponent ()
 	mCommandManager = new ApplicationCommandManager();
 	mCommandManager->registerAllCommandsForTarget(this);
 	mCommandManager->registerAllCommandsForTarget (JUCEApplication::getInstance());
+	//the default key presses of the commands, e.g. undo
+	addKeyListener(mCommandManager->getKeyMappings());
 
 
 	mMidiSetupPage = new AudioDemoSetupPage(mDeviceManager);
 
 	mDeviceManager.addChangeListener(mMidiSetupPage);
 
-//	mDeviceManager.addMidiInputCallback (String::empty, mArpEditorComponent);
+	//values changed on the synth end up in the ParameterStore
+	mDeviceManager.addMidiInputCallback (String::empty, &mMidiInputParser);
 
-	File xmlFile(File(File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getFullPathName() + String("/midi.cfg")));
-	if(xmlFile.exists())
-	{
-		XmlDocument xmlDoc(xmlFile);
-		XmlElement* xml = xmlDoc.getDocumentElement();
+	//the software preview plays on the audio output chosen in the MIDI setup
+	mDeviceManager.addAudioCallback(PreviewEngine::getInstance());
 
-		mDeviceManager.initialise(0,0,xml,true);
-		AudioDemoSetupPage::globalMidiOut = 	mDeviceManager.getDefaultMidiOutput () ;
-		if(AudioDemoSetupPage::globalMidiOut == NULL) {
-			DialogWindow::showDialog("MIDI Setup",mMidiSetupPage,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
-		}
-		deleteAndZero(xml);
-	} else {
-		if(AudioDemoSetupPage::globalMidiOut == NULL) {
-			DialogWindow::showDialog("MIDI Setup",mMidiSetupPage,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+	//the sound of a session that crashed comes back, the synth still has it
+	ParameterStore* store = ParameterStore::getInstance();
+	mJournal = new SessionJournal(File::getSpecialLocation(File::currentApplicationFile).getParentDirectory());
+	uint8_t recovered[NUM_PARAMS];
+	if(mJournal->recover(recovered))
+	{
+		Patch patch;
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			patch.setParameter(i,recovered[i]);
 		}
-	
+		store->loadFromPatch(&patch,false);
 	}
+	if(mJournal->start(store->getValues())) store->setJournal(mJournal);
+
+	//midi.cfg is read, knob.png decoded and the fonts measured in the background, see startupResourceReady()
+	StartupLoader::getInstance()->addListener(this);
+
+	addChildComponent(&mPaintProfilerOverlay);
 
 
 
@@ -108,6 +119,17 @@ MainComponent::MainComponent ()
 MainComponent::~MainComponent()
 {
     //[Destructor_pre]. You can add your own custom destruction code here..
+	PaintProfiler::getInstance()->setEnabled(false);
+	removeKeyListener(mCommandManager->getKeyMappings());
+	StartupLoader::getInstance()->removeListener(this);
+	mDeviceVerifier.stop();
+	mDeviceManager.removeMidiInputCallback (String::empty, &mMidiInputParser);
+	mDeviceManager.removeAudioCallback(PreviewEngine::getInstance());
+	//a clean exit leaves nothing to recover
+	ParameterStore::getInstance()->setJournal(NULL);
+	mJournal->close();
+	//the device manager deletes the midi output, so the transmit thread must let go of it first
+	MidiTransmitter::getInstance()->setMidiOutput(NULL);
     //[/Destructor_pre]
 
     deleteAndZero (mTabbedComponent);
@@ -133,12 +155,52 @@ void MainComponent::resized()
 {
     mTabbedComponent->setBounds (0, 40, proportionOfWidth (1.0000f), 650);
     //[UserResized] Add your own custom resize handling here..
+	mPaintProfilerOverlay.setTopRightPosition(getWidth()-4,44);
     //[/UserResized]
 }
 
 
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void MainComponent::startupResourceReady(int resource)
+{
+	StartupLoader* loader = StartupLoader::getInstance();
+
+	if(resource == RESOURCE_KNOB_IMAGE)
+	{
+		((GreenLookAndFeel*)(LookAndFeel*)mLookAndFeel)->setSliderImage(loader->getKnobImage(),31,false);
+		StartupProfiler::end(STARTUP_KNOB_IMAGE);
+		repaint();
+	}
+	else if(resource == RESOURCE_GLYPHS)
+	{
+		((GreenLookAndFeel*)(LookAndFeel*)mLookAndFeel)->setGlyphMetrics(loader->getGlyphMetrics());
+	}
+	else if(resource == RESOURCE_MIDI_CONFIG)
+	{
+		StartupProfiler::begin(STARTUP_DEVICE_INIT);
+		WindowRenderer::getInstance()->loadFromConfig(loader->getMidiConfig());
+		//without a config the default audio output is opened, so the preview works before the first setup
+		mDeviceManager.initialise(0,2,loader->getMidiConfig(),true);
+		if(loader->getMidiConfig() != NULL)
+		{
+			AudioDemoSetupPage::globalMidiOut = 	mDeviceManager.getDefaultMidiOutput () ;
+			MidiTransmitter::getInstance()->setMidiOutput(AudioDemoSetupPage::globalMidiOut);
+		}
+		MidiOutputRouter::getInstance()->loadFromConfig(loader->getMidiConfig());
+		StartupProfiler::end(STARTUP_DEVICE_INIT);
+		if(AudioDemoSetupPage::globalMidiOut == NULL) {
+			DialogWindow::showDialog("MIDI Setup",mMidiSetupPage,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+		}
+	}
+}
+
+void MainComponent::deviceVerified(DeviceVerifier* verifier)
+{
+	mCommandManager->commandStatusChanged();
+	const bool same = verifier->getResult() == DeviceVerifier::RESULT_SAME || verifier->getResult() == DeviceVerifier::RESULT_REPAIRED;
+	AlertWindow::showMessageBox(same ? AlertWindow::InfoIcon : AlertWindow::WarningIcon,"Verify Synth",verifier->getDescription());
+}
 //[/MiscUserCode]
 
 
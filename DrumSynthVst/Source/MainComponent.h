@@ -50,8 +50,30 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainTabbedComponent.h"
 #include "AudioDemoSetupPage.h"
+#include "../Midi/MidiTransmitter.h"
+#include "../Midi/MidiInputParser.h"
+#include "../Midi/DeviceVerifier.h"
+#include "../Midi/MidiDiagnosticsComponent.h"
+#include "../Midi/MidiMonitorComponent.h"
+#include "../Midi/MidiOutputsComponent.h"
+#include "../Midi/RemoteEditComponent.h"
+#include "../PresetFileJob.h"
 #include "AboutScreen.h"
 #include "../GreenLookAndFeel.h"
+#include "../StartupLoader.h"
+#include "../StartupProfiler.h"
+#include "../WindowRenderer.h"
+#include "../PaintProfiler.h"
+#include "../Preview/PreviewEngine.h"
+#include "../Midi/EditRecorder.h"
+#include "../Midi/MidiFileExport.h"
+#include "../Midi/EditReplay.h"
+#include "../MorphComponent.h"
+#include "../XyMorphComponent.h"
+#include "../MacroComponent.h"
+#include "../VoiceClipboard.h"
+#include "../Library/PatchBrowserComponent.h"
+#include "../SessionJournal.h"
 //[/Headers]
 
 
@@ -67,7 +89,9 @@
 class MainComponent  : public Component,
                        public MenuBarModel,
                        public ApplicationCommandTarget,
-                       public TextEditor::Listener
+                       public TextEditor::Listener,
+                       public StartupLoader::Listener,
+                       public DeviceVerifier::Listener
 {
 public:
     //==============================================================================
@@ -77,6 +101,12 @@ public:
     //==============================================================================
     //[UserMethods]     -- You can add your own custom methods in this section.
 
+	/** the knob images and the midi setup arrive after the window is shown*/
+	void startupResourceReady(int resource);
+
+	/** the answer to verifySynth*/
+	void deviceVerified(DeviceVerifier* verifier);
+
 	//----- command target
 	ApplicationCommandTarget* getNextCommandTarget()
     {
@@ -88,7 +118,7 @@ public:
     void getAllCommands (Array <CommandID>& commands)
     {
         // this returns the set of all commands that this target can perform..
-        const CommandID ids[] = {  showMidiSettings ,saveFile,saveFileAs,newFile,openFile,showAboutScreen};
+        const CommandID ids[] = {  showMidiSettings ,saveFile,saveFileAs,newFile,openFile,showAboutScreen,showMidiDiagnostics,showMidiMonitor,useDirect2D,showPaintProfiler,savePaintProfile,previewSound,autoPreview,playPattern,followClock,recordEdits,exportEdits,exportGroove,undoEdit,redoEdit,recordTrace,saveTrace,showStartupTimes,saveEditSession,morphSound,xyMorphSound,showMidiOutputs,showRemoteEditing,showPatchBrowser,verifySynth,showMacros,copyVoice,pasteVoice,swapVoice};
 
         commands.addArray (ids, numElementsInArray (ids));
     }
@@ -112,6 +142,55 @@ public:
            	result.setInfo ("Save File", "save preset to a file","file", 0);
             break;
 
+		case undoEdit:
+           	result.setInfo ("Undo", "undo the last edit or patch load","file", 0);
+			result.setActive(ParameterStore::getInstance()->canUndo());
+			result.addDefaultKeypress('z', ModifierKeys::commandModifier);
+            break;
+
+		case showRemoteEditing:
+           	result.setInfo ("Remote Editing", "edit the synths of another machine over the network","settings", 0);
+            break;
+
+		case showMidiOutputs:
+           	result.setInfo ("MIDI Outputs", "send the edits to more synths","settings", 0);
+            break;
+
+		case showPatchBrowser:
+           	result.setInfo ("Browse Library...", "audition the patches of a library","file", 0);
+            break;
+
+		case morphSound:
+           	result.setInfo ("Morph...", "morph the sound towards another preset","file", 0);
+            break;
+
+		case xyMorphSound:
+           	result.setInfo ("XY Morph...", "blend the sound between four presets on a pad","file", 0);
+            break;
+
+		case showMacros:
+           	result.setInfo ("Macros...", "knobs that move many parameters at once","file", 0);
+            break;
+
+		case copyVoice:
+           	result.setInfo (String("Copy ") + voiceNames[mTabbedComponent->getCurrentVoice()], "copy the settings of the shown voice","file", 0);
+            break;
+
+		case pasteVoice:
+           	result.setInfo (String("Paste ") + (mVoiceClipboard.canPaste() ? voiceNames[mVoiceClipboard.getVoice()] : "Voice") + " to " + voiceNames[mTabbedComponent->getCurrentVoice()], "set the shown voice to the copied settings","file", 0);
+			result.setActive(mVoiceClipboard.canPaste());
+            break;
+
+		case swapVoice:
+           	result.setInfo (String("Swap ") + voiceNames[mTabbedComponent->getCurrentVoice()] + " With...", "exchange the settings of the shown voice and another one","file", 0);
+            break;
+
+		case redoEdit:
+           	result.setInfo ("Redo", "redo the last undone edit","file", 0);
+			result.setActive(ParameterStore::getInstance()->canRedo());
+			result.addDefaultKeypress('z', ModifierKeys::commandModifier|ModifierKeys::shiftModifier);
+            break;
+
 		case saveFileAs:
            	result.setInfo ("Save File As", "save preset to a new file","file", 0);
             break;
@@ -124,6 +203,90 @@ public:
            	result.setInfo ("About", "show info screen","info", 0);
             break;
 
+		case verifySynth:
+           	result.setInfo ("Verify Synth", "read the sound back from the synth and send again what differs","settings", 0);
+			result.setActive(!mDeviceVerifier.isRunning());
+            break;
+
+		case showMidiDiagnostics:
+           	result.setInfo ("MIDI Diagnostics", "show MIDI latency and queue statistics","settings", 0);
+            break;
+
+		case showMidiMonitor:
+           	result.setInfo ("MIDI Monitor", "list the MIDI messages sent and received","settings", 0);
+            break;
+
+		case useDirect2D:
+           	result.setInfo ("Direct2D Renderer", "draw the window with Direct2D instead of the software renderer","settings", 0);
+			result.setActive(WindowRenderer::getInstance()->isDirect2DAvailable());
+			result.setTicked(WindowRenderer::getInstance()->isUsingDirect2D());
+            break;
+
+		case showPaintProfiler:
+           	result.setInfo ("Paint Profiler", "show the paint time of the components","settings", 0);
+			result.setTicked(PaintProfiler::getInstance()->isEnabled());
+            break;
+
+		case savePaintProfile:
+           	result.setInfo ("Save Paint Profile...", "write the paint times to a text file","settings", 0);
+			result.setActive(PaintProfiler::getInstance()->isEnabled());
+            break;
+
+		case recordTrace:
+           	result.setInfo ("Record Trace", "record the timed scopes of all threads, needs a build with TRACE_ENABLED","settings", 0);
+			result.setActive(TRACE_ENABLED != 0);
+			result.setTicked(Tracer::getInstanceWithoutCreating() != NULL && Tracer::getInstance()->isRecording());
+            break;
+
+		case saveTrace:
+           	result.setInfo ("Save Trace...", "write the recorded trace for chrome://tracing or Perfetto","settings", 0);
+			result.setActive(Tracer::getInstanceWithoutCreating() != NULL);
+            break;
+
+		case showStartupTimes:
+           	result.setInfo ("Startup Times", "show how long each startup phase took","settings", 0);
+            break;
+
+		case previewSound:
+           	result.setInfo ("Play Sound", "play the current sound on the computer's audio output","preview", 0);
+			result.setActive(mDeviceManager.getCurrentAudioDevice() != NULL);
+            break;
+
+		case autoPreview:
+           	result.setInfo ("Play Generated Patches", "play every patch of the generator on the computer's audio output","preview", 0);
+			result.setTicked(PreviewEngine::getInstance()->getAutoPreview());
+            break;
+
+		case playPattern:
+           	result.setInfo ("Play Pattern", "loop a groove with the current sound on the computer's audio output","preview", 0);
+			result.setActive(mDeviceManager.getCurrentAudioDevice() != NULL);
+			result.setTicked(PreviewEngine::getInstance()->isPatternPlaying());
+            break;
+
+		case followClock:
+           	result.setInfo ("Follow MIDI Clock", "play the pattern and the generated patches in time with the MIDI clock","preview", 0);
+			result.setTicked(PreviewEngine::getInstance()->isFollowingClock());
+            break;
+
+		case recordEdits:
+           	result.setInfo ("Record Edits", "record the parameter changes for a MIDI file or a replay","file", 0);
+			result.setTicked(mEditRecorder.isRecording());
+            break;
+
+		case exportEdits:
+           	result.setInfo ("Export Recorded Edits as MIDI File...", "write the recorded parameter changes to a MIDI file","file", 0);
+			result.setActive(mEditRecorder.getNumEdits() > 0);
+            break;
+
+		case saveEditSession:
+           	result.setInfo ("Save Recorded Edits for Replay...", "write the recorded knob edits for the replay of DrumSynthBenchmark","file", 0);
+			result.setActive(UiEditRecorder::getInstance()->getSession().getNumEdits() > 0);
+            break;
+
+		case exportGroove:
+           	result.setInfo ("Export Pattern as MIDI File...", "write the groove of the preview to a MIDI file","preview", 0);
+            break;
+
         default:
             break;
         };
@@ -143,20 +306,234 @@ public:
 			DialogWindow::showDialog("MIDI Setup",mMidiSetupPage,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
             break;
 
+		case showMidiDiagnostics:
+			DialogWindow::showDialog("MIDI Diagnostics",&mMidiDiagnostics,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+			break;
+
+		case showMidiMonitor:
+			DialogWindow::showDialog("MIDI Monitor",&mMidiMonitor,this,findColour(DocumentWindow::backgroundColourId),true,true,false);
+			break;
+
+		case verifySynth:
+			mDeviceVerifier.start(mMidiInputParser,this);
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case showRemoteEditing:
+			DialogWindow::showDialog("Remote Editing",&mRemoteEditComponent,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+			break;
+
+		case showMidiOutputs:
+			DialogWindow::showDialog("MIDI Outputs",&mMidiOutputs,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+			break;
+
+		case showPatchBrowser:
+			DialogWindow::showDialog("Patch Browser",&mPatchBrowser,this,findColour(DocumentWindow::backgroundColourId),true,true,false);
+			break;
+
+		case morphSound:
+			DialogWindow::showDialog("Morph",&mMorphComponent,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+			break;
+
+		case xyMorphSound:
+			DialogWindow::showDialog("XY Morph",&mXyMorphComponent,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+			break;
+
+		case showMacros:
+			DialogWindow::showDialog("Macros",&mMacroComponent,this,findColour(DocumentWindow::backgroundColourId),true,false,false);
+			break;
+
+		case useDirect2D:
+			WindowRenderer::getInstance()->setUseDirect2D(!WindowRenderer::getInstance()->isUsingDirect2D());
+			AudioDemoSetupPage::saveConfig(mDeviceManager);
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case showPaintProfiler:
+			PaintProfiler::getInstance()->setEnabled(!PaintProfiler::getInstance()->isEnabled());
+			mPaintProfilerOverlay.setVisible(PaintProfiler::getInstance()->isEnabled());
+			mPaintProfilerOverlay.toFront(false);
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case savePaintProfile:
+			{
+			//the summary is taken before the dialog adds its own frames
+			const String summary = PaintProfiler::getInstance()->getSummary();
+			FileChooser chooser("Save paint profile",File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("paintprofile.txt"),"*.txt");
+			if(chooser.browseForFileToSave(true))
+			{
+				chooser.getResult().replaceWithText(summary);
+			}
+			}
+			break;
+
+		case recordTrace:
+			{
+			const bool record = !Tracer::getInstance()->isRecording();
+			Tracer::getInstance()->setRecording(record);
+			PaintProfiler::getInstance()->setTracePaints(record);
+			mCommandManager->commandStatusChanged();
+			}
+			break;
+
+		case saveTrace:
+			{
+			//the trace keeps recording, the events overwritten while it is written are left out
+			FileChooser chooser("Save trace",File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("trace.json"),"*.json");
+			if(chooser.browseForFileToSave(true))
+			{
+				Tracer::getInstance()->writeJson(chooser.getResult());
+			}
+			}
+			break;
+
+		case showStartupTimes:
+			Logger::writeToLog(StartupProfiler::getSummary());
+			AlertWindow::showMessageBox(AlertWindow::InfoIcon,"Startup Times",StartupProfiler::getSummary());
+			break;
+
+		case previewSound:
+			PreviewEngine::getInstance()->playSound();
+			break;
+
+		case autoPreview:
+			PreviewEngine::getInstance()->setAutoPreview(!PreviewEngine::getInstance()->getAutoPreview());
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case playPattern:
+			PreviewEngine::getInstance()->setPatternPlaying(!PreviewEngine::getInstance()->isPatternPlaying());
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case followClock:
+			PreviewEngine::getInstance()->setFollowClock(!PreviewEngine::getInstance()->isFollowingClock());
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case undoEdit:
+			ParameterStore::getInstance()->undo();
+			break;
+
+		case redoEdit:
+			ParameterStore::getInstance()->redo();
+			break;
+
+		case copyVoice:
+			mVoiceClipboard.copy(mTabbedComponent->getCurrentVoice());
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case pasteVoice:
+			mVoiceClipboard.paste(mTabbedComponent->getCurrentVoice());
+			break;
+
+		case swapVoice:
+			{
+			const int voiceNr = mTabbedComponent->getCurrentVoice();
+			PopupMenu menu;
+			for(int v=0;v<NUM_VOICES;v++)
+			{
+				menu.addItem(v+1,voiceNames[v],v != voiceNr);
+			}
+			const int result = menu.show();
+			if(result > 0) VoiceClipboard::swap(voiceNr,result-1);
+			}
+			break;
+
+		case recordEdits:
+			if(mEditRecorder.isRecording())
+			{
+				mEditRecorder.stop();
+				UiEditRecorder::getInstance()->stop();
+			}
+			else
+			{
+				mEditRecorder.start();
+				UiEditRecorder::getInstance()->start();
+			}
+			mCommandManager->commandStatusChanged();
+			break;
+
+		case exportEdits:
+			{
+			mEditRecorder.stop();
+			mCommandManager->commandStatusChanged();
+			FileChooser chooser("Export recorded edits",getMidiFileDefault(),"*.mid");
+			if(chooser.browseForFileToSave(true))
+			{
+				if(!MidiFileExport::writeEdits(mEditRecorder,chooser.getResult().withFileExtension(".mid")))
+				{
+					AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Export failed","The MIDI file could not be written.");
+				}
+			}
+			}
+			break;
+
+		case saveEditSession:
+			{
+			mEditRecorder.stop();
+			UiEditRecorder::getInstance()->stop();
+			mCommandManager->commandStatusChanged();
+			FileChooser chooser("Save recorded edits",getMidiFileDefault().withFileExtension(EDIT_SESSION_EXTENSION),"*" EDIT_SESSION_EXTENSION);
+			if(chooser.browseForFileToSave(true))
+			{
+				if(!UiEditRecorder::getInstance()->getSession().save(chooser.getResult().withFileExtension(EDIT_SESSION_EXTENSION)))
+				{
+					AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Save failed","The recorded edits could not be written.");
+				}
+			}
+			}
+			break;
+
+		case exportGroove:
+			{
+			const uint8_t* values = ParameterStore::getInstance()->getValues();
+			Pattern pattern;
+			MidiFileExport::getPreviewPattern(values,pattern);
+			const int bpm = values[PAR_BPM] > 0 ? values[PAR_BPM] : PREVIEW_SEQUENCER_DEFAULT_BPM;
+
+			FileChooser chooser("Export pattern",getMidiFileDefault(),"*.mid");
+			if(chooser.browseForFileToSave(true))
+			{
+				if(!MidiFileExport::writePattern(pattern,bpm,1,chooser.getResult().withFileExtension(".mid")))
+				{
+					AlertWindow::showMessageBox(AlertWindow::WarningIcon,"Export failed","The MIDI file could not be written.");
+				}
+			}
+			}
+			break;
+
 		case openFile:
-		//	this->mArpEditorComponent->loadFromUserSpecifiedFile(true);
+			{
+			FileChooser chooser("Open preset",mCurrentFile,"*.snd");
+			if(chooser.browseForFileToOpen())
+			{
+				runPresetJob(PresetFileJob::LOAD_PRESET,chooser.getResult());
+			}
+			}
 			break;
 
 		case saveFile:
-		//	this->mArpEditorComponent->save(true,true);
-            break;
-
+			if(mCurrentFile.existsAsFile())
+			{
+				runPresetJob(PresetFileJob::SAVE_PRESET,mCurrentFile);
+				break;
+			}
+			//no file yet, ask for one
 		case saveFileAs:
-		//	this->mArpEditorComponent->saveAsInteractive(true);
+			{
+			FileChooser chooser("Save preset",mCurrentFile,"*.snd");
+			if(chooser.browseForFileToSave(true))
+			{
+				runPresetJob(PresetFileJob::SAVE_PRESET,chooser.getResult().withFileExtension(".SND"));
+			}
+			}
             break;
 
 		case newFile:
-          // 	this->mArpEditorComponent->init();
+			runPresetJob(PresetFileJob::NEW_PRESET,File::nonexistent);
             break;
 
 
@@ -175,12 +552,40 @@ public:
 		newFile							= 0x2003,
 		openFile						= 0x2004,
 		showAboutScreen					= 0x2005,
+		showMidiDiagnostics				= 0x2006,
+		useDirect2D						= 0x2007,
+		showPaintProfiler				= 0x2008,
+		savePaintProfile				= 0x2009,
+		previewSound					= 0x200a,
+		autoPreview						= 0x200b,
+		playPattern						= 0x200c,
+		recordEdits						= 0x200d,
+		exportEdits						= 0x200e,
+		exportGroove					= 0x200f,
+		followClock						= 0x2010,
+		undoEdit						= 0x2011,
+		redoEdit						= 0x2012,
+		recordTrace						= 0x2013,
+		saveTrace						= 0x2014,
+		showStartupTimes				= 0x2015,
+		saveEditSession					= 0x2016,
+		morphSound						= 0x2017,
+		showMidiOutputs					= 0x2018,
+		showRemoteEditing				= 0x2019,
+		showPatchBrowser				= 0x201a,
+		verifySynth						= 0x201b,
+		showMacros						= 0x201c,
+		copyVoice						= 0x201d,
+		pasteVoice						= 0x201e,
+		swapVoice						= 0x201f,
+		xyMorphSound					= 0x2020,
+		showMidiMonitor					= 0x2021,
 
     };
 
 	const StringArray getMenuBarNames()
     {
-        const char* const names[] = { "File", "Settings","About", 0 };
+        const char* const names[] = { "File", "Settings","Preview","About", 0 };
 
         return StringArray (names);
     }
@@ -195,16 +600,52 @@ public:
         {
 			 menu.addCommandItem (commandManager, newFile);
 			 menu.addCommandItem (commandManager, openFile);
+			 menu.addCommandItem (commandManager, showPatchBrowser);
 			 menu.addCommandItem (commandManager, saveFile);
 			 menu.addCommandItem (commandManager, saveFileAs);
+            menu.addSeparator();
+			 menu.addCommandItem (commandManager, undoEdit);
+			 menu.addCommandItem (commandManager, redoEdit);
+			 menu.addCommandItem (commandManager, morphSound);
+			 menu.addCommandItem (commandManager, xyMorphSound);
+			 menu.addCommandItem (commandManager, showMacros);
+            menu.addSeparator();
+			 menu.addCommandItem (commandManager, copyVoice);
+			 menu.addCommandItem (commandManager, pasteVoice);
+			 menu.addCommandItem (commandManager, swapVoice);
+            menu.addSeparator();
+			 menu.addCommandItem (commandManager, recordEdits);
+			 menu.addCommandItem (commandManager, exportEdits);
+			 menu.addCommandItem (commandManager, saveEditSession);
             menu.addSeparator();
             menu.addCommandItem (commandManager, StandardApplicationCommandIDs::quit);
         }
         else if (menuIndex == 1)
         {
              menu.addCommandItem (commandManager, showMidiSettings);
+             menu.addCommandItem (commandManager, showMidiOutputs);
+             menu.addCommandItem (commandManager, showRemoteEditing);
+             menu.addCommandItem (commandManager, showMidiDiagnostics);
+             menu.addCommandItem (commandManager, showMidiMonitor);
+             menu.addCommandItem (commandManager, verifySynth);
+             menu.addCommandItem (commandManager, useDirect2D);
+             menu.addSeparator();
+             menu.addCommandItem (commandManager, showPaintProfiler);
+             menu.addCommandItem (commandManager, savePaintProfile);
+             menu.addCommandItem (commandManager, recordTrace);
+             menu.addCommandItem (commandManager, saveTrace);
+             menu.addCommandItem (commandManager, showStartupTimes);
         }
 		else if(menuIndex == 2)
+		{
+			menu.addCommandItem(commandManager, previewSound);
+			menu.addCommandItem(commandManager, autoPreview);
+			menu.addSeparator();
+			menu.addCommandItem(commandManager, playPattern);
+			menu.addCommandItem(commandManager, followClock);
+			menu.addCommandItem(commandManager, exportGroove);
+		}
+		else if(menuIndex == 3)
 		{
 			menu.addCommandItem(commandManager, showAboutScreen);
 		}
@@ -218,6 +659,29 @@ public:
         // other special cases here..
     }
 
+	/** next to the current preset, in the documents folder for a new sound*/
+	const File getMidiFileDefault() const
+	{
+		if(mCurrentFile == File::nonexistent) return File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("drumsynth.mid");
+		return mCurrentFile.withFileExtension(".mid");
+	};
+
+	/** file I/O and the transfer to the synth run on the job thread, the editor keeps painting meanwhile*/
+	void runPresetJob(int jobType, const File& file)
+	{
+		PresetFileJob job(jobType,file);
+		const bool finished = job.runThread();
+
+		if(job.succeeded())
+		{
+			mCurrentFile = file;
+		}
+		else if(finished)
+		{
+			AlertWindow::showMessageBox(AlertWindow::WarningIcon,"File error","Couldn't access " + file.getFullPathName());
+		}
+	}
+
 
     //[/UserMethods]
 
@@ -235,7 +699,22 @@ private:
 	ScopedPointer<ApplicationCommandManager> mCommandManager;
 	ScopedPointer<AudioDemoSetupPage> mMidiSetupPage;
 	AudioDeviceManager mDeviceManager;
+	MidiInputParser mMidiInputParser;
+	DeviceVerifier mDeviceVerifier;
 	AboutScreen mAboutScreen;
+	MidiDiagnosticsComponent mMidiDiagnostics;
+	MidiMonitorComponent mMidiMonitor;
+	MidiOutputsComponent mMidiOutputs;
+	RemoteEditComponent mRemoteEditComponent;
+	MorphComponent mMorphComponent;
+	XyMorphComponent mXyMorphComponent;
+	MacroComponent mMacroComponent;
+	VoiceClipboard mVoiceClipboard;
+	PatchBrowserComponent mPatchBrowser;
+	PaintProfilerOverlay mPaintProfilerOverlay;
+	EditRecorder mEditRecorder;
+	ScopedPointer<SessionJournal> mJournal;
+	File mCurrentFile;	// the preset that saveFile writes to, nonexistent for a new sound
 
 	ScopedPointer<LookAndFeel> mLookAndFeel;
 
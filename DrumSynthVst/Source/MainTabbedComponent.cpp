@@ -45,6 +45,7 @@
 	=========================================================
  */
 #include "AudioDemoSetupPage.h"
+#include "../StartupProfiler.h"
 //[/Headers]
 
 #include "MainTabbedComponent.h"
@@ -57,6 +58,7 @@
 MainTabComponent::MainTabComponent ()
     : tabbedComponent (0)
 {
+	const ScopedStartupPhase startupPhase(STARTUP_TABS);
     addAndMakeVisible (tabbedComponent = new TabbedComponent (TabbedButtonBar::TabsAtTop));
     tabbedComponent->setTabBarDepth (30);
     tabbedComponent->addTab (L"Drum 1", Colours::lightgrey, 0, false);
@@ -70,13 +72,17 @@ MainTabComponent::MainTabComponent ()
 	tabbedComponent->removeTab(0);
 	tabbedComponent->removeTab(0);
 
-	tabbedComponent->addTab (L"Drum 1", Colours::lightgrey, new VoiceBasedDrumComponent(0), true);
-	tabbedComponent->addTab (L"Drum 2", Colours::lightgrey, new VoiceBasedDrumComponent(1), true);
-	tabbedComponent->addTab (L"Drum 3", Colours::lightgrey, new VoiceBasedDrumComponent(2), true);
-
-	tabbedComponent->addTab (L"Snare", Colours::lightgrey, new VoiceBasedSnareComponent(3), true);
-	tabbedComponent->addTab (L"Cymbal", Colours::lightgrey, new VoiceBasedCymbalComponent(4), true);
-	tabbedComponent->addTab (L"Hat", Colours::lightgrey, new VoiceBasedHatComponent(5), true);
+	//the voice panels are built when their tab is first shown
+	VoiceTab* tabs[NUM_VOICES];
+	for(int i=0;i<NUM_VOICES;i++)
+	{
+		tabs[i] = new VoiceTab(i,mVoiceGang);
+		tabbedComponent->addTab (voiceNames[i], Colours::lightgrey, tabs[i], true);
+	}
+	for(int i=0;i<NUM_VOICES;i++)
+	{
+		tabs[i]->setNeighbours(i > 0 ? tabs[i-1] : NULL, i < NUM_VOICES-1 ? tabs[i+1] : NULL);
+	}
 
 
     //[/UserPreSize]
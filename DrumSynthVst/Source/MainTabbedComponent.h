@@ -48,10 +48,7 @@
 	=========================================================
  */
 #include "../JuceLibraryCode/JuceHeader.h"
-#include "VoiceBasedDrumComponent.h"
-#include "VoiceBasedSnareComponent.h"
-#include "VoiceBasedCymbalComponent.h"
-#include "VoiceBasedHatComponent.h"
+#include "../VoicePanel.h"
 
 
 //[/Headers]
@@ -77,6 +74,12 @@ public:
     //[UserMethods]     -- You can add your own custom methods in this section.
 	//change listener to write midi setting to file when they change
 	//void changeListenerCallback (ChangeBroadcaster *source);
+
+	/** the voice of the shown tab*/
+	int getCurrentVoice() const
+	{
+		return jlimit(0,NUM_VOICES-1,tabbedComponent->getCurrentTabIndex());
+	};
     //[/UserMethods]
 
     void paint (Graphics& g);
@@ -89,6 +92,7 @@ public:
 
 private:
     //[UserVariables]   -- You can add your own custom variables in this section.
+	VoiceGang mVoiceGang;	// shared by the voice panels
     //[/UserVariables]
 
     //==============================================================================
@@ -45,6 +45,9 @@
 //[/Headers]
 
 #include "PatchGeneratorComponent.h"
+#include "../ParameterStore.h"
+#include "../Preview/PreviewEngine.h"
+#include "../Preview/PreviewRenderer.h"
 
 
 //[MiscUserDefs] You can add your own user definitions and misc code here...
@@ -57,7 +60,9 @@ PatchGeneratorComponent::PatchGeneratorComponent ()
       mLikeButton (0),
       mDislikeButton2 (0),
       mPrevButton (0),
-      mLogTextEditor (0)
+      mLogTextEditor (0),
+      mRenderButton (0),
+      mThumbnail (0)
 {
     addAndMakeVisible (mNextButton = new TextButton (L"Next Button"));
     mNextButton->setButtonText (L"Next");
@@ -96,12 +101,26 @@ PatchGeneratorComponent::PatchGeneratorComponent ()
     mLogTextEditor->setPopupMenuEnabled (true);
     mLogTextEditor->setText (String::empty);
 
+    addAndMakeVisible (mRenderButton = new TextButton (L"Render Button"));
+    mRenderButton->setButtonText (L"Render WAV...");
+    mRenderButton->addListener (this);
+
+    addAndMakeVisible (mThumbnail = new PatchThumbnailComponent());
+    mThumbnail->setName (L"Thumbnail");
+
 
     //[UserPreSize]
-	gloLogText = mLogTextEditor;
+	mLogSink = new LogSink(mLogTextEditor);
+	gloLog = mLogSink;
+	mPatchGenerator.addChangeListener(this);
+	mPatchGenerator.setJobListener(this);
+
+	addAndMakeVisible(mStatsLabel = new Label(L"Statistics",String::empty));
+	mStatsLabel->setFont(Font(13.0000f,Font::plain));
+	mStatsLabel->setJustificationType(Justification::centredLeft);
     //[/UserPreSize]
 
-    setSize (600, 400);
+    setSize (600, 460);
 
 
     //[Constructor] You can add your own custom stuff here..
@@ -111,6 +130,11 @@ PatchGeneratorComponent::PatchGeneratorComponent ()
 PatchGeneratorComponent::~PatchGeneratorComponent()
 {
     //[Destructor_pre]. You can add your own custom destruction code here..
+	mPatchGenerator.removeChangeListener(this);
+	mPatchGenerator.setJobListener(NULL);
+	mPatchGenerator.cancelSpeculation();
+	gloLog = NULL;
+	mLogSink = 0;
     //[/Destructor_pre]
 
     deleteAndZero (mNextButton);
@@ -119,6 +143,8 @@ PatchGeneratorComponent::~PatchGeneratorComponent()
     deleteAndZero (mDislikeButton2);
     deleteAndZero (mPrevButton);
     deleteAndZero (mLogTextEditor);
+    deleteAndZero (mRenderButton);
+    deleteAndZero (mThumbnail);
 
 
     //[Destructor]. You can add your own custom destruction code here..
@@ -145,7 +171,10 @@ void PatchGeneratorComponent::resized()
     mDislikeButton2->setBounds (288, 352, 70, 24);
     mPrevButton->setBounds (208, 352, 80, 24);
     mLogTextEditor->setBounds (56, 88, 624, 248);
+    mRenderButton->setBounds (440, 48, 120, 24);
+    mThumbnail->setBounds (56, 392, 624, 56);
     //[UserResized] Add your own custom resize handling here..
+	mStatsLabel->setBounds (56, 72, 624, 16);
     //[/UserResized]
 }
 
@@ -157,6 +186,11 @@ void PatchGeneratorComponent::buttonClicked (Button* buttonThatWasClicked)
     if (buttonThatWasClicked == mNextButton)
     {
         //[UserButtonCode_mNextButton] -- add your button handler code here..
+		if(!mPatchGenerator.isEvolving())
+		{
+			mPatchGenerator.getPopulation().next();
+			auditionCurrent();
+		}
         //[/UserButtonCode_mNextButton]
     }
     else if (buttonThatWasClicked == mGenerateButton)
@@ -166,24 +200,39 @@ void PatchGeneratorComponent::buttonClicked (Button* buttonThatWasClicked)
 		//ScopedPointer<Patch> father = new Patch();
 		//ScopedPointer<Patch> mother = new Patch();
 		//ScopedPointer<Patch> child = mPatchGenerator.generateChild(father,mother);
-		mPatchGenerator.combineAllParents();
+		mPatchGenerator.evolve();
+		//a speculation is taken at once
+		showStatistics();
         //[/UserButtonCode_mGenerateButton]
     }
     else if (buttonThatWasClicked == mLikeButton)
     {
         //[UserButtonCode_mLikeButton] -- add your button handler code here..
+		vote(LIKE);
         //[/UserButtonCode_mLikeButton]
     }
     else if (buttonThatWasClicked == mDislikeButton2)
     {
         //[UserButtonCode_mDislikeButton2] -- add your button handler code here..
+		vote(DISLIKE);
         //[/UserButtonCode_mDislikeButton2]
     }
     else if (buttonThatWasClicked == mPrevButton)
     {
         //[UserButtonCode_mPrevButton] -- add your button handler code here..
+		if(!mPatchGenerator.isEvolving())
+		{
+			mPatchGenerator.getPopulation().prev();
+			auditionCurrent();
+		}
         //[/UserButtonCode_mPrevButton]
     }
+    else if (buttonThatWasClicked == mRenderButton)
+    {
+        //[UserButtonCode_mRenderButton] -- add your button handler code here..
+		renderPopulation();
+        //[/UserButtonCode_mRenderButton]
+    }
 
     //[UserbuttonClicked_Post]
     //[/UserbuttonClicked_Post]
@@ -192,6 +241,114 @@ void PatchGeneratorComponent::buttonClicked (Button* buttonThatWasClicked)
 
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+void PatchGeneratorComponent::auditionCurrent()
+{
+	Population& population = mPatchGenerator.getPopulation();
+	if(population.getNumMembers() == 0) return;
+
+	Patch* patch = population.getMember(population.getCurrent());
+	ParameterStore::getInstance()->loadFromPatch(patch,true,mPlaylist.findDump(patch->getValues()));
+	mThumbnail->setPatch(patch->getValues());
+	if(PreviewEngine::getInstance()->getAutoPreview())
+	{
+		PreviewEngine::getInstance()->playSound();
+	}
+	//the next steps only send
+	mPlaylist.prepare(population);
+
+	String opinion;
+	if(patch->getOpinion() == LIKE) opinion = " (liked)";
+	else if(patch->getOpinion() == DISLIKE) opinion = " (disliked)";
+	logText(String(population.getCurrent()+1) + String("/") + String(population.getNumMembers()) + String(" ") + patch->getName() + opinion);
+}
+
+void PatchGeneratorComponent::vote(int opinion)
+{
+	//the votes are the fitness of the next evolve()
+	if(mPatchGenerator.isEvolving() || mPatchGenerator.getPopulation().getNumMembers() == 0) return;
+
+	//a speculation for the old votes is thrown away and bred again with this one
+	mPatchGenerator.cancelSpeculation();
+	Population& population = mPatchGenerator.getPopulation();
+	population.vote(opinion);
+	mPatchGenerator.addVote(population.getMember(population.getCurrent()));
+	mPatchGenerator.speculate();
+	population.next();
+	auditionCurrent();
+}
+
+void PatchGeneratorComponent::renderPopulation()
+{
+	if(mPatchGenerator.isEvolving() || mPatchGenerator.getPopulation().getNumMembers() == 0) return;
+
+	PopupMenu menu;
+	menu.addItem(1,"One WAV per patch...");
+	menu.addItem(2,"One WAV with cue points...");
+	menu.addItem(3,"One FLAC per patch...");
+	const int result = menu.showAt(mRenderButton);
+	if(result == 0) return;
+
+	const File documents = File::getSpecialLocation(File::userDocumentsDirectory);
+	File target;
+	if(result != 2)
+	{
+		FileChooser chooser("Render the generation into a folder",documents);
+		if(!chooser.browseForDirectory()) return;
+		target = chooser.getResult();
+	}
+	else
+	{
+		FileChooser chooser("Render the generation into one file",documents.getChildFile("generation.wav"),"*.wav");
+		if(!chooser.browseForFileToSave(true)) return;
+		target = chooser.getResult().withFileExtension(".wav");
+	}
+
+	PreviewRenderJob job(mPatchGenerator.getPopulation(),target,result != 2,result == 3 ? ".flac" : ".wav");
+	job.runThread();
+	logText(String("Rendered ") + String(job.getNumWritten()) + String(" sounds to ") + target.getFullPathName());
+}
+
+void PatchGeneratorComponent::changeListenerCallback(ChangeBroadcaster*)
+{
+	const Population* speculation = mPatchGenerator.getSpeculation();
+	if(speculation == NULL) return;
+
+	PatchThumbnailCache* cache = PatchThumbnailCache::getInstance();
+	ScopedPointer<AudioThumbnail> thumb(cache->createThumbnail());
+	for(int i=0;i<speculation->getNumMembers();i++)
+	{
+		const uint8_t* values = speculation->getMember(i)->getValues();
+		if(!cache->load(*thumb,PatchThumbnailCache::getHash(values))) cache->request(values);
+	}
+}
+
+void PatchGeneratorComponent::jobProgressChanged(BackgroundJob* job)
+{
+	mGenerateButton->setButtonText(job->getStatusMessage() + String(" ") + String(roundToInt(job->getProgress()*100)) + String("%"));
+	showStatistics();
+}
+
+void PatchGeneratorComponent::jobFinished(BackgroundJob*)
+{
+	mGenerateButton->setButtonText(L"New Generation");
+	showStatistics();
+	//the first steps through the new generation
+	if(!mPatchGenerator.isEvolving()) mPlaylist.prepare(mPatchGenerator.getPopulation());
+}
+
+void PatchGeneratorComponent::showStatistics()
+{
+	const GenerationSummary stats = mPatchGenerator.getStatistics();
+	if(stats.numMembers == 0) return;
+
+	String text(stats.toString());
+	const GenerationSummary start = mPatchGenerator.getStartStatistics();
+	if(start.diversity > 0.f && start.generation != stats.generation)
+	{
+		text << ", diversity " << roundToInt(100.f*stats.diversity/start.diversity) << "% of generation " << start.generation;
+	}
+	mStatsLabel->setText(text,false);
+}
 //[/MiscUserCode]
 
 
@@ -207,7 +364,7 @@ BEGIN_JUCER_METADATA
                  componentName="" parentClasses="public Component" constructorParams=""
                  variableInitialisers="" snapPixels="8" snapActive="1" snapShown="1"
                  overlayOpacity="0.330000013" fixedSize="0" initialWidth="600"
-                 initialHeight="400">
+                 initialHeight="460">
   <BACKGROUND backgroundColour="ffffffff"/>
   <TEXTBUTTON name="Next Button" id="3bebe7b13fb04379" memberName="mNextButton"
               virtualName="" explicitFocusOrder="0" pos="432 352 80 24" buttonText="Next"
@@ -230,6 +387,12 @@ BEGIN_JUCER_METADATA
               virtualName="" explicitFocusOrder="0" pos="56 88 624 248" initialText=""
               multiline="1" retKeyStartsLine="1" readonly="1" scrollbars="1"
               caret="1" popupmenu="1"/>
+  <TEXTBUTTON name="Render Button" id="5a1e7d3c0b9f42e6" memberName="mRenderButton"
+              virtualName="" explicitFocusOrder="0" pos="440 48 120 24" buttonText="Render WAV..."
+              connectedEdges="0" needsCallback="1" radioGroupId="0"/>
+  <GENERICCOMPONENT name="Thumbnail" id="8c3f51d07a2e96b4" memberName="mThumbnail"
+                    virtualName="" explicitFocusOrder="0" pos="56 392 624 56" class="PatchThumbnailComponent"
+                    params=""/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -49,6 +49,8 @@
  */
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "..\PatchGenerator.h"
+#include "../Preview/PatchThumbnailCache.h"
+#include "../Preview/AuditionPlaylist.h"
 //[/Headers]
 
 
@@ -62,7 +64,9 @@
                                                                     //[/Comments]
 */
 class PatchGeneratorComponent  : public Component,
-                                 public ButtonListener
+                                 public ButtonListener,
+                                 public ChangeListener,
+                                 public BackgroundJob::Listener
 {
 public:
     //==============================================================================
@@ -71,6 +75,19 @@ public:
 
     //==============================================================================
     //[UserMethods]     -- You can add your own custom methods in this section.
+	/** sends the current population member to the synth*/
+	void auditionCurrent();
+	/** vote for the current member and move on to the next*/
+	void vote(int opinion);
+	/** writes the population to WAV files with the software preview*/
+	void renderPopulation();
+	/** the speculated generation is ready, its thumbnails are rendered before it is shown*/
+	void changeListenerCallback(ChangeBroadcaster* source);
+	/** the generate button shows how far a run is*/
+	void jobProgressChanged(BackgroundJob* job);
+	void jobFinished(BackgroundJob* job);
+	/** the statistics of the last generation, with the diversity against the start of the run*/
+	void showStatistics();
     //[/UserMethods]
 
     void paint (Graphics& g);
@@ -85,6 +102,9 @@ public:
 private:
     //[UserVariables]   -- You can add your own custom variables in this section.
 	PatchGenerator mPatchGenerator;
+	AuditionPlaylist mPlaylist;
+	ScopedPointer<Label> mStatsLabel;
+	ScopedPointer<LogSink> mLogSink;
     //[/UserVariables]
 
     //==============================================================================
@@ -94,6 +114,8 @@ private:
     TextButton* mDislikeButton2;
     TextButton* mPrevButton;
     TextEditor* mLogTextEditor;
+    TextButton* mRenderButton;
+    PatchThumbnailComponent* mThumbnail;
 
 
     //==============================================================================
@@ -0,0 +1,155 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Singletons.h"
+#include "../Midi/MidiTransmitter.h"
+#include "../Midi/MidiOutputRouter.h"
+#include "../Midi/MidiCapture.h"
+#include "../Midi/RemoteEditServer.h"
+#include "../ParameterStore.h"
+#include "../NameModel.h"
+#include "../StartupLoader.h"
+#include "../WindowRenderer.h"
+#include "../PaintProfiler.h"
+#include "../ParallelFor.h"
+#include "../BackgroundJobs.h"
+#include "../ThreadPriorities.h"
+#include "../Log.h"
+#include "../MessageBatch.h"
+#include "../Trace.h"
+#include "../MemoryAccounting.h"
+#include "../StartupProfiler.h"
+#include "../Midi/EditReplay.h"
+#include "../Preview/PreviewEngine.h"
+#include "../Preview/PatchThumbnailCache.h"
+#include "../Preview/PreviewRenderCache.h"
+#include "../Telemetry.h"
+#include "../TelemetryServer.h"
+#include "../ComboItemModels.h"
+#include "../VoteDatabase.h"
+
+juce_ImplementSingleton (MidiTransmitter)
+juce_ImplementSingleton (MidiOutputRouter)
+juce_ImplementSingleton (RemoteEditServer)
+juce_ImplementSingleton (TelemetryServer)
+juce_ImplementSingleton (ParameterStore)
+juce_ImplementSingleton (LatencyMonitor)
+juce_ImplementSingleton (MidiCapture)
+juce_ImplementSingleton (MidiClockFollower)
+juce_ImplementSingleton (NameModel)
+juce_ImplementSingleton (StartupLoader)
+juce_ImplementSingleton (WindowRenderer)
+juce_ImplementSingleton (PaintProfiler)
+juce_ImplementSingleton (ParallelFor)
+juce_ImplementSingleton (JobQueue)
+juce_ImplementSingleton (MessageBatch)
+juce_ImplementSingleton (Tracer)
+juce_ImplementSingleton (PreviewEngine)
+juce_ImplementSingleton (PatchThumbnailCache)
+juce_ImplementSingleton (PreviewRenderCache)
+juce_ImplementSingleton (PreviewWavetables)
+juce_ImplementSingleton (UiEditRecorder)
+juce_ImplementSingleton (ComboItemModels)
+juce_ImplementSingleton (VoteDatabase)
+
+void deleteSingletons()
+{
+	StartupLoader::deleteInstance();
+	UiEditRecorder::deleteInstance();
+	//its connections read the transmitter, it tells the profiler to stop counting
+	TelemetryServer::deleteInstance();
+	WindowRenderer::deleteInstance();
+	PaintProfiler::deleteInstance();
+	//the windows are gone, their combos had the items
+	ComboItemModels::deleteInstance();
+	PreviewEngine::deleteInstance();
+	//read by the audio callback of the engine
+	MidiClockFollower::deleteInstance();
+	PatchThumbnailCache::deleteInstance();
+	//waits for its compaction job
+	VoteDatabase::deleteInstance();
+	//after the owners of jobs, the running ones still use the pools and tables below
+	JobQueue::deleteInstance();
+	ParallelFor::deleteInstance();
+	//the thumbnail jobs and the batch renders read and fill it
+	PreviewRenderCache::deleteInstance();
+	//the voices of the engine and the cache jobs read the tables
+	PreviewWavetables::deleteInstance();
+	//its connections feed the store and the transmitter
+	RemoteEditServer::deleteInstance();
+	//the extra units stop their threads before unit 0 goes
+	MidiOutputRouter::deleteInstance();
+	MidiTransmitter::deleteInstance();
+	//every unit and the input parser capture into it
+	MidiCapture::deleteInstance();
+	ParameterStore::deleteInstance();
+	LatencyMonitor::deleteInstance();
+	NameModel::deleteInstance();
+	//after everything that triggers updates through it
+	MessageBatch::deleteInstance();
+	//scopes of every other singleton may still record
+	Tracer::deleteInstance();
+}
+
+Thread::ThreadID volatile AudioThreadAllocations::sAudioThread = 0;
+Atomic<int> AudioThreadAllocations::sNumAllocations;
+MemoryAccounting::Counters MemoryAccounting::sCounters[NUM_MEMORY_TAGS];
+//the arrays first, processStarted() sets one of them. initialised before main()
+Atomic<int> StartupProfiler::sBegin[NUM_STARTUP_PHASES];
+Atomic<int> StartupProfiler::sEnd[NUM_STARTUP_PHASES];
+const uint32 StartupProfiler::sProcessStart = StartupProfiler::processStarted();
+Atomic<int> UserActivity::sActiveUntil;
+Atomic<int> LogLevel::sLevel (LOG_LEVEL_INFO);
+Atomic<int> Telemetry::sCounters[NUM_TELEMETRY_COUNTERS];
+
+//==============================================================================
+// every allocation of the application passes here, so the diagnostics can
+// show whether the audio thread allocates
+void* operator new (size_t size)
+{
+	AudioThreadAllocations::allocationMade();
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[] (size_t size)
+{
+	AudioThreadAllocations::allocationMade();
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete (void* p) throw()
+{
+	free(p);
+}
+
+void operator delete[] (void* p) throw()
+{
+	free(p);
+}
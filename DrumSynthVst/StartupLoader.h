@@ -0,0 +1,251 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./NameModel.h"
+#include "./Source/EmbeddedResources.h"
+#include "./MessageBatch.h"
+#include "./BackgroundJobs.h"
+#include "./Trace.h"
+#include "./StartupProfiler.h"
+#include "./GreenLookAndFeel.h"
+
+// the resources loaded in the background at startup
+#define RESOURCE_NAME_MODEL		0	// Markov chain and word list of the name generator
+#define RESOURCE_KNOB_IMAGE		1	// the film strip of GreenLookAndFeel, embedded
+#define RESOURCE_MIDI_CONFIG	2	// the saved device setup, midi.cfg
+#define RESOURCE_GLYPHS			3	// the GlyphMetrics of the GreenLookAndFeel fonts
+#define NUM_STARTUP_RESOURCES	4
+
+//---------------------------------------------------------------------------
+/** Loads the resources that used to be read while the windows were built.
+
+	start() queues every resource as an interactive job of the JobQueue, so
+	the windows can be shown at once. Listeners are told on the message thread when a
+	resource is ready. A listener added later is told right away about the
+	ones that are ready already. When everything is loaded the times of the
+	StartupProfiler phases are written to the log.
+*/
+class StartupLoader : public BatchedAsyncUpdater
+{
+public:
+	//-----------------------------------------------------------------------
+	class Listener
+	{
+	public:
+		virtual ~Listener() {};
+		/** called on the message thread, once per resource*/
+		virtual void startupResourceReady(int resource) = 0;
+	};
+	//-----------------------------------------------------------------------
+
+	StartupLoader()
+	{
+		mStarted = false;
+		for(int i=0;i<NUM_STARTUP_RESOURCES;i++)
+		{
+			mReady[i].set(0);
+			mReported[i] = false;
+		}
+	};
+
+	~StartupLoader()
+	{
+		//the jobs can't be interrupted, they write into the loader
+		for(int i=0;i<mJobs.size();i++)
+		{
+			mJobs.getUnchecked(i)->waitUntilDone(-1);
+		}
+		cancelPendingUpdate();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (StartupLoader, false)
+
+	/** starts loading, call it on the message thread before the windows are created*/
+	void start()
+	{
+		if(mStarted) return;
+		mStarted = true;
+
+		for(int i=0;i<NUM_STARTUP_RESOURCES;i++)
+		{
+			mJobs.add(JobQueue::getInstance()->addJob(new LoadJob(*this,i)));
+		}
+	};
+
+	void addListener(Listener* listener)
+	{
+		jassert(!mListeners.contains(listener));
+		mListeners.add(listener);
+
+		for(int i=0;i<NUM_STARTUP_RESOURCES;i++)
+		{
+			if(mReported[i]) listener->startupResourceReady(i);
+		}
+	};
+
+	void removeListener(Listener* listener)
+	{
+		mListeners.removeValue(listener);
+	};
+
+	bool isReady(int resource) const
+	{
+		return mReady[resource].get() != 0;
+	};
+
+	/** invalid until RESOURCE_KNOB_IMAGE is ready*/
+	const Image& getKnobImage() const
+	{
+		jassert(isReady(RESOURCE_KNOB_IMAGE));
+		return mKnobImage;
+	};
+
+	/** NULL until RESOURCE_MIDI_CONFIG is ready, and if there is no saved setup*/
+	const XmlElement* getMidiConfig() const
+	{
+		return isReady(RESOURCE_MIDI_CONFIG) ? (const XmlElement*)mMidiConfig : NULL;
+	};
+
+	/** empty until RESOURCE_GLYPHS is ready*/
+	const ReferenceCountedArray<GlyphMetrics>& getGlyphMetrics() const
+	{
+		jassert(isReady(RESOURCE_GLYPHS));
+		return mGlyphMetrics;
+	};
+
+	static File getMidiConfigFile()
+	{
+		return File(File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getFullPathName() + String("/midi.cfg"));
+	};
+
+	void handleAsyncUpdate()
+	{
+		bool allReady = true;
+		for(int i=0;i<NUM_STARTUP_RESOURCES;i++)
+		{
+			if(!isReady(i))
+			{
+				allReady = false;
+				continue;
+			}
+			if(mReported[i]) continue;
+
+			mReported[i] = true;
+			for(int l=0;l<mListeners.size();l++)
+			{
+				mListeners[l]->startupResourceReady(i);
+			}
+		}
+
+		if(allReady) Logger::writeToLog(StartupProfiler::getSummary());
+	};
+
+private:
+	/** loads one resource on a job thread*/
+	class LoadJob : public BackgroundJob
+	{
+	public:
+		LoadJob(StartupLoader& loader, int resource)
+		: BackgroundJob("startup",JOB_PRIORITY_INTERACTIVE),
+		mLoader(loader),
+		mResource(resource)
+		{
+		};
+
+		bool run()
+		{
+			mLoader.load(mResource);
+			return true;
+		};
+
+	private:
+		StartupLoader& mLoader;
+		const int mResource;
+	};
+
+	void load(int resource)
+	{
+		TRACE_SCOPE("startup","load resource");
+		switch(resource)
+		{
+		case RESOURCE_NAME_MODEL:
+			//the model has its own thread, this only waits for it
+			NameModel::get();
+			break;
+
+		case RESOURCE_KNOB_IMAGE:
+			//ends when the look and feel has it, see MainComponent::startupResourceReady()
+			StartupProfiler::begin(STARTUP_KNOB_IMAGE);
+			//decoded once, later calls get the cached image
+			mKnobImage = ImageCache::getFromMemory(EmbeddedResources::knob_png,EmbeddedResources::knob_pngSize);
+			break;
+
+		case RESOURCE_MIDI_CONFIG:
+			StartupProfiler::begin(STARTUP_MIDI_CONFIG);
+			if(getMidiConfigFile().exists())
+			{
+				XmlDocument xmlDoc(getMidiConfigFile());
+				mMidiConfig = xmlDoc.getDocumentElement();
+			}
+			StartupProfiler::end(STARTUP_MIDI_CONFIG);
+			break;
+
+		case RESOURCE_GLYPHS:
+			{
+				const ScopedStartupPhase startupPhase(STARTUP_GLYPHS);
+#if ! JUCE_LINUX
+				//the freetype faces of juce are shared without a lock, there the texts are laid out as before
+				Array<Font> fonts;
+				GreenLookAndFeel::getTextFonts(fonts);
+				for(int i=0;i<fonts.size();i++)
+				{
+					mGlyphMetrics.add(new GlyphMetrics(fonts.getReference(i)));
+				}
+#endif
+			}
+			break;
+		}
+
+		//the result is written before the flag, the message thread reads it after the flag
+		mReady[resource].set(1);
+		triggerAsyncUpdate();
+	};
+
+	ReferenceCountedArray<BackgroundJob> mJobs;
+	bool mStarted;
+
+	Atomic<int> mReady[NUM_STARTUP_RESOURCES];
+	bool mReported[NUM_STARTUP_RESOURCES];	// only used on the message thread
+
+	Image mKnobImage;
+	ScopedPointer<XmlElement> mMidiConfig;
+	ReferenceCountedArray<GlyphMetrics> mGlyphMetrics;
+
+	Array<Listener*> mListeners;
+};
+//---------------------------------------------------------------------------
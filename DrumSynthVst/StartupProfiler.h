@@ -0,0 +1,152 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+#define STARTUP_TIME_BUDGET_MS	500	// until everything should be loaded, more is logged as slow
+
+/** the timed parts of a cold start, several of them run at the same time*/
+enum StartupPhases
+{
+	STARTUP_JUCE_INIT = 0,		// process start until JUCEApplication::initialise()
+	STARTUP_MAIN_COMPONENT,		// the MainComponent constructor, the tabs included
+	STARTUP_TABS,				// the MainTabComponent constructor
+	STARTUP_KNOB_IMAGE,			// decoding knob.png until the look and feel has it
+	STARTUP_MIDI_CONFIG,		// reading midi.cfg
+	STARTUP_DEVICE_INIT,		// opening the devices of midi.cfg
+	STARTUP_PATCH_GENERATOR,	// the PatchGeneratorWindow constructor
+	STARTUP_NAME_MODEL,			// the Markov model and the word list of the name generator
+	STARTUP_GLYPHS,				// measuring the glyphs of the look and feel fonts
+	NUM_STARTUP_PHASES
+};
+
+//---------------------------------------------------------------------------
+/** Wall clock times of the startup phases, from the start of the process.
+
+	The start is taken while the static objects of Singletons.cpp are
+	initialised, before main(). The high resolution counter isn't set up
+	yet then on Windows, so it is the millisecond counter, which the high
+	resolution one is kept in line with. begin() and end()
+	can be called on any thread and on different ones for the same phase,
+	the first begin() and the last end() count. getSummary() lists every
+	phase and compares the time until the last one ended with
+	STARTUP_TIME_BUDGET_MS, the editor logs it when everything is loaded
+	and on exit, the Settings menu shows it.
+*/
+class StartupProfiler
+{
+public:
+	static void begin(int phase)
+	{
+		sBegin[phase].compareAndSetBool(getTime(),0);
+	};
+
+	static void end(int phase)
+	{
+		sEnd[phase].set(getTime());
+	};
+
+	/** ms from the process start until the last phase ended*/
+	static double getTotalTime()
+	{
+		int total = 0;
+		for(int i=0;i<NUM_STARTUP_PHASES;i++)
+		{
+			total = jmax(total,sEnd[i].get());
+		}
+		return toMs(total);
+	};
+
+	/** a line per phase with its start, end and duration*/
+	static String getSummary()
+	{
+		String text("startup phases (start, end, duration in ms):\n");
+		for(int i=0;i<NUM_STARTUP_PHASES;i++)
+		{
+			const int begin = sBegin[i].get();
+			const int end = sEnd[i].get();
+			text << "  " << getPhaseName(i) << ": ";
+			if(begin == 0)		text << "not run\n";
+			else if(end == 0)	text << String(toMs(begin),1) << ", running\n";
+			else				text << String(toMs(begin),1) << ", " << String(toMs(end),1) << ", " << String(toMs(end)-toMs(begin),1) << "\n";
+		}
+
+		const double total = getTotalTime();
+		text << "startup took " << String(total,1) << " ms of " << STARTUP_TIME_BUDGET_MS << " ms budget";
+		if(total > STARTUP_TIME_BUDGET_MS) text << " (too slow)";
+		return text;
+	};
+
+	static const char* getPhaseName(int phase)
+	{
+		const char* const names[] = { "juce init", "main component", "tabs", "knob image", "midi.cfg",
+			"device init", "patch generator", "name model", "glyph metrics" };
+		return names[phase];
+	};
+
+private:
+	/** us since the process start, 0 is kept for not yet*/
+	static int getTime()
+	{
+		return jmax(1,(int)((Time::getMillisecondCounterHiRes() - sProcessStart)*1000.));
+	};
+
+	/** the value of sProcessStart, the juce init phase starts with the process*/
+	static uint32 processStarted()
+	{
+		sBegin[STARTUP_JUCE_INIT].set(1);
+		return Time::getMillisecondCounter();
+	};
+
+	static double toMs(int us)
+	{
+		return us*0.001;
+	};
+
+	static const uint32 sProcessStart;	// Time::getMillisecondCounter()
+	static Atomic<int> sBegin[NUM_STARTUP_PHASES];
+	static Atomic<int> sEnd[NUM_STARTUP_PHASES];
+};
+
+//---------------------------------------------------------------------------
+/** times a phase that starts and ends in the same block*/
+class ScopedStartupPhase
+{
+public:
+	ScopedStartupPhase(int phase) : mPhase(phase)
+	{
+		StartupProfiler::begin(phase);
+	};
+
+	~ScopedStartupPhase()
+	{
+		StartupProfiler::end(mPhase);
+	};
+
+private:
+	const int mPhase;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,212 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "Patch.h"
+#include "PatchHash.h"
+#include "PatchVpTree.h"
+
+#define VOTE_HISTORY_MAGIC		0x48565053	// "SPVH" little endian
+#define VOTE_HISTORY_VERSION	1
+#define VOTE_HISTORY_EXTENSION	".svh"
+
+#define SURROGATE_K				7	// neighbours that are asked for a score
+#define SURROGATE_MIN_VOTES		8	// below this every patch gets SURROGATE_NO_SCORE
+#define SURROGATE_NO_SCORE		0.5f
+
+//---------------------------------------------------------------------------
+/** Guesses how much the user will like a patch from the votes so far.
+
+	Every vote is a sample of NUM_PARAMS values with the score 1 (like) or
+	0 (dislike). A patch scores the distance weighted mean of its
+	SURROGATE_K nearest voted patches. The samples are indexed in a
+	PatchVpTree; votes that came in after the last updateIndex() are
+	scanned linearly until the next one.
+	Voting for the same values again replaces the earlier vote.
+*/
+class SurrogateModel
+{
+public:
+	SurrogateModel() : mSampleIndex(1024), mNumIndexed(0)
+	{
+	};
+
+	~SurrogateModel()
+	{
+	};
+
+	void clear()
+	{
+		mSamples.setSize(0);
+		mLabels.clear();
+		mSampleIndex.clear();
+		mTree.clear();
+		mNumIndexed = 0;
+	};
+
+	/** LIKE or DISLIKE, NOT_VOTED withdraws an earlier vote for the values*/
+	void addVote(const uint8_t* values, int opinion)
+	{
+		const float label = (opinion == LIKE) ? 1.f : (opinion == DISLIKE) ? 0.f : SURROGATE_NO_SCORE;
+
+		const int existing = mSampleIndex.find(values);
+		if(existing >= 0)
+		{
+			mLabels.set(existing,label);
+			return;
+		}
+		if(opinion == NOT_VOTED) return;
+
+		mSampleIndex.add(values,mLabels.size());
+		mSamples.append(values,NUM_PARAMS);
+		mLabels.add(label);
+	};
+
+	int getNumVotes() const
+	{
+		return mLabels.size();
+	};
+
+	/** false while there are too few votes to tell patches apart*/
+	bool isTrained() const
+	{
+		return mLabels.size() >= SURROGATE_MIN_VOTES;
+	};
+
+	/** index the votes that came in since the last call. not thread safe, call it before scoring*/
+	void updateIndex()
+	{
+		if(mNumIndexed == mLabels.size()) return;
+
+		mTree.build(getSampleData(),mLabels.size());
+		mNumIndexed = mLabels.size();
+	};
+
+	/** [0:1], SURROGATE_NO_SCORE if the model isn't trained. can be called from several threads*/
+	float score(const uint8_t* values) const
+	{
+		if(!isTrained()) return SURROGATE_NO_SCORE;
+
+		KNearest neighbours(SURROGATE_K);
+		const uint8_t* data = getSampleData();
+		mTree.search(data,values,neighbours);
+		for(int i=mNumIndexed;i<mLabels.size();i++)
+		{
+			neighbours.add(i,PatchDistance::l1(values,data + i*NUM_PARAMS));
+		}
+
+		float sum = 0.f;
+		float weights = 0.f;
+		for(int i=0;i<neighbours.size();i++)
+		{
+			const float weight = 1.f / (1.f + neighbours.getDistance(i));
+			sum += weight * mLabels[neighbours.getSample(i)];
+			weights += weight;
+		}
+		return sum / weights;
+	};
+
+	bool save(const File& file) const
+	{
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+
+			write(*out);
+
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+	/** returns false if the file is missing or invalid, the model is empty then*/
+	bool load(const File& file)
+	{
+		FileInputStream in(file);
+		if(in.getStatus().failed())
+		{
+			clear();
+			return false;
+		}
+		return read(in);
+	};
+
+	/** header: magic, version, NUM_PARAMS, number of votes. then NUM_PARAMS values and one opinion byte per vote*/
+	void write(OutputStream& out) const
+	{
+		out.writeInt(VOTE_HISTORY_MAGIC);
+		out.writeInt(VOTE_HISTORY_VERSION);
+		out.writeInt(NUM_PARAMS);
+		out.writeInt(mLabels.size());
+		for(int i=0;i<mLabels.size();i++)
+		{
+			out.write(getSampleData() + i*NUM_PARAMS,NUM_PARAMS);
+			out.writeByte((char)(mLabels[i] == 1.f ? LIKE : mLabels[i] == 0.f ? DISLIKE : NOT_VOTED));
+		}
+	};
+
+	/** replaces the votes with the ones written by write(), the model is empty if they are invalid*/
+	bool read(InputStream& in)
+	{
+		clear();
+
+		if(in.readInt() != VOTE_HISTORY_MAGIC || in.readInt() != VOTE_HISTORY_VERSION || in.readInt() != NUM_PARAMS)
+		{
+			return false;
+		}
+
+		const int numVotes = in.readInt();
+		uint8_t values[NUM_PARAMS];
+		for(int i=0;i<numVotes;i++)
+		{
+			if(in.read(values,NUM_PARAMS) != NUM_PARAMS || in.isExhausted())
+			{
+				clear();
+				return false;
+			}
+			addVote(values,in.readByte());
+		}
+		updateIndex();
+		return true;
+	};
+
+private:
+	const uint8_t* getSampleData() const
+	{
+		return (const uint8_t*)mSamples.getData();
+	};
+
+	MemoryBlock mSamples;		// NUM_PARAMS values per vote
+	Array<float> mLabels;		// the score of every vote
+	PatchHashSet mSampleIndex;	// values -> vote, to replace a vote
+
+	PatchVpTree mTree;
+	int mNumIndexed;			// votes in mTree, the rest is scanned linearly
+};
+//---------------------------------------------------------------------------
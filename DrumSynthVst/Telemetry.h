@@ -0,0 +1,71 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+/** the running totals the TelemetryServer reports, they wrap and the rates are taken from the differences*/
+enum TelemetryCounters
+{
+	TELEMETRY_MIDI_BYTES = 0,		// bytes the MidiTransmitter put on the wire
+	TELEMETRY_MIDI_COALESCED,		// values that replaced a queued one of the same parameter
+	TELEMETRY_MIDI_DROPPED,			// queued values that a patch dump made obsolete
+	TELEMETRY_CHILDREN_BRED,		// children the generator bred, the dropped duplicates included
+	TELEMETRY_PAINT_FRAMES,			// windows painted while a telemetry server runs
+	TELEMETRY_PAINT_MICROSECONDS,	// spent in paint() of all components
+	NUM_TELEMETRY_COUNTERS
+};
+
+//---------------------------------------------------------------------------
+/** Health counters of the editor for the TelemetryServer.
+
+	One atomic add per event, on any thread, so the counters stay in the
+	builds that are monitored. The MIDI and generator counters always
+	count, the paint counters only while the PaintProfiler is told to,
+	which the server does while it runs.
+*/
+class Telemetry
+{
+public:
+	static void add(int counter, int amount)
+	{
+		sCounters[counter] += amount;
+	};
+
+	static int get(int counter)
+	{
+		return sCounters[counter].get();
+	};
+
+	static const char* getName(int counter)
+	{
+		const char* const names[] = { "midi.bytes", "midi.coalesced", "midi.dropped", "generator.children", "paint.frames", "paint.us" };
+		return names[counter];
+	};
+
+private:
+	static Atomic<int> sCounters[NUM_TELEMETRY_COUNTERS];
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,212 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./Telemetry.h"
+#include "./MemoryAccounting.h"
+#include "./PaintProfiler.h"
+#include "./Midi/MidiTransmitter.h"
+
+#define TELEMETRY_CONNECTION_MAGIC	0x53505445	// "SPTE", the header of every InterprocessConnection message
+
+//---------------------------------------------------------------------------
+/** Answers the health counters of the editor to monitoring tools.
+
+	A client connects to the port and sends any message, the reply is one
+	message of text lines "name value", e.g. "midi.bytes_per_sec 412.5".
+	The messages are those of an InterprocessConnection: the 4 bytes of
+	TELEMETRY_CONNECTION_MAGIC and the 4 bytes of the size, both little
+	endian, then the text in UTF-8.
+
+	Each line of Telemetry has its running total and, as name_per_sec, its
+	rate since the previous request of the same connection (since the
+	connection was made for the first one). Then come the depths of the
+	MIDI queues, the live and peak bytes of each MemoryAccounting tag and
+	the number of open connections.
+
+	A request is answered on the thread of its connection, everything it
+	reads is atomic. start() and stop() on the message thread, the paints
+	are counted while the server runs.
+*/
+class TelemetryServer : public InterprocessConnectionServer
+{
+public:
+	TelemetryServer() : mPort(0)
+	{
+		mNumConnections.set(0);
+		mNumRequests.set(0);
+	};
+
+	~TelemetryServer()
+	{
+		stop();
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (TelemetryServer, false)
+
+	/** returns false if the port can't be opened*/
+	bool start(int port)
+	{
+		stop();
+		if(!beginWaitingForSocket(port)) return false;
+		mPort = port;
+		PaintProfiler::getInstance()->setCountPaints(true);
+		return true;
+	};
+
+	/** closes the port and every connection*/
+	void stop()
+	{
+		InterprocessConnectionServer::stop();
+		{
+			const ScopedLock sl(mLock);
+			mConnections.clear();
+		}
+		PaintProfiler* profiler = PaintProfiler::getInstanceWithoutCreating();
+		if(mPort != 0 && profiler != NULL) profiler->setCountPaints(false);
+		mPort = 0;
+	};
+
+	/** 0 while stopped*/
+	int getPort() const
+	{
+		return mPort;
+	};
+
+	int getNumConnections()		{ return mNumConnections.get(); };
+	int getNumRequests()		{ return mNumRequests.get(); };
+
+private:
+	//-----------------------------------------------------------------------
+	class Reporter : public InterprocessConnection
+	{
+	public:
+		Reporter(TelemetryServer& owner) : InterprocessConnection(false,TELEMETRY_CONNECTION_MAGIC),
+			mOwner(owner),
+			mConnected(false)
+		{
+			takeTotals();
+		};
+
+		~Reporter()
+		{
+			//connectionLost() is still called from here
+			disconnect();
+		};
+
+		void connectionMade()
+		{
+			mConnected = true;
+			++mOwner.mNumConnections;
+		};
+
+		void connectionLost()
+		{
+			if(mConnected) --mOwner.mNumConnections;
+			mConnected = false;
+		};
+
+		void messageReceived(const MemoryBlock&)
+		{
+			++mOwner.mNumRequests;
+			const String report(getReport());
+			sendMessage(MemoryBlock(report.toUTF8(),report.getNumBytesAsUTF8()));
+		};
+
+	private:
+		String getReport()
+		{
+			int before[NUM_TELEMETRY_COUNTERS];
+			memcpy(before,mTotals,sizeof(before));
+			const uint32 beforeTime = mTime;
+			takeTotals();
+			const double seconds = jmax((uint32)1,mTime - beforeTime) * 0.001;
+
+			String report;
+			for(int i=0;i<NUM_TELEMETRY_COUNTERS;i++)
+			{
+				const String name(Telemetry::getName(i));
+				//the totals wrap, their difference doesn't
+				const uint32 delta = (uint32)mTotals[i] - (uint32)before[i];
+				report << name << " " << (int)mTotals[i] << "\n" << name << "_per_sec " << String(delta/seconds,1) << "\n";
+			}
+
+			MidiTransmitter* transmitter = MidiTransmitter::getInstanceWithoutCreating();
+			if(transmitter != NULL)
+			{
+				report << "midi.queue.interactive " << transmitter->getQueueDepth(PRIORITY_INTERACTIVE) << "\n"
+					<< "midi.queue.bulk " << transmitter->getQueueDepth(PRIORITY_BULK) << "\n"
+					<< "midi.drain_ms " << String(transmitter->getEstimatedDrainTime(),1) << "\n";
+			}
+
+			for(int i=0;i<NUM_MEMORY_TAGS;i++)
+			{
+				const String name(String("memory.") + MemoryAccounting::getTagName(i));
+				report << name << ".bytes " << MemoryAccounting::getLiveBytes(i) << "\n"
+					<< name << ".peak " << MemoryAccounting::getPeakBytes(i) << "\n";
+			}
+			report << "telemetry.connections " << mOwner.getNumConnections() << "\n";
+			return report;
+		};
+
+		void takeTotals()
+		{
+			mTime = Time::getMillisecondCounter();
+			for(int i=0;i<NUM_TELEMETRY_COUNTERS;i++)
+			{
+				mTotals[i] = Telemetry::get(i);
+			}
+		};
+
+		TelemetryServer& mOwner;
+		bool mConnected;
+		uint32 mTime;							// of the totals
+		int mTotals[NUM_TELEMETRY_COUNTERS];	// at the previous request, the rates are taken from them
+	};
+	//-----------------------------------------------------------------------
+
+	/** on the listener thread. A scraper connects again and again, so the closed connections go here*/
+	InterprocessConnection* createConnectionObject()
+	{
+		Reporter* reporter = new Reporter(*this);
+		const ScopedLock sl(mLock);
+		for(int i=mConnections.size();--i>=0;)
+		{
+			if(!mConnections.getUnchecked(i)->isConnected()) mConnections.remove(i);
+		}
+		mConnections.add(reporter);
+		return reporter;
+	};
+
+	CriticalSection mLock;
+	OwnedArray<Reporter> mConnections;	// the closed ones stay until the next connection is made
+	int mPort;
+
+	Atomic<int> mNumConnections;
+	Atomic<int> mNumRequests;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,245 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./FlatHashMap.h"
+
+#define GLYPH_METRICS_FIRST_CHAR	32		// the printable ASCII characters are measured
+#define GLYPH_METRICS_NUM_CHARS		95
+#define GLYPH_METRICS_NO_PAIR		-1.0e6f	// the typeface doesn't lay the two characters out as two glyphs
+#define TEXT_LAYOUT_CACHE_SIZE		1024	// layouts kept by the look and feel, the cache starts over when it is full
+
+//---------------------------------------------------------------------------
+/** The glyph numbers and advances of the printable ASCII characters in one
+	typeface style, measured once so a line of text is laid out without
+	asking the typeface.
+
+	The advance of a character is taken with the character that follows it,
+	so the kerning pairs are included. Like the metrics of a Typeface they
+	are for a font height of 1, Font::getGlyphPositions() scales them, so one
+	table serves every size of the style. The constructor measures with a
+	typeface of its own instead of the one Font shares, juce's typeface cache
+	has no lock, so it can run on any thread while the windows are painted.
+*/
+class GlyphMetrics : public ReferenceCountedObject
+{
+public:
+	typedef ReferenceCountedObjectPtr<GlyphMetrics> Ptr;
+
+	GlyphMetrics(const Font& font) :
+		mTypefaceName(font.getTypefaceName()),
+		mStyleFlags(font.getStyleFlags() & (Font::bold | Font::italic))
+	{
+		Typeface::Ptr typeface(Typeface::createSystemTypefaceFor(withPlatformName(font)));
+
+		Array<int> glyphs;
+		Array<float> xOffsets;
+		for(int a=0;a<GLYPH_METRICS_NUM_CHARS;a++)
+		{
+			const String first(String::charToString((juce_wchar)(GLYPH_METRICS_FIRST_CHAR + a)));
+			glyphs.clearQuick();
+			xOffsets.clearQuick();
+			typeface->getGlyphPositions(first,glyphs,xOffsets);
+			const bool valid = glyphs.size() == 1 && xOffsets.size() == 2;
+			mGlyphs[a] = valid ? glyphs[0] : -1;
+			mAdvances[a][GLYPH_METRICS_NUM_CHARS] = valid ? xOffsets[1] : GLYPH_METRICS_NO_PAIR;
+
+			for(int b=0;b<GLYPH_METRICS_NUM_CHARS;b++)
+			{
+				glyphs.clearQuick();
+				xOffsets.clearQuick();
+				typeface->getGlyphPositions(first + String::charToString((juce_wchar)(GLYPH_METRICS_FIRST_CHAR + b)),glyphs,xOffsets);
+				//a ligature is left to the typeface
+				mAdvances[a][b] = glyphs.size() == 2 && xOffsets.size() == 3 ? xOffsets[1] : GLYPH_METRICS_NO_PAIR;
+			}
+		}
+	};
+
+	/** same typeface and style, the size doesn't matter*/
+	bool isFor(const Font& font) const
+	{
+		return (font.getStyleFlags() & (Font::bold | Font::italic)) == mStyleFlags && font.getTypefaceName() == mTypefaceName;
+	};
+
+	/** the same as Font::getGlyphPositions() of a font isFor() is true for.
+		false if text has a character that isn't in the table*/
+	bool getGlyphPositions(const Font& font, const String& text, Array<int>& glyphs, Array<float>& xOffsets) const
+	{
+		const int numChars = text.length();
+		HeapBlock<int> chars(numChars + 1);
+		String::CharPointerType t(text.getCharPointer());
+		for(int i=0;i<numChars;i++)
+		{
+			chars[i] = (int)t.getAndAdvance() - GLYPH_METRICS_FIRST_CHAR;
+			if(chars[i] < 0 || chars[i] >= GLYPH_METRICS_NUM_CHARS || mGlyphs[chars[i]] < 0) return false;
+		}
+		chars[numChars] = GLYPH_METRICS_NUM_CHARS;
+
+		//the sum is taken in the order the typeface adds them up
+		const float scale = font.getHeight() * font.getHorizontalScale();
+		const float kerning = font.getExtraKerningFactor();
+		glyphs.ensureStorageAllocated(glyphs.size() + numChars);
+		xOffsets.ensureStorageAllocated(xOffsets.size() + numChars + 1);
+		float x = 0;
+		for(int i=0;i<numChars;i++)
+		{
+			const float advance = mAdvances[chars[i]][chars[i+1]];
+			if(advance == GLYPH_METRICS_NO_PAIR) return false;
+			glyphs.add(mGlyphs[chars[i]]);
+			xOffsets.add((x + i*kerning) * scale);
+			x += advance;
+		}
+		xOffsets.add((x + numChars*kerning) * scale);
+		return true;
+	};
+
+private:
+	/** the LookAndFeel puts the platform fonts in for the default names, see LookAndFeel::getTypefaceForFont()*/
+	static Font withPlatformName(const Font& font)
+	{
+		String sans, serif, fixed, fallback;
+		Font::getPlatformDefaultFontNames(sans,serif,fixed,fallback);
+
+		Font f(font);
+		if(font.getTypefaceName() == Font::getDefaultSansSerifFontName()) f.setTypefaceName(sans);
+		else if(font.getTypefaceName() == Font::getDefaultSerifFontName()) f.setTypefaceName(serif);
+		else if(font.getTypefaceName() == Font::getDefaultMonospacedFontName()) f.setTypefaceName(fixed);
+		return f;
+	};
+
+	const String mTypefaceName;		// as the Font has it, the default names aren't replaced
+	const int mStyleFlags;
+	int mGlyphs[GLYPH_METRICS_NUM_CHARS];										// -1 if the typeface has none
+	float mAdvances[GLYPH_METRICS_NUM_CHARS][GLYPH_METRICS_NUM_CHARS + 1];	// [char][next char], the last one for the end of the text
+};
+
+//---------------------------------------------------------------------------
+/** The laid out texts of the labels, combo boxes and slider text boxes.
+
+	Graphics::drawFittedText() asks the typeface for the glyph positions of
+	the text every time it is painted, and the first paint of a voice panel
+	after a tab switch lays out dozens of texts at once. Here the layout of
+	each text, font and box is kept, further paints only draw it. A new
+	layout takes its glyph positions from the GlyphMetrics of its style if
+	the StartupLoader has measured it, otherwise, and for the texts that
+	don't fit on one line, it is laid out by GlyphArrangement as before.
+	Only used on the message thread.
+*/
+class TextLayoutCache
+{
+public:
+	TextLayoutCache() : mIndex(TEXT_LAYOUT_CACHE_SIZE)
+	{
+	};
+
+	void setGlyphMetrics(const ReferenceCountedArray<GlyphMetrics>& metrics)
+	{
+		mMetrics = metrics;
+	};
+
+	/** draws like Graphics::drawFittedText() with font*/
+	void drawFittedText(Graphics& g, const Font& font, const String& text, int x, int y, int width, int height,
+		const Justification& justification, int maximumNumberOfLines, float minimumHorizontalScale)
+	{
+		if(text.isEmpty() || width <= 0 || height <= 0 || !g.clipRegionIntersects(Rectangle<int>(x,y,width,height))) return;
+
+		String key(text);
+		key << '\n' << font.getTypefaceName() << ' ' << font.getStyleFlags() << ' ' << font.getHeight() << ' ' << font.getHorizontalScale()
+			<< ' ' << font.getExtraKerningFactor() << ' ' << x << ' ' << y << ' ' << width << ' ' << height << ' '
+			<< justification.getFlags() << ' ' << maximumNumberOfLines << ' ' << minimumHorizontalScale;
+
+		const int* index = mIndex.find(key);
+		if(index != NULL)
+		{
+			mLayouts.getUnchecked(*index)->draw(g);
+			return;
+		}
+
+		if(mLayouts.size() >= TEXT_LAYOUT_CACHE_SIZE)
+		{
+			mIndex.clear();
+			mLayouts.clear();
+		}
+		GlyphArrangement* layout = new GlyphArrangement();
+		if(!addSingleLine(*layout,font,text,(float)x,(float)y,(float)width,(float)height,justification,minimumHorizontalScale))
+		{
+			layout->addFittedText(font,text,(float)x,(float)y,(float)width,(float)height,justification,maximumNumberOfLines,minimumHorizontalScale);
+		}
+		mIndex.set(key,mLayouts.size());
+		mLayouts.add(layout);
+		layout->draw(g);
+	};
+
+private:
+	/** the first case of GlyphArrangement::addFittedText(), a line that fits with the minimum scale.
+		false if the metrics can't do it*/
+	bool addSingleLine(GlyphArrangement& layout, const Font& font, const String& text, float x, float y, float width, float height,
+		const Justification& justification, float minimumHorizontalScale)
+	{
+		if(text.containsAnyOf("\r\n")) return false;
+
+		const GlyphMetrics* metrics = NULL;
+		for(int i=0;i<mMetrics.size() && metrics == NULL;i++)
+		{
+			if(mMetrics.getUnchecked(i)->isFor(font)) metrics = mMetrics.getUnchecked(i);
+		}
+		if(metrics == NULL) return false;
+
+		const String line(text.trim());
+		mGlyphs.clearQuick();
+		mXOffsets.clearQuick();
+		if(!metrics->getGlyphPositions(font,line,mGlyphs,mXOffsets)) return false;
+		const int numGlyphs = mGlyphs.size();
+		if(numGlyphs == 0) return true;
+
+		String::CharPointerType t(line.getCharPointer());
+		for(int i=0;i<numGlyphs;i++)
+		{
+			const bool isWhitespace = t.isWhitespace();
+			layout.addGlyph(PositionedGlyph(font,t.getAndAdvance(),mGlyphs.getUnchecked(i),x + mXOffsets.getUnchecked(i),y,
+				mXOffsets.getUnchecked(i+1) - mXOffsets.getUnchecked(i),isWhitespace));
+		}
+
+		//measured on the glyphs like addFittedText() does, so a line breaks at the same width
+		const float lineWidth = layout.getGlyph(numGlyphs-1).getRight() - layout.getGlyph(0).getLeft();
+		if(lineWidth <= 0) return true;
+		if(lineWidth * minimumHorizontalScale >= width)
+		{
+			layout.clear();
+			return false;
+		}
+		if(lineWidth > width) layout.stretchRangeOfGlyphs(0,numGlyphs,width / lineWidth);
+		layout.justifyGlyphs(0,numGlyphs,x,y,width,height,justification);
+		return true;
+	};
+
+	ReferenceCountedArray<GlyphMetrics> mMetrics;
+	FlatHashMap<String,int> mIndex;		// text, font and box -> index in mLayouts
+	OwnedArray<GlyphArrangement> mLayouts;
+	Array<int> mGlyphs;					// kept for the next layout
+	Array<float> mXOffsets;
+};
+//---------------------------------------------------------------------------
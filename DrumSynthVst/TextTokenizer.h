@@ -0,0 +1,190 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+
+#define TEXT_LINE_SEPARATORS	"\r\n"
+
+//---------------------------------------------------------------------------
+/** A piece of a text that a TextTokenizer found. It points into the text,
+	isn't 0 terminated and is only valid while the text is.
+*/
+struct TextToken
+{
+	const char* text;
+	int length;
+
+	/** ASCII letters are compared without case, like the names of a list*/
+	bool equalsIgnoreCase(const TextToken& other) const
+	{
+		if(length != other.length) return false;
+		for(int i=0;i<length;i++)
+		{
+			if(toLower(text[i]) != toLower(other.text[i])) return false;
+		}
+		return true;
+	};
+
+	static char toLower(char c)
+	{
+		return c >= 'A' && c <= 'Z' ? (char)(c + 32) : c;
+	};
+
+	/** nothing but spaces and tabs*/
+	bool isBlank() const
+	{
+		for(int i=0;i<length;i++)
+		{
+			if(text[i] != ' ' && text[i] != '\t') return false;
+		}
+		return true;
+	};
+
+	/** for the UI, e.g. an error message*/
+	String toString() const
+	{
+		return String::fromUTF8(text,length);
+	};
+};
+
+//---------------------------------------------------------------------------
+/** What happens to each byte of a text when it is filtered: removed or
+	replaced by another byte. One table lookup per byte instead of a search
+	through the characters to remove.
+*/
+class CharacterTable
+{
+public:
+	/** every byte stays as it is*/
+	CharacterTable()
+	{
+		for(int i=0;i<256;i++)
+		{
+			mMap[i] = (uint8_t)i;
+		}
+		mMap[0] = 0;
+	};
+
+	/** the characters are dropped*/
+	CharacterTable& remove(const char* characters)
+	{
+		for(;*characters != 0;characters++)
+		{
+			mMap[(uint8_t)*characters] = 0;
+		}
+		return *this;
+	};
+
+	/** every byte is dropped but first..last, they are mapped to the bytes from to on*/
+	CharacterTable& keepOnly(char first, char last, char to)
+	{
+		for(int i=0;i<256;i++)
+		{
+			if(i < (uint8_t)first || i > (uint8_t)last) mMap[i] = 0;
+		}
+		return map(first,last,to);
+	};
+
+	/** first..last are mapped to the bytes from to on*/
+	CharacterTable& map(char first, char last, char to)
+	{
+		for(int i=(uint8_t)first;i<=(uint8_t)last;i++)
+		{
+			mMap[i] = (uint8_t)((uint8_t)to + i - (uint8_t)first);
+		}
+		return *this;
+	};
+
+	/** the filtered token in dest, at most maxLength bytes. returns the number of bytes written*/
+	int apply(const TextToken& token, char* dest, int maxLength) const
+	{
+		int length = 0;
+		for(int i=0;i<token.length && length < maxLength;i++)
+		{
+			const uint8_t c = mMap[(uint8_t)token.text[i]];
+			if(c != 0) dest[length++] = (char)c;
+		}
+		return length;
+	};
+
+private:
+	uint8_t mMap[256];	// 0 drops the byte
+};
+
+//---------------------------------------------------------------------------
+/** Splits a text in memory, e.g. a mapped file or an embedded resource,
+	into the runs of bytes between separators, in a single pass.
+
+	StringArray::addLines() and addTokens() make a String for every line
+	and then another one for every token, and filtering a String makes a
+	third. Here a token is only a pointer and a length, the name lists are
+	read without a single allocation per name. Empty tokens are skipped,
+	TEXT_LINE_SEPARATORS as separators gives the lines that aren't empty.
+	The bytes are taken as they are, UTF-8 text stays UTF-8.
+*/
+class TextTokenizer
+{
+public:
+	TextTokenizer(const void* text, size_t size, const char* separators) :
+		mPos((const char*)text),
+		mEnd((const char*)text + size)
+	{
+		zerostruct(mSeparators);
+		for(;*separators != 0;separators++)
+		{
+			mSeparators[(uint8_t)*separators] = true;
+		}
+	};
+
+	/** false when the text is done*/
+	bool next(TextToken& token)
+	{
+		while(mPos < mEnd && mSeparators[(uint8_t)*mPos]) mPos++;
+		if(mPos == mEnd) return false;
+
+		token.text = mPos;
+		while(mPos < mEnd && !mSeparators[(uint8_t)*mPos]) mPos++;
+		token.length = (int)(mPos - token.text);
+		return true;
+	};
+
+	/** adds the tokens that are left*/
+	void getTokens(Array<TextToken>& tokens)
+	{
+		TextToken token;
+		while(next(token))
+		{
+			tokens.add(token);
+		}
+	};
+
+private:
+	const char* mPos;
+	const char* const mEnd;
+	bool mSeparators[256];
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+// the juce priorities of the threads of the editor. Above 6 they are realtime where the
+// system allows it, at 6 and below the message thread (5) shares the cpu with them by
+// priority, so nothing below it can hold up an edit
+#define PRIORITY_CLASS_AUDIO		9	// renders sound for a device
+#define PRIORITY_CLASS_MIDI			8	// sends and receives MIDI, an edit waits for it
+#define PRIORITY_CLASS_UI			5	// works for what is on screen, like the message thread
+#define PRIORITY_CLASS_BACKGROUND	3	// long work the user started, e.g. breeding
+#define PRIORITY_CLASS_IDLE			1	// work ahead that nobody waits for yet
+
+#define USER_ACTIVITY_EDIT_MS		300		// the background pauses this long after an edit
+#define USER_ACTIVITY_AUDITION_MS	1200	// and this long after a sound started
+#define USER_ACTIVITY_POLL_MS		20		// how often a paused thread looks again
+#define USER_ACTIVITY_MAX_MS		10000	// longer ahead than any mark, so a counter that wrapped isn't taken for one
+
+//---------------------------------------------------------------------------
+/** Tells the background threads when the user is editing or listening.
+
+	A lower priority only helps while the cpus are busy. The threads of a
+	breeding run fill every cpu, and the edits of a knob drag still have to
+	wait for the scheduler to get to the message thread. So the edits and
+	the preview sounds mark the user as active for a moment, and the
+	background work pauses in pauseIfActive() until the user has been
+	still for that long. Any thread, nothing is locked.
+*/
+class UserActivity
+{
+public:
+	/** a value was edited in the UI*/
+	static void edited()
+	{
+		activeFor(USER_ACTIVITY_EDIT_MS);
+	};
+
+	/** a sound starts after delayMs*/
+	static void auditioned(double delayMs)
+	{
+		activeFor(jmin(USER_ACTIVITY_AUDITION_MS + (int)delayMs, USER_ACTIVITY_MAX_MS));
+	};
+
+	static bool isActive()
+	{
+		const int remaining = sActiveUntil.get() - (int)Time::getMillisecondCounter();
+		return remaining > 0 && remaining <= USER_ACTIVITY_MAX_MS;
+	};
+
+	/** sleeps for one poll while the user is active, false if not. A background
+		loop calls it until it returns false or the work was cancelled*/
+	static bool pauseIfActive()
+	{
+		if(!isActive()) return false;
+		Thread::sleep(USER_ACTIVITY_POLL_MS);
+		return true;
+	};
+
+private:
+	static void activeFor(int ms)
+	{
+		const int until = (int)Time::getMillisecondCounter() + ms;
+		for(;;)
+		{
+			const int current = sActiveUntil.get();
+			if(current - until >= 0 || sActiveUntil.compareAndSetBool(until,current)) return;
+		}
+	};
+
+	static Atomic<int> sActiveUntil;	// millisecond counter, compared by the difference so it may wrap
+};
+//---------------------------------------------------------------------------
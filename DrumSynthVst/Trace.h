@@ -0,0 +1,268 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+// TRACE_SCOPE() compiles to nothing unless the build sets this to 1
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED				0
+#endif
+
+#define TRACE_EVENTS_PER_THREAD		16384	// the newest events of every thread are kept, a power of 2
+#define TRACE_MAX_THREADS			64		// threads beyond this aren't traced
+
+//---------------------------------------------------------------------------
+/** one timed scope, the strings are literals and only their pointers are kept*/
+struct TraceEvent
+{
+	const char* category;
+	const char* name;
+	int64 start;		// high resolution ticks
+	int64 end;
+};
+
+//---------------------------------------------------------------------------
+/** Records TRACE_SCOPE()s of all threads and writes them in the Chrome
+	trace event format, for chrome://tracing or ui.perfetto.dev.
+
+	Every thread writes into a ring buffer of its own, so recording an event
+	takes no lock: the thread looks up its buffer, fills the next slot and
+	publishes it with one atomic store. A thread gets its buffer the first
+	time it records, under a lock, and keeps it. The ring keeps the newest
+	TRACE_EVENTS_PER_THREAD events, writeJson() can be called while the
+	threads go on recording, events that were overwritten during the copy
+	are left out.
+
+	Nothing is recorded before setRecording(true), then a scope costs two
+	reads of the high resolution counter.
+*/
+class Tracer
+{
+public:
+	Tracer() : mRecording(0)
+	{
+		mStartTicks = Time::getHighResolutionTicks();
+	};
+
+	~Tracer()
+	{
+		for(int i=0;i<mNumThreads.get();i++)
+		{
+			delete mThreads[i];
+		}
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (Tracer, false)
+
+	/** starting clears what was recorded before*/
+	void setRecording(bool recording)
+	{
+		if(recording && !isRecording())
+		{
+			const SpinLock::ScopedLockType lock(mThreadLock);
+			for(int i=0;i<mNumThreads.get();i++)
+			{
+				mThreads[i]->numWritten.set(0);
+			}
+			mStartTicks = Time::getHighResolutionTicks();
+		}
+		mRecording.set(recording ? 1 : 0);
+	};
+
+	bool isRecording() const
+	{
+		return mRecording.get() != 0;
+	};
+
+	/** any thread, called by TraceScope*/
+	void add(const char* category, const char* name, int64 start, int64 end)
+	{
+		ThreadBuffer* buffer = getThreadBuffer();
+		if(buffer == NULL) return;
+
+		const int n = buffer->numWritten.get();
+		TraceEvent& event = buffer->events[n & (TRACE_EVENTS_PER_THREAD-1)];
+		event.category = category;
+		event.name = name;
+		event.start = start;
+		event.end = end;
+		buffer->numWritten.set(n+1);
+	};
+
+	/** {"traceEvents":[...]} with a complete event per scope and the names of the threads*/
+	bool writeJson(const File& file)
+	{
+		TemporaryFile temp(file);
+		{
+			FileOutputStream out(temp.getFile());
+			if(out.getStatus().failed()) return false;
+
+			out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			bool first = true;
+			HeapBlock<TraceEvent> events(TRACE_EVENTS_PER_THREAD);
+			const int numThreads = mNumThreads.get();
+			for(int t=0;t<numThreads;t++)
+			{
+				ThreadBuffer& buffer = *mThreads[t];
+				if(!first) out << ",\n";
+				first = false;
+				out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << (t+1)
+					<< ",\"args\":{\"name\":\"" << buffer.name << "\"}}";
+
+				const int num = copyEvents(buffer,events);
+				for(int i=0;i<num;i++)
+				{
+					const TraceEvent& e = events[i];
+					out << ",\n{\"ph\":\"X\",\"cat\":\"" << e.category << "\",\"name\":\"" << e.name
+						<< "\",\"pid\":1,\"tid\":" << (t+1)
+						<< ",\"ts\":" << String(ticksToMicroseconds(e.start-mStartTicks),3)
+						<< ",\"dur\":" << String(ticksToMicroseconds(e.end-e.start),3) << "}";
+				}
+			}
+			out << "\n]}\n";
+
+			out.flush();
+			if(out.getStatus().failed()) return false;
+		}
+		return temp.overwriteTargetFileWithTemporary();
+	};
+
+private:
+	struct ThreadBuffer
+	{
+		ThreadBuffer(Thread::ThreadID threadId, const String& threadName)
+		: id(threadId),
+		name(threadName),
+		events(TRACE_EVENTS_PER_THREAD)
+		{
+		};
+
+		const Thread::ThreadID id;
+		const String name;
+		HeapBlock<TraceEvent> events;
+		Atomic<int> numWritten;		// the slot of event n is n & (TRACE_EVENTS_PER_THREAD-1)
+	};
+
+	ThreadBuffer* getThreadBuffer()
+	{
+		const Thread::ThreadID id = Thread::getCurrentThreadId();
+		const int numThreads = mNumThreads.get();
+		for(int i=0;i<numThreads;i++)
+		{
+			if(mThreads[i]->id == id) return mThreads[i];
+		}
+		return addThread(id);
+	};
+
+	/** the lock only keeps two new threads from taking the same entry,
+		mNumThreads publishes the buffer to the lookup of the others*/
+	ThreadBuffer* addThread(Thread::ThreadID id)
+	{
+		const SpinLock::ScopedLockType lock(mThreadLock);
+		const int numThreads = mNumThreads.get();
+		if(numThreads == TRACE_MAX_THREADS) return NULL;
+
+		mThreads[numThreads] = new ThreadBuffer(id,getThreadName(numThreads));
+		mNumThreads.set(numThreads+1);
+		return mThreads[numThreads];
+	};
+
+	static String getThreadName(int index)
+	{
+		if(MessageManager::getInstance()->isThisTheMessageThread()) return "message thread";
+
+		Thread* thread = Thread::getCurrentThread();
+		if(thread != NULL) return thread->getThreadName() + " " + String(index+1);
+		return "thread " + String(index+1);
+	};
+
+	/** the events still in the ring, oldest first. returns how many*/
+	static int copyEvents(ThreadBuffer& buffer, TraceEvent* dest)
+	{
+		const int end = buffer.numWritten.get();
+		const int begin = jmax(0,end-TRACE_EVENTS_PER_THREAD);
+		for(int i=begin;i<end;i++)
+		{
+			dest[i-begin] = buffer.events[i & (TRACE_EVENTS_PER_THREAD-1)];
+		}
+
+		//the thread went on writing meanwhile, the slots it reused may be torn
+		const int overwritten = buffer.numWritten.get() - TRACE_EVENTS_PER_THREAD + 1;
+		if(overwritten <= begin) return end-begin;
+
+		const int skip = jmin(end,overwritten) - begin;
+		memmove(dest,dest+skip,(end-begin-skip)*sizeof(TraceEvent));
+		return end-begin-skip;
+	};
+
+	static double ticksToMicroseconds(int64 ticks)
+	{
+		return Time::highResolutionTicksToSeconds(ticks)*1.0e6;
+	};
+
+	Atomic<int> mRecording;
+	int64 mStartTicks;
+	SpinLock mThreadLock;
+	ThreadBuffer* mThreads[TRACE_MAX_THREADS];	// the first mNumThreads are set
+	Atomic<int> mNumThreads;
+};
+
+//---------------------------------------------------------------------------
+/** records the time from its construction to its destruction, use it through TRACE_SCOPE()*/
+class TraceScope
+{
+public:
+	TraceScope(const char* category, const char* name)
+	: mCategory(category),
+	mName(name),
+	mStart(0)
+	{
+		//no Tracer is made here, the menu or the -trace argument makes it
+		mTracer = Tracer::getInstanceWithoutCreating();
+		if(mTracer != NULL && !mTracer->isRecording()) mTracer = NULL;
+		if(mTracer != NULL) mStart = Time::getHighResolutionTicks();
+	};
+
+	~TraceScope()
+	{
+		if(mTracer != NULL) mTracer->add(mCategory,mName,mStart,Time::getHighResolutionTicks());
+	};
+
+private:
+	Tracer* mTracer;
+	const char* mCategory;
+	const char* mName;
+	int64 mStart;
+};
+
+/** times the rest of the enclosing block, category and name have to be string literals*/
+#if TRACE_ENABLED
+#define TRACE_SCOPE(category,name)	const TraceScope JUCE_JOIN_MACRO(traceScope,__LINE__)(category,name)
+#else
+#define TRACE_SCOPE(category,name)
+#endif
+//---------------------------------------------------------------------------
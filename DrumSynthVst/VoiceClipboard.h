@@ -0,0 +1,144 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./controllerAssignments.h"
+#include "./parameterRanges.h"
+#include "./Patch.h"
+#include "./ParameterStore.h"
+
+#define LFO_VOICE_CONTROL	35	// selecting the LFO voice changes the targets of
+#define LFO_TARGET_CONTROL	36	// the LFO target combo
+#define VELO_TARGET_CONTROL	13
+
+//---------------------------------------------------------------------------
+/** Copies, pastes and swaps the settings of whole voices.
+
+	The voices line up by their 1 based control index into controllerAssignments,
+	a control is taken over where it has the same type and range on both
+	voices, see mapParameter(). The ganged edits of the VoicePanel use the
+	same mapping. An operation builds the new sound in a Patch and loads it
+	with ParameterStore::loadFromPatch(), so it is undone in one step
+	and goes to the synth as one diff, or as a dump if that is shorter,
+	instead of one message per control. Message thread only.
+*/
+class VoiceClipboard
+{
+public:
+	VoiceClipboard() : mVoiceNr(-1)
+	{
+	};
+
+	/** the parameter of voice to that means the same as the control of voice from, NONE if there is none.
+		The targets and the LFO voice are numbered per voice, they only map onto the same voice*/
+	static int mapParameter(int controlNr, int from, int to)
+	{
+		const int source = controllerAssignments[from][controlNr-1];
+		const int dest = controllerAssignments[to][controlNr-1];
+		if(source == NONE || dest == NONE) return NONE;
+		if(from == to) return dest;
+
+		if(controlNr == VELO_TARGET_CONTROL || controlNr == LFO_VOICE_CONTROL || controlNr == LFO_TARGET_CONTROL) return NONE;
+		if(getControlType(controlNr,from) != getControlType(controlNr,to)) return NONE;
+		const ParameterRange& a = getParameterRange(source);
+		const ParameterRange& b = getParameterRange(dest);
+		if(a.min != b.min || a.max != b.max) return NONE;
+		return dest;
+	};
+
+	/** keeps the current values of the voice*/
+	void copy(int voiceNr)
+	{
+		getControls(voiceNr,mControls);
+		mVoiceNr = voiceNr;
+	};
+
+	bool canPaste() const
+	{
+		return mVoiceNr >= 0;
+	};
+
+	/** the copied voice, -1 before the first copy*/
+	int getVoice() const
+	{
+		return mVoiceNr;
+	};
+
+	/** the copied values onto a voice, returns the number of changed values*/
+	int paste(int voiceNr)
+	{
+		if(!canPaste()) return 0;
+
+		ParameterStore* store = ParameterStore::getInstance();
+		Patch patch;
+		store->storeToPatch(&patch);
+		setControls(patch,mControls,mVoiceNr,voiceNr);
+		return store->loadFromPatch(&patch,true);
+	};
+
+	/** exchanges the values of two voices, returns the number of changed values*/
+	static int swap(int a, int b)
+	{
+		if(a == b) return 0;
+
+		uint8_t controlsA[MAX_CONTROLS];
+		uint8_t controlsB[MAX_CONTROLS];
+		getControls(a,controlsA);
+		getControls(b,controlsB);
+
+		ParameterStore* store = ParameterStore::getInstance();
+		Patch patch;
+		store->storeToPatch(&patch);
+		setControls(patch,controlsA,a,b);
+		setControls(patch,controlsB,b,a);
+		return store->loadFromPatch(&patch,true);
+	};
+
+private:
+	/** the stored values of a voice by control, 0 where the voice has no control*/
+	static void getControls(int voiceNr, uint8_t* controls)
+	{
+		const uint8_t* values = ParameterStore::getInstance()->getValues();
+		for(int i=0;i<MAX_CONTROLS;i++)
+		{
+			const int parameterNr = controllerAssignments[voiceNr][i];
+			controls[i] = parameterNr != NONE ? values[parameterNr] : 0;
+		}
+	};
+
+	static void setControls(Patch& patch, const uint8_t* controls, int from, int to)
+	{
+		for(int i=1;i<=MAX_CONTROLS;i++)
+		{
+			const int parameterNr = mapParameter(i,from,to);
+			if(parameterNr != NONE) patch.setParameter(parameterNr,controls[i-1]);
+		}
+	};
+
+	int mVoiceNr;
+	uint8_t mControls[MAX_CONTROLS];
+};
+//---------------------------------------------------------------------------
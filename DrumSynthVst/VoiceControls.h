@@ -0,0 +1,112 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./controllerAssignments.h"
+#include "./parameterLocations.h"
+#include "./ComboItemModels.h"
+
+//---------------------------------------------------------------------------
+/** The controls of one voice component, indexed by control number.
+	The controls are named by their 1 based index into controllerAssignments.
+*/
+class VoiceControls
+{
+public:
+	VoiceControls()
+	{
+		for(int i=0;i<=MAX_CONTROLS;i++)
+		{
+			mControls[i] = NULL;
+		}
+	};
+
+	/** look up all controls once after the voice component created its children*/
+	void init(Component* voiceComponent)
+	{
+		for(int i=1;i<=MAX_CONTROLS;i++)
+		{
+			mControls[i] = findControl(voiceComponent,i);
+		}
+	};
+
+	/** for controls that are created in code instead of looked up by name*/
+	void setControl(int controlNr, Component* control)
+	{
+		jassert(controlNr >= 1 && controlNr <= MAX_CONTROLS);
+		mControls[controlNr] = control;
+	};
+
+	/** returns the control with the given 1 based index or NULL*/
+	Component* getControl(int controlNr)
+	{
+		if(controlNr < 1 || controlNr > MAX_CONTROLS) return NULL;
+		return mControls[controlNr];
+	};
+
+	/** returns the child of a voice component named controlNr or NULL*/
+	static Component* findControl(Component* voiceComponent, int controlNr)
+	{
+		const String name(controlNr);
+		for(int j=0;j<voiceComponent->getNumChildComponents();j++)
+		{
+			Component* child = voiceComponent->getChildComponent(j);
+			if(child->getName() == name)
+			{
+				return child;
+			}
+		}
+		return NULL;
+	};
+
+	/** show a value as sent by the synth (0-127, PM63 offset by 63) without sending it back*/
+	static void showValue(Component* control, int controlType, int value)
+	{
+		switch(controlType)
+		{
+		case TYPE_SLIDER:
+			{
+			Slider* slider = (Slider*)control;
+			const int min = (int)slider->getMinimum();
+			if(min<0) value += min; //back from 0-127 to pm63 range
+			slider->setValue(value,false);
+			}
+			break;
+
+		case TYPE_BUTTON:
+			((Button*)control)->setToggleState(value != 0,false);
+			break;
+
+		case TYPE_COMBO:
+			((ComboBox*)control)->setSelectedId(ComboItemModel::valueToItemId(value),true);
+			break;
+		}
+	};
+
+private:
+	Component* mControls[MAX_CONTROLS+1];
+};
+//---------------------------------------------------------------------------
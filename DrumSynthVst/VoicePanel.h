@@ -0,0 +1,829 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./controllerAssignments.h"
+#include "./parameterRanges.h"
+#include "./Patch.h"
+#include "./ParameterStore.h"
+#include "./VoiceControls.h"
+#include "./ComboItemModels.h"
+#include "./VoiceClipboard.h"
+#include "./MemoryAccounting.h"
+#include "./Midi/LatencyMonitor.h"
+#include "./Midi/EditReplay.h"
+
+#define VOICE_PANEL_WIDTH	850
+#define VOICE_PANEL_HEIGHT	600
+
+// layout of the generated panel, a section is a header bar over one row of cells
+#define VOICE_MARGIN		16
+#define VOICE_SECTION_GAP	8
+#define VOICE_ROW_HEIGHT	144
+#define VOICE_HEADER_HEIGHT	24
+#define VOICE_LABEL_HEIGHT	24
+#define VOICE_SLIDER_CELL	52	// a 48x68 knob
+#define VOICE_COMBO_CELL	82	// a 78x24 combo box or toggle, 4 rows hold every voice
+#define VOICE_GANG_CELL		70	// a toggle of the voice gang
+
+#define TRANS_WAVE_CONTROL	22
+
+#define VOICE_TAB_PREWARM	1	// build the neighbours of a shown tab in the following message loop turns
+#define VOICE_BATCHED_KNOBS	1	// the panel draws all knobs in its own paint instead of every slider
+#define VOICE_DRAG_RATE_CAP_MS	0	// default minimum time between two sends of a dragged knob, 0 sends every step
+
+//---------------------------------------------------------------------------
+/** A rotary slider whose knob is drawn by its VoicePanel, only the text box paints itself.
+	The text box shows the texts of the ValueTextTable of the parameter*/
+class BatchedKnob : public Slider
+{
+public:
+	BatchedKnob(const String& name, int parameterNr)
+	: Slider(name),
+	mTexts(ComboItemModels::getInstance()->getValueTexts(parameterNr))
+	{
+	};
+
+	/** the shared text, nothing is formatted when the synth or a drag changes the value*/
+	const String getTextFromValue(double value)
+	{
+		return mTexts.getText(roundToInt(value));
+	};
+
+	void paint(Graphics& g)
+	{
+		if(!VOICE_BATCHED_KNOBS) Slider::paint(g);
+	};
+
+	/** the area Slider::paint draws the knob into, above the text box*/
+	Rectangle<int> getKnobBounds()
+	{
+		return Rectangle<int>(getX(),getY(),getWidth(),getHeight() - jmax(0,jmin(getTextBoxHeight(),getHeight()-15)));
+	};
+
+private:
+	const ValueTextTable& mTexts;	// the ComboItemModels outlive the windows
+};
+
+//---------------------------------------------------------------------------
+/** The voices that are edited together, shared by the VoicePanels of all
+	voices. Moving a control on a ganged voice sets it on every other ganged
+	voice too, see VoicePanel::sendValue(). Message thread only.
+*/
+class VoiceGang : public ChangeBroadcaster
+{
+public:
+	VoiceGang() : mMask(0)
+	{
+	};
+
+	bool contains(int voiceNr) const
+	{
+		return (mMask & (1<<voiceNr)) != 0;
+	};
+
+	void setVoice(int voiceNr, bool ganged)
+	{
+		const int mask = ganged ? (mMask | (1<<voiceNr)) : (mMask & ~(1<<voiceNr));
+		if(mask == mMask) return;
+		mMask = mask;
+		sendChangeMessage();
+	};
+
+private:
+	int mMask;
+};
+
+//---------------------------------------------------------------------------
+/** Decimates the value changes of dragged sliders, by 1 based control index.
+
+	A slider reports every mouse move, the synth only needs a new value
+	when the integer changes. pass() lets a value through if it differs
+	from the one sent last, and while a drag is going on not sooner than
+	the rate cap of the control after the previous send. A held back value
+	is kept and end() returns it, so the value a drag stops at is always
+	sent. Outside of drags only the equal values are dropped. Message
+	thread only.
+*/
+class SliderEdgeFilter
+{
+public:
+	SliderEdgeFilter()
+	{
+		for(int i=0;i<=MAX_CONTROLS;i++)
+		{
+			mSent[i] = -1;
+			mPending[i] = -1;
+			mRateCapMs[i] = VOICE_DRAG_RATE_CAP_MS;
+			mLastSend[i] = 0;
+			mDragging[i] = false;
+		}
+	};
+
+	/** the minimum milliseconds between two sends while a control is dragged, 0 for no cap*/
+	void setRateCap(int controlNr, int intervalMs)
+	{
+		mRateCapMs[controlNr] = jmax(0,intervalMs);
+	};
+
+	/** the value the synth has now, e.g. changed by the synth or the undo. A held back value stays*/
+	void setSent(int controlNr, int value)
+	{
+		mSent[controlNr] = value;
+	};
+
+	void begin(int controlNr)
+	{
+		mDragging[controlNr] = true;
+		mPending[controlNr] = -1;
+	};
+
+	/** true if value is to be sent now, it is then taken as sent*/
+	bool pass(int controlNr, int value)
+	{
+		if(value == mSent[controlNr])
+		{
+			mPending[controlNr] = -1;
+			return false;
+		}
+
+		const uint32 now = Time::getMillisecondCounter();
+		if(mDragging[controlNr] && mRateCapMs[controlNr] > 0 && now - mLastSend[controlNr] < (uint32)mRateCapMs[controlNr])
+		{
+			mPending[controlNr] = value;
+			return false;
+		}
+
+		mSent[controlNr] = value;
+		mPending[controlNr] = -1;
+		mLastSend[controlNr] = now;
+		return true;
+	};
+
+	/** ends a drag, the held back value that still has to be sent or -1*/
+	int end(int controlNr)
+	{
+		mDragging[controlNr] = false;
+		const int value = mPending[controlNr];
+		mPending[controlNr] = -1;
+		if(value < 0 || value == mSent[controlNr]) return -1;
+		mSent[controlNr] = value;
+		mLastSend[controlNr] = Time::getMillisecondCounter();
+		return value;
+	};
+
+private:
+	int mSent[MAX_CONTROLS+1];		// -1 before the first value
+	int mPending[MAX_CONTROLS+1];	// held back by the rate cap, -1 if none
+	int mRateCapMs[MAX_CONTROLS+1];
+	uint32 mLastSend[MAX_CONTROLS+1];
+	bool mDragging[MAX_CONTROLS+1];
+};
+
+static const char* const voiceNames[NUM_VOICES] = {"Drum 1","Drum 2","Drum 3","Snare","Cymbal","Hat"};
+
+//---------------------------------------------------------------------------
+/** a group of controls with a header, by 1 based control index*/
+struct VoiceSection
+{
+	const char* name;
+	int firstControl;
+	int lastControl;
+};
+
+// the groups of the controllerAssignments columns. A section without an
+// assigned parameter for a voice is left out
+static const VoiceSection voiceSections[] = {
+	{"Oscillator",			1,	5},
+	{"Amplitude Envelope",	6,	9},
+	{"Modulation EG",		10,	12},
+	{"Velocity Modulation",	13,	15},
+	{"FM",					16,	21},
+	{"Transient Generator",	22,	24},
+	{"Filter",				25,	28},
+	{"LFO",					29,	36},
+	{"Mixer",				37,	40},
+	{"Routing",				41,	41},
+};
+#define NUM_VOICE_SECTIONS ((int)(sizeof(voiceSections)/sizeof(voiceSections[0])))
+
+//---------------------------------------------------------------------------
+/** The editor of one voice, built at runtime.
+
+	Every assigned column of controllerAssignments gets a widget of the type
+	getControlType() returns, named by its 1 based index like VoiceControls
+	expects, and labelled with the name the synth shows in menuPages. The
+	widget callbacks look the control up in one table instead of comparing
+	against every member, so all voices share this one class.
+
+	The toggles after the last section gang voices together. An edit on a
+	ganged voice is set on all of them in one ParameterStore::setValueGroup(),
+	which sends them to the synth as one burst.
+
+	The background, the header bars and the labels never change between two
+	layouts, they are drawn into one image after a resize or a new look and
+	feel, and a paint only copies it under the knobs.
+*/
+class VoicePanel  : public Component,
+					public SliderListener,
+					public ButtonListener,
+					public ComboBoxListener,
+					public ChangeListener,
+					public ParameterStore::Listener
+{
+public:
+	VoicePanel(int voiceNr, VoiceGang& gang) : mVoiceNr(voiceNr), mGang(gang), mChromeMemory(MEMORY_IMAGES)
+	{
+		for(int i=0;i<=MAX_CONTROLS;i++)
+		{
+			mLabels[i] = NULL;
+		}
+
+		for(int s=0;s<NUM_VOICE_SECTIONS;s++)
+		{
+			addSection(voiceSections[s]);
+		}
+		addGangButtons();
+
+		ParameterStore* store = ParameterStore::getInstance();
+		for(int i=1;i<=MAX_CONTROLS;i++)
+		{
+			Component* control = mControls.getControl(i);
+			if(control != NULL)
+			{
+				const int parameterNr = getParameterNr(i);
+				VoiceControls::showValue(control,getControlType(i,mVoiceNr),store->getValue(parameterNr));
+				mEdges.setSent(i,store->getValue(parameterNr));
+			}
+		}
+		updateLfoTargets();
+
+		//the chrome covers every pixel
+		setOpaque(true);
+		setSize(VOICE_PANEL_WIDTH,VOICE_PANEL_HEIGHT);
+
+		store->addListener(this,GROUP_VOICE(mVoiceNr));
+		mGang.addChangeListener(this);
+	};
+
+	~VoicePanel()
+	{
+		mGang.removeChangeListener(this);
+		ParameterStore::getInstance()->removeListener(this);
+		deleteAllChildren();
+	};
+
+	/** the chrome is drawn as one image, only the knobs are drawn on every paint*/
+	void paint(Graphics& g)
+	{
+		if(mChrome.isNull() || mChrome.getWidth() != getWidth() || mChrome.getHeight() != getHeight()) renderChrome();
+		g.drawImageAt(mChrome,0,0);
+
+		if(VOICE_BATCHED_KNOBS) paintKnobs(g);
+	};
+
+	/** a new skin draws the labels differently*/
+	void lookAndFeelChanged()
+	{
+		releaseChrome();
+		repaint();
+	};
+
+	/** all knobs in one pass. A slider that changed repaints its area, which
+		includes this panel, so only the knobs inside the clip region are drawn*/
+	void paintKnobs(Graphics& g)
+	{
+		LookAndFeel& lookAndFeel = getLookAndFeel();
+		for(int i=0;i<mKnobs.size();i++)
+		{
+			BatchedKnob* knob = mKnobs.getUnchecked(i);
+			const Rectangle<int> bounds(knob->getKnobBounds());
+			if(!knob->isVisible() || !g.clipRegionIntersects(bounds)) continue;
+
+			g.saveState();
+			g.setOrigin(bounds.getX(),bounds.getY());
+			lookAndFeel.drawRotarySlider(g,0,0,bounds.getWidth(),bounds.getHeight(),
+										(float)knob->valueToProportionOfLength(knob->getValue()),
+										float_Pi * 1.2f, float_Pi * 2.8f, *knob);
+			g.restoreState();
+		}
+	};
+
+	/** flows the sections into rows, a section that does not fit starts the next row*/
+	void resized()
+	{
+		mHeaderBars.clearQuick();
+
+		int x = VOICE_MARGIN;
+		int y = VOICE_MARGIN;
+		for(int s=0;s<mSectionTitles.size();s++)
+		{
+			const VoiceSection& section = voiceSections[mSectionIndex[s]];
+			const int width = getSectionWidth(section);
+			if(x > VOICE_MARGIN && x + width > getWidth() - VOICE_MARGIN)
+			{
+				x = VOICE_MARGIN;
+				y += VOICE_ROW_HEIGHT;
+			}
+
+			mHeaderBars.add(Rectangle<int>(x,y+5,width,15));
+			mSectionTitles[s]->setBounds(x,y,width,VOICE_HEADER_HEIGHT);
+
+			int cellX = x;
+			for(int i=section.firstControl;i<=section.lastControl;i++)
+			{
+				Component* control = mControls.getControl(i);
+				if(control == NULL) continue;
+
+				const int cell = getCellWidth(i);
+				const int controlY = y + VOICE_HEADER_HEIGHT + VOICE_LABEL_HEIGHT;
+				mLabels[i]->setBounds(cellX,y + VOICE_HEADER_HEIGHT,cell,VOICE_LABEL_HEIGHT);
+				if(getControlType(i,mVoiceNr) == TYPE_SLIDER)
+				{
+					control->setBounds(cellX,controlY,VOICE_SLIDER_CELL-4,68);
+				}
+				else
+				{
+					control->setBounds(cellX,controlY+16,VOICE_COMBO_CELL-4,24);
+				}
+				cellX += cell;
+			}
+			x += width + VOICE_SECTION_GAP;
+		}
+
+		const int gangWidth = NUM_VOICES*VOICE_GANG_CELL;
+		if(x > VOICE_MARGIN && x + gangWidth > getWidth() - VOICE_MARGIN)
+		{
+			x = VOICE_MARGIN;
+			y += VOICE_ROW_HEIGHT;
+		}
+		mHeaderBars.add(Rectangle<int>(x,y+5,gangWidth,15));
+		mGangTitle->setBounds(x,y,gangWidth,VOICE_HEADER_HEIGHT);
+		for(int v=0;v<NUM_VOICES;v++)
+		{
+			mGangButtons[v]->setBounds(x + v*VOICE_GANG_CELL,y + VOICE_HEADER_HEIGHT + VOICE_LABEL_HEIGHT + 16,VOICE_GANG_CELL-4,24);
+		}
+		releaseChrome();
+		repaint();
+	};
+
+	/** the widgets keep the synth range, PM63 sliders show -63..63 and are sent as 0..127.
+		Only a change of the integer value is sent, see SliderEdgeFilter*/
+	void sliderValueChanged(Slider* slider)
+	{
+		const int controlNr = getControlNr(slider);
+		if(controlNr == 0) return;
+		const int value = getSliderValue(slider);
+		if(mEdges.pass(controlNr,value)) sendValue(controlNr,value);
+	};
+
+	/** a drag is undone in one step*/
+	void sliderDragStarted(Slider* slider)
+	{
+		ParameterStore::getInstance()->beginUndoGroup();
+		const int controlNr = getControlNr(slider);
+		if(controlNr != 0) mEdges.begin(controlNr);
+	};
+
+	/** the value the drag stopped at is sent even if the rate cap held it back*/
+	void sliderDragEnded(Slider* slider)
+	{
+		const int controlNr = getControlNr(slider);
+		if(controlNr != 0)
+		{
+			const int value = mEdges.end(controlNr);
+			if(value >= 0) sendValue(controlNr,value);
+		}
+		ParameterStore::getInstance()->endUndoGroup();
+	};
+
+	/** the minimum milliseconds between two sends of a dragged knob, 0 sends every integer step*/
+	void setDragRateCap(int controlNr, int intervalMs)
+	{
+		if(controlNr > 0 && controlNr <= MAX_CONTROLS) mEdges.setRateCap(controlNr,intervalMs);
+	};
+
+	void buttonClicked(Button* button)
+	{
+		for(int v=0;v<NUM_VOICES;v++)
+		{
+			if(button != mGangButtons[v]) continue;
+			mGang.setVoice(v,button->getToggleState());
+			return;
+		}
+		sendValue(getControlNr(button),button->getToggleState() ? 1 : 0);
+	};
+
+	/** the gang was changed in another panel*/
+	void changeListenerCallback(ChangeBroadcaster* /*source*/)
+	{
+		for(int v=0;v<NUM_VOICES;v++)
+		{
+			mGangButtons[v]->setToggleState(mGang.contains(v),false);
+		}
+	};
+
+	void comboBoxChanged(ComboBox* combo)
+	{
+		const int controlNr = getControlNr(combo);
+		sendValue(controlNr,ComboItemModel::itemIdToValue(combo->getSelectedId()));
+		if(controlNr == LFO_VOICE_CONTROL) updateLfoTargets();
+	};
+
+	/** update the control of a parameter changed on the synth*/
+	void parameterChanged(int parameterNr, int value)
+	{
+		const ParameterLocation& location = getParameterLocation(parameterNr);
+		if(location.voiceNr != mVoiceNr) return;
+
+		Component* control = mControls.getControl(location.controlNr);
+		if(control == NULL) return;
+
+		VoiceControls::showValue(control,location.controlType,value);
+		mEdges.setSent(location.controlNr,value);
+		if(location.controlNr == LFO_VOICE_CONTROL) updateLfoTargets();
+	};
+
+private:
+	void addSection(const VoiceSection& section)
+	{
+		bool used = false;
+		for(int i=section.firstControl;i<=section.lastControl;i++)
+		{
+			if(getParameterNr(i) != NONE)
+			{
+				addControl(i);
+				used = true;
+			}
+		}
+		if(!used) return;
+
+		Label* title = new Label(String::empty,section.name);
+		title->setFont(Font(15.0000f,Font::bold));
+		title->setJustificationType(Justification::centredLeft);
+		title->setEditable(false,false,false);
+		addChildComponent(title);
+
+		mSectionTitles.add(title);
+		mSectionIndex.add((int)(&section - voiceSections));
+	};
+
+	void addGangButtons()
+	{
+		mGangTitle = new Label(String::empty,"Edit Together");
+		mGangTitle->setFont(Font(15.0000f,Font::bold));
+		mGangTitle->setJustificationType(Justification::centredLeft);
+		mGangTitle->setEditable(false,false,false);
+		addChildComponent(mGangTitle);
+
+		for(int v=0;v<NUM_VOICES;v++)
+		{
+			ToggleButton* button = new ToggleButton(voiceNames[v]);
+			button->setColour(ToggleButton::textColourId,Colours::white);
+			button->setToggleState(mGang.contains(v),false);
+			button->addListener(this);
+			addAndMakeVisible(button);
+			mGangButtons[v] = button;
+		}
+	};
+
+	/** creates the widget and the label of one controllerAssignments column*/
+	void addControl(int controlNr)
+	{
+		const int parameterNr = getParameterNr(controlNr);
+		const String name(controlNr);
+		Component* control = NULL;
+
+		switch(getControlType(controlNr,mVoiceNr))
+		{
+		case TYPE_SLIDER:
+			{
+			BatchedKnob* slider = new BatchedKnob(name,parameterNr);
+			mKnobs.add(slider);
+			const ParameterRange& range = getParameterRange(parameterNr);
+			slider->setRange(range.min,range.max,1);
+			slider->setSliderStyle(Slider::Rotary);
+			slider->setTextBoxStyle(Slider::TextBoxBelow,false,80,20);
+			slider->addListener(this);
+			control = slider;
+			}
+			break;
+
+		case TYPE_BUTTON:
+			{
+			ToggleButton* button = new ToggleButton(name);
+			button->setColour(ToggleButton::textColourId,Colours::white);
+			button->addListener(this);
+			control = button;
+			}
+			break;
+
+		case TYPE_COMBO:
+			{
+			ComboBox* combo = new ComboBox(name);
+			combo->setEditableText(false);
+			combo->setJustificationType(Justification::centredLeft);
+			combo->setTextWhenNothingSelected(String::empty);
+			combo->setTextWhenNoChoicesAvailable("(no choices)");
+			fillCombo(combo,controlNr,parameterNr);
+			combo->setSelectedItemIndex(0,true);
+			combo->addListener(this);
+			control = combo;
+			}
+			break;
+		}
+		addAndMakeVisible(control);
+		mControls.setControl(controlNr,control);
+
+		Label* label = new Label(String::empty,getControlName(parameterNr));
+		label->setFont(Font(15.0000f,Font::plain));
+		label->setJustificationType(Justification::centredLeft);
+		label->setMinimumHorizontalScale(0.6f);
+		label->setEditable(false,false,false);
+		label->setColour(Label::textColourId,Colours::white);
+		addChildComponent(label);
+		mLabels[controlNr] = label;
+	};
+
+	/** the shared items of the combo, the menu of a menu parameter*/
+	void fillCombo(ComboBox* combo, int controlNr, int parameterNr)
+	{
+		ComboItemModels* models = ComboItemModels::getInstance();
+		const ComboItemModel& menu = models->getMenu(Patch::getDtype(parameterNr)>>4);
+		if(menu.getNumItems() > 0)
+		{
+			menu.attachTo(*combo);
+			return;
+		}
+
+		//the parameters without a menu
+		switch(controlNr)
+		{
+		case TRANS_WAVE_CONTROL:	models->getTransientWaves().attachTo(*combo);	break;
+		case LFO_VOICE_CONTROL:		models->getVoices().attachTo(*combo);			break;
+		case VELO_TARGET_CONTROL:	models->getTargets(mVoiceNr).attachTo(*combo);	break;
+		case LFO_TARGET_CONTROL:	break;	//filled by updateLfoTargets()
+		default:					models->getPlaceholder().attachTo(*combo);		break;
+		}
+	};
+
+	/** the LFO targets are the parameters of the voice the LFO modulates*/
+	void updateLfoTargets()
+	{
+		ComboBox* voiceCombo = (ComboBox*)mControls.getControl(LFO_VOICE_CONTROL);
+		ComboBox* targetCombo = (ComboBox*)mControls.getControl(LFO_TARGET_CONTROL);
+		if(voiceCombo == NULL || targetCombo == NULL) return;
+
+		ComboItemModels::getInstance()->getTargets(ComboItemModel::itemIdToValue(voiceCombo->getSelectedId())).attachTo(*targetCombo);
+		targetCombo->setSelectedId(ComboItemModel::valueToItemId(ParameterStore::getInstance()->getValue(getParameterNr(LFO_TARGET_CONTROL))),true);
+	};
+
+	/** the long name the synth shows for a parameter on the menu pages of this voice*/
+	String getControlName(int parameterNr)
+	{
+		for(int subPage=0;subPage<NUM_SUB_PAGES;subPage++)
+		{
+			const Page& page = menuPages[mVoiceNr][subPage];
+			for(int i=0;i<8;i++)
+			{
+				if(*(&page.bot1 + i) == parameterNr)
+				{
+					return String(longNames[valueNames[*(&page.top1 + i)].longName]);
+				}
+			}
+		}
+		return String::empty;
+	};
+
+	void sendValue(int controlNr, int value)
+	{
+		if(controlNr == 0) return;
+		LatencyMonitor::getInstance()->uiEvent();
+		if(!mGang.contains(mVoiceNr) || !isGangControl(controlNr))
+		{
+			UiEditRecorder::getInstance()->add(mVoiceNr,controlNr,value);
+			ParameterStore::getInstance()->setValue(getParameterNr(controlNr),value);
+			return;
+		}
+
+		//the other ganged voices get the value where the control means the same
+		int parameterNrs[NUM_VOICES];
+		int values[NUM_VOICES];
+		int num = 0;
+		for(int v=0;v<NUM_VOICES;v++)
+		{
+			if(v != mVoiceNr && !mGang.contains(v)) continue;
+
+			const int parameterNr = VoiceClipboard::mapParameter(controlNr,mVoiceNr,v);
+			if(parameterNr == NONE) continue;
+
+			UiEditRecorder::getInstance()->add(v,controlNr,value);
+			parameterNrs[num] = parameterNr;
+			values[num] = value;
+			num++;
+		}
+		ParameterStore::getInstance()->setValueGroup(parameterNrs,values,num);
+	};
+
+	/** the targets and the LFO voice are numbered per voice, they aren't ganged, see VoiceClipboard::mapParameter()*/
+	static bool isGangControl(int controlNr)
+	{
+		return controlNr != VELO_TARGET_CONTROL && controlNr != LFO_VOICE_CONTROL && controlNr != LFO_TARGET_CONTROL;
+	};
+
+	/** the dispatch table lookup of the widget callbacks, 0 if the widget is not a control*/
+	int getControlNr(Component* control)
+	{
+		for(int i=1;i<=MAX_CONTROLS;i++)
+		{
+			if(mControls.getControl(i) == control) return i;
+		}
+		return 0;
+	};
+
+	/** the stored value, PM63 sliders are shifted to 0..127*/
+	static int getSliderValue(Slider* slider)
+	{
+		int value = roundToInt(slider->getValue());
+		const int min = (int)slider->getMinimum();
+		if(min<0) value -= min;
+		return value;
+	};
+
+	int getParameterNr(int controlNr)
+	{
+		return controllerAssignments[mVoiceNr][controlNr-1];
+	};
+
+	int getSectionWidth(const VoiceSection& section)
+	{
+		int width = 0;
+		for(int i=section.firstControl;i<=section.lastControl;i++)
+		{
+			if(mControls.getControl(i) != NULL) width += getCellWidth(i);
+		}
+		return width;
+	};
+
+	int getCellWidth(int controlNr)
+	{
+		return getControlType(controlNr,mVoiceNr) == TYPE_SLIDER ? VOICE_SLIDER_CELL : VOICE_COMBO_CELL;
+	};
+
+	/** the background, the header bars and the labels, which only change with the layout and the look
+		and feel. The labels are hidden children, they are only painted into the image*/
+	void renderChrome()
+	{
+		mChrome = Image(Image::RGB,jmax(1,getWidth()),jmax(1,getHeight()),false);
+		mChromeMemory.setBytes(mChrome.getWidth()*mChrome.getHeight()*4);
+		Graphics g(mChrome);
+		g.fillAll(Colour(0xff494949));
+
+		g.setColour(Colour(0xff0bb801));
+		for(int i=0;i<mHeaderBars.size();i++)
+		{
+			const Rectangle<int>& bar = mHeaderBars.getReference(i);
+			g.fillRoundedRectangle((float)bar.getX(),(float)bar.getY(),(float)bar.getWidth(),(float)bar.getHeight(),4.5f);
+		}
+
+		for(int i=0;i<mSectionTitles.size();i++)
+		{
+			paintLabel(g,mSectionTitles.getUnchecked(i));
+		}
+		for(int i=1;i<=MAX_CONTROLS;i++)
+		{
+			if(mLabels[i] != NULL) paintLabel(g,mLabels[i]);
+		}
+		paintLabel(g,mGangTitle);
+	};
+
+	static void paintLabel(Graphics& g, Label* label)
+	{
+		if(label->getWidth() <= 0 || label->getHeight() <= 0) return;
+		g.saveState();
+		g.setOrigin(label->getX(),label->getY());
+		if(g.reduceClipRegion(0,0,label->getWidth(),label->getHeight())) label->paintEntireComponent(g,true);
+		g.restoreState();
+	};
+
+	void releaseChrome()
+	{
+		mChrome = Image::null;
+		mChromeMemory.setBytes(0);
+	};
+
+private:
+	int mVoiceNr;
+	VoiceGang& mGang;
+	VoiceControls mControls;
+	SliderEdgeFilter mEdges;		// the slider values sent last
+	Label* mLabels[MAX_CONTROLS+1];
+	Array<Label*> mSectionTitles;	// of the sections that are shown
+	Array<int> mSectionIndex;		// into voiceSections
+	Array<Rectangle<int> > mHeaderBars;
+	Array<BatchedKnob*> mKnobs;		// the sliders, owned as children
+	Label* mGangTitle;
+	ToggleButton* mGangButtons[NUM_VOICES];
+	Image mChrome;					// NULL until the next paint after a layout or look and feel change
+	MemoryAccount mChromeMemory;
+
+	// (prevent copy constructor and operator= being generated..)
+	VoicePanel (const VoicePanel&);
+	const VoicePanel& operator= (const VoicePanel&);
+};
+//---------------------------------------------------------------------------
+/** The tab content of one voice. The VoicePanel is only built when the tab
+	is first shown, or when a neighbouring tab was shown and the message loop
+	is idle. A new panel reads the current ParameterStore values, so edits
+	made while the tab did not exist yet are shown.
+*/
+class VoiceTab : public Component, private AsyncUpdater
+{
+public:
+	VoiceTab(int voiceNr, VoiceGang& gang) : mVoiceNr(voiceNr), mGang(gang), mPanel(NULL), mPrevious(NULL), mNext(NULL)
+	{
+		setSize(VOICE_PANEL_WIDTH,VOICE_PANEL_HEIGHT);
+	};
+
+	~VoiceTab()
+	{
+		cancelPendingUpdate();
+		deleteAllChildren();
+	};
+
+	/** the tabs that are built after this one was shown*/
+	void setNeighbours(VoiceTab* previous, VoiceTab* next)
+	{
+		mPrevious = previous;
+		mNext = next;
+	};
+
+	void build()
+	{
+		if(mPanel != NULL) return;
+		addAndMakeVisible(mPanel = new VoicePanel(mVoiceNr,mGang));
+		resized();
+	};
+
+	void visibilityChanged()
+	{
+		if(!isVisible() || mPanel != NULL) return;
+		build();
+		if(VOICE_TAB_PREWARM) triggerAsyncUpdate();
+	};
+
+	void paint(Graphics& g)
+	{
+		if(mPanel == NULL) g.fillAll(Colour(0xff494949));
+	};
+
+	void resized()
+	{
+		if(mPanel != NULL) mPanel->setBounds(0,0,getWidth(),getHeight());
+	};
+
+private:
+	/** one neighbour per message, so input is handled in between*/
+	void handleAsyncUpdate()
+	{
+		if(mNext != NULL && mNext->mPanel == NULL)
+		{
+			mNext->build();
+			if(mPrevious != NULL && mPrevious->mPanel == NULL) triggerAsyncUpdate();
+		}
+		else if(mPrevious != NULL)
+		{
+			mPrevious->build();
+		}
+	};
+
+	int mVoiceNr;
+	VoiceGang& mGang;
+	VoicePanel* mPanel;
+	VoiceTab* mPrevious;
+	VoiceTab* mNext;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,362 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/menu.h"
+#include "Patch.h"
+#include "PatchHash.h"
+#include "FlatHashMap.h"
+#include "SurrogateModel.h"
+#include "BackgroundJobs.h"
+#include "Trace.h"
+#include "Log.h"
+
+#define VOTE_LOG_FILE			"SonicPotionsEditor/votes.svl"
+#define VOTE_LOG_MAGIC			0x4c565053	// "SPVL" little endian
+#define VOTE_LOG_VERSION		1
+#define VOTE_LOG_HEADER_SIZE	12			// magic, version, NUM_PARAMS
+#define VOTE_LOG_RECORD_SIZE	(8 + 8 + NUM_PARAMS + 2)	// hash, time, values, opinion, check
+#define VOTE_LOG_COMPACT_MIN	4096		// records in the log before it is ever compacted
+#define VOTE_LOG_COMPACT_RATIO	2			// it is compacted once it has this many records per vote
+#define VOTE_LOG_STOP_TIMEOUT_MS	5000
+
+//---------------------------------------------------------------------------
+/** Every vote the user ever gave, kept across sessions, keyed by the hash
+	of the patch values (see hashPatchValues()).
+
+	The votes are appended to a log in the user's application data folder,
+	one record per vote with the hash, the time, the values and the
+	opinion, and a check byte so a record cut off by a crash is ignored.
+	Voting again for the same values appends a new record, NOT_VOTED
+	withdraws a vote. When the log has VOTE_LOG_COMPACT_RATIO times more
+	records than votes an idle BackgroundJob writes the current votes to a
+	new log. It holds the lock only to copy the votes and, at the end, to
+	move over what was voted in between, so voting never waits for it.
+
+	The whole log is read into memory when the database is first used, a
+	FlatHashMap finds the vote of a patch in constant time. Any thread.
+*/
+class VoteDatabase
+{
+public:
+	VoteDatabase() : mIndex(1024), mNumVotes(0), mNumLogRecords(0)
+	{
+		mFile = File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile(VOTE_LOG_FILE);
+		open();
+	};
+
+	~VoteDatabase()
+	{
+		BackgroundJob::Ptr job;
+		{
+			const ScopedLock sl(mLock);
+			job = mCompactJob;
+		}
+		if(job != NULL)
+		{
+			job->cancel();
+			job->waitUntilDone(VOTE_LOG_STOP_TIMEOUT_MS);
+		}
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton(VoteDatabase,false)
+
+	/** LIKE, DISLIKE, or NOT_VOTED to withdraw the vote of the values*/
+	void setOpinion(const uint8_t* values, int opinion)
+	{
+		const int64 hash = (int64)hashPatchValues(values);
+		const ScopedLock sl(mLock);
+		if(!store(hash,values,opinion)) return;
+
+		if(mOut != NULL)
+		{
+			uint8 record[VOTE_LOG_RECORD_SIZE];
+			makeRecord(record,hash,values,opinion);
+			mOut->write(record,VOTE_LOG_RECORD_SIZE);
+			mOut->flush();
+			mNumLogRecords++;
+		}
+		if(mCompactJob == NULL && mNumLogRecords >= VOTE_LOG_COMPACT_MIN && mNumLogRecords >= mNumVotes*VOTE_LOG_COMPACT_RATIO)
+		{
+			mCompactJob = JobQueue::getInstance()->addJob(new CompactJob(*this));
+		}
+	};
+
+	/** NOT_VOTED if the values were never voted for*/
+	int getOpinion(const uint8_t* values) const
+	{
+		return getOpinion((int64)hashPatchValues(values));
+	};
+
+	int getOpinion(int64 hash) const
+	{
+		const ScopedLock sl(mLock);
+		const int* index = mIndex.find(hash);
+		return index != NULL ? mVotes.getReference(*index).opinion : NOT_VOTED;
+	};
+
+	/** likes and dislikes, without the withdrawn ones*/
+	int getNumVotes() const
+	{
+		const ScopedLock sl(mLock);
+		return mNumVotes;
+	};
+
+	/** teaches a surrogate all votes*/
+	void addVotesTo(SurrogateModel& model) const
+	{
+		const ScopedLock sl(mLock);
+		for(int i=0;i<mVotes.size();i++)
+		{
+			if(mVotes.getReference(i).opinion != NOT_VOTED) model.addVote(getValues(i),mVotes.getReference(i).opinion);
+		}
+	};
+
+private:
+	struct Vote
+	{
+		Vote(int opinion_ = NOT_VOTED) : opinion((int8)opinion_) {};
+		int8 opinion;
+	};
+
+	//-----------------------------------------------------------------------
+	class CompactJob : public BackgroundJob
+	{
+	public:
+		CompactJob(VoteDatabase& owner) : BackgroundJob("compact votes",JOB_PRIORITY_IDLE), mOwner(owner)
+		{
+		};
+
+		bool run()
+		{
+			const bool ok = !shouldExit() && mOwner.compact();
+			const ScopedLock sl(mOwner.mLock);
+			mOwner.mCompactJob = NULL;
+			return ok;
+		};
+
+	private:
+		VoteDatabase& mOwner;
+	};
+	//-----------------------------------------------------------------------
+
+	/** reads the log, one that was cut off or damaged is written again without the bad tail*/
+	void open()
+	{
+		TRACE_SCOPE("patch io","open votes");
+		MemoryBlock data;
+		if(mFile.existsAsFile()) mFile.loadFileAsData(data);
+
+		const uint8* log = (const uint8*)data.getData();
+		const int size = (int)data.getSize();
+		const bool valid = size >= VOTE_LOG_HEADER_SIZE && readInt(log,0) == VOTE_LOG_MAGIC
+			&& readInt(log,4) == VOTE_LOG_VERSION && readInt(log,8) == NUM_PARAMS;
+
+		int numRecords = 0;
+		if(valid)
+		{
+			for(;VOTE_LOG_HEADER_SIZE + (numRecords+1)*VOTE_LOG_RECORD_SIZE <= size;numRecords++)
+			{
+				const uint8* record = log + VOTE_LOG_HEADER_SIZE + numRecords*VOTE_LOG_RECORD_SIZE;
+				if(getCheck(record) != record[VOTE_LOG_RECORD_SIZE-1]) break;
+				readRecord(record);
+			}
+		}
+		mNumLogRecords = numRecords;
+
+		const bool intact = valid && size == VOTE_LOG_HEADER_SIZE + numRecords*VOTE_LOG_RECORD_SIZE;
+		if(!intact)
+		{
+			if(size > 0) logText("The vote log " + mFile.getFullPathName() + " was damaged, " + String(numRecords) + " votes were read");
+			mFile.getParentDirectory().createDirectory();
+			writeLog(mFile);
+		}
+		mOut = mFile.createOutputStream();
+	};
+
+	void readRecord(const uint8* record)
+	{
+		int64 hash = 0;
+		for(int i=0;i<8;i++)
+		{
+			hash |= (int64)record[i] << (8*i);
+		}
+		store(hash,record + 16,record[16 + NUM_PARAMS]);
+	};
+
+	/** false if the values already had the opinion*/
+	bool store(int64 hash, const uint8_t* values, int opinion)
+	{
+		const int* existing = mIndex.find(hash);
+		if(existing == NULL)
+		{
+			if(opinion == NOT_VOTED) return false;
+			mIndex.set(hash,mVotes.size());
+			mValues.append(values,NUM_PARAMS);
+			mVotes.add(Vote(opinion));
+			mNumVotes++;
+			return true;
+		}
+
+		Vote& vote = mVotes.getReference(*existing);
+		if(vote.opinion == opinion) return false;
+		if(vote.opinion == NOT_VOTED)	mNumVotes++;
+		else if(opinion == NOT_VOTED)	mNumVotes--;
+		vote.opinion = (int8)opinion;
+		return true;
+	};
+
+	/** a new log with the current votes, under the lock*/
+	bool writeLog(const File& file)
+	{
+		TemporaryFile temp(file);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+			writeHeader(*out);
+			MemoryBlock records;
+			getRecords(records);
+			out->write(records.getData(),records.getSize());
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+		if(!temp.overwriteTargetFileWithTemporary()) return false;
+		mNumLogRecords = mNumVotes;
+		return true;
+	};
+
+	/** on a pool thread*/
+	bool compact()
+	{
+		TRACE_SCOPE("patch io","compact votes");
+		MemoryBlock records;
+		int numCopied;
+		int numLive;
+		{
+			const ScopedLock sl(mLock);
+			getRecords(records);
+			numCopied = mNumLogRecords;
+			numLive = mNumVotes;
+		}
+
+		TemporaryFile temp(mFile);
+		{
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL) return false;
+			writeHeader(*out);
+			out->write(records.getData(),records.getSize());
+			out->flush();
+			if(out->getStatus().failed()) return false;
+		}
+
+		//the votes appended since the copy are moved to the new log, they are newer than all of it
+		const ScopedLock sl(mLock);
+		mOut = NULL;
+		{
+			FileInputStream in(mFile);
+			ScopedPointer<FileOutputStream> out(temp.getFile().createOutputStream());
+			if(out == NULL || in.getStatus().failed())
+			{
+				mOut = mFile.createOutputStream();
+				return false;
+			}
+			in.setPosition(VOTE_LOG_HEADER_SIZE + (int64)numCopied*VOTE_LOG_RECORD_SIZE);
+			out->writeFromInputStream(in,-1);
+			out->flush();
+		}
+		const bool ok = temp.overwriteTargetFileWithTemporary();
+		if(ok) mNumLogRecords = numLive + mNumLogRecords - numCopied;
+		mOut = mFile.createOutputStream();
+		return ok;
+	};
+
+	/** a record for every vote that isn't withdrawn, under the lock*/
+	void getRecords(MemoryBlock& records) const
+	{
+		records.setSize(mNumVotes*VOTE_LOG_RECORD_SIZE);
+		uint8* record = (uint8*)records.getData();
+		for(int i=0;i<mVotes.size();i++)
+		{
+			const int opinion = mVotes.getReference(i).opinion;
+			if(opinion == NOT_VOTED) continue;
+			makeRecord(record,(int64)hashPatchValues(getValues(i)),getValues(i),opinion);
+			record += VOTE_LOG_RECORD_SIZE;
+		}
+	};
+
+	const uint8_t* getValues(int vote) const
+	{
+		return (const uint8_t*)mValues.getData() + vote*NUM_PARAMS;
+	};
+
+	static void writeHeader(OutputStream& out)
+	{
+		out.writeInt(VOTE_LOG_MAGIC);
+		out.writeInt(VOTE_LOG_VERSION);
+		out.writeInt(NUM_PARAMS);
+	};
+
+	static void makeRecord(uint8* record, int64 hash, const uint8_t* values, int opinion)
+	{
+		const int64 time = Time::currentTimeMillis();
+		for(int i=0;i<8;i++)
+		{
+			record[i] = (uint8)(hash >> (8*i));
+			record[8+i] = (uint8)(time >> (8*i));
+		}
+		memcpy(record + 16,values,NUM_PARAMS);
+		record[16 + NUM_PARAMS] = (uint8)opinion;
+		record[VOTE_LOG_RECORD_SIZE-1] = getCheck(record);
+	};
+
+	/** the sum of the bytes before the check byte*/
+	static uint8 getCheck(const uint8* record)
+	{
+		uint8 sum = 0;
+		for(int i=0;i<VOTE_LOG_RECORD_SIZE-1;i++)
+		{
+			sum = (uint8)(sum + record[i]);
+		}
+		return sum;
+	};
+
+	static int readInt(const uint8* data, int offset)
+	{
+		return (int)ByteOrder::littleEndianInt(data + offset);
+	};
+
+	File mFile;
+	CriticalSection mLock;
+	Array<Vote> mVotes;					// in the order they were first given, withdrawn ones stay until the next session
+	MemoryBlock mValues;				// NUM_PARAMS per vote
+	FlatHashMap<int64,int,PatchHashFunctions> mIndex;	// hash -> vote
+	ScopedPointer<FileOutputStream> mOut;	// appends to the log, NULL if it can't be written
+	int mNumVotes;						// not withdrawn
+	int mNumLogRecords;
+	BackgroundJob::Ptr mCompactJob;		// running, under the lock
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,131 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+
+#define RENDERER_CONFIG_ATTRIBUTE	"renderer"	// attribute of the midi.cfg root element
+#define RENDERER_DIRECT2D			"Direct2D"
+#define RENDERER_SOFTWARE			"Software"
+
+//---------------------------------------------------------------------------
+/** Selects the renderer of the main window.
+
+	The software renderer is the default. Direct2D is only offered on
+	Windows 7 and later, and juce falls back to software by itself when the
+	graphics device is lost and can't be recreated. So isUsingDirect2D()
+	tells what the window really uses, getUseDirect2D() what was asked for.
+	The choice is stored in midi.cfg.
+*/
+class WindowRenderer
+{
+public:
+	WindowRenderer()
+	{
+		mWindow = NULL;
+		mUseDirect2D = false;
+	};
+
+	~WindowRenderer()
+	{
+		clearSingletonInstance();
+	};
+
+	juce_DeclareSingleton (WindowRenderer, false)
+
+	/** the window the setting is applied to, has to be on the desktop*/
+	void setWindow(Component* window)
+	{
+		mWindow = window;
+		apply();
+	};
+
+	bool isDirect2DAvailable() const
+	{
+		return getDirect2DIndex() >= 0;
+	};
+
+	bool isUsingDirect2D() const
+	{
+		ComponentPeer* peer = getPeer();
+		return peer != NULL && getDirect2DIndex() >= 0 && peer->getCurrentRenderingEngine() == getDirect2DIndex();
+	};
+
+	bool getUseDirect2D() const
+	{
+		return mUseDirect2D;
+	};
+
+	void setUseDirect2D(bool useDirect2D)
+	{
+		mUseDirect2D = useDirect2D;
+		apply();
+	};
+
+	/** reads the renderer attribute, a missing one means software*/
+	void loadFromConfig(const XmlElement* config)
+	{
+		if(config != NULL)
+		{
+			mUseDirect2D = config->getStringAttribute(RENDERER_CONFIG_ATTRIBUTE) == RENDERER_DIRECT2D;
+			apply();
+		}
+	};
+
+	void saveToConfig(XmlElement& config) const
+	{
+		config.setAttribute(RENDERER_CONFIG_ATTRIBUTE, mUseDirect2D ? RENDERER_DIRECT2D : RENDERER_SOFTWARE);
+	};
+
+private:
+	ComponentPeer* getPeer() const
+	{
+		return mWindow != NULL ? mWindow->getPeer() : NULL;
+	};
+
+	int getDirect2DIndex() const
+	{
+		ComponentPeer* peer = getPeer();
+		return peer != NULL ? peer->getAvailableRenderingEngines().indexOf(RENDERER_DIRECT2D) : -1;
+	};
+
+	void apply()
+	{
+		ComponentPeer* peer = getPeer();
+		if(peer == NULL) return;
+
+		const int index = mUseDirect2D ? getDirect2DIndex() : -1;
+		peer->setCurrentRenderingEngine(index >= 0 ? index : 0);
+
+		if(mUseDirect2D && !isUsingDirect2D())
+		{
+			Logger::writeToLog("Direct2D is not available, using the software renderer");
+		}
+	};
+
+	Component* mWindow;
+	bool mUseDirect2D;
+};
+//---------------------------------------------------------------------------
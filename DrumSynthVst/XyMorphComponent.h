@@ -0,0 +1,161 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./XyMorphEngine.h"
+#include "./PresetLoader.h"
+
+#define XY_PAD_HANDLE_SIZE	12	// diameter of the handle in pixels
+
+//---------------------------------------------------------------------------
+/** The XY morph dialog: a preset for each corner and the pad between them.
+
+	The first corner that is chosen makes the sound as it is then the
+	others, so a single corner morphs between it and the current sound.
+	Each drag on the pad is one undo step.
+*/
+class XyMorphComponent : public Component,
+						 public ButtonListener
+{
+public:
+	XyMorphComponent()
+	{
+		for(int c=0;c<XY_MORPH_NUM_CORNERS;c++)
+		{
+			addAndMakeVisible(mCornerButtons[c] = new TextButton("Corner " + String(c+1) + "..."));
+			mCornerButtons[c]->addListener(this);
+		}
+		addAndMakeVisible(mPad = new Pad(mEngine));
+
+		setSize(360,360);
+	};
+
+	~XyMorphComponent()
+	{
+		deleteAllChildren();
+	};
+
+	void paint(Graphics& g)
+	{
+		g.fillAll(Colour(0xff4e4e4e));
+	};
+
+	void resized()
+	{
+		const int buttonWidth = (getWidth()-24)/2;
+		mCornerButtons[0]->setBounds(8,8,buttonWidth,24);
+		mCornerButtons[1]->setBounds(getWidth()-8-buttonWidth,8,buttonWidth,24);
+		mCornerButtons[2]->setBounds(8,getHeight()-32,buttonWidth,24);
+		mCornerButtons[3]->setBounds(getWidth()-8-buttonWidth,getHeight()-32,buttonWidth,24);
+		mPad->setBounds(8,40,getWidth()-16,getHeight()-80);
+	};
+
+	void buttonClicked(Button* button)
+	{
+		int corner = 0;
+		while(corner < XY_MORPH_NUM_CORNERS-1 && mCornerButtons[corner] != button) corner++;
+
+		FileChooser chooser("Corner " + String(corner+1),File::nonexistent,"*.snd");
+		if(!chooser.browseForFileToOpen()) return;
+
+		uint8_t data[PATCH_DATA_SIZE];
+		memset(data,0,PATCH_DATA_SIZE);
+		FileInputStream in(chooser.getResult());
+		if(in.getStatus().failed() || in.read(data,PATCH_DATA_SIZE) <= 0)
+		{
+			AlertWindow::showMessageBox(AlertWindow::WarningIcon,"XY Morph","The preset could not be read.");
+			return;
+		}
+		Patch patch;
+		PresetLoader::readPatchData(data,&patch);
+
+		mEngine.setCorner(corner,patch.getValues());
+		mCornerButtons[corner]->setButtonText(patch.getShortName().toString());
+		mPad->repaint();
+	};
+
+private:
+	//-----------------------------------------------------------------------
+	/** the square the handle is dragged in, each drag is one undo group*/
+	class Pad : public Component
+	{
+	public:
+		Pad(XyMorphEngine& engine) : mEngine(engine)
+		{
+		};
+
+		void paint(Graphics& g)
+		{
+			g.fillAll(Colour(0xff494949));
+			g.setColour(Colour(0xff646464));
+			g.drawRect(0,0,getWidth(),getHeight());
+			g.drawHorizontalLine(getHeight()/2,0.f,(float)getWidth());
+			g.drawVerticalLine(getWidth()/2,0.f,(float)getHeight());
+
+			if(!mEngine.hasCorners())
+			{
+				g.setColour(Colours::white);
+				g.drawText("choose a corner",0,0,getWidth(),getHeight(),Justification::centred,false);
+				return;
+			}
+			const float x = mEngine.getX()*(getWidth()-XY_PAD_HANDLE_SIZE);
+			const float y = mEngine.getY()*(getHeight()-XY_PAD_HANDLE_SIZE);
+			g.setColour(Colour(0xff6aa52a));
+			g.fillEllipse(x,y,(float)XY_PAD_HANDLE_SIZE,(float)XY_PAD_HANDLE_SIZE);
+		};
+
+		void mouseDown(const MouseEvent& e)
+		{
+			if(!mEngine.hasCorners()) return;
+			mEngine.beginMorph();
+			mouseDrag(e);
+		};
+
+		void mouseDrag(const MouseEvent& e)
+		{
+			if(!mEngine.hasCorners()) return;
+			mEngine.setPosition((e.x - XY_PAD_HANDLE_SIZE/2)/(float)(getWidth()-XY_PAD_HANDLE_SIZE),
+								(e.y - XY_PAD_HANDLE_SIZE/2)/(float)(getHeight()-XY_PAD_HANDLE_SIZE));
+			repaint();
+		};
+
+		void mouseUp(const MouseEvent&)
+		{
+			if(!mEngine.hasCorners()) return;
+			mEngine.endMorph();
+		};
+
+	private:
+		XyMorphEngine& mEngine;
+	};
+	//-----------------------------------------------------------------------
+
+	XyMorphEngine mEngine;
+
+	TextButton* mCornerButtons[XY_MORPH_NUM_CORNERS];
+	Pad* mPad;
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,276 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./MorphEngine.h"
+
+#define XY_MORPH_NUM_CORNERS	4	// top left, top right, bottom left, bottom right
+
+//---------------------------------------------------------------------------
+/** Blends the edited sound between four corner patches on an XY pad.
+
+	x goes from the left to the right corners, y from the top to the bottom
+	ones, both 0-1. A value is the bilinear blend
+		c0 + (c1-c0)*x + (c2-c0)*y + (c0-c1-c2+c3)*x*y
+	and the three deltas of every parameter are worked out when a corner
+	is set, so a move of the pad costs three multiply-adds per parameter,
+	done 4 parameters per step in float with SSE2 or NEON. The scalar tail
+	does the same operations in the same order, so it gives the same
+	bytes. Discrete parameters (see MorphEngine::isDiscrete()) take the
+	value of the nearest corner.
+
+	Like the MorphEngine every step sends only the parameters whose value
+	changed, with bulk priority, and waits while the link has more than
+	MORPH_STEP_MS of data left, so a drag goes to the newest position
+	instead of queueing up the way there. Corners that weren't chosen yet
+	hold the sound as it was when the first one was. Message thread only.
+*/
+class XyMorphEngine : private Timer
+{
+public:
+	XyMorphEngine() : mX(0), mY(0), mAppliedX(-1), mAppliedY(-1), mHasCorners(false), mMorphing(false)
+	{
+		for(int c=0;c<XY_MORPH_NUM_CORNERS;c++)
+		{
+			memset(mCorners[c],0,NUM_PARAMS);
+			memset(mCornerValues[c],0,sizeof(mCornerValues[c]));
+			mCornerSet[c] = false;
+		}
+		memset(mBase,0,sizeof(mBase));
+		memset(mDeltaX,0,sizeof(mDeltaX));
+		memset(mDeltaY,0,sizeof(mDeltaY));
+		memset(mDeltaXY,0,sizeof(mDeltaXY));
+		memset(mValues,0,MORPH_STRIDE);
+		memset(mUndoStart,0,NUM_PARAMS);
+		for(int i=0;i<MORPH_STRIDE;i++)
+		{
+			mDiscrete[i] = i < NUM_PARAMS && MorphEngine::isDiscrete(i) ? 0xffffffff : 0;
+		}
+	};
+
+	~XyMorphEngine()
+	{
+		stopTimer();
+	};
+
+	/** NUM_PARAMS values for corner 0-3. The sound stays as it is until the pad is moved*/
+	void setCorner(int corner, const uint8_t* values)
+	{
+		jassert(corner >= 0 && corner < XY_MORPH_NUM_CORNERS);
+		stopTimer();
+		if(!mHasCorners)
+		{
+			const uint8_t* current = ParameterStore::getInstance()->getValues();
+			for(int c=0;c<XY_MORPH_NUM_CORNERS;c++)
+			{
+				memcpy(mCorners[c],current,NUM_PARAMS);
+			}
+			mHasCorners = true;
+		}
+		memcpy(mCorners[corner],values,NUM_PARAMS);
+		mCornerSet[corner] = true;
+		computeDeltas();
+		mAppliedX = mAppliedY = -1;
+	};
+
+	bool hasCorners() const
+	{
+		return mHasCorners;
+	};
+
+	bool isCornerSet(int corner) const
+	{
+		return mCornerSet[corner];
+	};
+
+	/** 0-1 each, sent with the next step the link has room for*/
+	void setPosition(float x, float y)
+	{
+		if(!mHasCorners) return;
+
+		mX = jlimit(0.f,1.f,x);
+		mY = jlimit(0.f,1.f,y);
+		if(!isTimerRunning())
+		{
+			timerCallback();
+			startTimer(MORPH_STEP_MS);
+		}
+	};
+
+	float getX() const
+	{
+		return mX;
+	};
+
+	float getY() const
+	{
+		return mY;
+	};
+
+	/** remembers the values the undo of the gesture goes back to*/
+	void beginMorph()
+	{
+		memcpy(mUndoStart,ParameterStore::getInstance()->getValues(),NUM_PARAMS);
+		mMorphing = true;
+	};
+
+	/** sends the last position right away and records the whole gesture as one undo group*/
+	void endMorph()
+	{
+		stopTimer();
+		if(mHasCorners && !isApplied()) step();
+		if(!mMorphing) return;
+		mMorphing = false;
+
+		ParameterStore* store = ParameterStore::getInstance();
+		const uint8_t* values = store->getValues();
+		store->beginUndoGroup();
+		for(int i=MORPH_FIRST_PARAMETER;i<MORPH_END_PARAMETER;i++)
+		{
+			store->getUndoLog().record(i,mUndoStart[i],values[i]);
+		}
+		store->endUndoGroup();
+	};
+
+	/** the blend at x,y into out, num is a multiple of 4 up to MORPH_STRIDE*/
+	void blend(float x, float y, uint8_t* out, int num) const
+	{
+		const float xy = x*y;
+		const float* nearest = mCornerValues[(x > 0.5f ? 1 : 0) + (y > 0.5f ? 2 : 0)];
+
+		int i = 0;
+#if MORPH_USE_SSE2
+		const __m128 vx = _mm_set1_ps(x);
+		const __m128 vy = _mm_set1_ps(y);
+		const __m128 vxy = _mm_set1_ps(xy);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for(;i+4<=num;i+=4)
+		{
+			const __m128 alongX = _mm_add_ps(_mm_loadu_ps(mBase+i),_mm_mul_ps(_mm_loadu_ps(mDeltaX+i),vx));
+			const __m128 alongY = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(mDeltaY+i),vy),_mm_mul_ps(_mm_loadu_ps(mDeltaXY+i),vxy));
+			const __m128 mixed = _mm_add_ps(alongX,alongY);
+
+			const __m128 select = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(mDiscrete+i)));
+			const __m128 value = _mm_or_ps(_mm_and_ps(select,_mm_loadu_ps(nearest+i)),_mm_andnot_ps(select,mixed));
+
+			//truncating after adding a half rounds, the packs saturate to 0-255
+			__m128i bytes = _mm_cvttps_epi32(_mm_add_ps(value,half));
+			bytes = _mm_packs_epi32(bytes,bytes);
+			bytes = _mm_packus_epi16(bytes,bytes);
+			const int packed = _mm_cvtsi128_si32(bytes);
+			memcpy(out+i,&packed,4);
+		}
+#elif MORPH_USE_NEON
+		const float32x4_t vx = vdupq_n_f32(x);
+		const float32x4_t vy = vdupq_n_f32(y);
+		const float32x4_t vxy = vdupq_n_f32(xy);
+		const float32x4_t half = vdupq_n_f32(0.5f);
+		for(;i+4<=num;i+=4)
+		{
+			//no vmlaq, the scalar tail has to round the same way
+			const float32x4_t alongX = vaddq_f32(vld1q_f32(mBase+i),vmulq_f32(vld1q_f32(mDeltaX+i),vx));
+			const float32x4_t alongY = vaddq_f32(vmulq_f32(vld1q_f32(mDeltaY+i),vy),vmulq_f32(vld1q_f32(mDeltaXY+i),vxy));
+			const float32x4_t value = vbslq_f32(vld1q_u32(mDiscrete+i),vld1q_f32(nearest+i),vaddq_f32(alongX,alongY));
+
+			const uint16x4_t words = vqmovun_s32(vcvtq_s32_f32(vaddq_f32(value,half)));
+			const uint8x8_t bytes = vqmovn_u16(vcombine_u16(words,words));
+			vst1_lane_u32((uint32_t*)(out+i),vreinterpret_u32_u8(bytes),0);
+		}
+#endif
+		//the tail (or everything without SIMD)
+		for(;i<num;i++)
+		{
+			const float alongX = mBase[i] + mDeltaX[i]*x;
+			const float alongY = mDeltaY[i]*y + mDeltaXY[i]*xy;
+			const float value = mDiscrete[i] != 0 ? nearest[i] : alongX + alongY;
+			out[i] = (uint8_t)jlimit(0,255,(int)(value + 0.5f));
+		}
+	};
+
+private:
+	void computeDeltas()
+	{
+		for(int i=0;i<NUM_PARAMS;i++)
+		{
+			const float c0 = mCorners[0][i];
+			const float c1 = mCorners[1][i];
+			const float c2 = mCorners[2][i];
+			const float c3 = mCorners[3][i];
+			mBase[i] = c0;
+			mDeltaX[i] = c1 - c0;
+			mDeltaY[i] = c2 - c0;
+			mDeltaXY[i] = c0 - c1 - c2 + c3;
+			for(int c=0;c<XY_MORPH_NUM_CORNERS;c++)
+			{
+				mCornerValues[c][i] = mCorners[c][i];
+			}
+		}
+	};
+
+	bool isApplied() const
+	{
+		return mAppliedX == mX && mAppliedY == mY;
+	};
+
+	void timerCallback()
+	{
+		if(isApplied())
+		{
+			stopTimer();
+			return;
+		}
+		//the wire is still busy with the last step, the next one goes to the newest position
+		if(MidiTransmitter::getInstance()->getEstimatedDrainTime() > MORPH_STEP_MS) return;
+		step();
+	};
+
+	void step()
+	{
+		blend(mX,mY,mValues,MORPH_STRIDE);
+		ParameterStore::getInstance()->setValues(mValues,MORPH_FIRST_PARAMETER,MORPH_END_PARAMETER,PRIORITY_BULK);
+		mAppliedX = mX;
+		mAppliedY = mY;
+	};
+
+	uint8_t mCorners[XY_MORPH_NUM_CORNERS][NUM_PARAMS];
+	float mCornerValues[XY_MORPH_NUM_CORNERS][MORPH_STRIDE];	// the corners as floats for the discrete parameters
+	float mBase[MORPH_STRIDE];		// corner 0
+	float mDeltaX[MORPH_STRIDE];	// c1-c0
+	float mDeltaY[MORPH_STRIDE];	// c2-c0
+	float mDeltaXY[MORPH_STRIDE];	// c0-c1-c2+c3
+	uint32 mDiscrete[MORPH_STRIDE];		// all bits set for the discrete parameters
+	uint8_t mValues[MORPH_STRIDE];		// the values of the last step
+	uint8_t mUndoStart[NUM_PARAMS];		// the store values at beginMorph()
+	bool mCornerSet[XY_MORPH_NUM_CORNERS];	// chosen, not just the sound at the start
+
+	float mX;
+	float mY;
+	float mAppliedX;	// what the store has, -1 after the corners changed
+	float mAppliedY;
+	bool mHasCorners;
+	bool mMorphing;		// between beginMorph() and endMorph()
+};
+//---------------------------------------------------------------------------
@@ -0,0 +1,283 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./drumSynthSource/menu.h"
+
+// data type of every parameter, the same for all patches. the lower 4 bit hold
+// the DTYPE, for DTYPE_MENU the upper 4 bit select the menu.
+// generated from the firmware menu_init(), keep in sync when a parameter changes its type
+static const uint8_t parameterDtypes[NUM_PARAMS] = {
+	DTYPE_0B127,							//   0 PAR_NONE
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//   1 PAR_OSC_WAVE_DRUM1
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//   2 PAR_OSC_WAVE_DRUM2
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//   3 PAR_OSC_WAVE_DRUM3
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//   4 PAR_OSC_WAVE_SNARE
+	DTYPE_0B127,							//   5 NRPN_DATA_ENTRY_COARSE
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//   6 PAR_WAVE1_CYM
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//   7 PAR_WAVE1_HH
+	DTYPE_0B127,							//   8 PAR_COARSE1
+	DTYPE_PM63,								//   9 PAR_FINE1
+	DTYPE_0B127,							//  10 PAR_COARSE2
+	DTYPE_PM63,								//  11 PAR_FINE2
+	DTYPE_0B127,							//  12 PAR_COARSE3
+	DTYPE_PM63,								//  13 PAR_FINE3
+	DTYPE_0B127,							//  14 PAR_COARSE4
+	DTYPE_PM63,								//  15 PAR_FINE4
+	DTYPE_0B127,							//  16 PAR_COARSE5
+	DTYPE_PM63,								//  17 PAR_FINE5
+	DTYPE_0B127,							//  18 PAR_COARSE6
+	DTYPE_PM63,								//  19 PAR_FINE6
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  20 PAR_MOD_WAVE_DRUM1
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  21 PAR_MOD_WAVE_DRUM2
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  22 PAR_MOD_WAVE_DRUM3
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  23 PAR_WAVE2_CYM
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  24 PAR_WAVE3_CYM
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  25 PAR_WAVE2_HH
+	DTYPE_MENU | (MENU_WAVEFORM<<4),		//  26 PAR_WAVE3_HH
+	DTYPE_0B127,							//  27 PAR_NOISE_FREQ1
+	DTYPE_0B127,							//  28 PAR_MIX1
+	DTYPE_0B127,							//  29 PAR_MOD_OSC_F1_CYM
+	DTYPE_0B127,							//  30 PAR_MOD_OSC_F2_CYM
+	DTYPE_0B127,							//  31 PAR_MOD_OSC_GAIN1_CYM
+	DTYPE_0B127,							//  32 PAR_MOD_OSC_GAIN2_CYM
+	DTYPE_0B127,							//  33 PAR_MOD_OSC_F1
+	DTYPE_0B127,							//  34 PAR_MOD_OSC_F2
+	DTYPE_0B127,							//  35 PAR_MOD_OSC_GAIN1
+	DTYPE_0B127,							//  36 PAR_MOD_OSC_GAIN2
+	DTYPE_0B127,							//  37 PAR_FILTER_FREQ_1
+	DTYPE_0B127,							//  38 PAR_FILTER_FREQ_2
+	DTYPE_0B127,							//  39 PAR_FILTER_FREQ_3
+	DTYPE_0B127,							//  40 PAR_FILTER_FREQ_4
+	DTYPE_0B127,							//  41 PAR_FILTER_FREQ_5
+	DTYPE_0B127,							//  42 PAR_FILTER_FREQ_6
+	DTYPE_0B127,							//  43 PAR_RESO_1
+	DTYPE_0B127,							//  44 PAR_RESO_2
+	DTYPE_0B127,							//  45 PAR_RESO_3
+	DTYPE_0B127,							//  46 PAR_RESO_4
+	DTYPE_0B127,							//  47 PAR_RESO_5
+	DTYPE_0B127,							//  48 PAR_RESO_6
+	DTYPE_0B127,							//  49 PAR_VELOA1
+	DTYPE_0B127,							//  50 PAR_VELOD1
+	DTYPE_0B127,							//  51 PAR_VELOA2
+	DTYPE_0B127,							//  52 PAR_VELOD2
+	DTYPE_0B127,							//  53 PAR_VELOA3
+	DTYPE_0B127,							//  54 PAR_VELOD3
+	DTYPE_0B127,							//  55 PAR_VELOA4
+	DTYPE_0B127,							//  56 PAR_VELOD4
+	DTYPE_0B127,							//  57 PAR_VELOA5
+	DTYPE_0B127,							//  58 PAR_VELOD5
+	DTYPE_0B127,							//  59 PAR_VELOA6
+	DTYPE_0B127,							//  60 PAR_VELOD6_CLOSED
+	DTYPE_0B127,							//  61 PAR_VELOD6_OPEN
+	DTYPE_0B127,							//  62 PAR_VOL_SLOPE1
+	DTYPE_0B127,							//  63 PAR_VOL_SLOPE2
+	DTYPE_0B127,							//  64 PAR_VOL_SLOPE3
+	DTYPE_0B127,							//  65 PAR_VOL_SLOPE4
+	DTYPE_0B127,							//  66 PAR_VOL_SLOPE5
+	DTYPE_0B127,							//  67 PAR_VOL_SLOPE6
+	DTYPE_0B127,							//  68 PAR_REPEAT4
+	DTYPE_0B127,							//  69 PAR_REPEAT5
+	DTYPE_0B127,							//  70 PAR_MOD_EG1
+	DTYPE_0B127,							//  71 PAR_MOD_EG2
+	DTYPE_0B127,							//  72 PAR_MOD_EG3
+	DTYPE_0B127,							//  73 PAR_MOD_EG4
+	DTYPE_0B127,							//  74 PAR_MODAMNT1
+	DTYPE_0B127,							//  75 PAR_MODAMNT2
+	DTYPE_0B127,							//  76 PAR_MODAMNT3
+	DTYPE_0B127,							//  77 PAR_MODAMNT4
+	DTYPE_0B127,							//  78 PAR_PITCH_SLOPE1
+	DTYPE_0B127,							//  79 PAR_PITCH_SLOPE2
+	DTYPE_0B127,							//  80 PAR_PITCH_SLOPE3
+	DTYPE_0B127,							//  81 PAR_PITCH_SLOPE4
+	DTYPE_0B127,							//  82 PAR_FMAMNT1
+	DTYPE_0B127,							//  83 PAR_FM_FREQ1
+	DTYPE_0B127,							//  84 PAR_FMAMNT2
+	DTYPE_0B127,							//  85 PAR_FM_FREQ2
+	DTYPE_0B127,							//  86 PAR_FMAMNT3
+	DTYPE_0B127,							//  87 PAR_FM_FREQ3
+	DTYPE_0B127,							//  88 PAR_VOL1
+	DTYPE_0B127,							//  89 PAR_VOL2
+	DTYPE_0B127,							//  90 PAR_VOL3
+	DTYPE_0B127,							//  91 PAR_VOL4
+	DTYPE_0B127,							//  92 PAR_VOL5
+	DTYPE_0B127,							//  93 PAR_VOL6
+	DTYPE_PM63,								//  94 PAR_PAN1
+	DTYPE_PM63,								//  95 PAR_PAN2
+	DTYPE_PM63,								//  96 PAR_PAN3
+	DTYPE_0B127,							//  97 NRPN_FINE
+	DTYPE_0B127,							//  98 NRPN_COARSE
+	DTYPE_PM63,								//  99 PAR_PAN4
+	DTYPE_PM63,								// 100 PAR_PAN5
+	DTYPE_PM63,								// 101 PAR_PAN6
+	DTYPE_0B127,							// 102 PAR_DRIVE1
+	DTYPE_0B127,							// 103 PAR_DRIVE2
+	DTYPE_0B127,							// 104 PAR_DRIVE3
+	DTYPE_0B127,							// 105 PAR_SNARE_DISTORTION
+	DTYPE_0B127,							// 106 PAR_CYMBAL_DISTORTION
+	DTYPE_0B127,							// 107 PAR_HAT_DISTORTION
+	DTYPE_0B127,							// 108 PAR_VOICE_DECIMATION1
+	DTYPE_0B127,							// 109 PAR_VOICE_DECIMATION2
+	DTYPE_0B127,							// 110 PAR_VOICE_DECIMATION3
+	DTYPE_0B127,							// 111 PAR_VOICE_DECIMATION4
+	DTYPE_0B127,							// 112 PAR_VOICE_DECIMATION5
+	DTYPE_0B127,							// 113 PAR_VOICE_DECIMATION6
+	DTYPE_0B127,							// 114 PAR_VOICE_DECIMATION_ALL
+	DTYPE_0B127,							// 115 PAR_FREQ_LFO1
+	DTYPE_0B127,							// 116 PAR_FREQ_LFO2
+	DTYPE_0B127,							// 117 PAR_FREQ_LFO3
+	DTYPE_0B127,							// 118 PAR_FREQ_LFO4
+	DTYPE_0B127,							// 119 PAR_FREQ_LFO5
+	DTYPE_0B127,							// 120 PAR_FREQ_LFO6
+	DTYPE_0B127,							// 121 PAR_AMOUNT_LFO1
+	DTYPE_0B127,							// 122 PAR_AMOUNT_LFO2
+	DTYPE_0B127,							// 123 PAR_AMOUNT_LFO3
+	DTYPE_0B127,							// 124 PAR_AMOUNT_LFO4
+	DTYPE_0B127,							// 125 PAR_AMOUNT_LFO5
+	DTYPE_0B127,							// 126 PAR_AMOUNT_LFO6
+	DTYPE_0B127,							// 127 PAR_RESERVED4
+	DTYPE_0B127,							// 128 PAR_FILTER_DRIVE_1
+	DTYPE_0B127,							// 129 PAR_FILTER_DRIVE_2
+	DTYPE_0B127,							// 130 PAR_FILTER_DRIVE_3
+	DTYPE_0B127,							// 131 PAR_FILTER_DRIVE_4
+	DTYPE_0B127,							// 132 PAR_FILTER_DRIVE_5
+	DTYPE_0B127,							// 133 PAR_FILTER_DRIVE_6
+	DTYPE_MIX_FM,							// 134 PAR_MIX_MOD_1
+	DTYPE_MIX_FM,							// 135 PAR_MIX_MOD_2
+	DTYPE_MIX_FM,							// 136 PAR_MIX_MOD_3
+	DTYPE_ON_OFF,							// 137 PAR_VOLUME_MOD_ON_OFF1
+	DTYPE_ON_OFF,							// 138 PAR_VOLUME_MOD_ON_OFF2
+	DTYPE_ON_OFF,							// 139 PAR_VOLUME_MOD_ON_OFF3
+	DTYPE_ON_OFF,							// 140 PAR_VOLUME_MOD_ON_OFF4
+	DTYPE_ON_OFF,							// 141 PAR_VOLUME_MOD_ON_OFF5
+	DTYPE_ON_OFF,							// 142 PAR_VOLUME_MOD_ON_OFF6
+	DTYPE_0B127,							// 143 PAR_VELO_MOD_AMT_1
+	DTYPE_0B127,							// 144 PAR_VELO_MOD_AMT_2
+	DTYPE_0B127,							// 145 PAR_VELO_MOD_AMT_3
+	DTYPE_0B127,							// 146 PAR_VELO_MOD_AMT_4
+	DTYPE_0B127,							// 147 PAR_VELO_MOD_AMT_5
+	DTYPE_0B127,							// 148 PAR_VELO_MOD_AMT_6
+	DTYPE_TARGET_SELECTION_VELO,			// 149 PAR_VEL_DEST_1
+	DTYPE_TARGET_SELECTION_VELO,			// 150 PAR_VEL_DEST_2
+	DTYPE_TARGET_SELECTION_VELO,			// 151 PAR_VEL_DEST_3
+	DTYPE_TARGET_SELECTION_VELO,			// 152 PAR_VEL_DEST_4
+	DTYPE_TARGET_SELECTION_VELO,			// 153 PAR_VEL_DEST_5
+	DTYPE_TARGET_SELECTION_VELO,			// 154 PAR_VEL_DEST_6
+	DTYPE_MENU | (MENU_LFO_WAVES<<4),		// 155 PAR_WAVE_LFO1
+	DTYPE_MENU | (MENU_LFO_WAVES<<4),		// 156 PAR_WAVE_LFO2
+	DTYPE_MENU | (MENU_LFO_WAVES<<4),		// 157 PAR_WAVE_LFO3
+	DTYPE_MENU | (MENU_LFO_WAVES<<4),		// 158 PAR_WAVE_LFO4
+	DTYPE_MENU | (MENU_LFO_WAVES<<4),		// 159 PAR_WAVE_LFO5
+	DTYPE_MENU | (MENU_LFO_WAVES<<4),		// 160 PAR_WAVE_LFO6
+	DTYPE_1B6,								// 161 PAR_VOICE_LFO1
+	DTYPE_1B6,								// 162 PAR_VOICE_LFO2
+	DTYPE_1B6,								// 163 PAR_VOICE_LFO3
+	DTYPE_1B6,								// 164 PAR_VOICE_LFO4
+	DTYPE_1B6,								// 165 PAR_VOICE_LFO5
+	DTYPE_1B6,								// 166 PAR_VOICE_LFO6
+	DTYPE_TARGET_SELECTION_LFO,				// 167 PAR_TARGET_LFO1
+	DTYPE_TARGET_SELECTION_LFO,				// 168 PAR_TARGET_LFO2
+	DTYPE_TARGET_SELECTION_LFO,				// 169 PAR_TARGET_LFO3
+	DTYPE_TARGET_SELECTION_LFO,				// 170 PAR_TARGET_LFO4
+	DTYPE_TARGET_SELECTION_LFO,				// 171 PAR_TARGET_LFO5
+	DTYPE_TARGET_SELECTION_LFO,				// 172 PAR_TARGET_LFO6
+	DTYPE_MENU | (MENU_RETRIGGER<<4),		// 173 PAR_RETRIGGER_LFO1
+	DTYPE_MENU | (MENU_RETRIGGER<<4),		// 174 PAR_RETRIGGER_LFO2
+	DTYPE_MENU | (MENU_RETRIGGER<<4),		// 175 PAR_RETRIGGER_LFO3
+	DTYPE_MENU | (MENU_RETRIGGER<<4),		// 176 PAR_RETRIGGER_LFO4
+	DTYPE_MENU | (MENU_RETRIGGER<<4),		// 177 PAR_RETRIGGER_LFO5
+	DTYPE_MENU | (MENU_RETRIGGER<<4),		// 178 PAR_RETRIGGER_LFO6
+	DTYPE_MENU | (MENU_SYNC_RATES<<4),		// 179 PAR_SYNC_LFO1
+	DTYPE_MENU | (MENU_SYNC_RATES<<4),		// 180 PAR_SYNC_LFO2
+	DTYPE_MENU | (MENU_SYNC_RATES<<4),		// 181 PAR_SYNC_LFO3
+	DTYPE_MENU | (MENU_SYNC_RATES<<4),		// 182 PAR_SYNC_LFO4
+	DTYPE_MENU | (MENU_SYNC_RATES<<4),		// 183 PAR_SYNC_LFO5
+	DTYPE_MENU | (MENU_SYNC_RATES<<4),		// 184 PAR_SYNC_LFO6
+	DTYPE_0B127,							// 185 PAR_OFFSET_LFO1
+	DTYPE_0B127,							// 186 PAR_OFFSET_LFO2
+	DTYPE_0B127,							// 187 PAR_OFFSET_LFO3
+	DTYPE_0B127,							// 188 PAR_OFFSET_LFO4
+	DTYPE_0B127,							// 189 PAR_OFFSET_LFO5
+	DTYPE_0B127,							// 190 PAR_OFFSET_LFO6
+	DTYPE_MENU | (MENU_FILTER<<4),			// 191 PAR_FILTER_TYPE_1
+	DTYPE_MENU | (MENU_FILTER<<4),			// 192 PAR_FILTER_TYPE_2
+	DTYPE_MENU | (MENU_FILTER<<4),			// 193 PAR_FILTER_TYPE_3
+	DTYPE_MENU | (MENU_FILTER<<4),			// 194 PAR_FILTER_TYPE_4
+	DTYPE_MENU | (MENU_FILTER<<4),			// 195 PAR_FILTER_TYPE_5
+	DTYPE_MENU | (MENU_FILTER<<4),			// 196 PAR_FILTER_TYPE_6
+	DTYPE_0B127,							// 197 PAR_TRANS1_VOL
+	DTYPE_0B127,							// 198 PAR_TRANS2_VOL
+	DTYPE_0B127,							// 199 PAR_TRANS3_VOL
+	DTYPE_0B127,							// 200 PAR_TRANS4_VOL
+	DTYPE_0B127,							// 201 PAR_TRANS5_VOL
+	DTYPE_0B127,							// 202 PAR_TRANS6_VOL
+	DTYPE_0B127,							// 203 PAR_TRANS1_WAVE
+	DTYPE_0B127,							// 204 PAR_TRANS2_WAVE
+	DTYPE_0B127,							// 205 PAR_TRANS3_WAVE
+	DTYPE_0B127,							// 206 PAR_TRANS4_WAVE
+	DTYPE_0B127,							// 207 PAR_TRANS5_WAVE
+	DTYPE_0B127,							// 208 PAR_TRANS6_WAVE
+	DTYPE_0B127,							// 209 PAR_TRANS1_FREQ
+	DTYPE_0B127,							// 210 PAR_TRANS2_FREQ
+	DTYPE_0B127,							// 211 PAR_TRANS3_FREQ
+	DTYPE_0B127,							// 212 PAR_TRANS4_FREQ
+	DTYPE_0B127,							// 213 PAR_TRANS5_FREQ
+	DTYPE_0B127,							// 214 PAR_TRANS6_FREQ
+	DTYPE_MENU | (MENU_AUDIO_OUT<<4),		// 215 PAR_AUDIO_OUT1
+	DTYPE_MENU | (MENU_AUDIO_OUT<<4),		// 216 PAR_AUDIO_OUT2
+	DTYPE_MENU | (MENU_AUDIO_OUT<<4),		// 217 PAR_AUDIO_OUT3
+	DTYPE_MENU | (MENU_AUDIO_OUT<<4),		// 218 PAR_AUDIO_OUT4
+	DTYPE_MENU | (MENU_AUDIO_OUT<<4),		// 219 PAR_AUDIO_OUT5
+	DTYPE_MENU | (MENU_AUDIO_OUT<<4),		// 220 PAR_AUDIO_OUT6
+	DTYPE_MENU | (MENU_ROLL_RATES<<4),		// 221 PAR_ROLL
+	DTYPE_0B255,							// 222 PAR_MORPH
+	DTYPE_0B127,							// 223 PAR_ACTIVE_STEP
+	DTYPE_0B127,							// 224 PAR_STEP_VOLUME
+	DTYPE_0B127,							// 225 PAR_STEP_PROB
+	DTYPE_PM63,								// 226 PAR_STEP_NOTE
+	DTYPE_1B16,								// 227 PAR_EUKLID_LENGTH
+	DTYPE_1B16,								// 228 PAR_EUKLID_STEPS
+	DTYPE_0b1,								// 229 PAR_AUTOM_TRACK
+	DTYPE_AUTOM_TARGET,						// 230 PAR_P1_DEST
+	DTYPE_AUTOM_TARGET,						// 231 PAR_P2_DEST
+	DTYPE_0B127,							// 232 PAR_P1_VAL
+	DTYPE_0B127,							// 233 PAR_P2_VAL
+	DTYPE_0B127,							// 234 PAR_SHUFFLE
+	DTYPE_0B127,							// 235 PAR_PATTERN_BEAT
+	DTYPE_MENU | (MENU_NEXT_PATTERN<<4),	// 236 PAR_PATTERN_NEXT
+	DTYPE_0B255,							// 237 PAR_BPM
+	DTYPE_1B16,								// 238 PAR_MIDI_CHAN_1
+	DTYPE_1B16,								// 239 PAR_MIDI_CHAN_2
+	DTYPE_1B16,								// 240 PAR_MIDI_CHAN_3
+	DTYPE_1B16,								// 241 PAR_MIDI_CHAN_4
+	DTYPE_1B16,								// 242 PAR_MIDI_CHAN_5
+	DTYPE_1B16,								// 243 PAR_MIDI_CHAN_6
+	DTYPE_ON_OFF,							// 244 PAR_FETCH
+	DTYPE_ON_OFF,							// 245 PAR_FOLLOW
+	DTYPE_MENU | (MENU_SEQ_QUANT<<4),		// 246 PAR_QUANTISATION
+	DTYPE_1B16,								// 247 PAR_TRACK_LENGTH
+};
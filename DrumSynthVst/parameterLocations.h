@@ -0,0 +1,331 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./controllerAssignments.h"
+
+#define NO_VOICE -1
+
+//---------------------------------------------------------------------------
+/** Where a parameter is edited: voice tab, 1 based control index (the
+	widget name) and control type. The reverse of controllerAssignments,
+	so incoming values can be routed without searching.
+*/
+struct ParameterLocation
+{
+	signed char voiceNr;	// NO_VOICE if no voice tab edits the parameter
+	signed char controlNr;
+	signed char controlType;
+};
+
+// generated from controllerAssignments and getControlType().
+// regenerate when an assignment changes, checkParameterLocations() catches a stale table in debug builds
+static const ParameterLocation parameterLocations[NUM_PARAMS] = {
+	{NO_VOICE,	0,	TYPE_SLIDER},	//   0 PAR_NONE
+	{0,		4,	TYPE_COMBO},	//   1 PAR_OSC_WAVE_DRUM1
+	{1,		4,	TYPE_COMBO},	//   2 PAR_OSC_WAVE_DRUM2
+	{2,		4,	TYPE_COMBO},	//   3 PAR_OSC_WAVE_DRUM3
+	{3,		4,	TYPE_COMBO},	//   4 PAR_OSC_WAVE_SNARE
+	{NO_VOICE,	0,	TYPE_SLIDER},	//   5 NRPN_DATA_ENTRY_COARSE
+	{4,		4,	TYPE_COMBO},	//   6 PAR_WAVE1_CYM
+	{5,		4,	TYPE_COMBO},	//   7 PAR_WAVE1_HH
+	{0,		1,	TYPE_SLIDER},	//   8 PAR_COARSE1
+	{0,		2,	TYPE_SLIDER},	//   9 PAR_FINE1
+	{1,		1,	TYPE_SLIDER},	//  10 PAR_COARSE2
+	{1,		2,	TYPE_SLIDER},	//  11 PAR_FINE2
+	{2,		1,	TYPE_SLIDER},	//  12 PAR_COARSE3
+	{2,		2,	TYPE_SLIDER},	//  13 PAR_FINE3
+	{3,		1,	TYPE_SLIDER},	//  14 PAR_COARSE4
+	{3,		2,	TYPE_SLIDER},	//  15 PAR_FINE4
+	{4,		1,	TYPE_SLIDER},	//  16 PAR_COARSE5
+	{4,		2,	TYPE_SLIDER},	//  17 PAR_FINE5
+	{5,		1,	TYPE_SLIDER},	//  18 PAR_COARSE6
+	{5,		2,	TYPE_SLIDER},	//  19 PAR_FINE6
+	{0,		18,	TYPE_COMBO},	//  20 PAR_MOD_WAVE_DRUM1
+	{1,		18,	TYPE_COMBO},	//  21 PAR_MOD_WAVE_DRUM2
+	{2,		18,	TYPE_COMBO},	//  22 PAR_MOD_WAVE_DRUM3
+	{4,		20,	TYPE_COMBO},	//  23 PAR_WAVE2_CYM
+	{4,		21,	TYPE_COMBO},	//  24 PAR_WAVE3_CYM
+	{5,		20,	TYPE_COMBO},	//  25 PAR_WAVE2_HH
+	{5,		21,	TYPE_COMBO},	//  26 PAR_WAVE3_HH
+	{3,		3,	TYPE_SLIDER},	//  27 PAR_NOISE_FREQ1
+	{3,		5,	TYPE_SLIDER},	//  28 PAR_MIX1
+	{4,		16,	TYPE_SLIDER},	//  29 PAR_MOD_OSC_F1_CYM
+	{4,		17,	TYPE_SLIDER},	//  30 PAR_MOD_OSC_F2_CYM
+	{4,		18,	TYPE_SLIDER},	//  31 PAR_MOD_OSC_GAIN1_CYM
+	{4,		19,	TYPE_SLIDER},	//  32 PAR_MOD_OSC_GAIN2_CYM
+	{5,		16,	TYPE_SLIDER},	//  33 PAR_MOD_OSC_F1
+	{5,		17,	TYPE_SLIDER},	//  34 PAR_MOD_OSC_F2
+	{5,		18,	TYPE_SLIDER},	//  35 PAR_MOD_OSC_GAIN1
+	{5,		19,	TYPE_SLIDER},	//  36 PAR_MOD_OSC_GAIN2
+	{0,		25,	TYPE_SLIDER},	//  37 PAR_FILTER_FREQ_1
+	{1,		25,	TYPE_SLIDER},	//  38 PAR_FILTER_FREQ_2
+	{2,		25,	TYPE_SLIDER},	//  39 PAR_FILTER_FREQ_3
+	{3,		25,	TYPE_SLIDER},	//  40 PAR_FILTER_FREQ_4
+	{4,		25,	TYPE_SLIDER},	//  41 PAR_FILTER_FREQ_5
+	{5,		25,	TYPE_SLIDER},	//  42 PAR_FILTER_FREQ_6
+	{0,		26,	TYPE_SLIDER},	//  43 PAR_RESO_1
+	{1,		26,	TYPE_SLIDER},	//  44 PAR_RESO_2
+	{2,		26,	TYPE_SLIDER},	//  45 PAR_RESO_3
+	{3,		26,	TYPE_SLIDER},	//  46 PAR_RESO_4
+	{4,		26,	TYPE_SLIDER},	//  47 PAR_RESO_5
+	{5,		26,	TYPE_SLIDER},	//  48 PAR_RESO_6
+	{0,		6,	TYPE_SLIDER},	//  49 PAR_VELOA1
+	{0,		7,	TYPE_SLIDER},	//  50 PAR_VELOD1
+	{1,		6,	TYPE_SLIDER},	//  51 PAR_VELOA2
+	{1,		7,	TYPE_SLIDER},	//  52 PAR_VELOD2
+	{2,		6,	TYPE_SLIDER},	//  53 PAR_VELOA3
+	{2,		7,	TYPE_SLIDER},	//  54 PAR_VELOD3
+	{3,		6,	TYPE_SLIDER},	//  55 PAR_VELOA4
+	{3,		7,	TYPE_SLIDER},	//  56 PAR_VELOD4
+	{4,		6,	TYPE_SLIDER},	//  57 PAR_VELOA5
+	{4,		7,	TYPE_SLIDER},	//  58 PAR_VELOD5
+	{5,		6,	TYPE_SLIDER},	//  59 PAR_VELOA6
+	{5,		7,	TYPE_SLIDER},	//  60 PAR_VELOD6_CLOSED
+	{5,		8,	TYPE_SLIDER},	//  61 PAR_VELOD6_OPEN
+	{0,		9,	TYPE_SLIDER},	//  62 PAR_VOL_SLOPE1
+	{1,		9,	TYPE_SLIDER},	//  63 PAR_VOL_SLOPE2
+	{2,		9,	TYPE_SLIDER},	//  64 PAR_VOL_SLOPE3
+	{3,		9,	TYPE_SLIDER},	//  65 PAR_VOL_SLOPE4
+	{4,		9,	TYPE_SLIDER},	//  66 PAR_VOL_SLOPE5
+	{5,		9,	TYPE_SLIDER},	//  67 PAR_VOL_SLOPE6
+	{3,		8,	TYPE_SLIDER},	//  68 PAR_REPEAT4
+	{4,		8,	TYPE_SLIDER},	//  69 PAR_REPEAT5
+	{0,		10,	TYPE_SLIDER},	//  70 PAR_MOD_EG1
+	{1,		10,	TYPE_SLIDER},	//  71 PAR_MOD_EG2
+	{2,		10,	TYPE_SLIDER},	//  72 PAR_MOD_EG3
+	{3,		10,	TYPE_SLIDER},	//  73 PAR_MOD_EG4
+	{0,		12,	TYPE_SLIDER},	//  74 PAR_MODAMNT1
+	{1,		12,	TYPE_SLIDER},	//  75 PAR_MODAMNT2
+	{2,		12,	TYPE_SLIDER},	//  76 PAR_MODAMNT3
+	{3,		12,	TYPE_SLIDER},	//  77 PAR_MODAMNT4
+	{0,		11,	TYPE_SLIDER},	//  78 PAR_PITCH_SLOPE1
+	{1,		11,	TYPE_SLIDER},	//  79 PAR_PITCH_SLOPE2
+	{2,		11,	TYPE_SLIDER},	//  80 PAR_PITCH_SLOPE3
+	{3,		11,	TYPE_SLIDER},	//  81 PAR_PITCH_SLOPE4
+	{0,		16,	TYPE_SLIDER},	//  82 PAR_FMAMNT1
+	{0,		17,	TYPE_SLIDER},	//  83 PAR_FM_FREQ1
+	{1,		16,	TYPE_SLIDER},	//  84 PAR_FMAMNT2
+	{1,		17,	TYPE_SLIDER},	//  85 PAR_FM_FREQ2
+	{2,		16,	TYPE_SLIDER},	//  86 PAR_FMAMNT3
+	{2,		17,	TYPE_SLIDER},	//  87 PAR_FM_FREQ3
+	{0,		37,	TYPE_SLIDER},	//  88 PAR_VOL1
+	{1,		37,	TYPE_SLIDER},	//  89 PAR_VOL2
+	{2,		37,	TYPE_SLIDER},	//  90 PAR_VOL3
+	{3,		37,	TYPE_SLIDER},	//  91 PAR_VOL4
+	{4,		37,	TYPE_SLIDER},	//  92 PAR_VOL5
+	{5,		37,	TYPE_SLIDER},	//  93 PAR_VOL6
+	{0,		38,	TYPE_SLIDER},	//  94 PAR_PAN1
+	{1,		38,	TYPE_SLIDER},	//  95 PAR_PAN2
+	{2,		38,	TYPE_SLIDER},	//  96 PAR_PAN3
+	{NO_VOICE,	0,	TYPE_SLIDER},	//  97 NRPN_FINE
+	{NO_VOICE,	0,	TYPE_SLIDER},	//  98 NRPN_COARSE
+	{3,		38,	TYPE_SLIDER},	//  99 PAR_PAN4
+	{4,		38,	TYPE_SLIDER},	// 100 PAR_PAN5
+	{5,		38,	TYPE_SLIDER},	// 101 PAR_PAN6
+	{0,		40,	TYPE_SLIDER},	// 102 PAR_DRIVE1
+	{1,		40,	TYPE_SLIDER},	// 103 PAR_DRIVE2
+	{2,		40,	TYPE_SLIDER},	// 104 PAR_DRIVE3
+	{3,		40,	TYPE_SLIDER},	// 105 PAR_SNARE_DISTORTION
+	{4,		40,	TYPE_SLIDER},	// 106 PAR_CYMBAL_DISTORTION
+	{5,		40,	TYPE_SLIDER},	// 107 PAR_HAT_DISTORTION
+	{0,		39,	TYPE_SLIDER},	// 108 PAR_VOICE_DECIMATION1
+	{1,		39,	TYPE_SLIDER},	// 109 PAR_VOICE_DECIMATION2
+	{2,		39,	TYPE_SLIDER},	// 110 PAR_VOICE_DECIMATION3
+	{3,		39,	TYPE_SLIDER},	// 111 PAR_VOICE_DECIMATION4
+	{4,		39,	TYPE_SLIDER},	// 112 PAR_VOICE_DECIMATION5
+	{5,		39,	TYPE_SLIDER},	// 113 PAR_VOICE_DECIMATION6
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 114 PAR_VOICE_DECIMATION_ALL
+	{0,		29,	TYPE_SLIDER},	// 115 PAR_FREQ_LFO1
+	{1,		29,	TYPE_SLIDER},	// 116 PAR_FREQ_LFO2
+	{2,		29,	TYPE_SLIDER},	// 117 PAR_FREQ_LFO3
+	{3,		29,	TYPE_SLIDER},	// 118 PAR_FREQ_LFO4
+	{4,		29,	TYPE_SLIDER},	// 119 PAR_FREQ_LFO5
+	{5,		29,	TYPE_SLIDER},	// 120 PAR_FREQ_LFO6
+	{0,		31,	TYPE_SLIDER},	// 121 PAR_AMOUNT_LFO1
+	{1,		31,	TYPE_SLIDER},	// 122 PAR_AMOUNT_LFO2
+	{2,		31,	TYPE_SLIDER},	// 123 PAR_AMOUNT_LFO3
+	{3,		31,	TYPE_SLIDER},	// 124 PAR_AMOUNT_LFO4
+	{4,		31,	TYPE_SLIDER},	// 125 PAR_AMOUNT_LFO5
+	{5,		31,	TYPE_SLIDER},	// 126 PAR_AMOUNT_LFO6
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 127 PAR_RESERVED4
+	{0,		28,	TYPE_SLIDER},	// 128 PAR_FILTER_DRIVE_1
+	{1,		28,	TYPE_SLIDER},	// 129 PAR_FILTER_DRIVE_2
+	{2,		28,	TYPE_SLIDER},	// 130 PAR_FILTER_DRIVE_3
+	{3,		28,	TYPE_SLIDER},	// 131 PAR_FILTER_DRIVE_4
+	{4,		28,	TYPE_SLIDER},	// 132 PAR_FILTER_DRIVE_5
+	{5,		28,	TYPE_SLIDER},	// 133 PAR_FILTER_DRIVE_6
+	{0,		19,	TYPE_BUTTON},	// 134 PAR_MIX_MOD_1
+	{1,		19,	TYPE_BUTTON},	// 135 PAR_MIX_MOD_2
+	{2,		19,	TYPE_BUTTON},	// 136 PAR_MIX_MOD_3
+	{0,		15,	TYPE_BUTTON},	// 137 PAR_VOLUME_MOD_ON_OFF1
+	{1,		15,	TYPE_BUTTON},	// 138 PAR_VOLUME_MOD_ON_OFF2
+	{2,		15,	TYPE_BUTTON},	// 139 PAR_VOLUME_MOD_ON_OFF3
+	{3,		15,	TYPE_BUTTON},	// 140 PAR_VOLUME_MOD_ON_OFF4
+	{4,		15,	TYPE_BUTTON},	// 141 PAR_VOLUME_MOD_ON_OFF5
+	{5,		15,	TYPE_BUTTON},	// 142 PAR_VOLUME_MOD_ON_OFF6
+	{0,		14,	TYPE_SLIDER},	// 143 PAR_VELO_MOD_AMT_1
+	{1,		14,	TYPE_SLIDER},	// 144 PAR_VELO_MOD_AMT_2
+	{2,		14,	TYPE_SLIDER},	// 145 PAR_VELO_MOD_AMT_3
+	{3,		14,	TYPE_SLIDER},	// 146 PAR_VELO_MOD_AMT_4
+	{4,		14,	TYPE_SLIDER},	// 147 PAR_VELO_MOD_AMT_5
+	{5,		14,	TYPE_SLIDER},	// 148 PAR_VELO_MOD_AMT_6
+	{0,		13,	TYPE_COMBO},	// 149 PAR_VEL_DEST_1
+	{1,		13,	TYPE_COMBO},	// 150 PAR_VEL_DEST_2
+	{2,		13,	TYPE_COMBO},	// 151 PAR_VEL_DEST_3
+	{3,		13,	TYPE_COMBO},	// 152 PAR_VEL_DEST_4
+	{4,		13,	TYPE_COMBO},	// 153 PAR_VEL_DEST_5
+	{5,		13,	TYPE_COMBO},	// 154 PAR_VEL_DEST_6
+	{0,		32,	TYPE_COMBO},	// 155 PAR_WAVE_LFO1
+	{1,		32,	TYPE_COMBO},	// 156 PAR_WAVE_LFO2
+	{2,		32,	TYPE_COMBO},	// 157 PAR_WAVE_LFO3
+	{3,		32,	TYPE_COMBO},	// 158 PAR_WAVE_LFO4
+	{4,		32,	TYPE_COMBO},	// 159 PAR_WAVE_LFO5
+	{5,		32,	TYPE_COMBO},	// 160 PAR_WAVE_LFO6
+	{0,		35,	TYPE_COMBO},	// 161 PAR_VOICE_LFO1
+	{1,		35,	TYPE_COMBO},	// 162 PAR_VOICE_LFO2
+	{2,		35,	TYPE_COMBO},	// 163 PAR_VOICE_LFO3
+	{3,		35,	TYPE_COMBO},	// 164 PAR_VOICE_LFO4
+	{4,		35,	TYPE_COMBO},	// 165 PAR_VOICE_LFO5
+	{5,		35,	TYPE_COMBO},	// 166 PAR_VOICE_LFO6
+	{0,		36,	TYPE_COMBO},	// 167 PAR_TARGET_LFO1
+	{1,		36,	TYPE_COMBO},	// 168 PAR_TARGET_LFO2
+	{2,		36,	TYPE_COMBO},	// 169 PAR_TARGET_LFO3
+	{3,		36,	TYPE_COMBO},	// 170 PAR_TARGET_LFO4
+	{4,		36,	TYPE_COMBO},	// 171 PAR_TARGET_LFO5
+	{5,		36,	TYPE_COMBO},	// 172 PAR_TARGET_LFO6
+	{0,		33,	TYPE_COMBO},	// 173 PAR_RETRIGGER_LFO1
+	{1,		33,	TYPE_COMBO},	// 174 PAR_RETRIGGER_LFO2
+	{2,		33,	TYPE_COMBO},	// 175 PAR_RETRIGGER_LFO3
+	{3,		33,	TYPE_COMBO},	// 176 PAR_RETRIGGER_LFO4
+	{4,		33,	TYPE_COMBO},	// 177 PAR_RETRIGGER_LFO5
+	{5,		33,	TYPE_COMBO},	// 178 PAR_RETRIGGER_LFO6
+	{0,		30,	TYPE_COMBO},	// 179 PAR_SYNC_LFO1
+	{1,		30,	TYPE_COMBO},	// 180 PAR_SYNC_LFO2
+	{2,		30,	TYPE_COMBO},	// 181 PAR_SYNC_LFO3
+	{3,		30,	TYPE_COMBO},	// 182 PAR_SYNC_LFO4
+	{4,		30,	TYPE_COMBO},	// 183 PAR_SYNC_LFO5
+	{5,		30,	TYPE_COMBO},	// 184 PAR_SYNC_LFO6
+	{0,		34,	TYPE_SLIDER},	// 185 PAR_OFFSET_LFO1
+	{1,		34,	TYPE_SLIDER},	// 186 PAR_OFFSET_LFO2
+	{2,		34,	TYPE_SLIDER},	// 187 PAR_OFFSET_LFO3
+	{3,		34,	TYPE_SLIDER},	// 188 PAR_OFFSET_LFO4
+	{4,		34,	TYPE_SLIDER},	// 189 PAR_OFFSET_LFO5
+	{5,		34,	TYPE_SLIDER},	// 190 PAR_OFFSET_LFO6
+	{0,		27,	TYPE_COMBO},	// 191 PAR_FILTER_TYPE_1
+	{1,		27,	TYPE_COMBO},	// 192 PAR_FILTER_TYPE_2
+	{2,		27,	TYPE_COMBO},	// 193 PAR_FILTER_TYPE_3
+	{3,		27,	TYPE_COMBO},	// 194 PAR_FILTER_TYPE_4
+	{4,		27,	TYPE_COMBO},	// 195 PAR_FILTER_TYPE_5
+	{5,		27,	TYPE_COMBO},	// 196 PAR_FILTER_TYPE_6
+	{0,		23,	TYPE_SLIDER},	// 197 PAR_TRANS1_VOL
+	{1,		23,	TYPE_SLIDER},	// 198 PAR_TRANS2_VOL
+	{2,		23,	TYPE_SLIDER},	// 199 PAR_TRANS3_VOL
+	{3,		23,	TYPE_SLIDER},	// 200 PAR_TRANS4_VOL
+	{4,		23,	TYPE_SLIDER},	// 201 PAR_TRANS5_VOL
+	{5,		23,	TYPE_SLIDER},	// 202 PAR_TRANS6_VOL
+	{0,		22,	TYPE_COMBO},	// 203 PAR_TRANS1_WAVE
+	{1,		22,	TYPE_COMBO},	// 204 PAR_TRANS2_WAVE
+	{2,		22,	TYPE_COMBO},	// 205 PAR_TRANS3_WAVE
+	{3,		22,	TYPE_COMBO},	// 206 PAR_TRANS4_WAVE
+	{4,		22,	TYPE_COMBO},	// 207 PAR_TRANS5_WAVE
+	{5,		22,	TYPE_COMBO},	// 208 PAR_TRANS6_WAVE
+	{0,		24,	TYPE_SLIDER},	// 209 PAR_TRANS1_FREQ
+	{1,		24,	TYPE_SLIDER},	// 210 PAR_TRANS2_FREQ
+	{2,		24,	TYPE_SLIDER},	// 211 PAR_TRANS3_FREQ
+	{3,		24,	TYPE_SLIDER},	// 212 PAR_TRANS4_FREQ
+	{4,		24,	TYPE_SLIDER},	// 213 PAR_TRANS5_FREQ
+	{5,		24,	TYPE_SLIDER},	// 214 PAR_TRANS6_FREQ
+	{0,		41,	TYPE_COMBO},	// 215 PAR_AUDIO_OUT1
+	{1,		41,	TYPE_COMBO},	// 216 PAR_AUDIO_OUT2
+	{2,		41,	TYPE_COMBO},	// 217 PAR_AUDIO_OUT3
+	{3,		41,	TYPE_COMBO},	// 218 PAR_AUDIO_OUT4
+	{4,		41,	TYPE_COMBO},	// 219 PAR_AUDIO_OUT5
+	{5,		41,	TYPE_COMBO},	// 220 PAR_AUDIO_OUT6
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 221 PAR_ROLL
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 222 PAR_MORPH
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 223 PAR_ACTIVE_STEP
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 224 PAR_STEP_VOLUME
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 225 PAR_STEP_PROB
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 226 PAR_STEP_NOTE
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 227 PAR_EUKLID_LENGTH
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 228 PAR_EUKLID_STEPS
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 229 PAR_AUTOM_TRACK
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 230 PAR_P1_DEST
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 231 PAR_P2_DEST
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 232 PAR_P1_VAL
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 233 PAR_P2_VAL
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 234 PAR_SHUFFLE
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 235 PAR_PATTERN_BEAT
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 236 PAR_PATTERN_NEXT
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 237 PAR_BPM
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 238 PAR_MIDI_CHAN_1
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 239 PAR_MIDI_CHAN_2
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 240 PAR_MIDI_CHAN_3
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 241 PAR_MIDI_CHAN_4
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 242 PAR_MIDI_CHAN_5
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 243 PAR_MIDI_CHAN_6
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 244 PAR_FETCH
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 245 PAR_FOLLOW
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 246 PAR_QUANTISATION
+	{NO_VOICE,	0,	TYPE_SLIDER},	// 247 PAR_TRACK_LENGTH
+};
+
+/** returns the location of a parameter number (as stored in controllerAssignments)*/
+static const ParameterLocation& getParameterLocation(int parameterNr)
+{
+	jassert(parameterNr >= 0 && parameterNr < NUM_PARAMS);
+	return parameterLocations[parameterNr];
+}
+
+/** returns false if parameterLocations doesn't match controllerAssignments*/
+static bool checkParameterLocations()
+{
+	int numMapped = 0;
+	for(int voice=0;voice<NUM_VOICES;voice++)
+	{
+		for(int control=0;control<MAX_CONTROLS;control++)
+		{
+			const int parameterNr = controllerAssignments[voice][control];
+			if(parameterNr == NONE) continue;
+
+			const ParameterLocation& loc = parameterLocations[parameterNr];
+			if(loc.voiceNr != voice || loc.controlNr != control+1 || loc.controlType != getControlType(control+1,voice))
+			{
+				return false;
+			}
+			numMapped++;
+		}
+	}
+	//the remaining entries have to be empty
+	for(int i=0;i<NUM_PARAMS;i++)
+	{
+		if(parameterLocations[i].voiceNr != NO_VOICE) numMapped--;
+	}
+	return numMapped == 0;
+}
+//---------------------------------------------------------------------------
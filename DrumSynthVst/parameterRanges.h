@@ -0,0 +1,387 @@
+/*
+	=========================================================
+				Copyright 2013 Julian Schmidt
+
+	This file is part of the Sonic Potions Drumsynth Editor
+	=========================================================
+
+    The Sonic Potions Drumsynth Editor is free software: you
+	can redistribute it and/or modify it under the terms of
+	the GNU General Public License as published by the Free
+	Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Sonic Potions Drumsynth Editor is distributed in the
+	hope that it will be useful, but WITHOUT ANY WARRANTY;
+	without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+	Public License for more details.
+
+    You should have received a copy of the GNU General
+	Public License along with the Sonic Potions Drumsynth
+	Editor. If not, see <http://www.gnu.org/licenses/>.
+	=========================================================
+ */
+#pragma once
+
+#include "./JuceLibraryCode/JuceHeader.h"
+#include "./drumSynthSource/Parameters.h"
+#include "./drumSynthSource/menu.h"
+#include "./drumSynthSource/menuText.h"
+#include "./drumSynthSource/menuPages.h"
+#include "./parameterDtypes.h"
+
+//---------------------------------------------------------------------------
+/** Value range of a parameter in the units the UI shows (PM63 is -63..63)*/
+struct ParameterRange
+{
+	short min;
+	short max;
+	short range;	// max-min
+};
+
+// generated from parameterDtypes with computeParameterMin/Max().
+// regenerate when a dtype or a menu changes, checkParameterRanges() catches a stale table in debug builds
+static const ParameterRange parameterRanges[NUM_PARAMS] = {
+	{0,	127,	127},	//   0 PAR_NONE
+	{0,	5,	5},	//   1 PAR_OSC_WAVE_DRUM1
+	{0,	5,	5},	//   2 PAR_OSC_WAVE_DRUM2
+	{0,	5,	5},	//   3 PAR_OSC_WAVE_DRUM3
+	{0,	5,	5},	//   4 PAR_OSC_WAVE_SNARE
+	{0,	127,	127},	//   5 NRPN_DATA_ENTRY_COARSE
+	{0,	5,	5},	//   6 PAR_WAVE1_CYM
+	{0,	5,	5},	//   7 PAR_WAVE1_HH
+	{0,	127,	127},	//   8 PAR_COARSE1
+	{-63,	63,	126},	//   9 PAR_FINE1
+	{0,	127,	127},	//  10 PAR_COARSE2
+	{-63,	63,	126},	//  11 PAR_FINE2
+	{0,	127,	127},	//  12 PAR_COARSE3
+	{-63,	63,	126},	//  13 PAR_FINE3
+	{0,	127,	127},	//  14 PAR_COARSE4
+	{-63,	63,	126},	//  15 PAR_FINE4
+	{0,	127,	127},	//  16 PAR_COARSE5
+	{-63,	63,	126},	//  17 PAR_FINE5
+	{0,	127,	127},	//  18 PAR_COARSE6
+	{-63,	63,	126},	//  19 PAR_FINE6
+	{0,	5,	5},	//  20 PAR_MOD_WAVE_DRUM1
+	{0,	5,	5},	//  21 PAR_MOD_WAVE_DRUM2
+	{0,	5,	5},	//  22 PAR_MOD_WAVE_DRUM3
+	{0,	5,	5},	//  23 PAR_WAVE2_CYM
+	{0,	5,	5},	//  24 PAR_WAVE3_CYM
+	{0,	5,	5},	//  25 PAR_WAVE2_HH
+	{0,	5,	5},	//  26 PAR_WAVE3_HH
+	{0,	127,	127},	//  27 PAR_NOISE_FREQ1
+	{0,	127,	127},	//  28 PAR_MIX1
+	{0,	127,	127},	//  29 PAR_MOD_OSC_F1_CYM
+	{0,	127,	127},	//  30 PAR_MOD_OSC_F2_CYM
+	{0,	127,	127},	//  31 PAR_MOD_OSC_GAIN1_CYM
+	{0,	127,	127},	//  32 PAR_MOD_OSC_GAIN2_CYM
+	{0,	127,	127},	//  33 PAR_MOD_OSC_F1
+	{0,	127,	127},	//  34 PAR_MOD_OSC_F2
+	{0,	127,	127},	//  35 PAR_MOD_OSC_GAIN1
+	{0,	127,	127},	//  36 PAR_MOD_OSC_GAIN2
+	{0,	127,	127},	//  37 PAR_FILTER_FREQ_1
+	{0,	127,	127},	//  38 PAR_FILTER_FREQ_2
+	{0,	127,	127},	//  39 PAR_FILTER_FREQ_3
+	{0,	127,	127},	//  40 PAR_FILTER_FREQ_4
+	{0,	127,	127},	//  41 PAR_FILTER_FREQ_5
+	{0,	127,	127},	//  42 PAR_FILTER_FREQ_6
+	{0,	127,	127},	//  43 PAR_RESO_1
+	{0,	127,	127},	//  44 PAR_RESO_2
+	{0,	127,	127},	//  45 PAR_RESO_3
+	{0,	127,	127},	//  46 PAR_RESO_4
+	{0,	127,	127},	//  47 PAR_RESO_5
+	{0,	127,	127},	//  48 PAR_RESO_6
+	{0,	127,	127},	//  49 PAR_VELOA1
+	{0,	127,	127},	//  50 PAR_VELOD1
+	{0,	127,	127},	//  51 PAR_VELOA2
+	{0,	127,	127},	//  52 PAR_VELOD2
+	{0,	127,	127},	//  53 PAR_VELOA3
+	{0,	127,	127},	//  54 PAR_VELOD3
+	{0,	127,	127},	//  55 PAR_VELOA4
+	{0,	127,	127},	//  56 PAR_VELOD4
+	{0,	127,	127},	//  57 PAR_VELOA5
+	{0,	127,	127},	//  58 PAR_VELOD5
+	{0,	127,	127},	//  59 PAR_VELOA6
+	{0,	127,	127},	//  60 PAR_VELOD6_CLOSED
+	{0,	127,	127},	//  61 PAR_VELOD6_OPEN
+	{0,	127,	127},	//  62 PAR_VOL_SLOPE1
+	{0,	127,	127},	//  63 PAR_VOL_SLOPE2
+	{0,	127,	127},	//  64 PAR_VOL_SLOPE3
+	{0,	127,	127},	//  65 PAR_VOL_SLOPE4
+	{0,	127,	127},	//  66 PAR_VOL_SLOPE5
+	{0,	127,	127},	//  67 PAR_VOL_SLOPE6
+	{0,	127,	127},	//  68 PAR_REPEAT4
+	{0,	127,	127},	//  69 PAR_REPEAT5
+	{0,	127,	127},	//  70 PAR_MOD_EG1
+	{0,	127,	127},	//  71 PAR_MOD_EG2
+	{0,	127,	127},	//  72 PAR_MOD_EG3
+	{0,	127,	127},	//  73 PAR_MOD_EG4
+	{0,	127,	127},	//  74 PAR_MODAMNT1
+	{0,	127,	127},	//  75 PAR_MODAMNT2
+	{0,	127,	127},	//  76 PAR_MODAMNT3
+	{0,	127,	127},	//  77 PAR_MODAMNT4
+	{0,	127,	127},	//  78 PAR_PITCH_SLOPE1
+	{0,	127,	127},	//  79 PAR_PITCH_SLOPE2
+	{0,	127,	127},	//  80 PAR_PITCH_SLOPE3
+	{0,	127,	127},	//  81 PAR_PITCH_SLOPE4
+	{0,	127,	127},	//  82 PAR_FMAMNT1
+	{0,	127,	127},	//  83 PAR_FM_FREQ1
+	{0,	127,	127},	//  84 PAR_FMAMNT2
+	{0,	127,	127},	//  85 PAR_FM_FREQ2
+	{0,	127,	127},	//  86 PAR_FMAMNT3
+	{0,	127,	127},	//  87 PAR_FM_FREQ3
+	{0,	127,	127},	//  88 PAR_VOL1
+	{0,	127,	127},	//  89 PAR_VOL2
+	{0,	127,	127},	//  90 PAR_VOL3
+	{0,	127,	127},	//  91 PAR_VOL4
+	{0,	127,	127},	//  92 PAR_VOL5
+	{0,	127,	127},	//  93 PAR_VOL6
+	{-63,	63,	126},	//  94 PAR_PAN1
+	{-63,	63,	126},	//  95 PAR_PAN2
+	{-63,	63,	126},	//  96 PAR_PAN3
+	{0,	127,	127},	//  97 NRPN_FINE
+	{0,	127,	127},	//  98 NRPN_COARSE
+	{-63,	63,	126},	//  99 PAR_PAN4
+	{-63,	63,	126},	// 100 PAR_PAN5
+	{-63,	63,	126},	// 101 PAR_PAN6
+	{0,	127,	127},	// 102 PAR_DRIVE1
+	{0,	127,	127},	// 103 PAR_DRIVE2
+	{0,	127,	127},	// 104 PAR_DRIVE3
+	{0,	127,	127},	// 105 PAR_SNARE_DISTORTION
+	{0,	127,	127},	// 106 PAR_CYMBAL_DISTORTION
+	{0,	127,	127},	// 107 PAR_HAT_DISTORTION
+	{0,	127,	127},	// 108 PAR_VOICE_DECIMATION1
+	{0,	127,	127},	// 109 PAR_VOICE_DECIMATION2
+	{0,	127,	127},	// 110 PAR_VOICE_DECIMATION3
+	{0,	127,	127},	// 111 PAR_VOICE_DECIMATION4
+	{0,	127,	127},	// 112 PAR_VOICE_DECIMATION5
+	{0,	127,	127},	// 113 PAR_VOICE_DECIMATION6
+	{0,	127,	127},	// 114 PAR_VOICE_DECIMATION_ALL
+	{0,	127,	127},	// 115 PAR_FREQ_LFO1
+	{0,	127,	127},	// 116 PAR_FREQ_LFO2
+	{0,	127,	127},	// 117 PAR_FREQ_LFO3
+	{0,	127,	127},	// 118 PAR_FREQ_LFO4
+	{0,	127,	127},	// 119 PAR_FREQ_LFO5
+	{0,	127,	127},	// 120 PAR_FREQ_LFO6
+	{0,	127,	127},	// 121 PAR_AMOUNT_LFO1
+	{0,	127,	127},	// 122 PAR_AMOUNT_LFO2
+	{0,	127,	127},	// 123 PAR_AMOUNT_LFO3
+	{0,	127,	127},	// 124 PAR_AMOUNT_LFO4
+	{0,	127,	127},	// 125 PAR_AMOUNT_LFO5
+	{0,	127,	127},	// 126 PAR_AMOUNT_LFO6
+	{0,	127,	127},	// 127 PAR_RESERVED4
+	{0,	127,	127},	// 128 PAR_FILTER_DRIVE_1
+	{0,	127,	127},	// 129 PAR_FILTER_DRIVE_2
+	{0,	127,	127},	// 130 PAR_FILTER_DRIVE_3
+	{0,	127,	127},	// 131 PAR_FILTER_DRIVE_4
+	{0,	127,	127},	// 132 PAR_FILTER_DRIVE_5
+	{0,	127,	127},	// 133 PAR_FILTER_DRIVE_6
+	{0,	1,	1},	// 134 PAR_MIX_MOD_1
+	{0,	1,	1},	// 135 PAR_MIX_MOD_2
+	{0,	1,	1},	// 136 PAR_MIX_MOD_3
+	{0,	1,	1},	// 137 PAR_VOLUME_MOD_ON_OFF1
+	{0,	1,	1},	// 138 PAR_VOLUME_MOD_ON_OFF2
+	{0,	1,	1},	// 139 PAR_VOLUME_MOD_ON_OFF3
+	{0,	1,	1},	// 140 PAR_VOLUME_MOD_ON_OFF4
+	{0,	1,	1},	// 141 PAR_VOLUME_MOD_ON_OFF5
+	{0,	1,	1},	// 142 PAR_VOLUME_MOD_ON_OFF6
+	{0,	127,	127},	// 143 PAR_VELO_MOD_AMT_1
+	{0,	127,	127},	// 144 PAR_VELO_MOD_AMT_2
+	{0,	127,	127},	// 145 PAR_VELO_MOD_AMT_3
+	{0,	127,	127},	// 146 PAR_VELO_MOD_AMT_4
+	{0,	127,	127},	// 147 PAR_VELO_MOD_AMT_5
+	{0,	127,	127},	// 148 PAR_VELO_MOD_AMT_6
+	{0,	63,	63},	// 149 PAR_VEL_DEST_1
+	{0,	63,	63},	// 150 PAR_VEL_DEST_2
+	{0,	63,	63},	// 151 PAR_VEL_DEST_3
+	{0,	63,	63},	// 152 PAR_VEL_DEST_4
+	{0,	63,	63},	// 153 PAR_VEL_DEST_5
+	{0,	63,	63},	// 154 PAR_VEL_DEST_6
+	{0,	7,	7},	// 155 PAR_WAVE_LFO1
+	{0,	7,	7},	// 156 PAR_WAVE_LFO2
+	{0,	7,	7},	// 157 PAR_WAVE_LFO3
+	{0,	7,	7},	// 158 PAR_WAVE_LFO4
+	{0,	7,	7},	// 159 PAR_WAVE_LFO5
+	{0,	7,	7},	// 160 PAR_WAVE_LFO6
+	{1,	6,	5},	// 161 PAR_VOICE_LFO1
+	{1,	6,	5},	// 162 PAR_VOICE_LFO2
+	{1,	6,	5},	// 163 PAR_VOICE_LFO3
+	{1,	6,	5},	// 164 PAR_VOICE_LFO4
+	{1,	6,	5},	// 165 PAR_VOICE_LFO5
+	{1,	6,	5},	// 166 PAR_VOICE_LFO6
+	{0,	63,	63},	// 167 PAR_TARGET_LFO1
+	{0,	63,	63},	// 168 PAR_TARGET_LFO2
+	{0,	63,	63},	// 169 PAR_TARGET_LFO3
+	{0,	63,	63},	// 170 PAR_TARGET_LFO4
+	{0,	63,	63},	// 171 PAR_TARGET_LFO5
+	{0,	63,	63},	// 172 PAR_TARGET_LFO6
+	{0,	6,	6},	// 173 PAR_RETRIGGER_LFO1
+	{0,	6,	6},	// 174 PAR_RETRIGGER_LFO2
+	{0,	6,	6},	// 175 PAR_RETRIGGER_LFO3
+	{0,	6,	6},	// 176 PAR_RETRIGGER_LFO4
+	{0,	6,	6},	// 177 PAR_RETRIGGER_LFO5
+	{0,	6,	6},	// 178 PAR_RETRIGGER_LFO6
+	{0,	11,	11},	// 179 PAR_SYNC_LFO1
+	{0,	11,	11},	// 180 PAR_SYNC_LFO2
+	{0,	11,	11},	// 181 PAR_SYNC_LFO3
+	{0,	11,	11},	// 182 PAR_SYNC_LFO4
+	{0,	11,	11},	// 183 PAR_SYNC_LFO5
+	{0,	11,	11},	// 184 PAR_SYNC_LFO6
+	{0,	127,	127},	// 185 PAR_OFFSET_LFO1
+	{0,	127,	127},	// 186 PAR_OFFSET_LFO2
+	{0,	127,	127},	// 187 PAR_OFFSET_LFO3
+	{0,	127,	127},	// 188 PAR_OFFSET_LFO4
+	{0,	127,	127},	// 189 PAR_OFFSET_LFO5
+	{0,	127,	127},	// 190 PAR_OFFSET_LFO6
+	{0,	5,	5},	// 191 PAR_FILTER_TYPE_1
+	{0,	5,	5},	// 192 PAR_FILTER_TYPE_2
+	{0,	5,	5},	// 193 PAR_FILTER_TYPE_3
+	{0,	5,	5},	// 194 PAR_FILTER_TYPE_4
+	{0,	5,	5},	// 195 PAR_FILTER_TYPE_5
+	{0,	5,	5},	// 196 PAR_FILTER_TYPE_6
+	{0,	127,	127},	// 197 PAR_TRANS1_VOL
+	{0,	127,	127},	// 198 PAR_TRANS2_VOL
+	{0,	127,	127},	// 199 PAR_TRANS3_VOL
+	{0,	127,	127},	// 200 PAR_TRANS4_VOL
+	{0,	127,	127},	// 201 PAR_TRANS5_VOL
+	{0,	127,	127},	// 202 PAR_TRANS6_VOL
+	{0,	127,	127},	// 203 PAR_TRANS1_WAVE
+	{0,	127,	127},	// 204 PAR_TRANS2_WAVE
+	{0,	127,	127},	// 205 PAR_TRANS3_WAVE
+	{0,	127,	127},	// 206 PAR_TRANS4_WAVE
+	{0,	127,	127},	// 207 PAR_TRANS5_WAVE
+	{0,	127,	127},	// 208 PAR_TRANS6_WAVE
+	{0,	127,	127},	// 209 PAR_TRANS1_FREQ
+	{0,	127,	127},	// 210 PAR_TRANS2_FREQ
+	{0,	127,	127},	// 211 PAR_TRANS3_FREQ
+	{0,	127,	127},	// 212 PAR_TRANS4_FREQ
+	{0,	127,	127},	// 213 PAR_TRANS5_FREQ
+	{0,	127,	127},	// 214 PAR_TRANS6_FREQ
+	{0,	5,	5},	// 215 PAR_AUDIO_OUT1
+	{0,	5,	5},	// 216 PAR_AUDIO_OUT2
+	{0,	5,	5},	// 217 PAR_AUDIO_OUT3
+	{0,	5,	5},	// 218 PAR_AUDIO_OUT4
+	{0,	5,	5},	// 219 PAR_AUDIO_OUT5
+	{0,	5,	5},	// 220 PAR_AUDIO_OUT6
+	{0,	13,	13},	// 221 PAR_ROLL
+	{0,	255,	255},	// 222 PAR_MORPH
+	{0,	127,	127},	// 223 PAR_ACTIVE_STEP
+	{0,	127,	127},	// 224 PAR_STEP_VOLUME
+	{0,	127,	127},	// 225 PAR_STEP_PROB
+	{-63,	63,	126},	// 226 PAR_STEP_NOTE
+	{1,	16,	15},	// 227 PAR_EUKLID_LENGTH
+	{1,	16,	15},	// 228 PAR_EUKLID_STEPS
+	{0,	1,	1},	// 229 PAR_AUTOM_TRACK
+	{0,	220,	220},	// 230 PAR_P1_DEST
+	{0,	220,	220},	// 231 PAR_P2_DEST
+	{0,	127,	127},	// 232 PAR_P1_VAL
+	{0,	127,	127},	// 233 PAR_P2_VAL
+	{0,	127,	127},	// 234 PAR_SHUFFLE
+	{0,	127,	127},	// 235 PAR_PATTERN_BEAT
+	{0,	14,	14},	// 236 PAR_PATTERN_NEXT
+	{0,	255,	255},	// 237 PAR_BPM
+	{1,	16,	15},	// 238 PAR_MIDI_CHAN_1
+	{1,	16,	15},	// 239 PAR_MIDI_CHAN_2
+	{1,	16,	15},	// 240 PAR_MIDI_CHAN_3
+	{1,	16,	15},	// 241 PAR_MIDI_CHAN_4
+	{1,	16,	15},	// 242 PAR_MIDI_CHAN_5
+	{1,	16,	15},	// 243 PAR_MIDI_CHAN_6
+	{0,	1,	1},	// 244 PAR_FETCH
+	{0,	1,	1},	// 245 PAR_FOLLOW
+	{0,	4,	4},	// 246 PAR_QUANTISATION
+	{1,	16,	15},	// 247 PAR_TRACK_LENGTH
+};
+
+static const ParameterRange& getParameterRange(int parameterNr)
+{
+	jassert(parameterNr >= 0 && parameterNr < NUM_PARAMS);
+	return parameterRanges[parameterNr];
+}
+
+/** the smallest value of a data type, the switch the table is generated from*/
+static int computeParameterMin(int dtype)
+{
+	switch(dtype&0x0F)
+	{
+		case DTYPE_PM63:
+			return -63;
+
+		case DTYPE_1B6:
+		case DTYPE_1B16:
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/** the largest value of a data type, the switch the table is generated from*/
+static int computeParameterMax(int dtype)
+{
+	switch(dtype&0x0F)
+	{
+		case DTYPE_TARGET_SELECTION_VELO:
+		case DTYPE_TARGET_SELECTION_LFO:
+			return (NUM_SUB_PAGES * 8 -1);
+
+		default:
+		case DTYPE_0B127:
+			return 127;
+
+		case DTYPE_PM63:
+			return 63;
+
+		case DTYPE_AUTOM_TARGET:
+			return END_OF_SOUND_PARAMETERS-1;
+
+		case DTYPE_0B255:
+			return 255;
+
+		case DTYPE_1B6:
+			return 6;
+
+		case DTYPE_1B16:
+			return 16;
+
+		case DTYPE_MIX_FM:
+		case DTYPE_ON_OFF:
+		case DTYPE_0b1:
+			return 1;
+
+		case DTYPE_MENU:
+		{
+			//the used menu is in the upper 4 bit, the first byte of a menu text array is its number of entries
+			uint8_t numEntries;
+			switch(dtype>>4)
+			{
+				case MENU_AUDIO_OUT:	numEntries = outputNames[0][0];			break;
+				case MENU_FILTER:		numEntries = filterTypes[0][0];			break;
+				case MENU_SYNC_RATES:	numEntries = syncRateNames[0][0];		break;
+				case MENU_LFO_WAVES:	numEntries = lfoWaveNames[0][0];		break;
+				case MENU_RETRIGGER:	numEntries = retriggerNames[0][0];		break;
+				case MENU_SEQ_QUANT:	numEntries = quantisationNames[0][0];	break;
+				case MENU_NEXT_PATTERN:	numEntries = nextPatternNames[0][0];	break;
+				case MENU_WAVEFORM:		numEntries = waveformNames[0][0];		break;
+				case MENU_ROLL_RATES:	numEntries = rollRateNames[0][0];		break;
+				default:				numEntries = 0;							break;
+			}
+			return numEntries-1;
+		}
+	}
+}
+
+/** returns false if parameterRanges doesn't match the dtypes*/
+static bool checkParameterRanges()
+{
+	for(int i=0;i<NUM_PARAMS;i++)
+	{
+		const ParameterRange& r = parameterRanges[i];
+		if(r.min != computeParameterMin(parameterDtypes[i]) || r.max != computeParameterMax(parameterDtypes[i]) || r.range != r.max-r.min)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
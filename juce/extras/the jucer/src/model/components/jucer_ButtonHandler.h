@@ -148,7 +148,9 @@ public:
     {
         ComponentTypeHandler::fillInGeneratedCode (component, code);
 
-        if (needsButtonListener (component))
+        const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
+
+        if (needsButtonListener (component) && ! code.isTableWidget (memberVariableName))
         {
             String& callback = code.getCallbackCode ("public ButtonListener",
                                                      "void",
@@ -158,15 +160,35 @@ public:
             if (callback.isNotEmpty())
                 callback << "else ";
 
-            const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
-            const String userCodeComment ("UserButtonCode_" + memberVariableName);
-
             callback
                 << "if (buttonThatWasClicked == " << memberVariableName
-                << ")\n{\n    //[" << userCodeComment << "] -- add your button handler code here..\n    //[/" << userCodeComment << "]\n}\n";
+                << ")\n{\n    " << indentCode (getHandlerCode (memberVariableName), 4) << "\n}\n";
         }
     }
 
+    bool getWidgetTable (Component* component, const String& memberVariableName,
+                         GeneratedCode::WidgetTable& table, String& handlerCode)
+    {
+        if (! needsButtonListener (component))
+            return false;
+
+        table.arrayName = "buttons";
+        table.widgetClass = "Button";
+        table.listenerClass = "public ButtonListener";
+        table.callbackPrototype = "buttonClicked (Button* buttonThatWasClicked)";
+        table.parameterName = "buttonThatWasClicked";
+        table.handlerSuffix = "Clicked";
+        handlerCode = getHandlerCode (memberVariableName);
+        return true;
+    }
+
+    static const String getHandlerCode (const String& memberVariableName)
+    {
+        const String userCodeComment ("UserButtonCode_" + memberVariableName);
+
+        return "//[" + userCodeComment + "] -- add your button handler code here..\n//[/" + userCodeComment + "]";
+    }
+
     static bool needsButtonListener (Component* button)
     {
         return button->getProperties().getWithDefault ("generateListenerCallback", true);
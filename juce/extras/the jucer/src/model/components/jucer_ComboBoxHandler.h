@@ -138,7 +138,9 @@ public:
     {
         ComponentTypeHandler::fillInGeneratedCode (component, code);
 
-        if (needsCallback (component))
+        const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
+
+        if (needsCallback (component) && ! code.isTableWidget (memberVariableName))
         {
             String& callback = code.getCallbackCode ("public ComboBoxListener",
                                                      "void",
@@ -148,15 +150,35 @@ public:
             if (callback.trim().isNotEmpty())
                 callback << "else ";
 
-            const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
-            const String userCodeComment ("UserComboBoxCode_" + memberVariableName);
-
             callback
                 << "if (comboBoxThatHasChanged == " << memberVariableName
-                << ")\n{\n    //[" << userCodeComment << "] -- add your combo box handling code here..\n    //[/" << userCodeComment << "]\n}\n";
+                << ")\n{\n    " << indentCode (getHandlerCode (memberVariableName), 4) << "\n}\n";
         }
     }
 
+    bool getWidgetTable (Component* component, const String& memberVariableName,
+                         GeneratedCode::WidgetTable& table, String& handlerCode)
+    {
+        if (! needsCallback (component))
+            return false;
+
+        table.arrayName = "comboBoxes";
+        table.widgetClass = "ComboBox";
+        table.listenerClass = "public ComboBoxListener";
+        table.callbackPrototype = "comboBoxChanged (ComboBox* comboBoxThatHasChanged)";
+        table.parameterName = "comboBoxThatHasChanged";
+        table.handlerSuffix = "Changed";
+        handlerCode = getHandlerCode (memberVariableName);
+        return true;
+    }
+
+    static const String getHandlerCode (const String& memberVariableName)
+    {
+        const String userCodeComment ("UserComboBoxCode_" + memberVariableName);
+
+        return "//[" + userCodeComment + "] -- add your combo box handling code here..\n//[/" + userCodeComment + "]";
+    }
+
     static void updateItems (ComboBox* c)
     {
         StringArray lines;
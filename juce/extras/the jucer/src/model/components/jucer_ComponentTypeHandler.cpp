@@ -497,14 +497,39 @@ const String ComponentTypeHandler::getColourIntialisationCode (Component* compon
 //==============================================================================
 void ComponentTypeHandler::fillInGeneratedCode (Component* component, GeneratedCode& code)
 {
-    const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
+    String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
+
+    GeneratedCode::WidgetTable table;
+    String handlerCode;
+
+    if (code.document->isUsingWidgetTables()
+         && getWidgetTable (component, memberVariableName, table, handlerCode))
+    {
+        const String indexName (memberVariableName);
+        memberVariableName = code.addTableWidget (table, indexName, handlerCode);
+
+        fillInCreationCode (code, component, memberVariableName);
+
+        code.constructorCode = code.constructorCode.trimEnd() + "\n";
+        code.constructorCode
+            << memberVariableName << "->getProperties().set (widgetIndexProperty, (int) "
+            << indexName << ");\n\n";
+    }
+    else
+    {
+        fillInMemberVariableDeclarations (code, component, memberVariableName);
+        fillInCreationCode (code, component, memberVariableName);
+    }
 
-    fillInMemberVariableDeclarations (code, component, memberVariableName);
-    fillInCreationCode (code, component, memberVariableName);
     fillInDeletionCode (code, component, memberVariableName);
     fillInResizeCode (code, component, memberVariableName);
 }
 
+bool ComponentTypeHandler::getWidgetTable (Component*, const String&, GeneratedCode::WidgetTable&, String&)
+{
+    return false;
+}
+
 void ComponentTypeHandler::fillInMemberVariableDeclarations (GeneratedCode& code, Component* component, const String& memberVariableName)
 {
     const String virtualName (component->getProperties() ["virtualName"].toString());
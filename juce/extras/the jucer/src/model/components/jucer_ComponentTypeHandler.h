@@ -105,6 +105,13 @@ public:
     virtual const String getCreationParameters (Component* component);
     virtual void fillInDeletionCode (GeneratedCode& code, Component* component, const String& memberVariableName);
 
+    /** If the document uses widget tables, a handler can put its kind of widget in one by
+        filling in the table description and the code for the widget's handler method.
+        Returns false if the widget should keep a member variable of its own.
+    */
+    virtual bool getWidgetTable (Component* component, const String& memberVariableName,
+                                 GeneratedCode::WidgetTable& table, String& handlerCode);
+
     //==============================================================================
     const String& getTypeName() const throw()                       { return typeName; }
     virtual const String getClassName (Component*) const            { return className; }
@@ -133,7 +133,9 @@ public:
     {
         ComponentTypeHandler::fillInGeneratedCode (component, code);
 
-        if (needsCallback (component))
+        const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
+
+        if (needsCallback (component) && ! code.isTableWidget (memberVariableName))
         {
             String& callback = code.getCallbackCode ("public SliderListener",
                                                      "void",
@@ -143,15 +145,35 @@ public:
             if (callback.isNotEmpty())
                 callback << "else ";
 
-            const String memberVariableName (code.document->getComponentLayout()->getComponentMemberVariableName (component));
-            const String userCodeComment ("UserSliderCode_" + memberVariableName);
-
             callback
                 << "if (sliderThatWasMoved == " << memberVariableName
-                << ")\n{\n    //[" << userCodeComment << "] -- add your slider handling code here..\n    //[/" << userCodeComment << "]\n}\n";
+                << ")\n{\n    " << indentCode (getHandlerCode (memberVariableName), 4) << "\n}\n";
         }
     }
 
+    bool getWidgetTable (Component* component, const String& memberVariableName,
+                         GeneratedCode::WidgetTable& table, String& handlerCode)
+    {
+        if (! needsCallback (component))
+            return false;
+
+        table.arrayName = "sliders";
+        table.widgetClass = "Slider";
+        table.listenerClass = "public SliderListener";
+        table.callbackPrototype = "sliderValueChanged (Slider* sliderThatWasMoved)";
+        table.parameterName = "sliderThatWasMoved";
+        table.handlerSuffix = "ValueChanged";
+        handlerCode = getHandlerCode (memberVariableName);
+        return true;
+    }
+
+    static const String getHandlerCode (const String& memberVariableName)
+    {
+        const String userCodeComment ("UserSliderCode_" + memberVariableName);
+
+        return "//[" + userCodeComment + "] -- add your slider handling code here..\n//[/" + userCodeComment + "]";
+    }
+
     //==============================================================================
     void getEditableProperties (Component* component, JucerDocument& document, Array <PropertyComponent*>& properties)
     {
@@ -109,6 +109,95 @@ void GeneratedCode::addImageResourceLoader (const String& imageMemberName, const
     }
 }
 
+//==============================================================================
+const String GeneratedCode::addTableWidget (const WidgetTable& table,
+                                            const String& memberVariableName,
+                                            const String& handlerCode)
+{
+    WidgetTable* t = 0;
+
+    for (int i = 0; i < widgetTables.size(); ++i)
+        if (widgetTables.getUnchecked(i)->arrayName == table.arrayName)
+            t = widgetTables.getUnchecked(i);
+
+    if (t == 0)
+    {
+        t = new WidgetTable (table);
+        t->widgetNames.clear();
+        widgetTables.add (t);
+    }
+
+    t->widgetNames.add (memberVariableName);
+
+    getCallbackCode (String::empty, "void", memberVariableName + t->handlerSuffix + "()", false)
+        << handlerCode;
+
+    return t->arrayName + "[" + memberVariableName + "]";
+}
+
+bool GeneratedCode::isTableWidget (const String& memberVariableName) const
+{
+    for (int i = 0; i < widgetTables.size(); ++i)
+        if (widgetTables.getUnchecked(i)->widgetNames.contains (memberVariableName))
+            return true;
+
+    return false;
+}
+
+void GeneratedCode::fillInWidgetTables()
+{
+    if (widgetTables.size() == 0)
+        return;
+
+    privateMemberDeclarations
+        << "static const Identifier widgetIndexProperty;\n";
+
+    staticMemberDefinitions
+        << "const Identifier " << className << "::widgetIndexProperty (\"widgetIndex\");\n";
+
+    for (int i = 0; i < widgetTables.size(); ++i)
+    {
+        const WidgetTable* const t = widgetTables.getUnchecked(i);
+
+        const String kind (t->widgetClass.substring (0, 1).toLowerCase() + t->widgetClass.substring (1));
+        const String countName ("num" + t->arrayName.substring (0, 1).toUpperCase() + t->arrayName.substring (1));
+        const String handlerType (t->widgetClass + "Handler");
+        const String handlersName (kind + "Handlers");
+
+        String r;
+        r << "\nenum " << t->widgetClass << "Index\n{\n";
+
+        for (int j = 0; j < t->widgetNames.size(); ++j)
+            r << "    " << t->widgetNames[j] << (j == 0 ? " = 0" : "") << ",\n";
+
+        r << "    " << countName << "\n};\n\n"
+          << t->widgetClass << "* " << t->arrayName << " [" << countName << "];\n"
+          << "typedef void (" << className << "::*" << handlerType << ") ();\n"
+          << "static const " << handlerType << " " << handlersName << " [" << countName << "];\n";
+
+        privateMemberDeclarations << r;
+
+        String s;
+        s << "\nconst " << className << "::" << handlerType << " "
+          << className << "::" << handlersName << " [" << className << "::" << countName << "] =\n{\n";
+
+        for (int j = 0; j < t->widgetNames.size(); ++j)
+            s << "    &" << className << "::" << t->widgetNames[j] << t->handlerSuffix
+              << (j < t->widgetNames.size() - 1 ? ",\n" : "\n");
+
+        s << "};\n";
+
+        staticMemberDefinitions << s;
+
+        // the widgets were given their index when they were created
+        getCallbackCode (t->listenerClass, "void", t->callbackPrototype, true)
+            << "const int index = " << t->parameterName << "->getProperties() [widgetIndexProperty];\n"
+            << "jassert (index >= 0 && index < " << countName << " && " << t->arrayName << " [index] == "
+            << t->parameterName << ");\n"
+            << "(this->*" << handlersName << " [index]) ();\n";
+    }
+}
+
 const StringArray GeneratedCode::getExtraParentClasses() const
 {
     StringArray s;
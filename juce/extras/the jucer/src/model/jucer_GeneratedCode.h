@@ -86,6 +86,41 @@ public:
 
     void addImageResourceLoader (const String& imageMemberName, const String& resourceName);
 
+    //==============================================================================
+    /** Describes how one kind of widget is dispatched when the document uses widget
+        tables (see JucerDocument::isUsingWidgetTables()).
+
+        Instead of a member pointer each, the widgets go into one array per kind, and
+        the listener callback looks up the widget's index and calls its handler method
+        through a table of member function pointers, rather than comparing it against
+        every widget in turn.
+    */
+    struct WidgetTable
+    {
+        String arrayName;           // e.g. "sliders"
+        String widgetClass;         // e.g. "Slider", the type of the array elements
+        String listenerClass;       // e.g. "public SliderListener"
+        String callbackPrototype;   // e.g. "sliderValueChanged (Slider* sliderThatWasMoved)"
+        String parameterName;       // e.g. "sliderThatWasMoved"
+        String handlerSuffix;       // e.g. "ValueChanged", appended to the widget name for its handler
+        StringArray widgetNames;
+    };
+
+    /** Adds a widget to the table for its kind, and creates its handler method containing
+        the given code. Returns the expression that the rest of the generated code should
+        use to refer to the widget.
+    */
+    const String addTableWidget (const WidgetTable& table,
+                                 const String& memberVariableName,
+                                 const String& handlerCode);
+
+    bool isTableWidget (const String& memberVariableName) const;
+
+    /** Creates the arrays, dispatch tables and callbacks for all the widgets that were added. */
+    void fillInWidgetTables();
+
+    OwnedArray <WidgetTable> widgetTables;
+
     const String getCallbackDeclarations() const;
     const String getCallbackDefinitions() const;
     const StringArray getExtraParentClasses() const;
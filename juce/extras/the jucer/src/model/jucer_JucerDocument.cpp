@@ -43,6 +43,7 @@ JucerDocument::JucerDocument()
       fixedSize (false),
       initialWidth (600),
       initialHeight (400),
+      useWidgetTables (false),
       snapGridPixels (8),
       snapActive (true),
       snapShown (true),
@@ -197,6 +198,15 @@ void JucerDocument::setFixedSize (const bool isFixed)
     }
 }
 
+void JucerDocument::setUsingWidgetTables (const bool shouldUseTables)
+{
+    if (useWidgetTables != shouldUseTables)
+    {
+        useWidgetTables = shouldUseTables;
+        changed();
+    }
+}
+
 void JucerDocument::setInitialSize (int w, int h)
 {
     w = jmax (1, w);
@@ -345,6 +355,9 @@ XmlElement* JucerDocument::createXml() const
     doc->setAttribute ("initialWidth", initialWidth);
     doc->setAttribute ("initialHeight", initialHeight);
 
+    if (useWidgetTables)
+        doc->setAttribute ("widgetTables", useWidgetTables);
+
     if (activeExtraMethods.size() > 0)
     {
         XmlElement* extraMethods = new XmlElement ("METHODS");
@@ -375,6 +388,7 @@ bool JucerDocument::loadFromXml (const XmlElement& xml)
         fixedSize = xml.getBoolAttribute ("fixedSize", false);
         initialWidth = xml.getIntAttribute ("initialWidth", 300);
         initialHeight = xml.getIntAttribute ("initialHeight", 200);
+        useWidgetTables = xml.getBoolAttribute ("widgetTables", false);
 
         snapGridPixels = xml.getIntAttribute ("snapPixels", snapGridPixels);
         snapActive = xml.getBoolAttribute ("snapActive", snapActive);
@@ -509,6 +523,8 @@ void JucerDocument::fillInGeneratedCode (GeneratedCode& code) const
     if (getComponentLayout() != 0)
         getComponentLayout()->fillInGeneratedCode (code);
 
+    code.fillInWidgetTables();
+
     fillInPaintCode (code);
 
     XmlElement* const e = createXml();
@@ -84,6 +84,13 @@ public:
 
     void setInitialSize (int w, int h);
 
+    /** When enabled, sliders, combo boxes and buttons are generated as arrays with a table of
+        handler methods, instead of a member variable each and an if-else chain in the callback.
+        @see GeneratedCode::WidgetTable
+    */
+    void setUsingWidgetTables (const bool shouldUseTables);
+    bool isUsingWidgetTables() const throw()                                { return useWidgetTables; }
+
     int getInitialWidth() const throw()                                     { return initialWidth; }
     int getInitialHeight() const throw()                                    { return initialHeight; }
 
@@ -171,6 +178,7 @@ protected:
     String parentClasses, constructorParams, variableInitialisers;
     bool fixedSize;
     int initialWidth, initialHeight;
+    bool useWidgetTables;
 
     BinaryResources resources;
 
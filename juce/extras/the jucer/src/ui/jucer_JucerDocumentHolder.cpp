@@ -148,6 +148,7 @@ public:
         props.add (new ComponentInitialSizeProperty (document_, true));
         props.add (new ComponentInitialSizeProperty (document_, false));
         props.add (new FixedSizeProperty (document_));
+        props.add (new WidgetTablesProperty (document_));
 
         panel1->addSection ("General class settings", props);
 
@@ -290,6 +291,21 @@ private:
         void setIndex (int newIndex)        { document.setFixedSize (newIndex != 0); }
         int getIndex() const                { return document.isFixedSize() ? 1 : 0; }
     };
+
+    //==============================================================================
+    class WidgetTablesProperty    : public ComponentChoiceProperty <Component>
+    {
+    public:
+        WidgetTablesProperty (JucerDocument& document_)
+            : ComponentChoiceProperty <Component> ("event dispatch", 0, document_)
+        {
+            choices.add ("A member and an if-else test per widget");
+            choices.add ("Widget arrays and handler tables");
+        }
+
+        void setIndex (int newIndex)        { document.setUsingWidgetTables (newIndex != 0); }
+        int getIndex() const                { return document.isUsingWidgetTables() ? 1 : 0; }
+    };
 };
 
 //==============================================================================
@@ -845,6 +845,8 @@ protected:
 #include <sys/sysinfo.h>
 #include <sys/file.h>
 #include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <signal.h>
 
 /* Got a build error here? You'll need to install the freetype library...
@@ -919,6 +921,7 @@ protected:
 	Juce with low latency audio support, just disable the JUCE_JACK flag in juce_Config.h
  */
  #include <jack/jack.h>
+ #include <jack/midiport.h>
  //#include <jack/transport.h>
 #endif
 
@@ -27016,7 +27019,8 @@ static void addIfNotNull (OwnedArray <AudioIODeviceType>& list, AudioIODeviceTyp
 
 void AudioDeviceManager::createAudioDeviceTypes (OwnedArray <AudioIODeviceType>& list)
 {
-	addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_WASAPI());
+	addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_WASAPI (false));
+	addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_WASAPI (true));
 	addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_DirectSound());
 	addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_ASIO());
 	addIfNotNull (list, AudioIODeviceType::createAudioIODeviceType_CoreAudio());
@@ -27902,7 +27906,7 @@ AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_iOSAudio()	{ retur
 #endif
 
 #if ! (JUCE_WINDOWS && JUCE_WASAPI)
-AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_WASAPI()	  { return nullptr; }
+AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_WASAPI (bool)	 { return nullptr; }
 #endif
 
 #if ! (JUCE_WINDOWS && JUCE_DIRECTSOUND)
@@ -27931,18 +27935,145 @@ END_JUCE_NAMESPACE
 
 
 /*** Start of inlined file: juce_AudioDataConverters.cpp ***/
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE2__)) && ! defined (JUCE_DISABLE_SSE2_CONVERTERS)
+ #define JUCE_USE_SSE2_CONVERTERS 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
+#if JUCE_USE_SSE2_CONVERTERS
+namespace AudioDataConverterHelpers
+{
+	// four samples scaled, dithered, clipped and rounded in double precision, so the
+	// results are exactly those of roundToInt (jlimit (-maxVal, maxVal, maxVal * x + noise))
+	forcedinline __m128i scaleFour (const float* source, const __m128d maxVal, const __m128d minVal,
+									AudioDataConverters::Dither& dither) noexcept
+	{
+		const __m128 s = _mm_loadu_ps (source);
+		__m128d lo = _mm_mul_pd (maxVal, _mm_cvtps_pd (s));
+		__m128d hi = _mm_mul_pd (maxVal, _mm_cvtps_pd (_mm_movehl_ps (s, s)));
+
+		if (dither.isActive())
+		{
+			const double n0 = dither.getNextNoise();
+			const double n1 = dither.getNextNoise();
+			const double n2 = dither.getNextNoise();
+			const double n3 = dither.getNextNoise();
+			lo = _mm_add_pd (lo, _mm_set_pd (n1, n0));
+			hi = _mm_add_pd (hi, _mm_set_pd (n3, n2));
+		}
+
+		lo = _mm_min_pd (_mm_max_pd (lo, minVal), maxVal);
+		hi = _mm_min_pd (_mm_max_pd (hi, minVal), maxVal);
+		return _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (lo), _mm_cvtpd_epi32 (hi));
+	}
+
+	forcedinline __m128i swapBytes16 (const __m128i v) noexcept
+	{
+		return _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+	}
+
+	// packed 16-bit samples, eight at a time. Returns the number of samples done
+	int convertFloatToPacked16 (const float* source, char* intData, const int numSamples,
+								const bool bigEndian, AudioDataConverters::Dither& dither) noexcept
+	{
+		const __m128d maxVal = _mm_set1_pd ((double) 0x7fff);
+		const __m128d minVal = _mm_set1_pd (-(double) 0x7fff);
+		int i = 0;
+
+		for (; i + 8 <= numSamples; i += 8)
+		{
+			const __m128i a = scaleFour (source + i, maxVal, minVal, dither);
+			const __m128i b = scaleFour (source + i + 4, maxVal, minVal, dither);
+			const __m128i v = _mm_packs_epi32 (a, b);
+			_mm_storeu_si128 ((__m128i*) (intData + i * 2), bigEndian ? swapBytes16 (v) : v);
+		}
+
+		return i;
+	}
+
+	struct Int16LEWriter  { static forcedinline void write (const int v, char* d) noexcept  { *(uint16*) d = ByteOrder::swapIfBigEndian ((uint16) (short) v); } };
+	struct Int16BEWriter  { static forcedinline void write (const int v, char* d) noexcept  { *(uint16*) d = ByteOrder::swapIfLittleEndian ((uint16) (short) v); } };
+	struct Int24LEWriter  { static forcedinline void write (const int v, char* d) noexcept  { ByteOrder::littleEndian24BitToChars ((uint32) v, d); } };
+	struct Int24BEWriter  { static forcedinline void write (const int v, char* d) noexcept  { ByteOrder::bigEndian24BitToChars ((uint32) v, d); } };
+
+	// any stride, the arithmetic four samples at a time and the stores one by one.
+	// Returns the number of samples done
+	template <class Writer>
+	int convertFloatToInt (const float* source, char* intData, const int numSamples, const int destBytesPerSample,
+						   const double maxValue, AudioDataConverters::Dither& dither) noexcept
+	{
+		const __m128d maxVal = _mm_set1_pd (maxValue);
+		const __m128d minVal = _mm_set1_pd (-maxValue);
+		int32 values[4];
+		int i = 0;
+
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			_mm_storeu_si128 ((__m128i*) values, scaleFour (source + i, maxVal, minVal, dither));
+
+			for (int j = 0; j < 4; ++j)
+			{
+				Writer::write (values[j], intData);
+				intData += destBytesPerSample;
+			}
+		}
+
+		return i;
+	}
+
+	// packed 16-bit samples, eight at a time, the same as scale * (short) value.
+	// Returns the number of samples done
+	int convertPacked16ToFloat (const char* intData, float* dest, const int numSamples,
+								const bool bigEndian, const float scale) noexcept
+	{
+		const __m128 s = _mm_set1_ps (scale);
+		int i = 0;
+
+		for (; i + 8 <= numSamples; i += 8)
+		{
+			__m128i v = _mm_loadu_si128 ((const __m128i*) (intData + i * 2));
+
+			if (bigEndian)
+				v = swapBytes16 (v);
+
+			_mm_storeu_ps (dest + i,     _mm_mul_ps (s, _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16))));
+			_mm_storeu_ps (dest + i + 4, _mm_mul_ps (s, _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16))));
+		}
+
+		return i;
+	}
+}
+#endif
+
 void AudioDataConverters::convertFloatToInt16LE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+	Dither noDither;
+	convertFloatToInt16LE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt16LE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
 	const double maxVal = (double) 0x7fff;
 	char* intData = static_cast <char*> (dest);
 
 	if (dest != (void*) source || destBytesPerSample <= 4)
 	{
-		for (int i = 0; i < numSamples; ++i)
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_CONVERTERS
+		if (SystemStats::canUseSSE2())
+		{
+			i = destBytesPerSample == 2 ? AudioDataConverterHelpers::convertFloatToPacked16 (source, intData, numSamples, false, dither)
+										: AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int16LEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+			intData += i * destBytesPerSample;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
 		{
-			*(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+			*(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
 			intData += destBytesPerSample;
 		}
 	}
@@ -27953,21 +28084,38 @@ void AudioDataConverters::convertFloatToInt16LE (const float* source, void* dest
 		for (int i = numSamples; --i >= 0;)
 		{
 			intData -= destBytesPerSample;
-			*(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+			*(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
 		}
 	}
 }
 
 void AudioDataConverters::convertFloatToInt16BE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+	Dither noDither;
+	convertFloatToInt16BE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt16BE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
 	const double maxVal = (double) 0x7fff;
 	char* intData = static_cast <char*> (dest);
 
 	if (dest != (void*) source || destBytesPerSample <= 4)
 	{
-		for (int i = 0; i < numSamples; ++i)
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_CONVERTERS
+		if (SystemStats::canUseSSE2())
 		{
-			*(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+			i = destBytesPerSample == 2 ? AudioDataConverterHelpers::convertFloatToPacked16 (source, intData, numSamples, true, dither)
+										: AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int16BEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+			intData += i * destBytesPerSample;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+		{
+			*(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
 			intData += destBytesPerSample;
 		}
 	}
@@ -27978,21 +28126,37 @@ void AudioDataConverters::convertFloatToInt16BE (const float* source, void* dest
 		for (int i = numSamples; --i >= 0;)
 		{
 			intData -= destBytesPerSample;
-			*(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+			*(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
 		}
 	}
 }
 
 void AudioDataConverters::convertFloatToInt24LE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+	Dither noDither;
+	convertFloatToInt24LE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt24LE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
 	const double maxVal = (double) 0x7fffff;
 	char* intData = static_cast <char*> (dest);
 
 	if (dest != (void*) source || destBytesPerSample <= 4)
 	{
-		for (int i = 0; i < numSamples; ++i)
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_CONVERTERS
+		if (SystemStats::canUseSSE2())
+		{
+			i = AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int24LEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+			intData += i * destBytesPerSample;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
 		{
-			ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+			ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
 			intData += destBytesPerSample;
 		}
 	}
@@ -28003,21 +28167,37 @@ void AudioDataConverters::convertFloatToInt24LE (const float* source, void* dest
 		for (int i = numSamples; --i >= 0;)
 		{
 			intData -= destBytesPerSample;
-			ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+			ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
 		}
 	}
 }
 
 void AudioDataConverters::convertFloatToInt24BE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+	Dither noDither;
+	convertFloatToInt24BE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt24BE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
 	const double maxVal = (double) 0x7fffff;
 	char* intData = static_cast <char*> (dest);
 
 	if (dest != (void*) source || destBytesPerSample <= 4)
 	{
-		for (int i = 0; i < numSamples; ++i)
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_CONVERTERS
+		if (SystemStats::canUseSSE2())
+		{
+			i = AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int24BEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+			intData += i * destBytesPerSample;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
 		{
-			ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+			ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
 			intData += destBytesPerSample;
 		}
 	}
@@ -28028,7 +28208,7 @@ void AudioDataConverters::convertFloatToInt24BE (const float* source, void* dest
 		for (int i = numSamples; --i >= 0;)
 		{
 			intData -= destBytesPerSample;
-			ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+			ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
 		}
 	}
 }
@@ -28126,7 +28306,17 @@ void AudioDataConverters::convertInt16LEToFloat (const void* const source, float
 
 	if (source != (void*) dest || srcBytesPerSample >= 4)
 	{
-		for (int i = 0; i < numSamples; ++i)
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_CONVERTERS
+		if (srcBytesPerSample == 2 && SystemStats::canUseSSE2())
+		{
+			i = AudioDataConverterHelpers::convertPacked16ToFloat (intData, dest, numSamples, false, scale);
+			intData += i * srcBytesPerSample;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
 		{
 			dest[i] = scale * (short) ByteOrder::swapIfBigEndian (*(uint16*)intData);
 			intData += srcBytesPerSample;
@@ -28151,7 +28341,17 @@ void AudioDataConverters::convertInt16BEToFloat (const void* const source, float
 
 	if (source != (void*) dest || srcBytesPerSample >= 4)
 	{
-		for (int i = 0; i < numSamples; ++i)
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_CONVERTERS
+		if (srcBytesPerSample == 2 && SystemStats::canUseSSE2())
+		{
+			i = AudioDataConverterHelpers::convertPacked16ToFloat (intData, dest, numSamples, true, scale);
+			intData += i * srcBytesPerSample;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
 		{
 			dest[i] = scale * (short) ByteOrder::swapIfLittleEndian (*(uint16*)intData);
 			intData += srcBytesPerSample;
@@ -28322,6 +28522,22 @@ void AudioDataConverters::convertFloatToFormat (const DataFormat destFormat,
 	}
 }
 
+void AudioDataConverters::convertFloatToFormat (const DataFormat destFormat,
+												const float* const source,
+												void* const dest,
+												const int numSamples,
+												Dither& dither)
+{
+	switch (destFormat)
+	{
+		case int16LE:       convertFloatToInt16LE   (source, dest, numSamples, 2, dither); break;
+		case int16BE:       convertFloatToInt16BE   (source, dest, numSamples, 2, dither); break;
+		case int24LE:       convertFloatToInt24LE   (source, dest, numSamples, 3, dither); break;
+		case int24BE:       convertFloatToInt24BE   (source, dest, numSamples, 3, dither); break;
+		default:            convertFloatToFormat    (destFormat, source, dest, numSamples); break;
+	}
+}
+
 void AudioDataConverters::convertFormatToFloat (const DataFormat sourceFormat,
 												const void* const source,
 												float* const dest,
@@ -28510,8 +28726,252 @@ END_JUCE_NAMESPACE
 
 
 /*** Start of inlined file: juce_AudioSampleBuffer.cpp ***/
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE2__)) && ! defined (JUCE_DISABLE_SSE2_AUDIO_BUFFERS)
+ #define JUCE_USE_SSE2_AUDIO_BUFFERS 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
+namespace AudioSampleBufferHelpers
+{
+	// the channels of an allocated buffer start on 32-byte boundaries, which the
+	// 32 spare bytes at the end of the block leave room for
+	inline int getPaddedSize (const int numSamples) noexcept
+	{
+		return (numSamples + 7) & ~7;
+	}
+
+	inline float* getFirstChannel (char* const data, const size_t channelListSize) noexcept
+	{
+		return reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (data + channelListSize) + 31) & ~(pointer_sized_int) 31);
+	}
+
+   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+	// the gains of the next four samples of a ramp
+	forcedinline __m128 getRampGains (const float gain, const float increment) noexcept
+	{
+		return _mm_add_ps (_mm_set1_ps (gain), _mm_mul_ps (_mm_set1_ps (increment), _mm_set_ps (3.0f, 2.0f, 1.0f, 0.0f)));
+	}
+   #endif
+
+	// The kernels below do as many samples as they can four at a time and leave
+	// the rest to the same scalar loops as before.
+	void multiply (float* const d, const int numSamples, const float gain) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			const __m128 g = _mm_set1_ps (gain);
+
+			for (; i + 4 <= numSamples; i += 4)
+				_mm_storeu_ps (d + i, _mm_mul_ps (_mm_loadu_ps (d + i), g));
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+			d[i] *= gain;
+	}
+
+	void multiplyWithRamp (float* const d, const int numSamples, float gain, const float increment) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			__m128 g = getRampGains (gain, increment);
+			const __m128 step = _mm_set1_ps (increment * 4.0f);
+
+			for (; i + 4 <= numSamples; i += 4)
+			{
+				_mm_storeu_ps (d + i, _mm_mul_ps (_mm_loadu_ps (d + i), g));
+				g = _mm_add_ps (g, step);
+			}
+
+			gain += increment * i;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+		{
+			d[i] *= gain;
+			gain += increment;
+		}
+	}
+
+	void add (float* const d, const float* const s, const int numSamples) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			for (; i + 4 <= numSamples; i += 4)
+				_mm_storeu_ps (d + i, _mm_add_ps (_mm_loadu_ps (d + i), _mm_loadu_ps (s + i)));
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+			d[i] += s[i];
+	}
+
+	void addWithGain (float* const d, const float* const s, const int numSamples, const float gain) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			const __m128 g = _mm_set1_ps (gain);
+
+			for (; i + 4 <= numSamples; i += 4)
+				_mm_storeu_ps (d + i, _mm_add_ps (_mm_loadu_ps (d + i), _mm_mul_ps (g, _mm_loadu_ps (s + i))));
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+			d[i] += gain * s[i];
+	}
+
+	void addWithRamp (float* const d, const float* const s, const int numSamples, float gain, const float increment) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			__m128 g = getRampGains (gain, increment);
+			const __m128 step = _mm_set1_ps (increment * 4.0f);
+
+			for (; i + 4 <= numSamples; i += 4)
+			{
+				_mm_storeu_ps (d + i, _mm_add_ps (_mm_loadu_ps (d + i), _mm_mul_ps (g, _mm_loadu_ps (s + i))));
+				g = _mm_add_ps (g, step);
+			}
+
+			gain += increment * i;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+		{
+			d[i] += gain * s[i];
+			gain += increment;
+		}
+	}
+
+	void copyWithGain (float* const d, const float* const s, const int numSamples, const float gain) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			const __m128 g = _mm_set1_ps (gain);
+
+			for (; i + 4 <= numSamples; i += 4)
+				_mm_storeu_ps (d + i, _mm_mul_ps (g, _mm_loadu_ps (s + i)));
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+			d[i] = gain * s[i];
+	}
+
+	void copyWithRamp (float* const d, const float* const s, const int numSamples, float gain, const float increment) noexcept
+	{
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2())
+		{
+			__m128 g = getRampGains (gain, increment);
+			const __m128 step = _mm_set1_ps (increment * 4.0f);
+
+			for (; i + 4 <= numSamples; i += 4)
+			{
+				_mm_storeu_ps (d + i, _mm_mul_ps (g, _mm_loadu_ps (s + i)));
+				g = _mm_add_ps (g, step);
+			}
+
+			gain += increment * i;
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+		{
+			d[i] = gain * s[i];
+			gain += increment;
+		}
+	}
+
+	// the largest absolute value, 0 for no samples
+	float findMagnitude (const float* const s, const int numSamples) noexcept
+	{
+		float mag = 0.0f;
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2() && numSamples >= 4)
+		{
+			const __m128 signMask = _mm_set1_ps (-0.0f);
+			__m128 m = _mm_setzero_ps();
+
+			for (; i + 4 <= numSamples; i += 4)
+				m = _mm_max_ps (m, _mm_andnot_ps (signMask, _mm_loadu_ps (s + i)));
+
+			m = _mm_max_ps (m, _mm_movehl_ps (m, m));
+			m = _mm_max_ss (m, _mm_shuffle_ps (m, m, 1));
+			_mm_store_ss (&mag, m);
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+			mag = jmax (mag, std::abs (s[i]));
+
+		return mag;
+	}
+
+	// the squares are rounded to floats and summed up as doubles, like the scalar loop,
+	// in two sums of two lanes each
+	double sumOfSquares (const float* const s, const int numSamples) noexcept
+	{
+		double sum = 0.0;
+		int i = 0;
+
+	   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+		if (SystemStats::canUseSSE2() && numSamples >= 4)
+		{
+			__m128d lo = _mm_setzero_pd();
+			__m128d hi = _mm_setzero_pd();
+
+			for (; i + 4 <= numSamples; i += 4)
+			{
+				const __m128 v = _mm_loadu_ps (s + i);
+				const __m128 squares = _mm_mul_ps (v, v);
+				lo = _mm_add_pd (lo, _mm_cvtps_pd (squares));
+				hi = _mm_add_pd (hi, _mm_cvtps_pd (_mm_movehl_ps (squares, squares)));
+			}
+
+			double sums[2];
+			_mm_storeu_pd (sums, _mm_add_pd (lo, hi));
+			sum = sums[0] + sums[1];
+		}
+	   #endif
+
+		for (; i < numSamples; ++i)
+		{
+			const float sample = s[i];
+			sum += sample * sample;
+		}
+
+		return sum;
+	}
+}
+
 AudioSampleBuffer::AudioSampleBuffer (const int numChannels_,
 									  const int numSamples) noexcept
   : numChannels (numChannels_),
@@ -28537,15 +28997,16 @@ AudioSampleBuffer::AudioSampleBuffer (const AudioSampleBuffer& other) noexcept
 void AudioSampleBuffer::allocateData()
 {
 	const size_t channelListSize = (numChannels + 1) * sizeof (float*);
-	allocatedBytes = (int) (numChannels * size * sizeof (float) + channelListSize + 32);
+	const int paddedSize = AudioSampleBufferHelpers::getPaddedSize (size);
+	allocatedBytes = (int) (numChannels * paddedSize * sizeof (float) + channelListSize + 32);
 	allocatedData.malloc (allocatedBytes);
 	channels = reinterpret_cast <float**> (allocatedData.getData());
 
-	float* chan = (float*) (allocatedData + channelListSize);
+	float* chan = AudioSampleBufferHelpers::getFirstChannel (allocatedData, channelListSize);
 	for (int i = 0; i < numChannels; ++i)
 	{
 		channels[i] = chan;
-		chan += size;
+		chan += paddedSize;
 	}
 
 	channels [numChannels] = 0;
@@ -28643,7 +29104,8 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
 	if (newNumSamples != size || newNumChannels != numChannels)
 	{
 		const size_t channelListSize = (newNumChannels + 1) * sizeof (float*);
-		const size_t newTotalBytes = (newNumChannels * newNumSamples * sizeof (float)) + channelListSize + 32;
+		const int paddedSize = AudioSampleBufferHelpers::getPaddedSize (newNumSamples);
+		const size_t newTotalBytes = (newNumChannels * paddedSize * sizeof (float)) + channelListSize + 32;
 
 		if (keepExistingContent)
 		{
@@ -28653,12 +29115,12 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
 			const size_t numBytesToCopy = sizeof (float) * jmin (newNumSamples, size);
 
 			float** const newChannels = reinterpret_cast <float**> (newData.getData());
-			float* newChan = reinterpret_cast <float*> (newData + channelListSize);
+			float* newChan = AudioSampleBufferHelpers::getFirstChannel (newData, channelListSize);
 
 			for (int j = 0; j < newNumChannels; ++j)
 			{
 				newChannels[j] = newChan;
-				newChan += newNumSamples;
+				newChan += paddedSize;
 			}
 
 			const int numChansToCopy = jmin (numChannels, newNumChannels);
@@ -28683,11 +29145,11 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
 				channels = reinterpret_cast <float**> (allocatedData.getData());
 			}
 
-			float* chan = reinterpret_cast <float*> (allocatedData + channelListSize);
+			float* chan = AudioSampleBufferHelpers::getFirstChannel (allocatedData, channelListSize);
 			for (int i = 0; i < newNumChannels; ++i)
 			{
 				channels[i] = chan;
-				chan += newNumSamples;
+				chan += paddedSize;
 			}
 		}
 
@@ -28740,8 +29202,7 @@ void AudioSampleBuffer::applyGain (const int channel,
 		}
 		else
 		{
-			while (--numSamples >= 0)
-				*d++ *= gain;
+			AudioSampleBufferHelpers::multiply (d, numSamples, gain);
 		}
 	}
 }
@@ -28764,11 +29225,7 @@ void AudioSampleBuffer::applyGainRamp (const int channel,
 		const float increment = (endGain - startGain) / numSamples;
 		float* d = channels [channel] + startSample;
 
-		while (--numSamples >= 0)
-		{
-			*d++ *= startGain;
-			startGain += increment;
-		}
+		AudioSampleBufferHelpers::multiplyWithRamp (d, numSamples, startGain, increment);
 	}
 }
 
@@ -28800,15 +29257,9 @@ void AudioSampleBuffer::addFrom (const int destChannel,
 		const float* s  = source.channels [sourceChannel] + sourceStartSample;
 
 		if (gain != 1.0f)
-		{
-			while (--numSamples >= 0)
-				*d++ += gain * *s++;
-		}
+			AudioSampleBufferHelpers::addWithGain (d, s, numSamples, gain);
 		else
-		{
-			while (--numSamples >= 0)
-				*d++ += *s++;
-		}
+			AudioSampleBufferHelpers::add (d, s, numSamples);
 	}
 }
 
@@ -28827,15 +29278,9 @@ void AudioSampleBuffer::addFrom (const int destChannel,
 		float* d = channels [destChannel] + destStartSample;
 
 		if (gain != 1.0f)
-		{
-			while (--numSamples >= 0)
-				*d++ += gain * *source++;
-		}
+			AudioSampleBufferHelpers::addWithGain (d, source, numSamples, gain);
 		else
-		{
-			while (--numSamples >= 0)
-				*d++ += *source++;
-		}
+			AudioSampleBufferHelpers::add (d, source, numSamples);
 	}
 }
 
@@ -28865,11 +29310,7 @@ void AudioSampleBuffer::addFromWithRamp (const int destChannel,
 			const float increment = (endGain - startGain) / numSamples;
 			float* d = channels [destChannel] + destStartSample;
 
-			while (--numSamples >= 0)
-			{
-				*d++ += startGain * *source++;
-				startGain += increment;
-			}
+			AudioSampleBufferHelpers::addWithRamp (d, source, numSamples, startGain, increment);
 		}
 	}
 }
@@ -28934,8 +29375,7 @@ void AudioSampleBuffer::copyFrom (const int destChannel,
 			}
 			else
 			{
-				while (--numSamples >= 0)
-					*d++ = gain * *source++;
+				AudioSampleBufferHelpers::copyWithGain (d, source, numSamples, gain);
 			}
 		}
 		else
@@ -28971,11 +29411,7 @@ void AudioSampleBuffer::copyFromWithRamp (const int destChannel,
 			const float increment = (endGain - startGain) / numSamples;
 			float* d = channels [destChannel] + destStartSample;
 
-			while (--numSamples >= 0)
-			{
-				*d++ = startGain * *source++;
-				startGain += increment;
-			}
+			AudioSampleBufferHelpers::copyWithRamp (d, source, numSamples, startGain, increment);
 		}
 	}
 }
@@ -28999,10 +29435,7 @@ float AudioSampleBuffer::getMagnitude (const int channel,
 	jassert (isPositiveAndBelow (channel, numChannels));
 	jassert (startSample >= 0 && startSample + numSamples <= size);
 
-	float mn, mx;
-	findMinMax (channel, startSample, numSamples, mn, mx);
-
-	return jmax (mn, -mn, mx, -mx);
+	return AudioSampleBufferHelpers::findMagnitude (channels [channel] + startSample, numSamples);
 }
 
 float AudioSampleBuffer::getMagnitude (const int startSample,
@@ -29026,14 +29459,7 @@ float AudioSampleBuffer::getRMSLevel (const int channel,
 	if (numSamples <= 0 || channel < 0 || channel >= numChannels)
 		return 0.0f;
 
-	const float* const data = channels [channel] + startSample;
-	double sum = 0.0;
-
-	for (int i = 0; i < numSamples; ++i)
-	{
-		const float sample = data [i];
-		sum += sample * sample;
-	}
+	const double sum = AudioSampleBufferHelpers::sumOfSquares (channels [channel] + startSample, numSamples);
 
 	return (float) std::sqrt (sum / numSamples);
 }
@@ -29112,6 +29538,11 @@ END_JUCE_NAMESPACE
 
 
 /*** Start of inlined file: juce_IIRFilter.cpp ***/
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE__)) && ! defined (JUCE_DISABLE_SSE_FILTERS)
+ #define JUCE_USE_SSE_FILTERS 1
+ #include <xmmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 IIRFilter::IIRFilter()
@@ -29335,6 +29766,315 @@ void IIRFilter::setCoefficients (double c1, double c2, double c3,
 	active = true;
 }
 
+#if JUCE_USE_SSE_FILTERS
+namespace IIRFilterBankHelpers
+{
+	// 64-bit CPUs always have SSE, 32-bit builds check it once
+	inline bool canUseSSE() noexcept
+	{
+	   #if JUCE_64BIT
+		return true;
+	   #else
+		static const bool hasSSE = SystemStats::hasSSE();
+		return hasSSE;
+	   #endif
+	}
+
+	// the biquads of four neighbouring channels, with the same arithmetic as IIRFilter
+	struct FourChannels
+	{
+		__m128 b0, b1, b2, a1, a2, x1, x2, y1, y2;
+
+		forcedinline void load (const float* coefficients, const float* state, const int stride) noexcept
+		{
+			b0 = _mm_loadu_ps (coefficients);
+			b1 = _mm_loadu_ps (coefficients + stride);
+			b2 = _mm_loadu_ps (coefficients + stride * 2);
+			a1 = _mm_loadu_ps (coefficients + stride * 3);
+			a2 = _mm_loadu_ps (coefficients + stride * 4);
+			x1 = _mm_loadu_ps (state);
+			x2 = _mm_loadu_ps (state + stride);
+			y1 = _mm_loadu_ps (state + stride * 2);
+			y2 = _mm_loadu_ps (state + stride * 3);
+		}
+
+		forcedinline void save (float* coefficients, float* state, const int stride) const noexcept
+		{
+			_mm_storeu_ps (coefficients, b0);
+			_mm_storeu_ps (coefficients + stride, b1);
+			_mm_storeu_ps (coefficients + stride * 2, b2);
+			_mm_storeu_ps (coefficients + stride * 3, a1);
+			_mm_storeu_ps (coefficients + stride * 4, a2);
+			_mm_storeu_ps (state, x1);
+			_mm_storeu_ps (state + stride, x2);
+			_mm_storeu_ps (state + stride * 2, y1);
+			_mm_storeu_ps (state + stride * 3, y2);
+		}
+
+		forcedinline void step (const float* steps, const int stride) noexcept
+		{
+			b0 = _mm_add_ps (b0, _mm_loadu_ps (steps));
+			b1 = _mm_add_ps (b1, _mm_loadu_ps (steps + stride));
+			b2 = _mm_add_ps (b2, _mm_loadu_ps (steps + stride * 2));
+			a1 = _mm_add_ps (a1, _mm_loadu_ps (steps + stride * 3));
+			a2 = _mm_add_ps (a2, _mm_loadu_ps (steps + stride * 4));
+		}
+
+		forcedinline __m128 process (const __m128 in, const __m128 threshold, const __m128 signMask) noexcept
+		{
+			__m128 out = _mm_sub_ps (_mm_sub_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (b0, in), _mm_mul_ps (b1, x1)),
+															 _mm_mul_ps (b2, x2)),
+												 _mm_mul_ps (a1, y1)),
+									 _mm_mul_ps (a2, y2));
+
+			// values within 1.0e-8 of 0 become 0, the same test as IIRFilter
+			out = _mm_and_ps (out, _mm_cmpgt_ps (_mm_andnot_ps (signMask, out), threshold));
+
+			x2 = x1;
+			x1 = in;
+			y2 = y1;
+			y1 = out;
+			return out;
+		}
+	};
+}
+#endif
+
+IIRFilterBank::IIRFilterBank (const int numChannels_)
+	: numChannels (numChannels_),
+	  coefficients (numCoefficients * numChannels_),
+	  targets (numCoefficients * numChannels_),
+	  steps (numCoefficients * numChannels_),
+	  state (4 * numChannels_),
+	  smoothingLength (0),
+	  rampRemaining (0)
+{
+	jassert (numChannels_ > 0);
+
+	for (int i = 0; i < numChannels; ++i)
+	{
+		coefficients[i] = 1.0f;
+
+		for (int j = 1; j < numCoefficients; ++j)
+			coefficients [j * numChannels + i] = 0;
+	}
+
+	memcpy (targets, coefficients, sizeof (float) * numCoefficients * numChannels);
+	zeromem (steps, sizeof (float) * numCoefficients * numChannels);
+	reset();
+}
+
+IIRFilterBank::~IIRFilterBank()
+{
+}
+
+void IIRFilterBank::setSmoothingLength (const int numSamples) noexcept
+{
+	smoothingLength = jmax (0, numSamples);
+}
+
+void IIRFilterBank::setCoefficients (const int channel, const IIRFilter& filter) noexcept
+{
+	jassert (isPositiveAndBelow (channel, numChannels));
+
+	float newCoefficients[numCoefficients] = { 1.0f, 0, 0, 0, 0 };
+
+	{
+		const ScopedLock sl (filter.processLock);
+
+		if (filter.active)
+		{
+			newCoefficients[0] = filter.coefficients[0];
+			newCoefficients[1] = filter.coefficients[1];
+			newCoefficients[2] = filter.coefficients[2];
+			newCoefficients[3] = filter.coefficients[4];
+			newCoefficients[4] = filter.coefficients[5];
+		}
+	}
+
+	for (int j = 0; j < numCoefficients; ++j)
+	{
+		const int index = j * numChannels + channel;
+		targets[index] = newCoefficients[j];
+
+		if (smoothingLength == 0)
+		{
+			coefficients[index] = newCoefficients[j];
+			steps[index] = 0;
+		}
+	}
+
+	if (smoothingLength > 0)
+	{
+		// every channel that's still moving starts a new ramp towards its target
+		const float scale = 1.0f / smoothingLength;
+
+		for (int i = numCoefficients * numChannels; --i >= 0;)
+			steps[i] = (targets[i] - coefficients[i]) * scale;
+
+		rampRemaining = smoothingLength;
+	}
+}
+
+void IIRFilterBank::reset() noexcept
+{
+	zeromem (state, sizeof (float) * 4 * numChannels);
+}
+
+void IIRFilterBank::processInterleaved (float* frames, int numSamples) noexcept
+{
+	if (rampRemaining > 0)
+	{
+		const int numRamped = jmin (numSamples, rampRemaining);
+		processSection (frames, numRamped, true);
+		rampRemaining -= numRamped;
+
+		if (rampRemaining == 0)
+		{
+			// the steps don't add up to the targets exactly
+			memcpy (coefficients, targets, sizeof (float) * numCoefficients * numChannels);
+			zeromem (steps, sizeof (float) * numCoefficients * numChannels);
+		}
+
+		frames += numRamped * numChannels;
+		numSamples -= numRamped;
+	}
+
+	if (numSamples > 0)
+		processSection (frames, numSamples, false);
+}
+
+void IIRFilterBank::processSection (float* const frames, const int numSamples, const bool ramping) noexcept
+{
+	int channel = 0;
+
+   #if JUCE_USE_SSE_FILTERS
+	if (IIRFilterBankHelpers::canUseSSE())
+	{
+		for (; channel + 8 <= numChannels; channel += 8)
+			processEight (frames, channel, numSamples, ramping);
+
+		if (channel + 4 <= numChannels)
+		{
+			processFour (frames, channel, numSamples, ramping);
+			channel += 4;
+		}
+	}
+   #endif
+
+	for (; channel < numChannels; ++channel)
+		processScalar (frames, channel, numSamples, ramping);
+}
+
+void IIRFilterBank::processScalar (float* const frames, const int channel, const int numSamples, const bool ramping) noexcept
+{
+	float* const c = coefficients + channel;
+	const float* const s = steps + channel;
+	float* const st = state + channel;
+	const int stride = numChannels;
+
+	float b0 = c[0], b1 = c[stride], b2 = c[stride * 2], a1 = c[stride * 3], a2 = c[stride * 4];
+	float x1 = st[0], x2 = st[stride], y1 = st[stride * 2], y2 = st[stride * 3];
+
+	float* sample = frames + channel;
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		if (ramping)
+		{
+			b0 += s[0];
+			b1 += s[stride];
+			b2 += s[stride * 2];
+			a1 += s[stride * 3];
+			a2 += s[stride * 4];
+		}
+
+		const float in = *sample;
+		float out = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+
+	   #if JUCE_INTEL
+		if (! (out < -1.0e-8 || out > 1.0e-8))
+			out = 0;
+	   #endif
+
+		x2 = x1;
+		x1 = in;
+		y2 = y1;
+		y1 = out;
+
+		*sample = out;
+		sample += stride;
+	}
+
+	c[0] = b0; c[stride] = b1; c[stride * 2] = b2; c[stride * 3] = a1; c[stride * 4] = a2;
+	st[0] = x1; st[stride] = x2; st[stride * 2] = y1; st[stride * 3] = y2;
+}
+
+void IIRFilterBank::processFour (float* const frames, const int channel, const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_USE_SSE_FILTERS
+	using namespace IIRFilterBankHelpers;
+	const int stride = numChannels;
+	const __m128 threshold = _mm_set1_ps (1.0e-8f);
+	const __m128 signMask = _mm_set1_ps (-0.0f);
+
+	FourChannels f;
+	f.load (coefficients + channel, state + channel, stride);
+
+	float* sample = frames + channel;
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		if (ramping)
+			f.step (steps + channel, stride);
+
+		_mm_storeu_ps (sample, f.process (_mm_loadu_ps (sample), threshold, signMask));
+		sample += stride;
+	}
+
+	f.save (coefficients + channel, state + channel, stride);
+   #else
+	(void) frames; (void) channel; (void) numSamples; (void) ramping;
+   #endif
+}
+
+void IIRFilterBank::processEight (float* const frames, const int channel, const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_USE_SSE_FILTERS
+	using namespace IIRFilterBankHelpers;
+	const int stride = numChannels;
+	const __m128 threshold = _mm_set1_ps (1.0e-8f);
+	const __m128 signMask = _mm_set1_ps (-0.0f);
+
+	// two independent chains, so one can run while the other waits for its results
+	FourChannels f1, f2;
+	f1.load (coefficients + channel, state + channel, stride);
+	f2.load (coefficients + channel + 4, state + channel + 4, stride);
+
+	float* sample = frames + channel;
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		if (ramping)
+		{
+			f1.step (steps + channel, stride);
+			f2.step (steps + channel + 4, stride);
+		}
+
+		const __m128 in1 = _mm_loadu_ps (sample);
+		const __m128 in2 = _mm_loadu_ps (sample + 4);
+		_mm_storeu_ps (sample, f1.process (in1, threshold, signMask));
+		_mm_storeu_ps (sample + 4, f2.process (in2, threshold, signMask));
+		sample += stride;
+	}
+
+	f1.save (coefficients + channel, state + channel, stride);
+	f2.save (coefficients + channel + 4, state + channel + 4, stride);
+   #else
+	(void) frames; (void) channel; (void) numSamples; (void) ramping;
+   #endif
+}
+
 END_JUCE_NAMESPACE
 
 /*** End of inlined file: juce_IIRFilter.cpp ***/
@@ -29370,6 +30110,12 @@ void MidiOutput::sendBlockOfMessages (const MidiBuffer& buffer,
 	// this needs to be a value in the future - RTFM for this method!
 	jassert (millisecondCounterToStartAt > 0);
 
+   #if JUCE_MAC
+	// CoreMIDI schedules the messages by their timestamps, so they don't have to wait in the queue
+	if (sendBlockScheduled (buffer, millisecondCounterToStartAt, samplesPerSecondForBuffer))
+		return;
+   #endif
+
 	const double timeScaleFactor = 1000.0 / samplesPerSecondForBuffer;
 
 	MidiBuffer::Iterator i (buffer);
@@ -29407,6 +30153,10 @@ void MidiOutput::sendBlockOfMessages (const MidiBuffer& buffer,
 
 void MidiOutput::clearAllPendingMessages()
 {
+   #if JUCE_MAC
+	flushScheduledMessages();
+   #endif
+
 	const ScopedLock sl (lock);
 
 	while (firstMessage != nullptr)
@@ -29417,6 +30167,21 @@ void MidiOutput::clearAllPendingMessages()
 	}
 }
 
+#if ! (JUCE_LINUX || JUCE_WINDOWS || JUCE_MAC)
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+	for (int i = 0; i < numMessages; ++i)
+		sendMessageNow (*messages[i]);
+}
+
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+	sendMessageNow (MidiMessage ((int) (packedMessage & 0xff),
+								 (int) ((packedMessage >> 8) & 0xff),
+								 (int) ((packedMessage >> 16) & 0xff)));
+}
+#endif
+
 void MidiOutput::startBackgroundThread()
 {
 	startThread (9);
@@ -29467,10 +30232,32 @@ void MidiOutput::run()
 					break;
 			}
 
-			if (eventTime > now - 200)
-				sendMessageNow (message->message);
+			// everything else that is due by now goes out in the same batch
+			Array<PendingMessage*> batch;
+			batch.add (message);
+
+			{
+				const ScopedLock sl (lock);
+				const double batchTime = Time::getMillisecondCounter();
+
+				while (firstMessage != nullptr && firstMessage->message.getTimeStamp() <= batchTime)
+				{
+					batch.add (firstMessage);
+					firstMessage = firstMessage->next;
+				}
+			}
+
+			Array<const MidiMessage*> messagesToSend;
+
+			for (int i = 0; i < batch.size(); ++i)
+				if (roundToInt (batch.getUnchecked(i)->message.getTimeStamp()) > (int) (now - 200))
+					messagesToSend.add (&(batch.getUnchecked(i)->message));
 
-			delete message;
+			if (messagesToSend.size() > 0)
+				sendMessagesNow (messagesToSend.getRawDataPointer(), messagesToSend.size());
+
+			for (int i = 0; i < batch.size(); ++i)
+				delete batch.getUnchecked(i);
 		}
 		else
 		{
@@ -41537,6 +42324,7 @@ BEGIN_JUCE_NAMESPACE
 #define CHECK_MESSAGE_MANAGER_IS_LOCKED	 jassert (MessageManager::getInstance()->currentThreadHasLockedMessageManager());
 
 Component* Component::currentlyFocusedComponent = nullptr;
+Component::PaintTimer* Component::currentPaintTimer = nullptr;
 
 class Component::MouseListenerList
 {
@@ -43269,8 +44057,16 @@ void Component::internalRepaint (int x, int y, int w, int h)
 	}
 }
 
+void Component::setPaintTimer (PaintTimer* newPaintTimer) noexcept
+{
+	currentPaintTimer = newPaintTimer;
+}
+
 void Component::paintComponent (Graphics& g)
 {
+	PaintTimer* const paintTimer = currentPaintTimer;
+	const double startTime = paintTimer != nullptr ? Time::getMillisecondCounterHiRes() : 0.0;
+
 	if (flags.bufferToImageFlag)
 	{
 		if (bufferedImage.isNull())
@@ -43289,6 +44085,9 @@ void Component::paintComponent (Graphics& g)
 	{
 		paint (g);
 	}
+
+	if (paintTimer != nullptr)
+		paintTimer->componentPainted (*this, Time::getMillisecondCounterHiRes() - startTime);
 }
 
 void Component::paintWithinParentContext (Graphics& g)
@@ -84338,14 +85137,134 @@ BEGIN_JUCE_NAMESPACE
 
 const int juce_edgeTableDefaultEdgesPerLine = 32;
 
+namespace EdgeTableHelpers
+{
+	/*  Most tables only live while one shape is drawn, so rather than freeing its memory
+		a table gives it to a cache of the thread that deletes it, and the next tables the
+		thread creates take it from there. A thread claims one of the slots the first
+		time it needs one and keeps it, so only that thread ever touches it and nothing
+		needs a lock. Threads that find no free slot just use the allocator.
+	*/
+	class ScratchCache
+	{
+	public:
+		ScratchCache() noexcept  : isShutDown (false)
+		{
+			for (int i = 0; i < numSlots; ++i)
+				for (int j = 0; j < blocksPerSlot; ++j)
+					slots[i].capacities[j] = 0;
+		}
+
+		~ScratchCache() noexcept
+		{
+			isShutDown = true;
+		}
+
+		/** Gives block room for at least numElements, and returns how many it can hold. */
+		int allocate (HeapBlock<int>& block, const int numElements)
+		{
+			Slot* const slot = getSlot();
+
+			if (slot != nullptr)
+			{
+				// the smallest block that fits, but not one that would waste most of its space
+				int best = -1;
+
+				for (int i = 0; i < blocksPerSlot; ++i)
+				{
+					const int capacity = slot->capacities[i];
+
+					if (capacity >= numElements && capacity / 2 <= numElements
+						 && (best < 0 || capacity < slot->capacities[best]))
+						best = i;
+				}
+
+				if (best >= 0)
+				{
+					block.swapWith (slot->blocks[best]);
+					const int capacity = slot->capacities[best];
+					slot->capacities[best] = 0;
+					return capacity;
+				}
+			}
+
+			block.malloc (numElements);
+			return numElements;
+		}
+
+		/** Takes over the memory of a block, which is empty afterwards. */
+		void release (HeapBlock<int>& block, const int capacity)
+		{
+			Slot* const slot = (capacity > 0 && capacity <= maxCachedElements) ? getSlot() : nullptr;
+
+			if (slot != nullptr)
+			{
+				// when the slot is full, the smallest block makes room for a bigger one
+				int smallest = 0;
+
+				for (int i = 1; i < blocksPerSlot; ++i)
+					if (slot->capacities[i] < slot->capacities[smallest])
+						smallest = i;
+
+				if (slot->capacities[smallest] < capacity)
+				{
+					slot->blocks[smallest].swapWith (block);
+					slot->capacities[smallest] = capacity;
+				}
+			}
+
+			block.free();
+		}
+
+	private:
+		enum { numSlots = 8, blocksPerSlot = 4, maxCachedElements = 256 * 1024 };
+
+		struct Slot
+		{
+			Atomic<Thread::ThreadID> owner;
+			HeapBlock<int> blocks [blocksPerSlot];
+			int capacities [blocksPerSlot];
+		};
+
+		Slot slots [numSlots];
+		bool isShutDown;
+
+		Slot* getSlot() noexcept
+		{
+			if (isShutDown)
+				return nullptr;
+
+			const Thread::ThreadID thread = Thread::getCurrentThreadId();
+
+			// slots are never given back, so a thread finds its own before any free one
+			for (int i = 0; i < numSlots; ++i)
+			{
+				Slot& slot = slots[i];
+				const Thread::ThreadID owner = slot.owner.get();
+
+				if (owner == thread
+					 || (owner == nullptr && slot.owner.compareAndSetBool (thread, nullptr)))
+					return &slot;
+			}
+
+			return nullptr;
+		}
+
+		JUCE_DECLARE_NON_COPYABLE (ScratchCache);
+	};
+
+	static ScratchCache scratchCache;
+}
+
 EdgeTable::EdgeTable (const Rectangle<int>& bounds_,
 					  const Path& path, const AffineTransform& transform)
    : bounds (bounds_),
 	 maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
 	 lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+	 tableCapacity (0),
 	 needToCheckEmptinesss (true)
 {
-	table.malloc ((bounds.getHeight() + 1) * lineStrideElements);
+	allocateTable ((bounds.getHeight() + 1) * lineStrideElements);
 	int* t = table;
 
 	for (int i = bounds.getHeight(); --i >= 0;)
@@ -84417,9 +85336,10 @@ EdgeTable::EdgeTable (const Rectangle<int>& rectangleToAdd)
    : bounds (rectangleToAdd),
 	 maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
 	 lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+	 tableCapacity (0),
 	 needToCheckEmptinesss (true)
 {
-	table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+	allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
 	table[0] = 0;
 
 	const int x1 = rectangleToAdd.getX() << 8;
@@ -84441,9 +85361,10 @@ EdgeTable::EdgeTable (const RectangleList& rectanglesToAdd)
    : bounds (rectanglesToAdd.getBounds()),
 	 maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
 	 lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+	 tableCapacity (0),
 	 needToCheckEmptinesss (true)
 {
-	table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+	allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
 
 	int* t = table;
 	for (int i = bounds.getHeight(); --i >= 0;)
@@ -84478,10 +85399,11 @@ EdgeTable::EdgeTable (const Rectangle<float>& rectangleToAdd)
 							 2 + (int) rectangleToAdd.getHeight())),
 	 maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
 	 lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+	 tableCapacity (0),
 	 needToCheckEmptinesss (true)
 {
 	jassert (! rectangleToAdd.isEmpty());
-	table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+	allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
 	table[0] = 0;
 
 	const int x1 = roundToInt (rectangleToAdd.getX() * 256.0f);
@@ -84550,6 +85472,7 @@ EdgeTable::EdgeTable (const Rectangle<float>& rectangleToAdd)
 }
 
 EdgeTable::EdgeTable (const EdgeTable& other)
+   : tableCapacity (0)
 {
 	operator= (other);
 }
@@ -84561,13 +85484,23 @@ EdgeTable& EdgeTable::operator= (const EdgeTable& other)
 	lineStrideElements = other.lineStrideElements;
 	needToCheckEmptinesss = other.needToCheckEmptinesss;
 
-	table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+	allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
 	copyEdgeTableData (table, lineStrideElements, other.table, lineStrideElements, bounds.getHeight());
 	return *this;
 }
 
 EdgeTable::~EdgeTable()
 {
+	EdgeTableHelpers::scratchCache.release (table, tableCapacity);
+}
+
+void EdgeTable::allocateTable (const int numElements)
+{
+	if (tableCapacity < numElements)
+	{
+		EdgeTableHelpers::scratchCache.release (table, tableCapacity);
+		tableCapacity = EdgeTableHelpers::scratchCache.allocate (table, numElements);
+	}
 }
 
 void EdgeTable::copyEdgeTableData (int* dest, const int destLineStride, const int* src, const int srcLineStride, int numLines) noexcept
@@ -84640,11 +85573,14 @@ void EdgeTable::remapTableForNumEdges (const int newNumEdgesPerLine)
 		jassert (bounds.getHeight() > 0);
 		const int newLineStrideElements = maxEdgesPerLine * 2 + 1;
 
-		HeapBlock <int> newTable (bounds.getHeight() * newLineStrideElements);
+		HeapBlock <int> newTable;
+		const int newCapacity = EdgeTableHelpers::scratchCache.allocate (newTable, bounds.getHeight() * newLineStrideElements);
 
 		copyEdgeTableData (newTable, newLineStrideElements, table, lineStrideElements, bounds.getHeight());
 
 		table.swapWith (newTable);
+		EdgeTableHelpers::scratchCache.release (newTable, tableCapacity);
+		tableCapacity = newCapacity;
 		lineStrideElements = newLineStrideElements;
 	}
 }
@@ -84656,7 +85592,20 @@ void EdgeTable::optimiseTable()
 	for (int i = bounds.getHeight(); --i >= 0;)
 		maxLineElements = jmax (maxLineElements, table [i * lineStrideElements]);
 
-	remapTableForNumEdges (maxLineElements);
+	// not from the scratch cache, that could hand out a bigger block than needed
+	if (maxLineElements != maxEdgesPerLine && bounds.getHeight() > 0)
+	{
+		maxEdgesPerLine = maxLineElements;
+		const int newLineStrideElements = maxEdgesPerLine * 2 + 1;
+		HeapBlock <int> newTable (bounds.getHeight() * newLineStrideElements);
+
+		copyEdgeTableData (newTable, newLineStrideElements, table, lineStrideElements, bounds.getHeight());
+
+		table.swapWith (newTable);
+		EdgeTableHelpers::scratchCache.release (newTable, tableCapacity);
+		tableCapacity = bounds.getHeight() * newLineStrideElements;
+		lineStrideElements = newLineStrideElements;
+	}
 }
 
 void EdgeTable::addEdgePoint (const int x, const int y, const int winding)
@@ -86388,6 +87337,11 @@ END_JUCE_NAMESPACE
 
 
 /*** Start of inlined file: juce_LowLevelGraphicsSoftwareRenderer.cpp ***/
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE2__)) && ! defined (JUCE_DISABLE_SSE2_RENDERING)
+ #define JUCE_USE_SSE2_RENDERING 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 #if JUCE_MSVC
@@ -86762,6 +87716,67 @@ namespace RenderingHelpers
 		n %= divisor;
 		return (n < 0) ? (n + divisor) : n;
 	}
+
+	/** Blends a line of pixels onto another one, with an extra opacity of 0 to 255.
+		This does the same as calling blend() for each pixel.
+	*/
+	template <class DestPixelType, class SrcPixelType>
+	forcedinline void blendLine (DestPixelType* dest, const SrcPixelType* src, int width, const int alphaLevel) noexcept
+	{
+		if (alphaLevel < 0xfe)
+		{
+			do
+			{
+				dest++ ->blend (*src++, alphaLevel);
+			} while (--width > 0);
+		}
+		else
+		{
+			do
+			{
+				dest++ ->blend (*src++);
+			} while (--width > 0);
+		}
+	}
+
+   #if JUCE_USE_SSE2_RENDERING
+	// blends two premultiplied pixels that are unpacked to 16 bits per channel
+	forcedinline __m128i blendPixelPair (const __m128i src, const __m128i dest, const __m128i extraAlpha) noexcept
+	{
+		const __m128i s = _mm_srli_epi16 (_mm_mullo_epi16 (src, extraAlpha), 8);
+		const __m128i a = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+		const __m128i inverseAlpha = _mm_sub_epi16 (_mm_set1_epi16 (256), a);
+
+		return _mm_add_epi16 (s, _mm_srli_epi16 (_mm_mullo_epi16 (dest, inverseAlpha), 8));
+	}
+
+	// the same as the generic version, but four pixels at a time
+	inline void blendLine (PixelARGB* dest, const PixelARGB* src, int width, const int alphaLevel) noexcept
+	{
+		if (SystemStats::canUseSSE2())
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i extraAlpha = _mm_set1_epi16 ((short) (alphaLevel < 0xfe ? alphaLevel + 1 : 256));
+
+			for (; width >= 4; width -= 4)
+			{
+				const __m128i s = _mm_loadu_si128 ((const __m128i*) src);
+				const __m128i d = _mm_loadu_si128 ((const __m128i*) dest);
+
+				_mm_storeu_si128 ((__m128i*) dest,
+								  _mm_packus_epi16 (blendPixelPair (_mm_unpacklo_epi8 (s, zero), _mm_unpacklo_epi8 (d, zero), extraAlpha),
+													blendPixelPair (_mm_unpackhi_epi8 (s, zero), _mm_unpackhi_epi8 (d, zero), extraAlpha)));
+				src += 4;
+				dest += 4;
+			}
+
+			if (width <= 0)
+				return;
+		}
+
+		blendLine<PixelARGB, PixelARGB> (dest, src, width, alphaLevel);
+	}
+   #endif
 }
 
 template <class DestPixelType, class SrcPixelType, bool repeatPattern>
@@ -86816,10 +87831,17 @@ public:
 
 		if (alphaLevel < 0xfe)
 		{
-			do
+			if (repeatPattern)
 			{
-				dest++ ->blend (sourceLineStart [repeatPattern ? (x++ % srcData.width) : x++], alphaLevel);
-			} while (--width > 0);
+				do
+				{
+					dest++ ->blend (sourceLineStart [x++ % srcData.width], alphaLevel);
+				} while (--width > 0);
+			}
+			else
+			{
+				RenderingHelpers::blendLine (dest, sourceLineStart + x, width, alphaLevel);
+			}
 		}
 		else
 		{
@@ -86900,6 +87922,11 @@ private:
 		memcpy (dest, src, width * sizeof (PixelRGB));
 	}
 
+	static forcedinline void copyRow (PixelARGB* dest, PixelARGB* src, int width) noexcept
+	{
+		RenderingHelpers::blendLine (dest, src, width, 0xff);
+	}
+
 	JUCE_DECLARE_NON_COPYABLE (ImageFillEdgeTableRenderer);
 };
 
@@ -86963,20 +87990,7 @@ public:
 		alphaLevel *= extraAlpha;
 		alphaLevel >>= 8;
 
-		if (alphaLevel < 0xfe)
-		{
-			do
-			{
-				dest++ ->blend (*span++, alphaLevel);
-			} while (--width > 0);
-		}
-		else
-		{
-			do
-			{
-				dest++ ->blend (*span++);
-			} while (--width > 0);
-		}
+		RenderingHelpers::blendLine (dest, span, width, alphaLevel);
 	}
 
 	forcedinline void handleEdgeTableLineFull (const int x, int width) noexcept
@@ -87083,6 +88097,37 @@ private:
 
 	void render4PixelAverage (PixelARGB* const dest, const uint8* src, const int subPixelX, const int subPixelY) noexcept
 	{
+	   #if JUCE_USE_SSE2_RENDERING
+		// the weights fit into 16 bits unless both sub-pixel positions are 0
+		if ((subPixelX | subPixelY) != 0 && SystemStats::canUseSSE2())
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const short w00 = (short) ((256 - subPixelX) * (256 - subPixelY));
+			const short w01 = (short) (subPixelX * (256 - subPixelY));
+			const short w10 = (short) ((256 - subPixelX) * subPixelY);
+			const short w11 = (short) (subPixelX * subPixelY);
+
+			const __m128i top = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i*) src), zero);
+			const __m128i bottom = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i*) (src + this->srcData.lineStride)), zero);
+			const __m128i topWeights = _mm_set_epi16 (w01, w01, w01, w01, w00, w00, w00, w00);
+			const __m128i bottomWeights = _mm_set_epi16 (w11, w11, w11, w11, w10, w10, w10, w10);
+
+			// full 32-bit products of the unsigned 16-bit channels and weights
+			__m128i lo = _mm_mullo_epi16 (top, topWeights);
+			__m128i hi = _mm_mulhi_epu16 (top, topWeights);
+			__m128i c = _mm_add_epi32 (_mm_unpacklo_epi16 (lo, hi), _mm_unpackhi_epi16 (lo, hi));
+
+			lo = _mm_mullo_epi16 (bottom, bottomWeights);
+			hi = _mm_mulhi_epu16 (bottom, bottomWeights);
+			c = _mm_add_epi32 (c, _mm_add_epi32 (_mm_unpacklo_epi16 (lo, hi), _mm_unpackhi_epi16 (lo, hi)));
+
+			c = _mm_srli_epi32 (_mm_add_epi32 (c, _mm_set1_epi32 (256 * 128)), 16);
+			c = _mm_packus_epi16 (_mm_packs_epi32 (c, zero), zero);
+			*dest = PixelARGB ((uint32) _mm_cvtsi128_si32 (c));
+			return;
+		}
+	   #endif
+
 		uint32 c[4] = { 256 * 128, 256 * 128, 256 * 128, 256 * 128 };
 
 		uint32 weight = (256 - subPixelX) * (256 - subPixelY);
@@ -98496,6 +99541,9 @@ public:
 
 	~Pimpl()
 	{
+		if (decoder != nullptr)
+			decoder->removeAllJobs (false, 10000, true);
+
 		clearSingletonInstance();
 	}
 
@@ -98556,6 +99604,87 @@ public:
 			stopTimer();
 	}
 
+	Image getAsync (const int64 hashCode, const File& file, const void* imageData,
+					const int dataSize, AsyncLoadCallback* const callback)
+	{
+		const ScopedLock sl (lock);
+
+		Image image (getFromHashCode (hashCode));
+		if (image.isValid())
+			return image;
+
+		AsyncLoad* load = findAsyncLoad (hashCode);
+
+		if (load == nullptr)
+		{
+			load = new AsyncLoad();
+			load->hashCode = hashCode;
+			load->file = file;
+			load->imageData = imageData;
+			load->dataSize = dataSize;
+			asyncLoads.add (load);
+
+			if (decoder == nullptr)
+				decoder = new ThreadPool (1);
+
+			decoder->addJob (new DecodeJob (*this, *load));
+		}
+
+		if (callback != nullptr)
+			load->callbacks.addIfNotAlreadyThere (callback);
+
+		return Image::null;
+	}
+
+	void cancelAsyncLoads (AsyncLoadCallback* const callback)
+	{
+		const ScopedLock sl (lock);
+
+		for (int i = asyncLoads.size(); --i >= 0;)
+			asyncLoads.getUnchecked(i)->callbacks.removeValue (callback);
+	}
+
+	// called on the message thread when a DecodeJob is done
+	void asyncLoadFinished (const int64 hashCode)
+	{
+		Image image;
+
+		{
+			const ScopedLock sl (lock);
+
+			AsyncLoad* const load = findAsyncLoad (hashCode);
+			if (load == nullptr)
+				return;
+
+			image = load->image;
+			addImageToCache (image, hashCode);
+		}
+
+		// a callback may cancel other ones, so they're taken out one at a time
+		for (;;)
+		{
+			AsyncLoadCallback* callback;
+
+			{
+				const ScopedLock sl (lock);
+
+				AsyncLoad* const load = findAsyncLoad (hashCode);
+				if (load == nullptr)
+					return;
+
+				if (load->callbacks.size() == 0)
+				{
+					asyncLoads.removeObject (load);
+					return;
+				}
+
+				callback = load->callbacks.remove (0);
+			}
+
+			callback->imageLoaded (image, hashCode);
+		}
+	}
+
 	struct Item
 	{
 		Image image;
@@ -98568,7 +99697,71 @@ public:
 	juce_DeclareSingleton_SingleThreaded_Minimal (ImageCache::Pimpl);
 
 private:
+	struct AsyncLoad
+	{
+		int64 hashCode;
+		File file;
+		const void* imageData;
+		int dataSize;
+		Image image;
+		Array<AsyncLoadCallback*> callbacks;
+	};
+
+	class LoadedMessage  : public CallbackMessage
+	{
+	public:
+		LoadedMessage (const int64 hashCode_) : hashCode (hashCode_) {}
+
+		void messageCallback()
+		{
+			if (ImageCache::Pimpl::getInstanceWithoutCreating() != nullptr)
+				ImageCache::Pimpl::getInstanceWithoutCreating()->asyncLoadFinished (hashCode);
+		}
+
+	private:
+		const int64 hashCode;
+	};
+
+	class DecodeJob  : public ThreadPoolJob
+	{
+	public:
+		DecodeJob (Pimpl& owner_, AsyncLoad& load_)
+			: ThreadPoolJob ("image decoder"), owner (owner_), load (load_)
+		{
+		}
+
+		JobStatus runJob()
+		{
+			// the load is only removed on the message thread, after this job has posted its message
+			const Image image (load.imageData != nullptr ? ImageFileFormat::loadFrom (load.imageData, load.dataSize)
+														 : ImageFileFormat::loadFrom (load.file));
+
+			{
+				const ScopedLock sl (owner.lock);
+				load.image = image;
+			}
+
+			(new LoadedMessage (load.hashCode))->post();
+			return jobHasFinishedAndShouldBeDeleted;
+		}
+
+	private:
+		Pimpl& owner;
+		AsyncLoad& load;
+	};
+
+	AsyncLoad* findAsyncLoad (const int64 hashCode) const
+	{
+		for (int i = asyncLoads.size(); --i >= 0;)
+			if (asyncLoads.getUnchecked(i)->hashCode == hashCode)
+				return asyncLoads.getUnchecked(i);
+
+		return nullptr;
+	}
+
 	OwnedArray<Item> images;
+	OwnedArray<AsyncLoad> asyncLoads;
+	ScopedPointer<ThreadPool> decoder;
 	CriticalSection lock;
 
 	JUCE_DECLARE_NON_COPYABLE (Pimpl);
@@ -98603,6 +99796,24 @@ Image ImageCache::getFromFile (const File& file)
 	return image;
 }
 
+Image ImageCache::getFromFileAsync (const File& file, AsyncLoadCallback* callback)
+{
+	return Pimpl::getInstance()->getAsync (file.hashCode64(), file, nullptr, 0, callback);
+}
+
+Image ImageCache::getFromMemoryAsync (const void* imageData, const int dataSize, AsyncLoadCallback* callback)
+{
+	// the same hash code as getFromMemory(), so both share the cached image
+	return Pimpl::getInstance()->getAsync ((int64) (pointer_sized_int) imageData, File::nonexistent,
+										   imageData, dataSize, callback);
+}
+
+void ImageCache::cancelAsyncLoads (AsyncLoadCallback* callback)
+{
+	if (Pimpl::getInstanceWithoutCreating() != nullptr)
+		Pimpl::getInstanceWithoutCreating()->cancelAsyncLoads (callback);
+}
+
 Image ImageCache::getFromMemory (const void* imageData, const int dataSize)
 {
 	const int64 hashCode = (int64) (pointer_sized_int) imageData;
@@ -246478,7 +247689,13 @@ public:
 
 		if (handle == INVALID_HANDLE_VALUE)
 		{
-			handle = FindFirstFile (directoryWithWildCard.toWideCharPointer(), &findData);
+			// without the short names, and with a bigger buffer for each call to the file system..
+			handle = FindFirstFileEx (directoryWithWildCard.toWideCharPointer(), (FINDEX_INFO_LEVELS) findExInfoBasic,
+									  &findData, FindExSearchNameMatch, 0, findFirstExLargeFetch);
+
+			// ..which needs Windows 7 or later
+			if (handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_INVALID_PARAMETER)
+				handle = FindFirstFile (directoryWithWildCard.toWideCharPointer(), &findData);
 
 			if (handle == INVALID_HANDLE_VALUE)
 				return false;
@@ -246505,6 +247722,9 @@ private:
 	const String directoryWithWildCard;
 	HANDLE handle;
 
+	// (not defined by older SDKs)
+	enum { findExInfoBasic = 1, findFirstExLargeFetch = 2 };
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Pimpl);
 };
 
@@ -248192,25 +249412,18 @@ public:
 		: hwnd (hwnd_),
 		  currentState (nullptr)
 	{
-		RECT windowRect;
-		GetClientRect (hwnd, &windowRect);
-		D2D1_SIZE_U size = { windowRect.right - windowRect.left, windowRect.bottom - windowRect.top };
-		bounds.setSize (size.width, size.height);
-
-		D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties();
-		D2D1_HWND_RENDER_TARGET_PROPERTIES propsHwnd = D2D1::HwndRenderTargetProperties (hwnd, size);
-
-		HRESULT hr = SharedD2DFactory::getInstance()->d2dFactory->CreateHwndRenderTarget (props, propsHwnd, renderingTarget.resetAndGetPointerAddress());
-		// xxx check for error
-
-		hr = renderingTarget->CreateSolidColorBrush (D2D1::ColorF::ColorF (0.0f, 0.0f, 0.0f, 1.0f), colourBrush.resetAndGetPointerAddress());
+		createRenderTarget();
 	}
 
 	~Direct2DLowLevelGraphicsContext()
 	{
 		states.clear();
+		cachedBitmaps.clear();
 	}
 
+	/** false if no render target could be created, the window has to paint in software*/
+	bool isValid() const noexcept       { return renderingTarget != nullptr; }
+
 	void resized()
 	{
 		RECT windowRect;
@@ -248232,12 +249445,24 @@ public:
 		saveState();
 	}
 
-	void end()
+	/** returns false if the device was lost and the render target could not be made again*/
+	bool end()
 	{
 		states.clear();
 		currentState = 0;
-		renderingTarget->EndDraw();
+		const HRESULT hr = renderingTarget->EndDraw();
+
+		if (hr == D2DERR_RECREATE_TARGET)
+		{
+			// everything made by the old target belongs to the lost device
+			cachedBitmaps.clear();
+			createRenderTarget();
+			InvalidateRect (hwnd, 0, FALSE);
+			return isValid();
+		}
+
 		renderingTarget->CheckWindowState();
+		return SUCCEEDED (hr);
 	}
 
 	bool isVectorDevice() const { return false; }
@@ -248362,20 +249587,18 @@ public:
 
 		renderingTarget->SetTransform (transformToMatrix (transform) * D2D1::Matrix3x2F::Translation (x, y));
 
-		D2D1_SIZE_U size;
-		size.width = image.getWidth();
-		size.height = image.getHeight();
-
-		D2D1_BITMAP_PROPERTIES bp = D2D1::BitmapProperties();
-
-		Image img (image.convertedToFormat (Image::ARGB));
-		Image::BitmapData bd (img, Image::BitmapData::readOnly);
-		bp.pixelFormat = renderingTarget->GetPixelFormat();
-		bp.pixelFormat.alphaMode = D2D1_ALPHA_MODE_PREMULTIPLIED;
-
+		// images that promise not to change are uploaded once and kept on the device
+		const NamedValueSet* const properties = image.getProperties();
+		if (properties != nullptr && properties->contains ("cacheAsBitmap"))
+		{
+			ID2D1Bitmap* const bitmap = getCachedBitmap (image);
+			if (bitmap != nullptr)
+				renderingTarget->DrawBitmap (bitmap);
+		}
+		else
 		{
 			ComSmartPtr <ID2D1Bitmap> tempBitmap;
-			renderingTarget->CreateBitmap (size, bd.data, bd.lineStride, bp, tempBitmap.resetAndGetPointerAddress());
+			createBitmap (image, tempBitmap);
 			if (tempBitmap != nullptr)
 				renderingTarget->DrawBitmap (tempBitmap);
 		}
@@ -248902,6 +250125,69 @@ private:
 	SavedState* currentState;
 	OwnedArray<SavedState> states;
 
+	struct CachedBitmap
+	{
+		Image image;
+		ComSmartPtr <ID2D1Bitmap> bitmap;
+	};
+
+	enum { maxCachedBitmaps = 256 };
+	OwnedArray<CachedBitmap> cachedBitmaps;
+
+	void createRenderTarget()
+	{
+		renderingTarget = nullptr;
+		colourBrush = nullptr;
+
+		RECT windowRect;
+		GetClientRect (hwnd, &windowRect);
+		D2D1_SIZE_U size = { windowRect.right - windowRect.left, windowRect.bottom - windowRect.top };
+		bounds.setSize (size.width, size.height);
+
+		D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties();
+		D2D1_HWND_RENDER_TARGET_PROPERTIES propsHwnd = D2D1::HwndRenderTargetProperties (hwnd, size);
+
+		HRESULT hr = SharedD2DFactory::getInstance()->d2dFactory->CreateHwndRenderTarget (props, propsHwnd, renderingTarget.resetAndGetPointerAddress());
+
+		if (FAILED (hr))
+			renderingTarget = nullptr;
+		else
+			hr = renderingTarget->CreateSolidColorBrush (D2D1::ColorF::ColorF (0.0f, 0.0f, 0.0f, 1.0f), colourBrush.resetAndGetPointerAddress());
+	}
+
+	void createBitmap (const Image& image, ComSmartPtr <ID2D1Bitmap>& bitmap)
+	{
+		D2D1_SIZE_U size;
+		size.width = image.getWidth();
+		size.height = image.getHeight();
+
+		D2D1_BITMAP_PROPERTIES bp = D2D1::BitmapProperties();
+
+		Image img (image.convertedToFormat (Image::ARGB));
+		Image::BitmapData bd (img, Image::BitmapData::readOnly);
+		bp.pixelFormat = renderingTarget->GetPixelFormat();
+		bp.pixelFormat.alphaMode = D2D1_ALPHA_MODE_PREMULTIPLIED;
+
+		renderingTarget->CreateBitmap (size, bd.data, bd.lineStride, bp, bitmap.resetAndGetPointerAddress());
+	}
+
+	ID2D1Bitmap* getCachedBitmap (const Image& image)
+	{
+		for (int i = cachedBitmaps.size(); --i >= 0;)
+			if (cachedBitmaps.getUnchecked(i)->image.getSharedImage() == image.getSharedImage())
+				return cachedBitmaps.getUnchecked(i)->bitmap;
+
+		// the oldest upload goes first
+		if (cachedBitmaps.size() >= maxCachedBitmaps)
+			cachedBitmaps.remove (0);
+
+		CachedBitmap* const cached = new CachedBitmap();
+		cached->image = image;
+		createBitmap (image, cached->bitmap);
+		cachedBitmaps.add (cached);
+		return cached->bitmap;
+	}
+
 	static D2D1_RECT_F rectangleToRectF (const Rectangle<int>& r)
 	{
 		return D2D1::RectF ((float) r.getX(), (float) r.getY(), (float) r.getRight(), (float) r.getBottom());
@@ -250123,10 +251409,6 @@ private:
 							   L"", type, 0, 0, 0, 0, parentToAddTo, 0,
 							   (HINSTANCE) Process::getCurrentModuleInstanceHandle(), 0);
 
-	   #if JUCE_DIRECT2D
-		setCurrentRenderingEngine (1);
-	   #endif
-
 		if (hwnd != 0)
 		{
 			SetWindowLongPtr (hwnd, 0, 0);
@@ -250235,7 +251517,14 @@ private:
 				direct2DContext->start();
 				direct2DContext->clipToRectangle (Rectangle<int> (r.left, r.top, r.right - r.left, r.bottom - r.top));
 				handlePaint (*direct2DContext);
-				direct2DContext->end();
+
+				if (! direct2DContext->end())
+				{
+					// the device was lost and no new render target could be made
+					currentRenderingEngine = softwareRenderingEngine;
+					updateDirect2DContext();
+					InvalidateRect (hwnd, 0, FALSE);
+				}
 			}
 		}
 		else
@@ -250398,6 +251687,12 @@ private:
 			direct2DContext = 0;
 		else if (direct2DContext == 0)
 			direct2DContext = new Direct2DLowLevelGraphicsContext (hwnd);
+
+		if (direct2DContext != 0 && ! direct2DContext->isValid())
+		{
+			currentRenderingEngine = softwareRenderingEngine;
+			direct2DContext = 0;
+		}
 	}
    #endif
 
@@ -256806,16 +258101,25 @@ bool AudioCDBurner::addAudioTrack (AudioSource* audioSource, int numSamples)
 // compiled on its own).
 #if JUCE_INCLUDED_FILE
 
-class MidiInCollector
+/*  The winmm callback only copies what arrives into a lock-free ring, together with the
+	driver's timestamp, and gives a long-message buffer straight back to the driver. The
+	headers are prepared once in start(), so recycling one is just midiInAddBuffer() and a
+	large dump never waits while buffers are re-prepared. A high-priority thread takes the
+	messages out of the ring and passes them on to the MidiInputCallback.
+*/
+class MidiInCollector  : public Thread
 {
 public:
 
 	MidiInCollector (MidiInput* const input_,
 					 MidiInputCallback& callback_)
-		: deviceHandle (0),
+		: Thread ("Juce MIDI Input"),
+		  deviceHandle (0),
 		  input (input_),
 		  callback (callback_),
 		  concatenator (4096),
+		  fifo (ringSize),
+		  ring (ringSize),
 		  isStarted (false),
 		  startTime (0)
 	{
@@ -256841,18 +258145,18 @@ public:
 	void handleMessage (const uint32 message, const uint32 timeStamp)
 	{
 		if ((message & 0xff) >= 0x80 && isStarted)
-		{
-			concatenator.pushMidiData (&message, 3, convertTimeStamp (timeStamp), input, callback);
-			writeFinishedBlocks();
-		}
+			pushToRing (&message, 3, timeStamp, false);
 	}
 
-	void handleSysEx (MIDIHDR* const hdr, const uint32 timeStamp)
+	void handleSysEx (MIDIHDR* const hdr, const uint32 timeStamp, const bool isValid)
 	{
-		if (isStarted && hdr->dwBytesRecorded > 0)
+		if (isStarted)
 		{
-			concatenator.pushMidiData (hdr->lpData, hdr->dwBytesRecorded, convertTimeStamp (timeStamp), input, callback);
-			writeFinishedBlocks();
+			if (isValid && hdr->dwBytesRecorded > 0)
+				pushToRing (hdr->lpData, (int) hdr->dwBytesRecorded, timeStamp, true);
+
+			hdr->dwBytesRecorded = 0;
+			midiInAddBuffer (deviceHandle, hdr, sizeof (MIDIHDR));
 		}
 	}
 
@@ -256863,19 +258167,24 @@ public:
 		{
 			activeMidiCollectors.addIfNotAlreadyThere (this);
 
+			fifo.reset();
+			concatenator.reset();
+
 			for (int i = 0; i < (int) numHeaders; ++i)
 				headers[i].write (deviceHandle);
 
 			startTime = Time::getMillisecondCounter();
+			startThread (9);
+
 			MMRESULT res = midiInStart (deviceHandle);
 
 			if (res == MMSYSERR_NOERROR)
 			{
-				concatenator.reset();
 				isStarted = true;
 			}
 			else
 			{
+				stopThread (2000);
 				unprepareAllHeaders();
 			}
 		}
@@ -256889,11 +258198,45 @@ public:
 			midiInReset (deviceHandle);
 			midiInStop (deviceHandle);
 			activeMidiCollectors.removeValue (this);
+			stopThread (2000);
 			unprepareAllHeaders();
 			concatenator.reset();
 		}
 	}
 
+	void run()
+	{
+		HeapBlock <uint8> data (maxRecordSize);
+
+		while (! threadShouldExit())
+		{
+			wait (500);
+
+			uint32 timeStamp;
+			int numBytes;
+			bool isSysEx;
+
+			while (popFromRing (data, numBytes, timeStamp, isSysEx))
+			{
+				const double time = convertTimeStamp (timeStamp);
+
+				if (isSysEx)
+				{
+					concatenator.pushMidiData (data, numBytes, time, input, callback);
+				}
+				else
+				{
+					// a short message is always complete, so it mustn't end up in the middle of a pending sysex
+					int used = 0;
+					const MidiMessage message (data, numBytes, used, 0, time);
+
+					if (used > 0)
+						callback.handleIncomingMidiMessage (input, message);
+				}
+			}
+		}
+	}
+
 	static void CALLBACK midiInCallback (HMIDIIN, UINT uMsg, DWORD_PTR dwInstance, DWORD_PTR midiMessage, DWORD_PTR timeStamp)
 	{
 		MidiInCollector* const collector = reinterpret_cast <MidiInCollector*> (dwInstance);
@@ -256902,8 +258245,8 @@ public:
 		{
 			if (uMsg == MIM_DATA)
 				collector->handleMessage ((uint32) midiMessage, (uint32) timeStamp);
-			else if (uMsg == MIM_LONGDATA)
-				collector->handleSysEx ((MIDIHDR*) midiMessage, (uint32) timeStamp);
+			else if (uMsg == MIM_LONGDATA || uMsg == MIM_LONGERROR)
+				collector->handleSysEx ((MIDIHDR*) midiMessage, (uint32) timeStamp, uMsg == MIM_LONGDATA);
 		}
 	}
 
@@ -256935,16 +258278,6 @@ private:
 			res = midiInAddBuffer (deviceHandle, &hdr, sizeof (hdr));
 		}
 
-		void writeIfFinished (HMIDIIN deviceHandle)
-		{
-			if ((hdr.dwFlags & WHDR_DONE) != 0)
-			{
-				MMRESULT res = midiInUnprepareHeader (deviceHandle, &hdr, sizeof (hdr));
-				(void) res;
-				write (deviceHandle);
-			}
-		}
-
 		void unprepare (HMIDIIN deviceHandle)
 		{
 			if ((hdr.dwFlags & WHDR_DONE) != 0)
@@ -256959,7 +258292,7 @@ private:
 
 	private:
 		MIDIHDR hdr;
-		char data [256];
+		char data [1024];
 
 		JUCE_DECLARE_NON_COPYABLE (MidiHeader);
 	};
@@ -256967,10 +258300,65 @@ private:
 	enum { numHeaders = 32 };
 	MidiHeader headers [numHeaders];
 
-	void writeFinishedBlocks()
+	/*  Each record in the ring is the driver's timestamp, the number of bytes and whether
+		they came in a sysex buffer, followed by the bytes. A record is only made visible when all of it has
+		been written, the callback is the only writer and run() the only reader.
+	*/
+	enum { ringSize = 256 * 1024,
+		   recordHeaderSize = 3 * sizeof (uint32),
+		   maxRecordSize = recordHeaderSize + 1024 };
+
+	AbstractFifo fifo;
+	HeapBlock <uint8> ring;
+
+	void pushToRing (const void* const data, const int numBytes, const uint32 timeStamp, const bool isSysEx)
 	{
-		for (int i = 0; i < (int) numHeaders; ++i)
-			headers[i].writeIfFinished (deviceHandle);
+		const int recordSize = (int) recordHeaderSize + numBytes;
+		jassert (recordSize <= (int) maxRecordSize);
+
+		if (fifo.getFreeSpace() < recordSize)
+		{
+			jassertfalse; // the input thread isn't keeping up..
+			return;
+		}
+
+		uint8 record [maxRecordSize];
+		const uint32 header[] = { timeStamp, (uint32) numBytes, isSysEx ? 1u : 0u };
+		memcpy (record, header, recordHeaderSize);
+		memcpy (record + recordHeaderSize, data, (size_t) numBytes);
+
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite (recordSize, start1, size1, start2, size2);
+		memcpy (ring + start1, record, (size_t) size1);
+		memcpy (ring + start2, record + size1, (size_t) size2);
+		fifo.finishedWrite (size1 + size2);
+
+		notify();
+	}
+
+	bool popFromRing (uint8* const data, int& numBytes, uint32& timeStamp, bool& isSysEx)
+	{
+		if (fifo.getNumReady() < (int) recordHeaderSize)
+			return false;
+
+		uint32 header[3];
+		copyFromRing (header, recordHeaderSize);
+		timeStamp = header[0];
+		numBytes = (int) header[1];
+		isSysEx = header[2] != 0;
+
+		copyFromRing (data, recordHeaderSize + numBytes);
+		memmove (data, data + recordHeaderSize, (size_t) numBytes);
+		fifo.finishedRead ((int) recordHeaderSize + numBytes);
+		return true;
+	}
+
+	void copyFromRing (void* const dest, const int numBytes)
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToRead (numBytes, start1, size1, start2, size2);
+		memcpy (dest, ring + start1, (size_t) size1);
+		memcpy (static_cast <uint8*> (dest) + size1, ring + start2, (size_t) size2);
 	}
 
 	void unprepareAllHeaders()
@@ -257097,7 +258485,146 @@ struct MidiOutHandle
 
 	static Array<MidiOutHandle*> activeHandles;
 
+	//==============================================================================
+	/* Long messages are copied into one of a few prepared headers which are reused once
+	   the driver has finished with them, so sending returns without waiting for the data
+	   to be played.
+	*/
+	void sendLongMessage (const void* const data, const int numBytes)
+	{
+		const ScopedLock sl (longMessageLock);
+
+		LongMessageHeader* const h = getFreeHeader();
+
+		if (h == nullptr)
+		{
+			jassertfalse; // the driver isn't returning any buffers..
+			return;
+		}
+
+		if (h->allocatedSize < numBytes)
+		{
+			h->unprepare (handle);
+			h->data.malloc ((size_t) numBytes);
+			h->allocatedSize = numBytes;
+		}
+
+		if (! h->prepare (handle))
+			return;
+
+		memcpy (h->data, data, (size_t) numBytes);
+		h->header.dwBufferLength = (DWORD) numBytes;
+		h->header.dwBytesRecorded = (DWORD) numBytes;
+
+		h->inFlight = (midiOutLongMsg (handle, &(h->header), sizeof (MIDIHDR)) == MMSYSERR_NOERROR);
+	}
+
+	/* Has to be called before the handle is closed. */
+	void releaseLongMessageHeaders()
+	{
+		const ScopedLock sl (longMessageLock);
+
+		for (int i = longMessageHeaders.size(); --i >= 0;)
+		{
+			LongMessageHeader* const h = longMessageHeaders.getUnchecked(i);
+
+			int count = 500; // 1 sec timeout
+
+			while (! h->isFree() && --count >= 0)
+				Sleep (2);
+
+			if (! h->isFree())
+				midiOutReset (handle);
+
+			h->unprepare (handle);
+		}
+
+		longMessageHeaders.clear();
+	}
+
 private:
+	struct LongMessageHeader
+	{
+		LongMessageHeader() : allocatedSize (0), prepared (false), inFlight (false)
+		{
+			zerostruct (header);
+		}
+
+		bool isFree() const noexcept
+		{
+			return (! inFlight) || (header.dwFlags & MHDR_DONE) != 0;
+		}
+
+		bool prepare (HMIDIOUT handle)
+		{
+			if (! prepared)
+			{
+				zerostruct (header);
+				header.lpData = data;
+				header.dwBufferLength = (DWORD) allocatedSize;
+
+				prepared = (midiOutPrepareHeader (handle, &header, sizeof (MIDIHDR)) == MMSYSERR_NOERROR);
+			}
+
+			return prepared;
+		}
+
+		void unprepare (HMIDIOUT handle)
+		{
+			if (prepared)
+			{
+				int count = 500;
+
+				while (midiOutUnprepareHeader (handle, &header, sizeof (MIDIHDR)) == MIDIERR_STILLPLAYING
+						&& --count >= 0)
+					Sleep (2);
+
+				prepared = false;
+				inFlight = false;
+			}
+		}
+
+		MIDIHDR header;
+		HeapBlock <char> data;
+		int allocatedSize;
+		bool prepared, inFlight;
+	};
+
+	enum { maxLongMessageHeaders = 8 };
+
+	LongMessageHeader* getFreeHeader()
+	{
+		for (int i = 0; i < longMessageHeaders.size(); ++i)
+			if (longMessageHeaders.getUnchecked(i)->isFree())
+				return longMessageHeaders.getUnchecked(i);
+
+		if (longMessageHeaders.size() < maxLongMessageHeaders)
+		{
+			LongMessageHeader* const h = new LongMessageHeader();
+			longMessageHeaders.add (h);
+			return h;
+		}
+
+		// all buffers are busy, wait for the oldest one
+		LongMessageHeader* const oldest = longMessageHeaders.getUnchecked(0);
+		int count = 500; // 1 sec timeout
+
+		while (! oldest->isFree())
+		{
+			if (--count < 0)
+				return nullptr;
+
+			Sleep (2);
+		}
+
+		// keep the headers in the order they were sent
+		longMessageHeaders.move (0, -1);
+		return oldest;
+	}
+
+	OwnedArray <LongMessageHeader> longMessageHeaders;
+	CriticalSection longMessageLock;
+
 	JUCE_LEAK_DETECTOR (MidiOutHandle);
 };
 
@@ -257219,6 +258746,7 @@ MidiOutput::~MidiOutput()
 
 	if (MidiOutHandle::activeHandles.contains (h) && --(h->refCount) == 0)
 	{
+		h->releaseLongMessageHeaders();
 		midiOutClose (h->handle);
 		MidiOutHandle::activeHandles.removeValue (h);
 		delete h;
@@ -257227,39 +258755,12 @@ MidiOutput::~MidiOutput()
 
 void MidiOutput::sendMessageNow (const MidiMessage& message)
 {
-	const MidiOutHandle* const handle = static_cast <const MidiOutHandle*> (internal);
+	MidiOutHandle* const handle = static_cast <MidiOutHandle*> (internal);
 
 	if (message.getRawDataSize() > 3
 		 || message.isSysEx())
 	{
-		MIDIHDR h = { 0 };
-
-		h.lpData = (char*) message.getRawData();
-		h.dwBufferLength = message.getRawDataSize();
-		h.dwBytesRecorded = message.getRawDataSize();
-
-		if (midiOutPrepareHeader (handle->handle, &h, sizeof (MIDIHDR)) == MMSYSERR_NOERROR)
-		{
-			MMRESULT res = midiOutLongMsg (handle->handle, &h, sizeof (MIDIHDR));
-
-			if (res == MMSYSERR_NOERROR)
-			{
-				while ((h.dwFlags & MHDR_DONE) == 0)
-					Sleep (1);
-
-				int count = 500; // 1 sec timeout
-
-				while (--count >= 0)
-				{
-					res = midiOutUnprepareHeader (handle->handle, &h, sizeof (MIDIHDR));
-
-					if (res == MIDIERR_STILLPLAYING)
-						Sleep (2);
-					else
-						break;
-				}
-			}
-		}
+		handle->sendLongMessage (message.getRawData(), message.getRawDataSize());
 	}
 	else
 	{
@@ -257268,6 +258769,28 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
 	}
 }
 
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+	midiOutShortMsg (static_cast <MidiOutHandle*> (internal)->handle, packedMessage);
+}
+
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+	if (numMessages == 1)
+	{
+		sendMessageNow (*messages[0]);
+		return;
+	}
+
+	// the whole run goes to the driver as one long buffer instead of a call per message
+	MemoryBlock data;
+
+	for (int i = 0; i < numMessages; ++i)
+		data.append (messages[i]->getRawData(), (size_t) messages[i]->getRawDataSize());
+
+	static_cast <MidiOutHandle*> (internal)->sendLongMessage (data.getData(), (int) data.getSize());
+}
+
 #endif
 
 /*** End of inlined file: juce_win32_Midi.cpp ***/
@@ -260376,6 +261899,10 @@ AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_DirectSound()
  #define WASAPI_ENABLE_LOGGING 0
 #endif
 
+#ifndef AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED
+ #define AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED  MAKE_HRESULT (SEVERITY_ERROR, 0x889, 0x019)
+#endif
+
 namespace WasapiClasses
 {
 
@@ -260415,6 +261942,7 @@ void logFailure (HRESULT hr)
 			case AUDCLNT_E_EVENTHANDLE_NOT_SET:             e << "AUDCLNT_E_EVENTHANDLE_NOT_SET"; break;
 			case AUDCLNT_E_INCORRECT_BUFFER_SIZE:           e << "AUDCLNT_E_INCORRECT_BUFFER_SIZE"; break;
 			case AUDCLNT_E_BUFFER_SIZE_ERROR:               e << "AUDCLNT_E_BUFFER_SIZE_ERROR"; break;
+			case AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED:         e << "AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED"; break;
 			case AUDCLNT_S_BUFFER_EMPTY:                    e << "AUDCLNT_S_BUFFER_EMPTY"; break;
 			case AUDCLNT_S_THREAD_ALREADY_REGISTERED:       e << "AUDCLNT_S_THREAD_ALREADY_REGISTERED"; break;
 			default:					e << String::toHexString ((int) hr); break;
@@ -260463,6 +261991,11 @@ int refTimeToSamples (const REFERENCE_TIME& t, const double sampleRate) noexcept
 	return roundDoubleToInt (sampleRate * ((double) t) * 0.0000001);
 }
 
+REFERENCE_TIME samplesToRefTime (const int numSamples, const double sampleRate) noexcept
+{
+	return (REFERENCE_TIME) ((numSamples * 10000.0 * 1000.0 / sampleRate) + 0.5);
+}
+
 void copyWavFormat (WAVEFORMATEXTENSIBLE& dest, const WAVEFORMATEX* const src) noexcept
 {
 	memcpy (&dest, src, src->wFormatTag == WAVE_FORMAT_EXTENSIBLE ? sizeof (WAVEFORMATEXTENSIBLE)
@@ -260482,9 +262015,10 @@ public:
 		  defaultBufferSize (0),
 		  latencySamples (0),
 		  useExclusiveMode (useExclusiveMode_),
+		  requestedBufferSize (0),
 		  sampleRateHasChanged (false)
 	{
-		clientEvent = CreateEvent (0, false, false, _T("JuceWASAPI"));
+		clientEvent = CreateEvent (0, false, false, 0);
 
 		ComSmartPtr <IAudioClient> tempClient (createClient());
 		if (tempClient == nullptr)
@@ -260533,9 +262067,12 @@ public:
 
 	bool isOk() const noexcept	{ return defaultBufferSize > 0 && defaultSampleRate > 0; }
 
-	bool openClient (const double newSampleRate, const BigInteger& newChannels)
+	bool openClient (const double newSampleRate, const BigInteger& newChannels,
+					 const int bufferSizeSamples, const bool exclusive)
 	{
 		sampleRate = newSampleRate;
+		requestedBufferSize = bufferSizeSamples;
+		useExclusiveMode = exclusive;
 		channels = newChannels;
 		channels.setRange (actualNumChannels, channels.getHighestBit() + 1 - actualNumChannels, false);
 		numChannels = channels.getHighestBit() + 1;
@@ -260590,7 +262127,8 @@ public:
 	double sampleRate, defaultSampleRate;
 	int numChannels, actualNumChannels;
 	int minBufferSize, defaultBufferSize, latencySamples;
-	const bool useExclusiveMode;
+	bool useExclusiveMode;
+	int requestedBufferSize;
 	Array <double> rates;
 	HANDLE clientEvent;
 	BigInteger channels;
@@ -260670,6 +262208,9 @@ private:
 
 	bool tryInitialisingWithFormat (const bool useFloat, const int bytesPerSampleToTry)
 	{
+		if (client == nullptr)
+			return false;
+
 		WAVEFORMATEXTENSIBLE format = { 0 };
 
 		if (numChannels <= 2 && bytesPerSampleToTry <= 2)
@@ -260716,13 +262257,34 @@ private:
 
 		REFERENCE_TIME defaultPeriod = 0, minPeriod = 0;
 		if (useExclusiveMode)
+		{
 			check (client->GetDevicePeriod (&defaultPeriod, &minPeriod));
 
-		GUID session;
-		if (hr == S_OK
-			 && check (client->Initialize (useExclusiveMode ? AUDCLNT_SHAREMODE_EXCLUSIVE : AUDCLNT_SHAREMODE_SHARED,
-										   AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-										   defaultPeriod, defaultPeriod, (WAVEFORMATEX*) &format, &session)))
+			// an exclusive stream's period is its buffer, so it's as short as was asked for
+			if (requestedBufferSize > 0)
+				defaultPeriod = jmax (minPeriod, samplesToRefTime (requestedBufferSize, format.Format.nSamplesPerSec));
+		}
+
+		if (hr == S_OK)
+		{
+			hr = initialiseClient (format, defaultPeriod);
+
+			if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+			{
+				// the buffer has to be a whole number of the device's own blocks, so the client is
+				// made again with the size it suggests
+				UINT32 alignedSize = 0;
+
+				if (check (client->GetBufferSize (&alignedSize)))
+				{
+					defaultPeriod = samplesToRefTime ((int) alignedSize, format.Format.nSamplesPerSec);
+					client = createClient();
+					hr = client != nullptr ? initialiseClient (format, defaultPeriod) : E_FAIL;
+				}
+			}
+		}
+
+		if (hr == S_OK)
 		{
 			actualNumChannels = format.Format.nChannels;
 			const bool isFloat = format.Format.wFormatTag == WAVE_FORMAT_EXTENSIBLE && format.SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
@@ -260735,6 +262297,16 @@ private:
 		return false;
 	}
 
+	HRESULT initialiseClient (WAVEFORMATEXTENSIBLE& format, const REFERENCE_TIME period)
+	{
+		GUID session;
+		const HRESULT hr = client->Initialize (useExclusiveMode ? AUDCLNT_SHAREMODE_EXCLUSIVE : AUDCLNT_SHAREMODE_SHARED,
+											   AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+											   period, period, (WAVEFORMATEX*) &format, &session);
+		logFailure (hr);
+		return hr;
+	}
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WASAPIDeviceBase);
 };
 
@@ -260752,12 +262324,13 @@ public:
 		close();
 	}
 
-	bool open (const double newSampleRate, const BigInteger& newChannels)
+	bool open (const double newSampleRate, const BigInteger& newChannels,
+			   const int bufferSizeSamples, const bool exclusive)
 	{
 		reservoirSize = 0;
 		reservoirCapacity = 16384;
 		reservoir.setSize (actualNumChannels * reservoirCapacity * sizeof (float));
-		return openClient (newSampleRate, newChannels)
+		return openClient (newSampleRate, newChannels, bufferSizeSamples, exclusive)
 				&& (numChannels == 0 || check (client->GetService (__uuidof (IAudioCaptureClient),
 																   (void**) captureClient.resetAndGetPointerAddress())));
 	}
@@ -260868,10 +262441,22 @@ public:
 		close();
 	}
 
-	bool open (const double newSampleRate, const BigInteger& newChannels)
+	bool open (const double newSampleRate, const BigInteger& newChannels,
+			   const int bufferSizeSamples, const bool exclusive)
 	{
-		return openClient (newSampleRate, newChannels)
-			&& (numChannels == 0 || check (client->GetService (__uuidof (IAudioRenderClient), (void**) renderClient.resetAndGetPointerAddress())));
+		if (! (openClient (newSampleRate, newChannels, bufferSizeSamples, exclusive)
+				&& (numChannels == 0 || check (client->GetService (__uuidof (IAudioRenderClient), (void**) renderClient.resetAndGetPointerAddress())))))
+			return false;
+
+		// an exclusive stream starts with a buffer of silence queued, so the first period isn't a glitch
+		if (useExclusiveMode && numChannels > 0)
+		{
+			uint8* outputData = nullptr;
+			if (check (renderClient->GetBuffer (actualBufferSize, &outputData)))
+				renderClient->ReleaseBuffer (actualBufferSize, AUDCLNT_BUFFERFLAGS_SILENT);
+		}
+
+		return true;
 	}
 
 	void close()
@@ -260904,20 +262489,34 @@ public:
 
 		while (bufferSize > 0)
 		{
-			UINT32 padding = 0;
-			if (! check (client->GetCurrentPadding (&padding)))
-				return;
-
-			int samplesToDo = useExclusiveMode ? bufferSize
-											   : jmin ((int) (actualBufferSize - padding), bufferSize);
+			int samplesToDo;
 
-			if (samplesToDo <= 0)
+			if (useExclusiveMode)
 			{
+				// the event comes each time the device has taken one of its two buffers, the
+				// next one is then written whole (the callback's buffer size is the device's)
 				if (thread.threadShouldExit()
 					 || WaitForSingleObject (clientEvent, 1000) == WAIT_TIMEOUT)
 					break;
 
-				continue;
+				samplesToDo = jmin ((int) actualBufferSize, bufferSize);
+			}
+			else
+			{
+				UINT32 padding = 0;
+				if (! check (client->GetCurrentPadding (&padding)))
+					return;
+
+				samplesToDo = jmin ((int) (actualBufferSize - padding), bufferSize);
+
+				if (samplesToDo <= 0)
+				{
+					if (thread.threadShouldExit()
+						 || WaitForSingleObject (clientEvent, 1000) == WAIT_TIMEOUT)
+						break;
+
+					continue;
+				}
 			}
 
 			uint8* outputData = nullptr;
@@ -260946,14 +262545,16 @@ class WASAPIAudioIODevice  : public AudioIODevice,
 {
 public:
 	WASAPIAudioIODevice (const String& deviceName,
+						 const String& typeName,
 						 const String& outputDeviceId_,
 						 const String& inputDeviceId_,
 						 const bool useExclusiveMode_)
-		: AudioIODevice (deviceName, "Windows Audio"),
+		: AudioIODevice (deviceName, typeName),
 		  Thread ("Juce WASAPI"),
 		  outputDeviceId (outputDeviceId_),
 		  inputDeviceId (inputDeviceId_),
 		  useExclusiveMode (useExclusiveMode_),
+		  isExclusive (false),
 		  isOpen_ (false),
 		  isStarted (false),
 		  currentBufferSizeSamples (0),
@@ -261065,18 +262666,24 @@ public:
 		currentBufferSizeSamples = bufferSizeSamples <= 0 ? defaultBufferSize : jmax (bufferSizeSamples, minBufferSize);
 		currentSampleRate = sampleRate > 0 ? sampleRate : defaultSampleRate;
 
-		if (inputDevice != nullptr && ! inputDevice->open (currentSampleRate, inputChannels))
+		isExclusive = useExclusiveMode;
+		lastError = openDevices (inputChannels, outputChannels);
+
+		if (lastError.isNotEmpty() && isExclusive)
 		{
-			lastError = "Couldn't open the input device!";
-			return lastError;
+			// another application has the device, or it can't do the format on its own..
+			isExclusive = false;
+			lastError = openDevices (inputChannels, outputChannels);
 		}
 
-		if (outputDevice != nullptr && ! outputDevice->open (currentSampleRate, outputChannels))
-		{
-			close();
-			lastError = "Couldn't open the output device!";
+		if (lastError.isNotEmpty())
 			return lastError;
-		}
+
+		// an exclusive stream is driven by the device's buffers, so the callbacks have their size
+		if (isExclusive && outputDevice != nullptr && outputDevice->numChannels > 0)
+			currentBufferSizeSamples = (int) outputDevice->actualBufferSize;
+		else if (isExclusive && inputDevice != nullptr && inputDevice->numChannels > 0)
+			currentBufferSizeSamples = (int) inputDevice->actualBufferSize;
 
 		if (inputDevice != nullptr)   ResetEvent (inputDevice->clientEvent);
 		if (outputDevice != nullptr)  ResetEvent (outputDevice->clientEvent);
@@ -261236,6 +262843,7 @@ private:
 	ScopedPointer<WASAPIInputDevice> inputDevice;
 	ScopedPointer<WASAPIOutputDevice> outputDevice;
 	const bool useExclusiveMode;
+	bool isExclusive;        // useExclusiveMode, unless the last open() had to fall back to shared mode
 	double defaultSampleRate;
 	int minBufferSize, defaultBufferSize;
 	int latencyIn, latencyOut;
@@ -261250,6 +262858,23 @@ private:
 	AudioIODeviceCallback* callback;
 	CriticalSection startStopLock;
 
+	String openDevices (const BigInteger& inputChannels, const BigInteger& outputChannels)
+	{
+		if (inputDevice != nullptr && ! inputDevice->open (currentSampleRate, inputChannels, currentBufferSizeSamples, isExclusive))
+		{
+			close();
+			return "Couldn't open the input device!";
+		}
+
+		if (outputDevice != nullptr && ! outputDevice->open (currentSampleRate, outputChannels, currentBufferSizeSamples, isExclusive))
+		{
+			close();
+			return "Couldn't open the output device!";
+		}
+
+		return String::empty;
+	}
+
 	bool createDevices()
 	{
 		ComSmartPtr <IMMDeviceEnumerator> enumerator;
@@ -261293,9 +262918,10 @@ class WASAPIAudioIODeviceType  : public AudioIODeviceType,
 								 private DeviceChangeDetector
 {
 public:
-	WASAPIAudioIODeviceType()
-		: AudioIODeviceType ("Windows Audio"),
+	WASAPIAudioIODeviceType (const bool exclusiveMode_)
+		: AudioIODeviceType (exclusiveMode_ ? "Windows Audio (Exclusive Mode)" : "Windows Audio"),
 		  DeviceChangeDetector (L"Windows Audio"),
+		  exclusiveMode (exclusiveMode_),
 		  hasScanned (false)
 	{
 	}
@@ -261342,7 +262968,6 @@ public:
 	{
 		jassert (hasScanned); // need to call scanForDevices() before doing this
 
-		const bool useExclusiveMode = false;
 		ScopedPointer<WASAPIAudioIODevice> device;
 
 		const int outputIndex = outputDeviceNames.indexOf (outputDeviceName);
@@ -261352,9 +262977,10 @@ public:
 		{
 			device = new WASAPIAudioIODevice (outputDeviceName.isNotEmpty() ? outputDeviceName
 																			: inputDeviceName,
+											  getTypeName(),
 											  outputDeviceIds [outputIndex],
 											  inputDeviceIds [inputIndex],
-											  useExclusiveMode);
+											  exclusiveMode);
 
 			if (! device->initialise())
 				device = nullptr;
@@ -261367,6 +262993,7 @@ public:
 	StringArray inputDeviceNames, inputDeviceIds;
 
 private:
+	const bool exclusiveMode;
 	bool hasScanned;
 
 	static String getDefaultEndpoint (IMMDeviceEnumerator* const enumerator, const bool forCapture)
@@ -261479,10 +263106,10 @@ private:
 
 }
 
-AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_WASAPI()
+AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_WASAPI (bool exclusiveMode)
 {
 	if (SystemStats::getOperatingSystemType() >= SystemStats::WinVista)
-		return new WasapiClasses::WASAPIAudioIODeviceType();
+		return new WasapiClasses::WASAPIAudioIODeviceType (exclusiveMode);
 
 	return nullptr;
 }
@@ -263226,13 +264853,27 @@ bool Thread::setThreadPriority (void* handle, int priority)
 	if (pthread_getschedparam ((pthread_t) handle, &policy, &param) != 0)
 		return false;
 
-	policy = priority == 0 ? SCHED_OTHER : SCHED_RR;
+	// only the priorities above normal are realtime, so that a background thread
+	// can't get ahead of the message thread
+	policy = priority > 6 ? SCHED_RR : SCHED_OTHER;
 
 	const int minPriority = sched_get_priority_min (policy);
 	const int maxPriority = sched_get_priority_max (policy);
 
 	param.sched_priority = ((maxPriority - minPriority) * priority) / 10 + minPriority;
-	return pthread_setschedparam ((pthread_t) handle, policy, &param) == 0;
+
+	if (pthread_setschedparam ((pthread_t) handle, policy, &param) != 0)
+		return false;
+
+   #if JUCE_LINUX
+	// SCHED_OTHER has only one priority here, so the nice value of the thread stands in
+	// for it. That can only be set for the calling thread, and going back up below a
+	// nice value of 0 needs the permission of RLIMIT_NICE.
+	if (policy == SCHED_OTHER && pthread_equal ((pthread_t) handle, pthread_self()))
+		return setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), (5 - priority) * 2) == 0;
+   #endif
+
+	return true;
 }
 
 Thread::ThreadID Thread::getCurrentThreadId()
@@ -263543,7 +265184,18 @@ public:
 				{
 					filenameFound = CharPointer_UTF8 (de->d_name);
 
-					updateStatInfoForFile (parentDir + filenameFound, isDir, fileSize, modTime, creationTime, isReadOnly);
+					// the entry already says whether it's a directory, so the file only
+					// needs to be stat'ed for the other attributes, or if it's a link
+					if (fileSize == nullptr && modTime == nullptr && creationTime == nullptr && isReadOnly == nullptr
+						 && de->d_type != DT_UNKNOWN && de->d_type != DT_LNK)
+					{
+						if (isDir != nullptr)
+							*isDir = (de->d_type == DT_DIR);
+					}
+					else
+					{
+						updateStatInfoForEntry (de->d_name, isDir, fileSize, modTime, creationTime, isReadOnly);
+					}
 
 					if (isHidden != nullptr)
 						*isHidden = filenameFound.startsWithChar ('.');
@@ -263560,6 +265212,26 @@ private:
 	String parentDir, wildCard;
 	DIR* dir;
 
+	// the same as updateStatInfoForFile(), but relative to the open directory, so
+	// there's no full path to build and look up for each file
+	void updateStatInfoForEntry (const char* const name, bool* const isDir, int64* const fileSize,
+								 Time* const modTime, Time* const creationTime, bool* const isReadOnly)
+	{
+		if (isDir != nullptr || fileSize != nullptr || modTime != nullptr || creationTime != nullptr)
+		{
+			juce_statStruct info;
+			const bool statOk = fstatat64 (dirfd (dir), name, &info, 0) == 0;
+
+			if (isDir != nullptr)         *isDir        = statOk && ((info.st_mode & S_IFDIR) != 0);
+			if (fileSize != nullptr)      *fileSize     = statOk ? info.st_size : 0;
+			if (modTime != nullptr)       *modTime      = Time (statOk ? (int64) info.st_mtime * 1000 : 0);
+			if (creationTime != nullptr)  *creationTime = Time (statOk ? (int64) info.st_ctime * 1000 : 0);
+		}
+
+		if (isReadOnly != nullptr)
+			*isReadOnly = faccessat (dirfd (dir), name, W_OK, 0) != 0;
+	}
+
 	JUCE_DECLARE_NON_COPYABLE (Pimpl);
 };
 
@@ -270051,6 +271723,20 @@ void* juce_load_jack_function (const char* const name)
 	return dlsym (juce_libjack_handle, name);
 }
 
+/*  Loads libjack if that hasn't been done yet. The unversioned name is only there when
+	the development package is installed, so the runtime library is tried as well.
+*/
+bool juce_load_jack_library()
+{
+	if (juce_libjack_handle == nullptr)
+		juce_libjack_handle = dlopen ("libjack.so", RTLD_LAZY);
+
+	if (juce_libjack_handle == nullptr)
+		juce_libjack_handle = dlopen ("libjack.so.0", RTLD_LAZY);
+
+	return juce_libjack_handle != nullptr;
+}
+
 #define JUCE_DECL_JACK_FUNCTION(return_type, fn_name, argument_types, arguments)  \
   typedef return_type (*fn_name##_ptr_t)argument_types;			   \
   return_type fn_name argument_types {					\
@@ -270087,6 +271773,13 @@ JUCE_DECL_JACK_FUNCTION (int, jack_set_port_connect_callback, (jack_client_t* cl
 JUCE_DECL_JACK_FUNCTION (jack_port_t* , jack_port_by_id, (jack_client_t* client, jack_port_id_t port_id), (client, port_id));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected, (const jack_port_t* port), (port));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected_to, (const jack_port_t* port, const char* port_name), (port, port_name));
+JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_frames_since_cycle_start, (const jack_client_t* client), (client));
+JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_last_frame_time, (const jack_client_t* client), (client));
+JUCE_DECL_JACK_FUNCTION (jack_time_t, jack_frames_to_time, (const jack_client_t* client, jack_nframes_t frames), (client, frames));
+JUCE_DECL_JACK_FUNCTION (uint32_t, jack_midi_get_event_count, (void* port_buffer), (port_buffer));
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_get, (jack_midi_event_t* event, void* port_buffer, uint32_t event_index), (event, port_buffer, event_index));
+JUCE_DECL_VOID_JACK_FUNCTION (jack_midi_clear_buffer, (void* port_buffer), (port_buffer));
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_write, (void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, size_t data_size), (port_buffer, time, data, data_size));
 
 #if JUCE_DEBUG
   #define JACK_LOGGING_ENABLED 1
@@ -270119,6 +271812,429 @@ namespace
   #define JUCE_JACK_CLIENT_NAME "JuceJack"
 #endif
 
+static const char* const jackMidiDeviceName = "JACK MIDI";
+
+/*  A lock-free ring of timestamped MIDI messages between the JACK process callback and
+	one other thread. Each record is the time, in Time::getMillisecondCounterHiRes()
+	milliseconds, the number of bytes and a generation number, followed by the bytes.
+	A record is only made visible when all of it has been written. There is one writer
+	and one reader at a time.
+*/
+class JackMidiRing
+{
+public:
+	JackMidiRing()
+		: fifo (ringSize),
+		  ring (ringSize)
+	{
+	}
+
+	struct Header
+	{
+		double time;
+		int numBytes;
+		int generation;
+	};
+
+	enum { ringSize = 64 * 1024,
+		   maxMessageSize = ringSize / 2 - (int) sizeof (Header) };
+
+	bool push (const void* const data, const int numBytes, const double time, const int generation) noexcept
+	{
+		const int recordSize = (int) sizeof (Header) + numBytes;
+
+		if (numBytes <= 0 || numBytes > (int) maxMessageSize || fifo.getFreeSpace() < recordSize)
+			return false;
+
+		Header header;
+		header.time = time;
+		header.numBytes = numBytes;
+		header.generation = generation;
+
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite (recordSize, start1, size1, start2, size2);
+		copyToRing (start1, size1, start2, 0, &header, sizeof (Header));
+		copyToRing (start1, size1, start2, sizeof (Header), data, numBytes);
+		fifo.finishedWrite (recordSize);
+		return true;
+	}
+
+	/** Reads the header of the oldest record without taking it out of the ring. */
+	bool peek (Header& header) const noexcept
+	{
+		if (fifo.getNumReady() < (int) sizeof (Header))
+			return false;
+
+		copyFromRing (&header, 0, sizeof (Header));
+		return true;
+	}
+
+	/** Copies the bytes of the oldest record, which peek() has returned the header of. */
+	void read (void* const dest, const Header& header) const noexcept
+	{
+		copyFromRing (dest, sizeof (Header), header.numBytes);
+	}
+
+	void discard (const Header& header) noexcept
+	{
+		fifo.finishedRead ((int) sizeof (Header) + header.numBytes);
+	}
+
+private:
+	AbstractFifo fifo;
+	HeapBlock <uint8> ring;
+
+	// copies to the part of a record that starts offset bytes into it, which may be split between the two blocks
+	void copyToRing (const int start1, const int size1, const int start2, const int offset,
+					 const void* const data, const int numBytes) noexcept
+	{
+		const int first = jlimit (0, numBytes, size1 - offset);
+		memcpy (ring + start1 + offset, data, (size_t) first);
+		memcpy (ring + start2 + jmax (0, offset - size1), static_cast <const uint8*> (data) + first, (size_t) (numBytes - first));
+	}
+
+	void copyFromRing (void* const dest, const int offset, const int numBytes) const noexcept
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToRead (offset + numBytes, start1, size1, start2, size2);
+
+		const int first = jlimit (0, numBytes, size1 - offset);
+		memcpy (dest, ring + start1 + offset, (size_t) first);
+		memcpy (static_cast <uint8*> (dest) + first, ring + start2 + jmax (0, offset - size1), (size_t) (numBytes - first));
+	}
+
+	JUCE_DECLARE_NON_COPYABLE (JackMidiRing);
+};
+
+/*  The MIDI output on the "midi_out" port of the JACK device that is running.
+
+	Nothing is sent from the calling thread: sendMessageNow() and sendBlockOfMessages()
+	only put the messages into a ring together with the time they're meant for, and the
+	device's process callback writes the ones that are due into the port buffer of the
+	cycle, each at the frame that its time falls on. So a block of messages keeps its
+	spacing to the sample, whatever the threads are doing. Like the queue of the
+	background thread, the messages go out in the order of their times and those with
+	the same time in the order they were sent, so a message sent now overtakes a block
+	that is still waiting. One that is late goes out at the start of the next cycle.
+	The port has one output at a time, the one opened last.
+*/
+class JackMidiOutput  : public MidiOutput
+{
+public:
+	JackMidiOutput()
+		: generation (0),
+		  pending (maxPending),
+		  numPending (0),
+		  pendingGeneration (0)
+	{
+		for (int i = 0; i < 2; ++i)
+			arenas[i].malloc (arenaSize);
+
+		arena = arenas[0];
+		arenaUsed = 0;
+
+		const ScopedLock sl (activeLock);
+		activeOutput = this;
+	}
+
+	~JackMidiOutput()
+	{
+		const ScopedLock sl (activeLock);
+
+		if (activeOutput == this)
+			activeOutput = nullptr;
+	}
+
+	void sendMessageNow (const MidiMessage& message)
+	{
+		const ScopedLock sl (writeLock);
+		push (message.getRawData(), message.getRawDataSize(), Time::getMillisecondCounterHiRes());
+	}
+
+	void sendShortMessageNow (const uint32 packedMessage)
+	{
+		const uint8 data[3] = { (uint8) packedMessage, (uint8) (packedMessage >> 8), (uint8) (packedMessage >> 16) };
+
+		const ScopedLock sl (writeLock);
+		push (data, MidiMessage::getMessageLengthFromFirstByte (data[0]), Time::getMillisecondCounterHiRes());
+	}
+
+	void sendBlockOfMessages (const MidiBuffer& buffer,
+							  const double millisecondCounterToStartAt,
+							  double samplesPerSecondForBuffer)
+	{
+		const double timeScaleFactor = 1000.0 / samplesPerSecondForBuffer;
+		const ScopedLock sl (writeLock);
+
+		MidiBuffer::Iterator i (buffer);
+		const uint8* data;
+		int len, time;
+
+		while (i.getNextEvent (data, len, time))
+			push (data, len, millisecondCounterToStartAt + timeScaleFactor * time);
+	}
+
+	void clearAllPendingMessages()
+	{
+		// the process callback skips the messages of an older generation
+		++generation;
+	}
+
+	// the messages are timed by the JACK cycle, so there's no thread to start
+	void startBackgroundThread()    {}
+	void stopBackgroundThread()     { clearAllPendingMessages(); }
+
+	/*  Called from the process callback of the device: takes the new messages out of the
+		ring and writes the ones that are due before the end of the cycle, as long as the
+		port buffer has room for them.
+	*/
+	void writeEvents (void* const portBuffer, const double cycleStart, const double msPerFrame, const int numFrames)
+	{
+		takeFromRing();
+
+		const double cycleEnd = cycleStart + msPerFrame * numFrames;
+		jack_nframes_t lastFrame = 0;
+		int numWritten = 0, numDone = 0;
+
+		for (; numDone < numPending; ++numDone)
+		{
+			const PendingMessage& m = pending [numDone];
+
+			if (m.time >= cycleEnd)
+				break;
+
+			const jack_nframes_t frame = (jack_nframes_t) jlimit (0, numFrames - 1, roundToInt ((m.time - cycleStart) / msPerFrame));
+			lastFrame = jmax (lastFrame, frame);
+
+			if (JUCE_NAMESPACE::jack_midi_event_write (portBuffer, lastFrame, arena + m.offset, (size_t) m.numBytes) == 0)
+				++numWritten;
+			else if (numWritten > 0)
+				break;  // the buffer is full, the rest goes out in the next cycle
+			else
+				jassertfalse; // too big for an empty buffer, so it's dropped
+		}
+
+		removeFirst (numDone);
+	}
+
+	static JackMidiOutput* activeOutput;
+	static CriticalSection activeLock;
+
+private:
+	CriticalSection writeLock;
+	JackMidiRing ring;
+	Atomic <int> generation;
+
+	/*  The messages that have left the ring, in the order they go out in. Their bytes are
+		in one of two arenas, the other one is used to pack them when the arena fills up.
+		Only used by the process callback.
+	*/
+	struct PendingMessage
+	{
+		double time;
+		int offset, numBytes;
+	};
+
+	enum { maxPending = 4096,
+		   arenaSize = JackMidiRing::ringSize };
+
+	HeapBlock <PendingMessage> pending;
+	int numPending, pendingGeneration;
+	HeapBlock <uint8> arenas[2];
+	uint8* arena;
+	int arenaUsed;
+
+	void push (const void* const data, const int numBytes, const double time)
+	{
+		if (! ring.push (data, numBytes, time, generation.get()))
+			jassertfalse; // the JACK device isn't running or is too far behind..
+	}
+
+	void takeFromRing()
+	{
+		const int currentGeneration = generation.get();
+
+		if (pendingGeneration != currentGeneration)
+		{
+			pendingGeneration = currentGeneration;
+			removeFirst (numPending);
+		}
+
+		JackMidiRing::Header header;
+
+		while (ring.peek (header))
+		{
+			if (header.generation == currentGeneration)
+			{
+				if (numPending >= (int) maxPending)
+					break;
+
+				if (arenaUsed + header.numBytes > (int) arenaSize)
+				{
+					packArena();
+
+					if (arenaUsed + header.numBytes > (int) arenaSize)
+						break;
+				}
+
+				// after the ones with the same or an earlier time
+				int index = numPending;
+				while (index > 0 && pending [index - 1].time > header.time)
+					--index;
+
+				memmove (pending + index + 1, pending + index, sizeof (PendingMessage) * (size_t) (numPending - index));
+				pending[index].time = header.time;
+				pending[index].offset = arenaUsed;
+				pending[index].numBytes = header.numBytes;
+				++numPending;
+
+				ring.read (arena + arenaUsed, header);
+				arenaUsed += header.numBytes;
+			}
+
+			ring.discard (header);
+		}
+	}
+
+	void removeFirst (const int num)
+	{
+		numPending -= num;
+		memmove (pending, pending + num, sizeof (PendingMessage) * (size_t) numPending);
+
+		if (numPending == 0)
+			arenaUsed = 0;
+	}
+
+	// copies the bytes of the pending messages to the start of the other arena
+	void packArena()
+	{
+		uint8* const packed = (arena == arenas[0]) ? arenas[1] : arenas[0];
+		int used = 0;
+
+		for (int i = 0; i < numPending; ++i)
+		{
+			memcpy (packed + used, arena + pending[i].offset, (size_t) pending[i].numBytes);
+			pending[i].offset = used;
+			used += pending[i].numBytes;
+		}
+
+		arena = packed;
+		arenaUsed = used;
+	}
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JackMidiOutput);
+};
+
+JackMidiOutput* JackMidiOutput::activeOutput = nullptr;
+CriticalSection JackMidiOutput::activeLock;
+
+/*  The MIDI input from the "midi_in" port of the JACK device that is running. The
+	process callback copies each event into a ring, stamped with the time of its frame,
+	and this thread hands them on to the MidiInputCallback in batches, so the callback
+	never runs on the JACK thread.
+*/
+class JackMidiInput  : public Thread
+{
+public:
+	JackMidiInput (MidiInput* const midiInput_, MidiInputCallback* const callback_)
+		: Thread ("Juce JACK MIDI Input"),
+		  midiInput (midiInput_),
+		  callback (callback_),
+		  isStarted (false)
+	{
+		jassert (callback != nullptr && midiInput != nullptr);
+
+		const ScopedLock sl (JackMidiOutput::activeLock);
+		activeInput = this;
+	}
+
+	~JackMidiInput()
+	{
+		stopThread (3000);
+
+		const ScopedLock sl (JackMidiOutput::activeLock);
+
+		if (activeInput == this)
+			activeInput = nullptr;
+	}
+
+	void run()
+	{
+		const int maxBatchSize = 256;
+		HeapBlock <uint8> data (JackMidiRing::maxMessageSize);
+		Array <MidiMessage> batch;
+		batch.ensureStorageAllocated (maxBatchSize);
+
+		isStarted = true;
+
+		while (! threadShouldExit())
+		{
+			wait (500);
+
+			JackMidiRing::Header header;
+
+			while (ring.peek (header))
+			{
+				ring.read (data, header);
+				batch.add (MidiMessage (data, header.numBytes, header.time * 0.001));
+				ring.discard (header);
+
+				if (batch.size() >= maxBatchSize)
+					deliver (batch);
+			}
+
+			deliver (batch);
+		}
+
+		isStarted = false;
+	}
+
+	/*  Called from the process callback of the device. The events in the port buffer
+		arrived during the cycle before this one, which is where their times are put.
+	*/
+	void readEvents (void* const portBuffer, const double cycleStart, const double msPerFrame, const int numFrames)
+	{
+		if (! isStarted)
+			return;
+
+		const uint32_t numEvents = JUCE_NAMESPACE::jack_midi_get_event_count (portBuffer);
+		const double previousCycleStart = cycleStart - msPerFrame * numFrames;
+
+		for (uint32_t i = 0; i < numEvents; ++i)
+		{
+			jack_midi_event_t event;
+
+			if (JUCE_NAMESPACE::jack_midi_event_get (&event, portBuffer, i) == 0
+				 && ! ring.push (event.buffer, (int) event.size, previousCycleStart + msPerFrame * event.time, 0))
+				break; // the input thread isn't keeping up..
+		}
+
+		if (numEvents > 0)
+			notify();
+	}
+
+	static JackMidiInput* activeInput;
+
+private:
+	MidiInput* const midiInput;
+	MidiInputCallback* const callback;
+	JackMidiRing ring;
+	bool volatile isStarted;
+
+	void deliver (Array <MidiMessage>& batch)
+	{
+		if (batch.size() > 0)
+		{
+			callback->handleIncomingMidiMessages (midiInput, batch.getRawDataPointer(), batch.size());
+			batch.clearQuick();
+		}
+	}
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JackMidiInput);
+};
+
+JackMidiInput* JackMidiInput::activeInput = nullptr;
+
 class JackAudioIODevice   : public AudioIODevice
 {
 public:
@@ -270131,7 +272247,9 @@ public:
 		  isOpen_ (false),
 		  callback (nullptr),
 		  totalNumberOfInputChannels (0),
-		  totalNumberOfOutputChannels (0)
+		  totalNumberOfOutputChannels (0),
+		  midiInputPort (nullptr),
+		  midiOutputPort (nullptr)
 	{
 		jassert (deviceName.isNotEmpty());
 
@@ -270168,6 +272286,10 @@ public:
 																	 JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0));
 			}
 
+			// the MIDI ports, which the JACK MIDI devices use while this device is running
+			midiInputPort = JUCE_NAMESPACE::jack_port_register (client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+			midiOutputPort = JUCE_NAMESPACE::jack_port_register (client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+
 			inChans.calloc (totalNumberOfInputChannels + 2);
 			outChans.calloc (totalNumberOfOutputChannels + 2);
 		}
@@ -270186,7 +272308,7 @@ public:
 	StringArray getChannelNames (bool forInput) const
 	{
 		StringArray names;
-		const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */
+		const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */
 																   forInput ? JackPortIsInput : JackPortIsOutput);
 
 		if (ports != 0)
@@ -270233,7 +272355,7 @@ public:
 
 		if (! inputChannels.isZero())
 		{
-			const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsOutput);
+			const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsOutput);
 
 			if (ports != 0)
 			{
@@ -270257,7 +272379,7 @@ public:
 
 		if (! outputChannels.isZero())
 		{
-			const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsInput);
+			const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsInput);
 
 			if (ports != 0)
 			{
@@ -270374,6 +272496,8 @@ public:
 private:
 	void process (const int numSamples)
 	{
+		processMidi (numSamples);
+
 		int i, numActiveInChans = 0, numActiveOutChans = 0;
 
 		for (i = 0; i < totalNumberOfInputChannels; ++i)
@@ -270408,6 +272532,48 @@ private:
 		}
 	}
 
+	/*  Passes the MIDI of this cycle between the ports and the JACK MIDI devices. The
+		times are converted with the start of the cycle on the millisecond counter, so a
+		message lands on the frame its timestamp falls on.
+	*/
+	void processMidi (const int numSamples)
+	{
+		void* const outputBuffer = midiOutputPort != nullptr ? JUCE_NAMESPACE::jack_port_get_buffer (midiOutputPort, numSamples) : nullptr;
+		void* const inputBuffer = midiInputPort != nullptr ? JUCE_NAMESPACE::jack_port_get_buffer (midiInputPort, numSamples) : nullptr;
+
+		if (outputBuffer != nullptr)
+			JUCE_NAMESPACE::jack_midi_clear_buffer (outputBuffer);
+
+		const double msPerFrame = 1000.0 / JUCE_NAMESPACE::jack_get_sample_rate (client);
+		const double cycleStart = getCycleStart (msPerFrame, numSamples);
+
+		// a device that is being opened or closed just misses this cycle
+		const ScopedTryLock sl (JackMidiOutput::activeLock);
+
+		if (sl.isLocked())
+		{
+			if (outputBuffer != nullptr && JackMidiOutput::activeOutput != nullptr)
+				JackMidiOutput::activeOutput->writeEvents (outputBuffer, cycleStart, msPerFrame, numSamples);
+
+			if (inputBuffer != nullptr && JackMidiInput::activeInput != nullptr)
+				JackMidiInput::activeInput->readEvents (inputBuffer, cycleStart, msPerFrame, numSamples);
+		}
+	}
+
+	/*  The time the cycle started at, in milliseconds. JACK's own estimate doesn't move
+		with the jitter of the thread waking up, so it's used if its clock is the same as
+		the one of Time::getMillisecondCounterHiRes(), which it normally is on Linux.
+	*/
+	double getCycleStart (const double msPerFrame, const int numSamples) const
+	{
+		const double wokenAt = Time::getMillisecondCounterHiRes()
+								 - msPerFrame * JUCE_NAMESPACE::jack_frames_since_cycle_start (client);
+
+		const double jackCycleStart = 0.001 * (double) JUCE_NAMESPACE::jack_frames_to_time (client, JUCE_NAMESPACE::jack_last_frame_time (client));
+
+		return std::abs (jackCycleStart - wokenAt) < msPerFrame * numSamples ? jackCycleStart : wokenAt;
+	}
+
 	static int processCallback (jack_nframes_t nframes, void* callbackArgument)
 	{
 		if (callbackArgument != 0)
@@ -270449,6 +272615,8 @@ private:
 	int totalNumberOfInputChannels;
 	int totalNumberOfOutputChannels;
 	Array<void*> inputPorts, outputPorts;
+	jack_port_t* midiInputPort;
+	jack_port_t* midiOutputPort;
 };
 
 class JackAudioIODeviceType  : public AudioIODeviceType
@@ -270469,13 +272637,8 @@ public:
 		outputNames.clear();
 		outputIds.clear();
 
-		if (juce_libjack_handle == 0)
-		{
-			juce_libjack_handle = dlopen ("libjack.so", RTLD_LAZY);
-
-			if (juce_libjack_handle == 0)
-				return;
-		}
+		if (! juce_load_jack_library())
+			return;
 
 		// open a dummy client
 		jack_status_t status;
@@ -270488,7 +272651,7 @@ public:
 		else
 		{
 			// scan for output devices
-			const char** ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsOutput);
+			const char** ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsOutput);
 
 			if (ports != 0)
 			{
@@ -270512,7 +272675,7 @@ public:
 			}
 
 			// scan for input devices
-			ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsInput);
+			ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsInput);
 
 			if (ports != 0)
 			{
@@ -270608,6 +272771,55 @@ AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_JACK()
 
 namespace
 {
+	const char* const midiInputQueueName = "Juce Midi Input Queue";
+
+	/*  Subscribes an input port to a source through a queue that stamps each event with
+		its real time, so the input thread can tell when it arrived instead of when the
+		thread got round to reading it. If the queue can't be made, the port is connected
+		without timestamps.
+	*/
+	void connectInputPort (snd_seq_t* seqHandle, const int portId, const int sourceClient, const int sourcePort)
+	{
+		const int queue = snd_seq_alloc_named_queue (seqHandle, midiInputQueueName);
+
+		if (queue >= 0)
+		{
+			snd_seq_port_subscribe_t* subscription = nullptr;
+
+			if (snd_seq_port_subscribe_malloc (&subscription) == 0)
+			{
+				snd_seq_addr_t sender, dest;
+				sender.client = (unsigned char) sourceClient;
+				sender.port = (unsigned char) sourcePort;
+				dest.client = (unsigned char) snd_seq_client_id (seqHandle);
+				dest.port = (unsigned char) portId;
+
+				snd_seq_port_subscribe_set_sender (subscription, &sender);
+				snd_seq_port_subscribe_set_dest (subscription, &dest);
+				snd_seq_port_subscribe_set_queue (subscription, queue);
+				snd_seq_port_subscribe_set_time_update (subscription, 1);
+				snd_seq_port_subscribe_set_time_real (subscription, 1);
+
+				const bool subscribed = snd_seq_subscribe_port (seqHandle, subscription) == 0;
+				const bool started = subscribed
+									  && snd_seq_start_queue (seqHandle, queue, nullptr) >= 0
+									  && snd_seq_drain_output (seqHandle) >= 0;
+
+				if (subscribed && ! started)
+					snd_seq_unsubscribe_port (seqHandle, subscription);
+
+				snd_seq_port_subscribe_free (subscription);
+
+				if (started)
+					return;
+			}
+
+			snd_seq_free_queue (seqHandle, queue);
+		}
+
+		snd_seq_connect_from (seqHandle, portId, sourceClient, sourcePort);
+	}
+
 	snd_seq_t* iterateMidiDevices (const bool forInput,
 								   StringArray& deviceNamesFound,
 								   const int deviceIndexToOpen)
@@ -270615,7 +272827,8 @@ namespace
 		snd_seq_t* returnedHandle = nullptr;
 		snd_seq_t* seqHandle = nullptr;
 
-		if (snd_seq_open (&seqHandle, "default", forInput ? SND_SEQ_OPEN_INPUT
+		// an input also writes, to start the queue that stamps its events
+		if (snd_seq_open (&seqHandle, "default", forInput ? SND_SEQ_OPEN_DUPLEX
 														  : SND_SEQ_OPEN_OUTPUT, 0) == 0)
 		{
 			snd_seq_system_info_t* systemInfo = nullptr;
@@ -270665,7 +272878,7 @@ namespace
 																								   SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
 																								   SND_SEQ_PORT_TYPE_MIDI_GENERIC);
 
-													snd_seq_connect_from (seqHandle, portId, sourceClient, sourcePort);
+													connectInputPort (seqHandle, portId, sourceClient, sourcePort);
 												}
 												else
 												{
@@ -270756,9 +272969,33 @@ public:
 
 	void sendMessageNow (const MidiMessage& message)
 	{
-		if (message.getRawDataSize() > maxEventSize)
+		outputEvent (message.getRawData(), message.getRawDataSize());
+		snd_seq_drain_output (seqHandle);
+	}
+
+	void sendShortMessageNow (const uint32 packedMessage)
+	{
+		const uint8 data[3] = { (uint8) packedMessage, (uint8) (packedMessage >> 8), (uint8) (packedMessage >> 16) };
+
+		outputEvent (data, MidiMessage::getMessageLengthFromFirstByte (data[0]));
+		snd_seq_drain_output (seqHandle);
+	}
+
+	// queues all events in the sequencer's output buffer and drains it once
+	void sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+	{
+		for (int i = 0; i < numMessages; ++i)
+			outputEvent (messages[i]->getRawData(), messages[i]->getRawDataSize());
+
+		snd_seq_drain_output (seqHandle);
+	}
+
+private:
+	void outputEvent (const uint8* const data, const int numBytes)
+	{
+		if (numBytes > maxEventSize)
 		{
-			maxEventSize = message.getRawDataSize();
+			maxEventSize = numBytes;
 			snd_midi_event_free (midiParser);
 			snd_midi_event_new (maxEventSize, &midiParser);
 		}
@@ -270766,10 +273003,7 @@ public:
 		snd_seq_event_t event;
 		snd_seq_ev_clear (&event);
 
-		snd_midi_event_encode (midiParser,
-							   message.getRawData(),
-							   message.getRawDataSize(),
-							   &event);
+		snd_midi_event_encode (midiParser, data, numBytes, &event);
 
 		snd_midi_event_reset_encode (midiParser);
 
@@ -270777,11 +273011,10 @@ public:
 		snd_seq_ev_set_subs (&event);
 		snd_seq_ev_set_direct (&event);
 
+		// this only writes into the output buffer, which is flushed by itself when it's full
 		snd_seq_event_output (seqHandle, &event);
-		snd_seq_drain_output (seqHandle);
 	}
 
-private:
 	MidiOutput* const midiOutput;
 	snd_seq_t* const seqHandle;
 	snd_midi_event_t* midiParser;
@@ -270794,6 +273027,13 @@ StringArray MidiOutput::getDevices()
 {
 	StringArray devices;
 	iterateMidiDevices (false, devices, -1);
+
+   #if JUCE_JACK
+	// the JACK MIDI device comes after the ALSA ones
+	if (juce_load_jack_library())
+		devices.add (jackMidiDeviceName);
+   #endif
+
 	return devices;
 }
 
@@ -270814,6 +273054,12 @@ MidiOutput* MidiOutput::openDevice (int deviceIndex)
 		newDevice = new MidiOutput();
 		newDevice->internal = new MidiOutputDevice (newDevice, handle);
 	}
+   #if JUCE_JACK
+	else if (deviceIndex == devices.size() && juce_load_jack_library())
+	{
+		newDevice = new JackMidiOutput();
+	}
+   #endif
 
 	return newDevice;
 }
@@ -270843,6 +273089,16 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
 	static_cast <MidiOutputDevice*> (internal)->sendMessageNow (message);
 }
 
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+	static_cast <MidiOutputDevice*> (internal)->sendShortMessageNow (packedMessage);
+}
+
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+	static_cast <MidiOutputDevice*> (internal)->sendMessagesNow (messages, numMessages);
+}
+
 class MidiInputThread   : public Thread
 {
 public:
@@ -270852,7 +273108,8 @@ public:
 		: Thread ("Juce MIDI Input"),
 		  midiInput (midiInput_),
 		  seqHandle (seqHandle_),
-		  callback (callback_)
+		  callback (callback_),
+		  queue (snd_seq_query_named_queue (seqHandle_, midiInputQueueName))
 	{
 		jassert (seqHandle != 0 && callback != 0 && midiInput != 0);
 	}
@@ -270865,60 +273122,113 @@ public:
 	void run()
 	{
 		const int maxEventSize = 16 * 1024;
-		snd_midi_event_t* midiParser;
+		const int maxBatchSize = 256;
+		snd_midi_event_t* midiParser = nullptr;
+		snd_seq_queue_status_t* queueStatus = nullptr;
 
-		if (snd_midi_event_new (maxEventSize, &midiParser) >= 0)
+		if (snd_midi_event_new (maxEventSize, &midiParser) >= 0
+			 && snd_seq_queue_status_malloc (&queueStatus) == 0)
 		{
 			HeapBlock <uint8> buffer (maxEventSize);
+			Array <MidiMessage> batch;
+			batch.ensureStorageAllocated (maxBatchSize);
 
 			const int numPfds = snd_seq_poll_descriptors_count (seqHandle, POLLIN);
 			struct pollfd* const pfd = (struct pollfd*) alloca (numPfds * sizeof (struct pollfd));
 
 			snd_seq_poll_descriptors (seqHandle, pfd, numPfds, POLLIN);
+			snd_seq_nonblock (seqHandle, 1);
 
 			while (! threadShouldExit())
 			{
 				if (poll (pfd, numPfds, 500) > 0)
 				{
-					snd_seq_event_t* inputEvent = nullptr;
+					// everything that has arrived is read now and handed on as one batch
+					double readTime, queueOffset;
+					const bool hasQueueTime = getQueueOffset (queueStatus, readTime, queueOffset);
 
-					snd_seq_nonblock (seqHandle, 1);
+					snd_seq_event_t* inputEvent = nullptr;
 
-					do
+					while (snd_seq_event_input (seqHandle, &inputEvent) >= 0)
 					{
-						if (snd_seq_event_input (seqHandle, &inputEvent) >= 0)
-						{
-							// xxx what about SYSEXes that are too big for the buffer?
-							const int numBytes = snd_midi_event_decode (midiParser, buffer, maxEventSize, inputEvent);
+						if (inputEvent == nullptr)
+							continue;
 
-							snd_midi_event_reset_decode (midiParser);
+						// xxx what about SYSEXes that are too big for the buffer?
+						const int numBytes = snd_midi_event_decode (midiParser, buffer, maxEventSize, inputEvent);
 
-							if (numBytes > 0)
-							{
-								const MidiMessage message ((const uint8*) buffer,
-														   numBytes,
-														   Time::getMillisecondCounter() * 0.001);
+						snd_midi_event_reset_decode (midiParser);
 
-								callback->handleIncomingMidiMessage (midiInput, message);
-							}
+						if (numBytes > 0)
+						{
+							batch.add (MidiMessage ((const uint8*) buffer, numBytes,
+													hasQueueTime ? getTimeStamp (*inputEvent, readTime, queueOffset)
+																 : readTime));
 
-							snd_seq_free_event (inputEvent);
+							if (batch.size() >= maxBatchSize)
+								deliver (batch);
 						}
+
+						snd_seq_free_event (inputEvent);
 					}
-					while (snd_seq_event_input_pending (seqHandle, 0) > 0);
 
-					snd_seq_free_event (inputEvent);
+					deliver (batch);
 				}
 			}
+		}
 
+		if (queueStatus != nullptr)
+			snd_seq_queue_status_free (queueStatus);
+
+		if (midiParser != nullptr)
 			snd_midi_event_free (midiParser);
-		}
 	};
 
 private:
 	MidiInput* const midiInput;
 	snd_seq_t* const seqHandle;
 	MidiInputCallback* const callback;
+	const int queue;    // the queue that stamps the events, or negative if the port isn't subscribed through one
+
+	/*  Reads the real time of the queue together with the monotonic clock that the
+		message timestamps use (Time::getMillisecondCounterHiRes()), and returns the
+		difference between the two. False if the input has no queue.
+	*/
+	bool getQueueOffset (snd_seq_queue_status_t* queueStatus, double& readTime, double& queueOffset) const
+	{
+		if (queue >= 0 && snd_seq_get_queue_status (seqHandle, queue, queueStatus) == 0)
+		{
+			readTime = Time::getMillisecondCounterHiRes() * 0.001;
+
+			const snd_seq_real_time_t* const queueTime = snd_seq_queue_status_get_real_time (queueStatus);
+			queueOffset = readTime - (queueTime->tv_sec + queueTime->tv_nsec * 1.0e-9);
+			return true;
+		}
+
+		readTime = Time::getMillisecondCounterHiRes() * 0.001;
+		queueOffset = 0;
+		return false;
+	}
+
+	/*  The time an event arrived. Events that came in another way than through the
+		queue get the time they were read.
+	*/
+	double getTimeStamp (const snd_seq_event_t& event, const double readTime, const double queueOffset) const
+	{
+		if ((event.flags & SND_SEQ_TIME_STAMP_MASK) != SND_SEQ_TIME_STAMP_REAL || event.queue != queue)
+			return readTime;
+
+		return jmin (readTime, queueOffset + event.time.time.tv_sec + event.time.time.tv_nsec * 1.0e-9);
+	}
+
+	void deliver (Array <MidiMessage>& batch)
+	{
+		if (batch.size() > 0)
+		{
+			callback->handleIncomingMidiMessages (midiInput, batch.getRawDataPointer(), batch.size());
+			batch.clearQuick();
+		}
+	}
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiInputThread);
 };
@@ -270929,20 +273239,22 @@ MidiInput::MidiInput (const String& name_)
 {
 }
 
+// (the internal object is a MidiInputThread, or a JackMidiInput for the JACK MIDI device)
 MidiInput::~MidiInput()
 {
 	stop();
-	delete static_cast <MidiInputThread*> (internal);
+	delete static_cast <Thread*> (internal);
 }
 
 void MidiInput::start()
 {
-	static_cast <MidiInputThread*> (internal)->startThread();
+	// a real-time priority, so the events are read as they arrive even while the UI is busy
+	static_cast <Thread*> (internal)->startThread (9);
 }
 
 void MidiInput::stop()
 {
-	static_cast <MidiInputThread*> (internal)->stopThread (3000);
+	static_cast <Thread*> (internal)->stopThread (3000);
 }
 
 int MidiInput::getDefaultDeviceIndex()
@@ -270954,6 +273266,12 @@ StringArray MidiInput::getDevices()
 {
 	StringArray devices;
 	iterateMidiDevices (true, devices, -1);
+
+   #if JUCE_JACK
+	if (juce_load_jack_library())
+		devices.add (jackMidiDeviceName);
+   #endif
+
 	return devices;
 }
 
@@ -270967,8 +273285,15 @@ MidiInput* MidiInput::openDevice (int deviceIndex, MidiInputCallback* callback)
 	if (handle != 0)
 	{
 		newDevice = new MidiInput (devices [deviceIndex]);
-		newDevice->internal = new MidiInputThread (newDevice, handle, callback);
+		newDevice->internal = static_cast <Thread*> (new MidiInputThread (newDevice, handle, callback));
+	}
+   #if JUCE_JACK
+	else if (deviceIndex == devices.size() && callback != nullptr && juce_load_jack_library())
+	{
+		newDevice = new MidiInput (jackMidiDeviceName);
+		newDevice->internal = static_cast <Thread*> (new JackMidiInput (newDevice, callback));
 	}
+   #endif
 
 	return newDevice;
 }
@@ -270982,7 +273307,7 @@ MidiInput* MidiInput::createNewDevice (const String& deviceName, MidiInputCallba
 	if (handle != 0)
 	{
 		newDevice = new MidiInput (deviceName);
-		newDevice->internal = new MidiInputThread (newDevice, handle, callback);
+		newDevice->internal = static_cast <Thread*> (new MidiInputThread (newDevice, handle, callback));
 	}
 
 	return newDevice;
@@ -270998,6 +273323,8 @@ MidiOutput* MidiOutput::openDevice (int)				{ return nullptr; }
 MidiOutput* MidiOutput::createNewDevice (const String&)		 { return nullptr; }
 MidiOutput::~MidiOutput()   {}
 void MidiOutput::sendMessageNow (const MidiMessage&)	{}
+void MidiOutput::sendShortMessageNow (uint32)		   {}
+void MidiOutput::sendMessagesNow (const MidiMessage* const*, int) {}
 
 MidiInput::MidiInput (const String& name_) : name (name_), internal (0)  {}
 MidiInput::~MidiInput() {}
@@ -273175,13 +275502,27 @@ bool Thread::setThreadPriority (void* handle, int priority)
 	if (pthread_getschedparam ((pthread_t) handle, &policy, &param) != 0)
 		return false;
 
-	policy = priority == 0 ? SCHED_OTHER : SCHED_RR;
+	// only the priorities above normal are realtime, so that a background thread
+	// can't get ahead of the message thread
+	policy = priority > 6 ? SCHED_RR : SCHED_OTHER;
 
 	const int minPriority = sched_get_priority_min (policy);
 	const int maxPriority = sched_get_priority_max (policy);
 
 	param.sched_priority = ((maxPriority - minPriority) * priority) / 10 + minPriority;
-	return pthread_setschedparam ((pthread_t) handle, policy, &param) == 0;
+
+	if (pthread_setschedparam ((pthread_t) handle, policy, &param) != 0)
+		return false;
+
+   #if JUCE_LINUX
+	// SCHED_OTHER has only one priority here, so the nice value of the thread stands in
+	// for it. That can only be set for the calling thread, and going back up below a
+	// nice value of 0 needs the permission of RLIMIT_NICE.
+	if (policy == SCHED_OTHER && pthread_equal ((pthread_t) handle, pthread_self()))
+		return setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), (5 - priority) * 2) == 0;
+   #endif
+
+	return true;
 }
 
 Thread::ThreadID Thread::getCurrentThreadId()
@@ -278726,6 +281067,76 @@ namespace CoreMidiHelpers
 		MIDIEndpointRef endPoint;
 	};
 
+	/*  Packs messages into as few MIDIPacketLists as possible. Short messages with the same
+		timestamp end up in one packet, a sysex is split into packets of maxSysExPacketSize
+		bytes, and a list is only sent when it's full or flush() is called.
+	*/
+	class PacketListBuilder
+	{
+	public:
+		PacketListBuilder (MidiPortAndEndpoint& mpe_)
+			: mpe (mpe_),
+			  buffer (listSize)
+		{
+			reset();
+		}
+
+		void add (const uint8* data, const int numBytes, const MIDITimeStamp timeStamp)
+		{
+			const int maxPacketSize = (numBytes > 0 && data[0] == 0xf0) ? (int) maxSysExPacketSize : numBytes;
+
+			for (int bytesLeft = numBytes; bytesLeft > 0;)
+			{
+				const int packetSize = jmin (maxPacketSize, bytesLeft);
+
+				if (! addPacket (data, packetSize, timeStamp))
+				{
+					flush();
+					addPacket (data, packetSize, timeStamp);
+				}
+
+				data += packetSize;
+				bytesLeft -= packetSize;
+			}
+		}
+
+		void flush()
+		{
+			if (getList()->numPackets > 0)
+				mpe.send (getList());
+
+			reset();
+		}
+
+	private:
+		enum { listSize = 16384,
+			   maxSysExPacketSize = 256 };
+
+		MidiPortAndEndpoint& mpe;
+		HeapBlock <char> buffer;
+		MIDIPacket* currentPacket;
+
+		MIDIPacketList* getList() const noexcept    { return reinterpret_cast <MIDIPacketList*> (buffer.getData()); }
+
+		void reset()
+		{
+			currentPacket = MIDIPacketListInit (getList());
+		}
+
+		bool addPacket (const uint8* const data, const int numBytes, const MIDITimeStamp timeStamp)
+		{
+			MIDIPacket* const next = MIDIPacketListAdd (getList(), listSize, currentPacket, timeStamp, (ByteCount) numBytes, data);
+
+			if (next == nullptr)
+				return false;
+
+			currentPacket = next;
+			return true;
+		}
+
+		JUCE_DECLARE_NON_COPYABLE (PacketListBuilder);
+	};
+
 	class MidiPortAndCallback;
 	CriticalSection callbackLock;
 	Array<MidiPortAndCallback*> activeCallbacks;
@@ -278873,26 +281284,9 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
 
 	if (message.isSysEx())
 	{
-		const int maxPacketSize = 256;
-		int pos = 0, bytesLeft = message.getRawDataSize();
-		const int numPackets = (bytesLeft + maxPacketSize - 1) / maxPacketSize;
-		HeapBlock <MIDIPacketList> packets;
-		packets.malloc (32 * numPackets + message.getRawDataSize(), 1);
-		packets->numPackets = numPackets;
-
-		MIDIPacket* p = packets->packet;
-
-		for (int i = 0; i < numPackets; ++i)
-		{
-			p->timeStamp = AudioGetCurrentHostTime();
-			p->length = jmin (maxPacketSize, bytesLeft);
-			memcpy (p->data, message.getRawData() + pos, p->length);
-			pos += p->length;
-			bytesLeft -= p->length;
-			p = MIDIPacketNext (p);
-		}
-
-		mpe->send (packets);
+		CoreMidiHelpers::PacketListBuilder packets (*mpe);
+		packets.add (message.getRawData(), message.getRawDataSize(), AudioGetCurrentHostTime());
+		packets.flush();
 	}
 	else
 	{
@@ -278906,6 +281300,69 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
 	}
 }
 
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+	MIDIPacketList packets;
+	packets.numPackets = 1;
+	packets.packet[0].timeStamp = AudioGetCurrentHostTime();
+	packets.packet[0].length = (UInt16) MidiMessage::getMessageLengthFromFirstByte ((uint8) packedMessage);
+	packets.packet[0].data[0] = (Byte) packedMessage;
+	packets.packet[0].data[1] = (Byte) (packedMessage >> 8);
+	packets.packet[0].data[2] = (Byte) (packedMessage >> 16);
+
+	static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal)->send (&packets);
+}
+
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+	CoreMidiHelpers::PacketListBuilder packets (*static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal));
+	const MIDITimeStamp now = AudioGetCurrentHostTime();
+
+	for (int i = 0; i < numMessages; ++i)
+		packets.add (messages[i]->getRawData(), messages[i]->getRawDataSize(), now);
+
+	packets.flush();
+}
+
+bool MidiOutput::sendBlockScheduled (const MidiBuffer& buffer,
+									 const double millisecondCounterToStartAt,
+									 const double samplesPerSecondForBuffer)
+{
+	CoreMidiHelpers::MidiPortAndEndpoint* const mpe = static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal);
+
+	// a virtual source passes the timestamps on to its clients without waiting for them
+	if (mpe->port == 0)
+		return false;
+
+	const MIDITimeStamp hostNow = AudioGetCurrentHostTime();
+	const double nanosToStart = (millisecondCounterToStartAt - Time::getMillisecondCounterHiRes()) * 1.0e6;
+	const double nanosPerSample = 1.0e9 / samplesPerSecondForBuffer;
+
+	CoreMidiHelpers::PacketListBuilder packets (*mpe);
+	MidiBuffer::Iterator i (buffer);
+	const uint8* data;
+	int len, time;
+
+	while (i.getNextEvent (data, len, time))
+	{
+		const double nanosAhead = nanosToStart + nanosPerSample * time;
+
+		packets.add (data, len, nanosAhead > 0 ? hostNow + AudioConvertNanosToHostTime ((UInt64) nanosAhead)
+											   : hostNow);
+	}
+
+	packets.flush();
+	return true;
+}
+
+void MidiOutput::flushScheduledMessages()
+{
+	CoreMidiHelpers::MidiPortAndEndpoint* const mpe = static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal);
+
+	if (mpe != nullptr && mpe->port != 0)
+		MIDIFlushOutput (mpe->endPoint);
+}
+
 StringArray MidiInput::getDevices()
 {
 	StringArray s;
@@ -290189,13 +292646,27 @@ bool Thread::setThreadPriority (void* handle, int priority)
 	if (pthread_getschedparam ((pthread_t) handle, &policy, &param) != 0)
 		return false;
 
-	policy = priority == 0 ? SCHED_OTHER : SCHED_RR;
+	// only the priorities above normal are realtime, so that a background thread
+	// can't get ahead of the message thread
+	policy = priority > 6 ? SCHED_RR : SCHED_OTHER;
 
 	const int minPriority = sched_get_priority_min (policy);
 	const int maxPriority = sched_get_priority_max (policy);
 
 	param.sched_priority = ((maxPriority - minPriority) * priority) / 10 + minPriority;
-	return pthread_setschedparam ((pthread_t) handle, policy, &param) == 0;
+
+	if (pthread_setschedparam ((pthread_t) handle, policy, &param) != 0)
+		return false;
+
+   #if JUCE_LINUX
+	// SCHED_OTHER has only one priority here, so the nice value of the thread stands in
+	// for it. That can only be set for the calling thread, and going back up below a
+	// nice value of 0 needs the permission of RLIMIT_NICE.
+	if (policy == SCHED_OTHER && pthread_equal ((pthread_t) handle, pthread_self()))
+		return setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), (5 - priority) * 2) == 0;
+   #endif
+
+	return true;
 }
 
 Thread::ThreadID Thread::getCurrentThreadId()
@@ -835,6 +835,11 @@ namespace JuceDummyNamespace {}
   #include <intrin.h>
 #endif
 
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE__)) && ! defined (JUCE_DISABLE_SSE_REVERB)
+  #define JUCE_USE_SSE_REVERB 1
+  #include <xmmintrin.h>
+#endif
+
 #if JUCE_MAC || JUCE_IOS
   #include <libkern/OSAtomic.h>
 #endif
@@ -7232,6 +7237,38 @@ public:
 		new (data.elements + numUsed++) ElementType (newElement);
 	}
 
+	/** Appends a default-constructed element and returns a reference to it.
+
+		This lets a large element be filled in where it is stored, instead of
+		being built on the stack and copied in by add(). The reference is only
+		valid until the array is next resized.
+
+		@see add, ensureStorageAllocated
+	*/
+	ElementType& addNew()
+	{
+		const ScopedLockType lock (getLock());
+		data.ensureAllocatedSize (numUsed + 1);
+		return *new (data.elements + numUsed++) ElementType();
+	}
+
+	/** Appends an element constructed in place from a single argument, and
+		returns a reference to it.
+
+		This avoids the temporary that add() would copy from when the element
+		is made from a different type, e.g. a File from a path String.
+		The argument must not refer to an element of this array.
+
+		@see add, addNew
+	*/
+	template <class ArgumentType>
+	ElementType& addNew (const ArgumentType& argument)
+	{
+		const ScopedLockType lock (getLock());
+		data.ensureAllocatedSize (numUsed + 1);
+		return *new (data.elements + numUsed++) ElementType (argument);
+	}
+
 	/** Inserts a new element into the array at a given position.
 
 		If the index is less than 0 or greater than the size of the array, the
@@ -18164,6 +18201,19 @@ public:
 	/** Checks whether Intel SSE2 instructions are available. */
 	static bool hasSSE2() noexcept		  { return getCPUFlags().hasSSE2; }
 
+	/** True if the SSE2 code paths of the renderer and the audio classes may run.
+		64-bit CPUs always have SSE2, a 32-bit build asks hasSSE2() once.
+	*/
+	static bool canUseSSE2() noexcept
+	{
+	   #if JUCE_64BIT
+		return true;
+	   #else
+		static const bool sse2 = hasSSE2();
+		return sse2;
+	   #endif
+	}
+
 	/** Checks whether AMD 3DNOW instructions are available. */
 	static bool has3DNow() noexcept		 { return getCPUFlags().has3DNow; }
 
@@ -32262,6 +32312,31 @@ public:
 	*/
 	virtual void paintOverChildren (Graphics& g);
 
+	/** Receives the time that each call to a component's paint() method takes.
+
+		This is meant for profiling, see setPaintTimer().
+	*/
+	class JUCE_API  PaintTimer
+	{
+	public:
+		/** Destructor. */
+		virtual ~PaintTimer() {}
+
+		/** Called on the message thread after a component's paint() method has returned.
+
+			A component that buffers itself to an image reports the time it took to
+			draw that image.
+		*/
+		virtual void componentPainted (Component& component, double milliseconds) = 0;
+	};
+
+	/** Sets the PaintTimer that is told about every component that gets painted.
+
+		Pass nullptr to stop timing, which is the default. The timer isn't deleted
+		by the components, and must be removed before it is deleted.
+	*/
+	static void JUCE_CALLTYPE setPaintTimer (PaintTimer* newPaintTimer) noexcept;
+
 	/** Called when the mouse moves inside this component.
 
 		If the mouse button isn't pressed and the mouse moves over a component,
@@ -33026,6 +33101,7 @@ private:
 
    #ifndef DOXYGEN
 	static Component* currentlyFocusedComponent;
+	static PaintTimer* currentPaintTimer;
 
 	String componentName, componentID;
 	Component* parentComponent;
@@ -35782,12 +35858,61 @@ class JUCE_API  AudioDataConverters
 {
 public:
 
+	/**
+		The noise that is added to the samples before they're rounded to 16 or 24 bits.
+
+		Triangular dither adds the difference of two uniform random numbers, up to one
+		step of the output format either way, which turns the rounding error of quiet
+		signals into a constant noise floor instead of distortion. Keep one Dither for
+		each channel from one block to the next.
+	*/
+	class JUCE_API  Dither
+	{
+	public:
+		enum Type
+		{
+			none,           /**< Plain rounding, the same results as the functions without a Dither. */
+			triangular      /**< TPDF noise of up to +/- 1 LSB. */
+		};
+
+		explicit Dither (Type type_ = none, uint32 seed = 1) noexcept
+			: type (type_), state (seed != 0 ? seed : 1)
+		{
+		}
+
+		bool isActive() const noexcept      { return type != none; }
+
+		/** Returns the noise for the next sample, in steps of the output format. */
+		inline double getNextNoise() noexcept
+		{
+			if (type == none)
+				return 0.0;
+
+			// xorshift32, its two halves are the two uniform numbers
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return ((int) (state & 0xffff) - (int) (state >> 16)) * (1.0 / 65536.0);
+		}
+
+	private:
+		Type type;
+		uint32 state;
+	};
+
 	static void convertFloatToInt16LE (const float* source, void* dest, int numSamples, int destBytesPerSample = 2);
 	static void convertFloatToInt16BE (const float* source, void* dest, int numSamples, int destBytesPerSample = 2);
 
 	static void convertFloatToInt24LE (const float* source, void* dest, int numSamples, int destBytesPerSample = 3);
 	static void convertFloatToInt24BE (const float* source, void* dest, int numSamples, int destBytesPerSample = 3);
 
+	/** These take a Dither, which keeps its state from one call to the next. */
+	static void convertFloatToInt16LE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+	static void convertFloatToInt16BE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+
+	static void convertFloatToInt24LE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+	static void convertFloatToInt24BE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+
 	static void convertFloatToInt32LE (const float* source, void* dest, int numSamples, int destBytesPerSample = 4);
 	static void convertFloatToInt32BE (const float* source, void* dest, int numSamples, int destBytesPerSample = 4);
 
@@ -35821,6 +35946,11 @@ public:
 	static void convertFloatToFormat (DataFormat destFormat,
 									  const float* source, void* dest, int numSamples);
 
+	/** The dither applies to the 16 and 24 bit formats, the others ignore it. */
+	static void convertFloatToFormat (DataFormat destFormat,
+									  const float* source, void* dest, int numSamples,
+									  Dither& dither);
+
 	static void convertFormatToFloat (DataFormat sourceFormat,
 									  const void* source, float* dest, int numSamples);
 
@@ -36076,6 +36206,9 @@ class AudioFormatWriter;
 /**
 	A multi-channel buffer of 32-bit floating point audio samples.
 
+	When the buffer allocates its own memory, every channel starts on a 32-byte
+	boundary and is padded to a multiple of 8 samples. The gain, add and level
+	methods use SSE2 where it's available.
 */
 class JUCE_API  AudioSampleBuffer
 {
@@ -39223,11 +39356,78 @@ protected:
 	float coefficients[6];
 	float x1, x2, y1, y2;
 
+	friend class IIRFilterBank;
+
 	// (use the copyCoefficientsFrom() method instead of this operator)
 	IIRFilter& operator= (const IIRFilter&);
 	JUCE_LEAK_DETECTOR (IIRFilter);
 };
 
+/**
+	Runs a biquad on each of a number of interleaved channels, with SSE on four
+	channels per instruction.
+
+	Every channel gets its coefficients from an IIRFilter that has been set up with
+	one of its make...() methods, so the bank filters exactly like that filter would.
+	Groups of eight channels are processed as two interleaved vectors, so that the two
+	chains hide each other's latency, and what's left over as one vector of four,
+	the remaining channels use scalar code.
+
+	A coefficient change can be ramped linearly over a number of samples, so that
+	moving an EQ doesn't click. Nothing is locked or allocated while processing, it's
+	meant to be called from the audio thread, and all set-up calls have to come from
+	that same thread.
+
+	@see IIRFilter
+*/
+class JUCE_API  IIRFilterBank
+{
+public:
+
+	/** Creates a bank of filters that all pass their channels through unchanged. */
+	explicit IIRFilterBank (int numChannels);
+
+	/** Destructor. */
+	~IIRFilterBank();
+
+	/** Returns the number of channels, which is also the stride of the interleaved frames. */
+	int getNumChannels() const noexcept                 { return numChannels; }
+
+	/** Sets how many samples a coefficient change is ramped over. 0 (the default)
+		makes new coefficients take effect at once.
+	*/
+	void setSmoothingLength (int numSamples) noexcept;
+
+	/** Makes a channel use the coefficients of a filter. An inactive filter lets
+		the channel pass through. The change is ramped over the smoothing length.
+	*/
+	void setCoefficients (int channel, const IIRFilter& filter) noexcept;
+
+	/** Clears the state of all channels, the coefficients are kept. */
+	void reset() noexcept;
+
+	/** Filters numSamples frames in place, the sample i of channel c being at
+		frames [i * getNumChannels() + c].
+	*/
+	void processInterleaved (float* frames, int numSamples) noexcept;
+
+private:
+
+	enum { numCoefficients = 5 };   // b0, b1, b2, a1, a2, already divided by a0
+
+	const int numChannels;
+	HeapBlock<float> coefficients, targets, steps;  // [coefficient * numChannels + channel]
+	HeapBlock<float> state;                         // x1, x2, y1, y2 in the same layout
+	int smoothingLength, rampRemaining;
+
+	void processScalar (float* frames, int channel, int numSamples, bool ramping) noexcept;
+	void processFour (float* frames, int channel, int numSamples, bool ramping) noexcept;
+	void processEight (float* frames, int channel, int numSamples, bool ramping) noexcept;
+	void processSection (float* frames, int numSamples, bool ramping) noexcept;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterBank);
+};
+
 #endif   // __JUCE_IIRFILTER_JUCEHEADER__
 
 /*** End of inlined file: juce_IIRFilter.h ***/
@@ -39388,6 +39588,11 @@ private:
 	Use setSampleRate() to prepare it, and then call processStereo() or processMono() to
 	apply the reverb to your audio data.
 
+	The audio is processed in blocks: the eight comb filters of a channel are run
+	together, with SSE on Intel CPUs that have it (define JUCE_DISABLE_SSE_REVERB
+	to turn that off), and each allpass filter then runs across the whole block.
+	The results are the same as running every filter sample by sample.
+
 	@see ReverbAudioSource
 */
 class Reverb
@@ -39457,8 +39662,8 @@ public:
 		int i;
 		for (i = 0; i < numCombs; ++i)
 		{
-			comb[0][i].setSize ((intSampleRate * combTunings[i]) / 44100);
-			comb[1][i].setSize ((intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
+			combs[0].setSize (i, (intSampleRate * combTunings[i]) / 44100);
+			combs[1].setSize (i, (intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
 		}
 
 		for (i = 0; i < numAllPasses; ++i)
@@ -39475,11 +39680,9 @@ public:
 	{
 		for (int j = 0; j < numChannels; ++j)
 		{
-			int i;
-			for (i = 0; i < numCombs; ++i)
-				comb[j][i].clear();
+			combs[j].clear();
 
-			for (i = 0; i < numAllPasses; ++i)
+			for (int i = 0; i < numAllPasses; ++i)
 				allPass[j][i].clear();
 		}
 	}
@@ -39492,26 +39695,32 @@ public:
 		if (shouldUpdateDamping)
 			updateDamping();
 
-		for (int i = 0; i < numSamples; ++i)
+		float input [blockSize], outL [blockSize], outR [blockSize];
+
+		for (int start = 0; start < numSamples; start += blockSize)
 		{
-			const float input = (left[i] + right[i]) * gain;
-			float outL = 0, outR = 0;
+			const int num = jmin ((int) blockSize, numSamples - start);
+			float* const l = left + start;
+			float* const r = right + start;
 
-			int j;
-			for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
+			int i;
+			for (i = 0; i < num; ++i)
+				input[i] = (l[i] + r[i]) * gain;
+
+			combs[0].process (input, outL, num);  // accumulate the comb filters in parallel
+			combs[1].process (input, outR, num);
+
+			for (int j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
 			{
-				outL += comb[0][j].process (input);
-				outR += comb[1][j].process (input);
+				allPass[0][j].process (outL, num);
+				allPass[1][j].process (outR, num);
 			}
 
-			for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
+			for (i = 0; i < num; ++i)
 			{
-				outL = allPass[0][j].process (outL);
-				outR = allPass[1][j].process (outR);
+				l[i] = outL[i] * wet1 + outR[i] * wet2 + l[i] * dry;
+				r[i] = outR[i] * wet1 + outL[i] * wet2 + r[i] * dry;
 			}
-
-			left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
-			right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
 		}
 	}
 
@@ -39523,19 +39732,24 @@ public:
 		if (shouldUpdateDamping)
 			updateDamping();
 
-		for (int i = 0; i < numSamples; ++i)
+		float input [blockSize], output [blockSize];
+
+		for (int start = 0; start < numSamples; start += blockSize)
 		{
-			const float input = samples[i] * gain;
-			float output = 0;
+			const int num = jmin ((int) blockSize, numSamples - start);
+			float* const s = samples + start;
+
+			int i;
+			for (i = 0; i < num; ++i)
+				input[i] = s[i] * gain;
 
-			int j;
-			for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-				output += comb[0][j].process (input);
+			combs[0].process (input, output, num);  // accumulate the comb filters in parallel
 
-			for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-				output = allPass[0][j].process (output);
+			for (int j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
+				allPass[0][j].process (output, num);
 
-			samples[i] = output * wet1 + input * dry;
+			for (i = 0; i < num; ++i)
+				s[i] = output[i] * wet1 + input[i] * dry;
 		}
 	}
 
@@ -39566,31 +39780,76 @@ private:
 	void setDamping (const float dampingToUse, const float roomSizeToUse) noexcept
 	{
 		for (int j = 0; j < numChannels; ++j)
-			for (int i = numCombs; --i >= 0;)
-				comb[j][i].setFeedbackAndDamp (roomSizeToUse, dampingToUse);
+			combs[j].setFeedbackAndDamp (roomSizeToUse, dampingToUse);
 	}
 
-	class CombFilter
+   #if JUCE_USE_SSE_REVERB
+	static bool canUseSSE() noexcept
+	{
+	   #if JUCE_64BIT
+		return true;
+	   #else
+		static const bool hasSSE = SystemStats::hasSSE();
+		return hasSSE;
+	   #endif
+	}
+
+	// the vector version of JUCE_UNDENORMALISE
+	static inline __m128 undenormalise (__m128 v) noexcept
+	{
+	   #if JUCE_32BIT
+		const __m128 one = _mm_set1_ps (1.0f);
+		v = _mm_sub_ps (_mm_add_ps (v, one), one);
+	   #endif
+		return v;
+	}
+   #endif
+
+	enum { numCombs = 8, numAllPasses = 4, numChannels = 2, blockSize = 256 };
+
+	/** The comb filters of one channel. They all share the same feedback and damping,
+		and their outputs are added up.
+
+		A block is cut where the first of the delay lines wraps around, within such a
+		part every comb reads and writes a contiguous run of its buffer. With SSE four
+		samples of four combs are loaded at a time and transposed, so that the damping
+		of all eight combs is updated with two vectors per sample.
+	*/
+	class CombBank
 	{
 	public:
-		CombFilter() noexcept  : bufferSize (0), bufferIndex (0) {}
+		CombBank() noexcept  : feedback (0), damp1 (0), damp2 (0)
+		{
+			for (int i = 0; i < numCombs; ++i)
+			{
+				bufferSizes[i] = 0;
+				bufferIndexes[i] = 0;
+				last[i] = 0;
+			}
+		}
 
-		void setSize (const int size)
+		void setSize (const int combIndex, int size)
 		{
-			if (size != bufferSize)
+			size = jmax (1, size);
+
+			if (size != bufferSizes [combIndex])
 			{
-				bufferIndex = 0;
-				buffer.malloc (size);
-				bufferSize = size;
+				bufferIndexes [combIndex] = 0;
+				buffers [combIndex].malloc (size);
+				bufferSizes [combIndex] = size;
 			}
 
-			clear();
+			last [combIndex] = 0;
+			buffers [combIndex].clear (size);
 		}
 
 		void clear() noexcept
 		{
-			last = 0;
-			buffer.clear (bufferSize);
+			for (int i = 0; i < numCombs; ++i)
+			{
+				last[i] = 0;
+				buffers[i].clear (bufferSizes[i]);
+			}
 		}
 
 		void setFeedbackAndDamp (const float f, const float d) noexcept
@@ -39600,25 +39859,154 @@ private:
 			feedback = f;
 		}
 
-		inline float process (const float input) noexcept
+		/** Writes the sum of the comb outputs for each input sample to output. */
+		void process (const float* input, float* output, int numSamples) noexcept
 		{
-			const float output = buffer [bufferIndex];
-			last = (output * damp2) + (last * damp1);
-			JUCE_UNDENORMALISE (last);
-
-			float temp = input + (last * feedback);
-			JUCE_UNDENORMALISE (temp);
-			buffer [bufferIndex] = temp;
-			bufferIndex = (bufferIndex + 1) % bufferSize;
-			return output;
+			while (numSamples > 0)
+			{
+				int num = numSamples;
+				float* runs [numCombs];
+
+				int i;
+				for (i = 0; i < numCombs; ++i)
+				{
+					num = jmin (num, bufferSizes[i] - bufferIndexes[i]);
+					runs[i] = buffers[i] + bufferIndexes[i];
+				}
+
+			   #if JUCE_USE_SSE_REVERB
+				if (canUseSSE())
+					processRunSSE (runs, input, output, num);
+				else
+			   #endif
+					processRun (runs, input, output, num);
+
+				for (i = 0; i < numCombs; ++i)
+				{
+					bufferIndexes[i] += num;
+
+					if (bufferIndexes[i] >= bufferSizes[i])
+						bufferIndexes[i] = 0;
+				}
+
+				input += num;
+				output += num;
+				numSamples -= num;
+			}
 		}
 
 	private:
-		HeapBlock<float> buffer;
-		int bufferSize, bufferIndex;
-		float feedback, last, damp1, damp2;
+		HeapBlock<float> buffers [numCombs];
+		int bufferSizes [numCombs], bufferIndexes [numCombs];
+		float last [numCombs];
+		float feedback, damp1, damp2;
 
-		JUCE_DECLARE_NON_COPYABLE (CombFilter);
+		void processRun (float* const* runs, const float* input, float* output, const int num) noexcept
+		{
+			int i;
+			for (i = 0; i < num; ++i)
+				output[i] = 0;
+
+			for (int j = 0; j < numCombs; ++j)
+			{
+				float* const buffer = runs[j];
+				float lastValue = last[j];
+
+				for (i = 0; i < num; ++i)
+				{
+					const float bufferedValue = buffer[i];
+					lastValue = (bufferedValue * damp2) + (lastValue * damp1);
+					JUCE_UNDENORMALISE (lastValue);
+
+					float temp = input[i] + (lastValue * feedback);
+					JUCE_UNDENORMALISE (temp);
+					buffer[i] = temp;
+					output[i] += bufferedValue;
+				}
+
+				last[j] = lastValue;
+			}
+		}
+
+	   #if JUCE_USE_SSE_REVERB
+		// damps the buffered values of four combs for one input sample, and returns what goes back into the buffers
+		static inline __m128 processFour (const __m128& bufferedValues, __m128& lastValues, const float input,
+										  const __m128& feedbacks, const __m128& damps1, const __m128& damps2) noexcept
+		{
+			lastValues = undenormalise (_mm_add_ps (_mm_mul_ps (bufferedValues, damps2), _mm_mul_ps (lastValues, damps1)));
+			return undenormalise (_mm_add_ps (_mm_set1_ps (input), _mm_mul_ps (lastValues, feedbacks)));
+		}
+
+		void processRunSSE (float* const* runs, const float* input, float* output, const int num) noexcept
+		{
+			const __m128 feedbacks = _mm_set1_ps (feedback);
+			const __m128 damps1 = _mm_set1_ps (damp1);
+			const __m128 damps2 = _mm_set1_ps (damp2);
+			__m128 lastLow = _mm_loadu_ps (last);
+			__m128 lastHigh = _mm_loadu_ps (last + 4);
+
+			int i = 0;
+			for (; i + 4 <= num; i += 4)
+			{
+				// one row per comb, four samples each
+				__m128 l0 = _mm_loadu_ps (runs[0] + i), l1 = _mm_loadu_ps (runs[1] + i);
+				__m128 l2 = _mm_loadu_ps (runs[2] + i), l3 = _mm_loadu_ps (runs[3] + i);
+				__m128 h0 = _mm_loadu_ps (runs[4] + i), h1 = _mm_loadu_ps (runs[5] + i);
+				__m128 h2 = _mm_loadu_ps (runs[6] + i), h3 = _mm_loadu_ps (runs[7] + i);
+
+				// added up in the same order as one comb after the other
+				__m128 sum = _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_setzero_ps(), l0), l1), l2), l3);
+				sum = _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_add_ps (sum, h0), h1), h2), h3);
+				_mm_storeu_ps (output + i, sum);
+
+				// now one row per sample, four combs each
+				_MM_TRANSPOSE4_PS (l0, l1, l2, l3);
+				_MM_TRANSPOSE4_PS (h0, h1, h2, h3);
+
+				l0 = processFour (l0, lastLow, input[i], feedbacks, damps1, damps2);
+				h0 = processFour (h0, lastHigh, input[i], feedbacks, damps1, damps2);
+				l1 = processFour (l1, lastLow, input[i + 1], feedbacks, damps1, damps2);
+				h1 = processFour (h1, lastHigh, input[i + 1], feedbacks, damps1, damps2);
+				l2 = processFour (l2, lastLow, input[i + 2], feedbacks, damps1, damps2);
+				h2 = processFour (h2, lastHigh, input[i + 2], feedbacks, damps1, damps2);
+				l3 = processFour (l3, lastLow, input[i + 3], feedbacks, damps1, damps2);
+				h3 = processFour (h3, lastHigh, input[i + 3], feedbacks, damps1, damps2);
+
+				_MM_TRANSPOSE4_PS (l0, l1, l2, l3);
+				_MM_TRANSPOSE4_PS (h0, h1, h2, h3);
+
+				_mm_storeu_ps (runs[0] + i, l0);  _mm_storeu_ps (runs[1] + i, l1);
+				_mm_storeu_ps (runs[2] + i, l2);  _mm_storeu_ps (runs[3] + i, l3);
+				_mm_storeu_ps (runs[4] + i, h0);  _mm_storeu_ps (runs[5] + i, h1);
+				_mm_storeu_ps (runs[6] + i, h2);  _mm_storeu_ps (runs[7] + i, h3);
+			}
+
+			for (; i < num; ++i)
+			{
+				float values [numCombs];
+				int j;
+				for (j = 0; j < numCombs; ++j)
+					values[j] = runs[j][i];
+
+				float sum = 0;
+				for (j = 0; j < numCombs; ++j)
+					sum += values[j];
+
+				output[i] = sum;
+
+				_mm_storeu_ps (values, processFour (_mm_loadu_ps (values), lastLow, input[i], feedbacks, damps1, damps2));
+				_mm_storeu_ps (values + 4, processFour (_mm_loadu_ps (values + 4), lastHigh, input[i], feedbacks, damps1, damps2));
+
+				for (j = 0; j < numCombs; ++j)
+					runs[j][i] = values[j];
+			}
+
+			_mm_storeu_ps (last, lastLow);
+			_mm_storeu_ps (last + 4, lastHigh);
+		}
+	   #endif
+
+		JUCE_DECLARE_NON_COPYABLE (CombBank);
 	};
 
 	class AllPassFilter
@@ -39626,8 +40014,10 @@ private:
 	public:
 		AllPassFilter() noexcept  : bufferSize (0), bufferIndex (0) {}
 
-		void setSize (const int size)
+		void setSize (int size)
 		{
+			size = jmax (1, size);
+
 			if (size != bufferSize)
 			{
 				bufferIndex = 0;
@@ -39643,14 +40033,48 @@ private:
 			buffer.clear (bufferSize);
 		}
 
-		inline float process (const float input) noexcept
+		/** Filters a block of samples in place. */
+		void process (float* samples, int numSamples) noexcept
 		{
-			const float bufferedValue = buffer [bufferIndex];
-			float temp = input + (bufferedValue * 0.5f);
-			JUCE_UNDENORMALISE (temp);
-			buffer [bufferIndex] = temp;
-			bufferIndex = (bufferIndex + 1) % bufferSize;
-			return bufferedValue - input;
+			while (numSamples > 0)
+			{
+				const int num = jmin (numSamples, bufferSize - bufferIndex);
+				float* const run = buffer + bufferIndex;
+				int i = 0;
+
+			   #if JUCE_USE_SSE_REVERB
+				if (canUseSSE())
+				{
+					const __m128 half = _mm_set1_ps (0.5f);
+
+					for (; i + 4 <= num; i += 4)
+					{
+						const __m128 bufferedValues = _mm_loadu_ps (run + i);
+						const __m128 inputs = _mm_loadu_ps (samples + i);
+						_mm_storeu_ps (run + i, undenormalise (_mm_add_ps (inputs, _mm_mul_ps (bufferedValues, half))));
+						_mm_storeu_ps (samples + i, _mm_sub_ps (bufferedValues, inputs));
+					}
+				}
+			   #endif
+
+				for (; i < num; ++i)
+				{
+					const float input = samples[i];
+					const float bufferedValue = run[i];
+					float temp = input + (bufferedValue * 0.5f);
+					JUCE_UNDENORMALISE (temp);
+					run[i] = temp;
+					samples[i] = bufferedValue - input;
+				}
+
+				bufferIndex += num;
+
+				if (bufferIndex >= bufferSize)
+					bufferIndex = 0;
+
+				samples += num;
+				numSamples -= num;
+			}
 		}
 
 	private:
@@ -39660,9 +40084,7 @@ private:
 		JUCE_DECLARE_NON_COPYABLE (AllPassFilter);
 	};
 
-	enum { numCombs = 8, numAllPasses = 4, numChannels = 2 };
-
-	CombFilter comb [numChannels][numCombs];
+	CombBank combs [numChannels];
 	AllPassFilter allPass [numChannels][numAllPasses];
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reverb);
@@ -39903,8 +40325,13 @@ public:
 	static AudioIODeviceType* createAudioIODeviceType_CoreAudio();
 	/** Creates an iOS device type if it's available on this platform, or returns null. */
 	static AudioIODeviceType* createAudioIODeviceType_iOSAudio();
-	/** Creates a WASAPI device type if it's available on this platform, or returns null. */
-	static AudioIODeviceType* createAudioIODeviceType_WASAPI();
+	/** Creates a WASAPI device type if it's available on this platform, or returns null.
+
+		With exclusiveMode the devices take the endpoint for themselves and are driven by
+		its events, with buffers down to the smallest period the hardware can do. A device
+		that can't get exclusive access when it's opened falls back to shared mode.
+	*/
+	static AudioIODeviceType* createAudioIODeviceType_WASAPI (bool exclusiveMode);
 	/** Creates a DirectSound device type if it's available on this platform, or returns null. */
 	static AudioIODeviceType* createAudioIODeviceType_DirectSound();
 	/** Creates an ASIO device type if it's available on this platform, or returns null. */
@@ -40852,6 +41279,25 @@ public:
 	virtual void handleIncomingMidiMessage (MidiInput* source,
 											const MidiMessage& message) = 0;
 
+	/** Receives a number of messages that were read from the device at once.
+
+		Where the device delivers its input in batches (currently ALSA on Linux), this
+		is called instead of handleIncomingMidiMessage() for each batch, on the same
+		thread. Each message keeps its own timestamp of when it arrived. The default
+		implementation just passes the messages one by one to handleIncomingMidiMessage().
+
+		@param source       the MidiInput object that generated the messages
+		@param messages     the messages, in the order they arrived
+		@param numMessages  the number of messages
+	*/
+	virtual void handleIncomingMidiMessages (MidiInput* source,
+											 const MidiMessage* messages,
+											 int numMessages)
+	{
+		for (int i = 0; i < numMessages; ++i)
+			handleIncomingMidiMessage (source, messages[i]);
+	}
+
 	/** Notification sent each time a packet of a multi-packet sysex message arrives.
 
 		If a long sysex message is broken up into multiple packets, this callback is made
@@ -41248,6 +41694,17 @@ public:
 	*/
 	virtual void sendMessageNow (const MidiMessage& message);
 
+	/** Makes this device output a message of up to three bytes, packed into an integer
+		the way midiOutShortMsg() takes it: the status byte in the lowest 8 bits and the
+		two data bytes above it.
+
+		On Windows, Linux and the Mac this goes to the driver without creating a
+		MidiMessage, which makes it the cheapest way to send controllers and notes.
+
+		@see sendMessageNow
+	*/
+	virtual void sendShortMessageNow (uint32 packedMessage);
+
 	/** This lets you supply a block of messages that will be sent out at some point
 		in the future.
 
@@ -41296,6 +41753,23 @@ protected:
 	void run();
 
 private:
+	/** Sends a run of messages that the background thread found due at the same time.
+		On Linux this costs a single ALSA drain, on Windows a single long message and on
+		the Mac a single packet list, elsewhere the messages go out one by one.
+	*/
+	void sendMessagesNow (const MidiMessage* const* messages, int numMessages);
+
+   #if JUCE_MAC
+	/** Hands a whole block to CoreMIDI in packet lists stamped with the host time of each
+		message, and CoreMIDI sends them when they're due. Returns false for a device that
+		can't schedule them, which then uses the background thread.
+	*/
+	bool sendBlockScheduled (const MidiBuffer& buffer, double millisecondCounterToStartAt, double samplesPerSecondForBuffer);
+
+	/** Unschedules what sendBlockScheduled() has handed to CoreMIDI. */
+	void flushScheduledMessages();
+   #endif
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiOutput);
 };
 
@@ -67002,6 +67476,10 @@ class Image;
 /**
 	A table of horizontal scan-line segments - used for rasterising Paths.
 
+	The memory of a table that is deleted is kept by the thread that deleted it,
+	and reused for the next tables that thread creates, so drawing a lot of shapes
+	doesn't need an allocation for each of them.
+
 	@see Path, Graphics
 */
 class JUCE_API  EdgeTable
@@ -67156,9 +67634,10 @@ private:
 	// table line format: number of points; point0 x, point0 levelDelta, point1 x, point1 levelDelta, etc
 	HeapBlock<int> table;
 	Rectangle<int> bounds;
-	int maxEdgesPerLine, lineStrideElements;
+	int maxEdgesPerLine, lineStrideElements, tableCapacity;
 	bool needToCheckEmptinesss;
 
+	void allocateTable (int numElements);
 	void addEdgePoint (int x, int y, int winding);
 	void remapTableForNumEdges (int newNumEdgesPerLine);
 	void intersectWithEdgeTableLine (int y, const int* otherLine);
@@ -68804,6 +69283,66 @@ public:
 	*/
 	static Image getFromMemory (const void* imageData, int dataSize);
 
+	/** Receives the images that getFromFileAsync() and getFromMemoryAsync() have
+		decoded in the background.
+
+		@see cancelAsyncLoads
+	*/
+	class JUCE_API  AsyncLoadCallback
+	{
+	public:
+		/** Destructor. */
+		virtual ~AsyncLoadCallback() {}
+
+		/** Called on the message thread when a requested image has been decoded.
+
+			The image has already been added to the cache at this point.
+
+			@param image        the image, or an invalid image if it couldn't be loaded
+			@param hashCode     the hash code of the image in the cache
+		*/
+		virtual void imageLoaded (const Image& image, int64 hashCode) = 0;
+	};
+
+	/** Loads an image from a file on a background thread, (or just returns the image if it's already cached).
+
+		If the cache already contains an image that was loaded from this file, that
+		image is returned and the callback isn't used. Otherwise this returns an invalid
+		image straight away, so that the caller can draw a placeholder, and the file is
+		decoded by a background thread. When it's ready, the image is added to the cache
+		and the callback is told about it.
+
+		If the same image is requested again while it's being decoded, it's only decoded
+		once and all the callbacks are told.
+
+		@param file         the file to try to load
+		@param callback     is told when the image is ready, this can be nullptr. It must be
+							removed with cancelAsyncLoads() before it's deleted
+		@returns            the cached image, or an invalid image if it's still being loaded
+		@see getFromFile, cancelAsyncLoads
+	*/
+	static Image getFromFileAsync (const File& file, AsyncLoadCallback* callback);
+
+	/** Loads an image from an in-memory image file on a background thread, (or just returns the image if it's already cached).
+
+		This works like getFromFileAsync(). The memory block has to stay valid until the
+		image has been decoded.
+
+		@param imageData    the block of memory containing the image data
+		@param dataSize     the data size in bytes
+		@param callback     is told when the image is ready, this can be nullptr. It must be
+							removed with cancelAsyncLoads() before it's deleted
+		@returns            the cached image, or an invalid image if it's still being loaded
+		@see getFromMemory, cancelAsyncLoads
+	*/
+	static Image getFromMemoryAsync (const void* imageData, int dataSize, AsyncLoadCallback* callback);
+
+	/** Makes sure that a callback isn't told about any of the images that it requested.
+
+		The images are still decoded and added to the cache.
+	*/
+	static void cancelAsyncLoads (AsyncLoadCallback* callback);
+
 	/** Checks the cache for an image with a particular hashcode.
 
 		If there's an image in the cache with this hashcode, it will be returned,
@@ -155,8 +155,13 @@ public:
     static AudioIODeviceType* createAudioIODeviceType_CoreAudio();
     /** Creates an iOS device type if it's available on this platform, or returns null. */
     static AudioIODeviceType* createAudioIODeviceType_iOSAudio();
-    /** Creates a WASAPI device type if it's available on this platform, or returns null. */
-    static AudioIODeviceType* createAudioIODeviceType_WASAPI();
+    /** Creates a WASAPI device type if it's available on this platform, or returns null.
+
+        With exclusiveMode the devices take the endpoint for themselves and are driven by
+        its events, with buffers down to the smallest period the hardware can do. A device
+        that can't get exclusive access when it's opened falls back to shared mode.
+    */
+    static AudioIODeviceType* createAudioIODeviceType_WASAPI (bool exclusiveMode);
     /** Creates a DirectSound device type if it's available on this platform, or returns null. */
     static AudioIODeviceType* createAudioIODeviceType_DirectSound();
     /** Creates an ASIO device type if it's available on this platform, or returns null. */
@@ -25,22 +25,151 @@
 
 #include "../../core/juce_StandardHeader.h"
 
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE2__)) && ! defined (JUCE_DISABLE_SSE2_CONVERTERS)
+ #define JUCE_USE_SSE2_CONVERTERS 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioDataConverters.h"
+#include "../../core/juce_SystemStats.h"
+
+#if JUCE_USE_SSE2_CONVERTERS
+//==============================================================================
+namespace AudioDataConverterHelpers
+{
+    // four samples scaled, dithered, clipped and rounded in double precision, so the
+    // results are exactly those of roundToInt (jlimit (-maxVal, maxVal, maxVal * x + noise))
+    forcedinline __m128i scaleFour (const float* source, const __m128d maxVal, const __m128d minVal,
+                                    AudioDataConverters::Dither& dither) noexcept
+    {
+        const __m128 s = _mm_loadu_ps (source);
+        __m128d lo = _mm_mul_pd (maxVal, _mm_cvtps_pd (s));
+        __m128d hi = _mm_mul_pd (maxVal, _mm_cvtps_pd (_mm_movehl_ps (s, s)));
+
+        if (dither.isActive())
+        {
+            const double n0 = dither.getNextNoise();
+            const double n1 = dither.getNextNoise();
+            const double n2 = dither.getNextNoise();
+            const double n3 = dither.getNextNoise();
+            lo = _mm_add_pd (lo, _mm_set_pd (n1, n0));
+            hi = _mm_add_pd (hi, _mm_set_pd (n3, n2));
+        }
+
+        lo = _mm_min_pd (_mm_max_pd (lo, minVal), maxVal);
+        hi = _mm_min_pd (_mm_max_pd (hi, minVal), maxVal);
+        return _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (lo), _mm_cvtpd_epi32 (hi));
+    }
+
+    forcedinline __m128i swapBytes16 (const __m128i v) noexcept
+    {
+        return _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+    }
+
+    // packed 16-bit samples, eight at a time. Returns the number of samples done
+    int convertFloatToPacked16 (const float* source, char* intData, const int numSamples,
+                                const bool bigEndian, AudioDataConverters::Dither& dither) noexcept
+    {
+        const __m128d maxVal = _mm_set1_pd ((double) 0x7fff);
+        const __m128d minVal = _mm_set1_pd (-(double) 0x7fff);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i a = scaleFour (source + i, maxVal, minVal, dither);
+            const __m128i b = scaleFour (source + i + 4, maxVal, minVal, dither);
+            const __m128i v = _mm_packs_epi32 (a, b);
+            _mm_storeu_si128 ((__m128i*) (intData + i * 2), bigEndian ? swapBytes16 (v) : v);
+        }
+
+        return i;
+    }
+
+    struct Int16LEWriter  { static forcedinline void write (const int v, char* d) noexcept  { *(uint16*) d = ByteOrder::swapIfBigEndian ((uint16) (short) v); } };
+    struct Int16BEWriter  { static forcedinline void write (const int v, char* d) noexcept  { *(uint16*) d = ByteOrder::swapIfLittleEndian ((uint16) (short) v); } };
+    struct Int24LEWriter  { static forcedinline void write (const int v, char* d) noexcept  { ByteOrder::littleEndian24BitToChars ((uint32) v, d); } };
+    struct Int24BEWriter  { static forcedinline void write (const int v, char* d) noexcept  { ByteOrder::bigEndian24BitToChars ((uint32) v, d); } };
+
+    // any stride, the arithmetic four samples at a time and the stores one by one.
+    // Returns the number of samples done
+    template <class Writer>
+    int convertFloatToInt (const float* source, char* intData, const int numSamples, const int destBytesPerSample,
+                           const double maxValue, AudioDataConverters::Dither& dither) noexcept
+    {
+        const __m128d maxVal = _mm_set1_pd (maxValue);
+        const __m128d minVal = _mm_set1_pd (-maxValue);
+        int32 values[4];
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            _mm_storeu_si128 ((__m128i*) values, scaleFour (source + i, maxVal, minVal, dither));
+
+            for (int j = 0; j < 4; ++j)
+            {
+                Writer::write (values[j], intData);
+                intData += destBytesPerSample;
+            }
+        }
+
+        return i;
+    }
+
+    // packed 16-bit samples, eight at a time, the same as scale * (short) value.
+    // Returns the number of samples done
+    int convertPacked16ToFloat (const char* intData, float* dest, const int numSamples,
+                                const bool bigEndian, const float scale) noexcept
+    {
+        const __m128 s = _mm_set1_ps (scale);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m128i v = _mm_loadu_si128 ((const __m128i*) (intData + i * 2));
+
+            if (bigEndian)
+                v = swapBytes16 (v);
+
+            _mm_storeu_ps (dest + i,     _mm_mul_ps (s, _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16))));
+            _mm_storeu_ps (dest + i + 4, _mm_mul_ps (s, _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16))));
+        }
+
+        return i;
+    }
+}
+#endif
 
 
 //==============================================================================
 void AudioDataConverters::convertFloatToInt16LE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+    Dither noDither;
+    convertFloatToInt16LE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt16LE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
     const double maxVal = (double) 0x7fff;
     char* intData = static_cast <char*> (dest);
 
     if (dest != (void*) source || destBytesPerSample <= 4)
     {
-        for (int i = 0; i < numSamples; ++i)
+        int i = 0;
+
+       #if JUCE_USE_SSE2_CONVERTERS
+        if (SystemStats::canUseSSE2())
+        {
+            i = destBytesPerSample == 2 ? AudioDataConverterHelpers::convertFloatToPacked16 (source, intData, numSamples, false, dither)
+                                        : AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int16LEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+            intData += i * destBytesPerSample;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
         {
-            *(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+            *(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
             intData += destBytesPerSample;
         }
     }
@@ -51,21 +180,38 @@ void AudioDataConverters::convertFloatToInt16LE (const float* source, void* dest
         for (int i = numSamples; --i >= 0;)
         {
             intData -= destBytesPerSample;
-            *(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+            *(uint16*) intData = ByteOrder::swapIfBigEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
         }
     }
 }
 
 void AudioDataConverters::convertFloatToInt16BE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+    Dither noDither;
+    convertFloatToInt16BE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt16BE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
     const double maxVal = (double) 0x7fff;
     char* intData = static_cast <char*> (dest);
 
     if (dest != (void*) source || destBytesPerSample <= 4)
     {
-        for (int i = 0; i < numSamples; ++i)
+        int i = 0;
+
+       #if JUCE_USE_SSE2_CONVERTERS
+        if (SystemStats::canUseSSE2())
         {
-            *(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+            i = destBytesPerSample == 2 ? AudioDataConverterHelpers::convertFloatToPacked16 (source, intData, numSamples, true, dither)
+                                        : AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int16BEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+            intData += i * destBytesPerSample;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            *(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
             intData += destBytesPerSample;
         }
     }
@@ -76,21 +222,37 @@ void AudioDataConverters::convertFloatToInt16BE (const float* source, void* dest
         for (int i = numSamples; --i >= 0;)
         {
             intData -= destBytesPerSample;
-            *(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])));
+            *(uint16*) intData = ByteOrder::swapIfLittleEndian ((uint16) (short) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())));
         }
     }
 }
 
 void AudioDataConverters::convertFloatToInt24LE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+    Dither noDither;
+    convertFloatToInt24LE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt24LE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
     const double maxVal = (double) 0x7fffff;
     char* intData = static_cast <char*> (dest);
 
     if (dest != (void*) source || destBytesPerSample <= 4)
     {
-        for (int i = 0; i < numSamples; ++i)
+        int i = 0;
+
+       #if JUCE_USE_SSE2_CONVERTERS
+        if (SystemStats::canUseSSE2())
+        {
+            i = AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int24LEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+            intData += i * destBytesPerSample;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
         {
-            ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+            ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
             intData += destBytesPerSample;
         }
     }
@@ -101,21 +263,37 @@ void AudioDataConverters::convertFloatToInt24LE (const float* source, void* dest
         for (int i = numSamples; --i >= 0;)
         {
             intData -= destBytesPerSample;
-            ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+            ByteOrder::littleEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
         }
     }
 }
 
 void AudioDataConverters::convertFloatToInt24BE (const float* source, void* dest, int numSamples, const int destBytesPerSample)
+{
+    Dither noDither;
+    convertFloatToInt24BE (source, dest, numSamples, destBytesPerSample, noDither);
+}
+
+void AudioDataConverters::convertFloatToInt24BE (const float* source, void* dest, int numSamples, const int destBytesPerSample, Dither& dither)
 {
     const double maxVal = (double) 0x7fffff;
     char* intData = static_cast <char*> (dest);
 
     if (dest != (void*) source || destBytesPerSample <= 4)
     {
-        for (int i = 0; i < numSamples; ++i)
+        int i = 0;
+
+       #if JUCE_USE_SSE2_CONVERTERS
+        if (SystemStats::canUseSSE2())
         {
-            ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+            i = AudioDataConverterHelpers::convertFloatToInt<AudioDataConverterHelpers::Int24BEWriter> (source, intData, numSamples, destBytesPerSample, maxVal, dither);
+            intData += i * destBytesPerSample;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
             intData += destBytesPerSample;
         }
     }
@@ -126,7 +304,7 @@ void AudioDataConverters::convertFloatToInt24BE (const float* source, void* dest
         for (int i = numSamples; --i >= 0;)
         {
             intData -= destBytesPerSample;
-            ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i])), intData);
+            ByteOrder::bigEndian24BitToChars ((uint32) roundToInt (jlimit (-maxVal, maxVal, maxVal * source[i] + dither.getNextNoise())), intData);
         }
     }
 }
@@ -225,7 +403,17 @@ void AudioDataConverters::convertInt16LEToFloat (const void* const source, float
 
     if (source != (void*) dest || srcBytesPerSample >= 4)
     {
-        for (int i = 0; i < numSamples; ++i)
+        int i = 0;
+
+       #if JUCE_USE_SSE2_CONVERTERS
+        if (srcBytesPerSample == 2 && SystemStats::canUseSSE2())
+        {
+            i = AudioDataConverterHelpers::convertPacked16ToFloat (intData, dest, numSamples, false, scale);
+            intData += i * srcBytesPerSample;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
         {
             dest[i] = scale * (short) ByteOrder::swapIfBigEndian (*(uint16*)intData);
             intData += srcBytesPerSample;
@@ -250,7 +438,17 @@ void AudioDataConverters::convertInt16BEToFloat (const void* const source, float
 
     if (source != (void*) dest || srcBytesPerSample >= 4)
     {
-        for (int i = 0; i < numSamples; ++i)
+        int i = 0;
+
+       #if JUCE_USE_SSE2_CONVERTERS
+        if (srcBytesPerSample == 2 && SystemStats::canUseSSE2())
+        {
+            i = AudioDataConverterHelpers::convertPacked16ToFloat (intData, dest, numSamples, true, scale);
+            intData += i * srcBytesPerSample;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
         {
             dest[i] = scale * (short) ByteOrder::swapIfLittleEndian (*(uint16*)intData);
             intData += srcBytesPerSample;
@@ -423,6 +621,22 @@ void AudioDataConverters::convertFloatToFormat (const DataFormat destFormat,
     }
 }
 
+void AudioDataConverters::convertFloatToFormat (const DataFormat destFormat,
+                                                const float* const source,
+                                                void* const dest,
+                                                const int numSamples,
+                                                Dither& dither)
+{
+    switch (destFormat)
+    {
+        case int16LE:       convertFloatToInt16LE   (source, dest, numSamples, 2, dither); break;
+        case int16BE:       convertFloatToInt16BE   (source, dest, numSamples, 2, dither); break;
+        case int24LE:       convertFloatToInt24LE   (source, dest, numSamples, 3, dither); break;
+        case int24BE:       convertFloatToInt24BE   (source, dest, numSamples, 3, dither); break;
+        default:            convertFloatToFormat    (destFormat, source, dest, numSamples); break;
+    }
+}
+
 void AudioDataConverters::convertFormatToFloat (const DataFormat sourceFormat,
                                                 const void* const source,
                                                 float* const dest,
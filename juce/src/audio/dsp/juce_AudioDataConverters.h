@@ -587,6 +587,49 @@ public:
 class JUCE_API  AudioDataConverters
 {
 public:
+    //==============================================================================
+    /**
+        The noise that is added to the samples before they're rounded to 16 or 24 bits.
+
+        Triangular dither adds the difference of two uniform random numbers, up to one
+        step of the output format either way, which turns the rounding error of quiet
+        signals into a constant noise floor instead of distortion. Keep one Dither for
+        each channel from one block to the next.
+    */
+    class JUCE_API  Dither
+    {
+    public:
+        enum Type
+        {
+            none,           /**< Plain rounding, the same results as the functions without a Dither. */
+            triangular      /**< TPDF noise of up to +/- 1 LSB. */
+        };
+
+        explicit Dither (Type type_ = none, uint32 seed = 1) noexcept
+            : type (type_), state (seed != 0 ? seed : 1)
+        {
+        }
+
+        bool isActive() const noexcept      { return type != none; }
+
+        /** Returns the noise for the next sample, in steps of the output format. */
+        inline double getNextNoise() noexcept
+        {
+            if (type == none)
+                return 0.0;
+
+            // xorshift32, its two halves are the two uniform numbers
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return ((int) (state & 0xffff) - (int) (state >> 16)) * (1.0 / 65536.0);
+        }
+
+    private:
+        Type type;
+        uint32 state;
+    };
+
     //==============================================================================
     static void convertFloatToInt16LE (const float* source, void* dest, int numSamples, int destBytesPerSample = 2);
     static void convertFloatToInt16BE (const float* source, void* dest, int numSamples, int destBytesPerSample = 2);
@@ -594,6 +637,13 @@ public:
     static void convertFloatToInt24LE (const float* source, void* dest, int numSamples, int destBytesPerSample = 3);
     static void convertFloatToInt24BE (const float* source, void* dest, int numSamples, int destBytesPerSample = 3);
 
+    /** These take a Dither, which keeps its state from one call to the next. */
+    static void convertFloatToInt16LE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+    static void convertFloatToInt16BE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+
+    static void convertFloatToInt24LE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+    static void convertFloatToInt24BE (const float* source, void* dest, int numSamples, int destBytesPerSample, Dither& dither);
+
     static void convertFloatToInt32LE (const float* source, void* dest, int numSamples, int destBytesPerSample = 4);
     static void convertFloatToInt32BE (const float* source, void* dest, int numSamples, int destBytesPerSample = 4);
 
@@ -629,6 +679,11 @@ public:
     static void convertFloatToFormat (DataFormat destFormat,
                                       const float* source, void* dest, int numSamples);
 
+    /** The dither applies to the 16 and 24 bit formats, the others ignore it. */
+    static void convertFloatToFormat (DataFormat destFormat,
+                                      const float* source, void* dest, int numSamples,
+                                      Dither& dither);
+
     static void convertFormatToFloat (DataFormat sourceFormat,
                                       const void* source, float* dest, int numSamples);
 
@@ -25,11 +25,258 @@
 
 #include "../../core/juce_StandardHeader.h"
 
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE2__)) && ! defined (JUCE_DISABLE_SSE2_AUDIO_BUFFERS)
+ #define JUCE_USE_SSE2_AUDIO_BUFFERS 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioSampleBuffer.h"
 #include "../audio_file_formats/juce_AudioFormatReader.h"
 #include "../audio_file_formats/juce_AudioFormatWriter.h"
+#include "../../core/juce_SystemStats.h"
+
+
+//==============================================================================
+namespace AudioSampleBufferHelpers
+{
+    // the channels of an allocated buffer start on 32-byte boundaries, which the
+    // 32 spare bytes at the end of the block leave room for
+    inline int getPaddedSize (const int numSamples) noexcept
+    {
+        return (numSamples + 7) & ~7;
+    }
+
+    inline float* getFirstChannel (char* const data, const size_t channelListSize) noexcept
+    {
+        return reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (data + channelListSize) + 31) & ~(pointer_sized_int) 31);
+    }
+
+   #if JUCE_USE_SSE2_AUDIO_BUFFERS
+    // the gains of the next four samples of a ramp
+    forcedinline __m128 getRampGains (const float gain, const float increment) noexcept
+    {
+        return _mm_add_ps (_mm_set1_ps (gain), _mm_mul_ps (_mm_set1_ps (increment), _mm_set_ps (3.0f, 2.0f, 1.0f, 0.0f)));
+    }
+   #endif
+
+    // The kernels below do as many samples as they can four at a time and leave
+    // the rest to the same scalar loops as before.
+    void multiply (float* const d, const int numSamples, const float gain) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            const __m128 g = _mm_set1_ps (gain);
+
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (d + i, _mm_mul_ps (_mm_loadu_ps (d + i), g));
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            d[i] *= gain;
+    }
+
+    void multiplyWithRamp (float* const d, const int numSamples, float gain, const float increment) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            __m128 g = getRampGains (gain, increment);
+            const __m128 step = _mm_set1_ps (increment * 4.0f);
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                _mm_storeu_ps (d + i, _mm_mul_ps (_mm_loadu_ps (d + i), g));
+                g = _mm_add_ps (g, step);
+            }
+
+            gain += increment * i;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            d[i] *= gain;
+            gain += increment;
+        }
+    }
+
+    void add (float* const d, const float* const s, const int numSamples) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (d + i, _mm_add_ps (_mm_loadu_ps (d + i), _mm_loadu_ps (s + i)));
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            d[i] += s[i];
+    }
+
+    void addWithGain (float* const d, const float* const s, const int numSamples, const float gain) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            const __m128 g = _mm_set1_ps (gain);
+
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (d + i, _mm_add_ps (_mm_loadu_ps (d + i), _mm_mul_ps (g, _mm_loadu_ps (s + i))));
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            d[i] += gain * s[i];
+    }
+
+    void addWithRamp (float* const d, const float* const s, const int numSamples, float gain, const float increment) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            __m128 g = getRampGains (gain, increment);
+            const __m128 step = _mm_set1_ps (increment * 4.0f);
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                _mm_storeu_ps (d + i, _mm_add_ps (_mm_loadu_ps (d + i), _mm_mul_ps (g, _mm_loadu_ps (s + i))));
+                g = _mm_add_ps (g, step);
+            }
+
+            gain += increment * i;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            d[i] += gain * s[i];
+            gain += increment;
+        }
+    }
+
+    void copyWithGain (float* const d, const float* const s, const int numSamples, const float gain) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            const __m128 g = _mm_set1_ps (gain);
+
+            for (; i + 4 <= numSamples; i += 4)
+                _mm_storeu_ps (d + i, _mm_mul_ps (g, _mm_loadu_ps (s + i)));
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            d[i] = gain * s[i];
+    }
+
+    void copyWithRamp (float* const d, const float* const s, const int numSamples, float gain, const float increment) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2())
+        {
+            __m128 g = getRampGains (gain, increment);
+            const __m128 step = _mm_set1_ps (increment * 4.0f);
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                _mm_storeu_ps (d + i, _mm_mul_ps (g, _mm_loadu_ps (s + i)));
+                g = _mm_add_ps (g, step);
+            }
+
+            gain += increment * i;
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            d[i] = gain * s[i];
+            gain += increment;
+        }
+    }
+
+    // the largest absolute value, 0 for no samples
+    float findMagnitude (const float* const s, const int numSamples) noexcept
+    {
+        float mag = 0.0f;
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2() && numSamples >= 4)
+        {
+            const __m128 signMask = _mm_set1_ps (-0.0f);
+            __m128 m = _mm_setzero_ps();
+
+            for (; i + 4 <= numSamples; i += 4)
+                m = _mm_max_ps (m, _mm_andnot_ps (signMask, _mm_loadu_ps (s + i)));
+
+            m = _mm_max_ps (m, _mm_movehl_ps (m, m));
+            m = _mm_max_ss (m, _mm_shuffle_ps (m, m, 1));
+            _mm_store_ss (&mag, m);
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            mag = jmax (mag, std::abs (s[i]));
+
+        return mag;
+    }
+
+    // the squares are rounded to floats and summed up as doubles, like the scalar loop,
+    // in two sums of two lanes each
+    double sumOfSquares (const float* const s, const int numSamples) noexcept
+    {
+        double sum = 0.0;
+        int i = 0;
+
+       #if JUCE_USE_SSE2_AUDIO_BUFFERS
+        if (SystemStats::canUseSSE2() && numSamples >= 4)
+        {
+            __m128d lo = _mm_setzero_pd();
+            __m128d hi = _mm_setzero_pd();
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const __m128 v = _mm_loadu_ps (s + i);
+                const __m128 squares = _mm_mul_ps (v, v);
+                lo = _mm_add_pd (lo, _mm_cvtps_pd (squares));
+                hi = _mm_add_pd (hi, _mm_cvtps_pd (_mm_movehl_ps (squares, squares)));
+            }
+
+            double sums[2];
+            _mm_storeu_pd (sums, _mm_add_pd (lo, hi));
+            sum = sums[0] + sums[1];
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+        {
+            const float sample = s[i];
+            sum += sample * sample;
+        }
+
+        return sum;
+    }
+}
 
 
 //==============================================================================
@@ -58,15 +305,16 @@ AudioSampleBuffer::AudioSampleBuffer (const AudioSampleBuffer& other) noexcept
 void AudioSampleBuffer::allocateData()
 {
     const size_t channelListSize = (numChannels + 1) * sizeof (float*);
-    allocatedBytes = (int) (numChannels * size * sizeof (float) + channelListSize + 32);
+    const int paddedSize = AudioSampleBufferHelpers::getPaddedSize (size);
+    allocatedBytes = (int) (numChannels * paddedSize * sizeof (float) + channelListSize + 32);
     allocatedData.malloc (allocatedBytes);
     channels = reinterpret_cast <float**> (allocatedData.getData());
 
-    float* chan = (float*) (allocatedData + channelListSize);
+    float* chan = AudioSampleBufferHelpers::getFirstChannel (allocatedData, channelListSize);
     for (int i = 0; i < numChannels; ++i)
     {
         channels[i] = chan;
-        chan += size;
+        chan += paddedSize;
     }
 
     channels [numChannels] = 0;
@@ -164,7 +412,8 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
     if (newNumSamples != size || newNumChannels != numChannels)
     {
         const size_t channelListSize = (newNumChannels + 1) * sizeof (float*);
-        const size_t newTotalBytes = (newNumChannels * newNumSamples * sizeof (float)) + channelListSize + 32;
+        const int paddedSize = AudioSampleBufferHelpers::getPaddedSize (newNumSamples);
+        const size_t newTotalBytes = (newNumChannels * paddedSize * sizeof (float)) + channelListSize + 32;
 
         if (keepExistingContent)
         {
@@ -174,12 +423,12 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
             const size_t numBytesToCopy = sizeof (float) * jmin (newNumSamples, size);
 
             float** const newChannels = reinterpret_cast <float**> (newData.getData());
-            float* newChan = reinterpret_cast <float*> (newData + channelListSize);
+            float* newChan = AudioSampleBufferHelpers::getFirstChannel (newData, channelListSize);
 
             for (int j = 0; j < newNumChannels; ++j)
             {
                 newChannels[j] = newChan;
-                newChan += newNumSamples;
+                newChan += paddedSize;
             }
 
             const int numChansToCopy = jmin (numChannels, newNumChannels);
@@ -204,11 +453,11 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
                 channels = reinterpret_cast <float**> (allocatedData.getData());
             }
 
-            float* chan = reinterpret_cast <float*> (allocatedData + channelListSize);
+            float* chan = AudioSampleBufferHelpers::getFirstChannel (allocatedData, channelListSize);
             for (int i = 0; i < newNumChannels; ++i)
             {
                 channels[i] = chan;
-                chan += newNumSamples;
+                chan += paddedSize;
             }
         }
 
@@ -261,8 +510,7 @@ void AudioSampleBuffer::applyGain (const int channel,
         }
         else
         {
-            while (--numSamples >= 0)
-                *d++ *= gain;
+            AudioSampleBufferHelpers::multiply (d, numSamples, gain);
         }
     }
 }
@@ -285,11 +533,7 @@ void AudioSampleBuffer::applyGainRamp (const int channel,
         const float increment = (endGain - startGain) / numSamples;
         float* d = channels [channel] + startSample;
 
-        while (--numSamples >= 0)
-        {
-            *d++ *= startGain;
-            startGain += increment;
-        }
+        AudioSampleBufferHelpers::multiplyWithRamp (d, numSamples, startGain, increment);
     }
 }
 
@@ -321,15 +565,9 @@ void AudioSampleBuffer::addFrom (const int destChannel,
         const float* s  = source.channels [sourceChannel] + sourceStartSample;
 
         if (gain != 1.0f)
-        {
-            while (--numSamples >= 0)
-                *d++ += gain * *s++;
-        }
+            AudioSampleBufferHelpers::addWithGain (d, s, numSamples, gain);
         else
-        {
-            while (--numSamples >= 0)
-                *d++ += *s++;
-        }
+            AudioSampleBufferHelpers::add (d, s, numSamples);
     }
 }
 
@@ -348,15 +586,9 @@ void AudioSampleBuffer::addFrom (const int destChannel,
         float* d = channels [destChannel] + destStartSample;
 
         if (gain != 1.0f)
-        {
-            while (--numSamples >= 0)
-                *d++ += gain * *source++;
-        }
+            AudioSampleBufferHelpers::addWithGain (d, source, numSamples, gain);
         else
-        {
-            while (--numSamples >= 0)
-                *d++ += *source++;
-        }
+            AudioSampleBufferHelpers::add (d, source, numSamples);
     }
 }
 
@@ -386,11 +618,7 @@ void AudioSampleBuffer::addFromWithRamp (const int destChannel,
             const float increment = (endGain - startGain) / numSamples;
             float* d = channels [destChannel] + destStartSample;
 
-            while (--numSamples >= 0)
-            {
-                *d++ += startGain * *source++;
-                startGain += increment;
-            }
+            AudioSampleBufferHelpers::addWithRamp (d, source, numSamples, startGain, increment);
         }
     }
 }
@@ -455,8 +683,7 @@ void AudioSampleBuffer::copyFrom (const int destChannel,
             }
             else
             {
-                while (--numSamples >= 0)
-                    *d++ = gain * *source++;
+                AudioSampleBufferHelpers::copyWithGain (d, source, numSamples, gain);
             }
         }
         else
@@ -492,11 +719,7 @@ void AudioSampleBuffer::copyFromWithRamp (const int destChannel,
             const float increment = (endGain - startGain) / numSamples;
             float* d = channels [destChannel] + destStartSample;
 
-            while (--numSamples >= 0)
-            {
-                *d++ = startGain * *source++;
-                startGain += increment;
-            }
+            AudioSampleBufferHelpers::copyWithRamp (d, source, numSamples, startGain, increment);
         }
     }
 }
@@ -520,10 +743,7 @@ float AudioSampleBuffer::getMagnitude (const int channel,
     jassert (isPositiveAndBelow (channel, numChannels));
     jassert (startSample >= 0 && startSample + numSamples <= size);
 
-    float mn, mx;
-    findMinMax (channel, startSample, numSamples, mn, mx);
-
-    return jmax (mn, -mn, mx, -mx);
+    return AudioSampleBufferHelpers::findMagnitude (channels [channel] + startSample, numSamples);
 }
 
 float AudioSampleBuffer::getMagnitude (const int startSample,
@@ -547,14 +767,7 @@ float AudioSampleBuffer::getRMSLevel (const int channel,
     if (numSamples <= 0 || channel < 0 || channel >= numChannels)
         return 0.0f;
 
-    const float* const data = channels [channel] + startSample;
-    double sum = 0.0;
-
-    for (int i = 0; i < numSamples; ++i)
-    {
-        const float sample = data [i];
-        sum += sample * sample;
-    }
+    const double sum = AudioSampleBufferHelpers::sumOfSquares (channels [channel] + startSample, numSamples);
 
     return (float) std::sqrt (sum / numSamples);
 }
@@ -35,6 +35,9 @@ class AudioFormatWriter;
 /**
     A multi-channel buffer of 32-bit floating point audio samples.
 
+    When the buffer allocates its own memory, every channel starts on a 32-byte
+    boundary and is padded to a multiple of 8 samples. The gain, add and level
+    methods use SSE2 where it's available.
 */
 class JUCE_API  AudioSampleBuffer
 {
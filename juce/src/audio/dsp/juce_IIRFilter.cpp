@@ -25,6 +25,11 @@
 
 #include "../../core/juce_StandardHeader.h"
 
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE__)) && ! defined (JUCE_DISABLE_SSE_FILTERS)
+ #define JUCE_USE_SSE_FILTERS 1
+ #include <xmmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_IIRFilter.h"
@@ -256,5 +261,317 @@ void IIRFilter::setCoefficients (double c1, double c2, double c3,
     active = true;
 }
 
+//==============================================================================
+#if JUCE_USE_SSE_FILTERS
+namespace IIRFilterBankHelpers
+{
+    // 64-bit CPUs always have SSE, 32-bit builds check it once
+    inline bool canUseSSE() noexcept
+    {
+       #if JUCE_64BIT
+        return true;
+       #else
+        static const bool hasSSE = SystemStats::hasSSE();
+        return hasSSE;
+       #endif
+    }
+
+    // the biquads of four neighbouring channels, with the same arithmetic as IIRFilter
+    struct FourChannels
+    {
+        __m128 b0, b1, b2, a1, a2, x1, x2, y1, y2;
+
+        forcedinline void load (const float* coefficients, const float* state, const int stride) noexcept
+        {
+            b0 = _mm_loadu_ps (coefficients);
+            b1 = _mm_loadu_ps (coefficients + stride);
+            b2 = _mm_loadu_ps (coefficients + stride * 2);
+            a1 = _mm_loadu_ps (coefficients + stride * 3);
+            a2 = _mm_loadu_ps (coefficients + stride * 4);
+            x1 = _mm_loadu_ps (state);
+            x2 = _mm_loadu_ps (state + stride);
+            y1 = _mm_loadu_ps (state + stride * 2);
+            y2 = _mm_loadu_ps (state + stride * 3);
+        }
+
+        forcedinline void save (float* coefficients, float* state, const int stride) const noexcept
+        {
+            _mm_storeu_ps (coefficients, b0);
+            _mm_storeu_ps (coefficients + stride, b1);
+            _mm_storeu_ps (coefficients + stride * 2, b2);
+            _mm_storeu_ps (coefficients + stride * 3, a1);
+            _mm_storeu_ps (coefficients + stride * 4, a2);
+            _mm_storeu_ps (state, x1);
+            _mm_storeu_ps (state + stride, x2);
+            _mm_storeu_ps (state + stride * 2, y1);
+            _mm_storeu_ps (state + stride * 3, y2);
+        }
+
+        forcedinline void step (const float* steps, const int stride) noexcept
+        {
+            b0 = _mm_add_ps (b0, _mm_loadu_ps (steps));
+            b1 = _mm_add_ps (b1, _mm_loadu_ps (steps + stride));
+            b2 = _mm_add_ps (b2, _mm_loadu_ps (steps + stride * 2));
+            a1 = _mm_add_ps (a1, _mm_loadu_ps (steps + stride * 3));
+            a2 = _mm_add_ps (a2, _mm_loadu_ps (steps + stride * 4));
+        }
+
+        forcedinline __m128 process (const __m128 in, const __m128 threshold, const __m128 signMask) noexcept
+        {
+            __m128 out = _mm_sub_ps (_mm_sub_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (b0, in), _mm_mul_ps (b1, x1)),
+                                                             _mm_mul_ps (b2, x2)),
+                                                 _mm_mul_ps (a1, y1)),
+                                     _mm_mul_ps (a2, y2));
+
+            // values within 1.0e-8 of 0 become 0, the same test as IIRFilter
+            out = _mm_and_ps (out, _mm_cmpgt_ps (_mm_andnot_ps (signMask, out), threshold));
+
+            x2 = x1;
+            x1 = in;
+            y2 = y1;
+            y1 = out;
+            return out;
+        }
+    };
+}
+#endif
+
+//==============================================================================
+IIRFilterBank::IIRFilterBank (const int numChannels_)
+    : numChannels (numChannels_),
+      coefficients (numCoefficients * numChannels_),
+      targets (numCoefficients * numChannels_),
+      steps (numCoefficients * numChannels_),
+      state (4 * numChannels_),
+      smoothingLength (0),
+      rampRemaining (0)
+{
+    jassert (numChannels_ > 0);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        coefficients[i] = 1.0f;
+
+        for (int j = 1; j < numCoefficients; ++j)
+            coefficients [j * numChannels + i] = 0;
+    }
+
+    memcpy (targets, coefficients, sizeof (float) * numCoefficients * numChannels);
+    zeromem (steps, sizeof (float) * numCoefficients * numChannels);
+    reset();
+}
+
+IIRFilterBank::~IIRFilterBank()
+{
+}
+
+void IIRFilterBank::setSmoothingLength (const int numSamples) noexcept
+{
+    smoothingLength = jmax (0, numSamples);
+}
+
+void IIRFilterBank::setCoefficients (const int channel, const IIRFilter& filter) noexcept
+{
+    jassert (isPositiveAndBelow (channel, numChannels));
+
+    float newCoefficients[numCoefficients] = { 1.0f, 0, 0, 0, 0 };
+
+    {
+        const ScopedLock sl (filter.processLock);
+
+        if (filter.active)
+        {
+            newCoefficients[0] = filter.coefficients[0];
+            newCoefficients[1] = filter.coefficients[1];
+            newCoefficients[2] = filter.coefficients[2];
+            newCoefficients[3] = filter.coefficients[4];
+            newCoefficients[4] = filter.coefficients[5];
+        }
+    }
+
+    for (int j = 0; j < numCoefficients; ++j)
+    {
+        const int index = j * numChannels + channel;
+        targets[index] = newCoefficients[j];
+
+        if (smoothingLength == 0)
+        {
+            coefficients[index] = newCoefficients[j];
+            steps[index] = 0;
+        }
+    }
+
+    if (smoothingLength > 0)
+    {
+        // every channel that's still moving starts a new ramp towards its target
+        const float scale = 1.0f / smoothingLength;
+
+        for (int i = numCoefficients * numChannels; --i >= 0;)
+            steps[i] = (targets[i] - coefficients[i]) * scale;
+
+        rampRemaining = smoothingLength;
+    }
+}
+
+void IIRFilterBank::reset() noexcept
+{
+    zeromem (state, sizeof (float) * 4 * numChannels);
+}
+
+//==============================================================================
+void IIRFilterBank::processInterleaved (float* frames, int numSamples) noexcept
+{
+    if (rampRemaining > 0)
+    {
+        const int numRamped = jmin (numSamples, rampRemaining);
+        processSection (frames, numRamped, true);
+        rampRemaining -= numRamped;
+
+        if (rampRemaining == 0)
+        {
+            // the steps don't add up to the targets exactly
+            memcpy (coefficients, targets, sizeof (float) * numCoefficients * numChannels);
+            zeromem (steps, sizeof (float) * numCoefficients * numChannels);
+        }
+
+        frames += numRamped * numChannels;
+        numSamples -= numRamped;
+    }
+
+    if (numSamples > 0)
+        processSection (frames, numSamples, false);
+}
+
+void IIRFilterBank::processSection (float* const frames, const int numSamples, const bool ramping) noexcept
+{
+    int channel = 0;
+
+   #if JUCE_USE_SSE_FILTERS
+    if (IIRFilterBankHelpers::canUseSSE())
+    {
+        for (; channel + 8 <= numChannels; channel += 8)
+            processEight (frames, channel, numSamples, ramping);
+
+        if (channel + 4 <= numChannels)
+        {
+            processFour (frames, channel, numSamples, ramping);
+            channel += 4;
+        }
+    }
+   #endif
+
+    for (; channel < numChannels; ++channel)
+        processScalar (frames, channel, numSamples, ramping);
+}
+
+void IIRFilterBank::processScalar (float* const frames, const int channel, const int numSamples, const bool ramping) noexcept
+{
+    float* const c = coefficients + channel;
+    const float* const s = steps + channel;
+    float* const st = state + channel;
+    const int stride = numChannels;
+
+    float b0 = c[0], b1 = c[stride], b2 = c[stride * 2], a1 = c[stride * 3], a2 = c[stride * 4];
+    float x1 = st[0], x2 = st[stride], y1 = st[stride * 2], y2 = st[stride * 3];
+
+    float* sample = frames + channel;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (ramping)
+        {
+            b0 += s[0];
+            b1 += s[stride];
+            b2 += s[stride * 2];
+            a1 += s[stride * 3];
+            a2 += s[stride * 4];
+        }
+
+        const float in = *sample;
+        float out = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+
+       #if JUCE_INTEL
+        if (! (out < -1.0e-8 || out > 1.0e-8))
+            out = 0;
+       #endif
+
+        x2 = x1;
+        x1 = in;
+        y2 = y1;
+        y1 = out;
+
+        *sample = out;
+        sample += stride;
+    }
+
+    c[0] = b0; c[stride] = b1; c[stride * 2] = b2; c[stride * 3] = a1; c[stride * 4] = a2;
+    st[0] = x1; st[stride] = x2; st[stride * 2] = y1; st[stride * 3] = y2;
+}
+
+void IIRFilterBank::processFour (float* const frames, const int channel, const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_USE_SSE_FILTERS
+    using namespace IIRFilterBankHelpers;
+    const int stride = numChannels;
+    const __m128 threshold = _mm_set1_ps (1.0e-8f);
+    const __m128 signMask = _mm_set1_ps (-0.0f);
+
+    FourChannels f;
+    f.load (coefficients + channel, state + channel, stride);
+
+    float* sample = frames + channel;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (ramping)
+            f.step (steps + channel, stride);
+
+        _mm_storeu_ps (sample, f.process (_mm_loadu_ps (sample), threshold, signMask));
+        sample += stride;
+    }
+
+    f.save (coefficients + channel, state + channel, stride);
+   #else
+    (void) frames; (void) channel; (void) numSamples; (void) ramping;
+   #endif
+}
+
+void IIRFilterBank::processEight (float* const frames, const int channel, const int numSamples, const bool ramping) noexcept
+{
+   #if JUCE_USE_SSE_FILTERS
+    using namespace IIRFilterBankHelpers;
+    const int stride = numChannels;
+    const __m128 threshold = _mm_set1_ps (1.0e-8f);
+    const __m128 signMask = _mm_set1_ps (-0.0f);
+
+    // two independent chains, so one can run while the other waits for its results
+    FourChannels f1, f2;
+    f1.load (coefficients + channel, state + channel, stride);
+    f2.load (coefficients + channel + 4, state + channel + 4, stride);
+
+    float* sample = frames + channel;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (ramping)
+        {
+            f1.step (steps + channel, stride);
+            f2.step (steps + channel + 4, stride);
+        }
+
+        const __m128 in1 = _mm_loadu_ps (sample);
+        const __m128 in2 = _mm_loadu_ps (sample + 4);
+        _mm_storeu_ps (sample, f1.process (in1, threshold, signMask));
+        _mm_storeu_ps (sample + 4, f2.process (in2, threshold, signMask));
+        sample += stride;
+    }
+
+    f1.save (coefficients + channel, state + channel, stride);
+    f2.save (coefficients + channel + 4, state + channel + 4, stride);
+   #else
+    (void) frames; (void) channel; (void) numSamples; (void) ramping;
+   #endif
+}
+
 
 END_JUCE_NAMESPACE
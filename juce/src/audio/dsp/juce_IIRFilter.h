@@ -27,6 +27,7 @@
 #define __JUCE_IIRFILTER_JUCEHEADER__
 
 #include "../../threads/juce_CriticalSection.h"
+#include "../../memory/juce_HeapBlock.h"
 
 
 //==============================================================================
@@ -142,10 +143,81 @@ protected:
     float coefficients[6];
     float x1, x2, y1, y2;
 
+    friend class IIRFilterBank;
+
     // (use the copyCoefficientsFrom() method instead of this operator)
     IIRFilter& operator= (const IIRFilter&);
     JUCE_LEAK_DETECTOR (IIRFilter);
 };
 
 
+//==============================================================================
+/**
+    Runs a biquad on each of a number of interleaved channels, with SSE on four
+    channels per instruction.
+
+    Every channel gets its coefficients from an IIRFilter that has been set up with
+    one of its make...() methods, so the bank filters exactly like that filter would.
+    Groups of eight channels are processed as two interleaved vectors, so that the two
+    chains hide each other's latency, and what's left over as one vector of four,
+    the remaining channels use scalar code.
+
+    A coefficient change can be ramped linearly over a number of samples, so that
+    moving an EQ doesn't click. Nothing is locked or allocated while processing, it's
+    meant to be called from the audio thread, and all set-up calls have to come from
+    that same thread.
+
+    @see IIRFilter
+*/
+class JUCE_API  IIRFilterBank
+{
+public:
+    //==============================================================================
+    /** Creates a bank of filters that all pass their channels through unchanged. */
+    explicit IIRFilterBank (int numChannels);
+
+    /** Destructor. */
+    ~IIRFilterBank();
+
+    //==============================================================================
+    /** Returns the number of channels, which is also the stride of the interleaved frames. */
+    int getNumChannels() const noexcept                 { return numChannels; }
+
+    /** Sets how many samples a coefficient change is ramped over. 0 (the default)
+        makes new coefficients take effect at once.
+    */
+    void setSmoothingLength (int numSamples) noexcept;
+
+    /** Makes a channel use the coefficients of a filter. An inactive filter lets
+        the channel pass through. The change is ramped over the smoothing length.
+    */
+    void setCoefficients (int channel, const IIRFilter& filter) noexcept;
+
+    /** Clears the state of all channels, the coefficients are kept. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Filters numSamples frames in place, the sample i of channel c being at
+        frames [i * getNumChannels() + c].
+    */
+    void processInterleaved (float* frames, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    enum { numCoefficients = 5 };   // b0, b1, b2, a1, a2, already divided by a0
+
+    const int numChannels;
+    HeapBlock<float> coefficients, targets, steps;  // [coefficient * numChannels + channel]
+    HeapBlock<float> state;                         // x1, x2, y1, y2 in the same layout
+    int smoothingLength, rampRemaining;
+
+    void processScalar (float* frames, int channel, int numSamples, bool ramping) noexcept;
+    void processFour (float* frames, int channel, int numSamples, bool ramping) noexcept;
+    void processEight (float* frames, int channel, int numSamples, bool ramping) noexcept;
+    void processSection (float* frames, int numSamples, bool ramping) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterBank);
+};
+
+
 #endif   // __JUCE_IIRFILTER_JUCEHEADER__
@@ -35,6 +35,11 @@
     Use setSampleRate() to prepare it, and then call processStereo() or processMono() to
     apply the reverb to your audio data.
 
+    The audio is processed in blocks: the eight comb filters of a channel are run
+    together, with SSE on Intel CPUs that have it (define JUCE_DISABLE_SSE_REVERB
+    to turn that off), and each allpass filter then runs across the whole block.
+    The results are the same as running every filter sample by sample.
+
     @see ReverbAudioSource
 */
 class Reverb
@@ -107,8 +112,8 @@ public:
         int i;
         for (i = 0; i < numCombs; ++i)
         {
-            comb[0][i].setSize ((intSampleRate * combTunings[i]) / 44100);
-            comb[1][i].setSize ((intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
+            combs[0].setSize (i, (intSampleRate * combTunings[i]) / 44100);
+            combs[1].setSize (i, (intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
         }
 
         for (i = 0; i < numAllPasses; ++i)
@@ -125,11 +130,9 @@ public:
     {
         for (int j = 0; j < numChannels; ++j)
         {
-            int i;
-            for (i = 0; i < numCombs; ++i)
-                comb[j][i].clear();
+            combs[j].clear();
 
-            for (i = 0; i < numAllPasses; ++i)
+            for (int i = 0; i < numAllPasses; ++i)
                 allPass[j][i].clear();
         }
     }
@@ -143,26 +146,32 @@ public:
         if (shouldUpdateDamping)
             updateDamping();
 
-        for (int i = 0; i < numSamples; ++i)
+        float input [blockSize], outL [blockSize], outR [blockSize];
+
+        for (int start = 0; start < numSamples; start += blockSize)
         {
-            const float input = (left[i] + right[i]) * gain;
-            float outL = 0, outR = 0;
+            const int num = jmin ((int) blockSize, numSamples - start);
+            float* const l = left + start;
+            float* const r = right + start;
+
+            int i;
+            for (i = 0; i < num; ++i)
+                input[i] = (l[i] + r[i]) * gain;
+
+            combs[0].process (input, outL, num);  // accumulate the comb filters in parallel
+            combs[1].process (input, outR, num);
 
-            int j;
-            for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
+            for (int j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
             {
-                outL += comb[0][j].process (input);
-                outR += comb[1][j].process (input);
+                allPass[0][j].process (outL, num);
+                allPass[1][j].process (outR, num);
             }
 
-            for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
+            for (i = 0; i < num; ++i)
             {
-                outL = allPass[0][j].process (outL);
-                outR = allPass[1][j].process (outR);
+                l[i] = outL[i] * wet1 + outR[i] * wet2 + l[i] * dry;
+                r[i] = outR[i] * wet1 + outL[i] * wet2 + r[i] * dry;
             }
-
-            left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
-            right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
         }
     }
 
@@ -174,19 +183,24 @@ public:
         if (shouldUpdateDamping)
             updateDamping();
 
-        for (int i = 0; i < numSamples; ++i)
+        float input [blockSize], output [blockSize];
+
+        for (int start = 0; start < numSamples; start += blockSize)
         {
-            const float input = samples[i] * gain;
-            float output = 0;
+            const int num = jmin ((int) blockSize, numSamples - start);
+            float* const s = samples + start;
 
-            int j;
-            for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-                output += comb[0][j].process (input);
+            int i;
+            for (i = 0; i < num; ++i)
+                input[i] = s[i] * gain;
+
+            combs[0].process (input, output, num);  // accumulate the comb filters in parallel
 
-            for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-                output = allPass[0][j].process (output);
+            for (int j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
+                allPass[0][j].process (output, num);
 
-            samples[i] = output * wet1 + input * dry;
+            for (i = 0; i < num; ++i)
+                s[i] = output[i] * wet1 + input[i] * dry;
         }
     }
 
@@ -217,32 +231,78 @@ private:
     void setDamping (const float dampingToUse, const float roomSizeToUse) noexcept
     {
         for (int j = 0; j < numChannels; ++j)
-            for (int i = numCombs; --i >= 0;)
-                comb[j][i].setFeedbackAndDamp (roomSizeToUse, dampingToUse);
+            combs[j].setFeedbackAndDamp (roomSizeToUse, dampingToUse);
+    }
+
+   #if JUCE_USE_SSE_REVERB
+    static bool canUseSSE() noexcept
+    {
+       #if JUCE_64BIT
+        return true;
+       #else
+        static const bool hasSSE = SystemStats::hasSSE();
+        return hasSSE;
+       #endif
+    }
+
+    // the vector version of JUCE_UNDENORMALISE
+    static inline __m128 undenormalise (__m128 v) noexcept
+    {
+       #if JUCE_32BIT
+        const __m128 one = _mm_set1_ps (1.0f);
+        v = _mm_sub_ps (_mm_add_ps (v, one), one);
+       #endif
+        return v;
     }
+   #endif
 
     //==============================================================================
-    class CombFilter
+    enum { numCombs = 8, numAllPasses = 4, numChannels = 2, blockSize = 256 };
+
+    //==============================================================================
+    /** The comb filters of one channel. They all share the same feedback and damping,
+        and their outputs are added up.
+
+        A block is cut where the first of the delay lines wraps around, within such a
+        part every comb reads and writes a contiguous run of its buffer. With SSE four
+        samples of four combs are loaded at a time and transposed, so that the damping
+        of all eight combs is updated with two vectors per sample.
+    */
+    class CombBank
     {
     public:
-        CombFilter() noexcept  : bufferSize (0), bufferIndex (0) {}
+        CombBank() noexcept  : feedback (0), damp1 (0), damp2 (0)
+        {
+            for (int i = 0; i < numCombs; ++i)
+            {
+                bufferSizes[i] = 0;
+                bufferIndexes[i] = 0;
+                last[i] = 0;
+            }
+        }
 
-        void setSize (const int size)
+        void setSize (const int combIndex, int size)
         {
-            if (size != bufferSize)
+            size = jmax (1, size);
+
+            if (size != bufferSizes [combIndex])
             {
-                bufferIndex = 0;
-                buffer.malloc (size);
-                bufferSize = size;
+                bufferIndexes [combIndex] = 0;
+                buffers [combIndex].malloc (size);
+                bufferSizes [combIndex] = size;
             }
 
-            clear();
+            last [combIndex] = 0;
+            buffers [combIndex].clear (size);
         }
 
         void clear() noexcept
         {
-            last = 0;
-            buffer.clear (bufferSize);
+            for (int i = 0; i < numCombs; ++i)
+            {
+                last[i] = 0;
+                buffers[i].clear (bufferSizes[i]);
+            }
         }
 
         void setFeedbackAndDamp (const float f, const float d) noexcept
@@ -252,25 +312,154 @@ private:
             feedback = f;
         }
 
-        inline float process (const float input) noexcept
+        /** Writes the sum of the comb outputs for each input sample to output. */
+        void process (const float* input, float* output, int numSamples) noexcept
         {
-            const float output = buffer [bufferIndex];
-            last = (output * damp2) + (last * damp1);
-            JUCE_UNDENORMALISE (last);
-
-            float temp = input + (last * feedback);
-            JUCE_UNDENORMALISE (temp);
-            buffer [bufferIndex] = temp;
-            bufferIndex = (bufferIndex + 1) % bufferSize;
-            return output;
+            while (numSamples > 0)
+            {
+                int num = numSamples;
+                float* runs [numCombs];
+
+                int i;
+                for (i = 0; i < numCombs; ++i)
+                {
+                    num = jmin (num, bufferSizes[i] - bufferIndexes[i]);
+                    runs[i] = buffers[i] + bufferIndexes[i];
+                }
+
+               #if JUCE_USE_SSE_REVERB
+                if (canUseSSE())
+                    processRunSSE (runs, input, output, num);
+                else
+               #endif
+                    processRun (runs, input, output, num);
+
+                for (i = 0; i < numCombs; ++i)
+                {
+                    bufferIndexes[i] += num;
+
+                    if (bufferIndexes[i] >= bufferSizes[i])
+                        bufferIndexes[i] = 0;
+                }
+
+                input += num;
+                output += num;
+                numSamples -= num;
+            }
         }
 
     private:
-        HeapBlock<float> buffer;
-        int bufferSize, bufferIndex;
-        float feedback, last, damp1, damp2;
+        HeapBlock<float> buffers [numCombs];
+        int bufferSizes [numCombs], bufferIndexes [numCombs];
+        float last [numCombs];
+        float feedback, damp1, damp2;
+
+        void processRun (float* const* runs, const float* input, float* output, const int num) noexcept
+        {
+            int i;
+            for (i = 0; i < num; ++i)
+                output[i] = 0;
+
+            for (int j = 0; j < numCombs; ++j)
+            {
+                float* const buffer = runs[j];
+                float lastValue = last[j];
+
+                for (i = 0; i < num; ++i)
+                {
+                    const float bufferedValue = buffer[i];
+                    lastValue = (bufferedValue * damp2) + (lastValue * damp1);
+                    JUCE_UNDENORMALISE (lastValue);
+
+                    float temp = input[i] + (lastValue * feedback);
+                    JUCE_UNDENORMALISE (temp);
+                    buffer[i] = temp;
+                    output[i] += bufferedValue;
+                }
+
+                last[j] = lastValue;
+            }
+        }
+
+       #if JUCE_USE_SSE_REVERB
+        // damps the buffered values of four combs for one input sample, and returns what goes back into the buffers
+        static inline __m128 processFour (const __m128& bufferedValues, __m128& lastValues, const float input,
+                                          const __m128& feedbacks, const __m128& damps1, const __m128& damps2) noexcept
+        {
+            lastValues = undenormalise (_mm_add_ps (_mm_mul_ps (bufferedValues, damps2), _mm_mul_ps (lastValues, damps1)));
+            return undenormalise (_mm_add_ps (_mm_set1_ps (input), _mm_mul_ps (lastValues, feedbacks)));
+        }
+
+        void processRunSSE (float* const* runs, const float* input, float* output, const int num) noexcept
+        {
+            const __m128 feedbacks = _mm_set1_ps (feedback);
+            const __m128 damps1 = _mm_set1_ps (damp1);
+            const __m128 damps2 = _mm_set1_ps (damp2);
+            __m128 lastLow = _mm_loadu_ps (last);
+            __m128 lastHigh = _mm_loadu_ps (last + 4);
+
+            int i = 0;
+            for (; i + 4 <= num; i += 4)
+            {
+                // one row per comb, four samples each
+                __m128 l0 = _mm_loadu_ps (runs[0] + i), l1 = _mm_loadu_ps (runs[1] + i);
+                __m128 l2 = _mm_loadu_ps (runs[2] + i), l3 = _mm_loadu_ps (runs[3] + i);
+                __m128 h0 = _mm_loadu_ps (runs[4] + i), h1 = _mm_loadu_ps (runs[5] + i);
+                __m128 h2 = _mm_loadu_ps (runs[6] + i), h3 = _mm_loadu_ps (runs[7] + i);
+
+                // added up in the same order as one comb after the other
+                __m128 sum = _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_setzero_ps(), l0), l1), l2), l3);
+                sum = _mm_add_ps (_mm_add_ps (_mm_add_ps (_mm_add_ps (sum, h0), h1), h2), h3);
+                _mm_storeu_ps (output + i, sum);
+
+                // now one row per sample, four combs each
+                _MM_TRANSPOSE4_PS (l0, l1, l2, l3);
+                _MM_TRANSPOSE4_PS (h0, h1, h2, h3);
+
+                l0 = processFour (l0, lastLow, input[i], feedbacks, damps1, damps2);
+                h0 = processFour (h0, lastHigh, input[i], feedbacks, damps1, damps2);
+                l1 = processFour (l1, lastLow, input[i + 1], feedbacks, damps1, damps2);
+                h1 = processFour (h1, lastHigh, input[i + 1], feedbacks, damps1, damps2);
+                l2 = processFour (l2, lastLow, input[i + 2], feedbacks, damps1, damps2);
+                h2 = processFour (h2, lastHigh, input[i + 2], feedbacks, damps1, damps2);
+                l3 = processFour (l3, lastLow, input[i + 3], feedbacks, damps1, damps2);
+                h3 = processFour (h3, lastHigh, input[i + 3], feedbacks, damps1, damps2);
+
+                _MM_TRANSPOSE4_PS (l0, l1, l2, l3);
+                _MM_TRANSPOSE4_PS (h0, h1, h2, h3);
+
+                _mm_storeu_ps (runs[0] + i, l0);  _mm_storeu_ps (runs[1] + i, l1);
+                _mm_storeu_ps (runs[2] + i, l2);  _mm_storeu_ps (runs[3] + i, l3);
+                _mm_storeu_ps (runs[4] + i, h0);  _mm_storeu_ps (runs[5] + i, h1);
+                _mm_storeu_ps (runs[6] + i, h2);  _mm_storeu_ps (runs[7] + i, h3);
+            }
+
+            for (; i < num; ++i)
+            {
+                float values [numCombs];
+                int j;
+                for (j = 0; j < numCombs; ++j)
+                    values[j] = runs[j][i];
+
+                float sum = 0;
+                for (j = 0; j < numCombs; ++j)
+                    sum += values[j];
+
+                output[i] = sum;
+
+                _mm_storeu_ps (values, processFour (_mm_loadu_ps (values), lastLow, input[i], feedbacks, damps1, damps2));
+                _mm_storeu_ps (values + 4, processFour (_mm_loadu_ps (values + 4), lastHigh, input[i], feedbacks, damps1, damps2));
 
-        JUCE_DECLARE_NON_COPYABLE (CombFilter);
+                for (j = 0; j < numCombs; ++j)
+                    runs[j][i] = values[j];
+            }
+
+            _mm_storeu_ps (last, lastLow);
+            _mm_storeu_ps (last + 4, lastHigh);
+        }
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (CombBank);
     };
 
     //==============================================================================
@@ -279,8 +468,10 @@ private:
     public:
         AllPassFilter() noexcept  : bufferSize (0), bufferIndex (0) {}
 
-        void setSize (const int size)
+        void setSize (int size)
         {
+            size = jmax (1, size);
+
             if (size != bufferSize)
             {
                 bufferIndex = 0;
@@ -296,14 +487,48 @@ private:
             buffer.clear (bufferSize);
         }
 
-        inline float process (const float input) noexcept
+        /** Filters a block of samples in place. */
+        void process (float* samples, int numSamples) noexcept
         {
-            const float bufferedValue = buffer [bufferIndex];
-            float temp = input + (bufferedValue * 0.5f);
-            JUCE_UNDENORMALISE (temp);
-            buffer [bufferIndex] = temp;
-            bufferIndex = (bufferIndex + 1) % bufferSize;
-            return bufferedValue - input;
+            while (numSamples > 0)
+            {
+                const int num = jmin (numSamples, bufferSize - bufferIndex);
+                float* const run = buffer + bufferIndex;
+                int i = 0;
+
+               #if JUCE_USE_SSE_REVERB
+                if (canUseSSE())
+                {
+                    const __m128 half = _mm_set1_ps (0.5f);
+
+                    for (; i + 4 <= num; i += 4)
+                    {
+                        const __m128 bufferedValues = _mm_loadu_ps (run + i);
+                        const __m128 inputs = _mm_loadu_ps (samples + i);
+                        _mm_storeu_ps (run + i, undenormalise (_mm_add_ps (inputs, _mm_mul_ps (bufferedValues, half))));
+                        _mm_storeu_ps (samples + i, _mm_sub_ps (bufferedValues, inputs));
+                    }
+                }
+               #endif
+
+                for (; i < num; ++i)
+                {
+                    const float input = samples[i];
+                    const float bufferedValue = run[i];
+                    float temp = input + (bufferedValue * 0.5f);
+                    JUCE_UNDENORMALISE (temp);
+                    run[i] = temp;
+                    samples[i] = bufferedValue - input;
+                }
+
+                bufferIndex += num;
+
+                if (bufferIndex >= bufferSize)
+                    bufferIndex = 0;
+
+                samples += num;
+                numSamples -= num;
+            }
         }
 
     private:
@@ -313,9 +538,7 @@ private:
         JUCE_DECLARE_NON_COPYABLE (AllPassFilter);
     };
 
-    enum { numCombs = 8, numAllPasses = 4, numChannels = 2 };
-
-    CombFilter comb [numChannels][numCombs];
+    CombBank combs [numChannels];
     AllPassFilter allPass [numChannels][numAllPasses];
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reverb);
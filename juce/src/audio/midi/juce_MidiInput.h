@@ -62,6 +62,25 @@ public:
     virtual void handleIncomingMidiMessage (MidiInput* source,
                                             const MidiMessage& message) = 0;
 
+    /** Receives a number of messages that were read from the device at once.
+
+        Where the device delivers its input in batches (currently ALSA on Linux), this
+        is called instead of handleIncomingMidiMessage() for each batch, on the same
+        thread. Each message keeps its own timestamp of when it arrived. The default
+        implementation just passes the messages one by one to handleIncomingMidiMessage().
+
+        @param source       the MidiInput object that generated the messages
+        @param messages     the messages, in the order they arrived
+        @param numMessages  the number of messages
+    */
+    virtual void handleIncomingMidiMessages (MidiInput* source,
+                                             const MidiMessage* messages,
+                                             int numMessages)
+    {
+        for (int i = 0; i < numMessages; ++i)
+            handleIncomingMidiMessage (source, messages[i]);
+    }
+
     /** Notification sent each time a packet of a multi-packet sysex message arrives.
 
         If a long sysex message is broken up into multiple packets, this callback is made
@@ -59,6 +59,12 @@ void MidiOutput::sendBlockOfMessages (const MidiBuffer& buffer,
     // this needs to be a value in the future - RTFM for this method!
     jassert (millisecondCounterToStartAt > 0);
 
+   #if JUCE_MAC
+    // CoreMIDI schedules the messages by their timestamps, so they don't have to wait in the queue
+    if (sendBlockScheduled (buffer, millisecondCounterToStartAt, samplesPerSecondForBuffer))
+        return;
+   #endif
+
     const double timeScaleFactor = 1000.0 / samplesPerSecondForBuffer;
 
     MidiBuffer::Iterator i (buffer);
@@ -96,6 +102,10 @@ void MidiOutput::sendBlockOfMessages (const MidiBuffer& buffer,
 
 void MidiOutput::clearAllPendingMessages()
 {
+   #if JUCE_MAC
+    flushScheduledMessages();
+   #endif
+
     const ScopedLock sl (lock);
 
     while (firstMessage != nullptr)
@@ -106,6 +116,21 @@ void MidiOutput::clearAllPendingMessages()
     }
 }
 
+#if ! (JUCE_LINUX || JUCE_WINDOWS || JUCE_MAC)
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+    for (int i = 0; i < numMessages; ++i)
+        sendMessageNow (*messages[i]);
+}
+
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+    sendMessageNow (MidiMessage ((int) (packedMessage & 0xff),
+                                 (int) ((packedMessage >> 8) & 0xff),
+                                 (int) ((packedMessage >> 16) & 0xff)));
+}
+#endif
+
 void MidiOutput::startBackgroundThread()
 {
     startThread (9);
@@ -156,10 +181,32 @@ void MidiOutput::run()
                     break;
             }
 
-            if (eventTime > now - 200)
-                sendMessageNow (message->message);
+            // everything else that is due by now goes out in the same batch
+            Array<PendingMessage*> batch;
+            batch.add (message);
+
+            {
+                const ScopedLock sl (lock);
+                const double batchTime = Time::getMillisecondCounter();
+
+                while (firstMessage != nullptr && firstMessage->message.getTimeStamp() <= batchTime)
+                {
+                    batch.add (firstMessage);
+                    firstMessage = firstMessage->next;
+                }
+            }
+
+            Array<const MidiMessage*> messagesToSend;
+
+            for (int i = 0; i < batch.size(); ++i)
+                if (roundToInt (batch.getUnchecked(i)->message.getTimeStamp()) > (int) (now - 200))
+                    messagesToSend.add (&(batch.getUnchecked(i)->message));
+
+            if (messagesToSend.size() > 0)
+                sendMessagesNow (messagesToSend.getRawDataPointer(), messagesToSend.size());
 
-            delete message;
+            for (int i = 0; i < batch.size(); ++i)
+                delete batch.getUnchecked(i);
         }
         else
         {
@@ -96,6 +96,17 @@ public:
     */
     virtual void sendMessageNow (const MidiMessage& message);
 
+    /** Makes this device output a message of up to three bytes, packed into an integer
+        the way midiOutShortMsg() takes it: the status byte in the lowest 8 bits and the
+        two data bytes above it.
+
+        On Windows, Linux and the Mac this goes to the driver without creating a
+        MidiMessage, which makes it the cheapest way to send controllers and notes.
+
+        @see sendMessageNow
+    */
+    virtual void sendShortMessageNow (uint32 packedMessage);
+
     //==============================================================================
     /** This lets you supply a block of messages that will be sent out at some point
         in the future.
@@ -146,6 +157,23 @@ protected:
     void run();
 
 private:
+    /** Sends a run of messages that the background thread found due at the same time.
+        On Linux this costs a single ALSA drain, on Windows a single long message and on
+        the Mac a single packet list, elsewhere the messages go out one by one.
+    */
+    void sendMessagesNow (const MidiMessage* const* messages, int numMessages);
+
+   #if JUCE_MAC
+    /** Hands a whole block to CoreMIDI in packet lists stamped with the host time of each
+        message, and CoreMIDI sends them when they're due. Returns false for a device that
+        can't schedule them, which then uses the background thread.
+    */
+    bool sendBlockScheduled (const MidiBuffer& buffer, double millisecondCounterToStartAt, double samplesPerSecondForBuffer);
+
+    /** Unschedules what sendBlockScheduled() has handed to CoreMIDI. */
+    void flushScheduledMessages();
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiOutput);
 };
 
@@ -355,6 +355,38 @@ public:
         new (data.elements + numUsed++) ElementType (newElement);
     }
 
+    /** Appends a default-constructed element and returns a reference to it.
+
+        This lets a large element be filled in where it is stored, instead of
+        being built on the stack and copied in by add(). The reference is only
+        valid until the array is next resized.
+
+        @see add, ensureStorageAllocated
+    */
+    ElementType& addNew()
+    {
+        const ScopedLockType lock (getLock());
+        data.ensureAllocatedSize (numUsed + 1);
+        return *new (data.elements + numUsed++) ElementType();
+    }
+
+    /** Appends an element constructed in place from a single argument, and
+        returns a reference to it.
+
+        This avoids the temporary that add() would copy from when the element
+        is made from a different type, e.g. a File from a path String.
+        The argument must not refer to an element of this array.
+
+        @see add, addNew
+    */
+    template <class ArgumentType>
+    ElementType& addNew (const ArgumentType& argument)
+    {
+        const ScopedLockType lock (getLock());
+        data.ensureAllocatedSize (numUsed + 1);
+        return *new (data.elements + numUsed++) ElementType (argument);
+    }
+
     /** Inserts a new element into the array at a given position.
 
         If the index is less than 0 or greater than the size of the array, the
@@ -101,6 +101,11 @@
   #include <intrin.h>
 #endif
 
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE__)) && ! defined (JUCE_DISABLE_SSE_REVERB)
+  #define JUCE_USE_SSE_REVERB 1
+  #include <xmmintrin.h>
+#endif
+
 #if JUCE_MAC || JUCE_IOS
   #include <libkern/OSAtomic.h>
 #endif
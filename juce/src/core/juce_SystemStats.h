@@ -134,6 +134,19 @@ public:
     /** Checks whether Intel SSE2 instructions are available. */
     static bool hasSSE2() noexcept              { return getCPUFlags().hasSSE2; }
 
+    /** True if the SSE2 code paths of the renderer and the audio classes may run.
+        64-bit CPUs always have SSE2, a 32-bit build asks hasSSE2() once.
+    */
+    static bool canUseSSE2() noexcept
+    {
+       #if JUCE_64BIT
+        return true;
+       #else
+        static const bool sse2 = hasSSE2();
+        return sse2;
+       #endif
+    }
+
     /** Checks whether AMD 3DNOW instructions are available. */
     static bool has3DNow() noexcept             { return getCPUFlags().has3DNow; }
 
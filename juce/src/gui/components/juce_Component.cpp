@@ -47,6 +47,7 @@ BEGIN_JUCE_NAMESPACE
 #define CHECK_MESSAGE_MANAGER_IS_LOCKED     jassert (MessageManager::getInstance()->currentThreadHasLockedMessageManager());
 
 Component* Component::currentlyFocusedComponent = nullptr;
+Component::PaintTimer* Component::currentPaintTimer = nullptr;
 
 
 //==============================================================================
@@ -1809,8 +1810,16 @@ void Component::internalRepaint (int x, int y, int w, int h)
 }
 
 //==============================================================================
+void Component::setPaintTimer (PaintTimer* newPaintTimer) noexcept
+{
+    currentPaintTimer = newPaintTimer;
+}
+
 void Component::paintComponent (Graphics& g)
 {
+    PaintTimer* const paintTimer = currentPaintTimer;
+    const double startTime = paintTimer != nullptr ? Time::getMillisecondCounterHiRes() : 0.0;
+
     if (flags.bufferToImageFlag)
     {
         if (bufferedImage.isNull())
@@ -1829,6 +1838,9 @@ void Component::paintComponent (Graphics& g)
     {
         paint (g);
     }
+
+    if (paintTimer != nullptr)
+        paintTimer->componentPainted (*this, Time::getMillisecondCounterHiRes() - startTime);
 }
 
 void Component::paintWithinParentContext (Graphics& g)
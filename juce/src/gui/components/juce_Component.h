@@ -1450,6 +1450,32 @@ public:
     */
     virtual void paintOverChildren (Graphics& g);
 
+    //==============================================================================
+    /** Receives the time that each call to a component's paint() method takes.
+
+        This is meant for profiling, see setPaintTimer().
+    */
+    class JUCE_API  PaintTimer
+    {
+    public:
+        /** Destructor. */
+        virtual ~PaintTimer() {}
+
+        /** Called on the message thread after a component's paint() method has returned.
+
+            A component that buffers itself to an image reports the time it took to
+            draw that image.
+        */
+        virtual void componentPainted (Component& component, double milliseconds) = 0;
+    };
+
+    /** Sets the PaintTimer that is told about every component that gets painted.
+
+        Pass nullptr to stop timing, which is the default. The timer isn't deleted
+        by the components, and must be removed before it is deleted.
+    */
+    static void JUCE_CALLTYPE setPaintTimer (PaintTimer* newPaintTimer) noexcept;
+
 
     //==============================================================================
     /** Called when the mouse moves inside this component.
@@ -2232,6 +2258,7 @@ private:
 
    #ifndef DOXYGEN
     static Component* currentlyFocusedComponent;
+    static PaintTimer* currentPaintTimer;
 
     //==============================================================================
     String componentName, componentID;
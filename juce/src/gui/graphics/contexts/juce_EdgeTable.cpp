@@ -31,18 +31,140 @@ BEGIN_JUCE_NAMESPACE
 #include "../geometry/juce_PathIterator.h"
 #include "../imaging/juce_Image.h"
 #include "../geometry/juce_RectangleList.h"
+#include "../../../threads/juce_Thread.h"
 
 const int juce_edgeTableDefaultEdgesPerLine = 32;
 
+//==============================================================================
+namespace EdgeTableHelpers
+{
+    /*  Most tables only live while one shape is drawn, so rather than freeing its memory
+        a table gives it to a cache of the thread that deletes it, and the next tables the
+        thread creates take it from there. A thread claims one of the slots the first
+        time it needs one and keeps it, so only that thread ever touches it and nothing
+        needs a lock. Threads that find no free slot just use the allocator.
+    */
+    class ScratchCache
+    {
+    public:
+        ScratchCache() noexcept  : isShutDown (false)
+        {
+            for (int i = 0; i < numSlots; ++i)
+                for (int j = 0; j < blocksPerSlot; ++j)
+                    slots[i].capacities[j] = 0;
+        }
+
+        ~ScratchCache() noexcept
+        {
+            isShutDown = true;
+        }
+
+        /** Gives block room for at least numElements, and returns how many it can hold. */
+        int allocate (HeapBlock<int>& block, const int numElements)
+        {
+            Slot* const slot = getSlot();
+
+            if (slot != nullptr)
+            {
+                // the smallest block that fits, but not one that would waste most of its space
+                int best = -1;
+
+                for (int i = 0; i < blocksPerSlot; ++i)
+                {
+                    const int capacity = slot->capacities[i];
+
+                    if (capacity >= numElements && capacity / 2 <= numElements
+                         && (best < 0 || capacity < slot->capacities[best]))
+                        best = i;
+                }
+
+                if (best >= 0)
+                {
+                    block.swapWith (slot->blocks[best]);
+                    const int capacity = slot->capacities[best];
+                    slot->capacities[best] = 0;
+                    return capacity;
+                }
+            }
+
+            block.malloc (numElements);
+            return numElements;
+        }
+
+        /** Takes over the memory of a block, which is empty afterwards. */
+        void release (HeapBlock<int>& block, const int capacity)
+        {
+            Slot* const slot = (capacity > 0 && capacity <= maxCachedElements) ? getSlot() : nullptr;
+
+            if (slot != nullptr)
+            {
+                // when the slot is full, the smallest block makes room for a bigger one
+                int smallest = 0;
+
+                for (int i = 1; i < blocksPerSlot; ++i)
+                    if (slot->capacities[i] < slot->capacities[smallest])
+                        smallest = i;
+
+                if (slot->capacities[smallest] < capacity)
+                {
+                    slot->blocks[smallest].swapWith (block);
+                    slot->capacities[smallest] = capacity;
+                }
+            }
+
+            block.free();
+        }
+
+    private:
+        enum { numSlots = 8, blocksPerSlot = 4, maxCachedElements = 256 * 1024 };
+
+        struct Slot
+        {
+            Atomic<Thread::ThreadID> owner;
+            HeapBlock<int> blocks [blocksPerSlot];
+            int capacities [blocksPerSlot];
+        };
+
+        Slot slots [numSlots];
+        bool isShutDown;
+
+        Slot* getSlot() noexcept
+        {
+            if (isShutDown)
+                return nullptr;
+
+            const Thread::ThreadID thread = Thread::getCurrentThreadId();
+
+            // slots are never given back, so a thread finds its own before any free one
+            for (int i = 0; i < numSlots; ++i)
+            {
+                Slot& slot = slots[i];
+                const Thread::ThreadID owner = slot.owner.get();
+
+                if (owner == thread
+                     || (owner == nullptr && slot.owner.compareAndSetBool (thread, nullptr)))
+                    return &slot;
+            }
+
+            return nullptr;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (ScratchCache);
+    };
+
+    static ScratchCache scratchCache;
+}
+
 //==============================================================================
 EdgeTable::EdgeTable (const Rectangle<int>& bounds_,
                       const Path& path, const AffineTransform& transform)
    : bounds (bounds_),
      maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
      lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+     tableCapacity (0),
      needToCheckEmptinesss (true)
 {
-    table.malloc ((bounds.getHeight() + 1) * lineStrideElements);
+    allocateTable ((bounds.getHeight() + 1) * lineStrideElements);
     int* t = table;
 
     for (int i = bounds.getHeight(); --i >= 0;)
@@ -114,9 +236,10 @@ EdgeTable::EdgeTable (const Rectangle<int>& rectangleToAdd)
    : bounds (rectangleToAdd),
      maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
      lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+     tableCapacity (0),
      needToCheckEmptinesss (true)
 {
-    table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+    allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
     table[0] = 0;
 
     const int x1 = rectangleToAdd.getX() << 8;
@@ -138,9 +261,10 @@ EdgeTable::EdgeTable (const RectangleList& rectanglesToAdd)
    : bounds (rectanglesToAdd.getBounds()),
      maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
      lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+     tableCapacity (0),
      needToCheckEmptinesss (true)
 {
-    table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+    allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
 
     int* t = table;
     for (int i = bounds.getHeight(); --i >= 0;)
@@ -175,10 +299,11 @@ EdgeTable::EdgeTable (const Rectangle<float>& rectangleToAdd)
                              2 + (int) rectangleToAdd.getHeight())),
      maxEdgesPerLine (juce_edgeTableDefaultEdgesPerLine),
      lineStrideElements ((juce_edgeTableDefaultEdgesPerLine << 1) + 1),
+     tableCapacity (0),
      needToCheckEmptinesss (true)
 {
     jassert (! rectangleToAdd.isEmpty());
-    table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+    allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
     table[0] = 0;
 
     const int x1 = roundToInt (rectangleToAdd.getX() * 256.0f);
@@ -247,6 +372,7 @@ EdgeTable::EdgeTable (const Rectangle<float>& rectangleToAdd)
 }
 
 EdgeTable::EdgeTable (const EdgeTable& other)
+   : tableCapacity (0)
 {
     operator= (other);
 }
@@ -258,13 +384,23 @@ EdgeTable& EdgeTable::operator= (const EdgeTable& other)
     lineStrideElements = other.lineStrideElements;
     needToCheckEmptinesss = other.needToCheckEmptinesss;
 
-    table.malloc (jmax (1, bounds.getHeight()) * lineStrideElements);
+    allocateTable (jmax (1, bounds.getHeight()) * lineStrideElements);
     copyEdgeTableData (table, lineStrideElements, other.table, lineStrideElements, bounds.getHeight());
     return *this;
 }
 
 EdgeTable::~EdgeTable()
 {
+    EdgeTableHelpers::scratchCache.release (table, tableCapacity);
+}
+
+void EdgeTable::allocateTable (const int numElements)
+{
+    if (tableCapacity < numElements)
+    {
+        EdgeTableHelpers::scratchCache.release (table, tableCapacity);
+        tableCapacity = EdgeTableHelpers::scratchCache.allocate (table, numElements);
+    }
 }
 
 //==============================================================================
@@ -338,11 +474,14 @@ void EdgeTable::remapTableForNumEdges (const int newNumEdgesPerLine)
         jassert (bounds.getHeight() > 0);
         const int newLineStrideElements = maxEdgesPerLine * 2 + 1;
 
-        HeapBlock <int> newTable (bounds.getHeight() * newLineStrideElements);
+        HeapBlock <int> newTable;
+        const int newCapacity = EdgeTableHelpers::scratchCache.allocate (newTable, bounds.getHeight() * newLineStrideElements);
 
         copyEdgeTableData (newTable, newLineStrideElements, table, lineStrideElements, bounds.getHeight());
 
         table.swapWith (newTable);
+        EdgeTableHelpers::scratchCache.release (newTable, tableCapacity);
+        tableCapacity = newCapacity;
         lineStrideElements = newLineStrideElements;
     }
 }
@@ -354,7 +493,20 @@ void EdgeTable::optimiseTable()
     for (int i = bounds.getHeight(); --i >= 0;)
         maxLineElements = jmax (maxLineElements, table [i * lineStrideElements]);
 
-    remapTableForNumEdges (maxLineElements);
+    // not from the scratch cache, that could hand out a bigger block than needed
+    if (maxLineElements != maxEdgesPerLine && bounds.getHeight() > 0)
+    {
+        maxEdgesPerLine = maxLineElements;
+        const int newLineStrideElements = maxEdgesPerLine * 2 + 1;
+        HeapBlock <int> newTable (bounds.getHeight() * newLineStrideElements);
+
+        copyEdgeTableData (newTable, newLineStrideElements, table, lineStrideElements, bounds.getHeight());
+
+        table.swapWith (newTable);
+        EdgeTableHelpers::scratchCache.release (newTable, tableCapacity);
+        tableCapacity = bounds.getHeight() * newLineStrideElements;
+        lineStrideElements = newLineStrideElements;
+    }
 }
 
 void EdgeTable::addEdgePoint (const int x, const int y, const int winding)
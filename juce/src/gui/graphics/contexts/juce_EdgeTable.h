@@ -38,6 +38,10 @@ class Image;
 /**
     A table of horizontal scan-line segments - used for rasterising Paths.
 
+    The memory of a table that is deleted is kept by the thread that deleted it,
+    and reused for the next tables that thread creates, so drawing a lot of shapes
+    doesn't need an allocation for each of them.
+
     @see Path, Graphics
 */
 class JUCE_API  EdgeTable
@@ -195,9 +199,10 @@ private:
     // table line format: number of points; point0 x, point0 levelDelta, point1 x, point1 levelDelta, etc
     HeapBlock<int> table;
     Rectangle<int> bounds;
-    int maxEdgesPerLine, lineStrideElements;
+    int maxEdgesPerLine, lineStrideElements, tableCapacity;
     bool needToCheckEmptinesss;
 
+    void allocateTable (int numElements);
     void addEdgePoint (int x, int y, int winding);
     void remapTableForNumEdges (int newNumEdgesPerLine);
     void intersectWithEdgeTableLine (int y, const int* otherLine);
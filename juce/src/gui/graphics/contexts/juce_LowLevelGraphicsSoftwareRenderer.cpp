@@ -25,6 +25,11 @@
 
 #include "../../../core/juce_StandardHeader.h"
 
+#if JUCE_INTEL && (JUCE_MSVC || defined (__SSE2__)) && ! defined (JUCE_DISABLE_SSE2_RENDERING)
+ #define JUCE_USE_SSE2_RENDERING 1
+ #include <emmintrin.h>
+#endif
+
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_LowLevelGraphicsSoftwareRenderer.h"
@@ -415,6 +420,67 @@ namespace RenderingHelpers
         n %= divisor;
         return (n < 0) ? (n + divisor) : n;
     }
+
+    /** Blends a line of pixels onto another one, with an extra opacity of 0 to 255.
+        This does the same as calling blend() for each pixel.
+    */
+    template <class DestPixelType, class SrcPixelType>
+    forcedinline void blendLine (DestPixelType* dest, const SrcPixelType* src, int width, const int alphaLevel) noexcept
+    {
+        if (alphaLevel < 0xfe)
+        {
+            do
+            {
+                dest++ ->blend (*src++, alphaLevel);
+            } while (--width > 0);
+        }
+        else
+        {
+            do
+            {
+                dest++ ->blend (*src++);
+            } while (--width > 0);
+        }
+    }
+
+   #if JUCE_USE_SSE2_RENDERING
+    // blends two premultiplied pixels that are unpacked to 16 bits per channel
+    forcedinline __m128i blendPixelPair (const __m128i src, const __m128i dest, const __m128i extraAlpha) noexcept
+    {
+        const __m128i s = _mm_srli_epi16 (_mm_mullo_epi16 (src, extraAlpha), 8);
+        const __m128i a = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (s, _MM_SHUFFLE (3, 3, 3, 3)), _MM_SHUFFLE (3, 3, 3, 3));
+        const __m128i inverseAlpha = _mm_sub_epi16 (_mm_set1_epi16 (256), a);
+
+        return _mm_add_epi16 (s, _mm_srli_epi16 (_mm_mullo_epi16 (dest, inverseAlpha), 8));
+    }
+
+    // the same as the generic version, but four pixels at a time
+    inline void blendLine (PixelARGB* dest, const PixelARGB* src, int width, const int alphaLevel) noexcept
+    {
+        if (SystemStats::canUseSSE2())
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i extraAlpha = _mm_set1_epi16 ((short) (alphaLevel < 0xfe ? alphaLevel + 1 : 256));
+
+            for (; width >= 4; width -= 4)
+            {
+                const __m128i s = _mm_loadu_si128 ((const __m128i*) src);
+                const __m128i d = _mm_loadu_si128 ((const __m128i*) dest);
+
+                _mm_storeu_si128 ((__m128i*) dest,
+                                  _mm_packus_epi16 (blendPixelPair (_mm_unpacklo_epi8 (s, zero), _mm_unpacklo_epi8 (d, zero), extraAlpha),
+                                                    blendPixelPair (_mm_unpackhi_epi8 (s, zero), _mm_unpackhi_epi8 (d, zero), extraAlpha)));
+                src += 4;
+                dest += 4;
+            }
+
+            if (width <= 0)
+                return;
+        }
+
+        blendLine<PixelARGB, PixelARGB> (dest, src, width, alphaLevel);
+    }
+   #endif
 }
 
 //==============================================================================
@@ -470,10 +536,17 @@ public:
 
         if (alphaLevel < 0xfe)
         {
-            do
+            if (repeatPattern)
             {
-                dest++ ->blend (sourceLineStart [repeatPattern ? (x++ % srcData.width) : x++], alphaLevel);
-            } while (--width > 0);
+                do
+                {
+                    dest++ ->blend (sourceLineStart [x++ % srcData.width], alphaLevel);
+                } while (--width > 0);
+            }
+            else
+            {
+                RenderingHelpers::blendLine (dest, sourceLineStart + x, width, alphaLevel);
+            }
         }
         else
         {
@@ -554,6 +627,11 @@ private:
         memcpy (dest, src, width * sizeof (PixelRGB));
     }
 
+    static forcedinline void copyRow (PixelARGB* dest, PixelARGB* src, int width) noexcept
+    {
+        RenderingHelpers::blendLine (dest, src, width, 0xff);
+    }
+
     JUCE_DECLARE_NON_COPYABLE (ImageFillEdgeTableRenderer);
 };
 
@@ -618,20 +696,7 @@ public:
         alphaLevel *= extraAlpha;
         alphaLevel >>= 8;
 
-        if (alphaLevel < 0xfe)
-        {
-            do
-            {
-                dest++ ->blend (*span++, alphaLevel);
-            } while (--width > 0);
-        }
-        else
-        {
-            do
-            {
-                dest++ ->blend (*span++);
-            } while (--width > 0);
-        }
+        RenderingHelpers::blendLine (dest, span, width, alphaLevel);
     }
 
     forcedinline void handleEdgeTableLineFull (const int x, int width) noexcept
@@ -739,6 +804,37 @@ private:
     //==============================================================================
     void render4PixelAverage (PixelARGB* const dest, const uint8* src, const int subPixelX, const int subPixelY) noexcept
     {
+       #if JUCE_USE_SSE2_RENDERING
+        // the weights fit into 16 bits unless both sub-pixel positions are 0
+        if ((subPixelX | subPixelY) != 0 && SystemStats::canUseSSE2())
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const short w00 = (short) ((256 - subPixelX) * (256 - subPixelY));
+            const short w01 = (short) (subPixelX * (256 - subPixelY));
+            const short w10 = (short) ((256 - subPixelX) * subPixelY);
+            const short w11 = (short) (subPixelX * subPixelY);
+
+            const __m128i top = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i*) src), zero);
+            const __m128i bottom = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i*) (src + this->srcData.lineStride)), zero);
+            const __m128i topWeights = _mm_set_epi16 (w01, w01, w01, w01, w00, w00, w00, w00);
+            const __m128i bottomWeights = _mm_set_epi16 (w11, w11, w11, w11, w10, w10, w10, w10);
+
+            // full 32-bit products of the unsigned 16-bit channels and weights
+            __m128i lo = _mm_mullo_epi16 (top, topWeights);
+            __m128i hi = _mm_mulhi_epu16 (top, topWeights);
+            __m128i c = _mm_add_epi32 (_mm_unpacklo_epi16 (lo, hi), _mm_unpackhi_epi16 (lo, hi));
+
+            lo = _mm_mullo_epi16 (bottom, bottomWeights);
+            hi = _mm_mulhi_epu16 (bottom, bottomWeights);
+            c = _mm_add_epi32 (c, _mm_add_epi32 (_mm_unpacklo_epi16 (lo, hi), _mm_unpackhi_epi16 (lo, hi)));
+
+            c = _mm_srli_epi32 (_mm_add_epi32 (c, _mm_set1_epi32 (256 * 128)), 16);
+            c = _mm_packus_epi16 (_mm_packs_epi32 (c, zero), zero);
+            *dest = PixelARGB ((uint32) _mm_cvtsi128_si32 (c));
+            return;
+        }
+       #endif
+
         uint32 c[4] = { 256 * 128, 256 * 128, 256 * 128, 256 * 128 };
 
         uint32 weight = (256 - subPixelX) * (256 - subPixelY);
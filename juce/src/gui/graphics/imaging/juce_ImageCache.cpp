@@ -33,6 +33,8 @@ BEGIN_JUCE_NAMESPACE
 #include "../../../containers/juce_OwnedArray.h"
 #include "../../../events/juce_Timer.h"
 #include "../../../core/juce_Singleton.h"
+#include "../../../threads/juce_ThreadPool.h"
+#include "../../../events/juce_CallbackMessage.h"
 
 
 //==============================================================================
@@ -47,6 +49,9 @@ public:
 
     ~Pimpl()
     {
+        if (decoder != nullptr)
+            decoder->removeAllJobs (false, 10000, true);
+
         clearSingletonInstance();
     }
 
@@ -107,6 +112,88 @@ public:
             stopTimer();
     }
 
+    //==============================================================================
+    Image getAsync (const int64 hashCode, const File& file, const void* imageData,
+                    const int dataSize, AsyncLoadCallback* const callback)
+    {
+        const ScopedLock sl (lock);
+
+        Image image (getFromHashCode (hashCode));
+        if (image.isValid())
+            return image;
+
+        AsyncLoad* load = findAsyncLoad (hashCode);
+
+        if (load == nullptr)
+        {
+            load = new AsyncLoad();
+            load->hashCode = hashCode;
+            load->file = file;
+            load->imageData = imageData;
+            load->dataSize = dataSize;
+            asyncLoads.add (load);
+
+            if (decoder == nullptr)
+                decoder = new ThreadPool (1);
+
+            decoder->addJob (new DecodeJob (*this, *load));
+        }
+
+        if (callback != nullptr)
+            load->callbacks.addIfNotAlreadyThere (callback);
+
+        return Image::null;
+    }
+
+    void cancelAsyncLoads (AsyncLoadCallback* const callback)
+    {
+        const ScopedLock sl (lock);
+
+        for (int i = asyncLoads.size(); --i >= 0;)
+            asyncLoads.getUnchecked(i)->callbacks.removeValue (callback);
+    }
+
+    // called on the message thread when a DecodeJob is done
+    void asyncLoadFinished (const int64 hashCode)
+    {
+        Image image;
+
+        {
+            const ScopedLock sl (lock);
+
+            AsyncLoad* const load = findAsyncLoad (hashCode);
+            if (load == nullptr)
+                return;
+
+            image = load->image;
+            addImageToCache (image, hashCode);
+        }
+
+        // a callback may cancel other ones, so they're taken out one at a time
+        for (;;)
+        {
+            AsyncLoadCallback* callback;
+
+            {
+                const ScopedLock sl (lock);
+
+                AsyncLoad* const load = findAsyncLoad (hashCode);
+                if (load == nullptr)
+                    return;
+
+                if (load->callbacks.size() == 0)
+                {
+                    asyncLoads.removeObject (load);
+                    return;
+                }
+
+                callback = load->callbacks.remove (0);
+            }
+
+            callback->imageLoaded (image, hashCode);
+        }
+    }
+
     struct Item
     {
         Image image;
@@ -119,7 +206,71 @@ public:
     juce_DeclareSingleton_SingleThreaded_Minimal (ImageCache::Pimpl);
 
 private:
+    struct AsyncLoad
+    {
+        int64 hashCode;
+        File file;
+        const void* imageData;
+        int dataSize;
+        Image image;
+        Array<AsyncLoadCallback*> callbacks;
+    };
+
+    class LoadedMessage  : public CallbackMessage
+    {
+    public:
+        LoadedMessage (const int64 hashCode_) : hashCode (hashCode_) {}
+
+        void messageCallback()
+        {
+            if (ImageCache::Pimpl::getInstanceWithoutCreating() != nullptr)
+                ImageCache::Pimpl::getInstanceWithoutCreating()->asyncLoadFinished (hashCode);
+        }
+
+    private:
+        const int64 hashCode;
+    };
+
+    class DecodeJob  : public ThreadPoolJob
+    {
+    public:
+        DecodeJob (Pimpl& owner_, AsyncLoad& load_)
+            : ThreadPoolJob ("image decoder"), owner (owner_), load (load_)
+        {
+        }
+
+        JobStatus runJob()
+        {
+            // the load is only removed on the message thread, after this job has posted its message
+            const Image image (load.imageData != nullptr ? ImageFileFormat::loadFrom (load.imageData, load.dataSize)
+                                                         : ImageFileFormat::loadFrom (load.file));
+
+            {
+                const ScopedLock sl (owner.lock);
+                load.image = image;
+            }
+
+            (new LoadedMessage (load.hashCode))->post();
+            return jobHasFinishedAndShouldBeDeleted;
+        }
+
+    private:
+        Pimpl& owner;
+        AsyncLoad& load;
+    };
+
+    AsyncLoad* findAsyncLoad (const int64 hashCode) const
+    {
+        for (int i = asyncLoads.size(); --i >= 0;)
+            if (asyncLoads.getUnchecked(i)->hashCode == hashCode)
+                return asyncLoads.getUnchecked(i);
+
+        return nullptr;
+    }
+
     OwnedArray<Item> images;
+    OwnedArray<AsyncLoad> asyncLoads;
+    ScopedPointer<ThreadPool> decoder;
     CriticalSection lock;
 
     JUCE_DECLARE_NON_COPYABLE (Pimpl);
@@ -156,6 +307,24 @@ Image ImageCache::getFromFile (const File& file)
     return image;
 }
 
+Image ImageCache::getFromFileAsync (const File& file, AsyncLoadCallback* callback)
+{
+    return Pimpl::getInstance()->getAsync (file.hashCode64(), file, nullptr, 0, callback);
+}
+
+Image ImageCache::getFromMemoryAsync (const void* imageData, const int dataSize, AsyncLoadCallback* callback)
+{
+    // the same hash code as getFromMemory(), so both share the cached image
+    return Pimpl::getInstance()->getAsync ((int64) (pointer_sized_int) imageData, File::nonexistent,
+                                           imageData, dataSize, callback);
+}
+
+void ImageCache::cancelAsyncLoads (AsyncLoadCallback* callback)
+{
+    if (Pimpl::getInstanceWithoutCreating() != nullptr)
+        Pimpl::getInstanceWithoutCreating()->cancelAsyncLoads (callback);
+}
+
 Image ImageCache::getFromMemory (const void* imageData, const int dataSize)
 {
     const int64 hashCode = (int64) (pointer_sized_int) imageData;
@@ -82,6 +82,67 @@ public:
     */
     static Image getFromMemory (const void* imageData, int dataSize);
 
+    //==============================================================================
+    /** Receives the images that getFromFileAsync() and getFromMemoryAsync() have
+        decoded in the background.
+
+        @see cancelAsyncLoads
+    */
+    class JUCE_API  AsyncLoadCallback
+    {
+    public:
+        /** Destructor. */
+        virtual ~AsyncLoadCallback() {}
+
+        /** Called on the message thread when a requested image has been decoded.
+
+            The image has already been added to the cache at this point.
+
+            @param image        the image, or an invalid image if it couldn't be loaded
+            @param hashCode     the hash code of the image in the cache
+        */
+        virtual void imageLoaded (const Image& image, int64 hashCode) = 0;
+    };
+
+    /** Loads an image from a file on a background thread, (or just returns the image if it's already cached).
+
+        If the cache already contains an image that was loaded from this file, that
+        image is returned and the callback isn't used. Otherwise this returns an invalid
+        image straight away, so that the caller can draw a placeholder, and the file is
+        decoded by a background thread. When it's ready, the image is added to the cache
+        and the callback is told about it.
+
+        If the same image is requested again while it's being decoded, it's only decoded
+        once and all the callbacks are told.
+
+        @param file         the file to try to load
+        @param callback     is told when the image is ready, this can be nullptr. It must be
+                            removed with cancelAsyncLoads() before it's deleted
+        @returns            the cached image, or an invalid image if it's still being loaded
+        @see getFromFile, cancelAsyncLoads
+    */
+    static Image getFromFileAsync (const File& file, AsyncLoadCallback* callback);
+
+    /** Loads an image from an in-memory image file on a background thread, (or just returns the image if it's already cached).
+
+        This works like getFromFileAsync(). The memory block has to stay valid until the
+        image has been decoded.
+
+        @param imageData    the block of memory containing the image data
+        @param dataSize     the data size in bytes
+        @param callback     is told when the image is ready, this can be nullptr. It must be
+                            removed with cancelAsyncLoads() before it's deleted
+        @returns            the cached image, or an invalid image if it's still being loaded
+        @see getFromMemory, cancelAsyncLoads
+    */
+    static Image getFromMemoryAsync (const void* imageData, int dataSize, AsyncLoadCallback* callback);
+
+    /** Makes sure that a callback isn't told about any of the images that it requested.
+
+        The images are still decoded and added to the cache.
+    */
+    static void cancelAsyncLoads (AsyncLoadCallback* callback);
+
     //==============================================================================
     /** Checks the cache for an image with a particular hashcode.
 
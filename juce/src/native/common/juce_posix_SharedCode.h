@@ -841,13 +841,27 @@ bool Thread::setThreadPriority (void* handle, int priority)
     if (pthread_getschedparam ((pthread_t) handle, &policy, &param) != 0)
         return false;
 
-    policy = priority == 0 ? SCHED_OTHER : SCHED_RR;
+    // only the priorities above normal are realtime, so that a background thread
+    // can't get ahead of the message thread
+    policy = priority > 6 ? SCHED_RR : SCHED_OTHER;
 
     const int minPriority = sched_get_priority_min (policy);
     const int maxPriority = sched_get_priority_max (policy);
 
     param.sched_priority = ((maxPriority - minPriority) * priority) / 10 + minPriority;
-    return pthread_setschedparam ((pthread_t) handle, policy, &param) == 0;
+
+    if (pthread_setschedparam ((pthread_t) handle, policy, &param) != 0)
+        return false;
+
+   #if JUCE_LINUX
+    // SCHED_OTHER has only one priority here, so the nice value of the thread stands in
+    // for it. That can only be set for the calling thread, and going back up below a
+    // nice value of 0 needs the permission of RLIMIT_NICE.
+    if (policy == SCHED_OTHER && pthread_equal ((pthread_t) handle, pthread_self()))
+        return setpriority (PRIO_PROCESS, (id_t) syscall (SYS_gettid), (5 - priority) * 2) == 0;
+   #endif
+
+    return true;
 }
 
 Thread::ThreadID Thread::getCurrentThreadId()
@@ -266,7 +266,18 @@ public:
                 {
                     filenameFound = CharPointer_UTF8 (de->d_name);
 
-                    updateStatInfoForFile (parentDir + filenameFound, isDir, fileSize, modTime, creationTime, isReadOnly);
+                    // the entry already says whether it's a directory, so the file only
+                    // needs to be stat'ed for the other attributes, or if it's a link
+                    if (fileSize == nullptr && modTime == nullptr && creationTime == nullptr && isReadOnly == nullptr
+                         && de->d_type != DT_UNKNOWN && de->d_type != DT_LNK)
+                    {
+                        if (isDir != nullptr)
+                            *isDir = (de->d_type == DT_DIR);
+                    }
+                    else
+                    {
+                        updateStatInfoForEntry (de->d_name, isDir, fileSize, modTime, creationTime, isReadOnly);
+                    }
 
                     if (isHidden != nullptr)
                         *isHidden = filenameFound.startsWithChar ('.');
@@ -283,6 +294,26 @@ private:
     String parentDir, wildCard;
     DIR* dir;
 
+    // the same as updateStatInfoForFile(), but relative to the open directory, so
+    // there's no full path to build and look up for each file
+    void updateStatInfoForEntry (const char* const name, bool* const isDir, int64* const fileSize,
+                                 Time* const modTime, Time* const creationTime, bool* const isReadOnly)
+    {
+        if (isDir != nullptr || fileSize != nullptr || modTime != nullptr || creationTime != nullptr)
+        {
+            juce_statStruct info;
+            const bool statOk = fstatat64 (dirfd (dir), name, &info, 0) == 0;
+
+            if (isDir != nullptr)         *isDir        = statOk && ((info.st_mode & S_IFDIR) != 0);
+            if (fileSize != nullptr)      *fileSize     = statOk ? info.st_size : 0;
+            if (modTime != nullptr)       *modTime      = Time (statOk ? (int64) info.st_mtime * 1000 : 0);
+            if (creationTime != nullptr)  *creationTime = Time (statOk ? (int64) info.st_ctime * 1000 : 0);
+        }
+
+        if (isReadOnly != nullptr)
+            *isReadOnly = faccessat (dirfd (dir), name, W_OK, 0) != 0;
+    }
+
     JUCE_DECLARE_NON_COPYABLE (Pimpl);
 };
 
@@ -40,6 +40,20 @@ void* juce_load_jack_function (const char* const name)
     return dlsym (juce_libjack_handle, name);
 }
 
+/*  Loads libjack if that hasn't been done yet. The unversioned name is only there when
+    the development package is installed, so the runtime library is tried as well.
+*/
+bool juce_load_jack_library()
+{
+    if (juce_libjack_handle == nullptr)
+        juce_libjack_handle = dlopen ("libjack.so", RTLD_LAZY);
+
+    if (juce_libjack_handle == nullptr)
+        juce_libjack_handle = dlopen ("libjack.so.0", RTLD_LAZY);
+
+    return juce_libjack_handle != nullptr;
+}
+
 //==============================================================================
 #define JUCE_DECL_JACK_FUNCTION(return_type, fn_name, argument_types, arguments)  \
   typedef return_type (*fn_name##_ptr_t)argument_types;                       \
@@ -78,6 +92,13 @@ JUCE_DECL_JACK_FUNCTION (int, jack_set_port_connect_callback, (jack_client_t* cl
 JUCE_DECL_JACK_FUNCTION (jack_port_t* , jack_port_by_id, (jack_client_t* client, jack_port_id_t port_id), (client, port_id));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected, (const jack_port_t* port), (port));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected_to, (const jack_port_t* port, const char* port_name), (port, port_name));
+JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_frames_since_cycle_start, (const jack_client_t* client), (client));
+JUCE_DECL_JACK_FUNCTION (jack_nframes_t, jack_last_frame_time, (const jack_client_t* client), (client));
+JUCE_DECL_JACK_FUNCTION (jack_time_t, jack_frames_to_time, (const jack_client_t* client, jack_nframes_t frames), (client, frames));
+JUCE_DECL_JACK_FUNCTION (uint32_t, jack_midi_get_event_count, (void* port_buffer), (port_buffer));
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_get, (jack_midi_event_t* event, void* port_buffer, uint32_t event_index), (event, port_buffer, event_index));
+JUCE_DECL_VOID_JACK_FUNCTION (jack_midi_clear_buffer, (void* port_buffer), (port_buffer));
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_write, (void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, size_t data_size), (port_buffer, time, data, data_size));
 
 #if JUCE_DEBUG
   #define JACK_LOGGING_ENABLED 1
@@ -112,6 +133,432 @@ namespace
   #define JUCE_JACK_CLIENT_NAME "JuceJack"
 #endif
 
+static const char* const jackMidiDeviceName = "JACK MIDI";
+
+//==============================================================================
+/*  A lock-free ring of timestamped MIDI messages between the JACK process callback and
+    one other thread. Each record is the time, in Time::getMillisecondCounterHiRes()
+    milliseconds, the number of bytes and a generation number, followed by the bytes.
+    A record is only made visible when all of it has been written. There is one writer
+    and one reader at a time.
+*/
+class JackMidiRing
+{
+public:
+    JackMidiRing()
+        : fifo (ringSize),
+          ring (ringSize)
+    {
+    }
+
+    struct Header
+    {
+        double time;
+        int numBytes;
+        int generation;
+    };
+
+    enum { ringSize = 64 * 1024,
+           maxMessageSize = ringSize / 2 - (int) sizeof (Header) };
+
+    bool push (const void* const data, const int numBytes, const double time, const int generation) noexcept
+    {
+        const int recordSize = (int) sizeof (Header) + numBytes;
+
+        if (numBytes <= 0 || numBytes > (int) maxMessageSize || fifo.getFreeSpace() < recordSize)
+            return false;
+
+        Header header;
+        header.time = time;
+        header.numBytes = numBytes;
+        header.generation = generation;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (recordSize, start1, size1, start2, size2);
+        copyToRing (start1, size1, start2, 0, &header, sizeof (Header));
+        copyToRing (start1, size1, start2, sizeof (Header), data, numBytes);
+        fifo.finishedWrite (recordSize);
+        return true;
+    }
+
+    /** Reads the header of the oldest record without taking it out of the ring. */
+    bool peek (Header& header) const noexcept
+    {
+        if (fifo.getNumReady() < (int) sizeof (Header))
+            return false;
+
+        copyFromRing (&header, 0, sizeof (Header));
+        return true;
+    }
+
+    /** Copies the bytes of the oldest record, which peek() has returned the header of. */
+    void read (void* const dest, const Header& header) const noexcept
+    {
+        copyFromRing (dest, sizeof (Header), header.numBytes);
+    }
+
+    void discard (const Header& header) noexcept
+    {
+        fifo.finishedRead ((int) sizeof (Header) + header.numBytes);
+    }
+
+private:
+    AbstractFifo fifo;
+    HeapBlock <uint8> ring;
+
+    // copies to the part of a record that starts offset bytes into it, which may be split between the two blocks
+    void copyToRing (const int start1, const int size1, const int start2, const int offset,
+                     const void* const data, const int numBytes) noexcept
+    {
+        const int first = jlimit (0, numBytes, size1 - offset);
+        memcpy (ring + start1 + offset, data, (size_t) first);
+        memcpy (ring + start2 + jmax (0, offset - size1), static_cast <const uint8*> (data) + first, (size_t) (numBytes - first));
+    }
+
+    void copyFromRing (void* const dest, const int offset, const int numBytes) const noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (offset + numBytes, start1, size1, start2, size2);
+
+        const int first = jlimit (0, numBytes, size1 - offset);
+        memcpy (dest, ring + start1 + offset, (size_t) first);
+        memcpy (static_cast <uint8*> (dest) + first, ring + start2 + jmax (0, offset - size1), (size_t) (numBytes - first));
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (JackMidiRing);
+};
+
+//==============================================================================
+/*  The MIDI output on the "midi_out" port of the JACK device that is running.
+
+    Nothing is sent from the calling thread: sendMessageNow() and sendBlockOfMessages()
+    only put the messages into a ring together with the time they're meant for, and the
+    device's process callback writes the ones that are due into the port buffer of the
+    cycle, each at the frame that its time falls on. So a block of messages keeps its
+    spacing to the sample, whatever the threads are doing. Like the queue of the
+    background thread, the messages go out in the order of their times and those with
+    the same time in the order they were sent, so a message sent now overtakes a block
+    that is still waiting. One that is late goes out at the start of the next cycle.
+    The port has one output at a time, the one opened last.
+*/
+class JackMidiOutput  : public MidiOutput
+{
+public:
+    JackMidiOutput()
+        : generation (0),
+          pending (maxPending),
+          numPending (0),
+          pendingGeneration (0)
+    {
+        for (int i = 0; i < 2; ++i)
+            arenas[i].malloc (arenaSize);
+
+        arena = arenas[0];
+        arenaUsed = 0;
+
+        const ScopedLock sl (activeLock);
+        activeOutput = this;
+    }
+
+    ~JackMidiOutput()
+    {
+        const ScopedLock sl (activeLock);
+
+        if (activeOutput == this)
+            activeOutput = nullptr;
+    }
+
+    void sendMessageNow (const MidiMessage& message)
+    {
+        const ScopedLock sl (writeLock);
+        push (message.getRawData(), message.getRawDataSize(), Time::getMillisecondCounterHiRes());
+    }
+
+    void sendShortMessageNow (const uint32 packedMessage)
+    {
+        const uint8 data[3] = { (uint8) packedMessage, (uint8) (packedMessage >> 8), (uint8) (packedMessage >> 16) };
+
+        const ScopedLock sl (writeLock);
+        push (data, MidiMessage::getMessageLengthFromFirstByte (data[0]), Time::getMillisecondCounterHiRes());
+    }
+
+    void sendBlockOfMessages (const MidiBuffer& buffer,
+                              const double millisecondCounterToStartAt,
+                              double samplesPerSecondForBuffer)
+    {
+        const double timeScaleFactor = 1000.0 / samplesPerSecondForBuffer;
+        const ScopedLock sl (writeLock);
+
+        MidiBuffer::Iterator i (buffer);
+        const uint8* data;
+        int len, time;
+
+        while (i.getNextEvent (data, len, time))
+            push (data, len, millisecondCounterToStartAt + timeScaleFactor * time);
+    }
+
+    void clearAllPendingMessages()
+    {
+        // the process callback skips the messages of an older generation
+        ++generation;
+    }
+
+    // the messages are timed by the JACK cycle, so there's no thread to start
+    void startBackgroundThread()    {}
+    void stopBackgroundThread()     { clearAllPendingMessages(); }
+
+    /*  Called from the process callback of the device: takes the new messages out of the
+        ring and writes the ones that are due before the end of the cycle, as long as the
+        port buffer has room for them.
+    */
+    void writeEvents (void* const portBuffer, const double cycleStart, const double msPerFrame, const int numFrames)
+    {
+        takeFromRing();
+
+        const double cycleEnd = cycleStart + msPerFrame * numFrames;
+        jack_nframes_t lastFrame = 0;
+        int numWritten = 0, numDone = 0;
+
+        for (; numDone < numPending; ++numDone)
+        {
+            const PendingMessage& m = pending [numDone];
+
+            if (m.time >= cycleEnd)
+                break;
+
+            const jack_nframes_t frame = (jack_nframes_t) jlimit (0, numFrames - 1, roundToInt ((m.time - cycleStart) / msPerFrame));
+            lastFrame = jmax (lastFrame, frame);
+
+            if (JUCE_NAMESPACE::jack_midi_event_write (portBuffer, lastFrame, arena + m.offset, (size_t) m.numBytes) == 0)
+                ++numWritten;
+            else if (numWritten > 0)
+                break;  // the buffer is full, the rest goes out in the next cycle
+            else
+                jassertfalse; // too big for an empty buffer, so it's dropped
+        }
+
+        removeFirst (numDone);
+    }
+
+    static JackMidiOutput* activeOutput;
+    static CriticalSection activeLock;
+
+private:
+    CriticalSection writeLock;
+    JackMidiRing ring;
+    Atomic <int> generation;
+
+    /*  The messages that have left the ring, in the order they go out in. Their bytes are
+        in one of two arenas, the other one is used to pack them when the arena fills up.
+        Only used by the process callback.
+    */
+    struct PendingMessage
+    {
+        double time;
+        int offset, numBytes;
+    };
+
+    enum { maxPending = 4096,
+           arenaSize = JackMidiRing::ringSize };
+
+    HeapBlock <PendingMessage> pending;
+    int numPending, pendingGeneration;
+    HeapBlock <uint8> arenas[2];
+    uint8* arena;
+    int arenaUsed;
+
+    void push (const void* const data, const int numBytes, const double time)
+    {
+        if (! ring.push (data, numBytes, time, generation.get()))
+            jassertfalse; // the JACK device isn't running or is too far behind..
+    }
+
+    void takeFromRing()
+    {
+        const int currentGeneration = generation.get();
+
+        if (pendingGeneration != currentGeneration)
+        {
+            pendingGeneration = currentGeneration;
+            removeFirst (numPending);
+        }
+
+        JackMidiRing::Header header;
+
+        while (ring.peek (header))
+        {
+            if (header.generation == currentGeneration)
+            {
+                if (numPending >= (int) maxPending)
+                    break;
+
+                if (arenaUsed + header.numBytes > (int) arenaSize)
+                {
+                    packArena();
+
+                    if (arenaUsed + header.numBytes > (int) arenaSize)
+                        break;
+                }
+
+                // after the ones with the same or an earlier time
+                int index = numPending;
+                while (index > 0 && pending [index - 1].time > header.time)
+                    --index;
+
+                memmove (pending + index + 1, pending + index, sizeof (PendingMessage) * (size_t) (numPending - index));
+                pending[index].time = header.time;
+                pending[index].offset = arenaUsed;
+                pending[index].numBytes = header.numBytes;
+                ++numPending;
+
+                ring.read (arena + arenaUsed, header);
+                arenaUsed += header.numBytes;
+            }
+
+            ring.discard (header);
+        }
+    }
+
+    void removeFirst (const int num)
+    {
+        numPending -= num;
+        memmove (pending, pending + num, sizeof (PendingMessage) * (size_t) numPending);
+
+        if (numPending == 0)
+            arenaUsed = 0;
+    }
+
+    // copies the bytes of the pending messages to the start of the other arena
+    void packArena()
+    {
+        uint8* const packed = (arena == arenas[0]) ? arenas[1] : arenas[0];
+        int used = 0;
+
+        for (int i = 0; i < numPending; ++i)
+        {
+            memcpy (packed + used, arena + pending[i].offset, (size_t) pending[i].numBytes);
+            pending[i].offset = used;
+            used += pending[i].numBytes;
+        }
+
+        arena = packed;
+        arenaUsed = used;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JackMidiOutput);
+};
+
+JackMidiOutput* JackMidiOutput::activeOutput = nullptr;
+CriticalSection JackMidiOutput::activeLock;
+
+//==============================================================================
+/*  The MIDI input from the "midi_in" port of the JACK device that is running. The
+    process callback copies each event into a ring, stamped with the time of its frame,
+    and this thread hands them on to the MidiInputCallback in batches, so the callback
+    never runs on the JACK thread.
+*/
+class JackMidiInput  : public Thread
+{
+public:
+    JackMidiInput (MidiInput* const midiInput_, MidiInputCallback* const callback_)
+        : Thread ("Juce JACK MIDI Input"),
+          midiInput (midiInput_),
+          callback (callback_),
+          isStarted (false)
+    {
+        jassert (callback != nullptr && midiInput != nullptr);
+
+        const ScopedLock sl (JackMidiOutput::activeLock);
+        activeInput = this;
+    }
+
+    ~JackMidiInput()
+    {
+        stopThread (3000);
+
+        const ScopedLock sl (JackMidiOutput::activeLock);
+
+        if (activeInput == this)
+            activeInput = nullptr;
+    }
+
+    void run()
+    {
+        const int maxBatchSize = 256;
+        HeapBlock <uint8> data (JackMidiRing::maxMessageSize);
+        Array <MidiMessage> batch;
+        batch.ensureStorageAllocated (maxBatchSize);
+
+        isStarted = true;
+
+        while (! threadShouldExit())
+        {
+            wait (500);
+
+            JackMidiRing::Header header;
+
+            while (ring.peek (header))
+            {
+                ring.read (data, header);
+                batch.add (MidiMessage (data, header.numBytes, header.time * 0.001));
+                ring.discard (header);
+
+                if (batch.size() >= maxBatchSize)
+                    deliver (batch);
+            }
+
+            deliver (batch);
+        }
+
+        isStarted = false;
+    }
+
+    /*  Called from the process callback of the device. The events in the port buffer
+        arrived during the cycle before this one, which is where their times are put.
+    */
+    void readEvents (void* const portBuffer, const double cycleStart, const double msPerFrame, const int numFrames)
+    {
+        if (! isStarted)
+            return;
+
+        const uint32_t numEvents = JUCE_NAMESPACE::jack_midi_get_event_count (portBuffer);
+        const double previousCycleStart = cycleStart - msPerFrame * numFrames;
+
+        for (uint32_t i = 0; i < numEvents; ++i)
+        {
+            jack_midi_event_t event;
+
+            if (JUCE_NAMESPACE::jack_midi_event_get (&event, portBuffer, i) == 0
+                 && ! ring.push (event.buffer, (int) event.size, previousCycleStart + msPerFrame * event.time, 0))
+                break; // the input thread isn't keeping up..
+        }
+
+        if (numEvents > 0)
+            notify();
+    }
+
+    static JackMidiInput* activeInput;
+
+private:
+    MidiInput* const midiInput;
+    MidiInputCallback* const callback;
+    JackMidiRing ring;
+    bool volatile isStarted;
+
+    void deliver (Array <MidiMessage>& batch)
+    {
+        if (batch.size() > 0)
+        {
+            callback->handleIncomingMidiMessages (midiInput, batch.getRawDataPointer(), batch.size());
+            batch.clearQuick();
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JackMidiInput);
+};
+
+JackMidiInput* JackMidiInput::activeInput = nullptr;
+
 //==============================================================================
 class JackAudioIODevice   : public AudioIODevice
 {
@@ -125,7 +572,9 @@ public:
           isOpen_ (false),
           callback (nullptr),
           totalNumberOfInputChannels (0),
-          totalNumberOfOutputChannels (0)
+          totalNumberOfOutputChannels (0),
+          midiInputPort (nullptr),
+          midiOutputPort (nullptr)
     {
         jassert (deviceName.isNotEmpty());
 
@@ -162,6 +611,10 @@ public:
                                                                      JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0));
             }
 
+            // the MIDI ports, which the JACK MIDI devices use while this device is running
+            midiInputPort = JUCE_NAMESPACE::jack_port_register (client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+            midiOutputPort = JUCE_NAMESPACE::jack_port_register (client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+
             inChans.calloc (totalNumberOfInputChannels + 2);
             outChans.calloc (totalNumberOfOutputChannels + 2);
         }
@@ -180,7 +633,7 @@ public:
     StringArray getChannelNames (bool forInput) const
     {
         StringArray names;
-        const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */
+        const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */
                                                                    forInput ? JackPortIsInput : JackPortIsOutput);
 
         if (ports != 0)
@@ -227,7 +680,7 @@ public:
 
         if (! inputChannels.isZero())
         {
-            const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsOutput);
+            const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsOutput);
 
             if (ports != 0)
             {
@@ -251,7 +704,7 @@ public:
 
         if (! outputChannels.isZero())
         {
-            const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsInput);
+            const char** const ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsInput);
 
             if (ports != 0)
             {
@@ -368,6 +821,8 @@ public:
 private:
     void process (const int numSamples)
     {
+        processMidi (numSamples);
+
         int i, numActiveInChans = 0, numActiveOutChans = 0;
 
         for (i = 0; i < totalNumberOfInputChannels; ++i)
@@ -402,6 +857,48 @@ private:
         }
     }
 
+    /*  Passes the MIDI of this cycle between the ports and the JACK MIDI devices. The
+        times are converted with the start of the cycle on the millisecond counter, so a
+        message lands on the frame its timestamp falls on.
+    */
+    void processMidi (const int numSamples)
+    {
+        void* const outputBuffer = midiOutputPort != nullptr ? JUCE_NAMESPACE::jack_port_get_buffer (midiOutputPort, numSamples) : nullptr;
+        void* const inputBuffer = midiInputPort != nullptr ? JUCE_NAMESPACE::jack_port_get_buffer (midiInputPort, numSamples) : nullptr;
+
+        if (outputBuffer != nullptr)
+            JUCE_NAMESPACE::jack_midi_clear_buffer (outputBuffer);
+
+        const double msPerFrame = 1000.0 / JUCE_NAMESPACE::jack_get_sample_rate (client);
+        const double cycleStart = getCycleStart (msPerFrame, numSamples);
+
+        // a device that is being opened or closed just misses this cycle
+        const ScopedTryLock sl (JackMidiOutput::activeLock);
+
+        if (sl.isLocked())
+        {
+            if (outputBuffer != nullptr && JackMidiOutput::activeOutput != nullptr)
+                JackMidiOutput::activeOutput->writeEvents (outputBuffer, cycleStart, msPerFrame, numSamples);
+
+            if (inputBuffer != nullptr && JackMidiInput::activeInput != nullptr)
+                JackMidiInput::activeInput->readEvents (inputBuffer, cycleStart, msPerFrame, numSamples);
+        }
+    }
+
+    /*  The time the cycle started at, in milliseconds. JACK's own estimate doesn't move
+        with the jitter of the thread waking up, so it's used if its clock is the same as
+        the one of Time::getMillisecondCounterHiRes(), which it normally is on Linux.
+    */
+    double getCycleStart (const double msPerFrame, const int numSamples) const
+    {
+        const double wokenAt = Time::getMillisecondCounterHiRes()
+                                 - msPerFrame * JUCE_NAMESPACE::jack_frames_since_cycle_start (client);
+
+        const double jackCycleStart = 0.001 * (double) JUCE_NAMESPACE::jack_frames_to_time (client, JUCE_NAMESPACE::jack_last_frame_time (client));
+
+        return std::abs (jackCycleStart - wokenAt) < msPerFrame * numSamples ? jackCycleStart : wokenAt;
+    }
+
     static int processCallback (jack_nframes_t nframes, void* callbackArgument)
     {
         if (callbackArgument != 0)
@@ -443,6 +940,8 @@ private:
     int totalNumberOfInputChannels;
     int totalNumberOfOutputChannels;
     Array<void*> inputPorts, outputPorts;
+    jack_port_t* midiInputPort;
+    jack_port_t* midiOutputPort;
 };
 
 
@@ -466,13 +965,8 @@ public:
         outputNames.clear();
         outputIds.clear();
 
-        if (juce_libjack_handle == 0)
-        {
-            juce_libjack_handle = dlopen ("libjack.so", RTLD_LAZY);
-
-            if (juce_libjack_handle == 0)
-                return;
-        }
+        if (! juce_load_jack_library())
+            return;
 
         // open a dummy client
         jack_status_t status;
@@ -485,7 +979,7 @@ public:
         else
         {
             // scan for output devices
-            const char** ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsOutput);
+            const char** ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsOutput);
 
             if (ports != 0)
             {
@@ -509,7 +1003,7 @@ public:
             }
 
             // scan for input devices
-            ports = JUCE_NAMESPACE::jack_get_ports (client, 0, 0, /* JackPortIsPhysical | */ JackPortIsInput);
+            ports = JUCE_NAMESPACE::jack_get_ports (client, 0, JACK_DEFAULT_AUDIO_TYPE, /* JackPortIsPhysical | */ JackPortIsInput);
 
             if (ports != 0)
             {
@@ -31,6 +31,55 @@
 //==============================================================================
 namespace
 {
+    const char* const midiInputQueueName = "Juce Midi Input Queue";
+
+    /*  Subscribes an input port to a source through a queue that stamps each event with
+        its real time, so the input thread can tell when it arrived instead of when the
+        thread got round to reading it. If the queue can't be made, the port is connected
+        without timestamps.
+    */
+    void connectInputPort (snd_seq_t* seqHandle, const int portId, const int sourceClient, const int sourcePort)
+    {
+        const int queue = snd_seq_alloc_named_queue (seqHandle, midiInputQueueName);
+
+        if (queue >= 0)
+        {
+            snd_seq_port_subscribe_t* subscription = nullptr;
+
+            if (snd_seq_port_subscribe_malloc (&subscription) == 0)
+            {
+                snd_seq_addr_t sender, dest;
+                sender.client = (unsigned char) sourceClient;
+                sender.port = (unsigned char) sourcePort;
+                dest.client = (unsigned char) snd_seq_client_id (seqHandle);
+                dest.port = (unsigned char) portId;
+
+                snd_seq_port_subscribe_set_sender (subscription, &sender);
+                snd_seq_port_subscribe_set_dest (subscription, &dest);
+                snd_seq_port_subscribe_set_queue (subscription, queue);
+                snd_seq_port_subscribe_set_time_update (subscription, 1);
+                snd_seq_port_subscribe_set_time_real (subscription, 1);
+
+                const bool subscribed = snd_seq_subscribe_port (seqHandle, subscription) == 0;
+                const bool started = subscribed
+                                      && snd_seq_start_queue (seqHandle, queue, nullptr) >= 0
+                                      && snd_seq_drain_output (seqHandle) >= 0;
+
+                if (subscribed && ! started)
+                    snd_seq_unsubscribe_port (seqHandle, subscription);
+
+                snd_seq_port_subscribe_free (subscription);
+
+                if (started)
+                    return;
+            }
+
+            snd_seq_free_queue (seqHandle, queue);
+        }
+
+        snd_seq_connect_from (seqHandle, portId, sourceClient, sourcePort);
+    }
+
     snd_seq_t* iterateMidiDevices (const bool forInput,
                                    StringArray& deviceNamesFound,
                                    const int deviceIndexToOpen)
@@ -38,7 +87,8 @@ namespace
         snd_seq_t* returnedHandle = nullptr;
         snd_seq_t* seqHandle = nullptr;
 
-        if (snd_seq_open (&seqHandle, "default", forInput ? SND_SEQ_OPEN_INPUT
+        // an input also writes, to start the queue that stamps its events
+        if (snd_seq_open (&seqHandle, "default", forInput ? SND_SEQ_OPEN_DUPLEX
                                                           : SND_SEQ_OPEN_OUTPUT, 0) == 0)
         {
             snd_seq_system_info_t* systemInfo = nullptr;
@@ -88,7 +138,7 @@ namespace
                                                                                                    SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
                                                                                                    SND_SEQ_PORT_TYPE_MIDI_GENERIC);
 
-                                                    snd_seq_connect_from (seqHandle, portId, sourceClient, sourcePort);
+                                                    connectInputPort (seqHandle, portId, sourceClient, sourcePort);
                                                 }
                                                 else
                                                 {
@@ -181,9 +231,33 @@ public:
 
     void sendMessageNow (const MidiMessage& message)
     {
-        if (message.getRawDataSize() > maxEventSize)
+        outputEvent (message.getRawData(), message.getRawDataSize());
+        snd_seq_drain_output (seqHandle);
+    }
+
+    void sendShortMessageNow (const uint32 packedMessage)
+    {
+        const uint8 data[3] = { (uint8) packedMessage, (uint8) (packedMessage >> 8), (uint8) (packedMessage >> 16) };
+
+        outputEvent (data, MidiMessage::getMessageLengthFromFirstByte (data[0]));
+        snd_seq_drain_output (seqHandle);
+    }
+
+    // queues all events in the sequencer's output buffer and drains it once
+    void sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+    {
+        for (int i = 0; i < numMessages; ++i)
+            outputEvent (messages[i]->getRawData(), messages[i]->getRawDataSize());
+
+        snd_seq_drain_output (seqHandle);
+    }
+
+private:
+    void outputEvent (const uint8* const data, const int numBytes)
+    {
+        if (numBytes > maxEventSize)
         {
-            maxEventSize = message.getRawDataSize();
+            maxEventSize = numBytes;
             snd_midi_event_free (midiParser);
             snd_midi_event_new (maxEventSize, &midiParser);
         }
@@ -191,10 +265,7 @@ public:
         snd_seq_event_t event;
         snd_seq_ev_clear (&event);
 
-        snd_midi_event_encode (midiParser,
-                               message.getRawData(),
-                               message.getRawDataSize(),
-                               &event);
+        snd_midi_event_encode (midiParser, data, numBytes, &event);
 
         snd_midi_event_reset_encode (midiParser);
 
@@ -202,11 +273,10 @@ public:
         snd_seq_ev_set_subs (&event);
         snd_seq_ev_set_direct (&event);
 
+        // this only writes into the output buffer, which is flushed by itself when it's full
         snd_seq_event_output (seqHandle, &event);
-        snd_seq_drain_output (seqHandle);
     }
 
-private:
     MidiOutput* const midiOutput;
     snd_seq_t* const seqHandle;
     snd_midi_event_t* midiParser;
@@ -219,6 +289,13 @@ StringArray MidiOutput::getDevices()
 {
     StringArray devices;
     iterateMidiDevices (false, devices, -1);
+
+   #if JUCE_JACK
+    // the JACK MIDI device comes after the ALSA ones
+    if (juce_load_jack_library())
+        devices.add (jackMidiDeviceName);
+   #endif
+
     return devices;
 }
 
@@ -239,6 +316,12 @@ MidiOutput* MidiOutput::openDevice (int deviceIndex)
         newDevice = new MidiOutput();
         newDevice->internal = new MidiOutputDevice (newDevice, handle);
     }
+   #if JUCE_JACK
+    else if (deviceIndex == devices.size() && juce_load_jack_library())
+    {
+        newDevice = new JackMidiOutput();
+    }
+   #endif
 
     return newDevice;
 }
@@ -268,6 +351,16 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
     static_cast <MidiOutputDevice*> (internal)->sendMessageNow (message);
 }
 
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+    static_cast <MidiOutputDevice*> (internal)->sendShortMessageNow (packedMessage);
+}
+
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+    static_cast <MidiOutputDevice*> (internal)->sendMessagesNow (messages, numMessages);
+}
+
 
 //==============================================================================
 class MidiInputThread   : public Thread
@@ -279,7 +372,8 @@ public:
         : Thread ("Juce MIDI Input"),
           midiInput (midiInput_),
           seqHandle (seqHandle_),
-          callback (callback_)
+          callback (callback_),
+          queue (snd_seq_query_named_queue (seqHandle_, midiInputQueueName))
     {
         jassert (seqHandle != 0 && callback != 0 && midiInput != 0);
     }
@@ -292,61 +386,113 @@ public:
     void run()
     {
         const int maxEventSize = 16 * 1024;
-        snd_midi_event_t* midiParser;
+        const int maxBatchSize = 256;
+        snd_midi_event_t* midiParser = nullptr;
+        snd_seq_queue_status_t* queueStatus = nullptr;
 
-        if (snd_midi_event_new (maxEventSize, &midiParser) >= 0)
+        if (snd_midi_event_new (maxEventSize, &midiParser) >= 0
+             && snd_seq_queue_status_malloc (&queueStatus) == 0)
         {
             HeapBlock <uint8> buffer (maxEventSize);
+            Array <MidiMessage> batch;
+            batch.ensureStorageAllocated (maxBatchSize);
 
             const int numPfds = snd_seq_poll_descriptors_count (seqHandle, POLLIN);
             struct pollfd* const pfd = (struct pollfd*) alloca (numPfds * sizeof (struct pollfd));
 
             snd_seq_poll_descriptors (seqHandle, pfd, numPfds, POLLIN);
+            snd_seq_nonblock (seqHandle, 1);
 
             while (! threadShouldExit())
             {
                 if (poll (pfd, numPfds, 500) > 0)
                 {
-                    snd_seq_event_t* inputEvent = nullptr;
+                    // everything that has arrived is read now and handed on as one batch
+                    double readTime, queueOffset;
+                    const bool hasQueueTime = getQueueOffset (queueStatus, readTime, queueOffset);
 
-                    snd_seq_nonblock (seqHandle, 1);
+                    snd_seq_event_t* inputEvent = nullptr;
 
-                    do
+                    while (snd_seq_event_input (seqHandle, &inputEvent) >= 0)
                     {
-                        if (snd_seq_event_input (seqHandle, &inputEvent) >= 0)
-                        {
-                            // xxx what about SYSEXes that are too big for the buffer?
-                            const int numBytes = snd_midi_event_decode (midiParser, buffer, maxEventSize, inputEvent);
+                        if (inputEvent == nullptr)
+                            continue;
 
-                            snd_midi_event_reset_decode (midiParser);
-
-                            if (numBytes > 0)
-                            {
-                                const MidiMessage message ((const uint8*) buffer,
-                                                           numBytes,
-                                                           Time::getMillisecondCounter() * 0.001);
+                        // xxx what about SYSEXes that are too big for the buffer?
+                        const int numBytes = snd_midi_event_decode (midiParser, buffer, maxEventSize, inputEvent);
 
+                        snd_midi_event_reset_decode (midiParser);
 
-                                callback->handleIncomingMidiMessage (midiInput, message);
-                            }
+                        if (numBytes > 0)
+                        {
+                            batch.add (MidiMessage ((const uint8*) buffer, numBytes,
+                                                    hasQueueTime ? getTimeStamp (*inputEvent, readTime, queueOffset)
+                                                                 : readTime));
 
-                            snd_seq_free_event (inputEvent);
+                            if (batch.size() >= maxBatchSize)
+                                deliver (batch);
                         }
+
+                        snd_seq_free_event (inputEvent);
                     }
-                    while (snd_seq_event_input_pending (seqHandle, 0) > 0);
 
-                    snd_seq_free_event (inputEvent);
+                    deliver (batch);
                 }
             }
+        }
+
+        if (queueStatus != nullptr)
+            snd_seq_queue_status_free (queueStatus);
 
+        if (midiParser != nullptr)
             snd_midi_event_free (midiParser);
-        }
     };
 
 private:
     MidiInput* const midiInput;
     snd_seq_t* const seqHandle;
     MidiInputCallback* const callback;
+    const int queue;    // the queue that stamps the events, or negative if the port isn't subscribed through one
+
+    /*  Reads the real time of the queue together with the monotonic clock that the
+        message timestamps use (Time::getMillisecondCounterHiRes()), and returns the
+        difference between the two. False if the input has no queue.
+    */
+    bool getQueueOffset (snd_seq_queue_status_t* queueStatus, double& readTime, double& queueOffset) const
+    {
+        if (queue >= 0 && snd_seq_get_queue_status (seqHandle, queue, queueStatus) == 0)
+        {
+            readTime = Time::getMillisecondCounterHiRes() * 0.001;
+
+            const snd_seq_real_time_t* const queueTime = snd_seq_queue_status_get_real_time (queueStatus);
+            queueOffset = readTime - (queueTime->tv_sec + queueTime->tv_nsec * 1.0e-9);
+            return true;
+        }
+
+        readTime = Time::getMillisecondCounterHiRes() * 0.001;
+        queueOffset = 0;
+        return false;
+    }
+
+    /*  The time an event arrived. Events that came in another way than through the
+        queue get the time they were read.
+    */
+    double getTimeStamp (const snd_seq_event_t& event, const double readTime, const double queueOffset) const
+    {
+        if ((event.flags & SND_SEQ_TIME_STAMP_MASK) != SND_SEQ_TIME_STAMP_REAL || event.queue != queue)
+            return readTime;
+
+        return jmin (readTime, queueOffset + event.time.time.tv_sec + event.time.time.tv_nsec * 1.0e-9);
+    }
+
+    void deliver (Array <MidiMessage>& batch)
+    {
+        if (batch.size() > 0)
+        {
+            callback->handleIncomingMidiMessages (midiInput, batch.getRawDataPointer(), batch.size());
+            batch.clearQuick();
+        }
+    }
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiInputThread);
 };
@@ -358,20 +504,22 @@ MidiInput::MidiInput (const String& name_)
 {
 }
 
+// (the internal object is a MidiInputThread, or a JackMidiInput for the JACK MIDI device)
 MidiInput::~MidiInput()
 {
     stop();
-    delete static_cast <MidiInputThread*> (internal);
+    delete static_cast <Thread*> (internal);
 }
 
 void MidiInput::start()
 {
-    static_cast <MidiInputThread*> (internal)->startThread();
+    // a real-time priority, so the events are read as they arrive even while the UI is busy
+    static_cast <Thread*> (internal)->startThread (9);
 }
 
 void MidiInput::stop()
 {
-    static_cast <MidiInputThread*> (internal)->stopThread (3000);
+    static_cast <Thread*> (internal)->stopThread (3000);
 }
 
 int MidiInput::getDefaultDeviceIndex()
@@ -383,6 +531,12 @@ StringArray MidiInput::getDevices()
 {
     StringArray devices;
     iterateMidiDevices (true, devices, -1);
+
+   #if JUCE_JACK
+    if (juce_load_jack_library())
+        devices.add (jackMidiDeviceName);
+   #endif
+
     return devices;
 }
 
@@ -396,8 +550,15 @@ MidiInput* MidiInput::openDevice (int deviceIndex, MidiInputCallback* callback)
     if (handle != 0)
     {
         newDevice = new MidiInput (devices [deviceIndex]);
-        newDevice->internal = new MidiInputThread (newDevice, handle, callback);
+        newDevice->internal = static_cast <Thread*> (new MidiInputThread (newDevice, handle, callback));
+    }
+   #if JUCE_JACK
+    else if (deviceIndex == devices.size() && callback != nullptr && juce_load_jack_library())
+    {
+        newDevice = new MidiInput (jackMidiDeviceName);
+        newDevice->internal = static_cast <Thread*> (new JackMidiInput (newDevice, callback));
     }
+   #endif
 
     return newDevice;
 }
@@ -411,7 +572,7 @@ MidiInput* MidiInput::createNewDevice (const String& deviceName, MidiInputCallba
     if (handle != 0)
     {
         newDevice = new MidiInput (deviceName);
-        newDevice->internal = new MidiInputThread (newDevice, handle, callback);
+        newDevice->internal = static_cast <Thread*> (new MidiInputThread (newDevice, handle, callback));
     }
 
     return newDevice;
@@ -430,6 +591,8 @@ MidiOutput* MidiOutput::openDevice (int)                            { return nul
 MidiOutput* MidiOutput::createNewDevice (const String&)             { return nullptr; }
 MidiOutput::~MidiOutput()   {}
 void MidiOutput::sendMessageNow (const MidiMessage&)    {}
+void MidiOutput::sendShortMessageNow (uint32)           {}
+void MidiOutput::sendMessagesNow (const MidiMessage* const*, int) {}
 
 MidiInput::MidiInput (const String& name_) : name (name_), internal (0)  {}
 MidiInput::~MidiInput() {}
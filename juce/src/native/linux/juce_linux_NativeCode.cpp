@@ -49,6 +49,7 @@ BEGIN_JUCE_NAMESPACE
 #include "../../core/juce_Singleton.h"
 #include "../../memory/juce_MemoryBlock.h"
 #include "../../containers/juce_ReferenceCountedArray.h"
+#include "../../containers/juce_AbstractFifo.h"
 #include "../../utilities/juce_DeletedAtShutdown.h"
 #include "../../utilities/juce_SystemClipboard.h"
 #include "../../text/juce_StringArray.h"
@@ -58,6 +58,8 @@
 #include <sys/sysinfo.h>
 #include <sys/file.h>
 #include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <signal.h>
 
 /* Got a build error here? You'll need to install the freetype library...
@@ -132,6 +134,7 @@
     Juce with low latency audio support, just disable the JUCE_JACK flag in juce_Config.h
  */
  #include <jack/jack.h>
+ #include <jack/midiport.h>
  //#include <jack/transport.h>
 #endif
 
@@ -226,6 +226,77 @@ namespace CoreMidiHelpers
         MIDIEndpointRef endPoint;
     };
 
+    //==============================================================================
+    /*  Packs messages into as few MIDIPacketLists as possible. Short messages with the same
+        timestamp end up in one packet, a sysex is split into packets of maxSysExPacketSize
+        bytes, and a list is only sent when it's full or flush() is called.
+    */
+    class PacketListBuilder
+    {
+    public:
+        PacketListBuilder (MidiPortAndEndpoint& mpe_)
+            : mpe (mpe_),
+              buffer (listSize)
+        {
+            reset();
+        }
+
+        void add (const uint8* data, const int numBytes, const MIDITimeStamp timeStamp)
+        {
+            const int maxPacketSize = (numBytes > 0 && data[0] == 0xf0) ? (int) maxSysExPacketSize : numBytes;
+
+            for (int bytesLeft = numBytes; bytesLeft > 0;)
+            {
+                const int packetSize = jmin (maxPacketSize, bytesLeft);
+
+                if (! addPacket (data, packetSize, timeStamp))
+                {
+                    flush();
+                    addPacket (data, packetSize, timeStamp);
+                }
+
+                data += packetSize;
+                bytesLeft -= packetSize;
+            }
+        }
+
+        void flush()
+        {
+            if (getList()->numPackets > 0)
+                mpe.send (getList());
+
+            reset();
+        }
+
+    private:
+        enum { listSize = 16384,
+               maxSysExPacketSize = 256 };
+
+        MidiPortAndEndpoint& mpe;
+        HeapBlock <char> buffer;
+        MIDIPacket* currentPacket;
+
+        MIDIPacketList* getList() const noexcept    { return reinterpret_cast <MIDIPacketList*> (buffer.getData()); }
+
+        void reset()
+        {
+            currentPacket = MIDIPacketListInit (getList());
+        }
+
+        bool addPacket (const uint8* const data, const int numBytes, const MIDITimeStamp timeStamp)
+        {
+            MIDIPacket* const next = MIDIPacketListAdd (getList(), listSize, currentPacket, timeStamp, (ByteCount) numBytes, data);
+
+            if (next == nullptr)
+                return false;
+
+            currentPacket = next;
+            return true;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (PacketListBuilder);
+    };
+
     //==============================================================================
     class MidiPortAndCallback;
     CriticalSection callbackLock;
@@ -375,26 +446,9 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
 
     if (message.isSysEx())
     {
-        const int maxPacketSize = 256;
-        int pos = 0, bytesLeft = message.getRawDataSize();
-        const int numPackets = (bytesLeft + maxPacketSize - 1) / maxPacketSize;
-        HeapBlock <MIDIPacketList> packets;
-        packets.malloc (32 * numPackets + message.getRawDataSize(), 1);
-        packets->numPackets = numPackets;
-
-        MIDIPacket* p = packets->packet;
-
-        for (int i = 0; i < numPackets; ++i)
-        {
-            p->timeStamp = AudioGetCurrentHostTime();
-            p->length = jmin (maxPacketSize, bytesLeft);
-            memcpy (p->data, message.getRawData() + pos, p->length);
-            pos += p->length;
-            bytesLeft -= p->length;
-            p = MIDIPacketNext (p);
-        }
-
-        mpe->send (packets);
+        CoreMidiHelpers::PacketListBuilder packets (*mpe);
+        packets.add (message.getRawData(), message.getRawDataSize(), AudioGetCurrentHostTime());
+        packets.flush();
     }
     else
     {
@@ -408,6 +462,69 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
     }
 }
 
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+    MIDIPacketList packets;
+    packets.numPackets = 1;
+    packets.packet[0].timeStamp = AudioGetCurrentHostTime();
+    packets.packet[0].length = (UInt16) MidiMessage::getMessageLengthFromFirstByte ((uint8) packedMessage);
+    packets.packet[0].data[0] = (Byte) packedMessage;
+    packets.packet[0].data[1] = (Byte) (packedMessage >> 8);
+    packets.packet[0].data[2] = (Byte) (packedMessage >> 16);
+
+    static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal)->send (&packets);
+}
+
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+    CoreMidiHelpers::PacketListBuilder packets (*static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal));
+    const MIDITimeStamp now = AudioGetCurrentHostTime();
+
+    for (int i = 0; i < numMessages; ++i)
+        packets.add (messages[i]->getRawData(), messages[i]->getRawDataSize(), now);
+
+    packets.flush();
+}
+
+bool MidiOutput::sendBlockScheduled (const MidiBuffer& buffer,
+                                     const double millisecondCounterToStartAt,
+                                     const double samplesPerSecondForBuffer)
+{
+    CoreMidiHelpers::MidiPortAndEndpoint* const mpe = static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal);
+
+    // a virtual source passes the timestamps on to its clients without waiting for them
+    if (mpe->port == 0)
+        return false;
+
+    const MIDITimeStamp hostNow = AudioGetCurrentHostTime();
+    const double nanosToStart = (millisecondCounterToStartAt - Time::getMillisecondCounterHiRes()) * 1.0e6;
+    const double nanosPerSample = 1.0e9 / samplesPerSecondForBuffer;
+
+    CoreMidiHelpers::PacketListBuilder packets (*mpe);
+    MidiBuffer::Iterator i (buffer);
+    const uint8* data;
+    int len, time;
+
+    while (i.getNextEvent (data, len, time))
+    {
+        const double nanosAhead = nanosToStart + nanosPerSample * time;
+
+        packets.add (data, len, nanosAhead > 0 ? hostNow + AudioConvertNanosToHostTime ((UInt64) nanosAhead)
+                                               : hostNow);
+    }
+
+    packets.flush();
+    return true;
+}
+
+void MidiOutput::flushScheduledMessages()
+{
+    CoreMidiHelpers::MidiPortAndEndpoint* const mpe = static_cast<CoreMidiHelpers::MidiPortAndEndpoint*> (internal);
+
+    if (mpe != nullptr && mpe->port != 0)
+        MIDIFlushOutput (mpe->endPoint);
+}
+
 //==============================================================================
 StringArray MidiInput::getDevices()
 {
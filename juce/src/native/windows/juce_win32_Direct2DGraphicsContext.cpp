@@ -66,25 +66,18 @@ public:
         : hwnd (hwnd_),
           currentState (nullptr)
     {
-        RECT windowRect;
-        GetClientRect (hwnd, &windowRect);
-        D2D1_SIZE_U size = { windowRect.right - windowRect.left, windowRect.bottom - windowRect.top };
-        bounds.setSize (size.width, size.height);
-
-        D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties();
-        D2D1_HWND_RENDER_TARGET_PROPERTIES propsHwnd = D2D1::HwndRenderTargetProperties (hwnd, size);
-
-        HRESULT hr = SharedD2DFactory::getInstance()->d2dFactory->CreateHwndRenderTarget (props, propsHwnd, renderingTarget.resetAndGetPointerAddress());
-        // xxx check for error
-
-        hr = renderingTarget->CreateSolidColorBrush (D2D1::ColorF::ColorF (0.0f, 0.0f, 0.0f, 1.0f), colourBrush.resetAndGetPointerAddress());
+        createRenderTarget();
     }
 
     ~Direct2DLowLevelGraphicsContext()
     {
         states.clear();
+        cachedBitmaps.clear();
     }
 
+    /** false if no render target could be created, the window has to paint in software*/
+    bool isValid() const noexcept       { return renderingTarget != nullptr; }
+
     void resized()
     {
         RECT windowRect;
@@ -106,12 +99,24 @@ public:
         saveState();
     }
 
-    void end()
+    /** returns false if the device was lost and the render target could not be made again*/
+    bool end()
     {
         states.clear();
         currentState = 0;
-        renderingTarget->EndDraw();
+        const HRESULT hr = renderingTarget->EndDraw();
+
+        if (hr == D2DERR_RECREATE_TARGET)
+        {
+            // everything made by the old target belongs to the lost device
+            cachedBitmaps.clear();
+            createRenderTarget();
+            InvalidateRect (hwnd, 0, FALSE);
+            return isValid();
+        }
+
         renderingTarget->CheckWindowState();
+        return SUCCEEDED (hr);
     }
 
     bool isVectorDevice() const { return false; }
@@ -236,20 +241,18 @@ public:
 
         renderingTarget->SetTransform (transformToMatrix (transform) * D2D1::Matrix3x2F::Translation (x, y));
 
-        D2D1_SIZE_U size;
-        size.width = image.getWidth();
-        size.height = image.getHeight();
-
-        D2D1_BITMAP_PROPERTIES bp = D2D1::BitmapProperties();
-
-        Image img (image.convertedToFormat (Image::ARGB));
-        Image::BitmapData bd (img, Image::BitmapData::readOnly);
-        bp.pixelFormat = renderingTarget->GetPixelFormat();
-        bp.pixelFormat.alphaMode = D2D1_ALPHA_MODE_PREMULTIPLIED;
-
+        // images that promise not to change are uploaded once and kept on the device
+        const NamedValueSet* const properties = image.getProperties();
+        if (properties != nullptr && properties->contains ("cacheAsBitmap"))
+        {
+            ID2D1Bitmap* const bitmap = getCachedBitmap (image);
+            if (bitmap != nullptr)
+                renderingTarget->DrawBitmap (bitmap);
+        }
+        else
         {
             ComSmartPtr <ID2D1Bitmap> tempBitmap;
-            renderingTarget->CreateBitmap (size, bd.data, bd.lineStride, bp, tempBitmap.resetAndGetPointerAddress());
+            createBitmap (image, tempBitmap);
             if (tempBitmap != nullptr)
                 renderingTarget->DrawBitmap (tempBitmap);
         }
@@ -779,6 +782,69 @@ private:
     SavedState* currentState;
     OwnedArray<SavedState> states;
 
+    struct CachedBitmap
+    {
+        Image image;
+        ComSmartPtr <ID2D1Bitmap> bitmap;
+    };
+
+    enum { maxCachedBitmaps = 256 };
+    OwnedArray<CachedBitmap> cachedBitmaps;
+
+    void createRenderTarget()
+    {
+        renderingTarget = nullptr;
+        colourBrush = nullptr;
+
+        RECT windowRect;
+        GetClientRect (hwnd, &windowRect);
+        D2D1_SIZE_U size = { windowRect.right - windowRect.left, windowRect.bottom - windowRect.top };
+        bounds.setSize (size.width, size.height);
+
+        D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties();
+        D2D1_HWND_RENDER_TARGET_PROPERTIES propsHwnd = D2D1::HwndRenderTargetProperties (hwnd, size);
+
+        HRESULT hr = SharedD2DFactory::getInstance()->d2dFactory->CreateHwndRenderTarget (props, propsHwnd, renderingTarget.resetAndGetPointerAddress());
+
+        if (FAILED (hr))
+            renderingTarget = nullptr;
+        else
+            hr = renderingTarget->CreateSolidColorBrush (D2D1::ColorF::ColorF (0.0f, 0.0f, 0.0f, 1.0f), colourBrush.resetAndGetPointerAddress());
+    }
+
+    void createBitmap (const Image& image, ComSmartPtr <ID2D1Bitmap>& bitmap)
+    {
+        D2D1_SIZE_U size;
+        size.width = image.getWidth();
+        size.height = image.getHeight();
+
+        D2D1_BITMAP_PROPERTIES bp = D2D1::BitmapProperties();
+
+        Image img (image.convertedToFormat (Image::ARGB));
+        Image::BitmapData bd (img, Image::BitmapData::readOnly);
+        bp.pixelFormat = renderingTarget->GetPixelFormat();
+        bp.pixelFormat.alphaMode = D2D1_ALPHA_MODE_PREMULTIPLIED;
+
+        renderingTarget->CreateBitmap (size, bd.data, bd.lineStride, bp, bitmap.resetAndGetPointerAddress());
+    }
+
+    ID2D1Bitmap* getCachedBitmap (const Image& image)
+    {
+        for (int i = cachedBitmaps.size(); --i >= 0;)
+            if (cachedBitmaps.getUnchecked(i)->image.getSharedImage() == image.getSharedImage())
+                return cachedBitmaps.getUnchecked(i)->bitmap;
+
+        // the oldest upload goes first
+        if (cachedBitmaps.size() >= maxCachedBitmaps)
+            cachedBitmaps.remove (0);
+
+        CachedBitmap* const cached = new CachedBitmap();
+        cached->image = image;
+        createBitmap (image, cached->bitmap);
+        cachedBitmaps.add (cached);
+        return cached->bitmap;
+    }
+
     //==============================================================================
     static D2D1_RECT_F rectangleToRectF (const Rectangle<int>& r)
     {
@@ -641,7 +641,13 @@ public:
 
         if (handle == INVALID_HANDLE_VALUE)
         {
-            handle = FindFirstFile (directoryWithWildCard.toWideCharPointer(), &findData);
+            // without the short names, and with a bigger buffer for each call to the file system..
+            handle = FindFirstFileEx (directoryWithWildCard.toWideCharPointer(), (FINDEX_INFO_LEVELS) findExInfoBasic,
+                                      &findData, FindExSearchNameMatch, 0, findFirstExLargeFetch);
+
+            // ..which needs Windows 7 or later
+            if (handle == INVALID_HANDLE_VALUE && GetLastError() == ERROR_INVALID_PARAMETER)
+                handle = FindFirstFile (directoryWithWildCard.toWideCharPointer(), &findData);
 
             if (handle == INVALID_HANDLE_VALUE)
                 return false;
@@ -668,6 +674,9 @@ private:
     const String directoryWithWildCard;
     HANDLE handle;
 
+    // (not defined by older SDKs)
+    enum { findExInfoBasic = 1, findFirstExLargeFetch = 2 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Pimpl);
 };
 
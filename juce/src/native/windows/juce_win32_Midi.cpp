@@ -29,16 +29,25 @@
 
 
 //==============================================================================
-class MidiInCollector
+/*  The winmm callback only copies what arrives into a lock-free ring, together with the
+    driver's timestamp, and gives a long-message buffer straight back to the driver. The
+    headers are prepared once in start(), so recycling one is just midiInAddBuffer() and a
+    large dump never waits while buffers are re-prepared. A high-priority thread takes the
+    messages out of the ring and passes them on to the MidiInputCallback.
+*/
+class MidiInCollector  : public Thread
 {
 public:
     //==============================================================================
     MidiInCollector (MidiInput* const input_,
                      MidiInputCallback& callback_)
-        : deviceHandle (0),
+        : Thread ("Juce MIDI Input"),
+          deviceHandle (0),
           input (input_),
           callback (callback_),
           concatenator (4096),
+          fifo (ringSize),
+          ring (ringSize),
           isStarted (false),
           startTime (0)
     {
@@ -65,18 +74,18 @@ public:
     void handleMessage (const uint32 message, const uint32 timeStamp)
     {
         if ((message & 0xff) >= 0x80 && isStarted)
-        {
-            concatenator.pushMidiData (&message, 3, convertTimeStamp (timeStamp), input, callback);
-            writeFinishedBlocks();
-        }
+            pushToRing (&message, 3, timeStamp, false);
     }
 
-    void handleSysEx (MIDIHDR* const hdr, const uint32 timeStamp)
+    void handleSysEx (MIDIHDR* const hdr, const uint32 timeStamp, const bool isValid)
     {
-        if (isStarted && hdr->dwBytesRecorded > 0)
+        if (isStarted)
         {
-            concatenator.pushMidiData (hdr->lpData, hdr->dwBytesRecorded, convertTimeStamp (timeStamp), input, callback);
-            writeFinishedBlocks();
+            if (isValid && hdr->dwBytesRecorded > 0)
+                pushToRing (hdr->lpData, (int) hdr->dwBytesRecorded, timeStamp, true);
+
+            hdr->dwBytesRecorded = 0;
+            midiInAddBuffer (deviceHandle, hdr, sizeof (MIDIHDR));
         }
     }
 
@@ -87,19 +96,24 @@ public:
         {
             activeMidiCollectors.addIfNotAlreadyThere (this);
 
+            fifo.reset();
+            concatenator.reset();
+
             for (int i = 0; i < (int) numHeaders; ++i)
                 headers[i].write (deviceHandle);
 
             startTime = Time::getMillisecondCounter();
+            startThread (9);
+
             MMRESULT res = midiInStart (deviceHandle);
 
             if (res == MMSYSERR_NOERROR)
             {
-                concatenator.reset();
                 isStarted = true;
             }
             else
             {
+                stopThread (2000);
                 unprepareAllHeaders();
             }
         }
@@ -113,11 +127,45 @@ public:
             midiInReset (deviceHandle);
             midiInStop (deviceHandle);
             activeMidiCollectors.removeValue (this);
+            stopThread (2000);
             unprepareAllHeaders();
             concatenator.reset();
         }
     }
 
+    void run()
+    {
+        HeapBlock <uint8> data (maxRecordSize);
+
+        while (! threadShouldExit())
+        {
+            wait (500);
+
+            uint32 timeStamp;
+            int numBytes;
+            bool isSysEx;
+
+            while (popFromRing (data, numBytes, timeStamp, isSysEx))
+            {
+                const double time = convertTimeStamp (timeStamp);
+
+                if (isSysEx)
+                {
+                    concatenator.pushMidiData (data, numBytes, time, input, callback);
+                }
+                else
+                {
+                    // a short message is always complete, so it mustn't end up in the middle of a pending sysex
+                    int used = 0;
+                    const MidiMessage message (data, numBytes, used, 0, time);
+
+                    if (used > 0)
+                        callback.handleIncomingMidiMessage (input, message);
+                }
+            }
+        }
+    }
+
     static void CALLBACK midiInCallback (HMIDIIN, UINT uMsg, DWORD_PTR dwInstance, DWORD_PTR midiMessage, DWORD_PTR timeStamp)
     {
         MidiInCollector* const collector = reinterpret_cast <MidiInCollector*> (dwInstance);
@@ -126,8 +174,8 @@ public:
         {
             if (uMsg == MIM_DATA)
                 collector->handleMessage ((uint32) midiMessage, (uint32) timeStamp);
-            else if (uMsg == MIM_LONGDATA)
-                collector->handleSysEx ((MIDIHDR*) midiMessage, (uint32) timeStamp);
+            else if (uMsg == MIM_LONGDATA || uMsg == MIM_LONGERROR)
+                collector->handleSysEx ((MIDIHDR*) midiMessage, (uint32) timeStamp, uMsg == MIM_LONGDATA);
         }
     }
 
@@ -159,16 +207,6 @@ private:
             res = midiInAddBuffer (deviceHandle, &hdr, sizeof (hdr));
         }
 
-        void writeIfFinished (HMIDIIN deviceHandle)
-        {
-            if ((hdr.dwFlags & WHDR_DONE) != 0)
-            {
-                MMRESULT res = midiInUnprepareHeader (deviceHandle, &hdr, sizeof (hdr));
-                (void) res;
-                write (deviceHandle);
-            }
-        }
-
         void unprepare (HMIDIIN deviceHandle)
         {
             if ((hdr.dwFlags & WHDR_DONE) != 0)
@@ -183,7 +221,7 @@ private:
 
     private:
         MIDIHDR hdr;
-        char data [256];
+        char data [1024];
 
         JUCE_DECLARE_NON_COPYABLE (MidiHeader);
     };
@@ -191,10 +229,65 @@ private:
     enum { numHeaders = 32 };
     MidiHeader headers [numHeaders];
 
-    void writeFinishedBlocks()
+    /*  Each record in the ring is the driver's timestamp, the number of bytes and whether
+        they came in a sysex buffer, followed by the bytes. A record is only made visible when all of it has
+        been written, the callback is the only writer and run() the only reader.
+    */
+    enum { ringSize = 256 * 1024,
+           recordHeaderSize = 3 * sizeof (uint32),
+           maxRecordSize = recordHeaderSize + 1024 };
+
+    AbstractFifo fifo;
+    HeapBlock <uint8> ring;
+
+    void pushToRing (const void* const data, const int numBytes, const uint32 timeStamp, const bool isSysEx)
     {
-        for (int i = 0; i < (int) numHeaders; ++i)
-            headers[i].writeIfFinished (deviceHandle);
+        const int recordSize = (int) recordHeaderSize + numBytes;
+        jassert (recordSize <= (int) maxRecordSize);
+
+        if (fifo.getFreeSpace() < recordSize)
+        {
+            jassertfalse; // the input thread isn't keeping up..
+            return;
+        }
+
+        uint8 record [maxRecordSize];
+        const uint32 header[] = { timeStamp, (uint32) numBytes, isSysEx ? 1u : 0u };
+        memcpy (record, header, recordHeaderSize);
+        memcpy (record + recordHeaderSize, data, (size_t) numBytes);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (recordSize, start1, size1, start2, size2);
+        memcpy (ring + start1, record, (size_t) size1);
+        memcpy (ring + start2, record + size1, (size_t) size2);
+        fifo.finishedWrite (size1 + size2);
+
+        notify();
+    }
+
+    bool popFromRing (uint8* const data, int& numBytes, uint32& timeStamp, bool& isSysEx)
+    {
+        if (fifo.getNumReady() < (int) recordHeaderSize)
+            return false;
+
+        uint32 header[3];
+        copyFromRing (header, recordHeaderSize);
+        timeStamp = header[0];
+        numBytes = (int) header[1];
+        isSysEx = header[2] != 0;
+
+        copyFromRing (data, recordHeaderSize + numBytes);
+        memmove (data, data + recordHeaderSize, (size_t) numBytes);
+        fifo.finishedRead ((int) recordHeaderSize + numBytes);
+        return true;
+    }
+
+    void copyFromRing (void* const dest, const int numBytes)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (numBytes, start1, size1, start2, size2);
+        memcpy (dest, ring + start1, (size_t) size1);
+        memcpy (static_cast <uint8*> (dest) + size1, ring + start2, (size_t) size2);
     }
 
     void unprepareAllHeaders()
@@ -325,7 +418,146 @@ struct MidiOutHandle
 
     static Array<MidiOutHandle*> activeHandles;
 
+    //==============================================================================
+    /* Long messages are copied into one of a few prepared headers which are reused once
+       the driver has finished with them, so sending returns without waiting for the data
+       to be played.
+    */
+    void sendLongMessage (const void* const data, const int numBytes)
+    {
+        const ScopedLock sl (longMessageLock);
+
+        LongMessageHeader* const h = getFreeHeader();
+
+        if (h == nullptr)
+        {
+            jassertfalse; // the driver isn't returning any buffers..
+            return;
+        }
+
+        if (h->allocatedSize < numBytes)
+        {
+            h->unprepare (handle);
+            h->data.malloc ((size_t) numBytes);
+            h->allocatedSize = numBytes;
+        }
+
+        if (! h->prepare (handle))
+            return;
+
+        memcpy (h->data, data, (size_t) numBytes);
+        h->header.dwBufferLength = (DWORD) numBytes;
+        h->header.dwBytesRecorded = (DWORD) numBytes;
+
+        h->inFlight = (midiOutLongMsg (handle, &(h->header), sizeof (MIDIHDR)) == MMSYSERR_NOERROR);
+    }
+
+    /* Has to be called before the handle is closed. */
+    void releaseLongMessageHeaders()
+    {
+        const ScopedLock sl (longMessageLock);
+
+        for (int i = longMessageHeaders.size(); --i >= 0;)
+        {
+            LongMessageHeader* const h = longMessageHeaders.getUnchecked(i);
+
+            int count = 500; // 1 sec timeout
+
+            while (! h->isFree() && --count >= 0)
+                Sleep (2);
+
+            if (! h->isFree())
+                midiOutReset (handle);
+
+            h->unprepare (handle);
+        }
+
+        longMessageHeaders.clear();
+    }
+
 private:
+    struct LongMessageHeader
+    {
+        LongMessageHeader() : allocatedSize (0), prepared (false), inFlight (false)
+        {
+            zerostruct (header);
+        }
+
+        bool isFree() const noexcept
+        {
+            return (! inFlight) || (header.dwFlags & MHDR_DONE) != 0;
+        }
+
+        bool prepare (HMIDIOUT handle)
+        {
+            if (! prepared)
+            {
+                zerostruct (header);
+                header.lpData = data;
+                header.dwBufferLength = (DWORD) allocatedSize;
+
+                prepared = (midiOutPrepareHeader (handle, &header, sizeof (MIDIHDR)) == MMSYSERR_NOERROR);
+            }
+
+            return prepared;
+        }
+
+        void unprepare (HMIDIOUT handle)
+        {
+            if (prepared)
+            {
+                int count = 500;
+
+                while (midiOutUnprepareHeader (handle, &header, sizeof (MIDIHDR)) == MIDIERR_STILLPLAYING
+                        && --count >= 0)
+                    Sleep (2);
+
+                prepared = false;
+                inFlight = false;
+            }
+        }
+
+        MIDIHDR header;
+        HeapBlock <char> data;
+        int allocatedSize;
+        bool prepared, inFlight;
+    };
+
+    enum { maxLongMessageHeaders = 8 };
+
+    LongMessageHeader* getFreeHeader()
+    {
+        for (int i = 0; i < longMessageHeaders.size(); ++i)
+            if (longMessageHeaders.getUnchecked(i)->isFree())
+                return longMessageHeaders.getUnchecked(i);
+
+        if (longMessageHeaders.size() < maxLongMessageHeaders)
+        {
+            LongMessageHeader* const h = new LongMessageHeader();
+            longMessageHeaders.add (h);
+            return h;
+        }
+
+        // all buffers are busy, wait for the oldest one
+        LongMessageHeader* const oldest = longMessageHeaders.getUnchecked(0);
+        int count = 500; // 1 sec timeout
+
+        while (! oldest->isFree())
+        {
+            if (--count < 0)
+                return nullptr;
+
+            Sleep (2);
+        }
+
+        // keep the headers in the order they were sent
+        longMessageHeaders.move (0, -1);
+        return oldest;
+    }
+
+    OwnedArray <LongMessageHeader> longMessageHeaders;
+    CriticalSection longMessageLock;
+
     JUCE_LEAK_DETECTOR (MidiOutHandle);
 };
 
@@ -448,6 +680,7 @@ MidiOutput::~MidiOutput()
 
     if (MidiOutHandle::activeHandles.contains (h) && --(h->refCount) == 0)
     {
+        h->releaseLongMessageHeaders();
         midiOutClose (h->handle);
         MidiOutHandle::activeHandles.removeValue (h);
         delete h;
@@ -456,39 +689,12 @@ MidiOutput::~MidiOutput()
 
 void MidiOutput::sendMessageNow (const MidiMessage& message)
 {
-    const MidiOutHandle* const handle = static_cast <const MidiOutHandle*> (internal);
+    MidiOutHandle* const handle = static_cast <MidiOutHandle*> (internal);
 
     if (message.getRawDataSize() > 3
          || message.isSysEx())
     {
-        MIDIHDR h = { 0 };
-
-        h.lpData = (char*) message.getRawData();
-        h.dwBufferLength = message.getRawDataSize();
-        h.dwBytesRecorded = message.getRawDataSize();
-
-        if (midiOutPrepareHeader (handle->handle, &h, sizeof (MIDIHDR)) == MMSYSERR_NOERROR)
-        {
-            MMRESULT res = midiOutLongMsg (handle->handle, &h, sizeof (MIDIHDR));
-
-            if (res == MMSYSERR_NOERROR)
-            {
-                while ((h.dwFlags & MHDR_DONE) == 0)
-                    Sleep (1);
-
-                int count = 500; // 1 sec timeout
-
-                while (--count >= 0)
-                {
-                    res = midiOutUnprepareHeader (handle->handle, &h, sizeof (MIDIHDR));
-
-                    if (res == MIDIERR_STILLPLAYING)
-                        Sleep (2);
-                    else
-                        break;
-                }
-            }
-        }
+        handle->sendLongMessage (message.getRawData(), message.getRawDataSize());
     }
     else
     {
@@ -497,4 +703,26 @@ void MidiOutput::sendMessageNow (const MidiMessage& message)
     }
 }
 
+void MidiOutput::sendShortMessageNow (const uint32 packedMessage)
+{
+    midiOutShortMsg (static_cast <MidiOutHandle*> (internal)->handle, packedMessage);
+}
+
+void MidiOutput::sendMessagesNow (const MidiMessage* const* messages, const int numMessages)
+{
+    if (numMessages == 1)
+    {
+        sendMessageNow (*messages[0]);
+        return;
+    }
+
+    // the whole run goes to the driver as one long buffer instead of a call per message
+    MemoryBlock data;
+
+    for (int i = 0; i < numMessages; ++i)
+        data.append (messages[i]->getRawData(), (size_t) messages[i]->getRawDataSize());
+
+    static_cast <MidiOutHandle*> (internal)->sendLongMessage (data.getData(), (int) data.getSize());
+}
+
 #endif
@@ -31,6 +31,10 @@
  #define WASAPI_ENABLE_LOGGING 0
 #endif
 
+#ifndef AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED
+ #define AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED  MAKE_HRESULT (SEVERITY_ERROR, 0x889, 0x019)
+#endif
+
 //==============================================================================
 namespace WasapiClasses
 {
@@ -71,6 +75,7 @@ void logFailure (HRESULT hr)
             case AUDCLNT_E_EVENTHANDLE_NOT_SET:             e << "AUDCLNT_E_EVENTHANDLE_NOT_SET"; break;
             case AUDCLNT_E_INCORRECT_BUFFER_SIZE:           e << "AUDCLNT_E_INCORRECT_BUFFER_SIZE"; break;
             case AUDCLNT_E_BUFFER_SIZE_ERROR:               e << "AUDCLNT_E_BUFFER_SIZE_ERROR"; break;
+            case AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED:         e << "AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED"; break;
             case AUDCLNT_S_BUFFER_EMPTY:                    e << "AUDCLNT_S_BUFFER_EMPTY"; break;
             case AUDCLNT_S_THREAD_ALREADY_REGISTERED:       e << "AUDCLNT_S_THREAD_ALREADY_REGISTERED"; break;
             default:                                        e << String::toHexString ((int) hr); break;
@@ -120,6 +125,11 @@ int refTimeToSamples (const REFERENCE_TIME& t, const double sampleRate) noexcept
     return roundDoubleToInt (sampleRate * ((double) t) * 0.0000001);
 }
 
+REFERENCE_TIME samplesToRefTime (const int numSamples, const double sampleRate) noexcept
+{
+    return (REFERENCE_TIME) ((numSamples * 10000.0 * 1000.0 / sampleRate) + 0.5);
+}
+
 void copyWavFormat (WAVEFORMATEXTENSIBLE& dest, const WAVEFORMATEX* const src) noexcept
 {
     memcpy (&dest, src, src->wFormatTag == WAVE_FORMAT_EXTENSIBLE ? sizeof (WAVEFORMATEXTENSIBLE)
@@ -140,9 +150,10 @@ public:
           defaultBufferSize (0),
           latencySamples (0),
           useExclusiveMode (useExclusiveMode_),
+          requestedBufferSize (0),
           sampleRateHasChanged (false)
     {
-        clientEvent = CreateEvent (0, false, false, _T("JuceWASAPI"));
+        clientEvent = CreateEvent (0, false, false, 0);
 
         ComSmartPtr <IAudioClient> tempClient (createClient());
         if (tempClient == nullptr)
@@ -191,9 +202,12 @@ public:
 
     bool isOk() const noexcept    { return defaultBufferSize > 0 && defaultSampleRate > 0; }
 
-    bool openClient (const double newSampleRate, const BigInteger& newChannels)
+    bool openClient (const double newSampleRate, const BigInteger& newChannels,
+                     const int bufferSizeSamples, const bool exclusive)
     {
         sampleRate = newSampleRate;
+        requestedBufferSize = bufferSizeSamples;
+        useExclusiveMode = exclusive;
         channels = newChannels;
         channels.setRange (actualNumChannels, channels.getHighestBit() + 1 - actualNumChannels, false);
         numChannels = channels.getHighestBit() + 1;
@@ -249,7 +263,8 @@ public:
     double sampleRate, defaultSampleRate;
     int numChannels, actualNumChannels;
     int minBufferSize, defaultBufferSize, latencySamples;
-    const bool useExclusiveMode;
+    bool useExclusiveMode;
+    int requestedBufferSize;
     Array <double> rates;
     HANDLE clientEvent;
     BigInteger channels;
@@ -330,6 +345,9 @@ private:
 
     bool tryInitialisingWithFormat (const bool useFloat, const int bytesPerSampleToTry)
     {
+        if (client == nullptr)
+            return false;
+
         WAVEFORMATEXTENSIBLE format = { 0 };
 
         if (numChannels <= 2 && bytesPerSampleToTry <= 2)
@@ -376,13 +394,34 @@ private:
 
         REFERENCE_TIME defaultPeriod = 0, minPeriod = 0;
         if (useExclusiveMode)
+        {
             check (client->GetDevicePeriod (&defaultPeriod, &minPeriod));
 
-        GUID session;
-        if (hr == S_OK
-             && check (client->Initialize (useExclusiveMode ? AUDCLNT_SHAREMODE_EXCLUSIVE : AUDCLNT_SHAREMODE_SHARED,
-                                           AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-                                           defaultPeriod, defaultPeriod, (WAVEFORMATEX*) &format, &session)))
+            // an exclusive stream's period is its buffer, so it's as short as was asked for
+            if (requestedBufferSize > 0)
+                defaultPeriod = jmax (minPeriod, samplesToRefTime (requestedBufferSize, format.Format.nSamplesPerSec));
+        }
+
+        if (hr == S_OK)
+        {
+            hr = initialiseClient (format, defaultPeriod);
+
+            if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+            {
+                // the buffer has to be a whole number of the device's own blocks, so the client is
+                // made again with the size it suggests
+                UINT32 alignedSize = 0;
+
+                if (check (client->GetBufferSize (&alignedSize)))
+                {
+                    defaultPeriod = samplesToRefTime ((int) alignedSize, format.Format.nSamplesPerSec);
+                    client = createClient();
+                    hr = client != nullptr ? initialiseClient (format, defaultPeriod) : E_FAIL;
+                }
+            }
+        }
+
+        if (hr == S_OK)
         {
             actualNumChannels = format.Format.nChannels;
             const bool isFloat = format.Format.wFormatTag == WAVE_FORMAT_EXTENSIBLE && format.SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
@@ -395,6 +434,16 @@ private:
         return false;
     }
 
+    HRESULT initialiseClient (WAVEFORMATEXTENSIBLE& format, const REFERENCE_TIME period)
+    {
+        GUID session;
+        const HRESULT hr = client->Initialize (useExclusiveMode ? AUDCLNT_SHAREMODE_EXCLUSIVE : AUDCLNT_SHAREMODE_SHARED,
+                                               AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                                               period, period, (WAVEFORMATEX*) &format, &session);
+        logFailure (hr);
+        return hr;
+    }
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WASAPIDeviceBase);
 };
 
@@ -413,12 +462,13 @@ public:
         close();
     }
 
-    bool open (const double newSampleRate, const BigInteger& newChannels)
+    bool open (const double newSampleRate, const BigInteger& newChannels,
+               const int bufferSizeSamples, const bool exclusive)
     {
         reservoirSize = 0;
         reservoirCapacity = 16384;
         reservoir.setSize (actualNumChannels * reservoirCapacity * sizeof (float));
-        return openClient (newSampleRate, newChannels)
+        return openClient (newSampleRate, newChannels, bufferSizeSamples, exclusive)
                 && (numChannels == 0 || check (client->GetService (__uuidof (IAudioCaptureClient),
                                                                    (void**) captureClient.resetAndGetPointerAddress())));
     }
@@ -530,10 +580,22 @@ public:
         close();
     }
 
-    bool open (const double newSampleRate, const BigInteger& newChannels)
+    bool open (const double newSampleRate, const BigInteger& newChannels,
+               const int bufferSizeSamples, const bool exclusive)
     {
-        return openClient (newSampleRate, newChannels)
-            && (numChannels == 0 || check (client->GetService (__uuidof (IAudioRenderClient), (void**) renderClient.resetAndGetPointerAddress())));
+        if (! (openClient (newSampleRate, newChannels, bufferSizeSamples, exclusive)
+                && (numChannels == 0 || check (client->GetService (__uuidof (IAudioRenderClient), (void**) renderClient.resetAndGetPointerAddress())))))
+            return false;
+
+        // an exclusive stream starts with a buffer of silence queued, so the first period isn't a glitch
+        if (useExclusiveMode && numChannels > 0)
+        {
+            uint8* outputData = nullptr;
+            if (check (renderClient->GetBuffer (actualBufferSize, &outputData)))
+                renderClient->ReleaseBuffer (actualBufferSize, AUDCLNT_BUFFERFLAGS_SILENT);
+        }
+
+        return true;
     }
 
     void close()
@@ -566,20 +628,34 @@ public:
 
         while (bufferSize > 0)
         {
-            UINT32 padding = 0;
-            if (! check (client->GetCurrentPadding (&padding)))
-                return;
-
-            int samplesToDo = useExclusiveMode ? bufferSize
-                                               : jmin ((int) (actualBufferSize - padding), bufferSize);
+            int samplesToDo;
 
-            if (samplesToDo <= 0)
+            if (useExclusiveMode)
             {
+                // the event comes each time the device has taken one of its two buffers, the
+                // next one is then written whole (the callback's buffer size is the device's)
                 if (thread.threadShouldExit()
                      || WaitForSingleObject (clientEvent, 1000) == WAIT_TIMEOUT)
                     break;
 
-                continue;
+                samplesToDo = jmin ((int) actualBufferSize, bufferSize);
+            }
+            else
+            {
+                UINT32 padding = 0;
+                if (! check (client->GetCurrentPadding (&padding)))
+                    return;
+
+                samplesToDo = jmin ((int) (actualBufferSize - padding), bufferSize);
+
+                if (samplesToDo <= 0)
+                {
+                    if (thread.threadShouldExit()
+                         || WaitForSingleObject (clientEvent, 1000) == WAIT_TIMEOUT)
+                        break;
+
+                    continue;
+                }
             }
 
             uint8* outputData = nullptr;
@@ -609,14 +685,16 @@ class WASAPIAudioIODevice  : public AudioIODevice,
 {
 public:
     WASAPIAudioIODevice (const String& deviceName,
+                         const String& typeName,
                          const String& outputDeviceId_,
                          const String& inputDeviceId_,
                          const bool useExclusiveMode_)
-        : AudioIODevice (deviceName, "Windows Audio"),
+        : AudioIODevice (deviceName, typeName),
           Thread ("Juce WASAPI"),
           outputDeviceId (outputDeviceId_),
           inputDeviceId (inputDeviceId_),
           useExclusiveMode (useExclusiveMode_),
+          isExclusive (false),
           isOpen_ (false),
           isStarted (false),
           currentBufferSizeSamples (0),
@@ -729,18 +807,24 @@ public:
         currentBufferSizeSamples = bufferSizeSamples <= 0 ? defaultBufferSize : jmax (bufferSizeSamples, minBufferSize);
         currentSampleRate = sampleRate > 0 ? sampleRate : defaultSampleRate;
 
-        if (inputDevice != nullptr && ! inputDevice->open (currentSampleRate, inputChannels))
+        isExclusive = useExclusiveMode;
+        lastError = openDevices (inputChannels, outputChannels);
+
+        if (lastError.isNotEmpty() && isExclusive)
         {
-            lastError = "Couldn't open the input device!";
-            return lastError;
+            // another application has the device, or it can't do the format on its own..
+            isExclusive = false;
+            lastError = openDevices (inputChannels, outputChannels);
         }
 
-        if (outputDevice != nullptr && ! outputDevice->open (currentSampleRate, outputChannels))
-        {
-            close();
-            lastError = "Couldn't open the output device!";
+        if (lastError.isNotEmpty())
             return lastError;
-        }
+
+        // an exclusive stream is driven by the device's buffers, so the callbacks have their size
+        if (isExclusive && outputDevice != nullptr && outputDevice->numChannels > 0)
+            currentBufferSizeSamples = (int) outputDevice->actualBufferSize;
+        else if (isExclusive && inputDevice != nullptr && inputDevice->numChannels > 0)
+            currentBufferSizeSamples = (int) inputDevice->actualBufferSize;
 
         if (inputDevice != nullptr)   ResetEvent (inputDevice->clientEvent);
         if (outputDevice != nullptr)  ResetEvent (outputDevice->clientEvent);
@@ -901,6 +985,7 @@ private:
     ScopedPointer<WASAPIInputDevice> inputDevice;
     ScopedPointer<WASAPIOutputDevice> outputDevice;
     const bool useExclusiveMode;
+    bool isExclusive;        // useExclusiveMode, unless the last open() had to fall back to shared mode
     double defaultSampleRate;
     int minBufferSize, defaultBufferSize;
     int latencyIn, latencyOut;
@@ -916,6 +1001,23 @@ private:
     CriticalSection startStopLock;
 
     //==============================================================================
+    String openDevices (const BigInteger& inputChannels, const BigInteger& outputChannels)
+    {
+        if (inputDevice != nullptr && ! inputDevice->open (currentSampleRate, inputChannels, currentBufferSizeSamples, isExclusive))
+        {
+            close();
+            return "Couldn't open the input device!";
+        }
+
+        if (outputDevice != nullptr && ! outputDevice->open (currentSampleRate, outputChannels, currentBufferSizeSamples, isExclusive))
+        {
+            close();
+            return "Couldn't open the output device!";
+        }
+
+        return String::empty;
+    }
+
     bool createDevices()
     {
         ComSmartPtr <IMMDeviceEnumerator> enumerator;
@@ -962,9 +1064,10 @@ class WASAPIAudioIODeviceType  : public AudioIODeviceType,
                                  private DeviceChangeDetector
 {
 public:
-    WASAPIAudioIODeviceType()
-        : AudioIODeviceType ("Windows Audio"),
+    WASAPIAudioIODeviceType (const bool exclusiveMode_)
+        : AudioIODeviceType (exclusiveMode_ ? "Windows Audio (Exclusive Mode)" : "Windows Audio"),
           DeviceChangeDetector (L"Windows Audio"),
+          exclusiveMode (exclusiveMode_),
           hasScanned (false)
     {
     }
@@ -1012,7 +1115,6 @@ public:
     {
         jassert (hasScanned); // need to call scanForDevices() before doing this
 
-        const bool useExclusiveMode = false;
         ScopedPointer<WASAPIAudioIODevice> device;
 
         const int outputIndex = outputDeviceNames.indexOf (outputDeviceName);
@@ -1022,9 +1124,10 @@ public:
         {
             device = new WASAPIAudioIODevice (outputDeviceName.isNotEmpty() ? outputDeviceName
                                                                             : inputDeviceName,
+                                              getTypeName(),
                                               outputDeviceIds [outputIndex],
                                               inputDeviceIds [inputIndex],
-                                              useExclusiveMode);
+                                              exclusiveMode);
 
             if (! device->initialise())
                 device = nullptr;
@@ -1038,6 +1141,7 @@ public:
     StringArray inputDeviceNames, inputDeviceIds;
 
 private:
+    const bool exclusiveMode;
     bool hasScanned;
 
     //==============================================================================
@@ -1155,10 +1259,10 @@ private:
 }
 
 //==============================================================================
-AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_WASAPI()
+AudioIODeviceType* AudioIODeviceType::createAudioIODeviceType_WASAPI (bool exclusiveMode)
 {
     if (SystemStats::getOperatingSystemType() >= SystemStats::WinVista)
-        return new WasapiClasses::WASAPIAudioIODeviceType();
+        return new WasapiClasses::WASAPIAudioIODeviceType (exclusiveMode);
 
     return nullptr;
 }
@@ -1123,10 +1123,6 @@ private:
                                L"", type, 0, 0, 0, 0, parentToAddTo, 0,
                                (HINSTANCE) Process::getCurrentModuleInstanceHandle(), 0);
 
-       #if JUCE_DIRECT2D
-        setCurrentRenderingEngine (1);
-       #endif
-
         if (hwnd != 0)
         {
             SetWindowLongPtr (hwnd, 0, 0);
@@ -1237,7 +1233,14 @@ private:
                 direct2DContext->start();
                 direct2DContext->clipToRectangle (Rectangle<int> (r.left, r.top, r.right - r.left, r.bottom - r.top));
                 handlePaint (*direct2DContext);
-                direct2DContext->end();
+
+                if (! direct2DContext->end())
+                {
+                    // the device was lost and no new render target could be made
+                    currentRenderingEngine = softwareRenderingEngine;
+                    updateDirect2DContext();
+                    InvalidateRect (hwnd, 0, FALSE);
+                }
             }
         }
         else
@@ -1401,6 +1404,12 @@ private:
             direct2DContext = 0;
         else if (direct2DContext == 0)
             direct2DContext = new Direct2DLowLevelGraphicsContext (hwnd);
+
+        if (direct2DContext != 0 && ! direct2DContext->isValid())
+        {
+            currentRenderingEngine = softwareRenderingEngine;
+            direct2DContext = 0;
+        }
     }
    #endif
 